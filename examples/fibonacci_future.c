@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <abt.h>
+#include "predef.h"
 
 #define N               10
 #define NUM_XSTREAMS    4
@@ -93,31 +94,34 @@ int main(int argc, char *argv[])
     int n, i, expected;
     int num_xstreams;
     ABT_xstream *xstreams;
+    ABT_sched_predef sched;
+    ABT_pool_kind kind;
     ABT_thread thread;
     thread_args args;
 
     if (argc > 1 && strcmp(argv[1], "-h") == 0) {
-        printf("Usage: %s [N=10] [num_ES=4]\n", argv[0]);
+        printf("Usage: %s [N=10] [num_ES=4] [sched=default] [pool=fifo]\n",
+               argv[0]);
         return EXIT_SUCCESS;
     }
     n = argc > 1 ? atoi(argv[1]) : N;
     num_xstreams = argc > 2 ? atoi(argv[2]) : NUM_XSTREAMS;
+    sched = predef_sched(argc > 3 ? argv[3] : NULL);
+    kind = predef_pool(argc > 4 ? argv[4] : NULL);
     printf("# of ESs: %d\n", num_xstreams);
 
     /* initialization */
     ABT_init(argc, argv);
 
     /* shared pool creation */
-    ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
-                          &g_pool);
+    ABT_pool_create_basic(kind, predef_pool_access(kind), ABT_TRUE, &g_pool);
 
     /* ES creation */
     xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
     ABT_xstream_self(&xstreams[0]);
-    ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT,
-                                     1, &g_pool);
+    ABT_xstream_set_main_sched_basic(xstreams[0], sched, 1, &g_pool);
     for (i = 1; i < num_xstreams; i++) {
-        ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &g_pool,
+        ABT_xstream_create_basic(sched, 1, &g_pool,
                                  ABT_SCHED_CONFIG_NULL, &xstreams[i]);
         ABT_xstream_start(xstreams[i]);
     }
@@ -0,0 +1,77 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Selection of the predefined schedulers and pools by name, so that the
+ * examples can be run with every combination (see maint/abt-scale.pl).
+ * The schedulers are "default", "basic", "prio", "randws", "localws",
+ * "edf", "hier" and "fair", and the pools are "fifo", "fifo_lockfree",
+ * "deque", "prio", "edf" and "multiq". */
+
+#ifndef PREDEF_H_INCLUDED
+#define PREDEF_H_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <abt.h>
+
+static inline ABT_sched_predef predef_sched(const char *name)
+{
+    if (name == NULL || strcmp(name, "default") == 0) return ABT_SCHED_DEFAULT;
+    if (strcmp(name, "basic") == 0) return ABT_SCHED_BASIC;
+    if (strcmp(name, "prio") == 0) return ABT_SCHED_PRIO;
+    if (strcmp(name, "randws") == 0) return ABT_SCHED_RANDWS;
+    if (strcmp(name, "localws") == 0) return ABT_SCHED_LOCALWS;
+    if (strcmp(name, "edf") == 0) return ABT_SCHED_EDF;
+    if (strcmp(name, "hier") == 0) return ABT_SCHED_HIER;
+    if (strcmp(name, "fair") == 0) return ABT_SCHED_FAIR;
+    fprintf(stderr, "ERROR: unknown scheduler: %s\n", name);
+    exit(EXIT_FAILURE);
+}
+
+static inline ABT_pool_kind predef_pool(const char *name)
+{
+    if (name == NULL || strcmp(name, "fifo") == 0) return ABT_POOL_FIFO;
+    if (strcmp(name, "fifo_lockfree") == 0) return ABT_POOL_FIFO_LOCKFREE;
+    if (strcmp(name, "deque") == 0) return ABT_POOL_DEQUE;
+    if (strcmp(name, "prio") == 0) return ABT_POOL_PRIO;
+    if (strcmp(name, "edf") == 0) return ABT_POOL_EDF;
+    if (strcmp(name, "multiq") == 0) return ABT_POOL_MULTIQ;
+    fprintf(stderr, "ERROR: unknown pool: %s\n", name);
+    exit(EXIT_FAILURE);
+}
+
+/* The deque pool only supports a single producer. */
+static inline ABT_pool_access predef_pool_access(ABT_pool_kind kind)
+{
+    return (kind == ABT_POOL_DEQUE) ? ABT_POOL_ACCESS_SPMC
+                                    : ABT_POOL_ACCESS_MPMC;
+}
+
+/* Create num_pools pools of the given kind and, for each of num_xstreams ESs,
+ * a scheduler that takes all of the pools starting from pools[i % num_pools].
+ * With a single pool, the pool is shared by all ESs. */
+static inline void predef_create(ABT_sched_predef sched, ABT_pool_kind kind,
+                                 int num_xstreams, int num_pools,
+                                 ABT_pool *pools, ABT_sched *scheds)
+{
+    ABT_pool *my_pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_pools);
+    int i, k;
+
+    for (i = 0; i < num_pools; i++) {
+        ABT_pool_create_basic(kind, predef_pool_access(kind), ABT_TRUE,
+                              &pools[i]);
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_pools; k++) {
+            my_pools[k] = pools[(i + k) % num_pools];
+        }
+        ABT_sched_create_basic(sched, num_pools, my_pools,
+                               ABT_SCHED_CONFIG_NULL, &scheds[i]);
+    }
+    free(my_pools);
+}
+
+#endif /* PREDEF_H_INCLUDED */
@@ -5,7 +5,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "abt.h"
+#include "predef.h"
 
 #define NUM_XSTREAMS    4
 #define NUM_THREADS     (NUM_XSTREAMS * 2)
@@ -19,50 +21,62 @@ void thread_hello(void *arg)
 
 int main(int argc, char *argv[])
 {
-    ABT_xstream xstreams[NUM_XSTREAMS];
-    ABT_sched   scheds[NUM_XSTREAMS];
+    ABT_xstream *xstreams;
+    ABT_sched   *scheds;
     ABT_pool    shared_pool;
-    ABT_thread  threads[NUM_THREADS];
+    ABT_thread  *threads;
+    int num_xstreams, num_threads;
     int i;
 
-    ABT_init(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "-h") == 0) {
+        printf("Usage: %s [num_ES=%d] [num_ULT=%d] [sched=default] "
+               "[pool=fifo]\n", argv[0], NUM_XSTREAMS, NUM_THREADS);
+        return EXIT_SUCCESS;
+    }
+    num_xstreams = argc > 1 ? atoi(argv[1]) : NUM_XSTREAMS;
+    num_threads = argc > 2 ? atoi(argv[2]) : NUM_THREADS;
 
-    /* Create a shared pool */
-    ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
-                          ABT_TRUE, &shared_pool);
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    scheds = (ABT_sched *)malloc(sizeof(ABT_sched) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
 
-    /* Create schedulers */
-    for (i = 0; i < NUM_XSTREAMS; i++) {
-        ABT_sched_create_basic(ABT_SCHED_DEFAULT, 1, &shared_pool,
-                               ABT_SCHED_CONFIG_NULL, &scheds[i]);
-    }
+    ABT_init(argc, argv);
+
+    /* Create a shared pool and schedulers */
+    predef_create(predef_sched(argc > 3 ? argv[3] : NULL),
+                  predef_pool(argc > 4 ? argv[4] : NULL),
+                  num_xstreams, 1, &shared_pool, scheds);
 
     /* Create ESs */
     ABT_xstream_self(&xstreams[0]);
     ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
-    for (i = 1; i < NUM_XSTREAMS; i++) {
+    for (i = 1; i < num_xstreams; i++) {
         ABT_xstream_create(scheds[i], &xstreams[i]);
     }
 
     /* Create ULTs */
-    for (i = 0; i < NUM_THREADS; i++) {
+    for (i = 0; i < num_threads; i++) {
         size_t tid = (size_t)i;
         ABT_thread_create(shared_pool, thread_hello, (void *)tid,
                           ABT_THREAD_ATTR_NULL, &threads[i]);
     }
 
     /* Join & Free */
-    for (i = 0; i < NUM_THREADS; i++) {
+    for (i = 0; i < num_threads; i++) {
         ABT_thread_join(threads[i]);
         ABT_thread_free(&threads[i]);
     }
-    for (i = 1; i < NUM_XSTREAMS; i++) {
+    for (i = 1; i < num_xstreams; i++) {
         ABT_xstream_join(xstreams[i]);
         ABT_xstream_free(&xstreams[i]);
     }
 
     ABT_finalize();
 
+    free(threads);
+    free(scheds);
+    free(xstreams);
+
     return 0;
 }
 
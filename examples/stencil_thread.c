@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <abt.h>
+#include "predef.h"
 
 #define N                       4
 #define NBLOCKS                 32
@@ -155,6 +156,7 @@ int main(int argc, char *argv[])
     int ret;
     int x, y;
     int i;
+    char *sched_name, *pool_name;
 
     ABT_init(argc, argv);
 
@@ -163,23 +165,40 @@ int main(int argc, char *argv[])
     niterations  = (argc > 3) ? atoi(argv[3]) : NITER;
     num_xstreams = (argc > 4) ? atoi(argv[4]) : DEFAULT_NUM_XSTREAMS;
     print        = (argc > 5) ? atoi(argv[5]) : PRINT;
+    sched_name   = (argc > 6) ? argv[6] : NULL;
+    pool_name    = (argc > 7) ? argv[7] : NULL;
 
     assert(blockSize > 0);
 
     ncells = blockSize*nBlocks;
 
-    /* ES creation */
+    /* ES creation.  If a scheduler or a pool is given, each ES gets a pool,
+     * and every scheduler takes all of the pools starting from its own. */
     xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
     ret = ABT_xstream_self(&xstreams[0]);
-    for (i = 1; i < num_xstreams; i++) {
-        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
-        HANDLE_ERROR(ret, "ABT_xstream_create");
-    }
+    if (sched_name != NULL || pool_name != NULL) {
+        ABT_sched *scheds = (ABT_sched *)malloc(sizeof(ABT_sched) *
+                                                num_xstreams);
+        predef_create(predef_sched(sched_name), predef_pool(pool_name),
+                      num_xstreams, num_xstreams, pools, scheds);
+        ret = ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+        HANDLE_ERROR(ret, "ABT_xstream_set_main_sched");
+        for (i = 1; i < num_xstreams; i++) {
+            ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+            HANDLE_ERROR(ret, "ABT_xstream_create");
+        }
+        free(scheds);
+    } else {
+        for (i = 1; i < num_xstreams; i++) {
+            ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+            HANDLE_ERROR(ret, "ABT_xstream_create");
+        }
 
-    /* Get the main pools */
-    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
-    for (i = 0; i < num_xstreams; i++) {
-        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        /* Get the main pools */
+        for (i = 0; i < num_xstreams; i++) {
+            ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        }
     }
 
     results = (double *)calloc((ncells+2)*(ncells+2), sizeof(double));
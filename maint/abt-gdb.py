@@ -0,0 +1,189 @@
+#
+# See COPYRIGHT in top-level directory.
+#
+# GDB commands for Argobots programs.
+#
+# Usage: (gdb) source maint/abt-gdb.py
+#
+#   abt ults          List the ULTs running on the ESs and queued in their
+#                     pools.  The units of pools that are not FIFO pools
+#                     (ABT_POOL_FIFO) are not listed.
+#   abt bt ULT        Print the backtrace of a suspended ULT from its saved
+#                     fcontext.  ULT is an ABT_thread, e.g., an address listed
+#                     by "abt ults".
+#   abt bt-all        Print the backtraces of all the suspended ULTs that
+#                     "abt ults" lists.
+#
+# Argobots has to be built with debugging symbols (-g).  Backtraces need a
+# live process on x86-64 or ARM64 and Argobots configured with fcontext, which
+# is the default: the registers of the current thread are replaced with the
+# saved ones while the backtrace is taken and restored afterwards.  A blocked
+# ULT is in none of the pools, but its ABT_thread can be given to "abt bt".
+
+import gdb
+
+# Registers saved by jump_fcontext: (name, offset from fctx)
+FCONTEXT_REGS = {
+    'i386:x86-64': [('r12', 0x08), ('r13', 0x10), ('r14', 0x18),
+                    ('r15', 0x20), ('rbx', 0x28), ('rbp', 0x30),
+                    ('pc', 0x38)],
+    'aarch64': [('x%d' % (19 + i), 0x40 + 8 * i) for i in range(12)] +
+               [('pc', 0xa0)],
+}
+FCONTEXT_SIZE = {'i386:x86-64': 0x40, 'aarch64': 0xb0}
+
+STATES = {0: 'ready', 1: 'running', 2: 'blocked', 3: 'terminated'}
+
+
+def thread_ptr(value):
+    return value.cast(gdb.lookup_type('ABTI_thread').pointer())
+
+
+def fifo_units(p_pool):
+    """Yield the units in p_pool if it is a FIFO pool."""
+    fifo = gdb.parse_and_eval('ABTI_pool_fifo')
+    if int(p_pool['p_get_size']) != int(fifo['p_get_size']):
+        return
+    p_data = p_pool['data'].cast(
+        gdb.lookup_type('ABTI_pool_fifo_data').pointer())
+    p_unit = p_data['p_head']
+    for _ in range(int(p_data['num_units'])):
+        if int(p_unit) == 0:
+            break
+        yield p_unit
+        p_unit = p_unit['p_next']
+
+
+def xstreams():
+    p_global = gdb.parse_and_eval('gp_ABTI_global')
+    if int(p_global) == 0:
+        raise gdb.GdbError('Argobots is not initialized.')
+    for i in range(int(p_global['max_xstreams'])):
+        p_xstream = p_global['p_xstreams'][i]
+        if int(p_xstream) != 0:
+            yield p_xstream
+
+
+def collect_ults():
+    """Return a list of (ES rank, pool ID or None, ABTI_thread *)."""
+    ults = []
+    seen_pools = set()
+    for p_xstream in xstreams():
+        rank = int(p_xstream['rank'])
+        p_local = p_xstream['p_local']
+        if int(p_local) != 0 and int(p_local['p_thread']) != 0:
+            ults.append((rank, None, p_local['p_thread']))
+        p_sched = p_xstream['p_main_sched']
+        if int(p_sched) == 0:
+            continue
+        for i in range(int(p_sched['num_pools'])):
+            p_pool = p_sched['pools'][i].cast(
+                gdb.lookup_type('ABTI_pool').pointer())
+            if int(p_pool) in seen_pools:
+                continue
+            seen_pools.add(int(p_pool))
+            for p_unit in fifo_units(p_pool):
+                if int(p_unit['type']) == 0:    # ABT_UNIT_TYPE_THREAD
+                    ults.append((rank, int(p_pool['id']),
+                                 thread_ptr(p_unit['thread'])))
+    return ults
+
+
+def ult_func(p_thread):
+    try:
+        func = p_thread['ctx']['f_thread']
+    except gdb.error:
+        return '?'
+    return str(func) if int(func) != 0 else '-'
+
+
+def backtrace(p_thread):
+    """Print the backtrace of p_thread from its saved fcontext."""
+    arch = gdb.selected_frame().architecture().name()
+    if arch not in FCONTEXT_REGS:
+        raise gdb.GdbError('Backtraces of ULTs are not supported on %s.' %
+                           arch)
+    state = int(p_thread['state'])
+    if state not in (0, 2):
+        raise gdb.GdbError('The ULT is %s, not suspended.' %
+                           STATES.get(state, '?'))
+    fctx = int(p_thread['ctx']['fctx'])
+    if fctx == 0:
+        raise gdb.GdbError('The ULT has no saved context.')
+
+    ptr = gdb.lookup_type('unsigned long').pointer()
+    saved = {}
+    gdb.execute('frame 0', to_string=True)
+    frame = gdb.selected_frame()
+    for name, _ in FCONTEXT_REGS[arch]:
+        saved[name] = int(frame.read_register(name))
+    saved['sp'] = int(frame.read_register('sp'))
+    try:
+        for name, offset in FCONTEXT_REGS[arch]:
+            value = gdb.Value(fctx + offset).cast(ptr).dereference()
+            gdb.execute('set $%s = %d' % (name, int(value)))
+        gdb.execute('set $sp = %d' % (fctx + FCONTEXT_SIZE[arch]))
+        gdb.execute('backtrace')
+    finally:
+        for name, value in saved.items():
+            gdb.execute('set $%s = %d' % (name, value))
+        gdb.execute('frame 0', to_string=True)
+
+
+class AbtCommand(gdb.Command):
+    """Commands for Argobots: abt ults, abt bt ULT, abt bt-all."""
+
+    def __init__(self):
+        super(AbtCommand, self).__init__('abt', gdb.COMMAND_DATA,
+                                         gdb.COMPLETE_NONE, True)
+
+
+class AbtUltsCommand(gdb.Command):
+    """List the ULTs running on the ESs and queued in their FIFO pools."""
+
+    def __init__(self):
+        super(AbtUltsCommand, self).__init__('abt ults', gdb.COMMAND_DATA)
+
+    def invoke(self, arg, from_tty):
+        for rank, pool_id, p_thread in collect_ults():
+            where = 'running' if pool_id is None else 'pool %d' % pool_id
+            gdb.write('ES %d %-9s ULT %d (ABT_thread)0x%x %s %s\n' %
+                      (rank, where, int(p_thread['id']), int(p_thread),
+                       STATES.get(int(p_thread['state']), '?'),
+                       ult_func(p_thread)))
+
+
+class AbtBtCommand(gdb.Command):
+    """Print the backtrace of a suspended ULT: abt bt ULT."""
+
+    def __init__(self):
+        super(AbtBtCommand, self).__init__('abt bt', gdb.COMMAND_STACK)
+
+    def invoke(self, arg, from_tty):
+        if not arg:
+            raise gdb.GdbError('Usage: abt bt ULT')
+        backtrace(thread_ptr(gdb.parse_and_eval(arg)))
+
+
+class AbtBtAllCommand(gdb.Command):
+    """Print the backtraces of all the suspended ULTs in FIFO pools."""
+
+    def __init__(self):
+        super(AbtBtAllCommand, self).__init__('abt bt-all', gdb.COMMAND_STACK)
+
+    def invoke(self, arg, from_tty):
+        for rank, pool_id, p_thread in collect_ults():
+            if pool_id is None:
+                continue
+            gdb.write('ULT %d in pool %d (ES %d):\n' %
+                      (int(p_thread['id']), pool_id, rank))
+            try:
+                backtrace(p_thread)
+            except gdb.GdbError as e:
+                gdb.write('  %s\n' % e)
+
+
+AbtCommand()
+AbtUltsCommand()
+AbtBtCommand()
+AbtBtAllCommand()
@@ -0,0 +1,215 @@
+#!/usr/bin/env perl
+#
+# See COPYRIGHT in top-level directory.
+#
+# Run the examples with 1..N ESs and every combination of the predefined
+# schedulers and pools, and print the speedup curves.
+#
+
+use strict;
+use warnings;
+
+use Getopt::Long;
+use POSIX qw(:sys_wait_h);
+use Time::HiRes qw(time);
+
+my @all_scheds = ("basic", "prio", "randws", "localws", "edf");
+my @all_pools = ("fifo", "fifo_lockfree", "deque", "prio", "edf",
+                 "multiq");
+my @all_examples = ("fibonacci_task", "fibonacci_future", "stencil_thread",
+                    "stencil_task", "sched_shared_pool");
+
+my $dir = "examples";
+my $max_es = 0;
+my $es_list = "";
+my $sched_list = join(",", @all_scheds);
+my $pool_list = join(",", @all_pools);
+my $repeats = 3;
+my $timeout = 60;
+my $fib = 25;
+my $csv = "";
+
+sub usage
+{
+    print "Usage: $0 [OPTIONS] [EXAMPLE ...]\n\n";
+    print "EXAMPLE is one of @all_examples (default: all)\n\n";
+    print "OPTIONS:\n";
+
+    print "\t--dir=DIR       directory of the built examples (default: examples)\n";
+    print "\t--max-es=N      largest number of ESs (default: number of CPUs)\n";
+    print "\t--es=LIST       comma-separated numbers of ESs (default: 1,2,4,...,N)\n";
+    print "\t--sched=LIST    comma-separated schedulers (default: $sched_list)\n";
+    print "\t--pool=LIST     comma-separated pools (default: $pool_list)\n";
+    print "\t--repeats=N     runs of each point; the fastest is used (default: 3)\n";
+    print "\t--timeout=SEC   time limit of each run (default: 60)\n";
+    print "\t--fib=N         Fibonacci number computed by fibonacci_* (default: 25)\n";
+    print "\t--csv=FILE      write all the results in CSV\n";
+
+    print "\n";
+
+    exit 1;
+}
+
+GetOptions(
+    "dir=s" => \$dir,
+    "max-es=i" => \$max_es,
+    "es=s" => \$es_list,
+    "sched=s" => \$sched_list,
+    "pool=s" => \$pool_list,
+    "repeats=i" => \$repeats,
+    "timeout=i" => \$timeout,
+    "fib=i" => \$fib,
+    "csv=s" => \$csv,
+    "help" => \&usage
+) or usage();
+
+my @examples = @ARGV ? @ARGV : @all_examples;
+my @scheds = split(/,/, $sched_list);
+my @pools = split(/,/, $pool_list);
+foreach my $example (@examples) {
+    usage() if (!grep { $_ eq $example } @all_examples);
+}
+
+if (!$max_es) {
+    $max_es = `getconf _NPROCESSORS_ONLN 2>/dev/null`;
+    chomp($max_es);
+    $max_es = 1 if (!$max_es || $max_es !~ /^\d+$/);
+}
+my @num_es;
+if ($es_list) {
+    @num_es = split(/,/, $es_list);
+} else {
+    for (my $n = 1; $n < $max_es; $n *= 2) {
+        push(@num_es, $n);
+    }
+    push(@num_es, $max_es);
+}
+
+# Command line of each example
+sub example_args
+{
+    my ($example, $es, $sched, $pool) = @_;
+
+    if ($example =~ /^fibonacci_/) {
+        return ($fib, $es, $sched, $pool);
+    } elsif ($example =~ /^stencil_/) {
+        # blockSize, nBlocks, niterations, num_ES, print
+        return (4, 32, 50, $es, 0, $sched, $pool);
+    } else {
+        # num_ES, num_ULT
+        return ($es, 1000, $sched, $pool);
+    }
+}
+
+# Run the command and return the elapsed time, or undef if it fails or
+# exceeds the time limit.
+sub run_once
+{
+    my @cmd = @_;
+    my $start = time();
+
+    my $pid = fork();
+    die "fork: $!\n" if (!defined($pid));
+    if ($pid == 0) {
+        open(STDOUT, ">", "/dev/null");
+        open(STDERR, ">", "/dev/null");
+        exec(@cmd) or POSIX::_exit(127);
+    }
+
+    my $status;
+    while (1) {
+        if (waitpid($pid, WNOHANG) == $pid) {
+            $status = $?;
+            last;
+        }
+        if (time() - $start > $timeout) {
+            kill("KILL", $pid);
+            waitpid($pid, 0);
+            return undef;
+        }
+        select(undef, undef, undef, 0.001);
+    }
+    return ($status == 0) ? time() - $start : undef;
+}
+
+sub run_best
+{
+    my @cmd = @_;
+    my $best;
+    for (my $i = 0; $i < $repeats; $i++) {
+        my $t = run_once(@cmd);
+        return undef if (!defined($t));
+        $best = $t if (!defined($best) || $t < $best);
+    }
+    return $best;
+}
+
+
+##### Run the examples
+
+my $csv_fh;
+if ($csv) {
+    open($csv_fh, ">", $csv) or die "$csv: $!\n";
+    print $csv_fh "example,sched,pool,num_es,time,speedup,efficiency\n";
+}
+
+# example => "sched/pool" => speedup at the largest number of ESs
+my %final;
+
+foreach my $example (@examples) {
+    my $prog = "$dir/$example";
+    die "$prog: not found (build the examples first)\n" if (!-x $prog);
+
+    foreach my $sched (@scheds) {
+        foreach my $pool (@pools) {
+            my $base;
+            printf("%s sched=%s pool=%s\n", $example, $sched, $pool);
+            printf("  %4s %10s %8s %10s\n", "ES", "time (s)", "speedup",
+                   "efficiency");
+            foreach my $es (@num_es) {
+                my $t = run_best($prog,
+                                 example_args($example, $es, $sched, $pool));
+                if (!defined($t)) {
+                    # e.g., the deque pool does not allow multiple
+                    # producers, and a waiting ULT that yields to a deque
+                    # pool is popped again before other work units.
+                    printf("  %4d %10s\n", $es, "failed");
+                    print $csv_fh "$example,$sched,$pool,$es,,,\n" if ($csv_fh);
+                    next;
+                }
+                $base = $t * $es / $num_es[0] if (!defined($base));
+                my $speedup = $base / $t;
+                printf("  %4d %10.4f %8.2f %10.2f\n", $es, $t, $speedup,
+                       $speedup / $es);
+                printf $csv_fh ("%s,%s,%s,%d,%.6f,%.4f,%.4f\n", $example, $sched,
+                                $pool, $es, $t, $speedup, $speedup / $es)
+                    if ($csv_fh);
+                $final{$example}{"$sched/$pool"} = $speedup
+                    if ($es == $num_es[-1]);
+            }
+            print "\n";
+        }
+    }
+}
+
+close($csv_fh) if ($csv_fh);
+
+
+##### Print the summary
+
+printf("Speedup with %d ESs\n", $num_es[-1]);
+printf("  %-22s", "");
+foreach my $example (@examples) {
+    printf(" %17s", $example);
+}
+print "\n";
+foreach my $sched (@scheds) {
+    foreach my $pool (@pools) {
+        printf("  %-22s", "$sched/$pool");
+        foreach my $example (@examples) {
+            my $s = $final{$example}{"$sched/$pool"};
+            printf(" %17s", defined($s) ? sprintf("%.2f", $s) : "-");
+        }
+        print "\n";
+    }
+}
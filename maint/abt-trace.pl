@@ -0,0 +1,273 @@
+#!/usr/bin/env perl
+#
+# See COPYRIGHT in top-level directory.
+#
+# Convert and analyze the binary event traces that Argobots writes with
+# ABT_TRACE=1 ABT_TRACE_FORMAT=binary (see README.envvar).
+#
+
+use strict;
+use warnings;
+
+use Getopt::Long;
+
+# Kinds of events (see src/include/abti_trace.h)
+my @kind_names = ("create", "push", "pop", "steal", "run", "stop", "block");
+my ($CREATE, $PUSH, $POP, $STEAL, $RUN, $STOP, $BLOCK) = (0 .. 6);
+my $TASK = 0x100;
+
+my $chrome = "";
+my $top = 10;
+my $quiet;
+
+sub usage
+{
+    print "Usage: $0 [OPTIONS] TRACE_FILE\n\n";
+    print "OPTIONS:\n";
+
+    print "\t--chrome=FILE   write the trace in the Chrome trace event format\n";
+    print "\t--top=N         number of the longest-running units to show (default: 10)\n";
+    print "\t--quiet         do not print the summary\n";
+
+    print "\n";
+
+    exit 1;
+}
+
+GetOptions(
+    "chrome=s" => \$chrome,
+    "top=i" => \$top,
+    "quiet" => \$quiet,
+    "help" => \&usage
+) or usage();
+usage() if (@ARGV != 1);
+
+sub read_bytes
+{
+    my ($fh, $len) = @_;
+    my $buf = "";
+    my $n = read($fh, $buf, $len);
+    die "$ARGV[0]: truncated trace\n" if (!defined($n) || $n != $len);
+    return $buf;
+}
+
+
+##### Read the trace
+
+open(my $fh, "<", $ARGV[0]) or die "$ARGV[0]: $!\n";
+binmode($fh);
+
+my ($magic, $us_per_cycle, $start_cycles, $pid, $num_xstreams) =
+    unpack("a8 d Q L L", read_bytes($fh, 32));
+die "$ARGV[0]: not a binary Argobots trace\n" if ($magic ne "ABTTRC01");
+
+# Each event is [time (us), rank, kind, is_task, unit, pool].
+my @events;
+my %xstreams;   # rank => { num_events, num_dropped }
+for (my $i = 0; $i < $num_xstreams; $i++) {
+    my ($rank, $num, $dropped) = unpack("Q Q Q", read_bytes($fh, 24));
+    my @raw = $num ? unpack("(Q Q L L)$num", read_bytes($fh, 24 * $num)) : ();
+    # A rank can be reused by a later ES.
+    $xstreams{$rank}{num_events} += $num;
+    $xstreams{$rank}{num_dropped} += $dropped;
+    for (my $j = 0; $j < $num; $j++) {
+        my ($cycles, $unit, $kind, $pool) = @raw[4 * $j .. 4 * $j + 3];
+        my $time = ($cycles - $start_cycles) * $us_per_cycle;
+        next if (($kind & ~$TASK) > $BLOCK);
+        push(@events, [$time, $rank, $kind & ~$TASK, ($kind & $TASK) ? 1 : 0,
+                       $unit, $pool]);
+    }
+}
+close($fh);
+
+@events = sort { $a->[0] <=> $b->[0] } @events;
+
+
+##### Replay the events
+
+# What each ES is running: rank => [unit, start time, is_task]
+my %running;
+my %first_time;     # rank => time of the first event
+my %last_time;      # rank => time of the last event
+my %busy;           # rank => time spent in work units
+my %num_runs;       # rank => number of runs
+my %steals;         # thief rank => { pool => number of steals }
+my %pops;           # pool => { rank => number of pops }
+my %pending;        # unit => time it was pushed
+my @waits;          # queue-wait times
+my %lives;          # unit => [total run time, # of runs, is_task, ranks]
+my @finished;       # lifetimes of units whose addresses have been reused
+my @chrome_events;
+
+sub unit_name
+{
+    my ($unit, $is_task) = @_;
+    return sprintf("%s 0x%x", $is_task ? "tasklet" : "ULT", $unit);
+}
+
+sub stop_running
+{
+    my ($rank, $time) = @_;
+    my $p_run = $running{$rank};
+    return if (!defined($p_run));
+    my ($unit, $start, $is_task) = @$p_run;
+    my $p_life = $lives{$unit} //= [0, 0, $is_task, {}];
+    $busy{$rank} += $time - $start;
+    $p_life->[0] += $time - $start;
+    $p_life->[1]++;
+    $p_life->[3]{$rank} = 1;
+    push(@chrome_events, [$time, $rank, "E", unit_name($unit, $is_task)]);
+    delete($running{$rank});
+}
+
+foreach my $p_ev (@events) {
+    my ($time, $rank, $kind, $is_task, $unit, $pool) = @$p_ev;
+    $first_time{$rank} //= $time;
+    $last_time{$rank} = $time;
+    if ($kind == $RUN) {
+        stop_running($rank, $time);
+        $running{$rank} = [$unit, $time, $is_task];
+        $num_runs{$rank}++;
+        if (defined($pending{$unit})) {
+            push(@waits, $time - $pending{$unit});
+            delete($pending{$unit});
+        }
+        push(@chrome_events, [$time, $rank, "B", unit_name($unit, $is_task)]);
+        next;
+    } elsif ($kind == $STOP) {
+        stop_running($rank, $time)
+            if (defined($running{$rank}) && $running{$rank}[0] == $unit);
+        next;
+    } elsif ($kind == $CREATE) {
+        if (defined($lives{$unit})) {
+            push(@finished, [$unit, @{$lives{$unit}}]);
+            delete($lives{$unit});
+        }
+        $pending{$unit} = $time;
+    } elsif ($kind == $PUSH) {
+        $pending{$unit} = $time;
+    } elsif ($kind == $POP) {
+        $pops{$pool}{$rank}++;
+    } elsif ($kind == $STEAL) {
+        $steals{$rank}{$pool}++;
+    }
+    push(@chrome_events, [$time, $rank, "i", $kind_names[$kind], $is_task,
+                          $unit, $pool]);
+}
+foreach my $rank (keys %running) {
+    stop_running($rank, $last_time{$rank});
+}
+foreach my $unit (keys %lives) {
+    push(@finished, [$unit, @{$lives{$unit}}]);
+}
+
+
+##### Write the Chrome trace
+
+if ($chrome ne "") {
+    open(my $out, ">", $chrome) or die "$chrome: $!\n";
+    my @lines;
+    foreach my $rank (sort { $a <=> $b } keys %xstreams) {
+        push(@lines, sprintf("{\"pid\":%d,\"tid\":%d,\"ph\":\"M\","
+                             . "\"name\":\"thread_name\","
+                             . "\"args\":{\"name\":\"ES %d\"}}",
+                             $pid, $rank, $rank));
+    }
+    foreach my $p_ev (@chrome_events) {
+        my ($time, $rank, $ph, $name, $is_task, $unit, $pool) = @$p_ev;
+        my $line = sprintf("{\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"ph\":\"%s\","
+                           . "\"name\":\"%s\"", $pid, $rank, $time, $ph,
+                           $name);
+        if ($ph eq "i") {
+            $line .= sprintf(",\"s\":\"t\",\"args\":{\"type\":\"%s\","
+                             . "\"unit\":\"0x%x\",\"pool\":%d}",
+                             $is_task ? "tasklet" : "ULT", $unit, $pool);
+        }
+        push(@lines, $line . "}");
+    }
+    print $out "{\"traceEvents\":[\n" . join(",\n", @lines)
+        . "\n],\"displayTimeUnit\":\"ns\"}\n";
+    close($out);
+}
+
+exit 0 if ($quiet);
+
+
+##### Print the summary
+
+printf("Trace of process %d: %d ESs, %d events\n", $pid,
+       scalar(keys %xstreams), scalar(@events));
+
+print "\nPer-ES utilization:\n";
+printf("  %4s %10s %10s %12s %12s %6s\n", "ES", "events", "dropped",
+       "span (us)", "busy (us)", "util");
+foreach my $rank (sort { $a <=> $b } keys %xstreams) {
+    my $span = defined($first_time{$rank})
+             ? $last_time{$rank} - $first_time{$rank} : 0;
+    my $busy = $busy{$rank} // 0;
+    printf("  %4d %10d %10d %12.1f %12.1f %5.1f%%\n", $rank,
+           $xstreams{$rank}{num_events}, $xstreams{$rank}{num_dropped},
+           $span, $busy, $span > 0 ? 100.0 * $busy / $span : 0.0);
+}
+
+# A pool is regarded as owned by the ES that popped from it most.
+my %owner;
+foreach my $pool (keys %pops) {
+    my $p_cnts = $pops{$pool};
+    ($owner{$pool}) = sort { $p_cnts->{$b} <=> $p_cnts->{$a} || $a <=> $b }
+                      keys %$p_cnts;
+}
+my %victims = map { %{$steals{$_}} } keys %steals;
+my @victim_pools = sort { $a <=> $b } keys %victims;
+print "\nSteal matrix (rows: thief ES, columns: victim pool (owner ES)):\n";
+if (@victim_pools == 0) {
+    print "  no steals\n";
+} else {
+    printf("  %4s", "");
+    foreach my $pool (@victim_pools) {
+        printf(" %10s", sprintf("P%d(%s)", $pool,
+                                defined($owner{$pool}) ? "E$owner{$pool}" : "-"));
+    }
+    print "\n";
+    foreach my $rank (sort { $a <=> $b } keys %steals) {
+        printf("  E%-3d", $rank);
+        foreach my $pool (@victim_pools) {
+            printf(" %10d", $steals{$rank}{$pool} // 0);
+        }
+        print "\n";
+    }
+}
+
+print "\nQueue-wait time (push to run):\n";
+if (@waits == 0) {
+    print "  no samples\n";
+} else {
+    my @hist;
+    my ($sum, $max) = (0, 0);
+    foreach my $wait (@waits) {
+        my $bin = 0;
+        $bin++ while ($bin < 30 && $wait >= 2 ** $bin);
+        $hist[$bin]++;
+        $sum += $wait;
+        $max = $wait if ($wait > $max);
+    }
+    printf("  %d samples, mean %.2f us, max %.2f us\n", scalar(@waits),
+           $sum / @waits, $max);
+    for (my $bin = 0; $bin < @hist; $bin++) {
+        next if (!$hist[$bin]);
+        my $range = ($bin == 0) ? "< 1 us"
+                  : sprintf("%d-%d us", 2 ** ($bin - 1), 2 ** $bin);
+        printf("  %14s %10d %s\n", $range, $hist[$bin],
+               "#" x int(50 * $hist[$bin] / @waits + 0.5));
+    }
+}
+
+print "\nLongest-running units (total run time of each unit):\n";
+printf("  %-24s %12s %8s %s\n", "unit", "time (us)", "runs", "ESs");
+@finished = sort { $b->[1] <=> $a->[1] } @finished;
+splice(@finished, $top) if (@finished > $top);
+foreach my $p_life (@finished) {
+    my ($unit, $time, $runs, $is_task, $p_ranks) = @$p_life;
+    printf("  %-24s %12.2f %8d %s\n", unit_name($unit, $is_task), $time,
+           $runs, join(",", sort { $a <=> $b } keys %$p_ranks));
+}
@@ -6,13 +6,22 @@
 abt_sources += \
 	arch/abtd_affinity.c \
 	arch/abtd_env.c \
+	arch/abtd_htm.c \
+	arch/abtd_preempt.c \
+	arch/abtd_profile.c \
 	arch/abtd_stream.c \
 	arch/abtd_thread.c \
-	arch/abtd_time.c
+	arch/abtd_time.c \
+	arch/abtd_xsave.c
 
 if ABT_USE_FCONTEXT
+if ABT_USE_FCONTEXT_GENERIC
+abt_sources += \
+	arch/fcontext/fcontext_generic.c
+else
 abt_sources += \
 	arch/fcontext/jump_@fctx_arch_bin@.S \
 	arch/fcontext/make_@fctx_arch_bin@.S \
 	arch/fcontext/take_@fctx_arch_bin@.S
 endif
+endif
@@ -5,6 +5,14 @@
 
 #include "abti.h"
 #include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__) && \
+    defined(HAVE_HWLOC_H) && defined(HAVE_LIBHWLOC)
+#define ABTD_USE_HWLOC
+#include <hwloc.h>
+#endif
 
 #ifdef HAVE_PTHREAD_SETAFFINITY_NP
 #if defined(__FreeBSD__)
@@ -34,24 +42,33 @@ int ABTD_CPU_COUNT(cpu_set_t *p_cpuset)
 
 enum {
     ABTI_ES_AFFINITY_CHAMELEON,
-    ABTI_ES_AFFINITY_DEFAULT
+    ABTI_ES_AFFINITY_DEFAULT,
+    ABTI_ES_AFFINITY_COMPACT,   /* Fill SMT siblings, cores, and sockets */
+    ABTI_ES_AFFINITY_SCATTER,   /* Spread over sockets, cores, and SMT */
+    ABTI_ES_AFFINITY_CORE       /* One CPU per physical core */
 };
 static int g_affinity_type = ABTI_ES_AFFINITY_DEFAULT;
 static cpu_set_t g_cpusets[CPU_SETSIZE];
+static int g_num_cpusets = 0;   /* # of valid elements of g_cpusets */
 
 static inline cpu_set_t ABTD_affinity_get_cpuset_for_rank(int rank)
 {
-    if (g_affinity_type == ABTI_ES_AFFINITY_CHAMELEON) {
-        int num_threads_per_socket = gp_ABTI_global->num_cores / 2;
+    if (g_affinity_type == ABTI_ES_AFFINITY_CHAMELEON && g_num_cpusets > 1) {
+        int num_threads_per_socket = g_num_cpusets / 2;
         int rem = rank % 2;
         int socket_id = rank / num_threads_per_socket;
         int target = (rank - num_threads_per_socket * socket_id - rem + socket_id)
                    + num_threads_per_socket * rem;
-        return g_cpusets[target % gp_ABTI_global->num_cores];
+        return g_cpusets[target % g_num_cpusets];
     } else {
-        return g_cpusets[rank % gp_ABTI_global->num_cores];
+        return g_cpusets[rank % g_num_cpusets];
     }
 }
+
+#if defined(__linux__)
+static void ABTD_affinity_order_cpus(cpu_set_t *p_allowed);
+static void ABTD_affinity_init_core_classes(cpu_set_t *p_allowed);
+#endif
 #endif
 
 void ABTD_affinity_init(void)
@@ -80,21 +97,528 @@ void ABTD_affinity_init(void)
     }
 #endif
     gp_ABTI_global->num_cores = num_cores;
+    g_num_cpusets = num_cores;
 
     /* affinity type */
+    g_affinity_type = ABTI_ES_AFFINITY_DEFAULT;
     char *env = getenv("ABT_AFFINITY_TYPE");
     if (env == NULL) env = getenv("ABT_ENV_AFFINITY_TYPE");
     if (env != NULL) {
         if (strcmp(env, "chameleon") == 0) {
             g_affinity_type = ABTI_ES_AFFINITY_CHAMELEON;
+        } else if (strcmp(env, "compact") == 0) {
+            g_affinity_type = ABTI_ES_AFFINITY_COMPACT;
+        } else if (strcmp(env, "scatter") == 0) {
+            g_affinity_type = ABTI_ES_AFFINITY_SCATTER;
+        } else if (strcmp(env, "core") == 0) {
+            g_affinity_type = ABTI_ES_AFFINITY_CORE;
         }
     }
+
+#if defined(__linux__)
+    /* Reorder the allowed CPUs according to the topology */
+    if (g_affinity_type == ABTI_ES_AFFINITY_COMPACT ||
+        g_affinity_type == ABTI_ES_AFFINITY_SCATTER ||
+        g_affinity_type == ABTI_ES_AFFINITY_CORE) {
+        ABTD_affinity_order_cpus(&cpuset);
+    }
+    ABTD_affinity_init_core_classes(&cpuset);
+#endif
+
+    /* With a CPU quota of N CPUs, ESs are bound to the first N CPUs in the
+     * order above so that the first N ESs do not share a CPU. */
+    if (gp_ABTI_global->cpu_quota > 0 &&
+        gp_ABTI_global->cpu_quota < g_num_cpusets) {
+        g_num_cpusets = gp_ABTI_global->cpu_quota;
+    }
 #else
     /* In this case, we don't support the ES affinity. */
     gp_ABTI_global->set_affinity = ABT_FALSE;
 #endif
 }
 
+/* Return the number of CPUs that the process is allowed to use, which
+ * reflects the cgroup cpuset. */
+int ABTD_affinity_get_num_cpus(void)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+    cpu_set_t cpuset;
+    if (sched_getaffinity(getpid(), sizeof(cpu_set_t), &cpuset) == 0) {
+        return ABTD_CPU_COUNT(&cpuset);
+    }
+#endif
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+#define ABTD_SYSFS_CPU_PATH     "/sys/devices/system/cpu"
+#define ABTD_SYSFS_NODE_PATH    "/sys/devices/system/node"
+#define ABTD_MAX_NUMA_NODES     256
+#define ABTD_MAX_CACHE_INDICES  16
+
+/* Check if cpu is included in the CPU list file (e.g., "0-3,8-11") at path.
+ * Returns 1 if it is, 0 if it is not, and -1 if the file cannot be read. */
+static int ABTD_affinity_cpulist_has(const char *path, int cpu)
+{
+    char buf[4096];
+    char *p = buf;
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return -1;
+    if (fgets(buf, sizeof(buf), fp) == NULL) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    while (*p >= '0' && *p <= '9') {
+        int first = (int)strtol(p, &p, 10);
+        int last = first;
+        if (*p == '-') last = (int)strtol(p + 1, &p, 10);
+        if (first <= cpu && cpu <= last) return 1;
+        if (*p != ',') break;
+        p++;
+    }
+    return 0;
+}
+
+static int ABTD_affinity_read_int(const char *path, int *p_val)
+{
+    int ret;
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return -1;
+    ret = fscanf(fp, "%d", p_val);
+    fclose(fp);
+    return (ret == 1) ? 0 : -1;
+}
+
+/* Return the first CPU in the CPU list file at path, or -1 if the file cannot
+ * be read. */
+static int ABTD_affinity_cpulist_first(const char *path)
+{
+    int cpu;
+    return (ABTD_affinity_read_int(path, &cpu) == 0) ? cpu : -1;
+}
+
+/* Write the path of the list of CPUs that share the L3 cache with cpu to
+ * path.  Returns 0 on success, or -1 if cpu has no L3 cache in sysfs. */
+static int ABTD_affinity_get_l3_path(int cpu, char *path)
+{
+    int i, level;
+
+    for (i = 0; i < ABTD_MAX_CACHE_INDICES; i++) {
+        sprintf(path, ABTD_SYSFS_CPU_PATH "/cpu%d/cache/index%d/level", cpu, i);
+        if (access(path, R_OK) != 0) break;
+        if (ABTD_affinity_read_int(path, &level) != 0 || level != 3) continue;
+
+        sprintf(path, ABTD_SYSFS_CPU_PATH "/cpu%d/cache/index%d/shared_cpu_list",
+                cpu, i);
+        return 0;
+    }
+    return -1;
+}
+
+/* Return the hardware distance between two CPUs based on sysfs. */
+static int ABTD_affinity_get_cpu_distance(int cpu1, int cpu2)
+{
+    char path[256];
+    int i, ret;
+
+    if (cpu1 == cpu2) return ABT_SCHED_STEAL_DIST_SMT;
+
+    sprintf(path, ABTD_SYSFS_CPU_PATH "/cpu%d/topology/thread_siblings_list",
+            cpu1);
+    if (ABTD_affinity_cpulist_has(path, cpu2) == 1) {
+        return ABT_SCHED_STEAL_DIST_SMT;
+    }
+
+    if (ABTD_affinity_get_l3_path(cpu1, path) == 0 &&
+        ABTD_affinity_cpulist_has(path, cpu2) == 1) {
+        return ABT_SCHED_STEAL_DIST_L3;
+    }
+
+    /* Find the NUMA node of cpu1 */
+    for (i = 0; i < ABTD_MAX_NUMA_NODES; i++) {
+        sprintf(path, ABTD_SYSFS_NODE_PATH "/node%d/cpulist", i);
+        if (ABTD_affinity_cpulist_has(path, cpu1) == 1) {
+            ret = ABTD_affinity_cpulist_has(path, cpu2);
+            return (ret == 1) ? ABT_SCHED_STEAL_DIST_NUMA
+                              : ABT_SCHED_STEAL_DIST_REMOTE;
+        }
+    }
+
+    /* Without NUMA information, a socket is regarded as a NUMA node. */
+    sprintf(path, ABTD_SYSFS_CPU_PATH "/cpu%d/topology/core_siblings_list",
+            cpu1);
+    if (ABTD_affinity_cpulist_has(path, cpu2) == 1) {
+        return ABT_SCHED_STEAL_DIST_NUMA;
+    }
+    return ABT_SCHED_STEAL_DIST_REMOTE;
+}
+#endif
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+/* Location of a CPU (PU) in the topology */
+typedef struct {
+    int cpu;            /* OS index */
+    int socket;         /* Socket (package) index */
+    int core;           /* Core ID, unique within the socket */
+    int smt;            /* Index among the allowed SMT siblings */
+    int core_rank;      /* Index of the core within the socket */
+    uint64_t key;       /* Sort key of the placement policy */
+} ABTD_affinity_pu;
+
+#ifdef ABTD_USE_HWLOC
+/* Fill p_pus with the allowed CPUs in the topological order of hwloc.
+ * Returns the number of CPUs, or -1 if the topology is not available. */
+static int ABTD_affinity_get_pus(cpu_set_t *p_allowed, ABTD_affinity_pu *p_pus)
+{
+    hwloc_topology_t topo;
+    int i, num_objs, num_pus = 0;
+
+    if (hwloc_topology_init(&topo) != 0) return -1;
+    if (hwloc_topology_load(topo) != 0) {
+        hwloc_topology_destroy(topo);
+        return -1;
+    }
+
+    num_objs = hwloc_get_nbobjs_by_type(topo, HWLOC_OBJ_PU);
+    for (i = 0; i < num_objs; i++) {
+        hwloc_obj_t pu = hwloc_get_obj_by_type(topo, HWLOC_OBJ_PU, i);
+        hwloc_obj_t core, socket;
+        int cpu = (int)pu->os_index;
+        if (cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, p_allowed)) {
+            continue;
+        }
+        core = hwloc_get_ancestor_obj_by_type(topo, HWLOC_OBJ_CORE, pu);
+        socket = hwloc_get_ancestor_obj_by_type(topo, HWLOC_OBJ_PACKAGE, pu);
+        p_pus[num_pus].cpu = cpu;
+        p_pus[num_pus].socket = socket ? (int)socket->logical_index : 0;
+        p_pus[num_pus].core = core ? (int)core->logical_index
+                                   : (int)pu->logical_index;
+        num_pus++;
+    }
+
+    hwloc_topology_destroy(topo);
+    return (num_pus > 0) ? num_pus : -1;
+}
+#else
+/* Fill p_pus with the allowed CPUs based on sysfs.  Returns the number of
+ * CPUs, or -1 if the topology is not available. */
+static int ABTD_affinity_get_pus(cpu_set_t *p_allowed, ABTD_affinity_pu *p_pus)
+{
+    char path[256];
+    int cpu, num_pus = 0;
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        ABTD_affinity_pu *p_pu = &p_pus[num_pus];
+        if (!CPU_ISSET(cpu, p_allowed)) continue;
+
+        sprintf(path, ABTD_SYSFS_CPU_PATH
+                "/cpu%d/topology/physical_package_id", cpu);
+        if (ABTD_affinity_read_int(path, &p_pu->socket) != 0) return -1;
+        sprintf(path, ABTD_SYSFS_CPU_PATH "/cpu%d/topology/core_id", cpu);
+        if (ABTD_affinity_read_int(path, &p_pu->core) != 0) return -1;
+        p_pu->cpu = cpu;
+        num_pus++;
+    }
+    return (num_pus > 0) ? num_pus : -1;
+}
+#endif
+
+static int ABTD_affinity_cmp_pus(const void *p1, const void *p2)
+{
+    const ABTD_affinity_pu *p_pu1 = (const ABTD_affinity_pu *)p1;
+    const ABTD_affinity_pu *p_pu2 = (const ABTD_affinity_pu *)p2;
+    if (p_pu1->key != p_pu2->key) return (p_pu1->key < p_pu2->key) ? -1 : 1;
+    return p_pu1->cpu - p_pu2->cpu;
+}
+
+/* Rebuild g_cpusets from the allowed CPUs according to g_affinity_type.
+ * The OS order is kept if the topology is not available. */
+static void ABTD_affinity_order_cpus(cpu_set_t *p_allowed)
+{
+    const uint64_t m = (uint64_t)1 << 20;   /* Weight of each sort key */
+    ABTD_affinity_pu *p_pus;
+    int i, num_pus, num_cpusets = 0;
+
+    p_pus = (ABTD_affinity_pu *)ABTU_malloc(CPU_SETSIZE *
+                                            sizeof(ABTD_affinity_pu));
+    num_pus = ABTD_affinity_get_pus(p_allowed, p_pus);
+    if (num_pus <= 0) {
+        LOG_DEBUG("CPU topology is not available\n");
+        goto fn_exit;
+    }
+
+    /* Number the cores of each socket and the SMT siblings of each core in
+     * order. */
+    for (i = 0; i < num_pus; i++) {
+        p_pus[i].key = (uint64_t)p_pus[i].socket * m + (uint64_t)p_pus[i].core;
+    }
+    qsort(p_pus, num_pus, sizeof(ABTD_affinity_pu), ABTD_affinity_cmp_pus);
+    for (i = 0; i < num_pus; i++) {
+        if (i == 0 || p_pus[i].socket != p_pus[i - 1].socket) {
+            p_pus[i].core_rank = 0;
+            p_pus[i].smt = 0;
+        } else if (p_pus[i].core != p_pus[i - 1].core) {
+            p_pus[i].core_rank = p_pus[i - 1].core_rank + 1;
+            p_pus[i].smt = 0;
+        } else {
+            p_pus[i].core_rank = p_pus[i - 1].core_rank;
+            p_pus[i].smt = p_pus[i - 1].smt + 1;
+        }
+    }
+
+    for (i = 0; i < num_pus; i++) {
+        uint64_t socket = p_pus[i].socket, core = p_pus[i].core_rank;
+        uint64_t smt = p_pus[i].smt;
+        switch (g_affinity_type) {
+            case ABTI_ES_AFFINITY_SCATTER:
+                p_pus[i].key = smt * m * m + core * m + socket;
+                break;
+            case ABTI_ES_AFFINITY_CORE:
+                /* SMT siblings other than the first one are dropped below. */
+                p_pus[i].key = socket * m + core;
+                break;
+            default:
+                p_pus[i].key = socket * m * m + core * m + smt;
+                break;
+        }
+    }
+    qsort(p_pus, num_pus, sizeof(ABTD_affinity_pu), ABTD_affinity_cmp_pus);
+
+    for (i = 0; i < num_pus; i++) {
+        if (g_affinity_type == ABTI_ES_AFFINITY_CORE && p_pus[i].smt != 0) {
+            continue;
+        }
+        CPU_ZERO(&g_cpusets[num_cpusets]);
+        CPU_SET(p_pus[i].cpu, &g_cpusets[num_cpusets]);
+        num_cpusets++;
+    }
+    g_num_cpusets = num_cpusets;
+
+  fn_exit:
+    ABTU_free(p_pus);
+}
+
+static int g_num_nodes = 1;
+static int g_cpu_nodes[CPU_SETSIZE];    /* NUMA node of each CPU */
+static char g_cpu_classes[CPU_SETSIZE]; /* ABT_CORE_CLASS_* of each CPU */
+
+/* Find the efficiency cores among the allowed CPUs.  Intel hybrid processors
+ * list them in sysfs as cpu_atom.  Otherwise, the CPUs whose capacity (ARM
+ * big.LITTLE) or maximum frequency is less than 80% of the fastest one are
+ * regarded as efficiency cores.  All CPUs are performance cores if neither is
+ * available. */
+static void ABTD_affinity_init_core_classes(cpu_set_t *p_allowed)
+{
+    const char *atom_path = "/sys/devices/cpu_atom/cpus";
+    char path[256];
+    int cpu, max_speed = 0;
+    int *p_speeds;
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        g_cpu_classes[cpu] = ABT_CORE_CLASS_PERF;
+    }
+    if (access(atom_path, R_OK) == 0) {
+        for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (!CPU_ISSET(cpu, p_allowed)) continue;
+            if (ABTD_affinity_cpulist_has(atom_path, cpu) == 1) {
+                g_cpu_classes[cpu] = ABT_CORE_CLASS_EFFICIENCY;
+            }
+        }
+        return;
+    }
+
+    p_speeds = (int *)ABTU_calloc(CPU_SETSIZE, sizeof(int));
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, p_allowed)) continue;
+        sprintf(path, ABTD_SYSFS_CPU_PATH "/cpu%d/cpu_capacity", cpu);
+        if (ABTD_affinity_read_int(path, &p_speeds[cpu]) != 0) {
+            sprintf(path, ABTD_SYSFS_CPU_PATH
+                    "/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+            if (ABTD_affinity_read_int(path, &p_speeds[cpu]) != 0) {
+                p_speeds[cpu] = 0;
+            }
+        }
+        if (p_speeds[cpu] > max_speed) max_speed = p_speeds[cpu];
+    }
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (p_speeds[cpu] > 0 && (int64_t)p_speeds[cpu] * 5 <
+                                 (int64_t)max_speed * 4) {
+            g_cpu_classes[cpu] = ABT_CORE_CLASS_EFFICIENCY;
+        }
+    }
+    ABTU_free(p_speeds);
+}
+#endif
+
+/* Read the NUMA topology and return the number of NUMA nodes.  One node is
+ * assumed if the topology is not available. */
+int ABTD_affinity_init_nodes(void)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+    char path[256];
+    int i, cpu;
+
+    g_num_nodes = 1;
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        g_cpu_nodes[cpu] = 0;
+    }
+    for (i = 0; i < ABTD_MAX_NUMA_NODES; i++) {
+        sprintf(path, ABTD_SYSFS_NODE_PATH "/node%d/cpulist", i);
+        if (access(path, R_OK) != 0) continue;
+        for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (ABTD_affinity_cpulist_has(path, cpu) == 1) {
+                g_cpu_nodes[cpu] = i;
+            }
+        }
+        if (i + 1 > g_num_nodes) g_num_nodes = i + 1;
+    }
+    return g_num_nodes;
+#else
+    return 1;
+#endif
+}
+
+/* Return the NUMA node of the CPU that the caller is running on. */
+int ABTD_affinity_get_node(void)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+    if (g_num_nodes > 1) {
+        int cpu = sched_getcpu();
+        if (cpu >= 0 && cpu < CPU_SETSIZE) return g_cpu_nodes[cpu];
+    }
+#endif
+    return 0;
+}
+
+/* Return the number of NUMA nodes found by ABTD_affinity_init_nodes(). */
+int ABTD_affinity_get_num_nodes(void)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+    return g_num_nodes;
+#else
+    return 1;
+#endif
+}
+
+/* Ask the OS to place the pages of [p_addr, p_addr + len) on node.  The pages
+ * that have already been touched are not moved, so this has to be called
+ * before the memory is used.  Nothing is done if the OS does not support it. */
+void ABTD_affinity_bind_memory(void *p_addr, size_t len, int node)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__) && \
+    defined(SYS_mbind)
+    const int mpol_preferred = 1;   /* MPOL_PREFERRED in <numaif.h> */
+    const size_t word_bits = sizeof(unsigned long) * 8;
+    unsigned long nodemask[ABTD_MAX_NUMA_NODES / (sizeof(unsigned long) * 8)];
+    size_t i;
+
+    if (g_num_nodes <= 1 || node < 0 || node >= ABTD_MAX_NUMA_NODES) return;
+
+    for (i = 0; i < sizeof(nodemask) / sizeof(nodemask[0]); i++) {
+        nodemask[i] = 0;
+    }
+    nodemask[node / word_bits] = 1UL << (node % word_bits);
+    if (syscall(SYS_mbind, p_addr, len, mpol_preferred, nodemask,
+                ABTD_MAX_NUMA_NODES, 0) != 0) {
+        LOG_DEBUG("mbind failed for %p (%zu) on node %d\n", p_addr, len, node);
+    }
+#endif
+}
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+/* Return the CPU that the ES is bound to, or -1 if it is not bound to a
+ * single CPU. */
+static int ABTD_affinity_get_bound_cpu(ABTD_xstream_context ctx)
+{
+    int cpu, num_cpus;
+    if (ABTD_affinity_get_cpuset(ctx, 1, &cpu, &num_cpus) != ABT_SUCCESS ||
+        num_cpus != 1) {
+        return -1;
+    }
+    return cpu;
+}
+#endif
+
+/* Return the hardware distance (ABT_SCHED_STEAL_DIST_*) between the CPUs that
+ * two ESs are bound to.  ESs that are not bound to a single CPU are regarded
+ * as remote. */
+int ABTD_affinity_get_distance(ABTD_xstream_context ctx1,
+                               ABTD_xstream_context ctx2)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+    int cpu1 = ABTD_affinity_get_bound_cpu(ctx1);
+    int cpu2 = ABTD_affinity_get_bound_cpu(ctx2);
+
+    if (cpu1 < 0 || cpu2 < 0) return ABT_SCHED_STEAL_DIST_REMOTE;
+    return ABTD_affinity_get_cpu_distance(cpu1, cpu2);
+#else
+    return ABT_SCHED_STEAL_DIST_REMOTE;
+#endif
+}
+
+/* Return the ID of the object at level (ABT_TOPOLOGY_*) that contains the CPU
+ * the ES is bound to.  Cores and L3 caches are identified by their first CPU.
+ * Returns -1 if the ES is not bound to a single CPU or the object is not
+ * known. */
+int ABTD_affinity_get_topology_id(ABTD_xstream_context ctx, int level)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+    char path[256];
+    int id = -1;
+    int cpu = ABTD_affinity_get_bound_cpu(ctx);
+    if (cpu < 0) return -1;
+
+    switch (level) {
+        case ABT_TOPOLOGY_CPU:
+            id = cpu;
+            break;
+        case ABT_TOPOLOGY_CORE:
+            sprintf(path, ABTD_SYSFS_CPU_PATH
+                    "/cpu%d/topology/thread_siblings_list", cpu);
+            id = ABTD_affinity_cpulist_first(path);
+            if (id < 0) id = cpu;
+            break;
+        case ABT_TOPOLOGY_L3:
+            if (ABTD_affinity_get_l3_path(cpu, path) == 0) {
+                id = ABTD_affinity_cpulist_first(path);
+            }
+            break;
+        case ABT_TOPOLOGY_NUMA:
+            id = g_cpu_nodes[cpu];
+            break;
+        case ABT_TOPOLOGY_SOCKET:
+            sprintf(path, ABTD_SYSFS_CPU_PATH
+                    "/cpu%d/topology/physical_package_id", cpu);
+            if (ABTD_affinity_read_int(path, &id) != 0) id = -1;
+            break;
+        default:
+            break;
+    }
+    return id;
+#else
+    ABTI_UNUSED(ctx);
+    ABTI_UNUSED(level);
+    return -1;
+#endif
+}
+
+/* Return the class (ABT_CORE_CLASS_*) of the CPU that the ES is bound to.
+ * ESs that are not bound to a single CPU are regarded as on performance
+ * cores. */
+int ABTD_affinity_get_core_class(ABTD_xstream_context ctx)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(__linux__)
+    int cpu = ABTD_affinity_get_bound_cpu(ctx);
+    if (cpu < 0) return ABT_CORE_CLASS_PERF;
+    return g_cpu_classes[cpu];
+#else
+    ABTI_UNUSED(ctx);
+    return ABT_CORE_CLASS_PERF;
+#endif
+}
+
 int ABTD_affinity_set(ABTD_xstream_context ctx, int rank)
 {
 #ifdef HAVE_PTHREAD_SETAFFINITY_NP
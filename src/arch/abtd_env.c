@@ -11,22 +11,174 @@
 #define ABTD_THREAD_DEFAULT_STACKSIZE   16384
 #define ABTD_SCHED_DEFAULT_STACKSIZE    (4*1024*1024)
 #define ABTD_SCHED_EVENT_FREQ           50
-#define ABTD_SCHED_SLEEP_NSEC           100
-
-#define ABTD_CACHE_LINE_SIZE            64
+#define ABTD_SCHED_SLEEP_NSEC           100000000
+#define ABTD_SCHED_REMOTE_THRESHOLD     8
+#define ABTD_MAX_PARKED_XSTREAMS        8
+#define ABTD_OFFLOAD_MAX_HELPERS        16
+#define ABTD_POOL_RING_CAPACITY         1024
+#define ABTD_TASK_BATCH_SIZE            32
+#define ABTD_TASK_BATCH_LATENCY_USEC    50
+#define ABTD_TASK_INLINE_DEPTH          8
+#define ABTD_TEAM_SPIN_TIME_USEC        100
+#define ABTD_TRACE_SIZE                 65536
+#define ABTD_WAKE_AFFINE_MAX_QUEUE      2
+#define ABTD_ELASTIC_INTERVAL_NSEC      10000000
+#define ABTD_ELASTIC_GROW_DEPTH         8
+#define ABTD_ELASTIC_PARK_IDLE          90
+
+#define ABTD_CACHE_LINE_SIZE            ABT_CONFIG_CACHE_LINE_SIZE
 #define ABTD_OS_PAGE_SIZE               (4*1024)
 #define ABTD_HUGE_PAGE_SIZE             (2*1024*1024)
 #define ABTD_MEM_PAGE_SIZE              (2*1024*1024)
 #define ABTD_MEM_STACK_PAGE_SIZE        (8*1024*1024)
 #define ABTD_MEM_MAX_NUM_STACKS         65536
+#define ABTD_MEM_STACK_COLORS           8
+
+
+#if defined(__linux__)
+#define ABTD_CGROUP_PATH                "/sys/fs/cgroup"
+#define ABTD_CGROUP_PATH_LEN            1024
+
+/* Copy the cgroup of this process in the hierarchy that has controller to
+ * path.  controller is "" for the cgroup v2 unified hierarchy.  Returns 0 on
+ * success, or -1 if there is no such hierarchy. */
+static int ABTD_env_get_cgroup(const char *controller, char *path)
+{
+    char line[ABTD_CGROUP_PATH_LEN];
+    int ret = -1;
+    FILE *fp = fopen("/proc/self/cgroup", "r");
+    if (fp == NULL) return -1;
+
+    /* Each line is "hierarchy-ID:controller-list:path". */
+    while (ret != 0 && fgets(line, sizeof(line), fp) != NULL) {
+        char *p_ctrl = strchr(line, ':');
+        char *p_path;
+        if (p_ctrl == NULL) continue;
+        p_ctrl++;
+        p_path = strchr(p_ctrl, ':');
+        if (p_path == NULL) continue;
+        *p_path++ = '\0';
+        p_path[strcspn(p_path, "\n")] = '\0';
+
+        if (controller[0] == '\0') {
+            if (p_ctrl[0] == '\0') ret = 0;
+        } else {
+            while (*p_ctrl != '\0') {
+                size_t len = strcspn(p_ctrl, ",");
+                if (len == strlen(controller) &&
+                    strncmp(p_ctrl, controller, len) == 0) {
+                    ret = 0;
+                    break;
+                }
+                p_ctrl += len;
+                if (*p_ctrl == ',') p_ctrl++;
+            }
+        }
+        if (ret == 0) strcpy(path, p_path);
+    }
+    fclose(fp);
+    return ret;
+}
 
+/* Set path to the file name in the cgroup directory dir.  False if the path
+ * does not fit, in which case the cgroup is skipped. */
+#define ABTD_ENV_CGROUP_FILE(path, dir, name)                               \
+    ((size_t)snprintf(path, sizeof(path), "%s/" name, dir) < sizeof(path))
+
+/* Return the CPU quota of the cgroup directory dir in CPUs (rounded up), or
+ * 0 if it is unlimited or not available. */
+static int ABTD_env_read_cpu_quota(const char *dir, ABT_bool is_v2)
+{
+    char path[ABTD_CGROUP_PATH_LEN * 2];
+    char buf[32];
+    long quota = -1, period = 0;
+    FILE *fp;
+
+    if (is_v2) {
+        /* cpu.max has "$MAX $PERIOD", where $MAX may be "max". */
+        if (!ABTD_ENV_CGROUP_FILE(path, dir, "cpu.max")) return 0;
+        if ((fp = fopen(path, "r")) == NULL) return 0;
+        if (fscanf(fp, "%31s %ld", buf, &period) == 2 &&
+            strcmp(buf, "max") != 0) {
+            quota = atol(buf);
+        }
+        fclose(fp);
+    } else {
+        /* cpu.cfs_quota_us is -1 if it is unlimited. */
+        if (!ABTD_ENV_CGROUP_FILE(path, dir, "cpu.cfs_quota_us")) return 0;
+        if ((fp = fopen(path, "r")) == NULL) return 0;
+        if (fscanf(fp, "%ld", &quota) != 1) quota = -1;
+        fclose(fp);
+        if (!ABTD_ENV_CGROUP_FILE(path, dir, "cpu.cfs_period_us")) return 0;
+        if ((fp = fopen(path, "r")) == NULL) return 0;
+        if (fscanf(fp, "%ld", &period) != 1) period = 0;
+        fclose(fp);
+    }
+    if (quota <= 0 || period <= 0) return 0;
+    return (int)((quota + period - 1) / period);
+}
+
+/* Return the CPU quota of this process in CPUs, which is the smallest one of
+ * its cgroup and the ancestors, or 0 if there is none.  The cgroup v1 cpu
+ * controller is used if it is mounted, and otherwise cgroup v2.  In a
+ * container with a cgroup namespace, the cgroup is "/" and the mount point
+ * is the cgroup of the container. */
+static int ABTD_env_get_cpu_quota(void)
+{
+    char cgroup[ABTD_CGROUP_PATH_LEN];
+    char dir[ABTD_CGROUP_PATH_LEN * 2];
+    const char *root;
+    ABT_bool is_v2;
+    size_t root_len;
+    int quota = 0;
+
+    if (ABTD_env_get_cgroup("cpu", cgroup) == 0) {
+        is_v2 = ABT_FALSE;
+        root = (access(ABTD_CGROUP_PATH "/cpu", R_OK) == 0)
+             ? ABTD_CGROUP_PATH "/cpu" : ABTD_CGROUP_PATH "/cpu,cpuacct";
+    } else if (ABTD_env_get_cgroup("", cgroup) == 0) {
+        is_v2 = ABT_TRUE;
+        root = ABTD_CGROUP_PATH;
+    } else {
+        return 0;
+    }
+
+    /* Walk up from the cgroup of this process to the mount point.  The
+     * directory does not exist if the cgroup is outside the namespace. */
+    root_len = strlen(root);
+    sprintf(dir, "%s%s", root, cgroup);
+    while (1) {
+        int q = ABTD_env_read_cpu_quota(dir, is_v2);
+        char *p_slash;
+        if (q > 0 && (quota == 0 || q < quota)) quota = q;
+        if (strlen(dir) <= root_len) break;
+        p_slash = strrchr(dir + root_len, '/');
+        if (p_slash == NULL) break;
+        *p_slash = '\0';
+    }
+    return quota;
+}
+#endif
 
 void ABTD_env_init(ABTI_global *p_global)
 {
     char *env;
 
-    /* Get the number of available cores in the system */
-    p_global->num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    /* Get the number of available cores, which the cgroup cpuset limits */
+    p_global->num_cores = ABTD_affinity_get_num_cpus();
+
+    /* CPU quota (e.g., of a container).  The CFS bandwidth control throttles
+     * all ESs if more ESs than the quota keep running. */
+    p_global->cpu_quota = 0;
+    env = getenv("ABT_CPU_QUOTA");
+    if (env == NULL) env = getenv("ABT_ENV_CPU_QUOTA");
+    if (env == NULL || strcasecmp(env, "auto") == 0) {
+#if defined(__linux__)
+        p_global->cpu_quota = ABTD_env_get_cpu_quota();
+#endif
+    } else if (atoi(env) > 0) {
+        p_global->cpu_quota = atoi(env);
+    }
 
     /* By default, we use the CPU affinity */
     p_global->set_affinity = ABT_TRUE;
@@ -41,6 +193,9 @@ void ABTD_env_init(ABTI_global *p_global)
     if (p_global->set_affinity == ABT_TRUE) {
         ABTD_affinity_init();
     }
+    if (p_global->cpu_quota > 0 && p_global->cpu_quota < p_global->num_cores) {
+        p_global->num_cores = p_global->cpu_quota;
+    }
 
 #ifdef ABT_CONFIG_USE_DEBUG_LOG_PRINT
     /* If the debug log printing is set in configure, logging is turned on by
@@ -73,6 +228,79 @@ void ABTD_env_init(ABTI_global *p_global)
         }
     }
 
+    /* Event tracing */
+    p_global->use_tracing = ABT_FALSE;
+    env = getenv("ABT_TRACE");
+    if (env == NULL) env = getenv("ABT_ENV_TRACE");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->use_tracing = ABT_TRUE;
+        }
+    }
+    env = getenv("ABT_TRACE_SIZE");
+    if (env == NULL) env = getenv("ABT_ENV_TRACE_SIZE");
+    if (env != NULL && atol(env) > 0) {
+        p_global->trace_size = (uint32_t)atol(env);
+    } else {
+        p_global->trace_size = ABTD_TRACE_SIZE;
+    }
+    env = getenv("ABT_TRACE_FILE");
+    if (env == NULL) env = getenv("ABT_ENV_TRACE_FILE");
+    p_global->trace_filename = env;
+    p_global->trace_binary = ABT_FALSE;
+    env = getenv("ABT_TRACE_FORMAT");
+    if (env == NULL) env = getenv("ABT_ENV_TRACE_FORMAT");
+    if (env != NULL && strcasecmp(env, "binary") == 0) {
+        p_global->trace_binary = ABT_TRUE;
+    }
+
+    /* Record or replay of schedules.  Replay takes precedence. */
+    p_global->sched_record = ABTI_RECORD_OFF;
+    env = getenv("ABT_SCHED_RECORD");
+    if (env == NULL) env = getenv("ABT_ENV_SCHED_RECORD");
+    p_global->record_filename = env;
+    if (env != NULL) p_global->sched_record = ABTI_RECORD_ON;
+    env = getenv("ABT_SCHED_REPLAY");
+    if (env == NULL) env = getenv("ABT_ENV_SCHED_REPLAY");
+    p_global->replay_filename = env;
+    if (env != NULL && env[0] != '\0') {
+        p_global->sched_record = ABTI_RECORD_REPLAY;
+    }
+
+    /* Timing histograms of work units */
+    p_global->use_unit_stats = ABT_FALSE;
+    env = getenv("ABT_UNIT_STATS");
+    if (env == NULL) env = getenv("ABT_ENV_UNIT_STATS");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->use_unit_stats = ABT_TRUE;
+        }
+    }
+
+    /* CPU time of work units */
+    p_global->use_cpu_time = ABT_FALSE;
+    env = getenv("ABT_CPU_TIME");
+    if (env == NULL) env = getenv("ABT_ENV_CPU_TIME");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->use_cpu_time = ABT_TRUE;
+        }
+    }
+
+    /* Operation counters of pools */
+    p_global->use_pool_stats = ABT_FALSE;
+    env = getenv("ABT_POOL_STATS");
+    if (env == NULL) env = getenv("ABT_ENV_POOL_STATS");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->use_pool_stats = ABT_TRUE;
+        }
+    }
+
     /* Maximum size of the internal ES array */
     env = getenv("ABT_MAX_NUM_XSTREAMS");
     if (env == NULL) env = getenv("ABT_ENV_MAX_NUM_XSTREAMS");
@@ -131,6 +359,37 @@ void ABTD_env_init(ABTI_global *p_global)
         p_global->sched_sleep_nsec = ABTD_SCHED_SLEEP_NSEC;
     }
 
+    /* Online tuning of the two above by each scheduler */
+    p_global->sched_autotune = ABT_FALSE;
+    env = getenv("ABT_SCHED_AUTOTUNE");
+    if (env == NULL) env = getenv("ABT_ENV_SCHED_AUTOTUNE");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->sched_autotune = ABT_TRUE;
+        }
+    }
+
+    /* Imbalance above which units are moved to another NUMA node */
+    env = getenv("ABT_SCHED_REMOTE_THRESHOLD");
+    if (env == NULL) env = getenv("ABT_ENV_SCHED_REMOTE_THRESHOLD");
+    if (env != NULL) {
+        p_global->sched_remote_threshold = (uint32_t)atol(env);
+    } else {
+        p_global->sched_remote_threshold = ABTD_SCHED_REMOTE_THRESHOLD;
+    }
+
+    /* By default, schedulers prefetch the units that they will run. */
+    p_global->sched_prefetch = ABT_TRUE;
+    env = getenv("ABT_SCHED_PREFETCH");
+    if (env == NULL) env = getenv("ABT_ENV_SCHED_PREFETCH");
+    if (env != NULL) {
+        if (strcmp(env, "0") == 0 || strcasecmp(env, "n") == 0 ||
+            strcasecmp(env, "no") == 0) {
+            p_global->sched_prefetch = ABT_FALSE;
+        }
+    }
+
     /* Mutex attributes */
     env = getenv("ABT_MUTEX_MAX_HANDOVERS");
     if (env == NULL) env = getenv("ABT_ENV_MUTEX_MAX_HANDOVERS");
@@ -150,6 +409,132 @@ void ABTD_env_init(ABTI_global *p_global)
         p_global->mutex_max_wakeups = 1;
     }
 
+    /* Maximum number of OS threads parked for later secondary ESs */
+    env = getenv("ABT_MAX_PARKED_XSTREAMS");
+    if (env == NULL) env = getenv("ABT_ENV_MAX_PARKED_XSTREAMS");
+    if (env != NULL) {
+        p_global->max_parked_xstreams = (uint32_t)atoi(env);
+    } else {
+        p_global->max_parked_xstreams = ABTD_MAX_PARKED_XSTREAMS;
+    }
+
+    /* Maximum number of helper OS threads for ABT_offload() */
+    env = getenv("ABT_OFFLOAD_MAX_HELPERS");
+    if (env == NULL) env = getenv("ABT_ENV_OFFLOAD_MAX_HELPERS");
+    if (env != NULL) {
+        p_global->offload.max_helpers = (uint32_t)atoi(env);
+    } else {
+        p_global->offload.max_helpers = ABTD_OFFLOAD_MAX_HELPERS;
+    }
+
+    /* Capacity of the ring pools */
+    env = getenv("ABT_POOL_RING_CAPACITY");
+    if (env == NULL) env = getenv("ABT_ENV_POOL_RING_CAPACITY");
+    if (env != NULL) {
+        p_global->pool_ring_capacity = (uint32_t)atoi(env);
+        ABTI_ASSERT(p_global->pool_ring_capacity >= 1);
+    } else {
+        p_global->pool_ring_capacity = ABTD_POOL_RING_CAPACITY;
+    }
+
+    /* Number of sub-queues of the relaxed FIFO pools */
+    env = getenv("ABT_POOL_MULTIQ_NUM_QUEUES");
+    if (env == NULL) env = getenv("ABT_ENV_POOL_MULTIQ_NUM_QUEUES");
+    if (env != NULL) {
+        p_global->pool_multiq_num_queues = (uint32_t)atoi(env);
+        ABTI_ASSERT(p_global->pool_multiq_num_queues >= 1);
+    } else {
+        p_global->pool_multiq_num_queues = 2 * p_global->max_xstreams;
+    }
+
+    /* Batching of ABT_task_create_batched */
+    env = getenv("ABT_TASK_BATCH_SIZE");
+    if (env == NULL) env = getenv("ABT_ENV_TASK_BATCH_SIZE");
+    if (env != NULL) {
+        p_global->task_batch_size = (uint32_t)atoi(env);
+    } else {
+        p_global->task_batch_size = ABTD_TASK_BATCH_SIZE;
+    }
+    env = getenv("ABT_TASK_BATCH_LATENCY");
+    if (env == NULL) env = getenv("ABT_ENV_TASK_BATCH_LATENCY");
+    p_global->task_batch_latency = 1.0e-6 * (env ? atof(env)
+                                   : ABTD_TASK_BATCH_LATENCY_USEC);
+
+    /* Nesting of ABT_task_create_inline */
+    env = getenv("ABT_TASK_INLINE_DEPTH");
+    if (env == NULL) env = getenv("ABT_ENV_TASK_INLINE_DEPTH");
+    if (env != NULL) {
+        p_global->task_inline_depth = (uint32_t)atoi(env);
+    } else {
+        p_global->task_inline_depth = ABTD_TASK_INLINE_DEPTH;
+    }
+
+    /* Spin time of team members before they block */
+    env = getenv("ABT_TEAM_SPIN_TIME");
+    if (env == NULL) env = getenv("ABT_ENV_TEAM_SPIN_TIME");
+    p_global->team_spin_time = 1.0e-6 * (env ? atof(env)
+                               : ABTD_TEAM_SPIN_TIME_USEC);
+
+    /* Whether wakers switch directly to the woken ULTs */
+    p_global->handoff = ABT_FALSE;
+    env = getenv("ABT_HANDOFF");
+    if (env == NULL) env = getenv("ABT_ENV_HANDOFF");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->handoff = ABT_TRUE;
+        }
+    }
+
+    /* Whether woken ULTs go back to the ES where they last ran if that ES has
+     * at most ABT_WAKE_AFFINE_MAX_QUEUE units */
+    p_global->wake_affine = ABT_FALSE;
+    env = getenv("ABT_WAKE_AFFINE");
+    if (env == NULL) env = getenv("ABT_ENV_WAKE_AFFINE");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->wake_affine = ABT_TRUE;
+        }
+    }
+    env = getenv("ABT_WAKE_AFFINE_MAX_QUEUE");
+    if (env == NULL) env = getenv("ABT_ENV_WAKE_AFFINE_MAX_QUEUE");
+    if (env != NULL) {
+        p_global->wake_affine_max_queue = (uint32_t)atoi(env);
+    } else {
+        p_global->wake_affine_max_queue = ABTD_WAKE_AFFINE_MAX_QUEUE;
+    }
+
+    /* Whether ULTs created on an ES run there before the queued units */
+    p_global->run_next = ABT_FALSE;
+    env = getenv("ABT_RUN_NEXT");
+    if (env == NULL) env = getenv("ABT_ENV_RUN_NEXT");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->run_next = ABT_TRUE;
+        }
+    }
+
+    /* Preemption quantum of ULTs in microseconds */
+    p_global->preempt_interval_nsec = 0;
+    env = getenv("ABT_PREEMPTION_INTERVAL");
+    if (env == NULL) env = getenv("ABT_ENV_PREEMPTION_INTERVAL");
+    if (env != NULL && atol(env) > 0) {
+        p_global->preempt_interval_nsec = atol(env) * 1000;
+    }
+
+    /* Sampling interval of the profiler in microseconds of CPU time */
+    p_global->profile_interval_nsec = 0;
+    env = getenv("ABT_PROFILE_INTERVAL");
+    if (env == NULL) env = getenv("ABT_ENV_PROFILE_INTERVAL");
+    if (env != NULL && atol(env) > 0) {
+        p_global->profile_interval_nsec = atol(env) * 1000;
+    }
+    env = getenv("ABT_PROFILE_FILE");
+    if (env == NULL) env = getenv("ABT_ENV_PROFILE_FILE");
+    p_global->profile_filename = env;
+
     /* Cache line size */
     env = getenv("ABT_CACHE_LINE_SIZE");
     if (env == NULL) env = getenv("ABT_ENV_CACHE_LINE_SIZE");
@@ -177,6 +562,35 @@ void ABTD_env_init(ABTI_global *p_global)
         p_global->huge_page_size = ABTD_HUGE_PAGE_SIZE;
     }
 
+    /* Whether canaries at the bottom of ULT stacks are checked.  By default,
+     * they are not. */
+    p_global->stack_canary = ABT_FALSE;
+    env = getenv("ABT_STACK_CANARY");
+    if (env == NULL) env = getenv("ABT_ENV_STACK_CANARY");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->stack_canary = ABT_TRUE;
+        }
+    }
+
+    /* Whether the stack usage of ULTs is measured.  By default, it is not. */
+    p_global->stack_profile = ABT_FALSE;
+    env = getenv("ABT_STACK_PROFILE");
+    if (env == NULL) env = getenv("ABT_ENV_STACK_PROFILE");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->stack_profile = ABT_TRUE;
+        }
+    }
+
+    /* File the contention of internal spinlocks is written to at exit
+     * ("stdout", "stderr", or a file name) with --enable-lock-profile */
+    env = getenv("ABT_LOCK_PROFILE_FILE");
+    if (env == NULL) env = getenv("ABT_ENV_LOCK_PROFILE_FILE");
+    p_global->lock_profile_filename = env;
+
 #ifdef ABT_CONFIG_USE_MEM_POOL
     /* Page size for memory allocation */
     env = getenv("ABT_MEM_PAGE_SIZE");
@@ -205,6 +619,16 @@ void ABTD_env_init(ABTI_global *p_global)
         p_global->mem_max_stacks = ABTD_MEM_MAX_NUM_STACKS;
     }
 
+    /* Number of cache-line offsets by which the initial stack pointers of
+     * pooled stacks are rotated.  1 disables the rotation. */
+    env = getenv("ABT_MEM_STACK_COLORS");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_STACK_COLORS");
+    if (env != NULL && atoi(env) > 0) {
+        p_global->mem_stack_colors = (uint32_t)atoi(env);
+    } else {
+        p_global->mem_stack_colors = ABTD_MEM_STACK_COLORS;
+    }
+
     /* How to allocate large pages.  The default is to use mmap() for huge
      * pages and then to fall back to allocate regular pages using mmap() when
      * huge pages are run out of. */
@@ -225,20 +649,57 @@ void ABTD_env_init(ABTI_global *p_global)
             lp_alloc = ABTI_MEM_LP_MMAP_HP_RP;
         } else if (strcasecmp(env, "mmap_hp_thp") == 0) {
             lp_alloc = ABTI_MEM_LP_MMAP_HP_THP;
+        } else if (strcasecmp(env, "mmap_gp_hp_rp") == 0) {
+            lp_alloc = ABTI_MEM_LP_MMAP_GP_HP_RP;
 #endif
         } else if (strcasecmp(env, "thp") == 0) {
             lp_alloc = ABTI_MEM_LP_THP;
         }
     }
 
-    /* Check if the requested allocation method is really possible. */
-    if (lp_alloc != ABTI_MEM_LP_MALLOC) {
-        p_global->mem_lp_alloc = ABTI_mem_check_lp_alloc(lp_alloc);
-    } else {
-        p_global->mem_lp_alloc = lp_alloc;
+    /* Whether the requested allocation method is really possible is not
+     * checked here but when large pages are allocated, which falls back to
+     * the next method if it fails. */
+    p_global->mem_lp_alloc = lp_alloc;
+
+    /* Whether ULT stacks are committed lazily.  By default, they are not. */
+    p_global->mem_lazy_stack = ABT_FALSE;
+#if defined(HAVE_MAP_ANONYMOUS) || defined(HAVE_MAP_ANON)
+    env = getenv("ABT_MEM_LAZY_STACK");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_LAZY_STACK");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->mem_lazy_stack = ABT_TRUE;
+        }
     }
 #endif
 
+    /* Whether ABT_finalize leaves the memory pool to the OS.  By default, it
+     * does not. */
+    p_global->mem_fast_finalize = ABT_FALSE;
+    env = getenv("ABT_MEM_FAST_FINALIZE");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_FAST_FINALIZE");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->mem_fast_finalize = ABT_TRUE;
+        }
+    }
+
+    /* Interval in seconds of background trims of the memory pool and the
+     * bytes of free stacks and blocks that they keep in the global data.  By
+     * default, the memory pool is trimmed only by ABT_mem_trim(). */
+    env = getenv("ABT_MEM_TRIM_INTERVAL");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_TRIM_INTERVAL");
+    p_global->mem_trim_interval = (env != NULL) ? atof(env) : 0.0;
+    if (p_global->mem_trim_interval < 0.0) p_global->mem_trim_interval = 0.0;
+
+    env = getenv("ABT_MEM_TRIM_SIZE");
+    if (env == NULL) env = getenv("ABT_ENV_MEM_TRIM_SIZE");
+    p_global->mem_trim_size = (env != NULL) ? (size_t)atol(env) : 0;
+#endif
+
 #ifdef ABT_CONFIG_HANDLE_POWER_EVENT
     /* Hostname for power management daemon */
     env = getenv("ABT_POWER_EVENT_HOSTNAME");
@@ -249,6 +710,55 @@ void ABTD_env_init(ABTI_global *p_global)
     env = getenv("ABT_POWER_EVENT_PORT");
     if (env == NULL) env = getenv("ABT_ENV_POWER_EVENT_PORT");
     p_global->pm_port = (env != NULL) ? atoi(env) : 60439;
+
+    /* File of the control block shared with power management daemon */
+    env = getenv("ABT_POWER_EVENT_SHM");
+    if (env == NULL) env = getenv("ABT_ENV_POWER_EVENT_SHM");
+    p_global->pm_shm = env;
+
+    /* Do we adjust the number of ESs without the daemon? */
+    p_global->elastic = ABT_FALSE;
+    env = getenv("ABT_ELASTIC");
+    if (env == NULL) env = getenv("ABT_ENV_ELASTIC");
+    if (env != NULL) {
+        if (strcmp(env, "1") == 0 || strcasecmp(env, "y") == 0 ||
+            strcasecmp(env, "yes") == 0) {
+            p_global->elastic = ABT_TRUE;
+        }
+    }
+
+    /* Bounds of the number of ESs for the controller */
+    env = getenv("ABT_ELASTIC_MIN_XSTREAMS");
+    if (env == NULL) env = getenv("ABT_ENV_ELASTIC_MIN_XSTREAMS");
+    p_global->elastic_min_xstreams = (env != NULL) ? atoi(env) : 1;
+    if (p_global->elastic_min_xstreams < 1) {
+        p_global->elastic_min_xstreams = 1;
+    }
+    env = getenv("ABT_ELASTIC_MAX_XSTREAMS");
+    if (env == NULL) env = getenv("ABT_ENV_ELASTIC_MAX_XSTREAMS");
+    p_global->elastic_max_xstreams = (env != NULL) ? atoi(env)
+                                   : p_global->max_xstreams;
+    if (p_global->elastic_max_xstreams < p_global->elastic_min_xstreams) {
+        p_global->elastic_max_xstreams = p_global->elastic_min_xstreams;
+    }
+
+    /* Time interval between two decisions of the controller */
+    env = getenv("ABT_ELASTIC_INTERVAL_NSEC");
+    if (env == NULL) env = getenv("ABT_ENV_ELASTIC_INTERVAL_NSEC");
+    p_global->elastic_interval = 1.0e-9 * ((env != NULL)
+                               ? (double)atoll(env)
+                               : (double)ABTD_ELASTIC_INTERVAL_NSEC);
+
+    /* Thresholds to add and park ESs */
+    env = getenv("ABT_ELASTIC_GROW_DEPTH");
+    if (env == NULL) env = getenv("ABT_ENV_ELASTIC_GROW_DEPTH");
+    p_global->elastic_grow_depth = (env != NULL) ? (uint32_t)atol(env)
+                                 : ABTD_ELASTIC_GROW_DEPTH;
+    env = getenv("ABT_ELASTIC_PARK_IDLE");
+    if (env == NULL) env = getenv("ABT_ENV_ELASTIC_PARK_IDLE");
+    p_global->elastic_park_idle = (env != NULL) ? (uint32_t)atol(env)
+                                : ABTD_ELASTIC_PARK_IDLE;
+    if (p_global->elastic_park_idle > 100) p_global->elastic_park_idle = 100;
 #endif
 
 #ifdef ABT_CONFIG_PUBLISH_INFO
@@ -293,5 +803,11 @@ void ABTD_env_init(ABTI_global *p_global)
 
     /* Init timer */
     ABTD_time_init();
+
+    /* Detect the extended processor state saved for vector ULTs */
+    ABTD_xsave_init();
+
+    /* Detect the transactional memory for lock elision */
+    ABTD_htm_init();
 }
 
@@ -0,0 +1,39 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+#include <cpuid.h>
+#include <strings.h>
+
+#define ABTD_HTM_CPUID_RTM      (1u << 11)  /* CPUID.(7,0):EBX */
+
+int g_ABTD_htm_available = 0;
+
+/* Elision is used if the processor supports RTM, which is disabled on many
+ * processors by microcode, and ABT_LOCK_ELISION is not set to 0. */
+void ABTD_htm_init(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    char *env;
+
+    g_ABTD_htm_available = 0;
+
+    env = getenv("ABT_LOCK_ELISION");
+    if (env == NULL) env = getenv("ABT_ENV_LOCK_ELISION");
+    if (env != NULL) {
+        if (strcmp(env, "0") == 0 || strcasecmp(env, "no") == 0 ||
+            strcasecmp(env, "n") == 0) {
+            return;
+        }
+    }
+
+    if (__get_cpuid_max(0, NULL) < 7) return;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if (ebx & ABTD_HTM_CPUID_RTM) g_ABTD_htm_available = 1;
+}
+
+#endif /* ABT_CONFIG_USE_LOCK_ELISION */
@@ -0,0 +1,185 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#define _GNU_SOURCE
+#include "abti.h"
+
+#ifdef ABTD_PREEMPT_SUPPORTED
+#include <errno.h>
+#include <signal.h>
+#include <link.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Older glibc does not name the thread ID field of struct sigevent. */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id  _sigev_un._tid
+#endif
+
+/* Preemption timers deliver SIGURG, which is ignored by default. */
+#define ABTD_PREEMPT_SIGNAL     SIGURG
+#define ABTD_PREEMPT_MAX_RANGES 8
+
+/* Executable segments of the main program.  A ULT is preempted only while it
+ * runs code in these ranges, i.e., never inside Argobots or other shared
+ * libraries such as libc, whose locks the scheduler might need. */
+typedef struct {
+    uintptr_t start;
+    uintptr_t end;
+} ABTD_preempt_range;
+
+static ABTD_preempt_range g_ranges[ABTD_PREEMPT_MAX_RANGES];
+static int g_num_ranges = 0;
+static struct sigaction g_old_action;
+
+static int ABTD_preempt_collect_ranges(struct dl_phdr_info *p_info,
+                                       size_t size, void *p_arg)
+{
+    int i;
+    ABTI_UNUSED(size);
+    ABTI_UNUSED(p_arg);
+
+    /* The first object is the main program. */
+    for (i = 0; i < p_info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *p_phdr = &p_info->dlpi_phdr[i];
+        if (p_phdr->p_type != PT_LOAD || !(p_phdr->p_flags & PF_X)) continue;
+        if (g_num_ranges == ABTD_PREEMPT_MAX_RANGES) break;
+        g_ranges[g_num_ranges].start = p_info->dlpi_addr + p_phdr->p_vaddr;
+        g_ranges[g_num_ranges].end = g_ranges[g_num_ranges].start
+                                   + p_phdr->p_memsz;
+        g_num_ranges++;
+    }
+    return 1;
+}
+
+static inline int ABTD_preempt_in_ranges(uintptr_t pc)
+{
+    int i;
+    for (i = 0; i < g_num_ranges; i++) {
+        if (g_ranges[i].start <= pc && pc < g_ranges[i].end) return 1;
+    }
+    return 0;
+}
+
+static inline uintptr_t ABTD_preempt_get_pc(void *p_uc)
+{
+    ucontext_t *p_ucontext = (ucontext_t *)p_uc;
+#if defined(__x86_64__)
+    return (uintptr_t)p_ucontext->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+    return (uintptr_t)p_ucontext->uc_mcontext.pc;
+#endif
+}
+
+static void ABTD_preempt_handler(int sig, siginfo_t *p_info, void *p_uc)
+{
+    int saved_errno;
+
+    if (p_info->si_code != SI_TIMER) {
+        /* Not ours.  Pass it to the handler installed before. */
+        if ((g_old_action.sa_flags & SA_SIGINFO) &&
+            g_old_action.sa_sigaction) {
+            g_old_action.sa_sigaction(sig, p_info, p_uc);
+        } else if (g_old_action.sa_handler != SIG_DFL &&
+                   g_old_action.sa_handler != SIG_IGN) {
+            g_old_action.sa_handler(sig);
+        }
+        return;
+    }
+
+    if (!ABTD_preempt_in_ranges(ABTD_preempt_get_pc(p_uc))) return;
+
+    /* The ULT may resume on another ES, where this handler returns. */
+    saved_errno = errno;
+    ABTI_xstream_check_preempt();
+    errno = saved_errno;
+}
+
+int ABTD_preempt_init(void)
+{
+    struct sigaction action;
+
+    g_num_ranges = 0;
+    dl_iterate_phdr(ABTD_preempt_collect_ranges, NULL);
+
+    /* If Argobots is linked into the main program, ULTs could be preempted
+     * inside the runtime. */
+    if (ABTD_preempt_in_ranges((uintptr_t)ABTD_preempt_init)) {
+        g_num_ranges = 0;
+        return ABT_ERR_FEATURE_NA;
+    }
+
+    /* SA_NODEFER keeps the signal unblocked after the handler switches to the
+     * scheduler.  A nested signal interrupts the handler, which is not in the
+     * main program, so it returns immediately. */
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = ABTD_preempt_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(ABTD_PREEMPT_SIGNAL, &action, &g_old_action) != 0) {
+        return ABT_ERR_OTHER;
+    }
+    return ABT_SUCCESS;
+}
+
+void ABTD_preempt_finalize(void)
+{
+    sigaction(ABTD_PREEMPT_SIGNAL, &g_old_action, NULL);
+}
+
+/* The timer measures the CPU time of the calling thread, so it does not
+ * fire while the ES sleeps. */
+int ABTD_preempt_timer_create(ABTD_preempt_timer *p_timer, long interval_nsec)
+{
+    struct sigevent sev;
+    struct itimerspec its;
+
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = ABTD_PREEMPT_SIGNAL;
+    sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, p_timer) != 0) {
+        return ABT_ERR_OTHER;
+    }
+
+    its.it_interval.tv_sec = interval_nsec / 1000000000;
+    its.it_interval.tv_nsec = interval_nsec % 1000000000;
+    its.it_value = its.it_interval;
+    if (timer_settime(*p_timer, 0, &its, NULL) != 0) {
+        timer_delete(*p_timer);
+        return ABT_ERR_OTHER;
+    }
+    return ABT_SUCCESS;
+}
+
+void ABTD_preempt_timer_free(ABTD_preempt_timer *p_timer)
+{
+    timer_delete(*p_timer);
+}
+
+#else
+
+int ABTD_preempt_init(void)
+{
+    return ABT_ERR_FEATURE_NA;
+}
+
+void ABTD_preempt_finalize(void)
+{
+}
+
+int ABTD_preempt_timer_create(ABTD_preempt_timer *p_timer, long interval_nsec)
+{
+    ABTI_UNUSED(p_timer);
+    ABTI_UNUSED(interval_nsec);
+    return ABT_ERR_FEATURE_NA;
+}
+
+void ABTD_preempt_timer_free(ABTD_preempt_timer *p_timer)
+{
+    ABTI_UNUSED(p_timer);
+}
+
+#endif
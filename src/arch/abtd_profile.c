@@ -0,0 +1,118 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#define _GNU_SOURCE
+#include "abti.h"
+
+#ifdef ABTD_PROFILE_SUPPORTED
+#include <errno.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Older glibc does not name the thread ID field of struct sigevent. */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id  _sigev_un._tid
+#endif
+
+/* Profiling timers deliver SIGPROF like setitimer(ITIMER_PROF). */
+#define ABTD_PROFILE_SIGNAL     SIGPROF
+
+static struct sigaction g_old_action;
+
+static void ABTD_profile_handler(int sig, siginfo_t *p_info, void *p_uc)
+{
+    int saved_errno;
+
+    if (p_info->si_code != SI_TIMER) {
+        /* Not ours.  Pass it to the handler installed before. */
+        if ((g_old_action.sa_flags & SA_SIGINFO) &&
+            g_old_action.sa_sigaction) {
+            g_old_action.sa_sigaction(sig, p_info, p_uc);
+        } else if (g_old_action.sa_handler != SIG_DFL &&
+                   g_old_action.sa_handler != SIG_IGN) {
+            g_old_action.sa_handler(sig);
+        }
+        return;
+    }
+
+    saved_errno = errno;
+    ABTI_profile_sample();
+    errno = saved_errno;
+}
+
+int ABTD_profile_init(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = ABTD_profile_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(ABTD_PROFILE_SIGNAL, &action, &g_old_action) != 0) {
+        return ABT_ERR_OTHER;
+    }
+    return ABT_SUCCESS;
+}
+
+void ABTD_profile_finalize(void)
+{
+    sigaction(ABTD_PROFILE_SIGNAL, &g_old_action, NULL);
+}
+
+/* The timer measures the CPU time of the calling thread, so an idle ES that
+ * sleeps is not sampled. */
+int ABTD_profile_timer_create(ABTD_profile_timer *p_timer, long interval_nsec)
+{
+    struct sigevent sev;
+    struct itimerspec its;
+
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = ABTD_PROFILE_SIGNAL;
+    sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, p_timer) != 0) {
+        return ABT_ERR_OTHER;
+    }
+
+    its.it_interval.tv_sec = interval_nsec / 1000000000;
+    its.it_interval.tv_nsec = interval_nsec % 1000000000;
+    its.it_value = its.it_interval;
+    if (timer_settime(*p_timer, 0, &its, NULL) != 0) {
+        timer_delete(*p_timer);
+        return ABT_ERR_OTHER;
+    }
+    return ABT_SUCCESS;
+}
+
+void ABTD_profile_timer_free(ABTD_profile_timer *p_timer)
+{
+    timer_delete(*p_timer);
+}
+
+#else
+
+int ABTD_profile_init(void)
+{
+    return ABT_ERR_FEATURE_NA;
+}
+
+void ABTD_profile_finalize(void)
+{
+}
+
+int ABTD_profile_timer_create(ABTD_profile_timer *p_timer, long interval_nsec)
+{
+    ABTI_UNUSED(p_timer);
+    ABTI_UNUSED(interval_nsec);
+    return ABT_ERR_FEATURE_NA;
+}
+
+void ABTD_profile_timer_free(ABTD_profile_timer *p_timer)
+{
+    ABTI_UNUSED(p_timer);
+}
+
+#endif
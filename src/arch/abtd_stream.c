@@ -3,13 +3,39 @@
  * See COPYRIGHT in top-level directory.
  */
 
+#define _GNU_SOURCE
 #include "abti.h"
+#include <limits.h>
+#include <sched.h>
+#include <sys/resource.h>
+#if defined(__linux__) && defined(HAVE_SYS_SYSCALL_H)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 int ABTD_xstream_context_create(void *(*f_xstream)(void *), void *p_arg,
                                 ABTD_xstream_context *p_ctx)
 {
     int abt_errno = ABT_SUCCESS;
-    int ret = pthread_create(p_ctx, NULL, f_xstream, p_arg);
+    pthread_attr_t attr;
+    int ret;
+
+    /* The main scheduler of a secondary ES runs on the stack of its OS
+     * thread, so the stack is sized like that of the primary ES's scheduler
+     * (ABT_SCHED_STACKSIZE) rather than by the default of the OS thread
+     * (RLIMIT_STACK, often 8MB). */
+    size_t stacksize = ABTI_global_get_sched_stacksize();
+#ifdef PTHREAD_STACK_MIN
+    if (stacksize < PTHREAD_STACK_MIN) stacksize = PTHREAD_STACK_MIN;
+#endif
+    pthread_attr_init(&attr);
+    if (pthread_attr_setstacksize(&attr, stacksize) != 0) {
+        /* Fall back on the default size */
+        pthread_attr_destroy(&attr);
+        pthread_attr_init(&attr);
+    }
+    ret = pthread_create(p_ctx, &attr, f_xstream, p_arg);
+    pthread_attr_destroy(&attr);
     if (ret != 0) {
         HANDLE_ERROR("pthread_create");
         abt_errno = ABT_ERR_XSTREAM;
@@ -49,3 +75,90 @@ int ABTD_xstream_context_self(ABTD_xstream_context *p_ctx)
     return abt_errno;
 }
 
+
+/* Return the OS thread ID of the caller, or 0 if it is not available. */
+int ABTD_xstream_context_get_tid(void)
+{
+#if defined(__linux__) && defined(HAVE_SYS_SYSCALL_H) && defined(SYS_gettid)
+    return (int)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+/* Convert policy to the OS scheduling policy.  Returns -1 if the OS does not
+ * support it. */
+static int ABTD_xstream_context_get_os_policy(ABT_xstream_os_policy policy)
+{
+    switch (policy) {
+        case ABT_XSTREAM_OS_POLICY_OTHER:   return SCHED_OTHER;
+#ifdef SCHED_BATCH
+        case ABT_XSTREAM_OS_POLICY_BATCH:   return SCHED_BATCH;
+#endif
+#ifdef SCHED_IDLE
+        case ABT_XSTREAM_OS_POLICY_IDLE:    return SCHED_IDLE;
+#endif
+        case ABT_XSTREAM_OS_POLICY_FIFO:    return SCHED_FIFO;
+        case ABT_XSTREAM_OS_POLICY_RR:      return SCHED_RR;
+        default:                            return -1;
+    }
+}
+
+/* Check if the OS supports policy with priority. */
+int ABTD_xstream_context_check_os_priority(ABT_xstream_os_policy policy,
+                                           int priority)
+{
+    int os_policy = ABTD_xstream_context_get_os_policy(policy);
+    if (os_policy == -1) return ABT_ERR_FEATURE_NA;
+
+    if (os_policy == SCHED_FIFO || os_policy == SCHED_RR) {
+        if (priority < sched_get_priority_min(os_policy) ||
+            priority > sched_get_priority_max(os_policy)) {
+            return ABT_ERR_XSTREAM;
+        }
+    } else if (policy == ABT_XSTREAM_OS_POLICY_IDLE) {
+        if (priority != 0) return ABT_ERR_XSTREAM;
+    } else {
+        if (priority < -20 || priority > 19) return ABT_ERR_XSTREAM;
+#if !defined(__linux__)
+        /* The niceness is per process except on Linux. */
+        if (priority != 0) return ABT_ERR_FEATURE_NA;
+#endif
+    }
+    return ABT_SUCCESS;
+}
+
+/* Set the scheduling policy and priority of the OS thread ctx, whose OS
+ * thread ID is tid.  tid is used to set the niceness, which is per thread
+ * on Linux. */
+int ABTD_xstream_context_set_os_priority(ABTD_xstream_context ctx, int tid,
+                                         ABT_xstream_os_policy policy,
+                                         int priority)
+{
+    struct sched_param param;
+    int os_policy = ABTD_xstream_context_get_os_policy(policy);
+    if (os_policy == -1) return ABT_ERR_FEATURE_NA;
+
+    memset(&param, 0, sizeof(param));
+    if (os_policy == SCHED_FIFO || os_policy == SCHED_RR) {
+        param.sched_priority = priority;
+    }
+    if (pthread_setschedparam(ctx, os_policy, &param) != 0) {
+        return ABT_ERR_XSTREAM;
+    }
+    if (os_policy == SCHED_FIFO || os_policy == SCHED_RR ||
+        policy == ABT_XSTREAM_OS_POLICY_IDLE) {
+        return ABT_SUCCESS;
+    }
+
+#if defined(__linux__)
+    if (tid == 0) return ABT_ERR_FEATURE_NA;
+    if (setpriority(PRIO_PROCESS, (id_t)tid, priority) != 0) {
+        return ABT_ERR_XSTREAM;
+    }
+    return ABT_SUCCESS;
+#else
+    ABTI_UNUSED(tid);
+    return (priority == 0) ? ABT_SUCCESS : ABT_ERR_FEATURE_NA;
+#endif
+}
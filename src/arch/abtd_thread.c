@@ -66,6 +66,11 @@ static inline void ABTD_thread_terminate(ABTI_thread *p_thread)
 #if defined(ABT_CONFIG_USE_FCONTEXT)
     ABTD_thread_context *p_fctx = &p_thread->ctx;
 
+    if (gp_ABTI_global->stack_profile == ABT_TRUE) {
+        ABTI_stack_usage_record(p_thread);
+    }
+    ABTI_cpu_time_terminate_thread(p_thread);
+
     /* Now, the ULT has finished its job. Terminate the ULT. */
     if (p_fctx->p_link) {
         /* If p_link is set, it means that other ULT has called the join. */
@@ -73,7 +78,9 @@ static inline void ABTD_thread_terminate(ABTI_thread *p_thread)
         if (p_thread->p_last_xstream == p_joiner->p_last_xstream) {
             /* Only when the current ULT is on the same ES as p_joiner's,
              * we can jump to the joiner ULT. */
+            ABTI_join_counter_dec(p_thread);
             p_thread->state = ABT_THREAD_STATE_TERMINATED;
+            ABTI_xstream_wake_ext_joiners();
             LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] terminated\n",
                       ABTI_thread_get_id(p_thread),
                       p_thread->p_last_xstream->rank);
@@ -84,8 +91,7 @@ static inline void ABTD_thread_terminate(ABTI_thread *p_thread)
             /* If the current ULT's associated ES is different from p_joiner's,
              * we can't directly jump to p_joiner.  Instead, we wake up
              * p_joiner here so that p_joiner's scheduler can resume it. */
-            p_joiner->p_pool = p_thread->p_pool;
-            ABTI_thread_set_ready(p_joiner);
+            ABTD_thread_wake_joiner(p_thread, p_joiner);
 
             /* We don't need to use the atomic operation here because the ULT
              * will be terminated regardless of other requests. */
@@ -101,8 +107,7 @@ static inline void ABTD_thread_terminate(ABTI_thread *p_thread)
                 ABTD_atomic_mem_barrier();
             }
             ABTI_thread *p_joiner = (ABTI_thread *)p_fctx->p_link;
-            p_joiner->p_pool = p_thread->p_pool;
-            ABTI_thread_set_ready((ABTI_thread *)p_fctx->p_link);
+            ABTD_thread_wake_joiner(p_thread, p_joiner);
         }
     }
 
@@ -133,6 +138,24 @@ static inline void ABTD_thread_terminate(ABTI_thread *p_thread)
 #endif
 }
 
+/* Wake up p_joiner, which has blocked to join p_thread or to wait on its join
+ * counter, from p_thread's ES.  p_joiner goes back to its own pool so that it
+ * stays on its ES.  Only if the pool does not accept units from other ESs,
+ * p_joiner is moved to p_thread's pool. */
+void ABTD_thread_wake_joiner(ABTI_thread *p_thread, ABTI_thread *p_joiner)
+{
+    ABT_pool_access access = p_joiner->p_pool->access;
+    if (p_joiner->p_pool != p_thread->p_pool &&
+        (access == ABT_POOL_ACCESS_PRIV ||
+         access == ABT_POOL_ACCESS_SPSC ||
+         access == ABT_POOL_ACCESS_SPMC)) {
+        ABTI_pool_dec_num_blocked(p_joiner->p_pool);
+        ABTI_pool_inc_num_blocked(p_thread->p_pool);
+        p_joiner->p_pool = p_thread->p_pool;
+    }
+    ABTI_thread_set_ready(p_joiner);
+}
+
 void ABTD_thread_cancel(ABTI_thread *p_thread)
 {
     /* When we cancel a ULT, if other ULT is blocked to join the canceled ULT,
@@ -4,6 +4,23 @@
  */
 
 #include "abti.h"
+#include <strings.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/* Time over which the cycle counter is calibrated against ABTD_time, and the
+ * number of readings of each end of it, of which the one that has the fewest
+ * cycles between the reads of the two clocks is used */
+#define ABTD_TIME_CALIBRATION_SEC   0.005
+#define ABTD_TIME_CALIBRATION_READS 5
+
+int g_ABTD_time_ticks_source = ABTD_TIME_TICKS_UNKNOWN;
+double g_ABTD_time_sec_per_tick = 1.0e-9;
+uint64_t g_ABTD_time_base_ticks = 0;
+double g_ABTD_time_base_sec = 0.0;
+
+static pthread_once_t g_ABTD_time_ticks_once = PTHREAD_ONCE_INIT;
 
 #if defined(HAVE_MACH_ABSOLUTE_TIME)
 static double g_time_mult = 0.0;
@@ -16,6 +33,7 @@ void ABTD_time_init(void)
     mach_timebase_info(&info);
     g_time_mult = 1.0e-9 * ((double)info.numer / (double)info.denom);
 #endif
+    ABTD_time_init_ticks();
 }
 
 /* Obtain the time value */
@@ -51,3 +69,124 @@ double ABTD_time_read_sec(ABTD_time *p_time)
     return secs;
 }
 
+/* Whether the cycle counter ticks at a constant rate that is the same on all
+ * the cores.  ABT_TIME_SOURCE=clock disables it. */
+static ABT_bool ABTD_time_has_constant_cycles(void)
+{
+    char *env = getenv("ABT_TIME_SOURCE");
+    if (env == NULL) env = getenv("ABT_ENV_TIME_SOURCE");
+    if (env != NULL && strcasecmp(env, "clock") == 0) return ABT_FALSE;
+
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    FILE *p_file;
+    char buf[32];
+
+    /* Invariant TSC */
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0 ||
+        !(edx & (1u << 8))) {
+        return ABT_FALSE;
+    }
+    /* Linux stops using the TSC as its clock source if it finds that the TSC
+     * is not synchronized across the cores. */
+    p_file = fopen("/sys/devices/system/clocksource/clocksource0/"
+                   "current_clocksource", "r");
+    if (p_file) {
+        ABT_bool is_tsc = ABT_TRUE;
+        if (fgets(buf, sizeof(buf), p_file) && strncmp(buf, "tsc", 3) != 0) {
+            is_tsc = ABT_FALSE;
+        }
+        fclose(p_file);
+        return is_tsc;
+    }
+    return ABT_TRUE;
+#elif defined(__aarch64__)
+    /* The generic timer has a constant frequency. */
+    return ABT_TRUE;
+#else
+    return ABT_FALSE;
+#endif
+}
+
+#if !defined(__aarch64__)
+/* Read ABTD_time and the cycle counter at the same moment.  A reading that is
+ * interrupted between the two clocks would skew the calibration, so the one
+ * with the fewest cycles around the read of ABTD_time is returned. */
+static void ABTD_time_read_pair(double *p_sec, uint64_t *p_cycles)
+{
+    uint64_t best = UINT64_MAX;
+    int i;
+
+    for (i = 0; i < ABTD_TIME_CALIBRATION_READS; i++) {
+        ABTD_time t;
+        uint64_t before = ABTD_time_get_cycles();
+        ABTD_time_get(&t);
+        uint64_t after = ABTD_time_get_cycles();
+        if (after >= before && after - before < best) {
+            best = after - before;
+            *p_sec = ABTD_time_read_sec(&t);
+            *p_cycles = before + (after - before) / 2;
+        }
+    }
+    if (best == UINT64_MAX) {
+        ABTD_time t;
+        ABTD_time_get(&t);
+        *p_sec = ABTD_time_read_sec(&t);
+        *p_cycles = ABTD_time_get_cycles();
+    }
+}
+#endif
+
+/* Choose the source of ABTD_time_get_ticks() and calibrate it.  This is run
+ * only once per process, so the globals are written by a single caller. */
+static void ABTD_time_calibrate_ticks(void)
+{
+    int source = ABTD_TIME_TICKS_CLOCK;
+    double sec_per_tick = 1.0e-9;
+    ABTD_time t;
+
+    if (ABTD_time_has_constant_cycles() == ABT_TRUE) {
+#if defined(__aarch64__)
+        uint64_t freq;
+        __asm__ __volatile__ ("mrs %0, cntfrq_el0" : "=r" (freq));
+        if (freq > 0) {
+            sec_per_tick = 1.0 / (double)freq;
+            source = ABTD_TIME_TICKS_CYCLES;
+        }
+#else
+        double start, now;
+        uint64_t start_cycles, cycles;
+        ABTD_time_read_pair(&start, &start_cycles);
+        do {
+            ABTD_time_get(&t);
+            now = ABTD_time_read_sec(&t);
+        } while (now - start < ABTD_TIME_CALIBRATION_SEC && now >= start);
+        ABTD_time_read_pair(&now, &cycles);
+        if (now > start && cycles > start_cycles) {
+            sec_per_tick = (now - start) / (double)(cycles - start_cycles);
+            source = ABTD_TIME_TICKS_CYCLES;
+        }
+#endif
+    }
+
+    /* Pairs of ticks and seconds at the same moment, which ABT_get_wtime()
+     * uses to convert ticks to the time of ABTD_time */
+    ABTD_time_get(&t);
+    g_ABTD_time_base_sec = ABTD_time_read_sec(&t);
+    g_ABTD_time_base_ticks = (source == ABTD_TIME_TICKS_CYCLES)
+                           ? ABTD_time_get_cycles()
+                           : (uint64_t)(g_ABTD_time_base_sec * 1.0e9);
+    g_ABTD_time_sec_per_tick = sec_per_tick;
+    ABTD_atomic_mem_barrier();
+    *(volatile int *)&g_ABTD_time_ticks_source = source;
+}
+
+/* Return the source of ABTD_time_get_ticks(), calibrating it at the first
+ * call.  Concurrent callers wait for the first one and get the same result. */
+int ABTD_time_init_ticks(void)
+{
+    if (*(volatile int *)&g_ABTD_time_ticks_source == ABTD_TIME_TICKS_UNKNOWN) {
+        pthread_once(&g_ABTD_time_ticks_once, ABTD_time_calibrate_ticks);
+    }
+    return g_ABTD_time_ticks_source;
+}
@@ -0,0 +1,96 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+
+#define ABTD_XSAVE_CPUID_LEAF       0xd
+#define ABTD_XSAVE_CPUID_XSAVE      (1u << 26)  /* CPUID.1:ECX */
+#define ABTD_XSAVE_CPUID_OSXSAVE    (1u << 27)  /* CPUID.1:ECX */
+#define ABTD_XSAVE_CPUID_XSAVEOPT   (1u << 0)   /* CPUID.(0xd,1):EAX */
+
+static size_t g_xsave_size = 0;     /* 0 if XSAVE is not usable */
+static uint32_t g_xsave_mask_lo = 0;
+static uint32_t g_xsave_mask_hi = 0;
+static int g_xsave_opt = 0;
+
+void ABTD_xsave_init(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    uint32_t xcr0_lo, xcr0_hi;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return;
+    if (!(ecx & ABTD_XSAVE_CPUID_XSAVE) || !(ecx & ABTD_XSAVE_CPUID_OSXSAVE)) {
+        return;
+    }
+
+    /* The state components enabled by the OS */
+    __asm__ __volatile__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    g_xsave_mask_lo = xcr0_lo;
+    g_xsave_mask_hi = xcr0_hi;
+
+    /* EBX is the size of the area for the components enabled in XCR0. */
+    __cpuid_count(ABTD_XSAVE_CPUID_LEAF, 0, eax, ebx, ecx, edx);
+    g_xsave_size = ebx;
+
+    __cpuid_count(ABTD_XSAVE_CPUID_LEAF, 1, eax, ebx, ecx, edx);
+    g_xsave_opt = (eax & ABTD_XSAVE_CPUID_XSAVEOPT) ? 1 : 0;
+}
+
+size_t ABTD_xsave_get_size(void)
+{
+    return g_xsave_size;
+}
+
+/* XSAVEOPT does not write the components that are in their initial state or
+ * have not been modified since the last XRSTOR from the same area, so the
+ * upper vector state of a ULT that has not used it is not copied. */
+void ABTD_xsave_save(void *p_area)
+{
+    if (g_xsave_opt) {
+        __asm__ __volatile__ ("xsaveopt64 (%0)"
+                              : : "r"(p_area), "a"(g_xsave_mask_lo),
+                                  "d"(g_xsave_mask_hi)
+                              : "memory");
+    } else {
+        __asm__ __volatile__ ("xsave64 (%0)"
+                              : : "r"(p_area), "a"(g_xsave_mask_lo),
+                                  "d"(g_xsave_mask_hi)
+                              : "memory");
+    }
+}
+
+void ABTD_xsave_restore(void *p_area)
+{
+    __asm__ __volatile__ ("xrstor64 (%0)"
+                          : : "r"(p_area), "a"(g_xsave_mask_lo),
+                              "d"(g_xsave_mask_hi)
+                          : "memory");
+}
+
+#else
+
+void ABTD_xsave_init(void)
+{
+}
+
+size_t ABTD_xsave_get_size(void)
+{
+    return 0;
+}
+
+void ABTD_xsave_save(void *p_area)
+{
+    ABTI_UNUSED(p_area);
+}
+
+void ABTD_xsave_restore(void *p_area)
+{
+    ABTI_UNUSED(p_area);
+}
+
+#endif
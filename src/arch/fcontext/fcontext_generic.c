@@ -0,0 +1,110 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* fcontext in C for the platforms without an assembly port.
+ *
+ * A context is switched with sigsetjmp() and siglongjmp() without saving the
+ * signal mask, so no system call is made unlike swapcontext(), which sets the
+ * signal mask at every switch.  Only the first switch to a context made by
+ * make_fcontext() uses setcontext() to move to the new stack.
+ *
+ * Like the assembly ports, the context data of a suspended context lives on
+ * its stack: in the frame of jump_fcontext() for a running context, and at
+ * the top of the stack for a new context.  fcontext_t points to it. */
+
+/* The checked longjmp of glibc rejects jumps to another stack. */
+#undef _FORTIFY_SOURCE
+#define _GNU_SOURCE
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "abti.h"
+
+typedef struct ABTD_fcontext_data {
+    sigjmp_buf env;                 /* Registers of the suspended context */
+    void *arg;                      /* Value passed by the last switch */
+    void (*f_start)(void *);        /* Function of a context not started */
+    ucontext_t *p_uc;               /* Entry of a context not started */
+} ABTD_fcontext_data;
+
+/* Context data and the entry of a new context */
+typedef struct {
+    ABTD_fcontext_data data;
+    ucontext_t uc;
+} ABTD_fcontext_start;
+
+/* New context that is being started on this OS thread */
+static ABTD_XSTREAM_LOCAL ABTD_fcontext_data *lp_start = NULL;
+
+static void ABTD_fcontext_entry(void)
+{
+    ABTD_fcontext_data *p_data = lp_start;
+    void (*f_start)(void *) = p_data->f_start;
+
+    p_data->f_start = NULL;
+    f_start(p_data->arg);
+
+    /* Same as the assembly ports when the function returns */
+    _exit(0);
+}
+
+static void ABTD_fcontext_resume(ABTD_fcontext_data *p_new, void *arg)
+{
+    p_new->arg = arg;
+    if (p_new->f_start) {
+        lp_start = p_new;
+        setcontext(p_new->p_uc);
+    } else {
+        siglongjmp(p_new->env, 1);
+    }
+    /* Never reached */
+    abort();
+}
+
+fcontext_t make_fcontext(void *sp, size_t size, void (*thread_func)(void *))
+{
+    uintptr_t bottom = (uintptr_t)sp - size;
+    uintptr_t top = ((uintptr_t)sp - sizeof(ABTD_fcontext_start))
+                  & ~(uintptr_t)15;
+    ABTD_fcontext_start *p_start = (ABTD_fcontext_start *)top;
+
+    p_start->data.arg = NULL;
+    p_start->data.f_start = thread_func;
+    p_start->data.p_uc = &p_start->uc;
+
+    if (getcontext(&p_start->uc) != 0) abort();
+    p_start->uc.uc_link = NULL;
+    p_start->uc.uc_stack.ss_sp = (void *)bottom;
+    p_start->uc.uc_stack.ss_size = top - bottom;
+    makecontext(&p_start->uc, ABTD_fcontext_entry, 0);
+    return (fcontext_t)&p_start->data;
+}
+
+void *jump_fcontext(fcontext_t *old, fcontext_t new, void *arg, int fpu_flags)
+{
+    ABTD_fcontext_data data;
+    ABTI_UNUSED(fpu_flags);
+
+    data.f_start = NULL;
+    data.p_uc = NULL;
+    *old = (fcontext_t)&data;
+    if (sigsetjmp(data.env, 0) == 0) {
+        ABTD_fcontext_resume((ABTD_fcontext_data *)new, arg);
+    }
+    /* Resumed by another context */
+    return *(void * volatile *)&data.arg;
+}
+
+void *take_fcontext(fcontext_t *old, fcontext_t new, void *arg, int fpu_flags)
+{
+    ABTI_UNUSED(old);
+    ABTI_UNUSED(fpu_flags);
+
+    ABTD_fcontext_resume((ABTD_fcontext_data *)new, arg);
+    return NULL;
+}
@@ -5,6 +5,15 @@
 
 #include "abti.h"
 
+/* Timed waiter kept in a slot of a centralized barrier */
+typedef struct {
+    ABTI_timeout timeout;
+    uint32_t pos;               /* Slot of this waiter */
+} ABTI_barrier_timed;
+
+static void ABTI_barrier_release(ABTI_barrier *p_barrier);
+static int ABTI_barrier_wait_tree(ABTI_barrier *p_barrier);
+
 
 /** @defgroup BARRIER Barrier
  * This group is for Barrier.
@@ -29,7 +38,8 @@ int ABT_barrier_create(uint32_t num_waiters, ABT_barrier *newbarrier)
     int abt_errno = ABT_SUCCESS;
     ABTI_barrier *p_newbarrier;
 
-    p_newbarrier = (ABTI_barrier *)ABTU_malloc(sizeof(ABTI_barrier));
+    p_newbarrier = (ABTI_barrier *)
+        ABTU_malloc_cache_aligned(sizeof(ABTI_barrier));
 
     ABTI_spinlock_create(&p_newbarrier->lock);
     p_newbarrier->num_waiters = num_waiters;
@@ -38,6 +48,7 @@ int ABT_barrier_create(uint32_t num_waiters, ABT_barrier *newbarrier)
         (ABTI_thread **)ABTU_malloc(num_waiters * sizeof(ABTI_thread *));
     p_newbarrier->waiter_type =
         (ABT_unit_type *)ABTU_malloc(num_waiters * sizeof(ABT_unit_type));
+    p_newbarrier->p_tree = NULL;
 
     /* Return value */
     *newbarrier = ABTI_barrier_get_handle(p_newbarrier);
@@ -45,6 +56,54 @@ int ABT_barrier_create(uint32_t num_waiters, ABT_barrier *newbarrier)
     return abt_errno;
 }
 
+/**
+ * @ingroup BARRIER
+ * @brief   Create a new barrier whose arrivals are combined in a tree.
+ *
+ * \c ABT_barrier_create_tree() creates a new barrier like
+ * \c ABT_barrier_create(), but the waiters do not take a lock to arrive.
+ * Instead, they are counted in a combining tree whose leaves take up to
+ * \c radix waiters each and whose internal nodes take up to \c radix children
+ * each.  Only the last waiter to arrive at a node goes up to its parent, so
+ * each counter is updated by at most \c radix waiters.  The waiters running on
+ * the same NUMA node start from the same group of leaves.  If \c radix is
+ * zero, a default value is used.
+ *
+ * This barrier is suitable for a large number of waiters.  The barrier is used
+ * with \c ABT_barrier_wait(), \c ABT_barrier_reinit(), and
+ * \c ABT_barrier_free() like the one created by \c ABT_barrier_create().
+ *
+ * @param[in]  num_waiters  number of waiters
+ * @param[in]  radix        maximum number of children of each node
+ * @param[out] newbarrier   handle to a new barrier
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_BARRIER \c num_waiters is zero
+ */
+int ABT_barrier_create_tree(uint32_t num_waiters, uint32_t radix,
+                            ABT_barrier *newbarrier)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_barrier *p_newbarrier;
+    ABT_barrier h_newbarrier = ABT_BARRIER_NULL;
+
+    ABTI_CHECK_TRUE(num_waiters > 0, ABT_ERR_BARRIER);
+
+    abt_errno = ABT_barrier_create(num_waiters, &h_newbarrier);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_newbarrier = ABTI_barrier_get_ptr(h_newbarrier);
+    p_newbarrier->p_tree = ABTI_barrier_tree_create(num_waiters, radix);
+
+  fn_exit:
+    /* Return value */
+    *newbarrier = h_newbarrier;
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup BARRIER
  * @brief   Reinitialize the barrier.
@@ -82,6 +141,14 @@ int ABT_barrier_reinit(ABT_barrier barrier, uint32_t num_waiters)
             (ABT_unit_type *)ABTU_malloc(num_waiters * sizeof(ABT_unit_type));
     }
 
+    /* The tree is rebuilt since its shape depends on num_waiters. */
+    if (p_barrier->p_tree) {
+        uint32_t radix = p_barrier->p_tree->radix;
+        ABTI_CHECK_TRUE(num_waiters > 0, ABT_ERR_BARRIER);
+        ABTI_barrier_tree_free(p_barrier->p_tree);
+        p_barrier->p_tree = ABTI_barrier_tree_create(num_waiters, radix);
+    }
+
   fn_exit:
     return abt_errno;
 
@@ -119,6 +186,7 @@ int ABT_barrier_free(ABT_barrier *barrier)
     ABTI_spinlock_free(&p_barrier->lock);
     ABTU_free(p_barrier->waiters);
     ABTU_free(p_barrier->waiter_type);
+    if (p_barrier->p_tree) ABTI_barrier_tree_free(p_barrier->p_tree);
     ABTU_free(p_barrier);
 
     /* Return value */
@@ -150,6 +218,12 @@ int ABT_barrier_wait(ABT_barrier barrier)
     ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
     uint32_t pos;
 
+    if (p_barrier->p_tree) {
+        abt_errno = ABTI_barrier_wait_tree(p_barrier);
+        ABTI_CHECK_ERROR(abt_errno);
+        goto fn_exit;
+    }
+
     ABTI_spinlock_acquire(&p_barrier->lock);
 
     ABTI_ASSERT(p_barrier->counter < p_barrier->num_waiters);
@@ -159,7 +233,7 @@ int ABT_barrier_wait(ABT_barrier barrier)
     if (p_barrier->counter < p_barrier->num_waiters) {
         ABTI_thread *p_thread;
         ABT_unit_type type;
-        volatile int ext_signal = 0;
+        uint32_t ext_signal = ABTD_FUTEX_SIGNAL_INIT;
 
         if (lp_ABTI_local != NULL) {
             p_thread = ABTI_local_get_thread();
@@ -189,32 +263,95 @@ int ABT_barrier_wait(ABT_barrier barrier)
             /* Suspend the current ULT */
             ABTI_thread_suspend(p_thread);
         } else {
-            /* External thread is waiting here polling ext_signal. */
-            /* FIXME: need a better implementation */
-            while (!ext_signal);
+            /* External thread is waiting here for ext_signal. */
+            ABTD_futex_signal_wait(&ext_signal);
         }
     } else {
-        /* Signal all the waiting ULTs */
-        int i;
-        for (i = 0; i < p_barrier->num_waiters - 1; i++) {
-            ABTI_thread *p_thread = p_barrier->waiters[i];
-            if (p_barrier->waiter_type[i] == ABT_UNIT_TYPE_THREAD) {
-                ABTI_thread_set_ready(p_thread);
-            } else {
-                /* When p_cur is an external thread */
-                volatile int *p_ext_signal = (volatile int *)p_thread;
-                *p_ext_signal = 1;
-            }
+        ABTI_barrier_release(p_barrier);
+    }
 
-            p_barrier->waiters[i] = NULL;
-        }
+  fn_exit:
+    return abt_errno;
 
-        /* Reset counter */
-        p_barrier->counter = 0;
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup BARRIER
+ * @brief   Wait on the barrier with a timeout.
+ *
+ * \c ABT_barrier_timedwait() works like \c ABT_barrier_wait() but gives up
+ * waiting if the other waiters do not arrive before the absolute time
+ * \c abstime.  In that case, the arrival of the caller is withdrawn and
+ * \c ABT_ERR_TIMEDOUT is returned, so the round still needs as many waiters
+ * as before.  A waiting ULT is woken up by the scheduler of its ES once the
+ * deadline passes, so it may return somewhat later than \c abstime.
+ *
+ * Timed waits are not supported by barriers created by
+ * \c ABT_barrier_create_tree(), since their arrivals cannot be withdrawn.
+ *
+ * @param[in] barrier  handle to the barrier
+ * @param[in] abstime  absolute time for timeout
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_TIMEDOUT   the deadline has passed
+ * @retval ABT_ERR_FEATURE_NA \c barrier is a tree barrier
+ */
+int ABT_barrier_timedwait(ABT_barrier barrier, const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
+    ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
+    ABTI_CHECK_TRUE(p_barrier->p_tree == NULL, ABT_ERR_FEATURE_NA);
+    ABTI_CHECK_TRUE(lp_ABTI_local == NULL || ABTI_local_get_thread() != NULL,
+                    ABT_ERR_BARRIER);
+
+    ABTI_spinlock_acquire(&p_barrier->lock);
+
+    ABTI_ASSERT(p_barrier->counter < p_barrier->num_waiters);
+
+    if (p_barrier->counter + 1 < p_barrier->num_waiters) {
+        ABTI_barrier_timed timed;
+        uint32_t last;
+
+        timed.pos = p_barrier->counter++;
+        ABTI_timeout_prepare(&timed.timeout, ABTI_timeout_convert(abstime));
+        p_barrier->waiters[timed.pos] = (ABTI_thread *)&timed;
+        p_barrier->waiter_type[timed.pos] = ABTI_UNIT_TYPE_TIMED;
 
         ABTI_spinlock_release(&p_barrier->lock);
+
+        if (ABTI_timeout_wait(&timed.timeout) == ABT_TRUE) goto fn_exit;
+
+        /* If the slot has been cleared, the round has been completed while
+         * the deadline was passing. */
+        ABTI_spinlock_acquire(&p_barrier->lock);
+        if (p_barrier->waiters[timed.pos] != (ABTI_thread *)&timed) {
+            ABTI_spinlock_release(&p_barrier->lock);
+            goto fn_exit;
+        }
+
+        /* Withdraw the arrival by moving the last waiter into the slot */
+        last = --p_barrier->counter;
+        if (timed.pos != last) {
+            ABTI_thread *p_last = p_barrier->waiters[last];
+            p_barrier->waiters[timed.pos] = p_last;
+            p_barrier->waiter_type[timed.pos] = p_barrier->waiter_type[last];
+            if (p_barrier->waiter_type[last] == ABTI_UNIT_TYPE_TIMED) {
+                ((ABTI_barrier_timed *)p_last)->pos = timed.pos;
+            }
+        }
+        p_barrier->waiters[last] = NULL;
+        ABTI_spinlock_release(&p_barrier->lock);
+        return ABT_ERR_TIMEDOUT;
     }
 
+    /* The last waiter does not wait. */
+    p_barrier->counter++;
+    ABTI_barrier_release(p_barrier);
+
   fn_exit:
     return abt_errno;
 
@@ -252,3 +389,185 @@ int ABT_barrier_get_num_waiters(ABT_barrier barrier, uint32_t *num_waiters)
     goto fn_exit;
 }
 
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* Build a tree for num_waiters waiters.  The leaves are stored first, and the
+ * nodes of each upper level follow the level below, so the root is the last
+ * node.  Each leaf owns capacity consecutive entries of the waiter arrays
+ * starting from first_slot. */
+ABTI_barrier_tree *ABTI_barrier_tree_create(uint32_t num_waiters,
+                                            uint32_t radix)
+{
+    ABTI_barrier_tree *p_tree;
+    uint32_t num_nodes, level_size, level_start, i;
+
+    ABTI_ASSERT(num_waiters > 0);
+    if (radix < 2) radix = ABTI_BARRIER_TREE_DEFAULT_RADIX;
+
+    /* Count the nodes */
+    level_size = (num_waiters + radix - 1) / radix;
+    num_nodes = level_size;
+    while (level_size > 1) {
+        level_size = (level_size + radix - 1) / radix;
+        num_nodes += level_size;
+    }
+
+    p_tree = (ABTI_barrier_tree *)
+        ABTU_malloc_cache_aligned(sizeof(ABTI_barrier_tree));
+    p_tree->p_nodes = (ABTI_barrier_tree_node *)
+        ABTU_malloc_cache_aligned(num_nodes * sizeof(ABTI_barrier_tree_node));
+    p_tree->num_waiters = num_waiters;
+    p_tree->radix = radix;
+    p_tree->num_leaves = (num_waiters + radix - 1) / radix;
+    p_tree->num_numa_nodes = (uint32_t)ABTD_affinity_get_num_nodes();
+    if (p_tree->num_numa_nodes > p_tree->num_leaves) {
+        p_tree->num_numa_nodes = p_tree->num_leaves;
+    }
+    p_tree->round = 0;
+
+    /* Leaves */
+    for (i = 0; i < p_tree->num_leaves; i++) {
+        ABTI_barrier_tree_node *p_node = &p_tree->p_nodes[i];
+        uint32_t first = i * radix;
+        p_node->num_reserved = 0;
+        p_node->num_arrived = 0;
+        p_node->first_slot = first;
+        p_node->capacity = (num_waiters - first < radix)
+                         ? num_waiters - first : radix;
+        p_node->p_parent = NULL;
+    }
+
+    /* Upper levels */
+    level_start = 0;
+    level_size = p_tree->num_leaves;
+    while (level_size > 1) {
+        uint32_t next_start = level_start + level_size;
+        uint32_t next_size = (level_size + radix - 1) / radix;
+        for (i = 0; i < next_size; i++) {
+            ABTI_barrier_tree_node *p_node = &p_tree->p_nodes[next_start + i];
+            uint32_t first = i * radix;
+            uint32_t j;
+            p_node->num_reserved = 0;
+            p_node->num_arrived = 0;
+            p_node->first_slot = 0;
+            p_node->capacity = (level_size - first < radix)
+                             ? level_size - first : radix;
+            p_node->p_parent = NULL;
+            for (j = 0; j < p_node->capacity; j++) {
+                p_tree->p_nodes[level_start + first + j].p_parent = p_node;
+            }
+        }
+        level_start = next_start;
+        level_size = next_size;
+    }
+
+    return p_tree;
+}
+
+void ABTI_barrier_tree_free(ABTI_barrier_tree *p_tree)
+{
+    ABTU_free(p_tree->p_nodes);
+    ABTU_free(p_tree);
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+/* Wake up all the waiters of the completed round.  The caller has to hold the
+ * lock, which is released here. */
+static void ABTI_barrier_release(ABTI_barrier *p_barrier)
+{
+    /* Signal all the waiting ULTs */
+    uint32_t i;
+    for (i = 0; i < p_barrier->num_waiters - 1; i++) {
+        ABTI_thread *p_thread = p_barrier->waiters[i];
+        if (p_barrier->waiter_type[i] == ABT_UNIT_TYPE_THREAD) {
+            ABTI_thread_set_ready(p_thread);
+        } else if (p_barrier->waiter_type[i] == ABTI_UNIT_TYPE_TIMED) {
+            ABTI_barrier_timed *p_timed = (ABTI_barrier_timed *)p_thread;
+            ABTI_timeout_signal(&p_timed->timeout);
+        } else {
+            /* When p_cur is an external thread */
+            ABTD_futex_signal_set((uint32_t *)p_thread);
+        }
+
+        p_barrier->waiters[i] = NULL;
+    }
+
+    /* Reset counter */
+    p_barrier->counter = 0;
+
+    ABTI_spinlock_release(&p_barrier->lock);
+}
+
+static int ABTI_barrier_wait_tree(ABTI_barrier *p_barrier)
+{
+    ABTI_barrier_tree *p_tree = p_barrier->p_tree;
+    ABTI_barrier_tree_node *p_leaf;
+    ABTI_thread *p_thread = NULL;
+    ABT_unit_type type;
+    uint64_t round;
+    uint32_t pos;
+
+    if (lp_ABTI_local != NULL) {
+        p_thread = ABTI_local_get_thread();
+        if (p_thread == NULL) return ABT_ERR_BARRIER;
+        type = ABT_UNIT_TYPE_THREAD;
+        /* The ULT has to be blocked before it is visible to the last waiter,
+         * which makes the ULTs ready without a lock. */
+        ABTI_thread_set_blocked(p_thread);
+    } else {
+        /* external thread */
+        type = ABT_UNIT_TYPE_EXT;
+    }
+
+    pos = ABTI_barrier_tree_reserve(p_tree, &round, &p_leaf);
+    p_barrier->waiters[pos] = p_thread;
+    p_barrier->waiter_type[pos] = type;
+
+    if (ABTI_barrier_tree_arrive(p_leaf, round) == ABT_FALSE) {
+        if (type == ABT_UNIT_TYPE_THREAD) {
+            /* Suspend the current ULT */
+            ABTI_thread_suspend(p_thread);
+        } else {
+            /* External thread is waiting here polling the round. */
+            while (ABTI_barrier_tree_is_released(p_tree, round) == ABT_FALSE) {
+                ABTD_atomic_pause();
+            }
+        }
+    } else {
+        /* All the other waiters have arrived.  The waiting ULTs are collected
+         * before the round is released because the slots are reused by the
+         * waiters of the next round once it is released. */
+        ABTI_unit *p_threads = NULL;
+        uint32_t i;
+
+        if (type == ABT_UNIT_TYPE_THREAD) {
+            ABTI_thread_unset_blocked(p_thread);
+        }
+        for (i = 0; i < p_tree->num_waiters; i++) {
+            ABTI_thread *p_waiter;
+            ABTI_unit *p_unit;
+            if (i == pos || p_barrier->waiter_type[i] != ABT_UNIT_TYPE_THREAD) {
+                continue;
+            }
+            p_waiter = p_barrier->waiters[i];
+            p_unit = &p_waiter->unit_def;
+            p_unit->thread = ABTI_thread_get_handle(p_waiter);
+            p_unit->type = ABT_UNIT_TYPE_THREAD;
+            p_unit->p_next = p_threads;
+            p_threads = p_unit;
+        }
+
+        /* Release external threads, and then wake up the ULTs. */
+        ABTI_barrier_tree_release(p_tree, round);
+        ABTI_thread_set_ready_list(p_threads);
+    }
+    return ABT_SUCCESS;
+}
@@ -0,0 +1,461 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+static int ABTI_channel_send_many(ABTI_channel *p_channel, int num_msgs,
+                                  void **msgs);
+static int ABTI_channel_recv_many(ABTI_channel *p_channel, int num_msgs,
+                                  void **msgs);
+
+
+/** @defgroup CHANNEL Channel
+ * A \a channel is a bounded FIFO queue of messages, i.e., pointers, that any
+ * number of ULTs, tasklets, and external threads can send to and receive
+ * from.  A sender waits while the channel is full and a receiver waits while
+ * it is empty.  A message is passed from a sender directly to a waiting
+ * receiver, and a receiver that makes room moves the message of a waiting
+ * sender into the channel, so a woken waiter does not have to access the
+ * channel again.  Waiters are served in FIFO order.
+ */
+
+/**
+ * @ingroup CHANNEL
+ * @brief   Create a new channel.
+ *
+ * \c ABT_channel_create() creates a new channel that can hold \c capacity
+ * messages and returns its handle through \c newchannel.  If \c capacity is
+ * zero, a sender waits until a receiver takes its message.
+ *
+ * @param[in]  capacity    maximum number of messages in the channel
+ * @param[out] newchannel  handle to a new channel
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_channel_create(size_t capacity, ABT_channel *newchannel)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_channel *p_channel;
+
+    p_channel = (ABTI_channel *)ABTU_malloc(sizeof(ABTI_channel) +
+                                            capacity * sizeof(void *));
+    ABTI_spinlock_create(&p_channel->lock);
+    p_channel->capacity = capacity;
+    p_channel->head = 0;
+    p_channel->count = 0;
+    p_channel->buf = (void **)(p_channel + 1);
+    p_channel->num_senders = 0;
+    p_channel->num_receivers = 0;
+    p_channel->p_send_head = NULL;
+    p_channel->p_send_tail = NULL;
+    p_channel->p_recv_head = NULL;
+    p_channel->p_recv_tail = NULL;
+
+    *newchannel = ABTI_channel_get_handle(p_channel);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup CHANNEL
+ * @brief   Free the channel.
+ *
+ * \c ABT_channel_free() releases the channel \c channel.  No work unit may be
+ * waiting on \c channel.  Messages left in \c channel are discarded.  If it
+ * is successfully processed, \c channel is set to \c ABT_CHANNEL_NULL.
+ *
+ * @param[in,out] channel  handle to the channel
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_CHANNEL there are waiters
+ */
+int ABT_channel_free(ABT_channel *channel)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_channel *p_channel = ABTI_channel_get_ptr(*channel);
+    ABTI_CHECK_NULL_CHANNEL_PTR(p_channel);
+
+    ABTI_spinlock_acquire(&p_channel->lock);
+    if (p_channel->num_senders > 0 || p_channel->num_receivers > 0) {
+        ABTI_spinlock_release(&p_channel->lock);
+        abt_errno = ABT_ERR_CHANNEL;
+        goto fn_fail;
+    }
+    ABTI_spinlock_free(&p_channel->lock);
+    ABTU_free(p_channel);
+
+    *channel = ABT_CHANNEL_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup CHANNEL
+ * @brief   Send a message to the channel.
+ *
+ * \c ABT_channel_send() sends \c msg to the channel \c channel.  If a work
+ * unit is waiting to receive, \c msg is passed to the first of them.
+ * Otherwise, if \c channel is full, the caller waits until a receiver takes
+ * \c msg.  A ULT is blocked while waiting, and an external thread polls.  A
+ * tasklet cannot wait, so \c ABT_ERR_CHANNEL is returned instead and \c msg
+ * is not sent.
+ *
+ * @param[in] channel  handle to the channel
+ * @param[in] msg      message to send
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_CHANNEL a tasklet would have to wait
+ */
+int ABT_channel_send(ABT_channel channel, void *msg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_channel *p_channel = ABTI_channel_get_ptr(channel);
+    ABTI_CHECK_NULL_CHANNEL_PTR(p_channel);
+
+    abt_errno = ABTI_channel_send_many(p_channel, 1, &msg);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup CHANNEL
+ * @brief   Receive a message from the channel.
+ *
+ * \c ABT_channel_recv() receives the oldest message of the channel
+ * \c channel and returns it through \c msg.  If \c channel is empty, the
+ * caller waits until a sender passes a message to it.  A ULT is blocked while
+ * waiting, and an external thread polls.  A tasklet cannot wait, so
+ * \c ABT_ERR_CHANNEL is returned instead.
+ *
+ * @param[in]  channel  handle to the channel
+ * @param[out] msg      received message
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_CHANNEL a tasklet would have to wait
+ */
+int ABT_channel_recv(ABT_channel channel, void **msg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_channel *p_channel = ABTI_channel_get_ptr(channel);
+    ABTI_CHECK_NULL_CHANNEL_PTR(p_channel);
+
+    abt_errno = ABTI_channel_recv_many(p_channel, 1, msg);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup CHANNEL
+ * @brief   Send messages to the channel.
+ *
+ * \c ABT_channel_send_many() sends \c num_msgs messages in \c msgs to the
+ * channel \c channel in order, as \c ABT_channel_send() does for each of
+ * them.  The lock of \c channel is taken once for all the messages that can
+ * be sent without waiting, and the receivers they are passed to are woken up
+ * after it is released.  A tasklet either sends all the messages without
+ * waiting or gets \c ABT_ERR_CHANNEL without sending any of them.
+ *
+ * @param[in] channel   handle to the channel
+ * @param[in] num_msgs  number of messages
+ * @param[in] msgs      array of messages to send
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_CHANNEL \c num_msgs is negative, or a tasklet would have
+ *                         to wait
+ */
+int ABT_channel_send_many(ABT_channel channel, int num_msgs, void **msgs)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_channel *p_channel = ABTI_channel_get_ptr(channel);
+    ABTI_CHECK_NULL_CHANNEL_PTR(p_channel);
+    ABTI_CHECK_TRUE(num_msgs >= 0, ABT_ERR_CHANNEL);
+
+    abt_errno = ABTI_channel_send_many(p_channel, num_msgs, msgs);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup CHANNEL
+ * @brief   Receive messages from the channel.
+ *
+ * \c ABT_channel_recv_many() receives \c num_msgs messages from the channel
+ * \c channel into \c msgs in order, as \c ABT_channel_recv() does for each of
+ * them.  The lock of \c channel is taken once for all the messages that can
+ * be received without waiting, and the senders whose messages are taken are
+ * woken up after it is released.  A tasklet either receives all the messages
+ * without waiting or gets \c ABT_ERR_CHANNEL without receiving any of them.
+ *
+ * @param[in]  channel   handle to the channel
+ * @param[in]  num_msgs  number of messages
+ * @param[out] msgs      array of received messages
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_CHANNEL \c num_msgs is negative, or a tasklet would have
+ *                         to wait
+ */
+int ABT_channel_recv_many(ABT_channel channel, int num_msgs, void **msgs)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_channel *p_channel = ABTI_channel_get_ptr(channel);
+    ABTI_CHECK_NULL_CHANNEL_PTR(p_channel);
+    ABTI_CHECK_TRUE(num_msgs >= 0, ABT_ERR_CHANNEL);
+
+    abt_errno = ABTI_channel_recv_many(p_channel, num_msgs, msgs);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup CHANNEL
+ * @brief   Get the number of messages in the channel.
+ *
+ * \c ABT_channel_get_count() returns through \c count the number of messages
+ * that are held by the channel \c channel.  The messages of waiting senders
+ * are not counted.
+ *
+ * @param[in]  channel  handle to the channel
+ * @param[out] count    number of messages
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_channel_get_count(ABT_channel channel, size_t *count)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_channel *p_channel = ABTI_channel_get_ptr(channel);
+    ABTI_CHECK_NULL_CHANNEL_PTR(p_channel);
+
+    *count = *(volatile size_t *)&p_channel->count;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+/* Wake up the waiters chained by p_next.  The caller has released the lock.
+ * A waiter may return as soon as it is woken up, so p_next is read first. */
+static void ABTI_channel_wake_all(ABTI_channel_waiter *p_waiter)
+{
+    while (p_waiter) {
+        ABTI_channel_waiter *p_next = p_waiter->p_next;
+        ABTI_thread *p_thread = p_waiter->p_thread;
+        if (p_thread) {
+            ABTI_thread_set_ready(p_thread);
+        } else {
+            p_waiter->done = 1;
+        }
+        p_waiter = p_next;
+    }
+}
+
+/* Queue p_waiter at the tail of the waiters and release the lock, and then
+ * wake up p_woken and wait until the other side takes p_waiter out.  A ULT is
+ * marked blocked before the lock is released so that it cannot be made ready
+ * before it is blocked. */
+static void ABTI_channel_wait(ABTI_channel *p_channel,
+                              ABTI_channel_waiter **pp_head,
+                              ABTI_channel_waiter **pp_tail,
+                              ABTI_channel_waiter *p_waiter,
+                              ABTI_channel_waiter *p_woken)
+{
+    ABTI_thread *p_thread = p_waiter->p_thread;
+
+    p_waiter->done = 0;
+    p_waiter->p_next = NULL;
+    if (*pp_tail) {
+        (*pp_tail)->p_next = p_waiter;
+    } else {
+        *pp_head = p_waiter;
+    }
+    *pp_tail = p_waiter;
+
+    if (p_thread) ABTI_thread_set_blocked(p_thread);
+    ABTI_spinlock_release(&p_channel->lock);
+    ABTI_channel_wake_all(p_woken);
+
+    if (p_thread) {
+        ABTI_thread_suspend(p_thread);
+    } else {
+        while (!p_waiter->done) {
+            ABTD_atomic_pause();
+        }
+    }
+}
+
+static inline
+ABTI_channel_waiter *ABTI_channel_pop(ABTI_channel_waiter **pp_head,
+                                      ABTI_channel_waiter **pp_tail)
+{
+    ABTI_channel_waiter *p_waiter = *pp_head;
+    *pp_head = p_waiter->p_next;
+    if (*pp_head == NULL) *pp_tail = NULL;
+    return p_waiter;
+}
+
+/* Returns ABT_TRUE if the caller is a tasklet, which cannot wait.  p_waiter
+ * is set up for a ULT or an external thread otherwise. */
+static inline
+ABT_bool ABTI_channel_init_waiter(ABTI_channel_waiter *p_waiter)
+{
+    if (lp_ABTI_local == NULL) {
+        p_waiter->p_thread = NULL;
+    } else if (ABTI_local_get_task() != NULL) {
+        return ABT_TRUE;
+    } else {
+        p_waiter->p_thread = ABTI_local_get_thread();
+    }
+    return ABT_FALSE;
+}
+
+static int ABTI_channel_send_many(ABTI_channel *p_channel, int num_msgs,
+                                  void **msgs)
+{
+    ABTI_channel_waiter waiter;
+    ABTI_channel_waiter *p_woken, *p_receiver;
+    ABT_bool is_task = ABTI_channel_init_waiter(&waiter);
+    int i = 0;
+
+    while (i < num_msgs) {
+        p_woken = NULL;
+        ABTI_spinlock_acquire(&p_channel->lock);
+
+        if (is_task && p_channel->capacity - p_channel->count +
+                       p_channel->num_receivers < (size_t)num_msgs) {
+            ABTI_spinlock_release(&p_channel->lock);
+            return ABT_ERR_CHANNEL;
+        }
+
+        for (; i < num_msgs; i++) {
+            if (p_channel->p_recv_head) {
+                /* Pass the message to the first receiver. */
+                p_receiver = ABTI_channel_pop(&p_channel->p_recv_head,
+                                              &p_channel->p_recv_tail);
+                p_channel->num_receivers--;
+                p_receiver->msg = msgs[i];
+                p_receiver->p_next = p_woken;
+                p_woken = p_receiver;
+            } else if (p_channel->count < p_channel->capacity) {
+                size_t idx = p_channel->head + p_channel->count;
+                if (idx >= p_channel->capacity) idx -= p_channel->capacity;
+                p_channel->buf[idx] = msgs[i];
+                p_channel->count++;
+            } else {
+                break;
+            }
+        }
+
+        if (i == num_msgs) {
+            ABTI_spinlock_release(&p_channel->lock);
+            ABTI_channel_wake_all(p_woken);
+            break;
+        }
+
+        /* The channel is full.  A receiver takes the message out of waiter. */
+        waiter.msg = msgs[i++];
+        p_channel->num_senders++;
+        ABTI_channel_wait(p_channel, &p_channel->p_send_head,
+                          &p_channel->p_send_tail, &waiter, p_woken);
+    }
+    return ABT_SUCCESS;
+}
+
+static int ABTI_channel_recv_many(ABTI_channel *p_channel, int num_msgs,
+                                  void **msgs)
+{
+    ABTI_channel_waiter waiter;
+    ABTI_channel_waiter *p_woken, *p_sender;
+    ABT_bool is_task = ABTI_channel_init_waiter(&waiter);
+    int i = 0;
+
+    while (i < num_msgs) {
+        p_woken = NULL;
+        ABTI_spinlock_acquire(&p_channel->lock);
+
+        if (is_task && p_channel->count + p_channel->num_senders <
+                       (size_t)num_msgs) {
+            ABTI_spinlock_release(&p_channel->lock);
+            return ABT_ERR_CHANNEL;
+        }
+
+        for (; i < num_msgs; i++) {
+            if (p_channel->count > 0) {
+                msgs[i] = p_channel->buf[p_channel->head];
+                if (++p_channel->head == p_channel->capacity) {
+                    p_channel->head = 0;
+                }
+                p_channel->count--;
+                if (p_channel->p_send_head == NULL) continue;
+
+                /* Move the message of the first sender into the room. */
+                size_t idx = p_channel->head + p_channel->count;
+                if (idx >= p_channel->capacity) idx -= p_channel->capacity;
+                p_sender = ABTI_channel_pop(&p_channel->p_send_head,
+                                            &p_channel->p_send_tail);
+                p_channel->buf[idx] = p_sender->msg;
+                p_channel->count++;
+            } else if (p_channel->p_send_head) {
+                /* Zero capacity: take the message from the first sender. */
+                p_sender = ABTI_channel_pop(&p_channel->p_send_head,
+                                            &p_channel->p_send_tail);
+                msgs[i] = p_sender->msg;
+            } else {
+                break;
+            }
+            p_channel->num_senders--;
+            p_sender->p_next = p_woken;
+            p_woken = p_sender;
+        }
+
+        if (i == num_msgs) {
+            ABTI_spinlock_release(&p_channel->lock);
+            ABTI_channel_wake_all(p_woken);
+            break;
+        }
+
+        /* The channel is empty.  A sender puts its message into waiter. */
+        p_channel->num_receivers++;
+        ABTI_channel_wait(p_channel, &p_channel->p_recv_head,
+                          &p_channel->p_recv_tail, &waiter, p_woken);
+        msgs[i++] = waiter.msg;
+    }
+    return ABT_SUCCESS;
+}
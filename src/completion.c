@@ -0,0 +1,294 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Initial allocation size of the arrays of a completion source */
+#define ABTI_COMPLETION_INIT_SIZE   16
+
+static void ABTI_completion_source_grow(ABTI_completion_source *p_source);
+static void ABTI_completion_source_poll(ABTI_completion_source *p_source);
+
+
+/** @defgroup COMPLETION Completion source
+ * A \a completion \a source lets ULTs wait for events that Argobots does not
+ * know about, e.g., CUDA or HIP events, without blocking their ESs.  The
+ * source is defined by a poll function, which tests a batch of events
+ * without blocking.  A waiting ULT is blocked, and the schedulers of all the
+ * ESs call the poll functions of the sources with the events of all their
+ * waiters whenever they check events.
+ *
+ * For example, the poll function of CUDA events marks each event for which
+ * \c cudaEventQuery() returns \c cudaSuccess as completed.
+ */
+
+/**
+ * @ingroup COMPLETION
+ * @brief   Create a new completion source.
+ *
+ * \c ABT_completion_source_create() creates a new completion source whose
+ * events are tested by \c poll_fn and returns its handle through
+ * \c newsource.
+ *
+ * \c poll_fn(arg, num_events, events, completed) must set \c completed[i] to
+ * \c ABT_TRUE for each completed event \c events[i] and leave the others
+ * \c ABT_FALSE.  It must not block or call Argobots routines that may block.
+ * It can be called by any ES and by the threads that wait for events, but
+ * the calls for one source are serialized.
+ *
+ * @param[in]  poll_fn    function that tests events
+ * @param[in]  arg        first argument for \c poll_fn
+ * @param[out] newsource  handle to a new completion source
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_completion_source_create(ABT_completion_poll_fn poll_fn, void *arg,
+                                 ABT_completion_source *newsource)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_completion_source *p_source;
+
+    p_source = (ABTI_completion_source *)
+        ABTU_malloc(sizeof(ABTI_completion_source));
+    ABTI_spinlock_create(&p_source->lock);
+    p_source->poll_fn = poll_fn;
+    p_source->arg = arg;
+    p_source->num_waiters = 0;
+    p_source->max_waiters = 0;
+    p_source->events = NULL;
+    p_source->waiters = NULL;
+    p_source->completed = NULL;
+
+    ABTI_spinlock_acquire(&p_global->completion_lock);
+    p_source->p_prev = NULL;
+    p_source->p_next = p_global->p_completion_sources;
+    if (p_source->p_next) p_source->p_next->p_prev = p_source;
+    p_global->p_completion_sources = p_source;
+    ABTI_spinlock_release(&p_global->completion_lock);
+
+    *newsource = ABTI_completion_source_get_handle(p_source);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup COMPLETION
+ * @brief   Free the completion source.
+ *
+ * \c ABT_completion_source_free() releases the completion source \c source.
+ * No ULT may be waiting on \c source.  If it is successfully processed,
+ * \c source is set to \c ABT_COMPLETION_SOURCE_NULL.
+ *
+ * @param[in,out] source  handle to the completion source
+ * @return Error code
+ * @retval ABT_SUCCESS               on success
+ * @retval ABT_ERR_COMPLETION_SOURCE there are waiters
+ */
+int ABT_completion_source_free(ABT_completion_source *source)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_completion_source *p_source;
+
+    p_source = ABTI_completion_source_get_ptr(*source);
+    ABTI_CHECK_NULL_COMPLETION_SOURCE_PTR(p_source);
+
+    ABTI_spinlock_acquire(&p_global->completion_lock);
+    ABTI_spinlock_acquire(&p_source->lock);
+    if (p_source->num_waiters > 0) {
+        ABTI_spinlock_release(&p_source->lock);
+        ABTI_spinlock_release(&p_global->completion_lock);
+        abt_errno = ABT_ERR_COMPLETION_SOURCE;
+        goto fn_fail;
+    }
+    if (p_source->p_prev) {
+        p_source->p_prev->p_next = p_source->p_next;
+    } else {
+        p_global->p_completion_sources = p_source->p_next;
+    }
+    if (p_source->p_next) p_source->p_next->p_prev = p_source->p_prev;
+    ABTI_spinlock_release(&p_source->lock);
+    ABTI_spinlock_release(&p_global->completion_lock);
+
+    ABTI_spinlock_free(&p_source->lock);
+    if (p_source->max_waiters > 0) {
+        ABTU_free(p_source->events);
+        ABTU_free(p_source->waiters);
+        ABTU_free(p_source->completed);
+    }
+    ABTU_free(p_source);
+
+    *source = ABT_COMPLETION_SOURCE_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup COMPLETION
+ * @brief   Wait for an event of the completion source.
+ *
+ * \c ABT_completion_source_wait() returns when the poll function of
+ * \c source reports that \c event has completed.  If it has not completed
+ * yet, the calling ULT is blocked until one of the schedulers finds its
+ * completion, so the other work units keep running meanwhile.
+ *
+ * Since a tasklet cannot be blocked, tasklets and external threads call the
+ * poll function repeatedly until the event completes.
+ *
+ * @param[in] source  handle to the completion source
+ * @param[in] event   event to wait for
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_completion_source_wait(ABT_completion_source source, void *event)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_completion_source *p_source;
+    ABTI_thread *p_thread;
+    ABT_bool completed = ABT_FALSE;
+
+    p_source = ABTI_completion_source_get_ptr(source);
+    ABTI_CHECK_NULL_COMPLETION_SOURCE_PTR(p_source);
+
+    /* Check it first since the event may have completed already. */
+    ABTI_spinlock_acquire(&p_source->lock);
+    p_source->poll_fn(p_source->arg, 1, &event, &completed);
+    if (completed == ABT_TRUE) goto unlock;
+
+    if (lp_ABTI_local == NULL || ABTI_local_get_task() != NULL) {
+        /* External thread or tasklet */
+        do {
+            ABTI_spinlock_release(&p_source->lock);
+            ABTD_atomic_pause();
+            ABTI_spinlock_acquire(&p_source->lock);
+            p_source->poll_fn(p_source->arg, 1, &event, &completed);
+        } while (completed == ABT_FALSE);
+        goto unlock;
+    }
+
+    p_thread = ABTI_local_get_thread();
+    if (p_source->num_waiters == p_source->max_waiters) {
+        ABTI_completion_source_grow(p_source);
+    }
+    ABTI_thread_set_blocked(p_thread);
+    p_source->events[p_source->num_waiters] = event;
+    p_source->waiters[p_source->num_waiters] = p_thread;
+    p_source->num_waiters++;
+    ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->num_completion_waiters, 1);
+    ABTI_spinlock_release(&p_source->lock);
+
+    /* A scheduler may make this ULT ready before it is suspended. */
+    ABTI_thread_suspend(p_thread);
+    goto fn_exit;
+
+  unlock:
+    ABTI_spinlock_release(&p_source->lock);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+void ABTI_completion_init(void)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_spinlock_create(&p_global->completion_lock);
+    p_global->num_completion_waiters = 0;
+    p_global->p_completion_sources = NULL;
+}
+
+/* Sources that the user has not freed are released. */
+void ABTI_completion_finalize(void)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_completion_source *p_source = p_global->p_completion_sources;
+
+    while (p_source) {
+        ABT_completion_source source;
+        source = ABTI_completion_source_get_handle(p_source);
+        p_source = p_source->p_next;
+        ABT_completion_source_free(&source);
+    }
+    ABTI_spinlock_free(&p_global->completion_lock);
+}
+
+/* Poll the sources that have waiters.  A source being polled by another ES is
+ * skipped, and so are all of them if the list is locked. */
+void ABTI_completion_poll(void)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_completion_source *p_source;
+
+    if (ABTI_spinlock_try_acquire(&p_global->completion_lock) == ABT_FALSE) {
+        return;
+    }
+    for (p_source = p_global->p_completion_sources; p_source;
+         p_source = p_source->p_next) {
+        if (*(volatile int *)&p_source->num_waiters == 0) continue;
+        if (ABTI_spinlock_try_acquire(&p_source->lock) == ABT_FALSE) continue;
+        ABTI_completion_source_poll(p_source);
+        ABTI_spinlock_release(&p_source->lock);
+    }
+    ABTI_spinlock_release(&p_global->completion_lock);
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void ABTI_completion_source_grow(ABTI_completion_source *p_source)
+{
+    int n = p_source->max_waiters ? p_source->max_waiters * 2
+                                  : ABTI_COMPLETION_INIT_SIZE;
+    p_source->events = (void **)ABTU_realloc(p_source->events,
+                                             sizeof(void *) * n);
+    p_source->waiters = (ABTI_thread **)ABTU_realloc(p_source->waiters,
+                                                     sizeof(ABTI_thread *) * n);
+    p_source->completed = (ABT_bool *)ABTU_realloc(p_source->completed,
+                                                   sizeof(ABT_bool) * n);
+    p_source->max_waiters = n;
+}
+
+/* Test the events of all the waiters with one call of poll_fn and resume the
+ * ULTs whose events have completed.  The caller holds p_source->lock. */
+static void ABTI_completion_source_poll(ABTI_completion_source *p_source)
+{
+    int i, j, n = p_source->num_waiters;
+
+    for (i = 0; i < n; i++) p_source->completed[i] = ABT_FALSE;
+    p_source->poll_fn(p_source->arg, n, p_source->events,
+                      p_source->completed);
+
+    /* Remove the completed events while keeping the order of the others */
+    for (i = 0, j = 0; i < n; i++) {
+        if (p_source->completed[i] == ABT_TRUE) {
+            ABTI_thread_set_ready(p_source->waiters[i]);
+            continue;
+        }
+        p_source->events[j] = p_source->events[i];
+        p_source->waiters[j] = p_source->waiters[i];
+        j++;
+    }
+    if (j < n) {
+        p_source->num_waiters = j;
+        ABTD_atomic_fetch_sub_uint32(&gp_ABTI_global->num_completion_waiters,
+                                     (uint32_t)(n - j));
+    }
+}
@@ -4,7 +4,6 @@
  */
 
 #include "abti.h"
-#include <sys/time.h>
 
 
 /** @defgroup COND Condition Variable
@@ -29,7 +28,7 @@ int ABT_cond_create(ABT_cond *newcond)
     int abt_errno = ABT_SUCCESS;
     ABTI_cond *p_newcond;
 
-    p_newcond = (ABTI_cond *)ABTU_malloc(sizeof(ABTI_cond));
+    p_newcond = (ABTI_cond *)ABTU_malloc_cache_aligned(sizeof(ABTI_cond));
     ABTI_cond_init(p_newcond);
 
     /* Return value */
@@ -111,36 +110,11 @@ int ABT_cond_wait(ABT_cond cond, ABT_mutex mutex)
 }
 
 
-static inline
-double convert_timespec_to_sec(const struct timespec *p_ts)
-{
-    double secs;
-    secs = ((double)p_ts->tv_sec) + 1.0e-9 * ((double)p_ts->tv_nsec);
-    return secs;
-}
-
-static inline
-double get_cur_time(void)
-{
-#if defined(HAVE_CLOCK_GETTIME)
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    return convert_timespec_to_sec(&ts);
-#elif defined(HAVE_GETTIMEOFDAY)
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return ((double)tv.tv_sec) + 1.0e-6 * ((double)tv.tv_usec);
-#else
-#error "No timer function available"
-    return 0.0;
-#endif
-}
-
 static inline
 void remove_unit(ABTI_cond *p_cond, ABTI_unit *p_unit)
 {
-    if (p_unit->p_next == NULL) return;
-
+    /* The lock has to be taken even if p_unit seems to have been removed
+     * since the signaler may still be looking at it. */
     ABTI_spinlock_acquire(&p_cond->lock);
 
     if (p_unit->p_next == NULL) {
@@ -201,14 +175,18 @@ int ABT_cond_timedwait(ABT_cond cond, ABT_mutex mutex,
     ABTI_mutex *p_mutex = ABTI_mutex_get_ptr(mutex);
     ABTI_CHECK_NULL_MUTEX_PTR(p_mutex);
 
-    double tar_time = convert_timespec_to_sec(abstime);
+    double tar_time = ABTI_timeout_convert(abstime);
+    ABTI_timeout timeout;
+    ABTI_unit unit;
 
-    ABTI_unit *p_unit;
-    volatile int ext_signal = 0;
+    /* A tasklet cannot wait */
+    ABTI_CHECK_TRUE(lp_ABTI_local == NULL || ABTI_local_get_thread() != NULL,
+                    ABT_ERR_COND);
 
-    p_unit = (ABTI_unit *)ABTU_calloc(1, sizeof(ABTI_unit));
-    p_unit->pool = (ABT_pool)&ext_signal;
-    p_unit->type = ABT_UNIT_TYPE_EXT;
+    unit.p_prev = NULL;
+    unit.p_next = NULL;
+    unit.pool = (ABT_pool)&timeout;
+    unit.type = ABTI_UNIT_TYPE_TIMED;
 
     ABTI_spinlock_acquire(&p_cond->lock);
 
@@ -223,17 +201,21 @@ int ABT_cond_timedwait(ABT_cond cond, ABT_mutex mutex,
         }
     }
 
+    /* The ULT is blocked and registered in the timer wheel of its ES before
+     * it becomes visible to signalers. */
+    ABTI_timeout_prepare(&timeout, tar_time);
+
     if (p_cond->num_waiters == 0) {
-        p_unit->p_prev = p_unit;
-        p_unit->p_next = p_unit;
-        p_cond->p_head = p_unit;
-        p_cond->p_tail = p_unit;
+        unit.p_prev = &unit;
+        unit.p_next = &unit;
+        p_cond->p_head = &unit;
+        p_cond->p_tail = &unit;
     } else {
-        p_cond->p_tail->p_next = p_unit;
-        p_cond->p_head->p_prev = p_unit;
-        p_unit->p_prev = p_cond->p_tail;
-        p_unit->p_next = p_cond->p_head;
-        p_cond->p_tail = p_unit;
+        p_cond->p_tail->p_next = &unit;
+        p_cond->p_head->p_prev = &unit;
+        unit.p_prev = p_cond->p_tail;
+        unit.p_next = p_cond->p_head;
+        p_cond->p_tail = &unit;
     }
 
     p_cond->num_waiters++;
@@ -243,16 +225,10 @@ int ABT_cond_timedwait(ABT_cond cond, ABT_mutex mutex,
     /* Unlock the mutex that the calling ULT is holding */
     ABTI_mutex_unlock(p_mutex);
 
-    while (!ext_signal) {
-        double cur_time = get_cur_time();
-        if (cur_time >= tar_time) {
-            remove_unit(p_cond, p_unit);
-            abt_errno = ABT_ERR_COND_TIMEDOUT;
-            break;
-        }
-        ABT_thread_yield();
+    if (ABTI_timeout_wait(&timeout) == ABT_FALSE) {
+        remove_unit(p_cond, &unit);
+        abt_errno = ABT_ERR_COND_TIMEDOUT;
     }
-    ABTU_free(p_unit);
 
     /* Lock the mutex again */
     ABTI_mutex_spinlock(p_mutex);
@@ -288,34 +264,35 @@ int ABT_cond_signal(ABT_cond cond)
 
     ABTI_spinlock_acquire(&p_cond->lock);
 
-    if (p_cond->num_waiters == 0) {
-        ABTI_spinlock_release(&p_cond->lock);
-        goto fn_exit;
-    }
-
-    /* Wake up the first waiting ULT */
-    ABTI_unit *p_unit = p_cond->p_head;
-
-    p_cond->num_waiters--;
-    if (p_cond->num_waiters == 0) {
-        p_cond->p_waiter_mutex = NULL;
-        p_cond->p_head = NULL;
-        p_cond->p_tail = NULL;
-    } else {
-        p_unit->p_prev->p_next = p_unit->p_next;
-        p_unit->p_next->p_prev = p_unit->p_prev;
-        p_cond->p_head = p_unit->p_next;
-    }
-    p_unit->p_prev = NULL;
-    p_unit->p_next = NULL;
-
-    if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
-        ABTI_thread *p_thread = ABTI_thread_get_ptr(p_unit->thread);
-        ABTI_thread_set_ready(p_thread);
-    } else {
-        /* When the head is an external thread */
-        volatile int *p_ext_signal = (volatile int *)p_unit->pool;
-        *p_ext_signal = 1;
+    /* Wake up the first waiting ULT.  Timed waiters that have timed out are
+     * skipped; they are removed from the queue here. */
+    while (p_cond->num_waiters > 0) {
+        ABTI_unit *p_unit = p_cond->p_head;
+
+        p_cond->num_waiters--;
+        if (p_cond->num_waiters == 0) {
+            p_cond->p_waiter_mutex = NULL;
+            p_cond->p_head = NULL;
+            p_cond->p_tail = NULL;
+        } else {
+            p_unit->p_prev->p_next = p_unit->p_next;
+            p_unit->p_next->p_prev = p_unit->p_prev;
+            p_cond->p_head = p_unit->p_next;
+        }
+        p_unit->p_prev = NULL;
+        p_unit->p_next = NULL;
+
+        if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
+            ABTI_thread *p_thread = ABTI_thread_get_ptr(p_unit->thread);
+            ABTI_thread_set_ready(p_thread);
+        } else if (p_unit->type == ABTI_UNIT_TYPE_TIMED) {
+            ABTI_timeout *p_timeout = (ABTI_timeout *)p_unit->pool;
+            if (ABTI_timeout_signal(p_timeout) == ABT_FALSE) continue;
+        } else {
+            /* When the head is an external thread */
+            ABTD_futex_signal_set((uint32_t *)p_unit->pool);
+        }
+        break;
     }
 
     ABTI_spinlock_release(&p_cond->lock);
@@ -357,3 +334,40 @@ int ABT_cond_broadcast(ABT_cond cond)
     goto fn_exit;
 }
 
+/* Called by ABT_thread_cancel() to remove p_thread waiting in
+ * ABTI_cond_wait().  A waiter that has been detached by a signal or a
+ * broadcast is not found. */
+ABT_bool ABTI_cond_unlink_waiter(void *p_obj, ABTI_thread *p_thread)
+{
+    ABTI_cond *p_cond = (ABTI_cond *)p_obj;
+    ABTI_unit *p_unit;
+    ABT_bool found = ABT_FALSE;
+    size_t i;
+
+    ABTI_spinlock_acquire(&p_cond->lock);
+    p_unit = p_cond->p_head;
+    for (i = 0; i < p_cond->num_waiters; i++) {
+        if (p_unit == &p_thread->unit_def) {
+            found = ABT_TRUE;
+            break;
+        }
+        p_unit = p_unit->p_next;
+    }
+    if (found == ABT_TRUE) {
+        p_cond->num_waiters--;
+        if (p_cond->num_waiters == 0) {
+            p_cond->p_waiter_mutex = NULL;
+            p_cond->p_head = NULL;
+            p_cond->p_tail = NULL;
+        } else {
+            p_unit->p_prev->p_next = p_unit->p_next;
+            p_unit->p_next->p_prev = p_unit->p_prev;
+            if (p_cond->p_head == p_unit) p_cond->p_head = p_unit->p_next;
+            if (p_cond->p_tail == p_unit) p_cond->p_tail = p_unit->p_prev;
+        }
+        p_unit->p_prev = NULL;
+        p_unit->p_next = NULL;
+    }
+    ABTI_spinlock_release(&p_cond->lock);
+    return found;
+}
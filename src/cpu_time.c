@@ -0,0 +1,126 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* CPU time of work units.  With ABT_CPU_TIME, an ES reads the tick counter
+ * at every switch to and from a ULT or a tasklet, and the ticks in between
+ * are added to the unit that ran (see abti_cpu_time.h), so the time of a ULT
+ * accumulates across yields and migrations.  When a unit terminates, its
+ * time is added to the sums of its function in a global open-addressing
+ * table like the one of the stack usage (see stack_usage.c). */
+
+/* Number of entries of the table (a power of two) without the last one */
+#define ABTI_CPU_TIME_NUM_ENTRIES   256
+
+void ABTI_cpu_time_init(void)
+{
+    gp_ABTI_global->p_cpu_time = NULL;
+#ifdef ABT_CONFIG_DISABLE_CPU_TIME
+    gp_ABTI_global->use_cpu_time = ABT_FALSE;
+#endif
+    if (gp_ABTI_global->use_cpu_time == ABT_FALSE) return;
+
+    gp_ABTI_global->p_cpu_time = (ABTI_cpu_time_entry *)ABTU_calloc(
+            ABTI_CPU_TIME_NUM_ENTRIES + 1, sizeof(ABTI_cpu_time_entry));
+}
+
+void ABTI_cpu_time_finalize(void)
+{
+    if (gp_ABTI_global->p_cpu_time == NULL) return;
+    ABTU_free(gp_ABTI_global->p_cpu_time);
+    gp_ABTI_global->p_cpu_time = NULL;
+}
+
+static ABTI_cpu_time_entry *ABTI_cpu_time_get_entry(uint64_t func)
+{
+    ABTI_cpu_time_entry *p_entries = gp_ABTI_global->p_cpu_time;
+    const uint32_t mask = ABTI_CPU_TIME_NUM_ENTRIES - 1;
+    uint32_t idx = (uint32_t)(((func >> 4) * 0x9E3779B97F4A7C15ULL) >> 32)
+                 & mask;
+    uint32_t i;
+    uint64_t old;
+
+    for (i = 0; i < ABTI_CPU_TIME_NUM_ENTRIES; i++) {
+        ABTI_cpu_time_entry *p_entry = &p_entries[(idx + i) & mask];
+        old = *(volatile uint64_t *)&p_entry->func;
+        if (old == 0) {
+            old = ABTD_atomic_cas_uint64(&p_entry->func, 0, func);
+        }
+        if (old == 0 || old == func) return p_entry;
+    }
+    return &p_entries[ABTI_CPU_TIME_NUM_ENTRIES];
+}
+
+/* A unit of func has terminated after running for ticks */
+void ABTI_cpu_time_add(uint64_t func, uint64_t ticks)
+{
+    ABTI_cpu_time_entry *p_entry;
+    uint64_t old;
+
+    if (gp_ABTI_global->p_cpu_time == NULL) return;
+    p_entry = ABTI_cpu_time_get_entry(func);
+    ABTD_atomic_fetch_add_uint64(&p_entry->ticks, ticks);
+    while ((old = *(volatile uint64_t *)&p_entry->max_ticks) < ticks) {
+        if (ABTD_atomic_cas_uint64(&p_entry->max_ticks, old, ticks) == old) {
+            break;
+        }
+    }
+    ABTD_atomic_fetch_add_uint64(&p_entry->count, 1);
+}
+
+/**
+ * @ingroup INFO
+ * @brief   Write the CPU time of ULTs and tasklets per function.
+ *
+ * \c ABT_info_print_cpu_time() writes to \c fp one line per function of the
+ * ULTs and tasklets that have terminated since \c ABT_init(): the number of
+ * them and the sum, the mean, and the maximum of their CPU time.  The CPU
+ * time of a unit is the time for which an ES ran it, accumulated across
+ * yields and migrations (see \c ABT_thread_get_cpu_time()).  Functions are
+ * named if the program is linked with -rdynamic.  The primary ULT and the
+ * ULTs of schedulers are not counted.
+ *
+ * The CPU time is measured only if the environment variable
+ * \c ABT_CPU_TIME is set.
+ *
+ * @param[in] fp  output stream
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA \c ABT_CPU_TIME is not set or Argobots is
+ *                            configured with --enable-feature=no-cpu-time
+ */
+int ABT_info_print_cpu_time(FILE *fp)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_cpu_time_entry *p_entries;
+    int i;
+
+    ABTI_CHECK_INITIALIZED();
+    p_entries = gp_ABTI_global->p_cpu_time;
+    ABTI_CHECK_TRUE(p_entries != NULL, ABT_ERR_FEATURE_NA);
+
+    fprintf(fp, "== CPU time ==\n");
+    for (i = 0; i <= ABTI_CPU_TIME_NUM_ENTRIES; i++) {
+        ABTI_cpu_time_entry *p_entry = &p_entries[i];
+        uint64_t count = *(volatile uint64_t *)&p_entry->count;
+        double sum;
+        if (count == 0) continue;
+        sum = ABTD_time_ticks_to_sec(p_entry->ticks);
+        ABTI_profile_print_func(fp, p_entry->func);
+        fprintf(fp, "\n  cpu_time: count %" PRIu64 ", sum %.6f s, "
+                    "mean %.3f us, max %.3f us\n", count, sum,
+                    sum / (double)count * 1.0e6,
+                    ABTD_time_ticks_to_sec(p_entry->max_ticks) * 1.0e6);
+    }
+    fflush(fp);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
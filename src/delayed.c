@@ -0,0 +1,444 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+static int ABTI_delayed_create(ABTI_pool *p_pool, ABT_unit_type type,
+                               void (*f_func)(void *), void *p_arg,
+                               ABTI_thread_attr *p_attr, double delay,
+                               double period, ABT_delayed *newdelayed);
+static void ABTI_delayed_expire(ABTI_timeout *p_timeout);
+static void ABTI_delayed_run(void *arg);
+static void ABTI_delayed_release(ABTI_delayed *p_delayed);
+
+
+/** @defgroup DELAYED Delayed work unit
+ * A \a delayed work unit is a ULT or a tasklet that is pushed into a pool
+ * after a delay, and then periodically if it has a period.  It is kept in
+ * the timer wheel of the ES that creates it, like sleeping ULTs, so no ULT
+ * has to poll the clock for it; the scheduler of the ES pushes a new work
+ * unit into the pool once the time has come.  The timer wheel is checked when
+ * the scheduler checks events, so a run may start somewhat later than its
+ * time.
+ *
+ * Runs of a periodic work unit do not overlap.  If the previous run has not
+ * finished when the next one is due, or if several periods have passed at
+ * once, e.g., because the ES has been busy, the due runs are coalesced into
+ * one.  The following runs keep to the original period.
+ *
+ * If the ES that holds a delayed work unit is freed, the work unit is run at
+ * once, and a periodic one moves to the ES that frees it, if any.
+ */
+
+/**
+ * @ingroup DELAYED
+ * @brief   Create a tasklet that is pushed into a pool after a delay.
+ *
+ * \c ABT_task_create_delayed() creates a delayed work unit that pushes a
+ * tasklet calling <tt>task_func(arg)</tt> into \c pool after \c delay
+ * seconds.  If \c newdelayed is not \c NULL, its handle is returned through
+ * \c newdelayed, which can be used to cancel it and has to be freed by
+ * \c ABT_delayed_free().  Otherwise, it is freed automatically.  The caller
+ * has to be a work unit running on an ES, and \c pool has to accept pushes
+ * from the ES.
+ *
+ * @param[in]  pool        handle to the pool
+ * @param[in]  task_func   function to be executed by the tasklet
+ * @param[in]  arg         argument for \c task_func
+ * @param[in]  delay       delay in seconds
+ * @param[out] newdelayed  handle to a new delayed work unit, or \c NULL
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_XSTREAM the caller is an external thread
+ */
+int ABT_task_create_delayed(ABT_pool pool, void (*task_func)(void *),
+                            void *arg, double delay, ABT_delayed *newdelayed)
+{
+    return ABT_task_create_periodic(pool, task_func, arg, delay, 0.0,
+                                    newdelayed);
+}
+
+/**
+ * @ingroup DELAYED
+ * @brief   Create a tasklet that is pushed into a pool periodically.
+ *
+ * \c ABT_task_create_periodic() works like \c ABT_task_create_delayed(), but
+ * it pushes a tasklet into \c pool every \c period seconds after the first
+ * one, until the delayed work unit is canceled by \c ABT_delayed_cancel() or
+ * \c ABT_delayed_free().  If \c period is zero, only one tasklet is pushed.
+ *
+ * @param[in]  pool        handle to the pool
+ * @param[in]  task_func   function to be executed by the tasklets
+ * @param[in]  arg         argument for \c task_func
+ * @param[in]  delay       delay of the first run in seconds
+ * @param[in]  period      period in seconds, or zero
+ * @param[out] newdelayed  handle to a new delayed work unit, or \c NULL
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_DELAYED \c period is negative
+ * @retval ABT_ERR_INV_XSTREAM the caller is an external thread
+ */
+int ABT_task_create_periodic(ABT_pool pool, void (*task_func)(void *),
+                             void *arg, double delay, double period,
+                             ABT_delayed *newdelayed)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    abt_errno = ABTI_delayed_create(p_pool, ABT_UNIT_TYPE_TASK, task_func,
+                                    arg, NULL, delay, period, newdelayed);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (newdelayed) *newdelayed = ABT_DELAYED_NULL;
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup DELAYED
+ * @brief   Create a ULT that is pushed into a pool after a delay.
+ *
+ * \c ABT_thread_create_delayed() is the same as \c ABT_task_create_delayed()
+ * except that it creates a ULT with the attribute \c attr.  \c attr is copied,
+ * so it can be freed after this routine returns.  The attribute must have
+ * neither a user-provided stack, a join counter, nor a gang, since a periodic
+ * work unit creates many ULTs with it, and work-first creation is not used.
+ *
+ * @param[in]  pool        handle to the pool
+ * @param[in]  thread_func function to be executed by the ULT
+ * @param[in]  arg         argument for \c thread_func
+ * @param[in]  attr        ULT attribute
+ * @param[in]  delay       delay in seconds
+ * @param[out] newdelayed  handle to a new delayed work unit, or \c NULL
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_THREAD_ATTR \c attr cannot be used
+ * @retval ABT_ERR_INV_XSTREAM     the caller is an external thread
+ */
+int ABT_thread_create_delayed(ABT_pool pool, void (*thread_func)(void *),
+                              void *arg, ABT_thread_attr attr, double delay,
+                              ABT_delayed *newdelayed)
+{
+    return ABT_thread_create_periodic(pool, thread_func, arg, attr, delay, 0.0,
+                                      newdelayed);
+}
+
+/**
+ * @ingroup DELAYED
+ * @brief   Create a ULT that is pushed into a pool periodically.
+ *
+ * \c ABT_thread_create_periodic() is the same as \c ABT_task_create_periodic()
+ * except that it creates ULTs with the attribute \c attr.  See
+ * \c ABT_thread_create_delayed() for the restrictions on \c attr.
+ *
+ * @param[in]  pool        handle to the pool
+ * @param[in]  thread_func function to be executed by the ULTs
+ * @param[in]  arg         argument for \c thread_func
+ * @param[in]  attr        ULT attribute
+ * @param[in]  delay       delay of the first run in seconds
+ * @param[in]  period      period in seconds, or zero
+ * @param[out] newdelayed  handle to a new delayed work unit, or \c NULL
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_DELAYED     \c period is negative
+ * @retval ABT_ERR_INV_THREAD_ATTR \c attr cannot be used
+ * @retval ABT_ERR_INV_XSTREAM     the caller is an external thread
+ */
+int ABT_thread_create_periodic(ABT_pool pool, void (*thread_func)(void *),
+                               void *arg, ABT_thread_attr attr, double delay,
+                               double period, ABT_delayed *newdelayed)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    if (p_attr) {
+        ABTI_CHECK_TRUE(p_attr->userstack == ABT_FALSE &&
+                        p_attr->p_join_counter == NULL &&
+                        p_attr->p_gang == NULL, ABT_ERR_INV_THREAD_ATTR);
+    }
+    abt_errno = ABTI_delayed_create(p_pool, ABT_UNIT_TYPE_THREAD, thread_func,
+                                    arg, p_attr, delay, period, newdelayed);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (newdelayed) *newdelayed = ABT_DELAYED_NULL;
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup DELAYED
+ * @brief   Cancel a delayed work unit.
+ *
+ * \c ABT_delayed_cancel() stops \c delayed from pushing work units any more.
+ * A work unit that has already been pushed is not affected.  The handle is
+ * still valid and has to be freed by \c ABT_delayed_free().
+ *
+ * @param[in] delayed  handle to the delayed work unit
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_delayed_cancel(ABT_delayed delayed)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_delayed *p_delayed = ABTI_delayed_get_ptr(delayed);
+    ABTI_CHECK_NULL_DELAYED_PTR(p_delayed);
+
+    *(volatile uint32_t *)&p_delayed->canceled = 1;
+    /* If the timeout is expiring or being started again, it sees canceled
+     * and releases itself later. */
+    if (ABTI_timeout_stop(&p_delayed->timeout) == ABT_TRUE) {
+        ABTI_delayed_release(p_delayed);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup DELAYED
+ * @brief   Free a delayed work unit.
+ *
+ * \c ABT_delayed_free() cancels \c delayed like \c ABT_delayed_cancel() and
+ * releases its handle.  The resources are freed once the work unit that has
+ * been pushed, if any, finishes.  \c delayed is set to \c ABT_DELAYED_NULL.
+ *
+ * @param[in,out] delayed  handle to the delayed work unit
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_delayed_free(ABT_delayed *delayed)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_delayed *p_delayed = ABTI_delayed_get_ptr(*delayed);
+    ABTI_CHECK_NULL_DELAYED_PTR(p_delayed);
+
+    abt_errno = ABT_delayed_cancel(*delayed);
+    ABTI_CHECK_ERROR(abt_errno);
+    ABTI_delayed_release(p_delayed);
+
+    *delayed = ABT_DELAYED_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup DELAYED
+ * @brief   Get the number of runs of a delayed work unit.
+ *
+ * \c ABT_delayed_get_num_runs() returns through \c num_runs the number of
+ * work units that \c delayed has pushed so far.
+ *
+ * @param[in]  delayed   handle to the delayed work unit
+ * @param[out] num_runs  number of runs
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_delayed_get_num_runs(ABT_delayed delayed, uint64_t *num_runs)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_delayed *p_delayed = ABTI_delayed_get_ptr(delayed);
+    ABTI_CHECK_NULL_DELAYED_PTR(p_delayed);
+
+    *num_runs = *(volatile uint64_t *)&p_delayed->num_runs;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup DELAYED
+ * @brief   Get the number of coalesced runs of a delayed work unit.
+ *
+ * \c ABT_delayed_get_num_coalesced() returns through \c num_coalesced the
+ * number of periodic runs of \c delayed that have been merged into other runs
+ * because they were due while the previous run was not finished or at the
+ * same time as another run.
+ *
+ * @param[in]  delayed        handle to the delayed work unit
+ * @param[out] num_coalesced  number of coalesced runs
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_delayed_get_num_coalesced(ABT_delayed delayed, uint64_t *num_coalesced)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_delayed *p_delayed = ABTI_delayed_get_ptr(delayed);
+    ABTI_CHECK_NULL_DELAYED_PTR(p_delayed);
+
+    *num_coalesced = *(volatile uint64_t *)&p_delayed->num_coalesced;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+/* A delayed work unit holds a reference for its handle, one while its timeout
+ * is in a wheel or expiring, and one while a pushed run has not finished. */
+static int ABTI_delayed_create(ABTI_pool *p_pool, ABT_unit_type type,
+                               void (*f_func)(void *), void *p_arg,
+                               ABTI_thread_attr *p_attr, double delay,
+                               double period, ABT_delayed *newdelayed)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_delayed *p_delayed;
+    ABTI_timer_wheel *p_wheel;
+    double deadline;
+
+    ABTI_CHECK_INITIALIZED();
+    ABTI_CHECK_TRUE(period >= 0.0, ABT_ERR_INV_DELAYED);
+    ABTI_CHECK_TRUE(lp_ABTI_local != NULL, ABT_ERR_INV_XSTREAM);
+
+    p_delayed = (ABTI_delayed *)ABTU_malloc(sizeof(ABTI_delayed));
+    p_delayed->p_pool = p_pool;
+    p_delayed->type = type;
+    p_delayed->f_func = f_func;
+    p_delayed->p_arg = p_arg;
+    p_delayed->p_attr = NULL;
+    if (p_attr) {
+        p_delayed->p_attr = ABTI_thread_attr_dup(p_attr);
+        p_delayed->p_attr->work_first = ABT_FALSE;
+    }
+    p_delayed->period = period;
+    p_delayed->refcount = (newdelayed != NULL) ? 2 : 1;
+    p_delayed->canceled = 0;
+    p_delayed->pending = 0;
+    p_delayed->num_runs = 0;
+    p_delayed->num_coalesced = 0;
+    p_delayed->timeout.linked = ABT_FALSE;
+    p_delayed->timeout.p_wheel = NULL;
+    p_delayed->timeout.p_prev = NULL;
+    p_delayed->timeout.p_next = NULL;
+
+    /* The handle is set before the timeout may expire. */
+    if (newdelayed) *newdelayed = ABTI_delayed_get_handle(p_delayed);
+
+    deadline = ABTI_timeout_get_time() + ((delay > 0.0) ? delay : 0.0);
+    p_wheel = &ABTI_local_get_xstream()->timer_wheel;
+    if (ABTI_timeout_start(&p_delayed->timeout, p_wheel, deadline,
+                           ABTI_delayed_expire) == ABT_FALSE) {
+        /* The ES is being freed. */
+        if (p_delayed->p_attr) ABTU_free(p_delayed->p_attr);
+        ABTU_free(p_delayed);
+        abt_errno = ABT_ERR_INV_XSTREAM;
+        goto fn_fail;
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Called by the timer wheel, which has taken the timeout out. */
+static void ABTI_delayed_expire(ABTI_timeout *p_timeout)
+{
+    ABTI_delayed *p_delayed = (ABTI_delayed *)
+        ((char *)p_timeout - offsetof(ABTI_delayed, timeout));
+    ABT_pool pool = ABTI_pool_get_handle(p_delayed->p_pool);
+    double now, deadline, period = p_delayed->period;
+    int abt_errno;
+
+    if (*(volatile uint32_t *)&p_delayed->canceled) {
+        p_timeout->p_wheel = NULL;
+        ABTI_delayed_release(p_delayed);
+        return;
+    }
+
+    if (*(volatile uint32_t *)&p_delayed->pending) {
+        /* The previous run has not finished. */
+        p_delayed->num_coalesced++;
+    } else {
+        *(volatile uint32_t *)&p_delayed->pending = 1;
+        ABTD_atomic_fetch_add_uint32(&p_delayed->refcount, 1);
+        if (p_delayed->type == ABT_UNIT_TYPE_TASK) {
+            abt_errno = ABT_task_create(pool, ABTI_delayed_run, p_delayed,
+                                        NULL);
+        } else {
+            abt_errno = ABT_thread_create(pool, ABTI_delayed_run, p_delayed,
+                            ABTI_thread_attr_get_handle(p_delayed->p_attr),
+                            NULL);
+        }
+        if (abt_errno == ABT_SUCCESS) {
+            p_delayed->num_runs++;
+        } else {
+            *(volatile uint32_t *)&p_delayed->pending = 0;
+            ABTD_atomic_fetch_sub_uint32(&p_delayed->refcount, 1);
+        }
+    }
+
+    if (period > 0.0 && lp_ABTI_local != NULL) {
+        /* Periods that have passed entirely are coalesced into this run. */
+        now = ABTI_timeout_get_time();
+        deadline = p_timeout->deadline + period;
+        if (deadline <= now) {
+            uint64_t num_missed =
+                (uint64_t)((now - p_timeout->deadline) / period);
+            p_delayed->num_coalesced += num_missed;
+            deadline = p_timeout->deadline + (double)(num_missed + 1) * period;
+        }
+        /* When the ES is being freed, the timeout moves to the ES that frees
+         * it, if the caller is on another ES. */
+        if (*(volatile uint32_t *)&p_delayed->canceled == 0 &&
+            ABTI_timeout_start(p_timeout,
+                               &ABTI_local_get_xstream()->timer_wheel,
+                               deadline, ABTI_delayed_expire) == ABT_TRUE) {
+            return;
+        }
+    }
+    /* The wheel may be freed after this. */
+    p_timeout->p_wheel = NULL;
+    ABTI_delayed_release(p_delayed);
+}
+
+static void ABTI_delayed_run(void *arg)
+{
+    ABTI_delayed *p_delayed = (ABTI_delayed *)arg;
+
+    p_delayed->f_func(p_delayed->p_arg);
+    *(volatile uint32_t *)&p_delayed->pending = 0;
+    ABTI_delayed_release(p_delayed);
+}
+
+static void ABTI_delayed_release(ABTI_delayed *p_delayed)
+{
+    if (ABTD_atomic_fetch_sub_uint32(&p_delayed->refcount, 1) == 1) {
+        if (p_delayed->p_attr) ABTU_free(p_delayed->p_attr);
+        ABTU_free(p_delayed);
+    }
+}
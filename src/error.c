@@ -79,11 +79,31 @@ int ABT_error_get_str(int err, char *str, size_t *len)
         "ABT_ERR_MIGRATION_TARGET",
         "ABT_ERR_MIGRATION_NA",
         "ABT_ERR_MISSING_JOIN",
-        "ABT_ERR_FEATURE_NA"
+        "ABT_ERR_FEATURE_NA",
+        "ABT_ERR_INV_TASK_GRAPH",
+        "ABT_ERR_TASK_GRAPH",
+        "ABT_ERR_TIMEDOUT",
+        "ABT_ERR_POOL_FULL",
+        "ABT_ERR_INV_JOIN_COUNTER",
+        "ABT_ERR_INV_WAIT_GROUP",
+        "ABT_ERR_WAIT_GROUP",
+        "ABT_ERR_INV_SEM",
+        "ABT_ERR_SEM",
+        "ABT_ERR_INV_CHANNEL",
+        "ABT_ERR_CHANNEL",
+        "ABT_ERR_IO",
+        "ABT_ERR_MPI",
+        "ABT_ERR_INV_COMPLETION_SOURCE",
+        "ABT_ERR_COMPLETION_SOURCE",
+        "ABT_ERR_INV_GANG",
+        "ABT_ERR_RCU",
+        "ABT_ERR_INV_DELAYED",
+        "ABT_ERR_INV_REMOTE_DESC",
+        "ABT_ERR_INV_TEAM"
     };
 
     int abt_errno = ABT_SUCCESS;
-    ABTI_CHECK_TRUE(err >= ABT_SUCCESS && err <= ABT_ERR_FEATURE_NA,
+    ABTI_CHECK_TRUE(err >= ABT_SUCCESS && err <= ABT_ERR_INV_TEAM,
                     ABT_ERR_OTHER);
     if (str) ABTU_strcpy(str, err_str[err]);
     if (len) *len = strlen(err_str[err]);
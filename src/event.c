@@ -14,10 +14,16 @@
 #include <netdb.h>
 #include <poll.h>
 
-#define ABTI_DEFAULT_MAX_CB_FN  4
 #define ABTI_MSG_BUF_LEN        20
 #endif
 
+#if defined(ABT_CONFIG_HANDLE_POWER_EVENT) || defined(ABT_CONFIG_PUBLISH_INFO)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <limits.h>
+#endif
+
 #ifdef ABT_CONFIG_PUBLISH_INFO
 #include <stdio.h>
 
@@ -59,12 +65,33 @@
 
 typedef enum {
     ABTI_PUB_TYPE_BEACON,
-    ABTI_PUB_TYPE_FILE
+    ABTI_PUB_TYPE_FILE,
+    ABTI_PUB_TYPE_SHM
 } ABTI_pub_type;
 #endif
 
 typedef struct ABTI_event_info  ABTI_event_info;
 
+#ifdef ABT_CONFIG_HANDLE_POWER_EVENT
+/* Callbacks registered for an event.  A table is never modified once it is
+ * published: registration copies it, swaps in the copy, and frees the old one
+ * through RCU, so the schedulers read the current table with a single load.
+ * The schedulers read it only while checking events, between two quiescent
+ * states of their ESs.  A callback ID is the index of its slot, and deleted
+ * slots have NULL functions. */
+typedef struct {
+    ABT_event_cb_fn ask_fn;
+    void *ask_arg;
+    ABT_event_cb_fn act_fn;
+    void *act_arg;
+} ABTI_event_cb;
+
+typedef struct {
+    int num_cbs;                /* # of slots */
+    ABTI_event_cb cbs[1];       /* num_cbs slots */
+} ABTI_event_cb_table;
+#endif
+
 struct ABTI_event_info {
     ABTI_mutex mutex;
     char hostname[100];
@@ -73,15 +100,18 @@ struct ABTI_event_info {
 #ifdef ABT_CONFIG_HANDLE_POWER_EVENT
     struct pollfd pfd;
 
-    int max_stop_xstream_fn;
-    int num_stop_xstream_fn;
-    ABT_event_cb_fn *stop_xstream_fn;
-    void **stop_xstream_arg;
+    ABTI_spinlock cb_lock;              /* Serializes registrations */
+    ABTI_event_cb_table *p_stop_xstream_cbs;
+    ABTI_event_cb_table *p_add_xstream_cbs;
+
+    /* Shared control block (ABT_POWER_EVENT_SHM) */
+    ABT_event_ctrl *p_ctrl;
+    uint32_t ctrl_seq;                  /* Request being handled */
 
-    int max_add_xstream_fn;
-    int num_add_xstream_fn;
-    ABT_event_cb_fn *add_xstream_fn;
-    void **add_xstream_arg;
+    /* In-process controller (ABT_ELASTIC) */
+    double elastic_next_time;           /* Time of the next decision */
+    uint64_t elastic_num_pops;          /* Sum of pops at the last decision */
+    uint64_t elastic_num_failed_pops;   /* Sum of failed pops at that time */
 #endif
 #ifdef ABT_CONFIG_PUBLISH_INFO
     ABTI_pub_type pub_type;
@@ -94,6 +124,7 @@ struct ABTI_event_info {
 #endif
 
     FILE *out_file;
+    ABT_event_metrics *p_metrics;   /* Mapped region of ABTI_PUB_TYPE_SHM */
 
     int max_xstream_rank;
     uint32_t *num_threads;      /* # of ULTs terminated on each ES */
@@ -113,6 +144,76 @@ struct ABTI_event_info {
 
 static ABTI_event_info *gp_einfo = NULL;
 
+#ifdef ABT_CONFIG_PUBLISH_INFO
+static int ABTI_event_map_metrics(const char *p_path);
+#endif
+
+#ifdef ABT_CONFIG_HANDLE_POWER_EVENT
+static ABTI_event_cb_table *ABTI_event_alloc_cbs(int num_cbs)
+{
+    size_t size = sizeof(ABTI_event_cb_table)
+                + (num_cbs > 1 ? num_cbs - 1 : 0) * sizeof(ABTI_event_cb);
+    ABTI_event_cb_table *p_cbs = (ABTI_event_cb_table *)ABTU_calloc(1, size);
+    p_cbs->num_cbs = num_cbs;
+    return p_cbs;
+}
+
+/* Return the current table with a single load. */
+static inline
+ABTI_event_cb_table *ABTI_event_get_cbs(ABTI_event_cb_table **pp_cbs)
+{
+    return *(ABTI_event_cb_table * volatile *)pp_cbs;
+}
+
+static ABTI_event_cb_table **ABTI_event_get_cb_slot(ABT_event_kind event)
+{
+    switch (event) {
+        case ABT_EVENT_STOP_XSTREAM: return &gp_einfo->p_stop_xstream_cbs;
+        case ABT_EVENT_ADD_XSTREAM:  return &gp_einfo->p_add_xstream_cbs;
+        default:                     return NULL;
+    }
+}
+
+static void ABTI_event_free_cbs(void *arg)
+{
+    ABTU_free(arg);
+}
+
+/* Replace the table, which the caller has copied under cb_lock, and free the
+ * old one after the schedulers that may be reading it are done. */
+static void ABTI_event_publish_cbs(ABTI_event_cb_table **pp_cbs,
+                                   ABTI_event_cb_table *p_new)
+{
+    ABTI_event_cb_table *p_old;
+    p_old = (ABTI_event_cb_table *)ABTD_atomic_exchange_ptr((void **)pp_cbs,
+                                                            (void *)p_new);
+    ABT_rcu_call(ABTI_event_free_cbs, (void *)p_old);
+}
+
+/* Return ABT_FALSE if any "ask" callback refuses to stop the ES. */
+static ABT_bool ABTI_event_ask_stop(ABTI_event_cb_table *p_cbs,
+                                    ABT_xstream xstream)
+{
+    int i;
+    for (i = 0; i < p_cbs->num_cbs; i++) {
+        ABTI_event_cb *p_cb = &p_cbs->cbs[i];
+        if (p_cb->ask_fn && p_cb->ask_fn(p_cb->ask_arg, xstream) == ABT_FALSE)
+            return ABT_FALSE;
+    }
+    return ABT_TRUE;
+}
+
+static void ABTI_event_act_stop(ABTI_event_cb_table *p_cbs,
+                                ABT_xstream xstream)
+{
+    int i;
+    for (i = 0; i < p_cbs->num_cbs; i++) {
+        ABTI_event_cb *p_cb = &p_cbs->cbs[i];
+        if (p_cb->act_fn) p_cb->act_fn(p_cb->act_arg, xstream);
+    }
+}
+#endif
+
 
 #define EVT_DEBUG(fmt,...)                      \
     do {                                        \
@@ -121,6 +222,47 @@ static ABTI_event_info *gp_einfo = NULL;
     } while (0)
 
 
+#if defined(ABT_CONFIG_HANDLE_POWER_EVENT) || defined(ABT_CONFIG_PUBLISH_INFO)
+/* Map the first size bytes of the file p_path, which is created or extended
+ * as needed.  The first "%d" in p_path is replaced with the process ID.
+ * Return NULL on failure. */
+static void *ABTI_event_map_file(const char *p_path, size_t size)
+{
+    char path[PATH_MAX];
+    const char *p_fmt = strstr(p_path, "%d");
+    struct stat st;
+    void *p_mem;
+    int fd;
+
+    if (p_fmt) {
+        snprintf(path, PATH_MAX, "%.*s%d%s", (int)(p_fmt - p_path), p_path,
+                 (int)getpid(), p_fmt + 2);
+    } else {
+        snprintf(path, PATH_MAX, "%s", p_path);
+    }
+
+    fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        EVT_DEBUG("[%s] %s: open failed\n", gp_einfo->hostname, path);
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || (st.st_size < (off_t)size &&
+        ftruncate(fd, size) != 0)) {
+        EVT_DEBUG("[%s] %s: resize failed\n", gp_einfo->hostname, path);
+        close(fd);
+        return NULL;
+    }
+    p_mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p_mem == MAP_FAILED) {
+        EVT_DEBUG("[%s] %s: mmap failed\n", gp_einfo->hostname, path);
+        return NULL;
+    }
+    EVT_DEBUG("[%s] %s: mapped\n", gp_einfo->hostname, path);
+    return p_mem;
+}
+#endif
+
 /** @defgroup EVENT Event
  * This group is for event handling.
  */
@@ -150,21 +292,16 @@ void ABTI_event_init(void)
     }
 
 #ifdef ABT_CONFIG_HANDLE_POWER_EVENT
-    gp_einfo->max_stop_xstream_fn = ABTI_DEFAULT_MAX_CB_FN;
-    gp_einfo->num_stop_xstream_fn = 0;
-    gp_einfo->stop_xstream_fn = (ABT_event_cb_fn *)
-        ABTU_calloc(ABTI_DEFAULT_MAX_CB_FN * 2, sizeof(ABT_event_cb_fn));
-    gp_einfo->stop_xstream_arg = (void **)
-        ABTU_calloc(ABTI_DEFAULT_MAX_CB_FN * 2, sizeof(void *));
-
-    gp_einfo->max_add_xstream_fn = ABTI_DEFAULT_MAX_CB_FN;
-    gp_einfo->num_add_xstream_fn = 0;
-    gp_einfo->add_xstream_fn = (ABT_event_cb_fn *)
-        ABTU_calloc(ABTI_DEFAULT_MAX_CB_FN * 2, sizeof(ABT_event_cb_fn));
-    gp_einfo->add_xstream_arg = (void **)
-        ABTU_calloc(ABTI_DEFAULT_MAX_CB_FN * 2, sizeof(void *));
-
-    ABTI_event_connect_power(gp_ABTI_global->pm_host, gp_ABTI_global->pm_port);
+    ABTI_spinlock_create(&gp_einfo->cb_lock);
+    gp_einfo->p_stop_xstream_cbs = ABTI_event_alloc_cbs(0);
+    gp_einfo->p_add_xstream_cbs = ABTI_event_alloc_cbs(0);
+
+    if (gp_ABTI_global->pm_shm) {
+        ABTI_event_map_power(gp_ABTI_global->pm_shm);
+    } else {
+        ABTI_event_connect_power(gp_ABTI_global->pm_host,
+                                 gp_ABTI_global->pm_port);
+    }
 #endif
 #ifdef ABT_CONFIG_PUBLISH_INFO
     if (gp_ABTI_global->pub_needed == ABT_TRUE) {
@@ -195,6 +332,14 @@ void ABTI_event_init(void)
             gp_einfo->out_file = stdout;
 #endif /* HAVE_BEACON_H */
 
+        } else if (!strncmp(gp_ABTI_global->pub_filename, "shm:", 4)) {
+            gp_einfo->pub_type = ABTI_PUB_TYPE_SHM;
+            if (ABTI_event_map_metrics(gp_ABTI_global->pub_filename + 4)
+                    != ABT_SUCCESS) {
+                gp_ABTI_global->pub_needed = ABT_FALSE;
+                goto fn_exit;
+            }
+
         } else {
             gp_einfo->pub_type = ABTI_PUB_TYPE_FILE;
             if (!strcmp(gp_ABTI_global->pub_filename, "stdout")) {
@@ -240,10 +385,9 @@ void ABTI_event_finalize(void)
 #ifdef ABT_CONFIG_HANDLE_POWER_EVENT
     ABTI_event_disconnect_power();
 
-    ABTU_free(gp_einfo->stop_xstream_fn);
-    ABTU_free(gp_einfo->stop_xstream_arg);
-    ABTU_free(gp_einfo->add_xstream_fn);
-    ABTU_free(gp_einfo->add_xstream_arg);
+    ABTU_free(gp_einfo->p_stop_xstream_cbs);
+    ABTU_free(gp_einfo->p_add_xstream_cbs);
+    ABTI_spinlock_free(&gp_einfo->cb_lock);
 #endif
 #ifdef ABT_CONFIG_PUBLISH_INFO
     if (gp_ABTI_global->pub_needed == ABT_TRUE) {
@@ -253,6 +397,11 @@ void ABTI_event_finalize(void)
             ABTU_free(gp_einfo->topic_info);
             ABTU_free(gp_einfo->eprop);
 #endif
+        } else if (gp_einfo->pub_type == ABTI_PUB_TYPE_SHM) {
+            ABT_event_metrics *p_metrics = gp_einfo->p_metrics;
+            munmap(p_metrics, p_metrics->es_offset +
+                   (size_t)p_metrics->max_xstreams * p_metrics->es_size);
+            gp_einfo->p_metrics = NULL;
         } else {
             if (gp_einfo->out_file != stdout && gp_einfo->out_file != stderr) {
                 fclose(gp_einfo->out_file);
@@ -313,8 +462,51 @@ void ABTI_event_connect_power(char *p_host, int port)
               gp_einfo->hostname, p_host, port);
 }
 
+/* Map the control block shared with the power management daemon. */
+void ABTI_event_map_power(char *p_path)
+{
+    ABT_event_ctrl *p_ctrl;
+
+    p_ctrl = (ABT_event_ctrl *)ABTI_event_map_file(p_path,
+                                                   sizeof(ABT_event_ctrl));
+    if (p_ctrl == NULL) return;
+
+    if (p_ctrl->magic != ABT_EVENT_CTRL_MAGIC ||
+        p_ctrl->version != ABT_EVENT_CTRL_VERSION) {
+        memset(p_ctrl, 0, sizeof(ABT_event_ctrl));
+        p_ctrl->magic = ABT_EVENT_CTRL_MAGIC;
+        p_ctrl->version = ABT_EVENT_CTRL_VERSION;
+    }
+    p_ctrl->pid = (int32_t)getpid();
+    p_ctrl->num_xstreams = gp_ABTI_global->num_xstreams;
+
+    /* A request posted before this process started is handled as well. */
+    gp_einfo->ctrl_seq = p_ctrl->ack_seq;
+    gp_einfo->p_ctrl = p_ctrl;
+}
+
+/* Report the result of a request to the power management daemon */
+static void ABTI_event_reply(char *send_buf)
+{
+    ABT_event_ctrl *p_ctrl = gp_einfo->p_ctrl;
+
+    if (p_ctrl) {
+        p_ctrl->num_xstreams = gp_ABTI_global->num_xstreams;
+        p_ctrl->status = (send_buf[1] == 'S') ? 1 : -1;
+        ABTD_atomic_mem_barrier();
+        p_ctrl->ack_seq = gp_einfo->ctrl_seq;
+    } else if (gp_ABTI_global->pm_connected == ABT_TRUE) {
+        int n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
+        ABTI_ASSERT(n == strlen(send_buf));
+    }
+}
+
 void ABTI_event_disconnect_power(void)
 {
+    if (gp_einfo->p_ctrl) {
+        munmap(gp_einfo->p_ctrl, sizeof(ABT_event_ctrl));
+        gp_einfo->p_ctrl = NULL;
+    }
     if (gp_ABTI_global->pm_connected == ABT_FALSE) return;
 
     close(gp_einfo->pfd.fd);
@@ -341,7 +533,7 @@ static void ABTI_event_free_xstream(void *arg)
     char send_buf[ABTI_MSG_BUF_LEN];
     ABT_xstream xstream = (ABT_xstream)arg;
     ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
-    int abt_errno, n;
+    int abt_errno;
 
     while (p_xstream->state != ABT_XSTREAM_STATE_TERMINATED) {
         ABT_thread_yield();
@@ -352,12 +544,9 @@ static void ABTI_event_free_xstream(void *arg)
     abt_errno = ABT_xstream_free(&xstream);
     ABTI_ASSERT(abt_errno == ABT_SUCCESS);
 
-    if (gp_ABTI_global->pm_connected == ABT_TRUE) {
-        LOG_DEBUG("# of ESs: %d\n", gp_ABTI_global->num_xstreams);
-        sprintf(send_buf, "[S] killed 1 (%d)", gp_ABTI_global->num_xstreams);
-        n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-        ABTI_ASSERT(n == strlen(send_buf));
-    }
+    LOG_DEBUG("# of ESs: %d\n", gp_ABTI_global->num_xstreams);
+    sprintf(send_buf, "[S] killed 1 (%d)", gp_ABTI_global->num_xstreams);
+    ABTI_event_reply(send_buf);
 }
 
 static void ABTI_event_free_multiple_xstreams(void *arg)
@@ -381,44 +570,30 @@ static void ABTI_event_free_multiple_xstreams(void *arg)
     }
     ABTU_free(p_xstreams);
 
-    if (gp_ABTI_global->pm_connected == ABT_TRUE) {
-        LOG_DEBUG("# of ESs: %d\n", gp_ABTI_global->num_xstreams);
-        sprintf(send_buf, "[S] killed %d (%d)", num_xstreams,
-                          gp_ABTI_global->num_xstreams);
-        n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-        ABTI_ASSERT(n == strlen(send_buf));
-    }
+    LOG_DEBUG("# of ESs: %d\n", gp_ABTI_global->num_xstreams);
+    sprintf(send_buf, "[S] killed %d (%d)", num_xstreams,
+                      gp_ABTI_global->num_xstreams);
+    ABTI_event_reply(send_buf);
 }
 
 ABT_bool ABTI_event_stop_xstream(ABTI_xstream *p_xstream)
 {
     int abt_errno = ABT_SUCCESS;
-    ABT_bool can_stop = ABT_TRUE;
-    ABT_event_cb_fn cb_fn;
+    ABTI_event_cb_table *p_cbs;
+    ABT_bool can_stop;
     ABT_xstream xstream = ABTI_xstream_get_handle(p_xstream);
     ABT_xstream primary;
     ABT_pool pool;
-    int i;
 
     /* Ask whether the target ES can be stopped */
-    for (i = 0; i < gp_einfo->max_stop_xstream_fn; i++) {
-        cb_fn = gp_einfo->stop_xstream_fn[i*2];
-        if (cb_fn) {
-            can_stop = cb_fn(gp_einfo->stop_xstream_arg[i*2], xstream);
-            if (can_stop == ABT_FALSE) break;
-        }
-    }
+    p_cbs = ABTI_event_get_cbs(&gp_einfo->p_stop_xstream_cbs);
+    can_stop = ABTI_event_ask_stop(p_cbs, xstream);
 
     if (can_stop == ABT_TRUE) {
         ABTI_xstream_set_request(p_xstream, ABTI_XSTREAM_REQ_STOP);
 
         /* Execute action callback functions */
-        for (i = 0; i < gp_einfo->max_stop_xstream_fn; i++) {
-            cb_fn = gp_einfo->stop_xstream_fn[i*2+1];
-            if (cb_fn) {
-                cb_fn(gp_einfo->stop_xstream_arg[i*2+1], xstream);
-            }
-        }
+        ABTI_event_act_stop(p_cbs, xstream);
 
         /* Create a ULT on the primary ES to join the target ES */
         primary = ABTI_xstream_get_handle(gp_ABTI_global->p_xstreams[0]);
@@ -434,24 +609,25 @@ ABT_bool ABTI_event_stop_xstream(ABTI_xstream *p_xstream)
 void ABTI_event_decrease_xstream(int target_rank)
 {
     char send_buf[ABTI_MSG_BUF_LEN];
+    ABTI_xstream **p_xstreams;
     ABTI_xstream *p_xstream;
-    int rank, n;
+    int rank, max_xstreams;
     ABT_bool can_stop = ABT_FALSE;
     ABTI_global *p_global = gp_ABTI_global;
 
     if (p_global->num_xstreams == 1) {
         LOG_DEBUG("Cannot shrink: # of ESs (%d)\n", p_global->num_xstreams);
         sprintf(send_buf, "[F] only one ES");
-        n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-        ABTI_ASSERT(n == strlen(send_buf));
+        ABTI_event_reply(send_buf);
         return;
     }
 
+    p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
     if (target_rank == ABT_XSTREAM_ANY_RANK) {
         /* Determine the ES to shut down.  For now, we try to shut down the most
          * recently created one. */
-        for (rank = p_global->num_xstreams - 1; rank > 0; rank--) {
-            p_xstream = p_global->p_xstreams[rank];
+        for (rank = max_xstreams - 1; rank > 0; rank--) {
+            p_xstream = p_xstreams[rank];
             if (p_xstream) {
                 can_stop = ABTI_event_stop_xstream(p_xstream);
                 if (can_stop == ABT_TRUE) break;
@@ -459,8 +635,8 @@ void ABTI_event_decrease_xstream(int target_rank)
         }
     } else {
         /* Stop a specific ES */
-        if (target_rank < p_global->max_xstreams) {
-            p_xstream = p_global->p_xstreams[target_rank];
+        if (target_rank < max_xstreams) {
+            p_xstream = p_xstreams[target_rank];
             if (p_xstream) {
                 can_stop = ABTI_event_stop_xstream(p_xstream);
             }
@@ -470,8 +646,7 @@ void ABTI_event_decrease_xstream(int target_rank)
     /* We couldn't stop an ES */
     if (can_stop == ABT_FALSE) {
         sprintf(send_buf, "[F] not possible");
-        n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-        ABTI_ASSERT(n == strlen(send_buf));
+        ABTI_event_reply(send_buf);
     }
 }
 
@@ -479,18 +654,17 @@ void ABTI_event_decrease_xstream(int target_rank)
 void ABTI_event_shrink_xstreams(int num_xstreams)
 {
     char send_buf[ABTI_MSG_BUF_LEN];
-    ABTI_xstream **p_xstreams;
+    ABTI_xstream **p_xstreams, **p_all_xstreams;
     ABTI_xstream *p_xstream;
     ABT_xstream xstream;
-    int i, rank, n;
-    ABT_event_cb_fn cb_fn;
+    int rank, n, max_xstreams;
+    ABTI_event_cb_table *p_cbs;
     ABTI_global *p_global = gp_ABTI_global;
 
     if (p_global->num_xstreams == 1) {
         LOG_DEBUG("Cannot shrink: # of ESs (%d)\n", p_global->num_xstreams);
         sprintf(send_buf, "[F] only one ES");
-        n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-        ABTI_ASSERT(n == strlen(send_buf));
+        ABTI_event_reply(send_buf);
         return;
     }
 
@@ -500,30 +674,19 @@ void ABTI_event_shrink_xstreams(int num_xstreams)
 
     /* Determine ESs to shut down.  For now, we try to shut down from the most
      * recently created ones. */
-    for (rank = p_global->num_xstreams - 1; rank > 0; rank--) {
-        p_xstream = p_global->p_xstreams[rank];
+    p_all_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+    p_cbs = ABTI_event_get_cbs(&gp_einfo->p_stop_xstream_cbs);
+    for (rank = max_xstreams - 1; rank > 0; rank--) {
+        p_xstream = p_all_xstreams[rank];
         if (p_xstream) {
             /* Ask whether the target ES can be stopped */
             xstream = ABTI_xstream_get_handle(p_xstream);
-            ABT_bool can_stop = ABT_TRUE;
-            for (i = 0; i < gp_einfo->max_stop_xstream_fn; i++) {
-                cb_fn = gp_einfo->stop_xstream_fn[i*2];
-                if (cb_fn) {
-                    can_stop = cb_fn(gp_einfo->stop_xstream_arg[i*2], xstream);
-                    if (can_stop == ABT_FALSE) break;
-                }
-            }
-            if (can_stop == ABT_FALSE) continue;
+            if (ABTI_event_ask_stop(p_cbs, xstream) == ABT_FALSE) continue;
 
             ABTI_xstream_set_request(p_xstream, ABTI_XSTREAM_REQ_STOP);
 
             /* Execute action callback functions */
-            for (i = 0; i < gp_einfo->max_stop_xstream_fn; i++) {
-                cb_fn = gp_einfo->stop_xstream_fn[i*2+1];
-                if (cb_fn) {
-                    cb_fn(gp_einfo->stop_xstream_arg[i*2+1], xstream);
-                }
-            }
+            ABTI_event_act_stop(p_cbs, xstream);
 
             p_xstreams[n+1] = p_xstream;
             if (++n == num_xstreams) break;
@@ -533,8 +696,7 @@ void ABTI_event_shrink_xstreams(int num_xstreams)
     if (n == 0) {
         /* We couldn't stop ESs */
         sprintf(send_buf, "[F] not possible");
-        n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-        ABTI_ASSERT(n == strlen(send_buf));
+        ABTI_event_reply(send_buf);
         ABTU_free(p_xstreams);
         return;
     }
@@ -555,23 +717,24 @@ void ABTI_event_increase_xstream(int target_rank)
 {
     void *abt_arg = (void *)(intptr_t)target_rank;
     char send_buf[ABTI_MSG_BUF_LEN];
-    ABT_event_cb_fn cb_fn;
+    ABTI_event_cb_table *p_cbs;
+    ABTI_event_cb *p_cb;
     ABT_bool ret;
-    int i, n;
+    int i;
 
-    for (i = 0; i < gp_einfo->max_add_xstream_fn; i++) {
+    p_cbs = ABTI_event_get_cbs(&gp_einfo->p_add_xstream_cbs);
+    for (i = 0; i < p_cbs->num_cbs; i++) {
         /* "ask" callback */
-        cb_fn = gp_einfo->add_xstream_fn[i*2];
-        if (!cb_fn) continue;
+        p_cb = &p_cbs->cbs[i];
+        if (!p_cb->ask_fn) continue;
 
         /* TODO: fairness */
-        ret = cb_fn(gp_einfo->add_xstream_arg[i*2], abt_arg);
+        ret = p_cb->ask_fn(p_cb->ask_arg, abt_arg);
         if (ret == ABT_TRUE) {
             /* "act" callback */
-            cb_fn = gp_einfo->add_xstream_fn[i*2+1];
-            if (!cb_fn) continue;
+            if (!p_cb->act_fn) continue;
 
-            ret = cb_fn(gp_einfo->add_xstream_arg[i*2+1], abt_arg);
+            ret = p_cb->act_fn(p_cb->act_arg, abt_arg);
             if (ret == ABT_TRUE) {
                 LOG_DEBUG("# of ESs: %d\n", gp_ABTI_global->num_xstreams);
                 sprintf(send_buf, "[S] created 1 (%d)", gp_ABTI_global->num_xstreams);
@@ -584,40 +747,47 @@ void ABTI_event_increase_xstream(int target_rank)
     sprintf(send_buf, "[F] not possible");
 
   send_ack:
-    n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-    ABTI_ASSERT(n == strlen(send_buf));
+    ABTI_event_reply(send_buf);
 }
 
-void ABTI_event_expand_xstreams(int num_xstreams)
+/* Create one ES through the add callbacks.  Return ABT_TRUE if created. */
+static ABT_bool ABTI_event_add_xstream(void)
 {
     void *abt_arg = (void *)(intptr_t)ABT_XSTREAM_ANY_RANK;
-    char send_buf[ABTI_MSG_BUF_LEN];
-    ABT_event_cb_fn cb_fn;
-    ABT_bool can_add;
-    int i, n;
+    ABTI_event_cb_table *p_cbs;
+    ABTI_event_cb *p_cb;
+    ABT_bool can_add = ABT_FALSE;
+    int i;
 
-    for (n = 0; n < num_xstreams; n++) {
-        can_add = ABT_FALSE;
-        for (i = 0; i < gp_einfo->max_add_xstream_fn; i++) {
-            /* "ask" callback */
-            cb_fn = gp_einfo->add_xstream_fn[i*2];
-            if (!cb_fn) continue;
-
-            /* TODO: fairness */
-            can_add = cb_fn(gp_einfo->add_xstream_arg[i*2], abt_arg);
-            if (can_add == ABT_TRUE) {
-                /* "act" callback */
-                cb_fn = gp_einfo->add_xstream_fn[i*2+1];
-                if (!cb_fn) {
-                    can_add = ABT_FALSE;
-                    continue;
-                }
+    p_cbs = ABTI_event_get_cbs(&gp_einfo->p_add_xstream_cbs);
+    for (i = 0; i < p_cbs->num_cbs; i++) {
+        /* "ask" callback */
+        p_cb = &p_cbs->cbs[i];
+        if (!p_cb->ask_fn) continue;
 
-                can_add = cb_fn(gp_einfo->add_xstream_arg[i*2+1], abt_arg);
-                if (can_add == ABT_TRUE) break;
+        /* TODO: fairness */
+        can_add = p_cb->ask_fn(p_cb->ask_arg, abt_arg);
+        if (can_add == ABT_TRUE) {
+            /* "act" callback */
+            if (!p_cb->act_fn) {
+                can_add = ABT_FALSE;
+                continue;
             }
+
+            can_add = p_cb->act_fn(p_cb->act_arg, abt_arg);
+            if (can_add == ABT_TRUE) break;
         }
-        if (can_add == ABT_FALSE) break;
+    }
+    return can_add;
+}
+
+void ABTI_event_expand_xstreams(int num_xstreams)
+{
+    char send_buf[ABTI_MSG_BUF_LEN];
+    int n;
+
+    for (n = 0; n < num_xstreams; n++) {
+        if (ABTI_event_add_xstream() == ABT_FALSE) break;
     }
 
     if (n > 0) {
@@ -628,8 +798,7 @@ void ABTI_event_expand_xstreams(int num_xstreams)
         sprintf(send_buf, "[F] not possible");
     }
 
-    n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-    ABTI_ASSERT(n == strlen(send_buf));
+    ABTI_event_reply(send_buf);
 }
 
 void ABTI_event_set_num_xstreams(int num_xstreams)
@@ -648,9 +817,105 @@ void ABTI_event_set_num_xstreams(int num_xstreams)
 
     } else {
         sprintf(send_buf, "[S] no change (%d)", p_global->num_xstreams);
-        int n = write(gp_einfo->pfd.fd, send_buf, strlen(send_buf));
-        ABTI_ASSERT(n == strlen(send_buf));
+        ABTI_event_reply(send_buf);
+    }
+}
+
+/* Add or stop an ES by the demand observed since the last decision.  An ES
+ * is added when the units waiting in the main pools exceed
+ * ABT_ELASTIC_GROW_DEPTH per ES, and the most recently created ES is stopped
+ * when the main pools are empty and most pops of the ESs found no unit.  At
+ * most one ES is added or stopped per ABT_ELASTIC_INTERVAL_NSEC. */
+static void ABTI_event_check_elastic(void)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_xstream **p_xstreams;
+    ABTI_xstream *p_xstream, *p_victim = NULL;
+    uint64_t num_pops = 0, num_failed_pops = 0, num_tries;
+    size_t depth = 0;
+    int rank, i, max_xstreams, num_active = 0;
+    double now = ABT_get_wtime();
+
+    if (now < gp_einfo->elastic_next_time) return;
+    if (ABTI_mutex_trylock(&gp_einfo->mutex) != ABT_SUCCESS) return;
+    if (now < gp_einfo->elastic_next_time) goto fn_exit;
+    gp_einfo->elastic_next_time = now + p_global->elastic_interval;
+
+    p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+    for (rank = 0; rank < max_xstreams; rank++) {
+        p_xstream = p_xstreams[rank];
+        if (p_xstream == NULL) continue;
+        if (p_xstream->state == ABT_XSTREAM_STATE_TERMINATED) continue;
+        if (p_xstream->request & ABTI_XSTREAM_REQ_STOP) continue;
+
+        /* A pool shared by several schedulers is counted once in total. */
+        ABTI_sched *p_sched = p_xstream->p_main_sched;
+        for (i = 0; i < p_sched->num_pools; i++) {
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[i]);
+            int32_t num_scheds = p_pool->num_scheds;
+            depth += ABTI_pool_call_get_size(p_pool)
+                   / (num_scheds > 1 ? (size_t)num_scheds : 1);
+        }
+        num_pops += p_xstream->stats.num_pops;
+        num_failed_pops += p_xstream->stats.num_failed_pops;
+        num_active++;
+        if (rank > 0) p_victim = p_xstream;
+    }
+
+    /* Look at the pops since the last decision */
+    num_tries = (num_pops - gp_einfo->elastic_num_pops)
+              + (num_failed_pops - gp_einfo->elastic_num_failed_pops);
+    ABT_bool is_idle = (num_tries > 0 &&
+        (num_failed_pops - gp_einfo->elastic_num_failed_pops) * 100
+        > num_tries * p_global->elastic_park_idle) ? ABT_TRUE : ABT_FALSE;
+    gp_einfo->elastic_num_pops = num_pops;
+    gp_einfo->elastic_num_failed_pops = num_failed_pops;
+
+    if (depth > (size_t)num_active * p_global->elastic_grow_depth &&
+        num_active < p_global->elastic_max_xstreams) {
+        if (ABTI_event_add_xstream() == ABT_TRUE) {
+            LOG_DEBUG("elastic: added an ES (depth %zu, # of ESs: %d)\n",
+                      depth, p_global->num_xstreams);
+        }
+    } else if (depth == 0 && is_idle == ABT_TRUE && p_victim &&
+               num_active > p_global->elastic_min_xstreams) {
+        if (ABTI_event_stop_xstream(p_victim) == ABT_TRUE) {
+            LOG_DEBUG("elastic: stopped ES%d (# of ESs: %d)\n",
+                      p_victim->rank, p_global->num_xstreams);
+        }
+    }
+
+  fn_exit:
+    ABTI_mutex_unlock(&gp_einfo->mutex);
+}
+
+/* Handle a new request in the shared control block.  Without a request,
+ * this only loads seq. */
+static void ABTI_event_check_ctrl(void)
+{
+    ABT_event_ctrl *p_ctrl = gp_einfo->p_ctrl;
+    char send_buf[ABTI_MSG_BUF_LEN];
+    uint32_t seq;
+    int target;
+
+    if (p_ctrl->seq == gp_einfo->ctrl_seq) return;
+    if (ABTI_mutex_trylock(&gp_einfo->mutex) != ABT_SUCCESS) return;
+
+    seq = p_ctrl->seq;
+    if (seq != gp_einfo->ctrl_seq) {
+        ABTD_atomic_mem_barrier();
+        target = p_ctrl->target_num_xstreams;
+        gp_einfo->ctrl_seq = seq;
+        LOG_DEBUG("received request %u: %d ESs\n", seq, target);
+        if (target > 0) {
+            ABTI_event_set_num_xstreams(target);
+        } else {
+            sprintf(send_buf, "[F] invalid target");
+            ABTI_event_reply(send_buf);
+        }
     }
+
+    ABTI_mutex_unlock(&gp_einfo->mutex);
 }
 
 ABT_bool ABTI_event_check_power(void)
@@ -660,7 +925,12 @@ ABT_bool ABTI_event_check_power(void)
     char recv_buf[ABTI_MSG_BUF_LEN];
     ABTI_xstream *p_xstream;
 
-    if (gp_ABTI_global->pm_connected == ABT_FALSE) goto fn_exit;
+    if (gp_ABTI_global->elastic == ABT_TRUE) ABTI_event_check_elastic();
+    if (gp_einfo->p_ctrl) {
+        ABTI_event_check_ctrl();
+        goto check_stop;
+    }
+    if (gp_ABTI_global->pm_connected == ABT_FALSE) goto check_stop;
 
     ABT_xstream_self_rank(&rank);
 
@@ -737,6 +1007,7 @@ ABT_bool ABTI_event_check_power(void)
 
     ABTI_mutex_unlock(&gp_einfo->mutex);
 
+  check_stop:
     p_xstream = ABTI_local_get_xstream();
     if (p_xstream->request & ABTI_XSTREAM_REQ_STOP) {
         stop_xstream = ABT_TRUE;
@@ -756,6 +1027,11 @@ ABT_bool ABTI_event_check_power(void)
  * used to delete registered callbacks in \c ABT_event_del_callback().  All
  * registered callbacks will be invoked when the event happens.
  *
+ * Registration never blocks the schedulers, which may be handling an event at
+ * the same time.  A scheduler that is running callbacks keeps using the set
+ * of callbacks that it has read, and sees the change at its next event check.
+ * Callbacks may add and delete callbacks.
+ *
  * @param[in] event         event kind
  * @param[in] ask_cb        callback to ask whether the event can be handled
  * @param[in] ask_user_arg  user argument for \c ask_cb
@@ -772,98 +1048,33 @@ int ABT_event_add_callback(ABT_event_kind event,
 {
 #ifdef ABT_CONFIG_HANDLE_POWER_EVENT
     int abt_errno = ABT_SUCCESS;
-    int cur_num, max_num;
-    size_t new_size;
-    int cid = -1;
-    int i;
-
-    ABTI_mutex_spinlock(&gp_einfo->mutex);
-    switch (event) {
-        case ABT_EVENT_STOP_XSTREAM:
-            cur_num = gp_einfo->num_stop_xstream_fn;
-            max_num = gp_einfo->max_stop_xstream_fn;
-            if (cur_num == max_num) {
-                /* We need to allocate more space */
-                max_num = max_num * 2;
-                gp_einfo->max_stop_xstream_fn = max_num;
-                new_size = max_num * 2 * sizeof(ABT_event_cb_fn);
-                gp_einfo->stop_xstream_fn = (ABT_event_cb_fn *)
-                    ABTU_realloc(gp_einfo->stop_xstream_fn, new_size);
-                new_size = max_num * 2 * sizeof(void *);
-                gp_einfo->stop_xstream_arg = (void **)
-                    ABTU_realloc(gp_einfo->stop_xstream_arg, new_size);
-            }
-            ABTI_ASSERT(cur_num < max_num);
-
-            if (gp_einfo->stop_xstream_fn[cur_num*2] == NULL) {
-                gp_einfo->stop_xstream_fn[cur_num*2] = ask_cb;
-                gp_einfo->stop_xstream_arg[cur_num*2] = ask_user_arg;
-                gp_einfo->stop_xstream_fn[cur_num*2+1] = act_cb;
-                gp_einfo->stop_xstream_arg[cur_num*2+1] = act_user_arg;
-                cid = cur_num;
-            } else {
-                for (i = 0; i < max_num; i++) {
-                    if (gp_einfo->stop_xstream_fn[i*2] == NULL) {
-                        gp_einfo->stop_xstream_fn[i*2] = ask_cb;
-                        gp_einfo->stop_xstream_arg[i*2] = ask_user_arg;
-                        gp_einfo->stop_xstream_fn[i*2+1] = act_cb;
-                        gp_einfo->stop_xstream_arg[i*2+1] = act_user_arg;
-                        cid = i;
-                        break;
-                    }
-                }
-                ABTI_ASSERT(i < max_num);
-            }
-            gp_einfo->num_stop_xstream_fn++;
-            break;
-
-        case ABT_EVENT_ADD_XSTREAM:
-            cur_num = gp_einfo->num_add_xstream_fn;
-            max_num = gp_einfo->max_add_xstream_fn;
-            if (cur_num == max_num) {
-                /* We need to allocate more space */
-                max_num = max_num * 2;
-                gp_einfo->max_add_xstream_fn = max_num;
-                new_size = max_num * 2 * sizeof(ABT_event_cb_fn);
-                gp_einfo->add_xstream_fn = (ABT_event_cb_fn *)
-                    ABTU_realloc(gp_einfo->add_xstream_fn, new_size);
-                new_size = max_num * 2 * sizeof(void *);
-                gp_einfo->add_xstream_arg = (void **)
-                    ABTU_realloc(gp_einfo->add_xstream_arg, new_size);
-            }
-            ABTI_ASSERT(cur_num < max_num);
-
-            if (gp_einfo->add_xstream_fn[cur_num*2] == NULL) {
-                gp_einfo->add_xstream_fn[cur_num*2] = ask_cb;
-                gp_einfo->add_xstream_arg[cur_num*2] = ask_user_arg;
-                gp_einfo->add_xstream_fn[cur_num*2+1] = act_cb;
-                gp_einfo->add_xstream_arg[cur_num*2+1] = act_user_arg;
-                cid = cur_num;
-            } else {
-                for (i = 0; i < max_num; i++) {
-                    if (gp_einfo->add_xstream_fn[i*2] == NULL) {
-                        gp_einfo->add_xstream_fn[i*2] = ask_cb;
-                        gp_einfo->add_xstream_arg[i*2] = ask_user_arg;
-                        gp_einfo->add_xstream_fn[i*2+1] = act_cb;
-                        gp_einfo->add_xstream_arg[i*2+1] = act_user_arg;
-                        cid = i;
-                        break;
-                    }
-                }
-                ABTI_ASSERT(i < max_num);
-            }
-            gp_einfo->num_add_xstream_fn++;
-            break;
-
-        default:
-            abt_errno = ABT_ERR_INV_EVENT;
-            goto fn_fail;
-            break;
+    ABTI_event_cb_table **pp_cbs, *p_old, *p_new;
+    int cid, i;
+
+    *cb_id = -1;
+    pp_cbs = ABTI_event_get_cb_slot(event);
+    ABTI_CHECK_TRUE(pp_cbs != NULL, ABT_ERR_INV_EVENT);
+
+    /* Copy the table into the first free slot or a new one */
+    ABTI_spinlock_acquire(&gp_einfo->cb_lock);
+    p_old = *pp_cbs;
+    for (cid = 0; cid < p_old->num_cbs; cid++) {
+        if (p_old->cbs[cid].ask_fn == NULL) break;
     }
+    p_new = ABTI_event_alloc_cbs((cid < p_old->num_cbs) ? p_old->num_cbs
+                                                        : cid + 1);
+    for (i = 0; i < p_old->num_cbs; i++) {
+        p_new->cbs[i] = p_old->cbs[i];
+    }
+    p_new->cbs[cid].ask_fn = ask_cb;
+    p_new->cbs[cid].ask_arg = ask_user_arg;
+    p_new->cbs[cid].act_fn = act_cb;
+    p_new->cbs[cid].act_arg = act_user_arg;
+    ABTI_event_publish_cbs(pp_cbs, p_new);
+    ABTI_spinlock_release(&gp_einfo->cb_lock);
+    *cb_id = cid;
 
   fn_exit:
-    ABTI_mutex_unlock(&gp_einfo->mutex);
-    *cb_id = cid;
     return abt_errno;
 
   fn_fail:
@@ -890,32 +1101,32 @@ int ABT_event_del_callback(ABT_event_kind event, int cb_id)
 {
 #ifdef ABT_CONFIG_HANDLE_POWER_EVENT
     int abt_errno = ABT_SUCCESS;
-    ABTI_mutex_spinlock(&gp_einfo->mutex);
-    switch (event) {
-        case ABT_EVENT_STOP_XSTREAM:
-            gp_einfo->stop_xstream_fn[cb_id*2] = NULL;
-            gp_einfo->stop_xstream_fn[cb_id*2+1] = NULL;
-            gp_einfo->stop_xstream_arg[cb_id*2] = NULL;
-            gp_einfo->stop_xstream_arg[cb_id*2+1] = NULL;
-            gp_einfo->num_stop_xstream_fn++;
-            break;
-
-        case ABT_EVENT_ADD_XSTREAM:
-            gp_einfo->add_xstream_fn[cb_id*2] = NULL;
-            gp_einfo->add_xstream_fn[cb_id*2+1] = NULL;
-            gp_einfo->add_xstream_arg[cb_id*2] = NULL;
-            gp_einfo->add_xstream_arg[cb_id*2+1] = NULL;
-            gp_einfo->num_add_xstream_fn++;
-            break;
-
-        default:
-            abt_errno = ABT_ERR_INV_EVENT;
-            goto fn_fail;
-            break;
+    ABTI_event_cb_table **pp_cbs, *p_old, *p_new;
+    int i;
+
+    pp_cbs = ABTI_event_get_cb_slot(event);
+    ABTI_CHECK_TRUE(pp_cbs != NULL, ABT_ERR_INV_EVENT);
+
+    ABTI_spinlock_acquire(&gp_einfo->cb_lock);
+    p_old = *pp_cbs;
+    if (cb_id < 0 || cb_id >= p_old->num_cbs ||
+        p_old->cbs[cb_id].ask_fn == NULL) {
+        /* Nothing is registered with cb_id. */
+        ABTI_spinlock_release(&gp_einfo->cb_lock);
+        goto fn_exit;
     }
+    p_new = ABTI_event_alloc_cbs(p_old->num_cbs);
+    for (i = 0; i < p_old->num_cbs; i++) {
+        p_new->cbs[i] = p_old->cbs[i];
+    }
+    p_new->cbs[cb_id].ask_fn = NULL;
+    p_new->cbs[cb_id].ask_arg = NULL;
+    p_new->cbs[cb_id].act_fn = NULL;
+    p_new->cbs[cb_id].act_arg = NULL;
+    ABTI_event_publish_cbs(pp_cbs, p_new);
+    ABTI_spinlock_release(&gp_einfo->cb_lock);
 
   fn_exit:
-    ABTI_mutex_unlock(&gp_einfo->mutex);
     return abt_errno;
 
   fn_fail:
@@ -932,12 +1143,107 @@ void ABTI_event_realloc_pub_arrays(int size)
     ABTI_ASSERT(0);
 }
 
+#define ABTI_EVENT_ROUNDUP(x)                                               \
+    (((x) + ABT_CONFIG_CACHE_LINE_SIZE - 1)                                 \
+     & ~((size_t)ABT_CONFIG_CACHE_LINE_SIZE - 1))
+
+static inline ABT_event_metrics_es *ABTI_event_get_metrics_es(int rank)
+{
+    ABT_event_metrics *p_metrics = gp_einfo->p_metrics;
+    if (rank < 0 || rank >= p_metrics->max_xstreams) return NULL;
+    return (ABT_event_metrics_es *)((char *)p_metrics + p_metrics->es_offset
+                                    + (size_t)rank * p_metrics->es_size);
+}
+
+/* Map the metrics region of ABTI_PUB_TYPE_SHM.  Each record is on its own
+ * cache line(s) because only the ES of its rank writes it. */
+static int ABTI_event_map_metrics(const char *p_path)
+{
+    int max_xstreams = gp_ABTI_global->max_xstreams * 2;
+    size_t es_offset = ABTI_EVENT_ROUNDUP(sizeof(ABT_event_metrics));
+    size_t es_size = ABTI_EVENT_ROUNDUP(sizeof(ABT_event_metrics_es));
+    size_t size = es_offset + (size_t)max_xstreams * es_size;
+    ABT_event_metrics *p_metrics;
+    int i;
+
+    p_metrics = (ABT_event_metrics *)ABTI_event_map_file(p_path, size);
+    if (p_metrics == NULL) return ABT_ERR_OTHER;
+
+    /* Readers do not use the region until magic is set. */
+    memset(p_metrics, 0, size);
+    p_metrics->version = ABT_EVENT_METRICS_VERSION;
+    p_metrics->pid = (int32_t)getpid();
+    p_metrics->max_xstreams = max_xstreams;
+    p_metrics->es_offset = (uint32_t)es_offset;
+    p_metrics->es_size = (uint32_t)es_size;
+    p_metrics->num_xstreams = gp_ABTI_global->num_xstreams;
+    gp_einfo->p_metrics = p_metrics;
+    for (i = 0; i < max_xstreams; i++) {
+        ABTI_event_get_metrics_es(i)->rank = i;
+    }
+    ABTD_atomic_write_barrier();
+    p_metrics->magic = ABT_EVENT_METRICS_MAGIC;
+
+    return ABT_SUCCESS;
+}
+
+/* Writer side of the seqlocks of the metrics region */
+static inline void ABTI_event_seq_begin(volatile uint32_t *p_seq)
+{
+    *p_seq = *p_seq + 1;
+    ABTD_atomic_write_barrier();
+}
+
+static inline void ABTI_event_seq_end(volatile uint32_t *p_seq)
+{
+    ABTD_atomic_write_barrier();
+    *p_seq = *p_seq + 1;
+}
+
+/* Update the idle time in the record of the calling ES.  No lock is taken
+ * because nobody else writes the record. */
+static void ABTI_event_update_metrics(ABTI_xstream *p_xstream)
+{
+    int rank = (int)p_xstream->rank;
+    ABT_event_metrics_es *p_rec = ABTI_event_get_metrics_es(rank);
+    double cur_time = ABT_get_wtime();
+    uint32_t cur_num_units;
+
+    if (p_rec == NULL) return;
+
+    cur_num_units = (uint32_t)(p_rec->num_threads + p_rec->num_tasks);
+    ABTI_event_seq_begin(&p_rec->seq);
+    if (gp_einfo->old_timestamp[rank] > 0.0 &&
+        cur_num_units == gp_einfo->old_num_units[rank]) {
+        p_rec->idle_time += cur_time - gp_einfo->old_timestamp[rank];
+    }
+    p_rec->timestamp = cur_time;
+    ABTI_event_seq_end(&p_rec->seq);
+
+    gp_einfo->old_num_units[rank] = cur_num_units;
+    gp_einfo->old_timestamp[rank] = cur_time;
+    gp_einfo->p_metrics->num_xstreams = gp_ABTI_global->num_xstreams;
+}
+
 void ABTI_event_inc_unit_cnt(ABTI_xstream *p_xstream, ABT_unit_type type)
 {
     if (gp_ABTI_global->pub_needed == ABT_FALSE) return;
 
     int rank = (int)p_xstream->rank;
 
+    if (gp_einfo->pub_type == ABTI_PUB_TYPE_SHM) {
+        ABT_event_metrics_es *p_rec = ABTI_event_get_metrics_es(rank);
+        if (p_rec == NULL) return;
+        ABTI_event_seq_begin(&p_rec->seq);
+        if (type == ABT_UNIT_TYPE_THREAD) {
+            p_rec->num_threads++;
+        } else if (type == ABT_UNIT_TYPE_TASK) {
+            p_rec->num_tasks++;
+        }
+        ABTI_event_seq_end(&p_rec->seq);
+        return;
+    }
+
     if (rank > gp_einfo->max_xstream_rank) {
         ABTI_event_realloc_pub_arrays(rank);
     }
@@ -963,6 +1269,11 @@ void ABTI_event_publish_info(void)
     if (gp_ABTI_global->pub_needed == ABT_FALSE) return;
 
     p_xstream = ABTI_local_get_xstream();
+    if (gp_einfo->pub_type == ABTI_PUB_TYPE_SHM) {
+        ABTI_event_update_metrics(p_xstream);
+        return;
+    }
+
     rank = (int)p_xstream->rank;
     if (rank > gp_einfo->max_xstream_rank) {
         ABTI_event_realloc_pub_arrays(rank);
@@ -1164,6 +1475,22 @@ int ABT_event_prof_publish(const char *unit_name, double local_work,
 
     const char *sample_name = "application";
     double elapsed_time = gp_einfo->prof_stop_time - gp_einfo->prof_start_time;
+
+    if (gp_einfo->pub_type == ABTI_PUB_TYPE_SHM) {
+        /* Only add the values up; monitors compute the rates. */
+        ABT_event_metrics *p_metrics = gp_einfo->p_metrics;
+        ABTI_mutex_spinlock(&gp_einfo->mutex);
+        ABTI_event_seq_begin(&p_metrics->prof_seq);
+        p_metrics->prof_count++;
+        p_metrics->prof_elapsed_time += elapsed_time;
+        p_metrics->prof_local_work += local_work;
+        p_metrics->prof_global_work += global_work;
+        strncpy(p_metrics->prof_unit_name, unit_name,
+                sizeof(p_metrics->prof_unit_name) - 1);
+        ABTI_event_seq_end(&p_metrics->prof_seq);
+        ABTI_mutex_unlock(&gp_einfo->mutex);
+        return ABT_SUCCESS;
+    }
 #if defined(HAVE_RAPLREADER_H) && defined(HAVE_LIBINTERCOOLR)
     double power = gp_einfo->rr.power_total;
 #endif
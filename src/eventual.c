@@ -5,6 +5,10 @@
 
 #include "abti.h"
 
+static ABTI_eventual *ABTI_eventual_alloc(void);
+static void ABTI_eventual_init(ABTI_eventual *p_eventual, int nbytes,
+                               ABT_bool is_user_mem);
+static void ABTI_eventual_release(ABTI_eventual *p_eventual);
 
 /** @defgroup EVENTUAL Eventual
  * In Argobots, an \a eventual corresponds to the traditional behavior of
@@ -25,6 +29,10 @@
  * The list is initially empty.  If \c nbytes is zero, the eventual is used
  * without passing the data.
  *
+ * Each ES keeps eventuals freed on it for the following creations, and a small
+ * buffer is placed in the same memory as the eventual, so creating an eventual
+ * usually does not call \c malloc().
+ *
  * @param[in]  nbytes       size in bytes of the memory buffer
  * @param[out] neweventual  handle to a new eventual
  * @return Error code
@@ -35,13 +43,62 @@ int ABT_eventual_create(int nbytes, ABT_eventual *neweventual)
     int abt_errno = ABT_SUCCESS;
     ABTI_eventual *p_eventual;
 
-    p_eventual = (ABTI_eventual *)ABTU_malloc(sizeof(ABTI_eventual));
-    ABTI_spinlock_create(&p_eventual->lock);
-    p_eventual->ready = ABT_FALSE;
-    p_eventual->nbytes = nbytes;
-    p_eventual->value = (nbytes == 0) ? NULL : ABTU_malloc(nbytes);
-    p_eventual->p_head = NULL;
-    p_eventual->p_tail = NULL;
+    p_eventual = ABTI_eventual_alloc();
+    ABTI_eventual_init(p_eventual, nbytes, ABT_FALSE);
+
+    *neweventual = ABTI_eventual_get_handle(p_eventual);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup EVENTUAL
+ * @brief   Create an eventual that passes a pointer.
+ *
+ * \c ABT_eventual_create_ptr() creates an eventual that has no memory buffer.
+ * \c ABT_eventual_set() on it publishes the pointer \c value itself, and the
+ * waiters receive the same pointer instead of a copy of the data.  This saves
+ * copying large payloads, but the caller of \c ABT_eventual_set() has to keep
+ * the pointed data valid and unchanged while the waiters use it.  The \c
+ * nbytes argument of \c ABT_eventual_set() is ignored for such an eventual.
+ *
+ * @param[out] neweventual  handle to a new eventual
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_eventual_create_ptr(ABT_eventual *neweventual)
+{
+    int abt_errno = ABT_eventual_create(0, neweventual);
+    if (abt_errno == ABT_SUCCESS) {
+        ABTI_eventual_get_ptr(*neweventual)->is_ptr = ABT_TRUE;
+    }
+    return abt_errno;
+}
+
+/**
+ * @ingroup EVENTUAL
+ * @brief   Create an eventual in the given memory.
+ *
+ * \c ABT_eventual_init() is the same as \c ABT_eventual_create() except that
+ * the eventual is placed in \c memory provided by the caller, e.g., on its
+ * stack or in a request structure.  If \c nbytes is not larger than 64, the
+ * memory buffer is placed in \c memory, too.  The eventual has
+ * to be freed by \c ABT_eventual_free(), which does not release \c memory,
+ * before \c memory is reused.
+ *
+ * @param[in]  memory       memory for the eventual
+ * @param[in]  nbytes       size in bytes of the memory buffer
+ * @param[out] neweventual  handle to a new eventual
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_eventual_init(ABT_eventual_memory *memory, int nbytes,
+                      ABT_eventual *neweventual)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_eventual *p_eventual = (ABTI_eventual *)memory;
+
+    ABTI_eventual_init(p_eventual, nbytes, ABT_TRUE);
 
     *neweventual = ABTI_eventual_get_handle(p_eventual);
 
@@ -55,6 +112,7 @@ int ABT_eventual_create(int nbytes, ABT_eventual *neweventual)
  * \c ABT_eventual_free releases memory associated with the eventual
  * \c eventual. It also deallocates the memory buffer of the eventual.
  * If it is successfully processed, \c eventual is set to \c ABT_EVENTUAL_NULL.
+ * The memory of an eventual created by \c ABT_eventual_init() is not released.
  *
  * @param[in,out] eventual  handle to the eventual
  * @return Error code
@@ -72,8 +130,8 @@ int ABT_eventual_free(ABT_eventual *eventual)
     ABTI_spinlock_acquire(&p_eventual->lock);
 
     ABTI_spinlock_free(&p_eventual->lock);
-    if (p_eventual->value) ABTU_free(p_eventual->value);
-    ABTU_free(p_eventual);
+    ABTI_cont_free_list(p_eventual->p_cont_head);
+    ABTI_eventual_release(p_eventual);
 
     *eventual = ABT_EVENTUAL_NULL;
 
@@ -108,12 +166,11 @@ int ABT_eventual_wait(ABT_eventual eventual, void **value)
     ABTI_eventual *p_eventual = ABTI_eventual_get_ptr(eventual);
     ABTI_CHECK_NULL_EVENTUAL_PTR(p_eventual);
 
-    ABTI_spinlock_acquire(&p_eventual->lock);
-    if (p_eventual->ready == ABT_FALSE) {
+    if (*(volatile ABT_bool *)&p_eventual->ready == ABT_FALSE) {
         ABTI_thread *p_current;
         ABTI_unit *p_unit;
         ABT_unit_type type;
-        volatile int ext_signal = 0;
+        uint32_t ext_signal = ABTD_FUTEX_SIGNAL_INIT;
 
         if (lp_ABTI_local != NULL) {
             p_current = ABTI_local_get_thread();
@@ -123,6 +180,9 @@ int ABT_eventual_wait(ABT_eventual eventual, void **value)
             p_unit = &p_current->unit_def;
             p_unit->thread = ABTI_thread_get_handle(p_current);
             p_unit->type = type;
+            ABTI_thread_set_wait_obj(p_current, p_eventual,
+                                     ABTI_eventual_unlink_waiter);
+            ABTI_thread_set_blocked(p_current);
         } else {
             /* external thread */
             type = ABT_UNIT_TYPE_EXT;
@@ -131,34 +191,98 @@ int ABT_eventual_wait(ABT_eventual eventual, void **value)
             p_unit->type = type;
         }
 
-        p_unit->p_next = NULL;
-        if (p_eventual->p_head == NULL) {
-            p_eventual->p_head = p_unit;
-            p_eventual->p_tail = p_unit;
+        if (ABTI_eventual_push_waiter(p_eventual, p_unit) == ABT_FALSE) {
+            /* The eventual has become ready in the meantime. */
+            if (type == ABT_UNIT_TYPE_THREAD) {
+                ABTI_thread_unset_blocked(p_current);
+                ABTI_thread_unset_wait_obj(p_current);
+            } else {
+                ABTU_free(p_unit);
+            }
+        } else if (type == ABT_UNIT_TYPE_THREAD) {
+            /* Suspend the current ULT */
+            ABTI_thread_suspend(p_current);
+            ABTI_thread_unset_wait_obj(p_current);
+
         } else {
-            p_eventual->p_tail->p_next = p_unit;
-            p_eventual->p_tail = p_unit;
+            /* External thread is waiting here for ext_signal. */
+            ABTD_futex_signal_wait(&ext_signal);
+            ABTU_free(p_unit);
         }
+    }
+    if (value) *value = p_eventual->value;
 
-        if (type == ABT_UNIT_TYPE_THREAD) {
-            ABTI_thread_set_blocked(p_current);
+  fn_exit:
+    return abt_errno;
 
-            ABTI_spinlock_release(&p_eventual->lock);
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
 
-            /* Suspend the current ULT */
-            ABTI_thread_suspend(p_current);
+/**
+ * @ingroup EVENTUAL
+ * @brief   Wait on the eventual with a timeout.
+ *
+ * \c ABT_eventual_timedwait() works like \c ABT_eventual_wait() but returns
+ * \c ABT_ERR_TIMEDOUT if the eventual \c eventual is not ready before the
+ * absolute time \c abstime.  \c value is not updated in that case.  A waiting
+ * ULT is woken up by the scheduler of its ES once the deadline passes, so it
+ * may return somewhat later than \c abstime.
+ *
+ * @param[in]  eventual handle to the eventual
+ * @param[out] value    pointer to the memory buffer of the eventual
+ * @param[in]  abstime  absolute time for timeout
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_TIMEDOUT the deadline has passed
+ */
+int ABT_eventual_timedwait(ABT_eventual eventual, void **value,
+                           const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_eventual *p_eventual = ABTI_eventual_get_ptr(eventual);
+    ABTI_CHECK_NULL_EVENTUAL_PTR(p_eventual);
 
-        } else {
+    if (*(volatile ABT_bool *)&p_eventual->ready == ABT_FALSE) {
+        ABTI_timeout timeout;
+        ABTI_unit unit;
+
+        ABTI_CHECK_TRUE(lp_ABTI_local == NULL ||
+                        ABTI_local_get_thread() != NULL, ABT_ERR_EVENTUAL);
+
+        ABTI_spinlock_acquire(&p_eventual->lock);
+        if (p_eventual->ready == ABT_FALSE) {
+            ABTI_timeout_prepare(&timeout, ABTI_timeout_convert(abstime));
+            unit.pool = (ABT_pool)&timeout;
+            unit.type = ABTI_UNIT_TYPE_TIMED;
+            unit.p_prev = NULL;
+            unit.p_next = p_eventual->p_timed_head;
+            if (unit.p_next) unit.p_next->p_prev = &unit;
+            p_eventual->p_timed_head = &unit;
             ABTI_spinlock_release(&p_eventual->lock);
 
-            /* External thread is waiting here polling ext_signal. */
-            /* FIXME: need a better implementation */
-            while (!ext_signal) {
+            if (ABTI_timeout_wait(&timeout) == ABT_FALSE) {
+                /* If the waiter has been detached, the deadline has passed
+                 * while the eventual is being set. */
+                ABT_bool linked;
+                ABTI_spinlock_acquire(&p_eventual->lock);
+                linked = (unit.p_prev || p_eventual->p_timed_head == &unit)
+                       ? ABT_TRUE : ABT_FALSE;
+                if (linked == ABT_TRUE) {
+                    if (unit.p_prev) {
+                        unit.p_prev->p_next = unit.p_next;
+                    } else {
+                        p_eventual->p_timed_head = unit.p_next;
+                    }
+                    if (unit.p_next) unit.p_next->p_prev = unit.p_prev;
+                }
+                ABTI_spinlock_release(&p_eventual->lock);
+                if (linked == ABT_TRUE) return ABT_ERR_TIMEDOUT;
             }
-            ABTU_free(p_unit);
+        } else {
+            ABTI_spinlock_release(&p_eventual->lock);
         }
-    } else {
-        ABTI_spinlock_release(&p_eventual->lock);
     }
     if (value) *value = p_eventual->value;
 
@@ -170,6 +294,57 @@ int ABT_eventual_wait(ABT_eventual eventual, void **value)
     goto fn_exit;
 }
 
+/* Set p_eventual ready with value and wake up its waiters */
+static inline
+void ABTI_eventual_set(ABTI_eventual *p_eventual, void *value, int nbytes)
+{
+    ABTI_unit *p_waiters;
+    ABTI_thread *p_target = NULL;
+
+    /* The value has to be visible before the readiness, since waiters check
+     * ready without the lock.  A pointer is published before the lock is
+     * taken, so that the lock only guards the detaching of the waiters. */
+    if (p_eventual->is_ptr == ABT_TRUE) {
+        *(void * volatile *)&p_eventual->value = value;
+        ABTD_atomic_mem_barrier();
+        ABTI_spinlock_acquire(&p_eventual->lock);
+    } else {
+        ABTI_spinlock_acquire(&p_eventual->lock);
+        if (p_eventual->value) memcpy(p_eventual->value, value, nbytes);
+        ABTD_atomic_mem_barrier();
+    }
+    p_eventual->ready = ABT_TRUE;
+
+    /* Continuations are invoked after the lock is released. */
+    ABTI_cont *p_conts = p_eventual->p_cont_head;
+    p_eventual->p_cont_head = NULL;
+    p_eventual->p_cont_tail = NULL;
+
+    /* Detach all the waiters at once.  Waiters that come later find the
+     * list closed and return without blocking. */
+    p_waiters = (ABTI_unit *)ABTD_atomic_exchange_uint64(
+        (uint64_t *)&p_eventual->p_head, (uint64_t)ABTI_EVENTUAL_CLOSED);
+
+    ABTI_eventual_signal_timed(p_eventual->p_timed_head);
+    p_eventual->p_timed_head = NULL;
+
+    ABTI_spinlock_release(&p_eventual->lock);
+
+    /* With the handoff policy, one waiter in the pool of the caller is
+     * switched to directly after the others are woken up. */
+    if (ABTI_global_get_handoff() == ABT_TRUE) {
+        p_target = ABTI_eventual_pick_handoff(&p_waiters);
+    }
+
+    /* Wake up all waiting ULTs */
+    ABTI_eventual_wake_waiters(p_waiters);
+    ABTI_cont_invoke_list(p_conts);
+
+    if (p_target && ABTI_thread_handoff(p_target) == ABT_FALSE) {
+        ABTI_thread_set_ready(p_target);
+    }
+}
+
 /**
  * @ingroup EVENTUAL
  * @brief   Signal the eventual.
@@ -180,6 +355,12 @@ int ABT_eventual_wait(ABT_eventual eventual, void **value)
  * on the eventual. Therefore, all ULTs waiting on this eventual will be ready
  * to be scheduled.
  *
+ * If the environment variable \c ABT_HANDOFF is set, a ULT calling this
+ * routine switches directly to one of the waiting ULTs that belong to the same
+ * pool as the caller, and the caller goes back to its pool.  This saves a
+ * round trip through the scheduler, e.g., in pipelines of ULTs.  Only pools
+ * that are consumed by a single ES are eligible.
+ *
  * @param[in] eventual  handle to the eventual
  * @param[in] value     pointer to the memory buffer containing the data that
  *                      will be copied to the memory buffer of the eventual
@@ -192,49 +373,79 @@ int ABT_eventual_set(ABT_eventual eventual, void *value, int nbytes)
     int abt_errno = ABT_SUCCESS;
     ABTI_eventual *p_eventual = ABTI_eventual_get_ptr(eventual);
     ABTI_CHECK_NULL_EVENTUAL_PTR(p_eventual);
-    ABTI_CHECK_TRUE(nbytes <= p_eventual->nbytes, ABT_ERR_INV_EVENTUAL);
+    ABTI_CHECK_TRUE(p_eventual->is_ptr == ABT_TRUE ||
+                    nbytes <= p_eventual->nbytes, ABT_ERR_INV_EVENTUAL);
 
-    ABTI_spinlock_acquire(&p_eventual->lock);
-
-    p_eventual->ready = ABT_TRUE;
-    if (p_eventual->value) memcpy(p_eventual->value, value, nbytes);
+    ABTI_eventual_set(p_eventual, value, nbytes);
 
-    if (p_eventual->p_head == NULL) {
-        ABTI_spinlock_release(&p_eventual->lock);
-        goto fn_exit;
-    }
+  fn_exit:
+    return abt_errno;
 
-    /* Wake up all waiting ULTs */
-    ABTI_unit *p_head = p_eventual->p_head;
-    ABTI_unit *p_unit = p_head;
-    while (1) {
-        ABTI_unit *p_next = p_unit->p_next;
-        ABT_unit_type type = p_unit->type;
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
 
-        p_unit->p_next = NULL;
+/**
+ * @ingroup EVENTUAL
+ * @brief   Signal the eventual without error checking.
+ *
+ * \c ABT_eventual_set_unchecked() is the same as \c ABT_eventual_set() except
+ * that it checks neither \c eventual nor \c nbytes, which must not be larger
+ * than the size of the eventual.
+ *
+ * @param[in] eventual  handle to the eventual
+ * @param[in] value     pointer to the memory buffer containing the data that
+ *                      will be copied to the memory buffer of the eventual
+ * @param[in] nbytes    number of bytes to be copied
+ */
+void ABT_eventual_set_unchecked(ABT_eventual eventual, void *value, int nbytes)
+{
+    ABTI_eventual_set((ABTI_eventual *)eventual, value, nbytes);
+}
 
-        if (type == ABT_UNIT_TYPE_THREAD) {
-            ABTI_thread *p_thread = ABTI_thread_get_ptr(p_unit->thread);
-            ABTI_thread_set_ready(p_thread);
-        } else {
-            /* When the head is an external thread */
-            volatile int *p_ext_signal = (volatile int *)p_unit->pool;
-            *p_ext_signal = 1;
-        }
+/**
+ * @ingroup EVENTUAL
+ * @brief   Register a continuation to be invoked when the eventual is ready.
+ *
+ * \c ABT_eventual_then() registers \c cb_func, which is invoked with \c arg
+ * once when \c eventual becomes ready, instead of blocking a ULT until then.
+ * If \c pool is \c ABT_POOL_NULL, \c cb_func is called inline by the caller
+ * of \c ABT_eventual_set().  Otherwise, a tasklet that executes \c cb_func is
+ * pushed into \c pool; if the tasklet cannot be created, \c cb_func is called
+ * inline.  If \c eventual is already ready, \c cb_func is invoked in the same
+ * way by this routine.  Continuations that have not been invoked are
+ * discarded when \c eventual is freed.
+ *
+ * @param[in] eventual  handle to the eventual
+ * @param[in] cb_func   continuation function
+ * @param[in] arg       argument for \c cb_func
+ * @param[in] pool      pool for the continuation tasklet, or \c ABT_POOL_NULL
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_eventual_then(ABT_eventual eventual, void (*cb_func)(void *),
+                      void *arg, ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_eventual *p_eventual = ABTI_eventual_get_ptr(eventual);
+    ABTI_CHECK_NULL_EVENTUAL_PTR(p_eventual);
 
-        /* Next ULT */
-        if (p_next != NULL) {
-            p_unit = p_next;
+    ABTI_spinlock_acquire(&p_eventual->lock);
+    if (p_eventual->ready == ABT_FALSE) {
+        ABTI_cont *p_cont = ABTI_cont_create(cb_func, arg, pool);
+        if (p_eventual->p_cont_head == NULL) {
+            p_eventual->p_cont_head = p_cont;
         } else {
-            break;
+            p_eventual->p_cont_tail->p_next = p_cont;
         }
+        p_eventual->p_cont_tail = p_cont;
+        ABTI_spinlock_release(&p_eventual->lock);
+    } else {
+        ABTI_spinlock_release(&p_eventual->lock);
+        ABTI_cont_invoke(cb_func, arg, pool);
     }
 
-    p_eventual->p_head = NULL;
-    p_eventual->p_tail = NULL;
-
-    ABTI_spinlock_release(&p_eventual->lock);
-
   fn_exit:
     return abt_errno;
 
@@ -263,6 +474,9 @@ int ABT_eventual_reset(ABT_eventual eventual)
 
     ABTI_spinlock_acquire(&p_eventual->lock);
     p_eventual->ready = ABT_FALSE;
+    /* Reopen the waiter list */
+    ABTD_atomic_cas_uint64((uint64_t *)&p_eventual->p_head,
+                           (uint64_t)ABTI_EVENTUAL_CLOSED, (uint64_t)NULL);
     ABTI_spinlock_release(&p_eventual->lock);
 
   fn_exit:
@@ -273,3 +487,119 @@ int ABT_eventual_reset(ABT_eventual eventual)
     goto fn_exit;
 }
 
+/* Called by ABT_thread_cancel() to remove p_thread waiting in
+ * ABT_eventual_wait().  Waiters are only pushed at the head without the lock,
+ * while the set detaches all of them with the lock held, so an inner waiter
+ * can be unlinked safely with the lock. */
+ABT_bool ABTI_eventual_unlink_waiter(void *p_obj, ABTI_thread *p_thread)
+{
+    ABTI_eventual *p_eventual = (ABTI_eventual *)p_obj;
+    ABTI_unit *p_target = &p_thread->unit_def;
+    ABTI_unit *p_head, *p_unit;
+    ABT_bool found = ABT_FALSE;
+
+    ABTI_spinlock_acquire(&p_eventual->lock);
+    while (1) {
+        p_head = *(ABTI_unit * volatile *)&p_eventual->p_head;
+        if (p_head == ABTI_EVENTUAL_CLOSED || p_head == NULL) break;
+        if (p_head == p_target) {
+            /* A new waiter may have been pushed in the meantime. */
+            if (ABTD_atomic_cas_uint64((uint64_t *)&p_eventual->p_head,
+                                       (uint64_t)p_head,
+                                       (uint64_t)p_target->p_next)
+                == (uint64_t)p_head) {
+                found = ABT_TRUE;
+                break;
+            }
+            continue;
+        }
+        for (p_unit = p_head; p_unit->p_next; p_unit = p_unit->p_next) {
+            if (p_unit->p_next == p_target) {
+                p_unit->p_next = p_target->p_next;
+                found = ABT_TRUE;
+                break;
+            }
+        }
+        break;
+    }
+    ABTI_spinlock_release(&p_eventual->lock);
+    if (found == ABT_TRUE) p_target->p_next = NULL;
+    return found;
+}
+
+/* An eventual takes ABT_eventual_memory, and the rest of it, which holds at
+ * least 64 bytes, is used as the buffer if the buffer fits there. */
+#define ABTI_EVENTUAL_INLINE_SIZE \
+    (sizeof(ABT_eventual_memory) - sizeof(ABTI_eventual))
+typedef char ABTI_eventual_memory_check
+    [(sizeof(ABT_eventual_memory) >= sizeof(ABTI_eventual) + 64) ? 1 : -1];
+
+static ABTI_eventual *ABTI_eventual_alloc(void)
+{
+    ABTI_local *p_local = lp_ABTI_local;
+    ABTI_eventual *p_eventual;
+
+    /* Cached eventuals are linked through value. */
+    if (p_local != NULL && p_local->p_eventuals != NULL) {
+        p_eventual = p_local->p_eventuals;
+        p_local->p_eventuals = (ABTI_eventual *)p_eventual->value;
+        p_local->num_eventuals--;
+        return p_eventual;
+    }
+    return (ABTI_eventual *)
+        ABTU_malloc_cache_aligned(sizeof(ABT_eventual_memory));
+}
+
+static void ABTI_eventual_init(ABTI_eventual *p_eventual, int nbytes,
+                               ABT_bool is_user_mem)
+{
+    ABTI_spinlock_create(&p_eventual->lock);
+    p_eventual->ready = ABT_FALSE;
+    p_eventual->is_ptr = ABT_FALSE;
+    p_eventual->is_user_mem = is_user_mem;
+    p_eventual->nbytes = nbytes;
+    if (nbytes == 0) {
+        p_eventual->value = NULL;
+    } else if ((size_t)nbytes <= ABTI_EVENTUAL_INLINE_SIZE) {
+        p_eventual->value = (void *)(p_eventual + 1);
+    } else {
+        p_eventual->value = ABTU_malloc(nbytes);
+    }
+    p_eventual->p_head = NULL;
+    p_eventual->p_timed_head = NULL;
+    p_eventual->p_cont_head = NULL;
+    p_eventual->p_cont_tail = NULL;
+}
+
+static void ABTI_eventual_release(ABTI_eventual *p_eventual)
+{
+    ABTI_local *p_local = lp_ABTI_local;
+
+    if (p_eventual->is_ptr == ABT_FALSE && p_eventual->value &&
+        p_eventual->value != (void *)(p_eventual + 1)) {
+        ABTU_free(p_eventual->value);
+    }
+    if (p_eventual->is_user_mem == ABT_TRUE) return;
+
+    if (p_local != NULL && p_local->num_eventuals < ABTI_SYNC_MAX_CACHE) {
+        /* Keep it for the next ABT_eventual_create() on this ES. */
+        p_eventual->value = (void *)p_local->p_eventuals;
+        p_local->p_eventuals = p_eventual;
+        p_local->num_eventuals++;
+        return;
+    }
+    ABTU_free(p_eventual);
+}
+
+/* Release the eventuals cached by the ES of p_local. */
+void ABTI_eventual_free_cached(ABTI_local *p_local)
+{
+    ABTI_eventual *p_eventual;
+
+    while (p_local->p_eventuals != NULL) {
+        p_eventual = p_local->p_eventuals;
+        p_local->p_eventuals = (ABTI_eventual *)p_eventual->value;
+        ABTU_free(p_eventual);
+    }
+    p_local->num_eventuals = 0;
+}
@@ -5,6 +5,11 @@
 
 #include "abti.h"
 
+static ABTI_future *ABTI_future_alloc(void);
+static void ABTI_future_init(ABTI_future *p_future, uint32_t compartments,
+                             void (*cb_func)(void **arg),
+                             ABT_bool is_user_mem);
+static void ABTI_future_release(ABTI_future *p_future);
 
 /** @defgroup FUTURE Future
  * A future, an eventual, or a \a promise, is a mechanism for passing a value
@@ -47,6 +52,10 @@
  * is initially empty. The entries in the list are set with the same order as
  * the \c ABT_future_set are terminated.
  *
+ * Each ES keeps futures freed on it for the following creations, and a small
+ * array is placed in the same memory as the future, so creating a future
+ * usually does not call \c malloc().
+ *
  * @param[in]  compartments number of compartments in the future
  * @param[in]  cb_func      callback function to be called once the future
  *                          is ready
@@ -60,15 +69,40 @@ int ABT_future_create(uint32_t compartments, void (*cb_func)(void **arg),
     int abt_errno = ABT_SUCCESS;
     ABTI_future *p_future;
 
-    p_future = (ABTI_future *)ABTU_malloc(sizeof(ABTI_future));
-    ABTI_spinlock_create(&p_future->lock);
-    p_future->ready = ABT_FALSE;
-    p_future->counter = 0;
-    p_future->compartments = compartments;
-    p_future->array = ABTU_malloc(compartments * sizeof(void *));
-    p_future->p_callback = cb_func;
-    p_future->p_head = NULL;
-    p_future->p_tail = NULL;
+    p_future = ABTI_future_alloc();
+    ABTI_future_init(p_future, compartments, cb_func, ABT_FALSE);
+
+    *newfuture = ABTI_future_get_handle(p_future);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup FUTURE
+ * @brief   Create a future in the given memory.
+ *
+ * \c ABT_future_init() is the same as \c ABT_future_create() except that the
+ * future is placed in \c memory provided by the caller, e.g., on its stack or
+ * in a request structure.  If \c compartments is not larger than 4, the array
+ * of compartments is placed in \c memory, too.  The future has to be freed by
+ * \c ABT_future_free(), which does not release \c memory, before \c memory is
+ * reused.
+ *
+ * @param[in]  memory       memory for the future
+ * @param[in]  compartments number of compartments in the future
+ * @param[in]  cb_func      callback function to be called once the future
+ *                          is ready
+ * @param[out] newfuture    handle to a new future
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_future_init(ABT_future_memory *memory, uint32_t compartments,
+                    void (*cb_func)(void **arg), ABT_future *newfuture)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_future *p_future = (ABTI_future *)memory;
+
+    ABTI_future_init(p_future, compartments, cb_func, ABT_TRUE);
 
     *newfuture = ABTI_future_get_handle(p_future);
 
@@ -81,7 +115,8 @@ int ABT_future_create(uint32_t compartments, void (*cb_func)(void **arg),
  *
  * \c ABT_future_free releases memory associated with the future \c future.
  * It also deallocates the array of compartments of the future. If it is
- * successfully processed, \c future is set to \c ABT_FUTURE_NULL.
+ * successfully processed, \c future is set to \c ABT_FUTURE_NULL.  The memory
+ * of a future created by \c ABT_future_init() is not released.
  *
  * @param[in,out] future  handle to the future
  * @return Error code
@@ -99,8 +134,8 @@ int ABT_future_free(ABT_future *future)
     ABTI_spinlock_acquire(&p_future->lock);
 
     ABTI_spinlock_free(&p_future->lock);
-    ABTU_free(p_future->array);
-    ABTU_free(p_future);
+    ABTI_cont_free_list(p_future->p_cont_head);
+    ABTI_future_release(p_future);
 
     *future = ABT_FUTURE_NULL;
 
@@ -138,7 +173,7 @@ int ABT_future_wait(ABT_future future)
         ABTI_thread *p_current;
         ABTI_unit *p_unit;
         ABT_unit_type type;
-        volatile int ext_signal = 0;
+        uint32_t ext_signal = ABTD_FUTEX_SIGNAL_INIT;
 
         if (lp_ABTI_local != NULL) {
             p_current = ABTI_local_get_thread();
@@ -176,10 +211,8 @@ int ABT_future_wait(ABT_future future)
         } else {
             ABTI_spinlock_release(&p_future->lock);
 
-            /* External thread is waiting here polling ext_signal. */
-            /* FIXME: need a better implementation */
-            while (!ext_signal) {
-            }
+            /* External thread is waiting here for ext_signal. */
+            ABTD_futex_signal_wait(&ext_signal);
             ABTU_free(p_unit);
         }
     } else {
@@ -194,6 +227,79 @@ int ABT_future_wait(ABT_future future)
     goto fn_exit;
 }
 
+/**
+ * @ingroup FUTURE
+ * @brief   Wait on the future with a timeout.
+ *
+ * \c ABT_future_timedwait() works like \c ABT_future_wait() but returns
+ * \c ABT_ERR_TIMEDOUT if the future \c future is not ready before the
+ * absolute time \c abstime.  A waiting ULT is woken up by the scheduler of
+ * its ES once the deadline passes, so it may return somewhat later than
+ * \c abstime.
+ *
+ * @param[in] future   handle to the future
+ * @param[in] abstime  absolute time for timeout
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_TIMEDOUT the deadline has passed
+ */
+int ABT_future_timedwait(ABT_future future, const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_future *p_future = ABTI_future_get_ptr(future);
+    ABTI_CHECK_NULL_FUTURE_PTR(p_future);
+    ABTI_CHECK_TRUE(lp_ABTI_local == NULL || ABTI_local_get_thread() != NULL,
+                    ABT_ERR_FUTURE);
+
+    ABTI_spinlock_acquire(&p_future->lock);
+    if (p_future->ready == ABT_FALSE) {
+        ABTI_timeout timeout;
+        ABTI_unit unit;
+
+        ABTI_timeout_prepare(&timeout, ABTI_timeout_convert(abstime));
+        unit.pool = (ABT_pool)&timeout;
+        unit.type = ABTI_UNIT_TYPE_TIMED;
+        unit.p_next = NULL;
+        if (p_future->p_head == NULL) {
+            p_future->p_head = &unit;
+        } else {
+            p_future->p_tail->p_next = &unit;
+        }
+        p_future->p_tail = &unit;
+        ABTI_spinlock_release(&p_future->lock);
+
+        if (ABTI_timeout_wait(&timeout) == ABT_FALSE) {
+            /* Leave the list unless the future has been made ready and the
+             * list has been detached in the meantime. */
+            ABTI_unit *p_prev = NULL, *p_unit;
+            ABTI_spinlock_acquire(&p_future->lock);
+            for (p_unit = p_future->p_head; p_unit; p_unit = p_unit->p_next) {
+                if (p_unit == &unit) break;
+                p_prev = p_unit;
+            }
+            if (p_unit) {
+                if (p_prev) {
+                    p_prev->p_next = unit.p_next;
+                } else {
+                    p_future->p_head = unit.p_next;
+                }
+                if (p_future->p_tail == &unit) p_future->p_tail = p_prev;
+            }
+            ABTI_spinlock_release(&p_future->lock);
+            if (p_unit) return ABT_ERR_TIMEDOUT;
+        }
+    } else {
+        ABTI_spinlock_release(&p_future->lock);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup FUTURE
  * @brief   Test whether the future is ready.
@@ -233,6 +339,11 @@ int ABT_future_test(ABT_future future, ABT_bool *flag)
  * routine will store the pointer passed by parameter \c value and increase
  * the internal counter.
  *
+ * Each caller reserves its own compartment with an atomic increment and stores
+ * \c value into it without taking the lock of \c future.  Only the caller
+ * that stores the last compartment acquires the lock to call the callback
+ * function and to wake up the waiters.
+ *
  * @param[in] future  handle to the future
  * @param[in] value   pointer to the memory buffer containing the data that
  *                    will be pointed by one compartment of the future
@@ -242,56 +353,113 @@ int ABT_future_test(ABT_future future, ABT_bool *flag)
 int ABT_future_set(ABT_future future, void *value)
 {
     int abt_errno = ABT_SUCCESS;
+    ABTI_cont *p_conts = NULL;
+    uint32_t slot;
     ABTI_future *p_future = ABTI_future_get_ptr(future);
     ABTI_CHECK_NULL_FUTURE_PTR(p_future);
 
+    /* Reserve a compartment and store the value without the lock */
+    slot = ABTD_atomic_fetch_add_uint32(&p_future->counter, 1);
+    ABTI_CHECK_TRUE(slot < p_future->compartments, ABT_ERR_FUTURE);
+    p_future->array[slot] = value;
+
+    /* The last one to store its value makes the future ready.  Counting the
+     * stored compartments instead of the reserved ones guarantees that all the
+     * values are visible to the callback. */
+    if (ABTD_atomic_fetch_add_uint32(&p_future->num_stored, 1) + 1
+        < p_future->compartments) {
+        goto fn_exit;
+    }
+
     ABTI_spinlock_acquire(&p_future->lock);
 
-    p_future->array[p_future->counter] = value;
-    p_future->counter++;
-    ABTI_CHECK_TRUE(p_future->counter <= p_future->compartments,
-                    ABT_ERR_FUTURE);
+    p_future->ready = ABT_TRUE;
+    if (p_future->p_callback != NULL)
+        (*p_future->p_callback)(p_future->array);
 
-    if (p_future->counter == p_future->compartments) {
-        p_future->ready = ABT_TRUE;
-        if (p_future->p_callback != NULL)
-            (*p_future->p_callback)(p_future->array);
+    /* Continuations are invoked after the lock is released. */
+    p_conts = p_future->p_cont_head;
+    p_future->p_cont_head = NULL;
+    p_future->p_cont_tail = NULL;
 
-        if (p_future->p_head == NULL) {
-            ABTI_spinlock_release(&p_future->lock);
-            goto fn_exit;
-        }
+    /* Wake up all waiting ULTs */
+    ABTI_unit *p_unit = p_future->p_head;
+    while (p_unit) {
+        ABTI_unit *p_next = p_unit->p_next;
+        ABT_unit_type type = p_unit->type;
 
-        /* Wake up all waiting ULTs */
-        ABTI_unit *p_head = p_future->p_head;
-        ABTI_unit *p_unit = p_head;
-        while (1) {
-            ABTI_unit *p_next = p_unit->p_next;
-            ABT_unit_type type = p_unit->type;
-
-            p_unit->p_next = NULL;
-
-            if (type == ABT_UNIT_TYPE_THREAD) {
-                ABTI_thread *p_thread = ABTI_thread_get_ptr(p_unit->thread);
-                ABTI_thread_set_ready(p_thread);
-            } else {
-                /* When the head is an external thread */
-                volatile int *p_ext_signal = (volatile int *)p_unit->pool;
-                *p_ext_signal = 1;
-            }
+        p_unit->p_next = NULL;
 
-            /* Next ULT */
-            if (p_next != NULL) {
-                p_unit = p_next;
-            } else {
-                break;
-            }
+        if (type == ABT_UNIT_TYPE_THREAD) {
+            ABTI_thread *p_thread = ABTI_thread_get_ptr(p_unit->thread);
+            ABTI_thread_set_ready(p_thread);
+        } else if (type == ABTI_UNIT_TYPE_TIMED) {
+            ABTI_timeout_signal((ABTI_timeout *)p_unit->pool);
+        } else {
+            /* When the head is an external thread */
+            ABTD_futex_signal_set((uint32_t *)p_unit->pool);
         }
-        p_future->p_head = NULL;
-        p_future->p_tail = NULL;
+
+        /* Next ULT */
+        p_unit = p_next;
     }
+    p_future->p_head = NULL;
+    p_future->p_tail = NULL;
 
     ABTI_spinlock_release(&p_future->lock);
+    ABTI_cont_invoke_list(p_conts);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup FUTURE
+ * @brief   Register a continuation to be invoked when the future is ready.
+ *
+ * \c ABT_future_then() registers \c cb_func, which is invoked with \c arg
+ * once when all the compartments of \c future have been set, instead of
+ * blocking a ULT until then.  The continuation is invoked after the callback
+ * given to \c ABT_future_create().  If \c pool is \c ABT_POOL_NULL,
+ * \c cb_func is called inline by the caller of \c ABT_future_set() that
+ * makes \c future ready.  Otherwise, a tasklet that executes \c cb_func is
+ * pushed into \c pool; if the tasklet cannot be created, \c cb_func is called
+ * inline.  If \c future is already ready, \c cb_func is invoked in the same
+ * way by this routine.  Continuations that have not been invoked are
+ * discarded when \c future is freed.
+ *
+ * @param[in] future   handle to the future
+ * @param[in] cb_func  continuation function
+ * @param[in] arg      argument for \c cb_func
+ * @param[in] pool     pool for the continuation tasklet, or \c ABT_POOL_NULL
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_future_then(ABT_future future, void (*cb_func)(void *), void *arg,
+                    ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_future *p_future = ABTI_future_get_ptr(future);
+    ABTI_CHECK_NULL_FUTURE_PTR(p_future);
+
+    ABTI_spinlock_acquire(&p_future->lock);
+    if (p_future->ready == ABT_FALSE) {
+        ABTI_cont *p_cont = ABTI_cont_create(cb_func, arg, pool);
+        if (p_future->p_cont_head == NULL) {
+            p_future->p_cont_head = p_cont;
+        } else {
+            p_future->p_cont_tail->p_next = p_cont;
+        }
+        p_future->p_cont_tail = p_cont;
+        ABTI_spinlock_release(&p_future->lock);
+    } else {
+        ABTI_spinlock_release(&p_future->lock);
+        ABTI_cont_invoke(cb_func, arg, pool);
+    }
 
   fn_exit:
     return abt_errno;
@@ -307,7 +475,7 @@ int ABT_future_set(ABT_future future, void *value)
  *
  * \c ABT_future_reset() resets the readiness of the target future \c future so
  * that it can be reused.  That is, it makes \c future unready irrespective of
- * its readiness.
+ * its readiness, and all of its compartments can be set again.
  *
  * @param[in] future  handle to the target future
  * @return Error code
@@ -321,6 +489,8 @@ int ABT_future_reset(ABT_future future)
 
     ABTI_spinlock_acquire(&p_future->lock);
     p_future->ready = ABT_FALSE;
+    p_future->counter = 0;
+    p_future->num_stored = 0;
     ABTI_spinlock_release(&p_future->lock);
 
   fn_exit:
@@ -330,3 +500,80 @@ int ABT_future_reset(ABT_future future)
     HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
     goto fn_exit;
 }
+
+/* A future takes ABT_future_memory, and the rest of it, which holds at least
+ * four compartments, is used as the array if the array fits there. */
+#define ABTI_FUTURE_INLINE_COMPARTMENTS \
+    ((sizeof(ABT_future_memory) - sizeof(ABTI_future)) / sizeof(void *))
+typedef char ABTI_future_memory_check
+    [(sizeof(ABT_future_memory) >= sizeof(ABTI_future) + 4 * sizeof(void *))
+     ? 1 : -1];
+
+static ABTI_future *ABTI_future_alloc(void)
+{
+    ABTI_local *p_local = lp_ABTI_local;
+    ABTI_future *p_future;
+
+    /* Cached futures are linked through array. */
+    if (p_local != NULL && p_local->p_futures != NULL) {
+        p_future = p_local->p_futures;
+        p_local->p_futures = (ABTI_future *)p_future->array;
+        p_local->num_futures--;
+        return p_future;
+    }
+    return (ABTI_future *)ABTU_malloc_cache_aligned(sizeof(ABT_future_memory));
+}
+
+static void ABTI_future_init(ABTI_future *p_future, uint32_t compartments,
+                             void (*cb_func)(void **arg),
+                             ABT_bool is_user_mem)
+{
+    ABTI_spinlock_create(&p_future->lock);
+    p_future->ready = ABT_FALSE;
+    p_future->counter = 0;
+    p_future->num_stored = 0;
+    p_future->compartments = compartments;
+    p_future->is_user_mem = is_user_mem;
+    if (compartments <= ABTI_FUTURE_INLINE_COMPARTMENTS) {
+        p_future->array = (void **)(p_future + 1);
+    } else {
+        p_future->array = ABTU_malloc(compartments * sizeof(void *));
+    }
+    p_future->p_callback = cb_func;
+    p_future->p_head = NULL;
+    p_future->p_tail = NULL;
+    p_future->p_cont_head = NULL;
+    p_future->p_cont_tail = NULL;
+}
+
+static void ABTI_future_release(ABTI_future *p_future)
+{
+    ABTI_local *p_local = lp_ABTI_local;
+
+    if (p_future->array != (void **)(p_future + 1)) {
+        ABTU_free(p_future->array);
+    }
+    if (p_future->is_user_mem == ABT_TRUE) return;
+
+    if (p_local != NULL && p_local->num_futures < ABTI_SYNC_MAX_CACHE) {
+        /* Keep it for the next ABT_future_create() on this ES. */
+        p_future->array = (void **)p_local->p_futures;
+        p_local->p_futures = p_future;
+        p_local->num_futures++;
+        return;
+    }
+    ABTU_free(p_future);
+}
+
+/* Release the futures cached by the ES of p_local. */
+void ABTI_future_free_cached(ABTI_local *p_local)
+{
+    ABTI_future *p_future;
+
+    while (p_local->p_futures != NULL) {
+        p_future = p_local->p_futures;
+        p_local->p_futures = (ABTI_future *)p_future->array;
+        ABTU_free(p_future);
+    }
+    p_local->num_futures = 0;
+}
@@ -0,0 +1,173 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Time that an ES holding a gang member waits for the other members */
+#define ABTI_GANG_WAIT_TIME     1.0e-3
+
+/** @defgroup GANG Gang
+ * A \a gang is a group of ULTs that are dispatched all at once.  ULTs created
+ * with a ULT attribute that has a gang (see \c ABT_thread_attr_set_gang())
+ * are its members.  When an ES pops a member, it holds the member until the
+ * other members are popped by other ESs, and then all of them start to run
+ * together, so that members synchronizing with, e.g., \c ABT_barrier do not
+ * wait for members that are still in pools.  If the other members do not
+ * arrive in time, the ES pushes the member back to its pool and goes on, so a
+ * gang is dispatched as a whole or not at all, and it needs as many ESs as
+ * its members to start.  Only the first run of the members is gang-dispatched;
+ * a member that has yielded or blocked, e.g., on \c ABT_barrier, is resumed
+ * by itself, since the other members may be running or blocked.
+ */
+
+/**
+ * @ingroup GANG
+ * @brief   Create a new gang.
+ *
+ * \c ABT_gang_create() creates a new gang of \c num_members ULTs and returns
+ * its handle through \c newgang.  Exactly \c num_members ULTs have to be
+ * created with an attribute that has the gang.
+ *
+ * @param[in]  num_members  the number of members
+ * @param[out] newgang      handle to a new gang
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_INV_GANG \c num_members is zero
+ */
+int ABT_gang_create(uint32_t num_members, ABT_gang *newgang)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_gang *p_gang;
+
+    ABTI_CHECK_TRUE(num_members > 0, ABT_ERR_INV_GANG);
+
+    p_gang = (ABTI_gang *)ABTU_malloc_cache_aligned(sizeof(ABTI_gang));
+    p_gang->num_members = num_members;
+    p_gang->state = 0;
+    p_gang->num_dispatches = 0;
+    p_gang->num_backoffs = 0;
+
+    *newgang = ABTI_gang_get_handle(p_gang);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    *newgang = ABT_GANG_NULL;
+    goto fn_exit;
+}
+
+/**
+ * @ingroup GANG
+ * @brief   Free the gang.
+ *
+ * \c ABT_gang_free() releases the gang \c gang.  No member of \c gang can be
+ * in a pool or be running.  If it is successfully processed, \c gang is set to
+ * \c ABT_GANG_NULL.
+ *
+ * @param[in,out] gang  handle to the gang
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_INV_GANG a member is waiting for the others
+ */
+int ABT_gang_free(ABT_gang *gang)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_gang *p_gang = ABTI_gang_get_ptr(*gang);
+    ABTI_CHECK_NULL_GANG_PTR(p_gang);
+    ABTI_CHECK_TRUE((uint32_t)*(volatile uint64_t *)&p_gang->state == 0,
+                    ABT_ERR_INV_GANG);
+
+    LOG_EVENT("gang %p: %" PRIu64 " dispatches, %" PRIu64 " backoffs\n",
+              p_gang, p_gang->num_dispatches, p_gang->num_backoffs);
+    ABTU_free(p_gang);
+
+    *gang = ABT_GANG_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup GANG
+ * @brief   Get the number of members of the gang.
+ *
+ * @param[in]  gang         handle to the gang
+ * @param[out] num_members  the number of members
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_gang_get_num_members(ABT_gang gang, uint32_t *num_members)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_gang *p_gang = ABTI_gang_get_ptr(gang);
+    ABTI_CHECK_NULL_GANG_PTR(p_gang);
+
+    *num_members = p_gang->num_members;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+#define ABTI_GANG_ROUND(state)      ((state) >> 32)
+#define ABTI_GANG_ARRIVED(state)    ((uint32_t)(state))
+
+/* Called by an ES that has popped a member of p_gang that has not run yet.
+ * It returns ABT_TRUE when all the members have been popped, in which case the
+ * member has to run now, or ABT_FALSE if the others did not arrive in time, in
+ * which case the member has to be pushed back. */
+ABT_bool ABTI_gang_dispatch(ABTI_gang *p_gang)
+{
+    uint64_t old_state, new_state, round;
+    double start;
+
+    if (p_gang->num_members == 1) return ABT_TRUE;
+
+    /* Arrive.  The last arrival starts the next round. */
+    do {
+        old_state = *(volatile uint64_t *)&p_gang->state;
+        round = ABTI_GANG_ROUND(old_state);
+        if (ABTI_GANG_ARRIVED(old_state) + 1 >= p_gang->num_members) {
+            new_state = (round + 1) << 32;
+        } else {
+            new_state = old_state + 1;
+        }
+    } while (ABTD_atomic_cas_uint64(&p_gang->state, old_state, new_state)
+             != old_state);
+    if (ABTI_GANG_ROUND(new_state) != round) {
+        ABTD_atomic_fetch_add_uint64(&p_gang->num_dispatches, 1);
+        return ABT_TRUE;
+    }
+
+    /* Wait for the others, or leave the round if they do not come */
+    start = ABT_get_wtime();
+    while (1) {
+        old_state = *(volatile uint64_t *)&p_gang->state;
+        if (ABTI_GANG_ROUND(old_state) != round) return ABT_TRUE;
+        if (ABT_get_wtime() - start < ABTI_GANG_WAIT_TIME) {
+            ABTD_atomic_pause();
+            continue;
+        }
+        if (ABTD_atomic_cas_uint64(&p_gang->state, old_state, old_state - 1)
+            == old_state) {
+            ABTD_atomic_fetch_add_uint64(&p_gang->num_backoffs, 1);
+            return ABT_FALSE;
+        }
+    }
+}
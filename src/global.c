@@ -46,12 +46,40 @@ int ABT_init(int argc, char **argv)
     /* Initialize the system environment */
     ABTD_env_init(gp_ABTI_global);
 
+    /* Install the preemption signal handler */
+    if (gp_ABTI_global->preempt_interval_nsec > 0 &&
+        ABTD_preempt_init() != ABT_SUCCESS) {
+        gp_ABTI_global->preempt_interval_nsec = 0;
+    }
+
+    /* Install the signal handler of the sampling profiler */
+    if (gp_ABTI_global->profile_interval_nsec > 0 &&
+        ABTD_profile_init() != ABT_SUCCESS) {
+        gp_ABTI_global->profile_interval_nsec = 0;
+    }
+
     /* Initialize memory pool */
     ABTI_mem_init(gp_ABTI_global);
 
     /* Initialize the event environment */
     ABTI_event_init();
 
+    /* Start event tracing */
+    ABTI_trace_init();
+
+    /* Start the sampling profiler */
+    ABTI_profile_init();
+
+    /* Start recording or replaying the schedules */
+    ABTI_record_init();
+
+    /* Start measuring the stack usage */
+    ABTI_stack_usage_init();
+    ABTI_cpu_time_init();
+
+    /* Start the first RCU epoch */
+    ABTI_rcu_init();
+
     /* Initialize rank and IDs. */
     ABTI_xstream_reset_rank();
     ABTI_thread_reset_id();
@@ -63,10 +91,28 @@ int ABT_init(int argc, char **argv)
     gp_ABTI_global->p_xstreams = (ABTI_xstream **)ABTU_calloc(
             gp_ABTI_global->max_xstreams, sizeof(ABTI_xstream *));
     gp_ABTI_global->num_xstreams = 0;
+    gp_ABTI_global->p_old_xstreams = NULL;
 
     /* Create a spinlock */
     ABTI_spinlock_create(&gp_ABTI_global->lock);
 
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    gp_ABTI_global->park_seq = 0;
+    gp_ABTI_global->num_parked = 0;
+    gp_ABTI_global->parked_mask = 0;
+    gp_ABTI_global->p_doorbells = (ABTI_doorbell *)ABTU_malloc_cache_aligned(
+            sizeof(ABTI_doorbell) * ABTI_SCHED_NUM_DOORBELLS);
+    memset(gp_ABTI_global->p_doorbells, 0,
+           sizeof(ABTI_doorbell) * ABTI_SCHED_NUM_DOORBELLS);
+#endif
+    gp_ABTI_global->num_parked_xstreams = 0;
+    gp_ABTI_global->p_parked_xstreams = NULL;
+    gp_ABTI_global->num_ext_joiners = 0;
+    gp_ABTI_global->ext_join_seq = 0;
+    gp_ABTI_global->core_class_gen = 0;
+    ABTI_offload_init(&gp_ABTI_global->offload);
+    ABTI_completion_init();
+
     /* Init the ES local data */
     abt_errno = ABTI_local_init();
     ABTI_CHECK_ERROR_MSG(abt_errno, "ABTI_local_init");
@@ -141,6 +187,11 @@ int ABT_finalize(void)
                         ABT_ERR_INV_THREAD,
                         "ABT_finalize must be called by the primary ULT.");
 
+    /* Batched tasklets are executed before the scheduler finishes. */
+    if (lp_ABTI_local->p_task_batch) {
+        ABTI_task_flush_batch(lp_ABTI_local);
+    }
+
     /* Set the join request */
     ABTI_xstream_set_request(p_xstream, ABTI_XSTREAM_REQ_JOIN);
 
@@ -162,6 +213,21 @@ int ABT_finalize(void)
                   ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
     }
 
+    /* Stop the helpers after the blocking calls left have returned */
+    ABTI_offload_finalize(&gp_ABTI_global->offload);
+    ABTI_completion_finalize();
+
+    /* Stop preemption and profiling before the primary ES is freed */
+    ABTI_xstream_stop_preempt(p_xstream);
+    ABTI_xstream_stop_os_priority(p_xstream);
+    if (gp_ABTI_global->preempt_interval_nsec > 0) {
+        ABTD_preempt_finalize();
+    }
+    ABTI_profile_stop(p_xstream);
+    if (gp_ABTI_global->profile_interval_nsec > 0) {
+        ABTD_profile_finalize();
+    }
+
     /* Remove the primary ES from the global ES array */
     gp_ABTI_global->p_xstreams[p_xstream->rank] = NULL;
     gp_ABTI_global->num_xstreams--;
@@ -180,12 +246,45 @@ int ABT_finalize(void)
     /* Finalize the event environment */
     ABTI_event_finalize();
 
-    /* Free the ES array */
+    /* Terminate the OS threads kept for secondary ESs */
+    ABTI_xstream_free_parked();
+
+    /* Dump the event traces of all ESs */
+    ABTI_trace_finalize();
+
+    /* Dump the profiles of all ESs */
+    ABTI_profile_finalize();
+
+    /* Write the schedules of all ESs */
+    ABTI_record_finalize();
+
+    /* Free the stack usage and the CPU time per function */
+    ABTI_stack_usage_finalize();
+    ABTI_cpu_time_finalize();
+
+    /* Call the RCU callbacks left by the ESs */
+    ABTI_rcu_finalize();
+
+    /* Free the ES arrays */
     ABTU_free(gp_ABTI_global->p_xstreams);
+    while (gp_ABTI_global->p_old_xstreams) {
+        ABTI_xstream_table *p_table = gp_ABTI_global->p_old_xstreams;
+        gp_ABTI_global->p_old_xstreams = p_table->p_next;
+        ABTU_free(p_table->p_xstreams);
+        ABTU_free(p_table);
+    }
+
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    /* Free the doorbells of parked ESs */
+    ABTU_free(gp_ABTI_global->p_doorbells);
+#endif
 
     /* Finalize the memory pool */
     ABTI_mem_finalize(gp_ABTI_global);
 
+    /* Write the contention of internal spinlocks */
+    ABTI_lock_profile_finalize();
+
     /* Free the spinlock */
     ABTI_spinlock_free(&gp_ABTI_global->lock);
 
@@ -3,16 +3,23 @@
 # See COPYRIGHT in top-level directory.
 #
 
-include_HEADERS = include/abt.h
+include_HEADERS = include/abt.h include/abt.hpp include/abt_inline.h
+if ABT_USE_MPI
+include_HEADERS += include/abt_mpi.h
+endif
 
 noinst_HEADERS = \
 	include/abt_config.h \
 	include/abtd.h \
 	include/abtd_atomic.h \
+	include/abtd_futex.h \
+	include/abtd_htm.h \
 	include/abtd_thread.h \
 	include/abtd_ucontext.h \
 	include/abti.h \
 	include/abti_barrier.h \
+	include/abti_channel.h \
+	include/abti_completion.h \
 	include/abti_cond.h \
 	include/abti_config.h \
 	include/abti_error.h \
@@ -20,23 +27,39 @@ noinst_HEADERS = \
 	include/abti_eventual.h \
 	include/abti_future.h \
 	include/abti_global.h \
+	include/abti_io.h \
+	include/abti_join_counter.h \
+	include/abti_rcu.h \
 	include/abti_key.h \
 	include/abti_local.h \
 	include/abti_log.h \
+	include/abti_mcs_lock.h \
 	include/abti_mem.h \
+	include/abti_mpi.h \
 	include/abti_mutex.h \
 	include/abti_mutex_attr.h \
 	include/abti_rwlock.h \
 	include/abti_pool.h \
+	include/abti_pool_group.h \
+	include/abti_pool_stats.h \
+	include/abti_record.h \
 	include/abti_sched.h \
 	include/abti_self.h \
+	include/abti_sem.h \
+	include/abti_gang.h \
+	include/abti_delayed.h \
 	include/abti_spinlock.h \
 	include/abti_stream.h \
 	include/abti_task.h \
+	include/abti_task_graph.h \
+	include/abti_timeout.h \
 	include/abti_timer.h \
 	include/abti_thread.h \
 	include/abti_thread_attr.h \
 	include/abti_thread_htable.h \
+	include/abti_unit.h \
+	include/abti_unit_stats.h \
 	include/abti_valgrind.h \
+	include/abti_wait_group.h \
 	include/abtu.h
 
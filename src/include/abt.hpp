@@ -0,0 +1,568 @@
+/* -*- Mode: C++; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABT_HPP_INCLUDED
+#define ABT_HPP_INCLUDED
+
+/* Header-only C++11 wrapper of Argobots.
+ *
+ * The classes own Argobots objects and release them in their destructors.
+ * They can be moved but not copied.  Errors are reported by throwing
+ * abt::error.
+ *
+ * A callable given to abt::thread::create() is constructed on the stack of
+ * the new ULT with ABT_thread_create_with_data(), so spawning a ULT does not
+ * allocate memory besides the ULT itself.  It has to be aligned to at most 16
+ * bytes, and an exception thrown by it terminates the program.
+ *
+ * With a C++20 compiler, eventuals and futures can also be awaited by
+ * abt::coroutine, whose frames are resumed by tasklets instead of ULTs; see
+ * the bottom of this file. */
+
+#include <abt.h>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define ABT_HPP_HAVE_COROUTINE 1
+#include <coroutine>
+#include <exception>
+#endif
+#endif
+
+namespace abt {
+
+class error : public std::runtime_error {
+  public:
+    explicit error(int code)
+        : std::runtime_error(message(code)), m_code(code) {}
+    int code() const noexcept { return m_code; }
+
+  private:
+    static std::string message(int code) {
+        char str[128];
+        size_t len = 0;
+        if (ABT_error_get_str(code, NULL, &len) == ABT_SUCCESS &&
+            len < sizeof(str) &&
+            ABT_error_get_str(code, str, NULL) == ABT_SUCCESS) {
+            return std::string(str);
+        }
+        return "Argobots error " + std::to_string(code);
+    }
+    int m_code;
+};
+
+namespace detail {
+
+inline void check(int ret) {
+    if (ret != ABT_SUCCESS) throw error(ret);
+}
+
+/* Storage of a value that is constructed later */
+template <class T>
+class storage {
+  public:
+    storage() noexcept : m_has_value(false) {}
+    ~storage() { reset(); }
+    storage(const storage &) = delete;
+    storage &operator=(const storage &) = delete;
+
+    template <class... Args>
+    void emplace(Args &&...args) {
+        reset();
+        ::new (static_cast<void *>(&m_data)) T(std::forward<Args>(args)...);
+        m_has_value = true;
+    }
+    void reset() noexcept {
+        if (m_has_value) {
+            get().~T();
+            m_has_value = false;
+        }
+    }
+    T &get() noexcept { return *reinterpret_cast<T *>(&m_data); }
+
+  private:
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type m_data;
+    bool m_has_value;
+};
+
+struct eventual_access;
+
+} /* namespace detail */
+
+class thread {
+  public:
+    thread() noexcept : m_thread(ABT_THREAD_NULL) {}
+    thread(thread &&other) noexcept : m_thread(other.release()) {}
+    thread &operator=(thread &&other) noexcept {
+        if (this != &other) {
+            reset();
+            m_thread = other.release();
+        }
+        return *this;
+    }
+    thread(const thread &) = delete;
+    thread &operator=(const thread &) = delete;
+    /* The ULT is joined. */
+    ~thread() { reset(); }
+
+    /* Create a ULT that runs f() in pool. */
+    template <class F>
+    static thread create(ABT_pool pool, F &&f,
+                         ABT_thread_attr attr = ABT_THREAD_ATTR_NULL) {
+        ABT_thread h;
+        spawn_impl(pool, std::forward<F>(f), attr, &h);
+        return thread(h);
+    }
+
+    /* Create an unnamed ULT, which is released when f() returns. */
+    template <class F>
+    static void spawn(ABT_pool pool, F &&f,
+                      ABT_thread_attr attr = ABT_THREAD_ATTR_NULL) {
+        spawn_impl(pool, std::forward<F>(f), attr, NULL);
+    }
+
+    void join() { detail::check(ABT_thread_join(m_thread)); }
+    bool joinable() const noexcept { return m_thread != ABT_THREAD_NULL; }
+    ABT_thread native_handle() const noexcept { return m_thread; }
+    /* The caller takes the ownership of the handle. */
+    ABT_thread release() noexcept {
+        ABT_thread h = m_thread;
+        m_thread = ABT_THREAD_NULL;
+        return h;
+    }
+
+    static void yield() { detail::check(ABT_thread_yield()); }
+
+  private:
+    explicit thread(ABT_thread h) noexcept : m_thread(h) {}
+
+    void reset() noexcept {
+        if (m_thread != ABT_THREAD_NULL) ABT_thread_free(&m_thread);
+    }
+
+    template <class F>
+    static void spawn_impl(ABT_pool pool, F &&f, ABT_thread_attr attr,
+                           ABT_thread *newthread) {
+        typedef typename std::decay<F>::type fn_type;
+        typedef typename std::remove_reference<F>::type arg_type;
+        static_assert(alignof(fn_type) <= 16,
+                      "the callable must be aligned to at most 16 bytes");
+        detail::check(ABT_thread_create_with_data(
+            pool, &run<fn_type>, sizeof(fn_type), &construct<fn_type, F>,
+            const_cast<void *>(static_cast<const void *>(
+                std::addressof(static_cast<arg_type &>(f)))),
+            attr, newthread));
+    }
+
+    template <class Fn, class F>
+    static void construct(void *p_data, void *p_arg) {
+        typedef typename std::remove_reference<F>::type arg_type;
+        ::new (p_data) Fn(std::forward<F>(*static_cast<arg_type *>(p_arg)));
+    }
+
+    template <class Fn>
+    static void run(void *p_data) noexcept {
+        Fn &fn = *static_cast<Fn *>(p_data);
+        fn();
+        fn.~Fn();
+    }
+
+    ABT_thread m_thread;
+};
+
+/* Eventual that carries a value of type T.  The value is kept in the object,
+ * so T does not need to be trivially copyable. */
+template <class T = void>
+class eventual {
+  public:
+    eventual() { detail::check(ABT_eventual_create(0, &m_eventual)); }
+    eventual(eventual &&other) noexcept
+        : m_eventual(other.m_eventual), m_value(std::move(other.m_value)) {
+        other.m_eventual = ABT_EVENTUAL_NULL;
+    }
+    eventual(const eventual &) = delete;
+    eventual &operator=(const eventual &) = delete;
+    eventual &operator=(eventual &&) = delete;
+    ~eventual() {
+        if (m_eventual != ABT_EVENTUAL_NULL) ABT_eventual_free(&m_eventual);
+    }
+
+    template <class... Args>
+    void set(Args &&...args) {
+        m_value->emplace(std::forward<Args>(args)...);
+        detail::check(ABT_eventual_set(m_eventual, NULL, 0));
+    }
+    T &wait() {
+        detail::check(ABT_eventual_wait(m_eventual, NULL));
+        return m_value->get();
+    }
+    void reset() {
+        detail::check(ABT_eventual_reset(m_eventual));
+        m_value->reset();
+    }
+    ABT_eventual native_handle() const noexcept { return m_eventual; }
+
+  private:
+    friend struct detail::eventual_access;
+    ABT_eventual m_eventual;
+    /* It is separated so that moving the eventual keeps its address. */
+    std::unique_ptr<detail::storage<T>> m_value{new detail::storage<T>()};
+};
+
+template <>
+class eventual<void> {
+  public:
+    eventual() { detail::check(ABT_eventual_create(0, &m_eventual)); }
+    eventual(eventual &&other) noexcept : m_eventual(other.m_eventual) {
+        other.m_eventual = ABT_EVENTUAL_NULL;
+    }
+    eventual(const eventual &) = delete;
+    eventual &operator=(const eventual &) = delete;
+    eventual &operator=(eventual &&) = delete;
+    ~eventual() {
+        if (m_eventual != ABT_EVENTUAL_NULL) ABT_eventual_free(&m_eventual);
+    }
+
+    void set() { detail::check(ABT_eventual_set(m_eventual, NULL, 0)); }
+    void wait() { detail::check(ABT_eventual_wait(m_eventual, NULL)); }
+    void reset() { detail::check(ABT_eventual_reset(m_eventual)); }
+    ABT_eventual native_handle() const noexcept { return m_eventual; }
+
+  private:
+    ABT_eventual m_eventual;
+};
+
+/* Future with one compartment for each of Ts.  set<I>() stores the I-th value
+ * and has to be called once for each I, and wait() returns all the values
+ * once all the compartments are set. */
+template <class... Ts>
+class future {
+  public:
+    future() {
+        detail::check(ABT_future_create(sizeof...(Ts), NULL, &m_future));
+    }
+    future(future &&other) noexcept
+        : m_future(other.m_future), m_values(std::move(other.m_values)) {
+        other.m_future = ABT_FUTURE_NULL;
+    }
+    future(const future &) = delete;
+    future &operator=(const future &) = delete;
+    future &operator=(future &&) = delete;
+    ~future() {
+        if (m_future != ABT_FUTURE_NULL) ABT_future_free(&m_future);
+    }
+
+    template <std::size_t I, class U>
+    void set(U &&value) {
+        std::get<I>(*m_values) = std::forward<U>(value);
+        detail::check(ABT_future_set(m_future, NULL));
+    }
+    std::tuple<Ts...> &wait() {
+        detail::check(ABT_future_wait(m_future));
+        return *m_values;
+    }
+    ABT_future native_handle() const noexcept { return m_future; }
+
+  private:
+    ABT_future m_future;
+    std::unique_ptr<std::tuple<Ts...>> m_values{new std::tuple<Ts...>()};
+};
+
+/* Mutex that meets the Lockable requirements, e.g., for std::lock_guard */
+class mutex {
+  public:
+    mutex() { detail::check(ABT_mutex_create(&m_mutex)); }
+    mutex(mutex &&other) noexcept : m_mutex(other.m_mutex) {
+        other.m_mutex = ABT_MUTEX_NULL;
+    }
+    mutex(const mutex &) = delete;
+    mutex &operator=(const mutex &) = delete;
+    mutex &operator=(mutex &&) = delete;
+    ~mutex() {
+        if (m_mutex != ABT_MUTEX_NULL) ABT_mutex_free(&m_mutex);
+    }
+
+    void lock() { detail::check(ABT_mutex_lock(m_mutex)); }
+    void unlock() { detail::check(ABT_mutex_unlock(m_mutex)); }
+    bool try_lock() { return ABT_mutex_trylock(m_mutex) == ABT_SUCCESS; }
+    ABT_mutex native_handle() const noexcept { return m_mutex; }
+
+  private:
+    ABT_mutex m_mutex;
+};
+
+#ifdef ABT_HPP_HAVE_COROUTINE
+/* Stackless coroutines
+ *
+ * abt::coroutine<T> is a lazily started coroutine that returns T.  It is
+ * started by co_await in another coroutine or by abt::co_spawn(), which
+ * pushes a tasklet that runs it into a pool.  Whenever a coroutine is
+ * suspended, the work unit running it returns, and a new tasklet resumes it
+ * later, so a suspended coroutine holds only its frame and not a ULT stack.
+ *
+ *   co_await eventual / future   resume in the current pool once it is ready
+ *   co_await abt::yield()        resume in the current pool after the others
+ *   co_await abt::schedule_on(p) resume in pool p */
+
+template <class T = void>
+class coroutine;
+
+namespace detail {
+
+inline void resume_coroutine(void *p_frame) {
+    std::coroutine_handle<>::from_address(p_frame).resume();
+}
+
+/* Pool of the running work unit */
+inline ABT_pool self_pool() {
+    ABT_unit_type type;
+    ABT_pool pool = ABT_POOL_NULL;
+    check(ABT_self_get_type(&type));
+    if (type == ABT_UNIT_TYPE_THREAD) {
+        ABT_thread self;
+        check(ABT_thread_self(&self));
+        check(ABT_thread_get_last_pool(self, &pool));
+    } else {
+        ABT_task self;
+        check(ABT_task_self(&self));
+        check(ABT_task_get_last_pool(self, &pool));
+    }
+    return pool;
+}
+
+inline void schedule(ABT_pool pool, std::coroutine_handle<> h) {
+    check(ABT_task_create(pool, resume_coroutine, h.address(), NULL));
+}
+
+class pool_awaiter {
+  public:
+    explicit pool_awaiter(ABT_pool pool) noexcept : m_pool(pool) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        schedule(m_pool == ABT_POOL_NULL ? self_pool() : m_pool, h);
+    }
+    void await_resume() const noexcept {}
+
+  private:
+    ABT_pool m_pool;
+};
+
+template <class E>
+class eventual_awaiter {
+  public:
+    explicit eventual_awaiter(E &ev) noexcept : m_ev(ev) {}
+    bool await_ready() const noexcept { return false; }
+    /* The coroutine may be resumed before this returns, so the awaiter must
+     * not be touched after ABT_eventual_then(). */
+    void await_suspend(std::coroutine_handle<> h) {
+        check(ABT_eventual_then(m_ev.native_handle(), resume_coroutine,
+                                h.address(), self_pool()));
+    }
+    decltype(auto) await_resume() { return m_ev.wait(); }
+
+  private:
+    E &m_ev;
+};
+
+template <class F>
+class future_awaiter {
+  public:
+    explicit future_awaiter(F &f) noexcept : m_future(f) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        check(ABT_future_then(m_future.native_handle(), resume_coroutine,
+                              h.address(), self_pool()));
+    }
+    decltype(auto) await_resume() { return m_future.wait(); }
+
+  private:
+    F &m_future;
+};
+
+template <class T>
+struct promise_result {
+    storage<T> m_value;
+    template <class U>
+    void return_value(U &&value) {
+        m_value.emplace(std::forward<U>(value));
+    }
+    T take() { return std::move(m_value.get()); }
+};
+
+template <>
+struct promise_result<void> {
+    void return_void() noexcept {}
+    void take() noexcept {}
+};
+
+/* Coroutine that is started by co_spawn() and frees itself when it returns */
+struct detached {
+    struct promise_type {
+        detached get_return_object() noexcept {
+            return detached{
+                std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+} /* namespace detail */
+
+template <class T>
+class coroutine {
+  public:
+    struct promise_type : detail::promise_result<T> {
+        std::coroutine_handle<> m_cont;
+        std::exception_ptr m_exception;
+
+        coroutine get_return_object() noexcept {
+            return coroutine(handle_type::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        /* The awaiting coroutine is resumed on the same work unit. */
+        struct final_awaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                std::coroutine_handle<> cont = h.promise().m_cont;
+                return cont ? cont : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+        final_awaiter final_suspend() noexcept { return {}; }
+        void unhandled_exception() noexcept {
+            m_exception = std::current_exception();
+        }
+    };
+    typedef std::coroutine_handle<promise_type> handle_type;
+
+    coroutine(coroutine &&other) noexcept : m_handle(other.m_handle) {
+        other.m_handle = nullptr;
+    }
+    coroutine &operator=(coroutine &&other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+        return *this;
+    }
+    coroutine(const coroutine &) = delete;
+    coroutine &operator=(const coroutine &) = delete;
+    ~coroutine() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    /* Start the coroutine and resume the caller once it returns.  An
+     * exception thrown by the coroutine is rethrown here. */
+    auto operator co_await() noexcept {
+        struct awaiter {
+            handle_type m_handle;
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<> h) noexcept {
+                m_handle.promise().m_cont = h;
+                return m_handle;
+            }
+            T await_resume() {
+                if (m_handle.promise().m_exception) {
+                    std::rethrow_exception(m_handle.promise().m_exception);
+                }
+                return m_handle.promise().take();
+            }
+        };
+        return awaiter{m_handle};
+    }
+
+  private:
+    explicit coroutine(handle_type h) noexcept : m_handle(h) {}
+    handle_type m_handle;
+};
+
+namespace detail {
+
+struct eventual_access {
+    template <class T>
+    static storage<T> *value(eventual<T> &ev) noexcept {
+        return ev.m_value.get();
+    }
+};
+
+template <class T>
+detached run_spawned(coroutine<T> c, ABT_eventual ev, storage<T> *p_value) {
+    p_value->emplace(co_await std::move(c));
+    ABT_eventual_set(ev, NULL, 0);
+}
+
+inline detached run_spawned(coroutine<void> c, ABT_eventual ev) {
+    co_await std::move(c);
+    ABT_eventual_set(ev, NULL, 0);
+}
+
+} /* namespace detail */
+
+/* Run c in a tasklet in pool.  The returned eventual is set to the value of
+ * c once it returns, and it must not be freed until then.  An exception
+ * thrown by c terminates the program. */
+template <class T>
+eventual<T> co_spawn(ABT_pool pool, coroutine<T> c) {
+    eventual<T> ev;
+    detail::detached d = detail::run_spawned(
+        std::move(c), ev.native_handle(), detail::eventual_access::value(ev));
+    try {
+        detail::schedule(pool, d.m_handle);
+    } catch (...) {
+        d.m_handle.destroy();
+        throw;
+    }
+    return ev;
+}
+
+inline eventual<void> co_spawn(ABT_pool pool, coroutine<void> c) {
+    eventual<void> ev;
+    detail::detached d = detail::run_spawned(std::move(c), ev.native_handle());
+    try {
+        detail::schedule(pool, d.m_handle);
+    } catch (...) {
+        d.m_handle.destroy();
+        throw;
+    }
+    return ev;
+}
+
+inline detail::pool_awaiter yield() noexcept {
+    return detail::pool_awaiter(ABT_POOL_NULL);
+}
+
+inline detail::pool_awaiter schedule_on(ABT_pool pool) noexcept {
+    return detail::pool_awaiter(pool);
+}
+
+template <class T>
+detail::eventual_awaiter<eventual<T>> operator co_await(eventual<T> &ev) {
+    return detail::eventual_awaiter<eventual<T>>(ev);
+}
+
+template <class... Ts>
+detail::future_awaiter<future<Ts...>> operator co_await(future<Ts...> &f) {
+    return detail::future_awaiter<future<Ts...>>(f);
+}
+#endif /* ABT_HPP_HAVE_COROUTINE */
+
+} /* namespace abt */
+
+#endif /* ABT_HPP_INCLUDED */
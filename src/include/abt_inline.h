@@ -0,0 +1,87 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABT_INLINE_H_INCLUDED
+#define ABT_INLINE_H_INCLUDED
+
+/* Opt-in user include file for the hot paths of ARGOBOTS.
+ *
+ * Including this file instead of abt.h replaces ABT_thread_yield(),
+ * ABT_thread_self(), ABT_self_get_type(), ABT_pool_push(), ABT_mutex_lock(),
+ * ABT_mutex_unlock(), and ABT_eventual_set() with static inline functions that
+ * call their *_unchecked() variants directly.  The arguments are not
+ * validated, so they have to be valid and the callers have to be ULTs or
+ * tasklets, not external threads.  The other error codes are the same as the
+ * original routines.
+ *
+ * If Argobots is configured with --enable-lto, libabt.a keeps the
+ * intermediate code of the compiler, and programs that link it statically with
+ * -flto can inline the bodies of the *_unchecked() routines as well.
+ *
+ * Define ABT_INLINE_NO_RENAME before including this file to keep the original
+ * routines and use the ABT_inline_ names explicitly. */
+
+#include <abt.h>
+
+#if defined(__GNUC__)
+#define ABT_INLINE_ATTR static inline __attribute__((always_inline))
+#else
+#define ABT_INLINE_ATTR static inline
+#endif
+
+ABT_INLINE_ATTR int ABT_inline_thread_yield(void)
+{
+    ABT_thread_yield_unchecked();
+    return ABT_SUCCESS;
+}
+
+ABT_INLINE_ATTR int ABT_inline_thread_self(ABT_thread *thread)
+{
+    *thread = ABT_thread_self_unchecked();
+    return (*thread != ABT_THREAD_NULL) ? ABT_SUCCESS : ABT_ERR_INV_THREAD;
+}
+
+ABT_INLINE_ATTR int ABT_inline_self_get_type(ABT_unit_type *type)
+{
+    *type = ABT_self_get_type_unchecked();
+    return ABT_SUCCESS;
+}
+
+ABT_INLINE_ATTR int ABT_inline_pool_push(ABT_pool pool, ABT_unit unit)
+{
+    ABT_pool_push_unchecked(pool, unit);
+    return ABT_SUCCESS;
+}
+
+ABT_INLINE_ATTR int ABT_inline_mutex_lock(ABT_mutex mutex)
+{
+    ABT_mutex_lock_unchecked(mutex);
+    return ABT_SUCCESS;
+}
+
+ABT_INLINE_ATTR int ABT_inline_mutex_unlock(ABT_mutex mutex)
+{
+    ABT_mutex_unlock_unchecked(mutex);
+    return ABT_SUCCESS;
+}
+
+ABT_INLINE_ATTR int ABT_inline_eventual_set(ABT_eventual eventual, void *value,
+                                            int nbytes)
+{
+    ABT_eventual_set_unchecked(eventual, value, nbytes);
+    return ABT_SUCCESS;
+}
+
+#ifndef ABT_INLINE_NO_RENAME
+#define ABT_thread_yield    ABT_inline_thread_yield
+#define ABT_thread_self     ABT_inline_thread_self
+#define ABT_self_get_type   ABT_inline_self_get_type
+#define ABT_pool_push       ABT_inline_pool_push
+#define ABT_mutex_lock      ABT_inline_mutex_lock
+#define ABT_mutex_unlock    ABT_inline_mutex_unlock
+#define ABT_eventual_set    ABT_inline_eventual_set
+#endif
+
+#endif /* ABT_INLINE_H_INCLUDED */
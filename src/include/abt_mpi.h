@@ -0,0 +1,47 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABT_MPI_H_INCLUDED
+#define ABT_MPI_H_INCLUDED
+
+/* user include file for the MPI integration of ARGOBOTS.  It is installed
+ * only if Argobots is configured with --with-mpi. */
+
+#include <mpi.h>
+#include <abt.h>
+
+/* Keep C++ compilers from getting confused */
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Queue of remote tasklets that other processes can steal over MPI RMA */
+typedef void *ABT_mpi_steal;
+#define ABT_MPI_STEAL_NULL  ((ABT_mpi_steal)NULL)
+
+/* Remote rings into which other processes push tasklets over MPI RMA */
+typedef void *ABT_mpi_ring;
+#define ABT_MPI_RING_NULL   ((ABT_mpi_ring)NULL)
+
+int ABT_mpi_wait(MPI_Request *request, MPI_Status *status) ABT_API_PUBLIC;
+int ABT_mpi_steal_create(MPI_Comm comm, int capacity,
+                         ABT_mpi_steal *newsteal) ABT_API_PUBLIC;
+int ABT_mpi_steal_free(ABT_mpi_steal *steal) ABT_API_PUBLIC;
+int ABT_mpi_steal_push(ABT_mpi_steal steal,
+                       const ABT_remote_desc *desc) ABT_API_PUBLIC;
+int ABT_mpi_steal_get_pool(ABT_mpi_steal steal, ABT_pool *pool)
+    ABT_API_PUBLIC;
+int ABT_mpi_ring_create(MPI_Comm comm, int capacity,
+                        ABT_mpi_ring *newring) ABT_API_PUBLIC;
+int ABT_mpi_ring_free(ABT_mpi_ring *ring) ABT_API_PUBLIC;
+int ABT_mpi_ring_push(ABT_mpi_ring ring, int rank,
+                      const ABT_remote_desc *desc) ABT_API_PUBLIC;
+int ABT_mpi_ring_get_pool(ABT_mpi_ring ring, ABT_pool *pool) ABT_API_PUBLIC;
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ABT_MPI_H_INCLUDED */
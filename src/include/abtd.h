@@ -6,7 +6,9 @@
 #ifndef ABTD_H_INCLUDED
 #define ABTD_H_INCLUDED
 
+#ifndef __USE_GNU
 #define __USE_GNU
+#endif
 #include <pthread.h>
 #include "abtd_ucontext.h"
 
@@ -33,25 +35,84 @@ int ABTD_xstream_context_free(ABTD_xstream_context *p_ctx);
 int ABTD_xstream_context_join(ABTD_xstream_context ctx);
 int ABTD_xstream_context_exit(void);
 int ABTD_xstream_context_self(ABTD_xstream_context *p_ctx);
+int ABTD_xstream_context_get_tid(void);
+int ABTD_xstream_context_check_os_priority(ABT_xstream_os_policy policy,
+                                           int priority);
+int ABTD_xstream_context_set_os_priority(ABTD_xstream_context ctx, int tid,
+                                         ABT_xstream_os_policy policy,
+                                         int priority);
 
 /* ES Affinity */
 void ABTD_affinity_init(void);
+int ABTD_affinity_get_num_cpus(void);
 int ABTD_affinity_set(ABTD_xstream_context ctx, int rank);
 int ABTD_affinity_set_cpuset(ABTD_xstream_context ctx, int cpuset_size,
                              int *p_cpuset);
 int ABTD_affinity_get_cpuset(ABTD_xstream_context ctx, int cpuset_size,
                              int *p_cpuset, int *p_num_cpus);
+int ABTD_affinity_get_distance(ABTD_xstream_context ctx1,
+                               ABTD_xstream_context ctx2);
+int ABTD_affinity_get_topology_id(ABTD_xstream_context ctx, int level);
+int ABTD_affinity_get_core_class(ABTD_xstream_context ctx);
+int ABTD_affinity_init_nodes(void);
+int ABTD_affinity_get_node(void);
+int ABTD_affinity_get_num_nodes(void);
+void ABTD_affinity_bind_memory(void *p_addr, size_t len, int node);
 
 #include "abtd_stream.h"
 
+/* Preemption of ULTs by per-ES timer signals */
+#if defined(__linux__) && defined(HAVE_TIMER_CREATE) && \
+    defined(ABT_CONFIG_USE_FCONTEXT) && \
+    (defined(__x86_64__) || defined(__aarch64__))
+#define ABTD_PREEMPT_SUPPORTED
+#include <time.h>
+typedef timer_t ABTD_preempt_timer;
+#else
+typedef int ABTD_preempt_timer;
+#endif
+int  ABTD_preempt_init(void);
+void ABTD_preempt_finalize(void);
+int  ABTD_preempt_timer_create(ABTD_preempt_timer *p_timer,
+                               long interval_nsec);
+void ABTD_preempt_timer_free(ABTD_preempt_timer *p_timer);
+
+/* Sampling profiler driven by per-ES timer signals */
+#if defined(__linux__) && defined(HAVE_TIMER_CREATE)
+#define ABTD_PROFILE_SUPPORTED
+#include <time.h>
+typedef timer_t ABTD_profile_timer;
+#else
+typedef int ABTD_profile_timer;
+#endif
+int  ABTD_profile_init(void);
+void ABTD_profile_finalize(void);
+int  ABTD_profile_timer_create(ABTD_profile_timer *p_timer,
+                               long interval_nsec);
+void ABTD_profile_timer_free(ABTD_profile_timer *p_timer);
+
+/* Extended processor state (XSAVE) */
+#define ABTD_XSAVE_ALIGN    64
+void   ABTD_xsave_init(void);
+size_t ABTD_xsave_get_size(void);
+void   ABTD_xsave_save(void *p_area);
+void   ABTD_xsave_restore(void *p_area);
+
 /* ULT Context */
 #include "abtd_thread.h"
 void ABTD_thread_exit(ABTI_thread *p_thread);
 void ABTD_thread_cancel(ABTI_thread *p_thread);
+void ABTD_thread_wake_joiner(ABTI_thread *p_thread, ABTI_thread *p_joiner);
 
 /* Atomic Functions */
 #include "abtd_atomic.h"
 
+/* Futex Functions */
+#include "abtd_futex.h"
+
+/* Transactional Memory for Lock Elision */
+#include "abtd_htm.h"
+
 #if defined(HAVE_CLOCK_GETTIME)
 #include <time.h>
 typedef struct timespec ABTD_time;
@@ -70,4 +131,62 @@ void   ABTD_time_init(void);
 int    ABTD_time_get(ABTD_time *p_time);
 double ABTD_time_read_sec(ABTD_time *p_time);
 
+/* Read a monotonic cycle counter (the TSC on x86-64).  Its frequency is not
+ * known, so the caller has to calibrate it against ABTD_time. */
+static inline uint64_t ABTD_time_get_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+    uint64_t val;
+    __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (val));
+    return val;
+#else
+    ABTD_time t;
+    ABTD_time_get(&t);
+    return (uint64_t)(ABTD_time_read_sec(&t) * 1.0e9);
+#endif
+}
+
+/* Source of the ticks of ABTD_time_get_ticks(), which is chosen and
+ * calibrated on first use, so it works before ABT_init() */
+#define ABTD_TIME_TICKS_UNKNOWN     0
+#define ABTD_TIME_TICKS_CLOCK       1   /* Nanoseconds of ABTD_time */
+#define ABTD_TIME_TICKS_CYCLES      2   /* Constant-rate cycle counter */
+
+extern int g_ABTD_time_ticks_source;
+extern double g_ABTD_time_sec_per_tick;
+extern uint64_t g_ABTD_time_base_ticks;
+extern double g_ABTD_time_base_sec;
+
+int ABTD_time_init_ticks(void);
+
+static inline int ABTD_time_get_ticks_source(void)
+{
+    int source = *(volatile int *)&g_ABTD_time_ticks_source;
+    if (source == ABTD_TIME_TICKS_UNKNOWN) source = ABTD_time_init_ticks();
+    return source;
+}
+
+/* Read a monotonic tick counter: the cycle counter if its rate is constant
+ * across cores, and nanoseconds of ABTD_time otherwise. */
+static inline uint64_t ABTD_time_get_ticks(void)
+{
+    ABTD_time t;
+
+    if (ABTD_time_get_ticks_source() == ABTD_TIME_TICKS_CYCLES) {
+        return ABTD_time_get_cycles();
+    }
+    ABTD_time_get(&t);
+    return (uint64_t)(ABTD_time_read_sec(&t) * 1.0e9);
+}
+
+static inline double ABTD_time_ticks_to_sec(uint64_t ticks)
+{
+    ABTD_time_get_ticks_source();
+    return (double)ticks * g_ABTD_time_sec_per_tick;
+}
+
 #endif /* ABTD_H_INCLUDED */
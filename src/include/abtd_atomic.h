@@ -199,6 +199,12 @@ uint64_t ABTD_atomic_exchange_uint64(uint64_t *ptr, uint64_t v)
 {
     return __atomic_exchange_n(ptr, v, __ATOMIC_SEQ_CST);
 }
+
+static inline
+void *ABTD_atomic_exchange_ptr(void **ptr, void *v)
+{
+    return __atomic_exchange_n(ptr, v, __ATOMIC_SEQ_CST);
+}
 #endif
 
 static inline
@@ -213,10 +219,30 @@ void ABTD_compiler_barrier(void)
     __asm__ __volatile__ ( "" ::: "memory" );
 }
 
+/* Order the preceding stores before the following stores */
+static inline
+void ABTD_atomic_write_barrier(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    /* x86 does not reorder stores with other stores. */
+    ABTD_compiler_barrier();
+#else
+    __sync_synchronize();
+#endif
+}
+
 static inline
 void ABTD_atomic_pause(void)
 {
     __asm__ __volatile__ ( "pause" ::: "memory" );
 }
 
+/* Bring the cache line of p_addr in for writing.  It never faults, so p_addr
+ * may be stale. */
+static inline
+void ABTD_prefetch_write(const void *p_addr)
+{
+    __builtin_prefetch(p_addr, 1, 3);
+}
+
 #endif /* ABTD_ATOMIC_H_INCLUDED */
@@ -0,0 +1,96 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTD_FUTEX_H_INCLUDED
+#define ABTD_FUTEX_H_INCLUDED
+
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+
+#if defined(HAVE_LINUX_FUTEX_H) && defined(HAVE_SYS_SYSCALL_H)
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/* Block until *ptr is changed from val and woken up, or until p_timeout
+ * passes.  It may return spuriously. */
+static inline
+void ABTD_futex_wait(uint32_t *ptr, uint32_t val,
+                     const struct timespec *p_timeout)
+{
+    syscall(SYS_futex, ptr, FUTEX_WAIT_PRIVATE, val, p_timeout, NULL, 0);
+}
+
+/* Wake up all waiters blocked on ptr */
+static inline
+void ABTD_futex_wake_all(uint32_t *ptr)
+{
+    syscall(SYS_futex, ptr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+#else
+
+/* Without futex, waiting falls back to sleeping for the timeout, or for
+ * 100 us if there is no timeout. */
+static inline
+void ABTD_futex_wait(uint32_t *ptr, uint32_t val,
+                     const struct timespec *p_timeout)
+{
+    const struct timespec poll = { 0, 100000 };
+    if (*(volatile uint32_t *)ptr == val) {
+        nanosleep(p_timeout ? p_timeout : &poll, NULL);
+    }
+}
+
+static inline
+void ABTD_futex_wake_all(uint32_t *ptr)
+{
+    (void)ptr;
+}
+
+#endif
+
+/* One-shot signal on which an external thread waits for a ULT or a tasklet.
+ * The waiter spins for ABTD_FUTEX_SIGNAL_SPINS iterations and then blocks on
+ * the futex, which the signaler wakes up only if the waiter has announced
+ * that it blocks.  The signal may be on the stack of the waiter, which can
+ * return as soon as the signal is set, so the wake-up may hit a stale
+ * address; this is harmless since futex waits can return spuriously. */
+#define ABTD_FUTEX_SIGNAL_INIT      0   /* Not set, the waiter is spinning */
+#define ABTD_FUTEX_SIGNAL_SET       1   /* Set */
+#define ABTD_FUTEX_SIGNAL_BLOCKED   2   /* Not set, the waiter is blocked */
+#define ABTD_FUTEX_SIGNAL_SPINS     4096
+
+static inline
+void ABTD_futex_signal_wait(uint32_t *p_signal)
+{
+    volatile uint32_t *p_val = (volatile uint32_t *)p_signal;
+    int i;
+
+    for (i = 0; i < ABTD_FUTEX_SIGNAL_SPINS; i++) {
+        if (*p_val == ABTD_FUTEX_SIGNAL_SET) return;
+        ABTD_atomic_pause();
+    }
+    if (ABTD_atomic_cas_uint32(p_signal, ABTD_FUTEX_SIGNAL_INIT,
+                               ABTD_FUTEX_SIGNAL_BLOCKED)
+        == ABTD_FUTEX_SIGNAL_SET) {
+        return;
+    }
+    while (*p_val != ABTD_FUTEX_SIGNAL_SET) {
+        ABTD_futex_wait(p_signal, ABTD_FUTEX_SIGNAL_BLOCKED, NULL);
+    }
+}
+
+static inline
+void ABTD_futex_signal_set(uint32_t *p_signal)
+{
+    if (ABTD_atomic_exchange_uint32(p_signal, ABTD_FUTEX_SIGNAL_SET)
+        == ABTD_FUTEX_SIGNAL_BLOCKED) {
+        ABTD_futex_wake_all(p_signal);
+    }
+}
+
+#endif /* ABTD_FUTEX_H_INCLUDED */
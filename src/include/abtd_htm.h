@@ -0,0 +1,70 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTD_HTM_H_INCLUDED
+#define ABTD_HTM_H_INCLUDED
+
+/* Hardware transactional memory (Intel RTM) for lock elision.  The
+ * instructions are encoded by hand so that the library does not need to be
+ * compiled with -mrtm; they are executed only if g_ABTD_htm_available is set
+ * by ABTD_htm_init(). */
+
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+
+#define ABTD_HTM_STARTED        (~0u)       /* Returned by ABTD_htm_begin() */
+#define ABTD_HTM_ABORT_EXPLICIT (1u << 0)   /* Aborted by ABTD_htm_abort() */
+#define ABTD_HTM_ABORT_RETRY    (1u << 1)   /* May succeed on a retry */
+#define ABTD_HTM_ABORT_CODE(status) (((status) >> 24) & 0xff)
+
+extern int g_ABTD_htm_available;
+
+void ABTD_htm_init(void);
+
+static inline int ABTD_htm_is_available(void)
+{
+    return g_ABTD_htm_available;
+}
+
+/* XBEGIN whose fallback is the next instruction.  EAX keeps ABTD_HTM_STARTED
+ * in the transaction and has the abort status after an abort. */
+static inline unsigned int ABTD_htm_begin(void)
+{
+    unsigned int status = ABTD_HTM_STARTED;
+    __asm__ __volatile__ (".byte 0xc7,0xf8 ; .long 0"
+                          : "+a"(status) : : "memory");
+    return status;
+}
+
+/* XEND */
+static inline void ABTD_htm_end(void)
+{
+    __asm__ __volatile__ (".byte 0x0f,0x01,0xd5" : : : "memory");
+}
+
+/* XABORT with code 0xff, the only code used by Argobots */
+#define ABTD_HTM_ABORT_BUSY     0xff
+static inline void ABTD_htm_abort(void)
+{
+    __asm__ __volatile__ (".byte 0xc6,0xf8,0xff" : : : "memory");
+}
+
+/* XTEST: nonzero in a transaction */
+static inline int ABTD_htm_test(void)
+{
+    unsigned char in_tx;
+    __asm__ __volatile__ (".byte 0x0f,0x01,0xd6 ; setnz %0"
+                          : "=r"(in_tx) : : "memory", "cc");
+    return in_tx;
+}
+
+#else
+
+static inline void ABTD_htm_init(void)
+{
+}
+
+#endif /* ABT_CONFIG_USE_LOCK_ELISION */
+
+#endif /* ABTD_HTM_H_INCLUDED */
@@ -6,6 +6,15 @@
 #ifndef ABTD_STREAM_H_INCLUDED
 #define ABTD_STREAM_H_INCLUDED
 
+#include <sched.h>
+
+/* Give up the CPU to other OS threads */
+static inline
+void ABTD_xstream_context_yield(void)
+{
+    sched_yield();
+}
+
 #ifdef HAVE_PTHREAD_BARRIER_INIT
 static inline
 int ABTD_xstream_barrier_init(uint32_t num_waiters,
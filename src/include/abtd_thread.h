@@ -17,9 +17,37 @@ void ABTD_thread_func_wrapper(void *p_arg);
 fcontext_t make_fcontext(void *sp, size_t size, void (*thread_func)(void *))
                          ABT_API_PRIVATE;
 void *jump_fcontext(fcontext_t *old, fcontext_t new, void *arg,
-                    int preserve_fpu) ABT_API_PRIVATE;
+                    int fpu_flags) ABT_API_PRIVATE;
 void *take_fcontext(fcontext_t *old, fcontext_t new, void *arg,
-                    int preserve_fpu) ABT_API_PRIVATE;
+                    int fpu_flags) ABT_API_PRIVATE;
+
+/* Flags passed to jump_fcontext() and take_fcontext().  The FPU state of the
+ * old context is saved only if it uses the FPU, and that of the new context
+ * is restored only if it uses the FPU.  x86-64, i386, ARM64, and RISC-V 64
+ * test the two bits separately, while the other architectures save and
+ * restore the FPU state if any bit is set.  The generic implementation
+ * ignores them. */
+#define ABTD_FCONTEXT_SAVE_FPU      0x1
+#define ABTD_FCONTEXT_RESTORE_FPU   0x2
+
+static inline
+int ABTD_thread_context_get_fpu_flags(ABTD_thread_context *p_old,
+                                      ABTD_thread_context *p_new)
+{
+    int flags = 0;
+    if (p_old && p_old->preserve_fpu) flags |= ABTD_FCONTEXT_SAVE_FPU;
+    if (p_new->preserve_fpu) flags |= ABTD_FCONTEXT_RESTORE_FPU;
+#if !defined(__aarch64__)
+    /* ARM64 always preserves d8-d15 unless a ULT opts out, because the
+     * compiler may keep integer values in them. */
+    if (!ABTD_FCONTEXT_PRESERVE_FPU) return 0;
+#endif
+#if !defined(__x86_64__) && !defined(__i386__) && !defined(__aarch64__) && \
+    !(defined(__riscv) && __riscv_xlen == 64)
+    if (flags) flags = ABTD_FCONTEXT_SAVE_FPU | ABTD_FCONTEXT_RESTORE_FPU;
+#endif
+    return flags;
+}
 #else
 void ABTD_thread_func_wrapper(int func_upper, int func_lower,
                               int arg_upper, int arg_lower);
@@ -35,6 +63,14 @@ int ABTD_thread_context_create(ABTD_thread_context *p_link,
 #if defined(ABT_CONFIG_USE_FCONTEXT)
     void *p_stacktop;
 
+    /* The function and the argument are kept even without a stack so that
+     * the context can be made when a stack is bound later. */
+    p_newctx->f_thread = f_thread;
+    p_newctx->p_arg = p_arg;
+    p_newctx->p_link = p_link;
+    p_newctx->preserve_fpu = 1;
+    p_newctx->p_xsave = NULL;
+
     /* If stack is NULL, we don't need to make a new context */
     if (p_stack == NULL) goto fn_exit;
 
@@ -44,9 +80,6 @@ int ABTD_thread_context_create(ABTD_thread_context *p_link,
 
     p_newctx->fctx = make_fcontext(p_stacktop, stacksize,
                                    ABTD_thread_func_wrapper);
-    p_newctx->f_thread = f_thread;
-    p_newctx->p_arg = p_arg;
-    p_newctx->p_link = p_link;
 
   fn_exit:
     return abt_errno;
@@ -98,13 +131,44 @@ int ABTD_thread_context_create(ABTD_thread_context *p_link,
 /* Currently, nothing to do */
 #define ABTD_thread_context_free(p_ctx)
 
+/* Declare whether the context uses the FPU.  The FPU state of a context that
+ * does not use it is not saved or restored at context switches. */
+#if defined(ABT_CONFIG_USE_FCONTEXT)
+#define ABTD_thread_context_set_fpu(p_ctx,flag) \
+    ((p_ctx)->preserve_fpu = ((flag) == ABT_TRUE) ? 1 : 0)
+#else
+#define ABTD_thread_context_set_fpu(p_ctx,flag)
+#endif
+
+/* Set the XSAVE area of the context.  The whole vector state of a context with
+ * an area is saved and restored at context switches. */
+#if defined(ABT_CONFIG_USE_FCONTEXT)
+#define ABTD_thread_context_set_xsave(p_ctx,p_area) \
+    ((p_ctx)->p_xsave = (p_area))
+#define ABTD_thread_context_get_xsave(p_ctx)    ((p_ctx)->p_xsave)
+#else
+#define ABTD_thread_context_set_xsave(p_ctx,p_area)
+#define ABTD_thread_context_get_xsave(p_ctx)    NULL
+#endif
+
+/* Function of the ULT, or NULL if the context does not keep it */
+#if defined(ABT_CONFIG_USE_FCONTEXT)
+#define ABTD_thread_context_get_func(p_ctx)     ((p_ctx)->f_thread)
+#else
+#define ABTD_thread_context_get_func(p_ctx)     NULL
+#endif
+
 static inline
 void ABTD_thread_context_switch(ABTD_thread_context *p_old,
                                 ABTD_thread_context *p_new)
 {
 #if defined(ABT_CONFIG_USE_FCONTEXT)
+    /* The vector state is saved before the old context is switched out and
+     * restored when it is switched back in. */
+    if (p_old->p_xsave) ABTD_xsave_save(p_old->p_xsave);
     jump_fcontext(&p_old->fctx, p_new->fctx, p_new,
-                  ABTD_FCONTEXT_PRESERVE_FPU);
+                  ABTD_thread_context_get_fpu_flags(p_old, p_new));
+    if (p_old->p_xsave) ABTD_xsave_restore(p_old->p_xsave);
 
 #else
     int ret = swapcontext(p_old, p_new);
@@ -118,7 +182,7 @@ void ABTD_thread_finish_context(ABTD_thread_context *p_old,
 {
 #if defined(ABT_CONFIG_USE_FCONTEXT)
     take_fcontext(&p_old->fctx, p_new->fctx, p_new,
-                  ABTD_FCONTEXT_PRESERVE_FPU);
+                  ABTD_thread_context_get_fpu_flags(NULL, p_new));
 #else
     int ret = swapcontext(p_old, p_new);
     ABTI_ASSERT(ret == 0);
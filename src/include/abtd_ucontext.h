@@ -16,6 +16,8 @@ typedef struct abt_ucontext_t {
     void (*f_thread)(void *);       /* ULT function */
     void *                 p_arg;   /* ULT function argument */
     struct abt_ucontext_t *p_link;  /* pointer to scheduler context */
+    int                    preserve_fpu; /* FPU state saved at switches? */
+    void *                 p_xsave; /* XSAVE area for the vector state */
 } abt_ucontext_t;
 
 #else
@@ -8,6 +8,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <inttypes.h>
 #include <string.h>
@@ -15,6 +16,9 @@
 
 #include "abt_config.h"
 #include "abt.h"
+#ifdef ABT_CONFIG_USE_MPI
+#include "abt_mpi.h"
+#endif
 #include "abtu.h"
 #include "abti_error.h"
 #include "abti_valgrind.h"
@@ -23,10 +27,23 @@
 /* Constants */
 #define ABTI_SCHED_NUM_PRIO         3
 
+/* Place a member at the beginning of a cache line.  Objects of types that
+ * have such members have to be allocated by ABTU_malloc_cache_aligned(). */
+#define ABTI_CACHE_ALIGNED          \
+    __attribute__((aligned(ABT_CONFIG_CACHE_LINE_SIZE)))
+
 #define ABTI_XSTREAM_REQ_JOIN       (1 << 0)
 #define ABTI_XSTREAM_REQ_EXIT       (1 << 1)
 #define ABTI_XSTREAM_REQ_CANCEL     (1 << 2)
 #define ABTI_XSTREAM_REQ_STOP       (1 << 3)
+#define ABTI_XSTREAM_REQ_MIGRATE    (1 << 4)
+#define ABTI_XSTREAM_REQ_SWAP       (1 << 5)
+
+/* p_run_next of an ES whose main scheduler is not running */
+#define ABTI_XSTREAM_RUN_NEXT_CLOSED    ((ABTI_thread *)1)
+
+/* ESs of smaller ranks than this park on their own doorbells */
+#define ABTI_SCHED_NUM_DOORBELLS    64
 
 #define ABTI_SCHED_REQ_FINISH       (1 << 0)
 #define ABTI_SCHED_REQ_EXIT         (1 << 1)
@@ -48,12 +65,82 @@
      ABTI_THREAD_REQ_NOPUSH)
 
 #define ABTI_TASK_REQ_CANCEL        (1 << 0)
+#define ABTI_TASK_REQ_RESUME        (1 << 1)
+
+/* Dependency that a resumable tasklet waits for */
+#define ABTI_TASK_AWAIT_NONE        0
+#define ABTI_TASK_AWAIT_EVENTUAL    1
+#define ABTI_TASK_AWAIT_FUTURE      2
+
+/* Handle states of ULTs and tasklets.  The ES that terminates a unit and the
+ * caller of ABT_thread_detach() or ABT_task_detach() race to move the state
+ * from ABTI_DETACH_NONE, and the loser frees the unit. */
+#define ABTI_DETACH_NONE            0
+#define ABTI_DETACH_DETACHED        1
+#define ABTI_DETACH_ENDED           2
 
 #define ABTI_THREAD_INIT_ID         0xFFFFFFFFFFFFFFFF
+#define ABTI_THREAD_MAX_REUSE       64
+#define ABTI_KTABLE_MAX_CACHE       64
+#define ABTI_KTABLE_END             UINT32_MAX
+#define ABTI_SYNC_MAX_CACHE         64
 #define ABTI_TASK_INIT_ID           0xFFFFFFFFFFFFFFFF
+/* Number of IDs that an ES takes from the global counter at once */
+#define ABTI_ID_BLOCK_SIZE          1024
 
 #define ABTI_INDENT                 4
 
+/* Stack size classes of the memory pool.  Class 0 is the default ULT stack
+ * size and classes 1 to 9 are powers of two from ABTI_MEM_MIN_CLASS_STACKSIZE
+ * to ABTI_MEM_MAX_CLASS_STACKSIZE.  The last class, ABTI_MEM_DESC_CLASS, has
+ * no stack area and holds descriptors of ULTs whose stacks are given by the
+ * user. */
+#define ABTI_MEM_NUM_STACK_CLASSES      11
+#define ABTI_MEM_DESC_CLASS             10
+#define ABTI_MEM_MIN_CLASS_STACKSIZE    (4*1024)
+#define ABTI_MEM_MAX_CLASS_STACKSIZE    (1024*1024)
+
+/* Size classes of ABT_mem_alloc().  Class i holds blocks of
+ * (ABTI_MEM_MIN_USER_SIZE << i) bytes; larger blocks are allocated with
+ * malloc(). */
+#define ABTI_MEM_NUM_USER_CLASSES       8
+#define ABTI_MEM_MIN_USER_SIZE          16
+
+/* Each ES buffers task blocks freed to pages owned by other ESs in
+ * ABTI_MEM_NUM_RFREE_BUFS buffers, one per page, and returns them to the
+ * page once ABTI_MEM_RFREE_BATCH blocks are buffered. */
+#define ABTI_MEM_NUM_RFREE_BUFS         4
+#define ABTI_MEM_RFREE_BATCH            32
+
+/* Max. # of NUMA nodes that have their own global lists in the memory pool.
+ * Nodes beyond it share the lists of other nodes. */
+#define ABTI_MEM_MAX_NUMA_NODES         16
+
+/* Hierarchical timer wheel of each ES for timed waits and sleeps.  Each of
+ * ABTI_TIMER_WHEEL_LEVELS levels has ABTI_TIMER_WHEEL_SIZE buckets, and a
+ * bucket of level l covers ABTI_TIMER_WHEEL_SIZE^l ticks of
+ * ABTI_TIMER_WHEEL_TICK seconds.  Timeouts beyond the span of the top level
+ * are kept in one overflow bucket. */
+#define ABTI_TIMER_WHEEL_BITS           8
+#define ABTI_TIMER_WHEEL_SIZE           (1 << ABTI_TIMER_WHEEL_BITS)
+#define ABTI_TIMER_WHEEL_LEVELS         3
+#define ABTI_TIMER_WHEEL_TICK           1.0e-4  /* in seconds */
+
+/* An adaptive mutex spins only if the average hold time is shorter than
+ * ABTI_MUTEX_SPIN_MAX_HOLD seconds, and the clock is read every
+ * ABTI_MUTEX_SPIN_CHECK iterations of spinning. */
+#define ABTI_MUTEX_SPIN_MAX_HOLD        5.0e-6
+#define ABTI_MUTEX_SPIN_CHECK           64
+
+/* States of a timed waiter */
+#define ABTI_TIMEOUT_WAITING            0
+#define ABTI_TIMEOUT_SIGNALED           1
+#define ABTI_TIMEOUT_EXPIRED            2
+
+/* Unit type of timed waiters in the wait queues of synchronization objects.
+ * The pool field of such a unit points to its ABTI_timeout. */
+#define ABTI_UNIT_TYPE_TIMED            ((ABT_unit_type)(ABT_UNIT_TYPE_EXT + 1))
+
 enum ABTI_xstream_type {
     ABTI_XSTREAM_TYPE_PRIMARY,
     ABTI_XSTREAM_TYPE_SECONDARY
@@ -71,9 +158,27 @@ enum ABTI_thread_type {
     ABTI_THREAD_TYPE_USER
 };
 
+/* Built-in pools whose operations are inlined instead of called through the
+ * function pointers */
+enum ABTI_pool_builtin {
+    ABTI_POOL_BUILTIN_NONE,
+    ABTI_POOL_BUILTIN_FIFO_PRIV,
+    ABTI_POOL_BUILTIN_FIFO_SHARED
+};
+
+/* Units of a pool.  With the embedded kinds, the unit of a work unit is the
+ * ABTI_unit in it, and the runtime does not call the unit functions. */
+enum ABTI_pool_units {
+    ABTI_POOL_UNITS_CUSTOM,     /* Units of the pool's unit functions */
+    ABTI_POOL_UNITS_EMBEDDED,   /* The pool sets the pool field of units */
+    ABTI_POOL_UNITS_TRACKED     /* The runtime sets it around push and pop */
+};
+
 enum ABTI_mutex_attr_val {
     ABTI_MUTEX_ATTR_NONE = 0,
-    ABTI_MUTEX_ATTR_RECURSIVE = 1 << 0
+    ABTI_MUTEX_ATTR_RECURSIVE = 1 << 0,
+    ABTI_MUTEX_ATTR_ADAPTIVE = 1 << 1,
+    ABTI_MUTEX_ATTR_PRIO_INHERIT = 1 << 2
 };
 
 /* Macro functions */
@@ -88,12 +193,30 @@ typedef struct ABTI_elem            ABTI_elem;
 typedef struct ABTI_xstream         ABTI_xstream;
 typedef enum ABTI_xstream_type      ABTI_xstream_type;
 typedef struct ABTI_xstream_contn   ABTI_xstream_contn;
+typedef struct ABTI_xstream_worker  ABTI_xstream_worker;
+typedef struct ABTI_xstream_bringup ABTI_xstream_bringup;
+typedef struct ABTI_xstream_snapshot ABTI_xstream_snapshot;
+typedef struct ABTI_xstream_table   ABTI_xstream_table;
+typedef struct ABTI_offload         ABTI_offload;
+typedef struct ABTI_offload_req     ABTI_offload_req;
+typedef struct ABTI_offload_helper  ABTI_offload_helper;
 typedef struct ABTI_sched           ABTI_sched;
+typedef struct ABTI_sched_tune      ABTI_sched_tune;
 typedef char *                      ABTI_sched_config;
 typedef enum ABTI_sched_used        ABTI_sched_used;
 typedef void *                      ABTI_sched_id;      /* Scheduler id */
 typedef uint64_t                    ABTI_sched_kind;    /* Scheduler kind */
 typedef struct ABTI_pool            ABTI_pool;
+typedef enum ABTI_pool_builtin      ABTI_pool_builtin;
+typedef enum ABTI_pool_units        ABTI_pool_units;
+typedef struct ABTI_pool_fifo_data  ABTI_pool_fifo_data;
+typedef struct ABTI_pool_stats      ABTI_pool_stats;
+typedef struct ABTI_pool_group      ABTI_pool_group;
+typedef struct ABTI_doorbell        ABTI_doorbell;
+typedef struct ABTI_rcu_cb          ABTI_rcu_cb;
+typedef void (*ABTI_pool_push_many_fn)(ABT_pool, ABT_unit *, size_t);
+typedef size_t (*ABTI_pool_pop_many_fn)(ABT_pool, ABT_unit *, size_t);
+typedef int (*ABTI_pool_try_push_fn)(ABT_pool, ABT_unit);
 typedef struct ABTI_unit            ABTI_unit;
 typedef struct ABTI_thread_attr     ABTI_thread_attr;
 typedef struct ABTI_thread          ABTI_thread;
@@ -104,21 +227,57 @@ typedef struct ABTI_thread_entry    ABTI_thread_entry;
 typedef struct ABTI_thread_htable   ABTI_thread_htable;
 typedef struct ABTI_thread_queue    ABTI_thread_queue;
 typedef struct ABTI_task            ABTI_task;
+typedef struct ABTI_task_resumable  ABTI_task_resumable;
 typedef struct ABTI_key             ABTI_key;
 typedef struct ABTI_ktelem          ABTI_ktelem;
 typedef struct ABTI_ktable          ABTI_ktable;
+typedef struct ABTI_task_batch      ABTI_task_batch;
 typedef struct ABTI_mutex_attr      ABTI_mutex_attr;
 typedef struct ABTI_mutex           ABTI_mutex;
 typedef struct ABTI_cond            ABTI_cond;
 typedef struct ABTI_rwlock          ABTI_rwlock;
+typedef struct ABTI_rwlock_slot     ABTI_rwlock_slot;
 typedef struct ABTI_eventual        ABTI_eventual;
+typedef struct ABTI_cont            ABTI_cont;
 typedef struct ABTI_future          ABTI_future;
 typedef struct ABTI_barrier         ABTI_barrier;
+typedef struct ABTI_barrier_tree    ABTI_barrier_tree;
+typedef struct ABTI_barrier_tree_node ABTI_barrier_tree_node;
 typedef struct ABTI_timer           ABTI_timer;
+typedef struct ABTI_timeout         ABTI_timeout;
+typedef struct ABTI_timer_wheel     ABTI_timer_wheel;
+typedef struct ABTI_io_waiter       ABTI_io_waiter;
+typedef struct ABTI_io_poller       ABTI_io_poller;
+typedef struct ABTI_io_ring         ABTI_io_ring;
+typedef struct ABTI_mpi_waiter      ABTI_mpi_waiter;
+typedef struct ABTI_mpi_poller      ABTI_mpi_poller;
+typedef struct ABTI_poll_hook       ABTI_poll_hook;
+typedef struct ABTI_task_graph      ABTI_task_graph;
+typedef struct ABTI_task_graph_node ABTI_task_graph_node;
+typedef struct ABTI_join_counter    ABTI_join_counter;
+typedef struct ABTI_wait_group      ABTI_wait_group;
+typedef struct ABTI_sem             ABTI_sem;
+typedef struct ABTI_gang            ABTI_gang;
+typedef struct ABTI_delayed         ABTI_delayed;
+typedef struct ABTI_channel         ABTI_channel;
+typedef struct ABTI_channel_waiter  ABTI_channel_waiter;
+typedef struct ABTI_completion_source ABTI_completion_source;
+typedef struct ABTI_trace_entry     ABTI_trace_entry;
+typedef struct ABTI_trace_buf       ABTI_trace_buf;
+typedef struct ABTI_profile_entry   ABTI_profile_entry;
+typedef struct ABTI_profile         ABTI_profile;
+typedef struct ABTI_record_entry    ABTI_record_entry;
+typedef struct ABTI_record          ABTI_record;
+typedef struct ABTI_stack_usage_entry ABTI_stack_usage_entry;
+typedef struct ABTI_cpu_time_entry  ABTI_cpu_time_entry;
 #ifdef ABT_CONFIG_USE_MEM_POOL
 typedef struct ABTI_stack_header    ABTI_stack_header;
 typedef struct ABTI_page_header     ABTI_page_header;
 typedef struct ABTI_sp_header       ABTI_sp_header;
+typedef struct ABTI_stack_list      ABTI_stack_list;
+typedef struct ABTI_mem_node        ABTI_mem_node;
+typedef struct ABTI_blk_header      ABTI_blk_header;
+typedef struct ABTI_rfree_buf       ABTI_rfree_buf;
 #endif
 
 
@@ -146,15 +305,85 @@ struct ABTI_mutex {
     ABTI_thread_htable *p_htable;   /* a set of queues */
     ABTI_thread *p_handover;        /* next ULT for the mutex handover */
     ABTI_thread *p_giver;           /* current ULT that hands over the mutex */
+    ABTI_unit *p_timed_head;        /* Timed waiters (protected by p_htable) */
+    ABTI_unit *p_timed_tail;
+    /* Adaptive mode.  These are updated only by the holder. */
+    ABTI_xstream *p_holder_xstream; /* ES running the holder */
+    double hold_start;              /* Time when the holder got the mutex */
+    double avg_hold_time;           /* Moving average of hold times */
+    uint64_t num_locks;             /* Number of acquisitions */
+    uint64_t num_contended;         /* Acquisitions that had to wait */
+    uint64_t num_spins;             /* Contended acquisitions by spinning */
+    uint64_t num_parks;             /* Number of times parked in p_htable */
+    /* Priority inheritance.  These are protected by pi_lock. */
+    ABTI_spinlock pi_lock;
+    ABTI_thread *p_pi_owner;        /* ULT holding the mutex */
+    int pi_priority;                /* Priority of p_pi_owner before boosts */
+};
+
+/* A blocking call of a ULT run by a helper OS thread.  It lives on the stack
+ * of the ULT, which is blocked until the call returns. */
+struct ABTI_offload_req {
+    void (*fn)(void *);
+    void *arg;
+    ABTI_thread *p_thread;      /* Calling ULT */
+    ABTI_offload_req *p_next;   /* Link in the queue */
+};
+
+struct ABTI_offload_helper {
+    ABTD_xstream_context ctx;   /* OS thread */
+    ABTI_offload_helper *p_next;
+};
+
+/* Helper OS threads of ABT_offload(), which are created on demand up to
+ * max_helpers.  All the fields are protected by lock. */
+struct ABTI_offload {
+    ABTI_spinlock lock;
+    uint32_t max_helpers;       /* Max. # of helper OS threads */
+    uint32_t num_helpers;       /* Current # of helper OS threads */
+    uint32_t num_idle;          /* # of helpers waiting for requests */
+    uint32_t num_queued;        /* # of requests in the queue */
+    uint32_t seq;               /* Futex word to wake up idle helpers */
+    ABT_bool exit;              /* Have the helpers to exit? */
+    ABTI_offload_req *p_head;   /* Queue of requests */
+    ABTI_offload_req *p_tail;
+    ABTI_offload_helper *p_helpers;
+};
+
+/* ULTs waiting for external events, e.g., GPU events, whose completion is
+ * tested by poll_fn.  The arrays are passed to poll_fn as they are.  All the
+ * fields are protected by lock, which also serializes the calls of poll_fn. */
+struct ABTI_completion_source {
+    ABTI_spinlock lock;
+    ABT_completion_poll_fn poll_fn;
+    void *arg;                  /* Argument for poll_fn */
+    int num_waiters;            /* Number of waiting ULTs */
+    int max_waiters;            /* Allocation size of the arrays */
+    void **events;              /* Events being waited for */
+    ABTI_thread **waiters;      /* waiters[i] waits for events[i] */
+    ABT_bool *completed;        /* Output of poll_fn */
+    ABTI_completion_source *p_prev; /* Links in the global list */
+    ABTI_completion_source *p_next;
+};
+
+/* ES array replaced by a larger one.  It is kept until ABT_finalize since
+ * lock-free readers may still be reading it. */
+struct ABTI_xstream_table {
+    ABTI_xstream **p_xstreams;
+    ABTI_xstream_table *p_next;
 };
 
 struct ABTI_global {
+    /* ES array.  It is read without locking (see ABTI_global_get_xstreams())
+     * and written while holding lock. */
     int max_xstreams;           /* Max. size of p_xstreams */
     int num_xstreams;           /* Current # of ESs */
     ABTI_xstream **p_xstreams;  /* ES array */
+    ABTI_xstream_table *p_old_xstreams; /* Replaced ES arrays */
     ABTI_spinlock lock;         /* Spinlock */
 
     int num_cores;              /* Number of CPU cores */
+    int cpu_quota;              /* CPU quota of the cgroup (0: unlimited) */
     ABT_bool set_affinity;      /* Whether CPU affinity is used */
     ABT_bool use_logging;       /* Whether logging is used */
     ABT_bool use_debug;         /* Whether debug output is used */
@@ -163,10 +392,45 @@ struct ABTI_global {
     size_t sched_stacksize;     /* Default stack size for sched (in bytes) */
     uint32_t sched_event_freq;  /* Default check frequency for sched */
     long sched_sleep_nsec;      /* Default nanoseconds for scheduler sleep */
+    ABT_bool sched_autotune;    /* Whether schedulers tune the two above */
+    uint32_t sched_remote_threshold; /* Imbalance to move across nodes */
+    uint32_t core_class_gen;    /* Bumped when the class of an ES changes */
+    ABT_bool sched_prefetch;    /* Whether schedulers prefetch units */
     ABTI_thread *p_thread_main; /* ULT of the main function */
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    uint32_t park_seq;          /* Futex word to wake up parked schedulers */
+    uint32_t num_parked;        /* Number of parked schedulers */
+    uint64_t parked_mask;       /* Ranks of the ESs parked on doorbells */
+    ABTI_doorbell *p_doorbells; /* ABTI_SCHED_NUM_DOORBELLS doorbells */
+#endif
 
     uint32_t mutex_max_handovers;      /* Default max. # of local handovers */
     uint32_t mutex_max_wakeups;        /* Default max. # of wakeups */
+    ABT_bool handoff;                  /* Switch to woken ULTs directly */
+    ABT_bool wake_affine;              /* Wake ULTs up on their last ES */
+    uint32_t wake_affine_max_queue;    /* Max. queue length for wake_affine */
+    ABT_bool run_next;                 /* Run created ULTs next on their ES */
+    long preempt_interval_nsec;        /* Preemption quantum (0: disabled) */
+    uint32_t max_parked_xstreams;      /* Max. # of parked OS threads */
+    uint32_t pool_ring_capacity;       /* Capacity of ABT_POOL_RING */
+    uint32_t pool_multiq_num_queues;   /* Sub-queues of ABT_POOL_MULTIQ */
+    uint32_t task_batch_size;          /* Max. # of tasklets in a batch */
+    double task_batch_latency;         /* Max. time a batch stays open (s) */
+    double team_spin_time;             /* Spin time of team members (s) */
+    uint32_t task_inline_depth;        /* Max. nesting of inline tasklets */
+    uint32_t num_parked_xstreams;      /* Current # of parked OS threads */
+    ABTI_xstream_worker *p_parked_xstreams; /* List of parked OS threads */
+    ABTI_offload offload;              /* Helpers for blocking calls */
+    ABTI_spinlock completion_lock;     /* Protects p_completion_sources */
+    uint32_t num_completion_waiters;   /* # of ULTs waiting on all sources */
+    ABTI_completion_source *p_completion_sources; /* List of all sources */
+    ABT_bool stack_canary;             /* Check canaries at stack bottoms? */
+    uint32_t num_ext_joiners;          /* External threads blocked in join */
+    uint32_t ext_join_seq;             /* Advanced to wake them up */
+    uint64_t rcu_epoch;                /* Current RCU epoch (from 1) */
+    ABTI_spinlock rcu_lock;            /* Protects the two below */
+    ABTI_xstream *p_rcu_xstreams;      /* ESs that may run readers */
+    ABTI_rcu_cb *p_rcu_orphans;        /* Callbacks of stopped or parked ESs */
 
     uint32_t cache_line_size;          /* Cache line size */
     uint32_t os_page_size;             /* OS page size */
@@ -175,17 +439,44 @@ struct ABTI_global {
     uint32_t mem_page_size;            /* Page size for memory allocation */
     uint32_t mem_sp_size;              /* Stack page size */
     uint32_t mem_max_stacks;           /* Max. # of stacks kept in each ES */
+    uint32_t mem_stack_colors;         /* # of offsets of stack tops */
     int mem_lp_alloc;                  /* How to allocate large pages */
+    ABT_bool mem_lazy_stack;           /* Whether stacks are lazily committed */
+    ABT_bool mem_fast_finalize;        /* Whether pages are left to the OS */
+    double mem_trim_interval;          /* Interval of background trims (s) */
+    size_t mem_trim_size;              /* Bytes kept by background trims */
+    uint32_t mem_trim_seq;             /* Incremented by ABT_mem_trim() */
+    size_t mem_trim_target;            /* Bytes kept by the last request */
+    ABTI_spinlock mem_trim_lock;       /* Serializes trims of global data */
+    uint64_t mem_trimmed_bytes;        /* Bytes of pages released by trims */
+    uint64_t mem_malloc_bytes;         /* Bytes of large pages allocated by */
+    uint64_t mem_mmap_rp_bytes;        /* each method */
+    uint64_t mem_mmap_hp_bytes;
+    uint64_t mem_thp_bytes;
+    uint64_t mem_mmap_gp_bytes;
+    uint64_t mem_num_gp_failures;      /* # of failures of each method, */
+    uint64_t mem_num_hp_failures;      /* after which the next one is used */
+    uint64_t mem_num_mmap_failures;
+    uint64_t mem_num_thp_failures;
     uint32_t mem_sh_size;              /* Stack header (including ABTI_thread
                                           ABTI_stack_header) size */
-    ABTI_stack_header *p_mem_stack;    /* List of ULT stack */
-    ABTI_page_header *p_mem_task;      /* List of task block pages */
+    int mem_num_nodes;                 /* # of elements of p_mem_nodes */
+    ABTI_mem_node *p_mem_nodes;        /* Global lists per NUMA node */
     ABTI_sp_header *p_mem_sph;         /* List of stack pages */
 #endif
 
     ABT_bool pm_connected;      /* Is power mgmt. daemon connected? */
     char *pm_host;              /* Hostname for power mgmt. daemon */
     int pm_port;                /* Port number for power mgmt. daemon */
+    char *pm_shm;               /* File of the shared control block */
+#ifdef ABT_CONFIG_HANDLE_POWER_EVENT
+    ABT_bool elastic;           /* Adjust # of ESs by demand? */
+    int elastic_min_xstreams;   /* Min. # of ESs kept by the controller */
+    int elastic_max_xstreams;   /* Max. # of ESs added by the controller */
+    double elastic_interval;    /* Time interval in seconds */
+    uint32_t elastic_grow_depth;/* Queued units per ES to add an ES */
+    uint32_t elastic_park_idle; /* Percentage of idle pops to park an ES */
+#endif
 #ifdef ABT_CONFIG_PUBLISH_INFO
     ABT_bool pub_needed;        /* Is info. publishing needed? */
     char *pub_filename;         /* Filename for publishing */
@@ -193,18 +484,102 @@ struct ABTI_global {
 #endif
 
     ABT_bool print_config;      /* Whether to print config on ABT_init */
+
+    ABT_bool use_tracing;       /* Whether events are traced */
+    ABT_bool use_unit_stats;    /* Whether unit timings are collected */
+    ABT_bool use_pool_stats;    /* Whether pool operations are counted */
+    uint32_t trace_size;        /* # of entries of each ES's trace buffer */
+    char *trace_filename;       /* File the traces are dumped to at exit */
+    ABT_bool trace_binary;      /* Whether the dump is in the binary format */
+    ABTI_trace_buf *p_trace_bufs;   /* Trace buffers of all ESs */
+    uint64_t trace_cycles;      /* Cycle counter at ABT_init */
+    double trace_wtime;         /* ABT_get_wtime() at ABT_init */
+
+    long profile_interval_nsec; /* Sampling interval (0: disabled) */
+    char *profile_filename;     /* File the profile is written to at exit */
+    ABTI_profile *p_profiles;   /* Profiles of all ESs */
+
+    ABT_bool stack_profile;     /* Whether stack usage is measured */
+    ABTI_stack_usage_entry *p_stack_usage; /* Stack usage per function */
+
+    ABT_bool use_cpu_time;      /* Whether the CPU time of units is counted */
+    ABTI_cpu_time_entry *p_cpu_time; /* CPU time per function */
+
+    char *lock_profile_filename; /* File the lock profile is written to */
+
+    uint32_t sched_record;      /* ABTI_RECORD_OFF, _ON, or _REPLAY */
+    char *record_filename;      /* File the schedules are recorded to */
+    char *replay_filename;      /* File of the schedules to replay */
+    ABTI_record *p_records;     /* Recorded or replayed schedules */
+    ABTI_spinlock record_lock;  /* Orders the pops while recording */
+    uint64_t record_seq;        /* Next decision in the order of all ESs */
+    uint64_t replay_total;      /* # of decisions to replay */
+    uint64_t replay_num;        /* # of replayed decisions */
+    uint64_t replay_diverged;   /* # of decisions that were not followed */
+};
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+struct ABTI_stack_list {
+    uint32_t num_stacks;        /* Current # of stacks */
+    uint32_t max_stacks;        /* Adaptive limit of num_stacks */
+    uint32_t min_stacks;        /* Lower bound of max_stacks */
+    uint32_t low_stacks;        /* Min. num_stacks in this epoch */
+    uint32_t num_frees;         /* # of stack frees in this epoch */
+    ABTI_stack_header *p_head;  /* Free stack list */
+    ABTI_sp_header *p_sph;      /* Stack page that has uncarved stacks */
+};
+#endif
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+struct ABTI_mem_node {
+    ABTI_spinlock lock;         /* Protects the lists below */
+    ABTI_stack_header *p_mem_stack[ABTI_MEM_NUM_STACK_CLASSES];
+                                /* Lists of ULT stacks per size class */
+    uint32_t num_mem_stacks[ABTI_MEM_NUM_STACK_CLASSES];
+                                /* # of stacks in p_mem_stack */
+    ABTI_page_header *p_mem_task;   /* List of task block pages */
+    ABTI_page_header *p_mem_user;   /* ABT_mem_alloc() pages left by ESs */
+    ABTI_sp_header *p_mem_sph[ABTI_MEM_NUM_STACK_CLASSES];
+                                /* Stack pages left with uncarved stacks */
+};
+
+struct ABTI_rfree_buf {
+    ABTI_page_header *p_ph;     /* Page of the buffered blocks */
+    ABTI_blk_header *p_head;    /* First buffered block */
+    ABTI_blk_header *p_tail;    /* Last buffered block */
+    uint32_t num_blks;          /* # of buffered blocks */
 };
+#endif
 
 struct ABTI_local {
     ABTI_xstream *p_xstream;    /* Current ES */
     ABTI_thread *p_thread;      /* Current running ULT */
     ABTI_task *p_task;          /* Current running tasklet */
+    uint32_t num_reuse_threads; /* # of ULTs in p_reuse_threads */
+    ABTI_thread *p_reuse_threads[ABTI_THREAD_MAX_REUSE];
+                                /* Freed reusable ULTs, the newest last */
+    uint32_t num_ktables;       /* # of tables in p_ktables */
+    ABTI_ktable *p_ktables;     /* Freed key tables */
+    ABTI_task_batch *p_task_batch; /* Open batch of tasklets */
+    uint32_t task_inline_depth; /* # of tasklets nested inline */
+    uint32_t num_eventuals;     /* # of eventuals in p_eventuals */
+    ABTI_eventual *p_eventuals; /* Freed eventuals */
+    uint32_t num_futures;       /* # of futures in p_futures */
+    ABTI_future *p_futures;     /* Freed futures */
 
 #ifdef ABT_CONFIG_USE_MEM_POOL
-    uint32_t num_stacks;                /* Current # of stacks */
-    ABTI_stack_header *p_mem_stack;     /* Free stack list */
+    ABTI_stack_list mem_stacks[ABTI_MEM_NUM_STACK_CLASSES];
+                                        /* Free stack lists per size class */
     ABTI_page_header *p_mem_task_head;  /* Head of page list */
     ABTI_page_header *p_mem_task_tail;  /* Tail of page list */
+    ABTI_page_header *p_mem_user[ABTI_MEM_NUM_USER_CLASSES];
+                                        /* ABT_mem_alloc() pages per class */
+    int mem_node;                       /* NUMA node the ES last ran on */
+    ABTI_rfree_buf mem_rfree_bufs[ABTI_MEM_NUM_RFREE_BUFS];
+                                        /* Buffers of remote free blocks */
+    uint32_t mem_rfree_victim;          /* Buffer to be flushed next */
+    uint32_t mem_trim_seq;              /* Last trim request handled */
+    double mem_trim_time;               /* Time of the next background trim */
 #endif
 };
 
@@ -222,6 +597,123 @@ struct ABTI_elem {
     ABTI_elem    *p_next;  /* Next element in list */
 };
 
+/* A timed waiter.  A signaler and the timer race to change state from
+ * ABTI_TIMEOUT_WAITING, and only the winner wakes up the waiter. */
+struct ABTI_timeout {
+    uint32_t state;             /* ABTI_TIMEOUT_* */
+    ABT_bool linked;            /* Is it in a bucket of p_wheel? */
+    uint32_t bucket;            /* Index of the bucket */
+    ABTI_thread *p_thread;      /* Waiting ULT, or NULL if external */
+    ABTI_timer_wheel *p_wheel;  /* Wheel of the ES where the ULT waits */
+    void (*f_expire)(ABTI_timeout *); /* Called by the wheel instead of
+                                         waking up p_thread if not NULL */
+    double deadline;            /* Absolute time in seconds */
+    ABTI_timeout *p_prev;       /* Links in the bucket */
+    ABTI_timeout *p_next;
+};
+
+struct ABTI_timer_wheel {
+    ABTI_spinlock lock;
+    uint32_t num_entries;       /* Number of linked timeouts */
+    uint32_t num_level_entries[ABTI_TIMER_WHEEL_LEVELS + 1];
+    uint64_t cur_tick;          /* Ticks before it have been processed */
+    ABT_bool is_closed;         /* No timeout is started once it is set */
+    ABTI_timeout *buckets[ABTI_TIMER_WHEEL_LEVELS * ABTI_TIMER_WHEEL_SIZE + 1];
+};
+
+/* A ULT waiting for a file descriptor.  It lives on the stack of the ULT and
+ * is woken up only by the poller of the ES where it started waiting. */
+struct ABTI_io_waiter {
+    ABTI_thread *p_thread;      /* Waiting ULT */
+    int fd;                     /* File descriptor */
+    int revents;                /* poll() events reported by the poller */
+    int status;                 /* Return value of ABT_io_wait() */
+    double deadline;            /* Absolute time in seconds, or negative */
+    ABTI_io_waiter *p_prev;     /* Links in the poller */
+    ABTI_io_waiter *p_next;
+};
+
+/* io_uring instance of an ES for file I/O of its ULTs.  The pointers refer to
+ * the rings shared with the kernel. */
+struct ABTI_io_ring {
+    int fd;                     /* -1 until it is used, or -2 if unavailable */
+    uint32_t num_unsubmitted;   /* Number of SQEs queued but not submitted */
+    uint32_t num_inflight;      /* Number of requests not completed */
+    uint32_t sq_mask;
+    uint32_t cq_mask;
+    uint32_t cq_entries;        /* Bound of num_inflight */
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t *sq_array;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    void *sqes;                 /* struct io_uring_sqe[] */
+    void *cqes;                 /* struct io_uring_cqe[] */
+    void *sq_ring;              /* Mappings */
+    void *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    size_t sqes_size;
+};
+
+/* Only the ES that owns the poller touches it while the ES runs, i.e., its
+ * waiters before they are suspended and its scheduler, so no lock is needed. */
+struct ABTI_io_poller {
+    int epfd;                   /* epoll instance, or -1 until it is used */
+    uint32_t num_waiters;       /* Number of waiters, including the requests
+                                   in ring */
+    double next_deadline;       /* No waiter times out before it, or negative */
+    ABTI_io_waiter *p_head;     /* Waiters registered in epfd */
+    ABTI_io_ring ring;
+};
+
+#ifdef ABT_CONFIG_USE_MPI
+struct ABTI_mpi_waiter {
+    ABTI_thread *p_thread;      /* Waiting ULT */
+    MPI_Request request;        /* Request after its completion */
+    MPI_Status status;
+    int error;                  /* Return value of ABT_mpi_wait() */
+};
+#endif
+
+/* MPI requests that the ULTs on an ES wait for.  The arrays are passed to
+ * MPI_Testsome() as they are. */
+struct ABTI_mpi_poller {
+    int num_waiters;            /* Number of requests */
+#ifdef ABT_CONFIG_USE_MPI
+    int max_waiters;            /* Allocation size of the arrays */
+    MPI_Request *requests;      /* Requests being waited for */
+    ABTI_mpi_waiter **waiters;  /* waiters[i] waits for requests[i] */
+    int *indices;               /* Output of MPI_Testsome() */
+    MPI_Status *statuses;
+#endif
+};
+
+/* Function called by the scheduler of an ES every period event checks */
+struct ABTI_poll_hook {
+    void (*fn)(void *);
+    void *arg;
+    uint32_t period;            /* Interval in calls of check_events */
+    uint32_t count;             /* Event checks since the last call */
+};
+
+/* Summary of an ES that the ES publishes from time to time, so the info
+ * routines can print it without touching the live ES.  seq is a seqlock: it
+ * is odd while the summary is being written. */
+struct ABTI_xstream_snapshot {
+    uint32_t seq;               /* Sequence number */
+    uint64_t rank;
+    ABTI_xstream_type type;
+    ABT_xstream_state state;
+    uint32_t request;
+    int max_scheds;
+    int num_scheds;
+    ABTI_sched *p_main_sched;
+    uint64_t num_remote_frees;
+    double time;                /* ABT_get_wtime() when it was published */
+    ABT_xstream_stats stats;
+};
+
 struct ABTI_xstream {
     uint64_t rank;              /* Rank */
     ABTI_xstream_type type;     /* Type */
@@ -229,13 +721,187 @@ struct ABTI_xstream {
     ABTI_sched **scheds;        /* Stack of running schedulers */
     int max_scheds;             /* Allocation size of the array scheds */
     int num_scheds;             /* Number of scheds */
-    ABTI_spinlock sched_lock;   /* Lock for the scheduler management */
+    ABTI_sched *p_main_sched;   /* Main scheduler */
 
-    uint32_t request;           /* Request */
+    /* Written by other ESs */
+    uint32_t request ABTI_CACHE_ALIGNED;    /* Request */
     void *p_req_arg;            /* Request argument */
-    ABTI_sched *p_main_sched;   /* Main scheduler */
+    ABTI_eventual *p_join_eventual; /* Set when the ES terminates */
+    ABTI_sched *p_swap_sched;   /* Next main scheduler */
+    ABTI_spinlock sched_lock;   /* Lock for the scheduler management */
 
     ABTD_xstream_context ctx;   /* ES context */
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    uint64_t num_remote_frees;  /* # of task blocks freed to other ESs */
+    ABTI_local *p_local;        /* ES-local data while the ES runs */
+#endif
+
+    /* Timed waits of the ULTs blocked on this ES */
+    ABTI_timer_wheel timer_wheel ABTI_CACHE_ALIGNED;
+
+    /* I/O waits of the ULTs blocked on this ES */
+    ABTI_io_poller io_poller;
+    ABTI_mpi_poller mpi_poller;
+
+    /* Poll hooks, which are protected by poll_hook_lock */
+    ABTI_spinlock poll_hook_lock;
+    int num_poll_hooks;         /* Number of hooks */
+    int max_poll_hooks;         /* Allocation size of poll_hooks */
+    ABTI_poll_hook *poll_hooks;
+
+    /* Preemption of long-running ULTs */
+    uint64_t num_thread_runs;   /* # of times ULTs have been scheduled */
+    uint64_t preempt_runs;      /* num_thread_runs at the last timer tick */
+    ABT_bool preemptive;        /* Is preempt_timer running? */
+    ABTD_preempt_timer preempt_timer;
+
+    /* Yields that have bypassed the scheduler since it last ran */
+    uint32_t num_fast_yields;
+
+    /* ULT created work-first, which runs once its creator has stopped */
+    ABTI_thread *p_work_first;
+
+    /* ULT to run before the next unit popped from the pools, i.e., a ULT woken
+     * up here because it last ran here or a ULT created here */
+    ABTI_thread *p_run_next;
+
+    /* Blocks of ULT and tasklet IDs taken from the global counters.  IDs are
+     * handed out from them without atomic operations. */
+    uint64_t thread_id_next;    /* Next ULT ID */
+    uint64_t thread_id_end;     /* End of the block of ULT IDs */
+    uint64_t task_id_next;      /* Next tasklet ID */
+    uint64_t task_id_end;       /* End of the block of tasklet IDs */
+
+    /* OS thread that runs this ES */
+    uint32_t ctx_released;      /* Has the OS thread stopped using this ES? */
+    ABT_bool ctx_parked;        /* Has the OS thread been parked for reuse? */
+    ABTI_xstream_bringup *p_bringup;    /* Set while this ES brings itself
+                                         * up (ABT_xstream_create_many) */
+    int bringup_index;          /* Index of this ES in p_bringup */
+
+    /* OS scheduling of the OS thread, which is protected by os_lock */
+    ABTI_spinlock os_lock;
+    int os_tid;                 /* OS thread ID, or 0 if it is not running */
+    ABT_xstream_os_policy os_policy;
+    int os_priority;            /* Niceness or real-time priority */
+    int core_class;             /* ABT_CORE_CLASS_* of the bound CPU */
+
+    /* RCU (see rcu.c).  Only rcu_epoch is read by other ESs. */
+    uint64_t rcu_epoch ABTI_CACHE_ALIGNED; /* Epoch of the last quiescent
+                                             * state, or 0 if offline */
+    uint32_t rcu_nesting;       /* Depth of read-side critical sections */
+    ABTI_xstream *p_rcu_next;   /* Next in p_rcu_xstreams of ABTI_global */
+    ABTI_rcu_cb *p_rcu_head;    /* Pending callbacks */
+    ABTI_rcu_cb *p_rcu_tail;
+
+    /* Statistics, which only this ES updates */
+    ABT_xstream_stats stats ABTI_CACHE_ALIGNED;
+
+    /* Summary for the info routines (see ABTI_xstream_publish()) */
+    ABTI_xstream_snapshot snapshot ABTI_CACHE_ALIGNED;
+
+    /* Event trace, which only this ES writes (NULL if tracing is off) */
+    ABTI_trace_buf *p_trace;
+    /* Samples of the running units (NULL if profiling is off) */
+    ABTI_profile *p_profile;
+    ABT_bool profiling;         /* Is profile_timer running? */
+    /* Recorded or replayed schedule (NULL if neither) */
+    ABTI_record *p_record;
+    uint64_t record_seq;        /* Order of the last pop while recording */
+    uint32_t record_nesting;    /* Depth of pops from nested pools */
+    ABTD_profile_timer profile_timer;
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    /* Histograms that only this ES writes (NULL if ABT_UNIT_STATS is off) */
+    ABT_unit_stats *p_unit_stats;
+#endif
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    /* Ticks at the last switch on this ES (see abti_cpu_time.h) */
+    uint64_t cpu_time_ticks;
+#endif
+};
+
+/* OS thread that runs secondary ESs one after another.  After its ES
+ * terminates, it is parked with its ES-local data intact until a new ES
+ * takes it over. */
+struct ABTI_xstream_worker {
+    ABTD_xstream_context ctx;   /* OS thread */
+    ABTI_xstream *p_xstream;    /* ES to run next (NULL while parked) */
+    ABT_bool exit;              /* Has the OS thread to exit? */
+    uint32_t seq;               /* Futex word to wake up the parked thread */
+    ABTI_xstream_worker *p_next;
+};
+
+/* A traced event.  The buffer is a ring, so only the last entries are kept
+ * once it wraps around. */
+struct ABTI_trace_entry {
+    uint64_t cycles;            /* ABTD_time_get_cycles() */
+    uint64_t obj;               /* Address of the work unit */
+    uint32_t kind;              /* ABTI_TRACE_* */
+    uint32_t arg;               /* Pool ID or other argument */
+};
+
+struct ABTI_trace_buf {
+    uint64_t pos;               /* # of recorded events */
+    uint64_t mask;              /* # of entries - 1 (a power of two - 1) */
+    uint64_t rank;              /* Rank of the ES that owns this buffer */
+    ABTI_trace_entry *p_entries;
+    ABTI_trace_buf *p_next;     /* Link in the global list */
+};
+
+/* Number of profiling samples of a running function in a pool.  An entry is
+ * written only by the signal handler of its ES and never removed, so a reader
+ * can scan the table while the ES is running. */
+struct ABTI_profile_entry {
+    uint64_t func;              /* Address of the function (0 if unknown) */
+    uint64_t pool_id;           /* Pool ID (UINT64_MAX if none) */
+    uint32_t kind;              /* ABTI_PROFILE_* */
+    uint32_t used;              /* Set after the fields above are written */
+    uint64_t count;             /* # of samples */
+};
+
+/* Stack usage of the ULTs that ran a function */
+struct ABTI_stack_usage_entry {
+    uint64_t func;              /* Address of the function (0 for others) */
+    ABT_histogram usage;        /* Bytes used at the deepest point */
+};
+
+struct ABTI_cpu_time_entry {
+    uint64_t func;              /* Address of the function (0 for others) */
+    uint64_t count;             /* # of terminated ULTs and tasklets */
+    uint64_t ticks;             /* Sum of their CPU time */
+    uint64_t max_ticks;         /* Maximum of their CPU time */
+};
+
+/* Open-addressing hash table of the samples of an ES */
+struct ABTI_profile {
+    uint64_t num_samples;       /* # of samples */
+    uint64_t num_dropped;       /* Samples that did not fit into the table */
+    uint64_t mask;              /* # of entries - 1 (a power of two - 1) */
+    uint64_t rank;              /* Rank of the ES that owns this table */
+    ABTI_profile_entry *p_entries;
+    ABTI_profile *p_next;       /* Link in the global list */
+};
+
+/* A scheduling decision: the unit popped from a pool by an ES.  seq orders
+ * the decisions of all ESs. */
+struct ABTI_record_entry {
+    uint64_t seq;               /* Position in the order of all decisions */
+    uint64_t unit;              /* Unit ID, or'ed with ABTI_RECORD_TASK */
+    uint32_t pool;              /* ID of the pool it was popped from */
+    uint32_t home;              /* ID of its pool after a steal, or pool */
+};
+
+/* The decisions of an ES in the order it made them */
+struct ABTI_record {
+    uint64_t rank;              /* Rank of the ES */
+    uint64_t num;               /* # of entries */
+    uint64_t size;              /* # of allocated entries */
+    uint64_t pos;               /* Next entry to replay */
+    ABT_bool used;              /* Taken by an ES to replay */
+    uint64_t wait_seq;          /* Decision the ES waits for after its own */
+    double wait_start;          /* When it started waiting */
+    ABTI_record_entry *p_entries;
+    ABTI_record *p_next;        /* Link in the global list */
 };
 
 struct ABTI_xstream_contn {
@@ -245,15 +911,38 @@ struct ABTI_xstream_contn {
     ABTI_mutex mutex;    /* Mutex */
 };
 
+/* Online tuning of the event frequency and the sleep time of a scheduler
+ * (ABT_SCHED_AUTOTUNE).  ABTI_xstream_check_events() measures each event
+ * check, and the values are adjusted once per window. */
+struct ABTI_sched_tune {
+    ABT_bool enabled;           /* Whether the scheduler is tuned */
+    uint32_t event_freq;        /* Tuned event frequency (0 until known) */
+    long sleep_nsec;            /* Tuned maximum time of a park */
+    double window_start;        /* Start time of the window, or 0 */
+    double check_time;          /* Time spent on event checks in the window */
+    uint32_t num_checks;        /* Event checks in the window */
+    uint64_t num_units;         /* stats.num_units at the window start */
+    uint64_t num_idle_loops;    /* stats.num_idle_loops at the window start */
+    double check_cost;          /* Results of the last window */
+    double check_overhead;
+    double idle_ratio;
+    uint64_t num_adjustments;   /* Number of changes of the values */
+};
+
 struct ABTI_sched {
     ABTI_sched_used used;       /* To know if it is used and how */
     ABT_bool automatic;         /* To know if automatic data free */
+    ABT_bool inline_nested;     /* Stacked tasklet scheduler that stays in
+                                   its pool and is skipped while idle */
     ABTI_sched_kind kind;       /* Kind of the scheduler  */
     ABT_sched_type type;        /* Can yield or not (ULT or task) */
     ABT_sched_state state;      /* State */
     uint32_t request;           /* Request */
     ABT_pool *pools;            /* Work unit pools */
     int num_pools;              /* Number of work unit pools */
+    ABT_pool *polling_pools;    /* Pools of units run only while idle */
+    int num_polling_pools;      /* Number of polling pools */
+    int polling_idx;            /* Next polling pool to pop */
     ABTI_thread *p_thread;      /* Associated ULT */
     ABTI_task *p_task;          /* Associated tasklet */
     ABTD_thread_context *p_ctx; /* Context */
@@ -265,6 +954,8 @@ struct ABTI_sched {
     ABT_sched_free_fn free;
     ABT_sched_get_migr_pool_fn get_migr_pool;
 
+    ABTI_sched_tune tune;       /* Autotuning of the predefined schedulers */
+
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     uint64_t id;                /* ID */
 #endif
@@ -272,6 +963,8 @@ struct ABTI_sched {
 
 struct ABTI_pool {
     ABT_pool_access access;  /* Access mode */
+    ABTI_pool_builtin builtin; /* Built-in pool to be inlined */
+    ABTI_pool_units units;   /* Kind of units */
     ABT_bool automatic;      /* To know if automatic data free */
     int32_t num_scheds;      /* Number of associated schedulers */
                              /* NOTE: int32_t to check if still positive */
@@ -281,8 +974,6 @@ struct ABTI_pool {
 #ifndef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
     ABTI_xstream *producer;  /* Associated producer ES */
 #endif
-    uint32_t num_blocked;    /* Number of blocked ULTs */
-    int32_t num_migrations;  /* Number of migrating ULTs */
     void *data;              /* Specific data */
     uint64_t id;             /* ID */
 
@@ -302,8 +993,116 @@ struct ABTI_pool {
     ABT_pool_pop_fn                p_pop;
     ABT_pool_remove_fn             p_remove;
     ABT_pool_free_fn               p_free;
+
+    /* Optional batched versions of p_push and p_pop (NULL if absent) */
+    ABTI_pool_push_many_fn         p_push_many;
+    ABTI_pool_pop_many_fn          p_pop_many;
+    /* Optional push that fails on a full bounded pool (NULL if absent) */
+    ABTI_pool_try_push_fn          p_try_push;
+    /* Operation counters (NULL if not collected) */
+    ABTI_pool_stats               *p_stats;
+    /* Group whose bitmap tracks whether this pool is empty (NULL if none) */
+    ABTI_pool_group               *p_group;
+    uint64_t                       group_mask; /* Bit of this pool */
+
+    /* Counters updated atomically by any ES.  They are kept away from the
+     * read-mostly fields above, which are used for every push and pop. */
+    uint32_t num_blocked ABTI_CACHE_ALIGNED;    /* Number of blocked ULTs */
+    int32_t num_migrations;  /* Number of migrating ULTs */
+    uint32_t split_req;      /* Set while an idle ES waits for a split unit */
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    uint32_t num_parked;     /* Number of schedulers parked on this pool */
+    uint64_t parked_mask;    /* Ranks of them parked on doorbells */
+#endif
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    /* Histograms updated atomically by any ES (NULL if not collected) */
+    ABT_unit_stats *p_unit_stats;
+#endif
+};
+
+/* Data of ABT_POOL_FIFO, whose operations are in abti_pool.h */
+struct ABTI_pool_fifo_data {
+    ABTI_spinlock mutex;
+    size_t num_units;
+    ABTI_unit *p_head;
+    ABTI_unit *p_tail;
+    /* For ABT_POOL_ACCESS_PRIV, the units pushed by the ESs other than the
+     * owner and by external threads wait in the inbox, which is a stack, until
+     * the owner moves them to the list above. */
+    ABTI_xstream *p_owner;      /* ES that has popped from the pool last */
+    void *p_inbox ABTI_CACHE_ALIGNED; /* Unit pushed to the inbox last */
+    uint32_t num_inbox;         /* Number of units in the inbox */
+};
+
+/* Operation counters of a pool (ABT_POOL_STATS).  Each ES has a cache line
+ * of counters that only the ES updates.  The last line is shared, with atomic
+ * updates, by external threads and by ESs of larger ranks. */
+#define ABTI_POOL_STATS_PUSH            0   /* Units pushed */
+#define ABTI_POOL_STATS_POP             1   /* Units popped */
+#define ABTI_POOL_STATS_EMPTY_POP       2   /* Pops that found no unit */
+#define ABTI_POOL_STATS_LOCK_WAIT       3   /* Lock acquisitions that waited */
+#define ABTI_POOL_STATS_RESIZE          4   /* Growths of the storage */
+#define ABTI_POOL_STATS_STEAL_ATTEMPT   5   /* Steals tried */
+#define ABTI_POOL_STATS_STEAL           6   /* Steals that took a unit */
+#define ABTI_POOL_STATS_NUM             7
+#define ABTI_POOL_STATS_STRIDE          8   /* Counters per line */
+
+struct ABTI_pool_stats {
+    uint32_t num_lines;         /* Number of lines, including the shared one */
+    uint64_t *p_counts;         /* num_lines * ABTI_POOL_STATS_STRIDE */
 };
 
+/* Pools of a scheduler with a bitmap of the pools that may have units.  A
+ * push sets the bit of the pool, and the scheduler clears it when the pool is
+ * found empty, so it finds the first non-empty pool with one instruction. */
+#define ABTI_POOL_GROUP_MAX_POOLS       64
+
+/* Futex word on which a parked ES waits for the pushes to its pools.  A
+ * pusher rings it only if the ES has set its bit in parked_mask of the pool.
+ * ESs of larger ranks wait on park_seq of ABTI_global instead. */
+struct ABTI_doorbell {
+    uint32_t seq ABTI_CACHE_ALIGNED;
+};
+
+/* Callback of ABT_rcu_call(), which is called once every ES has passed a
+ * quiescent state in epoch or later */
+struct ABTI_rcu_cb {
+    void (*func)(void *);
+    void *arg;
+    uint64_t epoch;
+    ABTI_rcu_cb *p_next;
+};
+
+struct ABTI_pool_group {
+    uint64_t nonempty;          /* Bit i is set if pools[i] may have units */
+    uint32_t refcount;          /* Pools and schedulers using the group */
+    int num_pools;              /* Number of pools */
+    ABT_pool *pools;            /* Pools in the order of the bits */
+};
+
+struct ABTI_channel_waiter {
+    ABTI_thread *p_thread;      /* Blocked ULT, or NULL for external thread */
+    void *msg;                  /* Message to send or received message */
+    volatile int done;          /* Set when an external thread is woken up */
+    ABTI_channel_waiter *p_next;
+};
+
+struct ABTI_channel {
+    ABTI_spinlock lock;         /* Protects the fields below */
+    size_t capacity;            /* Number of slots of buf */
+    size_t head;                /* Slot of the oldest message */
+    size_t count;               /* Messages in buf */
+    void **buf;                 /* Ring buffer of messages */
+    uint32_t num_senders;       /* Blocked senders */
+    uint32_t num_receivers;     /* Blocked receivers */
+    ABTI_channel_waiter *p_send_head;   /* FIFO of blocked senders */
+    ABTI_channel_waiter *p_send_tail;
+    ABTI_channel_waiter *p_recv_head;   /* FIFO of blocked receivers */
+    ABTI_channel_waiter *p_recv_tail;
+};
+
+/* The links come first to match ABT_unit_links, which user pools with
+ * intrusive units use. */
 struct ABTI_unit {
     ABTI_unit *p_prev;
     ABTI_unit *p_next;
@@ -313,12 +1112,25 @@ struct ABTI_unit {
         ABT_task   task;
     };
     ABT_unit_type type;
+    int level;                  /* Level in ABT_POOL_PRIO */
 };
 
 struct ABTI_thread_attr {
     void *p_stack;                      /* Stack address */
     size_t stacksize;                   /* Stack size (in bytes) */
     ABT_bool userstack;                 /* User-provided stack? */
+    ABT_bool deferred_stack;            /* Stack bound at the first run? */
+    ABT_bool use_fpu;                   /* Uses FP or SIMD registers? */
+    ABT_bool vector_state;              /* Saves the whole vector state? */
+    ABT_bool preemptible;               /* Can be preempted? */
+    int priority;                       /* Priority in ABT_POOL_PRIO */
+    double deadline;                    /* Deadline in ABT_POOL_EDF */
+    ABT_bool work_first;                /* Runs before its creator goes on? */
+    int home;                           /* Rank of the home ES, or -1 */
+    ABT_bool reusable;                  /* Recycled by the freeing ES? */
+    ABTI_join_counter *p_join_counter;  /* Counted down at termination */
+    ABTI_gang *p_gang;                  /* Gang dispatched all at once */
+    int core_class;                     /* Preferred ABT_CORE_CLASS_* */
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     ABT_bool migratable;                /* Migratability */
     void (*f_cb)(ABT_thread, void *);   /* Callback function */
@@ -326,24 +1138,48 @@ struct ABTI_thread_attr {
 #endif
 };
 
+/* The fields are ordered by how often they are touched.  With fcontext, the
+ * first cache line holds what a context switch reads and writes, and the
+ * second one what pushes and pops to pools touch, so scheduling a ULT brings
+ * in two lines of its descriptor.  Fields used only when a ULT is created,
+ * blocked, joined, or freed follow them, and the attributes, the largest and
+ * coldest part, come last.  Allocators place ABTI_thread at a cache-line
+ * boundary when aligned allocation is enabled. */
 struct ABTI_thread {
+    /* Hot: context switches */
     ABTD_thread_context ctx;        /* Context */
-    ABTI_unit unit_def;             /* Internal unit definition */
     ABT_thread_state state;         /* State */
     uint32_t request;               /* Request */
     ABTI_xstream *p_last_xstream;   /* Last ES where it ran */
+
+    /* Hot: pushes and pops */
+    ABTI_unit unit_def;             /* Internal unit definition */
+    ABT_unit unit;                  /* Unit enclosing this thread */
+    ABTI_pool *p_pool;              /* Associated pool */
 #ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     ABTI_sched *is_sched;           /* If it is a scheduler, its ptr */
 #endif
-    ABT_unit unit;                  /* Unit enclosing this thread */
-    ABTI_pool *p_pool;              /* Associated pool */
-    uint32_t refcount;              /* Reference count */
+
+    /* Cold */
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    uint64_t push_ticks;            /* Last push to a pool (ABT_UNIT_STATS) */
+#endif
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    uint64_t cpu_ticks;             /* CPU time so far (ABT_CPU_TIME) */
+#endif
     ABTI_thread_type type;          /* Type */
-    ABTI_thread_req_arg *p_req_arg; /* Request argument */
+    uint32_t refcount;              /* Reference count */
+    uint32_t detach;                /* ABTI_DETACH_* */
     ABTI_spinlock lock;             /* Spinlock */
+    ABTI_thread_req_arg *p_req_arg; /* Request argument */
+    void *p_wait_obj;               /* Object that it is blocked on */
+    ABT_bool (*f_wait_unlink)(void *, ABTI_thread *); /* Unlink from it */
     ABTI_ktable *p_keytable;        /* ULT-specific data */
-    ABTI_thread_attr attr;          /* Attributes */
     ABT_thread_id id;               /* ID */
+#ifdef HAVE_VALGRIND_SUPPORT
+    unsigned int valgrind_id;       /* Valgrind ID of the stack */
+#endif
+    ABTI_thread_attr attr;          /* Attributes */
 };
 
 struct ABTI_thread_req_arg {
@@ -376,11 +1212,39 @@ struct ABTI_task {
     ABT_unit unit;             /* Unit enclosing this task */
     ABTI_unit unit_def;        /* Internal unit definition */
     uint32_t refcount;         /* Reference count */
+    uint32_t detach;           /* ABTI_DETACH_* */
     ABTI_ktable *p_keytable;   /* Tasklet-specific data */
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     ABT_bool migratable;       /* Migratability */
 #endif
     uint64_t id;               /* ID */
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    uint64_t push_ticks;       /* Last push to a pool (ABT_UNIT_STATS) */
+#endif
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    uint64_t cpu_ticks;        /* CPU time so far (ABT_CPU_TIME) */
+#endif
+};
+
+/* p_arg of a resumable tasklet, whose f_task is ABTI_task_run_resumable */
+struct ABTI_task_resumable {
+    int (*f_task)(int, void *);     /* Resumable task function */
+    void *p_arg;                    /* Argument for f_task */
+    int state;                      /* State passed to f_task */
+    int await_kind;                 /* ABTI_TASK_AWAIT_* */
+    union {
+        ABT_eventual eventual;
+        ABT_future future;
+    } await;                        /* Dependency to wait for */
+};
+
+/* Tasklets batched by ABT_task_create_batched, run as one tasklet */
+struct ABTI_task_batch {
+    ABTI_pool *p_pool;              /* Pool into which the batch is pushed */
+    void (*f_task)(void *);         /* Function of all the tasklets */
+    uint32_t num_tasks;             /* # of arguments in p_args */
+    uint64_t start_ticks;           /* When the first tasklet was batched */
+    void **p_args;                  /* Arguments, allocated with the batch */
 };
 
 struct ABTI_key {
@@ -391,15 +1255,22 @@ struct ABTI_key {
 };
 
 struct ABTI_ktelem {
-    ABTI_key *p_key;
+    ABTI_key *p_key;            /* NULL if the slot is empty */
     void *value;
-    struct ABTI_ktelem *p_next;
+    uint32_t next;              /* Next slot in the used list */
+    ABT_bool used;              /* TRUE: in the used list */
 };
 
+/* Slots are indexed by the key ID.  The initial slots are allocated together
+ * with the table, and the slot array is moved to the heap when a key with a
+ * larger ID is set.  The slots that have been set are linked so that the
+ * table is cleared in O(# of used keys).  A table whose slots are still
+ * inline is cached in ABTI_local when freed. */
 struct ABTI_ktable {
-    int size;                   /* size of the table */
-    int num;                    /* number of elements stored */
-    ABTI_ktelem **p_elems;      /* element array */
+    uint32_t size;              /* number of slots */
+    uint32_t used_head;         /* First used slot or ABTI_KTABLE_END */
+    ABTI_ktelem *p_elems;       /* slot array */
+    ABTI_ktable *p_next;        /* Next table in the cache of ABTI_local */
 };
 
 struct ABTI_cond {
@@ -410,31 +1281,53 @@ struct ABTI_cond {
     ABTI_unit *p_tail;          /* Tail of waiters */
 };
 
+struct ABTI_rwlock_slot {
+    uint32_t count;             /* Number of readers hashed to this slot */
+    char pad[ABT_CONFIG_CACHE_LINE_SIZE - sizeof(uint32_t)];
+};
+
 struct ABTI_rwlock {
     ABTI_mutex mutex;
     ABTI_cond  cond;
     size_t reader_count;
     int write_flag;
+    uint32_t num_slots;         /* Number of reader slots (0 if not biased) */
+    ABTI_rwlock_slot *p_slots;  /* Reader slots of a reader-biased rwlock */
+};
+
+struct ABTI_cont {
+    void (*f_cb)(void *);       /* Continuation function */
+    void *p_arg;                /* Continuation function argument */
+    ABT_pool pool;              /* Pool for the tasklet, or ABT_POOL_NULL */
+    ABTI_cont *p_next;
 };
 
 struct ABTI_eventual {
     ABTI_spinlock lock;
     ABT_bool ready;
+    ABT_bool is_ptr;            /* value is the pointer given to the set */
+    ABT_bool is_user_mem;       /* Placed in ABT_eventual_memory */
     void *value;
     int nbytes;
-    ABTI_unit *p_head;          /* Head of waiters */
-    ABTI_unit *p_tail;          /* Tail of waiters */
+    ABTI_unit *p_head;          /* Stack of waiters, updated atomically */
+    ABTI_unit *p_timed_head;    /* Timed waiters, protected by lock */
+    ABTI_cont *p_cont_head;     /* Head of continuations */
+    ABTI_cont *p_cont_tail;     /* Tail of continuations */
 };
 
 struct ABTI_future {
     ABTI_spinlock lock;
     ABT_bool ready;
-    uint32_t counter;
+    uint32_t counter;           /* Number of reserved compartments */
+    uint32_t num_stored;        /* Number of stored compartments */
     uint32_t compartments;
+    ABT_bool is_user_mem;       /* Placed in ABT_future_memory */
     void **array;
     void (*p_callback)(void **arg);
     ABTI_unit *p_head;          /* Head of waiters */
     ABTI_unit *p_tail;          /* Tail of waiters */
+    ABTI_cont *p_cont_head;     /* Head of continuations */
+    ABTI_cont *p_cont_tail;     /* Tail of continuations */
 };
 
 struct ABTI_barrier {
@@ -443,11 +1336,95 @@ struct ABTI_barrier {
     ABTI_thread **waiters;
     ABT_unit_type *waiter_type;
     ABTI_spinlock lock;
+    ABTI_barrier_tree *p_tree;  /* Arrival tree (NULL if centralized) */
+};
+
+/* Combining tree for barrier arrivals.  Each node counts the arrivals of the
+ * current round; a leaf takes up to radix waiters and an internal node takes
+ * its children.  The counters are never reset: round r is complete at a node
+ * once its counter reaches (r + 1) * capacity. */
+struct ABTI_barrier_tree_node {
+    uint64_t num_reserved ABTI_CACHE_ALIGNED;  /* Slots taken in a leaf */
+    uint64_t num_arrived;       /* Arrivals at this node */
+    uint64_t capacity;          /* Arrivals per round */
+    uint32_t first_slot;        /* Index of the first slot of a leaf */
+    ABTI_barrier_tree_node *p_parent;
+};
+
+struct ABTI_barrier_tree {
+    uint32_t num_waiters;
+    uint32_t radix;
+    uint32_t num_leaves;
+    uint32_t num_numa_nodes;
+    ABTI_barrier_tree_node *p_nodes;    /* Leaves first, the root last */
+    uint64_t round ABTI_CACHE_ALIGNED;  /* Number of completed rounds */
 };
 
 struct ABTI_timer {
-    ABTD_time start;
-    ABTD_time end;
+    uint64_t start;     /* Ticks of ABTD_time_get_ticks() */
+    uint64_t end;
+};
+
+struct ABTI_task_graph_node {
+    void (*f_task)(void *);     /* Tasklet function */
+    void *p_arg;                /* Tasklet function argument */
+    ABTI_task_graph *p_graph;   /* Graph that the node belongs to */
+    uint32_t num_preds;         /* Number of predecessors */
+    uint32_t num_pending;       /* Predecessors not completed yet */
+    int num_succs;              /* Number of successors */
+    int max_succs;              /* Capacity of p_succs */
+    int *p_succs;               /* IDs of successors */
+};
+
+struct ABTI_task_graph {
+    int num_nodes;                  /* Number of nodes */
+    int max_nodes;                  /* Capacity of p_nodes */
+    ABTI_task_graph_node *p_nodes;  /* Nodes */
+    ABT_bool running;               /* Is the graph running? */
+    ABT_pool pool;                  /* Pool for the first nodes */
+    uint32_t num_remains;           /* Nodes not completed yet */
+    ABT_eventual eventual;          /* Set when all the nodes complete */
+};
+
+struct ABTI_wait_group {
+    uint64_t state;             /* Count and ABTI_WAIT_GROUP_WAITER */
+    ABTI_thread *p_waiter;      /* Valid while ABTI_WAIT_GROUP_WAITER is set */
+};
+
+struct ABTI_join_counter {
+    ABTI_wait_group wg;         /* Counts ULTs not terminated yet */
+};
+
+struct ABTI_sem {
+    int32_t value;              /* Permits, or minus the number of waiters */
+    ABTI_spinlock lock;         /* Protects the fields below */
+    uint32_t num_pending;       /* Permits passed to waiters not queued yet */
+    ABTI_unit *p_head;          /* FIFO of waiters linked by p_next */
+    ABTI_unit *p_tail;
+};
+
+struct ABTI_gang {
+    uint32_t num_members;       /* Members dispatched at once */
+    uint64_t state;             /* Round in the upper half, arrivals below */
+    uint64_t num_dispatches;    /* Rounds in which the gang was dispatched */
+    uint64_t num_backoffs;      /* Arrivals that gave up waiting */
+};
+
+/* A work unit submitted after a delay, and periodically if period is not
+ * zero.  The timeout is in the timer wheel of an ES while it is armed. */
+struct ABTI_delayed {
+    ABTI_timeout timeout;       /* Entry in the timer wheel */
+    ABTI_pool *p_pool;          /* Pool into which the unit is pushed */
+    ABT_unit_type type;         /* ABT_UNIT_TYPE_THREAD or _TASK */
+    void (*f_func)(void *);     /* Function of the work unit */
+    void *p_arg;                /* Argument for f_func */
+    ABTI_thread_attr *p_attr;   /* Attribute of ULTs, or NULL */
+    double period;              /* Period in seconds, or zero if run once */
+    uint32_t refcount;          /* Handle, armed timeout and pending run */
+    uint32_t canceled;          /* Set by ABT_delayed_cancel() */
+    uint32_t pending;           /* A submitted run has not finished */
+    uint64_t num_runs;          /* Runs submitted */
+    uint64_t num_coalesced;     /* Runs merged into others */
 };
 
 
@@ -498,18 +1475,44 @@ int ABTI_xstream_schedule_thread(ABTI_xstream *p_xstream,
                                  ABTI_thread *p_thread);
 void ABTI_xstream_schedule_task(ABTI_xstream *p_xstream, ABTI_task *p_task);
 int ABTI_xstream_migrate_thread(ABTI_thread *p_thread);
+ABTI_xstream *ABTI_xstream_find_pool_owner(ABT_pool pool);
+int ABTI_xstream_get_numa_node(ABTI_xstream *p_xstream);
+void ABTI_xstream_update_core_class(ABTI_xstream *p_xstream);
 int ABTI_xstream_set_main_sched(ABTI_xstream *p_xstream, ABTI_sched *p_sched);
 int ABTI_xstream_check_events(ABTI_xstream *p_xstream, ABT_sched sched);
 void *ABTI_xstream_launch_main_sched(void *p_arg);
+void ABTI_xstream_start_preempt(ABTI_xstream *p_xstream);
+void ABTI_xstream_stop_preempt(ABTI_xstream *p_xstream);
+void ABTI_xstream_start_os_priority(ABTI_xstream *p_xstream);
+void ABTI_xstream_stop_os_priority(ABTI_xstream *p_xstream);
+void ABTI_xstream_check_preempt(void);
+void ABTI_xstream_run_poll_hooks(ABTI_xstream *p_xstream);
 void ABTI_xstream_reset_rank(void);
 void ABTI_xstream_free_ranks(void);
+void ABTI_xstream_free_parked(void);
+
+/* Offload */
+void ABTI_offload_init(ABTI_offload *p_offload);
+void ABTI_offload_finalize(ABTI_offload *p_offload);
+
+/* Completion source */
+void ABTI_completion_init(void);
+void ABTI_completion_finalize(void);
+void ABTI_completion_poll(void);
 void ABTI_xstream_print(ABTI_xstream *p_xstream, FILE *p_os, int indent,
                         ABT_bool print_sub);
+void ABTI_xstream_print_snapshot(ABTI_xstream *p_xstream,
+                                 ABTI_xstream_snapshot *p_snap, FILE *p_os,
+                                 int indent);
 
 /* Scheduler */
 ABT_sched_def *ABTI_sched_get_basic_def(void);
 ABT_sched_def *ABTI_sched_get_prio_def(void);
 ABT_sched_def *ABTI_sched_get_randws_def(void);
+ABT_sched_def *ABTI_sched_get_localws_def(void);
+ABT_sched_def *ABTI_sched_get_hier_def(void);
+ABT_sched_def *ABTI_sched_get_fair_def(void);
+ABT_sched_def *ABTI_sched_get_edf_def(void);
 int ABTI_sched_free(ABTI_sched *p_sched);
 int ABTI_sched_get_migration_pool(ABTI_sched *, ABTI_pool *, ABTI_pool **);
 ABTI_sched_kind ABTI_sched_get_kind(ABT_sched_def *def);
@@ -517,9 +1520,14 @@ ABT_bool ABTI_sched_has_to_stop(ABTI_sched *p_sched, ABTI_xstream *p_xstream);
 size_t ABTI_sched_get_size(ABTI_sched *p_sched);
 size_t ABTI_sched_get_total_size(ABTI_sched *p_sched);
 size_t ABTI_sched_get_effective_size(ABTI_sched *p_sched);
+ABT_bool ABTI_sched_is_quiescent(ABTI_sched *p_sched, ABTI_xstream *p_xstream);
+ABT_bool ABTI_sched_run_polling(ABTI_sched *p_sched, ABTI_xstream *p_xstream);
 void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
                       ABT_bool print_sub);
 void ABTI_sched_reset_id(void);
+void ABTI_sched_tune_init(ABTI_sched *p_sched);
+void ABTI_sched_tune_update(ABTI_sched *p_sched, ABTI_xstream *p_xstream,
+                            double start, double end);
 
 /* Scheduler config */
 size_t ABTI_sched_config_type_size(ABT_sched_config_type type);
@@ -530,6 +1538,22 @@ int ABTI_sched_config_read_global(ABT_sched_config config,
 
 /* Pool */
 int ABTI_pool_get_fifo_def(ABT_pool_access access, ABT_pool_def *p_def);
+int ABTI_pool_get_fifo_lockfree_def(ABT_pool_access access,
+                                    ABT_pool_def *p_def);
+void ABTI_pool_set_fifo_many_fns(ABTI_pool *p_pool);
+void ABTI_pool_set_deque_many_fns(ABTI_pool *p_pool);
+ABT_unit ABTI_pool_deque_peek(ABTI_pool *p_pool);
+extern ABT_pool_def ABTI_pool_deque;
+int ABTI_pool_get_prio_def(ABT_pool_access access, ABT_pool_def *p_def);
+int ABTI_pool_get_edf_def(ABT_pool_access access, ABT_pool_def *p_def);
+void ABTI_pool_prio_set_priority(ABTI_pool *p_pool, ABTI_thread *p_thread,
+                                 int priority);
+ABT_bool ABTI_pool_is_prio(ABTI_pool *p_pool);
+ABT_bool ABTI_pool_is_edf(ABTI_pool *p_pool);
+double ABTI_pool_edf_get_deadline(ABTI_pool *p_pool);
+int ABTI_pool_get_ring_def(ABT_pool_access access, ABT_pool_def *p_def);
+void ABTI_pool_set_ring_fns(ABTI_pool *p_pool);
+int ABTI_pool_get_multiq_def(ABT_pool_access access, ABT_pool_def *p_def);
 #ifndef ABT_CONFIG_DISABLE_POOL_CONSUMER_CHECK
 int ABTI_pool_set_consumer(ABTI_pool *p_pool, ABTI_xstream *p_xstream);
 #endif
@@ -546,12 +1570,18 @@ int   ABTI_thread_create_main(ABTI_xstream *p_xstream, ABTI_thread **p_thread);
 int   ABTI_thread_create_main_sched(ABTI_xstream *p_xstream, ABTI_sched *p_sched);
 int   ABTI_thread_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched);
 void  ABTI_thread_free(ABTI_thread *p_thread);
+void  ABTI_thread_free_reusable(ABTI_local *p_local);
 void  ABTI_thread_free_main(ABTI_thread *p_thread);
 void  ABTI_thread_free_main_sched(ABTI_thread *p_thread);
 int   ABTI_thread_set_blocked(ABTI_thread *p_thread);
 void  ABTI_thread_suspend(ABTI_thread *p_thread);
 int   ABTI_thread_set_ready(ABTI_thread *p_thread);
+int   ABTI_thread_set_ready_list(ABTI_unit *p_head);
+ABT_bool ABTI_thread_handoff(ABTI_thread *p_thread);
 void  ABTI_thread_print(ABTI_thread *p_thread, FILE *p_os, int indent);
+#if defined(ABT_CONFIG_USE_MEM_POOL) && defined(ABT_CONFIG_USE_FCONTEXT)
+void  ABTI_thread_bind_stack(ABTI_thread *p_thread);
+#endif
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
 void  ABTI_thread_add_req_arg(ABTI_thread *p_thread, uint32_t req, void *arg);
 void *ABTI_thread_extract_req_arg(ABTI_thread *p_thread, uint32_t req);
@@ -587,6 +1617,8 @@ ABTI_thread *ABTI_thread_htable_pop_low(ABTI_thread_htable *p_htable,
 ABT_bool ABTI_thread_htable_switch_low(ABTI_thread_queue *p_queue,
                                        ABTI_thread *p_thread,
                                        ABTI_thread_htable *p_htable);
+ABT_bool ABTI_thread_htable_remove(ABTI_thread_htable *p_htable,
+                                   ABTI_thread *p_thread);
 
 /* Tasklet */
 int ABTI_task_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched);
@@ -596,16 +1628,158 @@ void ABTI_task_retain(ABTI_task *p_task);
 void ABTI_task_release(ABTI_task *p_task);
 void ABTI_task_reset_id(void);
 uint64_t ABTI_task_get_id(ABTI_task *p_task);
+void ABTI_task_run_resumable(void *arg);
+void ABTI_task_suspend_resumable(ABTI_task *p_task);
+void ABTI_task_flush_batch(ABTI_local *p_local);
 
 /* Key */
-ABTI_ktable *ABTI_ktable_alloc(int size);
+ABTI_ktable *ABTI_ktable_alloc(uint32_t size);
 void ABTI_ktable_free(ABTI_ktable *p_ktable);
+void ABTI_ktable_clear(ABTI_ktable *p_ktable);
+void ABTI_ktable_free_cached(ABTI_local *p_local);
 
 /* Mutex */
 void ABTI_mutex_wait(ABTI_mutex *p_mutex, int val);
 void ABTI_mutex_wait_low(ABTI_mutex *p_mutex, int val);
 void ABTI_mutex_wake_se(ABTI_mutex *p_mutex, int num);
 void ABTI_mutex_wake_de(ABTI_mutex *p_mutex);
+ABT_bool ABTI_mutex_unlink_waiter(void *p_obj, ABTI_thread *p_thread);
+
+/* Condition variable */
+ABT_bool ABTI_cond_unlink_waiter(void *p_obj, ABTI_thread *p_thread);
+
+/* Eventual */
+ABT_bool ABTI_eventual_unlink_waiter(void *p_obj, ABTI_thread *p_thread);
+void ABTI_eventual_free_cached(ABTI_local *p_local);
+
+/* Future */
+void ABTI_future_free_cached(ABTI_local *p_local);
+
+/* Gang */
+ABT_bool ABTI_gang_dispatch(ABTI_gang *p_gang);
+
+/* Timed waits */
+void ABTI_timer_wheel_init(ABTI_timer_wheel *p_wheel);
+void ABTI_timer_wheel_fini(ABTI_timer_wheel *p_wheel);
+void ABTI_timer_wheel_expire(ABTI_timer_wheel *p_wheel);
+void ABTI_timeout_prepare(ABTI_timeout *p_timeout, double deadline);
+ABT_bool ABTI_timeout_start(ABTI_timeout *p_timeout, ABTI_timer_wheel *p_wheel,
+                            double deadline,
+                            void (*f_expire)(ABTI_timeout *));
+ABT_bool ABTI_timeout_stop(ABTI_timeout *p_timeout);
+ABT_bool ABTI_timeout_wait(ABTI_timeout *p_timeout);
+ABT_bool ABTI_timeout_signal(ABTI_timeout *p_timeout);
+ABT_bool ABTI_timeout_cancel(ABTI_timeout *p_timeout);
+void ABTI_thread_sleep(double deadline);
+
+/* I/O waits */
+void ABTI_io_poller_init(ABTI_io_poller *p_poller);
+void ABTI_io_poller_fini(ABTI_io_poller *p_poller);
+void ABTI_io_poller_poll(ABTI_io_poller *p_poller);
+
+/* MPI */
+void ABTI_mpi_poller_init(ABTI_mpi_poller *p_poller);
+void ABTI_mpi_poller_fini(ABTI_mpi_poller *p_poller);
+void ABTI_mpi_poller_poll(ABTI_mpi_poller *p_poller);
+
+/* Remote tasklets */
+ABT_bool ABTI_remote_ring_pop(void *ring, ABT_remote_desc *desc);
+
+/* Units embedded in work units */
+ABT_unit_type ABTI_unit_get_type(ABT_unit unit);
+ABT_thread ABTI_unit_get_thread(ABT_unit unit);
+ABT_task ABTI_unit_get_task(ABT_unit unit);
+ABT_bool ABTI_unit_is_in_pool(ABT_unit unit);
+ABT_unit ABTI_unit_create_from_thread(ABT_thread thread);
+ABT_unit ABTI_unit_create_from_task(ABT_task task);
+void ABTI_unit_free(ABT_unit *unit);
+
+/* Pool statistics */
+ABTI_pool_stats *ABTI_pool_stats_create(void);
+void ABTI_pool_stats_free(ABTI_pool_stats *p_stats);
+void ABTI_pool_stats_reset(ABTI_pool_stats *p_stats);
+void ABTI_pool_stats_get(ABTI_pool_stats *p_stats, int rank,
+                         ABT_pool_stats *p_out);
+void ABTI_pool_stats_print(ABTI_pool_stats *p_stats, FILE *p_os,
+                           const char *prefix);
+
+/* Pool groups */
+ABTI_pool_group *ABTI_pool_group_get(int num_pools, ABT_pool *pools);
+void ABTI_pool_group_release(ABTI_pool_group *p_group);
+
+/* Unit statistics */
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+ABT_unit_stats *ABTI_unit_stats_create(void);
+void ABTI_unit_stats_reset(ABT_unit_stats *p_stats);
+void ABTI_unit_stats_stamp(ABTI_pool *p_pool, ABT_unit unit);
+void ABTI_unit_stats_add_delay(ABTI_xstream *p_xstream, ABTI_pool *p_pool,
+                               uint64_t push_ticks);
+void ABTI_unit_stats_add_run(ABTI_xstream *p_xstream, ABTI_pool *p_pool,
+                             uint64_t start_ticks);
+void ABTI_unit_stats_print(ABT_unit_stats *p_stats, FILE *p_os,
+                           const char *prefix);
+#endif
+void ABTI_histogram_reset(ABT_histogram *p_hist);
+void ABTI_histogram_add_atomic(ABT_histogram *p_hist, uint64_t value);
+void ABTI_histogram_print(ABT_histogram *p_hist, FILE *p_os,
+                          const char *prefix, const char *name,
+                          const char *unit);
+
+/* Profile */
+void ABTI_profile_init(void);
+void ABTI_profile_finalize(void);
+void ABTI_profile_xstream_init(ABTI_xstream *p_xstream);
+void ABTI_profile_start(ABTI_xstream *p_xstream);
+void ABTI_profile_stop(ABTI_xstream *p_xstream);
+void ABTI_profile_sample(void);
+void ABTI_profile_print(FILE *p_os);
+void ABTI_profile_print_func(FILE *p_os, uint64_t func);
+
+/* Record and replay of schedules */
+void ABTI_record_init(void);
+void ABTI_record_finalize(void);
+void ABTI_record_xstream_init(ABTI_xstream *p_xstream);
+void ABTI_record_add(ABTI_xstream *p_xstream, ABTI_pool *p_pool,
+                     uint64_t unit, ABTI_pool *p_home);
+ABT_bool ABTI_record_replay(ABTI_xstream *p_xstream, ABTI_sched *p_sched,
+                            int *p_run_cnt);
+
+/* RCU */
+void ABTI_rcu_init(void);
+void ABTI_rcu_finalize(void);
+void ABTI_rcu_xstream_start(ABTI_xstream *p_xstream);
+void ABTI_rcu_xstream_stop(ABTI_xstream *p_xstream);
+void ABTI_rcu_xstream_park(ABTI_xstream *p_xstream);
+void ABTI_rcu_process(ABTI_xstream *p_xstream);
+
+/* Stack usage */
+void ABTI_stack_usage_init(void);
+void ABTI_stack_usage_finalize(void);
+void ABTI_stack_usage_record(ABTI_thread *p_thread);
+
+/* Lock profile */
+void ABTI_lock_profile_finalize(void);
+
+/* CPU time */
+void ABTI_cpu_time_init(void);
+void ABTI_cpu_time_finalize(void);
+void ABTI_cpu_time_add(uint64_t func, uint64_t ticks);
+
+/* Trace */
+void ABTI_trace_init(void);
+void ABTI_trace_finalize(void);
+void ABTI_trace_xstream_init(ABTI_xstream *p_xstream);
+void ABTI_trace_print(FILE *p_os);
+void ABTI_trace_print_binary(FILE *p_os);
+
+/* Barrier */
+ABTI_barrier_tree *ABTI_barrier_tree_create(uint32_t num_waiters,
+                                            uint32_t radix);
+void ABTI_barrier_tree_free(ABTI_barrier_tree *p_tree);
+
+/* Wait Group */
+int  ABTI_wait_group_wait(ABTI_wait_group *p_wg);
+void ABTI_wait_group_wake(ABTI_wait_group *p_wg, ABTI_thread *p_thread);
 
 /* Mutex Attributes */
 void ABTI_mutex_attr_print(ABTI_mutex_attr *p_attr, FILE *p_os, int indent);
@@ -617,6 +1791,7 @@ void ABTI_event_finalize(void);
 #ifdef ABT_CONFIG_HANDLE_POWER_EVENT
 void ABTI_event_connect_power(char *p_host, int port);
 void ABTI_event_disconnect_power(void);
+void ABTI_event_map_power(char *p_path);
 ABT_bool ABTI_event_check_power(void);
 #endif
 #ifdef ABT_CONFIG_PUBLISH_INFO
@@ -628,14 +1803,32 @@ void ABTI_event_publish_info(void);
 #include "abti_event.h"
 #include "abti_local.h"
 #include "abti_global.h"
+#include "abti_trace.h"
+#include "abti_record.h"
+#include "abti_unit_stats.h"
+#include "abti_cpu_time.h"
+#include "abti_pool_stats.h"
 #include "abti_pool.h"
+#include "abti_pool_group.h"
 #include "abti_sched.h"
 #include "abti_config.h"
+#include "abti_wait_group.h"
+#include "abti_sem.h"
+#include "abti_channel.h"
+#include "abti_completion.h"
+#include "abti_join_counter.h"
+#include "abti_rcu.h"
+#include "abti_gang.h"
+#include "abti_delayed.h"
 #include "abti_stream.h"
 #include "abti_self.h"
 #include "abti_thread.h"
 #include "abti_thread_attr.h"
 #include "abti_task.h"
+#include "abti_unit.h"
+#include "abti_timeout.h"
+#include "abti_io.h"
+#include "abti_mpi.h"
 #include "abti_key.h"
 #include "abti_mutex.h"
 #include "abti_mutex_attr.h"
@@ -645,6 +1838,7 @@ void ABTI_event_publish_info(void);
 #include "abti_future.h"
 #include "abti_barrier.h"
 #include "abti_timer.h"
+#include "abti_task_graph.h"
 #include "abti_mem.h"
 
 #endif /* ABTI_H_INCLUDED */
@@ -41,5 +41,95 @@ ABT_barrier ABTI_barrier_get_handle(ABTI_barrier *p_barrier)
 #endif
 }
 
+/* Barrier arrival tree */
+#define ABTI_BARRIER_TREE_DEFAULT_RADIX 4
+
+/* Select the first leaf to try.  The leaves are divided among NUMA nodes, and
+ * the ESs on a node start from consecutive leaves of its share, so arrivals
+ * from the same node are combined in the same subtree as far as possible. */
+static inline
+uint32_t ABTI_barrier_tree_get_hint(ABTI_barrier_tree *p_tree)
+{
+    uint32_t num_leaves = p_tree->num_leaves;
+    uint32_t num_nodes = p_tree->num_numa_nodes;
+    uint32_t per_node, node, rank = 0;
+
+    if (num_leaves == 1) return 0;
+    if (lp_ABTI_local != NULL && ABTI_local_get_xstream() != NULL) {
+        rank = (uint32_t)ABTI_local_get_xstream()->rank;
+    }
+    node = (num_nodes > 1) ? (uint32_t)ABTD_affinity_get_node() % num_nodes
+                           : 0;
+    per_node = num_leaves / num_nodes;
+    if (per_node == 0) per_node = 1;
+    return (node * per_node + rank % per_node) % num_leaves;
+}
+
+/* Take a slot in a leaf for the round that has not completed yet.  The round
+ * is returned through p_round and the leaf through pp_leaf. */
+static inline
+uint32_t ABTI_barrier_tree_reserve(ABTI_barrier_tree *p_tree,
+                                   uint64_t *p_round,
+                                   ABTI_barrier_tree_node **pp_leaf)
+{
+    uint32_t leaf = ABTI_barrier_tree_get_hint(p_tree);
+
+    while (1) {
+        ABTI_barrier_tree_node *p_node = &p_tree->p_nodes[leaf];
+        /* The round has to be read for each leaf since the previous round
+         * may complete while this waiter is looking for a slot. */
+        uint64_t round = *(volatile uint64_t *)&p_tree->round;
+        uint64_t limit = (round + 1) * p_node->capacity;
+        uint64_t cur = *(volatile uint64_t *)&p_node->num_reserved;
+
+        while (cur < limit) {
+            uint64_t old = ABTD_atomic_cas_uint64(&p_node->num_reserved,
+                                                  cur, cur + 1);
+            if (old == cur) {
+                *p_round = round;
+                *pp_leaf = p_node;
+                return p_node->first_slot
+                       + (uint32_t)(cur - round * p_node->capacity);
+            }
+            cur = old;
+        }
+
+        /* This leaf is full in this round.  Try the next one. */
+        leaf = (leaf + 1 == p_tree->num_leaves) ? 0 : leaf + 1;
+    }
+}
+
+/* Count the arrival from the leaf up to the root.  Returns ABT_TRUE if the
+ * caller is the last one to arrive in this round. */
+static inline
+ABT_bool ABTI_barrier_tree_arrive(ABTI_barrier_tree_node *p_node,
+                                  uint64_t round)
+{
+    while (p_node) {
+        uint64_t target = (round + 1) * p_node->capacity;
+        if (ABTD_atomic_fetch_add_uint64(&p_node->num_arrived, 1) + 1
+            != target) {
+            return ABT_FALSE;
+        }
+        p_node = p_node->p_parent;
+    }
+    return ABT_TRUE;
+}
+
+static inline
+void ABTI_barrier_tree_release(ABTI_barrier_tree *p_tree, uint64_t round)
+{
+    ABTD_atomic_mem_barrier();
+    *(volatile uint64_t *)&p_tree->round = round + 1;
+}
+
+static inline
+ABT_bool ABTI_barrier_tree_is_released(ABTI_barrier_tree *p_tree,
+                                       uint64_t round)
+{
+    return (*(volatile uint64_t *)&p_tree->round != round)
+           ? ABT_TRUE : ABT_FALSE;
+}
+
 #endif /* BARRIER_H_INCLUDED */
 
@@ -0,0 +1,43 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef CHANNEL_H_INCLUDED
+#define CHANNEL_H_INCLUDED
+
+/* Inlined functions for Channel */
+
+static inline
+ABTI_channel *ABTI_channel_get_ptr(ABT_channel channel)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_channel *p_channel;
+    if (channel == ABT_CHANNEL_NULL) {
+        p_channel = NULL;
+    } else {
+        p_channel = (ABTI_channel *)channel;
+    }
+    return p_channel;
+#else
+    return (ABTI_channel *)channel;
+#endif
+}
+
+static inline
+ABT_channel ABTI_channel_get_handle(ABTI_channel *p_channel)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_channel h_channel;
+    if (p_channel == NULL) {
+        h_channel = ABT_CHANNEL_NULL;
+    } else {
+        h_channel = (ABT_channel)p_channel;
+    }
+    return h_channel;
+#else
+    return (ABT_channel)p_channel;
+#endif
+}
+
+#endif /* CHANNEL_H_INCLUDED */
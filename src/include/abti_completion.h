@@ -0,0 +1,54 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef COMPLETION_H_INCLUDED
+#define COMPLETION_H_INCLUDED
+
+/* Inlined functions for Completion source */
+
+static inline
+ABTI_completion_source *
+ABTI_completion_source_get_ptr(ABT_completion_source source)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_completion_source *p_source;
+    if (source == ABT_COMPLETION_SOURCE_NULL) {
+        p_source = NULL;
+    } else {
+        p_source = (ABTI_completion_source *)source;
+    }
+    return p_source;
+#else
+    return (ABTI_completion_source *)source;
+#endif
+}
+
+static inline
+ABT_completion_source
+ABTI_completion_source_get_handle(ABTI_completion_source *p_source)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_completion_source h_source;
+    if (p_source == NULL) {
+        h_source = ABT_COMPLETION_SOURCE_NULL;
+    } else {
+        h_source = (ABT_completion_source)p_source;
+    }
+    return h_source;
+#else
+    return (ABT_completion_source)p_source;
+#endif
+}
+
+/* Called by the schedulers through ABTI_xstream_check_events() */
+static inline
+void ABTI_completion_check(void)
+{
+    if (*(volatile uint32_t *)&gp_ABTI_global->num_completion_waiters > 0) {
+        ABTI_completion_poll();
+    }
+}
+
+#endif /* COMPLETION_H_INCLUDED */
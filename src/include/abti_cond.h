@@ -71,7 +71,7 @@ int ABTI_cond_wait(ABTI_cond *p_cond, ABTI_mutex *p_mutex)
     ABTI_thread *p_thread;
     ABTI_unit *p_unit;
     ABT_unit_type type;
-    volatile int ext_signal = 0;
+    uint32_t ext_signal = ABTD_FUTEX_SIGNAL_INIT;
 
     if (lp_ABTI_local != NULL) {
         p_thread = ABTI_local_get_thread();
@@ -81,6 +81,7 @@ int ABTI_cond_wait(ABTI_cond *p_cond, ABTI_mutex *p_mutex)
         p_unit = &p_thread->unit_def;
         p_unit->thread = ABTI_thread_get_handle(p_thread);
         p_unit->type = type;
+        ABTI_thread_set_wait_obj(p_thread, p_cond, ABTI_cond_unlink_waiter);
     } else {
         /* external thread */
         type = ABT_UNIT_TYPE_EXT;
@@ -97,6 +98,9 @@ int ABTI_cond_wait(ABTI_cond *p_cond, ABTI_mutex *p_mutex)
         ABT_bool result = ABTI_mutex_equal(p_cond->p_waiter_mutex, p_mutex);
         if (result == ABT_FALSE) {
             ABTI_spinlock_release(&p_cond->lock);
+            if (type == ABT_UNIT_TYPE_THREAD) {
+                ABTI_thread_unset_wait_obj(p_thread);
+            }
             abt_errno = ABT_ERR_INV_MUTEX;
             goto fn_fail;
         }
@@ -129,15 +133,14 @@ int ABTI_cond_wait(ABTI_cond *p_cond, ABTI_mutex *p_mutex)
 
         /* Suspend the current ULT */
         ABTI_thread_suspend(p_thread);
+        ABTI_thread_unset_wait_obj(p_thread);
 
     } else { /* TYPE == ABT_UNIT_TYPE_EXT */
         ABTI_spinlock_release(&p_cond->lock);
         ABTI_mutex_unlock(p_mutex);
 
-        /* External thread is waiting here polling ext_signal. */
-        /* FIXME: need a better implementation */
-        while (!ext_signal) {
-        }
+        /* External thread is waiting here for ext_signal. */
+        ABTD_futex_signal_wait(&ext_signal);
         ABTU_free(p_unit);
     }
 
@@ -155,6 +158,8 @@ int ABTI_cond_wait(ABTI_cond *p_cond, ABTI_mutex *p_mutex)
 static inline
 void ABTI_cond_broadcast(ABTI_cond *p_cond)
 {
+    ABTI_unit *p_threads = NULL;
+
     ABTI_spinlock_acquire(&p_cond->lock);
 
     if (p_cond->num_waiters == 0) {
@@ -162,7 +167,10 @@ void ABTI_cond_broadcast(ABTI_cond *p_cond)
         return;
     }
 
-    /* Wake up all waiting ULTs */
+    /* Detach all the waiters.  External threads and timed waiters are
+     * signaled here since they may leave and free their units as soon as the
+     * lock is released, while blocked ULTs are chained to be woken up in
+     * batches after the lock is released. */
     ABTI_unit *p_head = p_cond->p_head;
     ABTI_unit *p_unit = p_head;
     while (1) {
@@ -172,12 +180,13 @@ void ABTI_cond_broadcast(ABTI_cond *p_cond)
         p_unit->p_next = NULL;
 
         if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
-            ABTI_thread *p_thread = ABTI_thread_get_ptr(p_unit->thread);
-            ABTI_thread_set_ready(p_thread);
+            p_unit->p_next = p_threads;
+            p_threads = p_unit;
+        } else if (p_unit->type == ABTI_UNIT_TYPE_TIMED) {
+            ABTI_timeout_signal((ABTI_timeout *)p_unit->pool);
         } else {
             /* When the head is an external thread */
-            volatile int *p_ext_signal = (volatile int *)p_unit->pool;
-            *p_ext_signal = 1;
+            ABTD_futex_signal_set((uint32_t *)p_unit->pool);
         }
 
         /* Next ULT */
@@ -194,6 +203,9 @@ void ABTI_cond_broadcast(ABTI_cond *p_cond)
     p_cond->p_tail = NULL;
 
     ABTI_spinlock_release(&p_cond->lock);
+
+    /* Wake up all waiting ULTs */
+    ABTI_thread_set_ready_list(p_threads);
 }
 
 #endif /* COND_H_INCLUDED */
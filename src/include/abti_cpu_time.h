@@ -0,0 +1,82 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef CPU_TIME_H_INCLUDED
+#define CPU_TIME_H_INCLUDED
+
+/* Inlined functions for the CPU time of work units (see cpu_time.c).  Each ES
+ * keeps the ticks of its last switch, and a unit that stops running on it is
+ * charged the ticks since then.  They cost a flag check if ABT_CPU_TIME is
+ * not set, and nothing if Argobots is configured with
+ * --enable-feature=no-cpu-time. */
+
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+
+/* Ticks elapsed on p_xstream since its last switch.  The clock of p_xstream
+ * is restarted for the unit that runs next. */
+static inline
+uint64_t ABTI_cpu_time_lap(ABTI_xstream *p_xstream)
+{
+    uint64_t now = ABTD_time_get_ticks();
+    uint64_t last = p_xstream->cpu_time_ticks;
+
+    p_xstream->cpu_time_ticks = now;
+    return (last != 0 && now > last) ? now - last : 0;
+}
+
+/* p_xstream is about to switch to a unit */
+static inline
+void ABTI_cpu_time_start(ABTI_xstream *p_xstream)
+{
+    if (gp_ABTI_global->use_cpu_time == ABT_FALSE) return;
+    p_xstream->cpu_time_ticks = ABTD_time_get_ticks();
+}
+
+/* p_thread has stopped running on p_xstream, or it switches to another ULT */
+static inline
+void ABTI_cpu_time_stop_thread(ABTI_xstream *p_xstream, ABTI_thread *p_thread)
+{
+    if (gp_ABTI_global->use_cpu_time == ABT_FALSE) return;
+    p_thread->cpu_ticks += ABTI_cpu_time_lap(p_xstream);
+}
+
+static inline
+void ABTI_cpu_time_stop_task(ABTI_xstream *p_xstream, ABTI_task *p_task)
+{
+    if (gp_ABTI_global->use_cpu_time == ABT_FALSE) return;
+    p_task->cpu_ticks += ABTI_cpu_time_lap(p_xstream);
+}
+
+/* p_thread, which is running, is terminating.  Its CPU time is added to the
+ * sum of its function. */
+static inline
+void ABTI_cpu_time_terminate_thread(ABTI_thread *p_thread)
+{
+    if (gp_ABTI_global->use_cpu_time == ABT_FALSE) return;
+    p_thread->cpu_ticks += ABTI_cpu_time_lap(p_thread->p_last_xstream);
+    if (p_thread->type != ABTI_THREAD_TYPE_USER) return;
+    ABTI_cpu_time_add(
+        (uint64_t)(uintptr_t)ABTD_thread_context_get_func(&p_thread->ctx),
+        p_thread->cpu_ticks);
+}
+
+static inline
+void ABTI_cpu_time_terminate_task(ABTI_task *p_task)
+{
+    if (gp_ABTI_global->use_cpu_time == ABT_FALSE) return;
+    ABTI_cpu_time_add((uint64_t)(uintptr_t)p_task->f_task, p_task->cpu_ticks);
+}
+
+#else /* ABT_CONFIG_DISABLE_CPU_TIME */
+
+#define ABTI_cpu_time_start(p_xstream)
+#define ABTI_cpu_time_stop_thread(p_xstream, p_thread)
+#define ABTI_cpu_time_stop_task(p_xstream, p_task)
+#define ABTI_cpu_time_terminate_thread(p_thread)
+#define ABTI_cpu_time_terminate_task(p_task)
+
+#endif /* ABT_CONFIG_DISABLE_CPU_TIME */
+
+#endif /* CPU_TIME_H_INCLUDED */
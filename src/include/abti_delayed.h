@@ -0,0 +1,43 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef DELAYED_H_INCLUDED
+#define DELAYED_H_INCLUDED
+
+/* Inlined functions for Delayed work unit */
+
+static inline
+ABTI_delayed *ABTI_delayed_get_ptr(ABT_delayed delayed)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_delayed *p_delayed;
+    if (delayed == ABT_DELAYED_NULL) {
+        p_delayed = NULL;
+    } else {
+        p_delayed = (ABTI_delayed *)delayed;
+    }
+    return p_delayed;
+#else
+    return (ABTI_delayed *)delayed;
+#endif
+}
+
+static inline
+ABT_delayed ABTI_delayed_get_handle(ABTI_delayed *p_delayed)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_delayed h_delayed;
+    if (p_delayed == NULL) {
+        h_delayed = ABT_DELAYED_NULL;
+    } else {
+        h_delayed = (ABT_delayed)p_delayed;
+    }
+    return h_delayed;
+#else
+    return (ABT_delayed)p_delayed;
+#endif
+}
+
+#endif /* DELAYED_H_INCLUDED */
@@ -243,6 +243,114 @@
 #define ABTI_CHECK_NULL_BARRIER_PTR(p)
 #endif
 
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_TASK_GRAPH_PTR(p)       \
+    do {                                        \
+        if (p == NULL) {                        \
+            abt_errno = ABT_ERR_INV_TASK_GRAPH; \
+            goto fn_fail;                       \
+        }                                       \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_TASK_GRAPH_PTR(p)
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_JOIN_COUNTER_PTR(p)         \
+    do {                                            \
+        if (p == NULL) {                            \
+            abt_errno = ABT_ERR_INV_JOIN_COUNTER;   \
+            goto fn_fail;                           \
+        }                                           \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_JOIN_COUNTER_PTR(p)
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_WAIT_GROUP_PTR(p)       \
+    do {                                        \
+        if (p == NULL) {                        \
+            abt_errno = ABT_ERR_INV_WAIT_GROUP; \
+            goto fn_fail;                       \
+        }                                       \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_WAIT_GROUP_PTR(p)
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_SEM_PTR(p)              \
+    do {                                        \
+        if (p == NULL) {                        \
+            abt_errno = ABT_ERR_INV_SEM;        \
+            goto fn_fail;                       \
+        }                                       \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_SEM_PTR(p)
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_GANG_PTR(p)             \
+    do {                                        \
+        if (p == NULL) {                        \
+            abt_errno = ABT_ERR_INV_GANG;       \
+            goto fn_fail;                       \
+        }                                       \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_GANG_PTR(p)
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_DELAYED_PTR(p)          \
+    do {                                        \
+        if (p == NULL) {                        \
+            abt_errno = ABT_ERR_INV_DELAYED;    \
+            goto fn_fail;                       \
+        }                                       \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_DELAYED_PTR(p)
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_TEAM_PTR(p)             \
+    do {                                        \
+        if (p == NULL) {                        \
+            abt_errno = ABT_ERR_INV_TEAM;       \
+            goto fn_fail;                       \
+        }                                       \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_TEAM_PTR(p)
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_CHANNEL_PTR(p)          \
+    do {                                        \
+        if (p == NULL) {                        \
+            abt_errno = ABT_ERR_INV_CHANNEL;    \
+            goto fn_fail;                       \
+        }                                       \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_CHANNEL_PTR(p)
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+#define ABTI_CHECK_NULL_COMPLETION_SOURCE_PTR(p)        \
+    do {                                                \
+        if (p == NULL) {                                \
+            abt_errno = ABT_ERR_INV_COMPLETION_SOURCE;  \
+            goto fn_fail;                               \
+        }                                               \
+    } while (0)
+#else
+#define ABTI_CHECK_NULL_COMPLETION_SOURCE_PTR(p)
+#endif
+
 #ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
 #define ABTI_CHECK_NULL_TIMER_PTR(p)            \
     do {                                        \
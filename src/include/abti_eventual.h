@@ -40,5 +40,135 @@ ABT_eventual ABTI_eventual_get_handle(ABTI_eventual *p_eventual)
 #endif
 }
 
+/* Waiters of an eventual are kept in a stack updated with atomic operations.
+ * ABT_eventual_set() replaces it with ABTI_EVENTUAL_CLOSED, and
+ * ABT_eventual_reset() makes it empty again. */
+#define ABTI_EVENTUAL_CLOSED    ((ABTI_unit *)1)
+
+/* Returns ABT_FALSE if the eventual has been set and p_unit must not wait. */
+static inline
+ABT_bool ABTI_eventual_push_waiter(ABTI_eventual *p_eventual, ABTI_unit *p_unit)
+{
+    while (1) {
+        ABTI_unit *p_head = *(ABTI_unit * volatile *)&p_eventual->p_head;
+        if (p_head == ABTI_EVENTUAL_CLOSED) return ABT_FALSE;
+        p_unit->p_next = p_head;
+        if (ABTD_atomic_cas_uint64((uint64_t *)&p_eventual->p_head,
+                                   (uint64_t)p_head, (uint64_t)p_unit)
+            == (uint64_t)p_head) {
+            return ABT_TRUE;
+        }
+    }
+}
+
+/* Wake up the waiters detached from an eventual.  Blocked ULTs are made ready
+ * in batches for each pool. */
+static inline
+void ABTI_eventual_wake_waiters(ABTI_unit *p_unit)
+{
+    ABTI_unit *p_threads = NULL;
+    while (p_unit) {
+        ABTI_unit *p_next = p_unit->p_next;
+        if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
+            p_unit->p_next = p_threads;
+            p_threads = p_unit;
+        } else {
+            /* The external thread frees p_unit once it is signaled. */
+            ABTD_futex_signal_set((uint32_t *)p_unit->pool);
+        }
+        p_unit = p_next;
+    }
+    ABTI_thread_set_ready_list(p_threads);
+}
+
+/* Remove and return a waiting ULT that the caller can hand off to, i.e., the
+ * oldest one in the pool of the caller.  The waiters are stacked, so the last
+ * match in the list is the oldest. */
+static inline
+ABTI_thread *ABTI_eventual_pick_handoff(ABTI_unit **pp_waiters)
+{
+    ABTI_thread *p_self;
+    ABTI_unit **pp_unit, **pp_found = NULL;
+
+    if (lp_ABTI_local == NULL || ABTI_local_get_task() != NULL) return NULL;
+    p_self = ABTI_local_get_thread();
+    if (p_self == NULL) return NULL;
+
+    for (pp_unit = pp_waiters; *pp_unit; pp_unit = &(*pp_unit)->p_next) {
+        ABTI_unit *p_unit = *pp_unit;
+        if (p_unit->type == ABT_UNIT_TYPE_THREAD &&
+            ABTI_thread_get_ptr(p_unit->thread)->p_pool == p_self->p_pool) {
+            pp_found = pp_unit;
+        }
+    }
+    if (pp_found) {
+        ABTI_unit *p_unit = *pp_found;
+        *pp_found = p_unit->p_next;
+        p_unit->p_next = NULL;
+        return ABTI_thread_get_ptr(p_unit->thread);
+    }
+    return NULL;
+}
+
+/* Wake up the timed waiters detached from an eventual.  This has to be called
+ * with the lock of the eventual held. */
+static inline
+void ABTI_eventual_signal_timed(ABTI_unit *p_unit)
+{
+    while (p_unit) {
+        ABTI_unit *p_next = p_unit->p_next;
+        /* A waiter that has timed out checks its links with the lock. */
+        p_unit->p_prev = NULL;
+        p_unit->p_next = NULL;
+        ABTI_timeout_signal((ABTI_timeout *)p_unit->pool);
+        p_unit = p_next;
+    }
+}
+
+/* Continuations of eventuals and futures */
+static inline
+ABTI_cont *ABTI_cont_create(void (*cb_func)(void *), void *arg, ABT_pool pool)
+{
+    ABTI_cont *p_cont = (ABTI_cont *)ABTU_malloc(sizeof(ABTI_cont));
+    p_cont->f_cb = cb_func;
+    p_cont->p_arg = arg;
+    p_cont->pool = pool;
+    p_cont->p_next = NULL;
+    return p_cont;
+}
+
+/* Run a continuation inline, or push it into its pool as a tasklet.  If the
+ * tasklet cannot be created, the continuation is run inline. */
+static inline
+void ABTI_cont_invoke(void (*cb_func)(void *), void *arg, ABT_pool pool)
+{
+    if (pool == ABT_POOL_NULL ||
+        ABT_task_create(pool, cb_func, arg, NULL) != ABT_SUCCESS) {
+        cb_func(arg);
+    }
+}
+
+/* Invoke and free all the continuations in the list. */
+static inline
+void ABTI_cont_invoke_list(ABTI_cont *p_cont)
+{
+    while (p_cont) {
+        ABTI_cont *p_next = p_cont->p_next;
+        ABTI_cont_invoke(p_cont->f_cb, p_cont->p_arg, p_cont->pool);
+        ABTU_free(p_cont);
+        p_cont = p_next;
+    }
+}
+
+static inline
+void ABTI_cont_free_list(ABTI_cont *p_cont)
+{
+    while (p_cont) {
+        ABTI_cont *p_next = p_cont->p_next;
+        ABTU_free(p_cont);
+        p_cont = p_next;
+    }
+}
+
 #endif /* EVENTUAL_H_INCLUDED */
 
@@ -0,0 +1,43 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef GANG_H_INCLUDED
+#define GANG_H_INCLUDED
+
+/* Inlined functions for Gang */
+
+static inline
+ABTI_gang *ABTI_gang_get_ptr(ABT_gang gang)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_gang *p_gang;
+    if (gang == ABT_GANG_NULL) {
+        p_gang = NULL;
+    } else {
+        p_gang = (ABTI_gang *)gang;
+    }
+    return p_gang;
+#else
+    return (ABTI_gang *)gang;
+#endif
+}
+
+static inline
+ABT_gang ABTI_gang_get_handle(ABTI_gang *p_gang)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_gang h_gang;
+    if (p_gang == NULL) {
+        h_gang = ABT_GANG_NULL;
+    } else {
+        h_gang = (ABT_gang)p_gang;
+    }
+    return h_gang;
+#else
+    return (ABT_gang)p_gang;
+#endif
+}
+
+#endif /* GANG_H_INCLUDED */
@@ -50,5 +50,49 @@ uint32_t ABTI_global_get_mutex_max_wakeups(void)
     return gp_ABTI_global->mutex_max_wakeups;
 }
 
+static inline
+ABT_bool ABTI_global_get_handoff(void)
+{
+    return gp_ABTI_global->handoff;
+}
+
+static inline
+ABT_bool ABTI_global_get_wake_affine(void)
+{
+    return gp_ABTI_global->wake_affine;
+}
+
+static inline
+uint32_t ABTI_global_get_wake_affine_max_queue(void)
+{
+    return gp_ABTI_global->wake_affine_max_queue;
+}
+
+static inline
+ABT_bool ABTI_global_get_run_next(void)
+{
+    return gp_ABTI_global->run_next;
+}
+
+static inline
+long ABTI_global_get_preempt_interval(void)
+{
+    return gp_ABTI_global->preempt_interval_nsec;
+}
+
+/* Return the ES array and its size through p_max_xstreams without locking.
+ * The array is replaced by a larger copy when it grows, and the old one is
+ * kept until ABT_finalize, so the returned array stays valid.  Its entries
+ * may become NULL or be set while the caller scans it. */
+static inline
+ABTI_xstream **ABTI_global_get_xstreams(int *p_max_xstreams)
+{
+    *p_max_xstreams = *(volatile int *)&gp_ABTI_global->max_xstreams;
+    /* Pairs with the barrier in ABTI_xstream_grow_table(), so the array is
+     * at least as large as the size read above. */
+    ABTD_atomic_mem_barrier();
+    return *(ABTI_xstream **volatile *)&gp_ABTI_global->p_xstreams;
+}
+
 #endif /* GLOBAL_H_INCLUDED */
 
@@ -0,0 +1,20 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef IO_H_INCLUDED
+#define IO_H_INCLUDED
+
+/* Inlined functions for I/O waits */
+
+/* Called by the schedulers through ABTI_xstream_check_events() */
+static inline
+void ABTI_io_poller_check(ABTI_io_poller *p_poller)
+{
+    if (p_poller->num_waiters > 0) {
+        ABTI_io_poller_poll(p_poller);
+    }
+}
+
+#endif /* IO_H_INCLUDED */
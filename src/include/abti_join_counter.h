@@ -0,0 +1,59 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef JOIN_COUNTER_H_INCLUDED
+#define JOIN_COUNTER_H_INCLUDED
+
+/* Inlined functions for Join Counter */
+
+static inline
+ABTI_join_counter *ABTI_join_counter_get_ptr(ABT_join_counter counter)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_join_counter *p_counter;
+    if (counter == ABT_JOIN_COUNTER_NULL) {
+        p_counter = NULL;
+    } else {
+        p_counter = (ABTI_join_counter *)counter;
+    }
+    return p_counter;
+#else
+    return (ABTI_join_counter *)counter;
+#endif
+}
+
+static inline
+ABT_join_counter ABTI_join_counter_get_handle(ABTI_join_counter *p_counter)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_join_counter h_counter;
+    if (p_counter == NULL) {
+        h_counter = ABT_JOIN_COUNTER_NULL;
+    } else {
+        h_counter = (ABT_join_counter)p_counter;
+    }
+    return h_counter;
+#else
+    return (ABT_join_counter)p_counter;
+#endif
+}
+
+/* Count p_thread in its join counter when it is created or revived. */
+static inline
+void ABTI_join_counter_inc(ABTI_thread *p_thread)
+{
+    ABTI_join_counter *p_counter = p_thread->attr.p_join_counter;
+    if (p_counter) ABTI_wait_group_add(&p_counter->wg, 1);
+}
+
+/* Count down the join counter of the terminating ULT p_thread */
+static inline
+void ABTI_join_counter_dec(ABTI_thread *p_thread)
+{
+    ABTI_join_counter *p_counter = p_thread->attr.p_join_counter;
+    if (p_counter) ABTI_wait_group_done(&p_counter->wg, p_thread);
+}
+
+#endif /* JOIN_COUNTER_H_INCLUDED */
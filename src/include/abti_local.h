@@ -8,6 +8,16 @@
 
 /* Inlined functions for ES Local Data */
 
+/* lp_ABTI_local is a TLS variable, so each access may cost a call to
+ * __tls_get_addr() when Argobots is a shared library, which cannot use the
+ * initial-exec TLS model.  Hot paths read it once by ABTI_local_get_local()
+ * and pass the pointer down their call chains.  It is NULL for external
+ * threads. */
+static inline
+ABTI_local *ABTI_local_get_local(void) {
+    return lp_ABTI_local;
+}
+
 static inline
 ABTI_xstream *ABTI_local_get_xstream(void) {
     return lp_ABTI_local->p_xstream;
@@ -15,6 +25,11 @@ ABTI_xstream *ABTI_local_get_xstream(void) {
 
 static inline
 void ABTI_local_set_xstream(ABTI_xstream *p_xstream) {
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    /* Let ABT_info_query_mem() find the memory caches of the ES. */
+    if (lp_ABTI_local->p_xstream) lp_ABTI_local->p_xstream->p_local = NULL;
+    if (p_xstream) p_xstream->p_local = lp_ABTI_local;
+#endif
     lp_ABTI_local->p_xstream = p_xstream;
 }
 
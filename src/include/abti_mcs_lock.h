@@ -0,0 +1,120 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef MCS_LOCK_H_INCLUDED
+#define MCS_LOCK_H_INCLUDED
+
+/* MCS queue lock in the K42 variant, which needs no queue node for release.
+ * A waiter spins on a node on its own stack, so waiters do not bounce a
+ * shared cache line, and they are served in FIFO order.  Once a waiter
+ * acquires the lock, it moves its successor to the lock and takes its node
+ * out of the queue, so the owner is always represented by the lock itself.
+ * Unlike a pthread mutex, it never enters the kernel. */
+
+typedef struct ABTI_mcs_lock ABTI_mcs_lock;
+
+struct ABTI_mcs_lock {
+    ABTI_mcs_lock *p_tail;  /* Last node, or NULL if the lock is free.  For
+                               a waiter's node, ABTI_MCS_LOCK_WAITING until
+                               it acquires the lock. */
+    ABTI_mcs_lock *p_next;  /* Successor of the owner, or of a waiter */
+};
+
+#define ABTI_MCS_LOCK_WAITING   ((ABTI_mcs_lock *)1)
+
+static inline
+ABTI_mcs_lock *ABTI_mcs_lock_cas(ABTI_mcs_lock **pp, ABTI_mcs_lock *oldv,
+                                 ABTI_mcs_lock *newv)
+{
+    return (ABTI_mcs_lock *)ABTD_atomic_cas_uint64((uint64_t *)pp,
+                                                   (uint64_t)oldv,
+                                                   (uint64_t)newv);
+}
+
+static inline
+ABTI_mcs_lock *ABTI_mcs_lock_load(ABTI_mcs_lock **pp)
+{
+    return *(ABTI_mcs_lock * volatile *)pp;
+}
+
+static inline
+void ABTI_mcs_lock_create(ABTI_mcs_lock *p_lock)
+{
+    p_lock->p_tail = NULL;
+    p_lock->p_next = NULL;
+}
+
+static inline
+void ABTI_mcs_lock_free(ABTI_mcs_lock *p_lock)
+{
+    ABTI_ASSERT(p_lock->p_tail == NULL);
+}
+
+static inline
+void ABTI_mcs_lock_acquire(ABTI_mcs_lock *p_lock)
+{
+    ABTI_mcs_lock node, *p_prev, *p_succ;
+
+    while (1) {
+        p_prev = ABTI_mcs_lock_load(&p_lock->p_tail);
+        if (p_prev == NULL) {
+            /* The lock looks free. */
+            if (ABTI_mcs_lock_cas(&p_lock->p_tail, NULL, p_lock) == NULL) {
+                break;
+            }
+            continue;
+        }
+
+        node.p_tail = ABTI_MCS_LOCK_WAITING;
+        node.p_next = NULL;
+        if (ABTI_mcs_lock_cas(&p_lock->p_tail, p_prev, &node) != p_prev) {
+            continue;
+        }
+        /* The owner is p_lock itself if p_prev is p_lock. */
+        *(ABTI_mcs_lock * volatile *)&p_prev->p_next = &node;
+        while (ABTI_mcs_lock_load(&node.p_tail) == ABTI_MCS_LOCK_WAITING) {
+            ABTD_atomic_pause();
+        }
+        ABTD_atomic_mem_barrier();
+
+        /* Acquired.  Hand the successor to the lock and leave the queue. */
+        p_succ = ABTI_mcs_lock_load(&node.p_next);
+        if (p_succ == NULL) {
+            p_lock->p_next = NULL;
+            if (ABTI_mcs_lock_cas(&p_lock->p_tail, &node, p_lock) != &node) {
+                /* A new waiter has been queued behind node. */
+                while ((p_succ = ABTI_mcs_lock_load(&node.p_next)) == NULL) {
+                    ABTD_atomic_pause();
+                }
+                p_lock->p_next = p_succ;
+            }
+        } else {
+            p_lock->p_next = p_succ;
+        }
+        break;
+    }
+}
+
+static inline
+void ABTI_mcs_lock_release(ABTI_mcs_lock *p_lock)
+{
+    ABTI_mcs_lock *p_succ;
+
+    p_succ = ABTI_mcs_lock_load(&p_lock->p_next);
+    if (p_succ == NULL) {
+        if (ABTI_mcs_lock_cas(&p_lock->p_tail, p_lock, NULL) == p_lock) {
+            return;
+        }
+        /* A waiter is being queued. */
+        while ((p_succ = ABTI_mcs_lock_load(&p_lock->p_next)) == NULL) {
+            ABTD_atomic_pause();
+        }
+    }
+    /* The CAS above is a full barrier, but this plain store is not. */
+    ABTD_atomic_mem_barrier();
+    *(ABTI_mcs_lock * volatile *)&p_succ->p_tail = NULL;
+}
+
+#endif /* MCS_LOCK_H_INCLUDED */
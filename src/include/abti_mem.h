@@ -15,22 +15,26 @@
 #endif
 
 #ifdef ABT_CONFIG_USE_MEM_POOL
-typedef struct ABTI_blk_header  ABTI_blk_header;
-
 enum {
     ABTI_MEM_LP_MALLOC = 0,
     ABTI_MEM_LP_MMAP_RP,
     ABTI_MEM_LP_MMAP_HP_RP,
     ABTI_MEM_LP_MMAP_HP_THP,
-    ABTI_MEM_LP_THP
+    ABTI_MEM_LP_THP,
+    ABTI_MEM_LP_MMAP_GP_HP_RP
 };
 
 struct ABTI_sp_header {
     uint32_t num_total_stacks;  /* Number of total stacks */
     uint32_t num_empty_stacks;  /* Number of empty stacks */
+    uint32_t num_carved_stacks; /* Number of stacks carved from the page */
     size_t stacksize;           /* Stack size */
     uint64_t id;                /* ID */
     ABT_bool is_mmapped;        /* ABT_TRUE if it is mmapped */
+    ABT_bool is_lazy;           /* ABT_TRUE if stacks are lazily committed */
+    ABT_bool is_trimmed;        /* ABT_TRUE if it is being released */
+    int stack_class;            /* Size class of stacks */
+    int node;                   /* NUMA node of the stack page */
     void *p_sp;                 /* Pointer to the allocated stack page */
     ABTI_sp_header *p_next;     /* Next stack page header */
 };
@@ -39,6 +43,10 @@ struct ABTI_stack_header {
     ABTI_stack_header *p_next;
     ABTI_sp_header *p_sph;
     void *p_stack;
+    ABT_bool is_reclaimed;
+    uint32_t color;             /* Bytes below the top of the stack at which
+                                   the initial stack pointer is set */
+    ABTI_stack_header *p_bound; /* Stack bound to a descriptor-only block */
 };
 
 struct ABTI_page_header {
@@ -46,12 +54,14 @@ struct ABTI_page_header {
     uint32_t num_total_blks;    /* Number of total blocks */
     uint32_t num_empty_blks;    /* Number of empty blocks */
     uint32_t num_remote_free;   /* Number of remote free blocks */
+    uint32_t num_carved_blks;   /* Number of blocks carved from the page */
     ABTI_blk_header *p_head;    /* First empty block */
     ABTI_blk_header *p_free;    /* For remote free */
     ABTI_xstream *p_owner;      /* Owner ES */
     ABTI_page_header *p_prev;   /* Prev page header */
     ABTI_page_header *p_next;   /* Next page header */
     ABT_bool is_mmapped;        /* ABT_TRUE if it is mmapped */
+    int node;                   /* NUMA node of the page */
 };
 
 struct ABTI_blk_header {
@@ -63,17 +73,55 @@ void ABTI_mem_init(ABTI_global *p_global);
 void ABTI_mem_init_local(ABTI_local *p_local);
 void ABTI_mem_finalize(ABTI_global *p_global);
 void ABTI_mem_finalize_local(ABTI_local *p_local);
-int ABTI_mem_check_lp_alloc(int lp_alloc);
 
-char *ABTI_mem_take_global_stack(ABTI_local *p_local);
-void ABTI_mem_add_stack_to_global(ABTI_stack_header *p_sh);
+char *ABTI_mem_take_global_stack(ABTI_local *p_local, int cls);
+void ABTI_mem_add_stacks_to_global(int node, int cls,
+                                   ABTI_stack_header *p_head,
+                                   ABTI_stack_header *p_tail,
+                                   uint32_t num_stacks);
+void ABTI_mem_adjust_stacks(ABTI_local *p_local, int cls);
 ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size);
 void ABTI_mem_free_page(ABTI_local *p_local, ABTI_page_header *p_ph);
+void ABTI_mem_carve_blks(ABTI_page_header *p_ph);
 void ABTI_mem_take_free(ABTI_page_header *p_ph);
-void ABTI_mem_free_remote(ABTI_page_header *p_ph, ABTI_blk_header *p_bh);
+void ABTI_mem_free_remote(ABTI_local *p_local, ABTI_page_header *p_ph,
+                          ABTI_blk_header *p_bh);
+void ABTI_mem_flush_remote_frees(ABTI_local *p_local);
 ABTI_page_header *ABTI_mem_take_global_page(ABTI_local *p_local);
-
-char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize);
+void ABTI_mem_get_stats(ABTI_xstream *p_xstream, ABT_mem_stats *p_stats);
+void ABTI_mem_trim(ABTI_local *p_local, size_t max_bytes, ABT_bool wait);
+void *ABTI_mem_alloc_user(ABTI_local *p_local, size_t size);
+void ABTI_mem_free_user(ABTI_local *p_local, void *ptr);
+
+char *ABTI_mem_alloc_sp(ABTI_local *p_local, int cls);
+
+/* Pages are not divided into stacks or blocks when they are allocated, which
+ * would touch the whole page, e.g., at the first ULT creation after ABT_init.
+ * Instead, stacks and blocks are carved out of a page in batches when an ES
+ * runs out of them. */
+
+/* Each ES keeps up to max_stacks free stacks of each size class.  The limit
+ * starts at min_stacks, is doubled whenever the ES runs out of stacks of the
+ * class, and is lowered when stacks stay unused for ABTI_MEM_STACK_EPOCH
+ * frees.  It never exceeds gp_ABTI_global->mem_max_stacks.  min_stacks is
+ * ABTI_MEM_MIN_STACKS but is reduced for large stacks so that an idle class
+ * does not keep more than ABTI_MEM_MIN_STACK_BYTES.  Stacks are moved between
+ * an ES and the global list in batches of half of the limit. */
+#define ABTI_MEM_MIN_STACKS         64
+#define ABTI_MEM_MIN_STACK_BYTES    (1024*1024)
+#define ABTI_MEM_STACK_EPOCH        1024
+
+/* Stacks of ABTI_MEM_MIN_COLOR_STACKSIZE bytes or larger are colored: see
+ * ABTI_mem_alloc_thread. */
+#define ABTI_MEM_MIN_COLOR_STACKSIZE    (16*1024)
+
+/* Stacks and task block pages are allocated on the NUMA node of the ES that
+ * allocates them, and free ones are kept in the global lists of their node.
+ * An ES takes them only from the lists of the node it last ran on. */
+static inline ABTI_mem_node *ABTI_mem_get_node(int node)
+{
+    return &gp_ABTI_global->p_mem_nodes[node % gp_ABTI_global->mem_num_nodes];
+}
 
 /* ABTI_EXT_STACK means that the block will not be managed by ES's stack pool
  * and it needs to be freed with ABTU_free. */
@@ -95,6 +143,19 @@ char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize);
  * Thus, the actual size of stack becomes
  * (requested stack size) - sizeof(ABTI_thread) - sizeof(ABTI_stack_header)
  * and it is set in the attribute field of ABTI_thread.
+ *
+ * Stacks at the same position of different stack pages are placed at the same
+ * offset from the beginning of their pages, so their tops, where ULTs keep
+ * their hottest frames and switch contexts, map to the same cache set.  Each
+ * pooled stack therefore has a color, which is a multiple of the cache line
+ * size below gp_ABTI_global->mem_stack_colors lines, and its initial stack
+ * pointer is rotated down by the color:
+ *  |-------------------| <- p_stack
+ *  | actual stack area |
+ *  |-------------------| <- initial stack pointer
+ *  | color             |
+ *  |-------------------| <- p_stack + stacksize
+ * The color stays in ABTI_stack_header while the stack is reused.
  *****************************************************************************/
 
 /* Inline functions */
@@ -125,30 +186,132 @@ ABTI_thread *ABTI_mem_alloc_thread_with_stacksize(size_t *p_stacksize)
     /* Set attributes */
     ABTI_thread_attr *p_myattr = &p_thread->attr;
     ABTI_thread_attr_init(p_myattr, p_stack, actual_stacksize, ABT_TRUE);
+    ABTI_VALGRIND_STACK_REGISTER(p_thread);
 
     *p_stacksize = actual_stacksize;
     return p_thread;
 }
 
 static inline
-ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
+size_t ABTI_mem_get_class_stacksize(int cls)
+{
+    if (cls == 0) return gp_ABTI_global->thread_stacksize;
+    if (cls == ABTI_MEM_DESC_CLASS) return gp_ABTI_global->mem_sh_size;
+    return (size_t)ABTI_MEM_MIN_CLASS_STACKSIZE << (cls - 1);
+}
+
+/* Return the size of stack pages of class cls.  Descriptors are carved from
+ * pages of the task page size since they are much smaller than stacks. */
+static inline
+size_t ABTI_mem_get_class_sp_size(int cls)
+{
+    if (cls == ABTI_MEM_DESC_CLASS) return gp_ABTI_global->mem_page_size;
+    return gp_ABTI_global->mem_sp_size;
+}
+
+/* Return the size class of stacks of stacksize, or -1 if such stacks are not
+ * managed by the stack pool. */
+static inline
+int ABTI_mem_get_stack_class(size_t stacksize)
+{
+    size_t class_stacksize = ABTI_MEM_MIN_CLASS_STACKSIZE;
+    int cls = 1;
+
+    if (stacksize == gp_ABTI_global->thread_stacksize) return 0;
+    if (stacksize > ABTI_MEM_MAX_CLASS_STACKSIZE ||
+        stacksize > gp_ABTI_global->mem_sp_size) return -1;
+
+    while (class_stacksize < stacksize) {
+        class_stacksize <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+static inline
+void ABTI_mem_grow_stacks(ABTI_stack_list *p_list)
+{
+    uint32_t max_stacks = p_list->max_stacks * 2;
+    if (max_stacks < p_list->min_stacks) {
+        max_stacks = p_list->min_stacks;
+    }
+    if (max_stacks > gp_ABTI_global->mem_max_stacks) {
+        max_stacks = gp_ABTI_global->mem_max_stacks;
+    }
+    p_list->max_stacks = max_stacks;
+}
+
+/* Take a stack of class cls from the stack pool of p_local.  The pointer to
+ * the block that starts with ABTI_thread is returned. */
+static inline
+char *ABTI_mem_take_stack(ABTI_local *p_local, int cls)
+{
+    ABTI_stack_list *p_list = &p_local->mem_stacks[cls];
+    ABTI_stack_header *p_sh;
+    char *p_blk;
+
+    if (p_list->p_head) {
+        /* ES's stack pool has an available stack */
+        p_sh = p_list->p_head;
+        p_list->p_head = p_sh->p_next;
+        p_list->num_stacks--;
+        if (p_list->num_stacks < p_list->low_stacks) {
+            p_list->low_stacks = p_list->num_stacks;
+        }
+
+        p_sh->p_next = NULL;
+        p_blk = (char *)p_sh - sizeof(ABTI_thread);
+
+    } else {
+        /* The ES has run out of stacks, so let it keep more stacks. */
+        ABTI_mem_grow_stacks(p_list);
+
+        if (p_list->p_sph) {
+            /* Carve more stacks out of the current stack page */
+            p_blk = ABTI_mem_alloc_sp(p_local, cls);
+        } else {
+            /* Check stacks in the global data of the current NUMA node */
+            p_local->mem_node = ABTD_affinity_get_node();
+            if (ABTI_mem_get_node(p_local->mem_node)->p_mem_stack[cls]) {
+                p_blk = ABTI_mem_take_global_stack(p_local, cls);
+                if (p_blk == NULL) {
+                    p_blk = ABTI_mem_alloc_sp(p_local, cls);
+                }
+            } else {
+                /* Allocate a new stack if we don't have any empty stack */
+                p_blk = ABTI_mem_alloc_sp(p_local, cls);
+            }
+        }
+
+        p_sh = (ABTI_stack_header *)(p_blk + sizeof(ABTI_thread));
+        p_sh->p_next = NULL;
+    }
+    p_sh->is_reclaimed = ABT_FALSE;
+    p_sh->p_bound = NULL;
+
+    return p_blk;
+}
+
+static inline
+ABTI_thread *ABTI_mem_alloc_thread(ABTI_local *p_local, ABT_thread_attr attr,
+                                   size_t *p_stacksize)
 {
     /* Basic idea: allocate a memory for stack and use the first some memory as
      * ABTI_stack_header and ABTI_thread. So, the effective stack area is
      * reduced as much as the size of ABTI_stack_header and ABTI_thread. */
 
     const size_t header_size = gp_ABTI_global->mem_sh_size;
-    size_t stacksize, def_stacksize, actual_stacksize;
-    ABTI_local *p_local = lp_ABTI_local;
+    size_t stacksize, actual_stacksize;
     char *p_blk = NULL;
     ABTI_thread *p_thread;
     ABTI_stack_header *p_sh;
     void *p_stack;
+    int cls;
 
     /* Get the stack size */
-    def_stacksize = ABTI_global_get_thread_stacksize();
     if (attr == ABT_THREAD_ATTR_NULL) {
-        stacksize = def_stacksize;
+        stacksize = ABTI_global_get_thread_stacksize();
+        cls = 0;
 
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
         /* If an external thread allocates a stack, we use ABTU_malloc. */
@@ -162,13 +325,26 @@ ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
         ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
 
         if (p_attr->p_stack != NULL) {
-            /* Since the stack is given by the user, we create ABTI_thread and
-             * ABTI_stack_header explicitly with a single ABTU_malloc call. */
-            p_blk = (char *)ABTU_CA_MALLOC(header_size);
+            /* Since the stack is given by the user, we take only ABTI_thread
+             * and ABTI_stack_header from the pool of descriptors. */
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+            if (p_local == NULL) {
+                /* An external thread does not have its own pool, so we
+                 * create them with a single ABTU_malloc call. */
+                p_blk = (char *)ABTU_CA_MALLOC(header_size);
 
-            p_sh = (ABTI_stack_header *)(p_blk + sizeof(ABTI_thread));
-            p_sh->p_next = ABTI_EXT_STACK;
+                p_sh = (ABTI_stack_header *)(p_blk + sizeof(ABTI_thread));
+                p_sh->p_next = ABTI_EXT_STACK;
+
+                p_thread = (ABTI_thread *)p_blk;
+                ABTI_thread_attr_copy(&p_thread->attr, p_attr);
 
+                *p_stacksize = p_attr->stacksize;
+                return p_thread;
+            }
+#endif
+
+            p_blk = ABTI_mem_take_stack(p_local, ABTI_MEM_DESC_CLASS);
             p_thread = (ABTI_thread *)p_blk;
             ABTI_thread_attr_copy(&p_thread->attr, p_attr);
 
@@ -177,9 +353,27 @@ ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
         }
 
         stacksize = p_attr->stacksize;
-        if (stacksize != def_stacksize) {
-            /* Since the stack size requested is not the same as default one,
-             * we use ABTU_malloc. */
+        cls = ABTI_mem_get_stack_class(stacksize);
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+        /* An external thread does not have its own stack pool. */
+        if (p_local == NULL) cls = -1;
+#endif
+#ifdef ABT_CONFIG_USE_FCONTEXT
+        if (p_attr->deferred_stack == ABT_TRUE && cls >= 0) {
+            /* Only the descriptor is taken now.  A stack of class cls is
+             * bound by ABTI_mem_bind_stack when the ULT runs first. */
+            p_blk = ABTI_mem_take_stack(p_local, ABTI_MEM_DESC_CLASS);
+            p_thread = (ABTI_thread *)p_blk;
+            ABTI_thread_attr_copy(&p_thread->attr, p_attr);
+            p_thread->attr.stacksize = stacksize - header_size;
+
+            *p_stacksize = p_thread->attr.stacksize;
+            return p_thread;
+        }
+#endif
+        if (cls < 0) {
+            /* Since no size class can hold the stack size requested, we use
+             * ABTU_malloc. */
             p_blk = (char *)ABTU_CA_MALLOC(stacksize);
 
             p_sh = (ABTI_stack_header *)(p_blk + sizeof(ABTI_thread));
@@ -190,6 +384,7 @@ ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
             ABTI_thread_attr_copy(&p_thread->attr, p_attr);
             p_thread->attr.stacksize = actual_stacksize;
             p_thread->attr.p_stack = (void *)(p_blk + header_size);
+            ABTI_VALGRIND_STACK_REGISTER(p_thread);
 
             *p_stacksize = actual_stacksize;
             return p_thread;
@@ -197,32 +392,11 @@ ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
     }
 
     /* Use the stack pool */
-    if (p_local->p_mem_stack) {
-        /* ES's stack pool has an available stack */
-        p_sh = p_local->p_mem_stack;
-        p_local->p_mem_stack = p_sh->p_next;
-        p_local->num_stacks--;
-
-        p_sh->p_next = NULL;
-        p_blk = (char *)p_sh - sizeof(ABTI_thread);
-
-    } else {
-        /* Check stacks in the global data */
-        if (gp_ABTI_global->p_mem_stack) {
-            p_blk = ABTI_mem_take_global_stack(p_local);
-            if (p_blk == NULL) {
-                p_blk = ABTI_mem_alloc_sp(p_local, stacksize);
-            }
-        } else {
-            /* Allocate a new stack if we don't have any empty stack */
-            p_blk = ABTI_mem_alloc_sp(p_local, stacksize);
-        }
-
-        p_sh = (ABTI_stack_header *)(p_blk + sizeof(ABTI_thread));
-        p_sh->p_next = NULL;
-    }
+    p_blk = ABTI_mem_take_stack(p_local, cls);
+    p_sh = (ABTI_stack_header *)(p_blk + sizeof(ABTI_thread));
 
-    /* Actual stack size */
+    /* Actual stack size.  A stack of a power-of-two class may be larger than
+     * requested, but only the requested size is exposed. */
     actual_stacksize = stacksize - header_size;
 
     /* Get the ABTI_thread pointer and stack pointer */
@@ -239,11 +413,55 @@ ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
         p_thread->attr.stacksize = actual_stacksize;
         p_thread->attr.p_stack = p_stack;
     }
+    ABTI_VALGRIND_STACK_REGISTER(p_thread);
 
-    *p_stacksize = actual_stacksize;
+    /* The context is made below the color of the stack. */
+    *p_stacksize = actual_stacksize - p_sh->color;
     return p_thread;
 }
 
+#ifdef ABT_CONFIG_USE_FCONTEXT
+/* Bind a pooled stack to p_thread, whose descriptor has been taken without a
+ * stack.  Only an ES can bind a stack since it runs ULTs. */
+static inline
+void ABTI_mem_bind_stack(ABTI_thread *p_thread)
+{
+    const size_t header_size = gp_ABTI_global->mem_sh_size;
+    ABTI_stack_header *p_sh, *p_bound;
+    int cls;
+
+    cls = ABTI_mem_get_stack_class(p_thread->attr.stacksize + header_size);
+    p_bound = (ABTI_stack_header *)(ABTI_mem_take_stack(lp_ABTI_local, cls) +
+                                    sizeof(ABTI_thread));
+
+    p_sh = (ABTI_stack_header *)((char *)p_thread + sizeof(ABTI_thread));
+    p_sh->p_bound = p_bound;
+    p_thread->attr.p_stack = p_bound->p_stack;
+    ABTI_VALGRIND_STACK_REGISTER(p_thread);
+}
+#endif
+
+/* Return the size of the stack that ABTI_mem_alloc_thread gives a ULT when a
+ * stack of stacksize bytes is requested. */
+static inline
+size_t ABTI_mem_get_thread_stacksize(size_t stacksize)
+{
+    return stacksize - gp_ABTI_global->mem_sh_size;
+}
+
+/* Return the size of the stack of p_thread below its initial stack pointer,
+ * which is passed to ABTD_thread_context_create. */
+static inline
+size_t ABTI_mem_get_context_stacksize(ABTI_thread *p_thread)
+{
+    ABTI_stack_header *p_sh;
+
+    p_sh = (ABTI_stack_header *)((char *)p_thread + sizeof(ABTI_thread));
+    if (p_sh->p_next == ABTI_EXT_STACK) return p_thread->attr.stacksize;
+    if (p_sh->p_bound) return p_thread->attr.stacksize - p_sh->p_bound->color;
+    return p_thread->attr.stacksize - p_sh->color;
+}
+
 static inline
 ABTI_thread *ABTI_mem_alloc_main_thread(ABT_thread_attr attr)
 {
@@ -268,11 +486,43 @@ ABTI_thread *ABTI_mem_alloc_main_thread(ABT_thread_attr attr)
 }
 
 static inline
-void ABTI_mem_free_thread(ABTI_thread *p_thread)
+void ABTI_mem_free_stack(ABTI_stack_header *p_sh)
 {
     ABTI_local *p_local;
+    ABTI_stack_list *p_list;
+    int cls;
+
+    cls = p_sh->p_sph->stack_class;
+    p_local = lp_ABTI_local;
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    if (p_local == NULL) {
+        /* An external thread does not have its own stack pool. */
+        ABTI_mem_add_stacks_to_global(p_sh->p_sph->node, cls, p_sh, p_sh, 1);
+        return;
+    }
+#endif
+    if (p_sh->p_sph->node != p_local->mem_node) {
+        /* A stack of a remote node is returned to its own node. */
+        ABTI_mem_add_stacks_to_global(p_sh->p_sph->node, cls, p_sh, p_sh, 1);
+        return;
+    }
+
+    p_list = &p_local->mem_stacks[cls];
+    p_sh->p_next = p_list->p_head;
+    p_list->p_head = p_sh;
+    p_list->num_stacks++;
+    if (++p_list->num_frees >= ABTI_MEM_STACK_EPOCH ||
+        p_list->num_stacks > p_list->max_stacks) {
+        ABTI_mem_adjust_stacks(p_local, cls);
+    }
+}
+
+static inline
+void ABTI_mem_free_thread(ABTI_thread *p_thread)
+{
     ABTI_stack_header *p_sh;
 
+    ABTI_VALGRIND_STACK_DEREGISTER(p_thread);
     p_sh = (ABTI_stack_header *)((char *)p_thread + sizeof(ABTI_thread));
 
     if (p_sh->p_next == ABTI_EXT_STACK) {
@@ -280,38 +530,27 @@ void ABTI_mem_free_thread(ABTI_thread *p_thread)
         return;
     }
 
-    p_local = lp_ABTI_local;
-    if (p_local->num_stacks <= gp_ABTI_global->mem_max_stacks) {
-        p_sh->p_next = p_local->p_mem_stack;
-        p_local->p_mem_stack = p_sh;
-        p_local->num_stacks++;
-    } else {
-        ABTI_mem_add_stack_to_global(p_sh);
+    /* Return the stack bound to a descriptor-only block first. */
+    if (p_sh->p_bound != NULL) {
+        ABTI_mem_free_stack(p_sh->p_bound);
     }
+    ABTI_mem_free_stack(p_sh);
 }
 
+/* Return a page of p_local that has at least one empty block. */
 static inline
-ABTI_task *ABTI_mem_alloc_task(void)
+ABTI_page_header *ABTI_mem_get_task_page(ABTI_local *p_local)
 {
-    ABTI_task *p_task = NULL;
-    ABTI_local *p_local = lp_ABTI_local;
     const size_t blk_size = sizeof(ABTI_blk_header) + sizeof(ABTI_task);
 
-#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
-    if (p_local == NULL) {
-        /* For external threads */
-        char *p_blk = (char *)ABTU_CA_MALLOC(blk_size);
-        ABTI_blk_header *p_blk_header = (ABTI_blk_header *)p_blk;
-        p_blk_header->p_ph = NULL;
-        p_task = (ABTI_task *)(p_blk + sizeof(ABTI_blk_header));
-        return p_task;
-    }
-#endif
-
     /* Find the page that has an empty block */
     ABTI_page_header *p_ph = p_local->p_mem_task_head;
     while (p_ph) {
         if (p_ph->p_head) break;
+        if (p_ph->num_carved_blks < p_ph->num_total_blks) {
+            ABTI_mem_carve_blks(p_ph);
+            break;
+        }
         if (p_ph->p_free) {
             ABTI_mem_take_free(p_ph);
             break;
@@ -326,8 +565,9 @@ ABTI_task *ABTI_mem_alloc_task(void)
 
     /* If there is no page that has an empty block */
     if (p_ph == NULL) {
-        /* Check pages in the global data */
-        if (gp_ABTI_global->p_mem_task) {
+        /* Check pages in the global data of the current NUMA node */
+        p_local->mem_node = ABTD_affinity_get_node();
+        if (ABTI_mem_get_node(p_local->mem_node)->p_mem_task) {
             p_ph = ABTI_mem_take_global_page(p_local);
             if (p_ph == NULL) {
                 p_ph = ABTI_mem_alloc_page(p_local, blk_size);
@@ -338,6 +578,28 @@ ABTI_task *ABTI_mem_alloc_task(void)
         }
     }
 
+    return p_ph;
+}
+
+static inline
+ABTI_task *ABTI_mem_alloc_task(ABTI_local *p_local)
+{
+    ABTI_task *p_task = NULL;
+
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    if (p_local == NULL) {
+        /* For external threads */
+        const size_t blk_size = sizeof(ABTI_blk_header) + sizeof(ABTI_task);
+        char *p_blk = (char *)ABTU_CA_MALLOC(blk_size);
+        ABTI_blk_header *p_blk_header = (ABTI_blk_header *)p_blk;
+        p_blk_header->p_ph = NULL;
+        p_task = (ABTI_task *)(p_blk + sizeof(ABTI_blk_header));
+        return p_task;
+    }
+#endif
+
+    ABTI_page_header *p_ph = ABTI_mem_get_task_page(p_local);
+
     ABTI_blk_header *p_head = p_ph->p_head;
     p_ph->p_head = p_head->p_next;
     p_ph->num_empty_blks--;
@@ -347,6 +609,34 @@ ABTI_task *ABTI_mem_alloc_task(void)
     return p_task;
 }
 
+/* Allocate num tasklet objects.  Blocks are taken from a page until it runs
+ * out, so consecutive tasklets are adjacent in memory when the page is fresh.
+ */
+static inline
+void ABTI_mem_alloc_tasks(ABTI_local *p_local, int num, ABTI_task **p_tasks)
+{
+    int i = 0;
+
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    if (p_local == NULL) {
+        for (i = 0; i < num; i++) p_tasks[i] = ABTI_mem_alloc_task(p_local);
+        return;
+    }
+#endif
+
+    while (i < num) {
+        ABTI_page_header *p_ph = ABTI_mem_get_task_page(p_local);
+        ABTI_blk_header *p_head = p_ph->p_head;
+        while (p_head && i < num) {
+            p_tasks[i++] = (ABTI_task *)((char *)p_head +
+                                         sizeof(ABTI_blk_header));
+            p_head = p_head->p_next;
+            p_ph->num_empty_blks--;
+        }
+        p_ph->p_head = p_head;
+    }
+}
+
 static inline
 void ABTI_mem_free_task(ABTI_task *p_task)
 {
@@ -375,7 +665,27 @@ void ABTI_mem_free_task(ABTI_task *p_task)
         /* ABTI_mem_free_page(p_local, p_ph); */
     } else {
         /* Remote free */
-        ABTI_mem_free_remote(p_ph, p_head);
+        ABTI_mem_free_remote(p_local, p_ph, p_head);
+    }
+}
+
+/* Called by the schedulers through ABTI_xstream_check_events().  An ES trims
+ * its own caches when ABT_mem_trim() has been called since its last check or
+ * when the interval of background trims has elapsed. */
+static inline
+void ABTI_mem_check_trim(double now)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_local *p_local = lp_ABTI_local;
+    uint32_t seq = *(volatile uint32_t *)&p_global->mem_trim_seq;
+
+    if (p_local->mem_trim_seq != seq) {
+        p_local->mem_trim_seq = seq;
+        ABTI_mem_trim(p_local, p_global->mem_trim_target, ABT_FALSE);
+    } else if (p_global->mem_trim_interval > 0.0 &&
+               now >= p_local->mem_trim_time) {
+        p_local->mem_trim_time = now + p_global->mem_trim_interval;
+        ABTI_mem_trim(p_local, p_global->mem_trim_size, ABT_FALSE);
     }
 }
 
@@ -385,6 +695,7 @@ void ABTI_mem_free_task(ABTI_task *p_task)
 #define ABTI_mem_init_local(p)
 #define ABTI_mem_finalize(p)
 #define ABTI_mem_finalize_local(p)
+#define ABTI_mem_check_trim(t)
 
 static inline
 ABTI_thread *ABTI_mem_alloc_thread_with_stacksize(size_t *p_stacksize)
@@ -406,15 +717,18 @@ ABTI_thread *ABTI_mem_alloc_thread_with_stacksize(size_t *p_stacksize)
     /* Set attributes */
     ABTI_thread_attr *p_myattr = &p_thread->attr;
     ABTI_thread_attr_init(p_myattr, p_stack, actual_stacksize, ABT_TRUE);
+    ABTI_VALGRIND_STACK_REGISTER(p_thread);
 
     *p_stacksize = actual_stacksize;
     return p_thread;
 }
 
 static inline
-ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
+ABTI_thread *ABTI_mem_alloc_thread(ABTI_local *p_local, ABT_thread_attr attr,
+                                   size_t *p_stacksize)
 {
     ABTI_thread *p_thread;
+    ABTI_UNUSED(p_local);
 
     if (attr == ABT_THREAD_ATTR_NULL) {
         *p_stacksize = ABTI_global_get_thread_stacksize();
@@ -432,6 +746,7 @@ ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
         ABTI_thread_attr_copy(&p_thread->attr, p_attr);
         p_thread->attr.stacksize -= sizeof(ABTI_thread);
         p_thread->attr.p_stack = (void *)(p_blk + sizeof(ABTI_thread));
+        ABTI_VALGRIND_STACK_REGISTER(p_thread);
 
     } else {
         /* Since the stack is given by the user, we create ABTI_thread
@@ -445,6 +760,18 @@ ABTI_thread *ABTI_mem_alloc_thread(ABT_thread_attr attr, size_t *p_stacksize)
     return p_thread;
 }
 
+static inline
+size_t ABTI_mem_get_thread_stacksize(size_t stacksize)
+{
+    return stacksize - sizeof(ABTI_thread);
+}
+
+static inline
+size_t ABTI_mem_get_context_stacksize(ABTI_thread *p_thread)
+{
+    return p_thread->attr.stacksize;
+}
+
 static inline
 ABTI_thread *ABTI_mem_alloc_main_thread(ABT_thread_attr attr)
 {
@@ -463,21 +790,44 @@ ABTI_thread *ABTI_mem_alloc_main_thread(ABT_thread_attr attr)
 static inline
 void ABTI_mem_free_thread(ABTI_thread *p_thread)
 {
+    ABTI_VALGRIND_STACK_DEREGISTER(p_thread);
     ABTU_free(p_thread);
 }
 
 static inline
-ABTI_task *ABTI_mem_alloc_task(void)
+ABTI_task *ABTI_mem_alloc_task(ABTI_local *p_local)
 {
+    ABTI_UNUSED(p_local);
     return (ABTI_task *)ABTU_CA_MALLOC(sizeof(ABTI_task));
 }
 
+static inline
+void ABTI_mem_alloc_tasks(ABTI_local *p_local, int num, ABTI_task **p_tasks)
+{
+    int i;
+    for (i = 0; i < num; i++) p_tasks[i] = ABTI_mem_alloc_task(p_local);
+}
+
 static inline
 void ABTI_mem_free_task(ABTI_task *p_task)
 {
     ABTU_free(p_task);
 }
 
+static inline
+void *ABTI_mem_alloc_user(ABTI_local *p_local, size_t size)
+{
+    ABTI_UNUSED(p_local);
+    return ABTU_malloc(size);
+}
+
+static inline
+void ABTI_mem_free_user(ABTI_local *p_local, void *ptr)
+{
+    ABTI_UNUSED(p_local);
+    ABTU_free(ptr);
+}
+
 #endif /* ABT_CONFIG_USE_MEM_POOL */
 
 #endif /* ABTI_MEM_H_INCLUDED */
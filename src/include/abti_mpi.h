@@ -0,0 +1,20 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTI_MPI_H_INCLUDED
+#define ABTI_MPI_H_INCLUDED
+
+/* Inlined functions for MPI waits */
+
+/* Called by the schedulers through ABTI_xstream_check_events() */
+static inline
+void ABTI_mpi_poller_check(ABTI_mpi_poller *p_poller)
+{
+    if (p_poller->num_waiters > 0) {
+        ABTI_mpi_poller_poll(p_poller);
+    }
+}
+
+#endif /* ABTI_MPI_H_INCLUDED */
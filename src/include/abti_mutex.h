@@ -91,6 +91,18 @@ void ABTI_mutex_init(ABTI_mutex *p_mutex)
     p_mutex->attr.attrs = ABTI_MUTEX_ATTR_NONE;
     p_mutex->attr.max_handovers = ABTI_global_get_mutex_max_handovers();
     p_mutex->attr.max_wakeups = ABTI_global_get_mutex_max_wakeups();
+    p_mutex->p_timed_head = NULL;
+    p_mutex->p_timed_tail = NULL;
+    p_mutex->p_holder_xstream = NULL;
+    p_mutex->hold_start = 0.0;
+    p_mutex->avg_hold_time = 0.0;
+    p_mutex->num_locks = 0;
+    p_mutex->num_contended = 0;
+    p_mutex->num_spins = 0;
+    p_mutex->num_parks = 0;
+    ABTI_spinlock_create(&p_mutex->pi_lock);
+    p_mutex->p_pi_owner = NULL;
+    p_mutex->pi_priority = 0;
 #ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
     p_mutex->p_htable = ABTI_thread_htable_create(gp_ABTI_global->max_xstreams);
     p_mutex->p_handover = NULL;
@@ -115,6 +127,64 @@ void ABTI_mutex_spinlock(ABTI_mutex *p_mutex)
     LOG_EVENT("%p: spinlock\n", p_mutex);
 }
 
+/* Adaptive mutex.  The holder measures how long it keeps the mutex, and a
+ * contender spins for about twice the average hold time before it parks in
+ * p_htable.  Contenders do not spin when holders are slow or when the holder
+ * is running on the same ES, since it cannot release the mutex meanwhile. */
+static inline
+ABT_bool ABTI_mutex_spin_adaptive(ABTI_mutex *p_mutex)
+{
+    double avg = p_mutex->avg_hold_time;
+    double limit;
+    int i;
+
+    if (avg > ABTI_MUTEX_SPIN_MAX_HOLD) return ABT_FALSE;
+    if (*(ABTI_xstream * volatile *)&p_mutex->p_holder_xstream
+        == ABTI_local_get_xstream()) {
+        return ABT_FALSE;
+    }
+
+    limit = ABT_get_wtime() + 2.0 * avg;
+    do {
+        for (i = 0; i < ABTI_MUTEX_SPIN_CHECK; i++) {
+            if (*(volatile uint32_t *)&p_mutex->val == 0 &&
+                ABTD_atomic_cas_uint32(&p_mutex->val, 0, 1) == 0) {
+                return ABT_TRUE;
+            }
+            ABTD_atomic_pause();
+        }
+    } while (ABT_get_wtime() < limit);
+    return ABT_FALSE;
+}
+
+/* Called by a new holder of an adaptive mutex */
+static inline
+void ABTI_mutex_acquired_adaptive(ABTI_mutex *p_mutex, ABT_bool contended,
+                                  uint32_t num_parks)
+{
+    p_mutex->num_locks++;
+    if (contended == ABT_TRUE) {
+        p_mutex->num_contended++;
+        if (num_parks == 0) p_mutex->num_spins++;
+    }
+    p_mutex->num_parks += num_parks;
+    p_mutex->p_holder_xstream = lp_ABTI_local ? ABTI_local_get_xstream()
+                                              : NULL;
+    p_mutex->hold_start = ABT_get_wtime();
+}
+
+/* Called by the holder of an adaptive mutex before it releases the mutex */
+static inline
+void ABTI_mutex_release_adaptive(ABTI_mutex *p_mutex)
+{
+    if (p_mutex->hold_start != 0.0) {
+        double hold = ABT_get_wtime() - p_mutex->hold_start;
+        p_mutex->avg_hold_time += (hold - p_mutex->avg_hold_time) / 8.0;
+        p_mutex->hold_start = 0.0;
+    }
+    p_mutex->p_holder_xstream = NULL;
+}
+
 static inline
 void ABTI_mutex_lock(ABTI_mutex *p_mutex)
 {
@@ -140,12 +210,21 @@ void ABTI_mutex_lock(ABTI_mutex *p_mutex)
     if (type == ABT_UNIT_TYPE_THREAD) {
         LOG_EVENT("%p: lock - try\n", p_mutex);
         int c;
-        if ((c = ABTD_atomic_cas_uint32(&p_mutex->val, 0, 1)) != 0) {
+        ABT_bool adaptive = (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_ADAPTIVE)
+                          ? ABT_TRUE : ABT_FALSE;
+        uint32_t num_parks = 0;
+        ABT_bool contended;
+        c = ABTD_atomic_cas_uint32(&p_mutex->val, 0, 1);
+        contended = (c != 0) ? ABT_TRUE : ABT_FALSE;
+        if (contended == ABT_TRUE &&
+            (adaptive == ABT_FALSE ||
+             ABTI_mutex_spin_adaptive(p_mutex) == ABT_FALSE)) {
             if (c != 2) {
                 c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
             }
             while (c != 0) {
                 ABTI_mutex_wait(p_mutex, 2);
+                num_parks++;
 
                 /* If the mutex has been handed over to the current ULT from
                  * other ULT on the same ES, we don't need to change the mutex
@@ -168,6 +247,9 @@ void ABTI_mutex_lock(ABTI_mutex *p_mutex)
                 c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
             }
         }
+        if (adaptive == ABT_TRUE) {
+            ABTI_mutex_acquired_adaptive(p_mutex, contended, num_parks);
+        }
         LOG_EVENT("%p: lock - acquired\n", p_mutex);
     } else {
         ABTI_mutex_spinlock(p_mutex);
@@ -188,12 +270,18 @@ int ABTI_mutex_trylock(ABTI_mutex *p_mutex)
     if (ABTD_atomic_cas_uint32(&p_mutex->val, 0, 1) != 0) {
         return ABT_ERR_MUTEX_LOCKED;
     }
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_ADAPTIVE) {
+        ABTI_mutex_acquired_adaptive(p_mutex, ABT_FALSE, 0);
+    }
     return ABT_SUCCESS;
 }
 
 static inline
 void ABTI_mutex_unlock(ABTI_mutex *p_mutex)
 {
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_ADAPTIVE) {
+        ABTI_mutex_release_adaptive(p_mutex);
+    }
 #ifdef ABT_CONFIG_USE_SIMPLE_MUTEX
     ABTD_atomic_mem_barrier();
     *(volatile uint32_t *)&p_mutex->val = 0;
@@ -9,6 +9,7 @@
 /* Inlined functions for Pool */
 
 static inline ABTI_xstream *ABTI_xstream_self(void);
+static inline void ABTI_pool_group_set(ABTI_pool *p_pool);
 
 static inline
 ABTI_pool *ABTI_pool_get_ptr(ABT_pool pool)
@@ -42,6 +43,318 @@ ABT_pool ABTI_pool_get_handle(ABTI_pool *p_pool)
 #endif
 }
 
+/* Data of a pool without the handle check of ABT_pool_get_data().  This is
+ * only for the pool operations, which are never given ABT_POOL_NULL. */
+static inline
+void *ABTI_pool_get_data(ABT_pool pool)
+{
+    return ((ABTI_pool *)pool)->data;
+}
+
+
+/* FIFO pool operations, called without the lock for ABT_POOL_ACCESS_PRIV */
+
+static inline
+void ABTI_pool_fifo_push(ABTI_pool_fifo_data *p_data, ABT_pool pool,
+                         ABT_unit unit)
+{
+    ABTI_unit *p_unit = (ABTI_unit *)unit;
+
+    if (p_data->num_units == 0) {
+        p_unit->p_prev = p_unit;
+        p_unit->p_next = p_unit;
+        p_data->p_head = p_unit;
+        p_data->p_tail = p_unit;
+    } else {
+        ABTI_unit *p_head = p_data->p_head;
+        ABTI_unit *p_tail = p_data->p_tail;
+        p_tail->p_next = p_unit;
+        p_head->p_prev = p_unit;
+        p_unit->p_prev = p_tail;
+        p_unit->p_next = p_head;
+        p_data->p_tail = p_unit;
+    }
+    p_data->num_units++;
+
+    p_unit->pool = pool;
+}
+
+static inline
+ABT_unit ABTI_pool_fifo_pop(ABTI_pool_fifo_data *p_data)
+{
+    ABTI_unit *p_unit;
+
+    if (p_data->num_units == 0) return ABT_UNIT_NULL;
+
+    p_unit = p_data->p_head;
+    if (p_data->num_units == 1) {
+        p_data->p_head = NULL;
+        p_data->p_tail = NULL;
+    } else {
+        p_unit->p_prev->p_next = p_unit->p_next;
+        p_unit->p_next->p_prev = p_unit->p_prev;
+        p_data->p_head = p_unit->p_next;
+    }
+    p_data->num_units--;
+
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool = ABT_POOL_NULL;
+
+    return (ABT_unit)p_unit;
+}
+
+/* Remove a unit that is in the list */
+static inline
+void ABTI_pool_fifo_unlink(ABTI_pool_fifo_data *p_data, ABTI_unit *p_unit)
+{
+    if (p_data->num_units == 1) {
+        p_data->p_head = NULL;
+        p_data->p_tail = NULL;
+    } else {
+        p_unit->p_prev->p_next = p_unit->p_next;
+        p_unit->p_next->p_prev = p_unit->p_prev;
+        if (p_unit == p_data->p_head) {
+            p_data->p_head = p_unit->p_next;
+        } else if (p_unit == p_data->p_tail) {
+            p_data->p_tail = p_unit->p_prev;
+        }
+    }
+    p_data->num_units--;
+
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool = ABT_POOL_NULL;
+}
+
+static inline
+void ABTI_pool_fifo_push_shared(ABTI_pool_fifo_data *p_data, ABT_pool pool,
+                                ABT_unit unit)
+{
+    ABTI_pool_stats_lock(ABTI_pool_get_ptr(pool), &p_data->mutex);
+    ABTI_pool_fifo_push(p_data, pool, unit);
+    ABTI_spinlock_release(&p_data->mutex);
+}
+
+static inline
+ABT_unit ABTI_pool_fifo_pop_shared(ABTI_pool_fifo_data *p_data, ABT_pool pool)
+{
+    ABT_unit unit;
+
+    /* Do not take the lock for an empty pool, which idle schedulers poll. */
+    if (p_data->num_units == 0) return ABT_UNIT_NULL;
+
+    ABTI_pool_stats_lock(ABTI_pool_get_ptr(pool), &p_data->mutex);
+    unit = ABTI_pool_fifo_pop(p_data);
+    ABTI_spinlock_release(&p_data->mutex);
+    return unit;
+}
+
+
+/* FIFO pool operations for ABT_POOL_ACCESS_PRIV.  The ES that pops from the
+ * pool owns it and pushes to the list without atomics.  The others push to
+ * the inbox with one atomic exchange, which never waits.  A unit whose link
+ * is still ABTI_POOL_FIFO_INBOX_PENDING has been pushed but is not linked to
+ * the next one yet.  The owner takes all the units of the inbox at once and
+ * moves them to the list in the order they were pushed. */
+
+#define ABTI_POOL_FIFO_INBOX_PENDING    ((ABTI_unit *)1)
+
+static inline
+void ABTI_pool_fifo_push_inbox(ABTI_pool_fifo_data *p_data, ABT_pool pool,
+                               ABT_unit unit)
+{
+    ABTI_unit *p_unit = (ABTI_unit *)unit;
+
+    p_unit->pool = pool;
+    p_unit->p_prev = NULL;
+    p_unit->p_next = ABTI_POOL_FIFO_INBOX_PENDING;
+    /* Count the unit first so that the size never misses it. */
+    ABTD_atomic_fetch_add_uint32(&p_data->num_inbox, 1);
+    p_unit->p_next = (ABTI_unit *)ABTD_atomic_exchange_ptr(&p_data->p_inbox,
+                                                           p_unit);
+}
+
+static inline
+void ABTI_pool_fifo_drain_inbox(ABTI_pool_fifo_data *p_data)
+{
+    ABTI_unit *p_unit, *p_first = NULL;
+    uint32_t num = 0;
+
+    p_unit = (ABTI_unit *)ABTD_atomic_exchange_ptr(&p_data->p_inbox, NULL);
+    while (p_unit != NULL) {
+        ABTI_unit *p_next;
+        while ((p_next = *(ABTI_unit * volatile *)&p_unit->p_next)
+               == ABTI_POOL_FIFO_INBOX_PENDING) {
+            ABTD_atomic_pause();
+        }
+        p_unit->p_next = p_first;
+        p_first = p_unit;
+        p_unit = p_next;
+        num++;
+    }
+    while (p_first != NULL) {
+        p_unit = p_first;
+        p_first = p_unit->p_next;
+        ABTI_pool_fifo_push(p_data, p_unit->pool, (ABT_unit)p_unit);
+    }
+    ABTD_atomic_fetch_sub_uint32(&p_data->num_inbox, num);
+}
+
+static inline
+ABT_bool ABTI_pool_fifo_is_owner(ABTI_pool_fifo_data *p_data,
+                                 ABTI_xstream *p_xstream)
+{
+    return (p_xstream != NULL && p_data->p_owner == p_xstream)
+         ? ABT_TRUE : ABT_FALSE;
+}
+
+/* The caller becomes the owner and takes the units of the inbox. */
+static inline
+void ABTI_pool_fifo_own(ABTI_pool_fifo_data *p_data, ABTI_xstream *p_xstream)
+{
+    if (p_data->p_owner != p_xstream) p_data->p_owner = p_xstream;
+    if (*(void * volatile *)&p_data->p_inbox != NULL) {
+        ABTI_pool_fifo_drain_inbox(p_data);
+    }
+}
+
+static inline
+void ABTI_pool_fifo_push_priv(ABTI_pool_fifo_data *p_data, ABT_pool pool,
+                              ABT_unit unit)
+{
+    if (ABTI_pool_fifo_is_owner(p_data, ABTI_xstream_self()) == ABT_TRUE) {
+        ABTI_pool_fifo_push(p_data, pool, unit);
+    } else {
+        ABTI_pool_fifo_push_inbox(p_data, pool, unit);
+    }
+}
+
+static inline
+ABT_unit ABTI_pool_fifo_pop_priv(ABTI_pool_fifo_data *p_data,
+                                 ABTI_xstream *p_xstream)
+{
+    ABTI_pool_fifo_own(p_data, p_xstream);
+    return ABTI_pool_fifo_pop(p_data);
+}
+
+static inline
+size_t ABTI_pool_fifo_get_size_priv(ABTI_pool_fifo_data *p_data)
+{
+    return p_data->num_units + *(volatile uint32_t *)&p_data->num_inbox;
+}
+
+
+/* Calls of the pool operations.  The built-in pools are inlined, and the
+ * others go through the function pointers.  For a user pool with embedded
+ * units, the pool field of a unit is set here (ABTI_POOL_UNITS_TRACKED). */
+
+static inline
+size_t ABTI_pool_call_get_size(ABTI_pool *p_pool)
+{
+    switch (p_pool->builtin) {
+        case ABTI_POOL_BUILTIN_FIFO_PRIV:
+            return ABTI_pool_fifo_get_size_priv(
+                    (ABTI_pool_fifo_data *)p_pool->data);
+        case ABTI_POOL_BUILTIN_FIFO_SHARED:
+            return ((ABTI_pool_fifo_data *)p_pool->data)->num_units;
+        default:
+            return p_pool->p_get_size(ABTI_pool_get_handle(p_pool));
+    }
+}
+
+static inline
+void ABTI_pool_call_push(ABTI_pool *p_pool, ABT_unit unit)
+{
+    ABT_pool pool = ABTI_pool_get_handle(p_pool);
+    ABTI_pool_fifo_data *p_data = (ABTI_pool_fifo_data *)p_pool->data;
+
+    ABTI_pool_stats_add(p_pool, ABTI_POOL_STATS_PUSH, 1);
+    switch (p_pool->builtin) {
+        case ABTI_POOL_BUILTIN_FIFO_PRIV:
+            ABTI_pool_fifo_push_priv(p_data, pool, unit);
+            break;
+        case ABTI_POOL_BUILTIN_FIFO_SHARED:
+            ABTI_pool_fifo_push_shared(p_data, pool, unit);
+            break;
+        default:
+            if (p_pool->units == ABTI_POOL_UNITS_TRACKED) {
+                ((ABTI_unit *)unit)->pool = pool;
+            }
+            p_pool->p_push(pool, unit);
+            break;
+    }
+    ABTI_pool_group_set(p_pool);
+}
+
+static inline
+ABT_unit ABTI_pool_call_pop(ABTI_pool *p_pool)
+{
+    ABTI_pool_fifo_data *p_data = (ABTI_pool_fifo_data *)p_pool->data;
+    ABT_pool pool = ABTI_pool_get_handle(p_pool);
+    ABTI_xstream *p_recorder = ABTI_record_pop_begin();
+    ABT_unit unit;
+
+    switch (p_pool->builtin) {
+        case ABTI_POOL_BUILTIN_FIFO_PRIV:
+            unit = ABTI_pool_fifo_pop_priv(p_data, ABTI_xstream_self());
+            break;
+        case ABTI_POOL_BUILTIN_FIFO_SHARED:
+            unit = ABTI_pool_fifo_pop_shared(p_data, pool);
+            break;
+        default:
+            unit = p_pool->p_pop(pool);
+            if (p_pool->units == ABTI_POOL_UNITS_TRACKED &&
+                unit != ABT_UNIT_NULL) {
+                ((ABTI_unit *)unit)->pool = ABT_POOL_NULL;
+            }
+            break;
+    }
+    ABTI_pool_stats_pop(p_pool, unit);
+    ABTI_record_pop_end(p_recorder, unit);
+    return unit;
+}
+
+/* Remove out_unit from a built-in FIFO pool and push in_unit to it in one
+ * step, i.e., under one lock for a shared pool.  Returns ABT_FALSE without
+ * changing the pool if out_unit is not in the pool or the pool is not a
+ * built-in one. */
+static inline
+ABT_bool ABTI_pool_call_swap(ABTI_pool *p_pool, ABT_unit out_unit,
+                             ABT_unit in_unit)
+{
+    ABTI_pool_fifo_data *p_data = (ABTI_pool_fifo_data *)p_pool->data;
+    ABT_pool pool = ABTI_pool_get_handle(p_pool);
+    ABT_bool swapped = ABT_FALSE;
+
+    switch (p_pool->builtin) {
+        case ABTI_POOL_BUILTIN_FIFO_PRIV:
+            /* out_unit may be in the inbox. */
+            ABTI_pool_fifo_own(p_data, ABTI_xstream_self());
+            if (((ABTI_unit *)out_unit)->pool == pool) {
+                ABTI_pool_fifo_unlink(p_data, (ABTI_unit *)out_unit);
+                ABTI_pool_fifo_push(p_data, pool, in_unit);
+                swapped = ABT_TRUE;
+            }
+            break;
+        case ABTI_POOL_BUILTIN_FIFO_SHARED:
+            ABTI_pool_stats_lock(p_pool, &p_data->mutex);
+            if (((ABTI_unit *)out_unit)->pool == pool) {
+                ABTI_pool_fifo_unlink(p_data, (ABTI_unit *)out_unit);
+                ABTI_pool_fifo_push(p_data, pool, in_unit);
+                swapped = ABT_TRUE;
+            }
+            ABTI_spinlock_release(&p_data->mutex);
+            break;
+        default:
+            break;
+    }
+    if (swapped == ABT_TRUE) {
+        ABTI_pool_stats_add(p_pool, ABTI_POOL_STATS_PUSH, 1);
+    }
+    return swapped;
+}
+
 /* A ULT is blocked and is waiting for going back to this pool */
 static inline
 void ABTI_pool_inc_num_blocked(ABTI_pool *p_pool)
@@ -70,14 +383,91 @@ void ABTI_pool_dec_num_migrations(ABTI_pool *p_pool)
     ABTD_atomic_fetch_sub_int32(&p_pool->num_migrations, 1);
 }
 
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+/* Bit of parked_mask for p_xstream, or 0 if it does not have a doorbell */
+static inline
+uint64_t ABTI_sched_doorbell_bit(ABTI_xstream *p_xstream)
+{
+    return (p_xstream->rank < ABTI_SCHED_NUM_DOORBELLS)
+         ? (1ULL << p_xstream->rank) : 0;
+}
+
+/* Wake up the ESs parked on the doorbells of the ranks in mask */
+static inline
+void ABTI_sched_ring_doorbells(uint64_t mask)
+{
+    while (mask != 0) {
+        uint32_t *p_seq =
+            &gp_ABTI_global->p_doorbells[__builtin_ctzll(mask)].seq;
+        ABTD_atomic_fetch_add_uint32(p_seq, 1);
+        ABTD_futex_wake_all(p_seq);
+        mask &= mask - 1;
+    }
+}
+
+/* Wake up all parked schedulers */
+static inline
+void ABTI_sched_wake_parked(void)
+{
+    uint64_t mask = *(volatile uint64_t *)&gp_ABTI_global->parked_mask;
+    ABTI_sched_ring_doorbells(mask);
+    if (gp_ABTI_global->num_parked > (uint32_t)__builtin_popcountll(mask)) {
+        ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->park_seq, 1);
+        ABTD_futex_wake_all(&gp_ABTI_global->park_seq);
+    }
+}
+
+/* A scheduler whose doorbell bit is bit parks on p_pool.  The bit is set
+ * before the count is incremented and cleared after it is decremented, so a
+ * pusher that sees more parked schedulers than bits knows that some of them
+ * do not have doorbells. */
+static inline
+void ABTI_pool_add_parked(ABTI_pool *p_pool, uint64_t bit)
+{
+    if (bit != 0) ABTD_atomic_fetch_or_uint64(&p_pool->parked_mask, bit);
+    ABTD_atomic_fetch_add_uint32(&p_pool->num_parked, 1);
+}
+
+static inline
+void ABTI_pool_remove_parked(ABTI_pool *p_pool, uint64_t bit)
+{
+    ABTD_atomic_fetch_sub_uint32(&p_pool->num_parked, 1);
+    if (bit != 0) ABTD_atomic_fetch_and_uint64(&p_pool->parked_mask, ~bit);
+}
+
+/* Wake up the schedulers parked on p_pool after a unit has been pushed.  Only
+ * the ESs parked on this pool are woken up, and nothing but a load is done if
+ * there is none. */
+static inline
+void ABTI_pool_unpark(ABTI_pool *p_pool)
+{
+    /* Pairs with ABTI_pool_add_parked() in ABTI_sched_park */
+    ABTD_atomic_mem_barrier();
+    if (p_pool->num_parked > 0) {
+        uint64_t mask = *(volatile uint64_t *)&p_pool->parked_mask;
+        if (p_pool->num_parked > (uint32_t)__builtin_popcountll(mask)) {
+            ABTI_sched_wake_parked();
+        } else {
+            ABTI_sched_ring_doorbells(mask);
+        }
+    }
+}
+#define ABTI_POOL_UNPARK(p_pool)    ABTI_pool_unpark(p_pool)
+#else
+#define ABTI_POOL_UNPARK(p_pool)
+#endif
+
 #ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
 static inline
 void ABTI_pool_push(ABTI_pool *p_pool, ABT_unit unit)
 {
     LOG_EVENT_POOL_PUSH(p_pool, unit, ABTI_xstream_self());
+    ABTI_trace_unit(ABTI_TRACE_PUSH, p_pool, unit);
+    ABTI_unit_stats_push(p_pool, unit);
 
     /* Push unit into pool */
-    p_pool->p_push(ABTI_pool_get_handle(p_pool), unit);
+    ABTI_pool_call_push(p_pool, unit);
+    ABTI_POOL_UNPARK(p_pool);
 }
 
 static inline
@@ -104,13 +494,16 @@ int ABTI_pool_push(ABTI_pool *p_pool, ABT_unit unit, ABTI_xstream *p_producer)
     int abt_errno = ABT_SUCCESS;
 
     LOG_EVENT_POOL_PUSH(p_pool, unit, p_producer);
+    ABTI_trace_unit(ABTI_TRACE_PUSH, p_pool, unit);
+    ABTI_unit_stats_push(p_pool, unit);
 
     /* Save the producer ES information in the pool */
     abt_errno = ABTI_pool_set_producer(p_pool, p_producer);
     ABTI_CHECK_ERROR(abt_errno);
 
     /* Push unit into pool */
-    p_pool->p_push(ABTI_pool_get_handle(p_pool), unit);
+    ABTI_pool_call_push(p_pool, unit);
+    ABTI_POOL_UNPARK(p_pool);
 
   fn_exit:
     return abt_errno;
@@ -164,6 +557,9 @@ int ABTI_pool_remove(ABTI_pool *p_pool, ABT_unit unit)
 
     abt_errno = p_pool->p_remove(ABTI_pool_get_handle(p_pool), unit);
     ABTI_CHECK_ERROR(abt_errno);
+    if (p_pool->units == ABTI_POOL_UNITS_TRACKED) {
+        ((ABTI_unit *)unit)->pool = ABT_POOL_NULL;
+    }
 
   fn_exit:
     return abt_errno;
@@ -191,6 +587,9 @@ int ABTI_pool_remove(ABTI_pool *p_pool, ABT_unit unit, ABTI_xstream *p_consumer)
 
     abt_errno = p_pool->p_remove(ABTI_pool_get_handle(p_pool), unit);
     ABTI_CHECK_ERROR(abt_errno);
+    if (p_pool->units == ABTI_POOL_UNITS_TRACKED) {
+        ((ABTI_unit *)unit)->pool = ABT_POOL_NULL;
+    }
 
   fn_exit:
     return abt_errno;
@@ -213,13 +612,10 @@ int ABTI_pool_remove(ABTI_pool *p_pool, ABT_unit unit, ABTI_xstream *p_consumer)
 static inline
 ABT_unit ABTI_pool_pop(ABTI_pool *p_pool)
 {
-#ifdef ABT_CONFIG_USE_DEBUG_LOG
-    ABT_unit unit = p_pool->p_pop(ABTI_pool_get_handle(p_pool));
+    ABT_unit unit = ABTI_pool_call_pop(p_pool);
     LOG_EVENT_POOL_POP(p_pool, unit);
+    ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
     return unit;
-#else
-    return p_pool->p_pop(ABTI_pool_get_handle(p_pool));
-#endif
 }
 
 /* Increase num_scheds to mark the pool as having another scheduler. If the
@@ -0,0 +1,49 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef POOL_GROUP_H_INCLUDED
+#define POOL_GROUP_H_INCLUDED
+
+/* Inlined functions for pool groups.  A set bit only means that the pool may
+ * have units, so a stale bit costs one failed pop.  A bit must not be clear
+ * while its pool has units, which the fences of ABTI_pool_group_set() and
+ * ABTI_pool_group_clear() guarantee: either the pusher sees the cleared bit
+ * and sets it again, or the scheduler sees the pushed unit. */
+
+/* Mark the pool as non-empty after a unit has been pushed to it */
+static inline
+void ABTI_pool_group_set(ABTI_pool *p_pool)
+{
+    ABTI_pool_group *p_group = p_pool->p_group;
+    if (p_group == NULL) return;
+
+    ABTD_atomic_mem_barrier();
+    if ((*(volatile uint64_t *)&p_group->nonempty & p_pool->group_mask) == 0) {
+        ABTD_atomic_fetch_or_uint64(&p_group->nonempty, p_pool->group_mask);
+    }
+}
+
+/* Clear the bit of the idx-th pool, which has been found empty */
+static inline
+void ABTI_pool_group_clear(ABTI_pool_group *p_group, int idx)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(p_group->pools[idx]);
+
+    ABTD_atomic_fetch_and_uint64(&p_group->nonempty, ~p_pool->group_mask);
+    ABTD_atomic_mem_barrier();
+    if (ABTI_pool_call_get_size(p_pool) > 0) {
+        ABTD_atomic_fetch_or_uint64(&p_group->nonempty, p_pool->group_mask);
+    }
+}
+
+/* Index of the first pool that may have units, or -1 if all are empty */
+static inline
+int ABTI_pool_group_find(ABTI_pool_group *p_group)
+{
+    return __builtin_ffsll((long long)*(volatile uint64_t *)&p_group->nonempty)
+           - 1;
+}
+
+#endif /* POOL_GROUP_H_INCLUDED */
@@ -0,0 +1,90 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef POOL_STATS_H_INCLUDED
+#define POOL_STATS_H_INCLUDED
+
+/* Inlined functions for the operation counters of pools.  They cost a check
+ * of the pool's p_stats if ABT_POOL_STATS is not set. */
+
+static inline
+void ABTI_pool_stats_add_slow(ABTI_pool_stats *p_stats, int kind, uint64_t n)
+{
+    ABTI_local *p_local = lp_ABTI_local;
+    uint64_t line = p_stats->num_lines - 1;
+
+    if (p_local != NULL && p_local->p_xstream != NULL &&
+        p_local->p_xstream->rank < line) {
+        /* Only this ES updates its own line. */
+        line = p_local->p_xstream->rank;
+        p_stats->p_counts[line * ABTI_POOL_STATS_STRIDE + kind] += n;
+    } else {
+        ABTD_atomic_fetch_add_uint64(
+            &p_stats->p_counts[line * ABTI_POOL_STATS_STRIDE + kind], n);
+    }
+}
+
+/* Add n to the counter kind (ABTI_POOL_STATS_*) of p_pool */
+static inline
+void ABTI_pool_stats_add(ABTI_pool *p_pool, int kind, uint64_t n)
+{
+    if (p_pool->p_stats == NULL) return;
+    ABTI_pool_stats_add_slow(p_pool->p_stats, kind, n);
+}
+
+/* Count a pop of p_pool, which found unit */
+static inline
+void ABTI_pool_stats_pop(ABTI_pool *p_pool, ABT_unit unit)
+{
+    if (p_pool->p_stats == NULL) return;
+    ABTI_pool_stats_add_slow(p_pool->p_stats,
+                             unit != ABT_UNIT_NULL ? ABTI_POOL_STATS_POP
+                                                   : ABTI_POOL_STATS_EMPTY_POP,
+                             1);
+}
+
+/* Count a pop of num units of p_pool by a batched operation */
+static inline
+void ABTI_pool_stats_pop_many(ABTI_pool *p_pool, size_t num)
+{
+    if (p_pool->p_stats == NULL) return;
+    if (num > 0) {
+        ABTI_pool_stats_add_slow(p_pool->p_stats, ABTI_POOL_STATS_POP, num);
+    } else {
+        ABTI_pool_stats_add_slow(p_pool->p_stats,
+                                 ABTI_POOL_STATS_EMPTY_POP, 1);
+    }
+}
+
+/* Take the lock of a pool, counting whether it had to wait */
+#ifndef ABT_CONFIG_USE_LOCK_PROFILE
+static inline
+void ABTI_pool_stats_lock(ABTI_pool *p_pool, ABTI_spinlock *p_lock)
+{
+    if (p_pool->p_stats == NULL) {
+        ABTI_spinlock_acquire(p_lock);
+    } else if (ABTI_spinlock_try_acquire(p_lock) == ABT_FALSE) {
+        ABTI_pool_stats_add_slow(p_pool->p_stats, ABTI_POOL_STATS_LOCK_WAIT,
+                                 1);
+        ABTI_spinlock_acquire(p_lock);
+    }
+}
+#else
+/* A macro, so that the lock profile reports the pool lock at the callers */
+#define ABTI_pool_stats_lock(p_pool, p_lock)                                \
+    do {                                                                    \
+        ABTI_pool *p_pool_ = (p_pool);                                      \
+        ABTI_spinlock *p_lock_ = (p_lock);                                  \
+        if (p_pool_->p_stats == NULL) {                                     \
+            ABTI_spinlock_acquire(p_lock_);                                 \
+        } else if (ABTI_spinlock_try_acquire(p_lock_) == ABT_FALSE) {       \
+            ABTI_pool_stats_add_slow(p_pool_->p_stats,                      \
+                                     ABTI_POOL_STATS_LOCK_WAIT, 1);         \
+            ABTI_spinlock_acquire(p_lock_);                                 \
+        }                                                                   \
+    } while (0)
+#endif
+
+#endif /* POOL_STATS_H_INCLUDED */
@@ -0,0 +1,62 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef RCU_H_INCLUDED
+#define RCU_H_INCLUDED
+
+/* Inlined functions for RCU */
+
+/* Record that p_xstream has seen the current epoch outside of read-side
+ * critical sections.  A ULT that has yielded in its critical section is still
+ * in it, so nothing is recorded then. */
+static inline
+void ABTI_rcu_report(ABTI_xstream *p_xstream)
+{
+    uint64_t epoch;
+
+    if (p_xstream->rcu_nesting != 0) return;
+    epoch = *(volatile uint64_t *)&gp_ABTI_global->rcu_epoch;
+    if (p_xstream->rcu_epoch != epoch) {
+        /* The reads of the critical sections are done before this. */
+        ABTD_atomic_mem_barrier();
+        *(volatile uint64_t *)&p_xstream->rcu_epoch = epoch;
+    }
+}
+
+/* Called by the schedulers through ABTI_xstream_check_events(), where no work
+ * unit is running */
+static inline
+void ABTI_rcu_quiescent(ABTI_xstream *p_xstream)
+{
+    ABTI_rcu_report(p_xstream);
+    if (p_xstream->p_rcu_head != NULL ||
+        *(ABTI_rcu_cb * volatile *)&gp_ABTI_global->p_rcu_orphans != NULL) {
+        ABTI_rcu_process(p_xstream);
+    }
+}
+
+/* p_xstream stops running work units for a while, e.g., to park, so grace
+ * periods do not wait for it and its callbacks are called by others. */
+static inline
+void ABTI_rcu_offline(ABTI_xstream *p_xstream)
+{
+    if (p_xstream->p_rcu_head != NULL) ABTI_rcu_xstream_park(p_xstream);
+    if (p_xstream->rcu_nesting != 0) return;
+    ABTD_atomic_mem_barrier();
+    *(volatile uint64_t *)&p_xstream->rcu_epoch = 0;
+}
+
+/* p_xstream may run work units again.  The epoch is published before any
+ * read of the following critical sections. */
+static inline
+void ABTI_rcu_online(ABTI_xstream *p_xstream)
+{
+    if (p_xstream->rcu_epoch != 0) return;
+    *(volatile uint64_t *)&p_xstream->rcu_epoch =
+        *(volatile uint64_t *)&gp_ABTI_global->rcu_epoch;
+    ABTD_atomic_mem_barrier();
+}
+
+#endif /* RCU_H_INCLUDED */
@@ -0,0 +1,104 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef RECORD_H_INCLUDED
+#define RECORD_H_INCLUDED
+
+/* Modes of ABTI_global.sched_record */
+#define ABTI_RECORD_OFF     0
+#define ABTI_RECORD_ON      1   /* Record the schedules (ABT_SCHED_RECORD) */
+#define ABTI_RECORD_REPLAY  2   /* Replay them (ABT_SCHED_REPLAY) */
+
+/* Or'ed with the ID of a tasklet in ABTI_record_entry.unit */
+#define ABTI_RECORD_TASK    (1ULL << 63)
+
+/* Inlined hooks of the schedule recorder (see record.c).  They cost a flag
+ * check unless schedules are recorded or replayed. */
+
+/* Called before a unit is popped from a pool.  While recording, the pops of
+ * all ESs are serialized so that their order is recorded exactly.  A pool
+ * may pop from other pools inside (e.g., a remote pool), so only the
+ * outermost pop takes the lock. */
+static inline
+ABTI_xstream *ABTI_record_pop_begin(void)
+{
+    ABTI_xstream *p_xstream;
+
+    if (gp_ABTI_global->sched_record != ABTI_RECORD_ON) return NULL;
+    if (lp_ABTI_local == NULL) return NULL;
+    p_xstream = lp_ABTI_local->p_xstream;
+    if (p_xstream == NULL || p_xstream->p_record == NULL) return NULL;
+
+    if (p_xstream->record_nesting++ == 0) {
+        ABTI_spinlock_acquire(&gp_ABTI_global->record_lock);
+    }
+    return p_xstream;
+}
+
+static inline
+void ABTI_record_pop_end(ABTI_xstream *p_xstream, ABT_unit unit)
+{
+    if (p_xstream == NULL) return;
+
+    if (unit != ABT_UNIT_NULL) {
+        p_xstream->record_seq = gp_ABTI_global->record_seq++;
+    }
+    if (--p_xstream->record_nesting == 0) {
+        ABTI_spinlock_release(&gp_ABTI_global->record_lock);
+    }
+}
+
+/* IDs are assigned when the units are created so that the same units get the
+ * same IDs when the schedule is replayed. */
+static inline
+void ABTI_record_create_thread(ABTI_thread *p_thread)
+{
+    if (gp_ABTI_global->sched_record == ABTI_RECORD_OFF) return;
+    ABTI_thread_get_id(p_thread);
+}
+
+static inline
+void ABTI_record_create_task(ABTI_task *p_task)
+{
+    if (gp_ABTI_global->sched_record == ABTI_RECORD_OFF) return;
+    ABTI_task_get_id(p_task);
+}
+
+/* Record that p_xstream runs a unit popped from p_pool */
+static inline
+void ABTI_record_thread(ABTI_xstream *p_xstream, ABTI_pool *p_pool,
+                        ABTI_thread *p_thread)
+{
+    if (gp_ABTI_global->sched_record != ABTI_RECORD_ON) return;
+    if (p_xstream->p_record == NULL) return;
+    ABTI_record_add(p_xstream, p_pool, ABTI_thread_get_id(p_thread),
+                    p_thread->p_pool);
+}
+
+static inline
+void ABTI_record_task(ABTI_xstream *p_xstream, ABTI_pool *p_pool,
+                      ABTI_task *p_task)
+{
+    if (gp_ABTI_global->sched_record != ABTI_RECORD_ON) return;
+    if (p_xstream->p_record == NULL) return;
+    ABTI_record_add(p_xstream, p_pool,
+                    ABTI_task_get_id(p_task) | ABTI_RECORD_TASK,
+                    p_task->p_pool);
+}
+
+/* Called by the predefined schedulers before they choose a pool.  While
+ * p_xstream has a schedule to replay, this runs its next decision, sets
+ * *p_run_cnt to the number of units run, and returns ABT_TRUE.  Otherwise,
+ * the scheduler follows its own policy. */
+static inline
+ABT_bool ABTI_record_replay_run(ABTI_xstream *p_xstream, ABTI_sched *p_sched,
+                                int *p_run_cnt)
+{
+    if (gp_ABTI_global->sched_record != ABTI_RECORD_REPLAY) return ABT_FALSE;
+    if (p_xstream->p_record == NULL) return ABT_FALSE;
+    return ABTI_record_replay(p_xstream, p_sched, p_run_cnt);
+}
+
+#endif /* RECORD_H_INCLUDED */
@@ -50,6 +50,8 @@ void ABTI_rwlock_init(ABTI_rwlock *p_rwlock)
     ABTI_cond_init(&p_rwlock->cond);
     p_rwlock->reader_count = 0;
     p_rwlock->write_flag = 0;
+    p_rwlock->num_slots = 0;
+    p_rwlock->p_slots = NULL;
 }
 
 static inline
@@ -57,6 +59,127 @@ void ABTI_rwlock_fini(ABTI_rwlock *p_rwlock)
 {
     ABTI_mutex_fini(&p_rwlock->mutex);
     ABTI_cond_fini(&p_rwlock->cond);
+    if (p_rwlock->p_slots) ABTU_free(p_rwlock->p_slots);
+}
+
+/* Reader-biased rwlock.  A reader only increments the counter of the slot
+ * that its work unit is hashed to, so readers on different ESs do not touch
+ * the same cache line.  A writer announces itself with write_flag under the
+ * mutex, which makes new readers fall back to waiting on the cond, and then
+ * drains the slots.  Since a ULT keeps its slot even when it migrates, the
+ * reader that unlocks always decrements the slot it incremented.
+ *
+ * write_flag is ABTI_RWLOCK_WRITER_WAIT while the writer drains the slots and
+ * ABTI_RWLOCK_WRITER_OWN once it holds the lock, so that unlock can tell
+ * writers from readers that still hold the lock during the drain. */
+#define ABTI_RWLOCK_WRITER_WAIT     1
+#define ABTI_RWLOCK_WRITER_OWN      2
+#define ABTI_RWLOCK_MAX_SLOTS       256
+
+static inline
+void ABTI_rwlock_init_biased(ABTI_rwlock *p_rwlock, uint32_t num_slots)
+{
+    uint32_t i;
+    ABTI_rwlock_init(p_rwlock);
+    p_rwlock->num_slots = num_slots;
+    p_rwlock->p_slots = (ABTI_rwlock_slot *)
+        ABTU_malloc_cache_aligned(num_slots * sizeof(ABTI_rwlock_slot));
+    for (i = 0; i < num_slots; i++) {
+        p_rwlock->p_slots[i].count = 0;
+    }
+}
+
+static inline
+ABTI_rwlock_slot *ABTI_rwlock_get_slot(ABTI_rwlock *p_rwlock)
+{
+    uint64_t key = 0;
+    if (lp_ABTI_local != NULL) {
+        ABTI_thread *p_thread = ABTI_local_get_thread();
+        key = p_thread ? (uint64_t)(uintptr_t)p_thread
+                       : (uint64_t)(uintptr_t)ABTI_local_get_task();
+    }
+    /* Fibonacci hashing; num_slots is a power of two. */
+    key = (key >> 6) * UINT64_C(0x9E3779B97F4A7C15);
+    return &p_rwlock->p_slots[(key >> 32) & (p_rwlock->num_slots - 1)];
+}
+
+static inline
+uint32_t ABTI_rwlock_count_readers(ABTI_rwlock *p_rwlock)
+{
+    uint32_t i, num_readers = 0;
+    for (i = 0; i < p_rwlock->num_slots; i++) {
+        num_readers += *(volatile uint32_t *)&p_rwlock->p_slots[i].count;
+    }
+    return num_readers;
+}
+
+static inline
+int ABTI_rwlock_rdlock_biased(ABTI_rwlock *p_rwlock)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_rwlock_slot *p_slot = ABTI_rwlock_get_slot(p_rwlock);
+
+    while (1) {
+        /* The atomic increment is a full barrier, so either the writer sees
+         * this reader when it drains the slots or this reader sees the flag. */
+        ABTD_atomic_fetch_add_uint32(&p_slot->count, 1);
+        if (*(volatile int *)&p_rwlock->write_flag == 0) break;
+        ABTD_atomic_fetch_sub_uint32(&p_slot->count, 1);
+
+        /* Wait until the writer releases the lock */
+        ABTI_mutex_lock(&p_rwlock->mutex);
+        while (p_rwlock->write_flag && abt_errno == ABT_SUCCESS) {
+            abt_errno = ABTI_cond_wait(&p_rwlock->cond, &p_rwlock->mutex);
+        }
+        ABTI_mutex_unlock(&p_rwlock->mutex);
+        if (abt_errno != ABT_SUCCESS) break;
+    }
+    return abt_errno;
+}
+
+static inline
+int ABTI_rwlock_wrlock_biased(ABTI_rwlock *p_rwlock)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_unit_type type;
+
+    ABTI_mutex_lock(&p_rwlock->mutex);
+    while (p_rwlock->write_flag && abt_errno == ABT_SUCCESS) {
+        abt_errno = ABTI_cond_wait(&p_rwlock->cond, &p_rwlock->mutex);
+    }
+    if (abt_errno == ABT_SUCCESS) {
+        p_rwlock->write_flag = ABTI_RWLOCK_WRITER_WAIT;
+        ABTD_atomic_mem_barrier();
+    }
+    ABTI_mutex_unlock(&p_rwlock->mutex);
+    if (abt_errno != ABT_SUCCESS) return abt_errno;
+
+    /* Wait for the readers that have already acquired the lock */
+    ABT_self_get_type(&type);
+    while (ABTI_rwlock_count_readers(p_rwlock) != 0) {
+        if (type == ABT_UNIT_TYPE_THREAD) {
+            ABT_thread_yield();
+        } else {
+            ABTD_atomic_pause();
+        }
+    }
+    p_rwlock->write_flag = ABTI_RWLOCK_WRITER_OWN;
+    ABTD_atomic_mem_barrier();
+    return abt_errno;
+}
+
+static inline
+void ABTI_rwlock_unlock_biased(ABTI_rwlock *p_rwlock)
+{
+    if (*(volatile int *)&p_rwlock->write_flag == ABTI_RWLOCK_WRITER_OWN) {
+        ABTI_mutex_lock(&p_rwlock->mutex);
+        p_rwlock->write_flag = 0;
+        ABTI_cond_broadcast(&p_rwlock->cond);
+        ABTI_mutex_unlock(&p_rwlock->mutex);
+    } else {
+        ABTD_atomic_fetch_sub_uint32(&ABTI_rwlock_get_slot(p_rwlock)->count,
+                                     1);
+    }
 }
 
 static inline
@@ -64,6 +187,8 @@ int ABTI_rwlock_rdlock(ABTI_rwlock *p_rwlock)
 {
     int abt_errno = ABT_SUCCESS;
 
+    if (p_rwlock->p_slots) return ABTI_rwlock_rdlock_biased(p_rwlock);
+
     ABTI_mutex_lock(&p_rwlock->mutex);
 
     while (p_rwlock->write_flag && abt_errno == ABT_SUCCESS) {
@@ -82,6 +207,8 @@ static inline
 int ABTI_rwlock_wrlock(ABTI_rwlock *p_rwlock)
 {
     int abt_errno = ABT_SUCCESS;
+    if (p_rwlock->p_slots) return ABTI_rwlock_wrlock_biased(p_rwlock);
+
     ABTI_mutex_lock(&p_rwlock->mutex);
 
     while ((p_rwlock->write_flag || p_rwlock->reader_count)
@@ -100,6 +227,11 @@ int ABTI_rwlock_wrlock(ABTI_rwlock *p_rwlock)
 static inline
 void ABTI_rwlock_unlock(ABTI_rwlock *p_rwlock)
 {
+    if (p_rwlock->p_slots) {
+        ABTI_rwlock_unlock_biased(p_rwlock);
+        return;
+    }
+
     ABTI_mutex_lock(&p_rwlock->mutex);
 
     if (p_rwlock->write_flag) {
@@ -53,10 +53,29 @@ int ABTI_sched_discard_and_free(ABTI_sched *p_sched)
     return abt_errno;
 }
 
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+void ABTI_sched_park(ABTI_sched *p_sched, const struct timespec *p_timeout);
+
+/* Wake up all parked schedulers, e.g., to let them handle a new request */
+static inline
+void ABTI_sched_unpark_all(void)
+{
+    /* Pairs with the increment of num_parked in ABTI_sched_park */
+    ABTD_atomic_mem_barrier();
+    if (gp_ABTI_global->num_parked > 0) {
+        ABTI_sched_wake_parked();
+    }
+}
+#define ABTI_SCHED_UNPARK_ALL()     ABTI_sched_unpark_all()
+#else
+#define ABTI_SCHED_UNPARK_ALL()
+#endif
+
 static inline
 void ABTI_sched_set_request(ABTI_sched *p_sched, uint32_t req)
 {
     ABTD_atomic_fetch_or_uint32(&p_sched->request, req);
+    ABTI_SCHED_UNPARK_ALL();
 }
 
 static inline
@@ -65,6 +84,36 @@ void ABTI_sched_unset_request(ABTI_sched *p_sched, uint32_t req)
     ABTD_atomic_fetch_and_uint32(&p_sched->request, ~req);
 }
 
+/* Contribution of p_pool to ABTI_sched_get_effective_size() */
+static inline
+size_t ABTI_sched_get_effective_pool_size(ABTI_pool *p_pool)
+{
+    size_t pool_size = ABTI_pool_call_get_size(p_pool) + p_pool->num_migrations;
+
+    switch (p_pool->access) {
+        case ABT_POOL_ACCESS_PRIV:
+            pool_size += p_pool->num_blocked;
+            break;
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+#ifdef ABT_CONFIG_DISABLE_POOL_CONSUMER_CHECK
+            if (p_pool->num_scheds == 1) {
+                pool_size += p_pool->num_blocked;
+            }
+#else
+            if (p_pool->num_scheds == 1 &&
+                p_pool->consumer == ABTI_local_get_xstream()) {
+                pool_size += p_pool->num_blocked;
+            }
+#endif
+            break;
+        default: break;
+    }
+    return pool_size;
+}
+
 static inline
 ABT_bool ABTI_sched_has_unit(ABTI_sched *p_sched)
 {
@@ -74,24 +123,246 @@ ABT_bool ABTI_sched_has_unit(ABTI_sched *p_sched)
     for (p = 0; p < p_sched->num_pools; p++) {
         ABT_pool pool = p_sched->pools[p];
         ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-        s = p_pool->p_get_size(pool);
+        s = ABTI_pool_call_get_size(p_pool);
         if (s > 0) return ABT_TRUE;
     }
 
     return ABT_FALSE;
 }
 
+static inline
+ABT_bool ABTI_sched_has_polling_unit(ABTI_sched *p_sched)
+{
+    int p;
+
+    for (p = 0; p < p_sched->num_polling_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->polling_pools[p]);
+        if (ABTI_pool_call_get_size(p_pool) > 0) return ABT_TRUE;
+    }
+
+    return ABT_FALSE;
+}
+
+/* Event frequency that a predefined scheduler uses after checking events.
+ * Without ABT_SCHED_AUTOTUNE, it is the scheduler's own event_freq, which
+ * also seeds the tuned value. */
+static inline
+uint32_t ABTI_sched_get_event_freq(ABTI_sched *p_sched, uint32_t event_freq)
+{
+    if (p_sched->tune.enabled == ABT_FALSE) return event_freq;
+    if (p_sched->tune.event_freq == 0) p_sched->tune.event_freq = event_freq;
+    return p_sched->tune.event_freq;
+}
+
+/* Adaptive idle policy of the predefined schedulers.  When an iteration of a
+ * scheduler finds no work, the ES first spins with an exponential backoff of
+ * pause instructions, then yields the CPU to the OS, and finally parks (or
+ * keeps yielding without ABT_CONFIG_USE_SCHED_SLEEP).  The lengths of the spin
+ * and yield phases follow the moving average of recent idle periods: when work
+ * usually comes back soon, the ES keeps spinning long enough to catch it, and
+ * when it does not, the ES stops burning the core quickly. */
+#define ABTI_SCHED_IDLE_MIN_SPIN        1.0e-6  /* in seconds */
+#define ABTI_SCHED_IDLE_MAX_SPIN        1.0e-4
+#define ABTI_SCHED_IDLE_MAX_YIELD       1.0e-3
+#define ABTI_SCHED_IDLE_MAX_BACKOFF     1024    /* # of pause instructions */
+
+typedef struct {
+    double start;               /* Start time of the idle period, or 0 */
+    double avg;                 /* Moving average of idle periods */
+    double spin_time;           /* Length of the spin phase */
+    double yield_time;          /* Length of the yield phase */
+    uint32_t backoff;           /* # of pause instructions in the next spin */
+    ABT_bool checked;           /* Whether events were checked before parking */
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    struct timespec park_time;  /* Maximum time of a park */
+#endif
+} ABTI_sched_idle;
+
+static inline
+void ABTI_sched_idle_init(ABTI_sched_idle *p_idle)
+{
+    p_idle->start = 0.0;
+    p_idle->avg = ABTI_SCHED_IDLE_MAX_SPIN;
+    p_idle->spin_time = ABTI_SCHED_IDLE_MAX_SPIN;
+    p_idle->yield_time = ABTI_SCHED_IDLE_MAX_YIELD;
+    p_idle->backoff = 1;
+    p_idle->checked = ABT_FALSE;
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    long nsec = ABTI_global_get_sched_sleep_nsec();
+    p_idle->park_time.tv_sec = nsec / 1000000000;
+    p_idle->park_time.tv_nsec = nsec % 1000000000;
+#endif
+}
+
+/* The scheduler has found work.  This ends the current idle period, if any,
+ * and adapts the thresholds to its length. */
+static inline
+void ABTI_sched_idle_reset(ABTI_sched_idle *p_idle)
+{
+    double idle, spin;
+
+    if (p_idle->start == 0.0) return;
+
+    idle = ABT_get_wtime() - p_idle->start;
+    p_idle->avg = (7.0 * p_idle->avg + idle) / 8.0;
+
+    /* Spin as long as twice the usual idle period if it is short enough. */
+    spin = 2.0 * p_idle->avg;
+    if (spin > ABTI_SCHED_IDLE_MAX_SPIN) spin = ABTI_SCHED_IDLE_MIN_SPIN;
+    if (spin < ABTI_SCHED_IDLE_MIN_SPIN) spin = ABTI_SCHED_IDLE_MIN_SPIN;
+    p_idle->spin_time = spin;
+    p_idle->yield_time = (p_idle->avg < ABTI_SCHED_IDLE_MAX_YIELD)
+                       ? ABTI_SCHED_IDLE_MAX_YIELD : 10.0 * spin;
+
+    p_idle->start = 0.0;
+    p_idle->backoff = 1;
+    p_idle->checked = ABT_FALSE;
+}
+
+/* Whether any pool of the scheduler has a unit to pop.  Unlike
+ * ABTI_sched_is_quiescent(), blocked and migrating units are not counted. */
+static inline
+ABT_bool ABTI_sched_has_ready_units(ABTI_sched *p_sched)
+{
+    int p;
+    for (p = 0; p < p_sched->num_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[p]);
+        if (ABTI_pool_call_get_size(p_pool) > 0) return ABT_TRUE;
+    }
+    return ABT_FALSE;
+}
+
+/* Whether an inline nested scheduler has to terminate once it is drained,
+ * i.e., it or the main scheduler of the ES has been asked to finish. */
+static inline
+ABT_bool ABTI_sched_is_finishing(ABTI_sched *p_sched, ABTI_xstream *p_xstream)
+{
+    uint32_t req = *(volatile uint32_t *)&p_sched->request;
+    uint32_t main_req = *(volatile uint32_t *)&p_xstream->p_main_sched->request;
+
+    if ((req | main_req) & (ABTI_SCHED_REQ_FINISH | ABTI_SCHED_REQ_EXIT)) {
+        return ABT_TRUE;
+    }
+    return ABT_FALSE;
+}
+
+/* Whether the parent can put the unit of an inline nested scheduler back
+ * into its pool without running it. */
+static inline
+ABT_bool ABTI_sched_is_idle_inline(ABTI_sched *p_sched,
+                                   ABTI_xstream *p_xstream)
+{
+    return (p_sched->inline_nested == ABT_TRUE &&
+            ABTI_sched_is_finishing(p_sched, p_xstream) == ABT_FALSE &&
+            ABTI_sched_has_ready_units(p_sched) == ABT_FALSE)
+           ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Whether ABTI_sched_has_to_stop() has stopped p_sched, in which case it has
+ * acquired the sched_lock of the ES and the caller of the run function of
+ * p_sched releases it. */
+static inline
+ABT_bool ABTI_sched_is_stopped(ABTI_sched *p_sched)
+{
+    return (p_sched->state == ABT_SCHED_STATE_STOPPED ||
+            p_sched->state == ABT_SCHED_STATE_TERMINATED)
+           ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Close the run-next slot of p_xstream if p_sched is its main scheduler and
+ * is about to terminate, so that no ULT is put into the slot after the
+ * scheduler has found it empty.  The caller holds the sched_lock of
+ * p_xstream.  Returns ABT_FALSE if a ULT has been put into the slot. */
+static inline
+ABT_bool ABTI_sched_close_run_next(ABTI_sched *p_sched, ABTI_xstream *p_xstream)
+{
+    if (p_sched != p_xstream->p_main_sched) return ABT_TRUE;
+    return (ABTD_atomic_cas_uint64((uint64_t *)&p_xstream->p_run_next, 0,
+                (uint64_t)(uintptr_t)ABTI_XSTREAM_RUN_NEXT_CLOSED) == 0)
+           ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Whether a join or exit request can be served now.  Such a request is
+ * handled by ABTI_xstream_check_events() and ABTI_sched_has_to_stop(), which
+ * the schedulers call only every event_freq iterations; without this, the
+ * caller of ABT_finalize() or ABT_xstream_join() waits for the whole backoff
+ * of the idle scheduler. */
+static inline
+ABT_bool ABTI_sched_idle_has_request(ABTI_sched *p_sched,
+                                     ABTI_xstream *p_xstream)
+{
+    uint32_t req = *(volatile uint32_t *)&p_xstream->request;
+    uint32_t sched_req = *(volatile uint32_t *)&p_sched->request;
+
+    if (sched_req & ABTI_SCHED_REQ_EXIT) return ABT_TRUE;
+    if (sched_req & ABTI_SCHED_REQ_FINISH) {
+        /* Blocked units keep the scheduler alive; back off as usual. */
+        return ABTI_sched_is_quiescent(p_sched, p_xstream);
+    }
+    /* Not yet forwarded to the scheduler by ABTI_xstream_check_events() */
+    if (req & (ABTI_XSTREAM_REQ_JOIN | ABTI_XSTREAM_REQ_EXIT |
+               ABTI_XSTREAM_REQ_CANCEL)) {
+        return ABT_TRUE;
+    }
+    return ABT_FALSE;
+}
+
+/* The scheduler has found no work.  Returns ABT_TRUE when the caller has to
+ * check events and whether it has to stop before the ES is parked. */
+static inline
+ABT_bool ABTI_sched_idle_wait(ABTI_sched *p_sched, ABTI_sched_idle *p_idle)
+{
+    ABTI_xstream *p_xstream = ABTI_local_get_xstream();
+    double now;
+    double elapsed;
+    uint32_t i;
+
+    p_xstream->stats.num_idle_loops++;
+    if (ABTI_sched_idle_has_request(p_sched, p_xstream) == ABT_TRUE) {
+        return ABT_TRUE;
+    }
+    /* An inline nested scheduler does not wait but returns to its parent. */
+    if (p_sched->inline_nested == ABT_TRUE) return ABT_TRUE;
+    /* Polling units run in place of spinning, sleeping, and parking. */
+    if (p_sched->num_polling_pools > 0 &&
+        ABTI_sched_run_polling(p_sched, p_xstream) == ABT_TRUE) {
+        return ABT_FALSE;
+    }
+
+    now = ABT_get_wtime();
+    if (p_idle->start == 0.0) p_idle->start = now;
+    elapsed = now - p_idle->start;
+
+    if (elapsed < p_idle->spin_time) {
+        for (i = 0; i < p_idle->backoff; i++) {
+            ABTD_atomic_pause();
+        }
+        if (p_idle->backoff < ABTI_SCHED_IDLE_MAX_BACKOFF) {
+            p_idle->backoff *= 2;
+        }
+        return ABT_FALSE;
+    }
+    if (elapsed < p_idle->spin_time + p_idle->yield_time) {
+        ABTD_xstream_context_yield();
+        return ABT_FALSE;
+    }
+    if (p_idle->checked == ABT_FALSE) {
+        p_idle->checked = ABT_TRUE;
+        return ABT_TRUE;
+    }
+    p_idle->checked = ABT_FALSE;
 #ifdef ABT_CONFIG_USE_SCHED_SLEEP
-#define CNT_DECL(c)         int c
-#define CNT_INIT(c,v)       c = v
-#define CNT_INC(c)          c++
-#define SCHED_SLEEP(c,t)    if (c == 0) nanosleep(&(t), NULL)
+    if (p_sched->tune.enabled == ABT_TRUE) {
+        long nsec = p_sched->tune.sleep_nsec;
+        p_idle->park_time.tv_sec = nsec / 1000000000;
+        p_idle->park_time.tv_nsec = nsec % 1000000000;
+    }
+    ABTI_sched_park(p_sched, &p_idle->park_time);
 #else
-#define CNT_DECL(c)
-#define CNT_INIT(c,v)
-#define CNT_INC(c)
-#define SCHED_SLEEP(c,t)
+    ABTD_xstream_context_yield();
 #endif
+    return ABT_FALSE;
+}
 
 #endif /* SCHED_H_INCLUDED */
 
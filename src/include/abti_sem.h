@@ -0,0 +1,43 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef SEM_H_INCLUDED
+#define SEM_H_INCLUDED
+
+/* Inlined functions for Semaphore */
+
+static inline
+ABTI_sem *ABTI_sem_get_ptr(ABT_sem sem)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_sem *p_sem;
+    if (sem == ABT_SEM_NULL) {
+        p_sem = NULL;
+    } else {
+        p_sem = (ABTI_sem *)sem;
+    }
+    return p_sem;
+#else
+    return (ABTI_sem *)sem;
+#endif
+}
+
+static inline
+ABT_sem ABTI_sem_get_handle(ABTI_sem *p_sem)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_sem h_sem;
+    if (p_sem == NULL) {
+        h_sem = ABT_SEM_NULL;
+    } else {
+        h_sem = (ABT_sem)p_sem;
+    }
+    return h_sem;
+#else
+    return (ABT_sem)p_sem;
+#endif
+}
+
+#endif /* SEM_H_INCLUDED */
@@ -6,14 +6,180 @@
 #ifndef SPINLOCK_H_INCLUDED
 #define SPINLOCK_H_INCLUDED
 
+/* A spinlock occupies a whole cache line so that waiters spinning on it do
+ * not interfere with the data protected by it. */
+#define ABTI_SPINLOCK_SIZE          ABT_CONFIG_CACHE_LINE_SIZE
+
+/* Backoff parameters in the number of pause instructions */
+#define ABTI_SPINLOCK_BACKOFF_MIN   4
+#define ABTI_SPINLOCK_BACKOFF_MAX   256
+
+#ifdef ABT_CONFIG_USE_TICKET_SPINLOCK
+
+/* Ticket lock: waiters are served in FIFO order, and each waiter backs off in
+ * proportion to the number of waiters ahead of it. */
+struct ABTI_spinlock {
+    uint32_t next;      /* Next ticket to be taken */
+    uint32_t serving;   /* Ticket of the current owner */
+    char pad[ABTI_SPINLOCK_SIZE - 2 * sizeof(uint32_t)];
+};
+
+static inline void ABTI_spinlock_create(ABTI_spinlock *p_lock)
+{
+    p_lock->next = 0;
+    p_lock->serving = 0;
+}
+
+static inline void ABTI_spinlock_free(ABTI_spinlock *p_lock)
+{
+    ABTI_UNUSED(p_lock);
+}
+
+static inline void ABTI_spinlock_acquire(ABTI_spinlock *p_lock)
+{
+    uint32_t ticket = ABTD_atomic_fetch_add_uint32(&p_lock->next, 1);
+    while (1) {
+        uint32_t serving = *(volatile uint32_t *)&p_lock->serving;
+        uint32_t i, backoff;
+        if (serving == ticket) break;
+
+        backoff = (ticket - serving) * ABTI_SPINLOCK_BACKOFF_MIN;
+        if (backoff > ABTI_SPINLOCK_BACKOFF_MAX) {
+            backoff = ABTI_SPINLOCK_BACKOFF_MAX;
+        }
+        for (i = 0; i < backoff; i++) {
+            ABTD_atomic_pause();
+        }
+    }
+    ABTD_compiler_barrier();
+}
+
+/* Take the lock only if nobody holds or waits for it */
+static inline ABT_bool ABTI_spinlock_try_acquire(ABTI_spinlock *p_lock)
+{
+    uint32_t serving = *(volatile uint32_t *)&p_lock->serving;
+    if (ABTD_atomic_cas_uint32(&p_lock->next, serving, serving + 1)
+        != serving) {
+        return ABT_FALSE;
+    }
+    ABTD_compiler_barrier();
+    return ABT_TRUE;
+}
+
+static inline void ABTI_spinlock_release(ABTI_spinlock *p_lock)
+{
+    ABTD_atomic_fetch_add_uint32(&p_lock->serving, 1);
+}
+
+#elif defined(ABT_CONFIG_USE_MCS_SPINLOCK)
+
+/* MCS queue lock in the K42 variant (see abti_mcs_lock.h): waiters are served
+ * in FIFO order, and each spins on a node on its own stack instead of the
+ * lock word.  The K42 variant keeps the owner's node in the lock itself, so
+ * the acquire(lock)/release(lock) interface is kept as is, and the lock can
+ * be released in another function than the one that has acquired it. */
+#include "abti_mcs_lock.h"
+
+struct ABTI_spinlock {
+    ABTI_mcs_lock lock;
+    char pad[ABTI_SPINLOCK_SIZE - sizeof(ABTI_mcs_lock)];
+};
+
+static inline void ABTI_spinlock_create(ABTI_spinlock *p_lock)
+{
+    ABTI_mcs_lock_create(&p_lock->lock);
+}
+
+static inline void ABTI_spinlock_free(ABTI_spinlock *p_lock)
+{
+    ABTI_UNUSED(p_lock);
+}
+
+static inline void ABTI_spinlock_acquire(ABTI_spinlock *p_lock)
+{
+    ABTI_mcs_lock_acquire(&p_lock->lock);
+}
+
+/* Take the lock only if nobody holds or waits for it */
+static inline ABT_bool ABTI_spinlock_try_acquire(ABTI_spinlock *p_lock)
+{
+    if (ABTI_mcs_lock_load(&p_lock->lock.p_tail) != NULL) return ABT_FALSE;
+    return (ABTI_mcs_lock_cas(&p_lock->lock.p_tail, NULL, &p_lock->lock)
+            == NULL) ? ABT_TRUE : ABT_FALSE;
+}
+
+static inline void ABTI_spinlock_release(ABTI_spinlock *p_lock)
+{
+    ABTI_mcs_lock_release(&p_lock->lock);
+}
+
+#else /* ABT_CONFIG_USE_TICKET_SPINLOCK */
+
+/* Test-and-test-and-set lock with exponential backoff */
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+struct ABTI_spinlock {
+    uint32_t val;
+    uint32_t elision_skip;  /* Acquisitions left before eliding again */
+    char pad[ABTI_SPINLOCK_SIZE - 2 * sizeof(uint32_t)];
+};
+#else
 struct ABTI_spinlock {
     uint32_t val;
+    char pad[ABTI_SPINLOCK_SIZE - sizeof(uint32_t)];
 };
+#endif
 
 static inline void ABTI_spinlock_create(ABTI_spinlock *p_lock)
 {
     p_lock->val = 0;
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+    p_lock->elision_skip = 0;
+#endif
+}
+
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+/* Lock elision: the critical section runs in a hardware transaction that only
+ * reads the lock word, so critical sections that do not conflict run in
+ * parallel and the lock line is not written.  A transaction is retried a few
+ * times if the processor says it may succeed.  When elision fails otherwise,
+ * the lock is taken normally for the next ABTI_SPINLOCK_ELISION_SKIP
+ * acquisitions, so critical sections that always abort, e.g., ones that make
+ * system calls, soon stop paying for the transactions. */
+#define ABTI_SPINLOCK_ELISION_RETRIES   3
+#define ABTI_SPINLOCK_ELISION_SKIP      16
+
+static inline void ABTI_spinlock_elision_count(ABT_bool committed);
+
+static inline ABT_bool ABTI_spinlock_elide(ABTI_spinlock *p_lock)
+{
+    int i;
+
+    if (!ABTD_htm_is_available()) return ABT_FALSE;
+    if (p_lock->elision_skip > 0) {
+        p_lock->elision_skip--;
+        return ABT_FALSE;
+    }
+
+    for (i = 0; i < ABTI_SPINLOCK_ELISION_RETRIES; i++) {
+        unsigned int status = ABTD_htm_begin();
+        if (status == ABTD_HTM_STARTED) {
+            /* Reading the lock word aborts the transaction when another
+             * thread takes the lock. */
+            if (*(volatile uint32_t *)&p_lock->val == 0) return ABT_TRUE;
+            ABTD_htm_abort();
+        }
+        ABTI_spinlock_elision_count(ABT_FALSE);
+        if ((status & ABTD_HTM_ABORT_EXPLICIT) &&
+            ABTD_HTM_ABORT_CODE(status) == ABTD_HTM_ABORT_BUSY) {
+            /* The lock is held, so wait for it normally. */
+            return ABT_FALSE;
+        }
+        if (!(status & ABTD_HTM_ABORT_RETRY)) break;
+    }
+    p_lock->elision_skip = ABTI_SPINLOCK_ELISION_SKIP;
+    return ABT_FALSE;
 }
+#endif /* ABT_CONFIG_USE_LOCK_ELISION */
 
 static inline void ABTI_spinlock_free(ABTI_spinlock *p_lock)
 {
@@ -22,16 +188,92 @@ static inline void ABTI_spinlock_free(ABTI_spinlock *p_lock)
 
 static inline void ABTI_spinlock_acquire(ABTI_spinlock *p_lock)
 {
+    uint32_t backoff = ABTI_SPINLOCK_BACKOFF_MIN;
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+    if (ABTI_spinlock_elide(p_lock) == ABT_TRUE) return;
+#endif
     while (ABTD_atomic_cas_uint32(&p_lock->val, 0, 1) != 0) {
         while (*(volatile uint32_t *)(&p_lock->val) != 0) {
+            uint32_t i;
+            for (i = 0; i < backoff; i++) {
+                ABTD_atomic_pause();
+            }
+            if (backoff < ABTI_SPINLOCK_BACKOFF_MAX) backoff <<= 1;
         }
     }
 }
 
+static inline ABT_bool ABTI_spinlock_try_acquire(ABTI_spinlock *p_lock)
+{
+    if (*(volatile uint32_t *)&p_lock->val != 0) return ABT_FALSE;
+    return (ABTD_atomic_cas_uint32(&p_lock->val, 0, 1) == 0)
+           ? ABT_TRUE : ABT_FALSE;
+}
+
 static inline void ABTI_spinlock_release(ABTI_spinlock *p_lock)
 {
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+    /* A free lock that is being released was elided by this thread. */
+    if (*(volatile uint32_t *)&p_lock->val == 0 && ABTD_htm_is_available() &&
+        ABTD_htm_test()) {
+        ABTD_htm_end();
+        ABTI_spinlock_elision_count(ABT_TRUE);
+        return;
+    }
+#endif
     *(volatile uint32_t *)&p_lock->val = 0;
     ABTD_atomic_mem_barrier();
 }
 
+#endif /* ABT_CONFIG_USE_TICKET_SPINLOCK */
+
+#ifdef ABT_CONFIG_USE_LOCK_PROFILE
+/* Lock profiling (--enable-lock-profile): every call site of
+ * ABTI_spinlock_acquire() gets a static record that counts the acquisitions,
+ * the contended ones, i.e., those that could not take the lock at once, and
+ * the cycles spent waiting in them.  A record is linked to a global list at
+ * its first use (see lock_profile.c).  The counters are updated atomically,
+ * so profiling adds a shared write per acquisition. */
+typedef struct ABTI_lock_site ABTI_lock_site;
+struct ABTI_lock_site {
+    const char *file;
+    const char *func;
+    int line;
+    uint32_t registered;
+    uint64_t num_acquires;
+    uint64_t num_contended;
+    uint64_t spin_cycles;
+    ABTI_lock_site *p_next;
+};
+
+void ABTI_lock_profile_register(ABTI_lock_site *p_site);
+
+static inline void ABTI_spinlock_acquire_profiled(ABTI_spinlock *p_lock,
+                                                  ABTI_lock_site *p_site)
+{
+    if (*(volatile uint32_t *)&p_site->registered == 0) {
+        ABTI_lock_profile_register(p_site);
+    }
+    if (ABTI_spinlock_try_acquire(p_lock) == ABT_FALSE) {
+        uint64_t start = ABTD_time_get_cycles();
+        ABTI_spinlock_acquire(p_lock);
+        ABTD_atomic_fetch_add_uint64(&p_site->spin_cycles,
+                                     ABTD_time_get_cycles() - start);
+        ABTD_atomic_fetch_add_uint64(&p_site->num_contended, 1);
+    }
+    ABTD_atomic_fetch_add_uint64(&p_site->num_acquires, 1);
+}
+
+/* The record is static in the block expanded at each call site.  Sites in
+ * inline functions get a record in each translation unit, and the records of
+ * the same line are merged in the report. */
+#define ABTI_spinlock_acquire(p_lock)                                       \
+    do {                                                                    \
+        static ABTI_lock_site ABTI_lock_site_ = {                           \
+            __FILE__, __func__, __LINE__, 0, 0, 0, 0, NULL                  \
+        };                                                                  \
+        ABTI_spinlock_acquire_profiled(p_lock, &ABTI_lock_site_);           \
+    } while (0)
+#endif /* ABT_CONFIG_USE_LOCK_PROFILE */
+
 #endif /* SPINLOCK_H_INCLUDED */
@@ -44,6 +44,7 @@ static inline
 void ABTI_xstream_set_request(ABTI_xstream *p_xstream, uint32_t req)
 {
     ABTD_atomic_fetch_or_uint32(&p_xstream->request, req);
+    ABTI_SCHED_UNPARK_ALL();
 }
 
 static inline
@@ -52,12 +53,13 @@ void ABTI_xstream_unset_request(ABTI_xstream *p_xstream, uint32_t req)
     ABTD_atomic_fetch_and_uint32(&p_xstream->request, ~req);
 }
 
+/* ABTI_xstream_self() for a caller whose ES-local data is p_local */
 static inline
-ABTI_xstream *ABTI_xstream_self(void)
+ABTI_xstream *ABTI_xstream_self_local(ABTI_local *p_local)
 {
     ABTI_xstream *p_xstream;
-    if (lp_ABTI_local != NULL) {
-        p_xstream = ABTI_local_get_xstream();
+    if (p_local != NULL) {
+        p_xstream = p_local->p_xstream;
     } else {
         /* We allow external threads to call Argobots APIs. However, since it
          * is not trivial to identify them, we use ABTD_xstream_context to
@@ -69,6 +71,86 @@ ABTI_xstream *ABTI_xstream_self(void)
     return p_xstream;
 }
 
+static inline
+ABTI_xstream *ABTI_xstream_self(void)
+{
+    return ABTI_xstream_self_local(ABTI_local_get_local());
+}
+
+/* Publish the summary of p_xstream taken at time.  The ES does it whenever it
+ * checks events, and the other threads when they change its state.  Writers
+ * are serialized by making the sequence number odd with CAS. */
+static inline
+void ABTI_xstream_publish(ABTI_xstream *p_xstream, double time)
+{
+    ABTI_xstream_snapshot *p_snap = &p_xstream->snapshot;
+    uint32_t seq;
+
+    while (1) {
+        seq = *(volatile uint32_t *)&p_snap->seq;
+        if (!(seq & 1) &&
+            ABTD_atomic_cas_uint32(&p_snap->seq, seq, seq + 1) == seq) break;
+        ABTD_atomic_pause();
+    }
+
+    p_snap->rank = p_xstream->rank;
+    p_snap->type = p_xstream->type;
+    p_snap->state = p_xstream->state;
+    p_snap->request = p_xstream->request;
+    p_snap->max_scheds = p_xstream->max_scheds;
+    p_snap->num_scheds = p_xstream->num_scheds;
+    p_snap->p_main_sched = p_xstream->p_main_sched;
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    p_snap->num_remote_frees = p_xstream->num_remote_frees;
+#else
+    p_snap->num_remote_frees = 0;
+#endif
+    p_snap->time = time;
+    p_snap->stats = p_xstream->stats;
+
+    ABTD_atomic_write_barrier();
+    *(volatile uint32_t *)&p_snap->seq = seq + 2;
+}
+
+/* Copy the last published summary of p_xstream to p_snap.  It only retries
+ * while a writer is updating it and never blocks the ES. */
+static inline
+void ABTI_xstream_read_snapshot(ABTI_xstream *p_xstream,
+                                ABTI_xstream_snapshot *p_snap)
+{
+    uint32_t seq;
+
+    while (1) {
+        seq = *(volatile uint32_t *)&p_xstream->snapshot.seq;
+        if (seq & 1) {
+            ABTD_atomic_pause();
+            continue;
+        }
+        ABTD_atomic_mem_barrier();
+        memcpy(p_snap, &p_xstream->snapshot, sizeof(ABTI_xstream_snapshot));
+        ABTD_atomic_mem_barrier();
+        if (*(volatile uint32_t *)&p_xstream->snapshot.seq == seq) break;
+    }
+}
+
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+/* Count an elided critical section in the statistics of the calling ES.  It
+ * is called outside the transaction. */
+static inline
+void ABTI_spinlock_elision_count(ABT_bool committed)
+{
+    ABTI_xstream *p_xstream;
+    if (lp_ABTI_local == NULL) return;
+    p_xstream = ABTI_local_get_xstream();
+    if (p_xstream == NULL) return;
+    if (committed == ABT_TRUE) {
+        p_xstream->stats.num_lock_elisions++;
+    } else {
+        p_xstream->stats.num_lock_elision_aborts++;
+    }
+}
+#endif
+
 /* Get the top scheduler from the sched stack (field scheds) */
 static inline
 ABTI_sched *ABTI_xstream_get_top_sched(ABTI_xstream *p_xstream)
@@ -123,12 +205,28 @@ void ABTI_xstream_push_sched(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
     p_xstream->scheds[p_xstream->num_scheds++] = p_sched;
 }
 
+/* Wake up the external threads blocked in ABT_thread_join() after a ULT has
+ * become TERMINATED.  They are woken up all at once and check their ULTs. */
+static inline
+void ABTI_xstream_wake_ext_joiners(void)
+{
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    /* The state has to be visible before num_ext_joiners is read, pairing
+     * with ABTI_thread_join_ext(). */
+    ABTD_atomic_mem_barrier();
+    if (*(volatile uint32_t *)&gp_ABTI_global->num_ext_joiners == 0) return;
+    ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->ext_join_seq, 1);
+    ABTD_futex_wake_all(&gp_ABTI_global->ext_join_seq);
+#endif
+}
+
 static inline
 void ABTI_xstream_terminate_thread(ABTI_thread *p_thread)
 {
     LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] terminated\n",
               ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
     ABTI_EVENT_INC_UNIT_CNT(p_thread->p_last_xstream, ABT_UNIT_TYPE_THREAD);
+    ABTI_join_counter_dec(p_thread);
     if (p_thread->refcount == 0) {
         p_thread->state = ABT_THREAD_STATE_TERMINATED;
         ABTI_thread_free(p_thread);
@@ -138,6 +236,11 @@ void ABTI_xstream_terminate_thread(ABTI_thread *p_thread)
         p_thread->state = ABT_THREAD_STATE_TERMINATED;
         ABTI_sched_discard_and_free(p_thread->is_sched);
 #endif
+    } else if (ABTD_atomic_cas_uint32(&p_thread->detach, ABTI_DETACH_NONE,
+                                      ABTI_DETACH_ENDED) != ABTI_DETACH_NONE) {
+        /* The handle has been given up by ABT_thread_detach(). */
+        p_thread->state = ABT_THREAD_STATE_TERMINATED;
+        ABTI_thread_free(p_thread);
     } else {
         /* NOTE: We set the ULT's state as TERMINATED after checking refcount
          * because the ULT can be freed on a different ES.  In other words, we
@@ -145,6 +248,7 @@ void ABTI_xstream_terminate_thread(ABTI_thread *p_thread)
          * TERMINATED. */
         p_thread->state = ABT_THREAD_STATE_TERMINATED;
     }
+    ABTI_xstream_wake_ext_joiners();
 }
 
 static inline
@@ -162,6 +266,11 @@ void ABTI_xstream_terminate_task(ABTI_task *p_task)
         p_task->state = ABT_TASK_STATE_TERMINATED;
         ABTI_sched_discard_and_free(p_task->is_sched);
 #endif
+    } else if (ABTD_atomic_cas_uint32(&p_task->detach, ABTI_DETACH_NONE,
+                                      ABTI_DETACH_ENDED) != ABTI_DETACH_NONE) {
+        /* The handle has been given up by ABT_task_detach(). */
+        p_task->state = ABT_TASK_STATE_TERMINATED;
+        ABTI_task_free(p_task);
     } else {
         /* NOTE: We set the task's state as TERMINATED after checking refcount
          * because the task can be freed on a different ES.  In other words, we
@@ -171,4 +280,13 @@ void ABTI_xstream_terminate_task(ABTI_task *p_task)
     }
 }
 
+/* Called by the schedulers through ABTI_xstream_check_events() */
+static inline
+void ABTI_xstream_check_poll_hooks(ABTI_xstream *p_xstream)
+{
+    if (*(volatile int *)&p_xstream->num_poll_hooks > 0) {
+        ABTI_xstream_run_poll_hooks(p_xstream);
+    }
+}
+
 #endif /* XSTREAM_H_INCLUDED */
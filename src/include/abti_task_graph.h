@@ -0,0 +1,45 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef TASK_GRAPH_H_INCLUDED
+#define TASK_GRAPH_H_INCLUDED
+
+/* Inlined functions for Task Graph */
+
+/* Task Graph */
+static inline
+ABTI_task_graph *ABTI_task_graph_get_ptr(ABT_task_graph graph)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_task_graph *p_graph;
+    if (graph == ABT_TASK_GRAPH_NULL) {
+        p_graph = NULL;
+    } else {
+        p_graph = (ABTI_task_graph *)graph;
+    }
+    return p_graph;
+#else
+    return (ABTI_task_graph *)graph;
+#endif
+}
+
+static inline
+ABT_task_graph ABTI_task_graph_get_handle(ABTI_task_graph *p_graph)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_task_graph h_graph;
+    if (p_graph == NULL) {
+        h_graph = ABT_TASK_GRAPH_NULL;
+    } else {
+        h_graph = (ABT_task_graph)p_graph;
+    }
+    return h_graph;
+#else
+    return (ABT_task_graph)p_graph;
+#endif
+}
+
+#endif /* TASK_GRAPH_H_INCLUDED */
+
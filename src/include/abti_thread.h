@@ -81,5 +81,132 @@ void ABTI_thread_yield(ABTI_thread *p_thread)
               ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
 }
 
+/* Bind a stack to a ULT created with a deferred stack before it runs for the
+ * first time. */
+#if defined(ABT_CONFIG_USE_MEM_POOL) && defined(ABT_CONFIG_USE_FCONTEXT)
+#define ABTI_THREAD_BIND_STACK(p_thread)                            \
+    do {                                                            \
+        if ((p_thread)->attr.p_stack == NULL &&                     \
+            (p_thread)->attr.deferred_stack == ABT_TRUE) {          \
+            ABTI_thread_bind_stack(p_thread);                       \
+        }                                                           \
+    } while (0)
+#else
+#define ABTI_THREAD_BIND_STACK(p_thread)
+#endif
+
+/* With ABT_STACK_CANARY, the lowest ABTI_STACK_CANARY_WORDS words of a ULT
+ * stack hold a known pattern, which is written when the context of the ULT is
+ * made on the stack and checked whenever the ULT switches back to its
+ * scheduler.  A ULT that has run past the bottom of its stack has overwritten
+ * the pattern, and the process is aborted before the corrupted neighbor runs.
+ * This complements the guard pages of ABT_MEM_LAZY_STACK, which regular stack
+ * pages, user stacks, and malloc'ed stacks do not have. */
+#define ABTI_STACK_CANARY_WORDS     8
+#define ABTI_STACK_CANARY           0xABCA4A2DDEADBEEFULL
+
+/* With ABT_STACK_PROFILE, the part of a ULT stack above the canary words and
+ * below the initial frame is painted with ABTI_STACK_PAINT when the context
+ * of the ULT is made.  When the ULT terminates, the lowest word that is no
+ * longer painted tells how deep the stack has been used (see
+ * ABTI_stack_usage_record()).  The initial frame is known only with fcontext,
+ * so the stack is not painted otherwise. */
+#define ABTI_STACK_PAINT            0xA5A5A5A5A5A5A5A5ULL
+
+/* Prepare the stack of a ULT whose context has just been made on it */
+static inline
+void ABTI_thread_init_stack(ABTI_thread *p_thread)
+{
+    uint64_t *p_bottom = (uint64_t *)p_thread->attr.p_stack;
+    int i;
+
+    if (p_bottom == NULL) return;
+    if (gp_ABTI_global->stack_canary == ABT_TRUE) {
+        for (i = 0; i < ABTI_STACK_CANARY_WORDS; i++) {
+            p_bottom[i] = ABTI_STACK_CANARY;
+        }
+    }
+#ifdef ABT_CONFIG_USE_FCONTEXT
+    if (gp_ABTI_global->stack_profile == ABT_TRUE) {
+        uint64_t *p_word = p_bottom + ABTI_STACK_CANARY_WORDS;
+        uint64_t *p_frame = (uint64_t *)p_thread->ctx.fctx;
+        while (p_word < p_frame) *p_word++ = ABTI_STACK_PAINT;
+    }
+#endif
+}
+
+/* Prefetch the registers saved at the top of the stack of p_thread, which its
+ * context switch restores first.  The caller owns p_thread. */
+static inline
+void ABTI_thread_prefetch_stack(ABTI_thread *p_thread)
+{
+#ifdef ABT_CONFIG_USE_FCONTEXT
+    char *p_frame = (char *)p_thread->ctx.fctx;
+
+    if (gp_ABTI_global->sched_prefetch == ABT_FALSE || p_frame == NULL) return;
+    ABTD_prefetch_write(p_frame);
+    ABTD_prefetch_write(p_frame + ABT_CONFIG_CACHE_LINE_SIZE);
+#else
+    ABTI_UNUSED(p_thread);
+#endif
+}
+
+static inline
+void ABTI_thread_check_stack_canary(ABTI_thread *p_thread)
+{
+    uint64_t *p_bottom = (uint64_t *)p_thread->attr.p_stack;
+    int i;
+
+    if (gp_ABTI_global->stack_canary == ABT_FALSE || p_bottom == NULL) return;
+    if (p_thread->type == ABTI_THREAD_TYPE_MAIN) return;
+    for (i = 0; i < ABTI_STACK_CANARY_WORDS; i++) {
+        if (p_bottom[i] != ABTI_STACK_CANARY) {
+            fprintf(stderr, "ABT: stack overflow of ULT %" PRIu64
+                    " (stack %p, %zu bytes)\n", ABTI_thread_get_id(p_thread),
+                    p_thread->attr.p_stack, p_thread->attr.stacksize);
+            abort();
+        }
+    }
+}
+
+/* Revert ABTI_thread_set_blocked() for a ULT that has not been exposed to any
+ * waker. */
+static inline
+void ABTI_thread_unset_blocked(ABTI_thread *p_thread)
+{
+    ABTI_thread_unset_request(p_thread, ABTI_THREAD_REQ_BLOCK);
+    p_thread->state = ABT_THREAD_STATE_RUNNING;
+    ABTI_pool_dec_num_blocked(p_thread->p_pool);
+}
+
+/* A ULT that blocks on a synchronization object records the object and the
+ * function that unlinks a ULT from its waiters, so that ABT_thread_cancel()
+ * can cancel the ULT without waking it up.  The record is set before the ULT
+ * is exposed to wakers and unset once it resumes.  Both are done by the ULT
+ * itself with its lock held, which ABT_thread_cancel() also holds while it
+ * calls f_unlink. */
+static inline
+void ABTI_thread_set_wait_obj(ABTI_thread *p_thread, void *p_obj,
+                              ABT_bool (*f_unlink)(void *, ABTI_thread *))
+{
+#ifndef ABT_CONFIG_DISABLE_THREAD_CANCEL
+    ABTI_spinlock_acquire(&p_thread->lock);
+    p_thread->p_wait_obj = p_obj;
+    p_thread->f_wait_unlink = f_unlink;
+    ABTI_spinlock_release(&p_thread->lock);
+#endif
+}
+
+static inline
+void ABTI_thread_unset_wait_obj(ABTI_thread *p_thread)
+{
+#ifndef ABT_CONFIG_DISABLE_THREAD_CANCEL
+    ABTI_spinlock_acquire(&p_thread->lock);
+    p_thread->p_wait_obj = NULL;
+    p_thread->f_wait_unlink = NULL;
+    ABTI_spinlock_release(&p_thread->lock);
+#endif
+}
+
 #endif /* THREAD_H_INCLUDED */
 
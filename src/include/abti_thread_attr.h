@@ -78,6 +78,18 @@ ABT_thread_attr ABTI_thread_attr_get_handle(ABTI_thread_attr *p_attr)
         (p_attr)->p_stack    = p_st;                    \
         (p_attr)->stacksize  = st_size;                 \
         (p_attr)->userstack  = ABT_FALSE;               \
+        (p_attr)->deferred_stack = ABT_FALSE;           \
+        (p_attr)->use_fpu    = ABT_TRUE;                \
+        (p_attr)->vector_state = ABT_FALSE;             \
+        (p_attr)->preemptible  = ABT_FALSE;             \
+        (p_attr)->priority   = 0;                       \
+        (p_attr)->deadline   = 0.0;                     \
+        (p_attr)->work_first = ABT_FALSE;               \
+        (p_attr)->home       = ABT_XSTREAM_ANY_RANK;    \
+        (p_attr)->reusable   = ABT_FALSE;               \
+        (p_attr)->p_join_counter = NULL;                \
+        (p_attr)->p_gang     = NULL;                    \
+        (p_attr)->core_class = ABT_CORE_CLASS_ANY;      \
         ABTI_THREAD_ATTR_INIT_MIG(p_attr,mig);          \
     }
 
@@ -13,7 +13,8 @@
 #elif defined(HAVE_CLH_H)
 #include <clh.h>
 #else
-#define USE_PTHREAD_MUTEX
+#include "abti_mcs_lock.h"
+#define USE_MCS_LOCK
 #endif
 
 struct ABTI_thread_queue {
@@ -23,21 +24,21 @@ struct ABTI_thread_queue {
     uint32_t pad0;
     ABTI_thread *head;
     ABTI_thread *tail;
-    char pad1[64-8*4];
+    char pad1[ABT_CONFIG_CACHE_LINE_SIZE-8*4];
 
     /* low priority queue */
     uint32_t low_mutex;
     uint32_t low_num_threads;
     ABTI_thread *low_head;
     ABTI_thread *low_tail;
-    char pad2[64-8*3];
+    char pad2[ABT_CONFIG_CACHE_LINE_SIZE-8*3];
 
     /* two doubly-linked lists */
     ABTI_thread_queue *p_h_next;
     ABTI_thread_queue *p_h_prev;
     ABTI_thread_queue *p_l_next;
     ABTI_thread_queue *p_l_prev;
-    char pad3[64-8*4];
+    char pad3[ABT_CONFIG_CACHE_LINE_SIZE-8*4];
 };
 
 struct ABTI_thread_htable {
@@ -45,8 +46,8 @@ struct ABTI_thread_htable {
     lh_lock_t mutex;
 #elif defined(HAVE_CLH_H)
     clh_lock_t mutex;
-#elif defined(USE_PTHREAD_MUTEX)
-    pthread_mutex_t mutex;
+#elif defined(USE_MCS_LOCK)
+    ABTI_mcs_lock mutex;
 #else
     uint32_t mutex[2];          /* To protect table */
 #endif
@@ -64,9 +65,9 @@ struct ABTI_thread_htable {
 #elif defined(HAVE_CLH_H)
 #define ABTI_THREAD_HTABLE_LOCK(m)      clh_acquire(&m)
 #define ABTI_THREAD_HTABLE_UNLOCK(m)    clh_release(&m)
-#elif defined(USE_PTHREAD_MUTEX)
-#define ABTI_THREAD_HTABLE_LOCK(m)      pthread_mutex_lock(&m)
-#define ABTI_THREAD_HTABLE_UNLOCK(m)    pthread_mutex_unlock(&m)
+#elif defined(USE_MCS_LOCK)
+#define ABTI_THREAD_HTABLE_LOCK(m)      ABTI_mcs_lock_acquire(&m)
+#define ABTI_THREAD_HTABLE_UNLOCK(m)    ABTI_mcs_lock_release(&m)
 #else
 #define ABTI_THREAD_HTABLE_LOCK(m)      ABTI_PTR_SPINLOCK_LOW(m)
 #define ABTI_THREAD_HTABLE_UNLOCK(m)    ABTI_PTR_UNLOCK_LOW(m)
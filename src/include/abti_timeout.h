@@ -0,0 +1,52 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef TIMEOUT_H_INCLUDED
+#define TIMEOUT_H_INCLUDED
+
+#include <sys/time.h>
+
+/* Inlined functions for timed waits */
+
+static inline
+double ABTI_timeout_convert(const struct timespec *p_ts)
+{
+    return ((double)p_ts->tv_sec) + 1.0e-9 * ((double)p_ts->tv_nsec);
+}
+
+/* Current time of the clock used for the absolute time of timed waits */
+static inline
+double ABTI_timeout_get_time(void)
+{
+#if defined(HAVE_CLOCK_GETTIME)
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ABTI_timeout_convert(&ts);
+#elif defined(HAVE_GETTIMEOFDAY)
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return ((double)tv.tv_sec) + 1.0e-6 * ((double)tv.tv_usec);
+#else
+#error "No timer function available"
+    return 0.0;
+#endif
+}
+
+static inline
+uint64_t ABTI_timer_wheel_get_tick(double time)
+{
+    return (uint64_t)(time / ABTI_TIMER_WHEEL_TICK);
+}
+
+/* Called by the schedulers through ABTI_xstream_check_events() */
+static inline
+void ABTI_timer_wheel_check(ABTI_timer_wheel *p_wheel)
+{
+    if (*(volatile uint32_t *)&p_wheel->num_entries > 0) {
+        ABTI_timer_wheel_expire(p_wheel);
+    }
+}
+
+#endif /* TIMEOUT_H_INCLUDED */
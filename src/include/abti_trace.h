@@ -0,0 +1,80 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+/* Kinds of traced events, whose argument is the ID of the pool.
+ * ABTI_TRACE_TASK is or'ed if the work unit is a tasklet. */
+#define ABTI_TRACE_CREATE   0   /* Created */
+#define ABTI_TRACE_PUSH     1   /* Pushed to a pool */
+#define ABTI_TRACE_POP      2   /* Popped from a pool */
+#define ABTI_TRACE_STEAL    3   /* Stolen from a pool */
+#define ABTI_TRACE_RUN      4   /* Started or resumed running */
+#define ABTI_TRACE_STOP     5   /* Stopped running and back to the scheduler */
+#define ABTI_TRACE_BLOCK    6   /* Blocked */
+#define ABTI_TRACE_NUM_KINDS 7
+#define ABTI_TRACE_TASK     0x100
+
+/* Inlined functions for event tracing.  Only the ES that owns a trace buffer
+ * writes to it, so recording an event does not need any synchronization.  It
+ * costs a flag check if tracing is disabled. */
+
+static inline
+void ABTI_trace_event(uint32_t kind, ABT_unit unit, uint32_t arg)
+{
+    ABTI_xstream *p_xstream;
+    ABTI_trace_buf *p_buf;
+    ABTI_trace_entry *p_entry;
+    uint64_t pos;
+
+    if (gp_ABTI_global->use_tracing == ABT_FALSE) return;
+    /* Events of external threads are not recorded. */
+    if (lp_ABTI_local == NULL) return;
+    p_xstream = lp_ABTI_local->p_xstream;
+    if (p_xstream == NULL || p_xstream->p_trace == NULL) return;
+
+    p_buf = p_xstream->p_trace;
+    pos = p_buf->pos;
+    p_entry = &p_buf->p_entries[pos & p_buf->mask];
+    p_entry->cycles = ABTD_time_get_cycles();
+    p_entry->obj = (uint64_t)(uintptr_t)unit;
+    p_entry->kind = kind;
+    p_entry->arg = arg;
+    /* A reader that dumps the buffer while this ES is running may see a torn
+     * entry, but never an entry beyond pos. */
+    ABTD_compiler_barrier();
+    *(volatile uint64_t *)&p_buf->pos = pos + 1;
+}
+
+static inline
+void ABTI_trace_thread(uint32_t kind, ABTI_thread *p_thread)
+{
+    if (gp_ABTI_global->use_tracing == ABT_FALSE) return;
+    ABTI_trace_event(kind, p_thread->unit,
+                     p_thread->p_pool ? (uint32_t)p_thread->p_pool->id : 0);
+}
+
+static inline
+void ABTI_trace_task(uint32_t kind, ABTI_task *p_task)
+{
+    if (gp_ABTI_global->use_tracing == ABT_FALSE) return;
+    ABTI_trace_event(kind | ABTI_TRACE_TASK, p_task->unit,
+                     p_task->p_pool ? (uint32_t)p_task->p_pool->id : 0);
+}
+
+/* Trace an event of a work unit in p_pool, whose type is unknown */
+static inline
+void ABTI_trace_unit(uint32_t kind, ABTI_pool *p_pool, ABT_unit unit)
+{
+    if (gp_ABTI_global->use_tracing == ABT_FALSE) return;
+    if (unit == ABT_UNIT_NULL) return;
+    if (p_pool->u_get_type(unit) == ABT_UNIT_TYPE_TASK) {
+        kind |= ABTI_TRACE_TASK;
+    }
+    ABTI_trace_event(kind, unit, (uint32_t)p_pool->id);
+}
+
+#endif /* TRACE_H_INCLUDED */
@@ -0,0 +1,140 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef UNIT_H_INCLUDED
+#define UNIT_H_INCLUDED
+
+/* Inlined functions for the units of work units.  For a pool whose units are
+ * embedded (see ABTI_pool_units), they use the ABTI_unit in the work unit
+ * instead of calling the pool's unit functions. */
+
+static inline
+ABT_unit ABTI_unit_init_thread(ABTI_thread *p_thread)
+{
+    ABTI_unit *p_unit = &p_thread->unit_def;
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool   = ABT_POOL_NULL;
+    p_unit->thread = ABTI_thread_get_handle(p_thread);
+    p_unit->type   = ABT_UNIT_TYPE_THREAD;
+    return (ABT_unit)p_unit;
+}
+
+static inline
+ABT_unit ABTI_unit_init_task(ABTI_task *p_task)
+{
+    ABTI_unit *p_unit = &p_task->unit_def;
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool   = ABT_POOL_NULL;
+    p_unit->task   = ABTI_task_get_handle(p_task);
+    p_unit->type   = ABT_UNIT_TYPE_TASK;
+    return (ABT_unit)p_unit;
+}
+
+/* Prefetch the descriptor of the work unit whose embedded unit is p_unit.
+ * Another ES may take and free the work unit at any time, so p_unit is not
+ * dereferenced: the lines are those of a ULT, i.e., the line of the unit,
+ * the context-switch line before it, and the line that ABTI_xstream_run_unit
+ * reads from the attributes.  For a tasklet, they are only wasted. */
+static inline
+void ABTI_unit_prefetch(ABTI_unit *p_unit)
+{
+    char *p_thread = (char *)p_unit - offsetof(ABTI_thread, unit_def);
+
+    ABTD_prefetch_write(p_unit);
+    ABTD_prefetch_write(p_thread);
+    ABTD_prefetch_write(p_thread + offsetof(ABTI_thread, attr.p_gang));
+}
+
+/* Prefetch the unit that the next pop of p_pool by the caller is likely to
+ * return, so that it arrives while the current unit runs.  Only the built-in
+ * FIFO pools and the deque can be peeked. */
+static inline
+void ABTI_pool_prefetch_next(ABTI_pool *p_pool)
+{
+    ABTI_unit *p_unit;
+
+    if (gp_ABTI_global->sched_prefetch == ABT_FALSE) return;
+    switch (p_pool->builtin) {
+        case ABTI_POOL_BUILTIN_FIFO_PRIV:
+        case ABTI_POOL_BUILTIN_FIFO_SHARED:
+            p_unit = *(ABTI_unit * volatile *)
+                     &((ABTI_pool_fifo_data *)p_pool->data)->p_head;
+            break;
+        default:
+            if (p_pool->p_pop != ABTI_pool_deque.p_pop) return;
+            p_unit = (ABTI_unit *)ABTI_pool_deque_peek(p_pool);
+            break;
+    }
+    if (p_unit != NULL) ABTI_unit_prefetch(p_unit);
+}
+
+static inline
+ABT_unit ABTI_pool_unit_create_thread(ABTI_pool *p_pool, ABTI_thread *p_thread)
+{
+    if (p_pool->units != ABTI_POOL_UNITS_CUSTOM) {
+        return ABTI_unit_init_thread(p_thread);
+    }
+    return p_pool->u_create_from_thread(ABTI_thread_get_handle(p_thread));
+}
+
+static inline
+ABT_unit ABTI_pool_unit_create_task(ABTI_pool *p_pool, ABTI_task *p_task)
+{
+    if (p_pool->units != ABTI_POOL_UNITS_CUSTOM) {
+        return ABTI_unit_init_task(p_task);
+    }
+    return p_pool->u_create_from_task(ABTI_task_get_handle(p_task));
+}
+
+static inline
+void ABTI_pool_unit_free(ABTI_pool *p_pool, ABT_unit *p_unit)
+{
+    if (p_pool->units != ABTI_POOL_UNITS_CUSTOM) {
+        *p_unit = ABT_UNIT_NULL;
+    } else {
+        p_pool->u_free(p_unit);
+    }
+}
+
+static inline
+ABT_unit_type ABTI_pool_unit_get_type(ABTI_pool *p_pool, ABT_unit unit)
+{
+    if (p_pool->units != ABTI_POOL_UNITS_CUSTOM) {
+        return ((ABTI_unit *)unit)->type;
+    }
+    return p_pool->u_get_type(unit);
+}
+
+static inline
+ABTI_thread *ABTI_pool_unit_get_thread(ABTI_pool *p_pool, ABT_unit unit)
+{
+    if (p_pool->units != ABTI_POOL_UNITS_CUSTOM) {
+        return ABTI_thread_get_ptr(((ABTI_unit *)unit)->thread);
+    }
+    return ABTI_thread_get_ptr(p_pool->u_get_thread(unit));
+}
+
+static inline
+ABTI_task *ABTI_pool_unit_get_task(ABTI_pool *p_pool, ABT_unit unit)
+{
+    if (p_pool->units != ABTI_POOL_UNITS_CUSTOM) {
+        return ABTI_task_get_ptr(((ABTI_unit *)unit)->task);
+    }
+    return ABTI_task_get_ptr(p_pool->u_get_task(unit));
+}
+
+static inline
+ABT_bool ABTI_pool_unit_is_in_pool(ABTI_pool *p_pool, ABT_unit unit)
+{
+    if (p_pool->units != ABTI_POOL_UNITS_CUSTOM) {
+        return (((ABTI_unit *)unit)->pool != ABT_POOL_NULL) ? ABT_TRUE
+                                                             : ABT_FALSE;
+    }
+    return p_pool->u_is_in_pool(unit);
+}
+
+#endif /* UNIT_H_INCLUDED */
@@ -0,0 +1,37 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef UNIT_STATS_H_INCLUDED
+#define UNIT_STATS_H_INCLUDED
+
+/* Inlined functions for the histograms of ABT_unit_stats.  They cost a flag
+ * check if ABT_UNIT_STATS is not set, and nothing if Argobots is configured
+ * with --enable-feature=no-unit-stats. */
+
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+
+/* Save the time when unit is pushed to p_pool */
+static inline
+void ABTI_unit_stats_push(ABTI_pool *p_pool, ABT_unit unit)
+{
+    if (gp_ABTI_global->use_unit_stats == ABT_FALSE) return;
+    ABTI_unit_stats_stamp(p_pool, unit);
+}
+
+/* Ticks at the start of a run, or 0 if the timings are not collected */
+static inline
+uint64_t ABTI_unit_stats_get_ticks(void)
+{
+    if (gp_ABTI_global->use_unit_stats == ABT_FALSE) return 0;
+    return ABTD_time_get_ticks();
+}
+
+#else /* ABT_CONFIG_DISABLE_UNIT_STATS */
+
+#define ABTI_unit_stats_push(p_pool, unit)
+
+#endif /* ABT_CONFIG_DISABLE_UNIT_STATS */
+
+#endif /* UNIT_STATS_H_INCLUDED */
@@ -6,12 +6,30 @@
 #ifndef ABTI_VALGRIND_H_INCLUDED
 #define ABTI_VALGRIND_H_INCLUDED
 
+/* A stack that Argobots allocates for a ULT is registered when it is given to
+ * the ULT and deregistered when the ULT is freed, so Valgrind does not take a
+ * context switch for a huge stack pointer change.  A stack kept for a
+ * reusable ULT stays registered.  Stacks given by the user are not ours to
+ * register. */
 #ifdef HAVE_VALGRIND_SUPPORT
 #include <valgrind/valgrind.h>
-#define ABTI_VALGRIND_STACK_REGISTER(p,s)             \
-    VALGRIND_STACK_REGISTER(p, ((char *)p)+s)
+#define ABTI_VALGRIND_STACK_REGISTER(p_thread)                          \
+    do {                                                                \
+        (p_thread)->valgrind_id = VALGRIND_STACK_REGISTER(              \
+            (p_thread)->attr.p_stack,                                   \
+            (char *)(p_thread)->attr.p_stack +                          \
+            (p_thread)->attr.stacksize);                                \
+    } while (0)
+#define ABTI_VALGRIND_STACK_DEREGISTER(p_thread)                        \
+    do {                                                                \
+        if ((p_thread)->attr.p_stack != NULL &&                         \
+            (p_thread)->attr.userstack == ABT_FALSE) {                  \
+            VALGRIND_STACK_DEREGISTER((p_thread)->valgrind_id);         \
+        }                                                               \
+    } while (0)
 #else
-#define ABTI_VALGRIND_STACK_REGISTER(p,s)
+#define ABTI_VALGRIND_STACK_REGISTER(p_thread)
+#define ABTI_VALGRIND_STACK_DEREGISTER(p_thread)
 #endif
 
 #endif /* ABTI_VALGRIND_H_INCLUDED */
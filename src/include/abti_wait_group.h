@@ -0,0 +1,80 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef WAIT_GROUP_H_INCLUDED
+#define WAIT_GROUP_H_INCLUDED
+
+/* The lower 32 bits of the state are the count.  ABTI_WAIT_GROUP_WAITER is
+ * set while a ULT is blocked on the wait group. */
+#define ABTI_WAIT_GROUP_WAITER      ((uint64_t)1 << 32)
+#define ABTI_WAIT_GROUP_COUNT_MASK  (ABTI_WAIT_GROUP_WAITER - 1)
+
+/* Inlined functions for Wait Group */
+
+static inline
+ABTI_wait_group *ABTI_wait_group_get_ptr(ABT_wait_group wg)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_wait_group *p_wg;
+    if (wg == ABT_WAIT_GROUP_NULL) {
+        p_wg = NULL;
+    } else {
+        p_wg = (ABTI_wait_group *)wg;
+    }
+    return p_wg;
+#else
+    return (ABTI_wait_group *)wg;
+#endif
+}
+
+static inline
+ABT_wait_group ABTI_wait_group_get_handle(ABTI_wait_group *p_wg)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_wait_group h_wg;
+    if (p_wg == NULL) {
+        h_wg = ABT_WAIT_GROUP_NULL;
+    } else {
+        h_wg = (ABT_wait_group)p_wg;
+    }
+    return h_wg;
+#else
+    return (ABT_wait_group)p_wg;
+#endif
+}
+
+static inline
+void ABTI_wait_group_init(ABTI_wait_group *p_wg)
+{
+    p_wg->state = 0;
+    p_wg->p_waiter = NULL;
+}
+
+static inline
+uint32_t ABTI_wait_group_get_count(ABTI_wait_group *p_wg)
+{
+    return (uint32_t)(*(volatile uint64_t *)&p_wg->state &
+                      ABTI_WAIT_GROUP_COUNT_MASK);
+}
+
+static inline
+void ABTI_wait_group_add(ABTI_wait_group *p_wg, uint32_t n)
+{
+    ABTD_atomic_fetch_add_uint64(&p_wg->state, n);
+}
+
+/* Count down p_wg.  p_thread is the caller ULT, or NULL if the caller is not
+ * a ULT.  Without a waiter, the wait group is not touched after the count
+ * reaches zero, so the waiter may free it as soon as it sees zero. */
+static inline
+void ABTI_wait_group_done(ABTI_wait_group *p_wg, ABTI_thread *p_thread)
+{
+    uint64_t old = ABTD_atomic_fetch_sub_uint64(&p_wg->state, 1);
+    if (old == (ABTI_WAIT_GROUP_WAITER | 1)) {
+        ABTI_wait_group_wake(p_wg, p_thread);
+    }
+}
+
+#endif /* WAIT_GROUP_H_INCLUDED */
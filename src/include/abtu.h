@@ -25,6 +25,10 @@ void *ABTU_memalign(size_t alignment, size_t size)
     return p_ptr;
 }
 
+/* Memory returned by this can be freed by ABTU_free(). */
+#define ABTU_malloc_cache_aligned(a)    \
+    ABTU_memalign(ABT_CONFIG_CACHE_LINE_SIZE, (size_t)(a))
+
 #define ABTU_strcpy(d,s)        strcpy(d,s)
 #define ABTU_strncpy(d,s,n)     strncpy(d,s,n)
 
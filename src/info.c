@@ -31,24 +31,78 @@ int ABT_info_print_config(FILE *fp)
 
     fprintf(fp, "Argobots Configuration:\n");
     fprintf(fp, " - # of cores: %d\n", p_global->num_cores);
+    fprintf(fp, " - cgroup CPU quota: %d\n", p_global->cpu_quota);
     fprintf(fp, " - cache line size: %u\n", p_global->cache_line_size);
     fprintf(fp, " - OS page size: %u\n", p_global->os_page_size);
     fprintf(fp, " - huge page size: %u\n", p_global->huge_page_size);
     fprintf(fp, " - max. # of ESs: %d\n", p_global->max_xstreams);
     fprintf(fp, " - cur. # of ESs: %d\n", p_global->num_xstreams);
+    fprintf(fp, " - max. # of parked ES threads: %u\n",
+                p_global->max_parked_xstreams);
+    fprintf(fp, " - max. # of offload helper threads: %u\n",
+                p_global->offload.max_helpers);
     fprintf(fp, " - ES affinity: %s\n",
                 (p_global->set_affinity == ABT_TRUE) ? "on" : "off");
     fprintf(fp, " - logging: %s\n",
                 (p_global->use_logging == ABT_TRUE) ? "on" : "off");
     fprintf(fp, " - debug output: %s\n",
                 (p_global->use_debug == ABT_TRUE) ? "on" : "off");
-    fprintf(fp, " - key table entries: %d\n", p_global->key_table_size);
+    fprintf(fp, " - event tracing: %s\n",
+                (p_global->use_tracing == ABT_TRUE) ? "on" : "off");
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    fprintf(fp, " - unit timing histograms: %s\n",
+                (p_global->use_unit_stats == ABT_TRUE) ? "on" : "off");
+#else
+    fprintf(fp, " - unit timing histograms: disabled at build\n");
+#endif
+    fprintf(fp, " - pool operation counters: %s\n",
+                (p_global->use_pool_stats == ABT_TRUE) ? "on" : "off");
+    fprintf(fp, " - stack usage profiling: %s\n",
+                (p_global->stack_profile == ABT_TRUE) ? "on" : "off");
+    if (p_global->use_tracing == ABT_TRUE) {
+        fprintf(fp, " - trace events per ES: %u\n", p_global->trace_size);
+        fprintf(fp, " - trace format: %s\n",
+                    (p_global->trace_binary == ABT_TRUE) ? "binary" : "json");
+    }
+    fprintf(fp, " - initial key table slots: %d\n", p_global->key_table_size);
     fprintf(fp, " - ULT stack size: %u KB\n",
                 (unsigned)(p_global->thread_stacksize / 1024));
     fprintf(fp, " - scheduler stack size: %u KB\n",
                 (unsigned)(p_global->sched_stacksize / 1024));
     fprintf(fp, " - scheduler event check frequency: %u\n",
                 p_global->sched_event_freq);
+    fprintf(fp, " - scheduler autotuning: %s\n",
+                (p_global->sched_autotune == ABT_TRUE) ? "on" : "off");
+    fprintf(fp, " - remote steal threshold: %u\n",
+                p_global->sched_remote_threshold);
+    fprintf(fp, " - ring pool capacity: %u\n", p_global->pool_ring_capacity);
+    fprintf(fp, " - sub-queues of a multi-queue pool: %u\n",
+                p_global->pool_multiq_num_queues);
+    fprintf(fp, " - tasklet batch: %u tasklets, %.0f usec\n",
+                p_global->task_batch_size,
+                p_global->task_batch_latency * 1.0e6);
+    fprintf(fp, " - inline tasklet depth: %u\n", p_global->task_inline_depth);
+    fprintf(fp, " - team spin time: %.0f usec\n",
+                p_global->team_spin_time * 1.0e6);
+    fprintf(fp, " - direct handoff on wakeup: %s\n",
+                (p_global->handoff == ABT_TRUE) ? "on" : "off");
+    if (p_global->wake_affine == ABT_TRUE) {
+        fprintf(fp, " - wakeup on the last ES: on (max. queue length: %u)\n",
+                    p_global->wake_affine_max_queue);
+    } else {
+        fprintf(fp, " - wakeup on the last ES: off\n");
+    }
+    fprintf(fp, " - run created ULTs next: %s\n",
+                (p_global->run_next == ABT_TRUE) ? "on" : "off");
+    fprintf(fp, " - XSAVE area size: %zu\n", ABTD_xsave_get_size());
+#ifdef ABT_CONFIG_USE_LOCK_ELISION
+    fprintf(fp, " - lock elision: %s\n",
+            ABTD_htm_is_available() ? "on" : "off (no RTM or disabled)");
+#endif
+    fprintf(fp, " - preemption interval: %ld usec\n",
+                p_global->preempt_interval_nsec / 1000);
+    fprintf(fp, " - profiling interval: %ld usec\n",
+                p_global->profile_interval_nsec / 1000);
 
     fprintf(fp, " - timer function: "
 #if defined(HAVE_CLOCK_GETTIME)
@@ -59,6 +113,12 @@ int ABT_info_print_config(FILE *fp)
                 "gettimeofday"
 #endif
                 "\n");
+    if (ABTD_time_get_ticks_source() == ABTD_TIME_TICKS_CYCLES) {
+        fprintf(fp, " - tick counter: cycles (%.3f MHz)\n",
+                    1.0e-6 / g_ABTD_time_sec_per_tick);
+    } else {
+        fprintf(fp, " - tick counter: timer function\n");
+    }
 
 #ifdef ABT_CONFIG_USE_MEM_POOL
     fprintf(fp, "Memory Pool:\n");
@@ -66,6 +126,7 @@ int ABT_info_print_config(FILE *fp)
                 p_global->mem_page_size / 1024);
     fprintf(fp, " - stack page size: %u KB\n", p_global->mem_sp_size / 1024);
     fprintf(fp, " - max. # of stacks per ES: %u\n", p_global->mem_max_stacks);
+    fprintf(fp, " - # of stack colors: %u\n", p_global->mem_stack_colors);
     switch (p_global->mem_lp_alloc) {
         case ABTI_MEM_LP_MALLOC:
             fprintf(fp, " - large page allocation: malloc\n");
@@ -83,6 +144,20 @@ int ABT_info_print_config(FILE *fp)
         case ABTI_MEM_LP_THP:
             fprintf(fp, " - large page allocation: THPs\n");
             break;
+        case ABTI_MEM_LP_MMAP_GP_HP_RP:
+            fprintf(fp, " - large page allocation: mmap 1GB huge pages + "
+                        "huge pages + regular pages\n");
+            break;
+    }
+    fprintf(fp, " - lazy stack commit: %s\n",
+                (p_global->mem_lazy_stack == ABT_TRUE) ? "yes" : "no");
+    fprintf(fp, " - fast finalize: %s\n",
+                (p_global->mem_fast_finalize == ABT_TRUE) ? "yes" : "no");
+    if (p_global->mem_trim_interval > 0.0) {
+        fprintf(fp, " - trim interval: %lf sec. (keeping %zu bytes)\n",
+                    p_global->mem_trim_interval, p_global->mem_trim_size);
+    } else {
+        fprintf(fp, " - trim interval: disabled\n");
     }
 #endif /* ABT_CONFIG_USE_MEM_POOL */
 
@@ -94,6 +169,18 @@ int ABT_info_print_config(FILE *fp)
                 (p_global->pm_connected == ABT_TRUE) ? "yes" : "no");
     fprintf(fp, " - pm hostname: %s\n", p_global->pm_host);
     fprintf(fp, " - pm port: %d\n", p_global->pm_port);
+    fprintf(fp, " - pm shared control block: %s\n",
+                p_global->pm_shm ? p_global->pm_shm : "none");
+    fprintf(fp, " - elastic ESs: %s\n",
+                (p_global->elastic == ABT_TRUE) ? "yes" : "no");
+    fprintf(fp, " - elastic ES bounds: [%d, %d]\n",
+                p_global->elastic_min_xstreams,
+                p_global->elastic_max_xstreams);
+    fprintf(fp, " - elastic interval: %.3f ms\n",
+                p_global->elastic_interval * 1.0e3);
+    fprintf(fp, " - elastic grow depth: %u\n", p_global->elastic_grow_depth);
+    fprintf(fp, " - elastic park idle ratio: %u%%\n",
+                p_global->elastic_park_idle);
 #endif /* ABT_CONFIG_HANDLE_POWER_EVENT */
 
 #ifdef ABT_CONFIG_PUBLISH_INFO
@@ -120,7 +207,9 @@ int ABT_info_print_config(FILE *fp)
  * @brief   Write the information of all created ESs to the output stream.
  *
  * \c ABT_info_print_all_xstreams() writes the information of all ESs to the
- * given output stream \c fp.
+ * given output stream \c fp.  It prints the summaries that the ESs publish
+ * whenever they check events, so it neither stops nor races with them.  The
+ * age of each summary is printed as well.
  *
  * @param[in] fp  output stream
  * @return Error code
@@ -133,19 +222,36 @@ int ABT_info_print_all_xstreams(FILE *fp)
     ABTI_CHECK_INITIALIZED();
 
     ABTI_global *p_global = gp_ABTI_global;
-    int i;
+    ABTI_xstream **p_xstreams;
+    ABTI_xstream_snapshot *p_snaps;
+    int i, max_xstreams, num_xstreams = 0;
 
+    /* Only copy the summaries while holding the lock, which keeps the ESs
+     * from being removed and freed.  Ranks may not be contiguous. */
     ABTI_spinlock_acquire(&p_global->lock);
-
-    fprintf(fp, "# of created ESs: %d\n", p_global->num_xstreams);
-    for (i = 0; i < p_global->num_xstreams; i++) {
-        ABTI_xstream_print(p_global->p_xstreams[i], fp, 0, ABT_FALSE);
+    max_xstreams = p_global->max_xstreams;
+    p_xstreams = (ABTI_xstream **)
+        ABTU_malloc(max_xstreams * sizeof(ABTI_xstream *) + 1);
+    p_snaps = (ABTI_xstream_snapshot *)
+        ABTU_malloc(max_xstreams * sizeof(ABTI_xstream_snapshot) + 1);
+    for (i = 0; i < max_xstreams; i++) {
+        if (p_global->p_xstreams[i] == NULL) continue;
+        p_xstreams[num_xstreams] = p_global->p_xstreams[i];
+        ABTI_xstream_read_snapshot(p_xstreams[num_xstreams],
+                                   &p_snaps[num_xstreams]);
+        num_xstreams++;
     }
-
     ABTI_spinlock_release(&p_global->lock);
 
+    fprintf(fp, "# of created ESs: %d\n", num_xstreams);
+    for (i = 0; i < num_xstreams; i++) {
+        ABTI_xstream_print_snapshot(p_xstreams[i], &p_snaps[i], fp, 0);
+    }
     fflush(fp);
 
+    ABTU_free(p_snaps);
+    ABTU_free(p_xstreams);
+
   fn_exit:
     return abt_errno;
 
@@ -160,7 +266,9 @@ int ABT_info_print_all_xstreams(FILE *fp)
  * @brief   Write the information of the target ES to the output stream.
  *
  * \c ABT_info_print_xstream() writes the information of the target ES
- * \c xstream to the given output stream \c fp.
+ * \c xstream to the given output stream \c fp.  Like
+ * \c ABT_info_print_all_xstreams(), it prints the last summary published by
+ * the ES.
  *
  * @param[in] fp       output stream
  * @param[in] xstream  handle to the target ES
@@ -169,11 +277,468 @@ int ABT_info_print_all_xstreams(FILE *fp)
  */
 int ABT_info_print_xstream(FILE *fp, ABT_xstream xstream)
 {
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_xstream_snapshot snap;
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    ABTI_xstream_read_snapshot(p_xstream, &snap);
+    ABTI_xstream_print_snapshot(p_xstream, &snap, fp, 0);
+    fflush(fp);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Get the scheduling statistics of the target ES.
+ *
+ * \c ABT_info_query_xstream_stats() copies the statistics of the target ES
+ * \c xstream to \c stats.  The counters are accumulated since the ES was
+ * created.  Work units run by any scheduler are counted, while pops, failed
+ * pops, and steals are counted only by the predefined schedulers.  The ES
+ * updates the counters without synchronization, so a snapshot taken while it
+ * is running may be slightly out of date and not consistent across counters.
+ *
+ * @param[in]  xstream  handle to the target ES
+ * @param[out] stats    statistics of the ES
+ * @return Error code
+ * @retval ABT_SUCCESS  on success
+ */
+int ABT_info_query_xstream_stats(ABT_xstream xstream, ABT_xstream_stats *stats)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    memcpy(stats, &p_xstream->stats, sizeof(ABT_xstream_stats));
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Get the usage of the memory pool.
+ *
+ * \c ABT_info_query_mem() reports to \c stats how much memory the memory pool
+ * holds.  The fields about the caches of ESs describe the target ES \c xstream
+ * if it is given, or the sums over all running ESs if \c xstream is
+ * \c ABT_XSTREAM_NULL.  The other fields describe the global data shared by
+ * all ESs and are filled in either case.  The caches of ESs are read while
+ * they run, so the numbers may be slightly out of date.
+ *
+ * @param[in]  xstream  handle to the target ES or \c ABT_XSTREAM_NULL
+ * @param[out] stats    usage of the memory pool
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA the memory pool is not used
+ */
+int ABT_info_query_mem(ABT_xstream xstream, ABT_mem_stats *stats)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = NULL;
+
+    ABTI_CHECK_INITIALIZED();
+    if (xstream != ABT_XSTREAM_NULL) {
+        p_xstream = ABTI_xstream_get_ptr(xstream);
+        ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+    }
+
+    ABTI_mem_get_stats(p_xstream, stats);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(xstream);
+    ABTI_UNUSED(stats);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Get the memory that the runtime uses for each ULT.
+ *
+ * \c ABT_info_query_thread_mem() reports to \c mem the sizes of the parts of
+ * a ULT created with the default attributes: the descriptor, the unit
+ * embedded in it, the header placed at the bottom of the stack, the stack,
+ * which is \c ABT_THREAD_STACKSIZE, and the key table that the first
+ * \c ABT_key_set() allocates.  They are the runtime's memory overhead per ULT,
+ * of which the stack is usually committed only as far as the ULT touches it.
+ *
+ * @param[out] mem  sizes of the parts of a ULT
+ * @return Error code
+ * @retval ABT_SUCCESS            on success
+ * @retval ABT_ERR_UNINITIALIZED  Argobots has not been initialized
+ */
+int ABT_info_query_thread_mem(ABT_thread_mem *mem)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_INITIALIZED();
+
+    mem->thread_bytes = sizeof(ABTI_thread);
+    mem->unit_bytes = sizeof(ABTI_unit);
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    mem->header_bytes = gp_ABTI_global->mem_sh_size;
+#else
+    mem->header_bytes = sizeof(ABTI_thread);
+#endif
+    mem->stack_bytes = ABTI_global_get_thread_stacksize();
+    mem->ktable_bytes = sizeof(ABTI_ktable) +
+                        gp_ABTI_global->key_table_size * sizeof(ABTI_ktelem);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Get the timing histograms of the work units run by an ES.
+ *
+ * \c ABT_info_query_xstream_unit_stats() copies to \c stats the histograms of
+ * how long the work units run by \c xstream waited in pools and how long
+ * they ran, in nanoseconds.  A run of a ULT lasts until it yields, blocks, or
+ * terminates.  Only work units popped from pools by schedulers are counted,
+ * and ULTs that switch to each other directly skip the scheduler.  The
+ * histograms are collected only if \c ABT_UNIT_STATS is set.  The ES keeps
+ * updating them while they are copied, so the fields may be slightly
+ * inconsistent.
+ *
+ * @param[in]  xstream  handle to the target ES
+ * @param[out] stats    histograms of the ES
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA the histograms are not collected
+ */
+int ABT_info_query_xstream_unit_stats(ABT_xstream xstream,
+                                      ABT_unit_stats *stats)
+{
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+    ABTI_CHECK_TRUE(p_xstream->p_unit_stats != NULL, ABT_ERR_FEATURE_NA);
+
+    memcpy(stats, p_xstream->p_unit_stats, sizeof(ABT_unit_stats));
+    if (stats->queue_delay.count == 0) stats->queue_delay.min = 0;
+    if (stats->run_time.count == 0) stats->run_time.min = 0;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(xstream);
+    ABTI_UNUSED(stats);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Get the timing histograms of the work units taken from a pool.
+ *
+ * \c ABT_info_query_pool_unit_stats() copies to \c stats the histograms of
+ * how long the work units popped from \c pool waited in it and how long the
+ * work units of \c pool ran, in nanoseconds, on any ES.  See
+ * \c ABT_info_query_xstream_unit_stats() for what is counted.  Only pools
+ * created after \c ABT_init() with \c ABT_UNIT_STATS set have histograms.
+ *
+ * @param[in]  pool   handle to the target pool
+ * @param[out] stats  histograms of the pool
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA the histograms are not collected
+ */
+int ABT_info_query_pool_unit_stats(ABT_pool pool, ABT_unit_stats *stats)
+{
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+    ABTI_CHECK_TRUE(p_pool->p_unit_stats != NULL, ABT_ERR_FEATURE_NA);
+
+    memcpy(stats, p_pool->p_unit_stats, sizeof(ABT_unit_stats));
+    if (stats->queue_delay.count == 0) stats->queue_delay.min = 0;
+    if (stats->run_time.count == 0) stats->run_time.min = 0;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(pool);
+    ABTI_UNUSED(stats);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Clear the timing histograms of an ES.
+ *
+ * \c ABT_info_reset_xstream_unit_stats() clears the histograms reported by
+ * \c ABT_info_query_xstream_unit_stats().  Samples that \c xstream records
+ * during the reset may be partially lost.
+ *
+ * @param[in] xstream  handle to the target ES
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA the histograms are not collected
+ */
+int ABT_info_reset_xstream_unit_stats(ABT_xstream xstream)
+{
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
     int abt_errno = ABT_SUCCESS;
     ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
     ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+    ABTI_CHECK_TRUE(p_xstream->p_unit_stats != NULL, ABT_ERR_FEATURE_NA);
+
+    ABTI_unit_stats_reset(p_xstream->p_unit_stats);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(xstream);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Clear the timing histograms of a pool.
+ *
+ * \c ABT_info_reset_pool_unit_stats() clears the histograms reported by
+ * \c ABT_info_query_pool_unit_stats().  Samples recorded during the reset may
+ * be partially lost.
+ *
+ * @param[in] pool  handle to the target pool
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA the histograms are not collected
+ */
+int ABT_info_reset_pool_unit_stats(ABT_pool pool)
+{
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+    ABTI_CHECK_TRUE(p_pool->p_unit_stats != NULL, ABT_ERR_FEATURE_NA);
+
+    ABTI_unit_stats_reset(p_pool->p_unit_stats);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(pool);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Get the operation counters of a pool.
+ *
+ * \c ABT_info_query_pool_stats() copies to \c stats the numbers of the
+ * operations that the ES of rank \c rank did on \c pool, or their sums over
+ * all ESs and external threads if \c rank is \c ABT_XSTREAM_ANY_RANK.  Only
+ * pools created after \c ABT_init() with \c ABT_POOL_STATS set are counted.
+ * The counters of a rank that the pool does not know yet are zero.
+ *
+ * @param[in]  pool   handle to the target pool
+ * @param[in]  rank   rank of an ES, or \c ABT_XSTREAM_ANY_RANK
+ * @param[out] stats  counters of the pool
+ * @return Error code
+ * @retval ABT_SUCCESS              on success
+ * @retval ABT_ERR_INV_XSTREAM_RANK \c rank is invalid
+ * @retval ABT_ERR_FEATURE_NA       the operations are not counted
+ */
+int ABT_info_query_pool_stats(ABT_pool pool, int rank, ABT_pool_stats *stats)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+    ABTI_CHECK_TRUE(rank >= 0 || rank == ABT_XSTREAM_ANY_RANK,
+                    ABT_ERR_INV_XSTREAM_RANK);
+    ABTI_CHECK_TRUE(p_pool->p_stats != NULL, ABT_ERR_FEATURE_NA);
+
+    ABTI_pool_stats_get(p_pool->p_stats, rank, stats);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Clear the operation counters of a pool.
+ *
+ * \c ABT_info_reset_pool_stats() clears the counters reported by
+ * \c ABT_info_query_pool_stats().  Operations done during the reset may be
+ * partially lost.
+ *
+ * @param[in] pool  handle to the target pool
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA the operations are not counted
+ */
+int ABT_info_reset_pool_stats(ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+    ABTI_CHECK_TRUE(p_pool->p_stats != NULL, ABT_ERR_FEATURE_NA);
+
+    ABTI_pool_stats_reset(p_pool->p_stats);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Get the tuning state of a scheduler.
+ *
+ * \c ABT_info_query_sched_tuning() returns through \c tuning the event
+ * frequency and the sleep time that the scheduler \c sched currently uses,
+ * how many times they have been adjusted, and the measurements of the last
+ * tuning window.  The predefined schedulers tune them online if
+ * \c ABT_SCHED_AUTOTUNE is set; otherwise, \c tuning->enabled is
+ * \c ABT_FALSE and \c tuning->event_freq is 0.  The values are read while
+ * the scheduler runs, so they may be slightly out of date.
+ *
+ * @param[in]  sched   handle to the target scheduler
+ * @param[out] tuning  tuning state of the scheduler
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_INV_SCHED invalid scheduler
+ */
+int ABT_info_query_sched_tuning(ABT_sched sched, ABT_sched_tuning *tuning)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+
+    ABTI_sched_tune *p_tune = &p_sched->tune;
+    tuning->enabled = p_tune->enabled;
+    tuning->event_freq = *(volatile uint32_t *)&p_tune->event_freq;
+    tuning->sleep_nsec = *(volatile long *)&p_tune->sleep_nsec;
+    tuning->check_cost = p_tune->check_cost;
+    tuning->check_overhead = p_tune->check_overhead;
+    tuning->idle_ratio = p_tune->idle_ratio;
+    tuning->num_adjustments = p_tune->num_adjustments;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Write the event traces of all ESs to the output stream.
+ *
+ * \c ABT_info_print_trace() writes the events recorded so far by all ESs,
+ * including ESs that have been freed, to the given output stream \c fp in the
+ * Chrome trace event format.  Events are recorded only if \c ABT_TRACE is
+ * set, and each ES keeps only its latest \c ABT_TRACE_SIZE events.  ESs can
+ * keep running while their traces are written, in which case the events
+ * recorded during the call may be partially written.
+ *
+ * @param[in] fp  output stream
+ * @return Error code
+ * @retval ABT_SUCCESS            on success
+ * @retval ABT_ERR_UNINITIALIZED  Argobots has not been initialized
+ */
+int ABT_info_print_trace(FILE *fp)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_INITIALIZED();
+
+    ABTI_trace_print(fp);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup INFO
+ * @brief   Write the sampling profiles of all ESs to the output stream.
+ *
+ * \c ABT_info_print_profile() writes the samples taken so far on all ESs,
+ * including ESs that have been freed, to the given output stream \c fp.
+ * Samples are taken only if \c ABT_PROFILE_INTERVAL is set.  For each ES,
+ * it lists how many times each function was running in each pool, the most
+ * frequent first, with the symbol names of the functions if they can be
+ * found.  ESs can keep running while their profiles are written.
+ *
+ * @param[in] fp  output stream
+ * @return Error code
+ * @retval ABT_SUCCESS            on success
+ * @retval ABT_ERR_UNINITIALIZED  Argobots has not been initialized
+ */
+int ABT_info_print_profile(FILE *fp)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_INITIALIZED();
 
-    ABTI_xstream_print(p_xstream, fp, 0, ABT_FALSE);
+    ABTI_profile_print(fp);
 
   fn_exit:
     return abt_errno;
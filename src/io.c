@@ -0,0 +1,719 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <poll.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+#if defined(HAVE_LINUX_IO_URING_H) && defined(HAVE_SYS_SYSCALL_H)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#ifdef __NR_io_uring_setup
+#define ABTI_IO_USE_URING
+#endif
+#endif
+
+/* I/O waits.  Each ES has a poller, which is an epoll instance created when a
+ * ULT on the ES waits for a file descriptor for the first time.  The waiting
+ * ULT registers itself with EPOLLONESHOT and is blocked, and the scheduler of
+ * the ES polls the instance without blocking whenever it checks events.
+ *
+ * The poller is the only one that wakes up its waiters, whether their
+ * descriptors become ready, their deadlines pass, or the ES is freed.  It
+ * removes a waiter from the epoll instance and from its list before it makes
+ * the ULT ready, so a woken ULT never touches the poller again, even if it is
+ * resumed on another ES.
+ *
+ * File I/O of ULTs goes through an io_uring instance of the ES in the same
+ * way.  A ULT only puts an SQE in the ring and is blocked, and the scheduler
+ * submits all the SQEs queued since its last check with one io_uring_enter()
+ * and resumes the ULTs whose CQEs have arrived.  The number of requests in
+ * flight is bounded by the size of the CQ ring so that no CQE is dropped. */
+
+/* Number of events taken by one epoll_wait() of a poller */
+#define ABTI_IO_POLLER_BATCH    64
+
+#define ABTI_IO_EVENTS          (POLLIN | POLLPRI | POLLOUT)
+
+/* Number of SQEs of an io_uring instance */
+#define ABTI_IO_RING_ENTRIES    1024
+
+enum {
+    ABTI_IO_OP_READ,
+    ABTI_IO_OP_WRITE,
+    ABTI_IO_OP_FSYNC
+};
+
+static int ABTI_io_poll(int fd, int events, double deadline, int *p_revents);
+static int ABTI_io_rw(int op, int fd, void *buf, size_t count, off_t offset,
+                      ssize_t *p_result);
+#ifdef HAVE_SYS_EPOLL_H
+static int ABTI_io_wait_thread(ABTI_thread *p_thread, int fd, int events,
+                               double deadline, int *p_revents);
+static void ABTI_io_poller_add(ABTI_io_poller *p_poller,
+                               ABTI_io_waiter *p_waiter);
+static void ABTI_io_poller_wake(ABTI_io_poller *p_poller,
+                                ABTI_io_waiter *p_waiter, int revents,
+                                int status);
+static void ABTI_io_poller_expire(ABTI_io_poller *p_poller, double now);
+#endif
+#ifdef ABTI_IO_USE_URING
+/* File I/O request of a ULT, which lives on its stack */
+typedef struct {
+    ABTI_thread *p_thread;
+    int32_t result;             /* res of the CQE */
+} ABTI_io_req;
+
+static void ABTI_io_ring_init(ABTI_io_ring *p_ring);
+static void ABTI_io_ring_fini(ABTI_io_ring *p_ring);
+static ABT_bool ABTI_io_ring_reserve(ABTI_io_ring *p_ring);
+static int32_t ABTI_io_ring_wait(ABTI_io_poller *p_poller,
+                                 ABTI_thread *p_thread, int op, int fd,
+                                 void *buf, size_t count, off_t offset);
+static void ABTI_io_ring_submit(ABTI_io_ring *p_ring);
+static void ABTI_io_ring_reap(ABTI_io_poller *p_poller);
+#endif
+
+
+/** @defgroup IO I/O wait
+ * ULTs can wait for file descriptors without blocking their ESs.  A waiting
+ * ULT is blocked, and the scheduler of its ES, which polls the descriptors of
+ * its waiters with epoll whenever it checks events, resumes the ULT once the
+ * descriptor becomes ready.  Hence, ULTs on a few ESs can serve many
+ * connections without dedicating OS-level threads to I/O.  Likewise, file
+ * reads and writes of ULTs are submitted to io_uring, and the ULTs are
+ * resumed on completion.
+ */
+
+/**
+ * @ingroup IO
+ * @brief   Wait until the file descriptor is ready for I/O.
+ *
+ * \c ABT_io_wait() waits until the file descriptor \c fd is ready for the
+ * events \c events, which is a mask of \c POLLIN, \c POLLPRI, and \c POLLOUT
+ * as for \c poll(), or until \c timeout seconds pass.  A negative \c timeout
+ * means no timeout.  The ready events, which may include \c POLLERR,
+ * \c POLLHUP, and \c POLLNVAL, are returned through \c revents unless it is
+ * \c NULL.
+ *
+ * If \c fd is not ready when a ULT calls this routine, the ULT is blocked and
+ * woken up by the scheduler of its ES, so the ULT may be resumed somewhat
+ * later than the descriptor becomes ready or the timeout passes.  Only one ULT
+ * on each ES may wait for the same descriptor at a time, and \c fd must not
+ * be closed while it is waited for.  If the ES is freed in the meantime, the
+ * ULT is resumed with \c ABT_ERR_IO.
+ *
+ * Since a tasklet cannot be blocked, it only checks whether \c fd is ready, as
+ * if \c timeout were zero.  An external thread waits in \c poll().
+ *
+ * @param[in]  fd       file descriptor
+ * @param[in]  events   events to wait for
+ * @param[in]  timeout  timeout in seconds, or negative for no timeout
+ * @param[out] revents  ready events
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_TIMEDOUT \c fd has not become ready within \c timeout
+ * @retval ABT_ERR_IO       invalid \c events, the descriptor cannot be
+ *                          waited for, or the ES has been freed
+ */
+int ABT_io_wait(int fd, int events, double timeout, int *revents)
+{
+    int abt_errno = ABT_SUCCESS;
+    int ready = 0;
+    double deadline;
+    ABTI_CHECK_TRUE(fd >= 0 && (events & ~ABTI_IO_EVENTS) == 0, ABT_ERR_IO);
+
+    /* Check it first since the descriptor is often ready. */
+    abt_errno = ABTI_io_poll(fd, events, 0.0, &ready);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    if (ready == 0 && timeout != 0.0) {
+        deadline = (timeout < 0.0) ? -1.0 : ABTI_timeout_get_time() + timeout;
+        if (lp_ABTI_local == NULL) {
+            /* External thread */
+            abt_errno = ABTI_io_poll(fd, events, deadline, &ready);
+        } else if (ABTI_local_get_task() == NULL) {
+            ABTI_thread *p_thread = ABTI_local_get_thread();
+#ifdef HAVE_SYS_EPOLL_H
+            abt_errno = ABTI_io_wait_thread(p_thread, fd, events, deadline,
+                                            &ready);
+#else
+            /* Without epoll, the ULT polls the descriptor between yields. */
+            while (ready == 0 && abt_errno == ABT_SUCCESS &&
+                   (deadline < 0.0 || ABTI_timeout_get_time() < deadline)) {
+                ABTI_thread_yield(p_thread);
+                abt_errno = ABTI_io_poll(fd, events, 0.0, &ready);
+            }
+#endif
+        }
+        if (abt_errno == ABT_ERR_IO) goto fn_fail;
+    }
+
+    /* Not an error worth reporting */
+    if (ready == 0 && abt_errno == ABT_SUCCESS) abt_errno = ABT_ERR_TIMEDOUT;
+    if (revents) *revents = ready;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup IO
+ * @brief   Read from the file descriptor at the given offset.
+ *
+ * \c ABT_io_read() reads up to \c count bytes from the file descriptor \c fd
+ * at the offset \c offset into \c buf, as \c pread() does, and returns the
+ * number of bytes read through \c result unless it is \c NULL.  The file
+ * offset of \c fd is not changed.
+ *
+ * A ULT queues the request in the io_uring instance of its ES and is blocked
+ * until the request completes.  The requests queued by the ULTs on an ES are
+ * submitted together when the scheduler of the ES checks events.  Tasklets,
+ * external threads, and ULTs for which io_uring is not available call
+ * \c pread() instead, which may block the ES.
+ *
+ * If the operation fails, \c ABT_ERR_IO is returned and \c errno is set as
+ * \c pread() would set it.
+ *
+ * @param[in]  fd      file descriptor
+ * @param[out] buf     buffer
+ * @param[in]  count   number of bytes to read
+ * @param[in]  offset  file offset
+ * @param[out] result  number of bytes read
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_IO  \c fd or \c offset is negative, or the read failed
+ */
+int ABT_io_read(int fd, void *buf, size_t count, off_t offset,
+                ssize_t *result)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_TRUE(fd >= 0 && offset >= 0, ABT_ERR_IO);
+
+    /* A failure of the OS is reported through errno. */
+    abt_errno = ABTI_io_rw(ABTI_IO_OP_READ, fd, buf, count, offset, result);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup IO
+ * @brief   Write to the file descriptor at the given offset.
+ *
+ * \c ABT_io_write() writes up to \c count bytes from \c buf to the file
+ * descriptor \c fd at the offset \c offset, as \c pwrite() does, and returns
+ * the number of bytes written through \c result unless it is \c NULL.  It
+ * is submitted as \c ABT_io_read() is.
+ *
+ * If the operation fails, \c ABT_ERR_IO is returned and \c errno is set as
+ * \c pwrite() would set it.
+ *
+ * @param[in]  fd      file descriptor
+ * @param[in]  buf     buffer
+ * @param[in]  count   number of bytes to write
+ * @param[in]  offset  file offset
+ * @param[out] result  number of bytes written
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_IO  \c fd or \c offset is negative, or the write failed
+ */
+int ABT_io_write(int fd, const void *buf, size_t count, off_t offset,
+                 ssize_t *result)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_TRUE(fd >= 0 && offset >= 0, ABT_ERR_IO);
+
+    /* A failure of the OS is reported through errno. */
+    abt_errno = ABTI_io_rw(ABTI_IO_OP_WRITE, fd, (void *)buf, count, offset,
+                           result);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup IO
+ * @brief   Flush the file to the storage device.
+ *
+ * \c ABT_io_fsync() flushes the data and the metadata of the file referred to
+ * by \c fd, as \c fsync() does.  It is submitted as \c ABT_io_read() is.
+ *
+ * If the operation fails, \c ABT_ERR_IO is returned and \c errno is set as
+ * \c fsync() would set it.
+ *
+ * @param[in] fd  file descriptor
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_IO  \c fd is negative, or the flush failed
+ */
+int ABT_io_fsync(int fd)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_TRUE(fd >= 0, ABT_ERR_IO);
+
+    /* A failure of the OS is reported through errno. */
+    abt_errno = ABTI_io_rw(ABTI_IO_OP_FSYNC, fd, NULL, 0, 0, NULL);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+void ABTI_io_poller_init(ABTI_io_poller *p_poller)
+{
+    p_poller->epfd = -1;
+    p_poller->num_waiters = 0;
+    p_poller->next_deadline = -1.0;
+    p_poller->p_head = NULL;
+    p_poller->ring.fd = -1;
+    p_poller->ring.num_unsubmitted = 0;
+    p_poller->ring.num_inflight = 0;
+}
+
+/* Wake up the waiters left on an ES being freed with ABT_ERR_IO.  File I/O
+ * requests cannot be canceled, so this waits for their completion. */
+void ABTI_io_poller_fini(ABTI_io_poller *p_poller)
+{
+#ifdef ABTI_IO_USE_URING
+    ABTI_io_ring *p_ring = &p_poller->ring;
+    while (p_ring->num_inflight > 0) {
+        if (p_ring->num_unsubmitted > 0) ABTI_io_ring_submit(p_ring);
+        syscall(__NR_io_uring_enter, p_ring->fd, 0, 1,
+                IORING_ENTER_GETEVENTS, NULL, 0);
+        ABTI_io_ring_reap(p_poller);
+    }
+    if (p_ring->fd >= 0) ABTI_io_ring_fini(p_ring);
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+    while (p_poller->p_head) {
+        ABTI_io_poller_wake(p_poller, p_poller->p_head, 0, ABT_ERR_IO);
+    }
+    if (p_poller->epfd >= 0) {
+        close(p_poller->epfd);
+        p_poller->epfd = -1;
+    }
+#endif
+}
+
+/* Wake up the waiters whose descriptors are ready or whose deadlines have
+ * passed, and submit and complete file I/O requests.  Only the ES that owns
+ * p_poller may call this. */
+void ABTI_io_poller_poll(ABTI_io_poller *p_poller)
+{
+#ifdef ABTI_IO_USE_URING
+    if (p_poller->ring.num_inflight > 0) {
+        if (p_poller->ring.num_unsubmitted > 0) {
+            ABTI_io_ring_submit(&p_poller->ring);
+        }
+        ABTI_io_ring_reap(p_poller);
+    }
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event events[ABTI_IO_POLLER_BATCH];
+    int i, n;
+
+    if (p_poller->p_head == NULL) return;
+    n = epoll_wait(p_poller->epfd, events, ABTI_IO_POLLER_BATCH, 0);
+    for (i = 0; i < n; i++) {
+        ABTI_io_waiter *p_waiter = (ABTI_io_waiter *)events[i].data.ptr;
+        uint32_t e = events[i].events;
+        int revents = ((e & EPOLLIN)  ? POLLIN  : 0) |
+                      ((e & EPOLLPRI) ? POLLPRI : 0) |
+                      ((e & EPOLLOUT) ? POLLOUT : 0) |
+                      ((e & EPOLLERR) ? POLLERR : 0) |
+                      ((e & EPOLLHUP) ? POLLHUP : 0);
+        ABTI_io_poller_wake(p_poller, p_waiter, revents, ABT_SUCCESS);
+    }
+
+    if (p_poller->next_deadline >= 0.0) {
+        double now = ABTI_timeout_get_time();
+        if (now >= p_poller->next_deadline) {
+            ABTI_io_poller_expire(p_poller, now);
+        }
+    }
+#endif
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+/* poll() the descriptor until the deadline, which is not checked if it is
+ * negative.  A deadline that has passed, e.g., zero, just checks it. */
+static int ABTI_io_poll(int fd, int events, double deadline, int *p_revents)
+{
+    struct pollfd pfd;
+    int ret;
+
+    pfd.fd = fd;
+    pfd.events = (short)events;
+    while (1) {
+        int timeout_ms = -1;
+        if (deadline >= 0.0) {
+            double remain = (deadline - ABTI_timeout_get_time()) * 1.0e3;
+            if (remain <= 0.0) {
+                timeout_ms = 0;
+            } else if (remain < (double)INT_MAX) {
+                /* Round up so that it does not return just before the
+                 * deadline. */
+                timeout_ms = (int)remain;
+                if ((double)timeout_ms < remain) timeout_ms++;
+            } else {
+                timeout_ms = INT_MAX;
+            }
+        }
+
+        pfd.revents = 0;
+        ret = poll(&pfd, 1, timeout_ms);
+        if (ret > 0) {
+            *p_revents = pfd.revents;
+            return ABT_SUCCESS;
+        }
+        if (ret < 0 && errno != EINTR) return ABT_ERR_IO;
+        if (timeout_ms == 0) break;
+    }
+    *p_revents = 0;
+    return ABT_SUCCESS;
+}
+
+/* Perform a file I/O operation.  On failure, errno is set and ABT_ERR_IO is
+ * returned. */
+static int ABTI_io_rw(int op, int fd, void *buf, size_t count, off_t offset,
+                      ssize_t *p_result)
+{
+    ssize_t res;
+
+#ifdef ABTI_IO_USE_URING
+    if (lp_ABTI_local != NULL && ABTI_local_get_task() == NULL) {
+        ABTI_thread *p_thread = ABTI_local_get_thread();
+        while (1) {
+            /* The ULT may be on another ES after yielding. */
+            ABTI_io_poller *p_poller = &ABTI_local_get_xstream()->io_poller;
+            ABTI_io_ring *p_ring = &p_poller->ring;
+            if (p_ring->fd == -1) ABTI_io_ring_init(p_ring);
+            if (p_ring->fd < 0) break;
+            if (ABTI_io_ring_reserve(p_ring) == ABT_TRUE) {
+                res = ABTI_io_ring_wait(p_poller, p_thread, op, fd, buf,
+                                        count, offset);
+                goto done;
+            }
+            /* Let the scheduler complete requests. */
+            ABTI_thread_yield(p_thread);
+        }
+    }
+#endif
+
+    do {
+        if (op == ABTI_IO_OP_READ) {
+            res = pread(fd, buf, count, offset);
+        } else if (op == ABTI_IO_OP_WRITE) {
+            res = pwrite(fd, buf, count, offset);
+        } else {
+            res = fsync(fd);
+        }
+    } while (res < 0 && errno == EINTR);
+    if (res < 0) res = -errno;
+
+#ifdef ABTI_IO_USE_URING
+  done:
+#endif
+    if (res < 0) {
+        errno = (int)-res;
+        return ABT_ERR_IO;
+    }
+    if (p_result) *p_result = res;
+    return ABT_SUCCESS;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/* Register the calling ULT in the poller of its ES and suspend it until the
+ * poller wakes it up. */
+static int ABTI_io_wait_thread(ABTI_thread *p_thread, int fd, int events,
+                               double deadline, int *p_revents)
+{
+    ABTI_io_poller *p_poller = &ABTI_local_get_xstream()->io_poller;
+    ABTI_io_waiter waiter;
+    struct epoll_event ev;
+
+    if (p_poller->epfd < 0) {
+        p_poller->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (p_poller->epfd < 0) return ABT_ERR_IO;
+    }
+
+    waiter.p_thread = p_thread;
+    waiter.fd = fd;
+    waiter.revents = 0;
+    waiter.status = ABT_ERR_IO;
+    waiter.deadline = deadline;
+
+    ev.events = EPOLLONESHOT |
+                ((events & POLLIN)  ? EPOLLIN  : 0) |
+                ((events & POLLPRI) ? EPOLLPRI : 0) |
+                ((events & POLLOUT) ? EPOLLOUT : 0);
+    ev.data.ptr = &waiter;
+    /* This fails if another ULT on this ES waits for fd. */
+    if (epoll_ctl(p_poller->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        return ABT_ERR_IO;
+    }
+
+    /* The poller does not run until this ULT is suspended since it is called
+     * by the scheduler of this ES. */
+    ABTI_thread_set_blocked(p_thread);
+    ABTI_io_poller_add(p_poller, &waiter);
+    ABTI_thread_suspend(p_thread);
+
+    *p_revents = waiter.revents;
+    return waiter.status;
+}
+
+static void ABTI_io_poller_add(ABTI_io_poller *p_poller,
+                               ABTI_io_waiter *p_waiter)
+{
+    p_waiter->p_prev = NULL;
+    p_waiter->p_next = p_poller->p_head;
+    if (p_poller->p_head) p_poller->p_head->p_prev = p_waiter;
+    p_poller->p_head = p_waiter;
+    p_poller->num_waiters++;
+
+    if (p_waiter->deadline >= 0.0 &&
+        (p_poller->next_deadline < 0.0 ||
+         p_waiter->deadline < p_poller->next_deadline)) {
+        p_poller->next_deadline = p_waiter->deadline;
+    }
+}
+
+/* Take the waiter out of the poller and resume it.  The waiter must not be
+ * touched once the ULT is made ready since it may return at any time.
+ * next_deadline is left as it is, which only costs an extra scan. */
+static void ABTI_io_poller_wake(ABTI_io_poller *p_poller,
+                                ABTI_io_waiter *p_waiter, int revents,
+                                int status)
+{
+    ABTI_thread *p_thread = p_waiter->p_thread;
+
+    /* EPOLLONESHOT has disabled it, but it has to be removed so that fd can
+     * be waited for again. */
+    epoll_ctl(p_poller->epfd, EPOLL_CTL_DEL, p_waiter->fd, NULL);
+
+    if (p_waiter->p_prev) {
+        p_waiter->p_prev->p_next = p_waiter->p_next;
+    } else {
+        p_poller->p_head = p_waiter->p_next;
+    }
+    if (p_waiter->p_next) p_waiter->p_next->p_prev = p_waiter->p_prev;
+    p_poller->num_waiters--;
+
+    p_waiter->revents = revents;
+    p_waiter->status = status;
+    ABTI_thread_set_ready(p_thread);
+}
+
+/* Time out the waiters whose deadlines have passed and find the next
+ * deadline. */
+static void ABTI_io_poller_expire(ABTI_io_poller *p_poller, double now)
+{
+    ABTI_io_waiter *p_waiter = p_poller->p_head;
+    double next_deadline = -1.0;
+
+    while (p_waiter) {
+        ABTI_io_waiter *p_next = p_waiter->p_next;
+        if (p_waiter->deadline >= 0.0) {
+            if (p_waiter->deadline <= now) {
+                ABTI_io_poller_wake(p_poller, p_waiter, 0, ABT_ERR_TIMEDOUT);
+            } else if (next_deadline < 0.0 ||
+                       p_waiter->deadline < next_deadline) {
+                next_deadline = p_waiter->deadline;
+            }
+        }
+        p_waiter = p_next;
+    }
+    p_poller->next_deadline = next_deadline;
+}
+#endif
+
+#ifdef ABTI_IO_USE_URING
+/* Create the io_uring instance of an ES and map its rings.  If io_uring is
+ * not available, e.g., because of the kernel or a seccomp filter, the ring is
+ * marked as such and the ULTs on the ES fall back on synchronous calls. */
+static void ABTI_io_ring_init(ABTI_io_ring *p_ring)
+{
+    struct io_uring_params params;
+    char *sq_ring, *cq_ring;
+    int fd;
+
+    memset(&params, 0, sizeof(params));
+    fd = (int)syscall(__NR_io_uring_setup, ABTI_IO_RING_ENTRIES, &params);
+    if (fd < 0) {
+        p_ring->fd = -2;
+        return;
+    }
+
+    p_ring->fd = fd;
+    p_ring->sq_ring_size = params.sq_off.array +
+                           params.sq_entries * sizeof(uint32_t);
+    p_ring->cq_ring_size = params.cq_off.cqes +
+                           params.cq_entries * sizeof(struct io_uring_cqe);
+    p_ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    p_ring->sq_ring = mmap(NULL, p_ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    p_ring->cq_ring = mmap(NULL, p_ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    p_ring->sqes = mmap(NULL, p_ring->sqes_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (p_ring->sq_ring == MAP_FAILED || p_ring->cq_ring == MAP_FAILED ||
+        p_ring->sqes == MAP_FAILED) {
+        ABTI_io_ring_fini(p_ring);
+        p_ring->fd = -2;
+        return;
+    }
+
+    sq_ring = (char *)p_ring->sq_ring;
+    cq_ring = (char *)p_ring->cq_ring;
+    p_ring->sq_mask = *(uint32_t *)(sq_ring + params.sq_off.ring_mask);
+    p_ring->sq_head = (uint32_t *)(sq_ring + params.sq_off.head);
+    p_ring->sq_tail = (uint32_t *)(sq_ring + params.sq_off.tail);
+    p_ring->sq_array = (uint32_t *)(sq_ring + params.sq_off.array);
+    p_ring->cq_mask = *(uint32_t *)(cq_ring + params.cq_off.ring_mask);
+    p_ring->cq_entries = params.cq_entries;
+    p_ring->cq_head = (uint32_t *)(cq_ring + params.cq_off.head);
+    p_ring->cq_tail = (uint32_t *)(cq_ring + params.cq_off.tail);
+    p_ring->cqes = cq_ring + params.cq_off.cqes;
+}
+
+static void ABTI_io_ring_fini(ABTI_io_ring *p_ring)
+{
+    if (p_ring->sq_ring != MAP_FAILED) {
+        munmap(p_ring->sq_ring, p_ring->sq_ring_size);
+    }
+    if (p_ring->cq_ring != MAP_FAILED) {
+        munmap(p_ring->cq_ring, p_ring->cq_ring_size);
+    }
+    if (p_ring->sqes != MAP_FAILED) munmap(p_ring->sqes, p_ring->sqes_size);
+    close(p_ring->fd);
+    p_ring->fd = -1;
+}
+
+/* Returns ABT_TRUE if a request can be queued now.  The SQ ring is flushed if
+ * it is full. */
+static ABT_bool ABTI_io_ring_reserve(ABTI_io_ring *p_ring)
+{
+    if (p_ring->num_inflight >= p_ring->cq_entries) return ABT_FALSE;
+    if (p_ring->num_unsubmitted > p_ring->sq_mask) {
+        ABTI_io_ring_submit(p_ring);
+        if (p_ring->num_unsubmitted > p_ring->sq_mask) return ABT_FALSE;
+    }
+    return ABT_TRUE;
+}
+
+/* Queue a request of the calling ULT and suspend it until the request
+ * completes.  Returns res of the CQE. */
+static int32_t ABTI_io_ring_wait(ABTI_io_poller *p_poller,
+                                 ABTI_thread *p_thread, int op, int fd,
+                                 void *buf, size_t count, off_t offset)
+{
+    ABTI_io_ring *p_ring = &p_poller->ring;
+    ABTI_io_req req;
+    struct iovec iov;
+    struct io_uring_sqe *p_sqe;
+    uint32_t tail = *p_ring->sq_tail;
+    uint32_t index = tail & p_ring->sq_mask;
+
+    /* The iovec and req stay on the stack until the request completes. */
+    p_sqe = &((struct io_uring_sqe *)p_ring->sqes)[index];
+    memset(p_sqe, 0, sizeof(struct io_uring_sqe));
+    p_sqe->fd = fd;
+    if (op == ABTI_IO_OP_FSYNC) {
+        p_sqe->opcode = IORING_OP_FSYNC;
+    } else {
+        iov.iov_base = buf;
+        iov.iov_len = count;
+        p_sqe->opcode = (op == ABTI_IO_OP_READ) ? IORING_OP_READV
+                                                : IORING_OP_WRITEV;
+        p_sqe->addr = (uint64_t)(uintptr_t)&iov;
+        p_sqe->len = 1;
+        p_sqe->off = (uint64_t)offset;
+    }
+    p_sqe->user_data = (uint64_t)(uintptr_t)&req;
+    req.p_thread = p_thread;
+    req.result = 0;
+    p_ring->sq_array[index] = index;
+
+    /* The kernel has to see the SQE before the new tail. */
+    ABTD_atomic_write_barrier();
+    *(volatile uint32_t *)p_ring->sq_tail = tail + 1;
+    p_ring->num_unsubmitted++;
+    p_ring->num_inflight++;
+    p_poller->num_waiters++;
+
+    /* The scheduler of this ES submits it after this ULT is suspended. */
+    ABTI_thread_set_blocked(p_thread);
+    ABTI_thread_suspend(p_thread);
+
+    return req.result;
+}
+
+static void ABTI_io_ring_submit(ABTI_io_ring *p_ring)
+{
+    int ret = (int)syscall(__NR_io_uring_enter, p_ring->fd,
+                           p_ring->num_unsubmitted, 0, 0, NULL, 0);
+    /* SQEs that are not consumed, e.g., on EBUSY or EAGAIN, are submitted at
+     * the next check. */
+    if (ret > 0) p_ring->num_unsubmitted -= (uint32_t)ret;
+}
+
+/* Resume the ULTs whose requests have completed. */
+static void ABTI_io_ring_reap(ABTI_io_poller *p_poller)
+{
+    ABTI_io_ring *p_ring = &p_poller->ring;
+    uint32_t head = *p_ring->cq_head;
+    uint32_t tail = *(volatile uint32_t *)p_ring->cq_tail;
+
+    if (head == tail) return;
+    /* CQEs must be read after the tail. */
+    ABTD_atomic_mem_barrier();
+    while (head != tail) {
+        struct io_uring_cqe *p_cqe =
+            &((struct io_uring_cqe *)p_ring->cqes)[head & p_ring->cq_mask];
+        ABTI_io_req *p_req = (ABTI_io_req *)(uintptr_t)p_cqe->user_data;
+        ABTI_thread *p_thread = p_req->p_thread;
+        p_req->result = p_cqe->res;
+        p_ring->num_inflight--;
+        p_poller->num_waiters--;
+        ABTI_thread_set_ready(p_thread);
+        head++;
+    }
+    /* The kernel may reuse the CQEs once the head is updated. */
+    ABTD_atomic_mem_barrier();
+    *(volatile uint32_t *)p_ring->cq_head = head;
+}
+#endif
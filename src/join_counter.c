@@ -0,0 +1,147 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+
+/** @defgroup JOIN_COUNTER Join Counter
+ * A \a join counter is a counting latch for joining many ULTs at once.  ULTs
+ * created with a ULT attribute that has a join counter (see
+ * \c ABT_thread_attr_set_join_counter()) increment the counter when they are
+ * created and decrement it when they terminate.  A ULT waiting on the counter
+ * is woken up only once, when the count reaches zero, instead of being
+ * switched to and from for each ULT as with \c ABT_thread_join().
+ */
+
+/**
+ * @ingroup JOIN_COUNTER
+ * @brief   Create a new join counter.
+ *
+ * \c ABT_join_counter_create() creates a new join counter whose count is zero
+ * and returns its handle through \c newcounter.
+ *
+ * @param[out] newcounter  handle to a new join counter
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_join_counter_create(ABT_join_counter *newcounter)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_join_counter *p_counter;
+
+    p_counter = (ABTI_join_counter *)
+        ABTU_malloc_cache_aligned(sizeof(ABTI_join_counter));
+    ABTI_wait_group_init(&p_counter->wg);
+
+    *newcounter = ABTI_join_counter_get_handle(p_counter);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup JOIN_COUNTER
+ * @brief   Free the join counter.
+ *
+ * \c ABT_join_counter_free() releases the join counter \c counter.  All the
+ * ULTs counted by \c counter must have terminated, i.e., the count must be
+ * zero, and no ULT created with an attribute that has \c counter can be
+ * created or revived afterwards.  If it is successfully processed,
+ * \c counter is set to \c ABT_JOIN_COUNTER_NULL.
+ *
+ * @param[in,out] counter  handle to the join counter
+ * @return Error code
+ * @retval ABT_SUCCESS              on success
+ * @retval ABT_ERR_INV_JOIN_COUNTER the count is not zero
+ */
+int ABT_join_counter_free(ABT_join_counter *counter)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_join_counter *p_counter = ABTI_join_counter_get_ptr(*counter);
+    ABTI_CHECK_NULL_JOIN_COUNTER_PTR(p_counter);
+    ABTI_CHECK_TRUE(*(volatile uint64_t *)&p_counter->wg.state == 0,
+                    ABT_ERR_INV_JOIN_COUNTER);
+
+    ABTU_free(p_counter);
+
+    *counter = ABT_JOIN_COUNTER_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup JOIN_COUNTER
+ * @brief   Wait until all the ULTs counted by the join counter terminate.
+ *
+ * \c ABT_join_counter_wait() blocks the caller ULT until the count of
+ * \c counter becomes zero.  The caller is not woken up by each terminating
+ * ULT but only by the one that brings the count to zero.  The ULTs counted by
+ * \c counter must have been created before this routine is called, and only
+ * one ULT can wait on \c counter at a time.  An external thread waits by
+ * polling the count.  If the count is already zero, this routine returns
+ * immediately.
+ *
+ * The counted ULTs are not freed by this routine.  Unnamed ULTs are freed
+ * when they terminate, and named ones still need \c ABT_thread_free().
+ *
+ * @param[in] counter  handle to the join counter
+ * @return Error code
+ * @retval ABT_SUCCESS              on success
+ * @retval ABT_ERR_INV_JOIN_COUNTER another ULT is waiting on \c counter
+ * @retval ABT_ERR_THREAD           called by a tasklet
+ */
+int ABT_join_counter_wait(ABT_join_counter counter)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_join_counter *p_counter = ABTI_join_counter_get_ptr(counter);
+    ABTI_CHECK_NULL_JOIN_COUNTER_PTR(p_counter);
+
+    abt_errno = ABTI_wait_group_wait(&p_counter->wg);
+    if (abt_errno != ABT_SUCCESS) {
+        abt_errno = (ABTI_local_get_task() != NULL) ? ABT_ERR_THREAD
+                                                    : ABT_ERR_INV_JOIN_COUNTER;
+        goto fn_fail;
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup JOIN_COUNTER
+ * @brief   Get the count of the join counter.
+ *
+ * \c ABT_join_counter_get_count() returns through \c count the number of ULTs
+ * that are counted by \c counter and have not terminated yet.
+ *
+ * @param[in]  counter  handle to the join counter
+ * @param[out] count    number of ULTs not terminated yet
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_join_counter_get_count(ABT_join_counter counter, uint32_t *count)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_join_counter *p_counter = ABTI_join_counter_get_ptr(counter);
+    ABTI_CHECK_NULL_JOIN_COUNTER_PTR(p_counter);
+
+    *count = ABTI_wait_group_get_count(&p_counter->wg);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
@@ -14,8 +14,17 @@ static inline void ABTI_ktable_set(ABTI_ktable *p_ktable, ABTI_key *p_key,
                                    void *value);
 static inline void *ABTI_ktable_get(ABTI_ktable *p_ktable, ABTI_key *p_key);
 void ABTI_ktable_delete(ABTI_ktable *p_ktable, ABTI_key *p_key);
-
-static uint32_t g_key_id = 0;
+static uint32_t ABTI_key_alloc_id(void);
+static void ABTI_key_release(ABTI_key *p_key);
+
+/* Key IDs are kept dense so that they can directly index the slots of the
+ * key tables.  The ID of a key is recycled once no key table refers to the
+ * key anymore. */
+static ABTI_spinlock g_key_lock;
+static uint32_t g_key_id = 0;       /* Next ID that has never been used */
+static uint32_t *g_key_free_ids = NULL;
+static uint32_t g_key_num_free_ids = 0;
+static uint32_t g_key_max_free_ids = 0;
 
 /**
  * @ingroup KEY
@@ -50,7 +59,7 @@ int ABT_key_create(void (*destructor)(void *value), ABT_key *newkey)
 
     p_newkey = (ABTI_key *)ABTU_malloc(sizeof(ABTI_key));
     p_newkey->f_destructor = destructor;
-    p_newkey->id = ABTD_atomic_fetch_add_uint32(&g_key_id, 1);
+    p_newkey->id = ABTI_key_alloc_id();
     p_newkey->refcount = 1;
     p_newkey->freed = ABT_FALSE;
 
@@ -80,13 +89,8 @@ int ABT_key_free(ABT_key *key)
     ABTI_key *p_key = ABTI_key_get_ptr(h_key);
     ABTI_CHECK_NULL_KEY_PTR(p_key);
 
-    uint32_t refcount;
-
     p_key->freed = ABT_TRUE;
-    refcount = ABTD_atomic_fetch_sub_uint32(&p_key->refcount, 1);
-    if (refcount == 1) {
-        ABTU_free(p_key);
-    }
+    ABTI_key_release(p_key);
 
     /* Return value */
     *key = ABT_KEY_NULL;
@@ -212,121 +216,194 @@ int ABT_key_get(ABT_key key, void **value)
     goto fn_exit;
 }
 
-ABTI_ktable *ABTI_ktable_alloc(int size)
+ABTI_ktable *ABTI_ktable_alloc(uint32_t size)
 {
+    ABTI_local *p_local = lp_ABTI_local;
     ABTI_ktable *p_ktable;
 
-    p_ktable = (ABTI_ktable *)ABTU_malloc(sizeof(ABTI_ktable));
+    /* A cached table has been cleared. */
+    if (p_local != NULL && p_local->p_ktables != NULL &&
+        p_local->p_ktables->size == size) {
+        p_ktable = p_local->p_ktables;
+        p_local->p_ktables = p_ktable->p_next;
+        p_local->num_ktables--;
+        return p_ktable;
+    }
+
+    /* The initial slots follow the table header. */
+    p_ktable = (ABTI_ktable *)ABTU_malloc(sizeof(ABTI_ktable) +
+                                          size * sizeof(ABTI_ktelem));
     p_ktable->size = size;
-    p_ktable->num = 0;
-    p_ktable->p_elems = (ABTI_ktelem **)ABTU_calloc(size, sizeof(ABTI_ktelem *));
+    p_ktable->used_head = ABTI_KTABLE_END;
+    p_ktable->p_elems = (ABTI_ktelem *)(p_ktable + 1);
+    memset(p_ktable->p_elems, 0, size * sizeof(ABTI_ktelem));
 
     return p_ktable;
 }
 
-void ABTI_ktable_free(ABTI_ktable *p_ktable)
+/* Empty the table, calling the destructors.  Only the used slots are
+ * visited. */
+void ABTI_ktable_clear(ABTI_ktable *p_ktable)
 {
-    ABTI_ktelem *p_elem, *p_next;
+    ABTI_ktelem *p_elem;
     ABTI_key *p_key;
-    int i;
-    uint32_t refcount;
-
-    for (i = 0; i < p_ktable->size; i++) {
-        p_elem = p_ktable->p_elems[i];
-        while (p_elem) {
-            /* Call the destructor if it exists and the value is not null. */
-            p_key = p_elem->p_key;
-            if (p_key->f_destructor && p_elem->value) {
-                p_key->f_destructor(p_elem->value);
-            }
-            refcount = ABTD_atomic_fetch_sub_uint32(&p_key->refcount, 1);
-            if (refcount == 1 && p_key->freed == ABT_TRUE) {
-                ABTU_free(p_key);
-            }
-
-            p_next = p_elem->p_next;
-            ABTU_free(p_elem);
-            p_elem = p_next;
+    void *value;
+    uint32_t i;
+
+    while (p_ktable->used_head != ABTI_KTABLE_END) {
+        i = p_ktable->used_head;
+        p_elem = &p_ktable->p_elems[i];
+        p_ktable->used_head = p_elem->next;
+
+        p_key = p_elem->p_key;
+        value = p_elem->value;
+        p_elem->p_key = NULL;
+        p_elem->value = NULL;
+        p_elem->used = ABT_FALSE;
+        if (p_key == NULL) continue;
+
+        /* Call the destructor if it exists and the value is not null. */
+        if (p_key->f_destructor && value) {
+            p_key->f_destructor(value);
         }
+        ABTI_key_release(p_key);
     }
+}
 
-    ABTU_free(p_ktable->p_elems);
+void ABTI_ktable_free(ABTI_ktable *p_ktable)
+{
+    ABTI_local *p_local = lp_ABTI_local;
+
+    ABTI_ktable_clear(p_ktable);
+
+    if (p_ktable->p_elems != (ABTI_ktelem *)(p_ktable + 1)) {
+        ABTU_free(p_ktable->p_elems);
+    } else if (p_local != NULL &&
+               p_local->num_ktables < ABTI_KTABLE_MAX_CACHE) {
+        /* Keep the table for the next ABTI_ktable_alloc() on this ES. */
+        p_ktable->p_next = p_local->p_ktables;
+        p_local->p_ktables = p_ktable;
+        p_local->num_ktables++;
+        return;
+    }
     ABTU_free(p_ktable);
 }
 
-static inline uint32_t ABTI_ktable_get_idx(ABTI_key *p_key, int size)
+/* Release the key tables cached by the ES of p_local. */
+void ABTI_ktable_free_cached(ABTI_local *p_local)
+{
+    ABTI_ktable *p_ktable;
+
+    while (p_local->p_ktables != NULL) {
+        p_ktable = p_local->p_ktables;
+        p_local->p_ktables = p_ktable->p_next;
+        ABTU_free(p_ktable);
+    }
+    p_local->num_ktables = 0;
+}
+
+static void ABTI_ktable_grow(ABTI_ktable *p_ktable, uint32_t id)
 {
-    return p_key->id % size;
+    ABTI_ktelem *p_elems = p_ktable->p_elems;
+    uint32_t old_size = p_ktable->size;
+    uint32_t new_size = old_size * 2;
+    size_t old_bytes = old_size * sizeof(ABTI_ktelem);
+
+    if (new_size <= id) new_size = id + 1;
+
+    if (p_elems == (ABTI_ktelem *)(p_ktable + 1)) {
+        p_elems = (ABTI_ktelem *)ABTU_malloc(new_size * sizeof(ABTI_ktelem));
+        memcpy(p_elems, p_ktable->p_elems, old_bytes);
+    } else {
+        p_elems = (ABTI_ktelem *)ABTU_realloc(p_elems,
+                                              new_size * sizeof(ABTI_ktelem));
+    }
+    memset(&p_elems[old_size], 0, new_size * sizeof(ABTI_ktelem) - old_bytes);
+
+    p_ktable->p_elems = p_elems;
+    p_ktable->size = new_size;
 }
 
 static inline void ABTI_ktable_set(ABTI_ktable *p_ktable, ABTI_key *p_key,
                                    void *value)
 {
-    uint32_t idx;
     ABTI_ktelem *p_elem;
 
-    /* Look for the same key */
-    idx = ABTI_ktable_get_idx(p_key, p_ktable->size);
-    p_elem = p_ktable->p_elems[idx];
-    while (p_elem) {
-        if (p_elem->p_key == p_key) {
-            p_elem->value = value;
-            return;
-        }
-        p_elem = p_elem->p_next;
+    if (p_key->id >= p_ktable->size) {
+        ABTI_ktable_grow(p_ktable, p_key->id);
     }
 
-    /* The table does not have the same key */
-    p_elem = (ABTI_ktelem *)ABTU_malloc(sizeof(ABTI_ktelem));
-    p_elem->p_key = p_key;
+    p_elem = &p_ktable->p_elems[p_key->id];
+    if (p_elem->p_key == NULL) {
+        /* The slot keeps the key, and thus its ID, alive. */
+        ABTD_atomic_fetch_add_uint32(&p_key->refcount, 1);
+        p_elem->p_key = p_key;
+        if (p_elem->used == ABT_FALSE) {
+            p_elem->used = ABT_TRUE;
+            p_elem->next = p_ktable->used_head;
+            p_ktable->used_head = p_key->id;
+        }
+    }
+    ABTI_ASSERT(p_elem->p_key == p_key);
     p_elem->value = value;
-    p_elem->p_next = p_ktable->p_elems[idx];
-    ABTD_atomic_fetch_add_uint32(&p_key->refcount, 1);
-    p_ktable->p_elems[idx] = p_elem;
-
-    p_ktable->num++;
 }
 
 static inline void *ABTI_ktable_get(ABTI_ktable *p_ktable, ABTI_key *p_key)
 {
-    uint32_t idx;
-    ABTI_ktelem *p_elem;
-
-    idx = ABTI_ktable_get_idx(p_key, p_ktable->size);
-    p_elem = p_ktable->p_elems[idx];
-    while (p_elem) {
-        if (p_elem->p_key == p_key) {
-            return p_elem->value;
-        }
-        p_elem = p_elem->p_next;
+    /* An empty slot has a NULL value. */
+    if (p_key->id < p_ktable->size) {
+        return p_ktable->p_elems[p_key->id].value;
     }
-
     return NULL;
 }
 
 void ABTI_ktable_delete(ABTI_ktable *p_ktable, ABTI_key *p_key)
 {
-    uint32_t idx;
-    ABTI_ktelem *p_prev = NULL;
     ABTI_ktelem *p_elem;
 
-    idx = ABTI_ktable_get_idx(p_key, p_ktable->size);
-    p_elem = p_ktable->p_elems[idx];
-    while (p_elem) {
-        if (p_elem->p_key == p_key) {
-            if (p_prev) {
-                p_prev->p_next = p_elem->p_next;
-            } else {
-                p_ktable->p_elems[idx] = p_elem->p_next;
-            }
-            p_ktable->num--;
-
-            ABTU_free(p_elem);
-            return;
-        }
+    if (p_key->id >= p_ktable->size) return;
 
-        p_prev = p_elem;
-        p_elem = p_elem->p_next;
+    p_elem = &p_ktable->p_elems[p_key->id];
+    if (p_elem->p_key == p_key) {
+        /* The slot stays in the used list until the table is cleared. */
+        p_elem->p_key = NULL;
+        p_elem->value = NULL;
+        ABTI_key_release(p_key);
     }
 }
 
+static uint32_t ABTI_key_alloc_id(void)
+{
+    uint32_t id;
+
+    ABTI_spinlock_acquire(&g_key_lock);
+    if (g_key_num_free_ids > 0) {
+        id = g_key_free_ids[--g_key_num_free_ids];
+    } else {
+        id = g_key_id++;
+    }
+    ABTI_spinlock_release(&g_key_lock);
+
+    return id;
+}
+
+/* Drop a reference to the key.  The key and its ID are released with the
+ * last reference. */
+static void ABTI_key_release(ABTI_key *p_key)
+{
+    uint32_t refcount;
+
+    refcount = ABTD_atomic_fetch_sub_uint32(&p_key->refcount, 1);
+    if (refcount != 1) return;
+
+    ABTI_spinlock_acquire(&g_key_lock);
+    if (g_key_num_free_ids == g_key_max_free_ids) {
+        g_key_max_free_ids = g_key_max_free_ids ? g_key_max_free_ids * 2 : 16;
+        g_key_free_ids = (uint32_t *)ABTU_realloc(g_key_free_ids,
+                            g_key_max_free_ids * sizeof(uint32_t));
+    }
+    g_key_free_ids[g_key_num_free_ids++] = p_key->id;
+    ABTI_spinlock_release(&g_key_lock);
+
+    ABTU_free(p_key);
+}
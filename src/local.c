@@ -22,6 +22,15 @@ int ABTI_local_init(void)
     lp_ABTI_local->p_xstream = NULL;
     lp_ABTI_local->p_thread = NULL;
     lp_ABTI_local->p_task = NULL;
+    lp_ABTI_local->num_reuse_threads = 0;
+    lp_ABTI_local->num_ktables = 0;
+    lp_ABTI_local->p_ktables = NULL;
+    lp_ABTI_local->p_task_batch = NULL;
+    lp_ABTI_local->task_inline_depth = 0;
+    lp_ABTI_local->num_eventuals = 0;
+    lp_ABTI_local->p_eventuals = NULL;
+    lp_ABTI_local->num_futures = 0;
+    lp_ABTI_local->p_futures = NULL;
 
     ABTI_mem_init_local(lp_ABTI_local);
 
@@ -39,6 +48,10 @@ int ABTI_local_finalize(void)
 {
     int abt_errno = ABT_SUCCESS;
     ABTI_CHECK_TRUE(lp_ABTI_local != NULL, ABT_ERR_OTHER);
+    ABTI_thread_free_reusable(lp_ABTI_local);
+    ABTI_ktable_free_cached(lp_ABTI_local);
+    ABTI_eventual_free_cached(lp_ABTI_local);
+    ABTI_future_free_cached(lp_ABTI_local);
     ABTI_mem_finalize_local(lp_ABTI_local);
     ABTU_free(lp_ABTI_local);
     lp_ABTI_local = NULL;
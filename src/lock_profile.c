@@ -0,0 +1,213 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Contention of internal spinlocks per call site (--enable-lock-profile).
+ * The records of the call sites (see abti_spinlock.h) are pushed to a global
+ * list with CAS at their first use and stay there for the lifetime of the
+ * process, since they are static.  The list does not depend on
+ * gp_ABTI_global, so locks taken before ABT_init() are profiled too. */
+
+#ifdef ABT_CONFIG_USE_LOCK_PROFILE
+static ABTI_lock_site *g_lock_sites = NULL;
+
+void ABTI_lock_profile_register(ABTI_lock_site *p_site)
+{
+    ABTI_lock_site *p_head;
+
+    if (ABTD_atomic_cas_uint32(&p_site->registered, 0, 1) != 0) return;
+    do {
+        p_head = *(ABTI_lock_site * volatile *)&g_lock_sites;
+        p_site->p_next = p_head;
+    } while (ABTD_atomic_cas_uint64((uint64_t *)&g_lock_sites,
+                                    (uint64_t)p_head, (uint64_t)p_site)
+             != (uint64_t)p_head);
+}
+
+static int ABTI_lock_profile_cmp_site(const void *p1, const void *p2)
+{
+    const ABTI_lock_site *p_site1 = *(ABTI_lock_site * const *)p1;
+    const ABTI_lock_site *p_site2 = *(ABTI_lock_site * const *)p2;
+    int ret = strcmp(p_site1->file, p_site2->file);
+    if (ret != 0) return ret;
+    return p_site1->line - p_site2->line;
+}
+
+static int ABTI_lock_profile_cmp_cycles(const void *p1, const void *p2)
+{
+    const ABTI_lock_site *p_site1 = (const ABTI_lock_site *)p1;
+    const ABTI_lock_site *p_site2 = (const ABTI_lock_site *)p2;
+    if (p_site1->spin_cycles != p_site2->spin_cycles) {
+        return (p_site1->spin_cycles < p_site2->spin_cycles) ? 1 : -1;
+    }
+    if (p_site1->num_contended != p_site2->num_contended) {
+        return (p_site1->num_contended < p_site2->num_contended) ? 1 : -1;
+    }
+    return (p_site1->num_acquires < p_site2->num_acquires) ? 1 : -1;
+}
+
+/* Print the sites that have been used, the records of the same line merged,
+ * in decreasing order of the spin cycles */
+static void ABTI_lock_profile_print(FILE *fp)
+{
+    ABTI_lock_site *p_site, **pp_sites, *p_merged;
+    int i, num_sites = 0, num_merged = 0;
+
+    for (p_site = g_lock_sites; p_site; p_site = p_site->p_next) {
+        num_sites++;
+    }
+    pp_sites = (ABTI_lock_site **)ABTU_malloc(
+            sizeof(ABTI_lock_site *) * (num_sites + 1));
+    p_merged = (ABTI_lock_site *)ABTU_malloc(
+            sizeof(ABTI_lock_site) * (num_sites + 1));
+    for (p_site = g_lock_sites, i = 0; i < num_sites;
+         p_site = p_site->p_next, i++) {
+        pp_sites[i] = p_site;
+    }
+    qsort(pp_sites, num_sites, sizeof(ABTI_lock_site *),
+          ABTI_lock_profile_cmp_site);
+    for (i = 0; i < num_sites; i++) {
+        p_site = pp_sites[i];
+        if (p_site->num_acquires == 0) continue;
+        if (num_merged > 0 && p_merged[num_merged - 1].line == p_site->line &&
+            !strcmp(p_merged[num_merged - 1].file, p_site->file)) {
+            p_merged[num_merged - 1].num_acquires += p_site->num_acquires;
+            p_merged[num_merged - 1].num_contended += p_site->num_contended;
+            p_merged[num_merged - 1].spin_cycles += p_site->spin_cycles;
+            continue;
+        }
+        p_merged[num_merged++] = *p_site;
+    }
+    qsort(p_merged, num_merged, sizeof(ABTI_lock_site),
+          ABTI_lock_profile_cmp_cycles);
+
+    fprintf(fp, "== Lock profile ==\n");
+    fprintf(fp, "%12s %12s %8s %16s %12s  %s\n", "acquires", "contended",
+            "ratio", "spin cycles", "cycles/cont", "site");
+    for (i = 0; i < num_merged; i++) {
+        p_site = &p_merged[i];
+        fprintf(fp, "%12" PRIu64 " %12" PRIu64 " %7.2f%% %16" PRIu64
+                " %12" PRIu64 "  %s:%d (%s)\n", p_site->num_acquires,
+                p_site->num_contended,
+                100.0 * (double)p_site->num_contended
+                      / (double)p_site->num_acquires,
+                p_site->spin_cycles,
+                p_site->num_contended
+                    ? p_site->spin_cycles / p_site->num_contended : 0,
+                p_site->file, p_site->line, p_site->func);
+    }
+    fflush(fp);
+
+    ABTU_free(p_merged);
+    ABTU_free(pp_sites);
+}
+
+static void ABTI_lock_profile_reset(void)
+{
+    ABTI_lock_site *p_site;
+    for (p_site = g_lock_sites; p_site; p_site = p_site->p_next) {
+        ABTD_atomic_exchange_uint64(&p_site->num_acquires, 0);
+        ABTD_atomic_exchange_uint64(&p_site->num_contended, 0);
+        ABTD_atomic_exchange_uint64(&p_site->spin_cycles, 0);
+    }
+}
+#endif /* ABT_CONFIG_USE_LOCK_PROFILE */
+
+/* Write the profile to ABT_LOCK_PROFILE_FILE if it is set, and reset the
+ * counters so that the next ABT_init() starts from zero.  It is called at the
+ * end of ABT_finalize(), when the other ESs have been joined. */
+void ABTI_lock_profile_finalize(void)
+{
+#ifdef ABT_CONFIG_USE_LOCK_PROFILE
+    char *filename = gp_ABTI_global->lock_profile_filename;
+    FILE *fp = NULL;
+
+    if (filename != NULL) {
+        if (!strcmp(filename, "stdout")) {
+            fp = stdout;
+        } else if (!strcmp(filename, "stderr")) {
+            fp = stderr;
+        } else {
+            fp = fopen(filename, "w");
+        }
+    }
+    if (fp != NULL) {
+        ABTI_lock_profile_print(fp);
+        if (fp != stdout && fp != stderr) fclose(fp);
+    }
+    ABTI_lock_profile_reset();
+#endif
+}
+
+/**
+ * @ingroup INFO
+ * @brief   Write the contention of internal spinlocks per call site.
+ *
+ * \c ABT_info_print_lock_profile() writes to \c fp one line per call site of
+ * an internal spinlock that has been used: the number of acquisitions, the
+ * number of contended ones, which could not take the lock at once, the cycles
+ * spent waiting for the lock, and the source location.  The lines are sorted
+ * in decreasing order of the cycles.  The counters are accumulated from
+ * \c ABT_init() or the last \c ABT_info_reset_lock_profile().
+ *
+ * @param[in] fp  output stream
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA Argobots is not configured with
+ *                            --enable-lock-profile
+ */
+int ABT_info_print_lock_profile(FILE *fp)
+{
+#ifdef ABT_CONFIG_USE_LOCK_PROFILE
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_CHECK_INITIALIZED();
+    ABTI_lock_profile_print(fp);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(fp);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+/**
+ * @ingroup INFO
+ * @brief   Reset the contention counters of internal spinlocks.
+ *
+ * \c ABT_info_reset_lock_profile() sets all the counters reported by
+ * \c ABT_info_print_lock_profile() to zero, so that a phase of the program
+ * can be profiled separately.  Acquisitions that run concurrently may or may
+ * not be counted.
+ *
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA Argobots is not configured with
+ *                            --enable-lock-profile
+ */
+int ABT_info_reset_lock_profile(void)
+{
+#ifdef ABT_CONFIG_USE_LOCK_PROFILE
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_CHECK_INITIALIZED();
+    ABTI_lock_profile_reset();
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
@@ -6,12 +6,14 @@
 #include "abti.h"
 
 #ifdef ABT_CONFIG_USE_MEM_POOL
-/* Currently the total memory allocated for stacks and task block pages is not
- * shrunk to avoid the thrashing overhead except that ESs are terminated or
- * ABT_finalize is called.  When an ES terminates its execution, stacks and
- * empty pages that it holds are deallocated.  Non-empty pages are added to the
- * global data.  When ABTI_finalize is called, all memory objects that we have
- * allocated are returned to the higher-level memory allocator. */
+/* The total memory allocated for stacks and task block pages is not shrunk
+ * automatically to avoid the thrashing overhead except that ESs are terminated
+ * or ABT_finalize is called.  When an ES terminates its execution, empty pages
+ * that it holds are deallocated.  Its stacks and non-empty pages are added to
+ * the global data.  When ABTI_finalize is called, all memory objects that we have
+ * allocated are returned to the higher-level memory allocator.  Otherwise,
+ * memory is returned only by trims, which are requested by ABT_mem_trim() or
+ * run periodically if ABT_MEM_TRIM_INTERVAL is set. */
 
 #include <sys/types.h>
 #include <sys/mman.h>
@@ -40,20 +42,60 @@
 #define MMAP_DBG_MSG    "mmap regular pages"
 #endif
 
+/* 1GB huge pages are requested with the size encoded in the flags. */
+#if defined(HAVE_MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+#define FLAGS_GP        (FLAGS_HP | (30 << MAP_HUGE_SHIFT))
+#define GP_SIZE         ((size_t)1 << 30)
+#endif
+
+#if defined(MAP_NORESERVE)
+#define FLAGS_LAZY      (FLAGS_RP | MAP_NORESERVE)
+#else
+#define FLAGS_LAZY      FLAGS_RP
+#endif
+
 static inline void ABTI_mem_free_stack_list(ABTI_stack_header *p_stack);
 static inline void ABTI_mem_free_page_list(ABTI_page_header *p_ph);
+static inline void ABTI_mem_release_page(ABTI_page_header *p_ph);
+static ABTI_page_header *ABTI_mem_new_page(ABTI_local *p_local,
+                                           size_t blk_size);
 static inline void ABTI_mem_add_page(ABTI_local *p_local,
                                      ABTI_page_header *p_ph);
-static inline void ABTI_mem_add_pages_to_global(ABTI_page_header *p_head,
-                                                ABTI_page_header *p_tail);
+static inline void ABTI_mem_add_page_to_global(ABTI_page_header *p_ph);
 static inline void ABTI_mem_free_sph_list(ABTI_sp_header *p_sph);
+static inline void ABTI_mem_release_stacks(ABTI_local *p_local, int cls,
+                                           uint32_t num_keep);
+static inline void ABTI_mem_reclaim_stacks(ABTI_stack_list *p_list);
+static inline void ABTI_mem_add_sph_to_global(ABTI_sp_header *p_sph);
+static void ABTI_mem_release_sp(ABTI_local *p_local, int cls);
+static inline void ABTI_mem_free_sp(ABTI_sp_header *p_sph);
 static uint64_t g_sp_id = 0;
+static ABT_bool g_lp_checked = ABT_FALSE;
 
 
 void ABTI_mem_init(ABTI_global *p_global)
 {
-    p_global->p_mem_stack = NULL;
-    p_global->p_mem_task = NULL;
+    int i, n;
+
+    /* Global lists per NUMA node */
+    int num_nodes = ABTD_affinity_init_nodes();
+    if (num_nodes > ABTI_MEM_MAX_NUMA_NODES) {
+        num_nodes = ABTI_MEM_MAX_NUMA_NODES;
+    }
+    p_global->mem_num_nodes = num_nodes;
+    p_global->p_mem_nodes = (ABTI_mem_node *)ABTU_malloc(
+            num_nodes * sizeof(ABTI_mem_node));
+    for (n = 0; n < num_nodes; n++) {
+        ABTI_mem_node *p_node = &p_global->p_mem_nodes[n];
+        ABTI_spinlock_create(&p_node->lock);
+        for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+            p_node->p_mem_stack[i] = NULL;
+            p_node->num_mem_stacks[i] = 0;
+            p_node->p_mem_sph[i] = NULL;
+        }
+        p_node->p_mem_task = NULL;
+        p_node->p_mem_user = NULL;
+    }
     p_global->p_mem_sph = NULL;
 
     /* Calculate the header size that should be a multiple of cache line size */
@@ -64,45 +106,124 @@ void ABTI_mem_init(ABTI_global *p_global)
     }
     p_global->mem_sh_size = header_size;
 
+    p_global->mem_malloc_bytes = 0;
+    p_global->mem_mmap_rp_bytes = 0;
+    p_global->mem_mmap_hp_bytes = 0;
+    p_global->mem_thp_bytes = 0;
+    p_global->mem_mmap_gp_bytes = 0;
+    p_global->mem_num_gp_failures = 0;
+    p_global->mem_num_hp_failures = 0;
+    p_global->mem_num_mmap_failures = 0;
+    p_global->mem_num_thp_failures = 0;
+
+    p_global->mem_trim_seq = 0;
+    p_global->mem_trim_target = 0;
+    ABTI_spinlock_create(&p_global->mem_trim_lock);
+    p_global->mem_trimmed_bytes = 0;
+
     g_sp_id = 0;
+    g_lp_checked = ABT_FALSE;
 }
 
 void ABTI_mem_init_local(ABTI_local *p_local)
 {
+    int i;
+
     /* TODO: preallocate some stacks? */
-    p_local->num_stacks = 0;
-    p_local->p_mem_stack = NULL;
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        ABTI_stack_list *p_list = &p_local->mem_stacks[i];
+        size_t stacksize = ABTI_mem_get_class_stacksize(i);
+        uint32_t min_stacks = ABTI_MEM_MIN_STACK_BYTES / stacksize;
+        if (min_stacks < 1) min_stacks = 1;
+        if (min_stacks > ABTI_MEM_MIN_STACKS) min_stacks = ABTI_MEM_MIN_STACKS;
+
+        p_list->num_stacks = 0;
+        p_list->max_stacks = 0;
+        p_list->min_stacks = min_stacks;
+        ABTI_mem_grow_stacks(p_list);
+        p_list->low_stacks = 0;
+        p_list->num_frees = 0;
+        p_list->p_head = NULL;
+        p_list->p_sph = NULL;
+    }
 
     /* TODO: preallocate some task blocks? */
     p_local->p_mem_task_head = NULL;
     p_local->p_mem_task_tail = NULL;
+    for (i = 0; i < ABTI_MEM_NUM_USER_CLASSES; i++) {
+        p_local->p_mem_user[i] = NULL;
+    }
+    p_local->mem_node = ABTD_affinity_get_node();
+    for (i = 0; i < ABTI_MEM_NUM_RFREE_BUFS; i++) {
+        ABTI_rfree_buf *p_buf = &p_local->mem_rfree_bufs[i];
+        p_buf->p_ph = NULL;
+        p_buf->p_head = NULL;
+        p_buf->p_tail = NULL;
+        p_buf->num_blks = 0;
+    }
+    p_local->mem_rfree_victim = 0;
+
+    p_local->mem_trim_seq = gp_ABTI_global->mem_trim_seq;
+    p_local->mem_trim_time = 0.0;
+    if (gp_ABTI_global->mem_trim_interval > 0.0) {
+        p_local->mem_trim_time = ABT_get_wtime()
+                               + gp_ABTI_global->mem_trim_interval;
+    }
 }
 
+/* Stacks and task blocks are not freed one by one but with the pages that
+ * hold them.  With ABT_MEM_FAST_FINALIZE, even the pages are left to the OS,
+ * which releases them when the process exits. */
 void ABTI_mem_finalize(ABTI_global *p_global)
 {
-    /* Free all ramaining stacks */
-    ABTI_mem_free_stack_list(p_global->p_mem_stack);
-    p_global->p_mem_stack = NULL;
+    ABT_bool fast = p_global->mem_fast_finalize;
+    int i, n;
+
+    for (n = 0; n < p_global->mem_num_nodes; n++) {
+        ABTI_mem_node *p_node = &p_global->p_mem_nodes[n];
+
+        if (fast == ABT_FALSE) {
+            /* Free all ramaining stacks */
+            for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+                ABTI_mem_free_stack_list(p_node->p_mem_stack[i]);
+            }
+
+            /* Free all task blocks and the blocks of ABT_mem_alloc() */
+            ABTI_mem_free_page_list(p_node->p_mem_task);
+            ABTI_mem_free_page_list(p_node->p_mem_user);
+        }
 
-    /* Free all task blocks */
-    ABTI_mem_free_page_list(p_global->p_mem_task);
-    p_global->p_mem_task = NULL;
+        ABTI_spinlock_free(&p_node->lock);
+    }
+    ABTU_free(p_global->p_mem_nodes);
+    p_global->p_mem_nodes = NULL;
+    p_global->mem_num_nodes = 0;
 
     /* Free all stack pages */
-    ABTI_mem_free_sph_list(p_global->p_mem_sph);
+    if (fast == ABT_FALSE) {
+        ABTI_mem_free_sph_list(p_global->p_mem_sph);
+    }
     p_global->p_mem_sph = NULL;
+    ABTI_spinlock_free(&p_global->mem_trim_lock);
 }
 
 void ABTI_mem_finalize_local(ABTI_local *p_local)
 {
-    /* Free all ramaining stacks */
-    ABTI_mem_free_stack_list(p_local->p_mem_stack);
-    p_local->num_stacks = 0;
-    p_local->p_mem_stack = NULL;
+    int i;
 
-    /* Free all task block pages */
-    ABTI_page_header *p_rem_head = NULL;
-    ABTI_page_header *p_rem_tail = NULL;
+    /* Move all remaining stacks to the global data so that other ESs can
+     * reuse them */
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        ABTI_mem_release_stacks(p_local, i, 0);
+        ABTI_mem_release_sp(p_local, i);
+    }
+
+    /* Return the remote free blocks buffered in this ES */
+    ABTI_mem_flush_remote_frees(p_local);
+
+    /* Free all task block pages.  If there are pages that have not been
+     * fully freed, we move them to the global task page lists of their NUMA
+     * nodes. */
     ABTI_page_header *p_cur = p_local->p_mem_task_head;
     while (p_cur) {
         ABTI_page_header *p_tmp = p_cur;
@@ -122,11 +243,7 @@ void ABTI_mem_finalize_local(ABTI_local *p_local)
 
             p_tmp->p_owner = NULL;
             p_tmp->p_prev = NULL;
-            p_tmp->p_next = p_rem_head;
-            p_rem_head = p_tmp;
-            if (p_rem_tail == NULL) {
-                p_rem_tail = p_tmp;
-            }
+            ABTI_mem_add_page_to_global(p_tmp);
         }
 
         if (p_cur == p_local->p_mem_task_head) break;
@@ -134,89 +251,44 @@ void ABTI_mem_finalize_local(ABTI_local *p_local)
     p_local->p_mem_task_head = NULL;
     p_local->p_mem_task_tail = NULL;
 
-    /* If there are pages that have not been fully freed, we move them to the
-     * global task page list. */
-    if (p_rem_head) {
-        ABTI_mem_add_pages_to_global(p_rem_head, p_rem_tail);
-    }
-}
-
-int ABTI_mem_check_lp_alloc(int lp_alloc)
-{
-    size_t sp_size = gp_ABTI_global->mem_sp_size;
-    size_t pg_size = gp_ABTI_global->mem_page_size;
-    size_t alignment;
-    void *p_page = NULL;
-
-    switch (lp_alloc) {
-        case ABTI_MEM_LP_MMAP_RP:
-            p_page = mmap(NULL, pg_size, PROTS, FLAGS_RP, 0, 0);
-            if (p_page != MAP_FAILED) {
-                munmap(p_page, pg_size);
+    /* Pages of ABT_mem_alloc() that still have blocks in use are kept in the
+     * global data until ABT_finalize(), and the blocks freed later are
+     * returned to them as remote frees. */
+    for (i = 0; i < ABTI_MEM_NUM_USER_CLASSES; i++) {
+        p_cur = p_local->p_mem_user[i];
+        while (p_cur) {
+            ABTI_page_header *p_tmp = p_cur;
+            p_cur = p_cur->p_next;
+            if (p_tmp->num_empty_blks + p_tmp->num_remote_free
+                == p_tmp->num_total_blks) {
+                ABTI_mem_release_page(p_tmp);
             } else {
-                lp_alloc = ABTI_MEM_LP_MALLOC;
+                ABTI_mem_node *p_node = ABTI_mem_get_node(p_tmp->node);
+                p_tmp->p_owner = NULL;
+                ABTI_spinlock_acquire(&p_node->lock);
+                p_tmp->p_next = p_node->p_mem_user;
+                p_node->p_mem_user = p_tmp;
+                ABTI_spinlock_release(&p_node->lock);
             }
-            break;
-
-        case ABTI_MEM_LP_MMAP_HP_RP:
-            p_page = mmap(NULL, sp_size, PROTS, FLAGS_HP, 0, 0);
-            if (p_page != MAP_FAILED) {
-                munmap(p_page, sp_size);
-            } else {
-                p_page = mmap(NULL, pg_size, PROTS, FLAGS_RP, 0, 0);
-                if (p_page != MAP_FAILED) {
-                    munmap(p_page, pg_size);
-                    lp_alloc = ABTI_MEM_LP_MMAP_RP;
-                } else {
-                    lp_alloc = ABTI_MEM_LP_MALLOC;
-                }
-            }
-            break;
-
-        case ABTI_MEM_LP_MMAP_HP_THP:
-            p_page = mmap(NULL, sp_size, PROTS, FLAGS_HP, 0, 0);
-            if (p_page != MAP_FAILED) {
-                munmap(p_page, sp_size);
-            } else {
-                alignment = gp_ABTI_global->huge_page_size;
-                p_page = ABTU_memalign(alignment, pg_size);
-                if (p_page) {
-                    ABTU_free(p_page);
-                    lp_alloc = ABTI_MEM_LP_THP;
-                } else {
-                    lp_alloc = ABTI_MEM_LP_MALLOC;
-                }
-            }
-            break;
-
-        case ABTI_MEM_LP_THP:
-            alignment = gp_ABTI_global->huge_page_size;
-            p_page = ABTU_memalign(alignment, pg_size);
-            if (p_page) {
-                ABTU_free(p_page);
-                lp_alloc = ABTI_MEM_LP_THP;
-            } else {
-                lp_alloc = ABTI_MEM_LP_MALLOC;
-            }
-            break;
-
-        default:
-            break;
+        }
+        p_local->p_mem_user[i] = NULL;
     }
-
-    return lp_alloc;
 }
 
+/* The stacks are freed with their stack pages, so they are only counted to
+ * report ULTs that have not been freed. */
 static inline void ABTI_mem_free_stack_list(ABTI_stack_header *p_stack)
 {
-    ABTI_stack_header *p_cur, *p_tmp;
+#ifdef ABT_CONFIG_USE_DEBUG_LOG
+    ABTI_stack_header *p_cur;
 
-    p_cur = p_stack;
-    while (p_cur) {
-        p_tmp = p_cur;
-        p_cur = p_cur->p_next;
-        ABTD_atomic_fetch_add_uint32(&p_tmp->p_sph->num_empty_stacks, 1);
+    if (gp_ABTI_global->use_debug == ABT_FALSE) return;
+    for (p_cur = p_stack; p_cur; p_cur = p_cur->p_next) {
+        p_cur->p_sph->num_empty_stacks++;
     }
+#else
+    ABTI_UNUSED(p_stack);
+#endif
 }
 
 static inline void ABTI_mem_free_page_list(ABTI_page_header *p_ph)
@@ -235,6 +307,15 @@ static inline void ABTI_mem_free_page_list(ABTI_page_header *p_ph)
     }
 }
 
+static inline void ABTI_mem_release_page(ABTI_page_header *p_ph)
+{
+    if (p_ph->is_mmapped == ABT_TRUE) {
+        munmap(p_ph, gp_ABTI_global->mem_page_size);
+    } else {
+        ABTU_free(p_ph);
+    }
+}
+
 static inline void ABTI_mem_add_page(ABTI_local *p_local,
                                      ABTI_page_header *p_ph)
 {
@@ -255,138 +336,265 @@ static inline void ABTI_mem_add_page(ABTI_local *p_local,
     }
 }
 
-static inline void ABTI_mem_add_pages_to_global(ABTI_page_header *p_head,
-                                                ABTI_page_header *p_tail)
+static inline void ABTI_mem_add_page_to_global(ABTI_page_header *p_ph)
 {
-    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_mem_node *p_node = ABTI_mem_get_node(p_ph->node);
 
-    /* Add the page list to the global list */
-    ABTI_spinlock_acquire(&p_global->lock);
-    p_tail->p_next = p_global->p_mem_task;
-    p_global->p_mem_task = p_head;
-    ABTI_spinlock_release(&p_global->lock);
+    /* Add the page to the global list of its NUMA node */
+    ABTI_spinlock_acquire(&p_node->lock);
+    p_ph->p_next = p_node->p_mem_task;
+    p_node->p_mem_task = p_ph;
+    ABTI_spinlock_release(&p_node->lock);
 }
 
-char *ABTI_mem_take_global_stack(ABTI_local *p_local)
+/* Take a batch of stacks of class cls from the global data.  The first one is
+ * returned and the others are kept in p_local, whose stack list of the class
+ * has to be empty. */
+char *ABTI_mem_take_global_stack(ABTI_local *p_local, int cls)
 {
-    ABTI_global *p_global = gp_ABTI_global;
-    const size_t ptr_size = sizeof(void *);
+    ABTI_mem_node *p_node = ABTI_mem_get_node(p_local->mem_node);
+    ABTI_stack_list *p_list = &p_local->mem_stacks[cls];
     ABTI_stack_header *p_sh, *p_cur;
-    uint32_t cnt_stacks = 0;
-
-    if (ptr_size == 8) {
-        uint64_t *ptr;
-        uint64_t old, ret;
-        do {
-            p_sh = p_global->p_mem_stack;
-            ptr = (uint64_t *)&p_global->p_mem_stack;
-            old = (uint64_t)p_sh;
-            ret = ABTD_atomic_cas_uint64(ptr, old, (uint64_t)NULL);
-        } while (old != ret);
-    } else if (ptr_size == 4) {
-        uint32_t *ptr;
-        uint32_t old, ret;
-        do {
-            p_sh = p_global->p_mem_stack;
-            ptr = (uint32_t *)&p_global->p_mem_stack;
-            old = (uint32_t)(uintptr_t)p_sh;
-            ret = ABTD_atomic_cas_uint32(ptr, old, (uint64_t)NULL);
-        } while (old != ret);
+    uint32_t num_take = p_list->max_stacks / 2 + 1;
+    uint32_t cnt_stacks = 1;
+
+    ABTI_spinlock_acquire(&p_node->lock);
+    p_sh = p_node->p_mem_stack[cls];
+    if (p_sh == NULL) {
+        ABTI_spinlock_release(&p_node->lock);
+        return NULL;
     }
-
-    if (p_sh == NULL) return NULL;
-
-    /* TODO: need a better counting method */
-    /* TODO: if there are too many stacks in the global stack pool, we should
-     * only take some of them (e.g., take max_stacks count) and add the rest
-     * back to the global stack pool. */
     p_cur = p_sh;
-    while (p_cur->p_next) {
+    while (cnt_stacks < num_take && p_cur->p_next) {
         p_cur = p_cur->p_next;
         cnt_stacks++;
     }
+    p_node->p_mem_stack[cls] = p_cur->p_next;
+    p_node->num_mem_stacks[cls] -= cnt_stacks;
+    ABTI_spinlock_release(&p_node->lock);
+    p_cur->p_next = NULL;
 
     /* Return the first one and keep the rest in p_local */
-    p_local->num_stacks = cnt_stacks;
-    p_local->p_mem_stack = p_sh->p_next;
+    p_list->num_stacks = cnt_stacks - 1;
+    p_list->p_head = p_sh->p_next;
 
     return (char *)p_sh - sizeof(ABTI_thread);
 }
 
-void ABTI_mem_add_stack_to_global(ABTI_stack_header *p_sh)
+/* Add a list of stacks of class cls from p_head to p_tail to the global
+ * data of NUMA node node. */
+void ABTI_mem_add_stacks_to_global(int node, int cls,
+                                   ABTI_stack_header *p_head,
+                                   ABTI_stack_header *p_tail,
+                                   uint32_t num_stacks)
 {
-    ABTI_global *p_global = gp_ABTI_global;
-    const size_t ptr_size = sizeof(void *);
+    ABTI_mem_node *p_node = ABTI_mem_get_node(node);
 
-    if (ptr_size == 8) {
-        uint64_t *ptr;
-        uint64_t old, new, ret;
-        do {
-            p_sh->p_next = p_global->p_mem_stack;
-            ptr = (uint64_t *)&p_global->p_mem_stack;
-            old = (uint64_t)p_sh->p_next;
-            new = (uint64_t)p_sh;
-            ret = ABTD_atomic_cas_uint64(ptr, old, new);
-        } while (old != ret);
-    } else if (ptr_size == 4) {
-        uint32_t *ptr;
-        uint32_t old, new, ret;
-        do {
-            p_sh->p_next = p_global->p_mem_stack;
-            ptr = (uint32_t *)&p_global->p_mem_stack;
-            old = (uint32_t)(uintptr_t)p_sh->p_next;
-            new = (uint32_t)(uintptr_t)p_sh;
-            ret = ABTD_atomic_cas_uint32(ptr, old, new);
-        } while (old != ret);
+    ABTI_spinlock_acquire(&p_node->lock);
+    p_tail->p_next = p_node->p_mem_stack[cls];
+    p_node->p_mem_stack[cls] = p_head;
+    p_node->num_mem_stacks[cls] += num_stacks;
+    ABTI_spinlock_release(&p_node->lock);
+}
+
+/* Keep the first num_keep stacks of class cls in p_local and move the rest to
+ * the global data at once. */
+static inline void ABTI_mem_release_stacks(ABTI_local *p_local, int cls,
+                                           uint32_t num_keep)
+{
+    ABTI_stack_list *p_list = &p_local->mem_stacks[cls];
+    ABTI_stack_header *p_head, *p_tail;
+    uint32_t i, num_release;
+
+    if (p_list->num_stacks <= num_keep) return;
+    num_release = p_list->num_stacks - num_keep;
+
+    if (num_keep == 0) {
+        p_head = p_list->p_head;
+        p_list->p_head = NULL;
     } else {
-        ABTI_ASSERT(0);
+        ABTI_stack_header *p_last = p_list->p_head;
+        for (i = 1; i < num_keep; i++) {
+            p_last = p_last->p_next;
+        }
+        p_head = p_last->p_next;
+        p_last->p_next = NULL;
+    }
+    p_tail = p_head;
+    for (i = 1; i < num_release; i++) {
+        p_tail = p_tail->p_next;
     }
+
+    p_list->num_stacks = num_keep;
+    if (p_list->low_stacks > num_keep) {
+        p_list->low_stacks = num_keep;
+    }
+    ABTI_mem_add_stacks_to_global(p_local->mem_node, cls, p_head, p_tail,
+                                  num_release);
 }
 
-static char *ABTI_mem_alloc_large_page(int pgsize, ABT_bool *p_is_mmapped)
+/* Return the physical memory of the stack areas of the last low_stacks stacks
+ * of p_list, which have not been used in this epoch, to the OS.  The page that
+ * holds the stack header is kept. */
+static inline void ABTI_mem_reclaim_stacks(ABTI_stack_list *p_list)
 {
+#if defined(MADV_DONTNEED)
+    const uintptr_t pgsize = gp_ABTI_global->os_page_size;
+    ABTI_stack_header *p_sh = p_list->p_head;
+    uint32_t i;
+
+    for (i = 0; p_sh; i++, p_sh = p_sh->p_next) {
+        if (i + p_list->low_stacks < p_list->num_stacks) continue;
+        if (p_sh->p_sph->is_lazy == ABT_FALSE) continue;
+        if (p_sh->is_reclaimed == ABT_TRUE) continue;
+
+        char *p_start = (char *)p_sh->p_stack;
+        char *p_end = (char *)((uintptr_t)p_sh / pgsize * pgsize);
+        if (p_end > p_start) {
+            madvise(p_start, p_end - p_start, MADV_DONTNEED);
+        }
+        p_sh->is_reclaimed = ABT_TRUE;
+    }
+#endif
+}
+
+/* Called when p_local has more stacks of class cls than its limit or when an
+ * epoch of ABTI_MEM_STACK_EPOCH frees ends.  Stacks that have not been used
+ * during the epoch are regarded as excess, so the limit is lowered by half of
+ * them. */
+void ABTI_mem_adjust_stacks(ABTI_local *p_local, int cls)
+{
+    ABTI_stack_list *p_list = &p_local->mem_stacks[cls];
+    uint32_t max_stacks = p_list->max_stacks;
+
+    if (p_list->num_frees >= ABTI_MEM_STACK_EPOCH) {
+        uint32_t min_stacks = p_list->min_stacks;
+        uint32_t num_unused = p_list->low_stacks / 2;
+        if (gp_ABTI_global->mem_lazy_stack == ABT_TRUE) {
+            ABTI_mem_reclaim_stacks(p_list);
+        }
+        if (min_stacks > gp_ABTI_global->mem_max_stacks) {
+            min_stacks = gp_ABTI_global->mem_max_stacks;
+        }
+        if (max_stacks > min_stacks + num_unused) {
+            max_stacks -= num_unused;
+        } else if (max_stacks > min_stacks) {
+            max_stacks = min_stacks;
+        }
+        p_list->max_stacks = max_stacks;
+        p_list->num_frees = 0;
+        p_list->low_stacks = p_list->num_stacks;
+    }
+
+    if (p_list->num_stacks > max_stacks) {
+        ABTI_mem_release_stacks(p_local, cls, max_stacks / 2);
+    }
+}
+
+/* Ask the kernel to back p_page with transparent huge pages.  They are used
+ * only if THP is enabled in the madvise or always mode. */
+static inline void ABTI_mem_advise_thp(char *p_page, size_t pgsize)
+{
+#if defined(MADV_HUGEPAGE)
+    if (p_page && madvise(p_page, pgsize, MADV_HUGEPAGE) != 0) {
+        ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->mem_num_thp_failures, 1);
+    }
+#else
+    ABTI_UNUSED(p_page);
+    ABTI_UNUSED(pgsize);
+#endif
+}
+
+/* Allocate a page of pgsize bytes.  A mmapped page is bound to NUMA node
+ * node, while the other pages are placed on the node that first touches
+ * them.  If the first allocation falls back to another method, the method is
+ * used from then on instead of the requested one.  Each fallback is counted
+ * in gp_ABTI_global. */
+static char *ABTI_mem_alloc_large_page(size_t pgsize, int node,
+                                       ABT_bool *p_is_mmapped)
+{
+    ABTI_global *p_global = gp_ABTI_global;
     char *p_page = NULL;
+    int lp_alloc = p_global->mem_lp_alloc;
+    uint64_t *p_bytes = NULL;
 
-    switch (gp_ABTI_global->mem_lp_alloc) {
+    switch (lp_alloc) {
         case ABTI_MEM_LP_MALLOC:
             *p_is_mmapped = ABT_FALSE;
             p_page = (char *)ABTU_malloc(pgsize);
-            LOG_DEBUG("malloc a regular page (%d): %p\n", pgsize, p_page);
+            p_bytes = &p_global->mem_malloc_bytes;
+            LOG_DEBUG("malloc a regular page (%zu): %p\n", pgsize, p_page);
             break;
 
         case ABTI_MEM_LP_MMAP_RP:
             p_page = (char *)mmap(NULL, pgsize, PROTS, FLAGS_RP, 0, 0);
             if ((void *)p_page != MAP_FAILED) {
                 *p_is_mmapped = ABT_TRUE;
-                LOG_DEBUG("mmap a regular page (%d): %p\n", pgsize, p_page);
+                p_bytes = &p_global->mem_mmap_rp_bytes;
+                LOG_DEBUG("mmap a regular page (%zu): %p\n", pgsize, p_page);
             } else {
                 /* mmap failed and thus we fall back to malloc. */
+                ABTD_atomic_fetch_add_uint64(&p_global->mem_num_mmap_failures,
+                                             1);
                 p_page = (char *)ABTU_malloc(pgsize);
                 *p_is_mmapped = ABT_FALSE;
-                LOG_DEBUG("fall back to malloc a regular page (%d): %p\n",
+                p_bytes = &p_global->mem_malloc_bytes;
+                lp_alloc = ABTI_MEM_LP_MALLOC;
+                LOG_DEBUG("fall back to malloc a regular page (%zu): %p\n",
                           pgsize, p_page);
             }
             break;
 
+        case ABTI_MEM_LP_MMAP_GP_HP_RP:
+#ifdef FLAGS_GP
+            /* Only stack pages of multiples of 1GB can be 1GB huge pages.
+             * The others are mapped as in ABTI_MEM_LP_MMAP_HP_RP. */
+            if (pgsize % GP_SIZE == 0) {
+                p_page = (char *)mmap(NULL, pgsize, PROTS, FLAGS_GP, 0, 0);
+                if ((void *)p_page != MAP_FAILED) {
+                    *p_is_mmapped = ABT_TRUE;
+                    p_bytes = &p_global->mem_mmap_gp_bytes;
+                    LOG_DEBUG("mmap a 1GB huge page (%zu): %p\n", pgsize,
+                              p_page);
+                    break;
+                }
+                /* 1GB huge pages are run out of, so they are not tried
+                 * again. */
+                ABTD_atomic_fetch_add_uint64(&p_global->mem_num_gp_failures,
+                                             1);
+                p_global->mem_lp_alloc = ABTI_MEM_LP_MMAP_HP_RP;
+                lp_alloc = ABTI_MEM_LP_MMAP_HP_RP;
+            }
+#endif
+            /* Fall through */
+
         case ABTI_MEM_LP_MMAP_HP_RP:
             /* We first try to mmap a huge page, and then if it fails, we mmap
              * a regular page. */
             p_page = (char *)mmap(NULL, pgsize, PROTS, FLAGS_HP, 0, 0);
             if ((void *)p_page != MAP_FAILED) {
                 *p_is_mmapped = ABT_TRUE;
-                LOG_DEBUG(MMAP_DBG_MSG" (%d): %p\n", pgsize, p_page);
+                p_bytes = &p_global->mem_mmap_hp_bytes;
+                LOG_DEBUG(MMAP_DBG_MSG" (%zu): %p\n", pgsize, p_page);
             } else {
                 /* Huge pages are run out of. Use a normal mmap. */
+                ABTD_atomic_fetch_add_uint64(&p_global->mem_num_hp_failures, 1);
                 p_page = (char *)mmap(NULL, pgsize, PROTS, FLAGS_RP, 0, 0);
                 if ((void *)p_page != MAP_FAILED) {
                     *p_is_mmapped = ABT_TRUE;
-                    LOG_DEBUG("fall back to mmap regular pages (%d): %p\n",
+                    p_bytes = &p_global->mem_mmap_rp_bytes;
+                    lp_alloc = ABTI_MEM_LP_MMAP_RP;
+                    LOG_DEBUG("fall back to mmap regular pages (%zu): %p\n",
                               pgsize, p_page);
                 } else {
                     /* mmap failed and thus we fall back to malloc. */
+                    ABTD_atomic_fetch_add_uint64(
+                            &p_global->mem_num_mmap_failures, 1);
                     p_page = (char *)ABTU_malloc(pgsize);
                     *p_is_mmapped = ABT_FALSE;
-                    LOG_DEBUG("fall back to malloc a regular page (%d): %p\n",
+                    p_bytes = &p_global->mem_malloc_bytes;
+                    lp_alloc = ABTI_MEM_LP_MALLOC;
+                    LOG_DEBUG("fall back to malloc a regular page (%zu): %p\n",
                               pgsize, p_page);
                 }
             }
@@ -398,20 +606,27 @@ static char *ABTI_mem_alloc_large_page(int pgsize, ABT_bool *p_is_mmapped)
             p_page = (char *)mmap(NULL, pgsize, PROTS, FLAGS_HP, 0, 0);
             if ((void *)p_page != MAP_FAILED) {
                 *p_is_mmapped = ABT_TRUE;
-                LOG_DEBUG(MMAP_DBG_MSG" (%d): %p\n", pgsize, p_page);
+                p_bytes = &p_global->mem_mmap_hp_bytes;
+                LOG_DEBUG(MMAP_DBG_MSG" (%zu): %p\n", pgsize, p_page);
             } else {
+                ABTD_atomic_fetch_add_uint64(&p_global->mem_num_hp_failures, 1);
                 *p_is_mmapped = ABT_FALSE;
-                size_t alignment = gp_ABTI_global->huge_page_size;
+                size_t alignment = p_global->huge_page_size;
                 p_page = (char *)ABTU_memalign(alignment, pgsize);
-                LOG_DEBUG("memalign a THP (%d): %p\n", pgsize, p_page);
+                ABTI_mem_advise_thp(p_page, pgsize);
+                p_bytes = &p_global->mem_thp_bytes;
+                lp_alloc = ABTI_MEM_LP_THP;
+                LOG_DEBUG("memalign a THP (%zu): %p\n", pgsize, p_page);
             }
             break;
 
         case ABTI_MEM_LP_THP:
             *p_is_mmapped = ABT_FALSE;
-            size_t alignment = gp_ABTI_global->huge_page_size;
+            size_t alignment = p_global->huge_page_size;
             p_page = (char *)ABTU_memalign(alignment, pgsize);
-            LOG_DEBUG("memalign a THP (%d): %p\n", pgsize, p_page);
+            ABTI_mem_advise_thp(p_page, pgsize);
+            p_bytes = &p_global->mem_thp_bytes;
+            LOG_DEBUG("memalign a THP (%zu): %p\n", pgsize, p_page);
             break;
 
         default:
@@ -419,14 +634,24 @@ static char *ABTI_mem_alloc_large_page(int pgsize, ABT_bool *p_is_mmapped)
             break;
     }
 
+    if (g_lp_checked == ABT_FALSE) {
+        p_global->mem_lp_alloc = lp_alloc;
+        g_lp_checked = ABT_TRUE;
+    }
+    ABTD_atomic_fetch_add_uint64(p_bytes, pgsize);
+
+    if (*p_is_mmapped == ABT_TRUE) {
+        ABTD_affinity_bind_memory(p_page, pgsize, node);
+    }
     return p_page;
 }
 
-ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size)
+/* Allocate a page of blocks of blk_size bytes and carve its first blocks.  The
+ * page is not added to any list. */
+static ABTI_page_header *ABTI_mem_new_page(ABTI_local *p_local,
+                                           size_t blk_size)
 {
-    int i;
     ABTI_page_header *p_ph;
-    ABTI_blk_header *p_cur;
     ABTI_global *p_global = gp_ABTI_global;
     uint32_t clsize = p_global->cache_line_size;
     size_t pgsize = p_global->mem_page_size;
@@ -436,7 +661,8 @@ ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size)
     const size_t ph_size = (sizeof(ABTI_page_header)+clsize) / clsize * clsize;
 
     uint32_t num_blks = (pgsize - ph_size) / blk_size;
-    char *p_page = ABTI_mem_alloc_large_page(pgsize, &is_mmapped);
+    char *p_page = ABTI_mem_alloc_large_page(pgsize, p_local->mem_node,
+                                             &is_mmapped);
 
     /* Set the page header */
     p_ph = (ABTI_page_header *)p_page;
@@ -444,22 +670,54 @@ ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size)
     p_ph->num_total_blks = num_blks;
     p_ph->num_empty_blks = num_blks;
     p_ph->num_remote_free = 0;
-    p_ph->p_head = (ABTI_blk_header *)(p_page + ph_size);
+    p_ph->num_carved_blks = 0;
+    p_ph->p_head = NULL;
     p_ph->p_free = NULL;
-    ABTI_mem_add_page(p_local, p_ph);
+    p_ph->p_owner = p_local->p_xstream;
+    p_ph->p_prev = NULL;
+    p_ph->p_next = NULL;
     p_ph->is_mmapped = is_mmapped;
+    p_ph->node = p_local->mem_node;
 
-    /* Make a liked list of all free blocks */
-    p_cur = p_ph->p_head;
+    ABTI_mem_carve_blks(p_ph);
+
+    return p_ph;
+}
+
+ABTI_page_header *ABTI_mem_alloc_page(ABTI_local *p_local, size_t blk_size)
+{
+    ABTI_page_header *p_ph = ABTI_mem_new_page(p_local, blk_size);
+    ABTI_mem_add_page(p_local, p_ph);
+    return p_ph;
+}
+
+/* Make a linked list of the free blocks in the next OS page of p_ph, whose
+ * list of empty blocks has to be empty. */
+void ABTI_mem_carve_blks(ABTI_page_header *p_ph)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    uint32_t clsize = p_global->cache_line_size;
+    const size_t ph_size = (sizeof(ABTI_page_header)+clsize) / clsize * clsize;
+    uint32_t num_blks = p_global->os_page_size / p_ph->blk_size;
+    ABTI_blk_header *p_cur;
+    uint32_t i;
+
+    if (num_blks == 0) num_blks = 1;
+    if (num_blks > p_ph->num_total_blks - p_ph->num_carved_blks) {
+        num_blks = p_ph->num_total_blks - p_ph->num_carved_blks;
+    }
+
+    p_cur = (ABTI_blk_header *)((char *)p_ph + ph_size
+                                + (size_t)p_ph->blk_size * p_ph->num_carved_blks);
+    p_ph->p_head = p_cur;
     for (i = 0; i < num_blks - 1; i++) {
         p_cur->p_ph = p_ph;
-        p_cur->p_next = (ABTI_blk_header *)((char *)p_cur + blk_size);
+        p_cur->p_next = (ABTI_blk_header *)((char *)p_cur + p_ph->blk_size);
         p_cur = p_cur->p_next;
     }
     p_cur->p_ph = p_ph;
     p_cur->p_next = NULL;
-
-    return p_ph;
+    p_ph->num_carved_blks += num_blks;
 }
 
 void ABTI_mem_free_page(ABTI_local *p_local, ABTI_page_header *p_ph)
@@ -483,6 +741,8 @@ void ABTI_mem_free_page(ABTI_local *p_local, ABTI_page_header *p_ph)
         } else {
             ABTU_free(p_ph);
         }
+        ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->mem_trimmed_bytes,
+                                     gp_ABTI_global->mem_page_size);
     }
 }
 
@@ -523,7 +783,12 @@ void ABTI_mem_take_free(ABTI_page_header *p_ph)
     }
 }
 
-void ABTI_mem_free_remote(ABTI_page_header *p_ph, ABTI_blk_header *p_bh)
+/* Push a list of num_blks blocks from p_head to p_tail to the remote free list
+ * of p_ph with a single atomic operation. */
+static inline void ABTI_mem_push_remote(ABTI_page_header *p_ph,
+                                        ABTI_blk_header *p_head,
+                                        ABTI_blk_header *p_tail,
+                                        uint32_t num_blks)
 {
     const size_t ptr_size = sizeof(void *);
 
@@ -531,20 +796,20 @@ void ABTI_mem_free_remote(ABTI_page_header *p_ph, ABTI_blk_header *p_bh)
         uint64_t *ptr;
         uint64_t old, new, ret;
         do {
-            p_bh->p_next = p_ph->p_free;
+            p_tail->p_next = p_ph->p_free;
             ptr = (uint64_t *)&p_ph->p_free;
-            old = (uint64_t)p_bh->p_next;
-            new = (uint64_t)p_bh;
+            old = (uint64_t)p_tail->p_next;
+            new = (uint64_t)p_head;
             ret = ABTD_atomic_cas_uint64(ptr, old, new);
         } while (old != ret);
     } else if (ptr_size == 4) {
         uint32_t *ptr;
         uint32_t old, new, ret;
         do {
-            p_bh->p_next = p_ph->p_free;
+            p_tail->p_next = p_ph->p_free;
             ptr = (uint32_t *)&p_ph->p_free;
-            old = (uint32_t)(uintptr_t)p_bh->p_next;
-            new = (uint32_t)(uintptr_t)p_bh;
+            old = (uint32_t)(uintptr_t)p_tail->p_next;
+            new = (uint32_t)(uintptr_t)p_head;
             ret = ABTD_atomic_cas_uint32(ptr, old, new);
         } while (old != ret);
     } else {
@@ -552,25 +817,98 @@ void ABTI_mem_free_remote(ABTI_page_header *p_ph, ABTI_blk_header *p_bh)
     }
 
     /* Increase the number of remote free blocks */
-    ABTD_atomic_fetch_add_uint32(&p_ph->num_remote_free, 1);
+    ABTD_atomic_fetch_add_uint32(&p_ph->num_remote_free, num_blks);
+}
+
+static inline void ABTI_mem_flush_rfree_buf(ABTI_rfree_buf *p_buf)
+{
+    if (p_buf->p_ph == NULL) return;
+    ABTI_mem_push_remote(p_buf->p_ph, p_buf->p_head, p_buf->p_tail,
+                         p_buf->num_blks);
+    p_buf->p_ph = NULL;
+    p_buf->p_head = NULL;
+    p_buf->p_tail = NULL;
+    p_buf->num_blks = 0;
+}
+
+/* Free a block of a page owned by another ES.  The block is buffered in
+ * p_local with other blocks of the same page and they are returned to the
+ * page together so that the page header is updated atomically only once per
+ * ABTI_MEM_RFREE_BATCH blocks. */
+void ABTI_mem_free_remote(ABTI_local *p_local, ABTI_page_header *p_ph,
+                          ABTI_blk_header *p_bh)
+{
+    ABTI_rfree_buf *p_buf = NULL;
+    int i;
+
+    for (i = 0; i < ABTI_MEM_NUM_RFREE_BUFS; i++) {
+        if (p_local->mem_rfree_bufs[i].p_ph == p_ph) {
+            p_buf = &p_local->mem_rfree_bufs[i];
+            break;
+        }
+    }
+    if (p_buf == NULL) {
+        for (i = 0; i < ABTI_MEM_NUM_RFREE_BUFS; i++) {
+            if (p_local->mem_rfree_bufs[i].p_ph == NULL) {
+                p_buf = &p_local->mem_rfree_bufs[i];
+                break;
+            }
+        }
+    }
+    if (p_buf == NULL) {
+        /* All buffers are used for other pages, so one of them is flushed. */
+        p_buf = &p_local->mem_rfree_bufs[p_local->mem_rfree_victim];
+        p_local->mem_rfree_victim = (p_local->mem_rfree_victim + 1)
+                                  % ABTI_MEM_NUM_RFREE_BUFS;
+        ABTI_mem_flush_rfree_buf(p_buf);
+    }
+
+    if (p_buf->p_ph == NULL) {
+        p_bh->p_next = NULL;
+        p_buf->p_ph = p_ph;
+        p_buf->p_tail = p_bh;
+    } else {
+        p_bh->p_next = p_buf->p_head;
+    }
+    p_buf->p_head = p_bh;
+    p_buf->num_blks++;
+
+    if (p_local->p_xstream) p_local->p_xstream->num_remote_frees++;
+
+    if (p_buf->num_blks >= ABTI_MEM_RFREE_BATCH) {
+        ABTI_mem_flush_rfree_buf(p_buf);
+    }
+}
+
+/* Return all blocks buffered in p_local to their pages. */
+void ABTI_mem_flush_remote_frees(ABTI_local *p_local)
+{
+    int i;
+    for (i = 0; i < ABTI_MEM_NUM_RFREE_BUFS; i++) {
+        ABTI_mem_flush_rfree_buf(&p_local->mem_rfree_bufs[i]);
+    }
 }
 
 ABTI_page_header *ABTI_mem_take_global_page(ABTI_local *p_local)
 {
-    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_mem_node *p_node = ABTI_mem_get_node(p_local->mem_node);
     ABTI_page_header *p_ph = NULL;
 
     /* Take the first page out */
-    ABTI_spinlock_acquire(&p_global->lock);
-    if (p_global->p_mem_task) {
-        p_ph = p_global->p_mem_task;
-        p_global->p_mem_task = p_ph->p_next;
+    ABTI_spinlock_acquire(&p_node->lock);
+    if (p_node->p_mem_task) {
+        p_ph = p_node->p_mem_task;
+        p_node->p_mem_task = p_ph->p_next;
     }
-    ABTI_spinlock_release(&p_global->lock);
+    ABTI_spinlock_release(&p_node->lock);
 
     if (p_ph) {
         ABTI_mem_add_page(p_local, p_ph);
         if (p_ph->p_free) ABTI_mem_take_free(p_ph);
+        if (p_ph->p_head == NULL &&
+            p_ph->num_carved_blks < p_ph->num_total_blks) {
+            ABTI_mem_carve_blks(p_ph);
+        }
         if (p_ph->p_head == NULL) p_ph = NULL;
     }
 
@@ -586,89 +924,292 @@ static inline void ABTI_mem_free_sph_list(ABTI_sp_header *p_sph)
         p_tmp = p_cur;
         p_cur = p_cur->p_next;
 
-        if (p_tmp->num_total_stacks != p_tmp->num_empty_stacks) {
+#ifdef ABT_CONFIG_USE_DEBUG_LOG
+        if (gp_ABTI_global->use_debug == ABT_TRUE &&
+            p_tmp->num_carved_stacks != p_tmp->num_empty_stacks) {
             LOG_DEBUG("%u ULTs are not freed\n",
-                      p_tmp->num_total_stacks - p_tmp->num_empty_stacks);
+                      p_tmp->num_carved_stacks - p_tmp->num_empty_stacks);
         }
+#endif
 
-        if (p_tmp->is_mmapped == ABT_TRUE) {
-            if (munmap(p_tmp->p_sp, gp_ABTI_global->mem_sp_size)) {
-                ABTI_ASSERT(0);
-            }
-        } else {
-            ABTU_free(p_tmp->p_sp);
+        ABTI_mem_free_sp(p_tmp);
+    }
+}
+
+/* Free the stack page of p_sph and p_sph itself. */
+static inline void ABTI_mem_free_sp(ABTI_sp_header *p_sph)
+{
+    if (p_sph->is_mmapped == ABT_TRUE) {
+        size_t sp_size = ABTI_mem_get_class_sp_size(p_sph->stack_class);
+        if (munmap(p_sph->p_sp, sp_size)) {
+            ABTI_ASSERT(0);
         }
-        ABTU_free(p_tmp);
+    } else {
+        ABTU_free(p_sph->p_sp);
     }
+    ABTU_free(p_sph);
 }
 
-/* Allocate a stack page and divide it to multiple stacks by making a liked
- * list.  Then, the first stack is returned. */
-char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
+/* Allocate a stack page for stacks of class cls.  No stack is carved out of
+ * it yet. */
+static ABTI_sp_header *ABTI_mem_alloc_regular_sp(ABTI_local *p_local, int cls)
 {
-    char *p_sp, *p_first;
+    size_t stacksize = ABTI_mem_get_class_stacksize(cls);
+    uint32_t sp_size = ABTI_mem_get_class_sp_size(cls);
     ABTI_sp_header *p_sph;
-    ABTI_stack_header *p_sh, *p_next;
-    uint32_t num_stacks;
-    int i;
-
-    uint32_t header_size = gp_ABTI_global->mem_sh_size;
-    uint32_t sp_size = gp_ABTI_global->mem_sp_size;
-    size_t actual_stacksize = stacksize - header_size;
-    void *p_stack = NULL;
 
     /* Allocate a stack page header */
     p_sph = (ABTI_sp_header *)ABTU_malloc(sizeof(ABTI_sp_header));
-    num_stacks = sp_size / stacksize;
-    p_sph->num_total_stacks = num_stacks;
+    p_sph->num_total_stacks = sp_size / stacksize;
     p_sph->num_empty_stacks = 0;
+    p_sph->num_carved_stacks = 0;
     p_sph->stacksize = stacksize;
     p_sph->id = ABTD_atomic_fetch_add_uint64(&g_sp_id, 1);
+    p_sph->is_lazy = ABT_FALSE;
+    p_sph->is_trimmed = ABT_FALSE;
+    p_sph->stack_class = cls;
+    p_sph->node = p_local->mem_node;
 
     /* Allocate a stack page */
-    p_sp = ABTI_mem_alloc_large_page(sp_size, &p_sph->is_mmapped);
+    p_sph->p_sp = ABTI_mem_alloc_large_page(sp_size, p_sph->node,
+                                            &p_sph->is_mmapped);
+
+    /* Add this stack page to the global stack page list */
+    ABTI_mem_add_sph_to_global(p_sph);
+
+    return p_sph;
+}
+
+/* Return the size of the slot of a lazily committed stack of stacksize bytes,
+ * which has room to shift the stack by less than a page. */
+static inline size_t ABTI_mem_get_lazy_slot_size(size_t stacksize)
+{
+    size_t pgsize = gp_ABTI_global->os_page_size;
+    size_t max_color = pgsize - gp_ABTI_global->cache_line_size;
+    return pgsize + (stacksize + max_color + pgsize - 1) / pgsize * pgsize;
+}
+
+/* Allocate a stack page for lazily committed stacks.  The stack page is
+ * reserved with mmap() and each stack is laid out in its slot as
+ *  |-------------------|
+ *  | guard page        |
+ *  |-------------------|
+ *  | (unused)          |
+ *  |-------------------|
+ *  | actual stack area |
+ *  |-------------------|
+ *  | ABTI_thread       |
+ *  |-------------------|
+ *  | ABTI_stack_header |
+ *  |-------------------|
+ *  | color             |
+ *  |-------------------|
+ * so that only pages touched by the ULT and the pages of the headers become
+ * resident.  NULL is returned if the stack page cannot be reserved. */
+static ABTI_sp_header *ABTI_mem_alloc_lazy_sp(ABTI_local *p_local, int cls)
+{
+    size_t stacksize = ABTI_mem_get_class_stacksize(cls);
+    size_t sp_size = gp_ABTI_global->mem_sp_size;
+    size_t slot_size = ABTI_mem_get_lazy_slot_size(stacksize);
+    ABTI_sp_header *p_sph;
+    char *p_sp;
+
+    if (sp_size / slot_size == 0) return NULL;
+
+    p_sp = (char *)mmap(NULL, sp_size, PROTS, FLAGS_LAZY, 0, 0);
+    if ((void *)p_sp == MAP_FAILED) {
+        ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->mem_num_mmap_failures, 1);
+        return NULL;
+    }
+    LOG_DEBUG("mmap a lazy stack page (%zu): %p\n", sp_size, p_sp);
+    ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->mem_mmap_rp_bytes, sp_size);
+    ABTD_affinity_bind_memory(p_sp, sp_size, p_local->mem_node);
 
-    /* Save the stack page pointer */
+    /* Allocate a stack page header */
+    p_sph = (ABTI_sp_header *)ABTU_malloc(sizeof(ABTI_sp_header));
+    p_sph->num_total_stacks = sp_size / slot_size;
+    p_sph->num_empty_stacks = 0;
+    p_sph->num_carved_stacks = 0;
+    p_sph->stacksize = stacksize;
+    p_sph->id = ABTD_atomic_fetch_add_uint64(&g_sp_id, 1);
+    p_sph->is_mmapped = ABT_TRUE;
+    p_sph->is_lazy = ABT_TRUE;
+    p_sph->is_trimmed = ABT_FALSE;
+    p_sph->stack_class = cls;
+    p_sph->node = p_local->mem_node;
     p_sph->p_sp = p_sp;
 
-    /* First stack */
-    int first_pos = p_sph->id % num_stacks;
-    p_first = p_sp + actual_stacksize * first_pos;
-    p_sh = (ABTI_stack_header *)(p_first + sizeof(ABTI_thread));
+    /* Add this stack page to the global stack page list */
+    ABTI_mem_add_sph_to_global(p_sph);
+
+    return p_sph;
+}
+
+/* Return the color of the i-th stack of p_sph.  Lazily committed stacks are
+ * already shifted in their slots, and descriptors have no stack.  The colors
+ * of the stacks of a page start from the ID of the page so that stacks at the
+ * same position of consecutive pages get different colors. */
+static inline uint32_t ABTI_mem_get_stack_color(ABTI_sp_header *p_sph,
+                                                uint32_t i)
+{
+    uint32_t num_colors = gp_ABTI_global->mem_stack_colors;
+
+    if (p_sph->is_lazy == ABT_TRUE || p_sph->stack_class == ABTI_MEM_DESC_CLASS
+        || p_sph->stacksize < ABTI_MEM_MIN_COLOR_STACKSIZE) {
+        return 0;
+    }
+    return (uint32_t)((p_sph->id + i) % num_colors)
+           * gp_ABTI_global->cache_line_size;
+}
+
+/* Set up the i-th stack of p_sph and return the pointer to its block that
+ * starts with ABTI_thread.  In a regular stack page, the headers of all stacks
+ * are packed at the position of the (id % num_total_stacks)-th stack so that
+ * the headers of different stack pages are not mapped to the same cache set.
+ * Consecutive stacks are placed header_size bytes apart from multiples of the
+ * stack size, so the tops of the stacks, where ULTs start, are also spread
+ * over cache sets.  Lazily committed stacks are in page-aligned slots, so the
+ * i-th one is shifted down by i * header_size modulo the page size for the
+ * same effect.  A guard page is not set for a lazily committed stack if
+ * mprotect() fails, e.g., because the number of memory mappings reaches its
+ * limit. */
+static char *ABTI_mem_carve_stack(ABTI_sp_header *p_sph, uint32_t i)
+{
+    size_t header_size = gp_ABTI_global->mem_sh_size;
+    uint32_t num_stacks = p_sph->num_total_stacks;
+    char *p_sp = (char *)p_sph->p_sp;
+    char *p_blk;
+    ABTI_stack_header *p_sh;
+    void *p_stack;
+
+    if (p_sph->is_lazy == ABT_TRUE) {
+        size_t pgsize = gp_ABTI_global->os_page_size;
+        size_t stacksize = p_sph->stacksize;
+        size_t slot_size = ABTI_mem_get_lazy_slot_size(stacksize);
+        size_t color = (size_t)i * header_size % pgsize;
+        char *p_slot = p_sp + i * slot_size;
+
+        if (mprotect(p_slot, pgsize, PROT_NONE) != 0) {
+            LOG_DEBUG("no guard page for the stack at %p\n", p_slot);
+        }
+        p_blk = p_slot + slot_size - header_size - color;
+        p_stack = (void *)(p_blk + header_size - stacksize);
+    } else {
+        size_t actual_stacksize = p_sph->stacksize - header_size;
+        uint32_t first_pos = p_sph->id % num_stacks;
+        char *p_first = p_sp + actual_stacksize * first_pos;
+
+        p_blk = p_first + header_size * i;
+        p_stack = (i < first_pos)
+                ? (void *)(p_sp + actual_stacksize * i)
+                : (void *)(p_first + header_size * num_stacks
+                           + actual_stacksize * (i - first_pos));
+    }
+
+    p_sh = (ABTI_stack_header *)(p_blk + sizeof(ABTI_thread));
+    p_sh->p_next = NULL;
     p_sh->p_sph = p_sph;
-    p_stack = (first_pos == 0)
-            ? (void *)(p_first + header_size * num_stacks) : (void *)p_sp;
     p_sh->p_stack = p_stack;
+    p_sh->is_reclaimed = p_sph->is_lazy;
+    p_sh->color = ABTI_mem_get_stack_color(p_sph, i);
+    return p_blk;
+}
 
-    if (num_stacks > 1) {
-        /* Make a linked list with remaining stacks */
-        p_sh = (ABTI_stack_header *)((char *)p_sh + header_size);
-
-        p_local->num_stacks = num_stacks - 1;
-        p_local->p_mem_stack = p_sh;
-
-        for (i = 1; i < num_stacks; i++) {
-            p_next = (i + 1) < num_stacks
-                   ? (ABTI_stack_header *)((char *)p_sh + header_size)
-                   : NULL;
-            p_sh->p_next = p_next;
-            p_sh->p_sph = p_sph;
-            if (first_pos == 0) {
-                p_sh->p_stack = (void *)((char *)p_stack + i * actual_stacksize);
-            } else {
-                if (i < first_pos) {
-                    p_sh->p_stack = (void *)(p_sp + i * actual_stacksize);
-                } else {
-                    p_sh->p_stack = (void *)(p_first + header_size * num_stacks
-                                  + (i - first_pos) * actual_stacksize);
-                }
-            }
+/* Return a stack of class cls carved out of the stack page of p_local, which
+ * is allocated first if p_local has none.  A batch of half of the limit of
+ * the stack pool is carved at once: the first one is returned and the others
+ * are kept in p_local, whose stack list of the class has to be empty. */
+char *ABTI_mem_alloc_sp(ABTI_local *p_local, int cls)
+{
+    ABTI_stack_list *p_list = &p_local->mem_stacks[cls];
+    ABTI_sp_header *p_sph = p_list->p_sph;
+    ABTI_stack_header *p_sh, *p_prev = NULL;
+    uint32_t num_take = p_list->max_stacks / 2 + 1;
+    uint32_t i;
+    char *p_first;
+
+    if (p_sph == NULL) {
+        /* Continue a stack page left by a terminated ES */
+        ABTI_mem_node *p_node = ABTI_mem_get_node(p_local->mem_node);
+        if (p_node->p_mem_sph[cls]) {
+            ABTI_spinlock_acquire(&p_node->lock);
+            p_sph = p_node->p_mem_sph[cls];
+            p_node->p_mem_sph[cls] = NULL;
+            ABTI_spinlock_release(&p_node->lock);
+        }
+    }
+    if (p_sph == NULL) {
+        /* Descriptors have no stack to be lazily committed. */
+        if (gp_ABTI_global->mem_lazy_stack == ABT_TRUE &&
+            cls != ABTI_MEM_DESC_CLASS) {
+            p_sph = ABTI_mem_alloc_lazy_sp(p_local, cls);
+        }
+        if (p_sph == NULL) {
+            p_sph = ABTI_mem_alloc_regular_sp(p_local, cls);
+        }
+    }
 
-            p_sh = p_next;
+    if (num_take > p_sph->num_total_stacks - p_sph->num_carved_stacks) {
+        num_take = p_sph->num_total_stacks - p_sph->num_carved_stacks;
+    }
+    p_first = ABTI_mem_carve_stack(p_sph, p_sph->num_carved_stacks);
+    for (i = 1; i < num_take; i++) {
+        p_sh = (ABTI_stack_header *)
+            (ABTI_mem_carve_stack(p_sph, p_sph->num_carved_stacks + i)
+             + sizeof(ABTI_thread));
+        if (p_prev) {
+            p_prev->p_next = p_sh;
+        } else {
+            p_list->p_head = p_sh;
         }
+        p_prev = p_sh;
     }
+    p_list->num_stacks = num_take - 1;
+    p_sph->num_carved_stacks += num_take;
 
-    /* Add this stack page to the global stack page list */
+    p_list->p_sph = (p_sph->num_carved_stacks < p_sph->num_total_stacks)
+                  ? p_sph : NULL;
+    return p_first;
+}
+
+/* Hand the stack page being carved by p_local over to its NUMA node so that
+ * another ES continues it.  If the node already has one, the rest of the
+ * stacks are carved and added to the global data at once. */
+static void ABTI_mem_release_sp(ABTI_local *p_local, int cls)
+{
+    ABTI_stack_list *p_list = &p_local->mem_stacks[cls];
+    ABTI_sp_header *p_sph = p_list->p_sph;
+    ABTI_mem_node *p_node;
+    ABTI_stack_header *p_head = NULL, *p_tail = NULL;
+    uint32_t i;
+
+    if (p_sph == NULL) return;
+    p_list->p_sph = NULL;
+
+    p_node = ABTI_mem_get_node(p_sph->node);
+    ABTI_spinlock_acquire(&p_node->lock);
+    if (p_node->p_mem_sph[cls] == NULL) {
+        p_node->p_mem_sph[cls] = p_sph;
+        p_sph = NULL;
+    }
+    ABTI_spinlock_release(&p_node->lock);
+    if (p_sph == NULL) return;
+
+    for (i = p_sph->num_carved_stacks; i < p_sph->num_total_stacks; i++) {
+        ABTI_stack_header *p_sh = (ABTI_stack_header *)
+            (ABTI_mem_carve_stack(p_sph, i) + sizeof(ABTI_thread));
+        p_sh->p_next = p_head;
+        p_head = p_sh;
+        if (p_tail == NULL) p_tail = p_sh;
+    }
+    ABTI_mem_add_stacks_to_global(p_sph->node, cls, p_head, p_tail,
+                                  p_sph->num_total_stacks
+                                  - p_sph->num_carved_stacks);
+    p_sph->num_carved_stacks = p_sph->num_total_stacks;
+}
+
+static inline void ABTI_mem_add_sph_to_global(ABTI_sp_header *p_sph)
+{
     uint64_t *ptr = (uint64_t *)&gp_ABTI_global->p_mem_sph;
     uint64_t old, ret;
     do {
@@ -676,9 +1217,407 @@ char *ABTI_mem_alloc_sp(ABTI_local *p_local, size_t stacksize)
         old = (uint64_t)p_sph->p_next;
         ret = ABTD_atomic_cas_uint64(ptr, old, (uint64_t)p_sph);
     } while (old != ret);
+}
 
-    return p_first;
+static void ABTI_mem_add_local_stats(ABTI_local *p_local,
+                                     ABT_mem_stats *p_stats)
+{
+    ABTI_page_header *p_head, *p_ph;
+    int i;
+
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        uint32_t num_stacks = p_local->mem_stacks[i].num_stacks;
+        p_stats->num_stacks += num_stacks;
+        p_stats->stack_bytes += num_stacks * ABTI_mem_get_class_stacksize(i);
+    }
+
+    /* Task pages of an ES are not freed while it runs, so they can be
+     * traversed while it adds pages. */
+    p_head = p_local->p_mem_task_head;
+    p_ph = p_head;
+    while (p_ph) {
+        p_stats->num_task_pages++;
+        p_stats->num_task_blks += p_ph->num_total_blks;
+        p_stats->num_free_task_blks += p_ph->num_empty_blks;
+        p_stats->num_remote_frees += p_ph->num_remote_free;
+        p_ph = p_ph->p_next;
+        if (p_ph == p_head) break;
+    }
+
+    for (i = 0; i < ABTI_MEM_NUM_RFREE_BUFS; i++) {
+        p_stats->num_buffered_frees += p_local->mem_rfree_bufs[i].num_blks;
+    }
 }
 
-#endif /* ABT_CONFIG_USE_MEM_POOL */
+/* Fill p_stats with the memory held by the memory pool.  The caches of
+ * p_xstream, or of all ESs if it is NULL, are read without synchronization,
+ * so they may be slightly out of date while the ESs run. */
+void ABTI_mem_get_stats(ABTI_xstream *p_xstream, ABT_mem_stats *p_stats)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_sp_header *p_sph;
+    ABTI_page_header *p_ph;
+    int i, n;
+
+    memset(p_stats, 0, sizeof(ABT_mem_stats));
 
+    if (p_xstream) {
+        ABTI_local *p_local = p_xstream->p_local;
+        if (p_local) ABTI_mem_add_local_stats(p_local, p_stats);
+    } else {
+        ABTI_spinlock_acquire(&p_global->lock);
+        for (i = 0; i < p_global->max_xstreams; i++) {
+            ABTI_xstream *p_tmp = p_global->p_xstreams[i];
+            if (p_tmp && p_tmp->p_local) {
+                ABTI_mem_add_local_stats(p_tmp->p_local, p_stats);
+            }
+        }
+        ABTI_spinlock_release(&p_global->lock);
+    }
+
+    for (n = 0; n < p_global->mem_num_nodes; n++) {
+        ABTI_mem_node *p_node = &p_global->p_mem_nodes[n];
+
+        ABTI_spinlock_acquire(&p_node->lock);
+        for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+            uint32_t num_stacks = p_node->num_mem_stacks[i];
+            p_stats->num_global_stacks += num_stacks;
+            p_stats->global_stack_bytes += num_stacks
+                                         * ABTI_mem_get_class_stacksize(i);
+        }
+        for (p_ph = p_node->p_mem_task; p_ph; p_ph = p_ph->p_next) {
+            p_stats->num_global_task_pages++;
+            p_stats->num_global_task_blks += p_ph->num_total_blks;
+            p_stats->num_global_free_task_blks += p_ph->num_empty_blks
+                                                + p_ph->num_remote_free;
+        }
+        ABTI_spinlock_release(&p_node->lock);
+    }
+
+    /* Stack pages are removed from the list only by trims. */
+    ABTI_spinlock_acquire(&p_global->mem_trim_lock);
+    for (p_sph = p_global->p_mem_sph; p_sph; p_sph = p_sph->p_next) {
+        p_stats->num_stack_pages++;
+        p_stats->stack_page_bytes += ABTI_mem_get_class_sp_size(
+                p_sph->stack_class);
+        p_stats->num_uncarved_stacks += p_sph->num_total_stacks
+                                      - p_sph->num_carved_stacks;
+    }
+    ABTI_spinlock_release(&p_global->mem_trim_lock);
+
+    p_stats->malloc_bytes = p_global->mem_malloc_bytes;
+    p_stats->mmap_rp_bytes = p_global->mem_mmap_rp_bytes;
+    p_stats->mmap_hp_bytes = p_global->mem_mmap_hp_bytes;
+    p_stats->thp_bytes = p_global->mem_thp_bytes;
+    p_stats->trimmed_bytes = p_global->mem_trimmed_bytes;
+    p_stats->mmap_gp_bytes = p_global->mem_mmap_gp_bytes;
+    p_stats->num_gp_failures = p_global->mem_num_gp_failures;
+    p_stats->num_hp_failures = p_global->mem_num_hp_failures;
+    p_stats->num_mmap_failures = p_global->mem_num_mmap_failures;
+    p_stats->num_thp_failures = p_global->mem_num_thp_failures;
+}
+
+/* Release the caches of p_local beyond what an idle ES keeps.  Stacks of each
+ * class beyond the lower bound of the limit are moved to the global data, and
+ * task block pages whose blocks have all been freed are freed except one. */
+static void ABTI_mem_trim_local(ABTI_local *p_local)
+{
+    ABTI_page_header *p_ph;
+    uint32_t i, num_pages = 0;
+    int cls;
+
+    for (cls = 0; cls < ABTI_MEM_NUM_STACK_CLASSES; cls++) {
+        ABTI_stack_list *p_list = &p_local->mem_stacks[cls];
+        uint32_t min_stacks = p_list->min_stacks;
+        if (min_stacks > gp_ABTI_global->mem_max_stacks) {
+            min_stacks = gp_ABTI_global->mem_max_stacks;
+        }
+        ABTI_mem_release_stacks(p_local, cls, min_stacks);
+        p_list->max_stacks = min_stacks;
+        p_list->low_stacks = p_list->num_stacks;
+        p_list->num_frees = 0;
+    }
+
+    /* Blocks buffered here may complete pages of other ESs. */
+    ABTI_mem_flush_remote_frees(p_local);
+
+    /* Pages are counted first since freed ones leave the list. */
+    p_ph = p_local->p_mem_task_head;
+    while (p_ph) {
+        num_pages++;
+        p_ph = p_ph->p_next;
+        if (p_ph == p_local->p_mem_task_head) break;
+    }
+    p_ph = p_local->p_mem_task_head;
+    for (i = 0; i < num_pages; i++) {
+        ABTI_page_header *p_next = p_ph->p_next;
+        ABTI_mem_free_page(p_local, p_ph);
+        p_ph = p_next;
+    }
+
+    /* Pages of ABT_mem_alloc() whose blocks are all free, except the first
+     * one of each class */
+    for (cls = 0; cls < ABTI_MEM_NUM_USER_CLASSES; cls++) {
+        ABTI_page_header *p_head = p_local->p_mem_user[cls];
+        if (p_head == NULL) continue;
+        p_ph = p_head->p_next;
+        while (p_ph) {
+            ABTI_page_header *p_next = p_ph->p_next;
+            if (p_ph->num_empty_blks + p_ph->num_remote_free
+                == p_ph->num_total_blks) {
+                p_ph->p_prev->p_next = p_next;
+                if (p_next) p_next->p_prev = p_ph->p_prev;
+                ABTI_mem_release_page(p_ph);
+                ABTD_atomic_fetch_add_uint64(
+                    &gp_ABTI_global->mem_trimmed_bytes,
+                    gp_ABTI_global->mem_page_size);
+            }
+            p_ph = p_next;
+        }
+    }
+}
+
+/* Release pages of the global data until its free stacks and task blocks take
+ * at most max_bytes.  A stack page can be released when all of its stacks are
+ * in the global lists, which means that no stack is used or cached by an ES
+ * and that no ES carves the page.  Other ESs cannot take global stacks while
+ * they are examined.  If wait is ABT_FALSE, nothing is done while another
+ * trim runs. */
+static void ABTI_mem_trim_global(size_t max_bytes, ABT_bool wait)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_sp_header *p_sph, *p_next, *p_prev = NULL;
+    ABTI_page_header *p_ph, **pp_ph, *p_free_pages = NULL;
+    ABTI_stack_header *p_sh, **pp_sh;
+    uint64_t cached_bytes = 0, trimmed_bytes = 0;
+    size_t pgsize = p_global->mem_page_size;
+    ABT_bool is_trimmed = ABT_FALSE;
+    int i, n;
+
+    if (wait == ABT_TRUE) {
+        ABTI_spinlock_acquire(&p_global->mem_trim_lock);
+    } else if (ABTI_spinlock_try_acquire(&p_global->mem_trim_lock)
+               == ABT_FALSE) {
+        return;
+    }
+
+    for (n = 0; n < p_global->mem_num_nodes; n++) {
+        ABTI_mem_node *p_node = &p_global->p_mem_nodes[n];
+        ABTI_spinlock_acquire(&p_node->lock);
+        for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+            cached_bytes += (uint64_t)p_node->num_mem_stacks[i]
+                          * ABTI_mem_get_class_stacksize(i);
+        }
+        for (p_ph = p_node->p_mem_task; p_ph; p_ph = p_ph->p_next) {
+            if (p_ph->num_empty_blks + p_ph->num_remote_free
+                == p_ph->num_total_blks) {
+                cached_bytes += pgsize;
+            }
+        }
+    }
+
+    if (cached_bytes > max_bytes) {
+        /* Count the free stacks of each stack page */
+        for (n = 0; n < p_global->mem_num_nodes; n++) {
+            ABTI_mem_node *p_node = &p_global->p_mem_nodes[n];
+            for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+                for (p_sh = p_node->p_mem_stack[i]; p_sh; p_sh = p_sh->p_next) {
+                    p_sh->p_sph->num_empty_stacks++;
+                }
+            }
+        }
+
+        /* Choose the stack pages to be released.  A page that has not been
+         * fully carved must be the one left by a terminated ES. */
+        for (p_sph = p_global->p_mem_sph; p_sph && cached_bytes > max_bytes;
+             p_sph = p_sph->p_next) {
+            ABTI_mem_node *p_node = ABTI_mem_get_node(p_sph->node);
+            if (p_sph->num_empty_stacks != p_sph->num_carved_stacks) continue;
+            if (p_sph->num_carved_stacks < p_sph->num_total_stacks &&
+                p_node->p_mem_sph[p_sph->stack_class] != p_sph) continue;
+            p_sph->is_trimmed = ABT_TRUE;
+            is_trimmed = ABT_TRUE;
+            cached_bytes -= (uint64_t)p_sph->num_carved_stacks
+                          * p_sph->stacksize;
+        }
+    }
+
+    for (n = 0; n < p_global->mem_num_nodes; n++) {
+        ABTI_mem_node *p_node = &p_global->p_mem_nodes[n];
+
+        /* Remove the stacks of the chosen stack pages */
+        for (i = 0; is_trimmed == ABT_TRUE &&
+                    i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+            pp_sh = &p_node->p_mem_stack[i];
+            while ((p_sh = *pp_sh) != NULL) {
+                if (p_sh->p_sph->is_trimmed == ABT_TRUE) {
+                    *pp_sh = p_sh->p_next;
+                    p_node->num_mem_stacks[i]--;
+                } else {
+                    pp_sh = &p_sh->p_next;
+                }
+            }
+            if (p_node->p_mem_sph[i] &&
+                p_node->p_mem_sph[i]->is_trimmed == ABT_TRUE) {
+                p_node->p_mem_sph[i] = NULL;
+            }
+        }
+
+        /* Take out empty task block pages.  They are freed after the lock
+         * is released. */
+        pp_ph = &p_node->p_mem_task;
+        while ((p_ph = *pp_ph) != NULL && cached_bytes > max_bytes) {
+            if (p_ph->num_empty_blks + p_ph->num_remote_free
+                == p_ph->num_total_blks) {
+                *pp_ph = p_ph->p_next;
+                p_ph->p_next = p_free_pages;
+                p_free_pages = p_ph;
+                cached_bytes -= pgsize;
+                trimmed_bytes += pgsize;
+            } else {
+                pp_ph = &p_ph->p_next;
+            }
+        }
+        ABTI_spinlock_release(&p_node->lock);
+    }
+
+    /* Unlink the chosen stack pages from the list of stack pages and free
+     * them.  Other ESs may push new stack pages to its head meanwhile. */
+    p_sph = p_global->p_mem_sph;
+    while (p_sph) {
+        p_next = p_sph->p_next;
+        p_sph->num_empty_stacks = 0;
+        if (p_sph->is_trimmed == ABT_FALSE) {
+            p_prev = p_sph;
+            p_sph = p_next;
+            continue;
+        }
+
+        if (p_prev) {
+            p_prev->p_next = p_next;
+        } else {
+            uint64_t *ptr = (uint64_t *)&p_global->p_mem_sph;
+            uint64_t old = (uint64_t)p_sph;
+            if (ABTD_atomic_cas_uint64(ptr, old, (uint64_t)p_next) != old) {
+                /* p_sph is not the head anymore. */
+                ABTI_sp_header *p_tmp = p_global->p_mem_sph;
+                while (p_tmp->p_next != p_sph) p_tmp = p_tmp->p_next;
+                p_tmp->p_next = p_next;
+            }
+        }
+        trimmed_bytes += ABTI_mem_get_class_sp_size(p_sph->stack_class);
+        ABTI_mem_free_sp(p_sph);
+        p_sph = p_next;
+    }
+    ABTI_spinlock_release(&p_global->mem_trim_lock);
+
+    ABTI_mem_free_page_list(p_free_pages);
+    ABTD_atomic_fetch_add_uint64(&p_global->mem_trimmed_bytes, trimmed_bytes);
+}
+
+/* Trim the caches of p_local, unless it is NULL, and then the global data,
+ * whose free stacks and task blocks are reduced to max_bytes.  If wait is
+ * ABT_FALSE, the global data are not trimmed while another ES trims them. */
+void ABTI_mem_trim(ABTI_local *p_local, size_t max_bytes, ABT_bool wait)
+{
+    if (p_local) ABTI_mem_trim_local(p_local);
+    ABTI_mem_trim_global(max_bytes, wait);
+}
+
+/* Blocks of ABT_mem_alloc().  Each ES has a list of pages per size class,
+ * which are the same pages as those of tasklet blocks.  A block is taken from
+ * the first page of the list, and a page that still has free blocks is moved
+ * to the front when the first page runs out.  Blocks freed by other ESs go
+ * to the remote free list of their page like tasklet blocks.  Large blocks
+ * and blocks of external threads are allocated with malloc() and marked by a
+ * NULL page header. */
+static inline int ABTI_mem_get_user_class(size_t size)
+{
+    size_t blk_size = ABTI_MEM_MIN_USER_SIZE;
+    int cls = 0;
+
+    while (blk_size < size && cls < ABTI_MEM_NUM_USER_CLASSES) {
+        blk_size <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+static ABTI_page_header *ABTI_mem_get_user_page(ABTI_local *p_local, int cls)
+{
+    ABTI_page_header *p_head = p_local->p_mem_user[cls];
+    ABTI_page_header *p_ph;
+
+    for (p_ph = p_head; p_ph; p_ph = p_ph->p_next) {
+        if (p_ph->p_head) break;
+        if (p_ph->num_carved_blks < p_ph->num_total_blks) {
+            ABTI_mem_carve_blks(p_ph);
+            break;
+        }
+        if (p_ph->p_free) {
+            ABTI_mem_take_free(p_ph);
+            break;
+        }
+    }
+    if (p_ph == p_head && p_ph) return p_ph;
+
+    if (p_ph == NULL) {
+        size_t blk_size = sizeof(ABTI_blk_header)
+                        + ((size_t)ABTI_MEM_MIN_USER_SIZE << cls);
+        p_local->mem_node = ABTD_affinity_get_node();
+        p_ph = ABTI_mem_new_page(p_local, blk_size);
+    } else {
+        /* Unlink the page from the middle of the list */
+        p_ph->p_prev->p_next = p_ph->p_next;
+        if (p_ph->p_next) p_ph->p_next->p_prev = p_ph->p_prev;
+    }
+
+    /* Move it to the front */
+    p_ph->p_prev = NULL;
+    p_ph->p_next = p_head;
+    if (p_head) p_head->p_prev = p_ph;
+    p_local->p_mem_user[cls] = p_ph;
+    return p_ph;
+}
+
+void *ABTI_mem_alloc_user(ABTI_local *p_local, size_t size)
+{
+    ABTI_page_header *p_ph;
+    ABTI_blk_header *p_bh;
+    int cls = ABTI_mem_get_user_class(size);
+
+    if (p_local == NULL || cls == ABTI_MEM_NUM_USER_CLASSES) {
+        p_bh = (ABTI_blk_header *)ABTU_malloc(sizeof(ABTI_blk_header) + size);
+        if (p_bh == NULL) return NULL;
+        p_bh->p_ph = NULL;
+        return (void *)((char *)p_bh + sizeof(ABTI_blk_header));
+    }
+
+    p_ph = ABTI_mem_get_user_page(p_local, cls);
+    p_bh = p_ph->p_head;
+    p_ph->p_head = p_bh->p_next;
+    p_ph->num_empty_blks--;
+    return (void *)((char *)p_bh + sizeof(ABTI_blk_header));
+}
+
+void ABTI_mem_free_user(ABTI_local *p_local, void *ptr)
+{
+    ABTI_blk_header *p_bh;
+    ABTI_page_header *p_ph;
+
+    p_bh = (ABTI_blk_header *)((char *)ptr - sizeof(ABTI_blk_header));
+    p_ph = p_bh->p_ph;
+    if (p_ph == NULL) {
+        ABTU_free(p_bh);
+    } else if (p_local == NULL) {
+        /* External threads do not buffer remote frees. */
+        ABTI_mem_push_remote(p_ph, p_bh, p_bh, 1);
+    } else if (p_ph->p_owner == p_local->p_xstream) {
+        p_bh->p_next = p_ph->p_head;
+        p_ph->p_head = p_bh;
+        p_ph->num_empty_blks++;
+    } else {
+        ABTI_mem_free_remote(p_local, p_ph, p_bh);
+    }
+}
+#endif /* ABT_CONFIG_USE_MEM_POOL */
@@ -0,0 +1,130 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+
+/** @defgroup MEM  Memory Pool
+ * This group is for controlling the memory pool, which caches the stacks of
+ * ULTs and the blocks of tasklets for reuse.
+ */
+
+
+/**
+ * @ingroup MEM
+ * @brief   Return unused memory of the memory pool to the OS.
+ *
+ * \c ABT_mem_trim() trims the memory pool after a burst of work units.  The
+ * caller's ES moves the stacks that it keeps beyond its minimum to the global
+ * data and frees its task block pages whose blocks have all been freed.  Then
+ * the stack pages and task block pages of the global data whose stacks and
+ * blocks are all free are released until the free stacks and blocks in the
+ * global data take at most \c max_bytes bytes.  A stack page is released only
+ * when none of its stacks is used or cached by any ES.
+ *
+ * The other ESs trim their own caches and then the global data when they
+ * check events next time, so calling \c ABT_mem_trim() again after a while
+ * may release more memory.  \c ABT_mem_trim() can also be called by an
+ * external thread, which trims only the global data.  See
+ * \c ABT_MEM_TRIM_INTERVAL for periodic trims.
+ *
+ * @param[in] max_bytes  bytes of free stacks and blocks kept in the global data
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA the memory pool is not used
+ */
+int ABT_mem_trim(size_t max_bytes)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    int abt_errno = ABT_SUCCESS;
+    ABTI_global *p_global;
+    ABTI_local *p_local = lp_ABTI_local;
+
+    ABTI_CHECK_INITIALIZED();
+    p_global = gp_ABTI_global;
+
+    /* Ask the other ESs to trim their caches */
+    p_global->mem_trim_target = max_bytes;
+    ABTD_atomic_fetch_add_uint32(&p_global->mem_trim_seq, 1);
+    if (p_local) p_local->mem_trim_seq = p_global->mem_trim_seq;
+
+    ABTI_mem_trim(p_local, max_bytes, ABT_TRUE);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(max_bytes);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+/**
+ * @ingroup MEM
+ * @brief   Allocate memory from the per-ES block cache.
+ *
+ * \c ABT_mem_alloc() allocates \c size bytes from the caller's ES, which
+ * keeps pages of blocks per size class like those of tasklets, so small and
+ * short-lived objects are allocated and freed without contention with the
+ * other ESs.  The memory is aligned to 16 bytes and has to be freed by
+ * \c ABT_mem_free(), which can be called on any ES or external thread.
+ * Blocks larger than 2 KB and blocks allocated by external threads are taken
+ * from \c malloc().  All memory allocated by \c ABT_mem_alloc() has to be
+ * freed before \c ABT_finalize().
+ *
+ * @param[in]  size  number of bytes
+ * @param[out] ptr   allocated memory
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_MEM     memory allocation failure
+ */
+int ABT_mem_alloc(size_t size, void **ptr)
+{
+    int abt_errno = ABT_SUCCESS;
+    void *p_mem;
+
+    ABTI_CHECK_INITIALIZED();
+    p_mem = ABTI_mem_alloc_user(lp_ABTI_local, size);
+    ABTI_CHECK_TRUE(p_mem != NULL, ABT_ERR_MEM);
+    *ptr = p_mem;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MEM
+ * @brief   Free memory allocated by \c ABT_mem_alloc().
+ *
+ * Memory freed by the ES that allocated it is returned to the ES's cache
+ * directly.  Memory freed by another ES or an external thread is returned to
+ * the page that holds it with atomic operations, and the owner ES reuses it
+ * when it runs out of blocks.  \c ptr may be \c NULL.
+ *
+ * @param[in] ptr  memory allocated by \c ABT_mem_alloc()
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_mem_free(void *ptr)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_CHECK_INITIALIZED();
+    if (ptr != NULL) ABTI_mem_free_user(lp_ABTI_local, ptr);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
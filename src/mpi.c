@@ -0,0 +1,817 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* MPI waits.  Each ES has a poller, which keeps the MPI requests that the
+ * ULTs on the ES wait for in an array.  A waiting ULT appends its request and
+ * is blocked, and the scheduler of the ES tests all the requests with one
+ * MPI_Testsome() whenever it checks events, instead of each ULT calling
+ * MPI_Test() between yields.
+ *
+ * As with the I/O poller, only the poller wakes up its waiters.  It takes a
+ * completed request out of the array before it makes the ULT ready, so a
+ * woken ULT never touches the poller again.
+ *
+ * Work stealing across processes.  Each process exposes a bounded queue of
+ * remote tasklet descriptors in an MPI window, laid out as {head, tail,
+ * descs[capacity]}.  The owner appends at tail, and any process, including
+ * the owner, takes the descriptor at head in an exclusive lock epoch on the
+ * target, so no atomic RMA operation is needed.  Epochs of one process are
+ * serialized by a spinlock since only one of its threads may lock a target
+ * at a time.
+ *
+ * Function shipping.  Each process exposes a remote ring (see remote.c) in an
+ * MPI window, and other processes push descriptors into it with MPI atomics
+ * and puts in a passive epoch that lasts as long as the ring.  The pool of
+ * the ring reads the window memory directly after MPI_Win_sync(), so the
+ * owner makes no MPI call to receive tasklets. */
+
+/* Initial allocation size of the arrays of a poller */
+#define ABTI_MPI_POLLER_INIT_SIZE   16
+
+/* Time to wait after a failed steal from another process, in seconds */
+#define ABTI_MPI_STEAL_BACKOFF      50.0e-6
+
+#ifdef ABT_CONFIG_USE_MPI
+typedef struct {
+    MPI_Comm comm;
+    MPI_Win win;
+    int rank;
+    int size;
+    int capacity;
+    ABTI_spinlock lock;         /* Serializes the lock epochs */
+    ABT_pool pool;              /* Remote pool that steals with this */
+    unsigned int seed;
+    double next_steal_time;     /* No remote steal before this time */
+} ABTI_mpi_steal;
+
+typedef struct {
+    MPI_Comm comm;
+    MPI_Win win;
+    int capacity;
+    void *p_ring;               /* Memory of the window */
+    ABT_pool pool;              /* Remote pool on p_ring */
+} ABTI_mpi_ring;
+
+/* Displacements in the window in bytes */
+#define ABTI_MPI_STEAL_HEAD     0
+#define ABTI_MPI_STEAL_TAIL     sizeof(int64_t)
+#define ABTI_MPI_STEAL_DESC(p_steal, idx)                           \
+    (MPI_Aint)(2 * sizeof(int64_t) +                                \
+               ((idx) % (p_steal)->capacity) * sizeof(ABT_remote_desc))
+
+static int ABTI_mpi_wait_thread(ABTI_thread *p_thread, MPI_Request *p_request,
+                                MPI_Status *p_status);
+static void ABTI_mpi_poller_grow(ABTI_mpi_poller *p_poller);
+static void ABTI_mpi_poller_progress(ABTI_mpi_poller *p_poller,
+                                     ABT_bool blocking);
+static void ABTI_mpi_poller_wake(ABTI_mpi_poller *p_poller, int idx,
+                                 MPI_Status *p_status, int error);
+static ABT_bool ABTI_mpi_steal_fn(void *arg, ABT_remote_desc *desc);
+static ABT_bool ABTI_mpi_steal_from(ABTI_mpi_steal *p_steal, int target,
+                                    ABT_remote_desc *desc);
+static ABT_bool ABTI_mpi_ring_pop(void *arg, ABT_remote_desc *desc);
+
+
+/** @defgroup MPI MPI
+ * ULTs can wait for MPI requests without blocking their ESs.  This is
+ * available if Argobots is configured with \c --with-mpi; the routines are
+ * declared in \c abt_mpi.h.
+ *
+ * The schedulers make MPI calls on behalf of the waiting ULTs, so MPI must
+ * be initialized with \c MPI_THREAD_MULTIPLE if ULTs on more than one ES
+ * call MPI.  MPI must not be finalized while ULTs are waiting.
+ */
+
+/**
+ * @ingroup MPI
+ * @brief   Wait for an MPI request without blocking the ES.
+ *
+ * \c ABT_mpi_wait() completes the MPI request \c request as \c MPI_Wait()
+ * does.  If the request has not completed yet, the calling ULT is blocked and
+ * the request is registered with the ES.  The scheduler of the ES tests the
+ * requests of all its waiting ULTs together with \c MPI_Testsome() whenever
+ * it checks events, and the ULT is pushed back to its pool once its request
+ * completes.
+ *
+ * Since a tasklet cannot be blocked, tasklets and external threads call
+ * \c MPI_Wait() instead, which blocks the ES.
+ *
+ * @param[in,out] request  MPI request
+ * @param[out]    status   status of the request, or \c MPI_STATUS_IGNORE
+ * @return Error code
+ * @retval ABT_SUCCESS  on success
+ * @retval ABT_ERR_MPI  \c request is \c NULL, or MPI has reported an error
+ */
+int ABT_mpi_wait(MPI_Request *request, MPI_Status *status)
+{
+    int abt_errno = ABT_SUCCESS;
+    int flag = 0;
+    ABTI_CHECK_TRUE(request != NULL, ABT_ERR_MPI);
+
+    /* Check it first since the request often has completed already. */
+    if (MPI_Test(request, &flag, status) != MPI_SUCCESS) {
+        abt_errno = ABT_ERR_MPI;
+        goto fn_fail;
+    }
+
+    if (flag == 0) {
+        if (lp_ABTI_local == NULL || ABTI_local_get_task() != NULL) {
+            /* External thread or tasklet */
+            if (MPI_Wait(request, status) != MPI_SUCCESS) {
+                abt_errno = ABT_ERR_MPI;
+            }
+        } else {
+            abt_errno = ABTI_mpi_wait_thread(ABTI_local_get_thread(),
+                                             request, status);
+        }
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MPI
+ * @brief   Create a queue of remote tasklets shared by processes.
+ *
+ * \c ABT_mpi_steal_create() creates a queue that holds up to \c capacity
+ * descriptors of remote tasklets (\c ABT_remote_desc) in an MPI window over
+ * \c comm, and a remote pool (see \c ABT_pool_create_remote()) that takes
+ * tasklets from the queues of all the processes in \c comm.  This routine is
+ * collective over \c comm, and MPI must be initialized with
+ * \c MPI_THREAD_MULTIPLE.
+ *
+ * Tasklets pushed with \c ABT_mpi_steal_push() run where they are popped from
+ * the pool, which should be given to work-stealing schedulers such as
+ * \c ABT_SCHED_RANDWS as a victim.  The pool tries the queue of the calling
+ * process first, and then that of a random process.  After a failed steal
+ * from another process, it does not try again for a short while.
+ *
+ * @param[in]  comm      MPI communicator
+ * @param[in]  capacity  maximum number of descriptors in the queue
+ * @param[out] newsteal  handle to a new queue
+ * @return Error code
+ * @retval ABT_SUCCESS  on success
+ * @retval ABT_ERR_MPI  \c capacity is not positive, MPI is not initialized
+ *                      with \c MPI_THREAD_MULTIPLE, or MPI has reported an
+ *                      error
+ */
+int ABT_mpi_steal_create(MPI_Comm comm, int capacity, ABT_mpi_steal *newsteal)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mpi_steal *p_steal = NULL;
+    MPI_Aint win_size;
+    int64_t *p_base;
+    int provided;
+
+    ABTI_CHECK_TRUE(capacity > 0, ABT_ERR_MPI);
+    if (MPI_Query_thread(&provided) != MPI_SUCCESS ||
+        provided != MPI_THREAD_MULTIPLE) {
+        abt_errno = ABT_ERR_MPI;
+        goto fn_fail;
+    }
+
+    p_steal = (ABTI_mpi_steal *)ABTU_malloc(sizeof(ABTI_mpi_steal));
+    if (MPI_Comm_dup(comm, &p_steal->comm) != MPI_SUCCESS) {
+        ABTU_free(p_steal);
+        p_steal = NULL;
+        abt_errno = ABT_ERR_MPI;
+        goto fn_fail;
+    }
+    MPI_Comm_rank(p_steal->comm, &p_steal->rank);
+    MPI_Comm_size(p_steal->comm, &p_steal->size);
+    p_steal->capacity = capacity;
+    win_size = 2 * sizeof(int64_t) + capacity * sizeof(ABT_remote_desc);
+    if (MPI_Win_allocate(win_size, 1, MPI_INFO_NULL, p_steal->comm, &p_base,
+                         &p_steal->win) != MPI_SUCCESS) {
+        MPI_Comm_free(&p_steal->comm);
+        ABTU_free(p_steal);
+        p_steal = NULL;
+        abt_errno = ABT_ERR_MPI;
+        goto fn_fail;
+    }
+    /* No other process accesses the window before the barrier. */
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, p_steal->rank, 0, p_steal->win);
+    p_base[0] = 0;
+    p_base[1] = 0;
+    MPI_Win_unlock(p_steal->rank, p_steal->win);
+    MPI_Barrier(p_steal->comm);
+
+    ABTI_spinlock_create(&p_steal->lock);
+    p_steal->seed = (unsigned int)p_steal->rank * 2654435761u + 1;
+    p_steal->next_steal_time = 0.0;
+    abt_errno = ABT_pool_create_remote(ABTI_mpi_steal_fn, p_steal, ABT_FALSE,
+                                       &p_steal->pool);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    *newsteal = (ABT_mpi_steal)p_steal;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (p_steal) {
+        MPI_Win_free(&p_steal->win);
+        MPI_Comm_free(&p_steal->comm);
+        ABTU_free(p_steal);
+    }
+    *newsteal = ABT_MPI_STEAL_NULL;
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MPI
+ * @brief   Free a queue of remote tasklets.
+ *
+ * \c ABT_mpi_steal_free() frees the queue \c steal and its pool.  This routine
+ * is collective over the communicator of \c steal.  The pool must not be used
+ * by any scheduler, and the descriptors left in the queues are discarded, so
+ * the processes should agree that all the work is done before they call it.
+ *
+ * @param[in,out] steal  handle to the queue
+ * @return Error code
+ * @retval ABT_SUCCESS  on success
+ */
+int ABT_mpi_steal_free(ABT_mpi_steal *steal)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mpi_steal *p_steal = (ABTI_mpi_steal *)*steal;
+    ABTI_CHECK_TRUE(p_steal != NULL, ABT_ERR_MPI);
+
+    abt_errno = ABT_pool_free(&p_steal->pool);
+    ABTI_CHECK_ERROR(abt_errno);
+    MPI_Win_free(&p_steal->win);
+    MPI_Comm_free(&p_steal->comm);
+    ABTI_spinlock_free(&p_steal->lock);
+    ABTU_free(p_steal);
+    *steal = ABT_MPI_STEAL_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MPI
+ * @brief   Push a remote tasklet into the queue of the calling process.
+ *
+ * \c ABT_mpi_steal_push() appends a copy of \c desc to the queue \c steal of
+ * the calling process, from which any process in the communicator can take
+ * it.  If the queue is full, the caller should run the tasklet by itself,
+ * e.g., by calling its function directly.
+ *
+ * @param[in] steal  handle to the queue
+ * @param[in] desc   descriptor of the tasklet
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_POOL_FULL  the queue is full
+ * @retval ABT_ERR_MPI        MPI has reported an error
+ */
+int ABT_mpi_steal_push(ABT_mpi_steal steal, const ABT_remote_desc *desc)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mpi_steal *p_steal = (ABTI_mpi_steal *)steal;
+    int64_t idx[2];
+    int ret;
+
+    ABTI_CHECK_TRUE(p_steal != NULL, ABT_ERR_MPI);
+    ABTI_CHECK_TRUE(desc != NULL && desc->size <= ABT_REMOTE_ARGS_SIZE,
+                    ABT_ERR_INV_REMOTE_DESC);
+
+    ABTI_spinlock_acquire(&p_steal->lock);
+    ret = MPI_Win_lock(MPI_LOCK_EXCLUSIVE, p_steal->rank, 0, p_steal->win);
+    if (ret == MPI_SUCCESS) {
+        ret = MPI_Get(idx, 2, MPI_INT64_T, p_steal->rank, ABTI_MPI_STEAL_HEAD,
+                      2, MPI_INT64_T, p_steal->win);
+        if (ret == MPI_SUCCESS) ret = MPI_Win_flush(p_steal->rank, p_steal->win);
+        if (ret == MPI_SUCCESS && idx[1] - idx[0] >= p_steal->capacity) {
+            abt_errno = ABT_ERR_POOL_FULL;
+        } else if (ret == MPI_SUCCESS) {
+            ret = MPI_Put(desc, sizeof(ABT_remote_desc), MPI_BYTE,
+                          p_steal->rank, ABTI_MPI_STEAL_DESC(p_steal, idx[1]),
+                          sizeof(ABT_remote_desc), MPI_BYTE, p_steal->win);
+            idx[1]++;
+            if (ret == MPI_SUCCESS) {
+                ret = MPI_Put(&idx[1], 1, MPI_INT64_T, p_steal->rank,
+                              ABTI_MPI_STEAL_TAIL, 1, MPI_INT64_T,
+                              p_steal->win);
+            }
+        }
+        if (MPI_Win_unlock(p_steal->rank, p_steal->win) != MPI_SUCCESS) {
+            ret = MPI_ERR_OTHER;
+        }
+    }
+    ABTI_spinlock_release(&p_steal->lock);
+    if (ret != MPI_SUCCESS) abt_errno = ABT_ERR_MPI;
+    /* A full queue is not an error of the library. */
+    if (abt_errno == ABT_ERR_POOL_FULL) goto fn_exit;
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MPI
+ * @brief   Get the pool of the tasklets shared by processes.
+ *
+ * \c ABT_mpi_steal_get_pool() returns the remote pool of \c steal through
+ * \c pool.  The pool is owned by \c steal and freed by
+ * \c ABT_mpi_steal_free().
+ *
+ * @param[in]  steal  handle to the queue
+ * @param[out] pool   handle to the pool
+ * @return Error code
+ * @retval ABT_SUCCESS  on success
+ */
+int ABT_mpi_steal_get_pool(ABT_mpi_steal steal, ABT_pool *pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mpi_steal *p_steal = (ABTI_mpi_steal *)steal;
+    ABTI_CHECK_TRUE(p_steal != NULL, ABT_ERR_MPI);
+
+    *pool = p_steal->pool;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MPI
+ * @brief   Create remote rings into which processes push tasklets.
+ *
+ * \c ABT_mpi_ring_create() creates a remote ring (see
+ * \c ABT_remote_ring_init()) of \c capacity slots in an MPI window over
+ * \c comm, and a pool that pops the tasklets pushed into the ring of the
+ * calling process.  Other processes ship tasklets to the process with
+ * \c ABT_mpi_ring_push(), and its schedulers pop them from the pool like
+ * local units, with no MPI call to receive them.  This routine is collective
+ * over \c comm, \c capacity must be the same in all the processes, and MPI
+ * must be initialized with \c MPI_THREAD_MULTIPLE.
+ *
+ * @param[in]  comm      MPI communicator
+ * @param[in]  capacity  number of slots of the ring
+ * @param[out] newring   handle to new rings
+ * @return Error code
+ * @retval ABT_SUCCESS  on success
+ * @retval ABT_ERR_MPI  \c capacity is not positive, MPI is not initialized
+ *                      with \c MPI_THREAD_MULTIPLE, or MPI has reported an
+ *                      error
+ */
+int ABT_mpi_ring_create(MPI_Comm comm, int capacity, ABT_mpi_ring *newring)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mpi_ring *p_ring = NULL;
+    size_t size;
+    int provided, rank;
+
+    ABTI_CHECK_TRUE(capacity > 0, ABT_ERR_MPI);
+    if (MPI_Query_thread(&provided) != MPI_SUCCESS ||
+        provided != MPI_THREAD_MULTIPLE) {
+        abt_errno = ABT_ERR_MPI;
+        goto fn_fail;
+    }
+
+    p_ring = (ABTI_mpi_ring *)ABTU_malloc(sizeof(ABTI_mpi_ring));
+    if (MPI_Comm_dup(comm, &p_ring->comm) != MPI_SUCCESS) {
+        ABTU_free(p_ring);
+        p_ring = NULL;
+        abt_errno = ABT_ERR_MPI;
+        goto fn_fail;
+    }
+    MPI_Comm_rank(p_ring->comm, &rank);
+    p_ring->capacity = capacity;
+    ABT_remote_ring_get_size(capacity, &size);
+    if (MPI_Win_allocate((MPI_Aint)size, 1, MPI_INFO_NULL, p_ring->comm,
+                         &p_ring->p_ring, &p_ring->win) != MPI_SUCCESS) {
+        MPI_Comm_free(&p_ring->comm);
+        ABTU_free(p_ring);
+        p_ring = NULL;
+        abt_errno = ABT_ERR_MPI;
+        goto fn_fail;
+    }
+    /* No other process accesses the window before the barrier. */
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank, 0, p_ring->win);
+    ABT_remote_ring_init(p_ring->p_ring, capacity);
+    MPI_Win_unlock(rank, p_ring->win);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, p_ring->win);
+    MPI_Barrier(p_ring->comm);
+
+    abt_errno = ABT_pool_create_remote(ABTI_mpi_ring_pop, p_ring, ABT_FALSE,
+                                       &p_ring->pool);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    *newring = (ABT_mpi_ring)p_ring;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (p_ring) {
+        MPI_Win_unlock_all(p_ring->win);
+        MPI_Win_free(&p_ring->win);
+        MPI_Comm_free(&p_ring->comm);
+        ABTU_free(p_ring);
+    }
+    *newring = ABT_MPI_RING_NULL;
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MPI
+ * @brief   Free remote rings.
+ *
+ * \c ABT_mpi_ring_free() frees the rings \c ring and the pool of the calling
+ * process.  This routine is collective over the communicator of \c ring.
+ * The pool must not be used by any scheduler, and the descriptors left in the
+ * rings are discarded.
+ *
+ * @param[in,out] ring  handle to the rings
+ * @return Error code
+ * @retval ABT_SUCCESS  on success
+ */
+int ABT_mpi_ring_free(ABT_mpi_ring *ring)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mpi_ring *p_ring = (ABTI_mpi_ring *)*ring;
+    ABTI_CHECK_TRUE(p_ring != NULL, ABT_ERR_MPI);
+
+    abt_errno = ABT_pool_free(&p_ring->pool);
+    ABTI_CHECK_ERROR(abt_errno);
+    MPI_Win_unlock_all(p_ring->win);
+    MPI_Win_free(&p_ring->win);
+    MPI_Comm_free(&p_ring->comm);
+    ABTU_free(p_ring);
+    *ring = ABT_MPI_RING_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MPI
+ * @brief   Push a tasklet into the ring of a process.
+ *
+ * \c ABT_mpi_ring_push() writes a copy of \c desc into the ring of the
+ * process \c rank in the communicator of \c ring with one-sided
+ * communication, following the protocol at \c ABT_remote_ring_header.  The
+ * tasklet runs on the process \c rank when its pool pops it.  If the ring is
+ * full, the caller may retry later or run the tasklet by itself.
+ *
+ * @param[in] ring  handle to the rings
+ * @param[in] rank  rank of the target process
+ * @param[in] desc  descriptor of the tasklet
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_POOL_FULL  the ring of \c rank is full
+ * @retval ABT_ERR_INV_REMOTE_DESC \c desc is invalid
+ * @retval ABT_ERR_MPI        MPI has reported an error
+ */
+int ABT_mpi_ring_push(ABT_mpi_ring ring, int rank, const ABT_remote_desc *desc)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mpi_ring *p_ring = (ABTI_mpi_ring *)ring;
+    MPI_Aint slot;
+    uint64_t head, tail, next, result;
+    int ret;
+
+    ABTI_CHECK_TRUE(p_ring != NULL, ABT_ERR_MPI);
+    ABTI_CHECK_TRUE(desc != NULL && desc->size <= ABT_REMOTE_ARGS_SIZE,
+                    ABT_ERR_INV_REMOTE_DESC);
+
+    /* Claim the slot of tail */
+    while (1) {
+        ret = MPI_Fetch_and_op(NULL, &head, MPI_UINT64_T, rank,
+                               offsetof(ABT_remote_ring_header, head),
+                               MPI_NO_OP, p_ring->win);
+        if (ret != MPI_SUCCESS) break;
+        ret = MPI_Fetch_and_op(NULL, &tail, MPI_UINT64_T, rank,
+                               offsetof(ABT_remote_ring_header, tail),
+                               MPI_NO_OP, p_ring->win);
+        if (ret != MPI_SUCCESS) break;
+        ret = MPI_Win_flush(rank, p_ring->win);
+        if (ret != MPI_SUCCESS) break;
+        /* A full ring is not an error of the library. */
+        if (tail - head >= (uint64_t)p_ring->capacity) {
+            return ABT_ERR_POOL_FULL;
+        }
+        next = tail + 1;
+        ret = MPI_Compare_and_swap(&next, &tail, &result, MPI_UINT64_T, rank,
+                                   offsetof(ABT_remote_ring_header, tail),
+                                   p_ring->win);
+        if (ret == MPI_SUCCESS) ret = MPI_Win_flush(rank, p_ring->win);
+        if (ret != MPI_SUCCESS || result == tail) break;
+    }
+
+    /* Write the descriptor, and then publish it by its sequence number */
+    slot = (MPI_Aint)(sizeof(ABT_remote_ring_header) +
+                      (tail % p_ring->capacity) * sizeof(ABT_remote_ring_slot));
+    if (ret == MPI_SUCCESS) {
+        ret = MPI_Put(desc, sizeof(ABT_remote_desc), MPI_BYTE, rank,
+                      slot + offsetof(ABT_remote_ring_slot, desc),
+                      sizeof(ABT_remote_desc), MPI_BYTE, p_ring->win);
+    }
+    if (ret == MPI_SUCCESS) ret = MPI_Win_flush(rank, p_ring->win);
+    if (ret == MPI_SUCCESS) {
+        ret = MPI_Accumulate(&next, 1, MPI_UINT64_T, rank,
+                             slot + offsetof(ABT_remote_ring_slot, seq), 1,
+                             MPI_UINT64_T, MPI_REPLACE, p_ring->win);
+    }
+    if (ret == MPI_SUCCESS) ret = MPI_Win_flush(rank, p_ring->win);
+    if (ret != MPI_SUCCESS) {
+        abt_errno = ABT_ERR_MPI;
+        goto fn_fail;
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MPI
+ * @brief   Get the pool of the tasklets pushed into the ring.
+ *
+ * \c ABT_mpi_ring_get_pool() returns through \c pool the pool of the
+ * tasklets pushed into the ring of the calling process.  The pool is owned by
+ * \c ring and freed by \c ABT_mpi_ring_free().
+ *
+ * @param[in]  ring  handle to the rings
+ * @param[out] pool  handle to the pool
+ * @return Error code
+ * @retval ABT_SUCCESS  on success
+ */
+int ABT_mpi_ring_get_pool(ABT_mpi_ring ring, ABT_pool *pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mpi_ring *p_ring = (ABTI_mpi_ring *)ring;
+    ABTI_CHECK_TRUE(p_ring != NULL, ABT_ERR_MPI);
+
+    *pool = p_ring->pool;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+#endif /* ABT_CONFIG_USE_MPI */
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* The arrays are allocated when a ULT on the ES waits for the first time. */
+void ABTI_mpi_poller_init(ABTI_mpi_poller *p_poller)
+{
+    p_poller->num_waiters = 0;
+#ifdef ABT_CONFIG_USE_MPI
+    p_poller->max_waiters = 0;
+    p_poller->requests = NULL;
+    p_poller->waiters = NULL;
+    p_poller->indices = NULL;
+    p_poller->statuses = NULL;
+#endif
+}
+
+/* MPI requests cannot be canceled in general, so the waiters left on an ES
+ * being freed are woken up when their requests complete. */
+void ABTI_mpi_poller_fini(ABTI_mpi_poller *p_poller)
+{
+#ifdef ABT_CONFIG_USE_MPI
+    while (p_poller->num_waiters > 0) {
+        ABTI_mpi_poller_progress(p_poller, ABT_TRUE);
+    }
+    if (p_poller->max_waiters > 0) {
+        ABTU_free(p_poller->requests);
+        ABTU_free(p_poller->waiters);
+        ABTU_free(p_poller->indices);
+        ABTU_free(p_poller->statuses);
+        p_poller->max_waiters = 0;
+    }
+#else
+    ABTI_UNUSED(p_poller);
+#endif
+}
+
+/* Wake up the waiters whose requests have completed.  Only the ES that owns
+ * p_poller may call this. */
+void ABTI_mpi_poller_poll(ABTI_mpi_poller *p_poller)
+{
+#ifdef ABT_CONFIG_USE_MPI
+    ABTI_mpi_poller_progress(p_poller, ABT_FALSE);
+#else
+    ABTI_UNUSED(p_poller);
+#endif
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+#ifdef ABT_CONFIG_USE_MPI
+/* Register the request of the calling ULT in the poller of its ES and suspend
+ * the ULT until the request completes. */
+static int ABTI_mpi_wait_thread(ABTI_thread *p_thread, MPI_Request *p_request,
+                                MPI_Status *p_status)
+{
+    ABTI_mpi_poller *p_poller = &ABTI_local_get_xstream()->mpi_poller;
+    ABTI_mpi_waiter waiter;
+    int idx;
+
+    if (p_poller->num_waiters == p_poller->max_waiters) {
+        ABTI_mpi_poller_grow(p_poller);
+    }
+    waiter.p_thread = p_thread;
+    waiter.request = *p_request;
+    waiter.error = ABT_ERR_MPI;
+
+    /* The poller does not run until this ULT is suspended since it is called
+     * by the scheduler of this ES. */
+    ABTI_thread_set_blocked(p_thread);
+    idx = p_poller->num_waiters++;
+    p_poller->requests[idx] = *p_request;
+    p_poller->waiters[idx] = &waiter;
+    ABTI_thread_suspend(p_thread);
+
+    *p_request = waiter.request;
+    if (p_status != MPI_STATUS_IGNORE) *p_status = waiter.status;
+    return waiter.error;
+}
+
+static void ABTI_mpi_poller_grow(ABTI_mpi_poller *p_poller)
+{
+    int n = p_poller->max_waiters ? p_poller->max_waiters * 2
+                                  : ABTI_MPI_POLLER_INIT_SIZE;
+    p_poller->requests = (MPI_Request *)ABTU_realloc(p_poller->requests,
+                                                     sizeof(MPI_Request) * n);
+    p_poller->waiters = (ABTI_mpi_waiter **)
+        ABTU_realloc(p_poller->waiters, sizeof(ABTI_mpi_waiter *) * n);
+    p_poller->indices = (int *)ABTU_realloc(p_poller->indices,
+                                            sizeof(int) * n);
+    p_poller->statuses = (MPI_Status *)ABTU_realloc(p_poller->statuses,
+                                                    sizeof(MPI_Status) * n);
+    p_poller->max_waiters = n;
+}
+
+/* Test all the requests with one MPI call, or wait until some of them
+ * complete if blocking is ABT_TRUE. */
+static void ABTI_mpi_poller_progress(ABTI_mpi_poller *p_poller,
+                                     ABT_bool blocking)
+{
+    int i, j, ret, outcount = 0;
+
+    if (blocking == ABT_TRUE) {
+        ret = MPI_Waitsome(p_poller->num_waiters, p_poller->requests,
+                           &outcount, p_poller->indices, p_poller->statuses);
+    } else {
+        ret = MPI_Testsome(p_poller->num_waiters, p_poller->requests,
+                           &outcount, p_poller->indices, p_poller->statuses);
+    }
+
+    if (ret != MPI_SUCCESS && ret != MPI_ERR_IN_STATUS) {
+        /* The requests are returned as they are, so the callers can handle
+         * them. */
+        for (i = 0; i < p_poller->num_waiters; i++) {
+            ABTI_mpi_poller_wake(p_poller, i, NULL, ABT_ERR_MPI);
+        }
+        p_poller->num_waiters = 0;
+        return;
+    }
+    /* Every request is active since MPI_Test() has been called. */
+    if (outcount == MPI_UNDEFINED || outcount == 0) return;
+
+    for (i = 0; i < outcount; i++) {
+        MPI_Status *p_status = &p_poller->statuses[i];
+        ABTI_mpi_poller_wake(p_poller, p_poller->indices[i], p_status,
+                             (ret == MPI_ERR_IN_STATUS &&
+                              p_status->MPI_ERROR != MPI_SUCCESS)
+                             ? ABT_ERR_MPI : ABT_SUCCESS);
+    }
+
+    /* Remove the completed requests while keeping the order of the others */
+    for (i = 0, j = 0; i < p_poller->num_waiters; i++) {
+        if (p_poller->waiters[i] == NULL) continue;
+        p_poller->requests[j] = p_poller->requests[i];
+        p_poller->waiters[j] = p_poller->waiters[i];
+        j++;
+    }
+    p_poller->num_waiters = j;
+}
+
+/* Resume the waiter of the request at idx and clear waiters[idx].  The waiter
+ * must not be touched once the ULT is made ready since it may return at any
+ * time. */
+static void ABTI_mpi_poller_wake(ABTI_mpi_poller *p_poller, int idx,
+                                 MPI_Status *p_status, int error)
+{
+    ABTI_mpi_waiter *p_waiter = p_poller->waiters[idx];
+
+    p_waiter->request = p_poller->requests[idx];
+    if (p_status) p_waiter->status = *p_status;
+    p_waiter->error = error;
+    p_poller->waiters[idx] = NULL;
+
+    ABTI_thread_set_ready(p_waiter->p_thread);
+}
+
+/* Steal function of the remote pool.  It may be called by any ES. */
+static ABT_bool ABTI_mpi_steal_fn(void *arg, ABT_remote_desc *desc)
+{
+    ABTI_mpi_steal *p_steal = (ABTI_mpi_steal *)arg;
+    double now;
+    int target;
+
+    if (ABTI_mpi_steal_from(p_steal, p_steal->rank, desc) == ABT_TRUE) {
+        return ABT_TRUE;
+    }
+    if (p_steal->size == 1) return ABT_FALSE;
+
+    /* The time and the seed are updated without a lock since they are only
+     * hints. */
+    now = ABT_get_wtime();
+    if (now < p_steal->next_steal_time) return ABT_FALSE;
+    target = rand_r(&p_steal->seed) % (p_steal->size - 1);
+    if (target >= p_steal->rank) target++;
+    if (ABTI_mpi_steal_from(p_steal, target, desc) == ABT_TRUE) {
+        return ABT_TRUE;
+    }
+    p_steal->next_steal_time = now + ABTI_MPI_STEAL_BACKOFF;
+    return ABT_FALSE;
+}
+
+/* Pop function of the pool of a ring.  The window memory is synchronized
+ * with the updates by other processes before it is read. */
+static ABT_bool ABTI_mpi_ring_pop(void *arg, ABT_remote_desc *desc)
+{
+    ABTI_mpi_ring *p_ring = (ABTI_mpi_ring *)arg;
+    MPI_Win_sync(p_ring->win);
+    return ABTI_remote_ring_pop(p_ring->p_ring, desc);
+}
+
+/* Take the descriptor at the head of the queue of target */
+static ABT_bool ABTI_mpi_steal_from(ABTI_mpi_steal *p_steal, int target,
+                                    ABT_remote_desc *desc)
+{
+    ABT_bool stolen = ABT_FALSE;
+    int64_t idx[2];
+    int ret;
+
+    ABTI_spinlock_acquire(&p_steal->lock);
+    ret = MPI_Win_lock(MPI_LOCK_EXCLUSIVE, target, 0, p_steal->win);
+    if (ret == MPI_SUCCESS) {
+        ret = MPI_Get(idx, 2, MPI_INT64_T, target, ABTI_MPI_STEAL_HEAD, 2,
+                      MPI_INT64_T, p_steal->win);
+        if (ret == MPI_SUCCESS) ret = MPI_Win_flush(target, p_steal->win);
+        if (ret == MPI_SUCCESS && idx[0] < idx[1]) {
+            ret = MPI_Get(desc, sizeof(ABT_remote_desc), MPI_BYTE, target,
+                          ABTI_MPI_STEAL_DESC(p_steal, idx[0]),
+                          sizeof(ABT_remote_desc), MPI_BYTE, p_steal->win);
+            idx[0]++;
+            if (ret == MPI_SUCCESS) {
+                ret = MPI_Put(&idx[0], 1, MPI_INT64_T, target,
+                              ABTI_MPI_STEAL_HEAD, 1, MPI_INT64_T,
+                              p_steal->win);
+            }
+            if (ret == MPI_SUCCESS) stolen = ABT_TRUE;
+        }
+        if (MPI_Win_unlock(target, p_steal->win) != MPI_SUCCESS) {
+            stolen = ABT_FALSE;
+        }
+    }
+    ABTI_spinlock_release(&p_steal->lock);
+    return stolen;
+}
+#endif /* ABT_CONFIG_USE_MPI */
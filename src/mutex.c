@@ -6,6 +6,17 @@
 #include "abti.h"
 #include "abti_thread_htable.h"
 
+static int ABTI_mutex_timedlock(ABTI_mutex *p_mutex, double deadline);
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+static ABT_bool ABTI_mutex_wait_timed(ABTI_mutex *p_mutex, uint32_t val,
+                                      double deadline);
+#endif
+static void ABTI_mutex_unlink_timed(ABTI_mutex *p_mutex, ABTI_unit *p_unit);
+static void ABTI_mutex_lock_pi(ABTI_mutex *p_mutex, ABT_bool low);
+static int ABTI_mutex_trylock_pi(ABTI_mutex *p_mutex);
+static void ABTI_mutex_spinlock_pi(ABTI_mutex *p_mutex);
+static int ABTI_mutex_timedlock_pi(ABTI_mutex *p_mutex, double deadline);
+static void ABTI_mutex_unlock_pi(ABTI_mutex *p_mutex, ABT_bool se);
 
 /** @defgroup MUTEX Mutex
  * Mutex is a synchronization method to support mutual exclusion between ULTs.
@@ -153,7 +164,7 @@ int ABT_mutex_lock(ABT_mutex mutex)
         /* recursive mutex */
         ABTI_unit *p_self = ABTI_self_get_unit();
         if (p_self != p_mutex->attr.p_owner) {
-            ABTI_mutex_lock(p_mutex);
+            ABTI_mutex_lock_pi(p_mutex, ABT_FALSE);
             p_mutex->attr.p_owner = p_self;
             ABTI_ASSERT(p_mutex->attr.nesting_cnt == 0);
         } else {
@@ -161,8 +172,8 @@ int ABT_mutex_lock(ABT_mutex mutex)
         }
 
     } else {
-        /* unknown attributes */
-        ABTI_mutex_lock(p_mutex);
+        /* other attributes */
+        ABTI_mutex_lock_pi(p_mutex, ABT_FALSE);
     }
 
   fn_exit:
@@ -173,6 +184,26 @@ int ABT_mutex_lock(ABT_mutex mutex)
     goto fn_exit;
 }
 
+/**
+ * @ingroup MUTEX
+ * @brief   Lock the mutex without error checking.
+ *
+ * \c ABT_mutex_lock_unchecked() is the same as \c ABT_mutex_lock() except
+ * that it does not check \c mutex.  A mutex with default attributes is
+ * locked inline; other mutexes take the path of \c ABT_mutex_lock().
+ *
+ * @param[in] mutex  handle to the mutex
+ */
+void ABT_mutex_lock_unchecked(ABT_mutex mutex)
+{
+    ABTI_mutex *p_mutex = (ABTI_mutex *)mutex;
+    if (p_mutex->attr.attrs == ABTI_MUTEX_ATTR_NONE) {
+        ABTI_mutex_lock(p_mutex);
+    } else {
+        ABT_mutex_lock(mutex);
+    }
+}
+
 static inline
 void ABTI_mutex_lock_low(ABTI_mutex *p_mutex)
 {
@@ -198,6 +229,10 @@ void ABTI_mutex_lock_low(ABTI_mutex *p_mutex)
     if (type == ABT_UNIT_TYPE_THREAD) {
         LOG_EVENT("%p: lock_low - try\n", p_mutex);
         int c;
+        ABT_bool adaptive = (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_ADAPTIVE)
+                          ? ABT_TRUE : ABT_FALSE;
+        ABT_bool contended = ABT_TRUE;
+        uint32_t num_parks = 0;
 
         /* If other ULTs associated with the same ES are waiting on the
          * low-mutex queue, we give the header ULT a chance to try to get
@@ -211,16 +246,22 @@ void ABTI_mutex_lock_low(ABTI_mutex *p_mutex)
             ABT_bool ret = ABTI_thread_htable_switch_low(p_queue, p_self, p_htable);
             if (ret == ABT_TRUE) {
                 /* This ULT became a waiter in the mutex queue */
+                num_parks++;
                 goto check_handover;
             }
         }
 
-        if ((c = ABTD_atomic_cas_uint32(&p_mutex->val, 0, 1)) != 0) {
+        c = ABTD_atomic_cas_uint32(&p_mutex->val, 0, 1);
+        if (c == 0) contended = ABT_FALSE;
+        if (contended == ABT_TRUE &&
+            (adaptive == ABT_FALSE ||
+             ABTI_mutex_spin_adaptive(p_mutex) == ABT_FALSE)) {
             if (c != 2) {
                 c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
             }
             while (c != 0) {
                 ABTI_mutex_wait_low(p_mutex, 2);
+                num_parks++;
 
   check_handover:
                 /* If the mutex has been handed over to the current ULT from
@@ -243,6 +284,9 @@ void ABTI_mutex_lock_low(ABTI_mutex *p_mutex)
                 c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
             }
         }
+        if (adaptive == ABT_TRUE) {
+            ABTI_mutex_acquired_adaptive(p_mutex, contended, num_parks);
+        }
         LOG_EVENT("%p: lock_low - acquired\n", p_mutex);
     } else {
         ABTI_mutex_spinlock(p_mutex);
@@ -284,7 +328,7 @@ int ABT_mutex_lock_low(ABT_mutex mutex)
         /* recursive mutex */
         ABTI_unit *p_self = ABTI_self_get_unit();
         if (p_self != p_mutex->attr.p_owner) {
-            ABTI_mutex_lock_low(p_mutex);
+            ABTI_mutex_lock_pi(p_mutex, ABT_TRUE);
             p_mutex->attr.p_owner = p_self;
             ABTI_ASSERT(p_mutex->attr.nesting_cnt == 0);
         } else {
@@ -292,8 +336,8 @@ int ABT_mutex_lock_low(ABT_mutex mutex)
         }
 
     } else {
-        /* unknown attributes */
-        ABTI_mutex_lock_low(p_mutex);
+        /* other attributes */
+        ABTI_mutex_lock_pi(p_mutex, ABT_TRUE);
     }
 
   fn_exit:
@@ -340,7 +384,7 @@ int ABT_mutex_trylock(ABT_mutex mutex)
         /* recursive mutex */
         ABTI_unit *p_self = ABTI_self_get_unit();
         if (p_self != p_mutex->attr.p_owner) {
-            abt_errno = ABTI_mutex_trylock(p_mutex);
+            abt_errno = ABTI_mutex_trylock_pi(p_mutex);
             if (abt_errno == ABT_SUCCESS) {
                 p_mutex->attr.p_owner = p_self;
                 ABTI_ASSERT(p_mutex->attr.nesting_cnt == 0);
@@ -351,8 +395,8 @@ int ABT_mutex_trylock(ABT_mutex mutex)
         }
 
     } else {
-        /* unknown attributes */
-        abt_errno = ABTI_mutex_trylock(p_mutex);
+        /* other attributes */
+        abt_errno = ABTI_mutex_trylock_pi(p_mutex);
     }
 
   fn_exit:
@@ -391,7 +435,7 @@ int ABT_mutex_spinlock(ABT_mutex mutex)
         /* recursive mutex */
         ABTI_unit *p_self = ABTI_self_get_unit();
         if (p_self != p_mutex->attr.p_owner) {
-            ABTI_mutex_spinlock(p_mutex);
+            ABTI_mutex_spinlock_pi(p_mutex);
             p_mutex->attr.p_owner = p_self;
             ABTI_ASSERT(p_mutex->attr.nesting_cnt == 0);
         } else {
@@ -399,8 +443,60 @@ int ABT_mutex_spinlock(ABT_mutex mutex)
         }
 
     } else {
-        /* unknown attributes */
-        ABTI_mutex_spinlock(p_mutex);
+        /* other attributes */
+        ABTI_mutex_spinlock_pi(p_mutex);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MUTEX
+ * @brief   Lock the mutex with a timeout.
+ *
+ * \c ABT_mutex_timedlock() locks the mutex \c mutex like \c ABT_mutex_lock()
+ * but gives up if the mutex cannot be locked before the absolute time
+ * \c abstime, which is measured by the same clock as
+ * \c ABT_cond_timedwait().  In that case, \c ABT_ERR_TIMEDOUT is returned and
+ * the caller does not own the mutex.
+ *
+ * A ULT waiting for the mutex is blocked, and it is woken up by the scheduler
+ * of its ES when the deadline passes.  The deadline is therefore checked only
+ * when the scheduler checks events, so the ULT may wake up somewhat later than
+ * \c abstime.  External threads and tasklets spin until the deadline.
+ *
+ * @param[in] mutex    handle to the mutex
+ * @param[in] abstime  absolute time for timeout
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_TIMEDOUT the deadline has passed
+ */
+int ABT_mutex_timedlock(ABT_mutex mutex, const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mutex *p_mutex = ABTI_mutex_get_ptr(mutex);
+    ABTI_CHECK_NULL_MUTEX_PTR(p_mutex);
+    double deadline = ABTI_timeout_convert(abstime);
+
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_RECURSIVE) {
+        /* recursive mutex */
+        ABTI_unit *p_self = ABTI_self_get_unit();
+        if (p_self != p_mutex->attr.p_owner) {
+            abt_errno = ABTI_mutex_timedlock_pi(p_mutex, deadline);
+            if (abt_errno == ABT_SUCCESS) {
+                p_mutex->attr.p_owner = p_self;
+                ABTI_ASSERT(p_mutex->attr.nesting_cnt == 0);
+            }
+        } else {
+            p_mutex->attr.nesting_cnt++;
+        }
+    } else {
+        abt_errno = ABTI_mutex_timedlock_pi(p_mutex, deadline);
     }
 
   fn_exit:
@@ -439,14 +535,14 @@ int ABT_mutex_unlock(ABT_mutex mutex)
         ABTI_CHECK_TRUE(p_self == p_mutex->attr.p_owner, ABT_ERR_INV_THREAD);
         if (p_mutex->attr.nesting_cnt == 0) {
             p_mutex->attr.p_owner = NULL;
-            ABTI_mutex_unlock(p_mutex);
+            ABTI_mutex_unlock_pi(p_mutex, ABT_FALSE);
         } else {
             p_mutex->attr.nesting_cnt--;
         }
 
     } else {
-        /* unknown attributes */
-        ABTI_mutex_unlock(p_mutex);
+        /* other attributes */
+        ABTI_mutex_unlock_pi(p_mutex, ABT_FALSE);
     }
 
   fn_exit:
@@ -457,12 +553,36 @@ int ABT_mutex_unlock(ABT_mutex mutex)
     goto fn_exit;
 }
 
+/**
+ * @ingroup MUTEX
+ * @brief   Unlock the mutex without error checking.
+ *
+ * \c ABT_mutex_unlock_unchecked() is the same as \c ABT_mutex_unlock() except
+ * that it does not check \c mutex.  A mutex with default attributes is
+ * unlocked inline; other mutexes take the path of \c ABT_mutex_unlock().
+ *
+ * @param[in] mutex  handle to the mutex
+ */
+void ABT_mutex_unlock_unchecked(ABT_mutex mutex)
+{
+    ABTI_mutex *p_mutex = (ABTI_mutex *)mutex;
+    if (p_mutex->attr.attrs == ABTI_MUTEX_ATTR_NONE) {
+        ABTI_mutex_unlock(p_mutex);
+    } else {
+        ABT_mutex_unlock(mutex);
+    }
+}
+
 /* Hand over the mutex to other ULT on the same ES */
 static inline
 int ABTI_mutex_unlock_se(ABTI_mutex *p_mutex)
 {
     int abt_errno = ABT_SUCCESS;
 
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_ADAPTIVE) {
+        ABTI_mutex_release_adaptive(p_mutex);
+    }
+
 #ifdef ABT_CONFIG_USE_SIMPLE_MUTEX
     ABTD_atomic_mem_barrier();
     *(volatile uint32_t *)&p_mutex->val = 0;
@@ -549,6 +669,9 @@ int ABTI_mutex_unlock_se(ABTI_mutex *p_mutex)
     ABTI_pool_dec_num_blocked(p_next->p_pool);
     ABTI_local_set_thread(p_next);
     p_next->state = ABT_THREAD_STATE_RUNNING;
+    ABTI_trace_thread(ABTI_TRACE_RUN, p_next);
+    ABTI_local_get_xstream()->stats.num_switches++;
+    ABTI_cpu_time_stop_thread(ABTI_local_get_xstream(), p_thread);
     ABTD_thread_context_switch(&p_thread->ctx, &p_next->ctx);
 #endif
 
@@ -588,14 +711,14 @@ int ABT_mutex_unlock_se(ABT_mutex mutex)
         ABTI_CHECK_TRUE(p_self == p_mutex->attr.p_owner, ABT_ERR_INV_THREAD);
         if (p_mutex->attr.nesting_cnt == 0) {
             p_mutex->attr.p_owner = NULL;
-            ABTI_mutex_unlock_se(p_mutex);
+            ABTI_mutex_unlock_pi(p_mutex, ABT_TRUE);
         } else {
             p_mutex->attr.nesting_cnt--;
         }
 
     } else {
-        /* unknown attributes */
-        ABTI_mutex_unlock_se(p_mutex);
+        /* other attributes */
+        ABTI_mutex_unlock_pi(p_mutex, ABT_TRUE);
     }
 
   fn_exit:
@@ -612,7 +735,43 @@ int ABT_mutex_unlock_de(ABT_mutex mutex)
     ABTI_mutex *p_mutex = ABTI_mutex_get_ptr(mutex);
     ABTI_CHECK_NULL_MUTEX_PTR(p_mutex);
 
-    ABTI_mutex_unlock(p_mutex);
+    ABTI_mutex_unlock_pi(p_mutex, ABT_FALSE);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MUTEX
+ * @brief   Get the contention statistics of the mutex.
+ *
+ * \c ABT_mutex_get_stats() returns the statistics of the mutex \c mutex
+ * through \c stats.  The statistics are collected only for adaptive mutexes
+ * (see \c ABT_mutex_attr_set_adaptive()); other mutexes report zeros.
+ * Acquisitions by \c ABT_mutex_spinlock() and \c ABT_mutex_timedlock() are
+ * not counted.  The values are updated by the holders of the mutex without
+ * synchronization, so they are exact only when the mutex is not in use.
+ *
+ * @param[in]  mutex  handle to the mutex
+ * @param[out] stats  statistics of the mutex
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_mutex_get_stats(ABT_mutex mutex, ABT_mutex_stats *stats)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mutex *p_mutex = ABTI_mutex_get_ptr(mutex);
+    ABTI_CHECK_NULL_MUTEX_PTR(p_mutex);
+
+    stats->num_locks = p_mutex->num_locks;
+    stats->num_contended = p_mutex->num_contended;
+    stats->num_spins = p_mutex->num_spins;
+    stats->num_parks = p_mutex->num_parks;
+    stats->avg_hold_time = p_mutex->avg_hold_time;
 
   fn_exit:
     return abt_errno;
@@ -656,7 +815,13 @@ void ABTI_mutex_wait(ABTI_mutex *p_mutex, int val)
     ABTI_ASSERT(rank < p_htable->num_rows);
     ABTI_thread_queue *p_queue = &p_htable->queue[rank];
 
-#if 0
+    ABTI_thread_set_wait_obj(p_self, p_mutex, ABTI_mutex_unlink_waiter);
+
+    /* If ULTs of this ES are already waiting, join them under the lock of
+     * the row only.  p_mutex->val does not have to be checked because the
+     * ULT at the head will be woken up and lock the mutex with val of 2, so
+     * its unlock wakes up the next waiter.  Only a ULT that finds the row
+     * empty takes the table lock to check val and link the row. */
     if (p_queue->num_threads > 0) {
         /* Push the current ULT to the queue */
         if (ABTI_thread_htable_add(p_htable, rank, p_self) == ABT_TRUE) {
@@ -664,21 +829,22 @@ void ABTI_mutex_wait(ABTI_mutex *p_mutex, int val)
             if (p_queue->p_h_next == NULL) {
                 ABTI_THREAD_HTABLE_LOCK(p_htable->mutex);
                 ABTI_thread_htable_add_h_node(p_htable, p_queue);
-                ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);return;
+                ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
             }
 
             /* Suspend the current ULT */
             ABTI_thread_suspend(p_self);
+            ABTI_thread_unset_wait_obj(p_self);
 
             return;
         }
     }
-#endif
 
     ABTI_THREAD_HTABLE_LOCK(p_htable->mutex);
 
     if (p_mutex->val != val) {
         ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
+        ABTI_thread_unset_wait_obj(p_self);
         return;
     }
 
@@ -697,6 +863,7 @@ void ABTI_mutex_wait(ABTI_mutex *p_mutex, int val)
 
     /* Suspend the current ULT */
     ABTI_thread_suspend(p_self);
+    ABTI_thread_unset_wait_obj(p_self);
 }
 
 void ABTI_mutex_wait_low(ABTI_mutex *p_mutex, int val)
@@ -709,7 +876,9 @@ void ABTI_mutex_wait_low(ABTI_mutex *p_mutex, int val)
     ABTI_ASSERT(rank < p_htable->num_rows);
     ABTI_thread_queue *p_queue = &p_htable->queue[rank];
 
-#if 0
+    ABTI_thread_set_wait_obj(p_self, p_mutex, ABTI_mutex_unlink_waiter);
+
+    /* Same as the high-priority queue in ABTI_mutex_wait() */
     if (p_queue->low_num_threads > 0) {
         /* Push the current ULT to the queue */
         if (ABTI_thread_htable_add_low(p_htable, rank, p_self) == ABT_TRUE) {
@@ -722,16 +891,17 @@ void ABTI_mutex_wait_low(ABTI_mutex *p_mutex, int val)
 
             /* Suspend the current ULT */
             ABTI_thread_suspend(p_self);
+            ABTI_thread_unset_wait_obj(p_self);
 
             return;
         }
     }
-#endif
 
     ABTI_THREAD_HTABLE_LOCK(p_htable->mutex);
 
     if (p_mutex->val != val) {
         ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
+        ABTI_thread_unset_wait_obj(p_self);
         return;
     }
 
@@ -750,12 +920,246 @@ void ABTI_mutex_wait_low(ABTI_mutex *p_mutex, int val)
 
     /* Suspend the current ULT */
     ABTI_thread_suspend(p_self);
+    ABTI_thread_unset_wait_obj(p_self);
+}
+
+static int ABTI_mutex_timedlock(ABTI_mutex *p_mutex, double deadline)
+{
+    uint32_t c;
+
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    if (lp_ABTI_local == NULL || ABTI_local_get_task() == NULL) {
+        /* ULTs and external threads wait in the timed queue. */
+        if ((c = ABTD_atomic_cas_uint32(&p_mutex->val, 0, 1)) == 0) {
+            return ABT_SUCCESS;
+        }
+        if (c != 2) {
+            c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
+        }
+        while (c != 0) {
+            if (ABTI_timeout_get_time() >= deadline ||
+                ABTI_mutex_wait_timed(p_mutex, 2, deadline) == ABT_FALSE) {
+                return ABT_ERR_TIMEDOUT;
+            }
+            c = ABTD_atomic_exchange_uint32(&p_mutex->val, 2);
+        }
+        return ABT_SUCCESS;
+    }
+#endif
+
+    /* Tasklets cannot be blocked. */
+    while ((c = ABTD_atomic_cas_uint32(&p_mutex->val, 0, 1)) != 0) {
+        if (ABTI_timeout_get_time() >= deadline) return ABT_ERR_TIMEDOUT;
+#ifdef ABT_CONFIG_USE_SIMPLE_MUTEX
+        if (lp_ABTI_local != NULL && ABTI_local_get_thread() != NULL) {
+            ABT_thread_yield();
+            continue;
+        }
+#endif
+        ABTD_atomic_pause();
+    }
+    return ABT_SUCCESS;
+}
+
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+/* Wait in the timed queue while p_mutex->val is val.  Returns ABT_FALSE if the
+ * deadline has passed. */
+static ABT_bool ABTI_mutex_wait_timed(ABTI_mutex *p_mutex, uint32_t val,
+                                      double deadline)
+{
+    ABTI_thread_htable *p_htable = p_mutex->p_htable;
+    ABTI_timeout timeout;
+    ABTI_unit unit;
+
+    ABTI_THREAD_HTABLE_LOCK(p_htable->mutex);
+
+    if (p_mutex->val != val) {
+        ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
+        return ABT_TRUE;
+    }
+
+    ABTI_timeout_prepare(&timeout, deadline);
+    unit.pool = (ABT_pool)&timeout;
+    unit.type = ABTI_UNIT_TYPE_TIMED;
+    unit.p_next = NULL;
+    unit.p_prev = p_mutex->p_timed_tail;
+    if (p_mutex->p_timed_tail) {
+        p_mutex->p_timed_tail->p_next = &unit;
+    } else {
+        p_mutex->p_timed_head = &unit;
+    }
+    p_mutex->p_timed_tail = &unit;
+
+    ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
+
+    if (ABTI_timeout_wait(&timeout) == ABT_TRUE) return ABT_TRUE;
+
+    /* Leave the queue unless an unlocker has already taken this waiter */
+    ABTI_THREAD_HTABLE_LOCK(p_htable->mutex);
+    if (unit.p_prev != NULL || p_mutex->p_timed_head == &unit) {
+        ABTI_mutex_unlink_timed(p_mutex, &unit);
+    }
+    ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
+    return ABT_FALSE;
+}
+#endif
+
+/* The caller has to hold the lock of p_mutex->p_htable. */
+static void ABTI_mutex_unlink_timed(ABTI_mutex *p_mutex, ABTI_unit *p_unit)
+{
+    if (p_unit->p_prev) {
+        p_unit->p_prev->p_next = p_unit->p_next;
+    } else {
+        p_mutex->p_timed_head = p_unit->p_next;
+    }
+    if (p_unit->p_next) {
+        p_unit->p_next->p_prev = p_unit->p_prev;
+    } else {
+        p_mutex->p_timed_tail = p_unit->p_prev;
+    }
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+}
+
+/* Priority inheritance.  A ULT that has to wait for a mutex with the
+ * priority-inheritance attribute raises the priority of the ULT holding it to
+ * its own if it is higher.  A holder waiting in an ABT_POOL_PRIO pool is moved
+ * to the level of the new priority, so it is not stuck behind units of its
+ * old priority.  The holder gets back its priority when it unlocks the mutex.
+ * Only the holder found by a waiter when it starts to wait is boosted, and the
+ * boost is not propagated to the holders of other mutexes. */
+static void ABTI_mutex_pi_set_priority(ABTI_thread *p_thread, int priority)
+{
+    ABTI_pool *p_pool = p_thread->p_pool;
+    if (p_pool && ABTI_pool_is_prio(p_pool) == ABT_TRUE) {
+        ABTI_pool_prio_set_priority(p_pool, p_thread, priority);
+    } else {
+        p_thread->attr.priority = priority;
+    }
+}
+
+static void ABTI_mutex_pi_boost(ABTI_mutex *p_mutex)
+{
+    ABTI_thread *p_self, *p_owner;
+
+    if (lp_ABTI_local == NULL) return;
+    p_self = ABTI_local_get_thread();
+    if (p_self == NULL) return;
+
+    ABTI_spinlock_acquire(&p_mutex->pi_lock);
+    p_owner = p_mutex->p_pi_owner;
+    if (p_owner && p_owner->attr.priority < p_self->attr.priority) {
+        LOG_EVENT("%p: boost U%" PRIu64 " to %d\n", p_mutex,
+                  ABTI_thread_get_id(p_owner), p_self->attr.priority);
+        ABTI_mutex_pi_set_priority(p_owner, p_self->attr.priority);
+    }
+    ABTI_spinlock_release(&p_mutex->pi_lock);
+}
+
+static void ABTI_mutex_pi_acquired(ABTI_mutex *p_mutex)
+{
+    ABTI_thread *p_self = lp_ABTI_local ? ABTI_local_get_thread() : NULL;
+
+    ABTI_spinlock_acquire(&p_mutex->pi_lock);
+    p_mutex->p_pi_owner = p_self;
+    if (p_self) p_mutex->pi_priority = p_self->attr.priority;
+    ABTI_spinlock_release(&p_mutex->pi_lock);
+}
+
+static void ABTI_mutex_pi_release(ABTI_mutex *p_mutex)
+{
+    ABTI_thread *p_owner;
+
+    ABTI_spinlock_acquire(&p_mutex->pi_lock);
+    p_owner = p_mutex->p_pi_owner;
+    p_mutex->p_pi_owner = NULL;
+    /* The owner is running, so it is not in any pool. */
+    if (p_owner) p_owner->attr.priority = p_mutex->pi_priority;
+    ABTI_spinlock_release(&p_mutex->pi_lock);
+}
+
+static void ABTI_mutex_lock_pi(ABTI_mutex *p_mutex, ABT_bool low)
+{
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_PRIO_INHERIT) {
+        if (ABTI_mutex_trylock(p_mutex) == ABT_SUCCESS) {
+            ABTI_mutex_pi_acquired(p_mutex);
+            return;
+        }
+        ABTI_mutex_pi_boost(p_mutex);
+    }
+    if (low == ABT_TRUE) {
+        ABTI_mutex_lock_low(p_mutex);
+    } else {
+        ABTI_mutex_lock(p_mutex);
+    }
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_PRIO_INHERIT) {
+        ABTI_mutex_pi_acquired(p_mutex);
+    }
+}
+
+static int ABTI_mutex_trylock_pi(ABTI_mutex *p_mutex)
+{
+    int abt_errno = ABTI_mutex_trylock(p_mutex);
+    if (abt_errno == ABT_SUCCESS &&
+        (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_PRIO_INHERIT)) {
+        ABTI_mutex_pi_acquired(p_mutex);
+    }
+    return abt_errno;
+}
+
+static void ABTI_mutex_spinlock_pi(ABTI_mutex *p_mutex)
+{
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_PRIO_INHERIT) {
+        if (ABTI_mutex_trylock(p_mutex) != ABT_SUCCESS) {
+            ABTI_mutex_pi_boost(p_mutex);
+            ABTI_mutex_spinlock(p_mutex);
+        }
+        ABTI_mutex_pi_acquired(p_mutex);
+    } else {
+        ABTI_mutex_spinlock(p_mutex);
+    }
+}
+
+static int ABTI_mutex_timedlock_pi(ABTI_mutex *p_mutex, double deadline)
+{
+    int abt_errno;
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_PRIO_INHERIT) {
+        if (ABTI_mutex_trylock(p_mutex) != ABT_SUCCESS) {
+            ABTI_mutex_pi_boost(p_mutex);
+            abt_errno = ABTI_mutex_timedlock(p_mutex, deadline);
+            if (abt_errno != ABT_SUCCESS) return abt_errno;
+        }
+        ABTI_mutex_pi_acquired(p_mutex);
+        return ABT_SUCCESS;
+    }
+    return ABTI_mutex_timedlock(p_mutex, deadline);
+}
+
+static void ABTI_mutex_unlock_pi(ABTI_mutex *p_mutex, ABT_bool se)
+{
+    if (p_mutex->attr.attrs & ABTI_MUTEX_ATTR_PRIO_INHERIT) {
+        ABTI_mutex_pi_release(p_mutex);
+    }
+    if (se == ABT_TRUE) {
+        ABTI_mutex_unlock_se(p_mutex);
+    } else {
+        ABTI_mutex_unlock(p_mutex);
+    }
+}
+
+/* Called by ABT_thread_cancel() to remove p_thread waiting in
+ * ABTI_mutex_wait() or ABTI_mutex_wait_low() */
+ABT_bool ABTI_mutex_unlink_waiter(void *p_obj, ABTI_thread *p_thread)
+{
+    ABTI_mutex *p_mutex = (ABTI_mutex *)p_obj;
+    return ABTI_thread_htable_remove(p_mutex->p_htable, p_thread);
 }
 
 void ABTI_mutex_wake_de(ABTI_mutex *p_mutex)
 {
     int n;
     ABTI_thread *p_thread;
+    ABT_bool signaled;
     ABTI_thread_htable *p_htable = p_mutex->p_htable;
     int num = p_mutex->attr.max_wakeups;
     ABTI_thread_queue *p_start, *p_curr;
@@ -766,11 +1170,25 @@ void ABTI_mutex_wake_de(ABTI_mutex *p_mutex)
 
         ABTI_THREAD_HTABLE_LOCK(p_htable->mutex);
 
-        if (p_htable->num_elems == 0) {
+        if (p_htable->num_elems == 0 && p_mutex->p_timed_head == NULL) {
             ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
             break;
         }
 
+        /* Wake up the timed waiters first since they have deadlines.  Those
+         * that have timed out are just removed. */
+        signaled = ABT_FALSE;
+        while (p_mutex->p_timed_head && signaled == ABT_FALSE) {
+            ABTI_unit *p_unit = p_mutex->p_timed_head;
+            ABTI_mutex_unlink_timed(p_mutex, p_unit);
+            signaled = ABTI_timeout_signal((ABTI_timeout *)p_unit->pool);
+        }
+        if (signaled == ABT_TRUE) {
+            ABTI_THREAD_HTABLE_UNLOCK(p_htable->mutex);
+            LOG_EVENT("%p: wake up a timed waiter\n", p_mutex);
+            continue;
+        }
+
         /* Wake up the high-priority ULTs */
         p_start = p_htable->h_list;
         for (p_curr = p_start; p_curr; ) {
@@ -111,6 +111,88 @@ int ABT_mutex_attr_set_recursive(ABT_mutex_attr attr, ABT_bool recursive)
     goto fn_exit;
 }
 
+/**
+ * @ingroup MUTEX_ATTR
+ * @brief   Set the adaptive property in the attribute object.
+ *
+ * \c ABT_mutex_attr_set_adaptive() sets the adaptive property in the
+ * attribute object associated with handle \c attr.  An adaptive mutex
+ * measures the time for which each holder keeps it.  When a ULT finds the
+ * mutex locked and the average hold time is short, the ULT spins for about
+ * twice the average hold time before it is blocked, unless the holder is
+ * running on the same ES.  When holders are slow, the ULT is blocked
+ * immediately.  An adaptive mutex also collects contention statistics, which
+ * can be read by \c ABT_mutex_get_stats().
+ *
+ * The adaptive property has no effect on spinning if Argobots is configured
+ * with the simple mutex, although the statistics are still collected.
+ *
+ * @param[in] attr      handle to the target attribute object
+ * @param[in] adaptive  boolean value for the adaptive mode
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_mutex_attr_set_adaptive(ABT_mutex_attr attr, ABT_bool adaptive)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mutex_attr *p_attr = ABTI_mutex_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_MUTEX_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    if (adaptive == ABT_TRUE) {
+        ABTD_atomic_fetch_or_uint32(&p_attr->attrs, ABTI_MUTEX_ATTR_ADAPTIVE);
+    } else {
+        ABTD_atomic_fetch_and_uint32(&p_attr->attrs, ~ABTI_MUTEX_ATTR_ADAPTIVE);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup MUTEX_ATTR
+ * @brief   Set the priority-inheritance property in the attribute object.
+ *
+ * \c ABT_mutex_attr_set_prio_inherit() sets the priority-inheritance property
+ * in the attribute object associated with handle \c attr.  When a ULT has to
+ * wait for a mutex with this property and the ULT holding the mutex has a
+ * lower priority (see \c ABT_thread_attr_set_priority()), the holder
+ * temporarily gets the priority of the waiter.  If the holder is waiting in a
+ * pool created with \c ABT_POOL_PRIO, it is moved ahead of the units of its
+ * old priority.  The holder gets back its priority when it unlocks the mutex.
+ *
+ * @param[in] attr          handle to the target attribute object
+ * @param[in] prio_inherit  boolean value for priority inheritance
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_mutex_attr_set_prio_inherit(ABT_mutex_attr attr, ABT_bool prio_inherit)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_mutex_attr *p_attr = ABTI_mutex_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_MUTEX_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    if (prio_inherit == ABT_TRUE) {
+        ABTD_atomic_fetch_or_uint32(&p_attr->attrs,
+                                    ABTI_MUTEX_ATTR_PRIO_INHERIT);
+    } else {
+        ABTD_atomic_fetch_and_uint32(&p_attr->attrs,
+                                     ~ABTI_MUTEX_ATTR_PRIO_INHERIT);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 
 /*****************************************************************************/
 /* Private APIs                                                              */
@@ -0,0 +1,285 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#if defined(HAVE_MAP_ANONYMOUS) || defined(HAVE_MAP_ANON)
+#include <sys/mman.h>
+#if defined(HAVE_MAP_ANONYMOUS)
+#define ABTI_NUMA_MAP_FLAGS     (MAP_PRIVATE | MAP_ANONYMOUS)
+#else
+#define ABTI_NUMA_MAP_FLAGS     (MAP_PRIVATE | MAP_ANON)
+#endif
+#define ABTI_NUMA_USE_MMAP
+#endif
+
+/* A first touch divides the pages of a range among ESs.  Each ES gets one
+ * tasklet in its first main pool, which asks the OS to place the pages of the
+ * ES on the NUMA node of the ES and then writes to each of them.  Since the
+ * node is set explicitly, the pages land there even if the tasklet is stolen
+ * by another ES. */
+
+typedef struct {
+    char *p_base;               /* Start of the first page */
+    char *p_lo;                 /* Start of the range */
+    char *p_hi;                 /* End of the range */
+    size_t page_size;
+    size_t num_pages;
+    int num_parts;
+    int policy;
+    uint64_t num_remains;       /* Parts not touched yet */
+    ABT_eventual eventual;      /* Set when all the parts are touched */
+} ABTI_ptouch;
+
+typedef struct {
+    ABTI_ptouch *p_ptouch;
+    int index;                  /* Index of the part */
+    int node;                   /* NUMA node of the ES, or -1 */
+} ABTI_ptouch_part;
+
+static void ABTI_ptouch_run(void *arg);
+static void ABTI_ptouch_pages(ABTI_ptouch *p_ptouch, size_t first,
+                              size_t num_pages, int node);
+
+
+/** @defgroup NUMA NUMA
+ * This group is for memory whose pages are placed on the NUMA nodes of the
+ * ESs that compute on them.
+ */
+
+/**
+ * @ingroup NUMA
+ * @brief   Allocate memory whose pages are not placed yet.
+ *
+ * \c ABT_numa_alloc() allocates \c size bytes of zero-filled memory aligned
+ * to the OS page size and returns its address through \c ptr.  The pages are
+ * not touched, so each of them is placed on a NUMA node when it is written
+ * first, e.g., by \c ABT_parallel_first_touch().  If \c size is zero, \c ptr
+ * is set to \c NULL.  The memory has to be freed by \c ABT_numa_free().
+ *
+ * @param[in]  size  the size of the memory in bytes
+ * @param[out] ptr   address of the memory
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_MEM if the memory cannot be allocated
+ */
+int ABT_numa_alloc(size_t size, void **ptr)
+{
+    int abt_errno = ABT_SUCCESS;
+    void *p_mem;
+
+    ABTI_CHECK_INITIALIZED();
+    if (size == 0) {
+        *ptr = NULL;
+        goto fn_exit;
+    }
+
+#ifdef ABTI_NUMA_USE_MMAP
+    p_mem = mmap(NULL, size, PROT_READ | PROT_WRITE, ABTI_NUMA_MAP_FLAGS,
+                 -1, 0);
+    ABTI_CHECK_TRUE(p_mem != MAP_FAILED, ABT_ERR_MEM);
+#else
+    p_mem = ABTU_memalign(gp_ABTI_global->os_page_size, size);
+    ABTI_CHECK_TRUE(p_mem != NULL, ABT_ERR_MEM);
+    memset(p_mem, 0, size);
+#endif
+    *ptr = p_mem;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup NUMA
+ * @brief   Free memory allocated by \c ABT_numa_alloc().
+ *
+ * @param[in] ptr   address returned by \c ABT_numa_alloc()
+ * @param[in] size  the size given to \c ABT_numa_alloc()
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_numa_free(void *ptr, size_t size)
+{
+    if (ptr == NULL) return ABT_SUCCESS;
+#ifdef ABTI_NUMA_USE_MMAP
+    munmap(ptr, size);
+#else
+    ABTI_UNUSED(size);
+    ABTU_free(ptr);
+#endif
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup NUMA
+ * @brief   Place the pages of memory on the NUMA nodes of ESs.
+ *
+ * \c ABT_parallel_first_touch() divides the pages of [\c ptr,
+ * \c ptr + \c len) among the \c num_xstreams ESs in \c xstreams and places
+ * the pages of each ES on the NUMA node of the CPU that the ES is bound to
+ * (see \c ABT_SET_AFFINITY).  With \c ABT_FIRST_TOUCH_BLOCK, the ESs get
+ * contiguous blocks of pages in order, which matches the division of
+ * \c ABT_parallel_for() when the main pools of the same ESs are given.  With
+ * \c ABT_FIRST_TOUCH_CYCLIC, page \c i goes to <tt>xstreams[i %
+ * num_xstreams]</tt>.
+ *
+ * The pages are touched by one tasklet per ES, which is pushed into the first
+ * main pool of the ES.  Each byte in the range that is written is written
+ * with the value it holds, so the contents are not changed, but the range
+ * must not be accessed by others during this call.  Pages that have already
+ * been touched are not moved.  If an ES is not bound to a single CPU, its
+ * pages are placed by the OS on the node of the CPU that touches them.
+ *
+ * This routine has to be called by a ULT or an external thread, which is
+ * blocked until all the pages are touched.
+ *
+ * @param[in] num_xstreams  the number of ESs in \c xstreams
+ * @param[in] xstreams      ESs that compute on the memory
+ * @param[in] ptr           start of the memory
+ * @param[in] len           the size of the memory in bytes
+ * @param[in] policy        \c ABT_FIRST_TOUCH_BLOCK or
+ *                          \c ABT_FIRST_TOUCH_CYCLIC
+ * @return Error code
+ * @retval ABT_SUCCESS         on success
+ * @retval ABT_ERR_INV_XSTREAM invalid ES
+ * @retval ABT_ERR_INV_TASK    the caller is a tasklet
+ * @retval ABT_ERR_OTHER       \c policy is invalid
+ */
+int ABT_parallel_first_touch(int num_xstreams, ABT_xstream *xstreams,
+                             void *ptr, size_t len, int policy)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_ptouch *p_ptouch;
+    size_t page_size;
+    uintptr_t lo, hi, base;
+    int i;
+
+    /* A tasklet cannot wait for the pages. */
+    ABTI_CHECK_TRUE(lp_ABTI_local == NULL || ABTI_local_get_task() == NULL,
+                    ABT_ERR_INV_TASK);
+    ABTI_CHECK_TRUE(num_xstreams > 0, ABT_ERR_INV_XSTREAM);
+    ABTI_CHECK_TRUE(policy == ABT_FIRST_TOUCH_BLOCK ||
+                    policy == ABT_FIRST_TOUCH_CYCLIC, ABT_ERR_OTHER);
+    for (i = 0; i < num_xstreams; i++) {
+        ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstreams[i]);
+        ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+    }
+    if (ptr == NULL || len == 0) goto fn_exit;
+
+    page_size = gp_ABTI_global->os_page_size;
+    lo = (uintptr_t)ptr;
+    hi = lo + len;
+    base = lo - lo % page_size;
+
+    p_ptouch = (ABTI_ptouch *)ABTU_malloc(sizeof(ABTI_ptouch));
+    p_ptouch->p_base = (char *)base;
+    p_ptouch->p_lo = (char *)lo;
+    p_ptouch->p_hi = (char *)hi;
+    p_ptouch->page_size = page_size;
+    p_ptouch->num_pages = (hi - base + page_size - 1) / page_size;
+    p_ptouch->num_parts = num_xstreams;
+    if ((size_t)p_ptouch->num_parts > p_ptouch->num_pages) {
+        p_ptouch->num_parts = (int)p_ptouch->num_pages;
+    }
+    p_ptouch->policy = policy;
+    p_ptouch->num_remains = (uint64_t)p_ptouch->num_parts;
+    abt_errno = ABT_eventual_create(0, &p_ptouch->eventual);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_ptouch);
+        goto fn_fail;
+    }
+
+    for (i = 0; i < p_ptouch->num_parts; i++) {
+        ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstreams[i]);
+        ABTI_ptouch_part *p_part;
+        ABT_pool pool;
+
+        p_part = (ABTI_ptouch_part *)ABTU_malloc(sizeof(ABTI_ptouch_part));
+        p_part->p_ptouch = p_ptouch;
+        p_part->index = i;
+        p_part->node = ABTD_affinity_get_topology_id(p_xstream->ctx,
+                                                     ABT_TOPOLOGY_NUMA);
+
+        /* If the tasklet cannot be pushed, the caller touches the pages. */
+        if (ABT_xstream_get_main_pools(xstreams[i], 1, &pool) != ABT_SUCCESS
+            || ABT_task_create(pool, ABTI_ptouch_run, (void *)p_part, NULL)
+               != ABT_SUCCESS) {
+            ABTI_ptouch_run((void *)p_part);
+        }
+    }
+
+    /* Wait for all the parts */
+    abt_errno = ABT_eventual_wait(p_ptouch->eventual, NULL);
+    ABT_eventual_free(&p_ptouch->eventual);
+    ABTU_free(p_ptouch);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void ABTI_ptouch_run(void *arg)
+{
+    ABTI_ptouch_part *p_part = (ABTI_ptouch_part *)arg;
+    ABTI_ptouch *p_ptouch = p_part->p_ptouch;
+    size_t num_pages = p_ptouch->num_pages;
+    size_t num_parts = (size_t)p_ptouch->num_parts;
+    size_t index = (size_t)p_part->index;
+    int node = p_part->node;
+    size_t p;
+
+    ABTU_free(p_part);
+
+    if (p_ptouch->policy == ABT_FIRST_TOUCH_BLOCK) {
+        /* Divide the pages as ABT_parallel_for() divides iterations */
+        size_t chunk = num_pages / num_parts;
+        size_t rem = num_pages % num_parts;
+        size_t first = index * chunk + ((index < rem) ? index : rem);
+        ABTI_ptouch_pages(p_ptouch, first, chunk + ((index < rem) ? 1 : 0),
+                          node);
+    } else {
+        for (p = index; p < num_pages; p += num_parts) {
+            ABTI_ptouch_pages(p_ptouch, p, 1, node);
+        }
+    }
+
+    /* The last one to finish signals the caller. */
+    if (ABTD_atomic_fetch_sub_uint64(&p_ptouch->num_remains, 1) == 1) {
+        ABT_eventual_set(p_ptouch->eventual, NULL, 0);
+    }
+}
+
+/* Place num_pages pages from page first on node and write to each of them.
+ * Only bytes in the range are written, each with its own value. */
+static void ABTI_ptouch_pages(ABTI_ptouch *p_ptouch, size_t first,
+                              size_t num_pages, int node)
+{
+    char *p_page = p_ptouch->p_base + first * p_ptouch->page_size;
+    size_t i;
+
+    if (num_pages == 0) return;
+    if (node >= 0) {
+        ABTD_affinity_bind_memory(p_page, num_pages * p_ptouch->page_size,
+                                  node);
+    }
+    for (i = 0; i < num_pages; i++, p_page += p_ptouch->page_size) {
+        volatile char *p_byte = (p_page < p_ptouch->p_lo) ? p_ptouch->p_lo
+                                                         : p_page;
+        if ((char *)p_byte < p_ptouch->p_hi) *p_byte = *p_byte;
+    }
+}
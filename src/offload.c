@@ -0,0 +1,213 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+static ABT_bool ABTI_offload_push(ABTI_offload *p_offload,
+                                  ABTI_offload_req *p_req);
+static ABT_bool ABTI_offload_add_helper(ABTI_offload *p_offload);
+static void *ABTI_offload_helper_main(void *p_arg);
+
+
+/** @defgroup OFFLOAD Offload
+ * Blocking calls that Argobots cannot make asynchronous, e.g., name
+ * resolution or a synchronous database driver, can be offloaded to helper OS
+ * threads.  The calling ULT is blocked meanwhile, so the other work units on
+ * its ES keep running.
+ */
+
+/**
+ * @ingroup OFFLOAD
+ * @brief   Run a blocking function on a helper OS thread.
+ *
+ * \c ABT_offload() calls \c fn with \c arg on one of the helper OS threads of
+ * Argobots and blocks the calling ULT until \c fn returns.  The ULT is then
+ * pushed back to its pool.  A new helper is created if all the existing ones
+ * are busy and fewer than \c ABT_OFFLOAD_MAX_HELPERS helpers exist; otherwise,
+ * the call waits in FIFO order for a free helper.
+ *
+ * \c fn runs as an external thread, so it must not call Argobots routines
+ * that only work units may call.  Tasklets and external threads, and ULTs
+ * when no helper can be used, call \c fn directly.
+ *
+ * @param[in] fn   function to call
+ * @param[in] arg  argument for \c fn
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_offload(void (*fn)(void *), void *arg)
+{
+    ABTI_offload_req req;
+    ABTI_thread *p_thread;
+
+    if (lp_ABTI_local == NULL || ABTI_local_get_task() != NULL) {
+        fn(arg);
+        return ABT_SUCCESS;
+    }
+    p_thread = ABTI_local_get_thread();
+
+    req.fn = fn;
+    req.arg = arg;
+    req.p_thread = p_thread;
+    req.p_next = NULL;
+    if (ABTI_offload_push(&gp_ABTI_global->offload, &req) == ABT_TRUE) {
+        ABTI_thread_suspend(p_thread);
+    } else {
+        fn(arg);
+    }
+    return ABT_SUCCESS;
+}
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* max_helpers has been set by ABTD_env_init(). */
+void ABTI_offload_init(ABTI_offload *p_offload)
+{
+    ABTI_spinlock_create(&p_offload->lock);
+    p_offload->num_helpers = 0;
+    p_offload->num_idle = 0;
+    p_offload->num_queued = 0;
+    p_offload->seq = 0;
+    p_offload->exit = ABT_FALSE;
+    p_offload->p_head = NULL;
+    p_offload->p_tail = NULL;
+    p_offload->p_helpers = NULL;
+}
+
+/* Let the helpers exit once the queue becomes empty and join them.  It should
+ * be called in ABT_finalize() while the pools still exist. */
+void ABTI_offload_finalize(ABTI_offload *p_offload)
+{
+    ABTI_offload_helper *p_helper;
+
+    ABTI_spinlock_acquire(&p_offload->lock);
+    p_offload->exit = ABT_TRUE;
+    p_offload->seq++;
+    p_helper = p_offload->p_helpers;
+    p_offload->p_helpers = NULL;
+    ABTI_spinlock_release(&p_offload->lock);
+    ABTD_futex_wake_all(&p_offload->seq);
+
+    while (p_helper) {
+        ABTI_offload_helper *p_next = p_helper->p_next;
+        ABTD_xstream_context_join(p_helper->ctx);
+        ABTU_free(p_helper);
+        p_helper = p_next;
+    }
+    ABTI_spinlock_free(&p_offload->lock);
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+/* Queue the request of the calling ULT and block the ULT.  A new helper is
+ * created unless an idle one will take the request.  Returns ABT_FALSE if
+ * no helper is available. */
+static ABT_bool ABTI_offload_push(ABTI_offload *p_offload,
+                                  ABTI_offload_req *p_req)
+{
+    ABT_bool wake = ABT_FALSE;
+
+    ABTI_spinlock_acquire(&p_offload->lock);
+    if (p_offload->num_queued >= p_offload->num_idle &&
+        p_offload->num_helpers < p_offload->max_helpers) {
+        p_offload->num_helpers++;
+        ABTI_spinlock_release(&p_offload->lock);
+        if (ABTI_offload_add_helper(p_offload) == ABT_FALSE) {
+            ABTI_spinlock_acquire(&p_offload->lock);
+            p_offload->num_helpers--;
+            ABTI_spinlock_release(&p_offload->lock);
+        }
+        ABTI_spinlock_acquire(&p_offload->lock);
+    }
+    if (p_offload->num_helpers == 0) {
+        ABTI_spinlock_release(&p_offload->lock);
+        return ABT_FALSE;
+    }
+
+    ABTI_thread_set_blocked(p_req->p_thread);
+    if (p_offload->p_tail) {
+        p_offload->p_tail->p_next = p_req;
+    } else {
+        p_offload->p_head = p_req;
+    }
+    p_offload->p_tail = p_req;
+    p_offload->num_queued++;
+    if (p_offload->num_idle > 0) {
+        p_offload->seq++;
+        wake = ABT_TRUE;
+    }
+    ABTI_spinlock_release(&p_offload->lock);
+
+    if (wake == ABT_TRUE) ABTD_futex_wake_all(&p_offload->seq);
+    return ABT_TRUE;
+}
+
+/* The caller has counted the new helper in num_helpers. */
+static ABT_bool ABTI_offload_add_helper(ABTI_offload *p_offload)
+{
+    ABTI_offload_helper *p_helper;
+
+    p_helper = (ABTI_offload_helper *)ABTU_malloc(sizeof(ABTI_offload_helper));
+    if (ABTD_xstream_context_create(ABTI_offload_helper_main, p_offload,
+                                    &p_helper->ctx) != ABT_SUCCESS) {
+        ABTU_free(p_helper);
+        return ABT_FALSE;
+    }
+
+    ABTI_spinlock_acquire(&p_offload->lock);
+    p_helper->p_next = p_offload->p_helpers;
+    p_offload->p_helpers = p_helper;
+    ABTI_spinlock_release(&p_offload->lock);
+    return ABT_TRUE;
+}
+
+/* Body of the helper OS threads.  p_arg is ABTI_offload. */
+static void *ABTI_offload_helper_main(void *p_arg)
+{
+    ABTI_offload *p_offload = (ABTI_offload *)p_arg;
+#if defined(HAVE_LINUX_FUTEX_H) && defined(HAVE_SYS_SYSCALL_H)
+    const struct timespec *p_timeout = NULL;
+#else
+    /* Without futex, idle helpers poll. */
+    const struct timespec timeout = { 0, 1000000 };
+    const struct timespec *p_timeout = &timeout;
+#endif
+
+    ABTI_spinlock_acquire(&p_offload->lock);
+    while (1) {
+        ABTI_offload_req *p_req = p_offload->p_head;
+        uint32_t seq;
+
+        if (p_req) {
+            p_offload->p_head = p_req->p_next;
+            if (p_offload->p_head == NULL) p_offload->p_tail = NULL;
+            p_offload->num_queued--;
+            ABTI_spinlock_release(&p_offload->lock);
+
+            p_req->fn(p_req->arg);
+            /* p_req must not be touched once the ULT is made ready. */
+            ABTI_thread_set_ready(p_req->p_thread);
+
+            ABTI_spinlock_acquire(&p_offload->lock);
+            continue;
+        }
+        if (p_offload->exit == ABT_TRUE) break;
+
+        p_offload->num_idle++;
+        seq = p_offload->seq;
+        ABTI_spinlock_release(&p_offload->lock);
+        ABTD_futex_wait(&p_offload->seq, seq, p_timeout);
+        ABTI_spinlock_acquire(&p_offload->lock);
+        p_offload->num_idle--;
+    }
+    ABTI_spinlock_release(&p_offload->lock);
+    return NULL;
+}
@@ -0,0 +1,1323 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#ifdef ABT_CONFIG_USE_OMP
+#include <stdbool.h>
+#include <limits.h>
+#include <strings.h>
+#include <pthread.h>
+
+/* OpenMP runtime.  If Argobots is configured with --enable-omp, libabt
+ * implements the part of the GNU OpenMP ABI (libgomp) that GCC emits for
+ * parallel regions, worksharing constructs, tasks, and synchronization, so an
+ * OpenMP program compiled with -fopenmp and linked with -labt instead of
+ * -lgomp runs on Argobots.
+ *
+ * A parallel region is a team of ULTs.  The encountering thread runs the
+ * implicit task of thread 0, and the other implicit tasks are ULTs pushed into
+ * the main pools of the next ESs, so a nested region is spread over the
+ * existing ESs instead of creating OS threads.  Explicit tasks are ULTs pushed
+ * into the pools of the team in a round-robin manner.  Team barriers are
+ * ABT_barrier, and the ULTs waiting on them let the ESs run the tasks.
+ *
+ * The OpenMP data of the running task is kept in a WU-specific key, or in a
+ * thread-local variable for external threads. */
+
+/* Number of worksharing constructs whose states a team keeps.  A thread can
+ * go ahead of the slowest one by this number of nowait constructs. */
+#define ABTI_OMP_NUM_WS             8
+
+/* GOMP_task() flags */
+#define ABTI_OMP_TASK_FLAG_FINAL    2
+#define ABTI_OMP_TASK_FLAG_DEPEND   8
+
+typedef enum {
+    ABTI_OMP_SCHED_STATIC,
+    ABTI_OMP_SCHED_DYNAMIC,
+    ABTI_OMP_SCHED_GUIDED
+} ABTI_omp_sched;
+
+typedef struct ABTI_omp_team      ABTI_omp_team;
+typedef struct ABTI_omp_task      ABTI_omp_task;
+typedef struct ABTI_omp_taskgroup ABTI_omp_taskgroup;
+
+/* Worksharing construct.  The fields are initialized by the first thread that
+ * encounters it and protected by lock. */
+typedef struct {
+    ABTI_spinlock lock;
+    uint32_t id;                /* Sequence number of the construct, or 0 */
+    int num_left;               /* Threads that have not left it */
+    ABTI_omp_sched sched;       /* Loop schedule */
+    long next;                  /* Next iteration (the first one if static) */
+    long end;                   /* Iteration next to the last one */
+    long incr;                  /* Loop increment */
+    long chunk;                 /* Chunk size in iterations */
+    void *copy_data;            /* Data of single copyprivate */
+} ABTI_omp_ws;
+
+struct ABTI_omp_taskgroup {
+    uint32_t num_tasks;         /* Tasks of the group not completed */
+    ABTI_omp_taskgroup *p_parent;
+};
+
+/* An implicit or explicit task */
+struct ABTI_omp_task {
+    ABTI_omp_team *p_team;
+    int tid;                    /* Thread number in the team */
+    ABT_bool is_final;
+    ABT_bool is_initial;        /* Implicit task outside parallel regions */
+    uint32_t num_refs;          /* 1 + children not completed */
+    ABTI_omp_task *p_parent;    /* Parent of an explicit task */
+    ABTI_omp_taskgroup *p_taskgroup;    /* Innermost task group */
+
+    /* Implicit tasks */
+    uint32_t ws_seq;            /* Worksharing constructs encountered */
+    ABTI_omp_ws *p_ws;          /* Current worksharing construct */
+    long static_trip;           /* Chunks taken from the static loop */
+
+    /* Explicit tasks */
+    void (*fn)(void *);
+    void *data;
+};
+
+struct ABTI_omp_team {
+    int num_threads;
+    int level;                  /* Nesting level */
+    int active_level;           /* Nesting level of teams of 2+ threads */
+    void (*fn)(void *);         /* Outlined body of the region */
+    void *data;
+    ABT_barrier barrier;
+    uint32_t num_tasks;         /* Explicit tasks not completed */
+    uint32_t next_pool;         /* Pool for the next explicit task */
+    int num_pools;
+    ABT_pool *pools;            /* Main pools of the ESs of the team */
+    ABTI_omp_task *p_tasks;     /* Implicit tasks */
+    ABT_thread *threads;        /* threads[i] runs p_tasks[i] (i > 0) */
+    ABTI_omp_task *p_prev;      /* Task of the master before the region */
+    ABTI_omp_ws ws[ABTI_OMP_NUM_WS];
+};
+
+/* Global state and internal control variables */
+typedef struct {
+    ABT_key key;                /* Running task */
+    ABT_mutex critical_lock;    /* Unnamed critical sections */
+    ABT_mutex atomic_lock;      /* GOMP_atomic_start() */
+    ABTI_spinlock name_lock;    /* Creation of named critical sections */
+    int num_threads;            /* nthreads-var, or 0 for the number of ESs */
+    int max_active_levels;      /* max-active-levels-var */
+    ABTI_omp_sched run_sched;   /* run-sched-var */
+    long run_chunk;
+} ABTI_omp_global;
+
+static ABTI_omp_global g_ABTI_omp;
+static pthread_once_t g_ABTI_omp_once = PTHREAD_ONCE_INIT;
+static ABTD_XSTREAM_LOCAL ABTI_omp_task *lp_ABTI_omp_task = NULL;
+
+static void ABTI_omp_init(void);
+static void ABTI_omp_init_once(void);
+static void ABTI_omp_key_destructor(void *value);
+static ABTI_omp_task *ABTI_omp_get_task(void);
+static void ABTI_omp_set_task(ABTI_omp_task *p_task);
+static void ABTI_omp_yield(void);
+static ABTI_omp_team *ABTI_omp_team_create(int num_threads, int level,
+                                           int active_level);
+static void ABTI_omp_team_free(ABTI_omp_team *p_team);
+static ABTI_omp_team *ABTI_omp_team_begin(void (*fn)(void *), void *data,
+                                          unsigned num_threads,
+                                          const ABTI_omp_ws *p_ws);
+static void ABTI_omp_team_end(ABTI_omp_team *p_team);
+static void ABTI_omp_team_barrier(ABTI_omp_team *p_team);
+static void ABTI_omp_thread_func(void *arg);
+static void ABTI_omp_task_func(void *arg);
+static void ABTI_omp_task_release(ABTI_omp_task *p_task);
+static void ABTI_omp_taskwait(ABTI_omp_task *p_task);
+static ABT_bool ABTI_omp_ws_enter(ABTI_omp_task *p_task);
+static void ABTI_omp_ws_leave(ABTI_omp_task *p_task);
+static void ABTI_omp_loop_init(ABTI_omp_ws *p_ws, ABTI_omp_sched sched,
+                               long start, long end, long incr, long chunk);
+static bool ABTI_omp_loop_start(ABTI_omp_sched sched, long start, long end,
+                                long incr, long chunk, long *istart,
+                                long *iend);
+static bool ABTI_omp_loop_next(long *istart, long *iend);
+static void ABTI_omp_parallel_loop(void (*fn)(void *), void *data,
+                                   unsigned num_threads, ABTI_omp_sched sched,
+                                   long start, long end, long incr,
+                                   long chunk);
+
+/* GNU OpenMP ABI.  The prototypes follow libgomp_g.h of GCC 11 and later. */
+void GOMP_parallel(void (*fn)(void *), void *data, unsigned num_threads,
+                   unsigned flags) ABT_API_PUBLIC;
+void GOMP_parallel_start(void (*fn)(void *), void *data,
+                         unsigned num_threads) ABT_API_PUBLIC;
+void GOMP_parallel_end(void) ABT_API_PUBLIC;
+void GOMP_barrier(void) ABT_API_PUBLIC;
+void GOMP_critical_start(void) ABT_API_PUBLIC;
+void GOMP_critical_end(void) ABT_API_PUBLIC;
+void GOMP_critical_name_start(void **pptr) ABT_API_PUBLIC;
+void GOMP_critical_name_end(void **pptr) ABT_API_PUBLIC;
+void GOMP_atomic_start(void) ABT_API_PUBLIC;
+void GOMP_atomic_end(void) ABT_API_PUBLIC;
+bool GOMP_single_start(void) ABT_API_PUBLIC;
+void *GOMP_single_copy_start(void) ABT_API_PUBLIC;
+void GOMP_single_copy_end(void *data) ABT_API_PUBLIC;
+bool GOMP_loop_static_start(long start, long end, long incr, long chunk,
+                            long *istart, long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_dynamic_start(long start, long end, long incr, long chunk,
+                             long *istart, long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_guided_start(long start, long end, long incr, long chunk,
+                            long *istart, long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_runtime_start(long start, long end, long incr, long *istart,
+                             long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_nonmonotonic_dynamic_start(long start, long end, long incr,
+                                          long chunk, long *istart,
+                                          long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_nonmonotonic_guided_start(long start, long end, long incr,
+                                         long chunk, long *istart,
+                                         long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_nonmonotonic_runtime_start(long start, long end, long incr,
+                                          long *istart,
+                                          long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_maybe_nonmonotonic_runtime_start(long start, long end,
+                                                long incr, long *istart,
+                                                long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_static_next(long *istart, long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_dynamic_next(long *istart, long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_guided_next(long *istart, long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_runtime_next(long *istart, long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_nonmonotonic_dynamic_next(long *istart,
+                                         long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_nonmonotonic_guided_next(long *istart,
+                                        long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_nonmonotonic_runtime_next(long *istart,
+                                         long *iend) ABT_API_PUBLIC;
+bool GOMP_loop_maybe_nonmonotonic_runtime_next(long *istart,
+                                               long *iend) ABT_API_PUBLIC;
+void GOMP_loop_end(void) ABT_API_PUBLIC;
+void GOMP_loop_end_nowait(void) ABT_API_PUBLIC;
+void GOMP_parallel_loop_static(void (*fn)(void *), void *data,
+                               unsigned num_threads, long start, long end,
+                               long incr, long chunk,
+                               unsigned flags) ABT_API_PUBLIC;
+void GOMP_parallel_loop_dynamic(void (*fn)(void *), void *data,
+                                unsigned num_threads, long start, long end,
+                                long incr, long chunk,
+                                unsigned flags) ABT_API_PUBLIC;
+void GOMP_parallel_loop_guided(void (*fn)(void *), void *data,
+                               unsigned num_threads, long start, long end,
+                               long incr, long chunk,
+                               unsigned flags) ABT_API_PUBLIC;
+void GOMP_parallel_loop_runtime(void (*fn)(void *), void *data,
+                                unsigned num_threads, long start, long end,
+                                long incr, unsigned flags) ABT_API_PUBLIC;
+void GOMP_parallel_loop_nonmonotonic_dynamic(void (*fn)(void *), void *data,
+                                             unsigned num_threads, long start,
+                                             long end, long incr, long chunk,
+                                             unsigned flags) ABT_API_PUBLIC;
+void GOMP_parallel_loop_nonmonotonic_guided(void (*fn)(void *), void *data,
+                                            unsigned num_threads, long start,
+                                            long end, long incr, long chunk,
+                                            unsigned flags) ABT_API_PUBLIC;
+void GOMP_parallel_loop_nonmonotonic_runtime(void (*fn)(void *), void *data,
+                                             unsigned num_threads, long start,
+                                             long end, long incr,
+                                             unsigned flags) ABT_API_PUBLIC;
+void GOMP_parallel_loop_maybe_nonmonotonic_runtime(void (*fn)(void *),
+                                                   void *data,
+                                                   unsigned num_threads,
+                                                   long start, long end,
+                                                   long incr,
+                                                   unsigned flags)
+                                                   ABT_API_PUBLIC;
+unsigned GOMP_sections_start(unsigned count) ABT_API_PUBLIC;
+unsigned GOMP_sections_next(void) ABT_API_PUBLIC;
+void GOMP_sections_end(void) ABT_API_PUBLIC;
+void GOMP_sections_end_nowait(void) ABT_API_PUBLIC;
+void GOMP_parallel_sections(void (*fn)(void *), void *data,
+                            unsigned num_threads, unsigned count,
+                            unsigned flags) ABT_API_PUBLIC;
+void GOMP_task(void (*fn)(void *), void *data,
+               void (*cpyfn)(void *, void *), long arg_size, long arg_align,
+               bool if_clause, unsigned flags, void **depend, int priority,
+               void *detach) ABT_API_PUBLIC;
+void GOMP_taskwait(void) ABT_API_PUBLIC;
+void GOMP_taskyield(void) ABT_API_PUBLIC;
+void GOMP_taskgroup_start(void) ABT_API_PUBLIC;
+void GOMP_taskgroup_end(void) ABT_API_PUBLIC;
+
+/* OpenMP API routines.  omp_lock_t is a 32-bit word in GCC's omp.h. */
+int omp_get_thread_num(void) ABT_API_PUBLIC;
+int omp_get_num_threads(void) ABT_API_PUBLIC;
+int omp_get_max_threads(void) ABT_API_PUBLIC;
+void omp_set_num_threads(int num_threads) ABT_API_PUBLIC;
+int omp_in_parallel(void) ABT_API_PUBLIC;
+int omp_get_level(void) ABT_API_PUBLIC;
+int omp_get_active_level(void) ABT_API_PUBLIC;
+int omp_get_max_active_levels(void) ABT_API_PUBLIC;
+void omp_set_max_active_levels(int max_levels) ABT_API_PUBLIC;
+int omp_get_dynamic(void) ABT_API_PUBLIC;
+void omp_set_dynamic(int dynamic_threads) ABT_API_PUBLIC;
+int omp_get_nested(void) ABT_API_PUBLIC;
+void omp_set_nested(int nested) ABT_API_PUBLIC;
+int omp_get_num_procs(void) ABT_API_PUBLIC;
+double omp_get_wtime(void) ABT_API_PUBLIC;
+double omp_get_wtick(void) ABT_API_PUBLIC;
+void omp_init_lock(uint32_t *lock) ABT_API_PUBLIC;
+void omp_destroy_lock(uint32_t *lock) ABT_API_PUBLIC;
+void omp_set_lock(uint32_t *lock) ABT_API_PUBLIC;
+void omp_unset_lock(uint32_t *lock) ABT_API_PUBLIC;
+int omp_test_lock(uint32_t *lock) ABT_API_PUBLIC;
+
+
+/*****************************************************************************/
+/* Parallel regions                                                          */
+/*****************************************************************************/
+
+void GOMP_parallel(void (*fn)(void *), void *data, unsigned num_threads,
+                   unsigned flags)
+{
+    /* The proc_bind clause is ignored since ULTs are bound to ESs.  */
+    ABTI_omp_team *p_team;
+    ABTI_UNUSED(flags);
+
+    p_team = ABTI_omp_team_begin(fn, data, num_threads, NULL);
+    fn(data);
+    ABTI_omp_team_end(p_team);
+}
+
+/* The encountering thread calls fn between these two. */
+void GOMP_parallel_start(void (*fn)(void *), void *data, unsigned num_threads)
+{
+    ABTI_omp_team_begin(fn, data, num_threads, NULL);
+}
+
+void GOMP_parallel_end(void)
+{
+    ABTI_omp_team_end(ABTI_omp_get_task()->p_team);
+}
+
+void GOMP_barrier(void)
+{
+    ABTI_omp_team_barrier(ABTI_omp_get_task()->p_team);
+}
+
+
+/*****************************************************************************/
+/* Synchronization                                                           */
+/*****************************************************************************/
+
+void GOMP_critical_start(void)
+{
+    ABTI_omp_init();
+    ABT_mutex_lock(g_ABTI_omp.critical_lock);
+}
+
+void GOMP_critical_end(void)
+{
+    ABT_mutex_unlock(g_ABTI_omp.critical_lock);
+}
+
+/* *pptr holds the mutex of the named critical section. */
+void GOMP_critical_name_start(void **pptr)
+{
+    ABT_mutex mutex = *(ABT_mutex volatile *)pptr;
+
+    if (mutex == NULL) {
+        ABTI_omp_init();
+        ABTI_spinlock_acquire(&g_ABTI_omp.name_lock);
+        mutex = (ABT_mutex)*pptr;
+        if (mutex == NULL) {
+            ABT_mutex_create(&mutex);
+            ABTD_atomic_mem_barrier();
+            *pptr = (void *)mutex;
+        }
+        ABTI_spinlock_release(&g_ABTI_omp.name_lock);
+    }
+    ABT_mutex_lock(mutex);
+}
+
+void GOMP_critical_name_end(void **pptr)
+{
+    ABT_mutex_unlock((ABT_mutex)*pptr);
+}
+
+void GOMP_atomic_start(void)
+{
+    ABTI_omp_init();
+    ABT_mutex_lock(g_ABTI_omp.atomic_lock);
+}
+
+void GOMP_atomic_end(void)
+{
+    ABT_mutex_unlock(g_ABTI_omp.atomic_lock);
+}
+
+
+/*****************************************************************************/
+/* Worksharing constructs                                                    */
+/*****************************************************************************/
+
+bool GOMP_single_start(void)
+{
+    ABTI_omp_task *p_task = ABTI_omp_get_task();
+    ABT_bool first = ABTI_omp_ws_enter(p_task);
+    ABTI_spinlock_release(&p_task->p_ws->lock);
+    ABTI_omp_ws_leave(p_task);
+    return first == ABT_TRUE;
+}
+
+/* The first thread runs the single construct and passes its data to the
+ * others through GOMP_single_copy_end(). */
+void *GOMP_single_copy_start(void)
+{
+    ABTI_omp_task *p_task = ABTI_omp_get_task();
+    void *data;
+
+    ABT_bool first = ABTI_omp_ws_enter(p_task);
+    ABTI_spinlock_release(&p_task->p_ws->lock);
+    if (first == ABT_TRUE) return NULL;
+
+    ABTI_omp_team_barrier(p_task->p_team);
+    data = p_task->p_ws->copy_data;
+    ABTI_omp_ws_leave(p_task);
+    return data;
+}
+
+void GOMP_single_copy_end(void *data)
+{
+    ABTI_omp_task *p_task = ABTI_omp_get_task();
+    p_task->p_ws->copy_data = data;
+    ABTI_omp_ws_leave(p_task);
+    ABTI_omp_team_barrier(p_task->p_team);
+}
+
+bool GOMP_loop_static_start(long start, long end, long incr, long chunk,
+                            long *istart, long *iend)
+{
+    return ABTI_omp_loop_start(ABTI_OMP_SCHED_STATIC, start, end, incr, chunk,
+                               istart, iend);
+}
+
+bool GOMP_loop_dynamic_start(long start, long end, long incr, long chunk,
+                             long *istart, long *iend)
+{
+    return ABTI_omp_loop_start(ABTI_OMP_SCHED_DYNAMIC, start, end, incr,
+                               chunk, istart, iend);
+}
+
+bool GOMP_loop_guided_start(long start, long end, long incr, long chunk,
+                            long *istart, long *iend)
+{
+    return ABTI_omp_loop_start(ABTI_OMP_SCHED_GUIDED, start, end, incr, chunk,
+                               istart, iend);
+}
+
+bool GOMP_loop_runtime_start(long start, long end, long incr, long *istart,
+                             long *iend)
+{
+    ABTI_omp_init();
+    return ABTI_omp_loop_start(g_ABTI_omp.run_sched, start, end, incr,
+                               g_ABTI_omp.run_chunk, istart, iend);
+}
+
+/* Dynamic and guided schedules are always nonmonotonic. */
+bool GOMP_loop_nonmonotonic_dynamic_start(long start, long end, long incr,
+                                          long chunk, long *istart,
+                                          long *iend)
+{
+    return GOMP_loop_dynamic_start(start, end, incr, chunk, istart, iend);
+}
+
+bool GOMP_loop_nonmonotonic_guided_start(long start, long end, long incr,
+                                         long chunk, long *istart,
+                                         long *iend)
+{
+    return GOMP_loop_guided_start(start, end, incr, chunk, istart, iend);
+}
+
+bool GOMP_loop_nonmonotonic_runtime_start(long start, long end, long incr,
+                                          long *istart, long *iend)
+{
+    return GOMP_loop_runtime_start(start, end, incr, istart, iend);
+}
+
+bool GOMP_loop_maybe_nonmonotonic_runtime_start(long start, long end,
+                                                long incr, long *istart,
+                                                long *iend)
+{
+    return GOMP_loop_runtime_start(start, end, incr, istart, iend);
+}
+
+/* The schedule is known from the construct, so all of them are the same. */
+bool GOMP_loop_static_next(long *istart, long *iend)
+{
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+bool GOMP_loop_dynamic_next(long *istart, long *iend)
+{
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+bool GOMP_loop_guided_next(long *istart, long *iend)
+{
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+bool GOMP_loop_runtime_next(long *istart, long *iend)
+{
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+bool GOMP_loop_nonmonotonic_dynamic_next(long *istart, long *iend)
+{
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+bool GOMP_loop_nonmonotonic_guided_next(long *istart, long *iend)
+{
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+bool GOMP_loop_nonmonotonic_runtime_next(long *istart, long *iend)
+{
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+bool GOMP_loop_maybe_nonmonotonic_runtime_next(long *istart, long *iend)
+{
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+void GOMP_loop_end(void)
+{
+    ABTI_omp_task *p_task = ABTI_omp_get_task();
+    ABTI_omp_ws_leave(p_task);
+    ABTI_omp_team_barrier(p_task->p_team);
+}
+
+void GOMP_loop_end_nowait(void)
+{
+    ABTI_omp_ws_leave(ABTI_omp_get_task());
+}
+
+void GOMP_parallel_loop_static(void (*fn)(void *), void *data,
+                               unsigned num_threads, long start, long end,
+                               long incr, long chunk, unsigned flags)
+{
+    ABTI_UNUSED(flags);
+    ABTI_omp_parallel_loop(fn, data, num_threads, ABTI_OMP_SCHED_STATIC,
+                           start, end, incr, chunk);
+}
+
+void GOMP_parallel_loop_dynamic(void (*fn)(void *), void *data,
+                                unsigned num_threads, long start, long end,
+                                long incr, long chunk, unsigned flags)
+{
+    ABTI_UNUSED(flags);
+    ABTI_omp_parallel_loop(fn, data, num_threads, ABTI_OMP_SCHED_DYNAMIC,
+                           start, end, incr, chunk);
+}
+
+void GOMP_parallel_loop_guided(void (*fn)(void *), void *data,
+                               unsigned num_threads, long start, long end,
+                               long incr, long chunk, unsigned flags)
+{
+    ABTI_UNUSED(flags);
+    ABTI_omp_parallel_loop(fn, data, num_threads, ABTI_OMP_SCHED_GUIDED,
+                           start, end, incr, chunk);
+}
+
+void GOMP_parallel_loop_runtime(void (*fn)(void *), void *data,
+                                unsigned num_threads, long start, long end,
+                                long incr, unsigned flags)
+{
+    ABTI_UNUSED(flags);
+    ABTI_omp_init();
+    ABTI_omp_parallel_loop(fn, data, num_threads, g_ABTI_omp.run_sched,
+                           start, end, incr, g_ABTI_omp.run_chunk);
+}
+
+void GOMP_parallel_loop_nonmonotonic_dynamic(void (*fn)(void *), void *data,
+                                             unsigned num_threads, long start,
+                                             long end, long incr, long chunk,
+                                             unsigned flags)
+{
+    GOMP_parallel_loop_dynamic(fn, data, num_threads, start, end, incr, chunk,
+                               flags);
+}
+
+void GOMP_parallel_loop_nonmonotonic_guided(void (*fn)(void *), void *data,
+                                            unsigned num_threads, long start,
+                                            long end, long incr, long chunk,
+                                            unsigned flags)
+{
+    GOMP_parallel_loop_guided(fn, data, num_threads, start, end, incr, chunk,
+                              flags);
+}
+
+void GOMP_parallel_loop_nonmonotonic_runtime(void (*fn)(void *), void *data,
+                                             unsigned num_threads, long start,
+                                             long end, long incr,
+                                             unsigned flags)
+{
+    GOMP_parallel_loop_runtime(fn, data, num_threads, start, end, incr,
+                               flags);
+}
+
+void GOMP_parallel_loop_maybe_nonmonotonic_runtime(void (*fn)(void *),
+                                                   void *data,
+                                                   unsigned num_threads,
+                                                   long start, long end,
+                                                   long incr, unsigned flags)
+{
+    GOMP_parallel_loop_runtime(fn, data, num_threads, start, end, incr,
+                               flags);
+}
+
+/* Sections are the iterations [1, count] of a dynamic loop.  0 means that no
+ * section is left. */
+unsigned GOMP_sections_start(unsigned count)
+{
+    long istart, iend;
+    if (ABTI_omp_loop_start(ABTI_OMP_SCHED_DYNAMIC, 1, (long)count + 1, 1, 1,
+                            &istart, &iend)) {
+        return (unsigned)istart;
+    }
+    return 0;
+}
+
+unsigned GOMP_sections_next(void)
+{
+    long istart, iend;
+    if (ABTI_omp_loop_next(&istart, &iend)) return (unsigned)istart;
+    return 0;
+}
+
+void GOMP_sections_end(void)
+{
+    GOMP_loop_end();
+}
+
+void GOMP_sections_end_nowait(void)
+{
+    GOMP_loop_end_nowait();
+}
+
+void GOMP_parallel_sections(void (*fn)(void *), void *data,
+                            unsigned num_threads, unsigned count,
+                            unsigned flags)
+{
+    ABTI_UNUSED(flags);
+    ABTI_omp_parallel_loop(fn, data, num_threads, ABTI_OMP_SCHED_DYNAMIC, 1,
+                           (long)count + 1, 1, 1);
+}
+
+
+/*****************************************************************************/
+/* Tasks                                                                     */
+/*****************************************************************************/
+
+/* A task is run immediately by the encountering thread if it is undeferred
+ * or final, and if it has dependences.  Since all the tasks with depend
+ * clauses are then completed in the order of their creation, the
+ * dependences are satisfied.  The detach clause and priorities are not
+ * supported. */
+void GOMP_task(void (*fn)(void *), void *data,
+               void (*cpyfn)(void *, void *), long arg_size, long arg_align,
+               bool if_clause, unsigned flags, void **depend, int priority,
+               void *detach)
+{
+    ABTI_omp_task *p_parent = ABTI_omp_get_task();
+    ABTI_omp_team *p_team = p_parent->p_team;
+    ABTI_omp_task *p_task;
+    ABT_pool pool;
+    char *p_arg;
+    uint32_t idx;
+    int ret;
+    ABTI_UNUSED(depend);
+    ABTI_UNUSED(priority);
+    ABTI_UNUSED(detach);
+
+    if (arg_align < 1) arg_align = 1;
+    if (!if_clause || p_parent->is_final == ABT_TRUE ||
+        (flags & ABTI_OMP_TASK_FLAG_DEPEND)) {
+        ABTI_omp_task task = *p_parent;
+        task.is_final = (p_parent->is_final == ABT_TRUE ||
+                         (flags & ABTI_OMP_TASK_FLAG_FINAL))
+                      ? ABT_TRUE : ABT_FALSE;
+        task.is_initial = ABT_FALSE;
+        task.num_refs = 1;
+        task.p_parent = NULL;
+        if (cpyfn) {
+            char buf[arg_size + arg_align];
+            p_arg = (char *)(((uintptr_t)buf + arg_align - 1)
+                             & ~(uintptr_t)(arg_align - 1));
+            cpyfn(p_arg, data);
+            data = p_arg;
+        }
+        ABTI_omp_set_task(&task);
+        fn(data);
+        /* The children refer to the task, which is on this stack. */
+        ABTI_omp_taskwait(&task);
+        ABTI_omp_set_task(p_parent);
+        return;
+    }
+
+    p_task = (ABTI_omp_task *)ABTU_malloc(sizeof(ABTI_omp_task) + arg_size +
+                                          arg_align - 1);
+    p_arg = (char *)(((uintptr_t)(p_task + 1) + arg_align - 1)
+                     & ~(uintptr_t)(arg_align - 1));
+    if (cpyfn) {
+        cpyfn(p_arg, data);
+    } else {
+        memcpy(p_arg, data, arg_size);
+    }
+    p_task->p_team = p_team;
+    p_task->tid = p_parent->tid;
+    p_task->is_final = (flags & ABTI_OMP_TASK_FLAG_FINAL) ? ABT_TRUE
+                                                          : ABT_FALSE;
+    p_task->is_initial = ABT_FALSE;
+    p_task->num_refs = 1;
+    p_task->p_parent = p_parent;
+    p_task->p_taskgroup = p_parent->p_taskgroup;
+    p_task->ws_seq = 0;
+    p_task->p_ws = NULL;
+    p_task->static_trip = 0;
+    p_task->fn = fn;
+    p_task->data = p_arg;
+
+    ABTD_atomic_fetch_add_uint32(&p_parent->num_refs, 1);
+    if (p_task->p_taskgroup) {
+        ABTD_atomic_fetch_add_uint32(&p_task->p_taskgroup->num_tasks, 1);
+    }
+    ABTD_atomic_fetch_add_uint32(&p_team->num_tasks, 1);
+
+    idx = ABTD_atomic_fetch_add_uint32(&p_team->next_pool, 1);
+    pool = p_team->pools[idx % (uint32_t)p_team->num_pools];
+    ret = ABT_thread_create(pool, ABTI_omp_task_func, p_task,
+                            ABT_THREAD_ATTR_NULL, NULL);
+    if (ret != ABT_SUCCESS) {
+        /* Run it here if a ULT cannot be created. */
+        ABTI_omp_task_func(p_task);
+    }
+}
+
+void GOMP_taskwait(void)
+{
+    ABTI_omp_taskwait(ABTI_omp_get_task());
+}
+
+void GOMP_taskyield(void)
+{
+    ABTI_omp_yield();
+}
+
+void GOMP_taskgroup_start(void)
+{
+    ABTI_omp_task *p_task = ABTI_omp_get_task();
+    ABTI_omp_taskgroup *p_taskgroup;
+
+    p_taskgroup = (ABTI_omp_taskgroup *)
+        ABTU_malloc(sizeof(ABTI_omp_taskgroup));
+    p_taskgroup->num_tasks = 0;
+    p_taskgroup->p_parent = p_task->p_taskgroup;
+    p_task->p_taskgroup = p_taskgroup;
+}
+
+/* Wait for the tasks of the group and their descendants. */
+void GOMP_taskgroup_end(void)
+{
+    ABTI_omp_task *p_task = ABTI_omp_get_task();
+    ABTI_omp_taskgroup *p_taskgroup = p_task->p_taskgroup;
+
+    while (*(volatile uint32_t *)&p_taskgroup->num_tasks > 0) {
+        ABTI_omp_yield();
+    }
+    p_task->p_taskgroup = p_taskgroup->p_parent;
+    ABTU_free(p_taskgroup);
+}
+
+
+/*****************************************************************************/
+/* OpenMP API routines                                                       */
+/*****************************************************************************/
+
+int omp_get_thread_num(void)
+{
+    return ABTI_omp_get_task()->tid;
+}
+
+int omp_get_num_threads(void)
+{
+    return ABTI_omp_get_task()->p_team->num_threads;
+}
+
+int omp_get_max_threads(void)
+{
+    ABTI_omp_init();
+    if (g_ABTI_omp.num_threads > 0) return g_ABTI_omp.num_threads;
+    return gp_ABTI_global->num_xstreams;
+}
+
+/* nthreads-var is shared by all the tasks. */
+void omp_set_num_threads(int num_threads)
+{
+    ABTI_omp_init();
+    if (num_threads > 0) g_ABTI_omp.num_threads = num_threads;
+}
+
+int omp_in_parallel(void)
+{
+    return ABTI_omp_get_task()->p_team->active_level > 0;
+}
+
+int omp_get_level(void)
+{
+    return ABTI_omp_get_task()->p_team->level;
+}
+
+int omp_get_active_level(void)
+{
+    return ABTI_omp_get_task()->p_team->active_level;
+}
+
+int omp_get_max_active_levels(void)
+{
+    ABTI_omp_init();
+    return g_ABTI_omp.max_active_levels;
+}
+
+void omp_set_max_active_levels(int max_levels)
+{
+    ABTI_omp_init();
+    if (max_levels >= 0) g_ABTI_omp.max_active_levels = max_levels;
+}
+
+/* The number of threads is not adjusted. */
+int omp_get_dynamic(void)
+{
+    return 0;
+}
+
+void omp_set_dynamic(int dynamic_threads)
+{
+    ABTI_UNUSED(dynamic_threads);
+}
+
+int omp_get_nested(void)
+{
+    return omp_get_max_active_levels() > 1;
+}
+
+void omp_set_nested(int nested)
+{
+    omp_set_max_active_levels(nested ? INT_MAX : 1);
+}
+
+int omp_get_num_procs(void)
+{
+    ABTI_omp_init();
+    return gp_ABTI_global->num_cores;
+}
+
+double omp_get_wtime(void)
+{
+    return ABT_get_wtime();
+}
+
+double omp_get_wtick(void)
+{
+    return 1.0e-9;
+}
+
+void omp_init_lock(uint32_t *lock)
+{
+    *lock = 0;
+}
+
+void omp_destroy_lock(uint32_t *lock)
+{
+    ABTI_UNUSED(lock);
+}
+
+void omp_set_lock(uint32_t *lock)
+{
+    while (ABTD_atomic_cas_uint32(lock, 0, 1) != 0) {
+        ABTI_omp_yield();
+    }
+}
+
+void omp_unset_lock(uint32_t *lock)
+{
+    ABTD_atomic_mem_barrier();
+    *(volatile uint32_t *)lock = 0;
+}
+
+int omp_test_lock(uint32_t *lock)
+{
+    return ABTD_atomic_cas_uint32(lock, 0, 1) == 0;
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void ABTI_omp_init(void)
+{
+    pthread_once(&g_ABTI_omp_once, ABTI_omp_init_once);
+}
+
+/* If Argobots has not been initialized, it is initialized with as many ESs
+ * as OMP_NUM_THREADS or the number of cores.  Otherwise, the ESs that the
+ * program has created are used. */
+static void ABTI_omp_init_once(void)
+{
+    ABTI_omp_global *p_omp = &g_ABTI_omp;
+    char *env;
+
+    p_omp->num_threads = 0;
+    env = getenv("OMP_NUM_THREADS");
+    if (env != NULL && atoi(env) > 0) p_omp->num_threads = atoi(env);
+
+    p_omp->max_active_levels = INT_MAX;
+    env = getenv("OMP_MAX_ACTIVE_LEVELS");
+    if (env != NULL && atoi(env) >= 0) p_omp->max_active_levels = atoi(env);
+    env = getenv("OMP_NESTED");
+    if (env != NULL && (strcasecmp(env, "false") == 0 ||
+                        strcmp(env, "0") == 0)) {
+        p_omp->max_active_levels = 1;
+    }
+
+    /* OMP_SCHEDULE is "[modifier:]kind[,chunk]".  The default is dynamic
+     * with chunks of one iteration. */
+    p_omp->run_sched = ABTI_OMP_SCHED_DYNAMIC;
+    p_omp->run_chunk = 1;
+    env = getenv("OMP_SCHEDULE");
+    if (env != NULL) {
+        char *p_kind = strchr(env, ':') ? strchr(env, ':') + 1 : env;
+        char *p_chunk = strchr(p_kind, ',');
+        if (strncasecmp(p_kind, "static", 6) == 0) {
+            p_omp->run_sched = ABTI_OMP_SCHED_STATIC;
+            p_omp->run_chunk = 0;
+        } else if (strncasecmp(p_kind, "guided", 6) == 0) {
+            p_omp->run_sched = ABTI_OMP_SCHED_GUIDED;
+        }
+        if (p_chunk != NULL && atol(p_chunk + 1) > 0) {
+            p_omp->run_chunk = atol(p_chunk + 1);
+        }
+    }
+
+    if (ABT_initialized() != ABT_SUCCESS) {
+        int num_xstreams;
+        ABT_xstream *xstreams;
+        ABT_init(0, NULL);
+        num_xstreams = p_omp->num_threads > 0 ? p_omp->num_threads
+                                              : gp_ABTI_global->num_cores;
+        if (num_xstreams > 1) {
+            /* The ESs are brought up in parallel. */
+            xstreams = (ABT_xstream *)
+                ABTU_malloc((num_xstreams - 1) * sizeof(ABT_xstream));
+            ABT_xstream_create_many(num_xstreams - 1, xstreams);
+            ABTU_free(xstreams);
+        }
+    }
+
+    ABT_key_create(ABTI_omp_key_destructor, &p_omp->key);
+    ABT_mutex_create(&p_omp->critical_lock);
+    ABT_mutex_create(&p_omp->atomic_lock);
+    ABTI_spinlock_create(&p_omp->name_lock);
+}
+
+/* Only the initial tasks are owned by the WUs. */
+static void ABTI_omp_key_destructor(void *value)
+{
+    ABTI_omp_task *p_task = (ABTI_omp_task *)value;
+    if (p_task->is_initial == ABT_TRUE) {
+        ABTI_omp_taskwait(p_task);
+        ABTI_omp_team_free(p_task->p_team);
+    }
+}
+
+/* A WU outside parallel regions runs the initial task of its own team of
+ * one thread, which is created when it calls the OpenMP runtime first. */
+static ABTI_omp_task *ABTI_omp_get_task(void)
+{
+    ABTI_omp_task *p_task = NULL;
+
+    if (lp_ABTI_local == NULL) {
+        p_task = lp_ABTI_omp_task;
+    } else {
+        ABTI_omp_init();
+        ABT_key_get(g_ABTI_omp.key, (void **)&p_task);
+    }
+    if (p_task == NULL) {
+        ABTI_omp_init();
+        p_task = &ABTI_omp_team_create(1, 0, 0)->p_tasks[0];
+        p_task->is_initial = ABT_TRUE;
+        ABTI_omp_set_task(p_task);
+    }
+    return p_task;
+}
+
+static void ABTI_omp_set_task(ABTI_omp_task *p_task)
+{
+    if (lp_ABTI_local == NULL) {
+        lp_ABTI_omp_task = p_task;
+    } else {
+        ABT_key_set(g_ABTI_omp.key, (void *)p_task);
+    }
+}
+
+static void ABTI_omp_yield(void)
+{
+    if (lp_ABTI_local != NULL && ABTI_local_get_thread() != NULL) {
+        ABT_thread_yield();
+    } else {
+        ABTD_atomic_pause();
+    }
+}
+
+/* Create a team whose threads are placed on the ESs following the caller's
+ * one. */
+static ABTI_omp_team *ABTI_omp_team_create(int num_threads, int level,
+                                           int active_level)
+{
+    ABTI_xstream *p_local_xstream = NULL;
+    ABTI_omp_team *p_team;
+    int i, num_pools, base = 0, max_xstreams;
+    ABTI_xstream **p_xstreams;
+
+    p_team = (ABTI_omp_team *)ABTU_malloc(sizeof(ABTI_omp_team));
+    p_team->num_threads = num_threads;
+    p_team->level = level;
+    p_team->active_level = active_level;
+    p_team->fn = NULL;
+    p_team->data = NULL;
+    ABT_barrier_create((uint32_t)num_threads, &p_team->barrier);
+    p_team->num_tasks = 0;
+    p_team->next_pool = 0;
+
+    /* The ESs being created or freed may be missed. */
+    if (lp_ABTI_local != NULL) p_local_xstream = ABTI_local_get_xstream();
+    num_pools = 0;
+    p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+    p_team->pools = (ABT_pool *)ABTU_malloc(sizeof(ABT_pool) * max_xstreams);
+    for (i = 0; i < max_xstreams; i++) {
+        ABTI_xstream *p_xstream = p_xstreams[i];
+        if (p_xstream == NULL || p_xstream->p_main_sched == NULL ||
+            p_xstream->state == ABT_XSTREAM_STATE_TERMINATED) {
+            continue;
+        }
+        if (p_xstream == p_local_xstream) base = num_pools;
+        p_team->pools[num_pools++] = p_xstream->p_main_sched->pools[0];
+    }
+    /* Rotate the pools so that pools[i] is the one of thread i. */
+    for (i = 0; i < base; i++) {
+        ABT_pool pool = p_team->pools[0];
+        memmove(&p_team->pools[0], &p_team->pools[1],
+                sizeof(ABT_pool) * (num_pools - 1));
+        p_team->pools[num_pools - 1] = pool;
+    }
+    p_team->num_pools = num_pools < num_threads ? num_pools : num_threads;
+
+    p_team->p_tasks = (ABTI_omp_task *)ABTU_malloc(sizeof(ABTI_omp_task) *
+                                                   num_threads);
+    p_team->threads = (ABT_thread *)ABTU_malloc(sizeof(ABT_thread) *
+                                                num_threads);
+    for (i = 0; i < num_threads; i++) {
+        ABTI_omp_task *p_task = &p_team->p_tasks[i];
+        p_task->p_team = p_team;
+        p_task->tid = i;
+        p_task->is_final = ABT_FALSE;
+        p_task->is_initial = ABT_FALSE;
+        p_task->num_refs = 1;
+        p_task->p_parent = NULL;
+        p_task->p_taskgroup = NULL;
+        p_task->ws_seq = 0;
+        p_task->p_ws = NULL;
+        p_task->static_trip = 0;
+        p_task->fn = NULL;
+        p_task->data = NULL;
+        p_team->threads[i] = ABT_THREAD_NULL;
+    }
+    for (i = 0; i < ABTI_OMP_NUM_WS; i++) {
+        ABTI_spinlock_create(&p_team->ws[i].lock);
+        p_team->ws[i].id = 0;
+        p_team->ws[i].num_left = 0;
+    }
+    p_team->p_prev = NULL;
+    return p_team;
+}
+
+static void ABTI_omp_team_free(ABTI_omp_team *p_team)
+{
+    int i;
+    for (i = 0; i < ABTI_OMP_NUM_WS; i++) {
+        ABTI_spinlock_free(&p_team->ws[i].lock);
+    }
+    ABT_barrier_free(&p_team->barrier);
+    ABTU_free(p_team->pools);
+    ABTU_free(p_team->p_tasks);
+    ABTU_free(p_team->threads);
+    ABTU_free(p_team);
+}
+
+/* Start a parallel region.  If p_ws is not NULL, the team starts with the
+ * loop of p_ws as its first worksharing construct. */
+static ABTI_omp_team *ABTI_omp_team_begin(void (*fn)(void *), void *data,
+                                          unsigned num_threads,
+                                          const ABTI_omp_ws *p_ws)
+{
+    ABTI_omp_task *p_parent = ABTI_omp_get_task();
+    ABTI_omp_team *p_outer = p_parent->p_team;
+    ABTI_omp_team *p_team;
+    int i, n, active_level;
+
+    n = num_threads > 0 ? (int)num_threads : omp_get_max_threads();
+    /* A tasklet cannot wait for other threads. */
+    if (p_outer->active_level >= g_ABTI_omp.max_active_levels ||
+        (lp_ABTI_local != NULL && ABTI_local_get_task() != NULL)) {
+        n = 1;
+    }
+    active_level = p_outer->active_level + (n > 1 ? 1 : 0);
+    p_team = ABTI_omp_team_create(n, p_outer->level + 1, active_level);
+    p_team->fn = fn;
+    p_team->data = data;
+    p_team->p_prev = p_parent;
+    if (p_ws) {
+        ABTI_omp_ws *p_ws0 = &p_team->ws[1];
+        ABTI_omp_loop_init(p_ws0, p_ws->sched, p_ws->next, p_ws->end,
+                           p_ws->incr, p_ws->chunk);
+        p_ws0->id = 1;
+        p_ws0->num_left = n;
+        for (i = 0; i < n; i++) {
+            p_team->p_tasks[i].ws_seq = 1;
+            p_team->p_tasks[i].p_ws = p_ws0;
+        }
+    }
+
+    for (i = 1; i < n; i++) {
+        ABT_pool pool = p_team->pools[i % p_team->num_pools];
+        int ret = ABT_thread_create(pool, ABTI_omp_thread_func,
+                                    &p_team->p_tasks[i], ABT_THREAD_ATTR_NULL,
+                                    &p_team->threads[i]);
+        ABTI_ASSERT(ret == ABT_SUCCESS);
+        ABTI_UNUSED(ret);
+    }
+    ABTI_omp_set_task(&p_team->p_tasks[0]);
+    return p_team;
+}
+
+/* The encountering thread waits for the other threads and all the tasks of
+ * the team, which is the implicit barrier at the end of the region. */
+static void ABTI_omp_team_end(ABTI_omp_team *p_team)
+{
+    int i;
+
+    for (i = 1; i < p_team->num_threads; i++) {
+        ABT_thread_free(&p_team->threads[i]);
+    }
+    while (*(volatile uint32_t *)&p_team->num_tasks > 0) {
+        ABTI_omp_yield();
+    }
+    ABTI_omp_set_task(p_team->p_prev);
+    ABTI_omp_team_free(p_team);
+}
+
+/* After all the threads arrive, no implicit task creates tasks, so the
+ * number of tasks of the team becomes zero only when all of them complete.
+ * The waiting ULTs let their ESs run the tasks. */
+static void ABTI_omp_team_barrier(ABTI_omp_team *p_team)
+{
+    if (p_team->num_threads > 1) ABT_barrier_wait(p_team->barrier);
+    while (*(volatile uint32_t *)&p_team->num_tasks > 0) {
+        ABTI_omp_yield();
+    }
+}
+
+static void ABTI_omp_thread_func(void *arg)
+{
+    ABTI_omp_task *p_task = (ABTI_omp_task *)arg;
+    ABTI_omp_set_task(p_task);
+    p_task->p_team->fn(p_task->p_team->data);
+}
+
+static void ABTI_omp_task_func(void *arg)
+{
+    ABTI_omp_task *p_task = (ABTI_omp_task *)arg;
+    ABTI_omp_team *p_team = p_task->p_team;
+    ABTI_omp_taskgroup *p_taskgroup = p_task->p_taskgroup;
+
+    ABTI_omp_set_task(p_task);
+    p_task->fn(p_task->data);
+
+    /* None of them may be touched after its counter is decremented. */
+    ABTI_omp_task_release(p_task);
+    if (p_taskgroup) {
+        ABTD_atomic_fetch_sub_uint32(&p_taskgroup->num_tasks, 1);
+    }
+    ABTD_atomic_fetch_sub_uint32(&p_team->num_tasks, 1);
+}
+
+/* An explicit task is freed when it and all its children complete. */
+static void ABTI_omp_task_release(ABTI_omp_task *p_task)
+{
+    while (ABTD_atomic_fetch_sub_uint32(&p_task->num_refs, 1) == 1) {
+        ABTI_omp_task *p_parent = p_task->p_parent;
+        ABTU_free(p_task);
+        if (p_parent == NULL) break;
+        p_task = p_parent;
+    }
+}
+
+static void ABTI_omp_taskwait(ABTI_omp_task *p_task)
+{
+    while (*(volatile uint32_t *)&p_task->num_refs > 1) {
+        ABTI_omp_yield();
+    }
+}
+
+/* Find the state of the next worksharing construct.  It returns ABT_TRUE if
+ * the caller is the first thread, which has to initialize it.  The state is
+ * locked on return. */
+static ABT_bool ABTI_omp_ws_enter(ABTI_omp_task *p_task)
+{
+    ABTI_omp_team *p_team = p_task->p_team;
+    uint32_t id = ++p_task->ws_seq;
+    ABTI_omp_ws *p_ws = &p_team->ws[id % ABTI_OMP_NUM_WS];
+
+    p_task->p_ws = p_ws;
+    ABTI_spinlock_acquire(&p_ws->lock);
+    /* Wait until the threads leave the older construct. */
+    while (p_ws->id != id && p_ws->num_left > 0) {
+        ABTI_spinlock_release(&p_ws->lock);
+        ABTI_omp_yield();
+        ABTI_spinlock_acquire(&p_ws->lock);
+    }
+    if (p_ws->id == id) return ABT_FALSE;
+
+    p_ws->id = id;
+    p_ws->num_left = p_team->num_threads;
+    return ABT_TRUE;
+}
+
+static void ABTI_omp_ws_leave(ABTI_omp_task *p_task)
+{
+    ABTI_omp_ws *p_ws = p_task->p_ws;
+    ABTI_spinlock_acquire(&p_ws->lock);
+    p_ws->num_left--;
+    ABTI_spinlock_release(&p_ws->lock);
+    p_task->p_ws = NULL;
+}
+
+static void ABTI_omp_loop_init(ABTI_omp_ws *p_ws, ABTI_omp_sched sched,
+                               long start, long end, long incr, long chunk)
+{
+    p_ws->sched = sched;
+    p_ws->next = start;
+    /* An empty loop has end == start. */
+    p_ws->end = ((incr > 0 && start > end) || (incr < 0 && start < end))
+              ? start : end;
+    p_ws->incr = incr;
+    if (sched == ABTI_OMP_SCHED_STATIC) {
+        p_ws->chunk = chunk > 0 ? chunk : 0;
+    } else {
+        p_ws->chunk = chunk > 0 ? chunk : 1;
+    }
+}
+
+static bool ABTI_omp_loop_start(ABTI_omp_sched sched, long start, long end,
+                                long incr, long chunk, long *istart,
+                                long *iend)
+{
+    ABTI_omp_task *p_task = ABTI_omp_get_task();
+
+    if (ABTI_omp_ws_enter(p_task) == ABT_TRUE) {
+        ABTI_omp_loop_init(p_task->p_ws, sched, start, end, incr, chunk);
+    }
+    ABTI_spinlock_release(&p_task->p_ws->lock);
+    p_task->static_trip = 0;
+    return ABTI_omp_loop_next(istart, iend);
+}
+
+/* Take the next chunk of the current loop as [*istart, *iend). */
+static bool ABTI_omp_loop_next(long *istart, long *iend)
+{
+    ABTI_omp_task *p_task = ABTI_omp_get_task();
+    ABTI_omp_ws *p_ws = p_task->p_ws;
+    long nthreads = p_task->p_team->num_threads;
+    long incr = p_ws->incr;
+    long n, start, end;
+
+    if (p_ws->sched == ABTI_OMP_SCHED_STATIC) {
+        /* The fields are not updated, and the k-th chunk of thread i is the
+         * (k * nthreads + i)-th one. */
+        long s, e;
+        n = (p_ws->end - p_ws->next + incr + (incr > 0 ? -1 : 1)) / incr;
+        if (p_ws->chunk == 0) {
+            long q = n / nthreads, t = n % nthreads;
+            if (p_task->static_trip++ > 0) return false;
+            if (p_task->tid < t) {
+                q++;
+                s = q * p_task->tid;
+            } else {
+                s = q * p_task->tid + t;
+            }
+            e = s + q;
+        } else {
+            s = (p_task->static_trip++ * nthreads + p_task->tid)
+              * p_ws->chunk;
+            e = s + p_ws->chunk;
+        }
+        if (s >= n) return false;
+        if (e > n) e = n;
+        *istart = p_ws->next + s * incr;
+        *iend = e == n ? p_ws->end : p_ws->next + e * incr;
+        return s < e;
+    }
+
+    ABTI_spinlock_acquire(&p_ws->lock);
+    start = p_ws->next;
+    if (start == p_ws->end) {
+        ABTI_spinlock_release(&p_ws->lock);
+        return false;
+    }
+    n = (p_ws->end - start + incr + (incr > 0 ? -1 : 1)) / incr;
+    if (p_ws->sched == ABTI_OMP_SCHED_GUIDED) {
+        long q = (n + nthreads - 1) / nthreads;
+        if (q < p_ws->chunk) q = p_ws->chunk;
+        end = q < n ? start + q * incr : p_ws->end;
+    } else {
+        end = p_ws->chunk < n ? start + p_ws->chunk * incr : p_ws->end;
+    }
+    p_ws->next = end;
+    ABTI_spinlock_release(&p_ws->lock);
+
+    *istart = start;
+    *iend = end;
+    return true;
+}
+
+static void ABTI_omp_parallel_loop(void (*fn)(void *), void *data,
+                                   unsigned num_threads, ABTI_omp_sched sched,
+                                   long start, long end, long incr, long chunk)
+{
+    ABTI_omp_team *p_team;
+    ABTI_omp_ws ws;
+
+    ws.sched = sched;
+    ws.next = start;
+    ws.end = end;
+    ws.incr = incr;
+    ws.chunk = chunk;
+    p_team = ABTI_omp_team_begin(fn, data, num_threads, &ws);
+    fn(data);
+    ABTI_omp_team_end(p_team);
+}
+
+#endif /* ABT_CONFIG_USE_OMP */
@@ -0,0 +1,494 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* A parallel loop is executed by tasklets.  The iteration space is first
+ * divided among the given pools, and then each tasklet recursively pushes the
+ * upper half of its range into its own pool as a new tasklet until the range
+ * is not larger than the grain.  Idle ESs can steal the pushed tasklets, which
+ * hold large ranges, from the pools of busy ones. */
+
+typedef struct {
+    void (*body)(size_t, size_t, void *);   /* Loop body */
+    void *arg;                              /* Argument for body */
+    size_t grain;                           /* Maximum range of a leaf */
+    uint64_t num_remains;                   /* Iterations not executed yet */
+    ABT_eventual eventual;                  /* Set when the loop completes */
+} ABTI_pfor;
+
+typedef struct {
+    ABTI_pfor *p_pfor;
+    size_t begin;
+    size_t end;
+} ABTI_pfor_range;
+
+static void ABTI_pfor_run(void *arg);
+static int  ABTI_pfor_spawn(ABTI_pfor *p_pfor, ABT_pool pool, size_t begin,
+                            size_t end);
+static void ABTI_pfor_exec(ABTI_pfor *p_pfor, size_t begin, size_t end);
+
+/* A reduction keeps one partial result per ES, each in its own cache lines,
+ * so that tasklets, which run to completion, fold their ranges into the slot
+ * of their ES without synchronization.  Partial results of the others, i.e.,
+ * the caller and ESs created after the reduction started, are folded into the
+ * shared slot under the lock. */
+typedef struct {
+    void (*body)(size_t, size_t, void *, void *);
+    void (*combine)(void *, const void *, void *);
+    void *arg;
+    size_t size;                /* Size of a result */
+    const void *identity;
+    int num_slots;              /* # of per-ES slots */
+    size_t slot_stride;         /* Bytes per slot, a multiple of cache lines */
+    size_t used_offset;         /* Offset of the used flag in a slot */
+    char *p_slots;              /* num_slots + 1 slots; the last is shared */
+    ABTI_spinlock lock;         /* Protects the shared slot */
+} ABTI_preduce;
+
+/* A scan is executed in two passes over blocks of grain iterations.  The
+ * first pass reduces every block, and the second one calls the body with the
+ * prefix of the block to produce the final values. */
+typedef struct {
+    void (*body)(size_t, size_t, void *, ABT_bool, void *);
+    void *arg;
+    size_t size;
+    const void *identity;
+    size_t begin;
+    size_t end;
+    size_t grain;
+    char *p_sums;               /* Result of each block, then its prefix */
+} ABTI_pscan;
+
+static void ABTI_preduce_body(size_t begin, size_t end, void *arg);
+static void ABTI_pscan_up(size_t begin, size_t end, void *arg);
+static void ABTI_pscan_down(size_t begin, size_t end, void *arg);
+
+
+/** @defgroup PARALLEL Parallel Loop
+ * This group is for parallel loops, reductions, and scans built on tasklets.
+ */
+
+/**
+ * @ingroup PARALLEL
+ * @brief   Execute a loop in parallel with tasklets.
+ *
+ * \c ABT_parallel_for() executes \c body for the iteration space
+ * [\c begin, \c end) with tasklets and returns when all the iterations have
+ * been executed.  \c body is called as <tt>body(b, e, arg)</tt> for disjoint
+ * subranges [\c b, \c e) that cover the iteration space, and each subrange
+ * has at most \c grain iterations.  If \c grain is zero, it is regarded as
+ * one.
+ *
+ * The iteration space is divided evenly among the \c num_pools pools in
+ * \c pools, which are usually the main pools of all ESs.  Then, each tasklet
+ * recursively splits its range into halves and pushes the upper half into the
+ * pool where the tasklet has been scheduled.  Schedulers that steal work
+ * units, e.g., \c ABT_SCHED_RANDWS with \c ABT_POOL_DEQUE pools, balance the
+ * load.  Since the caller and the tasklets push tasklets into the pools from
+ * different ESs, the access types of the pools have to allow multiple
+ * producers.  If a tasklet cannot be pushed, its range is executed by the ULT
+ * or the tasklet that tried to push it.
+ *
+ * This routine has to be called by a ULT or an external thread, which is
+ * blocked until the loop completes.
+ *
+ * @param[in] num_pools  the number of pools in \c pools
+ * @param[in] pools      pools into which tasklets are pushed
+ * @param[in] begin      the first iteration
+ * @param[in] end        the iteration next to the last one
+ * @param[in] grain      the maximum number of iterations given to \c body
+ * @param[in] body       loop body
+ * @param[in] arg        argument for \c body
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_INV_POOL invalid pool
+ * @retval ABT_ERR_INV_TASK the caller is a tasklet
+ */
+int ABT_parallel_for(int num_pools, ABT_pool *pools, size_t begin, size_t end,
+                     size_t grain, void (*body)(size_t, size_t, void *),
+                     void *arg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pfor *p_pfor;
+    size_t num_iters, chunk, rem, b, e;
+    int i;
+
+    /* A tasklet cannot wait for the completion of the loop. */
+    ABTI_CHECK_TRUE(lp_ABTI_local == NULL || ABTI_local_get_task() == NULL,
+                    ABT_ERR_INV_TASK);
+    ABTI_CHECK_TRUE(num_pools > 0, ABT_ERR_INV_POOL);
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[i]);
+        ABTI_CHECK_NULL_POOL_PTR(p_pool);
+    }
+    if (begin >= end) goto fn_exit;
+
+    num_iters = end - begin;
+    p_pfor = (ABTI_pfor *)ABTU_malloc(sizeof(ABTI_pfor));
+    p_pfor->body = body;
+    p_pfor->arg = arg;
+    p_pfor->grain = (grain == 0) ? 1 : grain;
+    p_pfor->num_remains = (uint64_t)num_iters;
+    abt_errno = ABT_eventual_create(0, &p_pfor->eventual);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_pfor);
+        goto fn_fail;
+    }
+
+    /* Divide the iteration space among the pools */
+    if ((size_t)num_pools > num_iters) num_pools = (int)num_iters;
+    chunk = num_iters / num_pools;
+    rem = num_iters % num_pools;
+    b = begin;
+    for (i = 0; i < num_pools; i++) {
+        e = b + chunk + (((size_t)i < rem) ? 1 : 0);
+        if (ABTI_pfor_spawn(p_pfor, pools[i], b, e) != ABT_SUCCESS) {
+            ABTI_pfor_exec(p_pfor, b, e);
+        }
+        b = e;
+    }
+
+    /* Wait for all the iterations */
+    abt_errno = ABT_eventual_wait(p_pfor->eventual, NULL);
+    ABT_eventual_free(&p_pfor->eventual);
+    ABTU_free(p_pfor);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup PARALLEL
+ * @brief   Execute a reduction in parallel with tasklets.
+ *
+ * \c ABT_parallel_reduce() reduces the iteration space [\c begin, \c end)
+ * into \c result, whose size is \c size bytes.  \c body is called as
+ * <tt>body(b, e, acc, arg)</tt> for disjoint subranges [\c b, \c e) of at
+ * most \c grain iterations and folds them into the partial result \c acc,
+ * which starts as a copy of \c identity.  Partial results are merged by
+ * <tt>combine(dst, src, arg)</tt>, which folds \c src into \c dst.  Since the
+ * subranges folded into a partial result are not contiguous, \c combine and
+ * \c body have to be associative and commutative.
+ *
+ * The loop is executed as \c ABT_parallel_for().  Each ES keeps its own
+ * partial result, padded to cache lines, which the tasklets on the ES update
+ * in place.  When the loop completes, the partial results of the ESs are
+ * combined in a tree.  If the iteration space is empty, \c result is set to
+ * \c identity.
+ *
+ * This routine has to be called by a ULT or an external thread, which is
+ * blocked until the reduction completes.
+ *
+ * @param[in]  num_pools  the number of pools in \c pools
+ * @param[in]  pools      pools into which tasklets are pushed
+ * @param[in]  begin      the first iteration
+ * @param[in]  end        the iteration next to the last one
+ * @param[in]  grain      the maximum number of iterations given to \c body
+ * @param[in]  size       the size of a result in bytes
+ * @param[in]  identity   identity of \c combine
+ * @param[in]  body       function folding iterations into a partial result
+ * @param[in]  combine    function folding a partial result into another
+ * @param[in]  arg        argument for \c body and \c combine
+ * @param[out] result     result of the reduction
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_INV_POOL invalid pool
+ * @retval ABT_ERR_INV_TASK the caller is a tasklet
+ */
+int ABT_parallel_reduce(int num_pools, ABT_pool *pools, size_t begin,
+                        size_t end, size_t grain, size_t size,
+                        const void *identity,
+                        void (*body)(size_t, size_t, void *, void *),
+                        void (*combine)(void *, const void *, void *),
+                        void *arg, void *result)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_preduce red;
+    void **pp_partials;
+    int i, num_partials, stride;
+
+    red.body = body;
+    red.combine = combine;
+    red.arg = arg;
+    red.size = size;
+    red.identity = identity;
+    red.num_slots = gp_ABTI_global->max_xstreams;
+    red.used_offset = (size + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+    red.slot_stride = (red.used_offset + sizeof(int) +
+                       ABT_CONFIG_CACHE_LINE_SIZE - 1) /
+                      ABT_CONFIG_CACHE_LINE_SIZE * ABT_CONFIG_CACHE_LINE_SIZE;
+    red.p_slots = (char *)ABTU_malloc_cache_aligned(
+                      red.slot_stride * (red.num_slots + 1));
+    for (i = 0; i <= red.num_slots; i++) {
+        *(int *)(red.p_slots + i * red.slot_stride + red.used_offset) = 0;
+    }
+    ABTI_spinlock_create(&red.lock);
+
+    abt_errno = ABT_parallel_for(num_pools, pools, begin, end, grain,
+                                 ABTI_preduce_body, (void *)&red);
+    if (abt_errno != ABT_SUCCESS) goto fn_free;
+
+    /* Combine the used slots in a tree */
+    pp_partials = (void **)ABTU_malloc(sizeof(void *) * (red.num_slots + 1));
+    num_partials = 0;
+    for (i = 0; i <= red.num_slots; i++) {
+        char *p_slot = red.p_slots + i * red.slot_stride;
+        if (*(int *)(p_slot + red.used_offset)) {
+            pp_partials[num_partials++] = (void *)p_slot;
+        }
+    }
+    for (stride = 1; stride < num_partials; stride *= 2) {
+        for (i = 0; i + stride < num_partials; i += 2 * stride) {
+            combine(pp_partials[i], pp_partials[i + stride], arg);
+        }
+    }
+    memcpy(result, num_partials ? pp_partials[0] : identity, size);
+    ABTU_free(pp_partials);
+
+  fn_free:
+    ABTI_spinlock_free(&red.lock);
+    ABTU_free(red.p_slots);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup PARALLEL
+ * @brief   Execute an inclusive scan in parallel with tasklets.
+ *
+ * \c ABT_parallel_scan() computes the prefixes of the iteration space
+ * [\c begin, \c end) in two passes.  The space is divided into blocks of
+ * \c grain iterations, and \c body is called as
+ * <tt>body(b, e, acc, final, arg)</tt> for each block [\c b, \c e).  \c body
+ * folds the iterations into \c acc in order.  In the first pass, \c final is
+ * \c ABT_FALSE and \c acc starts as a copy of \c identity, so \c body only
+ * computes the result of the block.  In the second pass, \c final is
+ * \c ABT_TRUE and \c acc starts as the prefix of all the preceding blocks, so
+ * \c body can store the prefix of each iteration.  The results of the blocks
+ * are combined in order by <tt>combine(dst, src, arg)</tt>, which has to be
+ * associative.  The result of the whole space is returned through \c result
+ * if it is not \c NULL.
+ *
+ * The passes are executed as \c ABT_parallel_for() over the blocks, so the
+ * conditions of \c ABT_parallel_for() apply.
+ *
+ * @param[in]  num_pools  the number of pools in \c pools
+ * @param[in]  pools      pools into which tasklets are pushed
+ * @param[in]  begin      the first iteration
+ * @param[in]  end        the iteration next to the last one
+ * @param[in]  grain      the number of iterations in a block
+ * @param[in]  size       the size of a result in bytes
+ * @param[in]  identity   identity of \c combine
+ * @param[in]  body       function folding a block into a result
+ * @param[in]  combine    function folding a result into the preceding one
+ * @param[in]  arg        argument for \c body and \c combine
+ * @param[out] result     result of the whole space (may be \c NULL)
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_INV_POOL invalid pool
+ * @retval ABT_ERR_INV_TASK the caller is a tasklet
+ */
+int ABT_parallel_scan(int num_pools, ABT_pool *pools, size_t begin,
+                      size_t end, size_t grain, size_t size,
+                      const void *identity,
+                      void (*body)(size_t, size_t, void *, ABT_bool, void *),
+                      void (*combine)(void *, const void *, void *),
+                      void *arg, void *result)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_pscan scan;
+    size_t num_blocks, k;
+    char *p_total, *p_tmp;
+
+    if (grain == 0) grain = 1;
+    num_blocks = (begin < end) ? (end - begin + grain - 1) / grain : 0;
+
+    scan.body = body;
+    scan.arg = arg;
+    scan.size = size;
+    scan.identity = identity;
+    scan.begin = begin;
+    scan.end = end;
+    scan.grain = grain;
+    scan.p_sums = (char *)ABTU_malloc(size * (num_blocks + 2));
+    p_total = scan.p_sums + size * num_blocks;
+    p_tmp = p_total + size;
+    memcpy(p_total, identity, size);
+
+    /* The last block is not needed for the prefixes. */
+    if (num_blocks > 1) {
+        abt_errno = ABT_parallel_for(num_pools, pools, 0, num_blocks - 1, 1,
+                                     ABTI_pscan_up, (void *)&scan);
+        if (abt_errno != ABT_SUCCESS) goto fn_free;
+    }
+
+    /* Replace the result of each block with its prefix */
+    for (k = 0; k < num_blocks; k++) {
+        char *p_sum = scan.p_sums + size * k;
+        if (k + 1 < num_blocks) memcpy(p_tmp, p_sum, size);
+        memcpy(p_sum, p_total, size);
+        if (k + 1 < num_blocks) combine(p_total, p_tmp, arg);
+    }
+
+    abt_errno = ABT_parallel_for(num_pools, pools, 0, num_blocks, 1,
+                                 ABTI_pscan_down, (void *)&scan);
+    if (abt_errno != ABT_SUCCESS) goto fn_free;
+
+    /* The last block has left the result of the whole space. */
+    if (result) {
+        memcpy(result, num_blocks ? scan.p_sums + size * (num_blocks - 1)
+                                  : identity, size);
+    }
+
+  fn_free:
+    ABTU_free(scan.p_sums);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void ABTI_pfor_run(void *arg)
+{
+    ABTI_pfor_range *p_range = (ABTI_pfor_range *)arg;
+    ABTI_pfor *p_pfor = p_range->p_pfor;
+    size_t begin = p_range->begin;
+    size_t end = p_range->end;
+    ABTI_task *p_task = ABTI_local_get_task();
+    ABT_pool pool = ABTI_pool_get_handle(p_task->p_pool);
+
+    ABTU_free(p_range);
+
+    /* Give the upper half to other tasklets until the range fits the grain */
+    while (end - begin > p_pfor->grain) {
+        size_t mid = begin + (end - begin) / 2;
+        if (ABTI_pfor_spawn(p_pfor, pool, mid, end) != ABT_SUCCESS) break;
+        end = mid;
+    }
+
+    ABTI_pfor_exec(p_pfor, begin, end);
+}
+
+static int ABTI_pfor_spawn(ABTI_pfor *p_pfor, ABT_pool pool, size_t begin,
+                           size_t end)
+{
+    int abt_errno;
+    ABTI_pfor_range *p_range;
+
+    p_range = (ABTI_pfor_range *)ABTU_malloc(sizeof(ABTI_pfor_range));
+    p_range->p_pfor = p_pfor;
+    p_range->begin = begin;
+    p_range->end = end;
+
+    abt_errno = ABT_task_create(pool, ABTI_pfor_run, (void *)p_range, NULL);
+    if (abt_errno != ABT_SUCCESS) ABTU_free(p_range);
+    return abt_errno;
+}
+
+/* Execute [begin, end) without splitting it further. */
+static void ABTI_pfor_exec(ABTI_pfor *p_pfor, size_t begin, size_t end)
+{
+    size_t b, e;
+    uint64_t num_iters = (uint64_t)(end - begin);
+
+    for (b = begin; b < end; b = e) {
+        e = (end - b > p_pfor->grain) ? b + p_pfor->grain : end;
+        p_pfor->body(b, e, p_pfor->arg);
+    }
+
+    /* The last one to finish signals the caller. */
+    if (ABTD_atomic_fetch_sub_uint64(&p_pfor->num_remains, num_iters)
+        == num_iters) {
+        ABT_eventual_set(p_pfor->eventual, NULL, 0);
+    }
+}
+
+static void ABTI_preduce_body(size_t begin, size_t end, void *arg)
+{
+    ABTI_preduce *p_red = (ABTI_preduce *)arg;
+    ABTI_local *p_local = lp_ABTI_local;
+    char *p_slot;
+    int *p_used;
+    void *p_acc;
+
+    /* A tasklet owns the slot of its ES while it runs. */
+    if (p_local != NULL && ABTI_local_get_task() != NULL &&
+        p_local->p_xstream->rank < (uint64_t)p_red->num_slots) {
+        p_slot = p_red->p_slots + p_local->p_xstream->rank * p_red->slot_stride;
+        p_used = (int *)(p_slot + p_red->used_offset);
+        if (*p_used == 0) {
+            memcpy(p_slot, p_red->identity, p_red->size);
+            *p_used = 1;
+        }
+        p_red->body(begin, end, (void *)p_slot, p_red->arg);
+        return;
+    }
+
+    /* Others may block in body, so they fold the range privately. */
+    p_acc = ABTU_malloc(p_red->size);
+    memcpy(p_acc, p_red->identity, p_red->size);
+    p_red->body(begin, end, p_acc, p_red->arg);
+
+    p_slot = p_red->p_slots + p_red->num_slots * p_red->slot_stride;
+    p_used = (int *)(p_slot + p_red->used_offset);
+    ABTI_spinlock_acquire(&p_red->lock);
+    if (*p_used == 0) {
+        memcpy(p_slot, p_acc, p_red->size);
+        *p_used = 1;
+    } else {
+        p_red->combine((void *)p_slot, p_acc, p_red->arg);
+    }
+    ABTI_spinlock_release(&p_red->lock);
+    ABTU_free(p_acc);
+}
+
+static void ABTI_pscan_up(size_t begin, size_t end, void *arg)
+{
+    ABTI_pscan *p_scan = (ABTI_pscan *)arg;
+    size_t k, b;
+
+    for (k = begin; k < end; k++) {
+        char *p_sum = p_scan->p_sums + p_scan->size * k;
+        b = p_scan->begin + k * p_scan->grain;
+        memcpy(p_sum, p_scan->identity, p_scan->size);
+        p_scan->body(b, b + p_scan->grain, (void *)p_sum, ABT_FALSE,
+                     p_scan->arg);
+    }
+}
+
+static void ABTI_pscan_down(size_t begin, size_t end, void *arg)
+{
+    ABTI_pscan *p_scan = (ABTI_pscan *)arg;
+    size_t k, b, e;
+
+    for (k = begin; k < end; k++) {
+        b = p_scan->begin + k * p_scan->grain;
+        e = (p_scan->end - b > p_scan->grain) ? b + p_scan->grain
+                                              : p_scan->end;
+        p_scan->body(b, e, (void *)(p_scan->p_sums + p_scan->size * k),
+                     ABT_TRUE, p_scan->arg);
+    }
+}
@@ -5,6 +5,13 @@
 
 abt_sources += \
 	pool/fifo.c \
+	pool/fifo_lockfree.c \
 	pool/pool.c \
+	pool/pool_group.c \
+	pool/pool_stats.c \
+	pool/prio.c \
+	pool/edf.c \
+	pool/ring.c \
+	pool/multiq.c \
 	pool/deque.c
 
@@ -1,19 +1,172 @@
 #include "abti.h"
 #include <stdatomic.h>
 
-// Deque pool implementation based on the .NET Framework's WorkStealingQueue
-// (https://referencesource.microsoft.com/#mscorlib/system/threading/threadpool.cs,c6809900d25746e6).
+// Deque pool implementation based on the Chase-Lev work-stealing deque, with
+// the C11 memory orderings given in N. M. Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (PPoPP '13).
+//
+// The owner pushes and pops at the bottom without any atomic RMW except when
+// racing for the last element; thieves take units from the top with a single
+// CAS.  When the circular array is full, the owner copies the live range into
+// an array twice as large, and when it is less than 1/8 full, into an array
+// half as large (never smaller than INITIAL_LENGTH).  Neither blocks thieves:
+// the copy is published with one store, and a thief still reading the old
+// array finds the same units at the same indices.
+//
+// Retired arrays are chained from the current one.  Thieves and remove count
+// themselves in num_readers while they may use an array, and the owner frees
+// the chain at its next push or pop when it sees no reader.  A reader that
+// registers after the owner published the new array reads the new one, since
+// both sides order the two accesses with seq_cst fences.
+//
+// A unit is owned by whoever first clears its pool field.  pop and steal do
+// this after winning their index, and remove does it directly, so a unit that
+// has been removed is just skipped when its slot is reached later.
+//
+// The array holds 32-bit references to units instead of pointers while every
+// unit pushed so far falls in a 32 GB window, which covers the descriptors in
+// the memory pools of all ESs in practice.  A reference is the offset of the
+// unit from the process-wide base of the window in 8-byte words, and 0 means
+// NULL.  When a unit outside the window is pushed, the owner copies the live
+// range into an array of pointers of the same length, which is published and
+// read by thieves in the same way as a resized array.  Each array records
+// which representation it uses, so thieves still reading an old array decode
+// it correctly.
+//
+// top and bottom are 64-bit counters that are never reset; only their low
+// bits index the array, and their distance is taken as a signed difference,
+// so they are correct across wraparound.  The size counts the units between
+// them minus the removed ones that are still waiting to be skipped.
+
+typedef struct array {
+    size_t mask;
+    struct array *p_prev;           // retired arrays
+    ABT_bool compact;               // refs is used instead of units
+    union {
+        _Atomic(ABTI_unit *) *units;
+        _Atomic uint32_t *refs;
+    } buf;                          // follows this header
+} array_t;
 
 typedef struct data {
-    ABTI_unit **unit_array;
-    size_t array_length;
-    size_t mask;
-    size_t head_idx;
-    size_t tail_idx;
-    ABTI_spinlock foreign_lock;
+    _Atomic uint64_t top ABTI_CACHE_ALIGNED;    // thieves' end
+    _Atomic size_t num_readers;                 // thieves and removers
+    _Atomic int64_t num_removed;                // removed but not skipped
+    _Atomic uint64_t bottom ABTI_CACHE_ALIGNED; // owner's end
+    _Atomic(array_t *) array;
 } data_t;
 
 static size_t const INITIAL_LENGTH = 256;
+static size_t const SHRINK_RATIO = 8;
+
+#define UNIT_REF_SHIFT  3           // units are 8-byte aligned
+
+// Base of the window of 32-bit references plus one, or 0 if it is not set
+static _Atomic uintptr_t g_unit_base = 0;
+
+// Center the window at the first unit that is pushed to any deque.
+static uintptr_t unit_base_init(uintptr_t addr)
+{
+    uintptr_t half = (uintptr_t)1 << (31 + UNIT_REF_SHIFT);
+    uintptr_t base = (addr > half) ? addr - half : 0;
+    uintptr_t expected = 0;
+    base &= ~(((uintptr_t)1 << UNIT_REF_SHIFT) - 1);
+    if (atomic_compare_exchange_strong(&g_unit_base, &expected, base + 1)) {
+        return base;
+    }
+    return expected - 1;
+}
+
+// Return the 32-bit reference to unit, or 0 if it is out of the window.
+static inline uint32_t unit_ref(ABTI_unit *unit)
+{
+    uintptr_t addr = (uintptr_t)unit;
+    uintptr_t base = atomic_load_explicit(&g_unit_base, memory_order_relaxed);
+    base = base ? base - 1 : unit_base_init(addr);
+    if (addr <= base || (addr & (((uintptr_t)1 << UNIT_REF_SHIFT) - 1))) {
+        return 0;
+    }
+    uintptr_t ref = (addr - base) >> UNIT_REF_SHIFT;
+    return (ref <= UINT32_MAX) ? (uint32_t)ref : 0;
+}
+
+static inline ABTI_unit *unit_deref(uint32_t ref)
+{
+    if (ref == 0) return NULL;
+    uintptr_t base = atomic_load_explicit(&g_unit_base, memory_order_relaxed);
+    return (ABTI_unit *)(base - 1 + ((uintptr_t)ref << UNIT_REF_SHIFT));
+}
+
+static array_t *array_create(size_t length, ABT_bool compact,
+                             array_t *p_prev)
+{
+    size_t slot_size = compact ? sizeof(uint32_t) : sizeof(ABTI_unit *);
+    array_t *a = ABTU_malloc(sizeof(array_t) + length * slot_size);
+    a->mask = length - 1;
+    a->p_prev = p_prev;
+    a->compact = compact;
+    if (compact) {
+        a->buf.refs = (_Atomic uint32_t *)(a + 1);
+        for (size_t i = 0; i < length; i++) {
+            atomic_init(&a->buf.refs[i], 0);
+        }
+    } else {
+        a->buf.units = (_Atomic(ABTI_unit *) *)(a + 1);
+        for (size_t i = 0; i < length; i++) {
+            atomic_init(&a->buf.units[i], NULL);
+        }
+    }
+    return a;
+}
+
+// The slots are accessed with relaxed orderings; top and bottom order them.
+static inline ABTI_unit *slot_load(array_t *a, uint64_t i)
+{
+    if (a->compact) {
+        return unit_deref(atomic_load_explicit(&a->buf.refs[i & a->mask],
+                                               memory_order_relaxed));
+    }
+    return atomic_load_explicit(&a->buf.units[i & a->mask],
+                                memory_order_relaxed);
+}
+
+// unit must be NULL or have a reference if a is compact.
+static inline void slot_store(array_t *a, uint64_t i, ABTI_unit *unit)
+{
+    if (a->compact) {
+        atomic_store_explicit(&a->buf.refs[i & a->mask],
+                              unit ? unit_ref(unit) : 0,
+                              memory_order_relaxed);
+    } else {
+        atomic_store_explicit(&a->buf.units[i & a->mask], unit,
+                              memory_order_relaxed);
+    }
+}
+
+// Clear the slot if it holds unit.
+static inline ABT_bool slot_clear(array_t *a, uint64_t i, ABTI_unit *unit)
+{
+    if (a->compact) {
+        uint32_t expected = unit_ref(unit);
+        return (expected != 0 &&
+                atomic_compare_exchange_strong(&a->buf.refs[i & a->mask],
+                                               &expected, 0))
+               ? ABT_TRUE : ABT_FALSE;
+    }
+    ABTI_unit *expected = unit;
+    return atomic_compare_exchange_strong(&a->buf.units[i & a->mask],
+                                          &expected, NULL)
+           ? ABT_TRUE : ABT_FALSE;
+}
+
+// Take the ownership of a unit found in the deque.
+static inline ABT_bool unit_claim(ABTI_pool *self, ABTI_unit *unit)
+{
+    uint64_t pool = (uint64_t)ABTI_pool_get_handle(self);
+    return ABTD_atomic_cas_uint64((uint64_t *)&unit->pool, pool,
+                                  (uint64_t)ABT_POOL_NULL) == pool
+           ? ABT_TRUE : ABT_FALSE;
+}
 
 /* Pool functions */
 
@@ -22,19 +175,13 @@ static int deque_init(ABT_pool pool, ABT_pool_config config)
     ABTI_UNUSED(config);
     int abt_errno = ABT_SUCCESS;
 
-    data_t *p_data = ABTU_malloc(sizeof(data_t));
+    data_t *p_data = ABTU_malloc_cache_aligned(sizeof(data_t));
 
-    p_data->unit_array = ABTU_malloc(INITIAL_LENGTH * sizeof(ABTI_unit *));
-#ifdef ABT_CONFIG_USE_DEBUG_LOG
-    for (int i = 0; i < INITIAL_LENGTH; i++) {
-        p_data->unit_array[i] = (1ULL << 63) + i;
-    }
-#endif
-    p_data->array_length = INITIAL_LENGTH;
-    p_data->mask = INITIAL_LENGTH - 1;
-    p_data->head_idx = 0;
-    p_data->tail_idx = 0;
-    ABTI_spinlock_create(&p_data->foreign_lock);
+    atomic_init(&p_data->top, 0);
+    atomic_init(&p_data->num_readers, 0);
+    atomic_init(&p_data->num_removed, 0);
+    atomic_init(&p_data->bottom, 0);
+    atomic_init(&p_data->array, array_create(INITIAL_LENGTH, ABT_TRUE, NULL));
 
     ABT_pool_set_data(pool, p_data);
 
@@ -45,276 +192,342 @@ static int deque_free(ABT_pool pool)
 {
     int abt_errno = ABT_SUCCESS;
     data_t *p_data;
-    ABT_pool_get_data(pool, &p_data);
+    ABT_pool_get_data(pool, (void **)&p_data);
 
-    ABTU_free(p_data->unit_array);
-    ABTI_spinlock_free(&p_data->foreign_lock);
+    array_t *a = atomic_load_explicit(&p_data->array, memory_order_relaxed);
+    while (a) {
+        array_t *p_prev = a->p_prev;
+        ABTU_free(a);
+        a = p_prev;
+    }
     ABTU_free(p_data);
 
     return abt_errno;
 }
 
+// Read top again after bottom so that both are from the same moment; a
+// thief that moved top in between only makes it read them again.  A unit
+// being popped by the owner is already excluded from bottom.
 static size_t deque_get_size(ABTI_pool *self)
 {
     data_t *m = self->data;
-    // cheap but inaccurate calculation
-    return m->tail_idx - m->head_idx;
+    uint64_t t, b;
+    int64_t size;
+
+    t = atomic_load_explicit(&m->top, memory_order_acquire);
+    while (1) {
+        b = atomic_load_explicit(&m->bottom, memory_order_acquire);
+        uint64_t t2 = atomic_load_explicit(&m->top, memory_order_acquire);
+        if (t2 == t) break;
+        t = t2;
+    }
+    size = (int64_t)(b - t) -
+           atomic_load_explicit(&m->num_removed, memory_order_relaxed);
+    return size > 0 ? (size_t)size : 0;
 }
 
-static void deque_push(ABTI_pool *self, ABTI_unit *unit)
+// A removed unit has been skipped at its index.
+static inline void deque_skip_removed(data_t *m)
 {
-    data_t *m = self->data;
-
-    size_t tail = m->tail_idx;
+    atomic_fetch_sub_explicit(&m->num_removed, 1, memory_order_relaxed);
+}
 
-    // We're going to increment the tail; if we'll overflow, then we need to reset our counts.
-    if (tail == SIZE_MAX) {
-        ABTI_spinlock_acquire(&m->foreign_lock);
-        if (m->tail_idx == SIZE_MAX) {
-            m->head_idx = m->head_idx & m->mask;
-            m->tail_idx = tail = m->tail_idx & m->mask;
+// Copy the live range into an array of the given length and representation
+// and publish it.
+static array_t *deque_resize(data_t *m, array_t *a, size_t length,
+                             ABT_bool compact, uint64_t t, uint64_t b)
+{
+    array_t *new_a = array_create(length, compact, a);
+    if (compact && a->compact) {
+        for (uint64_t i = t; i != b; i++) {
+            uint32_t ref = atomic_load_explicit(&a->buf.refs[i & a->mask],
+                                                memory_order_relaxed);
+            atomic_store_explicit(&new_a->buf.refs[i & new_a->mask], ref,
+                                  memory_order_relaxed);
         }
-        ABTI_spinlock_release(&m->foreign_lock);
-    }
-
-    // When there are at least 2 elements' worth of space, we can take the fast path.
-    if (tail < m->head_idx + m->mask) {
-        m->unit_array[tail & m->mask] = unit;
-        m->tail_idx = tail + 1;
     } else {
-        // We need to contend with foreign pops, so we lock.
-        ABTI_spinlock_acquire(&m->foreign_lock);
-
-        size_t head = m->head_idx;
-        size_t count = m->tail_idx - m->head_idx;
-
-        // If there is still space (one left), just add the element.
-        if (count >= m->mask) {
-            // We're full; expand the queue by doubling its size.
-            size_t new_length = m->array_length << 1;
-            ABTI_unit **new_array = ABTU_malloc(new_length * sizeof(ABTI_unit *));
-            for (int i = 0; i < m->array_length; i++) {
-                new_array[i] = m->unit_array[(i + head) & m->mask];
-            }
-
-            // Reset the field values, incl. the mask.
-            ABTU_free(m->unit_array);
-            m->unit_array = new_array;
-            m->array_length = new_length;
-            m->head_idx = 0;
-            m->tail_idx = tail = count;
-            m->mask = (m->mask << 1) | 1;
+        for (uint64_t i = t; i != b; i++) {
+            slot_store(new_a, i, slot_load(a, i));
         }
+    }
+    atomic_store_explicit(&m->array, new_a, memory_order_release);
+    return new_a;
+}
 
-        m->unit_array[tail & m->mask] = unit;
-        m->tail_idx = tail + 1;
+static inline array_t *deque_grow(data_t *m, array_t *a, uint64_t t,
+                                  uint64_t b)
+{
+    return deque_resize(m, a, (a->mask + 1) << 1, a->compact, t, b);
+}
 
-        ABTI_spinlock_release(&m->foreign_lock);
+// Switch to pointers if unit has no 32-bit reference.
+static inline array_t *deque_widen(ABTI_pool *self, data_t *m, array_t *a,
+                                   ABTI_unit *unit, uint64_t t, uint64_t b)
+{
+    if (a->compact && unit_ref(unit) == 0) {
+        a = deque_resize(m, a, a->mask + 1, ABT_FALSE, t, b);
+        ABTI_pool_stats_add(self, ABTI_POOL_STATS_RESIZE, 1);
     }
+    return a;
 }
 
-static ABT_unit deque_pop_local(ABTI_pool *self)
+// Free the retired arrays if nobody can be reading them.  Called only by the
+// owner.
+static void deque_reclaim(data_t *m, array_t *a)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&m->num_readers, memory_order_relaxed) != 0) {
+        return;
+    }
+    array_t *p_prev = a->p_prev;
+    a->p_prev = NULL;
+    while (p_prev) {
+        array_t *p_next = p_prev->p_prev;
+        ABTU_free(p_prev);
+        p_prev = p_next;
+    }
+}
+
+// Halve the array after a burst has drained, which thieves may have done
+// while the owner was busy, so the owner checks at both push and pop.
+static inline array_t *deque_shrink(data_t *m, array_t *a, uint64_t t,
+                                    uint64_t b)
+{
+    if (a->mask + 1 > INITIAL_LENGTH &&
+        (int64_t)(b - t) < (int64_t)((a->mask + 1) / SHRINK_RATIO)) {
+        a = deque_resize(m, a, (a->mask + 1) >> 1, a->compact, t, b);
+    }
+    if (a->p_prev) deque_reclaim(m, a);
+    return a;
+}
+
+static inline void reader_enter(data_t *m)
+{
+    atomic_fetch_add_explicit(&m->num_readers, 1, memory_order_seq_cst);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+static inline void reader_exit(data_t *m)
+{
+    atomic_fetch_sub_explicit(&m->num_readers, 1, memory_order_release);
+}
+
+static void deque_push(ABTI_pool *self, ABTI_unit *unit)
 {
     data_t *m = self->data;
 
-    while (1) {
-        // Decrement the tail using a fence to ensure subsequent read doesn't come before.
-        size_t tail = m->tail_idx;
-        if (m->head_idx >= tail) {
-            return ABT_UNIT_NULL;
-        }
+    uint64_t b = atomic_load_explicit(&m->bottom, memory_order_relaxed);
+    uint64_t t = atomic_load_explicit(&m->top, memory_order_acquire);
+    array_t *a = atomic_load_explicit(&m->array, memory_order_relaxed);
 
-        tail -= 1;
-        __sync_lock_test_and_set(&m->tail_idx, tail);
-
-        // If there is no interaction with a take, we can head down the fast path.
-        if (m->head_idx <= tail) {
-            size_t idx = tail & m->mask;
-            ABTI_unit *unit = m->unit_array[idx];
-
-            // Check for nulls in the array.
-            if (unit == ABT_UNIT_NULL) {
-                continue;
-            }
-
-            m->unit_array[idx] = ABT_UNIT_NULL;
-            return unit;
-        } else {
-            // Interaction with takes: 0 or 1 elements left.
-            ABTI_spinlock_acquire(&m->foreign_lock);
-
-            if (m->head_idx <= tail) {
-                // Element still available. Take it.
-                size_t idx = tail & m->mask;
-                ABTI_unit *unit = m->unit_array[idx];
-
-                // Check for nulls in the array.
-                if (unit == ABT_UNIT_NULL) {
-                    continue;
-                }
-
-                m->unit_array[idx] = ABT_UNIT_NULL;
-                ABTI_spinlock_release(&m->foreign_lock);
-                return unit;
-            } else {
-                // Element was stolen, restore the tail.
-                m->tail_idx = tail + 1;
-                ABTI_spinlock_release(&m->foreign_lock);
-                return ABT_UNIT_NULL;
-            }
-        }
+    if (b - t > a->mask) {
+        a = deque_grow(m, a, t, b);
+        ABTI_pool_stats_add(self, ABTI_POOL_STATS_RESIZE, 1);
+    } else {
+        a = deque_shrink(m, a, t, b);
     }
+    a = deque_widen(self, m, a, unit, t, b);
+
+    unit->pool = ABTI_pool_get_handle(self);
+    slot_store(a, b, unit);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&m->bottom, b + 1, memory_order_relaxed);
 }
 
-// called from sched_randws directly
-ABT_unit deque_pop_steal(ABTI_pool *self)
+static ABT_unit deque_pop_local(ABTI_pool *self)
 {
     data_t *m = self->data;
+    array_t *a = atomic_load_explicit(&m->array, memory_order_relaxed);
+
+    if (a->mask + 1 > INITIAL_LENGTH || a->p_prev) {
+        uint64_t b = atomic_load_explicit(&m->bottom, memory_order_relaxed);
+        uint64_t t = atomic_load_explicit(&m->top, memory_order_acquire);
+        deque_shrink(m, a, t, b);
+    }
 
     while (1) {
-        if (m->head_idx >= m->tail_idx) {
+        uint64_t b = atomic_load_explicit(&m->bottom, memory_order_relaxed) - 1;
+        array_t *a = atomic_load_explicit(&m->array, memory_order_relaxed);
+        atomic_store_explicit(&m->bottom, b, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t t = atomic_load_explicit(&m->top, memory_order_relaxed);
+
+        if ((int64_t)(b - t) < 0) {
+            // Empty.
+            atomic_store_explicit(&m->bottom, b + 1, memory_order_relaxed);
             return ABT_UNIT_NULL;
         }
 
-        ABTI_spinlock_acquire(&m->foreign_lock);
-
-        // Increment head, and ensure read of tail doesn't move before it (fence).
-        size_t head = m->head_idx;
-        __sync_lock_test_and_set(&m->head_idx, head + 1);
-
-        if (head < m->tail_idx) {
-            size_t idx = head & m->mask;
-            ABTI_unit *unit = m->unit_array[idx];
-
-            // Check for nulls in the array.
-            if (unit == ABT_UNIT_NULL) {
-                continue;
-            }
+        ABTI_unit *unit = slot_load(a, b);
+        if (t == b) {
+            // The last element: race against thieves.
+            int won = atomic_compare_exchange_strong_explicit(&m->top, &t,
+                                                              t + 1,
+                                                              memory_order_seq_cst,
+                                                              memory_order_relaxed);
+            atomic_store_explicit(&m->bottom, b + 1, memory_order_relaxed);
+            if (!won) return ABT_UNIT_NULL;
+        }
 
-            m->unit_array[idx] = ABT_UNIT_NULL;
-            ABTI_spinlock_release(&m->foreign_lock);
-            return unit;
-        } else {
-            // Failed, restore head.
-            m->head_idx = head;
-            ABTI_spinlock_release(&m->foreign_lock);
-            return ABT_UNIT_NULL;
+        // Skip units that have been removed.
+        if (unit != NULL && unit_claim(self, unit) == ABT_TRUE) {
+            return (ABT_unit)unit;
         }
+        deque_skip_removed(m);
     }
 }
 
-static int deque_remove(ABTI_pool *self, ABTI_unit *unit)
+static void deque_push_many(ABTI_pool *self, ABT_unit *units, size_t num)
 {
     data_t *m = self->data;
 
-    // Fast path: check the tail. If equal, we can skip the lock.
-    if (m->unit_array[(m->tail_idx - 1) & m->mask] == unit) {
-        return deque_pop_local(self) != ABT_UNIT_NULL ? ABT_SUCCESS : ABT_ERR_POOL;
+    uint64_t b = atomic_load_explicit(&m->bottom, memory_order_relaxed);
+    uint64_t t = atomic_load_explicit(&m->top, memory_order_acquire);
+    array_t *a = atomic_load_explicit(&m->array, memory_order_relaxed);
+
+    while (b + num - t > a->mask + 1) {
+        a = deque_grow(m, a, t, b);
+        ABTI_pool_stats_add(self, ABTI_POOL_STATS_RESIZE, 1);
+    }
+    for (size_t i = 0; i < num && a->compact; i++) {
+        a = deque_widen(self, m, a, (ABTI_unit *)units[i], t, b);
     }
+    if (a->p_prev) deque_reclaim(m, a);
 
-    // Else, do an O(N) search for the work item. The theory of work stealing and our
-    // inlining logic is that most waits will happen on recently queued work.  And
-    // since recently queued work will be close to the tail end (which is where we
-    // begin our search), we will likely find it quickly.
-    for (size_t i = m->tail_idx - 2; i >= m->head_idx; i--) {
-        if (m->unit_array[i & m->mask] == unit) {
-            // If we found the element, block out steals to avoid interference.
-            ABTI_spinlock_acquire(&m->foreign_lock);
-
-            if (m->unit_array[i & m->mask] == ABT_UNIT_NULL) {
-                ABTI_spinlock_release(&m->foreign_lock);
-                return ABT_ERR_POOL;
-            }
-
-            // Null out the element.
-            m->unit_array[i & m->mask] = ABT_UNIT_NULL;
-
-            // And then check to see if we can fix up the indexes (if we're at
-            // the edge).  If we can't, we just leave nulls in the array and they'll
-            // get filtered out eventually (but may lead to superflous resizing).
-            if (i == m->tail_idx) {
-                m->tail_idx -= 1;
-            } else if (i == m->head_idx) {
-                m->head_idx += 1;
-            }
-
-            ABTI_spinlock_release(&m->foreign_lock);
-            return ABT_SUCCESS;
-        }
+    // Publish all units with a single update of bottom.
+    for (size_t i = 0; i < num; i++) {
+        ABTI_unit *unit = (ABTI_unit *)units[i];
+        unit->pool = ABTI_pool_get_handle(self);
+        slot_store(a, b + i, unit);
     }
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&m->bottom, b + num, memory_order_relaxed);
+}
 
-    return ABT_ERR_POOL;
+static size_t deque_pop_many_local(ABTI_pool *self, ABT_unit *units,
+                                   size_t max_units)
+{
+    size_t num = 0;
+    while (num < max_units) {
+        ABT_unit unit = deque_pop_local(self);
+        if (unit == ABT_UNIT_NULL) break;
+        units[num++] = unit;
+    }
+    return num;
 }
 
-/* Unit functions */
+// Return the unit that the owner's next pop would take, which is only a hint:
+// a thief may take it at any time, so the caller must not dereference it.
+ABT_unit ABTI_pool_deque_peek(ABTI_pool *p_pool)
+{
+    data_t *m = p_pool->data;
+    uint64_t b = atomic_load_explicit(&m->bottom, memory_order_relaxed) - 1;
+    uint64_t t = atomic_load_explicit(&m->top, memory_order_relaxed);
+    array_t *a = atomic_load_explicit(&m->array, memory_order_relaxed);
 
-typedef ABTI_unit unit_t;
+    if ((int64_t)(b - t) < 0) return ABT_UNIT_NULL;
+    return (ABT_unit)slot_load(a, b);
+}
 
-static ABT_unit_type unit_get_type(ABT_unit unit)
+void ABTI_pool_set_deque_many_fns(ABTI_pool *p_pool)
 {
-   unit_t *p_unit = (unit_t *)unit;
-   return p_unit->type;
+    p_pool->p_push_many = (ABTI_pool_push_many_fn)deque_push_many;
+    p_pool->p_pop_many  = (ABTI_pool_pop_many_fn)deque_pop_many_local;
 }
 
-static ABT_thread unit_get_thread(ABT_unit unit)
+// Take one unit from the top.  Lost races are counted as lock waits since
+// they are the contention of this pool.  The caller must be a reader.
+static ABT_unit deque_steal(ABTI_pool *self)
 {
-    ABT_thread h_thread;
-    unit_t *p_unit = (unit_t *)unit;
-    if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
-        h_thread = p_unit->thread;
-    } else {
-        h_thread = ABT_THREAD_NULL;
+    data_t *m = self->data;
+
+    while (1) {
+        uint64_t t = atomic_load_explicit(&m->top, memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t b = atomic_load_explicit(&m->bottom, memory_order_acquire);
+
+        if ((int64_t)(b - t) <= 0) {
+            return ABT_UNIT_NULL;
+        }
+
+        array_t *a = atomic_load_explicit(&m->array, memory_order_acquire);
+        ABTI_unit *unit = slot_load(a, t);
+        if (!atomic_compare_exchange_strong_explicit(&m->top, &t, t + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            // Lost the race against another thief or the owner.
+            ABTI_pool_stats_add(self, ABTI_POOL_STATS_LOCK_WAIT, 1);
+            continue;
+        }
+
+        // Skip units that have been removed.
+        if (unit != NULL && unit_claim(self, unit) == ABT_TRUE) {
+            return (ABT_unit)unit;
+        }
+        deque_skip_removed(m);
     }
-    return h_thread;
 }
 
-static ABT_task unit_get_task(ABT_unit unit)
+// called from sched_randws directly
+ABT_unit deque_pop_steal(ABTI_pool *self)
 {
-    ABT_task h_task;
-    unit_t *p_unit = (unit_t *)unit;
-    if (p_unit->type == ABT_UNIT_TYPE_TASK) {
-        h_task = p_unit->task;
-    } else {
-        h_task = ABT_TASK_NULL;
+    data_t *m = self->data;
+
+    reader_enter(m);
+    ABT_unit unit = deque_steal(self);
+    reader_exit(m);
+
+    ABTI_pool_stats_add(self, ABTI_POOL_STATS_STEAL_ATTEMPT, 1);
+    if (unit != ABT_UNIT_NULL) {
+        ABTI_pool_stats_add(self, ABTI_POOL_STATS_STEAL, 1);
     }
-    return h_task;
+    return unit;
 }
 
-static ABT_bool unit_is_in_pool(ABT_unit unit)
+// called from sched_randws directly
+// Each unit is taken with its own CAS on top.  Moving a whole range with one
+// CAS would race with the owner, which pops without a CAS unless it reaches
+// the last element.
+size_t deque_pop_steal_many(ABTI_pool *self, ABT_unit *units, size_t max_units)
 {
-    unit_t *p_unit = (unit_t *)unit;
-    return (p_unit->pool != ABT_POOL_NULL) ? ABT_TRUE : ABT_FALSE;
-}
+    data_t *m = self->data;
+    size_t num = 0;
 
-static ABT_unit unit_create_from_thread(ABT_thread thread)
-{
-    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
-    unit_t *p_unit = &p_thread->unit_def;
-    p_unit->p_prev = NULL;
-    p_unit->p_next = NULL;
-    p_unit->pool   = ABT_POOL_NULL;
-    p_unit->thread = thread;
-    p_unit->type   = ABT_UNIT_TYPE_THREAD;
-
-    return (ABT_unit)p_unit;
+    reader_enter(m);
+    while (num < max_units) {
+        ABT_unit unit = deque_steal(self);
+        if (unit == ABT_UNIT_NULL) break;
+        units[num++] = unit;
+    }
+    reader_exit(m);
+    ABTI_pool_stats_add(self, ABTI_POOL_STATS_STEAL_ATTEMPT, 1);
+    if (num > 0) ABTI_pool_stats_add(self, ABTI_POOL_STATS_STEAL, num);
+    return num;
 }
 
-static ABT_unit unit_create_from_task(ABT_task task)
+static int deque_remove(ABTI_pool *self, ABTI_unit *unit)
 {
-    ABTI_task *p_task = ABTI_task_get_ptr(task);
-    unit_t *p_unit = &p_task->unit_def;
-    p_unit->p_prev = NULL;
-    p_unit->p_next = NULL;
-    p_unit->pool   = ABT_POOL_NULL;
-    p_unit->task   = task;
-    p_unit->type   = ABT_UNIT_TYPE_TASK;
-
-    return (ABT_unit)p_unit;
-}
+    data_t *m = self->data;
 
-static void unit_free(ABT_unit *unit)
-{
-    *unit = ABT_UNIT_NULL;
+    if (unit_claim(self, unit) == ABT_FALSE) {
+        return ABT_ERR_POOL;
+    }
+    atomic_fetch_add_explicit(&m->num_removed, 1, memory_order_relaxed);
+
+    // Clear the slot so that pop and steal don't touch the unit again.
+    // Search from the bottom, where recently queued units are.  If it is not
+    // found (e.g., it has just been copied by deque_resize), pop and steal
+    // will skip it because its pool field is no longer set.
+    reader_enter(m);
+    uint64_t t = atomic_load_explicit(&m->top, memory_order_acquire);
+    uint64_t b = atomic_load_explicit(&m->bottom, memory_order_acquire);
+    array_t *a = atomic_load_explicit(&m->array, memory_order_acquire);
+    for (uint64_t i = b; (int64_t)(i - t) > 0; i--) {
+        if (slot_clear(a, i - 1, unit) == ABT_TRUE) break;
+    }
+    reader_exit(m);
+
+    return ABT_SUCCESS;
 }
 
 /* Deque pool definition */
@@ -326,11 +539,11 @@ ABT_pool_def ABTI_pool_deque = {
     .p_push               = deque_push,
     .p_pop                = deque_pop_local,
     .p_remove             = deque_remove,
-    .u_get_type           = unit_get_type,
-    .u_get_thread         = unit_get_thread,
-    .u_get_task           = unit_get_task,
-    .u_is_in_pool         = unit_is_in_pool,
-    .u_create_from_thread = unit_create_from_thread,
-    .u_create_from_task   = unit_create_from_task,
-    .u_free               = unit_free,
+    .u_get_type           = ABTI_unit_get_type,
+    .u_get_thread         = ABTI_unit_get_thread,
+    .u_get_task           = ABTI_unit_get_task,
+    .u_is_in_pool         = ABTI_unit_is_in_pool,
+    .u_create_from_thread = ABTI_unit_create_from_thread,
+    .u_create_from_task   = ABTI_unit_create_from_task,
+    .u_free               = ABTI_unit_free,
 };
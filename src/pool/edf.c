@@ -0,0 +1,338 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+#include <float.h>
+
+/* Earliest-deadline-first pool implementation
+ *
+ * Units are kept in a binary min-heap ordered by their deadlines, so push and
+ * pop are O(log n).  The deadline of a ULT is given by
+ * ABT_thread_attr_set_deadline(); ULTs without a deadline and tasklets come
+ * after all the units with a deadline.  Units with the same deadline are
+ * popped in the order they were pushed.
+ */
+
+#define EDF_INIT_CAPACITY   64
+
+typedef ABTI_unit unit_t;
+
+typedef struct {
+    double key;             /* Deadline, or DBL_MAX if there is none */
+    uint64_t seq;           /* Order of push to break ties */
+    unit_t *p_unit;
+} entry_t;
+
+struct data {
+    ABTI_spinlock mutex;
+    size_t num_units;
+    size_t capacity;
+    uint64_t seq;
+    entry_t *p_heap;
+};
+typedef struct data data_t;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+static inline double unit_get_key(unit_t *p_unit)
+{
+    if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
+        double deadline = ABTI_thread_get_ptr(p_unit->thread)->attr.deadline;
+        if (deadline > 0.0) return deadline;
+    }
+    return DBL_MAX;
+}
+
+static inline int entry_less(const entry_t *p_a, const entry_t *p_b)
+{
+    return (p_a->key < p_b->key) ||
+           (p_a->key == p_b->key && p_a->seq < p_b->seq);
+}
+
+
+/* Heap operations */
+
+static inline void edf_sift_up(entry_t *p_heap, size_t i)
+{
+    entry_t entry = p_heap[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!entry_less(&entry, &p_heap[parent])) break;
+        p_heap[i] = p_heap[parent];
+        i = parent;
+    }
+    p_heap[i] = entry;
+}
+
+static inline void edf_sift_down(entry_t *p_heap, size_t num, size_t i)
+{
+    entry_t entry = p_heap[i];
+    while (1) {
+        size_t child = 2 * i + 1;
+        if (child >= num) break;
+        if (child + 1 < num && entry_less(&p_heap[child + 1], &p_heap[child])) {
+            child++;
+        }
+        if (!entry_less(&p_heap[child], &entry)) break;
+        p_heap[i] = p_heap[child];
+        i = child;
+    }
+    p_heap[i] = entry;
+}
+
+static inline void edf_push(data_t *p_data, ABT_pool pool, unit_t *p_unit)
+{
+    size_t i = p_data->num_units;
+
+    if (i == p_data->capacity) {
+        p_data->capacity *= 2;
+        p_data->p_heap = (entry_t *)ABTU_realloc(p_data->p_heap,
+                p_data->capacity * sizeof(entry_t));
+    }
+    p_data->p_heap[i].key = unit_get_key(p_unit);
+    p_data->p_heap[i].seq = p_data->seq++;
+    p_data->p_heap[i].p_unit = p_unit;
+    p_data->num_units++;
+    edf_sift_up(p_data->p_heap, i);
+
+    p_unit->pool = pool;
+}
+
+/* Remove the i-th entry of the heap */
+static inline unit_t *edf_remove_at(data_t *p_data, size_t i)
+{
+    entry_t *p_heap = p_data->p_heap;
+    unit_t *p_unit = p_heap[i].p_unit;
+    size_t last = --p_data->num_units;
+
+    if (i != last) {
+        p_heap[i] = p_heap[last];
+        if (i > 0 && entry_less(&p_heap[i], &p_heap[(i - 1) / 2])) {
+            edf_sift_up(p_heap, i);
+        } else {
+            edf_sift_down(p_heap, last, i);
+        }
+    }
+
+    p_unit->pool = ABT_POOL_NULL;
+    return p_unit;
+}
+
+static inline ABT_unit edf_pop(data_t *p_data)
+{
+    if (p_data->num_units == 0) return ABT_UNIT_NULL;
+    return (ABT_unit)edf_remove_at(p_data, 0);
+}
+
+static inline int edf_remove(data_t *p_data, unit_t *p_unit)
+{
+    size_t i;
+    for (i = 0; i < p_data->num_units; i++) {
+        if (p_data->p_heap[i].p_unit == p_unit) {
+            edf_remove_at(p_data, i);
+            return ABT_SUCCESS;
+        }
+    }
+    return ABT_ERR_POOL;
+}
+
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno = ABT_SUCCESS;
+    ABT_pool_access access;
+
+    data_t *p_data = (data_t *)ABTU_malloc_cache_aligned(sizeof(data_t));
+
+    ABT_pool_get_access(pool, &access);
+
+    if (access != ABT_POOL_ACCESS_PRIV) {
+        /* Initialize the mutex */
+        ABTI_spinlock_create(&p_data->mutex);
+    }
+
+    p_data->num_units = 0;
+    p_data->capacity = EDF_INIT_CAPACITY;
+    p_data->seq = 0;
+    p_data->p_heap = (entry_t *)ABTU_malloc(EDF_INIT_CAPACITY *
+                                            sizeof(entry_t));
+
+    ABT_pool_set_data(pool, p_data);
+
+    return abt_errno;
+}
+
+static int pool_free(ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    void *data;
+    ABT_pool_access access;
+    ABT_pool_get_data(pool, &data);
+    data_t *p_data = pool_get_data_ptr(data);
+
+    ABT_pool_get_access(pool, &access);
+    if (access != ABT_POOL_ACCESS_PRIV) {
+        ABTI_spinlock_free(&p_data->mutex);
+    }
+
+    ABTU_free(p_data->p_heap);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    return p_data->num_units;
+}
+
+static void pool_push_shared(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    edf_push(p_data, pool, (unit_t *)unit);
+    ABTI_spinlock_release(&p_data->mutex);
+}
+
+static void pool_push_private(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    edf_push(p_data, pool, (unit_t *)unit);
+}
+
+static ABT_unit pool_pop_shared(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    ABT_unit h_unit;
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    h_unit = edf_pop(p_data);
+    ABTI_spinlock_release(&p_data->mutex);
+
+    return h_unit;
+}
+
+static ABT_unit pool_pop_private(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    return edf_pop(p_data);
+}
+
+static int pool_remove_shared(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    unit_t *p_unit = (unit_t *)unit;
+    int abt_errno;
+
+    if (p_data->num_units == 0) return ABT_ERR_POOL;
+    if (p_unit->pool == ABT_POOL_NULL) return ABT_ERR_POOL;
+
+    if (p_unit->pool != pool) {
+        HANDLE_ERROR("Not my pool");
+    }
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    abt_errno = edf_remove(p_data, p_unit);
+    ABTI_spinlock_release(&p_data->mutex);
+
+    return abt_errno;
+}
+
+static int pool_remove_private(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    unit_t *p_unit = (unit_t *)unit;
+
+    if (p_data->num_units == 0) return ABT_ERR_POOL;
+    if (p_unit->pool == ABT_POOL_NULL) return ABT_ERR_POOL;
+
+    if (p_unit->pool != pool) {
+        HANDLE_ERROR("Not my pool");
+    }
+
+    return edf_remove(p_data, p_unit);
+}
+
+/* Obtain the EDF pool definition according to the access type */
+int ABTI_pool_get_edf_def(ABT_pool_access access, ABT_pool_def *p_def)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    /* Definitions according to the access type */
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+            p_def->p_push   = pool_push_private;
+            p_def->p_pop    = pool_pop_private;
+            p_def->p_remove = pool_remove_private;
+            break;
+
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+            p_def->p_push   = pool_push_shared;
+            p_def->p_pop    = pool_pop_shared;
+            p_def->p_remove = pool_remove_shared;
+            break;
+
+        default:
+            ABTI_CHECK_TRUE(0, ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    /* Common definitions regardless of the access type */
+    p_def->access               = access;
+    p_def->p_init               = pool_init;
+    p_def->p_free               = pool_free;
+    p_def->p_get_size           = pool_get_size;
+    p_def->u_get_type           = ABTI_unit_get_type;
+    p_def->u_get_thread         = ABTI_unit_get_thread;
+    p_def->u_get_task           = ABTI_unit_get_task;
+    p_def->u_is_in_pool         = ABTI_unit_is_in_pool;
+    p_def->u_create_from_thread = ABTI_unit_create_from_thread;
+    p_def->u_create_from_task   = ABTI_unit_create_from_task;
+    p_def->u_free               = ABTI_unit_free;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Return ABT_TRUE if p_pool is a pool of the kind ABT_POOL_EDF */
+ABT_bool ABTI_pool_is_edf(ABTI_pool *p_pool)
+{
+    return (p_pool->p_init == pool_init) ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Return the earliest deadline in the EDF pool p_pool, or 0.0 if no units in
+ * it have a deadline. */
+double ABTI_pool_edf_get_deadline(ABTI_pool *p_pool)
+{
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    double key = DBL_MAX;
+
+    if (p_data->num_units == 0) return 0.0;
+
+    if (p_pool->access != ABT_POOL_ACCESS_PRIV) {
+        ABTI_spinlock_acquire(&p_data->mutex);
+        if (p_data->num_units > 0) key = p_data->p_heap[0].key;
+        ABTI_spinlock_release(&p_data->mutex);
+    } else {
+        key = p_data->p_heap[0].key;
+    }
+    return (key == DBL_MAX) ? 0.0 : key;
+}
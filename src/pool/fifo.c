@@ -16,15 +16,16 @@ static ABT_unit pool_pop_shared(ABT_pool pool);
 static ABT_unit pool_pop_private(ABT_pool pool);
 static int      pool_remove_shared(ABT_pool pool, ABT_unit unit);
 static int      pool_remove_private(ABT_pool pool, ABT_unit unit);
+static void     pool_push_many_shared(ABT_pool pool, ABT_unit *units,
+                                      size_t num_units);
+static void     pool_push_many_private(ABT_pool pool, ABT_unit *units,
+                                       size_t num_units);
+static size_t   pool_pop_many_shared(ABT_pool pool, ABT_unit *units,
+                                     size_t max_units);
+static size_t   pool_pop_many_private(ABT_pool pool, ABT_unit *units,
+                                      size_t max_units);
 
 typedef ABTI_unit unit_t;
-static ABT_unit_type unit_get_type(ABT_unit unit);
-static ABT_thread unit_get_thread(ABT_unit unit);
-static ABT_task unit_get_task(ABT_unit unit);
-static ABT_bool unit_is_in_pool(ABT_unit unit);
-static ABT_unit unit_create_from_thread(ABT_thread thread);
-static ABT_unit unit_create_from_task(ABT_task task);
-static void unit_free(ABT_unit *unit);
 
 
 /* FIXME: do we need this? */
@@ -36,22 +37,16 @@ ABT_pool_def ABTI_pool_fifo = {
     .p_push               = pool_push_shared,
     .p_pop                = pool_pop_shared,
     .p_remove             = pool_remove_shared,
-    .u_get_type           = unit_get_type,
-    .u_get_thread         = unit_get_thread,
-    .u_get_task           = unit_get_task,
-    .u_is_in_pool         = unit_is_in_pool,
-    .u_create_from_thread = unit_create_from_thread,
-    .u_create_from_task   = unit_create_from_task,
-    .u_free               = unit_free,
+    .u_get_type           = ABTI_unit_get_type,
+    .u_get_thread         = ABTI_unit_get_thread,
+    .u_get_task           = ABTI_unit_get_task,
+    .u_is_in_pool         = ABTI_unit_is_in_pool,
+    .u_create_from_thread = ABTI_unit_create_from_thread,
+    .u_create_from_task   = ABTI_unit_create_from_task,
+    .u_free               = ABTI_unit_free,
 };
 
-struct data {
-    ABTI_spinlock mutex;
-    size_t num_units;
-    unit_t *p_head;
-    unit_t *p_tail;
-};
-typedef struct data data_t;
+typedef ABTI_pool_fifo_data data_t;
 
 static inline data_t *pool_get_data_ptr(void *p_data)
 {
@@ -91,13 +86,13 @@ int ABTI_pool_get_fifo_def(ABT_pool_access access, ABT_pool_def *p_def)
     p_def->p_init               = pool_init;
     p_def->p_free               = pool_free;
     p_def->p_get_size           = pool_get_size;
-    p_def->u_get_type           = unit_get_type;
-    p_def->u_get_thread         = unit_get_thread;
-    p_def->u_get_task           = unit_get_task;
-    p_def->u_is_in_pool         = unit_is_in_pool;
-    p_def->u_create_from_thread = unit_create_from_thread;
-    p_def->u_create_from_task   = unit_create_from_task;
-    p_def->u_free               = unit_free;
+    p_def->u_get_type           = ABTI_unit_get_type;
+    p_def->u_get_thread         = ABTI_unit_get_thread;
+    p_def->u_get_task           = ABTI_unit_get_task;
+    p_def->u_is_in_pool         = ABTI_unit_is_in_pool;
+    p_def->u_create_from_thread = ABTI_unit_create_from_thread;
+    p_def->u_create_from_task   = ABTI_unit_create_from_task;
+    p_def->u_free               = ABTI_unit_free;
 
   fn_exit:
     return abt_errno;
@@ -107,6 +102,21 @@ int ABTI_pool_get_fifo_def(ABT_pool_access access, ABT_pool_def *p_def)
     goto fn_exit;
 }
 
+/* Set the batched operations according to the access type, and let the
+ * runtime inline push and pop (see ABTI_pool_call_push()) */
+void ABTI_pool_set_fifo_many_fns(ABTI_pool *p_pool)
+{
+    if (p_pool->access == ABT_POOL_ACCESS_PRIV) {
+        p_pool->p_push_many = pool_push_many_private;
+        p_pool->p_pop_many  = pool_pop_many_private;
+        p_pool->builtin     = ABTI_POOL_BUILTIN_FIFO_PRIV;
+    } else {
+        p_pool->p_push_many = pool_push_many_shared;
+        p_pool->p_pop_many  = pool_pop_many_shared;
+        p_pool->builtin     = ABTI_POOL_BUILTIN_FIFO_SHARED;
+    }
+}
+
 
 /* Pool functions */
 
@@ -116,7 +126,7 @@ int pool_init(ABT_pool pool, ABT_pool_config config)
     int abt_errno = ABT_SUCCESS;
     ABT_pool_access access;
 
-    data_t *p_data = (data_t *)ABTU_malloc(sizeof(data_t));
+    data_t *p_data = (data_t *)ABTU_malloc_cache_aligned(sizeof(data_t));
 
     ABT_pool_get_access(pool, &access);
 
@@ -128,6 +138,9 @@ int pool_init(ABT_pool pool, ABT_pool_config config)
     p_data->num_units = 0;
     p_data->p_head = NULL;
     p_data->p_tail = NULL;
+    p_data->p_owner = NULL;
+    p_data->p_inbox = NULL;
+    p_data->num_inbox = 0;
 
     ABT_pool_set_data(pool, p_data);
 
@@ -154,133 +167,37 @@ static int pool_free(ABT_pool pool)
 
 static size_t pool_get_size(ABT_pool pool)
 {
-    void *data;
-    ABT_pool_get_data(pool, &data);
-    data_t *p_data = pool_get_data_ptr(data);
-    return p_data->num_units;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    return ABTI_pool_fifo_get_size_priv(p_data);
 }
 
 static void pool_push_shared(ABT_pool pool, ABT_unit unit)
 {
-    void *data;
-    ABT_pool_get_data(pool, &data);
-    data_t *p_data = pool_get_data_ptr(data);
-    unit_t *p_unit = (unit_t *)unit;
-
-    ABTI_spinlock_acquire(&p_data->mutex);
-    if (p_data->num_units == 0) {
-        p_unit->p_prev = p_unit;
-        p_unit->p_next = p_unit;
-        p_data->p_head = p_unit;
-        p_data->p_tail = p_unit;
-    } else {
-        unit_t *p_head = p_data->p_head;
-        unit_t *p_tail = p_data->p_tail;
-        p_tail->p_next = p_unit;
-        p_head->p_prev = p_unit;
-        p_unit->p_prev = p_tail;
-        p_unit->p_next = p_head;
-        p_data->p_tail = p_unit;
-    }
-    p_data->num_units++;
-
-    p_unit->pool = pool;
-    ABTI_spinlock_release(&p_data->mutex);
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    ABTI_pool_fifo_push_shared(p_data, pool, unit);
 }
 
 static void pool_push_private(ABT_pool pool, ABT_unit unit)
 {
-    void *data;
-    ABT_pool_get_data(pool, &data);
-    data_t *p_data = pool_get_data_ptr(data);
-    unit_t *p_unit = (unit_t *)unit;
-
-    if (p_data->num_units == 0) {
-        p_unit->p_prev = p_unit;
-        p_unit->p_next = p_unit;
-        p_data->p_head = p_unit;
-        p_data->p_tail = p_unit;
-    } else {
-        unit_t *p_head = p_data->p_head;
-        unit_t *p_tail = p_data->p_tail;
-        p_tail->p_next = p_unit;
-        p_head->p_prev = p_unit;
-        p_unit->p_prev = p_tail;
-        p_unit->p_next = p_head;
-        p_data->p_tail = p_unit;
-    }
-    p_data->num_units++;
-
-    p_unit->pool = pool;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    ABTI_pool_fifo_push_priv(p_data, pool, unit);
 }
 
 static ABT_unit pool_pop_shared(ABT_pool pool)
 {
-    void *data;
-    ABT_pool_get_data(pool, &data);
-    data_t *p_data = pool_get_data_ptr(data);
-    unit_t *p_unit = NULL;
-    ABT_unit h_unit = ABT_UNIT_NULL;
-
-    ABTI_spinlock_acquire(&p_data->mutex);
-    if (p_data->num_units > 0) {
-        p_unit = p_data->p_head;
-        if (p_data->num_units == 1) {
-            p_data->p_head = NULL;
-            p_data->p_tail = NULL;
-        } else {
-            p_unit->p_prev->p_next = p_unit->p_next;
-            p_unit->p_next->p_prev = p_unit->p_prev;
-            p_data->p_head = p_unit->p_next;
-        }
-        p_data->num_units--;
-
-        p_unit->p_prev = NULL;
-        p_unit->p_next = NULL;
-        p_unit->pool = ABT_POOL_NULL;
-
-        h_unit = (ABT_unit)p_unit;
-    }
-    ABTI_spinlock_release(&p_data->mutex);
-
-    return h_unit;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    return ABTI_pool_fifo_pop_shared(p_data, pool);
 }
 
 static ABT_unit pool_pop_private(ABT_pool pool)
 {
-    void *data;
-    ABT_pool_get_data(pool, &data);
-    data_t *p_data = pool_get_data_ptr(data);
-    unit_t *p_unit = NULL;
-    ABT_unit h_unit = ABT_UNIT_NULL;
-
-    if (p_data->num_units > 0) {
-        p_unit = p_data->p_head;
-        if (p_data->num_units == 1) {
-            p_data->p_head = NULL;
-            p_data->p_tail = NULL;
-        } else {
-            p_unit->p_prev->p_next = p_unit->p_next;
-            p_unit->p_next->p_prev = p_unit->p_prev;
-            p_data->p_head = p_unit->p_next;
-        }
-        p_data->num_units--;
-
-        p_unit->p_prev = NULL;
-        p_unit->p_next = NULL;
-        p_unit->pool = ABT_POOL_NULL;
-
-        h_unit = (ABT_unit)p_unit;
-    }
-
-    return h_unit;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    return ABTI_pool_fifo_pop_priv(p_data, ABTI_xstream_self());
 }
 
 static int pool_remove_shared(ABT_pool pool, ABT_unit unit)
 {
-    void *data;
-    ABT_pool_get_data(pool, &data);
-    data_t *p_data = pool_get_data_ptr(data);
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
     unit_t *p_unit = (unit_t *)unit;
 
     if (p_data->num_units == 0) return ABT_ERR_POOL;
@@ -290,37 +207,21 @@ static int pool_remove_shared(ABT_pool pool, ABT_unit unit)
         HANDLE_ERROR("Not my pool");
     }
 
-    ABTI_spinlock_acquire(&p_data->mutex);
-    if (p_data->num_units == 1) {
-        p_data->p_head = NULL;
-        p_data->p_tail = NULL;
-    } else {
-        p_unit->p_prev->p_next = p_unit->p_next;
-        p_unit->p_next->p_prev = p_unit->p_prev;
-        if (p_unit == p_data->p_head) {
-            p_data->p_head = p_unit->p_next;
-        } else if (p_unit == p_data->p_tail) {
-            p_data->p_tail = p_unit->p_prev;
-        }
-    }
-    p_data->num_units--;
-
-    p_unit->pool = ABT_POOL_NULL;
+    ABTI_pool_stats_lock(ABTI_pool_get_ptr(pool), &p_data->mutex);
+    ABTI_pool_fifo_unlink(p_data, p_unit);
     ABTI_spinlock_release(&p_data->mutex);
 
-    p_unit->p_prev = NULL;
-    p_unit->p_next = NULL;
-
     return ABT_SUCCESS;
 }
 
 static int pool_remove_private(ABT_pool pool, ABT_unit unit)
 {
-    void *data;
-    ABT_pool_get_data(pool, &data);
-    data_t *p_data = pool_get_data_ptr(data);
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
     unit_t *p_unit = (unit_t *)unit;
 
+    /* The unit may be in the inbox. */
+    ABTI_pool_fifo_own(p_data, ABTI_xstream_self());
+
     if (p_data->num_units == 0) return ABT_ERR_POOL;
     if (p_unit->pool == ABT_POOL_NULL) return ABT_ERR_POOL;
 
@@ -328,110 +229,129 @@ static int pool_remove_private(ABT_pool pool, ABT_unit unit)
         HANDLE_ERROR("Not my pool");
     }
 
-    if (p_data->num_units == 1) {
-        p_data->p_head = NULL;
-        p_data->p_tail = NULL;
-    } else {
-        p_unit->p_prev->p_next = p_unit->p_next;
-        p_unit->p_next->p_prev = p_unit->p_prev;
-        if (p_unit == p_data->p_head) {
-            p_data->p_head = p_unit->p_next;
-        } else if (p_unit == p_data->p_tail) {
-            p_data->p_tail = p_unit->p_prev;
-        }
-    }
-    p_data->num_units--;
-
-    p_unit->pool = ABT_POOL_NULL;
-    p_unit->p_prev = NULL;
-    p_unit->p_next = NULL;
+    ABTI_pool_fifo_unlink(p_data, p_unit);
 
     return ABT_SUCCESS;
 }
 
-#if 0
-int pool_print(ABT_pool pool)
+/* Link units into a chain and splice it in front of the head, i.e., after the
+ * tail of the circular list. */
+static inline void pool_push_chain(data_t *p_data, ABT_pool pool,
+                                   ABT_unit *units, size_t num_units)
 {
-    void *data;
-    ABT_pool_get_data(pool, &data);
-    data_t *p_data = pool_get_data_ptr(data);
-    printf("[");
-    printf("num_units: %zu ", p_data->num_units);
-    printf("head: %p ", p_data->p_head);
-    printf("tail: %p", p_data->p_tail);
-    printf("]");
+    size_t i;
+    unit_t *p_first = (unit_t *)units[0];
+    unit_t *p_last = (unit_t *)units[num_units - 1];
+
+    for (i = 0; i < num_units; i++) {
+        unit_t *p_unit = (unit_t *)units[i];
+        p_unit->p_prev = (i > 0) ? (unit_t *)units[i - 1] : NULL;
+        p_unit->p_next = (i + 1 < num_units) ? (unit_t *)units[i + 1] : NULL;
+        p_unit->pool = pool;
+    }
 
-    return ABT_SUCCESS;
+    if (p_data->num_units == 0) {
+        p_first->p_prev = p_last;
+        p_last->p_next = p_first;
+        p_data->p_head = p_first;
+    } else {
+        unit_t *p_head = p_data->p_head;
+        unit_t *p_tail = p_data->p_tail;
+        p_tail->p_next = p_first;
+        p_first->p_prev = p_tail;
+        p_last->p_next = p_head;
+        p_head->p_prev = p_last;
+    }
+    p_data->p_tail = p_last;
+    p_data->num_units += num_units;
 }
-#endif
 
+static inline size_t pool_pop_chain(data_t *p_data, ABT_unit *units,
+                                    size_t max_units)
+{
+    size_t i, num = (p_data->num_units < max_units)
+                  ? p_data->num_units : max_units;
+    unit_t *p_unit = p_data->p_head;
+
+    for (i = 0; i < num; i++) {
+        unit_t *p_next = p_unit->p_next;
+        p_unit->p_prev = NULL;
+        p_unit->p_next = NULL;
+        p_unit->pool = ABT_POOL_NULL;
+        units[i] = (ABT_unit)p_unit;
+        p_unit = p_next;
+    }
 
-/* Unit functions */
+    p_data->num_units -= num;
+    if (p_data->num_units == 0) {
+        p_data->p_head = NULL;
+        p_data->p_tail = NULL;
+    } else if (num > 0) {
+        p_unit->p_prev = p_data->p_tail;
+        p_data->p_tail->p_next = p_unit;
+        p_data->p_head = p_unit;
+    }
 
-static ABT_unit_type unit_get_type(ABT_unit unit)
-{
-   unit_t *p_unit = (unit_t *)unit;
-   return p_unit->type;
+    return num;
 }
 
-static ABT_thread unit_get_thread(ABT_unit unit)
+static void pool_push_many_shared(ABT_pool pool, ABT_unit *units,
+                                  size_t num_units)
 {
-    ABT_thread h_thread;
-    unit_t *p_unit = (unit_t *)unit;
-    if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
-        h_thread = p_unit->thread;
-    } else {
-        h_thread = ABT_THREAD_NULL;
-    }
-    return h_thread;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    ABTI_pool_stats_lock(ABTI_pool_get_ptr(pool), &p_data->mutex);
+    pool_push_chain(p_data, pool, units, num_units);
+    ABTI_spinlock_release(&p_data->mutex);
 }
 
-static ABT_task unit_get_task(ABT_unit unit)
+static void pool_push_many_private(ABT_pool pool, ABT_unit *units,
+                                   size_t num_units)
 {
-    ABT_task h_task;
-    unit_t *p_unit = (unit_t *)unit;
-    if (p_unit->type == ABT_UNIT_TYPE_TASK) {
-        h_task = p_unit->task;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    size_t i;
+
+    if (ABTI_pool_fifo_is_owner(p_data, ABTI_xstream_self()) == ABT_TRUE) {
+        pool_push_chain(p_data, pool, units, num_units);
     } else {
-        h_task = ABT_TASK_NULL;
+        for (i = 0; i < num_units; i++) {
+            ABTI_pool_fifo_push_inbox(p_data, pool, units[i]);
+        }
     }
-    return h_task;
 }
 
-static ABT_bool unit_is_in_pool(ABT_unit unit)
+static size_t pool_pop_many_shared(ABT_pool pool, ABT_unit *units,
+                                   size_t max_units)
 {
-    unit_t *p_unit = (unit_t *)unit;
-    return (p_unit->pool != ABT_POOL_NULL) ? ABT_TRUE : ABT_FALSE;
-}
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    size_t num;
 
-static ABT_unit unit_create_from_thread(ABT_thread thread)
-{
-    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
-    unit_t *p_unit = &p_thread->unit_def;
-    p_unit->p_prev = NULL;
-    p_unit->p_next = NULL;
-    p_unit->pool   = ABT_POOL_NULL;
-    p_unit->thread = thread;
-    p_unit->type   = ABT_UNIT_TYPE_THREAD;
-
-    return (ABT_unit)p_unit;
+    ABTI_pool_stats_lock(ABTI_pool_get_ptr(pool), &p_data->mutex);
+    num = pool_pop_chain(p_data, units, max_units);
+    ABTI_spinlock_release(&p_data->mutex);
+
+    return num;
 }
 
-static ABT_unit unit_create_from_task(ABT_task task)
+static size_t pool_pop_many_private(ABT_pool pool, ABT_unit *units,
+                                    size_t max_units)
 {
-    ABTI_task *p_task = ABTI_task_get_ptr(task);
-    unit_t *p_unit = &p_task->unit_def;
-    p_unit->p_prev = NULL;
-    p_unit->p_next = NULL;
-    p_unit->pool   = ABT_POOL_NULL;
-    p_unit->task   = task;
-    p_unit->type   = ABT_UNIT_TYPE_TASK;
-
-    return (ABT_unit)p_unit;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    ABTI_pool_fifo_own(p_data, ABTI_xstream_self());
+    return pool_pop_chain(p_data, units, max_units);
 }
 
-static void unit_free(ABT_unit *unit)
+#if 0
+int pool_print(ABT_pool pool)
 {
-    *unit = ABT_UNIT_NULL;
-}
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    printf("[");
+    printf("num_units: %zu ", p_data->num_units);
+    printf("head: %p ", p_data->p_head);
+    printf("tail: %p", p_data->p_tail);
+    printf("]");
 
+    return ABT_SUCCESS;
+}
+#endif
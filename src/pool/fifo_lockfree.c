@@ -0,0 +1,307 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Lock-free FIFO pool implementation
+ *
+ * Units are kept in a bounded ring of cells, each of which carries a sequence
+ * number (D. Vyukov's bounded MPMC queue).  Producers and consumers claim a
+ * position with a single CAS on the tail or head index and then publish or
+ * release the cell by updating its sequence number, so no lock is taken in
+ * the common case.  If the ring is full, units are pushed to a small overflow
+ * list, which is a locked FIFO pool list (see abti_pool.h); consumers drain
+ * it once the ring is empty.
+ *
+ * To support p_remove, a unit in the ring has a NULL p_prev and remembers its
+ * position in p_next, while a unit in the overflow list has a non-NULL p_prev.
+ * Remove takes a unit out of the ring only if the sequence number of its cell
+ * shows that the cell still holds the push at that position, so it does not
+ * act on a cell that has been consumed and reused since.  Both pop and remove
+ * take the unit out of the cell with a CAS, so exactly one of them succeeds.
+ * A consumer that finds an emptied cell just skips it.
+ */
+
+#define LF_RING_SIZE    1024        /* Must be a power of two */
+/* Keeps indices on separate lines */
+#define LF_PAD_SIZE     ABT_CONFIG_CACHE_LINE_SIZE
+
+static int      pool_init(ABT_pool pool, ABT_pool_config config);
+static int      pool_free(ABT_pool pool);
+static size_t   pool_get_size(ABT_pool pool);
+static void     pool_push(ABT_pool pool, ABT_unit unit);
+static ABT_unit pool_pop(ABT_pool pool);
+static int      pool_remove(ABT_pool pool, ABT_unit unit);
+
+typedef ABTI_unit unit_t;
+
+struct cell {
+    uint64_t seq;
+    uint64_t unit;                  /* unit_t * */
+};
+typedef struct cell cell_t;
+
+struct data {
+    cell_t *p_cells;
+    uint64_t mask;
+    char pad1[LF_PAD_SIZE];
+    uint64_t enq_pos;
+    char pad2[LF_PAD_SIZE];
+    uint64_t deq_pos;
+    char pad3[LF_PAD_SIZE];
+    uint64_t num_units;
+    ABTI_pool_fifo_data ovf;        /* Overflow list */
+};
+typedef struct data data_t;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+
+/* Obtain the lock-free FIFO pool definition according to the access type */
+int ABTI_pool_get_fifo_lockfree_def(ABT_pool_access access,
+                                    ABT_pool_def *p_def)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    /* The same implementation serves all access types. */
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+            break;
+
+        default:
+            ABTI_CHECK_TRUE(0, ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    p_def->access               = access;
+    p_def->p_init               = pool_init;
+    p_def->p_free               = pool_free;
+    p_def->p_get_size           = pool_get_size;
+    p_def->p_push               = pool_push;
+    p_def->p_pop                = pool_pop;
+    p_def->p_remove             = pool_remove;
+    p_def->u_get_type           = ABTI_unit_get_type;
+    p_def->u_get_thread         = ABTI_unit_get_thread;
+    p_def->u_get_task           = ABTI_unit_get_task;
+    p_def->u_is_in_pool         = ABTI_unit_is_in_pool;
+    p_def->u_create_from_thread = ABTI_unit_create_from_thread;
+    p_def->u_create_from_task   = ABTI_unit_create_from_task;
+    p_def->u_free               = ABTI_unit_free;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno = ABT_SUCCESS;
+    uint64_t i;
+
+    data_t *p_data = (data_t *)ABTU_malloc_cache_aligned(sizeof(data_t));
+    p_data->p_cells = (cell_t *)ABTU_malloc(sizeof(cell_t) * LF_RING_SIZE);
+    p_data->mask = LF_RING_SIZE - 1;
+    for (i = 0; i < LF_RING_SIZE; i++) {
+        p_data->p_cells[i].seq = i;
+        p_data->p_cells[i].unit = (uint64_t)NULL;
+    }
+    p_data->enq_pos = 0;
+    p_data->deq_pos = 0;
+    p_data->num_units = 0;
+    ABTI_spinlock_create(&p_data->ovf.mutex);
+    p_data->ovf.num_units = 0;
+    p_data->ovf.p_head = NULL;
+    p_data->ovf.p_tail = NULL;
+    p_data->ovf.p_owner = NULL;
+    p_data->ovf.p_inbox = NULL;
+    p_data->ovf.num_inbox = 0;
+
+    ABT_pool_set_data(pool, p_data);
+
+    return abt_errno;
+}
+
+static int pool_free(ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    ABTI_spinlock_free(&p_data->ovf.mutex);
+    ABTU_free(p_data->p_cells);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    return (size_t)*(volatile uint64_t *)&p_data->num_units;
+}
+
+/* Returns ABT_FALSE if the ring is full. */
+static inline ABT_bool ring_push(data_t *p_data, unit_t *p_unit)
+{
+    cell_t *p_cell;
+    uint64_t pos = *(volatile uint64_t *)&p_data->enq_pos;
+
+    while (1) {
+        p_cell = &p_data->p_cells[pos & p_data->mask];
+        uint64_t seq = *(volatile uint64_t *)&p_cell->seq;
+        int64_t dif = (int64_t)seq - (int64_t)pos;
+        if (dif == 0) {
+            uint64_t old = ABTD_atomic_cas_uint64(&p_data->enq_pos,
+                                                  pos, pos + 1);
+            if (old == pos) break;
+            pos = old;
+        } else if (dif < 0) {
+            return ABT_FALSE;
+        } else {
+            pos = *(volatile uint64_t *)&p_data->enq_pos;
+        }
+    }
+
+    p_unit->p_prev = NULL;
+    p_unit->p_next = (unit_t *)(uintptr_t)pos;
+    p_cell->unit = (uint64_t)p_unit;
+    ABTD_atomic_mem_barrier();
+    *(volatile uint64_t *)&p_cell->seq = pos + 1;
+    return ABT_TRUE;
+}
+
+/* Returns ABT_FALSE if the ring is empty.  *pp_unit can be NULL if the unit
+ * in the claimed cell has been removed. */
+static inline ABT_bool ring_pop(data_t *p_data, unit_t **pp_unit)
+{
+    cell_t *p_cell;
+    uint64_t pos = *(volatile uint64_t *)&p_data->deq_pos;
+
+    while (1) {
+        p_cell = &p_data->p_cells[pos & p_data->mask];
+        uint64_t seq = *(volatile uint64_t *)&p_cell->seq;
+        int64_t dif = (int64_t)seq - (int64_t)(pos + 1);
+        if (dif == 0) {
+            uint64_t old = ABTD_atomic_cas_uint64(&p_data->deq_pos,
+                                                  pos, pos + 1);
+            if (old == pos) break;
+            pos = old;
+        } else if (dif < 0) {
+            return ABT_FALSE;
+        } else {
+            pos = *(volatile uint64_t *)&p_data->deq_pos;
+        }
+    }
+
+    /* Race with pool_remove: whoever empties the cell owns the unit. */
+    uint64_t unit = *(volatile uint64_t *)&p_cell->unit;
+    if (unit != (uint64_t)NULL &&
+        ABTD_atomic_cas_uint64(&p_cell->unit, unit, (uint64_t)NULL) != unit) {
+        unit = (uint64_t)NULL;
+    }
+    *pp_unit = (unit_t *)unit;
+
+    ABTD_atomic_mem_barrier();
+    *(volatile uint64_t *)&p_cell->seq = pos + p_data->mask + 1;
+    return ABT_TRUE;
+}
+
+static void pool_push(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    unit_t *p_unit = (unit_t *)unit;
+
+    p_unit->pool = pool;
+    ABTD_atomic_fetch_add_uint64(&p_data->num_units, 1);
+
+    /* Keep FIFO order while the overflow list is in use. */
+    if (*(volatile size_t *)&p_data->ovf.num_units == 0 &&
+        ring_push(p_data, p_unit) == ABT_TRUE) {
+        return;
+    }
+
+    ABTI_spinlock_acquire(&p_data->ovf.mutex);
+    ABTI_pool_fifo_push(&p_data->ovf, pool, unit);
+    ABTI_spinlock_release(&p_data->ovf.mutex);
+}
+
+static ABT_unit pool_pop(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    unit_t *p_unit = NULL;
+
+    while (ring_pop(p_data, &p_unit) == ABT_TRUE) {
+        if (p_unit) goto found;
+    }
+
+    if (*(volatile size_t *)&p_data->ovf.num_units == 0) {
+        return ABT_UNIT_NULL;
+    }
+
+    ABTI_spinlock_acquire(&p_data->ovf.mutex);
+    p_unit = (unit_t *)ABTI_pool_fifo_pop(&p_data->ovf);
+    ABTI_spinlock_release(&p_data->ovf.mutex);
+    if (p_unit == NULL) return ABT_UNIT_NULL;
+    ABTD_atomic_fetch_sub_uint64(&p_data->num_units, 1);
+    return (ABT_unit)p_unit;
+
+  found:
+    ABTD_atomic_fetch_sub_uint64(&p_data->num_units, 1);
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool = ABT_POOL_NULL;
+
+    return (ABT_unit)p_unit;
+}
+
+static int pool_remove(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    unit_t *p_unit = (unit_t *)unit;
+
+    if (p_unit->pool == ABT_POOL_NULL) return ABT_ERR_POOL;
+
+    if (p_unit->pool != pool) {
+        HANDLE_ERROR("Not my pool");
+    }
+
+    if (p_unit->p_prev == NULL) {
+        /* The unit is in the ring.  The cell is skipped later by pool_pop. */
+        uintptr_t pos = (uintptr_t)p_unit->p_next;
+        cell_t *p_cell = &p_data->p_cells[pos & p_data->mask];
+        uint64_t seq = *(volatile uint64_t *)&p_cell->seq;
+        if ((uintptr_t)(seq - 1) != pos ||
+            ABTD_atomic_cas_uint64(&p_cell->unit, (uint64_t)p_unit,
+                                   (uint64_t)NULL) != (uint64_t)p_unit) {
+            return ABT_ERR_POOL;
+        }
+        p_unit->p_next = NULL;
+        p_unit->pool = ABT_POOL_NULL;
+    } else {
+        /* The unit is in the overflow list unless it has been popped. */
+        ABTI_spinlock_acquire(&p_data->ovf.mutex);
+        if (p_unit->pool != pool || p_unit->p_prev == NULL) {
+            ABTI_spinlock_release(&p_data->ovf.mutex);
+            return ABT_ERR_POOL;
+        }
+        ABTI_pool_fifo_unlink(&p_data->ovf, p_unit);
+        ABTI_spinlock_release(&p_data->ovf.mutex);
+    }
+
+    ABTD_atomic_fetch_sub_uint64(&p_data->num_units, 1);
+    return ABT_SUCCESS;
+}
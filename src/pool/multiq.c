@@ -0,0 +1,267 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Relaxed FIFO pool implementation
+ *
+ * A single shared FIFO serializes all ESs on its lock.  This pool instead
+ * spreads units over ABT_POOL_MULTIQ_NUM_QUEUES FIFO sub-queues, each with its
+ * own lock on its own cache lines.  push appends the unit to a random
+ * sub-queue, and pop draws two random sub-queues and takes the head of the
+ * longer one (the power of two choices), so the sub-queues stay balanced and
+ * concurrent ESs rarely meet on the same lock.  A locked sub-queue is not
+ * waited for but another pair is drawn.  When the draws find nothing, pop
+ * scans all sub-queues so that no unit is left behind.
+ *
+ * Units pushed to the same sub-queue are popped in FIFO order, but there is
+ * no order among the sub-queues.  Removing a unit searches the sub-queues,
+ * which is slow but rare.
+ */
+
+#define NUM_TRIES       4
+
+typedef ABTI_unit unit_t;
+
+typedef struct {
+    ABTI_pool_fifo_data fifo ABTI_CACHE_ALIGNED;
+} queue_t;
+
+typedef struct data {
+    uint32_t num_queues;
+    queue_t *p_queues;
+} data_t;
+
+/* Per-ES state of the random number generator */
+static ABTD_XSTREAM_LOCAL uint32_t l_seed = 0;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+static inline size_t queue_get_size(queue_t *p_queue)
+{
+    return *(volatile size_t *)&p_queue->fifo.num_units;
+}
+
+/* Return a random sub-queue (xorshift32) */
+static inline queue_t *multiq_choose(data_t *p_data)
+{
+    uint32_t x = l_seed;
+    if (x == 0) {
+        /* Seed each ES differently */
+        x = (uint32_t)((uintptr_t)&l_seed >> 4) * 2654435761u | 1;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    l_seed = x;
+    return &p_data->p_queues[(uint32_t)(((uint64_t)x * p_data->num_queues)
+                                        >> 32)];
+}
+
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno = ABT_SUCCESS;
+    uint32_t i, num_queues = gp_ABTI_global->pool_multiq_num_queues;
+
+    data_t *p_data = (data_t *)ABTU_malloc(sizeof(data_t));
+    p_data->num_queues = num_queues;
+    p_data->p_queues = (queue_t *)ABTU_malloc_cache_aligned(
+            sizeof(queue_t) * num_queues);
+    for (i = 0; i < num_queues; i++) {
+        ABTI_pool_fifo_data *p_fifo = &p_data->p_queues[i].fifo;
+        ABTI_spinlock_create(&p_fifo->mutex);
+        p_fifo->num_units = 0;
+        p_fifo->p_head = NULL;
+        p_fifo->p_tail = NULL;
+    }
+
+    ABT_pool_set_data(pool, p_data);
+
+    return abt_errno;
+}
+
+static int pool_free(ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    uint32_t i;
+
+    for (i = 0; i < p_data->num_queues; i++) {
+        ABTI_spinlock_free(&p_data->p_queues[i].fifo.mutex);
+    }
+    ABTU_free(p_data->p_queues);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    size_t num_units = 0;
+    uint32_t i;
+
+    for (i = 0; i < p_data->num_queues; i++) {
+        num_units += queue_get_size(&p_data->p_queues[i]);
+    }
+    return num_units;
+}
+
+static void pool_push(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    queue_t *p_queue;
+    int i;
+
+    for (i = 0; ; i++) {
+        p_queue = multiq_choose(p_data);
+        if (i == NUM_TRIES - 1) {
+            ABTI_spinlock_acquire(&p_queue->fifo.mutex);
+            break;
+        }
+        if (ABTI_spinlock_try_acquire(&p_queue->fifo.mutex) == ABT_TRUE) break;
+    }
+    ABTI_pool_fifo_push(&p_queue->fifo, pool, unit);
+    ABTI_spinlock_release(&p_queue->fifo.mutex);
+}
+
+static ABT_unit pool_pop(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    ABT_unit unit;
+    queue_t *p_queue;
+    uint32_t i, start;
+
+    for (i = 0; i < NUM_TRIES; i++) {
+        queue_t *p_other = multiq_choose(p_data);
+        p_queue = multiq_choose(p_data);
+        if (queue_get_size(p_other) > queue_get_size(p_queue)) {
+            p_queue = p_other;
+        }
+        if (queue_get_size(p_queue) == 0) continue;
+        if (ABTI_spinlock_try_acquire(&p_queue->fifo.mutex) == ABT_FALSE) {
+            continue;
+        }
+        unit = ABTI_pool_fifo_pop(&p_queue->fifo);
+        ABTI_spinlock_release(&p_queue->fifo.mutex);
+        if (unit != ABT_UNIT_NULL) return unit;
+    }
+
+    /* Look at every sub-queue before reporting that the pool is empty */
+    start = (uint32_t)(multiq_choose(p_data) - p_data->p_queues);
+    for (i = 0; i < p_data->num_queues; i++) {
+        p_queue = &p_data->p_queues[(start + i) % p_data->num_queues];
+        if (queue_get_size(p_queue) == 0) continue;
+        ABTI_spinlock_acquire(&p_queue->fifo.mutex);
+        unit = ABTI_pool_fifo_pop(&p_queue->fifo);
+        ABTI_spinlock_release(&p_queue->fifo.mutex);
+        if (unit != ABT_UNIT_NULL) return unit;
+    }
+    return ABT_UNIT_NULL;
+}
+
+/* Unlink p_unit if it is in p_fifo.  The lock must be held. */
+static inline ABT_bool queue_remove(ABTI_pool_fifo_data *p_fifo,
+                                    unit_t *p_unit)
+{
+    unit_t *p_cur = p_fifo->p_head;
+    size_t i;
+
+    for (i = 0; i < p_fifo->num_units; i++, p_cur = p_cur->p_next) {
+        if (p_cur == p_unit) break;
+    }
+    if (i == p_fifo->num_units) return ABT_FALSE;
+
+    if (p_fifo->num_units == 1) {
+        p_fifo->p_head = NULL;
+        p_fifo->p_tail = NULL;
+    } else {
+        p_unit->p_prev->p_next = p_unit->p_next;
+        p_unit->p_next->p_prev = p_unit->p_prev;
+        if (p_unit == p_fifo->p_head) {
+            p_fifo->p_head = p_unit->p_next;
+        } else if (p_unit == p_fifo->p_tail) {
+            p_fifo->p_tail = p_unit->p_prev;
+        }
+    }
+    p_fifo->num_units--;
+
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool = ABT_POOL_NULL;
+    return ABT_TRUE;
+}
+
+static int pool_remove(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    unit_t *p_unit = (unit_t *)unit;
+    uint32_t i;
+
+    if (p_unit->pool == ABT_POOL_NULL) return ABT_ERR_POOL;
+
+    if (p_unit->pool != pool) {
+        HANDLE_ERROR("Not my pool");
+    }
+
+    for (i = 0; i < p_data->num_queues; i++) {
+        ABTI_pool_fifo_data *p_fifo = &p_data->p_queues[i].fifo;
+        ABT_bool found;
+        if (queue_get_size(&p_data->p_queues[i]) == 0) continue;
+        ABTI_spinlock_acquire(&p_fifo->mutex);
+        found = queue_remove(p_fifo, p_unit);
+        ABTI_spinlock_release(&p_fifo->mutex);
+        if (found == ABT_TRUE) return ABT_SUCCESS;
+    }
+    return ABT_ERR_POOL;
+}
+
+/* Obtain the relaxed FIFO pool definition.  The sub-queues are always locked,
+ * so every access type is served by the same functions. */
+int ABTI_pool_get_multiq_def(ABT_pool_access access, ABT_pool_def *p_def)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+            break;
+
+        default:
+            ABTI_CHECK_TRUE(0, ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    p_def->access               = access;
+    p_def->p_init               = pool_init;
+    p_def->p_free               = pool_free;
+    p_def->p_get_size           = pool_get_size;
+    p_def->p_push               = pool_push;
+    p_def->p_pop                = pool_pop;
+    p_def->p_remove             = pool_remove;
+    p_def->u_get_type           = ABTI_unit_get_type;
+    p_def->u_get_thread         = ABTI_unit_get_thread;
+    p_def->u_get_task           = ABTI_unit_get_task;
+    p_def->u_is_in_pool         = ABTI_unit_is_in_pool;
+    p_def->u_create_from_thread = ABTI_unit_create_from_thread;
+    p_def->u_create_from_task   = ABTI_unit_create_from_task;
+    p_def->u_free               = ABTI_unit_free;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
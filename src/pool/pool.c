@@ -6,6 +6,7 @@
 #include "abti.h"
 
 static inline uint64_t ABTI_pool_get_new_id(void);
+static ABTI_pool_units ABTI_pool_get_units(ABT_pool_def *def);
 
 
 /** @defgroup POOL Pool
@@ -34,7 +35,7 @@ int ABT_pool_create(ABT_pool_def *def, ABT_pool_config config,
     int abt_errno = ABT_SUCCESS;
     ABTI_pool *p_pool;
 
-    p_pool = (ABTI_pool *)ABTU_malloc(sizeof(ABTI_pool));
+    p_pool = (ABTI_pool *)ABTU_malloc_cache_aligned(sizeof(ABTI_pool));
     p_pool->access               = def->access;
     p_pool->automatic            = ABT_FALSE;
     p_pool->num_scheds           = 0;
@@ -46,6 +47,11 @@ int ABT_pool_create(ABT_pool_def *def, ABT_pool_config config,
 #endif
     p_pool->num_blocked          = 0;
     p_pool->num_migrations       = 0;
+    p_pool->split_req            = 0;
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    p_pool->num_parked           = 0;
+    p_pool->parked_mask          = 0;
+#endif
     p_pool->data                 = NULL;
 
     /* Set up the pool functions from def */
@@ -62,6 +68,13 @@ int ABT_pool_create(ABT_pool_def *def, ABT_pool_config config,
     p_pool->p_pop                = def->p_pop;
     p_pool->p_remove             = def->p_remove;
     p_pool->p_free               = def->p_free;
+    p_pool->p_push_many          = NULL;
+    p_pool->p_pop_many           = NULL;
+    p_pool->p_try_push           = NULL;
+    p_pool->p_group              = NULL;
+    p_pool->group_mask           = 0;
+    p_pool->builtin              = ABTI_POOL_BUILTIN_NONE;
+    p_pool->units                = ABTI_pool_get_units(def);
     p_pool->id                   = ABTI_pool_get_new_id();
     LOG_EVENT("[P%" PRIu64 "] created\n", p_pool->id);
 
@@ -75,6 +88,14 @@ int ABT_pool_create(ABT_pool_def *def, ABT_pool_config config,
             goto fn_fail;
         }
     }
+    p_pool->p_stats = (gp_ABTI_global &&
+                       gp_ABTI_global->use_pool_stats == ABT_TRUE)
+                    ? ABTI_pool_stats_create() : NULL;
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    p_pool->p_unit_stats = (gp_ABTI_global &&
+                            gp_ABTI_global->use_unit_stats == ABT_TRUE)
+                         ? ABTI_unit_stats_create() : NULL;
+#endif
 
   fn_exit:
     return abt_errno;
@@ -85,8 +106,6 @@ int ABT_pool_create(ABT_pool_def *def, ABT_pool_config config,
     goto fn_exit;
 }
 
-extern ABT_pool_def ABTI_pool_deque;
-
 /**
  * @ingroup POOL
  * @brief   Create a new pool from a predefined type and return its handle
@@ -115,6 +134,21 @@ int ABT_pool_create_basic(ABT_pool_kind kind, ABT_pool_access access,
             ABTI_ASSERT(access == ABT_POOL_ACCESS_SPMC);
             def = ABTI_pool_deque;
             break;
+        case ABT_POOL_FIFO_LOCKFREE:
+            abt_errno = ABTI_pool_get_fifo_lockfree_def(access, &def);
+            break;
+        case ABT_POOL_PRIO:
+            abt_errno = ABTI_pool_get_prio_def(access, &def);
+            break;
+        case ABT_POOL_EDF:
+            abt_errno = ABTI_pool_get_edf_def(access, &def);
+            break;
+        case ABT_POOL_RING:
+            abt_errno = ABTI_pool_get_ring_def(access, &def);
+            break;
+        case ABT_POOL_MULTIQ:
+            abt_errno = ABTI_pool_get_multiq_def(access, &def);
+            break;
         default:
             abt_errno = ABT_ERR_INV_POOL_KIND;
             break;
@@ -125,6 +159,16 @@ int ABT_pool_create_basic(ABT_pool_kind kind, ABT_pool_access access,
     ABTI_CHECK_ERROR(abt_errno);
     ABTI_pool *p_pool = ABTI_pool_get_ptr(*newpool);
     p_pool->automatic = automatic;
+    /* The predefined pools set the pool field of their units themselves. */
+    p_pool->units = ABTI_POOL_UNITS_EMBEDDED;
+
+    /* Batched operations of the predefined pools */
+    switch (kind) {
+        case ABT_POOL_FIFO:  ABTI_pool_set_fifo_many_fns(p_pool); break;
+        case ABT_POOL_DEQUE: ABTI_pool_set_deque_many_fns(p_pool); break;
+        case ABT_POOL_RING:  ABTI_pool_set_ring_fns(p_pool); break;
+        default: break;
+    }
 
   fn_exit:
     return abt_errno;
@@ -155,6 +199,11 @@ int ABT_pool_free(ABT_pool *pool)
     LOG_EVENT("[P%" PRIu64 "] freed\n", p_pool->id);
 
     p_pool->p_free(h_pool);
+    if (p_pool->p_group) ABTI_pool_group_release(p_pool->p_group);
+    if (p_pool->p_stats) ABTI_pool_stats_free(p_pool->p_stats);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    if (p_pool->p_unit_stats) ABTU_free(p_pool->p_unit_stats);
+#endif
     ABTU_free(p_pool);
 
     *pool = ABT_POOL_NULL;
@@ -213,7 +262,7 @@ int ABT_pool_get_total_size(ABT_pool pool, size_t *size)
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
 
-    total_size = p_pool->p_get_size(pool);
+    total_size = ABTI_pool_call_get_size(p_pool);
     total_size += p_pool->num_blocked;
     total_size += p_pool->num_migrations;
     *size = total_size;
@@ -246,7 +295,7 @@ int ABT_pool_get_size(ABT_pool pool, size_t *size)
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
 
-    *size = p_pool->p_get_size(pool);
+    *size = ABTI_pool_call_get_size(p_pool);
 
   fn_exit:
     return abt_errno;
@@ -276,7 +325,7 @@ int ABT_pool_pop(ABT_pool pool, ABT_unit *p_unit)
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
 
-    unit = p_pool->p_pop(pool);
+    unit = ABTI_pool_call_pop(p_pool);
 
     LOG_EVENT_POOL_POP(p_pool, unit);
 
@@ -290,6 +339,24 @@ int ABT_pool_pop(ABT_pool pool, ABT_unit *p_unit)
     goto fn_exit;
 }
 
+/**
+ * @ingroup POOL
+ * @brief   Pop a unit from the target pool without error checking.
+ *
+ * \c ABT_pool_pop_unchecked() is the same as \c ABT_pool_pop() except that it
+ * checks neither \c pool nor the caller, which must run on an ES.
+ *
+ * @param[in] pool handle to the pool
+ * @return handle to the unit, or \c ABT_UNIT_NULL if \c pool is empty
+ */
+ABT_unit ABT_pool_pop_unchecked(ABT_pool pool)
+{
+    ABTI_pool *p_pool = (ABTI_pool *)pool;
+    ABT_unit unit = ABTI_pool_call_pop(p_pool);
+    LOG_EVENT_POOL_POP(p_pool, unit);
+    return unit;
+}
+
 /**
  * @ingroup POOL
  * @brief   Push a unit to the target pool
@@ -325,6 +392,303 @@ int ABT_pool_push(ABT_pool pool, ABT_unit unit)
     goto fn_exit;
 }
 
+/**
+ * @ingroup POOL
+ * @brief   Push a unit to the target pool without error checking.
+ *
+ * \c ABT_pool_push_unchecked() is the same as \c ABT_pool_push() except that
+ * it checks neither its arguments nor whether the caller may push to
+ * \c pool, i.e., the producer check of the access type is skipped.
+ *
+ * @param[in] pool handle to the pool
+ * @param[in] unit handle to the unit
+ */
+void ABT_pool_push_unchecked(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = (ABTI_pool *)pool;
+
+    LOG_EVENT_POOL_PUSH(p_pool, unit, ABTI_xstream_self());
+    ABTI_trace_unit(ABTI_TRACE_PUSH, p_pool, unit);
+    ABTI_unit_stats_push(p_pool, unit);
+    ABTI_pool_call_push(p_pool, unit);
+    ABTI_POOL_UNPARK(p_pool);
+}
+
+/**
+ * @ingroup POOL
+ * @brief   Push a unit to the target pool unless the pool is full
+ *
+ * \c ABT_pool_try_push() is the same as \c ABT_pool_push() except that it
+ * returns \c ABT_ERR_POOL_FULL without pushing \c unit if \c pool is a
+ * bounded pool that is full, e.g., of the kind \c ABT_POOL_RING, whereas
+ * \c ABT_pool_push() waits for room.  A producer can use it to apply
+ * backpressure.  Other pools are never full.
+ *
+ * @param[in] pool handle to the pool
+ * @param[in] unit handle to the unit
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_POOL_FULL \c pool is full
+ */
+int ABT_pool_try_push(ABT_pool pool, ABT_unit unit)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    ABTI_CHECK_TRUE(unit != ABT_UNIT_NULL, ABT_ERR_UNIT);
+
+    if (p_pool->p_try_push == NULL) {
+        abt_errno = ABT_pool_push(pool, unit);
+        goto fn_exit;
+    }
+
+#ifndef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    /* Save the producer ES information in the pool */
+    abt_errno = ABTI_pool_set_producer(p_pool, ABTI_xstream_self());
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+    /* A full pool is not an error to be reported.  The push time is saved
+     * before the unit becomes visible to other ESs. */
+    ABTI_unit_stats_push(p_pool, unit);
+    if (p_pool->p_try_push(pool, unit) != ABT_SUCCESS) {
+        return ABT_ERR_POOL_FULL;
+    }
+    ABTI_pool_stats_add(p_pool, ABTI_POOL_STATS_PUSH, 1);
+    ABTI_pool_group_set(p_pool);
+    LOG_EVENT_POOL_PUSH(p_pool, unit, ABTI_xstream_self());
+    ABTI_trace_unit(ABTI_TRACE_PUSH, p_pool, unit);
+    ABTI_POOL_UNPARK(p_pool);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup POOL
+ * @brief   Pop at most \c max_units units from the target pool
+ *
+ * \c ABT_pool_pop_many() pops units from \c pool until \c max_units units
+ * are popped or the pool becomes empty, and stores them in \c units.  The
+ * number of popped units is returned through \c num_units.  If the pool
+ * provides a batched pop operation, all units are taken at once, e.g., under
+ * a single lock acquisition.
+ *
+ * @param[in]  pool       handle to the pool
+ * @param[out] units      array of unit handles (at least \c max_units)
+ * @param[in]  max_units  maximum number of units to pop
+ * @param[out] num_units  number of popped units
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_pool_pop_many(ABT_pool pool, ABT_unit *units, size_t max_units,
+                      size_t *num_units)
+{
+    int abt_errno = ABT_SUCCESS;
+    size_t i, num = 0;
+
+    /* If called by an external thread, return an error. */
+    ABTI_CHECK_TRUE(lp_ABTI_local != NULL, ABT_ERR_INV_XSTREAM);
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    if (p_pool->p_pop_many) {
+        num = p_pool->p_pop_many(pool, units, max_units);
+        ABTI_pool_stats_pop_many(p_pool, num);
+    } else {
+        while (num < max_units) {
+            ABT_unit unit = ABTI_pool_call_pop(p_pool);
+            if (unit == ABT_UNIT_NULL) break;
+            units[num++] = unit;
+        }
+    }
+
+    for (i = 0; i < num; i++) {
+        LOG_EVENT_POOL_POP(p_pool, units[i]);
+    }
+
+  fn_exit:
+    *num_units = num;
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup POOL
+ * @brief   Push \c num_units units to the target pool
+ *
+ * \c ABT_pool_push_many() has the same effect as calling \c ABT_pool_push()
+ * for each unit in \c units in order, but the producer check is done only
+ * once.  If the pool provides a batched push operation, all units are added
+ * at once, e.g., under a single lock acquisition.
+ *
+ * @param[in] pool       handle to the pool
+ * @param[in] units      array of unit handles
+ * @param[in] num_units  number of units in \c units
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_pool_push_many(ABT_pool pool, ABT_unit *units, size_t num_units)
+{
+    int abt_errno = ABT_SUCCESS;
+    size_t i;
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    for (i = 0; i < num_units; i++) {
+        ABTI_CHECK_TRUE(units[i] != ABT_UNIT_NULL, ABT_ERR_UNIT);
+    }
+    if (num_units == 0) goto fn_exit;
+
+#ifndef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    /* Save the producer ES information in the pool */
+    abt_errno = ABTI_pool_set_producer(p_pool, ABTI_xstream_self());
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+    for (i = 0; i < num_units; i++) {
+        LOG_EVENT_POOL_PUSH(p_pool, units[i], ABTI_xstream_self());
+        ABTI_unit_stats_push(p_pool, units[i]);
+    }
+
+    if (p_pool->p_push_many) {
+        p_pool->p_push_many(pool, units, num_units);
+        ABTI_pool_stats_add(p_pool, ABTI_POOL_STATS_PUSH, num_units);
+        ABTI_pool_group_set(p_pool);
+    } else {
+        for (i = 0; i < num_units; i++) {
+            ABTI_pool_call_push(p_pool, units[i]);
+        }
+    }
+    ABTI_POOL_UNPARK(p_pool);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup POOL
+ * @brief   Migrate at most \c max_units ready units from one pool to another
+ *
+ * \c ABT_pool_migrate() pops at most \c max_units units from \c source,
+ * changes the associated pool of the migratable ones to \c target and pushes
+ * them to \c target at once.  Units that are not migratable, such as the main
+ * ULT or units of which the migratability is disabled, are pushed back to
+ * \c source.  The migrated units are stored in \c units and their number is
+ * returned through \c num_units.
+ *
+ * Unlike \c ABT_thread_migrate_to_pool(), the migration is done when this
+ * routine returns and no migration request is posted on each unit.  Only the
+ * units waiting in \c source are moved; the others, e.g., running or blocked
+ * ULTs, stay associated with \c source.  The callback functions set by
+ * \c ABT_thread_attr_set_callback() are not called.  Instead, \c cb_func is
+ * called once with the migrated units before they are pushed to \c target if
+ * it is not \c NULL and at least one unit is migrated.
+ *
+ * @param[in]  source     handle to the pool to migrate units from
+ * @param[in]  target     handle to the pool to migrate units to
+ * @param[out] units      array of unit handles (at least \c max_units)
+ * @param[in]  max_units  maximum number of units to migrate
+ * @param[out] num_units  number of migrated units
+ * @param[in]  cb_func    callback function called once per batch
+ * @param[in]  cb_arg     argument for \c cb_func
+ * @return Error code
+ * @retval ABT_SUCCESS              on success
+ * @retval ABT_ERR_MIGRATION_TARGET the same pool is used
+ * @retval ABT_ERR_MIGRATION_NA     migration is not supported
+ */
+int ABT_pool_migrate(ABT_pool source, ABT_pool target, ABT_unit *units,
+                     size_t max_units, size_t *num_units,
+                     void (*cb_func)(ABT_unit *, size_t, void *), void *cb_arg)
+{
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+    int abt_errno = ABT_SUCCESS;
+    size_t i, num = 0, num_popped, num_kept;
+
+    ABTI_pool *p_source = ABTI_pool_get_ptr(source);
+    ABTI_CHECK_NULL_POOL_PTR(p_source);
+    ABTI_pool *p_target = ABTI_pool_get_ptr(target);
+    ABTI_CHECK_NULL_POOL_PTR(p_target);
+
+    /* checking for cases when migration is not allowed */
+    ABTI_CHECK_TRUE(p_source != p_target, ABT_ERR_MIGRATION_TARGET);
+    ABTI_CHECK_TRUE(ABTI_pool_accept_migration(p_target, p_source) == ABT_TRUE,
+                    ABT_ERR_INV_POOL);
+
+    abt_errno = ABT_pool_pop_many(source, units, max_units, &num_popped);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* Move the migratable units to the front of units, keeping their order,
+     * and the others behind them. */
+    for (i = 0; i < num_popped; i++) {
+        ABT_unit unit = units[i];
+        ABT_bool migratable;
+        if (ABTI_pool_unit_get_type(p_source, unit) == ABT_UNIT_TYPE_THREAD) {
+            ABTI_thread *p_thread = ABTI_pool_unit_get_thread(p_source, unit);
+            migratable = (p_thread->type != ABTI_THREAD_TYPE_MAIN &&
+                          p_thread->type != ABTI_THREAD_TYPE_MAIN_SCHED)
+                       ? p_thread->attr.migratable : ABT_FALSE;
+            if (migratable == ABT_TRUE) p_thread->p_pool = p_target;
+        } else {
+            ABTI_task *p_task = ABTI_pool_unit_get_task(p_source, unit);
+            migratable = p_task->migratable;
+            if (migratable == ABT_TRUE) p_task->p_pool = p_target;
+        }
+        if (migratable == ABT_TRUE) {
+            units[i] = units[num];
+            units[num++] = unit;
+        }
+    }
+
+    num_kept = num_popped - num;
+    if (num_kept > 0) {
+        abt_errno = ABT_pool_push_many(source, &units[num], num_kept);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+    if (num == 0) goto fn_exit;
+
+    if (cb_func) cb_func(units, num, cb_arg);
+
+    abt_errno = ABT_pool_push_many(target, units, num);
+    ABTI_CHECK_ERROR(abt_errno);
+
+#ifndef ABT_CONFIG_DISABLE_POOL_CONSUMER_CHECK
+    /* checking the state destination xstream */
+    ABTI_xstream *p_consumer = p_target->consumer;
+    if (p_consumer && p_consumer->state == ABT_XSTREAM_STATE_CREATED) {
+        abt_errno = ABTI_xstream_start(p_consumer);
+        ABTI_CHECK_ERROR_MSG(abt_errno, "ABTI_xstream_start");
+    }
+#endif
+
+  fn_exit:
+    *num_units = num;
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    *num_units = 0;
+    return ABT_ERR_MIGRATION_NA;
+#endif
+}
+
 /**
  * @ingroup POOL
  * @brief   Remove a specified unit from the target pool
@@ -506,6 +870,57 @@ fn_fail:
 #endif
 }
 
+/**
+ * @ingroup POOL
+ * @brief   Push a scheduler that runs inline and stays in a pool
+ *
+ * \c ABT_pool_add_sched_inline() pushes \c sched into \c pool like
+ * \c ABT_pool_add_sched(), but the scheduler, which has to be of the tasklet
+ * type, is invoked by its parent as a function call and is not terminated when
+ * its pools become empty.  Once none of its pools has a unit to pop, the
+ * scheduler returns to its parent and is put back into \c pool.  Until a unit
+ * is pushed into one of its pools, the parent puts it back into \c pool
+ * whenever it is popped, after checking the sizes of its pools, so an idle
+ * nested scheduler costs no context switch.
+ *
+ * The scheduler terminates once its pools are empty after
+ * \c ABT_sched_finish() is called on it or the ES is joined.
+ *
+ * @param[in] pool   handle to the pool
+ * @param[in] sched  handle to the tasklet-type scheduler to push
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_SCHED_TYPE the scheduler is not of the tasklet type
+ */
+int ABT_pool_add_sched_inline(ABT_pool pool, ABT_sched sched)
+{
+#ifdef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+    return ABT_ERR_FEATURE_NA;
+#else
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+    ABTI_CHECK_TRUE(p_sched->type == ABT_SCHED_TYPE_TASK,
+                    ABT_ERR_INV_SCHED_TYPE);
+    ABTI_CHECK_TRUE(p_sched->used == ABTI_SCHED_NOT_USED, ABT_ERR_INV_SCHED);
+
+    p_sched->inline_nested = ABT_TRUE;
+    abt_errno = ABT_pool_add_sched(pool, sched);
+    if (abt_errno != ABT_SUCCESS) {
+        p_sched->inline_nested = ABT_FALSE;
+        goto fn_fail;
+    }
+
+fn_exit:
+    return abt_errno;
+
+fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#endif
+}
+
 /**
  * @ingroup POOL
  * @brief   Get the ID of the target pool
@@ -590,6 +1005,14 @@ void ABTI_pool_print(ABTI_pool *p_pool, FILE *p_os, int indent)
         prefix, p_pool->num_migrations,
         prefix, p_pool->data
     );
+    if (p_pool->p_stats) {
+        ABTI_pool_stats_print(p_pool->p_stats, p_os, prefix);
+    }
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    if (p_pool->p_unit_stats) {
+        ABTI_unit_stats_print(p_pool->p_unit_stats, p_os, prefix);
+    }
+#endif
 
   fn_exit:
     fflush(p_os);
@@ -664,6 +1087,8 @@ int ABTI_pool_set_producer(ABTI_pool *p_pool, ABTI_xstream *p_xstream)
 
     switch (p_pool->access) {
         case ABT_POOL_ACCESS_PRIV:
+            /* The other ESs push to the inbox of a private FIFO pool. */
+            if (p_pool->builtin == ABTI_POOL_BUILTIN_FIFO_PRIV) break;
 #ifndef ABT_CONFIG_DISABLE_POOL_CONSUMER_CHECK
             ABTI_CHECK_TRUE(!p_pool->consumer || p_xstream == p_pool->consumer,
                             ABT_ERR_INV_POOL_ACCESS);
@@ -739,3 +1164,20 @@ static inline uint64_t ABTI_pool_get_new_id(void)
 {
     return (uint64_t)ABTD_atomic_fetch_add_uint64(&g_pool_id, 1);
 }
+
+/* Units of the pool of def.  A pool that uses all the unit functions of the
+ * built-in pools (see ABT_pool_def_set_intrusive_units()) uses the units
+ * embedded in work units. */
+static ABTI_pool_units ABTI_pool_get_units(ABT_pool_def *def)
+{
+    if (def->u_get_type == ABTI_unit_get_type &&
+        def->u_get_thread == ABTI_unit_get_thread &&
+        def->u_get_task == ABTI_unit_get_task &&
+        def->u_is_in_pool == ABTI_unit_is_in_pool &&
+        def->u_create_from_thread == ABTI_unit_create_from_thread &&
+        def->u_create_from_task == ABTI_unit_create_from_task &&
+        def->u_free == ABTI_unit_free) {
+        return ABTI_POOL_UNITS_TRACKED;
+    }
+    return ABTI_POOL_UNITS_CUSTOM;
+}
@@ -0,0 +1,93 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Pool groups.  A pool belongs to at most one group, which lives until the
+ * pool is freed, so a push never sees a group being freed.  Schedulers that
+ * use the same pools in the same order share the group, e.g., the schedulers
+ * of ESs that share their pools.  See abti_pool_group.h for the bitmap. */
+
+static ABTI_spinlock g_pool_group_lock;
+
+static ABT_bool pool_group_match(ABTI_pool_group *p_group, int num_pools,
+                                 ABT_pool *pools)
+{
+    int i;
+    if (p_group->num_pools != num_pools) return ABT_FALSE;
+    for (i = 0; i < num_pools; i++) {
+        if (p_group->pools[i] != pools[i]) return ABT_FALSE;
+        if (ABTI_pool_get_ptr(pools[i])->p_group != p_group) return ABT_FALSE;
+    }
+    return ABT_TRUE;
+}
+
+/* Return the group of the pools with a reference for the caller, or NULL if
+ * they cannot be grouped because there are too many pools or one of them is
+ * in another group. */
+ABTI_pool_group *ABTI_pool_group_get(int num_pools, ABT_pool *pools)
+{
+    ABTI_pool_group *p_group;
+    int i;
+
+    if (num_pools < 2 || num_pools > ABTI_POOL_GROUP_MAX_POOLS) return NULL;
+
+    ABTI_spinlock_acquire(&g_pool_group_lock);
+
+    p_group = ABTI_pool_get_ptr(pools[0])->p_group;
+    if (p_group != NULL) {
+        if (pool_group_match(p_group, num_pools, pools) == ABT_TRUE) {
+            ABTD_atomic_fetch_add_uint32(&p_group->refcount, 1);
+        } else {
+            p_group = NULL;
+        }
+        goto fn_exit;
+    }
+
+    /* The pools must not be in another group or appear twice. */
+    for (i = 0; i < num_pools; i++) {
+        int k;
+        if (ABTI_pool_get_ptr(pools[i])->p_group != NULL) goto fn_exit;
+        for (k = 0; k < i; k++) {
+            if (pools[k] == pools[i]) goto fn_exit;
+        }
+    }
+
+    p_group = (ABTI_pool_group *)ABTU_malloc(sizeof(ABTI_pool_group));
+    p_group->nonempty  = 0;
+    p_group->refcount  = (uint32_t)num_pools + 1;
+    p_group->num_pools = num_pools;
+    p_group->pools = (ABT_pool *)ABTU_malloc(num_pools * sizeof(ABT_pool));
+    memcpy(p_group->pools, pools, num_pools * sizeof(ABT_pool));
+
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool_get_ptr(pools[i])->group_mask = (uint64_t)1 << i;
+    }
+    ABTD_atomic_write_barrier();
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool_get_ptr(pools[i])->p_group = p_group;
+    }
+
+    /* Pushes after this fence set the bits themselves. */
+    ABTD_atomic_mem_barrier();
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[i]);
+        if (ABTI_pool_call_get_size(p_pool) > 0) {
+            ABTD_atomic_fetch_or_uint64(&p_group->nonempty, p_pool->group_mask);
+        }
+    }
+
+  fn_exit:
+    ABTI_spinlock_release(&g_pool_group_lock);
+    return p_group;
+}
+
+void ABTI_pool_group_release(ABTI_pool_group *p_group)
+{
+    if (ABTD_atomic_fetch_sub_uint32(&p_group->refcount, 1) == 1) {
+        ABTU_free(p_group->pools);
+        ABTU_free(p_group);
+    }
+}
@@ -0,0 +1,136 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Operation counters of pools.  Each ES counts the operations that it does on
+ * a pool in its own cache line of counters, so counting does not add
+ * contention to the pool.  The last line is shared by external threads and
+ * ESs whose rank does not fit, and is updated atomically.  See
+ * abti_pool_stats.h for where the counters are updated. */
+
+static const char *g_pool_stats_names[ABTI_POOL_STATS_NUM] = {
+    "pushes", "pops", "empty_pops", "lock_waits", "resizes",
+    "steal_attempts", "steals"
+};
+
+ABTI_pool_stats *ABTI_pool_stats_create(void)
+{
+    ABTI_pool_stats *p_stats;
+    size_t size;
+
+    p_stats = (ABTI_pool_stats *)ABTU_malloc(sizeof(ABTI_pool_stats));
+    p_stats->num_lines = (uint32_t)gp_ABTI_global->max_xstreams + 1;
+    size = sizeof(uint64_t) * ABTI_POOL_STATS_STRIDE * p_stats->num_lines;
+    p_stats->p_counts = (uint64_t *)ABTU_malloc_cache_aligned(size);
+    memset(p_stats->p_counts, 0, size);
+    return p_stats;
+}
+
+void ABTI_pool_stats_free(ABTI_pool_stats *p_stats)
+{
+    ABTU_free(p_stats->p_counts);
+    ABTU_free(p_stats);
+}
+
+/* Operations counted during the reset may be partially lost. */
+void ABTI_pool_stats_reset(ABTI_pool_stats *p_stats)
+{
+    memset(p_stats->p_counts, 0,
+           sizeof(uint64_t) * ABTI_POOL_STATS_STRIDE * p_stats->num_lines);
+}
+
+static inline uint64_t ABTI_pool_stats_read(ABTI_pool_stats *p_stats,
+                                            uint32_t line, int kind)
+{
+    return *(volatile uint64_t *)
+           &p_stats->p_counts[line * ABTI_POOL_STATS_STRIDE + kind];
+}
+
+static void ABTI_pool_stats_sum(ABTI_pool_stats *p_stats, int rank,
+                                uint64_t *p_counts)
+{
+    uint32_t line;
+    int kind;
+
+    for (kind = 0; kind < ABTI_POOL_STATS_NUM; kind++) p_counts[kind] = 0;
+    for (line = 0; line < p_stats->num_lines; line++) {
+        if (rank != ABT_XSTREAM_ANY_RANK && (uint32_t)rank != line) continue;
+        for (kind = 0; kind < ABTI_POOL_STATS_NUM; kind++) {
+            p_counts[kind] += ABTI_pool_stats_read(p_stats, line, kind);
+        }
+    }
+}
+
+/* Get the counters of the ES of rank, or their sums over all ESs and external
+ * threads if rank is ABT_XSTREAM_ANY_RANK.  Operations of an ES whose rank is
+ * not less than max_xstreams at the creation of the pool are counted only in
+ * the sums. */
+void ABTI_pool_stats_get(ABTI_pool_stats *p_stats, int rank,
+                         ABT_pool_stats *p_out)
+{
+    uint64_t counts[ABTI_POOL_STATS_NUM];
+
+    if (rank != ABT_XSTREAM_ANY_RANK &&
+        (uint32_t)rank >= p_stats->num_lines - 1) {
+        memset(p_out, 0, sizeof(ABT_pool_stats));
+        return;
+    }
+    ABTI_pool_stats_sum(p_stats, rank, counts);
+    p_out->num_pushes         = counts[ABTI_POOL_STATS_PUSH];
+    p_out->num_pops           = counts[ABTI_POOL_STATS_POP];
+    p_out->num_empty_pops     = counts[ABTI_POOL_STATS_EMPTY_POP];
+    p_out->num_lock_waits     = counts[ABTI_POOL_STATS_LOCK_WAIT];
+    p_out->num_resizes        = counts[ABTI_POOL_STATS_RESIZE];
+    p_out->num_steal_attempts = counts[ABTI_POOL_STATS_STEAL_ATTEMPT];
+    p_out->num_steals         = counts[ABTI_POOL_STATS_STEAL];
+}
+
+static void ABTI_pool_stats_print_line(FILE *p_os, const char *prefix,
+                                       const char *name, uint64_t *p_counts)
+{
+    uint64_t num_pops;
+    int kind;
+
+    fprintf(p_os, "%s%-14s:", prefix, name);
+    for (kind = 0; kind < ABTI_POOL_STATS_NUM; kind++) {
+        fprintf(p_os, " %s %" PRIu64, g_pool_stats_names[kind],
+                p_counts[kind]);
+    }
+    num_pops = p_counts[ABTI_POOL_STATS_POP]
+             + p_counts[ABTI_POOL_STATS_EMPTY_POP];
+    if (num_pops > 0) {
+        fprintf(p_os, " (%.1f%% empty)",
+                100.0 * (double)p_counts[ABTI_POOL_STATS_EMPTY_POP]
+                / (double)num_pops);
+    }
+    fprintf(p_os, "\n");
+}
+
+void ABTI_pool_stats_print(ABTI_pool_stats *p_stats, FILE *p_os,
+                           const char *prefix)
+{
+    uint64_t counts[ABTI_POOL_STATS_NUM];
+    char name[32];
+    uint32_t line;
+    int kind;
+
+    ABTI_pool_stats_sum(p_stats, ABT_XSTREAM_ANY_RANK, counts);
+    ABTI_pool_stats_print_line(p_os, prefix, "ops (total)", counts);
+    for (line = 0; line < p_stats->num_lines; line++) {
+        uint64_t any = 0;
+        for (kind = 0; kind < ABTI_POOL_STATS_NUM; kind++) {
+            counts[kind] = ABTI_pool_stats_read(p_stats, line, kind);
+            any |= counts[kind];
+        }
+        if (any == 0) continue;
+        if (line < p_stats->num_lines - 1) {
+            sprintf(name, "ops (ES %u)", line);
+        } else {
+            sprintf(name, "ops (others)");
+        }
+        ABTI_pool_stats_print_line(p_os, prefix, name, counts);
+    }
+}
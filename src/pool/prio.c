@@ -0,0 +1,315 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Priority pool implementation
+ *
+ * Each of the ABT_POOL_PRIO_NUM_LEVELS priority levels has its own circular
+ * FIFO list, and a bitmap records which levels are not empty.  push appends
+ * the unit to the list of its level, and pop takes the head of the highest
+ * non-empty level found from the bitmap, so both are O(1).  The priority of a
+ * ULT is given by ABT_thread_attr_set_priority(); tasklets have priority 0.
+ * The level of a unit is recorded at push, so the priority of a ULT can be
+ * changed while it is in the pool (see ABTI_pool_prio_set_priority()).
+ */
+
+#define NUM_LEVELS      ABT_POOL_PRIO_NUM_LEVELS
+#define NUM_WORDS       (NUM_LEVELS / 64)
+
+typedef ABTI_unit unit_t;
+
+struct data {
+    ABTI_spinlock mutex;
+    size_t num_units;
+    uint64_t bitmap[NUM_WORDS];     /* Bit i is set if level i has units */
+    unit_t *p_heads[NUM_LEVELS];    /* Circular lists; p_prev is the tail */
+};
+typedef struct data data_t;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+static inline int unit_get_priority(unit_t *p_unit)
+{
+    if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
+        return ABTI_thread_get_ptr(p_unit->thread)->attr.priority;
+    }
+    return 0;
+}
+
+
+/* Priority queue operations */
+
+static inline void prio_push(data_t *p_data, ABT_pool pool, unit_t *p_unit)
+{
+    int level = unit_get_priority(p_unit);
+    unit_t *p_head = p_data->p_heads[level];
+
+    p_unit->level = level;
+    if (p_head == NULL) {
+        p_unit->p_prev = p_unit;
+        p_unit->p_next = p_unit;
+        p_data->p_heads[level] = p_unit;
+        p_data->bitmap[level / 64] |= (uint64_t)1 << (level % 64);
+    } else {
+        unit_t *p_tail = p_head->p_prev;
+        p_tail->p_next = p_unit;
+        p_head->p_prev = p_unit;
+        p_unit->p_prev = p_tail;
+        p_unit->p_next = p_head;
+    }
+    p_data->num_units++;
+
+    p_unit->pool = pool;
+}
+
+/* Unlink p_unit from the list of level */
+static inline void prio_unlink(data_t *p_data, int level, unit_t *p_unit)
+{
+    if (p_unit->p_next == p_unit) {
+        p_data->p_heads[level] = NULL;
+        p_data->bitmap[level / 64] &= ~((uint64_t)1 << (level % 64));
+    } else {
+        p_unit->p_prev->p_next = p_unit->p_next;
+        p_unit->p_next->p_prev = p_unit->p_prev;
+        if (p_data->p_heads[level] == p_unit) {
+            p_data->p_heads[level] = p_unit->p_next;
+        }
+    }
+    p_data->num_units--;
+
+    p_unit->p_prev = NULL;
+    p_unit->p_next = NULL;
+    p_unit->pool = ABT_POOL_NULL;
+}
+
+static inline ABT_unit prio_pop(data_t *p_data)
+{
+    int i;
+
+    if (p_data->num_units == 0) return ABT_UNIT_NULL;
+
+    for (i = NUM_WORDS - 1; i >= 0; i--) {
+        uint64_t word = p_data->bitmap[i];
+        if (word) {
+            int level = i * 64 + 63 - __builtin_clzll(word);
+            unit_t *p_unit = p_data->p_heads[level];
+            prio_unlink(p_data, level, p_unit);
+            return (ABT_unit)p_unit;
+        }
+    }
+    return ABT_UNIT_NULL;
+}
+
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno = ABT_SUCCESS;
+    ABT_pool_access access;
+
+    data_t *p_data = (data_t *)ABTU_malloc_cache_aligned(sizeof(data_t));
+
+    ABT_pool_get_access(pool, &access);
+
+    if (access != ABT_POOL_ACCESS_PRIV) {
+        /* Initialize the mutex */
+        ABTI_spinlock_create(&p_data->mutex);
+    }
+
+    p_data->num_units = 0;
+    memset(p_data->bitmap, 0, sizeof(p_data->bitmap));
+    memset(p_data->p_heads, 0, sizeof(p_data->p_heads));
+
+    ABT_pool_set_data(pool, p_data);
+
+    return abt_errno;
+}
+
+static int pool_free(ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    void *data;
+    ABT_pool_access access;
+    ABT_pool_get_data(pool, &data);
+    data_t *p_data = pool_get_data_ptr(data);
+
+    ABT_pool_get_access(pool, &access);
+    if (access != ABT_POOL_ACCESS_PRIV) {
+        ABTI_spinlock_free(&p_data->mutex);
+    }
+
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    return p_data->num_units;
+}
+
+static void pool_push_shared(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    prio_push(p_data, pool, (unit_t *)unit);
+    ABTI_spinlock_release(&p_data->mutex);
+}
+
+static void pool_push_private(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    prio_push(p_data, pool, (unit_t *)unit);
+}
+
+static ABT_unit pool_pop_shared(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    ABT_unit h_unit;
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    h_unit = prio_pop(p_data);
+    ABTI_spinlock_release(&p_data->mutex);
+
+    return h_unit;
+}
+
+static ABT_unit pool_pop_private(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    return prio_pop(p_data);
+}
+
+static int pool_remove_shared(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    unit_t *p_unit = (unit_t *)unit;
+
+    if (p_data->num_units == 0) return ABT_ERR_POOL;
+    if (p_unit->pool == ABT_POOL_NULL) return ABT_ERR_POOL;
+
+    if (p_unit->pool != pool) {
+        HANDLE_ERROR("Not my pool");
+    }
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    /* The unit may have been popped meanwhile */
+    if (p_unit->pool != pool) {
+        ABTI_spinlock_release(&p_data->mutex);
+        return ABT_ERR_POOL;
+    }
+    prio_unlink(p_data, p_unit->level, p_unit);
+    ABTI_spinlock_release(&p_data->mutex);
+
+    return ABT_SUCCESS;
+}
+
+static int pool_remove_private(ABT_pool pool, ABT_unit unit)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    unit_t *p_unit = (unit_t *)unit;
+
+    if (p_data->num_units == 0) return ABT_ERR_POOL;
+    if (p_unit->pool == ABT_POOL_NULL) return ABT_ERR_POOL;
+
+    if (p_unit->pool != pool) {
+        HANDLE_ERROR("Not my pool");
+    }
+
+    prio_unlink(p_data, p_unit->level, p_unit);
+
+    return ABT_SUCCESS;
+}
+
+/* Obtain the priority pool definition according to the access type */
+int ABTI_pool_get_prio_def(ABT_pool_access access, ABT_pool_def *p_def)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    /* Definitions according to the access type */
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+            p_def->p_push   = pool_push_private;
+            p_def->p_pop    = pool_pop_private;
+            p_def->p_remove = pool_remove_private;
+            break;
+
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+            p_def->p_push   = pool_push_shared;
+            p_def->p_pop    = pool_pop_shared;
+            p_def->p_remove = pool_remove_shared;
+            break;
+
+        default:
+            ABTI_CHECK_TRUE(0, ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    /* Common definitions regardless of the access type */
+    p_def->access               = access;
+    p_def->p_init               = pool_init;
+    p_def->p_free               = pool_free;
+    p_def->p_get_size           = pool_get_size;
+    p_def->u_get_type           = ABTI_unit_get_type;
+    p_def->u_get_thread         = ABTI_unit_get_thread;
+    p_def->u_get_task           = ABTI_unit_get_task;
+    p_def->u_is_in_pool         = ABTI_unit_is_in_pool;
+    p_def->u_create_from_thread = ABTI_unit_create_from_thread;
+    p_def->u_create_from_task   = ABTI_unit_create_from_task;
+    p_def->u_free               = ABTI_unit_free;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Set the priority of the ULT p_thread, whose pool is the priority pool
+ * p_pool.  If the ULT is in p_pool, it is moved to the list of the new
+ * priority.  A private pool can be accessed only by its ES, so the unit of a
+ * ULT in it is not moved, and the new priority applies from its next push. */
+void ABTI_pool_prio_set_priority(ABTI_pool *p_pool, ABTI_thread *p_thread,
+                                 int priority)
+{
+    ABT_pool pool = ABTI_pool_get_handle(p_pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    unit_t *p_unit = (unit_t *)p_thread->unit;
+
+    ABTI_ASSERT(p_pool->p_init == pool_init);
+    if (p_pool->access == ABT_POOL_ACCESS_PRIV) {
+        p_thread->attr.priority = priority;
+        return;
+    }
+
+    ABTI_spinlock_acquire(&p_data->mutex);
+    if (p_unit->pool == pool && p_unit->level != priority) {
+        prio_unlink(p_data, p_unit->level, p_unit);
+        p_thread->attr.priority = priority;
+        prio_push(p_data, pool, p_unit);
+    } else {
+        p_thread->attr.priority = priority;
+    }
+    ABTI_spinlock_release(&p_data->mutex);
+}
+
+/* Return ABT_TRUE if p_pool is a pool of the kind ABT_POOL_PRIO */
+ABT_bool ABTI_pool_is_prio(ABTI_pool *p_pool)
+{
+    return (p_pool->p_init == pool_init) ? ABT_TRUE : ABT_FALSE;
+}
@@ -0,0 +1,306 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+#include <stdatomic.h>
+
+/* Bounded ring pool implementation
+ *
+ * Units are kept in a fixed-size circular array whose capacity is set by
+ * ABT_POOL_RING_CAPACITY and rounded up to a power of two.  Producers write a
+ * slot and then publish the tail index with a release store, and consumers
+ * publish the head index in the same way, so a single producer and a single
+ * consumer never take a lock.  Multiple producers (MPSC and MPMC) serialize
+ * on a push lock, and multiple consumers (SPMC and MPMC) on a pop lock.  The
+ * head and the tail are on separate cache lines, and each side keeps a cached
+ * copy of the other side's index to read it only when the ring looks full or
+ * empty.  The batched operations publish the index once per batch.
+ *
+ * A push to a full ring waits until consumers make room, while
+ * ABT_pool_try_push() returns ABT_ERR_POOL_FULL instead.  A producer must
+ * therefore not be the only consumer of a full ring.
+ *
+ * As in the deque pool, a unit is owned by whoever first clears its pool
+ * field, so a unit that has been removed is skipped when its slot is popped.
+ */
+
+typedef ABTI_unit unit_t;
+
+typedef struct data {
+    /* Producers' end */
+    _Atomic size_t tail ABTI_CACHE_ALIGNED;
+    size_t head_cache;                  /* Last head seen by producers */
+    ABTI_spinlock push_lock;
+    /* Consumers' end */
+    _Atomic size_t head ABTI_CACHE_ALIGNED;
+    size_t tail_cache;                  /* Last tail seen by consumers */
+    ABTI_spinlock pop_lock;
+    /* Read-only after initialization */
+    size_t capacity ABTI_CACHE_ALIGNED;
+    size_t mask;
+    ABT_bool multi_producer;
+    ABT_bool multi_consumer;
+    unit_t **p_slots;
+} data_t;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+/* Take the ownership of a unit found in the ring. */
+static inline ABT_bool unit_claim(ABT_pool pool, unit_t *p_unit)
+{
+    return ABTD_atomic_cas_uint64((uint64_t *)&p_unit->pool, (uint64_t)pool,
+                                  (uint64_t)ABT_POOL_NULL) == (uint64_t)pool
+           ? ABT_TRUE : ABT_FALSE;
+}
+
+
+/* Ring operations */
+
+/* Return the number of free slots seen by the producer holding the tail t.
+ * The head is read only when the cached one shows fewer than num slots. */
+static inline size_t ring_room(data_t *p_data, size_t t, size_t num)
+{
+    size_t room = p_data->capacity - (t - p_data->head_cache);
+    if (room < num) {
+        p_data->head_cache = atomic_load_explicit(&p_data->head,
+                                                  memory_order_acquire);
+        room = p_data->capacity - (t - p_data->head_cache);
+    }
+    return room;
+}
+
+/* Return the number of units seen by the consumer holding the head h */
+static inline size_t ring_avail(data_t *p_data, size_t h)
+{
+    size_t avail = p_data->tail_cache - h;
+    if (avail == 0) {
+        p_data->tail_cache = atomic_load_explicit(&p_data->tail,
+                                                  memory_order_acquire);
+        avail = p_data->tail_cache - h;
+    }
+    return avail;
+}
+
+/* Push num units, waiting for room if block is ABT_TRUE.  Otherwise, nothing
+ * is pushed unless all of them fit.  Return the number of pushed units. */
+static size_t ring_push(data_t *p_data, ABT_pool pool, ABT_unit *units,
+                        size_t num, ABT_bool block)
+{
+    size_t t, i, done = 0;
+
+    if (p_data->multi_producer) ABTI_spinlock_acquire(&p_data->push_lock);
+    t = atomic_load_explicit(&p_data->tail, memory_order_relaxed);
+
+    if (block == ABT_FALSE && ring_room(p_data, t, num) < num) goto fn_exit;
+
+    while (done < num) {
+        size_t room = ring_room(p_data, t, num - done);
+        if (room == 0) {
+            ABTD_atomic_pause();
+            continue;
+        }
+        if (room > num - done) room = num - done;
+        for (i = 0; i < room; i++) {
+            unit_t *p_unit = (unit_t *)units[done + i];
+            p_unit->pool = pool;
+            p_data->p_slots[(t + i) & p_data->mask] = p_unit;
+        }
+        t += room;
+        done += room;
+        atomic_store_explicit(&p_data->tail, t, memory_order_release);
+    }
+
+  fn_exit:
+    if (p_data->multi_producer) ABTI_spinlock_release(&p_data->push_lock);
+    return done;
+}
+
+/* Pop at most max_units units */
+static size_t ring_pop(data_t *p_data, ABT_pool pool, ABT_unit *units,
+                       size_t max_units)
+{
+    size_t h, avail, i, num = 0;
+
+    if (p_data->multi_consumer) ABTI_spinlock_acquire(&p_data->pop_lock);
+    h = atomic_load_explicit(&p_data->head, memory_order_relaxed);
+
+    while (num < max_units && (avail = ring_avail(p_data, h)) > 0) {
+        if (avail > max_units - num) avail = max_units - num;
+        for (i = 0; i < avail; i++) {
+            unit_t *p_unit = p_data->p_slots[(h + i) & p_data->mask];
+            /* Skip units that have been removed */
+            if (unit_claim(pool, p_unit) == ABT_TRUE) {
+                units[num++] = (ABT_unit)p_unit;
+            }
+        }
+        h += avail;
+        atomic_store_explicit(&p_data->head, h, memory_order_release);
+    }
+
+    if (p_data->multi_consumer) ABTI_spinlock_release(&p_data->pop_lock);
+    return num;
+}
+
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno = ABT_SUCCESS;
+    ABT_pool_access access;
+    size_t capacity = 1;
+
+    data_t *p_data = (data_t *)ABTU_malloc_cache_aligned(sizeof(data_t));
+
+    ABT_pool_get_access(pool, &access);
+    p_data->multi_producer = (access == ABT_POOL_ACCESS_MPSC ||
+                              access == ABT_POOL_ACCESS_MPMC)
+                           ? ABT_TRUE : ABT_FALSE;
+    p_data->multi_consumer = (access == ABT_POOL_ACCESS_SPMC ||
+                              access == ABT_POOL_ACCESS_MPMC)
+                           ? ABT_TRUE : ABT_FALSE;
+    if (p_data->multi_producer) ABTI_spinlock_create(&p_data->push_lock);
+    if (p_data->multi_consumer) ABTI_spinlock_create(&p_data->pop_lock);
+
+    while (capacity < gp_ABTI_global->pool_ring_capacity) capacity *= 2;
+    p_data->capacity = capacity;
+    p_data->mask = capacity - 1;
+    p_data->p_slots = (unit_t **)ABTU_malloc_cache_aligned(
+            capacity * sizeof(unit_t *));
+
+    atomic_init(&p_data->tail, 0);
+    atomic_init(&p_data->head, 0);
+    p_data->head_cache = 0;
+    p_data->tail_cache = 0;
+
+    ABT_pool_set_data(pool, p_data);
+
+    return abt_errno;
+}
+
+static int pool_free(ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+
+    if (p_data->multi_producer) ABTI_spinlock_free(&p_data->push_lock);
+    if (p_data->multi_consumer) ABTI_spinlock_free(&p_data->pop_lock);
+
+    ABTU_free(p_data->p_slots);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+/* Units that have been removed are counted until their slots are popped. */
+static size_t pool_get_size(ABT_pool pool)
+{
+    data_t *p_data = pool_get_data_ptr(ABTI_pool_get_data(pool));
+    size_t h = atomic_load_explicit(&p_data->head, memory_order_acquire);
+    size_t t = atomic_load_explicit(&p_data->tail, memory_order_acquire);
+    return (t > h) ? t - h : 0;
+}
+
+static void pool_push(ABT_pool pool, ABT_unit unit)
+{
+    void *data = ABTI_pool_get_data(pool);
+    ring_push(pool_get_data_ptr(data), pool, &unit, 1, ABT_TRUE);
+}
+
+static int pool_try_push(ABT_pool pool, ABT_unit unit)
+{
+    void *data = ABTI_pool_get_data(pool);
+    size_t num = ring_push(pool_get_data_ptr(data), pool, &unit, 1, ABT_FALSE);
+    return (num == 1) ? ABT_SUCCESS : ABT_ERR_POOL_FULL;
+}
+
+static ABT_unit pool_pop(ABT_pool pool)
+{
+    void *data = ABTI_pool_get_data(pool);
+    ABT_unit unit;
+    if (ring_pop(pool_get_data_ptr(data), pool, &unit, 1) == 0) {
+        return ABT_UNIT_NULL;
+    }
+    return unit;
+}
+
+static void pool_push_many(ABT_pool pool, ABT_unit *units, size_t num_units)
+{
+    void *data = ABTI_pool_get_data(pool);
+    ring_push(pool_get_data_ptr(data), pool, units, num_units, ABT_TRUE);
+}
+
+static size_t pool_pop_many(ABT_pool pool, ABT_unit *units, size_t max_units)
+{
+    void *data = ABTI_pool_get_data(pool);
+    return ring_pop(pool_get_data_ptr(data), pool, units, max_units);
+}
+
+static int pool_remove(ABT_pool pool, ABT_unit unit)
+{
+    unit_t *p_unit = (unit_t *)unit;
+
+    if (p_unit->pool == ABT_POOL_NULL) return ABT_ERR_POOL;
+
+    if (p_unit->pool != pool) {
+        HANDLE_ERROR("Not my pool");
+    }
+
+    /* The slot is skipped when it is popped. */
+    return (unit_claim(pool, p_unit) == ABT_TRUE) ? ABT_SUCCESS : ABT_ERR_POOL;
+}
+
+/* Obtain the ring pool definition.  The synchronization needed by the access
+ * type is decided in pool_init(). */
+int ABTI_pool_get_ring_def(ABT_pool_access access, ABT_pool_def *p_def)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+            break;
+
+        default:
+            ABTI_CHECK_TRUE(0, ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    p_def->access               = access;
+    p_def->p_init               = pool_init;
+    p_def->p_free               = pool_free;
+    p_def->p_get_size           = pool_get_size;
+    p_def->p_push               = pool_push;
+    p_def->p_pop                = pool_pop;
+    p_def->p_remove             = pool_remove;
+    p_def->u_get_type           = ABTI_unit_get_type;
+    p_def->u_get_thread         = ABTI_unit_get_thread;
+    p_def->u_get_task           = ABTI_unit_get_task;
+    p_def->u_is_in_pool         = ABTI_unit_is_in_pool;
+    p_def->u_create_from_thread = ABTI_unit_create_from_thread;
+    p_def->u_create_from_task   = ABTI_unit_create_from_task;
+    p_def->u_free               = ABTI_unit_free;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Set the batched and non-blocking operations */
+void ABTI_pool_set_ring_fns(ABTI_pool *p_pool)
+{
+    p_pool->p_push_many = pool_push_many;
+    p_pool->p_pop_many  = pool_pop_many;
+    p_pool->p_try_push  = pool_try_push;
+}
@@ -0,0 +1,272 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#define _GNU_SOURCE
+#include "abti.h"
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+/* Sampling profiler.  A timer of each ES that counts the CPU time of the ES
+ * periodically interrupts it, and the signal handler counts the function of
+ * the running work unit and its pool in a table of the ES.  The tables
+ * outlive their ESs so that the whole execution can be written on
+ * ABT_finalize(). */
+
+/* Kinds of what an ES is running when it is sampled */
+#define ABTI_PROFILE_THREAD     0   /* ULT */
+#define ABTI_PROFILE_TASK       1   /* Tasklet */
+#define ABTI_PROFILE_MAIN       2   /* Primary ULT */
+#define ABTI_PROFILE_SCHED      3   /* Scheduler */
+#define ABTI_PROFILE_NONE       4   /* Nothing, e.g., the ES is starting */
+#define ABTI_PROFILE_NUM_KINDS  5
+
+/* Number of entries of each table (a power of two) */
+#define ABTI_PROFILE_NUM_ENTRIES    1024
+
+static const char *g_profile_names[ABTI_PROFILE_NUM_KINDS] = {
+    "ULT", "tasklet", "main", "sched", "none"
+};
+
+void ABTI_profile_init(void)
+{
+    gp_ABTI_global->p_profiles = NULL;
+}
+
+void ABTI_profile_xstream_init(ABTI_xstream *p_xstream)
+{
+    ABTI_profile *p_profile;
+
+    p_xstream->p_profile = NULL;
+    p_xstream->profiling = ABT_FALSE;
+    if (gp_ABTI_global->profile_interval_nsec <= 0) return;
+
+    p_profile = (ABTI_profile *)ABTU_malloc(sizeof(ABTI_profile));
+    p_profile->num_samples = 0;
+    p_profile->num_dropped = 0;
+    p_profile->mask = ABTI_PROFILE_NUM_ENTRIES - 1;
+    p_profile->rank = p_xstream->rank;
+    p_profile->p_entries = (ABTI_profile_entry *)ABTU_calloc(
+            ABTI_PROFILE_NUM_ENTRIES, sizeof(ABTI_profile_entry));
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    p_profile->p_next = gp_ABTI_global->p_profiles;
+    gp_ABTI_global->p_profiles = p_profile;
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+
+    p_xstream->p_profile = p_profile;
+}
+
+/* Start the profiling timer of the calling ES.  This has to be called by the
+ * thread that runs the ES. */
+void ABTI_profile_start(ABTI_xstream *p_xstream)
+{
+    if (p_xstream->p_profile == NULL) return;
+
+    if (ABTD_profile_timer_create(&p_xstream->profile_timer,
+                                  gp_ABTI_global->profile_interval_nsec)
+        == ABT_SUCCESS) {
+        p_xstream->profiling = ABT_TRUE;
+    }
+}
+
+void ABTI_profile_stop(ABTI_xstream *p_xstream)
+{
+    if (p_xstream->profiling == ABT_TRUE) {
+        ABTD_profile_timer_free(&p_xstream->profile_timer);
+        p_xstream->profiling = ABT_FALSE;
+    }
+}
+
+/* Called by the signal handler on the interrupted ES.  Only the handler of
+ * the ES writes to its table, so no synchronization is needed, and nothing
+ * here may take a lock or allocate memory. */
+void ABTI_profile_sample(void)
+{
+    ABTI_local *p_local = lp_ABTI_local;
+    ABTI_xstream *p_xstream;
+    ABTI_profile *p_profile;
+    ABTI_profile_entry *p_entry;
+    ABTI_thread *p_thread;
+    ABTI_task *p_task;
+    ABTI_pool *p_pool = NULL;
+    uint64_t func = 0, pool_id, hash, i;
+    uint32_t kind;
+
+    /* External threads are not sampled. */
+    if (p_local == NULL) return;
+    p_xstream = p_local->p_xstream;
+    if (p_xstream == NULL || (p_profile = p_xstream->p_profile) == NULL) {
+        return;
+    }
+
+    p_task = p_local->p_task;
+    p_thread = p_local->p_thread;
+    if (p_task != NULL) {
+        kind = ABTI_PROFILE_TASK;
+        p_pool = p_task->p_pool;
+        if (p_task->f_task == ABTI_task_run_resumable) {
+            ABTI_task_resumable *p_res = (ABTI_task_resumable *)p_task->p_arg;
+            func = (uint64_t)(uintptr_t)p_res->f_task;
+        } else {
+            func = (uint64_t)(uintptr_t)p_task->f_task;
+        }
+    } else if (p_thread != NULL) {
+        p_pool = p_thread->p_pool;
+        if (p_thread->type == ABTI_THREAD_TYPE_MAIN) {
+            kind = ABTI_PROFILE_MAIN;
+        } else if (p_thread->type == ABTI_THREAD_TYPE_MAIN_SCHED) {
+            kind = ABTI_PROFILE_SCHED;
+#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+        } else if (p_thread->is_sched != NULL) {
+            kind = ABTI_PROFILE_SCHED;
+#endif
+        } else {
+            kind = ABTI_PROFILE_THREAD;
+            func = (uint64_t)(uintptr_t)
+                   ABTD_thread_context_get_func(&p_thread->ctx);
+        }
+    } else {
+        kind = ABTI_PROFILE_NONE;
+    }
+    pool_id = p_pool ? p_pool->id : UINT64_MAX;
+
+    p_profile->num_samples++;
+    hash = ((func >> 4) ^ (pool_id * 0x9e3779b97f4a7c15ULL) ^ kind)
+         * 0x9e3779b97f4a7c15ULL;
+    for (i = 0; i <= p_profile->mask; i++) {
+        p_entry = &p_profile->p_entries[((hash >> 32) + i) & p_profile->mask];
+        if (p_entry->used == 0) {
+            p_entry->func = func;
+            p_entry->pool_id = pool_id;
+            p_entry->kind = kind;
+            p_entry->count = 1;
+            ABTD_compiler_barrier();
+            *(volatile uint32_t *)&p_entry->used = 1;
+            return;
+        }
+        if (p_entry->func == func && p_entry->pool_id == pool_id &&
+            p_entry->kind == kind) {
+            *(volatile uint64_t *)&p_entry->count = p_entry->count + 1;
+            return;
+        }
+    }
+    p_profile->num_dropped++;
+}
+
+static int ABTI_profile_compare(const void *p_a, const void *p_b)
+{
+    uint64_t a = (*(ABTI_profile_entry *const *)p_a)->count;
+    uint64_t b = (*(ABTI_profile_entry *const *)p_b)->count;
+    return (a < b) ? 1 : ((a > b) ? -1 : 0);
+}
+
+void ABTI_profile_print_func(FILE *p_os, uint64_t func)
+{
+#ifdef HAVE_DLADDR
+    Dl_info info;
+#endif
+
+    if (func == 0) {
+        fprintf(p_os, "-");
+        return;
+    }
+    fprintf(p_os, "0x%" PRIx64, func);
+#ifdef HAVE_DLADDR
+    if (dladdr((void *)(uintptr_t)func, &info) != 0) {
+        if (info.dli_sname != NULL) {
+            fprintf(p_os, " %s", info.dli_sname);
+            if ((uintptr_t)info.dli_saddr != func) {
+                fprintf(p_os, "+0x%" PRIx64,
+                        func - (uint64_t)(uintptr_t)info.dli_saddr);
+            }
+        }
+        if (info.dli_fname != NULL) fprintf(p_os, " (%s)", info.dli_fname);
+    }
+#endif
+}
+
+/* Print the samples of one ES, the most frequent first */
+static void ABTI_profile_print_xstream(FILE *p_os, ABTI_profile *p_profile)
+{
+    uint64_t num_samples = *(volatile uint64_t *)&p_profile->num_samples;
+    ABTI_profile_entry **pp_entries;
+    uint64_t i, num = 0;
+
+    fprintf(p_os, "ES %" PRIu64 ": %" PRIu64 " samples, %" PRIu64
+            " dropped\n", p_profile->rank, num_samples,
+            p_profile->num_dropped);
+    if (num_samples == 0) return;
+
+    pp_entries = (ABTI_profile_entry **)ABTU_malloc(
+            sizeof(ABTI_profile_entry *) * (p_profile->mask + 1));
+    for (i = 0; i <= p_profile->mask; i++) {
+        ABTI_profile_entry *p_entry = &p_profile->p_entries[i];
+        if (*(volatile uint32_t *)&p_entry->used) pp_entries[num++] = p_entry;
+    }
+    qsort(pp_entries, num, sizeof(ABTI_profile_entry *), ABTI_profile_compare);
+
+    for (i = 0; i < num; i++) {
+        ABTI_profile_entry *p_entry = pp_entries[i];
+        fprintf(p_os, "  %10" PRIu64 " %6.2f%%  %-7s  ", p_entry->count,
+                100.0 * (double)p_entry->count / (double)num_samples,
+                g_profile_names[p_entry->kind]);
+        if (p_entry->pool_id == UINT64_MAX) {
+            fprintf(p_os, "%-6s  ", "-");
+        } else {
+            fprintf(p_os, "P%-5" PRIu64 "  ", p_entry->pool_id);
+        }
+        ABTI_profile_print_func(p_os, p_entry->func);
+        fprintf(p_os, "\n");
+    }
+    ABTU_free(pp_entries);
+}
+
+void ABTI_profile_print(FILE *p_os)
+{
+    ABTI_profile *p_profile;
+
+    fprintf(p_os, "# Argobots profile: a sample every %ld usec of CPU time\n"
+            "# samples percent kind pool function\n",
+            gp_ABTI_global->profile_interval_nsec / 1000);
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    for (p_profile = gp_ABTI_global->p_profiles; p_profile;
+         p_profile = p_profile->p_next) {
+        ABTI_profile_print_xstream(p_os, p_profile);
+    }
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+    fflush(p_os);
+}
+
+void ABTI_profile_finalize(void)
+{
+    ABTI_profile *p_profile = gp_ABTI_global->p_profiles;
+    char *filename = gp_ABTI_global->profile_filename;
+    FILE *fp = NULL;
+
+    if (p_profile == NULL) return;
+
+    if (filename != NULL) {
+        if (!strcmp(filename, "stdout")) {
+            fp = stdout;
+        } else if (!strcmp(filename, "stderr")) {
+            fp = stderr;
+        } else {
+            fp = fopen(filename, "w");
+        }
+    }
+    if (fp != NULL) {
+        ABTI_profile_print(fp);
+        if (fp != stdout && fp != stderr) fclose(fp);
+    }
+
+    while (p_profile) {
+        ABTI_profile *p_next = p_profile->p_next;
+        ABTU_free(p_profile->p_entries);
+        ABTU_free(p_profile);
+        p_profile = p_next;
+    }
+    gp_ABTI_global->p_profiles = NULL;
+}
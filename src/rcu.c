@@ -0,0 +1,329 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+
+/** @defgroup RCU Read-Copy-Update (RCU)
+ * RCU lets readers access shared data without locks or atomic operations,
+ * while a writer replaces the data and frees the old version once no reader
+ * can be using it.  This is quiescent-state-based RCU: an ES is in a quiescent
+ * state whenever its scheduler checks events, since no work unit is running
+ * then.  Each ES records there the global epoch that it has seen, and a grace
+ * period that starts at an epoch ends once every ES has recorded that epoch or
+ * is offline, i.e., is parked or does not run its scheduler.
+ *
+ * A read-side critical section between \c ABT_rcu_read_lock() and
+ * \c ABT_rcu_read_unlock() must not yield, block, or migrate, because the
+ * sections are counted per ES.  A section that has yielded anyway only delays
+ * grace periods until it ends.  External threads cannot be readers.  An ES
+ * that blocks in the OS, e.g., in a system call made by a work unit, delays
+ * grace periods until it returns to its scheduler.
+ */
+
+void ABTI_rcu_init(void)
+{
+    gp_ABTI_global->rcu_epoch = 1;
+    ABTI_spinlock_create(&gp_ABTI_global->rcu_lock);
+    gp_ABTI_global->p_rcu_xstreams = NULL;
+    gp_ABTI_global->p_rcu_orphans = NULL;
+}
+
+static void ABTI_rcu_run_cbs(ABTI_rcu_cb *p_cb)
+{
+    while (p_cb != NULL) {
+        ABTI_rcu_cb *p_next = p_cb->p_next;
+        p_cb->func(p_cb->arg);
+        ABTU_free(p_cb);
+        p_cb = p_next;
+    }
+}
+
+/* No ES is running, so the callbacks left can be called. */
+void ABTI_rcu_finalize(void)
+{
+    ABTI_rcu_run_cbs(gp_ABTI_global->p_rcu_orphans);
+    gp_ABTI_global->p_rcu_orphans = NULL;
+    ABTI_spinlock_free(&gp_ABTI_global->rcu_lock);
+}
+
+/* p_xstream starts its main scheduler and joins grace periods. */
+void ABTI_rcu_xstream_start(ABTI_xstream *p_xstream)
+{
+    p_xstream->rcu_nesting = 0;
+    p_xstream->p_rcu_head = NULL;
+    p_xstream->p_rcu_tail = NULL;
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->rcu_lock);
+    p_xstream->rcu_epoch = 0;
+    ABTI_rcu_online(p_xstream);
+    p_xstream->p_rcu_next = gp_ABTI_global->p_rcu_xstreams;
+    gp_ABTI_global->p_rcu_xstreams = p_xstream;
+    ABTI_spinlock_release(&gp_ABTI_global->rcu_lock);
+}
+
+/* Must be called with rcu_lock held */
+static void ABTI_rcu_orphan_cbs(ABTI_xstream *p_xstream)
+{
+    if (p_xstream->p_rcu_head != NULL) {
+        p_xstream->p_rcu_tail->p_next = gp_ABTI_global->p_rcu_orphans;
+        gp_ABTI_global->p_rcu_orphans = p_xstream->p_rcu_head;
+        p_xstream->p_rcu_head = NULL;
+        p_xstream->p_rcu_tail = NULL;
+    }
+}
+
+/* p_xstream has terminated its main scheduler.  Its pending callbacks are
+ * left to the other ESs. */
+void ABTI_rcu_xstream_stop(ABTI_xstream *p_xstream)
+{
+    ABTI_xstream **pp_xstream;
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->rcu_lock);
+    pp_xstream = &gp_ABTI_global->p_rcu_xstreams;
+    while (*pp_xstream != p_xstream) pp_xstream = &(*pp_xstream)->p_rcu_next;
+    *pp_xstream = p_xstream->p_rcu_next;
+    p_xstream->rcu_epoch = 0;
+    ABTI_rcu_orphan_cbs(p_xstream);
+    ABTI_spinlock_release(&gp_ABTI_global->rcu_lock);
+}
+
+/* p_xstream is going to park.  Its pending callbacks are left to the ESs
+ * that keep running, so that they are not delayed until it wakes up. */
+void ABTI_rcu_xstream_park(ABTI_xstream *p_xstream)
+{
+    ABTI_spinlock_acquire(&gp_ABTI_global->rcu_lock);
+    ABTI_rcu_orphan_cbs(p_xstream);
+    ABTI_spinlock_release(&gp_ABTI_global->rcu_lock);
+}
+
+/* Return the last epoch whose grace period has ended */
+static uint64_t ABTI_rcu_get_done(void)
+{
+    uint64_t done = *(volatile uint64_t *)&gp_ABTI_global->rcu_epoch;
+    ABTI_xstream *p_xstream;
+
+    /* Pairs with the barriers of ABTI_rcu_report() and ABTI_rcu_online() */
+    ABTD_atomic_mem_barrier();
+    ABTI_spinlock_acquire(&gp_ABTI_global->rcu_lock);
+    for (p_xstream = gp_ABTI_global->p_rcu_xstreams; p_xstream != NULL;
+         p_xstream = p_xstream->p_rcu_next) {
+        uint64_t epoch = *(volatile uint64_t *)&p_xstream->rcu_epoch;
+        if (epoch != 0 && epoch < done) done = epoch;
+    }
+    ABTI_spinlock_release(&gp_ABTI_global->rcu_lock);
+    return done;
+}
+
+static void ABTI_rcu_add_cb(ABTI_xstream *p_xstream, ABTI_rcu_cb *p_cb)
+{
+    p_cb->p_next = NULL;
+    if (p_xstream->p_rcu_tail != NULL) {
+        p_xstream->p_rcu_tail->p_next = p_cb;
+    } else {
+        p_xstream->p_rcu_head = p_cb;
+    }
+    p_xstream->p_rcu_tail = p_cb;
+}
+
+/* Call the callbacks of p_xstream whose grace periods have ended.  The
+ * callbacks of stopped or parked ESs are taken over first. */
+void ABTI_rcu_process(ABTI_xstream *p_xstream)
+{
+    ABTI_rcu_cb *p_cb, *p_ready = NULL, **pp_ready = &p_ready;
+    ABTI_rcu_cb *p_list;
+    uint64_t done;
+
+    if (*(ABTI_rcu_cb * volatile *)&gp_ABTI_global->p_rcu_orphans != NULL) {
+        ABTI_spinlock_acquire(&gp_ABTI_global->rcu_lock);
+        p_list = gp_ABTI_global->p_rcu_orphans;
+        gp_ABTI_global->p_rcu_orphans = NULL;
+        ABTI_spinlock_release(&gp_ABTI_global->rcu_lock);
+        while (p_list != NULL) {
+            p_cb = p_list;
+            p_list = p_cb->p_next;
+            ABTI_rcu_add_cb(p_xstream, p_cb);
+        }
+    }
+
+    if (p_xstream->p_rcu_head == NULL) return;
+    done = ABTI_rcu_get_done();
+
+    /* Detach the ready callbacks before calling them, since they may add
+     * new ones. */
+    p_list = p_xstream->p_rcu_head;
+    p_xstream->p_rcu_head = NULL;
+    p_xstream->p_rcu_tail = NULL;
+    while (p_list != NULL) {
+        p_cb = p_list;
+        p_list = p_cb->p_next;
+        if (p_cb->epoch <= done) {
+            p_cb->p_next = NULL;
+            *pp_ready = p_cb;
+            pp_ready = &p_cb->p_next;
+        } else {
+            ABTI_rcu_add_cb(p_xstream, p_cb);
+        }
+    }
+    ABTI_rcu_run_cbs(p_ready);
+}
+
+/**
+ * @ingroup RCU
+ * @brief   Enter a read-side critical section.
+ *
+ * \c ABT_rcu_read_lock() marks the beginning of a read-side critical section
+ * of the calling work unit.  The data read in the section are not reclaimed
+ * until \c ABT_rcu_read_unlock() is called.  Sections can be nested.  The
+ * caller must not yield, block, or migrate until it leaves the section.
+ *
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_RCU called by an external thread
+ */
+int ABT_rcu_read_lock(void)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_CHECK_INITIALIZED();
+    ABTI_CHECK_TRUE(lp_ABTI_local != NULL, ABT_ERR_RCU);
+    ABTI_local_get_xstream()->rcu_nesting++;
+    /* The reads of the section must not be moved before this. */
+    ABTD_compiler_barrier();
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup RCU
+ * @brief   Leave a read-side critical section.
+ *
+ * \c ABT_rcu_read_unlock() marks the end of the read-side critical section
+ * entered by the last \c ABT_rcu_read_lock() of the calling work unit.
+ *
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_RCU called by an external thread or not in a section
+ */
+int ABT_rcu_read_unlock(void)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream;
+
+    ABTI_CHECK_INITIALIZED();
+    ABTI_CHECK_TRUE(lp_ABTI_local != NULL, ABT_ERR_RCU);
+    p_xstream = ABTI_local_get_xstream();
+    ABTI_CHECK_TRUE(p_xstream->rcu_nesting > 0, ABT_ERR_RCU);
+    ABTD_compiler_barrier();
+    p_xstream->rcu_nesting--;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup RCU
+ * @brief   Wait for a grace period.
+ *
+ * \c ABT_rcu_synchronize() returns after every read-side critical section
+ * that was running when it was called has ended, so data that were made
+ * unreachable before the call can be freed afterwards.  A ULT yields while it
+ * waits, and a tasklet or an external thread spins.  The caller must not be
+ * in a read-side critical section.
+ *
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_RCU called in a read-side critical section
+ */
+int ABT_rcu_synchronize(void)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = NULL;
+    uint64_t epoch;
+
+    ABTI_CHECK_INITIALIZED();
+    if (lp_ABTI_local != NULL) {
+        p_xstream = ABTI_local_get_xstream();
+        ABTI_CHECK_TRUE(p_xstream->rcu_nesting == 0, ABT_ERR_RCU);
+    }
+
+    epoch = ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->rcu_epoch, 1) + 1;
+    while (1) {
+        /* The caller is not reading, and neither is any other work unit of
+         * its ES, which the caller is running. */
+        if (p_xstream != NULL) ABTI_rcu_report(p_xstream);
+        if (ABTI_rcu_get_done() >= epoch) break;
+
+        if (p_xstream == NULL) {
+            ABTD_xstream_context_yield();
+        } else if (ABTI_local_get_task() == NULL) {
+            ABTI_thread_yield(ABTI_local_get_thread());
+            p_xstream = ABTI_local_get_xstream();
+        } else {
+            ABTD_atomic_pause();
+        }
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup RCU
+ * @brief   Call a function after a grace period.
+ *
+ * \c ABT_rcu_call() makes the ES of the caller call \c func with \c arg after
+ * every read-side critical section that is running now has ended, without
+ * waiting for it.  It is typically used to free data that have just been made
+ * unreachable.  \c func is called by the scheduler while it checks events, or
+ * by another ES if this ES terminates first, or by \c ABT_finalize().  An
+ * external thread waits for the grace period as \c ABT_rcu_synchronize() does
+ * and calls \c func itself.
+ *
+ * @param[in] func  function to call
+ * @param[in] arg   argument for \c func
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_rcu_call(void (*func)(void *), void *arg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_rcu_cb *p_cb;
+
+    ABTI_CHECK_INITIALIZED();
+    if (lp_ABTI_local == NULL) {
+        abt_errno = ABT_rcu_synchronize();
+        ABTI_CHECK_ERROR(abt_errno);
+        func(arg);
+        goto fn_exit;
+    }
+
+    p_cb = (ABTI_rcu_cb *)ABTU_malloc(sizeof(ABTI_rcu_cb));
+    p_cb->func = func;
+    p_cb->arg = arg;
+    p_cb->epoch = ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->rcu_epoch, 1)
+                + 1;
+    ABTI_rcu_add_cb(ABTI_local_get_xstream(), p_cb);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
@@ -0,0 +1,387 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+#include <unistd.h>
+
+/* Record and replay of schedules.  With ABT_SCHED_RECORD, each ES records
+ * the units it runs and the pools it pops them from, and the pops of all ESs
+ * are numbered in one order.  The records outlive their ESs and are written
+ * on ABT_finalize().  With ABT_SCHED_REPLAY, the predefined schedulers pop
+ * from the recorded pools in the recorded order instead of following their
+ * policies, so that two builds can be compared on the same schedule.
+ *
+ * Units get IDs from a range of the rank of the ES that creates them, so the
+ * same units have the same IDs in both runs.  A decision is not followed if
+ * its pool stays empty for ABTI_RECORD_REPLAY_WAIT seconds or the unit
+ * popped has another ID; such decisions are counted and reported on
+ * ABT_finalize().  Once all the decisions have been followed, the schedulers
+ * follow their own policies. */
+
+/* Bits of the IDs of each ES */
+#define ABTI_RECORD_ID_SHIFT    40
+
+/* # of entries allocated first for each ES */
+#define ABTI_RECORD_INIT_SIZE   1024
+
+/* Seconds a decision waits for its turn or its unit */
+#define ABTI_RECORD_REPLAY_WAIT 0.1
+
+static int ABTI_record_load(const char *filename);
+static void ABTI_record_write(FILE *p_os);
+static ABTI_pool *ABTI_record_find_pool(ABTI_sched *p_sched, uint32_t id);
+
+void ABTI_record_init(void)
+{
+    gp_ABTI_global->p_records = NULL;
+    ABTI_spinlock_create(&gp_ABTI_global->record_lock);
+    gp_ABTI_global->record_seq = 0;
+    gp_ABTI_global->replay_total = 0;
+    gp_ABTI_global->replay_num = 0;
+    gp_ABTI_global->replay_diverged = 0;
+
+    if (gp_ABTI_global->sched_record == ABTI_RECORD_REPLAY &&
+        ABTI_record_load(gp_ABTI_global->replay_filename) != ABT_SUCCESS) {
+        fprintf(stderr, "ABT_SCHED_REPLAY: %s cannot be read\n",
+                gp_ABTI_global->replay_filename);
+        gp_ABTI_global->sched_record = ABTI_RECORD_OFF;
+    }
+}
+
+void ABTI_record_xstream_init(ABTI_xstream *p_xstream)
+{
+    ABTI_record *p_rec = NULL;
+    uint64_t base;
+
+    p_xstream->p_record = NULL;
+    p_xstream->record_seq = UINT64_MAX;
+    p_xstream->record_nesting = 0;
+    if (gp_ABTI_global->sched_record == ABTI_RECORD_OFF) return;
+
+    base = (p_xstream->rank + 1) << ABTI_RECORD_ID_SHIFT;
+    p_xstream->thread_id_next = base;
+    p_xstream->thread_id_end = base + (1ULL << ABTI_RECORD_ID_SHIFT);
+    p_xstream->task_id_next = base;
+    p_xstream->task_id_end = base + (1ULL << ABTI_RECORD_ID_SHIFT);
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    if (gp_ABTI_global->sched_record == ABTI_RECORD_ON) {
+        p_rec = (ABTI_record *)ABTU_malloc(sizeof(ABTI_record));
+        p_rec->rank = p_xstream->rank;
+        p_rec->num = 0;
+        p_rec->size = ABTI_RECORD_INIT_SIZE;
+        p_rec->pos = 0;
+        p_rec->used = ABT_TRUE;
+        p_rec->wait_seq = 0;
+        p_rec->wait_start = 0.0;
+        p_rec->p_entries = (ABTI_record_entry *)ABTU_malloc(
+                ABTI_RECORD_INIT_SIZE * sizeof(ABTI_record_entry));
+        p_rec->p_next = gp_ABTI_global->p_records;
+        gp_ABTI_global->p_records = p_rec;
+    } else {
+        /* A rank that is reused replays the records of that rank in the
+         * order the ESs were created. */
+        for (p_rec = gp_ABTI_global->p_records; p_rec; p_rec = p_rec->p_next) {
+            if (p_rec->rank == p_xstream->rank && p_rec->used == ABT_FALSE) {
+                p_rec->used = ABT_TRUE;
+                break;
+            }
+        }
+    }
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+
+    p_xstream->p_record = p_rec;
+}
+
+void ABTI_record_finalize(void)
+{
+    ABTI_record *p_rec = gp_ABTI_global->p_records;
+    char *filename = gp_ABTI_global->record_filename;
+    char default_name[64];
+    FILE *fp;
+
+    if (gp_ABTI_global->sched_record == ABTI_RECORD_ON) {
+        if (filename == NULL || filename[0] == '\0') {
+            sprintf(default_name, "abt_sched.%d.rec", (int)getpid());
+            filename = default_name;
+        }
+        fp = fopen(filename, "wb");
+        if (fp != NULL) {
+            ABTI_record_write(fp);
+            fclose(fp);
+        }
+    } else if (gp_ABTI_global->sched_record == ABTI_RECORD_REPLAY &&
+               gp_ABTI_global->replay_diverged > 0) {
+        fprintf(stderr, "ABT_SCHED_REPLAY: %" PRIu64 " of %" PRIu64
+                " decisions were not followed\n",
+                gp_ABTI_global->replay_diverged, gp_ABTI_global->replay_num);
+    }
+
+    while (p_rec) {
+        ABTI_record *p_next = p_rec->p_next;
+        ABTU_free(p_rec->p_entries);
+        ABTU_free(p_rec);
+        p_rec = p_next;
+    }
+    gp_ABTI_global->p_records = NULL;
+}
+
+/* Append a decision of p_xstream, which only this ES does. */
+void ABTI_record_add(ABTI_xstream *p_xstream, ABTI_pool *p_pool,
+                     uint64_t unit, ABTI_pool *p_home)
+{
+    ABTI_record *p_rec = p_xstream->p_record;
+    ABTI_record_entry *p_entry;
+    uint64_t seq = p_xstream->record_seq;
+
+    /* A unit that has not been popped by ABTI_pool_call_pop(), e.g., stolen
+     * from a deque, is ordered when it runs. */
+    if (seq == UINT64_MAX) {
+        ABTI_spinlock_acquire(&gp_ABTI_global->record_lock);
+        seq = gp_ABTI_global->record_seq++;
+        ABTI_spinlock_release(&gp_ABTI_global->record_lock);
+    }
+    p_xstream->record_seq = UINT64_MAX;
+
+    if (p_rec->num == p_rec->size) {
+        p_rec->size *= 2;
+        p_rec->p_entries = (ABTI_record_entry *)ABTU_realloc(
+                p_rec->p_entries, p_rec->size * sizeof(ABTI_record_entry));
+    }
+    p_entry = &p_rec->p_entries[p_rec->num++];
+    p_entry->seq = seq;
+    p_entry->unit = unit;
+    p_entry->pool = (uint32_t)p_pool->id;
+    p_entry->home = p_home ? (uint32_t)p_home->id : p_entry->pool;
+}
+
+/* Follow the next decision of p_xstream (see ABTI_record_replay_run()). */
+ABT_bool ABTI_record_replay(ABTI_xstream *p_xstream, ABTI_sched *p_sched,
+                            int *p_run_cnt)
+{
+    ABTI_record *p_rec = p_xstream->p_record;
+    uint64_t *p_seq = &gp_ABTI_global->record_seq;
+    ABTI_record_entry *p_entry;
+    ABTI_pool *p_pool, *p_home;
+    ABT_unit unit = ABT_UNIT_NULL;
+    uint64_t seq, last_seq, id;
+    double start, now;
+
+    *p_run_cnt = 0;
+    if (p_rec->pos == p_rec->num) {
+        /* The ES does not take the units of the other ESs until they have
+         * followed their decisions or stopped making progress.  Then, the
+         * scheduler follows its own policy. */
+        seq = *(volatile uint64_t *)p_seq;
+        now = ABT_get_wtime();
+        if (seq < gp_ABTI_global->replay_total) {
+            if (p_rec->wait_start == 0.0 || seq != p_rec->wait_seq) {
+                p_rec->wait_seq = seq;
+                p_rec->wait_start = now;
+            }
+            if (now - p_rec->wait_start <= ABTI_RECORD_REPLAY_WAIT) {
+                ABTD_xstream_context_yield();
+                return ABT_TRUE;
+            }
+        }
+        p_xstream->p_record = NULL;
+        return ABT_FALSE;
+    }
+    p_entry = &p_rec->p_entries[p_rec->pos++];
+    p_pool = ABTI_record_find_pool(p_sched, p_entry->pool);
+
+    /* Wait for the turn of the decision and then for a unit in its pool.  If
+     * the other ESs make no progress, e.g., because their ESs have been
+     * freed, the decision does not wait for its turn anymore. */
+    start = ABT_get_wtime();
+    last_seq = *(volatile uint64_t *)p_seq;
+    while (1) {
+        seq = *(volatile uint64_t *)p_seq;
+        if (seq >= p_entry->seq && p_pool != NULL) {
+            unit = ABTI_pool_call_pop(p_pool);
+            if (unit != ABT_UNIT_NULL) break;
+        }
+        now = ABT_get_wtime();
+        if (seq != last_seq) {
+            last_seq = seq;
+            start = now;
+        } else if (now - start > ABTI_RECORD_REPLAY_WAIT) {
+            break;
+        }
+        ABTD_xstream_context_yield();
+    }
+
+    /* The next decision can be made. */
+    seq = *(volatile uint64_t *)p_seq;
+    while (seq <= p_entry->seq) {
+        uint64_t old = ABTD_atomic_cas_uint64(p_seq, seq, p_entry->seq + 1);
+        if (old == seq) break;
+        seq = old;
+    }
+    ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->replay_num, 1);
+    if (unit == ABT_UNIT_NULL) {
+        ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->replay_diverged, 1);
+        return ABT_TRUE;
+    }
+
+    if (ABTI_pool_unit_get_type(p_pool, unit) == ABT_UNIT_TYPE_THREAD) {
+        id = ABTI_thread_get_id(ABTI_pool_unit_get_thread(p_pool, unit));
+    } else {
+        id = ABTI_task_get_id(ABTI_pool_unit_get_task(p_pool, unit))
+           | ABTI_RECORD_TASK;
+    }
+    if (id != p_entry->unit) {
+        ABTD_atomic_fetch_add_uint64(&gp_ABTI_global->replay_diverged, 1);
+    }
+
+    LOG_EVENT_POOL_POP(p_pool, unit);
+    if (p_entry->home != p_entry->pool) {
+        ABTI_trace_unit(ABTI_TRACE_STEAL, p_pool, unit);
+        p_home = ABTI_record_find_pool(p_sched, p_entry->home);
+        if (p_home != NULL) {
+            ABT_unit_set_associated_pool(unit, ABTI_pool_get_handle(p_home));
+        }
+        p_xstream->stats.num_steals++;
+    } else {
+        ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+        p_xstream->stats.num_pops++;
+    }
+    ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+    *p_run_cnt = 1;
+    return ABT_TRUE;
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+/* The pools of p_sched, or those of the main schedulers of the other ESs,
+ * which the priority scheduler steals from */
+static ABTI_pool *ABTI_record_find_pool(ABTI_sched *p_sched, uint32_t id)
+{
+    ABTI_xstream **p_xstreams;
+    ABTI_pool *p_pool;
+    int i, k, max_xstreams;
+
+    for (i = 0; i < p_sched->num_pools; i++) {
+        p_pool = ABTI_pool_get_ptr(p_sched->pools[i]);
+        if ((uint32_t)p_pool->id == id) return p_pool;
+    }
+
+    p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+    for (k = 0; k < max_xstreams; k++) {
+        ABTI_xstream *p_target = p_xstreams[k];
+        ABTI_sched *p_main;
+        if (p_target == NULL) continue;
+        p_main = p_target->p_main_sched;
+        if (p_main == NULL || p_main == p_sched) continue;
+        for (i = 0; i < p_main->num_pools; i++) {
+            p_pool = ABTI_pool_get_ptr(p_main->pools[i]);
+            if ((uint32_t)p_pool->id == id) return p_pool;
+        }
+    }
+    return NULL;
+}
+
+static int ABTI_record_cmp_seq(const void *p1, const void *p2)
+{
+    uint64_t seq1 = (*(ABTI_record_entry **)p1)->seq;
+    uint64_t seq2 = (*(ABTI_record_entry **)p2)->seq;
+    return (seq1 > seq2) - (seq1 < seq2);
+}
+
+/* Read the records written by ABTI_record_write().  The decisions are
+ * renumbered from 0 without gaps, since a pop whose unit was not run by the
+ * ES still took a number. */
+static int ABTI_record_load(const char *filename)
+{
+    ABTI_record *p_rec;
+    ABTI_record_entry **pp_entries;
+    char magic[8];
+    uint32_t num_recs, reserved, i;
+    uint64_t total = 0, k, n;
+    FILE *fp;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) return ABT_ERR_OTHER;
+    if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, "ABTREC01", 8) != 0 ||
+        fread(&num_recs, sizeof(uint32_t), 1, fp) != 1 ||
+        fread(&reserved, sizeof(uint32_t), 1, fp) != 1) {
+        fclose(fp);
+        return ABT_ERR_OTHER;
+    }
+
+    /* Records are written from the last ES created, so prepending them puts
+     * the list back in the order of creation. */
+    for (i = 0; i < num_recs; i++) {
+        p_rec = (ABTI_record *)ABTU_malloc(sizeof(ABTI_record));
+        p_rec->num = 0;
+        p_rec->p_entries = NULL;
+        if (fread(&p_rec->rank, sizeof(uint64_t), 1, fp) != 1 ||
+            fread(&p_rec->num, sizeof(uint64_t), 1, fp) != 1) {
+            p_rec->num = 0;
+        }
+        p_rec->size = p_rec->num;
+        p_rec->pos = 0;
+        p_rec->used = ABT_FALSE;
+        p_rec->wait_seq = 0;
+        p_rec->wait_start = 0.0;
+        if (p_rec->num > 0) {
+            p_rec->p_entries = (ABTI_record_entry *)ABTU_malloc(
+                    p_rec->num * sizeof(ABTI_record_entry));
+            p_rec->num = fread(p_rec->p_entries, sizeof(ABTI_record_entry),
+                               p_rec->num, fp);
+        }
+        p_rec->p_next = gp_ABTI_global->p_records;
+        gp_ABTI_global->p_records = p_rec;
+        total += p_rec->num;
+    }
+    fclose(fp);
+
+    pp_entries = (ABTI_record_entry **)ABTU_malloc(
+            (total + 1) * sizeof(ABTI_record_entry *));
+    n = 0;
+    for (p_rec = gp_ABTI_global->p_records; p_rec; p_rec = p_rec->p_next) {
+        for (k = 0; k < p_rec->num; k++) {
+            pp_entries[n++] = &p_rec->p_entries[k];
+        }
+    }
+    qsort(pp_entries, n, sizeof(ABTI_record_entry *), ABTI_record_cmp_seq);
+    for (k = 0; k < n; k++) {
+        pp_entries[k]->seq = k;
+    }
+    ABTU_free(pp_entries);
+    gp_ABTI_global->replay_total = n;
+
+    return ABT_SUCCESS;
+}
+
+/* Write the records.  The format, in the native byte order, is
+ *   header:  char magic[8] = "ABTREC01", uint32_t num_xstreams,
+ *            uint32_t reserved
+ *   then for each ES:
+ *            uint64_t rank, uint64_t num_entries,
+ *            ABTI_record_entry entries[num_entries] in the order of the ES */
+static void ABTI_record_write(FILE *p_os)
+{
+    ABTI_record *p_rec;
+    uint32_t num_recs = 0, reserved = 0;
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    for (p_rec = gp_ABTI_global->p_records; p_rec; p_rec = p_rec->p_next) {
+        num_recs++;
+    }
+    fwrite("ABTREC01", 1, 8, p_os);
+    fwrite(&num_recs, sizeof(uint32_t), 1, p_os);
+    fwrite(&reserved, sizeof(uint32_t), 1, p_os);
+    for (p_rec = gp_ABTI_global->p_records; p_rec; p_rec = p_rec->p_next) {
+        fwrite(&p_rec->rank, sizeof(uint64_t), 1, p_os);
+        fwrite(&p_rec->num, sizeof(uint64_t), 1, p_os);
+        fwrite(p_rec->p_entries, sizeof(ABTI_record_entry), p_rec->num, p_os);
+    }
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+    fflush(p_os);
+}
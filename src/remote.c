@@ -0,0 +1,504 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Remote tasklets.  A tasklet is described by ABT_remote_desc, i.e., the ID
+ * of a registered function and a copy of its arguments, so that it can be
+ * moved to another process, where a tasklet is created from the descriptor.
+ * Function pointers differ between processes, but IDs do not as long as all
+ * the processes register the same functions in the same order.
+ *
+ * A remote pool is an adapter that exposes the tasklets of other processes to
+ * the schedulers as if they were in a local pool.  Its pop takes a descriptor
+ * with the user's steal function and returns a tasklet created from it, so it
+ * can be a victim of the randws scheduler.  The transport, e.g., MPI RMA (see
+ * abt_mpi.h) or RDMA, is up to the steal function.
+ *
+ * A remote ring is the other direction: other processes push descriptors
+ * into a ring in memory of this process, e.g., by RDMA, and the pool created
+ * on the ring pops them.  Writers claim a slot by a compare-and-swap on tail
+ * and publish it by its sequence number, so the ring needs neither a lock
+ * nor a message to the process that owns it.  Consumers take the head by a
+ * compare-and-swap after copying the descriptor out of the slot, and a
+ * writer reuses the slot only after head has passed it. */
+
+#define ABTI_REMOTE_MAX_FUNCS   256
+
+static void (*g_remote_funcs[ABTI_REMOTE_MAX_FUNCS])(void *);
+static uint32_t g_num_remote_funcs = 0;
+
+typedef struct {
+    ABT_pool local;             /* Pool of the tasklets taken from others */
+    ABT_remote_steal_fn steal_fn;
+    void *steal_arg;
+} ABTI_pool_remote_data;
+
+static void ABTI_remote_task_func(void *arg);
+static int      pool_init(ABT_pool pool, ABT_pool_config config);
+static int      pool_free(ABT_pool pool);
+static size_t   pool_get_size(ABT_pool pool);
+static void     pool_push(ABT_pool pool, ABT_unit unit);
+static ABT_unit pool_pop(ABT_pool pool);
+static int      pool_remove(ABT_pool pool, ABT_unit unit);
+
+
+/** @defgroup REMOTE Remote tasklet
+ * Tasklets that can be moved between processes.  See also \c ABT_mpi_steal in
+ * \c abt_mpi.h for the work stealing across processes over MPI.
+ */
+
+/**
+ * @ingroup REMOTE
+ * @brief   Register a function of remote tasklets.
+ *
+ * \c ABT_remote_func_register() gives \c func the next ID, starting from 0,
+ * and returns it through \c func_id.  A descriptor (\c ABT_remote_desc) names
+ * the function of its tasklet by the ID, so every process must register the
+ * same functions in the same order before it exchanges descriptors.  This
+ * routine can be called before \c ABT_init().
+ *
+ * @param[in]  func     function of tasklets
+ * @param[out] func_id  ID of \c func
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_OTHER too many functions are registered
+ */
+int ABT_remote_func_register(void (*func)(void *), int *func_id)
+{
+    int abt_errno = ABT_SUCCESS;
+    uint32_t id;
+
+    ABTI_CHECK_TRUE(func != NULL, ABT_ERR_INV_REMOTE_DESC);
+    id = ABTD_atomic_fetch_add_uint32(&g_num_remote_funcs, 1);
+    if (id >= ABTI_REMOTE_MAX_FUNCS) {
+        ABTD_atomic_fetch_sub_uint32(&g_num_remote_funcs, 1);
+        abt_errno = ABT_ERR_OTHER;
+        goto fn_fail;
+    }
+    g_remote_funcs[id] = func;
+    *func_id = (int)id;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup REMOTE
+ * @brief   Set up a descriptor of a remote tasklet.
+ *
+ * \c ABT_remote_desc_set() sets \c desc to describe a tasklet that calls the
+ * function of \c func_id with a copy of the \c size bytes at \c args.  The
+ * arguments must not contain pointers unless they are valid in every process.
+ *
+ * @param[out] desc     descriptor
+ * @param[in]  func_id  ID given by \c ABT_remote_func_register()
+ * @param[in]  args     arguments, or \c NULL if \c size is 0
+ * @param[in]  size     size of the arguments in bytes
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_REMOTE_DESC \c func_id is not registered, or \c size is
+ *                                 larger than \c ABT_REMOTE_ARGS_SIZE
+ */
+int ABT_remote_desc_set(ABT_remote_desc *desc, int func_id, const void *args,
+                        size_t size)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_CHECK_TRUE(func_id >= 0 &&
+                    (uint32_t)func_id < g_num_remote_funcs &&
+                    (uint32_t)func_id < ABTI_REMOTE_MAX_FUNCS,
+                    ABT_ERR_INV_REMOTE_DESC);
+    ABTI_CHECK_TRUE(size <= ABT_REMOTE_ARGS_SIZE, ABT_ERR_INV_REMOTE_DESC);
+
+    desc->func_id = (uint32_t)func_id;
+    desc->size = (uint32_t)size;
+    if (size > 0) memcpy(desc->args, args, size);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup REMOTE
+ * @brief   Create a tasklet from a descriptor.
+ *
+ * \c ABT_task_create_from_desc() creates a tasklet in \c pool as
+ * \c ABT_task_create() does.  The tasklet calls the function of
+ * \c desc->func_id with a pointer to its own copy of the arguments of
+ * \c desc, which is freed when the function returns.
+ *
+ * @param[in]  pool     handle to the associated pool
+ * @param[in]  desc     descriptor, e.g., received from another process
+ * @param[out] newtask  handle to a new tasklet, or \c NULL
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_REMOTE_DESC \c desc is invalid in this process
+ */
+int ABT_task_create_from_desc(ABT_pool pool, const ABT_remote_desc *desc,
+                              ABT_task *newtask)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_remote_desc *p_copy;
+
+    ABTI_CHECK_TRUE(desc != NULL &&
+                    desc->func_id < g_num_remote_funcs &&
+                    desc->func_id < ABTI_REMOTE_MAX_FUNCS &&
+                    g_remote_funcs[desc->func_id] != NULL &&
+                    desc->size <= ABT_REMOTE_ARGS_SIZE,
+                    ABT_ERR_INV_REMOTE_DESC);
+
+    p_copy = (ABT_remote_desc *)ABTU_malloc(sizeof(ABT_remote_desc));
+    memcpy(p_copy, desc, offsetof(ABT_remote_desc, args) + desc->size);
+    abt_errno = ABT_task_create(pool, ABTI_remote_task_func, p_copy, newtask);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_copy);
+        goto fn_fail;
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup REMOTE
+ * @brief   Create a pool of the tasklets of other processes.
+ *
+ * \c ABT_pool_create_remote() creates a pool of the \c ABT_POOL_ACCESS_MPMC
+ * access type whose pop takes a descriptor with \c steal_fn when the pool has
+ * no unit, and returns a tasklet created from it.  Units pushed into the pool
+ * are kept in it as in an \c ABT_POOL_FIFO pool.
+ *
+ * The pool is meant to be a victim of work-stealing schedulers such as
+ * \c ABT_SCHED_RANDWS, which steal from it only when their own pools are
+ * empty, so that idle ESs take work from other processes.  Its size is the
+ * number of local units, and the work of the other processes is not counted.
+ * \c steal_fn may be called by any ES at the same time.
+ *
+ * @param[in]  steal_fn   function to take a descriptor from other processes
+ * @param[in]  arg        argument of \c steal_fn
+ * @param[in]  automatic  ABT_TRUE if the pool should be automatically freed
+ * @param[out] newpool    handle to a new pool
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_pool_create_remote(ABT_remote_steal_fn steal_fn, void *arg,
+                           ABT_bool automatic, ABT_pool *newpool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_pool_def def;
+    ABTI_pool *p_pool;
+    ABTI_pool_remote_data *p_data;
+
+    abt_errno = ABTI_pool_get_fifo_def(ABT_POOL_ACCESS_MPMC, &def);
+    ABTI_CHECK_ERROR(abt_errno);
+    def.p_init     = pool_init;
+    def.p_free     = pool_free;
+    def.p_get_size = pool_get_size;
+    def.p_push     = pool_push;
+    def.p_pop      = pool_pop;
+    def.p_remove   = pool_remove;
+
+    abt_errno = ABT_pool_create(&def, ABT_POOL_CONFIG_NULL, newpool);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_pool = ABTI_pool_get_ptr(*newpool);
+    p_pool->automatic = automatic;
+    p_data = (ABTI_pool_remote_data *)p_pool->data;
+    p_data->steal_fn = steal_fn;
+    p_data->steal_arg = arg;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    *newpool = ABT_POOL_NULL;
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup REMOTE
+ * @brief   Get the size of a remote ring.
+ *
+ * \c ABT_remote_ring_get_size() returns through \c size the number of bytes
+ * of a remote ring that has \c capacity slots, i.e., a header
+ * (\c ABT_remote_ring_header) followed by the slots
+ * (\c ABT_remote_ring_slot).
+ *
+ * @param[in]  capacity  number of slots
+ * @param[out] size      size of the ring in bytes
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_POOL \c capacity is not positive
+ */
+int ABT_remote_ring_get_size(int capacity, size_t *size)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_TRUE(capacity > 0, ABT_ERR_INV_POOL);
+
+    *size = sizeof(ABT_remote_ring_header) +
+            (size_t)capacity * sizeof(ABT_remote_ring_slot);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup REMOTE
+ * @brief   Initialize a remote ring.
+ *
+ * \c ABT_remote_ring_init() initializes the memory at \c ring, whose size is
+ * given by \c ABT_remote_ring_get_size(), as an empty ring of \c capacity
+ * slots.  The memory is provided by the user so that it can be registered
+ * with a NIC or exposed in an MPI window, through which other processes push
+ * descriptors as described at \c ABT_remote_ring_header.  It should be
+ * aligned to 64 bytes for the compare-and-swap of the NIC.
+ *
+ * @param[in] ring      memory of the ring
+ * @param[in] capacity  number of slots
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_POOL \c capacity is not positive
+ */
+int ABT_remote_ring_init(void *ring, int capacity)
+{
+    int abt_errno = ABT_SUCCESS;
+    size_t size;
+
+    abt_errno = ABT_remote_ring_get_size(capacity, &size);
+    ABTI_CHECK_ERROR(abt_errno);
+    memset(ring, 0, size);
+    ((ABT_remote_ring_header *)ring)->capacity = (uint64_t)capacity;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup REMOTE
+ * @brief   Push a descriptor into a remote ring in the same address space.
+ *
+ * \c ABT_remote_ring_push() pushes a copy of \c desc into \c ring with the
+ * CPU's atomic operations, following the same protocol as remote writers.
+ * It is for rings in memory shared with the caller, e.g., to ship tasklets
+ * within a node, and for testing.  It can be called by any thread at the
+ * same time as remote writers if the NIC's atomics are coherent with the
+ * CPU's.
+ *
+ * @param[in] ring  memory of the ring
+ * @param[in] desc  descriptor of the tasklet
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_POOL_FULL the ring is full
+ * @retval ABT_ERR_INV_REMOTE_DESC \c desc is invalid
+ */
+int ABT_remote_ring_push(void *ring, const ABT_remote_desc *desc)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_remote_ring_header *p_header = (ABT_remote_ring_header *)ring;
+    ABT_remote_ring_slot *p_slot;
+    uint64_t head, tail, cap;
+
+    ABTI_CHECK_TRUE(desc != NULL && desc->size <= ABT_REMOTE_ARGS_SIZE,
+                    ABT_ERR_INV_REMOTE_DESC);
+
+    cap = p_header->capacity;
+    while (1) {
+        tail = *(volatile uint64_t *)&p_header->tail;
+        head = *(volatile uint64_t *)&p_header->head;
+        /* A full ring is not an error of the library. */
+        if (tail - head >= cap) return ABT_ERR_POOL_FULL;
+        if (ABTD_atomic_cas_uint64(&p_header->tail, tail, tail + 1) == tail) {
+            break;
+        }
+    }
+    p_slot = (ABT_remote_ring_slot *)(p_header + 1) + tail % cap;
+    memcpy(&p_slot->desc, desc, sizeof(ABT_remote_desc));
+    ABTD_atomic_write_barrier();
+    *(volatile uint64_t *)&p_slot->seq = tail + 1;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup REMOTE
+ * @brief   Create a pool of the tasklets pushed into a remote ring.
+ *
+ * \c ABT_pool_create_remote_ring() creates a remote pool (see
+ * \c ABT_pool_create_remote()) whose pop takes the descriptor at the head of
+ * \c ring and returns a tasklet created from it.  Other processes ship
+ * tasklets to this process by writing descriptors into the ring, and the
+ * schedulers pop them like local units without any dispatcher in between.
+ * \c ring must be initialized by \c ABT_remote_ring_init() and stay valid
+ * until the pool is freed.
+ *
+ * @param[in]  ring       memory of the ring
+ * @param[in]  automatic  ABT_TRUE if the pool should be automatically freed
+ * @param[out] newpool    handle to a new pool
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_POOL \c ring is not initialized
+ */
+int ABT_pool_create_remote_ring(void *ring, ABT_bool automatic,
+                                ABT_pool *newpool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_remote_ring_header *p_header = (ABT_remote_ring_header *)ring;
+
+    ABTI_CHECK_TRUE(p_header != NULL && p_header->capacity > 0,
+                    ABT_ERR_INV_POOL);
+    abt_errno = ABT_pool_create_remote(ABTI_remote_ring_pop, ring, automatic,
+                                       newpool);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    *newpool = ABT_POOL_NULL;
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* Take the descriptor at the head of ring.  Any number of threads can call
+ * this at the same time. */
+ABT_bool ABTI_remote_ring_pop(void *ring, ABT_remote_desc *desc)
+{
+    ABT_remote_ring_header *p_header = (ABT_remote_ring_header *)ring;
+    ABT_remote_ring_slot *p_slot;
+    uint64_t head, cap = p_header->capacity;
+
+    while (1) {
+        head = *(volatile uint64_t *)&p_header->head;
+        p_slot = (ABT_remote_ring_slot *)(p_header + 1) + head % cap;
+        if (*(volatile uint64_t *)&p_slot->seq != head + 1) return ABT_FALSE;
+        /* Read the descriptor after its sequence number and before the slot
+         * is given back to writers.  A copy torn by a writer of the next
+         * round is discarded since head has moved then. */
+        ABTD_atomic_mem_barrier();
+        memcpy(desc, (const void *)&p_slot->desc, sizeof(ABT_remote_desc));
+        ABTD_atomic_mem_barrier();
+        if (ABTD_atomic_cas_uint64(&p_header->head, head, head + 1) == head) {
+            return ABT_TRUE;
+        }
+    }
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void ABTI_remote_task_func(void *arg)
+{
+    ABT_remote_desc *p_desc = (ABT_remote_desc *)arg;
+    g_remote_funcs[p_desc->func_id](p_desc->args);
+    ABTU_free(p_desc);
+}
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno;
+    ABTI_pool_remote_data *p_data;
+
+    p_data = (ABTI_pool_remote_data *)
+             ABTU_malloc(sizeof(ABTI_pool_remote_data));
+    p_data->steal_fn = NULL;
+    p_data->steal_arg = NULL;
+    abt_errno = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                      ABT_FALSE, &p_data->local);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_data);
+        return abt_errno;
+    }
+    return ABT_pool_set_data(pool, p_data);
+}
+
+static int pool_free(ABT_pool pool)
+{
+    ABTI_pool_remote_data *p_data;
+    ABT_pool_get_data(pool, (void **)&p_data);
+    ABT_pool_free(&p_data->local);
+    ABTU_free(p_data);
+    return ABT_SUCCESS;
+}
+
+static inline ABTI_pool *pool_get_local(ABT_pool pool)
+{
+    ABTI_pool_remote_data *p_data;
+    p_data = (ABTI_pool_remote_data *)ABTI_pool_get_ptr(pool)->data;
+    return ABTI_pool_get_ptr(p_data->local);
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    return ABTI_pool_call_get_size(pool_get_local(pool));
+}
+
+static void pool_push(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool_call_push(pool_get_local(pool), unit);
+}
+
+static ABT_unit pool_pop(ABT_pool pool)
+{
+    ABTI_pool_remote_data *p_data;
+    ABTI_pool *p_local;
+    ABT_remote_desc desc;
+    ABT_unit unit;
+
+    p_data = (ABTI_pool_remote_data *)ABTI_pool_get_ptr(pool)->data;
+    p_local = ABTI_pool_get_ptr(p_data->local);
+    unit = ABTI_pool_call_pop(p_local);
+    if (unit != ABT_UNIT_NULL) return unit;
+
+    /* Take a tasklet from another process.  It is pushed into this pool and
+     * popped again, so another ES may take it first. */
+    if (p_data->steal_fn(p_data->steal_arg, &desc) == ABT_FALSE) {
+        return ABT_UNIT_NULL;
+    }
+    if (ABT_task_create_from_desc(pool, &desc, NULL) != ABT_SUCCESS) {
+        return ABT_UNIT_NULL;
+    }
+    return ABTI_pool_call_pop(p_local);
+}
+
+static int pool_remove(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_local = pool_get_local(pool);
+    return p_local->p_remove(ABTI_pool_get_handle(p_local), unit);
+}
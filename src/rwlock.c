@@ -42,6 +42,44 @@ int ABT_rwlock_create(ABT_rwlock *newrwlock)
     return abt_errno;
 }
 
+/**
+ * @ingroup RWLOCK
+ * @brief   Create a new reader-biased rwlock
+ *
+ * \c ABT_rwlock_create_reader_biased() creates a new rwlock object optimized
+ * for workloads that rarely acquire it as a writer, and returns its handle
+ * through \c newrwlock.  A reader only updates a counter on a cache line
+ * selected by its work unit, so readers running on different ESs can acquire
+ * the lock concurrently without contending on a shared counter or the
+ * internal mutex.  A writer blocks new readers and waits until all the readers
+ * that hold the lock release it.  The rwlock is used through the same
+ * routines as one created by \c ABT_rwlock_create().
+ *
+ * @param[out] newrwlock  handle to a new rwlock
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_rwlock_create_reader_biased(ABT_rwlock *newrwlock)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_rwlock *p_newrwlock;
+    uint32_t num_slots = 1;
+
+    /* Roughly one slot per ES */
+    while (num_slots < ABTI_RWLOCK_MAX_SLOTS
+           && num_slots < (uint32_t)gp_ABTI_global->max_xstreams) {
+        num_slots <<= 1;
+    }
+
+    p_newrwlock = (ABTI_rwlock *)ABTU_malloc(sizeof(ABTI_rwlock));
+    ABTI_rwlock_init_biased(p_newrwlock, num_slots);
+
+    /* Return value */
+    *newrwlock = ABTI_rwlock_get_handle(p_newrwlock);
+
+    return abt_errno;
+}
+
 /**
  * @ingroup RWLOCK
  * @brief   Free the rwlock object.
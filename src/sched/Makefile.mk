@@ -8,5 +8,9 @@ abt_sources += \
 	sched/config.c \
 	sched/prio.c \
 	sched/sched.c \
-	sched/randws.c
+	sched/randws.c \
+	sched/localws.c \
+	sched/edf.c \
+	sched/hier.c \
+	sched/fair.c
 
@@ -13,6 +13,8 @@ static int  sched_init(ABT_sched sched, ABT_sched_config config);
 static void sched_run(ABT_sched sched);
 static int  sched_free(ABT_sched);
 static void sched_sort_pools(int num_pools, ABT_pool *pools);
+static void sched_run_fifo_priv(ABT_sched sched);
+static void sched_run_fifo_shared(ABT_sched sched);
 
 static ABT_sched_def sched_basic_def = {
     .type = ABT_SCHED_TYPE_TASK,
@@ -26,9 +28,7 @@ typedef struct {
     uint32_t event_freq;
     int num_pools;
     ABT_pool *pools;
-#ifdef ABT_CONFIG_USE_SCHED_SLEEP
-    struct timespec sleep_time;
-#endif
+    ABTI_pool_group *p_group;   /* Bitmap of non-empty pools, or NULL */
 } sched_data;
 
 ABT_sched_config_var ABT_sched_basic_freq = {
@@ -54,10 +54,6 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     /* Default settings */
     sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
     p_data->event_freq = ABTI_global_get_sched_event_freq();
-#ifdef ABT_CONFIG_USE_SCHED_SLEEP
-    p_data->sleep_time.tv_sec = 0;
-    p_data->sleep_time.tv_nsec = ABTI_global_get_sched_sleep_nsec();
-#endif
 
     /* Set the variables from the config */
     ABT_sched_config_read(config, 1, &p_data->event_freq);
@@ -74,8 +70,29 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     if (num_pools > 1) {
         sched_sort_pools(num_pools, p_data->pools);
     }
+    p_data->p_group = ABTI_pool_group_get(num_pools, p_data->pools);
 
     abt_errno = ABT_sched_set_data(sched, (void *)p_data);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* A scheduler with one built-in pool, which is what ABT_SCHED_DEFAULT
+     * creates, runs the loop specialized for that pool unless schedules are
+     * recorded or replayed. */
+    if (num_pools == 1 &&
+        gp_ABTI_global->sched_record == ABTI_RECORD_OFF) {
+        ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_data->pools[0]);
+        switch (p_pool->builtin) {
+            case ABTI_POOL_BUILTIN_FIFO_PRIV:
+                p_sched->run = sched_run_fifo_priv;
+                break;
+            case ABTI_POOL_BUILTIN_FIFO_SHARED:
+                p_sched->run = sched_run_fifo_shared;
+                break;
+            default:
+                break;
+        }
+    }
 
   fn_exit:
     return abt_errno;
@@ -85,6 +102,20 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     goto fn_exit;
 }
 
+/* Pop one work unit from p_pool and run it.  Returns 1 if a unit was run. */
+static inline int sched_pop_run(ABTI_xstream *p_xstream, ABTI_pool *p_pool)
+{
+    ABT_unit unit = ABTI_pool_call_pop(p_pool);
+    LOG_EVENT_POOL_POP(p_pool, unit);
+    ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+    if (unit == ABT_UNIT_NULL) return 0;
+
+    p_xstream->stats.num_pops++;
+    ABTI_pool_prefetch_next(p_pool);
+    ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+    return 1;
+}
+
 static void sched_run(ABT_sched sched)
 {
     uint32_t work_count = 0;
@@ -93,8 +124,10 @@ static void sched_run(ABT_sched sched)
     uint32_t event_freq;
     int num_pools;
     ABT_pool *pools;
+    ABTI_pool_group *p_group;
     int i;
-    CNT_DECL(run_cnt);
+    int run_cnt;
+    ABTI_sched_idle idle;
 
     ABTI_xstream *p_xstream = ABTI_local_get_xstream();
     ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
@@ -104,38 +137,107 @@ static void sched_run(ABT_sched sched)
     event_freq = p_data->event_freq;
     num_pools  = p_data->num_pools;
     pools      = p_data->pools;
+    p_group    = p_data->p_group;
 
+    ABTI_sched_idle_init(&idle);
     while (1) {
-        CNT_INIT(run_cnt, 0);
+        run_cnt = 0;
 
         /* Execute one work unit from the scheduler's pool */
-        for (i = 0; i < num_pools; i++) {
-            ABT_pool pool = pools[i];
-            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-            size_t size = p_pool->p_get_size(pool);
-            if (size > 0) {
-                /* Pop one work unit */
-                ABT_unit unit = p_pool->p_pop(pool);
-                LOG_EVENT_POOL_POP(p_pool, unit);
-                if (unit != ABT_UNIT_NULL) {
-                    ABTI_xstream_run_unit(p_xstream, unit, p_pool);
-                    CNT_INC(run_cnt);
+        if (ABTI_record_replay_run(p_xstream, p_sched, &run_cnt) == ABT_TRUE) {
+            /* The recorded decision has been followed. */
+        } else if (p_group != NULL) {
+            /* The first pool that may have units */
+            i = ABTI_pool_group_find(p_group);
+            if (i >= 0) {
+                run_cnt = sched_pop_run(p_xstream,
+                                        ABTI_pool_get_ptr(pools[i]));
+                if (run_cnt == 0) ABTI_pool_group_clear(p_group, i);
+            }
+        } else {
+            for (i = 0; i < num_pools; i++) {
+                ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[i]);
+                size_t size = ABTI_pool_call_get_size(p_pool);
+                if (size > 0) {
+                    run_cnt = sched_pop_run(p_xstream, p_pool);
+                    break;
                 }
-                break;
             }
         }
 
+        if (run_cnt == 0) p_xstream->stats.num_failed_pops++;
+        if (run_cnt > 0) {
+            ABTI_sched_idle_reset(&idle);
+        } else if (ABTI_sched_idle_wait(p_sched, &idle) == ABT_TRUE) {
+            /* Check events before the ES is parked */
+            work_count = event_freq;
+        }
+
         if (++work_count >= event_freq) {
             ABTI_xstream_check_events(p_xstream, sched);
+            event_freq = ABTI_sched_get_event_freq(p_sched, event_freq);
             ABT_bool stop = ABTI_sched_has_to_stop(p_sched, p_xstream);
             if (stop == ABT_TRUE)
                 break;
             work_count = 0;
-            SCHED_SLEEP(run_cnt, p_data->sleep_time);
         }
     }
 }
 
+/* The scheduling loop for one built-in pool.  The pool operation is fixed in
+ * each instance, so the pop is inlined without the size check and the switch
+ * of ABTI_pool_call_pop().  Otherwise, it behaves like sched_run(). */
+#define SCHED_RUN_ONE_POOL(name, pop)                                       \
+static void name(ABT_sched sched)                                           \
+{                                                                           \
+    uint32_t work_count = 0;                                                \
+    ABTI_sched_idle idle;                                                   \
+    ABTI_xstream *p_xstream = ABTI_local_get_xstream();                     \
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);                        \
+    sched_data *p_data = sched_data_get_ptr(p_sched->data);                 \
+    uint32_t event_freq = p_data->event_freq;                               \
+    ABT_pool pool = p_data->pools[0];                                       \
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);                            \
+    ABTI_pool_fifo_data *p_fifo = (ABTI_pool_fifo_data *)p_pool->data;      \
+                                                                            \
+    ABTI_sched_idle_init(&idle);                                            \
+    while (1) {                                                             \
+        ABT_unit unit = pop(p_fifo, pool, p_xstream);                       \
+        ABTI_pool_stats_pop(p_pool, unit);                                  \
+        if (unit != ABT_UNIT_NULL) {                                        \
+            LOG_EVENT_POOL_POP(p_pool, unit);                               \
+            ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);                  \
+            p_xstream->stats.num_pops++;                                    \
+            ABTI_pool_prefetch_next(p_pool);                                \
+            ABTI_xstream_run_unit(p_xstream, unit, p_pool);                 \
+            ABTI_sched_idle_reset(&idle);                                   \
+        } else {                                                            \
+            p_xstream->stats.num_failed_pops++;                             \
+            if (ABTI_sched_idle_wait(p_sched, &idle) == ABT_TRUE) {         \
+                /* Check events before the ES is parked */                  \
+                work_count = event_freq;                                    \
+            }                                                               \
+        }                                                                   \
+                                                                            \
+        if (++work_count >= event_freq) {                                   \
+            ABTI_xstream_check_events(p_xstream, sched);                    \
+            event_freq = ABTI_sched_get_event_freq(p_sched, event_freq);    \
+            ABT_bool stop = ABTI_sched_has_to_stop(p_sched, p_xstream);     \
+            if (stop == ABT_TRUE)                                           \
+                break;                                                      \
+            work_count = 0;                                                 \
+        }                                                                   \
+    }                                                                       \
+}
+
+#define SCHED_POP_FIFO_PRIV(p_fifo, pool, p_xstream) \
+    ABTI_pool_fifo_pop_priv(p_fifo, p_xstream)
+#define SCHED_POP_FIFO_SHARED(p_fifo, pool, p_xstream) \
+    ABTI_pool_fifo_pop_shared(p_fifo, pool)
+
+SCHED_RUN_ONE_POOL(sched_run_fifo_priv, SCHED_POP_FIFO_PRIV)
+SCHED_RUN_ONE_POOL(sched_run_fifo_shared, SCHED_POP_FIFO_SHARED)
+
 static int sched_free(ABT_sched sched)
 {
     int abt_errno = ABT_SUCCESS;
@@ -144,6 +246,7 @@ static int sched_free(ABT_sched sched)
 
     ABT_sched_get_data(sched, &data);
     sched_data *p_data = sched_data_get_ptr(data);
+    if (p_data->p_group) ABTI_pool_group_release(p_data->p_group);
     ABTU_free(p_data->pools);
     ABTU_free(p_data);
     return abt_errno;
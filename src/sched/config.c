@@ -43,6 +43,27 @@ ABT_sched_config_var ABT_sched_config_access = {
  *     unused (ABT_TRUE by default)
  *   - for the basic scheduler:
  *     - ABT_sched_basic_freq; to set the frequency on checking events
+ *   - for the priority scheduler:
+ *     - ABT_sched_basic_freq; to set the frequency on checking events
+ *     - ABT_sched_prio_steal; to steal units of higher priorities than the
+ *     own ones from the other ESs with priority schedulers (0 by default, 1
+ *     to steal), whose pools need ABT_POOL_ACCESS_SPMC or MPMC
+ *   - for the random work-stealing scheduler:
+ *     - ABT_sched_basic_freq; to set the frequency on checking events
+ *     - ABT_sched_randws_steal; to set the number of units stolen at once
+ *     (1 by default, ABT_SCHED_RANDWS_STEAL_HALF to steal half of the victim)
+ *     - ABT_sched_randws_split; to request a split from the units running on
+ *     a victim that has nothing to steal (0 by default, 1 to request)
+ *   - for the locality-aware work-stealing scheduler:
+ *     - ABT_sched_basic_freq; to set the frequency on checking events
+ *   - for the hierarchical scheduler:
+ *     - ABT_sched_basic_freq; to set the frequency on checking events
+ *     - ABT_sched_hier_spill; to set the length of the own pool above which
+ *     units are moved up to the shared pools (16 by default, 0 not to move)
+ *   - for the weighted fair-share scheduler:
+ *     - ABT_sched_basic_freq; to set the frequency on checking events
+ *     - ABT_sched_fair_weights; to set the weights of the pools by an array
+ *     of int, one per pool (1 for each pool by default)
  *
  * If you want to write your own scheduler and use this function, you can find
  * a good example in the test called \c sched_config.
@@ -0,0 +1,199 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+
+/* Earliest-Deadline-First Scheduler Implementation
+ *
+ * The scheduler runs the unit with the earliest deadline among its pools.
+ * Pools of the kind ABT_POOL_EDF are ordered by deadline, so only their heads
+ * have to be compared.  When no pool has a unit with a deadline, the first
+ * non-empty pool is used as the priority scheduler does.  ULTs that start
+ * after their deadlines are counted in the statistics of the ES.
+ */
+
+static int  sched_init(ABT_sched sched, ABT_sched_config config);
+static void sched_run(ABT_sched sched);
+static int  sched_free(ABT_sched);
+
+static ABT_sched_def sched_edf_def = {
+    .type = ABT_SCHED_TYPE_TASK,
+    .init = sched_init,
+    .run = sched_run,
+    .free = sched_free,
+    .get_migr_pool = NULL
+};
+
+typedef struct {
+    uint32_t event_freq;
+} sched_data;
+
+
+ABT_sched_def *ABTI_sched_get_edf_def(void)
+{
+    return &sched_edf_def;
+}
+
+static inline sched_data *sched_data_get_ptr(void *data)
+{
+    return (sched_data *)data;
+}
+
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    /* Default settings */
+    sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
+    p_data->event_freq = ABTI_global_get_sched_event_freq();
+
+    /* Set the variables from the config */
+    ABT_sched_config_read(config, 1, &p_data->event_freq);
+
+    abt_errno = ABT_sched_set_data(sched, (void *)p_data);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_WITH_CODE("edf: sched_init", abt_errno);
+    goto fn_exit;
+}
+
+/* Return the index of the pool to pop from, or -1 if all are empty */
+static inline int sched_select_pool(ABT_pool *p_pools, ABT_bool *p_is_edf,
+                                    int num_pools)
+{
+    int i, first = -1, best = -1;
+    double best_deadline = 0.0;
+
+    for (i = 0; i < num_pools; i++) {
+        ABT_pool pool = p_pools[i];
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+        if (ABTI_pool_call_get_size(p_pool) == 0) continue;
+        if (first < 0) {
+            first = i;
+            if (num_pools == 1) break;
+        }
+        if (p_is_edf[i] == ABT_TRUE) {
+            double deadline = ABTI_pool_edf_get_deadline(p_pool);
+            if (deadline > 0.0 && (best < 0 || deadline < best_deadline)) {
+                best = i;
+                best_deadline = deadline;
+            }
+        }
+    }
+    return (best >= 0) ? best : first;
+}
+
+/* Count the ULT if it has a deadline and it is about to start after it.
+ * ULTs that resume after yielding or blocking are not counted again. */
+static inline void sched_check_deadline(ABTI_xstream *p_xstream,
+                                        ABTI_pool *p_pool, ABT_unit unit)
+{
+    ABTI_thread *p_thread;
+    double deadline, lateness;
+
+    if (ABTI_pool_unit_get_type(p_pool, unit) != ABT_UNIT_TYPE_THREAD) {
+        return;
+    }
+    p_thread = ABTI_pool_unit_get_thread(p_pool, unit);
+    deadline = p_thread->attr.deadline;
+    if (deadline <= 0.0 || p_thread->p_last_xstream != NULL) return;
+
+    p_xstream->stats.num_deadline_units++;
+    lateness = ABT_get_wtime() - deadline;
+    if (lateness > 0.0) {
+        p_xstream->stats.num_deadline_misses++;
+        if (lateness > p_xstream->stats.max_lateness) {
+            p_xstream->stats.max_lateness = lateness;
+        }
+    }
+}
+
+static void sched_run(ABT_sched sched)
+{
+    uint32_t work_count = 0;
+    void *data;
+    sched_data *p_data;
+    uint32_t event_freq;
+    int num_pools;
+    ABT_pool *p_pools;
+    ABT_bool *p_is_edf;
+    int i;
+    int run_cnt;
+    ABTI_sched_idle idle;
+
+    ABTI_xstream *p_xstream = ABTI_local_get_xstream();
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+
+    ABT_sched_get_data(sched, &data);
+    p_data = sched_data_get_ptr(data);
+    event_freq = p_data->event_freq;
+
+    /* Get the list of pools */
+    ABT_sched_get_num_pools(sched, &num_pools);
+    p_pools = (ABT_pool *)ABTU_malloc(num_pools * sizeof(ABT_pool));
+    p_is_edf = (ABT_bool *)ABTU_malloc(num_pools * sizeof(ABT_bool));
+    ABT_sched_get_pools(sched, num_pools, 0, p_pools);
+    for (i = 0; i < num_pools; i++) {
+        p_is_edf[i] = ABTI_pool_is_edf(ABTI_pool_get_ptr(p_pools[i]));
+    }
+
+    ABTI_sched_idle_init(&idle);
+    while (1) {
+        run_cnt = 0;
+
+        /* Execute the unit with the earliest deadline */
+        i = sched_select_pool(p_pools, p_is_edf, num_pools);
+        if (i >= 0) {
+            ABT_pool pool = p_pools[i];
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+            ABT_unit unit = ABTI_pool_call_pop(p_pool);
+            LOG_EVENT_POOL_POP(p_pool, unit);
+            ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+            if (unit != ABT_UNIT_NULL) {
+                p_xstream->stats.num_pops++;
+                sched_check_deadline(p_xstream, p_pool, unit);
+                ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+                run_cnt++;
+            }
+        }
+
+        if (run_cnt == 0) p_xstream->stats.num_failed_pops++;
+        if (run_cnt > 0) {
+            ABTI_sched_idle_reset(&idle);
+        } else if (ABTI_sched_idle_wait(p_sched, &idle) == ABT_TRUE) {
+            /* Check events before the ES is parked */
+            work_count = event_freq;
+        }
+
+        if (++work_count >= event_freq) {
+            ABT_bool stop = ABTI_sched_has_to_stop(p_sched, p_xstream);
+            if (stop == ABT_TRUE) break;
+            work_count = 0;
+            ABTI_xstream_check_events(p_xstream, sched);
+            event_freq = ABTI_sched_get_event_freq(p_sched, event_freq);
+        }
+    }
+
+    ABTU_free(p_is_edf);
+    ABTU_free(p_pools);
+}
+
+static int sched_free(ABT_sched sched)
+{
+    int abt_errno = ABT_SUCCESS;
+    void *data;
+    sched_data *p_data;
+
+    ABT_sched_get_data(sched, &data);
+    p_data = sched_data_get_ptr(data);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
@@ -0,0 +1,221 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Weighted Fair-share Scheduler Implementation
+ *
+ * Each pool belongs to a tenant with a weight, 1 by default, and the
+ * scheduler shares its ES among the tenants in proportion to the weights by
+ * stride scheduling on the measured run time: each pool has a virtual time
+ * that advances by the run time of its units divided by its weight, and the
+ * non-empty pool with the smallest virtual time runs next.  A pool that was
+ * empty does not keep the credit of its idle time but restarts from the
+ * virtual time of the scheduler.  The fairness is kept per ES; ESs sharing
+ * the pools share them fairly only as a whole. */
+
+static int  sched_init(ABT_sched sched, ABT_sched_config config);
+static void sched_run(ABT_sched sched);
+static int  sched_free(ABT_sched);
+
+static ABT_sched_def sched_fair_def = {
+    .type = ABT_SCHED_TYPE_TASK,
+    .init = sched_init,
+    .run = sched_run,
+    .free = sched_free,
+    .get_migr_pool = NULL,
+};
+
+typedef struct {
+    uint32_t event_freq;
+    int num_pools;
+    ABT_pool *pools;
+    double vtime;               /* Virtual time of the last unit run */
+    double *p_weights;          /* Weight of each pool */
+    double *p_vtimes;           /* Virtual time of each pool */
+    uint64_t *p_ticks;          /* Run time of each pool in ticks */
+} sched_data;
+
+ABT_sched_config_var ABT_sched_fair_weights = {
+    .idx = 1,
+    .type = ABT_SCHED_CONFIG_PTR
+};
+
+ABT_sched_def *ABTI_sched_get_fair_def(void)
+{
+    return &sched_fair_def;
+}
+
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    int abt_errno = ABT_SUCCESS;
+    int i, num_pools;
+    int *weights = NULL;
+
+    abt_errno = ABT_sched_get_num_pools(sched, &num_pools);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* Default settings */
+    sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
+    p_data->event_freq = ABTI_global_get_sched_event_freq();
+    p_data->num_pools = num_pools;
+    p_data->pools = (ABT_pool *)ABTU_malloc(num_pools * sizeof(ABT_pool));
+    p_data->vtime = 0.0;
+    p_data->p_weights = (double *)ABTU_malloc(num_pools * sizeof(double));
+    p_data->p_vtimes = (double *)ABTU_malloc(num_pools * sizeof(double));
+    p_data->p_ticks = (uint64_t *)ABTU_malloc(num_pools * sizeof(uint64_t));
+    abt_errno = ABT_sched_get_pools(sched, num_pools, 0, p_data->pools);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* Set the variables from the config.  The weights are copied. */
+    ABT_sched_config_read(config, 2, &p_data->event_freq, &weights);
+    for (i = 0; i < num_pools; i++) {
+        p_data->p_weights[i] = (weights && weights[i] > 0) ? weights[i] : 1;
+        p_data->p_vtimes[i] = 0.0;
+        p_data->p_ticks[i] = 0;
+    }
+
+    abt_errno = ABT_sched_set_data(sched, (void *)p_data);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_WITH_CODE("fair: sched_init", abt_errno);
+    goto fn_exit;
+}
+
+/* Index of the non-empty pool with the smallest virtual time, or -1 */
+static inline int sched_select(sched_data *p_data)
+{
+    int i, sel = -1;
+    for (i = 0; i < p_data->num_pools; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_data->pools[i]);
+        if (ABTI_pool_call_get_size(p_pool) == 0) {
+            /* No credit for the time it is idle */
+            if (p_data->p_vtimes[i] < p_data->vtime) {
+                p_data->p_vtimes[i] = p_data->vtime;
+            }
+            continue;
+        }
+        if (sel < 0 || p_data->p_vtimes[i] < p_data->p_vtimes[sel]) sel = i;
+    }
+    return sel;
+}
+
+static void sched_run(ABT_sched sched)
+{
+    uint32_t work_count = 0;
+    sched_data *p_data;
+    int run_cnt;
+    ABTI_sched_idle idle;
+
+    ABTI_xstream *p_xstream = ABTI_local_get_xstream();
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+
+    ABTI_sched_idle_init(&idle);
+    while (1) {
+        int sel = sched_select(p_data);
+        run_cnt = 0;
+
+        if (sel >= 0) {
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(p_data->pools[sel]);
+            ABT_unit unit = ABTI_pool_call_pop(p_pool);
+            LOG_EVENT_POOL_POP(p_pool, unit);
+            ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+            if (unit != ABT_UNIT_NULL) {
+                uint64_t start = ABTD_time_get_ticks();
+                uint64_t ticks;
+                p_xstream->stats.num_pops++;
+                ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+                ticks = ABTD_time_get_ticks() - start;
+                p_data->p_ticks[sel] += ticks;
+                p_data->p_vtimes[sel] += ticks / p_data->p_weights[sel];
+                p_data->vtime = p_data->p_vtimes[sel];
+                run_cnt++;
+            }
+        }
+
+        if (run_cnt > 0) {
+            ABTI_sched_idle_reset(&idle);
+        } else {
+            p_xstream->stats.num_failed_pops++;
+            if (ABTI_sched_idle_wait(p_sched, &idle) == ABT_TRUE) {
+                /* Check events before the ES is parked */
+                work_count = p_data->event_freq;
+            }
+        }
+
+        if (++work_count >= p_data->event_freq) {
+            ABTI_xstream_check_events(p_xstream, sched);
+            p_data->event_freq = ABTI_sched_get_event_freq(p_sched,
+                                                           p_data->event_freq);
+            ABT_bool stop = ABTI_sched_has_to_stop(p_sched, p_xstream);
+            if (stop == ABT_TRUE) break;
+            work_count = 0;
+        }
+    }
+}
+
+static int sched_free(ABT_sched sched)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    sched_data *p_data;
+    ABT_sched_get_data(sched, (void **)&p_data);
+    ABTU_free(p_data->pools);
+    ABTU_free(p_data->p_weights);
+    ABTU_free(p_data->p_vtimes);
+    ABTU_free(p_data->p_ticks);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup SCHED
+ * @brief   Get the run time of each pool of a fair-share scheduler.
+ *
+ * \c ABT_sched_get_pool_times returns through \c times the time in seconds
+ * that \c sched has spent running the units of each of its pools, i.e., the
+ * CPU time used by each tenant on the ES of \c sched.  \c times[i] is the time
+ * of the i-th pool.  At most \c max_pools times are returned.  \c sched has to
+ * be created with \c ABT_SCHED_FAIR.
+ *
+ * @param[in]  sched      handle to the target scheduler
+ * @param[in]  max_pools  the number of elements in \c times
+ * @param[out] times      the run time of each pool
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_INV_SCHED invalid scheduler
+ * @retval ABT_ERR_SCHED     \c sched is not a fair-share scheduler
+ */
+int ABT_sched_get_pool_times(ABT_sched sched, int max_pools, double *times)
+{
+    int abt_errno = ABT_SUCCESS;
+    sched_data *p_data;
+    int i;
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+    ABTI_CHECK_TRUE(p_sched->run == sched_run, ABT_ERR_SCHED);
+
+    p_data = (sched_data *)p_sched->data;
+    if (max_pools > p_data->num_pools) max_pools = p_data->num_pools;
+    for (i = 0; i < max_pools; i++) {
+        times[i] = ABTD_time_ticks_to_sec(
+            *(volatile uint64_t *)&p_data->p_ticks[i]);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
@@ -0,0 +1,310 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Hierarchical Scheduler Implementation
+ *
+ * The scheduler pops from a hierarchy of pools from the nearest one: its own
+ * pool, the pool shared by the ESs on the same L3 cache, and the pool shared
+ * by the ESs on the same socket.  If the scheduler is created with one pool,
+ * the shared pools are looked up by the topology of the ES when the scheduler
+ * starts to run, and ESs whose topology is unknown share one pool per level.
+ * If it is created with more pools, they are the levels from the nearest.
+ *
+ * Units created by a ULT go to the pool the ULT pushes to, usually the first
+ * pool of the main scheduler, so spawns stay local.  When the own pool has
+ * more than the spill threshold units, the scheduler moves one unit up to the
+ * next level in each iteration so that its neighbors can run it. */
+
+#define HIER_MAX_LEVELS         3
+#define HIER_DEFAULT_SPILL      16
+
+static int  sched_init(ABT_sched sched, ABT_sched_config config);
+static void sched_run(ABT_sched sched);
+static int  sched_free(ABT_sched);
+
+static ABT_sched_def sched_hier_def = {
+    .type = ABT_SCHED_TYPE_TASK,
+    .init = sched_init,
+    .run = sched_run,
+    .free = sched_free,
+    .get_migr_pool = NULL,
+};
+
+typedef struct {
+    uint32_t event_freq;
+    int spill;                  /* Spill threshold, or 0 not to spill */
+    int num_levels;
+    int num_shared;             /* Levels looked up by topology */
+    ABTI_pool *p_levels[HIER_MAX_LEVELS];
+} sched_data;
+
+ABT_sched_config_var ABT_sched_hier_spill = {
+    .idx = 1,
+    .type = ABT_SCHED_CONFIG_INT
+};
+
+ABT_sched_def *ABTI_sched_get_hier_def(void)
+{
+    return &sched_hier_def;
+}
+
+/* Pools shared by the hierarchical schedulers, one per topology ID of each
+ * level.  A pool is freed when the last scheduler that uses it is freed. */
+typedef struct hier_shared hier_shared;
+struct hier_shared {
+    int level;
+    int id;
+    int refcount;
+    ABTI_pool *p_pool;
+    hier_shared *p_next;
+};
+
+static ABTI_spinlock g_hier_lock;
+static hier_shared *gp_hier_shared = NULL;
+
+static ABTI_pool *hier_shared_get(int level, int id)
+{
+    hier_shared *p_shared;
+    ABT_pool pool;
+
+    ABTI_spinlock_acquire(&g_hier_lock);
+    for (p_shared = gp_hier_shared; p_shared; p_shared = p_shared->p_next) {
+        if (p_shared->level == level && p_shared->id == id) break;
+    }
+    if (p_shared == NULL) {
+        if (ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                  ABT_FALSE, &pool) != ABT_SUCCESS) {
+            ABTI_spinlock_release(&g_hier_lock);
+            return NULL;
+        }
+        p_shared = (hier_shared *)ABTU_malloc(sizeof(hier_shared));
+        p_shared->level = level;
+        p_shared->id = id;
+        p_shared->refcount = 0;
+        p_shared->p_pool = ABTI_pool_get_ptr(pool);
+        p_shared->p_next = gp_hier_shared;
+        gp_hier_shared = p_shared;
+    }
+    p_shared->refcount++;
+    ABTI_spinlock_release(&g_hier_lock);
+
+    return p_shared->p_pool;
+}
+
+static void hier_shared_release(ABTI_pool *p_pool)
+{
+    hier_shared **pp_shared;
+
+    ABTI_spinlock_acquire(&g_hier_lock);
+    for (pp_shared = &gp_hier_shared; *pp_shared;
+         pp_shared = &(*pp_shared)->p_next) {
+        hier_shared *p_shared = *pp_shared;
+        if (p_shared->p_pool != p_pool) continue;
+        if (--p_shared->refcount == 0) {
+            ABT_pool pool = ABTI_pool_get_handle(p_pool);
+            *pp_shared = p_shared->p_next;
+            ABTU_free(p_shared);
+            ABT_pool_free(&pool);
+        }
+        break;
+    }
+    ABTI_spinlock_release(&g_hier_lock);
+}
+
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    int abt_errno = ABT_SUCCESS;
+    int i, num_pools;
+    ABT_pool pools[HIER_MAX_LEVELS];
+
+    abt_errno = ABT_sched_get_num_pools(sched, &num_pools);
+    ABTI_CHECK_ERROR(abt_errno);
+    ABTI_CHECK_TRUE(num_pools <= HIER_MAX_LEVELS, ABT_ERR_SCHED);
+    abt_errno = ABT_sched_get_pools(sched, num_pools, 0, pools);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* Default settings */
+    sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
+    p_data->event_freq = ABTI_global_get_sched_event_freq();
+    p_data->spill = HIER_DEFAULT_SPILL;
+    p_data->num_levels = num_pools;
+    p_data->num_shared = 0;
+    for (i = 0; i < num_pools; i++) {
+        p_data->p_levels[i] = ABTI_pool_get_ptr(pools[i]);
+    }
+
+    /* Set the variables from the config */
+    ABT_sched_config_read(config, 2, &p_data->event_freq, &p_data->spill);
+
+    abt_errno = ABT_sched_set_data(sched, (void *)p_data);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_WITH_CODE("hier: sched_init", abt_errno);
+    goto fn_exit;
+}
+
+/* Look up the L3 and socket pools of the ES running the scheduler. */
+static void sched_resolve_levels(sched_data *p_data, ABTI_xstream *p_xstream)
+{
+    static const int levels[] = { ABT_TOPOLOGY_L3, ABT_TOPOLOGY_SOCKET };
+    int i;
+
+    if (p_data->num_levels != 1) return;
+    for (i = 0; i < 2; i++) {
+        int id = ABTD_affinity_get_topology_id(p_xstream->ctx, levels[i]);
+        ABTI_pool *p_pool = hier_shared_get(levels[i], id);
+        if (p_pool == NULL) break;
+        p_data->p_levels[p_data->num_levels++] = p_pool;
+        p_data->num_shared++;
+    }
+}
+
+/* Number of units in the pools that are not in the scheduler's pool list,
+ * which ABTI_sched_has_to_stop() does not see. */
+static inline size_t sched_shared_size(sched_data *p_data)
+{
+    size_t size = 0;
+    int i;
+    for (i = p_data->num_levels - p_data->num_shared; i < p_data->num_levels;
+         i++) {
+        size += ABTI_pool_call_get_size(p_data->p_levels[i]);
+    }
+    return size;
+}
+
+/* Move a unit from the own pool to the next level if the own pool is long. */
+static inline void sched_spill(sched_data *p_data, ABTI_xstream *p_xstream)
+{
+    ABTI_pool *p_own = p_data->p_levels[0];
+    ABTI_pool *p_up;
+    ABT_unit unit;
+
+    if (p_data->spill <= 0 || p_data->num_levels < 2) return;
+    if (ABTI_pool_call_get_size(p_own) <= (size_t)p_data->spill) return;
+
+    unit = ABTI_pool_call_pop(p_own);
+    if (unit == ABT_UNIT_NULL) return;
+    LOG_EVENT_POOL_POP(p_own, unit);
+    ABTI_trace_unit(ABTI_TRACE_POP, p_own, unit);
+
+    p_up = p_data->p_levels[1];
+    ABT_unit_set_associated_pool(unit, ABTI_pool_get_handle(p_up));
+    LOG_EVENT_POOL_PUSH(p_up, unit, p_xstream);
+    ABTI_trace_unit(ABTI_TRACE_PUSH, p_up, unit);
+    ABTI_pool_call_push(p_up, unit);
+    ABTI_POOL_UNPARK(p_up);
+}
+
+static inline ABT_bool sched_idle_wait(ABTI_sched *p_sched,
+                                       sched_data *p_data,
+                                       ABTI_sched_idle *p_idle)
+{
+    ABT_bool ret;
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    /* Pushes to the shared pools have to wake up this ES when it parks. */
+    int first = p_data->num_levels - p_data->num_shared;
+    uint64_t bit = ABTI_sched_doorbell_bit(ABTI_local_get_xstream());
+    int i;
+    for (i = first; i < p_data->num_levels; i++) {
+        ABTI_pool_add_parked(p_data->p_levels[i], bit);
+    }
+    ABTD_atomic_mem_barrier();
+    if (sched_shared_size(p_data) > 0) {
+        ret = ABT_FALSE;
+    } else {
+        ret = ABTI_sched_idle_wait(p_sched, p_idle);
+    }
+    for (i = first; i < p_data->num_levels; i++) {
+        ABTI_pool_remove_parked(p_data->p_levels[i], bit);
+    }
+#else
+    ABTI_UNUSED(p_data);
+    ret = ABTI_sched_idle_wait(p_sched, p_idle);
+#endif
+    return ret;
+}
+
+static void sched_run(ABT_sched sched)
+{
+    uint32_t work_count = 0;
+    sched_data *p_data;
+    int i;
+    int run_cnt;
+    ABTI_sched_idle idle;
+
+    ABTI_xstream *p_xstream = ABTI_local_get_xstream();
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+    if (p_data->num_shared == 0) sched_resolve_levels(p_data, p_xstream);
+
+    ABTI_sched_idle_init(&idle);
+    while (1) {
+        run_cnt = 0;
+
+        /* Execute one work unit from the nearest pool that has one */
+        for (i = 0; i < p_data->num_levels; i++) {
+            ABTI_pool *p_pool = p_data->p_levels[i];
+            ABT_unit unit;
+            if (ABTI_pool_call_get_size(p_pool) == 0) continue;
+            if (i == 0) sched_spill(p_data, p_xstream);
+            unit = ABTI_pool_call_pop(p_pool);
+            LOG_EVENT_POOL_POP(p_pool, unit);
+            ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+            if (unit == ABT_UNIT_NULL) continue;
+            p_xstream->stats.num_pops++;
+            ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+            run_cnt++;
+            break;
+        }
+
+        if (run_cnt > 0) {
+            ABTI_sched_idle_reset(&idle);
+        } else {
+            p_xstream->stats.num_failed_pops++;
+            if (sched_idle_wait(p_sched, p_data, &idle) == ABT_TRUE) {
+                /* Check events before the ES is parked */
+                work_count = p_data->event_freq;
+            }
+        }
+
+        if (++work_count >= p_data->event_freq) {
+            ABTI_xstream_check_events(p_xstream, sched);
+            p_data->event_freq = ABTI_sched_get_event_freq(p_sched,
+                                                           p_data->event_freq);
+            /* A finishing scheduler leaves the shared pools empty unless
+             * it is asked to exit. */
+            if (sched_shared_size(p_data) == 0 ||
+                (p_sched->request & ABTI_SCHED_REQ_EXIT) ||
+                (p_xstream->request & ABTI_XSTREAM_REQ_EXIT)) {
+                ABT_bool stop = ABTI_sched_has_to_stop(p_sched, p_xstream);
+                if (stop == ABT_TRUE) break;
+            }
+            work_count = 0;
+        }
+    }
+}
+
+static int sched_free(ABT_sched sched)
+{
+    int abt_errno = ABT_SUCCESS;
+    int i;
+
+    sched_data *p_data;
+    ABT_sched_get_data(sched, (void **)&p_data);
+    for (i = p_data->num_levels - p_data->num_shared; i < p_data->num_levels;
+         i++) {
+        hier_shared_release(p_data->p_levels[i]);
+    }
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
@@ -0,0 +1,296 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Locality-aware Work-stealing Scheduler Implementation
+ *
+ * The first pool is the scheduler's own pool and the others are victims. A
+ * victim pool is regarded as the first pool of the main scheduler of another
+ * ES, and victims are tried from the nearest ES to the farthest one in terms
+ * of CPU topology: SMT siblings, the same L3 cache, the same NUMA node, and
+ * remote.  Victims at the same distance are tried in a random order. */
+
+static int  sched_init(ABT_sched sched, ABT_sched_config config);
+static void sched_run(ABT_sched sched);
+static int  sched_free(ABT_sched);
+
+static ABT_sched_def sched_localws_def = {
+    .type = ABT_SCHED_TYPE_TASK,
+    .init = sched_init,
+    .run = sched_run,
+    .free = sched_free,
+    .get_migr_pool = NULL,
+};
+
+typedef struct {
+    uint32_t event_freq;
+    int num_unknowns;           /* Number of victims whose ES is unknown */
+    int *p_dists;               /* Distance of each pool, or -1 if unknown */
+    int *p_victims;             /* Victim pool indices sorted by distance */
+    uint64_t steal_cnts[ABT_SCHED_STEAL_DIST_NUM]; /* Successful steals */
+} sched_data;
+
+ABT_sched_def *ABTI_sched_get_localws_def(void)
+{
+    return &sched_localws_def;
+}
+
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    int abt_errno = ABT_SUCCESS;
+    int i, num_pools;
+
+    abt_errno = ABT_sched_get_num_pools(sched, &num_pools);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* Default settings */
+    sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
+    p_data->event_freq = ABTI_global_get_sched_event_freq();
+    p_data->num_unknowns = num_pools - 1;
+    p_data->p_dists = (int *)ABTU_malloc(num_pools * sizeof(int));
+    p_data->p_victims = (int *)ABTU_malloc(num_pools * sizeof(int));
+    for (i = 0; i < num_pools; i++) {
+        p_data->p_dists[i] = -1;
+        p_data->p_victims[i] = i;
+    }
+    for (i = 0; i < ABT_SCHED_STEAL_DIST_NUM; i++) {
+        p_data->steal_cnts[i] = 0;
+    }
+
+    /* Set the variables from the config */
+    ABT_sched_config_read(config, 1, &p_data->event_freq);
+
+    abt_errno = ABT_sched_set_data(sched, (void *)p_data);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_WITH_CODE("localws: sched_init", abt_errno);
+    goto fn_exit;
+}
+
+static inline int sched_get_dist(sched_data *p_data, int idx)
+{
+    int dist = p_data->p_dists[idx];
+    return (dist < 0) ? ABT_SCHED_STEAL_DIST_REMOTE : dist;
+}
+
+/* Compute the distances of victims whose ES was unknown and sort victims. */
+static void sched_update_victims(sched_data *p_data, ABTI_xstream *p_xstream,
+                                 int num_pools, ABT_pool *p_pools)
+{
+    int i, j;
+    int updated = 0;
+
+    for (i = 1; i < num_pools; i++) {
+        if (p_data->p_dists[i] >= 0) continue;
+        ABTI_xstream *p_owner = ABTI_xstream_find_pool_owner(p_pools[i]);
+        if (p_owner == NULL) continue;
+        p_data->p_dists[i] = ABTD_affinity_get_distance(p_xstream->ctx,
+                                                        p_owner->ctx);
+        p_data->num_unknowns--;
+        updated = 1;
+    }
+    if (!updated) return;
+
+    /* Insertion sort of p_victims[1..num_pools-1] by distance */
+    for (i = 2; i < num_pools; i++) {
+        int victim = p_data->p_victims[i];
+        int dist = sched_get_dist(p_data, victim);
+        for (j = i; j > 1; j--) {
+            if (sched_get_dist(p_data, p_data->p_victims[j - 1]) <= dist) break;
+            p_data->p_victims[j] = p_data->p_victims[j - 1];
+        }
+        p_data->p_victims[j] = victim;
+    }
+}
+
+// call the stealing function directly
+ABT_unit deque_pop_steal(ABTI_pool *self);
+
+/* Steal a unit from the nearest victim that has one. */
+static ABT_unit sched_steal(sched_data *p_data, int num_pools,
+                            ABT_pool *p_pools, unsigned *p_seed,
+                            ABTI_pool **pp_victim)
+{
+    int first = 1;
+    while (first < num_pools) {
+        /* Victims in [first, last) have the same distance. */
+        int dist = sched_get_dist(p_data, p_data->p_victims[first]);
+        int last = first + 1;
+        while (last < num_pools &&
+               sched_get_dist(p_data, p_data->p_victims[last]) == dist) {
+            last++;
+        }
+
+        int num = last - first;
+        int start = (num == 1) ? 0 : rand_r(p_seed) % num;
+        int i;
+        for (i = 0; i < num; i++) {
+            int target = p_data->p_victims[first + (start + i) % num];
+            ABT_pool pool = p_pools[target];
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+            ABT_unit unit;
+            if (ABTI_pool_call_get_size(p_pool) == 0) continue;
+            // Pools other than deques have no separate steal operation.
+            if (p_pool->p_pop == ABTI_pool_deque.p_pop) {
+                unit = deque_pop_steal(p_pool);
+            } else {
+                unit = ABTI_pool_call_pop(p_pool);
+            }
+            LOG_EVENT_POOL_POP(p_pool, unit);
+            ABTI_trace_unit(ABTI_TRACE_STEAL, p_pool, unit);
+            if (unit != ABT_UNIT_NULL) {
+                p_data->steal_cnts[dist]++;
+                *pp_victim = p_pool;
+                return unit;
+            }
+        }
+        first = last;
+    }
+    return ABT_UNIT_NULL;
+}
+
+static void sched_run(ABT_sched sched)
+{
+    uint32_t work_count = 0;
+    sched_data *p_data;
+    int num_pools;
+    ABT_pool *p_pools;
+    ABT_unit unit;
+    unsigned seed = time(NULL);
+    int run_cnt;
+    ABTI_sched_idle idle;
+
+    ABTI_xstream *p_xstream = ABTI_local_get_xstream();
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+    ABT_sched_get_num_pools(sched, &num_pools);
+    p_pools = (ABT_pool *)ABTU_malloc(num_pools * sizeof(ABT_pool));
+    ABT_sched_get_pools(sched, num_pools, 0, p_pools);
+
+    sched_update_victims(p_data, p_xstream, num_pools, p_pools);
+
+    ABTI_sched_idle_init(&idle);
+    while (1) {
+        run_cnt = 0;
+
+        /* Execute one work unit from the scheduler's pool */
+        ABT_pool pool = p_pools[0];
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+        size_t size = ABTI_pool_call_get_size(p_pool);
+        if (size > 0) {
+            unit = ABTI_pool_call_pop(p_pool);
+            LOG_EVENT_POOL_POP(p_pool, unit);
+            ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+            if (unit != ABT_UNIT_NULL) {
+                p_xstream->stats.num_pops++;
+                ABTI_pool_prefetch_next(p_pool);
+                ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+                run_cnt++;
+            } else {
+                p_xstream->stats.num_failed_pops++;
+            }
+        } else if (num_pools > 1) {
+            p_xstream->stats.num_failed_pops++;
+            p_xstream->stats.num_steal_attempts++;
+            /* Steal a work unit from other pools */
+            unit = sched_steal(p_data, num_pools, p_pools, &seed, &p_pool);
+            if (unit != ABT_UNIT_NULL) {
+                p_xstream->stats.num_steals++;
+                ABT_unit_set_associated_pool(unit, p_pools[0]);
+                ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+                run_cnt++;
+            }
+        } else {
+            p_xstream->stats.num_failed_pops++;
+        }
+
+        if (run_cnt > 0) {
+            ABTI_sched_idle_reset(&idle);
+        } else if (ABTI_sched_idle_wait(p_sched, &idle) == ABT_TRUE) {
+            /* Check events before the ES is parked */
+            work_count = p_data->event_freq;
+        }
+
+        if (++work_count >= p_data->event_freq) {
+            ABT_bool stop = ABTI_sched_has_to_stop(p_sched, p_xstream);
+            if (stop == ABT_TRUE) break;
+            work_count = 0;
+            ABTI_xstream_check_events(p_xstream, sched);
+            p_data->event_freq = ABTI_sched_get_event_freq(p_sched,
+                                                           p_data->event_freq);
+            if (p_data->num_unknowns > 0) {
+                sched_update_victims(p_data, p_xstream, num_pools, p_pools);
+            }
+        }
+    }
+
+    ABTU_free(p_pools);
+}
+
+static int sched_free(ABT_sched sched)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    sched_data *p_data;
+    ABT_sched_get_data(sched, (void **)&p_data);
+    ABTU_free(p_data->p_dists);
+    ABTU_free(p_data->p_victims);
+    ABTU_free(p_data);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup SCHED
+ * @brief   Get the numbers of successful steals of a locality-aware scheduler.
+ *
+ * \c ABT_sched_get_steal_counts returns through \c counts the number of units
+ * stolen by \c sched for each hardware distance between the thief and the
+ * victim.  \c counts[d] is the count for distance \c d, which is one of
+ * \c ABT_SCHED_STEAL_DIST_SMT, \c ABT_SCHED_STEAL_DIST_L3,
+ * \c ABT_SCHED_STEAL_DIST_NUMA, and \c ABT_SCHED_STEAL_DIST_REMOTE.  At most
+ * \c num_counts counts are returned.  \c sched has to be created with
+ * \c ABT_SCHED_LOCALWS.
+ *
+ * @param[in]  sched       handle to the target scheduler
+ * @param[in]  num_counts  the number of elements in \c counts
+ * @param[out] counts      the numbers of steals per distance
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_INV_SCHED invalid scheduler
+ * @retval ABT_ERR_SCHED     \c sched is not a locality-aware scheduler
+ */
+int ABT_sched_get_steal_counts(ABT_sched sched, int num_counts,
+                               uint64_t *counts)
+{
+    int abt_errno = ABT_SUCCESS;
+    sched_data *p_data;
+    int i;
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+    ABTI_CHECK_TRUE(p_sched->run == sched_run, ABT_ERR_SCHED);
+
+    p_data = (sched_data *)p_sched->data;
+    if (num_counts > ABT_SCHED_STEAL_DIST_NUM) {
+        num_counts = ABT_SCHED_STEAL_DIST_NUM;
+    }
+    for (i = 0; i < num_counts; i++) {
+        counts[i] = p_data->steal_cnts[i];
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
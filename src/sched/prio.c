@@ -6,7 +6,14 @@
 #include "abti.h"
 
 
-/* Priority Scheduler Implementation */
+/* Priority Scheduler Implementation
+ *
+ * With ABT_sched_prio_steal, the scheduler steals units of a priority higher
+ * than those of its own pools from the other ESs whose main schedulers are
+ * priority schedulers, before it runs its own units of lower priorities.  The
+ * victim is the ES that has the most units at the highest priority found.
+ * Only the pools with multiple consumers (ABT_POOL_ACCESS_SPMC or MPMC) are
+ * victims. */
 
 static int  sched_init(ABT_sched sched, ABT_sched_config config);
 static void sched_run(ABT_sched sched);
@@ -20,13 +27,21 @@ static ABT_sched_def sched_prio_def = {
     .get_migr_pool = NULL
 };
 
+/* Number of scheduling iterations that run local units without looking for
+ * units of higher priorities after a failed search */
+#define PRIO_STEAL_SKIP     16
+
 typedef struct {
     uint32_t event_freq;
-#ifdef ABT_CONFIG_USE_SCHED_SLEEP
-    struct timespec sleep_time;
-#endif
+    ABTI_pool_group *p_group;   /* Bitmap of non-empty pools, or NULL */
+    int steal;                  /* Steal units of higher priorities */
 } sched_data;
 
+ABT_sched_config_var ABT_sched_prio_steal = {
+    .idx = 1,
+    .type = ABT_SCHED_CONFIG_INT
+};
+
 
 ABT_sched_def *ABTI_sched_get_prio_def(void)
 {
@@ -45,13 +60,16 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     /* Default settings */
     sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
     p_data->event_freq = ABTI_global_get_sched_event_freq();
-#ifdef ABT_CONFIG_USE_SCHED_SLEEP
-    p_data->sleep_time.tv_sec = 0;
-    p_data->sleep_time.tv_nsec = ABTI_global_get_sched_sleep_nsec();
-#endif
+    p_data->steal = 0;
 
     /* Set the variables from the config */
-    ABT_sched_config_read(config, 1, &p_data->event_freq);
+    ABT_sched_config_read(config, 2, &p_data->event_freq, &p_data->steal);
+
+    /* Track the non-empty pools so that the scheduler does not check every
+     * priority level. */
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    p_data->p_group = ABTI_pool_group_get(p_sched->num_pools,
+                                          p_sched->pools);
 
     abt_errno = ABT_sched_set_data(sched, (void *)p_data);
     ABTI_CHECK_ERROR(abt_errno);
@@ -64,6 +82,68 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     goto fn_exit;
 }
 
+/* Pop one work unit from p_pool and run it.  Returns 1 if a unit was run. */
+static inline int sched_pop_run(ABTI_xstream *p_xstream, ABTI_pool *p_pool)
+{
+    ABT_unit unit = ABTI_pool_call_pop(p_pool);
+    LOG_EVENT_POOL_POP(p_pool, unit);
+    ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+    if (unit == ABT_UNIT_NULL) return 0;
+
+    p_xstream->stats.num_pops++;
+    ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+    return 1;
+}
+
+/* Steal one work unit of a priority in [0, num_prios) from another ES and
+ * run it.  Returns 1 if a unit was run. */
+static int sched_steal_run(ABTI_xstream *p_xstream, ABT_pool *p_pools,
+                           int num_prios, unsigned *p_seed)
+{
+    ABTI_sched_kind kind = ABTI_sched_get_kind(&sched_prio_def);
+    int i, prio, start, max_xstreams;
+    ABTI_xstream **p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+
+    p_xstream->stats.num_steal_attempts++;
+    start = rand_r(p_seed) % max_xstreams;
+    for (prio = 0; prio < num_prios; prio++) {
+        ABTI_pool *p_own = ABTI_pool_get_ptr(p_pools[prio]);
+        ABTI_pool *p_victim = NULL;
+        size_t victim_size = 0;
+
+        for (i = 0; i < max_xstreams; i++) {
+            ABTI_xstream *p_target = p_xstreams[(start + i) % max_xstreams];
+            if (p_target == NULL || p_target == p_xstream) continue;
+            if (p_target->state != ABT_XSTREAM_STATE_READY &&
+                p_target->state != ABT_XSTREAM_STATE_RUNNING) continue;
+            ABTI_sched *p_sched = p_target->p_main_sched;
+            if (p_sched == NULL || p_sched->kind != kind ||
+                p_sched->num_pools <= prio) continue;
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[prio]);
+            if (p_pool == p_own) continue;
+            if (p_pool->access != ABT_POOL_ACCESS_SPMC &&
+                p_pool->access != ABT_POOL_ACCESS_MPMC) continue;
+            size_t size = ABTI_pool_call_get_size(p_pool);
+            if (size > victim_size) {
+                p_victim = p_pool;
+                victim_size = size;
+            }
+        }
+        if (p_victim == NULL) continue;
+
+        ABT_unit unit = ABTI_pool_call_pop(p_victim);
+        LOG_EVENT_POOL_POP(p_victim, unit);
+        if (unit == ABT_UNIT_NULL) continue;
+        ABTI_trace_unit(ABTI_TRACE_STEAL, p_victim, unit);
+        /* The unit goes back to the own pool of the same priority. */
+        ABT_unit_set_associated_pool(unit, p_pools[prio]);
+        p_xstream->stats.num_steals++;
+        ABTI_xstream_run_unit(p_xstream, unit, p_victim);
+        return 1;
+    }
+    return 0;
+}
+
 static void sched_run(ABT_sched sched)
 {
     uint32_t work_count = 0;
@@ -72,8 +152,13 @@ static void sched_run(ABT_sched sched)
     uint32_t event_freq;
     int num_pools;
     ABT_pool *p_pools;
+    ABTI_pool_group *p_group;
     int i;
-    CNT_DECL(run_cnt);
+    int run_cnt;
+    int steal_skip = 0;
+    ABT_bool replayed;
+    unsigned seed = time(NULL);
+    ABTI_sched_idle idle;
 
     ABTI_xstream *p_xstream = ABTI_local_get_xstream();
     ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
@@ -81,38 +166,67 @@ static void sched_run(ABT_sched sched)
     ABT_sched_get_data(sched, &data);
     p_data = sched_data_get_ptr(data);
     event_freq = p_data->event_freq;
+    p_group = p_data->p_group;
 
     /* Get the list of pools */
     ABT_sched_get_num_pools(sched, &num_pools);
     p_pools = (ABT_pool *)ABTU_malloc(num_pools * sizeof(ABT_pool));
     ABT_sched_get_pools(sched, num_pools, 0, p_pools);
 
+    ABTI_sched_idle_init(&idle);
     while (1) {
-        CNT_INIT(run_cnt, 0);
+        run_cnt = 0;
 
-        /* Execute one work unit from the scheduler's pool */
+        /* Follow the recorded decision if the schedule is replayed */
+        replayed = ABTI_record_replay_run(p_xstream, p_sched, &run_cnt);
+
+        /* Find the own pool of the highest priority that has units */
         /* The pool with lower index has higher priority. */
-        for (i = 0; i < num_pools; i++) {
-            ABT_pool pool = p_pools[i];
-            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-            size_t size = p_pool->p_get_size(pool);
-            if (size > 0) {
-                ABT_unit unit = p_pool->p_pop(pool);
-                LOG_EVENT_POOL_POP(p_pool, unit);
-                if (unit != ABT_UNIT_NULL) {
-                    ABTI_xstream_run_unit(p_xstream, unit, p_pool);
-                    CNT_INC(run_cnt);
-                }
-                break;
+        if (replayed == ABT_TRUE) {
+            i = -1;
+        } else if (p_group != NULL) {
+            i = ABTI_pool_group_find(p_group);
+        } else {
+            for (i = 0; i < num_pools; i++) {
+                ABTI_pool *p_pool = ABTI_pool_get_ptr(p_pools[i]);
+                if (ABTI_pool_call_get_size(p_pool) > 0) break;
+            }
+            if (i == num_pools) i = -1;
+        }
+
+        /* Look for units of higher priorities on the other ESs first */
+        if (replayed == ABT_FALSE && p_data->steal && i != 0) {
+            if (i < 0 || steal_skip == 0) {
+                run_cnt = sched_steal_run(p_xstream, p_pools,
+                                          i < 0 ? num_pools : i, &seed);
+                steal_skip = run_cnt ? 0 : PRIO_STEAL_SKIP;
+            } else {
+                steal_skip--;
             }
         }
 
+        /* Execute one work unit from the scheduler's pool */
+        if (run_cnt == 0 && i >= 0) {
+            run_cnt = sched_pop_run(p_xstream, ABTI_pool_get_ptr(p_pools[i]));
+            if (run_cnt == 0 && p_group != NULL) {
+                ABTI_pool_group_clear(p_group, i);
+            }
+        }
+
+        if (run_cnt == 0) p_xstream->stats.num_failed_pops++;
+        if (run_cnt > 0) {
+            ABTI_sched_idle_reset(&idle);
+        } else if (ABTI_sched_idle_wait(p_sched, &idle) == ABT_TRUE) {
+            /* Check events before the ES is parked */
+            work_count = event_freq;
+        }
+
         if (++work_count >= event_freq) {
             ABT_bool stop = ABTI_sched_has_to_stop(p_sched, p_xstream);
             if (stop == ABT_TRUE) break;
             work_count = 0;
             ABTI_xstream_check_events(p_xstream, sched);
-            SCHED_SLEEP(run_cnt, p_data->sleep_time);
+            event_freq = ABTI_sched_get_event_freq(p_sched, event_freq);
         }
     }
 
@@ -127,6 +241,7 @@ static int sched_free(ABT_sched sched)
 
     ABT_sched_get_data(sched, &data);
     p_data = sched_data_get_ptr(data);
+    if (p_data->p_group) ABTI_pool_group_release(p_data->p_group);
     ABTU_free(p_data);
 
     return abt_errno;
@@ -5,7 +5,23 @@
 
 #include "abti.h"
 
-/* Random Work-stealing Scheduler Implementation */
+/* Random Work-stealing Scheduler Implementation
+ *
+ * The first pool is the scheduler's own pool and the others are victims,
+ * which are chosen at random.  If a victim is the own pool of an ES on
+ * another NUMA node, units are stolen from it only when it has more than
+ * ABT_SCHED_REMOTE_THRESHOLD units, so that units stay near their data unless
+ * the imbalance is large.
+ *
+ * With ABT_sched_randws_split, a scheduler that finds nothing in a victim
+ * posts a split request to it and tries it again.  The units running on the
+ * owner of the victim split their work into a new unit only when they see the
+ * request (ABT_self_get_split_pool), which is lazy task creation.
+ *
+ * On heterogeneous processors, victims on efficiency cores are tried first
+ * since their units would finish later there, and an ES on an efficiency core
+ * passes the ULTs hinted with ABT_CORE_CLASS_PERF that it pops from its own
+ * pool to the least loaded ES on a performance core. */
 
 static int  sched_init(ABT_sched sched, ABT_sched_config config);
 static void sched_run(ABT_sched sched);
@@ -19,13 +35,24 @@ static ABT_sched_def sched_randws_def = {
     .get_migr_pool = NULL,
 };
 
+#define RANDWS_MAX_STEAL    256     /* Upper bound of units stolen at once */
+
 typedef struct {
     uint32_t event_freq;
-#ifdef ABT_CONFIG_USE_SCHED_SLEEP
-    struct timespec sleep_time;
-#endif
+    int steal_num;              /* ABT_SCHED_RANDWS_STEAL_HALF or > 0 */
+    int split;                  /* Post split requests to empty victims */
 } sched_data;
 
+ABT_sched_config_var ABT_sched_randws_steal = {
+    .idx = 1,
+    .type = ABT_SCHED_CONFIG_INT
+};
+
+ABT_sched_config_var ABT_sched_randws_split = {
+    .idx = 2,
+    .type = ABT_SCHED_CONFIG_INT
+};
+
 ABT_sched_def *ABTI_sched_get_randws_def(void)
 {
     return &sched_randws_def;
@@ -38,13 +65,13 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     /* Default settings */
     sched_data *p_data = (sched_data *)ABTU_malloc(sizeof(sched_data));
     p_data->event_freq = ABTI_global_get_sched_event_freq();
-#ifdef ABT_CONFIG_USE_SCHED_SLEEP
-    p_data->sleep_time.tv_sec = 0;
-    p_data->sleep_time.tv_nsec = ABTI_global_get_sched_sleep_nsec();
-#endif
+    p_data->steal_num = 1;
+    p_data->split = 0;
 
     /* Set the variables from the config */
-    ABT_sched_config_read(config, 1, &p_data->event_freq);
+    ABT_sched_config_read(config, 3, &p_data->event_freq, &p_data->steal_num,
+                          &p_data->split);
+    ABTI_CHECK_TRUE(p_data->steal_num >= 0, ABT_ERR_INV_SCHED_CONFIG);
 
     abt_errno = ABT_sched_set_data(sched, (void *)p_data);
     ABTI_CHECK_ERROR(abt_errno);
@@ -59,6 +86,197 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
 
 // call the stealing function directly
 ABT_unit deque_pop_steal(ABTI_pool *self);
+size_t deque_pop_steal_many(ABTI_pool *self, ABT_unit *units, size_t max_units);
+
+/* Steal units from p_victim.  The first one is returned, and the others are
+ * moved to the scheduler's own pool p_own. */
+static inline ABT_unit sched_steal(sched_data *p_data, ABTI_pool *p_victim,
+                                   ABTI_pool *p_own, ABT_unit *units)
+{
+    ABT_pool victim = ABTI_pool_get_handle(p_victim);
+    ABT_pool own = ABTI_pool_get_handle(p_own);
+    size_t max_units, num, i;
+
+    if (p_data->steal_num == ABT_SCHED_RANDWS_STEAL_HALF) {
+        max_units = (ABTI_pool_call_get_size(p_victim) + 1) / 2;
+    } else {
+        max_units = (size_t)p_data->steal_num;
+    }
+    if (max_units > RANDWS_MAX_STEAL) max_units = RANDWS_MAX_STEAL;
+    if (max_units == 0) max_units = 1;
+
+    // Pools other than deques have no separate steal operation.
+    if (p_victim->p_pop == ABTI_pool_deque.p_pop) {
+        if (max_units == 1) {
+            units[0] = deque_pop_steal(p_victim);
+            num = (units[0] != ABT_UNIT_NULL) ? 1 : 0;
+        } else {
+            num = deque_pop_steal_many(p_victim, units, max_units);
+        }
+    } else if (p_victim->p_pop_many) {
+        num = p_victim->p_pop_many(victim, units, max_units);
+        ABTI_pool_stats_pop_many(p_victim, num);
+    } else {
+        for (num = 0; num < max_units; num++) {
+            units[num] = ABTI_pool_call_pop(p_victim);
+            if (units[num] == ABT_UNIT_NULL) break;
+        }
+    }
+    if (num == 0) return ABT_UNIT_NULL;
+
+    for (i = 0; i < num; i++) {
+        LOG_EVENT_POOL_POP(p_victim, units[i]);
+        ABTI_trace_unit(ABTI_TRACE_STEAL, p_victim, units[i]);
+        ABT_unit_set_associated_pool(units[i], own);
+    }
+    if (num > 1) {
+        for (i = 1; i < num; i++) {
+            LOG_EVENT_POOL_PUSH(p_own, units[i], ABTI_local_get_xstream());
+            ABTI_trace_unit(ABTI_TRACE_PUSH, p_own, units[i]);
+        }
+        if (p_own->p_push_many) {
+            p_own->p_push_many(own, units + 1, num - 1);
+            ABTI_pool_stats_add(p_own, ABTI_POOL_STATS_PUSH, num - 1);
+        } else {
+            for (i = 1; i < num; i++) {
+                ABTI_pool_call_push(p_own, units[i]);
+            }
+        }
+        ABTI_POOL_UNPARK(p_own);
+    }
+    return units[0];
+}
+
+/* Return ABT_TRUE if the victim p_pools[idx] is known to be on another NUMA
+ * node than node.  The answer is cached in p_remote, where -1 means that the
+ * owner of the victim has not been found yet. */
+static inline ABT_bool sched_is_remote(int *p_remote, ABT_pool *p_pools,
+                                       int idx, int node)
+{
+    if (p_remote[idx] < 0) {
+        ABTI_xstream *p_owner = ABTI_xstream_find_pool_owner(p_pools[idx]);
+        int owner_node;
+        if (p_owner == NULL) return ABT_FALSE;
+        owner_node = ABTI_xstream_get_numa_node(p_owner);
+        p_remote[idx] = (node >= 0 && owner_node >= 0 && node != owner_node);
+    }
+    return p_remote[idx] ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Core classes of the owners of the victims */
+typedef struct {
+    int *p_class;               /* ABT_CORE_CLASS_* of each victim, or -1 */
+    uint32_t gen;               /* core_class_gen when p_class was filled */
+    int num_unknown;            /* Victims whose owners were not found */
+    int num_slow;               /* Victims on efficiency cores */
+    int num_fast;               /* Victims on performance cores */
+} sched_classes;
+
+/* Find the ES whose main scheduler uses pool as its own pool.  Unlike
+ * ABTI_xstream_find_pool_owner(), ESs that have started but not run their
+ * schedulers yet are also found, since units passed to them will be run. */
+static ABTI_xstream *sched_find_owner(ABT_pool pool)
+{
+    int i, max_xstreams;
+    ABTI_xstream **p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+    for (i = 0; i < max_xstreams; i++) {
+        ABTI_xstream *p_xstream = p_xstreams[i];
+        ABTI_sched *p_sched;
+        if (p_xstream == NULL) continue;
+        if (p_xstream->state != ABT_XSTREAM_STATE_READY &&
+            p_xstream->state != ABT_XSTREAM_STATE_RUNNING) {
+            continue;
+        }
+        p_sched = p_xstream->p_main_sched;
+        if (p_sched && p_sched->num_pools > 0 && p_sched->pools[0] == pool) {
+            return p_xstream;
+        }
+    }
+    return NULL;
+}
+
+/* Look up the owners of the victims again if some of them were not found or
+ * the class of an ES has changed since the last lookup. */
+static void sched_update_classes(sched_classes *p_classes, ABT_pool *p_pools,
+                                 int num_pools)
+{
+    uint32_t gen = *(volatile uint32_t *)&gp_ABTI_global->core_class_gen;
+    int i;
+
+    if (p_classes->num_unknown == 0 && p_classes->gen == gen) return;
+    p_classes->gen = gen;
+    p_classes->num_unknown = 0;
+    p_classes->num_slow = 0;
+    p_classes->num_fast = 0;
+    for (i = 1; i < num_pools; i++) {
+        ABTI_xstream *p_owner = sched_find_owner(p_pools[i]);
+        if (p_owner == NULL) {
+            p_classes->p_class[i] = -1;
+            p_classes->num_unknown++;
+        } else {
+            p_classes->p_class[i] = p_owner->core_class;
+            if (p_owner->core_class == ABT_CORE_CLASS_EFFICIENCY) {
+                p_classes->num_slow++;
+            } else {
+                p_classes->num_fast++;
+            }
+        }
+    }
+}
+
+/* Return a victim on an efficiency core that has units, starting from a
+ * random one, or -1 if there is none. */
+static inline int sched_pick_slow_victim(sched_classes *p_classes,
+                                         ABT_pool *p_pools, int num_pools,
+                                         unsigned *p_seed)
+{
+    int i, target = rand_r(p_seed) % (num_pools - 1) + 1;
+    for (i = 1; i < num_pools; i++) {
+        if (p_classes->p_class[target] == ABT_CORE_CLASS_EFFICIENCY &&
+            ABTI_pool_call_get_size(ABTI_pool_get_ptr(p_pools[target])) > 0) {
+            return target;
+        }
+        target = (target == num_pools - 1) ? 1 : target + 1;
+    }
+    return -1;
+}
+
+/* If unit is a ULT hinted to run on a performance core, push it to the least
+ * loaded victim on a performance core and return ABT_TRUE. */
+static ABT_bool sched_pass_to_fast(sched_classes *p_classes, ABT_pool *p_pools,
+                                   int num_pools, ABTI_pool *p_pool,
+                                   ABT_unit unit)
+{
+    ABTI_thread *p_thread;
+    ABTI_pool *p_target = NULL;
+    size_t size, min_size = 0;
+    int i;
+
+    if (ABTI_pool_unit_get_type(p_pool, unit) != ABT_UNIT_TYPE_THREAD) {
+        return ABT_FALSE;
+    }
+    p_thread = ABTI_pool_unit_get_thread(p_pool, unit);
+    if (p_thread->attr.core_class != ABT_CORE_CLASS_PERF) return ABT_FALSE;
+
+    for (i = 1; i < num_pools; i++) {
+        ABTI_pool *p_victim;
+        if (p_classes->p_class[i] != ABT_CORE_CLASS_PERF) continue;
+        p_victim = ABTI_pool_get_ptr(p_pools[i]);
+        size = ABTI_pool_call_get_size(p_victim);
+        if (p_target == NULL || size < min_size) {
+            p_target = p_victim;
+            min_size = size;
+        }
+    }
+    if (p_target == NULL) return ABT_FALSE;
+
+    ABT_unit_set_associated_pool(unit, ABTI_pool_get_handle(p_target));
+    LOG_EVENT_POOL_PUSH(p_target, unit, ABTI_local_get_xstream());
+    ABTI_trace_unit(ABTI_TRACE_PUSH, p_target, unit);
+    ABTI_pool_call_push(p_target, unit);
+    ABTI_POOL_UNPARK(p_target);
+    return ABT_TRUE;
+}
 
 static void sched_run(ABT_sched sched)
 {
@@ -67,10 +285,16 @@ static void sched_run(ABT_sched sched)
     int num_pools;
     ABT_pool *p_pools;
     ABT_unit unit;
+    ABT_unit units[RANDWS_MAX_STEAL];
     int target;
     unsigned seed = time(NULL);
     int pool_last_stolen = -1;
-    CNT_DECL(run_cnt);
+    int run_cnt;
+    int *p_remote;
+    int node;
+    sched_classes classes;
+    uint32_t remote_threshold = gp_ABTI_global->sched_remote_threshold;
+    ABTI_sched_idle idle;
 
     ABTI_xstream *p_xstream = ABTI_local_get_xstream();
     ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
@@ -79,42 +303,99 @@ static void sched_run(ABT_sched sched)
     ABT_sched_get_num_pools(sched, &num_pools);
     p_pools = (ABT_pool *)ABTU_malloc(num_pools * sizeof(ABT_pool));
     ABT_sched_get_pools(sched, num_pools, 0, p_pools);
+    p_remote = (int *)ABTU_malloc(num_pools * sizeof(int));
+    for (target = 0; target < num_pools; target++) {
+        p_remote[target] = -1;
+    }
+    node = ABTI_xstream_get_numa_node(p_xstream);
+    classes.p_class = (int *)ABTU_malloc(num_pools * sizeof(int));
+    classes.gen = 0;
+    classes.num_unknown = num_pools;
+    sched_update_classes(&classes, p_pools, num_pools);
 
+    ABTI_sched_idle_init(&idle);
     while (1) {
-        CNT_INIT(run_cnt, 0);
+        run_cnt = 0;
 
         /* Execute one work unit from the scheduler's pool */
         ABT_pool pool = p_pools[0];
         ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-        size_t size = p_pool->p_get_size(pool);
-        if (size > 0) {
-            unit = p_pool->p_pop(pool);
+        size_t size = ABTI_pool_call_get_size(p_pool);
+        if (ABTI_record_replay_run(p_xstream, p_sched, &run_cnt) == ABT_TRUE) {
+            /* The recorded decision has been followed. */
+        } else if (size > 0) {
+            unit = ABTI_pool_call_pop(p_pool);
             LOG_EVENT_POOL_POP(p_pool, unit);
+            ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
             if (unit != ABT_UNIT_NULL) {
-                ABTI_xstream_run_unit(p_xstream, unit, p_pool);
-                CNT_INC(run_cnt);
+                p_xstream->stats.num_pops++;
+                ABTI_pool_prefetch_next(p_pool);
+                if (p_xstream->core_class == ABT_CORE_CLASS_EFFICIENCY &&
+                    classes.num_fast > 0 &&
+                    sched_pass_to_fast(&classes, p_pools, num_pools, p_pool,
+                                       unit) == ABT_TRUE) {
+                    /* A performance core will run it. */
+                } else {
+                    ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+                }
+                run_cnt++;
+            } else {
+                p_xstream->stats.num_failed_pops++;
             }
         } else if (num_pools > 1) {
+            p_xstream->stats.num_failed_pops++;
+            p_xstream->stats.num_steal_attempts++;
             unit = ABT_UNIT_NULL;
             /* Steal a work unit from other pools */
             target = pool_last_stolen;
-            // If no recent successful stealing, select a random pool.
+            // If no recent successful stealing, select a random pool,
+            // preferring the ones on efficiency cores.
+            if (target == -1 && classes.num_slow > 0) {
+                target = sched_pick_slow_victim(&classes, p_pools, num_pools,
+                                                &seed);
+            }
             if (target == -1) {
                 target = (num_pools == 2) ? 1 : (rand_r(&seed) % (num_pools-1) + 1);
             }
             pool = p_pools[target];
             p_pool = ABTI_pool_get_ptr(pool);
-            unit = deque_pop_steal(p_pool);
-            LOG_EVENT_POOL_POP(p_pool, unit);
+            if (remote_threshold > 0 &&
+                sched_is_remote(p_remote, p_pools, target, node) == ABT_TRUE &&
+                ABTI_pool_call_get_size(p_pool) <= remote_threshold) {
+                /* Leave the units near their data */
+                unit = ABT_UNIT_NULL;
+            } else {
+                unit = sched_steal(p_data, p_pool,
+                                   ABTI_pool_get_ptr(p_pools[0]), units);
+            }
             if (unit != ABT_UNIT_NULL) {
+                p_xstream->stats.num_steals++;
                 pool_last_stolen = target;
-                ABT_unit_set_associated_pool(unit, p_pools[0]);
+                /* The other stolen units are in the own pool. */
+                ABTI_pool_prefetch_next(ABTI_pool_get_ptr(p_pools[0]));
                 ABTI_xstream_run_unit(p_xstream, unit, p_pool);
-                CNT_INC(run_cnt);
+                run_cnt++;
             }
             if (unit == ABT_UNIT_NULL) {
                 pool_last_stolen = -1;
+                if (p_data->split && ABTI_pool_call_get_size(p_pool) == 0) {
+                    /* Wait for a split of the victim unless another ES has
+                     * already requested one that is not served yet. */
+                    if (*(volatile uint32_t *)&p_pool->split_req == 0) {
+                        ABTD_atomic_exchange_uint32(&p_pool->split_req, 1);
+                        pool_last_stolen = target;
+                    }
+                }
             }
+        } else {
+            p_xstream->stats.num_failed_pops++;
+        }
+
+        if (run_cnt > 0) {
+            ABTI_sched_idle_reset(&idle);
+        } else if (ABTI_sched_idle_wait(p_sched, &idle) == ABT_TRUE) {
+            /* Check events before the ES is parked */
+            work_count = p_data->event_freq;
         }
 
         if (++work_count >= p_data->event_freq) {
@@ -122,10 +403,14 @@ static void sched_run(ABT_sched sched)
             if (stop == ABT_TRUE) break;
             work_count = 0;
             ABTI_xstream_check_events(p_xstream, sched);
-            SCHED_SLEEP(run_cnt, p_data->sleep_time);
+            sched_update_classes(&classes, p_pools, num_pools);
+            p_data->event_freq = ABTI_sched_get_event_freq(p_sched,
+                                                           p_data->event_freq);
         }
     }
 
+    ABTU_free(classes.p_class);
+    ABTU_free(p_remote);
     ABTU_free(p_pools);
 }
 
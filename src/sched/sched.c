@@ -66,11 +66,15 @@ int ABT_sched_create(ABT_sched_def *def, int num_pools, ABT_pool *pools,
 
     p_sched->used          = ABTI_SCHED_NOT_USED;
     p_sched->automatic     = ABT_FALSE;
+    p_sched->inline_nested = ABT_FALSE;
     p_sched->kind          = ABTI_sched_get_kind(def);
     p_sched->state         = ABT_SCHED_STATE_READY;
     p_sched->request       = 0;
     p_sched->pools         = pool_list;
     p_sched->num_pools     = num_pools;
+    p_sched->polling_pools = NULL;
+    p_sched->num_polling_pools = 0;
+    p_sched->polling_idx   = 0;
     p_sched->type          = def->type;
     p_sched->p_thread      = NULL;
     p_sched->p_task        = NULL;
@@ -80,6 +84,7 @@ int ABT_sched_create(ABT_sched_def *def, int num_pools, ABT_pool *pools,
     p_sched->run           = def->run;
     p_sched->free          = def->free;
     p_sched->get_migr_pool = def->get_migr_pool;
+    ABTI_sched_tune_init(p_sched);
 
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     p_sched->id            = ABTI_sched_get_new_id();
@@ -113,7 +118,8 @@ int ABT_sched_create(ABT_sched_def *def, int num_pools, ABT_pool *pools,
  * the pools will be created automatically.  The config must have been created
  * by \c ABT_sched_config_create(), and will be used as argument in the
  * initialization. If no specific configuration is required, the parameter can
- * be \c ABT_CONFIG_NULL.
+ * be \c ABT_CONFIG_NULL.  The pools created automatically are of the kind
+ * \c ABT_POOL_EDF for \c ABT_SCHED_EDF and \c ABT_POOL_FIFO otherwise.
  *
  * NOTE: The new scheduler will be automatically freed when it is not used
  * anymore or its associated ES is terminated.  Accordingly, the pools
@@ -138,9 +144,13 @@ int ABT_sched_create_basic(ABT_sched_predef predef, int num_pools,
 {
     int abt_errno = ABT_SUCCESS;
     ABT_pool_access access;
+    ABT_pool_kind kind;
     ABT_bool automatic;
     int p;
 
+    /* The EDF scheduler needs pools ordered by deadline. */
+    kind = (predef == ABT_SCHED_EDF) ? ABT_POOL_EDF : ABT_POOL_FIFO;
+
     /* We set the access to the default one */
     access = ABT_POOL_ACCESS_MPSC;
     automatic = ABT_TRUE;;
@@ -155,7 +165,7 @@ int ABT_sched_create_basic(ABT_sched_predef predef, int num_pools,
         pool_list = (ABT_pool *)ABTU_malloc(num_pools*sizeof(ABT_pool));
         for (p = 0; p < num_pools; p++) {
             if (pools[p] == ABT_POOL_NULL) {
-                abt_errno = ABT_pool_create_basic(ABT_POOL_FIFO, access,
+                abt_errno = ABT_pool_create_basic(kind, access,
                                                   ABT_TRUE, &pool_list[p]);
                 ABTI_CHECK_ERROR(abt_errno);
             } else {
@@ -169,20 +179,37 @@ int ABT_sched_create_basic(ABT_sched_predef predef, int num_pools,
             case ABT_SCHED_BASIC:
                 abt_errno = ABT_sched_create(ABTI_sched_get_basic_def(),
                                              num_pools, pool_list,
-                                             ABT_SCHED_CONFIG_NULL,
-                                             newsched);
+                                             config, newsched);
                 break;
             case ABT_SCHED_PRIO:
                 abt_errno = ABT_sched_create(ABTI_sched_get_prio_def(),
                                              num_pools, pool_list,
-                                             ABT_SCHED_CONFIG_NULL,
-                                             newsched);
+                                             config, newsched);
                 break;
             case ABT_SCHED_RANDWS:
                 abt_errno = ABT_sched_create(ABTI_sched_get_randws_def(),
                                              num_pools, pool_list,
-                                             ABT_SCHED_CONFIG_NULL,
-                                             newsched);
+                                             config, newsched);
+                break;
+            case ABT_SCHED_LOCALWS:
+                abt_errno = ABT_sched_create(ABTI_sched_get_localws_def(),
+                                             num_pools, pool_list,
+                                             config, newsched);
+                break;
+            case ABT_SCHED_EDF:
+                abt_errno = ABT_sched_create(ABTI_sched_get_edf_def(),
+                                             num_pools, pool_list,
+                                             config, newsched);
+                break;
+            case ABT_SCHED_HIER:
+                abt_errno = ABT_sched_create(ABTI_sched_get_hier_def(),
+                                             num_pools, pool_list,
+                                             config, newsched);
+                break;
+            case ABT_SCHED_FAIR:
+                abt_errno = ABT_sched_create(ABTI_sched_get_fair_def(),
+                                             num_pools, pool_list,
+                                             config, newsched);
                 break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
@@ -204,6 +231,10 @@ int ABT_sched_create_basic(ABT_sched_predef predef, int num_pools,
                 num_pools = ABTI_SCHED_NUM_PRIO;
                 break;
             case ABT_SCHED_RANDWS:
+            case ABT_SCHED_LOCALWS:
+            case ABT_SCHED_EDF:
+            case ABT_SCHED_HIER:
+            case ABT_SCHED_FAIR:
                 num_pools = 1;
                 break;
             default:
@@ -217,7 +248,7 @@ int ABT_sched_create_basic(ABT_sched_predef predef, int num_pools,
         ABT_pool pool_list[ABTI_SCHED_NUM_PRIO];
         int p;
         for (p = 0; p < num_pools; p++) {
-            abt_errno = ABT_pool_create_basic(ABT_POOL_FIFO, access, ABT_TRUE,
+            abt_errno = ABT_pool_create_basic(kind, access, ABT_TRUE,
                                               pool_list+p);
             ABTI_CHECK_ERROR(abt_errno);
         }
@@ -240,6 +271,26 @@ int ABT_sched_create_basic(ABT_sched_predef predef, int num_pools,
                                              num_pools, pool_list,
                                              config, newsched);
                 break;
+            case ABT_SCHED_LOCALWS:
+                abt_errno = ABT_sched_create(ABTI_sched_get_localws_def(),
+                                             num_pools, pool_list,
+                                             config, newsched);
+                break;
+            case ABT_SCHED_EDF:
+                abt_errno = ABT_sched_create(ABTI_sched_get_edf_def(),
+                                             num_pools, pool_list,
+                                             config, newsched);
+                break;
+            case ABT_SCHED_HIER:
+                abt_errno = ABT_sched_create(ABTI_sched_get_hier_def(),
+                                             num_pools, pool_list,
+                                             config, newsched);
+                break;
+            case ABT_SCHED_FAIR:
+                abt_errno = ABT_sched_create(ABTI_sched_get_fair_def(),
+                                             num_pools, pool_list,
+                                             config, newsched);
+                break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
                 ABTI_CHECK_ERROR(abt_errno);
@@ -359,6 +410,61 @@ int ABT_sched_get_pools(ABT_sched sched, int max_pools, int idx,
     goto fn_exit;
 }
 
+/**
+ * @ingroup SCHED
+ * @brief   Add a pool of polling units to the scheduler \c sched.
+ *
+ * \c ABT_sched_add_polling_pool() associates \c pool with \c sched as a pool
+ * of polling units, such as progress engines that loop on
+ * \c ABT_thread_yield().  The predefined schedulers run the units in polling
+ * pools one at a time only when all their other pools are empty, in place of
+ * spinning, sleeping, or parking the ES.  Polling pools are not returned by
+ * \c ABT_sched_get_pools() and do not count in the size of \c sched, so they
+ * do not keep the scheduler from finishing; polling units have to be stopped
+ * before the ES is joined.  Schedulers defined by the user do not run them.
+ *
+ * \c sched must not be used by an ES yet.
+ *
+ * @param[in] sched  handle to the target scheduler
+ * @param[in] pool   handle to the pool of polling units
+ * @return Error code
+ * @retval ABT_SUCCESS       on success
+ * @retval ABT_ERR_INV_SCHED invalid scheduler
+ * @retval ABT_ERR_INV_POOL  invalid pool
+ * @retval ABT_ERR_SCHED     \c sched is already used or \c pool is one of its
+ *                           pools
+ */
+int ABT_sched_add_polling_pool(ABT_sched sched, ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    int p;
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    ABTI_CHECK_TRUE(p_sched->used == ABTI_SCHED_NOT_USED, ABT_ERR_SCHED);
+    for (p = 0; p < p_sched->num_pools; p++) {
+        ABTI_CHECK_TRUE(p_sched->pools[p] != pool, ABT_ERR_SCHED);
+    }
+    for (p = 0; p < p_sched->num_polling_pools; p++) {
+        ABTI_CHECK_TRUE(p_sched->polling_pools[p] != pool, ABT_ERR_SCHED);
+    }
+
+    ABTI_pool_retain(p_pool);
+    p_sched->polling_pools = (ABT_pool *)ABTU_realloc(p_sched->polling_pools,
+        (p_sched->num_polling_pools + 1) * sizeof(ABT_pool));
+    p_sched->polling_pools[p_sched->num_polling_pools++] = pool;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup SCHED
  * @brief   Ask a scheduler to finish
@@ -460,7 +566,6 @@ int ABT_sched_has_to_stop(ABT_sched sched, ABT_bool *stop)
 ABT_bool ABTI_sched_has_to_stop(ABTI_sched *p_sched, ABTI_xstream *p_xstream)
 {
     ABT_bool stop = ABT_FALSE;
-    size_t size;
 
     /* Check exit request */
     if (p_sched->request & ABTI_SCHED_REQ_EXIT) {
@@ -470,15 +575,37 @@ ABT_bool ABTI_sched_has_to_stop(ABTI_sched *p_sched, ABTI_xstream *p_xstream)
         goto fn_exit;
     }
 
-    size = ABTI_sched_get_effective_size(p_sched);
-    if (size == 0) {
+    /* Only a scheduler that has a join request or is stacked stops when its
+     * pools are drained, so the pools, whose counters are written by other
+     * ESs, are not read otherwise. */
+    if (!(p_sched->request & ABTI_SCHED_REQ_FINISH) &&
+        p_sched->used != ABTI_SCHED_IN_POOL) {
+        goto fn_exit;
+    }
+
+    /* An inline nested scheduler returns to its parent as soon as it has no
+     * ready unit, and it terminates only when it or the ES is finishing. */
+    if (p_sched->inline_nested == ABT_TRUE) {
+        if (ABTI_sched_has_ready_units(p_sched) == ABT_TRUE) goto fn_exit;
+        ABTI_spinlock_acquire(&p_xstream->sched_lock);
+        if (ABTI_sched_is_finishing(p_sched, p_xstream) == ABT_TRUE &&
+            ABTI_sched_is_quiescent(p_sched, p_xstream) == ABT_TRUE) {
+            p_sched->state = ABT_SCHED_STATE_TERMINATED;
+        } else {
+            p_sched->state = ABT_SCHED_STATE_STOPPED;
+        }
+        stop = ABT_TRUE;
+        goto fn_exit;
+    }
+
+    if (ABTI_sched_is_quiescent(p_sched, p_xstream) == ABT_TRUE) {
         if (p_sched->request & ABTI_SCHED_REQ_FINISH) {
             /* Check join request */
             /* We need to lock in case someone wants to migrate to this
              * scheduler */
             ABTI_spinlock_acquire(&p_xstream->sched_lock);
-            size_t size = ABTI_sched_get_effective_size(p_sched);
-            if (size == 0) {
+            if (ABTI_sched_is_quiescent(p_sched, p_xstream) == ABT_TRUE &&
+                ABTI_sched_close_run_next(p_sched, p_xstream) == ABT_TRUE) {
                 p_sched->state = ABT_SCHED_STATE_TERMINATED;
                 stop = ABT_TRUE;
             } else {
@@ -490,6 +617,7 @@ ABT_bool ABTI_sched_has_to_stop(ABTI_sched *p_sched, ABTI_xstream *p_xstream)
              * tasklet type. However, if the scheduler is a ULT type, we
              * context switch to the parent scheduler. */
             if (p_sched->type == ABT_SCHED_TYPE_TASK) {
+                ABTI_spinlock_acquire(&p_xstream->sched_lock);
                 p_sched->state = ABT_SCHED_STATE_TERMINATED;
                 stop = ABT_TRUE;
             } else {
@@ -661,38 +789,135 @@ size_t ABTI_sched_get_effective_size(ABTI_sched *p_sched)
     size_t pool_size = 0;
     int p;
 
-#ifndef ABT_CONFIG_DISABLE_POOL_CONSUMER_CHECK
+    for (p = 0; p < p_sched->num_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[p]);
+        pool_size += ABTI_sched_get_effective_pool_size(p_pool);
+    }
+
+    return pool_size;
+}
+
+/* Whether ABTI_sched_get_effective_size() would return zero and, if p_sched
+ * is the main scheduler of p_xstream, the run-next slot of p_xstream is empty.
+ * It stops reading the pools at the first one that has work, so a busy
+ * scheduler with many pools usually reads only one of them. */
+ABT_bool ABTI_sched_is_quiescent(ABTI_sched *p_sched, ABTI_xstream *p_xstream)
+{
+    int p;
+
+    if (p_sched == p_xstream->p_main_sched) {
+        ABTI_thread *p_next = *(ABTI_thread *volatile *)&p_xstream->p_run_next;
+        if (p_next != NULL && p_next != ABTI_XSTREAM_RUN_NEXT_CLOSED) {
+            return ABT_FALSE;
+        }
+    }
+
+    for (p = 0; p < p_sched->num_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[p]);
+        if (ABTI_sched_get_effective_pool_size(p_pool) > 0) return ABT_FALSE;
+    }
+
+    return ABT_TRUE;
+}
+
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+/* Park the calling ES until a unit is pushed into one of the pools of p_sched,
+ * a request is made to the scheduler or the ES, or p_timeout has passed. */
+void ABTI_sched_park(ABTI_sched *p_sched, const struct timespec *p_timeout)
+{
     ABTI_xstream *p_xstream = ABTI_local_get_xstream();
-#endif
+    uint64_t bit = ABTI_sched_doorbell_bit(p_xstream);
+    uint32_t *p_seq = (bit != 0)
+                    ? &gp_ABTI_global->p_doorbells[p_xstream->rank].seq
+                    : &gp_ABTI_global->park_seq;
+    struct timespec tick_timeout;
+    uint32_t seq;
+    int p;
 
+    /* Register as a waiter first so that a concurrent push or request either
+     * is seen by the checks below or rings the doorbell. */
     for (p = 0; p < p_sched->num_pools; p++) {
-        ABT_pool pool = p_sched->pools[p];
-        ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-        pool_size += p_pool->p_get_size(pool);
-        pool_size += p_pool->num_migrations;
-        switch (p_pool->access) {
-            case ABT_POOL_ACCESS_PRIV:
-                pool_size += p_pool->num_blocked;
-                break;
-            case ABT_POOL_ACCESS_SPSC:
-            case ABT_POOL_ACCESS_MPSC:
-            case ABT_POOL_ACCESS_SPMC:
-            case ABT_POOL_ACCESS_MPMC:
-#ifdef ABT_CONFIG_DISABLE_POOL_CONSUMER_CHECK
-                if (p_pool->num_scheds == 1) {
-                    pool_size += p_pool->num_blocked;
-                }
-#else
-                if (p_pool->num_scheds == 1 && p_pool->consumer == p_xstream) {
-                    pool_size += p_pool->num_blocked;
-                }
-#endif
-                break;
-            default: break;
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[p]);
+        ABTI_pool_add_parked(p_pool, bit);
+    }
+    for (p = 0; p < p_sched->num_polling_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->polling_pools[p]);
+        ABTI_pool_add_parked(p_pool, bit);
+    }
+    if (bit != 0) {
+        ABTD_atomic_fetch_or_uint64(&gp_ABTI_global->parked_mask, bit);
+    }
+    ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->num_parked, 1);
+    seq = *(volatile uint32_t *)p_seq;
+
+    /* Timed waits on this ES expire, and its I/O and MPI waiters, the
+     * completion sources, and its poll hooks are polled, only while the
+     * scheduler runs. */
+    if (p_xstream->timer_wheel.num_entries > 0 ||
+        p_xstream->io_poller.num_waiters > 0 ||
+        p_xstream->mpi_poller.num_waiters > 0 ||
+        *(volatile uint32_t *)&gp_ABTI_global->num_completion_waiters > 0 ||
+        *(volatile int *)&p_xstream->num_poll_hooks > 0) {
+        if (p_timeout == NULL ||
+            (double)p_timeout->tv_sec + 1.0e-9 * p_timeout->tv_nsec
+            > ABTI_TIMER_WHEEL_TICK) {
+            tick_timeout.tv_sec = 0;
+            tick_timeout.tv_nsec = (long)(ABTI_TIMER_WHEEL_TICK * 1.0e9);
+            p_timeout = &tick_timeout;
         }
     }
 
-    return pool_size;
+    if (ABTI_sched_has_unit(p_sched) == ABT_FALSE &&
+        ABTI_sched_has_polling_unit(p_sched) == ABT_FALSE &&
+        *(ABTI_thread *volatile *)&p_xstream->p_run_next == NULL &&
+        p_sched->request == 0 && p_xstream->request == 0) {
+        ABTI_rcu_offline(p_xstream);
+        ABTD_futex_wait(p_seq, seq, p_timeout);
+        ABTI_rcu_online(p_xstream);
+    }
+
+    ABTD_atomic_fetch_sub_uint32(&gp_ABTI_global->num_parked, 1);
+    if (bit != 0) {
+        ABTD_atomic_fetch_and_uint64(&gp_ABTI_global->parked_mask, ~bit);
+    }
+    for (p = 0; p < p_sched->num_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[p]);
+        ABTI_pool_remove_parked(p_pool, bit);
+    }
+    for (p = 0; p < p_sched->num_polling_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->polling_pools[p]);
+        ABTI_pool_remove_parked(p_pool, bit);
+    }
+}
+#endif
+
+/* Run one unit of the polling pools of p_sched, which the predefined
+ * schedulers call when their other pools are empty.  The pools are visited
+ * round-robin so that every polling unit makes progress.  Returns ABT_TRUE if
+ * a unit was run. */
+ABT_bool ABTI_sched_run_polling(ABTI_sched *p_sched, ABTI_xstream *p_xstream)
+{
+    int num_pools = p_sched->num_polling_pools;
+    int i, idx = p_sched->polling_idx;
+
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool *p_pool;
+        ABT_unit unit;
+
+        if (++idx >= num_pools) idx = 0;
+        p_pool = ABTI_pool_get_ptr(p_sched->polling_pools[idx]);
+        if (ABTI_pool_call_get_size(p_pool) == 0) continue;
+        unit = ABTI_pool_call_pop(p_pool);
+        LOG_EVENT_POOL_POP(p_pool, unit);
+        ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+        if (unit == ABT_UNIT_NULL) continue;
+
+        p_sched->polling_idx = idx;
+        p_xstream->stats.num_pops++;
+        ABTI_xstream_run_unit(p_xstream, unit, p_pool);
+        return ABT_TRUE;
+    }
+    return ABT_FALSE;
 }
 
 
@@ -722,6 +947,15 @@ int ABTI_sched_free(ABTI_sched *p_sched)
         }
     }
     ABTU_free(p_sched->pools);
+    for (p = 0; p < p_sched->num_polling_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->polling_pools[p]);
+        int32_t num_scheds = ABTI_pool_release(p_pool);
+        if (p_pool->automatic == ABT_TRUE && num_scheds == 0) {
+            abt_errno = ABT_pool_free(p_sched->polling_pools+p);
+            ABTI_CHECK_ERROR(abt_errno);
+        }
+    }
+    ABTU_free(p_sched->polling_pools);
 
     /* Free the associated work unit */
     if (p_sched->type == ABT_SCHED_TYPE_ULT) {
@@ -818,6 +1052,8 @@ void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
         kind_str = "BASIC";
     } else if (kind == ABTI_sched_get_kind(ABTI_sched_get_prio_def())) {
         kind_str = "PRIO";
+    } else if (kind == ABTI_sched_get_kind(ABTI_sched_get_edf_def())) {
+        kind_str = "EDF";
     } else {
         kind_str = "USER";
     }
@@ -866,6 +1102,7 @@ void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
         "%srequest  : 0x%x\n"
         "%snum_pools: %d\n"
         "%spools    : %s\n"
+        "%spolling  : %d pools\n"
         "%ssize     : %zu\n"
         "%stot_size : %zu\n"
         "%sdata     : %p\n",
@@ -881,11 +1118,22 @@ void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
         prefix, p_sched->request,
         prefix, p_sched->num_pools,
         prefix, pools_str,
+        prefix, p_sched->num_polling_pools,
         prefix, ABTI_sched_get_size(p_sched),
         prefix, ABTI_sched_get_total_size(p_sched),
         prefix, p_sched->data
     );
     ABTU_free(pools_str);
+    if (p_sched->tune.enabled == ABT_TRUE) {
+        fprintf(p_os,
+            "%sevent_freq: %u (tuned)\n"
+            "%ssleep_nsec: %ld (tuned)\n"
+            "%sadjusted : %" PRIu64 " times\n",
+            prefix, p_sched->tune.event_freq,
+            prefix, p_sched->tune.sleep_nsec,
+            prefix, p_sched->tune.num_adjustments
+        );
+    }
 
     if (print_sub == ABT_TRUE) {
         for (i = 0; i < p_sched->num_pools; i++) {
@@ -905,6 +1153,104 @@ void ABTI_sched_reset_id(void)
     g_sched_id = 0;
 }
 
+/* Autotuning (ABT_SCHED_AUTOTUNE).  Once per window, the event frequency is
+ * doubled if event checks take more than HIGH_OVERHEAD of the time and halved
+ * if they take less than LOW_OVERHEAD, so the ES reacts to events as early as
+ * the overhead allows.  The sleep time is doubled up to ABT_SCHED_SLEEP_NSEC
+ * while the scheduler is mostly idle, which saves wakeups, and halved when it
+ * is mostly busy, so that the ES comes back quickly after short idle periods.
+ */
+#define ABTI_SCHED_TUNE_WINDOW          1.0e-2  /* in seconds */
+#define ABTI_SCHED_TUNE_MIN_FREQ        4
+#define ABTI_SCHED_TUNE_MAX_FREQ        4096
+#define ABTI_SCHED_TUNE_HIGH_OVERHEAD   0.05
+#define ABTI_SCHED_TUNE_LOW_OVERHEAD    0.01
+#define ABTI_SCHED_TUNE_MIN_SLEEP       10000   /* in nanoseconds */
+#define ABTI_SCHED_TUNE_HIGH_IDLE       0.9
+#define ABTI_SCHED_TUNE_LOW_IDLE        0.5
+
+void ABTI_sched_tune_init(ABTI_sched *p_sched)
+{
+    ABTI_sched_tune *p_tune = &p_sched->tune;
+
+    p_tune->enabled = gp_ABTI_global->sched_autotune;
+    p_tune->event_freq = 0;
+    p_tune->sleep_nsec = ABTI_global_get_sched_sleep_nsec();
+    p_tune->window_start = 0.0;
+    p_tune->check_time = 0.0;
+    p_tune->num_checks = 0;
+    p_tune->num_units = 0;
+    p_tune->num_idle_loops = 0;
+    p_tune->check_cost = 0.0;
+    p_tune->check_overhead = 0.0;
+    p_tune->idle_ratio = 0.0;
+    p_tune->num_adjustments = 0;
+}
+
+/* Called by ABTI_xstream_check_events() with the time of an event check */
+void ABTI_sched_tune_update(ABTI_sched *p_sched, ABTI_xstream *p_xstream,
+                            double start, double end)
+{
+    ABTI_sched_tune *p_tune = &p_sched->tune;
+    ABT_xstream_stats *p_stats = &p_xstream->stats;
+    uint64_t num_units, num_idle_loops;
+    double window;
+    uint32_t freq;
+    long sleep, max_sleep;
+
+    if (p_tune->window_start == 0.0) goto new_window;
+
+    p_tune->check_time += end - start;
+    p_tune->num_checks++;
+    window = end - p_tune->window_start;
+    if (window < ABTI_SCHED_TUNE_WINDOW) return;
+
+    num_units = p_stats->num_units - p_tune->num_units;
+    num_idle_loops = p_stats->num_idle_loops - p_tune->num_idle_loops;
+    p_tune->check_cost = p_tune->check_time / p_tune->num_checks;
+    p_tune->check_overhead = p_tune->check_time / window;
+    p_tune->idle_ratio = (num_units + num_idle_loops > 0)
+                       ? (double)num_idle_loops / (num_units + num_idle_loops)
+                       : 1.0;
+
+    freq = p_tune->event_freq;
+    if (freq != 0) {
+        if (p_tune->check_overhead > ABTI_SCHED_TUNE_HIGH_OVERHEAD) {
+            freq = (freq * 2 < ABTI_SCHED_TUNE_MAX_FREQ)
+                 ? freq * 2 : ABTI_SCHED_TUNE_MAX_FREQ;
+        } else if (p_tune->check_overhead < ABTI_SCHED_TUNE_LOW_OVERHEAD) {
+            freq = (freq / 2 > ABTI_SCHED_TUNE_MIN_FREQ)
+                 ? freq / 2 : ABTI_SCHED_TUNE_MIN_FREQ;
+        }
+    }
+
+    sleep = p_tune->sleep_nsec;
+    max_sleep = ABTI_global_get_sched_sleep_nsec();
+    if (p_tune->idle_ratio > ABTI_SCHED_TUNE_HIGH_IDLE) {
+        sleep = (sleep * 2 < max_sleep) ? sleep * 2 : max_sleep;
+    } else if (p_tune->idle_ratio < ABTI_SCHED_TUNE_LOW_IDLE) {
+        sleep = (sleep / 2 > ABTI_SCHED_TUNE_MIN_SLEEP)
+              ? sleep / 2 : ABTI_SCHED_TUNE_MIN_SLEEP;
+        if (sleep > max_sleep) sleep = max_sleep;
+    }
+
+    if (freq != p_tune->event_freq || sleep != p_tune->sleep_nsec) {
+        LOG_EVENT("[E%" PRIu64 "] tune: event_freq %u -> %u, "
+                  "sleep_nsec %ld -> %ld\n", p_xstream->rank,
+                  p_tune->event_freq, freq, p_tune->sleep_nsec, sleep);
+        p_tune->event_freq = freq;
+        p_tune->sleep_nsec = sleep;
+        p_tune->num_adjustments++;
+    }
+
+  new_window:
+    p_tune->window_start = end;
+    p_tune->check_time = 0.0;
+    p_tune->num_checks = 0;
+    p_tune->num_units = p_stats->num_units;
+    p_tune->num_idle_loops = p_stats->num_idle_loops;
+}
+
 /*****************************************************************************/
 /* Internal static functions                                                 */
 /*****************************************************************************/
@@ -33,6 +33,7 @@
 int ABT_self_get_type(ABT_unit_type *type)
 {
     int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local;
 
     /* If Argobots has not been initialized, set type to ABT_UNIT_TYPE_EXIT. */
     if (gp_ABTI_global == NULL) {
@@ -41,16 +42,17 @@ int ABT_self_get_type(ABT_unit_type *type)
         goto fn_exit;
     }
 
+    p_local = ABTI_local_get_local();
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
     /* This is when an external thread called this routine. */
-    if (lp_ABTI_local == NULL) {
+    if (p_local == NULL) {
         abt_errno = ABT_ERR_INV_XSTREAM;
         *type = ABT_UNIT_TYPE_EXT;
         goto fn_exit;
     }
 #endif
 
-    if (ABTI_local_get_task() != NULL) {
+    if (p_local->p_task != NULL) {
         *type = ABT_UNIT_TYPE_TASK;
     } else {
         /* Since ABTI_local_get_thread() can return NULL during executing
@@ -63,6 +65,22 @@ int ABT_self_get_type(ABT_unit_type *type)
     return abt_errno;
 }
 
+/**
+ * @ingroup SELF
+ * @brief   Return the type of calling work unit without error checking.
+ *
+ * \c ABT_self_get_type_unchecked() returns the type of the calling work unit,
+ * which is \c ABT_UNIT_TYPE_THREAD or \c ABT_UNIT_TYPE_TASK.  Unlike
+ * \c ABT_self_get_type(), it must not be called by an external thread.
+ *
+ * @return work unit type
+ */
+ABT_unit_type ABT_self_get_type_unchecked(void)
+{
+    return (ABTI_local_get_task() != NULL) ? ABT_UNIT_TYPE_TASK
+                                           : ABT_UNIT_TYPE_THREAD;
+}
+
 /**
  * @ingroup SELF
  * @brief   Check if the caller is the primary ULT.
@@ -220,6 +238,65 @@ int ABT_self_get_last_pool_id(int *pool_id)
     return abt_errno;
 }
 
+/**
+ * @ingroup SELF
+ * @brief   Check whether an idle ES waits for the caller to split its work.
+ *
+ * \c ABT_self_get_split_pool() is a cheap split point for lazy task creation.
+ * A work unit that has divisible work (e.g., the remaining iterations of a
+ * loop) keeps the work to itself and calls this routine from time to time.
+ * If an idle ES has found nothing to steal from the pool of the caller and has
+ * requested a split (see \c ABT_sched_randws_split), the request is consumed
+ * and \c pool is set to that pool, into which the caller should push a new
+ * work unit for part of its work.  Otherwise, \c pool is set to
+ * \c ABT_POOL_NULL, and the caller should go on by itself, so that no unit is
+ * created unless another ES can execute it.
+ *
+ * @param[out] pool  pool to push a split work unit to, or \c ABT_POOL_NULL
+ * @return Error code
+ * @retval ABT_SUCCESS           on success
+ * @retval ABT_ERR_UNINITIALIZED Argobots has not been initialized
+ * @retval ABT_ERR_INV_XSTREAM   called by an external thread, e.g., pthread
+ */
+int ABT_self_get_split_pool(ABT_pool *pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread *p_thread;
+    ABTI_task *p_task;
+    ABTI_pool *p_pool;
+
+    *pool = ABT_POOL_NULL;
+
+    if (gp_ABTI_global == NULL) {
+        abt_errno = ABT_ERR_UNINITIALIZED;
+        goto fn_exit;
+    }
+
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    if (lp_ABTI_local == NULL) {
+        abt_errno = ABT_ERR_INV_XSTREAM;
+        goto fn_exit;
+    }
+#endif
+
+    if ((p_thread = ABTI_local_get_thread())) {
+        p_pool = p_thread->p_pool;
+    } else if ((p_task = ABTI_local_get_task())) {
+        p_pool = p_task->p_pool;
+    } else {
+        goto fn_exit;
+    }
+
+    /* Only a plain read unless a request is posted */
+    if (*(volatile uint32_t *)&p_pool->split_req != 0 &&
+        ABTD_atomic_exchange_uint32(&p_pool->split_req, 0) != 0) {
+        *pool = ABTI_pool_get_handle(p_pool);
+    }
+
+  fn_exit:
+    return abt_errno;
+}
+
 /**
  * @ingroup SELF
  * @brief   Suspend the current ULT.
@@ -0,0 +1,304 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+static void ABTI_sem_wait_slow(ABTI_sem *p_sem);
+static void ABTI_sem_post_slow(ABTI_sem *p_sem);
+
+
+/** @defgroup SEM Semaphore
+ * A \a semaphore is a counting semaphore.  Acquiring an available permit and
+ * releasing a permit nobody waits for are a single atomic operation on the
+ * value.  Only when there is no permit, the caller is queued in FIFO order
+ * under a spinlock, and a released permit is handed over to the first waiter
+ * so that it cannot be taken by a later caller.  Waiting ULTs are blocked, and
+ * waiting external threads poll a flag of their own.
+ */
+
+/**
+ * @ingroup SEM
+ * @brief   Create a new semaphore.
+ *
+ * \c ABT_sem_create() creates a new semaphore that has \c value permits and
+ * returns its handle through \c newsem.
+ *
+ * @param[in]  value   initial number of permits
+ * @param[out] newsem  handle to a new semaphore
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_SEM \c value is larger than \c INT32_MAX
+ */
+int ABT_sem_create(uint32_t value, ABT_sem *newsem)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sem *p_sem;
+    ABTI_CHECK_TRUE(value <= INT32_MAX, ABT_ERR_SEM);
+
+    p_sem = (ABTI_sem *)ABTU_malloc(sizeof(ABTI_sem));
+    p_sem->value = (int32_t)value;
+    ABTI_spinlock_create(&p_sem->lock);
+    p_sem->num_pending = 0;
+    p_sem->p_head = NULL;
+    p_sem->p_tail = NULL;
+
+    *newsem = ABTI_sem_get_handle(p_sem);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup SEM
+ * @brief   Free the semaphore.
+ *
+ * \c ABT_sem_free() releases the semaphore \c sem.  No work unit may be
+ * waiting on \c sem.  If it is successfully processed, \c sem is set to
+ * \c ABT_SEM_NULL.
+ *
+ * @param[in,out] sem  handle to the semaphore
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_SEM there are waiters
+ */
+int ABT_sem_free(ABT_sem *sem)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sem *p_sem = ABTI_sem_get_ptr(*sem);
+    ABTI_CHECK_NULL_SEM_PTR(p_sem);
+    ABTI_CHECK_TRUE(*(volatile int32_t *)&p_sem->value >= 0, ABT_ERR_SEM);
+
+    /* The last waiter may still be leaving ABTI_sem_wait_slow(). */
+    ABTI_spinlock_acquire(&p_sem->lock);
+    ABTI_spinlock_free(&p_sem->lock);
+    ABTU_free(p_sem);
+
+    *sem = ABT_SEM_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup SEM
+ * @brief   Acquire a permit of the semaphore.
+ *
+ * \c ABT_sem_wait() takes a permit of the semaphore \c sem.  If no permit is
+ * available, the caller waits until \c ABT_sem_post() hands one over to it.
+ * Waiters are served in FIFO order.  A ULT is blocked while waiting, and an
+ * external thread polls.  Since a tasklet cannot be blocked, it has to use
+ * \c ABT_sem_trywait() instead.
+ *
+ * @param[in] sem  handle to the semaphore
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_SEM called by a tasklet
+ */
+int ABT_sem_wait(ABT_sem sem)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sem *p_sem = ABTI_sem_get_ptr(sem);
+    ABTI_CHECK_NULL_SEM_PTR(p_sem);
+    ABTI_CHECK_TRUE(lp_ABTI_local == NULL || ABTI_local_get_task() == NULL,
+                    ABT_ERR_SEM);
+
+    if (ABTD_atomic_fetch_sub_int32(&p_sem->value, 1) <= 0) {
+        ABTI_sem_wait_slow(p_sem);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup SEM
+ * @brief   Acquire a permit of the semaphore without waiting.
+ *
+ * \c ABT_sem_trywait() takes a permit of the semaphore \c sem if one is
+ * available.  Otherwise, it returns \c ABT_ERR_SEM immediately.  This routine
+ * can be called by tasklets.
+ *
+ * @param[in] sem  handle to the semaphore
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_SEM no permit is available
+ */
+int ABT_sem_trywait(ABT_sem sem)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sem *p_sem = ABTI_sem_get_ptr(sem);
+    ABTI_CHECK_NULL_SEM_PTR(p_sem);
+
+    while (1) {
+        int32_t value = *(volatile int32_t *)&p_sem->value;
+        if (value <= 0) {
+            /* Not an error worth reporting */
+            abt_errno = ABT_ERR_SEM;
+            break;
+        }
+        if (ABTD_atomic_cas_int32(&p_sem->value, value, value - 1) == value) {
+            break;
+        }
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup SEM
+ * @brief   Release a permit of the semaphore.
+ *
+ * \c ABT_sem_post() returns a permit to the semaphore \c sem.  If work units
+ * are waiting on \c sem, the permit is handed over to the first of them and
+ * it is woken up.  This routine can be called by ULTs, tasklets, and external
+ * threads.
+ *
+ * @param[in] sem  handle to the semaphore
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_sem_post(ABT_sem sem)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sem *p_sem = ABTI_sem_get_ptr(sem);
+    ABTI_CHECK_NULL_SEM_PTR(p_sem);
+
+    if (ABTD_atomic_fetch_add_int32(&p_sem->value, 1) < 0) {
+        ABTI_sem_post_slow(p_sem);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup SEM
+ * @brief   Get the number of available permits of the semaphore.
+ *
+ * \c ABT_sem_get_value() returns through \c value the number of permits of
+ * the semaphore \c sem that can be taken without waiting.  It is zero while
+ * work units are waiting on \c sem.
+ *
+ * @param[in]  sem    handle to the semaphore
+ * @param[out] value  number of available permits
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_sem_get_value(ABT_sem sem, int *value)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sem *p_sem = ABTI_sem_get_ptr(sem);
+    ABTI_CHECK_NULL_SEM_PTR(p_sem);
+
+    int32_t cur = *(volatile int32_t *)&p_sem->value;
+    *value = (cur > 0) ? (int)cur : 0;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+/* The caller has taken a permit that is not available, i.e., it has made the
+ * value negative.  If ABTI_sem_post_slow() has already passed a permit
+ * because the caller was not queued yet, take it.  Otherwise, queue the caller
+ * at the tail as the thread hash table does and wait for a permit. */
+static void ABTI_sem_wait_slow(ABTI_sem *p_sem)
+{
+    ABTI_thread *p_thread = NULL;
+    ABTI_unit unit_ext;
+    ABTI_unit *p_unit;
+    uint32_t ext_signal = ABTD_FUTEX_SIGNAL_INIT;
+
+    if (lp_ABTI_local != NULL) {
+        p_thread = ABTI_local_get_thread();
+        p_unit = &p_thread->unit_def;
+        p_unit->thread = ABTI_thread_get_handle(p_thread);
+        p_unit->type = ABT_UNIT_TYPE_THREAD;
+    } else {
+        /* external thread */
+        p_unit = &unit_ext;
+        p_unit->pool = (ABT_pool)&ext_signal;
+        p_unit->type = ABT_UNIT_TYPE_EXT;
+    }
+    p_unit->p_next = NULL;
+
+    ABTI_spinlock_acquire(&p_sem->lock);
+    if (p_sem->num_pending > 0) {
+        p_sem->num_pending--;
+        ABTI_spinlock_release(&p_sem->lock);
+        return;
+    }
+    if (p_sem->p_tail) {
+        p_sem->p_tail->p_next = p_unit;
+    } else {
+        p_sem->p_head = p_unit;
+    }
+    p_sem->p_tail = p_unit;
+
+    if (p_thread) {
+        ABTI_thread_set_blocked(p_thread);
+        ABTI_spinlock_release(&p_sem->lock);
+        ABTI_thread_suspend(p_thread);
+    } else {
+        ABTI_spinlock_release(&p_sem->lock);
+        ABTD_futex_signal_wait(&ext_signal);
+    }
+}
+
+/* The caller has returned a permit while the value was negative, so there is
+ * a waiter.  Wake up the head of the queue, or leave the permit to the waiter
+ * that has not been queued yet. */
+static void ABTI_sem_post_slow(ABTI_sem *p_sem)
+{
+    ABTI_unit *p_unit;
+
+    ABTI_spinlock_acquire(&p_sem->lock);
+    p_unit = p_sem->p_head;
+    if (p_unit == NULL) {
+        p_sem->num_pending++;
+        ABTI_spinlock_release(&p_sem->lock);
+        return;
+    }
+    p_sem->p_head = p_unit->p_next;
+    if (p_sem->p_head == NULL) p_sem->p_tail = NULL;
+    p_unit->p_next = NULL;
+
+    if (p_unit->type == ABT_UNIT_TYPE_THREAD) {
+        ABTI_thread_set_ready(ABTI_thread_get_ptr(p_unit->thread));
+    } else {
+        /* When the head is an external thread */
+        ABTD_futex_signal_set((uint32_t *)p_unit->pool);
+    }
+    ABTI_spinlock_release(&p_sem->lock);
+}
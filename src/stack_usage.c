@@ -0,0 +1,188 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Stack usage per ULT function.  With ABT_STACK_PROFILE, ULT stacks are
+ * painted when their contexts are made (see ABTI_thread_init_stack()), and a
+ * ULT that has returned from its function measures how much of its stack has
+ * been overwritten before it switches away for the last time.  The size is
+ * added to the histogram of the function of the ULT in a global
+ * open-addressing table, whose entries are claimed with CAS and never
+ * released until ABT_finalize().  The ULTs of the functions that do not fit
+ * the table are counted in its last entry. */
+
+/* Number of entries of the table (a power of two) without the last one */
+#define ABTI_STACK_USAGE_NUM_ENTRIES    256
+
+void ABTI_stack_usage_init(void)
+{
+    ABTI_stack_usage_entry *p_entries;
+    int i;
+
+    gp_ABTI_global->p_stack_usage = NULL;
+#ifndef ABT_CONFIG_USE_FCONTEXT
+    /* Stacks are not painted (see ABTI_thread_init_stack()). */
+    gp_ABTI_global->stack_profile = ABT_FALSE;
+#endif
+    if (gp_ABTI_global->stack_profile == ABT_FALSE) return;
+
+    p_entries = (ABTI_stack_usage_entry *)ABTU_malloc(
+            sizeof(ABTI_stack_usage_entry)
+            * (ABTI_STACK_USAGE_NUM_ENTRIES + 1));
+    for (i = 0; i <= ABTI_STACK_USAGE_NUM_ENTRIES; i++) {
+        p_entries[i].func = 0;
+        ABTI_histogram_reset(&p_entries[i].usage);
+    }
+    gp_ABTI_global->p_stack_usage = p_entries;
+}
+
+void ABTI_stack_usage_finalize(void)
+{
+    if (gp_ABTI_global->p_stack_usage == NULL) return;
+    ABTU_free(gp_ABTI_global->p_stack_usage);
+    gp_ABTI_global->p_stack_usage = NULL;
+}
+
+static ABTI_stack_usage_entry *ABTI_stack_usage_get_entry(uint64_t func)
+{
+    ABTI_stack_usage_entry *p_entries = gp_ABTI_global->p_stack_usage;
+    const uint32_t mask = ABTI_STACK_USAGE_NUM_ENTRIES - 1;
+    uint32_t idx = (uint32_t)(((func >> 4) * 0x9E3779B97F4A7C15ULL) >> 32)
+                 & mask;
+    uint32_t i;
+    uint64_t old;
+
+    for (i = 0; i < ABTI_STACK_USAGE_NUM_ENTRIES; i++) {
+        ABTI_stack_usage_entry *p_entry = &p_entries[(idx + i) & mask];
+        old = *(volatile uint64_t *)&p_entry->func;
+        if (old == 0) {
+            old = ABTD_atomic_cas_uint64(&p_entry->func, 0, func);
+        }
+        if (old == 0 || old == func) return p_entry;
+    }
+    return &p_entries[ABTI_STACK_USAGE_NUM_ENTRIES];
+}
+
+/* p_thread, which is running on a painted stack, is terminating */
+void ABTI_stack_usage_record(ABTI_thread *p_thread)
+{
+    uint64_t *p_word = (uint64_t *)p_thread->attr.p_stack;
+    uint64_t *p_top;
+    uint64_t func;
+
+    if (p_word == NULL || p_thread->type != ABTI_THREAD_TYPE_USER) return;
+    if (gp_ABTI_global->p_stack_usage == NULL) return;
+
+    /* The stack is used from the top down, so the first word that is not
+     * painted from the bottom marks the deepest point. */
+    p_top = (uint64_t *)((char *)p_word
+                         + ABTI_mem_get_context_stacksize(p_thread));
+    p_word += ABTI_STACK_CANARY_WORDS;
+    while (p_word < p_top && *p_word == ABTI_STACK_PAINT) p_word++;
+
+    func = (uint64_t)(uintptr_t)ABTD_thread_context_get_func(&p_thread->ctx);
+    ABTI_histogram_add_atomic(&ABTI_stack_usage_get_entry(func)->usage,
+                              (uint64_t)((char *)p_top - (char *)p_word));
+}
+
+/**
+ * @ingroup INFO
+ * @brief   Get the stack usage of ULTs per function.
+ *
+ * \c ABT_info_query_stack_usage() copies to \c entries the histograms of the
+ * stack usage of the ULTs that have terminated since \c ABT_init(), one per
+ * function of the ULTs, and returns the number of functions in
+ * \c num_entries.  At most \c max_entries entries are copied, so this routine
+ * can be called with \c max_entries of zero to get the number first.  A
+ * sample is the distance in bytes from the top of the stack to the deepest
+ * word that the ULT has written, so the stack size of the function should be
+ * larger than the maximum of its histogram.
+ *
+ * The usage is measured only if the environment variable
+ * \c ABT_STACK_PROFILE is set.  The stacks are painted when ULTs are created,
+ * which costs a write of every stack word.  Stacks given by the user are
+ * measured as well.  ULTs that are canceled and the primary ULT are not
+ * counted.
+ *
+ * @param[in]  max_entries  number of elements of \c entries
+ * @param[out] entries      stack usage per function
+ * @param[out] num_entries  number of functions
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA \c ABT_STACK_PROFILE is not set or fcontext is
+ *                            not used
+ */
+int ABT_info_query_stack_usage(int max_entries, ABT_stack_usage *entries,
+                               int *num_entries)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_stack_usage_entry *p_entries;
+    int i, n = 0;
+
+    ABTI_CHECK_INITIALIZED();
+    p_entries = gp_ABTI_global->p_stack_usage;
+    ABTI_CHECK_TRUE(p_entries != NULL, ABT_ERR_FEATURE_NA);
+
+    for (i = 0; i <= ABTI_STACK_USAGE_NUM_ENTRIES; i++) {
+        ABTI_stack_usage_entry *p_entry = &p_entries[i];
+        if (p_entry->usage.count == 0) continue;
+        if (n < max_entries) {
+            entries[n].thread_func =
+                (void (*)(void *))(uintptr_t)p_entry->func;
+            memcpy(&entries[n].usage, &p_entry->usage, sizeof(ABT_histogram));
+        }
+        n++;
+    }
+    *num_entries = n;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup INFO
+ * @brief   Write the stack usage of ULTs per function.
+ *
+ * \c ABT_info_print_stack_usage() writes to \c fp the summaries of the
+ * histograms reported by \c ABT_info_query_stack_usage(), one line per
+ * function.
+ *
+ * @param[in] fp  output stream
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA \c ABT_STACK_PROFILE is not set or fcontext is
+ *                            not used
+ */
+int ABT_info_print_stack_usage(FILE *fp)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_stack_usage_entry *p_entries;
+    int i;
+
+    ABTI_CHECK_INITIALIZED();
+    p_entries = gp_ABTI_global->p_stack_usage;
+    ABTI_CHECK_TRUE(p_entries != NULL, ABT_ERR_FEATURE_NA);
+
+    fprintf(fp, "== Stack usage ==\n");
+    for (i = 0; i <= ABTI_STACK_USAGE_NUM_ENTRIES; i++) {
+        ABTI_stack_usage_entry *p_entry = &p_entries[i];
+        if (p_entry->usage.count == 0) continue;
+        ABTI_profile_print_func(fp, p_entry->func);
+        ABTI_histogram_print(&p_entry->usage, fp, "\n  ", "usage", "B");
+    }
+    fflush(fp);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
@@ -8,6 +8,36 @@
 static uint64_t ABTI_xstream_get_new_rank(void);
 static void ABTI_xstream_return_rank(uint64_t);
 static ABT_bool ABTI_xstream_take_rank(uint64_t);
+static void ABTI_xstream_grow_table(int size);
+static void ABTI_xstream_set_entry(uint64_t rank, ABTI_xstream *p_xstream);
+static int ABTI_xstream_start_context(ABTI_xstream *p_xstream);
+static int ABTI_xstream_join_context(ABTI_xstream *p_xstream);
+static int ABTI_xstream_move_units(ABTI_xstream *p_xstream);
+static int ABTI_xstream_swap_main_sched(ABTI_xstream *p_xstream);
+static ABT_bool ABTI_xstream_park_worker(ABTI_xstream_worker *p_worker);
+static ABT_bool ABTI_xstream_wait_worker(ABTI_xstream_worker *p_worker);
+static int ABTI_xstream_run_work_first(ABTI_xstream *p_xstream);
+static int ABTI_xstream_run_next(ABTI_xstream *p_xstream);
+static int ABTI_xstream_check_events_timed(ABTI_xstream *p_xstream,
+                                          ABT_sched sched);
+static void ABTI_xstream_close_run_next(ABTI_xstream *p_xstream);
+static void ABTI_xstream_bringup_start(ABTI_xstream_bringup *p_bringup,
+                                       int index);
+static ABT_bool ABTI_xstream_bringup_self(ABTI_xstream *p_xstream,
+                                          ABTI_xstream_worker *p_worker);
+
+/* ESs created by ABT_xstream_create_many() start one another's OS threads in
+ * a tree.  ES i starts ESs FANOUT * (i + 1) + k for k in [0, FANOUT), and the
+ * caller starts ESs 0 to FANOUT - 1. */
+#define ABTI_XSTREAM_BRINGUP_FANOUT 4
+
+struct ABTI_xstream_bringup {
+    ABTI_xstream **p_xstreams;
+    int num_xstreams;
+    uint32_t num_remains;       /* ESs that have not finished the bring-up */
+    int32_t abt_errno;          /* First error, or ABT_SUCCESS */
+    ABT_eventual eventual;      /* Set when num_remains becomes zero */
+};
 
 
 /** @defgroup ES Execution Stream (ES)
@@ -61,6 +91,9 @@ int ABT_xstream_create(ABT_sched sched, ABT_xstream *newxstream)
     goto fn_exit;
 }
 
+/* Create a secondary ES.  If p_sched is NULL, the ES is neither given a main
+ * scheduler nor added to the global ES array; ABTI_xstream_bringup_self()
+ * does both on the OS thread of the ES. */
 int ABTI_xstream_create(ABTI_sched *p_sched, ABTI_xstream **pp_xstream)
 {
     int abt_errno = ABT_SUCCESS;
@@ -73,7 +106,8 @@ int ABTI_xstream_create(ABTI_sched *p_sched, ABTI_xstream **pp_xstream)
         goto fn_fail;
     }
 
-    p_newxstream = (ABTI_xstream *)ABTU_malloc(sizeof(ABTI_xstream));
+    p_newxstream = (ABTI_xstream *)
+        ABTU_malloc_cache_aligned(sizeof(ABTI_xstream));
 
     /* Create a wrapper unit */
     ABTI_elem_create_from_xstream(p_newxstream);
@@ -86,24 +120,68 @@ int ABTI_xstream_create(ABTI_sched *p_sched, ABTI_xstream **pp_xstream)
     p_newxstream->max_scheds   = 0;
     p_newxstream->request      = 0;
     p_newxstream->p_req_arg    = NULL;
+    p_newxstream->p_join_eventual = NULL;
+    p_newxstream->p_swap_sched = NULL;
     p_newxstream->p_main_sched = NULL;
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    p_newxstream->num_remote_frees = 0;
+    p_newxstream->p_local = NULL;
+#endif
 
     /* Create the spinlock */
     ABTI_spinlock_create(&p_newxstream->sched_lock);
+    ABTI_timer_wheel_init(&p_newxstream->timer_wheel);
+    ABTI_io_poller_init(&p_newxstream->io_poller);
+    ABTI_mpi_poller_init(&p_newxstream->mpi_poller);
+    ABTI_spinlock_create(&p_newxstream->poll_hook_lock);
+    p_newxstream->num_poll_hooks = 0;
+    p_newxstream->max_poll_hooks = 0;
+    p_newxstream->poll_hooks = NULL;
+    p_newxstream->num_thread_runs = 0;
+    p_newxstream->num_fast_yields = 0;
+    p_newxstream->p_work_first = NULL;
+    p_newxstream->p_run_next = ABTI_XSTREAM_RUN_NEXT_CLOSED;
+    p_newxstream->thread_id_next = 0;
+    ABTI_spinlock_create(&p_newxstream->os_lock);
+    p_newxstream->os_tid = 0;
+    p_newxstream->os_policy = ABT_XSTREAM_OS_POLICY_OTHER;
+    p_newxstream->os_priority = 0;
+    p_newxstream->core_class = ABT_CORE_CLASS_PERF;
+    p_newxstream->thread_id_end = 0;
+    p_newxstream->task_id_next = 0;
+    p_newxstream->task_id_end = 0;
+    memset(&p_newxstream->stats, 0, sizeof(ABT_xstream_stats));
+    ABTI_trace_xstream_init(p_newxstream);
+    ABTI_profile_xstream_init(p_newxstream);
+    ABTI_record_xstream_init(p_newxstream);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    p_newxstream->p_unit_stats = (gp_ABTI_global->use_unit_stats == ABT_TRUE)
+                               ? ABTI_unit_stats_create() : NULL;
+#endif
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_newxstream->cpu_time_ticks = 0;
+#endif
+    p_newxstream->ctx_released = 0;
+    p_newxstream->ctx_parked = ABT_FALSE;
+    p_newxstream->preempt_runs = 0;
+    p_newxstream->preemptive = ABT_FALSE;
+    p_newxstream->p_bringup = NULL;
+    p_newxstream->bringup_index = 0;
+
+    LOG_EVENT("[E%" PRIu64 "] created\n", p_newxstream->rank);
+    p_newxstream->snapshot.seq = 0;
+    *pp_xstream = p_newxstream;
+    if (p_sched == NULL) goto fn_exit;
 
     /* Set the main scheduler */
     abt_errno = ABTI_xstream_set_main_sched(p_newxstream, p_sched);
     ABTI_CHECK_ERROR(abt_errno);
-
-    LOG_EVENT("[E%" PRIu64 "] created\n", p_newxstream->rank);
+    ABTI_xstream_publish(p_newxstream, ABT_get_wtime());
 
     /* Add this ES to the global ES array */
-    gp_ABTI_global->p_xstreams[rank] = p_newxstream;
+    ABTI_xstream_set_entry(rank, p_newxstream);
     ABTD_atomic_fetch_add_int32(&gp_ABTI_global->num_xstreams, 1);
 
-    /* Return value */
-    *pp_xstream = p_newxstream;
-
   fn_exit:
     return abt_errno;
 
@@ -196,8 +274,7 @@ int ABT_xstream_create_with_rank(ABT_sched sched, int rank,
     ABTI_xstream *p_newxstream;
     ABTI_sched *p_sched;
 
-    if (gp_ABTI_global->p_xstreams[rank] ||
-        ABTI_xstream_take_rank(rank) == ABT_FALSE) {
+    if (rank < 0 || ABTI_xstream_take_rank(rank) == ABT_FALSE) {
         abt_errno = ABT_ERR_INV_XSTREAM_RANK;
         goto fn_fail;
     }
@@ -213,7 +290,8 @@ int ABT_xstream_create_with_rank(ABT_sched sched, int rank,
                         ABT_ERR_INV_SCHED);
     }
 
-    p_newxstream = (ABTI_xstream *)ABTU_malloc(sizeof(ABTI_xstream));
+    p_newxstream = (ABTI_xstream *)
+        ABTU_malloc_cache_aligned(sizeof(ABTI_xstream));
 
     /* Create a wrapper unit */
     ABTI_elem_create_from_xstream(p_newxstream);
@@ -226,19 +304,64 @@ int ABT_xstream_create_with_rank(ABT_sched sched, int rank,
     p_newxstream->max_scheds   = 0;
     p_newxstream->request      = 0;
     p_newxstream->p_req_arg    = NULL;
+    p_newxstream->p_join_eventual = NULL;
+    p_newxstream->p_swap_sched = NULL;
     p_newxstream->p_main_sched = NULL;
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    p_newxstream->num_remote_frees = 0;
+    p_newxstream->p_local = NULL;
+#endif
 
     /* Create the spinlock */
     ABTI_spinlock_create(&p_newxstream->sched_lock);
+    ABTI_timer_wheel_init(&p_newxstream->timer_wheel);
+    ABTI_io_poller_init(&p_newxstream->io_poller);
+    ABTI_mpi_poller_init(&p_newxstream->mpi_poller);
+    ABTI_spinlock_create(&p_newxstream->poll_hook_lock);
+    p_newxstream->num_poll_hooks = 0;
+    p_newxstream->max_poll_hooks = 0;
+    p_newxstream->poll_hooks = NULL;
+    p_newxstream->num_thread_runs = 0;
+    p_newxstream->num_fast_yields = 0;
+    p_newxstream->p_work_first = NULL;
+    p_newxstream->p_run_next = ABTI_XSTREAM_RUN_NEXT_CLOSED;
+    p_newxstream->thread_id_next = 0;
+    ABTI_spinlock_create(&p_newxstream->os_lock);
+    p_newxstream->os_tid = 0;
+    p_newxstream->os_policy = ABT_XSTREAM_OS_POLICY_OTHER;
+    p_newxstream->os_priority = 0;
+    p_newxstream->core_class = ABT_CORE_CLASS_PERF;
+    p_newxstream->thread_id_end = 0;
+    p_newxstream->task_id_next = 0;
+    p_newxstream->task_id_end = 0;
+    memset(&p_newxstream->stats, 0, sizeof(ABT_xstream_stats));
+    ABTI_trace_xstream_init(p_newxstream);
+    ABTI_profile_xstream_init(p_newxstream);
+    ABTI_record_xstream_init(p_newxstream);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    p_newxstream->p_unit_stats = (gp_ABTI_global->use_unit_stats == ABT_TRUE)
+                               ? ABTI_unit_stats_create() : NULL;
+#endif
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_newxstream->cpu_time_ticks = 0;
+#endif
+    p_newxstream->ctx_released = 0;
+    p_newxstream->ctx_parked = ABT_FALSE;
+    p_newxstream->preempt_runs = 0;
+    p_newxstream->preemptive = ABT_FALSE;
+    p_newxstream->p_bringup = NULL;
+    p_newxstream->bringup_index = 0;
 
     /* Set the main scheduler */
     abt_errno = ABTI_xstream_set_main_sched(p_newxstream, p_sched);
     ABTI_CHECK_ERROR(abt_errno);
 
     LOG_EVENT("[E%" PRIu64 "] created\n", p_newxstream->rank);
+    p_newxstream->snapshot.seq = 0;
+    ABTI_xstream_publish(p_newxstream, ABT_get_wtime());
 
     /* Add this ES to the global ES array */
-    gp_ABTI_global->p_xstreams[rank] = p_newxstream;
+    ABTI_xstream_set_entry(rank, p_newxstream);
     ABTD_atomic_fetch_add_int32(&gp_ABTI_global->num_xstreams, 1);
 
     /* Start this ES */
@@ -257,6 +380,106 @@ int ABT_xstream_create_with_rank(ABT_sched sched, int rank,
     goto fn_exit;
 }
 
+/**
+ * @ingroup ES
+ * @brief   Create many ESs in parallel.
+ *
+ * \c ABT_xstream_create_many() creates \c num_xstreams ESs, each with the
+ * runtime-provided scheduler as \c ABT_xstream_create() with
+ * \c ABT_SCHED_NULL does, and returns their handles through \c newxstreams.
+ * It returns when all the ESs have their main schedulers.
+ *
+ * The OS threads are started in a tree: the caller starts the first four,
+ * and each new ES starts up to four others before it initializes itself, so
+ * the bring-up takes a time logarithmic in \c num_xstreams.  Each ES binds
+ * itself to its CPU (see \c ABT_SET_AFFINITY) and then creates its scheduler
+ * and pools, whose memory is thus touched first on the NUMA node of the ES.
+ *
+ * If any ES cannot be created, the ESs created so far are joined and freed,
+ * and all the handles are set to \c ABT_XSTREAM_NULL.
+ *
+ * @param[in]  num_xstreams  the number of ESs to create
+ * @param[out] newxstreams   handles to the new ESs
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_xstream_create_many(int num_xstreams, ABT_xstream *newxstreams)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream_bringup *p_bringup;
+    ABTI_xstream **p_xstreams;
+    ABT_xstream h_xstream;
+    int i, num_created;
+
+    ABTI_CHECK_INITIALIZED();
+    if (num_xstreams <= 0) goto fn_exit;
+
+    p_xstreams = (ABTI_xstream **)
+        ABTU_malloc(num_xstreams * sizeof(ABTI_xstream *));
+    p_bringup = (ABTI_xstream_bringup *)
+        ABTU_malloc(sizeof(ABTI_xstream_bringup));
+    p_bringup->p_xstreams = p_xstreams;
+    p_bringup->num_xstreams = num_xstreams;
+    p_bringup->num_remains = (uint32_t)num_xstreams;
+    p_bringup->abt_errno = ABT_SUCCESS;
+    abt_errno = ABT_eventual_create(0, &p_bringup->eventual);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_bringup);
+        ABTU_free(p_xstreams);
+        goto fn_fail;
+    }
+
+    /* Only the objects are created here, which is cheap. */
+    for (num_created = 0; num_created < num_xstreams; num_created++) {
+        ABTI_xstream *p_xstream;
+        abt_errno = ABTI_xstream_create(NULL, &p_xstream);
+        if (abt_errno != ABT_SUCCESS) break;
+        p_xstream->p_bringup = p_bringup;
+        p_xstream->bringup_index = num_created;
+        p_xstreams[num_created] = p_xstream;
+    }
+
+    if (num_created == num_xstreams) {
+        for (i = 0; i < ABTI_XSTREAM_BRINGUP_FANOUT && i < num_xstreams; i++) {
+            ABTI_xstream_bringup_start(p_bringup, i);
+        }
+        abt_errno = ABT_eventual_wait(p_bringup->eventual, NULL);
+        if (abt_errno == ABT_SUCCESS) abt_errno = p_bringup->abt_errno;
+    }
+    ABT_eventual_free(&p_bringup->eventual);
+    ABTU_free(p_bringup);
+
+    for (i = 0; i < num_created; i++) {
+        ABTI_xstream *p_xstream = p_xstreams[i];
+        h_xstream = ABTI_xstream_get_handle(p_xstream);
+        if (abt_errno == ABT_SUCCESS) {
+            newxstreams[i] = h_xstream;
+            continue;
+        }
+
+        /* An ES that has not set its main scheduler is not in the global
+         * ES array yet. */
+        if (p_xstream->p_main_sched == NULL) {
+            ABTI_xstream_set_entry(p_xstream->rank, p_xstream);
+            ABTD_atomic_fetch_add_int32(&gp_ABTI_global->num_xstreams, 1);
+        }
+        ABT_xstream_join(h_xstream);
+        ABT_xstream_free(&h_xstream);
+    }
+    ABTU_free(p_xstreams);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    for (i = 0; i < num_xstreams; i++) {
+        newxstreams[i] = ABT_XSTREAM_NULL;
+    }
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup ES
  * @brief   Start the target ES.
@@ -299,6 +522,7 @@ int ABTI_xstream_start(ABTI_xstream *p_xstream)
 
     /* Add the main scheduler to the stack of schedulers */
     ABTI_xstream_push_sched(p_xstream, p_xstream->p_main_sched);
+    ABTI_xstream_publish(p_xstream, ABT_get_wtime());
 
     if (p_xstream->type == ABTI_XSTREAM_TYPE_PRIMARY) {
         LOG_EVENT("[E%" PRIu64 "] start\n", p_xstream->rank);
@@ -313,15 +537,14 @@ int ABTI_xstream_start(ABTI_xstream *p_xstream)
 
     } else {
         /* Start the main scheduler on a different ES */
-        abt_errno = ABTD_xstream_context_create(
-                ABTI_xstream_launch_main_sched, (void *)p_xstream,
-                &p_xstream->ctx);
-        ABTI_CHECK_ERROR_MSG(abt_errno, "ABTD_xstream_context_create");
+        abt_errno = ABTI_xstream_start_context(p_xstream);
+        ABTI_CHECK_ERROR_MSG(abt_errno, "ABTI_xstream_start_context");
     }
 
     /* Set the CPU affinity for the ES */
     if (gp_ABTI_global->set_affinity == ABT_TRUE) {
         ABTD_affinity_set(p_xstream->ctx, p_xstream->rank);
+        ABTI_xstream_update_core_class(p_xstream);
     }
 
   fn_exit:
@@ -346,6 +569,7 @@ int ABTI_xstream_start_primary(ABTI_xstream *p_xstream, ABTI_thread *p_thread)
     /* Set the ES's state to READY.  The ES's state will be set to RUNNING in
      * ABTI_xstream_schedule(). */
     p_xstream->state = ABT_XSTREAM_STATE_READY;
+    ABTI_xstream_publish(p_xstream, ABT_get_wtime());
 
     LOG_EVENT("[E%" PRIu64 "] start\n", p_xstream->rank);
 
@@ -355,6 +579,7 @@ int ABTI_xstream_start_primary(ABTI_xstream *p_xstream, ABTI_thread *p_thread)
     /* Set the CPU affinity for the ES */
     if (gp_ABTI_global->set_affinity == ABT_TRUE) {
         ABTD_affinity_set(p_xstream->ctx, p_xstream->rank);
+        ABTI_xstream_update_core_class(p_xstream);
     }
 
     /* Create the main sched ULT */
@@ -362,6 +587,10 @@ int ABTI_xstream_start_primary(ABTI_xstream *p_xstream, ABTI_thread *p_thread)
     abt_errno = ABTI_thread_create_main_sched(p_xstream, p_sched);
     ABTI_CHECK_ERROR(abt_errno);
 
+    ABTI_xstream_start_preempt(p_xstream);
+    ABTI_xstream_start_os_priority(p_xstream);
+    ABTI_profile_start(p_xstream);
+
     /* Start the scheduler by context switching to it */
     LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] yield\n",
               ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
@@ -413,14 +642,16 @@ int ABT_xstream_free(ABT_xstream *xstream)
                         ABT_ERR_INV_XSTREAM,
                         "The primary xstream cannot be freed explicitly.");
 
-    /* If the xstream is running, wait until it terminates */
-    if (p_xstream->state == ABT_XSTREAM_STATE_RUNNING) {
+    /* If the xstream is running or its asynchronous join has not been
+     * completed, wait until it terminates */
+    if (p_xstream->state == ABT_XSTREAM_STATE_RUNNING ||
+        p_xstream->p_join_eventual != NULL) {
         abt_errno = ABT_xstream_join(h_xstream);
         ABTI_CHECK_ERROR(abt_errno);
     }
 
     /* Remove this xstream from the global ES array */
-    gp_ABTI_global->p_xstreams[p_xstream->rank] = NULL;
+    ABTI_xstream_set_entry(p_xstream->rank, NULL);
     ABTD_atomic_fetch_sub_int32(&gp_ABTI_global->num_xstreams, 1);
 
     /* Free the xstream object */
@@ -506,13 +737,13 @@ int ABT_xstream_join(ABT_xstream xstream)
         ABTI_thread_set_blocked(p_thread);
 
         /* Set the join request */
-        ABTD_atomic_fetch_or_uint32(&p_xstream->request, ABTI_XSTREAM_REQ_JOIN);
+        ABTI_xstream_set_request(p_xstream, ABTI_XSTREAM_REQ_JOIN);
 
         /* If the caller is a ULT, it is blocked here */
         ABTI_thread_suspend(p_thread);
     } else {
         /* Set the join request */
-        ABTD_atomic_fetch_or_uint32(&p_xstream->request, ABTI_XSTREAM_REQ_JOIN);
+        ABTI_xstream_set_request(p_xstream, ABTI_XSTREAM_REQ_JOIN);
 
         while (p_xstream->state != ABT_XSTREAM_STATE_TERMINATED) {
             ABT_thread_yield();
@@ -521,13 +752,94 @@ int ABT_xstream_join(ABT_xstream xstream)
 
   fn_join:
     /* Normal join request */
-    abt_errno = ABTD_xstream_context_join(p_xstream->ctx);
-    ABTI_CHECK_ERROR_MSG(abt_errno, "ABTD_xstream_context_join");
+    abt_errno = ABTI_xstream_join_context(p_xstream);
+    ABTI_CHECK_ERROR_MSG(abt_errno, "ABTI_xstream_join_context");
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ES
+ * @brief   Request the termination of the ES without waiting for it.
+ *
+ * \c ABT_xstream_join_async() makes the ES \c xstream terminate like
+ * \c ABT_xstream_join() but returns immediately.  It creates a new eventual
+ * whose size is zero and returns it through \c eventual.  The eventual is set
+ * once \c xstream has terminated, so many ESs can be shut down at the same
+ * time by waiting for their eventuals afterwards.  The caller has to free the
+ * eventual and then \c xstream with \c ABT_xstream_free(), which completes
+ * the join.
+ *
+ * If \c migrate is \c ABT_FALSE, \c xstream terminates after it has
+ * executed all the work units in the pools of its main scheduler.  Otherwise,
+ * \c xstream stops running them and moves them to the first main pools of
+ * the other running ESs in turn, which is much faster when many work units
+ * are queued.  Only pools that are not shared with other schedulers are
+ * emptied, and only pools of the multiple-producer access types
+ * (\c ABT_POOL_ACCESS_MPSC and \c ABT_POOL_ACCESS_MPMC) receive the work
+ * units.  The ULTs blocked in the pools of \c xstream are moved once they
+ * become ready.  If no ES can receive them, \c xstream executes the work
+ * units as if \c migrate were \c ABT_FALSE.
+ *
+ * @param[in]  xstream   handle to the target ES
+ * @param[in]  migrate   whether the remaining work units are moved to other
+ *                       ESs
+ * @param[out] eventual  handle to a new eventual set when \c xstream has
+ *                       terminated
+ * @return Error code
+ * @retval ABT_SUCCESS         on success
+ * @retval ABT_ERR_INV_XSTREAM \c xstream is the primary ES or is already
+ *                             being joined asynchronously
+ */
+int ABT_xstream_join_async(ABT_xstream xstream, ABT_bool migrate,
+                           ABT_eventual *eventual)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABT_eventual h_eventual = ABT_EVENTUAL_NULL;
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    ABTI_CHECK_TRUE_MSG(p_xstream->type != ABTI_XSTREAM_TYPE_PRIMARY,
+                        ABT_ERR_INV_XSTREAM,
+                        "The primary ES cannot be joined.");
+    ABTI_CHECK_TRUE_MSG(p_xstream->p_join_eventual == NULL,
+                        ABT_ERR_INV_XSTREAM,
+                        "The ES is already being joined.");
+
+    abt_errno = ABT_eventual_create(0, &h_eventual);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* An ES that has not started terminates here. */
+    if (p_xstream->state == ABT_XSTREAM_STATE_TERMINATED ||
+        (p_xstream->state == ABT_XSTREAM_STATE_CREATED &&
+         ABTD_atomic_cas_int32((int32_t *)&p_xstream->state,
+                               ABT_XSTREAM_STATE_CREATED,
+                               ABT_XSTREAM_STATE_TERMINATED)
+         == ABT_XSTREAM_STATE_CREATED)) {
+        abt_errno = ABT_eventual_set(h_eventual, NULL, 0);
+        ABTI_CHECK_ERROR(abt_errno);
+        goto fn_exit;
+    }
+
+    /* The ES sets the eventual when it terminates.  The eventual has to be
+     * visible before the request. */
+    p_xstream->p_join_eventual = ABTI_eventual_get_ptr(h_eventual);
+    ABTD_atomic_mem_barrier();
+    ABTI_xstream_set_request(p_xstream, migrate == ABT_TRUE
+                             ? ABTI_XSTREAM_REQ_JOIN | ABTI_XSTREAM_REQ_MIGRATE
+                             : ABTI_XSTREAM_REQ_JOIN);
 
   fn_exit:
+    *eventual = h_eventual;
     return abt_errno;
 
   fn_fail:
+    if (h_eventual != ABT_EVENTUAL_NULL) ABT_eventual_free(&h_eventual);
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
     goto fn_exit;
 }
 
@@ -622,6 +934,7 @@ int ABT_xstream_cancel(ABT_xstream xstream)
 int ABT_xstream_self(ABT_xstream *xstream)
 {
     int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
 
     /* In case that Argobots has not been initialized or this routine is called
      * by an external thread, e.g., pthread, return an error code instead of
@@ -631,13 +944,13 @@ int ABT_xstream_self(ABT_xstream *xstream)
         *xstream = ABT_XSTREAM_NULL;
         goto fn_exit;
     }
-    if (lp_ABTI_local == NULL) {
+    if (p_local == NULL) {
         abt_errno = ABT_ERR_INV_XSTREAM;
         *xstream = ABT_XSTREAM_NULL;
         goto fn_exit;
     }
 
-    ABTI_xstream *p_xstream = ABTI_local_get_xstream();
+    ABTI_xstream *p_xstream = p_local->p_xstream;
     ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
 
     /* Return value */
@@ -707,10 +1020,12 @@ int ABT_xstream_set_rank(ABT_xstream xstream, const int rank)
     ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
 
     p_xstream->rank = (uint64_t)rank;
+    ABTI_xstream_publish(p_xstream, ABT_get_wtime());
 
     /* Set the CPU affinity for the ES */
     if (gp_ABTI_global->set_affinity == ABT_TRUE) {
         ABTD_affinity_set(p_xstream->ctx, p_xstream->rank);
+        ABTI_xstream_update_core_class(p_xstream);
     }
 
   fn_exit:
@@ -800,7 +1115,8 @@ int ABT_xstream_set_main_sched(ABT_xstream xstream, ABT_sched sched)
     if (p_xstream->p_main_sched) {
         /* We only allow to change the main scheduler when the current main
          * scheduler of p_xstream has no work unit in its associated pools. */
-        if (ABTI_sched_get_effective_size(p_xstream->p_main_sched) > 0) {
+        if (ABTI_sched_is_quiescent(p_xstream->p_main_sched, p_xstream)
+            == ABT_FALSE) {
             abt_errno = ABT_ERR_XSTREAM;
             goto fn_fail;
         }
@@ -866,6 +1182,121 @@ int ABT_xstream_set_main_sched_basic(ABT_xstream xstream,
     goto fn_exit;
 }
 
+/**
+ * @ingroup ES
+ * @brief   Replace the main scheduler of a running ES.
+ *
+ * \c ABT_xstream_swap_main_sched() makes the ES \c xstream replace its main
+ * scheduler with \c sched the next time the current main scheduler checks
+ * events, e.g., to switch from the basic scheduler to the random work-stealing
+ * one under load imbalance.  Unlike \c ABT_xstream_set_main_sched(), it can
+ * be called by any ULT or external thread, it returns without waiting for the
+ * replacement, and the pools may have work units in them.  The work units stay
+ * where they are, so \c sched usually takes over the pools of the current main
+ * scheduler (see \c ABT_xstream_swap_main_sched_basic()).  Units left in the
+ * pools that \c sched does not use are executed only by the other schedulers
+ * of those pools.
+ *
+ * The old main scheduler is freed if it has been created with the automatic
+ * flag, and otherwise it can be freed or used again by the user after the
+ * replacement.  \c ABT_xstream_get_main_sched() returns \c sched once the
+ * replacement has been done.
+ *
+ * @param[in] xstream  handle to the target ES
+ * @param[in] sched    handle to the new main scheduler
+ * @return Error code
+ * @retval ABT_SUCCESS           on success
+ * @retval ABT_ERR_INV_SCHED     \c sched is already used
+ * @retval ABT_ERR_XSTREAM_STATE \c xstream is not running or another
+ *                               replacement is pending
+ */
+int ABT_xstream_swap_main_sched(ABT_xstream xstream, ABT_sched sched)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+
+    ABTI_CHECK_TRUE(p_xstream->state == ABT_XSTREAM_STATE_RUNNING ||
+                    p_xstream->state == ABT_XSTREAM_STATE_READY,
+                    ABT_ERR_XSTREAM_STATE);
+    ABTI_CHECK_TRUE(ABTD_atomic_cas_int32((int32_t *)&p_sched->used,
+                                          ABTI_SCHED_NOT_USED,
+                                          ABTI_SCHED_MAIN)
+                    == ABTI_SCHED_NOT_USED, ABT_ERR_INV_SCHED);
+
+    /* The main scheduler will to be a ULT, not a tasklet */
+    p_sched->type = ABT_SCHED_TYPE_ULT;
+
+    if (ABTD_atomic_cas_uint64((uint64_t *)&p_xstream->p_swap_sched, 0,
+                               (uint64_t)(uintptr_t)p_sched) != 0) {
+        p_sched->used = ABTI_SCHED_NOT_USED;
+        abt_errno = ABT_ERR_XSTREAM_STATE;
+        goto fn_fail;
+    }
+    ABTI_xstream_set_request(p_xstream, ABTI_XSTREAM_REQ_SWAP);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ES
+ * @brief   Replace the main scheduler of a running ES with a predefined one.
+ *
+ * \c ABT_xstream_swap_main_sched_basic() creates a predefined scheduler of
+ * type \c predef over the pools of the current main scheduler of \c xstream
+ * and makes \c xstream switch to it.  See \c ABT_xstream_swap_main_sched()
+ * for more details.
+ *
+ * @param[in] xstream  handle to the target ES
+ * @param[in] predef   predefined scheduler
+ * @return Error code
+ * @retval ABT_SUCCESS           on success
+ * @retval ABT_ERR_XSTREAM_STATE \c xstream is not running or another
+ *                               replacement is pending
+ */
+int ABT_xstream_swap_main_sched_basic(ABT_xstream xstream,
+                                      ABT_sched_predef predef)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABT_sched sched = ABT_SCHED_NULL;
+    ABT_pool *pools = NULL;
+    int num_pools;
+
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    /* The lock keeps the main scheduler from being replaced meanwhile. */
+    ABTI_spinlock_acquire(&p_xstream->sched_lock);
+    num_pools = p_xstream->p_main_sched->num_pools;
+    pools = (ABT_pool *)ABTU_malloc(num_pools * sizeof(ABT_pool));
+    memcpy(pools, p_xstream->p_main_sched->pools,
+           num_pools * sizeof(ABT_pool));
+    ABTI_spinlock_release(&p_xstream->sched_lock);
+
+    abt_errno = ABT_sched_create_basic(predef, num_pools, pools,
+                                       ABT_SCHED_CONFIG_NULL, &sched);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    abt_errno = ABT_xstream_swap_main_sched(xstream, sched);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    if (pools) ABTU_free(pools);
+    return abt_errno;
+
+  fn_fail:
+    if (sched != ABT_SCHED_NULL) ABT_sched_free(&sched);
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup ES
  * @brief   Get the main scheduler of the target ES.
@@ -1080,18 +1511,55 @@ int ABTI_xstream_run_unit(ABTI_xstream *p_xstream, ABT_unit unit,
 
     ABTI_LOG_SET_SCHED(ABTI_xstream_get_top_sched(p_xstream));
 
-    ABT_unit_type type = p_pool->u_get_type(unit);
+    ABT_unit_type type = ABTI_pool_unit_get_type(p_pool, unit);
 
+    p_xstream->stats.num_units++;
     if (type == ABT_UNIT_TYPE_THREAD) {
-        ABT_thread thread = p_pool->u_get_thread(unit);
-        ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+        ABTI_thread *p_thread = ABTI_pool_unit_get_thread(p_pool, unit);
+        /* A gang member starts only together with the other members.  Once
+         * it has run, i.e., it has a last ES, it is resumed by itself. */
+        if (p_thread->attr.p_gang != NULL && p_thread->p_last_xstream == NULL &&
+            ABTI_gang_dispatch(p_thread->attr.p_gang) == ABT_FALSE) {
+            p_xstream->stats.num_units--;
+            abt_errno = ABT_pool_push(ABTI_pool_get_handle(p_thread->p_pool),
+                                      unit);
+            ABTI_CHECK_ERROR(abt_errno);
+            goto fn_exit;
+        }
+        p_xstream->stats.num_threads++;
+        ABTI_record_thread(p_xstream, p_pool, p_thread);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+        if (gp_ABTI_global->use_unit_stats == ABT_TRUE) {
+            ABTI_unit_stats_add_delay(p_xstream, p_pool, p_thread->push_ticks);
+        }
+#endif
         /* Switch the context */
         abt_errno = ABTI_xstream_schedule_thread(p_xstream, p_thread);
         ABTI_CHECK_ERROR(abt_errno);
 
+        abt_errno = ABTI_xstream_run_work_first(p_xstream);
+        ABTI_CHECK_ERROR(abt_errno);
+
     } else if (type == ABT_UNIT_TYPE_TASK) {
-        ABT_task task = p_pool->u_get_task(unit);
-        ABTI_task *p_task = ABTI_task_get_ptr(task);
+        ABTI_task *p_task = ABTI_pool_unit_get_task(p_pool, unit);
+#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+        /* An idle inline nested scheduler is put back without running it. */
+        if (p_task->is_sched != NULL &&
+            ABTI_sched_is_idle_inline(p_task->is_sched, p_xstream) == ABT_TRUE) {
+            p_xstream->stats.num_units--;
+            abt_errno = ABT_pool_push(ABTI_pool_get_handle(p_task->p_pool),
+                                      unit);
+            ABTI_CHECK_ERROR(abt_errno);
+            goto fn_exit;
+        }
+#endif
+        p_xstream->stats.num_tasks++;
+        ABTI_record_task(p_xstream, p_pool, p_task);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+        if (gp_ABTI_global->use_unit_stats == ABT_TRUE) {
+            ABTI_unit_stats_add_delay(p_xstream, p_pool, p_task->push_ticks);
+        }
+#endif
         /* Execute the task */
         ABTI_xstream_schedule_task(p_xstream, p_task);
 
@@ -1100,6 +1568,15 @@ int ABTI_xstream_run_unit(ABTI_xstream *p_xstream, ABT_unit unit,
         ABTI_CHECK_TRUE(0, ABT_ERR_INV_UNIT);
     }
 
+    /* Tasklets batched by the unit are pushed once it returns. */
+    if (lp_ABTI_local->p_task_batch) {
+        ABTI_task_flush_batch(lp_ABTI_local);
+    }
+
+    /* The ULT in the run-next slot runs before the next unit. */
+    abt_errno = ABTI_xstream_run_next(p_xstream);
+    ABTI_CHECK_ERROR(abt_errno);
+
   fn_exit:
     return abt_errno;
 
@@ -1152,25 +1629,65 @@ int ABTI_xstream_check_events(ABTI_xstream *p_xstream, ABT_sched sched)
 {
     int abt_errno = ABT_SUCCESS;
 
-    if (p_xstream->request & ABTI_XSTREAM_REQ_JOIN) {
-        abt_errno = ABT_sched_finish(sched);
-        ABTI_CHECK_ERROR(abt_errno);
-    }
+    /* Run the ULT in the run-next slot while the scheduler has found nothing
+     * to run.  This does not count as checking events. */
+    abt_errno = ABTI_xstream_run_next(p_xstream);
+    ABTI_CHECK_ERROR(abt_errno);
 
-    if ((p_xstream->request & ABTI_XSTREAM_REQ_EXIT) ||
-        (p_xstream->request & ABTI_XSTREAM_REQ_CANCEL)) {
-        abt_errno = ABT_sched_exit(sched);
-        ABTI_CHECK_ERROR(abt_errno);
-    }
+    abt_errno = ABTI_xstream_check_events_timed(p_xstream, sched);
+    ABTI_CHECK_ERROR(abt_errno);
 
-    // TODO: check event queue
-#ifdef ABT_CONFIG_HANDLE_POWER_EVENT
-    if (ABTI_event_check_power() == ABT_TRUE) {
-        abt_errno = ABT_sched_exit(sched);
-        ABTI_CHECK_ERROR(abt_errno);
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup ES
+ * @brief   Register a poll hook on the ES.
+ *
+ * \c ABT_xstream_add_poll_hook() makes the scheduler of the ES \c xstream
+ * call \c fn(arg) once every \c period times it checks events, i.e., calls
+ * \c ABT_xstream_check_events(), which all the predefined schedulers do
+ * periodically.  A \c period of zero is treated as one.  The same pair of
+ * \c fn and \c arg can be registered more than once.
+ *
+ * \c fn runs on the scheduler of \c xstream, so it must not block.  It may
+ * add and remove hooks, including itself.
+ *
+ * @param[in] xstream  handle to the target ES
+ * @param[in] fn       function to call
+ * @param[in] arg      argument for \c fn
+ * @param[in] period   number of event checks between two calls
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_xstream_add_poll_hook(ABT_xstream xstream, void (*fn)(void *),
+                              void *arg, uint32_t period)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_poll_hook *p_hook;
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    ABTI_spinlock_acquire(&p_xstream->poll_hook_lock);
+    if (p_xstream->num_poll_hooks == p_xstream->max_poll_hooks) {
+        int n = p_xstream->max_poll_hooks ? p_xstream->max_poll_hooks * 2 : 4;
+        p_xstream->poll_hooks = (ABTI_poll_hook *)
+            ABTU_realloc(p_xstream->poll_hooks, sizeof(ABTI_poll_hook) * n);
+        p_xstream->max_poll_hooks = n;
     }
-#endif
-    ABTI_EVENT_PUBLISH_INFO();
+    p_hook = &p_xstream->poll_hooks[p_xstream->num_poll_hooks];
+    p_hook->fn = fn;
+    p_hook->arg = arg;
+    p_hook->period = (period == 0) ? 1 : period;
+    p_hook->count = 0;
+    p_xstream->num_poll_hooks++;
+    ABTI_spinlock_release(&p_xstream->poll_hook_lock);
 
   fn_exit:
     return abt_errno;
@@ -1180,6 +1697,51 @@ int ABTI_xstream_check_events(ABTI_xstream *p_xstream, ABT_sched sched)
     goto fn_exit;
 }
 
+/**
+ * @ingroup ES
+ * @brief   Unregister a poll hook from the ES.
+ *
+ * \c ABT_xstream_remove_poll_hook() removes a poll hook of \c fn and \c arg
+ * registered on the ES \c xstream by \c ABT_xstream_add_poll_hook().  If it
+ * has been registered more than once, only one registration is removed.
+ *
+ * @param[in] xstream  handle to the target ES
+ * @param[in] fn       function of the hook
+ * @param[in] arg      argument of the hook
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_XSTREAM the hook is not registered on \c xstream
+ */
+int ABT_xstream_remove_poll_hook(ABT_xstream xstream, void (*fn)(void *),
+                                 void *arg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    int i;
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    ABTI_spinlock_acquire(&p_xstream->poll_hook_lock);
+    for (i = 0; i < p_xstream->num_poll_hooks; i++) {
+        ABTI_poll_hook *p_hook = &p_xstream->poll_hooks[i];
+        if (p_hook->fn == fn && p_hook->arg == arg) break;
+    }
+    if (i == p_xstream->num_poll_hooks) {
+        ABTI_spinlock_release(&p_xstream->poll_hook_lock);
+        abt_errno = ABT_ERR_XSTREAM;
+        goto fn_fail;
+    }
+    p_xstream->num_poll_hooks--;
+    memmove(&p_xstream->poll_hooks[i], &p_xstream->poll_hooks[i + 1],
+            sizeof(ABTI_poll_hook) * (p_xstream->num_poll_hooks - i));
+    ABTI_spinlock_release(&p_xstream->poll_hook_lock);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
 
 /**
  * @ingroup ES
@@ -1202,6 +1764,7 @@ int ABT_xstream_set_cpubind(ABT_xstream xstream, int cpuid)
 
     abt_errno = ABTD_affinity_set_cpuset(p_xstream->ctx, 1, &cpuid);
     ABTI_CHECK_ERROR(abt_errno);
+    ABTI_xstream_update_core_class(p_xstream);
 
   fn_exit:
     return abt_errno;
@@ -1263,6 +1826,7 @@ int ABT_xstream_set_affinity(ABT_xstream xstream, int cpuset_size, int *cpuset)
 
     abt_errno = ABTD_affinity_set_cpuset(p_xstream->ctx, cpuset_size, cpuset);
     ABTI_CHECK_ERROR(abt_errno);
+    ABTI_xstream_update_core_class(p_xstream);
 
   fn_exit:
     return abt_errno;
@@ -1315,36 +1879,148 @@ int ABT_xstream_get_affinity(ABT_xstream xstream, int cpuset_size, int *cpuset,
     goto fn_exit;
 }
 
-
-/*****************************************************************************/
-/* Private APIs                                                              */
-/*****************************************************************************/
-int ABTI_xstream_free(ABTI_xstream *p_xstream)
+/**
+ * @ingroup ES
+ * @brief   Set the OS scheduling policy and priority of the target ES.
+ *
+ * \c ABT_xstream_set_os_priority() sets the scheduling policy of the OS
+ * thread that runs the target ES \c xstream to \c policy.  \c priority is
+ * the niceness (from -20 to 19) for \c ABT_XSTREAM_OS_POLICY_OTHER and
+ * \c ABT_XSTREAM_OS_POLICY_BATCH, the real-time priority (from 1 to 99 on
+ * Linux) for \c ABT_XSTREAM_OS_POLICY_FIFO and \c ABT_XSTREAM_OS_POLICY_RR,
+ * and 0 for \c ABT_XSTREAM_OS_POLICY_IDLE.  Latency-critical ESs can use a
+ * real-time policy, which usually requires a privilege, and ESs that run
+ * batch work can run at a lower priority so that the kernel does not preempt
+ * the other ESs for them.  To keep other processes off its CPU, bind a
+ * latency-critical ES to a CPU isolated with \c isolcpus by
+ * \c ABT_xstream_set_cpubind().
+ *
+ * The setting is applied when \c xstream starts if it has not started yet,
+ * and reverted when \c xstream terminates.
+ *
+ * @param[in] xstream   handle to the target ES
+ * @param[in] policy    OS scheduling policy
+ * @param[in] priority  niceness or real-time priority
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_XSTREAM if \c priority is out of range or the OS refuses
+ *                         the setting (e.g., for lack of a privilege)
+ * @retval ABT_ERR_FEATURE_NA if the OS does not support \c policy
+ */
+int ABT_xstream_set_os_priority(ABT_xstream xstream,
+                                ABT_xstream_os_policy policy, int priority)
 {
     int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
 
-    /* Free the scheduler */
-    ABTI_sched *p_cursched = p_xstream->p_main_sched;
-    if (p_cursched != NULL) {
-        abt_errno = ABTI_sched_discard_and_free(p_cursched);
-        ABTI_CHECK_ERROR(abt_errno);
-    }
-
-    /* Free the array of sched contexts */
-    ABTU_free(p_xstream->scheds);
+    abt_errno = ABTD_xstream_context_check_os_priority(policy, priority);
+    ABTI_CHECK_ERROR(abt_errno);
 
-    /* Free the context */
-    abt_errno = ABTD_xstream_context_free(&p_xstream->ctx);
+    ABTI_spinlock_acquire(&p_xstream->os_lock);
+    if (p_xstream->os_tid != 0) {
+        abt_errno = ABTD_xstream_context_set_os_priority(p_xstream->ctx,
+                                                         p_xstream->os_tid,
+                                                         policy, priority);
+    }
+    if (abt_errno == ABT_SUCCESS) {
+        p_xstream->os_policy = policy;
+        p_xstream->os_priority = priority;
+    }
+    ABTI_spinlock_release(&p_xstream->os_lock);
     ABTI_CHECK_ERROR(abt_errno);
 
-    LOG_EVENT("[E%" PRIu64 "] freed\n", p_xstream->rank);
+  fn_exit:
+    return abt_errno;
 
-    /* Return rank for reuse */
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ES
+ * @brief   Get the OS scheduling policy and priority of the target ES.
+ *
+ * \c ABT_xstream_get_os_priority() returns the OS scheduling policy and
+ * priority set by \c ABT_xstream_set_os_priority() through \c policy and
+ * \c priority.  They are \c ABT_XSTREAM_OS_POLICY_OTHER and 0 by default.
+ * If \c policy or \c priority is \c NULL, it is ignored.
+ *
+ * @param[in]  xstream   handle to the target ES
+ * @param[out] policy    OS scheduling policy
+ * @param[out] priority  niceness or real-time priority
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_xstream_get_os_priority(ABT_xstream xstream,
+                                ABT_xstream_os_policy *policy, int *priority)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    ABTI_spinlock_acquire(&p_xstream->os_lock);
+    if (policy) *policy = p_xstream->os_policy;
+    if (priority) *priority = p_xstream->os_priority;
+    ABTI_spinlock_release(&p_xstream->os_lock);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+int ABTI_xstream_free(ABTI_xstream *p_xstream)
+{
+    int abt_errno = ABT_SUCCESS;
+
+    /* Free the scheduler */
+    ABTI_sched *p_cursched = p_xstream->p_main_sched;
+    if (p_cursched != NULL) {
+        abt_errno = ABTI_sched_discard_and_free(p_cursched);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+    /* A replacement that has not been done is dropped. */
+    if (p_xstream->p_swap_sched != NULL) {
+        abt_errno = ABTI_sched_discard_and_free(p_xstream->p_swap_sched);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
+    /* Free the array of sched contexts */
+    ABTU_free(p_xstream->scheds);
+
+    /* Free the context */
+    abt_errno = ABTD_xstream_context_free(&p_xstream->ctx);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    LOG_EVENT("[E%" PRIu64 "] freed\n", p_xstream->rank);
+
+    /* Return rank for reuse */
     ABTI_xstream_return_rank(p_xstream->rank);
 
+    /* Complete the MPI and I/O waits and expire the timed waits left on
+     * this ES */
+    ABTI_mpi_poller_fini(&p_xstream->mpi_poller);
+    ABTI_io_poller_fini(&p_xstream->io_poller);
+    ABTI_timer_wheel_fini(&p_xstream->timer_wheel);
+
+    if (p_xstream->max_poll_hooks > 0) ABTU_free(p_xstream->poll_hooks);
+    ABTI_spinlock_free(&p_xstream->poll_hook_lock);
+    ABTI_spinlock_free(&p_xstream->os_lock);
+
     /* Free the spinlock */
     ABTI_spinlock_free(&p_xstream->sched_lock);
 
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    if (p_xstream->p_unit_stats) ABTU_free(p_xstream->p_unit_stats);
+#endif
     ABTU_free(p_xstream);
 
   fn_exit:
@@ -1360,8 +2036,12 @@ void ABTI_xstream_schedule(void *p_arg)
 {
     ABTI_xstream *p_xstream = (ABTI_xstream *)p_arg;
 
+    ABTI_rcu_xstream_start(p_xstream);
     while (1) {
+        /* Open the run-next slot while the main scheduler runs */
+        p_xstream->p_run_next = NULL;
         p_xstream->state = ABT_XSTREAM_STATE_RUNNING;
+        ABTI_xstream_publish(p_xstream, ABT_get_wtime());
 
         /* Execute the run function of scheduler */
         ABTI_sched *p_sched = p_xstream->p_main_sched;
@@ -1370,10 +2050,17 @@ void ABTI_xstream_schedule(void *p_arg)
         LOG_EVENT("[S%" PRIu64 "] start\n", p_sched->id);
         p_sched->run(ABTI_sched_get_handle(p_sched));
         LOG_EVENT("[S%" PRIu64 "] end\n", p_sched->id);
+        /* ABTI_sched_has_to_stop() has taken sched_lock if it has stopped the
+         * scheduler.  A run function may also return on its own. */
+        ABT_bool sched_locked = ABTI_sched_is_stopped(p_sched);
         p_sched->state = ABT_SCHED_STATE_TERMINATED;
+        ABTI_xstream_close_run_next(p_xstream);
 
         p_xstream->state = ABT_XSTREAM_STATE_READY;
-        ABTI_spinlock_release(&p_xstream->sched_lock);
+        ABTI_xstream_publish(p_xstream, ABT_get_wtime());
+        if (sched_locked == ABT_TRUE) {
+            ABTI_spinlock_release(&p_xstream->sched_lock);
+        }
 
 #ifdef ABT_CONFIG_HANDLE_POWER_EVENT
         /* If there is a stop request, the ES has to be terminated/ */
@@ -1386,10 +2073,29 @@ void ABTI_xstream_schedule(void *p_arg)
             (p_xstream->request & ABTI_XSTREAM_REQ_CANCEL))
             break;
 
+        /* Switch to the new main scheduler, which takes over the pools */
+        if (p_xstream->request & ABTI_XSTREAM_REQ_SWAP) {
+            int abt_errno = ABTI_xstream_swap_main_sched(p_xstream);
+            if (abt_errno != ABT_SUCCESS) HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+            continue;
+        }
+
         /* When join is requested, the ES terminates after finishing
          * execution of all work units. */
         if (p_xstream->request & ABTI_XSTREAM_REQ_JOIN) {
-            if (ABTI_sched_get_effective_size(p_xstream->p_main_sched) == 0) {
+            if (p_xstream->request & ABTI_XSTREAM_REQ_MIGRATE) {
+                /* If the units cannot be moved, they are executed here. */
+                if (ABTI_xstream_move_units(p_xstream) != ABT_SUCCESS) {
+                    ABTI_xstream_unset_request(p_xstream,
+                                               ABTI_XSTREAM_REQ_MIGRATE);
+                }
+                /* The scheduler runs again if ULTs blocked on this ES have
+                 * not come back yet. */
+                ABTI_sched_unset_request(p_xstream->p_main_sched,
+                                         ABTI_SCHED_REQ_EXIT);
+            }
+            if (ABTI_sched_is_quiescent(p_xstream->p_main_sched, p_xstream)
+                == ABT_TRUE) {
                 /* If a ULT has been blocked on the join call, we make it ready */
                 if (p_xstream->p_req_arg) {
                     ABTI_thread_set_ready((ABTI_thread *)p_xstream->p_req_arg);
@@ -1400,8 +2106,11 @@ void ABTI_xstream_schedule(void *p_arg)
         }
     }
 
+    ABTI_rcu_xstream_stop(p_xstream);
+
     /* Set the ES's state as TERMINATED */
     p_xstream->state = ABT_XSTREAM_STATE_TERMINATED;
+    ABTI_xstream_publish(p_xstream, ABT_get_wtime());
     LOG_EVENT("[E%" PRIu64 "] terminated\n", p_xstream->rank);
 }
 
@@ -1409,6 +2118,9 @@ int ABTI_xstream_schedule_thread(ABTI_xstream *p_xstream, ABTI_thread *p_thread)
 {
     int abt_errno = ABT_SUCCESS;
 
+    /* The saved context arrives while the ULT is being set up. */
+    ABTI_thread_prefetch_stack(p_thread);
+
 #ifndef ABT_CONFIG_DISABLE_THREAD_CANCEL
     if (p_thread->request & ABTI_THREAD_REQ_CANCEL) {
         LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] canceled\n",
@@ -1452,6 +2164,18 @@ int ABTI_xstream_schedule_thread(ABTI_xstream *p_xstream, ABTI_thread *p_thread)
     /* Change the ULT state */
     p_thread->state = ABT_THREAD_STATE_RUNNING;
 
+    /* Bind a stack if the ULT has not got one yet */
+    ABTI_THREAD_BIND_STACK(p_thread);
+
+    /* Start a new run for the preemption timer */
+    p_xstream->num_thread_runs++;
+    p_xstream->stats.num_switches++;
+    ABTI_trace_thread(ABTI_TRACE_RUN, p_thread);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    uint64_t start_ticks = ABTI_unit_stats_get_ticks();
+#endif
+    ABTI_cpu_time_start(p_xstream);
+
     /* Switch the context */
     LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] start running\n",
               ABTI_thread_get_id(p_thread), p_xstream->rank);
@@ -1466,15 +2190,27 @@ int ABTI_xstream_schedule_thread(ABTI_xstream *p_xstream, ABTI_thread *p_thread)
     p_xstream = p_thread->p_last_xstream;
     LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] stopped\n",
               ABTI_thread_get_id(p_thread), p_xstream->rank);
+    ABTI_trace_thread(ABTI_TRACE_STOP, p_thread);
+    ABTI_cpu_time_stop_thread(p_xstream, p_thread);
+    ABTI_thread_check_stack_canary(p_thread);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    if (start_ticks != 0) {
+        ABTI_unit_stats_add_run(p_xstream, p_thread->p_pool, start_ticks);
+    }
+#endif
 
 #ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     /* Delete the last scheduler if the ULT was a scheduler */
     if (p_thread->is_sched != NULL) {
         ABTI_xstream_pop_sched(p_xstream);
         /* If a migration is trying to read the state of the scheduler, we need
-         * to let it finish before freeing the scheduler */
+         * to let it finish before freeing the scheduler.  A scheduler that has
+         * switched to its parent while running does not hold sched_lock. */
+        ABT_bool sched_locked = ABTI_sched_is_stopped(p_thread->is_sched);
         p_thread->is_sched->state = ABT_SCHED_STATE_STOPPED;
-        ABTI_spinlock_release(&p_xstream->sched_lock);
+        if (sched_locked == ABT_TRUE) {
+            ABTI_spinlock_release(&p_xstream->sched_lock);
+        }
     }
 #endif
 
@@ -1515,7 +2251,7 @@ int ABTI_xstream_schedule_thread(ABTI_xstream *p_xstream, ABTI_thread *p_thread)
         LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] orphaned\n",
                   ABTI_thread_get_id(p_thread), p_xstream->rank);
         ABTI_thread_unset_request(p_thread, ABTI_THREAD_REQ_ORPHAN);
-        p_thread->p_pool->u_free(&p_thread->unit);
+        ABTI_pool_unit_free(p_thread->p_pool, &p_thread->unit);
         p_thread->p_pool = NULL;
     } else if (p_thread->request & ABTI_THREAD_REQ_NOPUSH) {
         /* The ULT is not pushed back to the pool */
@@ -1565,6 +2301,11 @@ void ABTI_xstream_schedule_task(ABTI_xstream *p_xstream, ABTI_task *p_task)
 
     /* Set the associated ES */
     p_task->p_xstream = p_xstream;
+    ABTI_trace_task(ABTI_TRACE_RUN, p_task);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    uint64_t start_ticks = ABTI_unit_stats_get_ticks();
+#endif
+    ABTI_cpu_time_start(p_xstream);
 
 #ifdef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     /* Execute the task function */
@@ -1598,7 +2339,9 @@ void ABTI_xstream_schedule_task(ABTI_xstream *p_xstream, ABTI_task *p_task)
         ABTI_xstream_pop_sched(p_xstream);
         /* If a migration is trying to read the state of the scheduler, we need
          * to let it finish before freeing the scheduler */
-        ABTI_spinlock_release(&p_xstream->sched_lock);
+        if (ABTI_sched_is_stopped(p_task->is_sched) == ABT_TRUE) {
+            ABTI_spinlock_release(&p_xstream->sched_lock);
+        }
         ABTI_LOG_SET_SCHED(ABTI_xstream_get_top_sched(p_xstream));
         LOG_EVENT("[S%" PRIu64 ":E%" PRIu64 "] stacked sched end\n",
                   p_task->is_sched->id, p_xstream->rank);
@@ -1608,9 +2351,31 @@ void ABTI_xstream_schedule_task(ABTI_xstream *p_xstream, ABTI_task *p_task)
     ABTI_LOG_SET_SCHED(ABTI_xstream_get_top_sched(p_xstream));
     LOG_EVENT("[T%" PRIu64 ":E%" PRIu64 "] stopped\n",
               ABTI_task_get_id(p_task), p_xstream->rank);
+    ABTI_trace_task(ABTI_TRACE_STOP, p_task);
+    ABTI_cpu_time_stop_task(p_xstream, p_task);
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    if (start_ticks != 0) {
+        ABTI_unit_stats_add_run(p_xstream, p_task->p_pool, start_ticks);
+    }
+#endif
 
-    /* Terminate the tasklet */
-    ABTI_xstream_terminate_task(p_task);
+    if (p_task->request & ABTI_TASK_REQ_RESUME) {
+        /* The resumable tasklet will be invoked again. */
+        ABTI_task_unset_request(p_task, ABTI_TASK_REQ_RESUME);
+        ABTI_task_suspend_resumable(p_task);
+#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+    } else if (p_task->is_sched != NULL &&
+               p_task->is_sched->inline_nested == ABT_TRUE &&
+               p_task->is_sched->state == ABT_SCHED_STATE_STOPPED) {
+        /* An inline nested scheduler stays in its pool. */
+        p_task->state = ABT_TASK_STATE_READY;
+        ABT_pool_push(ABTI_pool_get_handle(p_task->p_pool), p_task->unit);
+#endif
+    } else {
+        /* Terminate the tasklet */
+        ABTI_cpu_time_terminate_task(p_task);
+        ABTI_xstream_terminate_task(p_task);
+    }
 
 #ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     /* Set the current running ULT/tasklet */
@@ -1678,6 +2443,41 @@ int ABTI_xstream_migrate_thread(ABTI_thread *p_thread)
 #endif
 }
 
+/* Find the running ES whose main scheduler uses pool as its own pool. */
+ABTI_xstream *ABTI_xstream_find_pool_owner(ABT_pool pool)
+{
+    int i, max_xstreams;
+    ABTI_xstream **p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+    for (i = 0; i < max_xstreams; i++) {
+        ABTI_xstream *p_xstream = p_xstreams[i];
+        if (p_xstream == NULL) continue;
+        if (p_xstream->state != ABT_XSTREAM_STATE_RUNNING) continue;
+        ABTI_sched *p_sched = p_xstream->p_main_sched;
+        if (p_sched && p_sched->num_pools > 0 && p_sched->pools[0] == pool) {
+            return p_xstream;
+        }
+    }
+    return NULL;
+}
+
+/* Return the NUMA node of the CPU that the ES is bound to, or -1 if it is not
+ * known. */
+int ABTI_xstream_get_numa_node(ABTI_xstream *p_xstream)
+{
+    return ABTD_affinity_get_topology_id(p_xstream->ctx, ABT_TOPOLOGY_NUMA);
+}
+
+/* Set the core class of the ES from the CPU it is bound to.  Schedulers that
+ * cache the classes of other ESs notice the change through core_class_gen. */
+void ABTI_xstream_update_core_class(ABTI_xstream *p_xstream)
+{
+    int core_class = ABTD_affinity_get_core_class(p_xstream->ctx);
+    if (p_xstream->core_class != core_class) {
+        p_xstream->core_class = core_class;
+        ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->core_class_gen, 1);
+    }
+}
+
 int ABTI_xstream_set_main_sched(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
 {
     int abt_errno = ABT_SUCCESS;
@@ -1721,9 +2521,9 @@ int ABTI_xstream_set_main_sched(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
     for (p = 0; p < p_main_sched->num_pools; p++) {
         if (p_thread->p_pool == ABTI_pool_get_ptr(p_main_sched->pools[p])) {
             /* Associate the work unit to the first pool of new scheduler */
-            p_thread->p_pool->u_free(&p_thread->unit);
-            ABT_thread h_thread = ABTI_thread_get_handle(p_thread);
-            p_thread->unit = p_tar_pool->u_create_from_thread(h_thread);
+            ABTI_pool_unit_free(p_thread->p_pool, &p_thread->unit);
+            p_thread->unit = ABTI_pool_unit_create_thread(p_tar_pool,
+                                                          p_thread);
             p_thread->p_pool = p_tar_pool;
             break;
         }
@@ -1793,6 +2593,26 @@ int ABTI_xstream_set_main_sched(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
     goto fn_exit;
 }
 
+static const char *ABTI_xstream_type_str(ABTI_xstream_type type)
+{
+    switch (type) {
+        case ABTI_XSTREAM_TYPE_PRIMARY:   return "PRIMARY";
+        case ABTI_XSTREAM_TYPE_SECONDARY: return "SECONDARY";
+        default:                          return "UNKNOWN";
+    }
+}
+
+static const char *ABTI_xstream_state_str(ABT_xstream_state state)
+{
+    switch (state) {
+        case ABT_XSTREAM_STATE_CREATED:    return "CREATED";
+        case ABT_XSTREAM_STATE_READY:      return "READY";
+        case ABT_XSTREAM_STATE_RUNNING:    return "RUNNING";
+        case ABT_XSTREAM_STATE_TERMINATED: return "TERMINATED";
+        default:                           return "UNKNOWN";
+    }
+}
+
 void ABTI_xstream_print(ABTI_xstream *p_xstream, FILE *p_os, int indent,
                         ABT_bool print_sub)
 {
@@ -1803,23 +2623,13 @@ void ABTI_xstream_print(ABTI_xstream *p_xstream, FILE *p_os, int indent,
         goto fn_exit;
     }
 
-    char *type, *state;
+    const char *type, *state;
     char *scheds_str;
     int i;
     size_t size, pos;
 
-    switch (p_xstream->type) {
-        case ABTI_XSTREAM_TYPE_PRIMARY:   type = "PRIMARY"; break;
-        case ABTI_XSTREAM_TYPE_SECONDARY: type = "SECONDARY"; break;
-        default:                          type = "UNKNOWN"; break;
-    }
-    switch (p_xstream->state) {
-        case ABT_XSTREAM_STATE_CREATED:    state = "CREATED"; break;
-        case ABT_XSTREAM_STATE_READY:      state = "READY"; break;
-        case ABT_XSTREAM_STATE_RUNNING:    state = "RUNNING"; break;
-        case ABT_XSTREAM_STATE_TERMINATED: state = "TERMINATED"; break;
-        default:                           state = "UNKNOWN"; break;
-    }
+    type = ABTI_xstream_type_str(p_xstream->type);
+    state = ABTI_xstream_state_str(p_xstream->state);
 
     size = sizeof(char) * (p_xstream->num_scheds * 20 + 4);
     scheds_str = (char *)ABTU_calloc(size, 1);
@@ -1853,6 +2663,15 @@ void ABTI_xstream_print(ABTI_xstream *p_xstream, FILE *p_os, int indent,
         prefix, p_xstream->p_main_sched
     );
     ABTU_free(scheds_str);
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    fprintf(p_os, "%snum_rfrees: %" PRIu64 "\n",
+            prefix, p_xstream->num_remote_frees);
+#endif
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    if (p_xstream->p_unit_stats) {
+        ABTI_unit_stats_print(p_xstream->p_unit_stats, p_os, prefix);
+    }
+#endif
 
     if (print_sub == ABT_TRUE) {
         ABTI_sched_print(p_xstream->p_main_sched, p_os, indent + ABTI_INDENT,
@@ -1864,34 +2683,114 @@ void ABTI_xstream_print(ABTI_xstream *p_xstream, FILE *p_os, int indent,
     ABTU_free(prefix);
 }
 
+/* Print the summary p_snap of p_xstream, which has been copied by
+ * ABTI_xstream_read_snapshot().  p_xstream itself is not read. */
+void ABTI_xstream_print_snapshot(ABTI_xstream *p_xstream,
+                                 ABTI_xstream_snapshot *p_snap, FILE *p_os,
+                                 int indent)
+{
+    char *prefix = ABTU_get_indent_str(indent);
+    ABT_xstream_stats *p_stats = &p_snap->stats;
+
+    fprintf(p_os,
+        "%s== ES (%p) ==\n"
+        "%srank      : %" PRIu64 "\n"
+        "%stype      : %s\n"
+        "%sstate     : %s\n"
+        "%srequest   : 0x%x\n"
+        "%smax_scheds: %d\n"
+        "%snum_scheds: %d\n"
+        "%smain_sched: %p\n"
+        "%snum_rfrees: %" PRIu64 "\n"
+        "%sunits     : %" PRIu64 " (ULTs: %" PRIu64 ", tasklets: %" PRIu64 ")\n"
+        "%spops      : %" PRIu64 " (failed: %" PRIu64 ")\n"
+        "%ssteals    : %" PRIu64 " / %" PRIu64 "\n"
+        "%sage       : %.6f sec\n",
+        prefix, p_xstream,
+        prefix, p_snap->rank,
+        prefix, ABTI_xstream_type_str(p_snap->type),
+        prefix, ABTI_xstream_state_str(p_snap->state),
+        prefix, p_snap->request,
+        prefix, p_snap->max_scheds,
+        prefix, p_snap->num_scheds,
+        prefix, p_snap->p_main_sched,
+        prefix, p_snap->num_remote_frees,
+        prefix, p_stats->num_units, p_stats->num_threads, p_stats->num_tasks,
+        prefix, p_stats->num_pops, p_stats->num_failed_pops,
+        prefix, p_stats->num_steals, p_stats->num_steal_attempts,
+        prefix, ABT_get_wtime() - p_snap->time
+    );
+
+    ABTU_free(prefix);
+}
+
+/* Body of the OS threads of secondary ESs.  p_arg is ABTI_xstream_worker. */
 void *ABTI_xstream_launch_main_sched(void *p_arg)
 {
     int abt_errno = ABT_SUCCESS;
-    ABTI_xstream *p_xstream = (ABTI_xstream *)p_arg;
+    ABTI_xstream_worker *p_worker = (ABTI_xstream_worker *)p_arg;
+    ABTI_xstream *p_xstream;
+    ABT_bool parked;
 
     /* Initialization of the local variables */
     abt_errno = ABTI_local_init();
     ABTI_CHECK_ERROR(abt_errno);
-    ABTI_local_set_xstream(p_xstream);
 
-    /* Create the main sched ULT */
-    ABTI_sched *p_sched = p_xstream->p_main_sched;
-    abt_errno = ABTI_thread_create_main_sched(p_xstream, p_sched);
-    ABTI_CHECK_ERROR(abt_errno);
+    do {
+        p_xstream = p_worker->p_xstream;
+        ABTI_local_set_xstream(p_xstream);
 
-    /* Set the sched ULT as the current ULT */
-    ABTI_local_set_thread(p_sched->p_thread);
+        /* An ES created by ABT_xstream_create_many() initializes itself. */
+        if (p_xstream->p_bringup != NULL &&
+            ABTI_xstream_bringup_self(p_xstream, p_worker) == ABT_FALSE) {
+            break;
+        }
 
-    /* Set the current scheduler for logging */
-    ABTI_LOG_SET_SCHED(p_sched);
+        /* Create the main sched ULT */
+        ABTI_sched *p_sched = p_xstream->p_main_sched;
+        abt_errno = ABTI_thread_create_main_sched(p_xstream, p_sched);
+        ABTI_CHECK_ERROR(abt_errno);
 
-    /* Execute the main scheduler of this ES */
-    LOG_EVENT("[E%" PRIu64 "] start\n", p_xstream->rank);
-    ABTI_xstream_schedule(p_arg);
-    LOG_EVENT("[E%" PRIu64 "] end\n", p_xstream->rank);
+        /* Set the sched ULT as the current ULT */
+        ABTI_local_set_thread(p_sched->p_thread);
+
+        /* Set the current scheduler for logging */
+        ABTI_LOG_SET_SCHED(p_sched);
+
+        /* Execute the main scheduler of this ES */
+        LOG_EVENT("[E%" PRIu64 "] start\n", p_xstream->rank);
+        ABTI_xstream_start_preempt(p_xstream);
+        ABTI_xstream_start_os_priority(p_xstream);
+        ABTI_profile_start(p_xstream);
+        ABTI_xstream_schedule((void *)p_xstream);
+        ABTI_profile_stop(p_xstream);
+        ABTI_xstream_stop_preempt(p_xstream);
+        ABTI_xstream_stop_os_priority(p_xstream);
+        LOG_EVENT("[E%" PRIu64 "] end\n", p_xstream->rank);
+
+        /* Notify the asynchronous joiner.  It waits for the release below
+         * before it frees p_xstream.  This ES is still the current one, which
+         * pushes the joiner back to its pool as the producer. */
+        if (p_xstream->p_join_eventual) {
+            ABT_eventual_set(ABTI_eventual_get_handle(
+                             p_xstream->p_join_eventual), NULL, 0);
+        }
+
+        /* Reset the current ES but keep the local memory caches. */
+        ABTI_local_set_xstream(NULL);
+        ABTI_local_set_thread(NULL);
+        ABTI_local_set_task(NULL);
+
+        /* The joiner frees p_xstream as soon as it is released. */
+        p_worker->p_xstream = NULL;
+        parked = ABTI_xstream_park_worker(p_worker);
+        p_xstream->ctx_parked = parked;
+        ABTD_atomic_exchange_uint32(&p_xstream->ctx_released, 1);
+    } while (parked == ABT_TRUE &&
+             ABTI_xstream_wait_worker(p_worker) == ABT_TRUE);
 
-    /* Reset the current ES and its local info. */
     ABTI_local_finalize();
+    ABTU_free(p_worker);
 
     ABTD_xstream_context_exit();
 
@@ -1903,6 +2802,116 @@ void *ABTI_xstream_launch_main_sched(void *p_arg)
     goto fn_exit;
 }
 
+/* Start the preemption timer of the calling ES if preemption is enabled.
+ * This has to be called by the thread that runs the ES. */
+void ABTI_xstream_start_preempt(ABTI_xstream *p_xstream)
+{
+    long interval = ABTI_global_get_preempt_interval();
+    if (interval <= 0) return;
+
+    if (ABTD_preempt_timer_create(&p_xstream->preempt_timer, interval)
+        == ABT_SUCCESS) {
+        p_xstream->preemptive = ABT_TRUE;
+    }
+}
+
+void ABTI_xstream_stop_preempt(ABTI_xstream *p_xstream)
+{
+    if (p_xstream->preemptive == ABT_TRUE) {
+        ABTD_preempt_timer_free(&p_xstream->preempt_timer);
+        p_xstream->preemptive = ABT_FALSE;
+    }
+}
+
+/* Record the OS thread of the calling ES and apply the OS scheduling set by
+ * ABT_xstream_set_os_priority() before the ES started.  This has to be called
+ * by the thread that runs the ES. */
+void ABTI_xstream_start_os_priority(ABTI_xstream *p_xstream)
+{
+    ABTD_xstream_context ctx;
+    ABTD_xstream_context_self(&ctx);
+
+    ABTI_spinlock_acquire(&p_xstream->os_lock);
+    p_xstream->os_tid = ABTD_xstream_context_get_tid();
+    if (p_xstream->os_policy != ABT_XSTREAM_OS_POLICY_OTHER ||
+        p_xstream->os_priority != 0) {
+        ABTD_xstream_context_set_os_priority(ctx, p_xstream->os_tid,
+                                             p_xstream->os_policy,
+                                             p_xstream->os_priority);
+    }
+    ABTI_spinlock_release(&p_xstream->os_lock);
+}
+
+/* Restore the default OS scheduling of the OS thread, which may be parked and
+ * reused by another ES.  Restoring the niceness fails without privileges
+ * if it has been raised, which is ignored. */
+void ABTI_xstream_stop_os_priority(ABTI_xstream *p_xstream)
+{
+    ABTD_xstream_context ctx;
+    ABTD_xstream_context_self(&ctx);
+
+    ABTI_spinlock_acquire(&p_xstream->os_lock);
+    if (p_xstream->os_policy != ABT_XSTREAM_OS_POLICY_OTHER ||
+        p_xstream->os_priority != 0) {
+        ABTD_xstream_context_set_os_priority(ctx, p_xstream->os_tid,
+                                             ABT_XSTREAM_OS_POLICY_OTHER, 0);
+    }
+    p_xstream->os_tid = 0;
+    ABTI_spinlock_release(&p_xstream->os_lock);
+}
+
+/* Call the poll hooks whose periods have passed.  The lock is released while
+ * a hook runs so that it can add and remove hooks; a hook moved meanwhile may
+ * be skipped or called again in this round. */
+void ABTI_xstream_run_poll_hooks(ABTI_xstream *p_xstream)
+{
+    int i;
+
+    ABTI_spinlock_acquire(&p_xstream->poll_hook_lock);
+    for (i = 0; i < p_xstream->num_poll_hooks; i++) {
+        ABTI_poll_hook *p_hook = &p_xstream->poll_hooks[i];
+        if (++p_hook->count >= p_hook->period) {
+            void (*fn)(void *) = p_hook->fn;
+            void *arg = p_hook->arg;
+            p_hook->count = 0;
+            ABTI_spinlock_release(&p_xstream->poll_hook_lock);
+            fn(arg);
+            ABTI_spinlock_acquire(&p_xstream->poll_hook_lock);
+        }
+    }
+    ABTI_spinlock_release(&p_xstream->poll_hook_lock);
+}
+
+/* Called by the preemption signal handler when the ES has been interrupted in
+ * user code.  The running ULT is preempted if it is preemptible and has been
+ * running since the previous timer tick. */
+void ABTI_xstream_check_preempt(void)
+{
+    ABTI_xstream *p_xstream;
+    ABTI_thread *p_thread;
+    uint64_t num_runs;
+
+    if (lp_ABTI_local == NULL) return;
+    p_xstream = ABTI_local_get_xstream();
+    p_thread = ABTI_local_get_thread();
+    if (p_xstream == NULL || p_thread == NULL) return;
+    if (ABTI_local_get_task() != NULL) return;
+    if (p_thread->type != ABTI_THREAD_TYPE_USER ||
+        p_thread->attr.preemptible != ABT_TRUE ||
+        p_thread->state != ABT_THREAD_STATE_RUNNING) {
+        return;
+    }
+
+    num_runs = p_xstream->num_thread_runs;
+    if (num_runs != p_xstream->preempt_runs) {
+        p_xstream->preempt_runs = num_runs;
+        return;
+    }
+
+    LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] preempted\n",
+              ABTI_thread_get_id(p_thread), p_xstream->rank);
+    ABTI_thread_yield(p_thread);
+}
 
 /* global rank variable for ES */
 static uint32_t *g_rank_list = NULL;
@@ -1920,56 +2929,637 @@ void ABTI_xstream_free_ranks(void)
     g_rank_list = NULL;
 }
 
+/* Terminate the parked OS threads.  It should be called in ABT_finalize
+ * before the memory pool is finalized. */
+void ABTI_xstream_free_parked(void)
+{
+    ABTI_xstream_worker *p_worker, *p_next;
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    p_worker = gp_ABTI_global->p_parked_xstreams;
+    gp_ABTI_global->p_parked_xstreams = NULL;
+    gp_ABTI_global->num_parked_xstreams = 0;
+    gp_ABTI_global->max_parked_xstreams = 0;
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+
+    while (p_worker) {
+        ABTD_xstream_context ctx = p_worker->ctx;
+        /* The OS thread frees p_worker before it exits. */
+        p_next = p_worker->p_next;
+        p_worker->exit = ABT_TRUE;
+        ABTD_atomic_fetch_add_uint32(&p_worker->seq, 1);
+        ABTD_futex_wake_all(&p_worker->seq);
+        ABTD_xstream_context_join(ctx);
+        p_worker = p_next;
+    }
+}
+
 /*****************************************************************************/
 /* Internal static functions                                                 */
 /*****************************************************************************/
 
+/* Grow the ES array and the rank list to hold at least size ESs.  The caller
+ * has to hold the global lock.  The ES array is replaced by a larger copy
+ * instead of being reallocated since other ESs read it without locking. */
+static void ABTI_xstream_grow_table(int size)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    ABTI_xstream **p_xstreams;
+    ABTI_xstream_table *p_table;
+    int i, max_xstreams = p_global->max_xstreams;
+
+    if (size <= max_xstreams) return;
+    if (max_xstreams == 0) max_xstreams = 1;
+    while (max_xstreams < size) max_xstreams *= 2;
+
+    p_xstreams = (ABTI_xstream **)ABTU_calloc(max_xstreams,
+                                              sizeof(ABTI_xstream *));
+    for (i = 0; i < p_global->max_xstreams; i++) {
+        p_xstreams[i] = p_global->p_xstreams[i];
+    }
+    g_rank_list = (uint32_t *)ABTU_realloc(g_rank_list,
+            max_xstreams * sizeof(uint32_t));
+    for (i = p_global->max_xstreams; i < max_xstreams; i++) {
+        g_rank_list[i] = 0;
+    }
+
+    p_table = (ABTI_xstream_table *)ABTU_malloc(sizeof(ABTI_xstream_table));
+    p_table->p_xstreams = p_global->p_xstreams;
+    p_table->p_next = p_global->p_old_xstreams;
+    p_global->p_old_xstreams = p_table;
+
+    /* Publish the new array before its size so that a reader that sees the
+     * new size also sees the new array (see ABTI_global_get_xstreams()). */
+    *(ABTI_xstream **volatile *)&p_global->p_xstreams = p_xstreams;
+    ABTD_atomic_mem_barrier();
+    *(volatile int *)&p_global->max_xstreams = max_xstreams;
+}
+
+/* Set the entry of the ES array for rank.  The lock keeps the entry from
+ * being written to an array that is being replaced. */
+static void ABTI_xstream_set_entry(uint64_t rank, ABTI_xstream *p_xstream)
+{
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    gp_ABTI_global->p_xstreams[rank] = p_xstream;
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+}
+
 /* Get a new ES rank */
 static uint64_t ABTI_xstream_get_new_rank(void)
 {
-    uint64_t i;
-    int max_xstreams;
+    int i;
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    for (i = 0; i < gp_ABTI_global->max_xstreams; i++) {
+        if (g_rank_list[i] == 0) break;
+    }
+    ABTI_xstream_grow_table(i + 1);
+    g_rank_list[i] = 1;
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+    return (uint64_t)i;
+}
+
+static ABT_bool ABTI_xstream_take_rank(uint64_t rank)
+{
+    ABT_bool taken = ABT_FALSE;
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    ABTI_xstream_grow_table((int)rank + 1);
+    if (g_rank_list[rank] == 0) {
+        g_rank_list[rank] = 1;
+        taken = ABT_TRUE;
+    }
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+    return taken;
+}
+
+static void ABTI_xstream_return_rank(uint64_t rank)
+{
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    if (rank < gp_ABTI_global->max_xstreams) {
+        g_rank_list[rank] = 0;
+    }
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+}
+
+/* Run a secondary ES on a parked OS thread if any, or on a new one. */
+static int ABTI_xstream_start_context(ABTI_xstream *p_xstream)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream_worker *p_worker = NULL;
 
-    if (gp_ABTI_global->num_xstreams >= gp_ABTI_global->max_xstreams) {
+    if (gp_ABTI_global->num_parked_xstreams > 0) {
         ABTI_spinlock_acquire(&gp_ABTI_global->lock);
-        if (gp_ABTI_global->num_xstreams >= gp_ABTI_global->max_xstreams) {
-            max_xstreams = gp_ABTI_global->max_xstreams * 2;
-            gp_ABTI_global->p_xstreams = (ABTI_xstream **)ABTU_realloc(
-                    gp_ABTI_global->p_xstreams,
-                    max_xstreams * sizeof(ABTI_xstream *));
-            g_rank_list = (uint32_t *)ABTU_realloc(g_rank_list,
-                    max_xstreams * sizeof(uint32_t));
-            for (i = gp_ABTI_global->num_xstreams; i < max_xstreams; i++) {
-                g_rank_list[i] = 0;
-            }
-            gp_ABTI_global->max_xstreams = max_xstreams;
+        p_worker = gp_ABTI_global->p_parked_xstreams;
+        if (p_worker) {
+            gp_ABTI_global->p_parked_xstreams = p_worker->p_next;
+            gp_ABTI_global->num_parked_xstreams--;
         }
         ABTI_spinlock_release(&gp_ABTI_global->lock);
     }
 
-    for (i = 0; i < gp_ABTI_global->max_xstreams; i++) {
-        if (g_rank_list[i] == 0) {
-            if (ABTD_atomic_cas_uint32(&g_rank_list[i], 0, 1) == 0) {
-                return i;
+    if (p_worker) {
+        LOG_EVENT("[E%" PRIu64 "] reuse a parked OS thread\n",
+                  p_xstream->rank);
+        p_xstream->ctx = p_worker->ctx;
+        p_worker->p_xstream = p_xstream;
+        ABTD_atomic_fetch_add_uint32(&p_worker->seq, 1);
+        ABTD_futex_wake_all(&p_worker->seq);
+        goto fn_exit;
+    }
+
+    p_worker = (ABTI_xstream_worker *)ABTU_malloc(sizeof(ABTI_xstream_worker));
+    p_worker->p_xstream = p_xstream;
+    p_worker->exit = ABT_FALSE;
+    p_worker->seq = 0;
+    p_worker->p_next = NULL;
+    abt_errno = ABTD_xstream_context_create(ABTI_xstream_launch_main_sched,
+                                            (void *)p_worker, &p_worker->ctx);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_worker);
+        goto fn_fail;
+    }
+    p_xstream->ctx = p_worker->ctx;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Number of ESs in the bring-up subtree rooted at ES index */
+static int ABTI_xstream_bringup_subtree(int num_xstreams, int index)
+{
+    int k, child, num = 1;
+    for (k = 0; k < ABTI_XSTREAM_BRINGUP_FANOUT; k++) {
+        child = ABTI_XSTREAM_BRINGUP_FANOUT * (index + 1) + k;
+        if (child >= num_xstreams) break;
+        num += ABTI_xstream_bringup_subtree(num_xstreams, child);
+    }
+    return num;
+}
+
+/* num ESs have finished the bring-up.  The caller must not touch p_bringup
+ * after this since ABT_xstream_create_many() may free it. */
+static void ABTI_xstream_bringup_done(ABTI_xstream_bringup *p_bringup,
+                                      int num)
+{
+    if (ABTD_atomic_fetch_sub_uint32(&p_bringup->num_remains, (uint32_t)num)
+        == (uint32_t)num) {
+        ABT_eventual_set(p_bringup->eventual, NULL, 0);
+    }
+}
+
+static void ABTI_xstream_bringup_fail(ABTI_xstream_bringup *p_bringup,
+                                      int abt_errno)
+{
+    ABTD_atomic_cas_int32(&p_bringup->abt_errno, ABT_SUCCESS, abt_errno);
+}
+
+/* Start the OS thread of ES index.  If it cannot be started, neither can the
+ * ESs that it would start. */
+static void ABTI_xstream_bringup_start(ABTI_xstream_bringup *p_bringup,
+                                       int index)
+{
+    ABTI_xstream *p_xstream = p_bringup->p_xstreams[index];
+    int abt_errno;
+
+    p_xstream->state = ABT_XSTREAM_STATE_READY;
+    abt_errno = ABTI_xstream_start_context(p_xstream);
+    if (abt_errno != ABT_SUCCESS) {
+        p_xstream->state = ABT_XSTREAM_STATE_CREATED;
+        ABTI_xstream_bringup_fail(p_bringup, abt_errno);
+        ABTI_xstream_bringup_done(p_bringup,
+            ABTI_xstream_bringup_subtree(p_bringup->num_xstreams, index));
+    }
+}
+
+/* Bring up p_xstream on its own OS thread: start the OS threads of its
+ * children, bind itself, and create its main scheduler, so that the memory
+ * of the scheduler and pools is touched first on the CPU of the ES.  Return
+ * ABT_FALSE if the ES has terminated because it could not be brought up. */
+static ABT_bool ABTI_xstream_bringup_self(ABTI_xstream *p_xstream,
+                                          ABTI_xstream_worker *p_worker)
+{
+    ABTI_xstream_bringup *p_bringup = p_xstream->p_bringup;
+    int index = p_xstream->bringup_index;
+    ABTI_sched *p_sched = NULL;
+    ABTD_xstream_context ctx;
+    ABT_sched sched;
+    int abt_errno, core_class, k, child;
+
+    for (k = 0; k < ABTI_XSTREAM_BRINGUP_FANOUT; k++) {
+        child = ABTI_XSTREAM_BRINGUP_FANOUT * (index + 1) + k;
+        if (child >= p_bringup->num_xstreams) break;
+        ABTI_xstream_bringup_start(p_bringup, child);
+    }
+
+    /* p_xstream->ctx may not have been set by the parent yet. */
+    if (gp_ABTI_global->set_affinity == ABT_TRUE) {
+        ABTD_xstream_context_self(&ctx);
+        ABTD_affinity_set(ctx, p_xstream->rank);
+        core_class = ABTD_affinity_get_core_class(ctx);
+        if (p_xstream->core_class != core_class) {
+            p_xstream->core_class = core_class;
+            ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->core_class_gen, 1);
+        }
+    }
+
+    abt_errno = ABT_sched_create_basic(ABT_SCHED_DEFAULT, 0, NULL,
+                                       ABT_SCHED_CONFIG_NULL, &sched);
+    if (abt_errno == ABT_SUCCESS) {
+        p_sched = ABTI_sched_get_ptr(sched);
+        abt_errno = ABTI_xstream_set_main_sched(p_xstream, p_sched);
+    }
+    p_xstream->p_bringup = NULL;
+
+    if (abt_errno == ABT_SUCCESS) {
+        ABTI_xstream_push_sched(p_xstream, p_sched);
+        ABTI_xstream_publish(p_xstream, ABT_get_wtime());
+        ABTI_xstream_set_entry(p_xstream->rank, p_xstream);
+        ABTD_atomic_fetch_add_int32(&gp_ABTI_global->num_xstreams, 1);
+        ABTI_xstream_bringup_done(p_bringup, 1);
+        return ABT_TRUE;
+    }
+
+    /* Terminate without running a scheduler.  The caller of
+     * ABT_xstream_create_many() joins and frees this ES. */
+    if (p_sched != NULL) ABTI_sched_discard_and_free(p_sched);
+    p_xstream->p_main_sched = NULL;
+    ABTI_local_set_xstream(NULL);
+    p_xstream->state = ABT_XSTREAM_STATE_TERMINATED;
+    p_worker->p_xstream = NULL;
+    p_xstream->ctx_parked = ABT_FALSE;
+    ABTD_atomic_exchange_uint32(&p_xstream->ctx_released, 1);
+    ABTI_xstream_bringup_fail(p_bringup, abt_errno);
+    ABTI_xstream_bringup_done(p_bringup, 1);
+    return ABT_FALSE;
+}
+
+/* Wait until the OS thread of a terminated secondary ES stops using it. */
+static int ABTI_xstream_join_context(ABTI_xstream *p_xstream)
+{
+    while (*(volatile uint32_t *)&p_xstream->ctx_released == 0) {
+        ABTD_xstream_context_yield();
+    }
+    /* The asynchronous join, if any, is completed. */
+    p_xstream->p_join_eventual = NULL;
+    if (p_xstream->ctx_parked == ABT_TRUE) return ABT_SUCCESS;
+    return ABTD_xstream_context_join(p_xstream->ctx);
+}
+
+/* Replace the main scheduler of p_xstream, which has just returned, with the
+ * one requested by ABT_xstream_swap_main_sched().  This runs on the main
+ * scheduler ULT of p_xstream, which the new scheduler takes over. */
+static int ABTI_xstream_swap_main_sched(ABTI_xstream *p_xstream)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sched *p_old_sched = p_xstream->p_main_sched;
+    ABTI_sched *p_sched;
+
+    ABTI_xstream_unset_request(p_xstream, ABTI_XSTREAM_REQ_SWAP);
+    p_sched = (ABTI_sched *)(uintptr_t)ABTD_atomic_exchange_uint64(
+        (uint64_t *)&p_xstream->p_swap_sched, 0);
+    if (p_sched == NULL) goto fn_exit;
+
+#ifndef ABT_CONFIG_DISABLE_POOL_CONSUMER_CHECK
+    int p;
+    for (p = 0; p < p_sched->num_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[p]);
+        abt_errno = ABTI_pool_set_consumer(p_pool, p_xstream);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+#endif
+
+    /* The new scheduler runs on the ULT of the old one. */
+    ABTI_spinlock_acquire(&p_xstream->sched_lock);
+    p_sched->p_thread = p_old_sched->p_thread;
+    p_sched->p_ctx = p_old_sched->p_ctx;
+    p_sched->p_thread->is_sched = p_sched;
+    p_old_sched->p_thread = NULL;
+    p_old_sched->p_ctx = NULL;
+    if (p_xstream->type == ABTI_XSTREAM_TYPE_PRIMARY) {
+        /* See ABTI_xstream_set_main_sched() */
+        p_sched->automatic = ABT_TRUE;
+    }
+    p_xstream->p_main_sched = p_sched;
+    ABTI_xstream_replace_top_sched(p_xstream, p_sched);
+    ABTI_spinlock_release(&p_xstream->sched_lock);
+
+    LOG_EVENT("[E%" PRIu64 "] main scheduler: S%" PRIu64 " -> S%" PRIu64 "\n",
+              p_xstream->rank, p_old_sched->id, p_sched->id);
+
+    /* The old scheduler can be used again if it is not freed here.  Its pools
+     * are kept by the new scheduler if it shares them. */
+    p_old_sched->request = 0;
+    abt_errno = ABTI_sched_discard_and_free(p_old_sched);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Return the first main pool of p_target if the units of p_xstream can be
+ * pushed into it, or NULL otherwise.  The caller holds the sched_lock of
+ * p_target, so its main scheduler does not stop while the units are pushed. */
+static ABTI_pool *ABTI_xstream_get_move_target(ABTI_xstream *p_xstream,
+                                               ABTI_xstream *p_target)
+{
+    ABTI_sched *p_sched = p_target->p_main_sched;
+    ABTI_pool *p_pool;
+    int p;
+
+    if (p_target->state != ABT_XSTREAM_STATE_RUNNING) return NULL;
+    if (p_target->request & (ABTI_XSTREAM_REQ_JOIN | ABTI_XSTREAM_REQ_EXIT |
+                             ABTI_XSTREAM_REQ_CANCEL)) {
+        return NULL;
+    }
+    if (p_sched == NULL || p_sched->num_pools == 0) return NULL;
+
+    p_pool = ABTI_pool_get_ptr(p_sched->pools[0]);
+    if (p_pool->units == ABTI_POOL_UNITS_CUSTOM) return NULL;
+    if (p_pool->access != ABT_POOL_ACCESS_MPSC &&
+        p_pool->access != ABT_POOL_ACCESS_MPMC) {
+        return NULL;
+    }
+    for (p = 0; p < p_xstream->p_main_sched->num_pools; p++) {
+        if (p_xstream->p_main_sched->pools[p] == p_sched->pools[0]) {
+            return NULL;
+        }
+    }
+    return p_pool;
+}
+
+/* Move the units in the pools of the main scheduler of p_xstream, which is
+ * being joined, to the first main pools of the other running ESs in turn.
+ * Pools shared with other schedulers are left to them.  Returns
+ * ABT_ERR_MIGRATION_TARGET if some units cannot be moved. */
+static int ABTI_xstream_move_units(ABTI_xstream *p_xstream)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sched *p_sched = p_xstream->p_main_sched;
+    ABTI_xstream **p_xstreams;
+    int i, p, max_xstreams, next = 0;
+
+    /* The lock keeps the other ESs from being freed. */
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+
+    for (p = 0; p < p_sched->num_pools; p++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(p_sched->pools[p]);
+        if (p_pool->num_scheds > 1) continue;
+
+        while (ABTI_pool_call_get_size(p_pool) > 0) {
+            ABTI_xstream *p_target = NULL;
+            ABTI_pool *p_target_pool = NULL;
+            ABT_unit unit;
+
+            if (p_pool->units == ABTI_POOL_UNITS_CUSTOM) {
+                abt_errno = ABT_ERR_MIGRATION_TARGET;
+                goto fn_exit;
             }
+
+            /* Find the next ES that accepts the unit */
+            for (i = 0; i < max_xstreams; i++) {
+                p_target = p_xstreams[(next + i) % max_xstreams];
+                if (p_target == NULL || p_target == p_xstream) continue;
+                ABTI_spinlock_acquire(&p_target->sched_lock);
+                p_target_pool = ABTI_xstream_get_move_target(p_xstream,
+                                                             p_target);
+                if (p_target_pool) break;
+                ABTI_spinlock_release(&p_target->sched_lock);
+            }
+            if (p_target_pool == NULL) {
+                abt_errno = ABT_ERR_MIGRATION_TARGET;
+                goto fn_exit;
+            }
+            next = (next + i + 1) % max_xstreams;
+
+            unit = ABTI_pool_pop(p_pool);
+            if (unit != ABT_UNIT_NULL) {
+                if (ABTI_pool_unit_get_type(p_pool, unit)
+                    == ABT_UNIT_TYPE_THREAD) {
+                    ABTI_pool_unit_get_thread(p_pool, unit)->p_pool
+                        = p_target_pool;
+                } else {
+                    ABTI_pool_unit_get_task(p_pool, unit)->p_pool
+                        = p_target_pool;
+                }
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+                ABTI_pool_push(p_target_pool, unit);
+#else
+                abt_errno = ABTI_pool_push(p_target_pool, unit, p_xstream);
+#endif
+            }
+            ABTI_spinlock_release(&p_target->sched_lock);
+            if (abt_errno != ABT_SUCCESS || unit == ABT_UNIT_NULL) break;
         }
+        if (abt_errno != ABT_SUCCESS) break;
     }
-    return gp_ABTI_global->max_xstreams;
+
+  fn_exit:
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+    return abt_errno;
 }
 
-static ABT_bool ABTI_xstream_take_rank(uint64_t rank)
+/* Keep the OS thread whose ES has terminated for a later ES.  Returns
+ * ABT_FALSE if the OS thread has to exit. */
+static ABT_bool ABTI_xstream_park_worker(ABTI_xstream_worker *p_worker)
 {
-    if (ABTD_atomic_cas_uint32(&g_rank_list[rank], 0, 1) == 0) {
-        return ABT_TRUE;
-    } else {
-        return ABT_FALSE;
+    ABT_bool parked = ABT_FALSE;
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    if (gp_ABTI_global->num_parked_xstreams <
+        gp_ABTI_global->max_parked_xstreams) {
+        p_worker->p_next = gp_ABTI_global->p_parked_xstreams;
+        gp_ABTI_global->p_parked_xstreams = p_worker;
+        gp_ABTI_global->num_parked_xstreams++;
+        parked = ABT_TRUE;
     }
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+    return parked;
 }
 
-static void ABTI_xstream_return_rank(uint64_t rank)
+/* Block the parked OS thread until a new ES takes it over.  Returns ABT_FALSE
+ * if the OS thread has to exit. */
+static ABT_bool ABTI_xstream_wait_worker(ABTI_xstream_worker *p_worker)
 {
-    if (rank < gp_ABTI_global->max_xstreams) {
-        g_rank_list[rank] = 0;
+#if defined(HAVE_LINUX_FUTEX_H) && defined(HAVE_SYS_SYSCALL_H)
+    const struct timespec *p_timeout = NULL;
+#else
+    /* Without futex, the parked thread polls. */
+    const struct timespec timeout = { 0, 1000000 };
+    const struct timespec *p_timeout = &timeout;
+#endif
+
+    while (1) {
+        uint32_t seq = *(volatile uint32_t *)&p_worker->seq;
+        if (*(ABTI_xstream * volatile *)&p_worker->p_xstream != NULL) {
+            ABTD_atomic_mem_barrier();
+            return ABT_TRUE;
+        }
+        if (*(volatile ABT_bool *)&p_worker->exit == ABT_TRUE) {
+            return ABT_FALSE;
+        }
+        ABTD_futex_wait(&p_worker->seq, seq, p_timeout);
+    }
+}
+
+/* Run the ULTs created work-first by the ULT that has just stopped.  A loop is
+ * used so that nested spawns do not grow the stack. */
+static int ABTI_xstream_run_work_first(ABTI_xstream *p_xstream)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread *p_thread;
+
+    while ((p_thread = p_xstream->p_work_first) != NULL) {
+        p_xstream->p_work_first = NULL;
+        p_xstream->stats.num_units++;
+        p_xstream->stats.num_threads++;
+        abt_errno = ABTI_xstream_schedule_thread(p_xstream, p_thread);
+        ABTI_CHECK_ERROR(abt_errno);
     }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Run the ULT in the run-next slot of p_xstream if any (see
+ * ABTI_thread_wake_affine() and ABTI_thread_spawn_run_next()).  Only one ULT
+ * runs per call, i.e., per unit popped from the pools, so that ULTs that wake
+ * up or create each other on the same ES do not starve the pools. */
+static int ABTI_xstream_run_next(ABTI_xstream *p_xstream)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread *p_thread = *(ABTI_thread *volatile *)&p_xstream->p_run_next;
+
+    if (p_thread == NULL || p_thread == ABTI_XSTREAM_RUN_NEXT_CLOSED) {
+        goto fn_exit;
+    }
+    p_thread = (ABTI_thread *)(uintptr_t)ABTD_atomic_exchange_uint64(
+        (uint64_t *)&p_xstream->p_run_next, 0);
+
+    p_xstream->stats.num_units++;
+    p_xstream->stats.num_threads++;
+    abt_errno = ABTI_xstream_schedule_thread(p_xstream, p_thread);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    abt_errno = ABTI_xstream_run_work_first(p_xstream);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Close the run-next slot of p_xstream after its main scheduler has stopped.  A
+ * ULT left in the slot is set ready again in its pool. */
+static void ABTI_xstream_close_run_next(ABTI_xstream *p_xstream)
+{
+    ABTI_thread *p_thread;
+
+    p_thread = (ABTI_thread *)(uintptr_t)ABTD_atomic_exchange_uint64(
+        (uint64_t *)&p_xstream->p_run_next,
+        (uint64_t)(uintptr_t)ABTI_XSTREAM_RUN_NEXT_CLOSED);
+    if (p_thread == NULL || p_thread == ABTI_XSTREAM_RUN_NEXT_CLOSED) return;
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    ABTI_pool_push(p_thread->p_pool, p_thread->unit);
+#else
+    int abt_errno = ABTI_pool_push(p_thread->p_pool, p_thread->unit,
+                                   p_xstream);
+    if (abt_errno != ABT_SUCCESS) HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+#endif
 }
 
+/* Body of ABTI_xstream_check_events(), whose time is accounted to
+ * check_events_time and the scheduler tuning */
+static int ABTI_xstream_check_events_timed(ABTI_xstream *p_xstream,
+                                          ABT_sched sched)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    double start_time, end_time;
+
+    start_time = ABT_get_wtime();
+
+    /* No work unit is running, so this ES is in a quiescent state. */
+    ABTI_rcu_quiescent(p_xstream);
+
+    /* Wake up the ULTs whose timed waits have expired */
+    ABTI_timer_wheel_check(&p_xstream->timer_wheel);
+
+    /* Wake up the ULTs whose file descriptors are ready */
+    ABTI_io_poller_check(&p_xstream->io_poller);
+
+    /* Wake up the ULTs whose MPI requests have completed */
+    ABTI_mpi_poller_check(&p_xstream->mpi_poller);
+
+    /* Wake up the ULTs whose external events have completed */
+    ABTI_completion_check();
+
+    /* Run the poll hooks registered on this ES */
+    ABTI_xstream_check_poll_hooks(p_xstream);
+
+    /* Return unused memory of the memory pool if requested */
+    ABTI_mem_check_trim(start_time);
+
+    if (p_xstream->request & ABTI_XSTREAM_REQ_JOIN) {
+        /* To move the remaining units, the scheduler stops right away. */
+        if (p_xstream->request & ABTI_XSTREAM_REQ_MIGRATE) {
+            abt_errno = ABT_sched_exit(sched);
+        } else {
+            abt_errno = ABT_sched_finish(sched);
+        }
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
+    if ((p_xstream->request & ABTI_XSTREAM_REQ_EXIT) ||
+        (p_xstream->request & ABTI_XSTREAM_REQ_CANCEL)) {
+        abt_errno = ABT_sched_exit(sched);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
+    /* The main scheduler is replaced when it returns. */
+    if ((p_xstream->request & ABTI_XSTREAM_REQ_SWAP) &&
+        p_sched == p_xstream->p_main_sched) {
+        abt_errno = ABT_sched_exit(sched);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
+    // TODO: check event queue
+#ifdef ABT_CONFIG_HANDLE_POWER_EVENT
+    if (ABTI_event_check_power() == ABT_TRUE) {
+        abt_errno = ABT_sched_exit(sched);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+#endif
+    ABTI_EVENT_PUBLISH_INFO();
+
+    /* Publish the summary for the info routines */
+    ABTI_xstream_publish(p_xstream, start_time);
+
+  fn_exit:
+    end_time = ABT_get_wtime();
+    p_xstream->stats.check_events_time += end_time - start_time;
+    if (p_sched && p_sched->tune.enabled == ABT_TRUE) {
+        ABTI_sched_tune_update(p_sched, p_xstream, start_time, end_time);
+    }
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
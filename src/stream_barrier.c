@@ -13,10 +13,10 @@
 typedef struct {
     uint32_t num_waiters;
     ABTD_xstream_barrier bar;
+    ABTI_barrier_tree *p_tree;  /* Arrival tree (NULL if bar is used) */
 } ABTI_xstream_barrier;
 
 
-#ifdef HAVE_PTHREAD_BARRIER_INIT
 static inline
 ABTI_xstream_barrier *ABTI_xstream_barrier_get_ptr(ABT_xstream_barrier barrier)
 {
@@ -48,7 +48,6 @@ ABT_xstream_barrier ABTI_xstream_barrier_get_handle(ABTI_xstream_barrier *p_barr
     return (ABT_xstream_barrier)p_barrier;
 #endif
 }
-#endif
 
 
 /**
@@ -74,6 +73,7 @@ int ABT_xstream_barrier_create(uint32_t num_waiters, ABT_xstream_barrier *newbar
     p_newbarrier = (ABTI_xstream_barrier *)ABTU_malloc(sizeof(ABTI_xstream_barrier));
 
     p_newbarrier->num_waiters = num_waiters;
+    p_newbarrier->p_tree = NULL;
     abt_errno = ABTD_xstream_barrier_init(num_waiters, &p_newbarrier->bar);
     ABTI_CHECK_ERROR(abt_errno);
 
@@ -91,6 +91,52 @@ int ABT_xstream_barrier_create(uint32_t num_waiters, ABT_xstream_barrier *newbar
 #endif
 }
 
+/**
+ * @ingroup ES_BARRIER
+ * @brief   Create a new ES barrier whose arrivals are combined in a tree.
+ *
+ * \c ABT_xstream_barrier_create_tree() creates a new ES barrier like
+ * \c ABT_xstream_barrier_create(), but it does not use the barrier of the
+ * underlying threads package.  The arrivals are counted in a combining tree
+ * whose nodes take up to \c radix children each, and the ESs running on the
+ * same NUMA node start from the same group of leaves.  The waiters spin until
+ * the last one arrives.  If \c radix is zero, a default value is used.
+ *
+ * This barrier is available even if the threads package does not provide a
+ * barrier.
+ *
+ * @param[in]  num_waiters  number of waiters
+ * @param[in]  radix        maximum number of children of each node
+ * @param[out] newbarrier   handle to a new ES barrier
+ * @return Error code
+ * @retval ABT_SUCCESS     on success
+ * @retval ABT_ERR_BARRIER \c num_waiters is zero
+ */
+int ABT_xstream_barrier_create_tree(uint32_t num_waiters, uint32_t radix,
+                                    ABT_xstream_barrier *newbarrier)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream_barrier *p_newbarrier;
+
+    ABTI_CHECK_TRUE(num_waiters > 0, ABT_ERR_BARRIER);
+
+    p_newbarrier = (ABTI_xstream_barrier *)
+        ABTU_malloc(sizeof(ABTI_xstream_barrier));
+    p_newbarrier->num_waiters = num_waiters;
+    p_newbarrier->p_tree = ABTI_barrier_tree_create(num_waiters, radix);
+
+    /* Return value */
+    *newbarrier = ABTI_xstream_barrier_get_handle(p_newbarrier);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    *newbarrier = ABT_XSTREAM_BARRIER_NULL;
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup ES_BARRIER
  * @brief   Free the ES barrier.
@@ -105,14 +151,21 @@ int ABT_xstream_barrier_create(uint32_t num_waiters, ABT_xstream_barrier *newbar
  */
 int ABT_xstream_barrier_free(ABT_barrier *barrier)
 {
-#ifdef HAVE_PTHREAD_BARRIER_INIT
     int abt_errno = ABT_SUCCESS;
     ABT_xstream_barrier h_barrier = *barrier;
     ABTI_xstream_barrier *p_barrier = ABTI_xstream_barrier_get_ptr(h_barrier);
     ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
 
-    abt_errno = ABTD_xstream_barrier_destroy(&p_barrier->bar);
-    ABTI_CHECK_ERROR(abt_errno);
+    if (p_barrier->p_tree) {
+        ABTI_barrier_tree_free(p_barrier->p_tree);
+    } else {
+#ifdef HAVE_PTHREAD_BARRIER_INIT
+        abt_errno = ABTD_xstream_barrier_destroy(&p_barrier->bar);
+        ABTI_CHECK_ERROR(abt_errno);
+#else
+        ABTI_CHECK_TRUE(0, ABT_ERR_FEATURE_NA);
+#endif
+    }
 
     ABTU_free(p_barrier);
 
@@ -125,9 +178,6 @@ int ABT_xstream_barrier_free(ABT_barrier *barrier)
   fn_fail:
     HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
     goto fn_exit;
-#else
-    return ABT_ERR_FEATURE_NA;
-#endif
 }
 
 /**
@@ -143,13 +193,31 @@ int ABT_xstream_barrier_free(ABT_barrier *barrier)
  */
 int ABT_xstream_barrier_wait(ABT_xstream_barrier barrier)
 {
-#ifdef HAVE_PTHREAD_BARRIER_INIT
     int abt_errno = ABT_SUCCESS;
     ABTI_xstream_barrier *p_barrier = ABTI_xstream_barrier_get_ptr(barrier);
     ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
 
-    if (p_barrier->num_waiters > 1) {
+    if (p_barrier->num_waiters <= 1) goto fn_exit;
+
+    if (p_barrier->p_tree) {
+        ABTI_barrier_tree *p_tree = p_barrier->p_tree;
+        ABTI_barrier_tree_node *p_leaf;
+        uint64_t round;
+
+        ABTI_barrier_tree_reserve(p_tree, &round, &p_leaf);
+        if (ABTI_barrier_tree_arrive(p_leaf, round) == ABT_TRUE) {
+            ABTI_barrier_tree_release(p_tree, round);
+        } else {
+            while (ABTI_barrier_tree_is_released(p_tree, round) == ABT_FALSE) {
+                ABTD_atomic_pause();
+            }
+        }
+    } else {
+#ifdef HAVE_PTHREAD_BARRIER_INIT
         ABTD_xstream_barrier_wait(&p_barrier->bar);
+#else
+        ABTI_CHECK_TRUE(0, ABT_ERR_FEATURE_NA);
+#endif
     }
 
   fn_exit:
@@ -158,8 +226,5 @@ int ABT_xstream_barrier_wait(ABT_xstream_barrier barrier)
   fn_fail:
     HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
     goto fn_exit;
-#else
-    return ABT_ERR_FEATURE_NA;
-#endif
 }
 
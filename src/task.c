@@ -6,6 +6,16 @@
 #include "abti.h"
 
 static inline uint64_t ABTI_task_get_new_id(void);
+static int ABTI_task_get_resumable(ABTI_task_resumable **pp_res);
+static void ABTI_task_resume(void *arg);
+static ABTI_task *ABTI_task_alloc(ABTI_local *p_local, ABTI_pool *p_pool,
+                                  void (*task_func)(void *), void *arg,
+                                  int named);
+static ABT_bool ABTI_task_can_run_inline(ABTI_local *p_local,
+                                         ABTI_pool *p_pool);
+
+/* Maximum number of tasklets pushed at once by ABT_task_create_many */
+#define ABTI_TASK_CREATE_MANY_BATCH     64
 
 
 /** @defgroup TASK Tasklet
@@ -40,41 +50,22 @@ int ABT_task_create(ABT_pool pool,
                     ABT_task *newtask)
 {
     int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
     ABTI_task *p_newtask;
     ABT_task h_newtask;
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
 
-    /* Allocate a task object */
-    p_newtask = ABTI_mem_alloc_task();
-
-    p_newtask->p_xstream  = NULL;
-    p_newtask->state      = ABT_TASK_STATE_READY;
-    p_newtask->request    = 0;
-    p_newtask->f_task     = task_func;
-    p_newtask->p_arg      = arg;
-#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
-    p_newtask->is_sched   = NULL;
-#endif
-    p_newtask->p_pool     = p_pool;
-    p_newtask->refcount   = (newtask != NULL) ? 1 : 0;
-    p_newtask->p_keytable = NULL;
-#ifndef ABT_CONFIG_DISABLE_MIGRATION
-    p_newtask->migratable = ABT_TRUE;
-#endif
-    p_newtask->id         = ABTI_TASK_INIT_ID;
-
-    /* Create a wrapper work unit */
+    p_newtask = ABTI_task_alloc(p_local, p_pool, task_func, arg,
+                                newtask != NULL);
     h_newtask = ABTI_task_get_handle(p_newtask);
-    p_newtask->unit = p_pool->u_create_from_task(h_newtask);
-
-    LOG_EVENT("[T%" PRIu64 "] created\n", ABTI_task_get_id(p_newtask));
 
     /* Add this task to the scheduler's pool */
 #ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
     ABTI_pool_push(p_pool, p_newtask->unit);
 #else
-    abt_errno = ABTI_pool_push(p_pool, p_newtask->unit, ABTI_xstream_self());
+    abt_errno = ABTI_pool_push(p_pool, p_newtask->unit,
+                               ABTI_xstream_self_local(p_local));
     if (abt_errno != ABT_SUCCESS) {
         p_newtask->state = ABT_TASK_STATE_CREATED;
         int ret = ABT_task_free(&h_newtask);
@@ -95,12 +86,127 @@ int ABT_task_create(ABT_pool pool,
     goto fn_exit;
 }
 
+/**
+ * @ingroup TASK
+ * @brief   Create multiple tasklets in the target pool at once.
+ *
+ * \c ABT_task_create_many() has the same effect as calling
+ * \c ABT_task_create() \c num_tasks times with \c task_func_list[i] and
+ * \c arg_list[i], but it is cheaper for a large number of tasklets.  The
+ * tasklet objects are allocated in bulk so that consecutive tasklets are
+ * likely to be adjacent in memory, the producer check of \c pool is done only
+ * once, and the tasklets are pushed into \c pool in batches.
+ *
+ * If \c arg_list is \c NULL, \c NULL is passed to all the tasklets.  If
+ * \c newtask_list is \c NULL, all the tasklets are unnamed.  Otherwise, the
+ * handle of the i-th tasklet is returned through \c newtask_list[i].
+ *
+ * @param[in]  pool            handle to the associated pool
+ * @param[in]  num_tasks       the number of tasklets to create
+ * @param[in]  task_func_list  functions to be executed by the new tasklets
+ * @param[in]  arg_list        arguments for the functions
+ * @param[out] newtask_list    handles to the newly created tasklets
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_task_create_many(ABT_pool pool, int num_tasks,
+                         void (**task_func_list)(void *), void **arg_list,
+                         ABT_task *newtask_list)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task *p_tasks[ABTI_TASK_CREATE_MANY_BATCH];
+    ABT_unit units[ABTI_TASK_CREATE_MANY_BATCH];
+    int i, j, num;
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+    ABTI_CHECK_TRUE(num_tasks >= 0, ABT_ERR_OTHER);
+    if (num_tasks == 0) goto fn_exit;
+
+#ifndef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    /* Save the producer ES information in the pool */
+    abt_errno = ABTI_pool_set_producer(p_pool, ABTI_xstream_self());
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+    for (i = 0; i < num_tasks; i += num) {
+        num = num_tasks - i;
+        if (num > ABTI_TASK_CREATE_MANY_BATCH) {
+            num = ABTI_TASK_CREATE_MANY_BATCH;
+        }
+
+        /* Allocate tasklet objects */
+        ABTI_mem_alloc_tasks(ABTI_local_get_local(), num, p_tasks);
+
+        for (j = 0; j < num; j++) {
+            ABTI_task *p_newtask = p_tasks[j];
+
+            p_newtask->p_xstream  = NULL;
+            p_newtask->state      = ABT_TASK_STATE_READY;
+            p_newtask->request    = 0;
+            p_newtask->f_task     = task_func_list[i + j];
+            p_newtask->p_arg      = arg_list ? arg_list[i + j] : NULL;
+#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+            p_newtask->is_sched   = NULL;
+#endif
+            p_newtask->p_pool     = p_pool;
+            p_newtask->refcount   = newtask_list ? 1 : 0;
+            p_newtask->detach     = ABTI_DETACH_NONE;
+            p_newtask->p_keytable = NULL;
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+            p_newtask->migratable = ABT_TRUE;
+#endif
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+            p_newtask->cpu_ticks  = 0;
+#endif
+            p_newtask->id         = ABTI_TASK_INIT_ID;
+
+            /* Create a wrapper work unit */
+            p_newtask->unit = ABTI_pool_unit_create_task(p_pool, p_newtask);
+            units[j] = p_newtask->unit;
+
+            LOG_EVENT("[T%" PRIu64 "] created\n",
+                      ABTI_task_get_id(p_newtask));
+            ABTI_trace_task(ABTI_TRACE_CREATE, p_newtask);
+            ABTI_record_create_task(p_newtask);
+            LOG_EVENT_POOL_PUSH(p_pool, units[j], ABTI_xstream_self());
+            ABTI_trace_unit(ABTI_TRACE_PUSH, p_pool, units[j]);
+            ABTI_unit_stats_push(p_pool, units[j]);
+
+            /* Return value */
+            if (newtask_list) {
+                newtask_list[i + j] = ABTI_task_get_handle(p_newtask);
+            }
+        }
+
+        /* Add this batch of tasklets to the pool */
+        if (p_pool->p_push_many) {
+            p_pool->p_push_many(pool, units, num);
+            ABTI_pool_stats_add(p_pool, ABTI_POOL_STATS_PUSH, num);
+        } else {
+            for (j = 0; j < num; j++) {
+                ABTI_pool_call_push(p_pool, units[j]);
+            }
+        }
+        ABTI_POOL_UNPARK(p_pool);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (newtask_list) {
+        for (i = 0; i < num_tasks; i++) newtask_list[i] = ABT_TASK_NULL;
+    }
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /* This routine is to create a tasklet for the scheduler. */
 int ABTI_task_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched)
 {
     int abt_errno = ABT_SUCCESS;
     ABTI_task *p_newtask;
-    ABT_task h_newtask;
 
     /* If p_sched is reused, ABT_task_revive() can be used. */
     if (p_sched->p_task) {
@@ -114,7 +220,7 @@ int ABTI_task_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched)
     }
 
     /* Allocate a task object */
-    p_newtask = ABTI_mem_alloc_task();
+    p_newtask = ABTI_mem_alloc_task(ABTI_local_get_local());
 
     p_newtask->p_xstream  = NULL;
     p_newtask->state      = ABT_TASK_STATE_READY;
@@ -126,17 +232,22 @@ int ABTI_task_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched)
 #endif
     p_newtask->p_pool     = p_pool;
     p_newtask->refcount   = 1;
+    p_newtask->detach     = ABTI_DETACH_NONE;
     p_newtask->p_keytable = NULL;
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     p_newtask->migratable = ABT_TRUE;
+#endif
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_newtask->cpu_ticks  = 0;
 #endif
     p_newtask->id         = ABTI_TASK_INIT_ID;
 
     /* Create a wrapper unit */
-    h_newtask = ABTI_task_get_handle(p_newtask);
-    p_newtask->unit = p_pool->u_create_from_task(h_newtask);
+    p_newtask->unit = ABTI_pool_unit_create_task(p_pool, p_newtask);
 
     LOG_EVENT("[T%" PRIu64 "] created\n", ABTI_task_get_id(p_newtask));
+    ABTI_trace_task(ABTI_TRACE_CREATE, p_newtask);
+    ABTI_record_create_task(p_newtask);
 
     /* Save the tasklet pointer in p_sched */
     p_sched->p_task = p_newtask;
@@ -215,6 +326,302 @@ int ABT_task_create_on_xstream(ABT_xstream xstream, void (*task_func)(void *),
     goto fn_exit;
 }
 
+/**
+ * @ingroup TASK
+ * @brief   Create an unnamed tasklet that may be batched with others.
+ *
+ * \c ABT_task_create_batched() has the same effect as \c ABT_task_create()
+ * with \c newtask \c NULL, but it is intended for tiny tasklets whose
+ * creation, scheduling, and release would cost more than their work.
+ * Consecutive calls on the same ES with the same \c pool and \c task_func
+ * append \c arg to a batch, and the batch is pushed into \c pool as one
+ * tasklet that calls \c task_func for the arguments back to back in order.
+ *
+ * A batch is pushed when it has \c ABT_TASK_BATCH_SIZE tasklets, when it has
+ * been open longer than \c ABT_TASK_BATCH_LATENCY microseconds, when a
+ * tasklet with another \c pool or \c task_func is batched, when the caller
+ * returns to the scheduler, e.g., by finishing or yielding, or when
+ * \c ABT_task_flush_batch() is called.  An external thread creates the
+ * tasklet directly.
+ *
+ * @param[in] pool       handle to the associated pool
+ * @param[in] task_func  function to be executed by the tasklet
+ * @param[in] arg        argument for task_func
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_task_create_batched(ABT_pool pool, void (*task_func)(void *),
+                            void *arg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = lp_ABTI_local;
+    ABTI_task_batch *p_batch;
+    uint32_t max_tasks;
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    max_tasks = gp_ABTI_global->task_batch_size;
+    if (p_local == NULL || max_tasks <= 1) {
+        abt_errno = ABT_task_create(pool, task_func, arg, NULL);
+        ABTI_CHECK_ERROR(abt_errno);
+        goto fn_exit;
+    }
+
+    p_batch = p_local->p_task_batch;
+    if (p_batch != NULL &&
+        (p_batch->p_pool != p_pool || p_batch->f_task != task_func)) {
+        ABTI_task_flush_batch(p_local);
+        p_batch = NULL;
+    }
+    if (p_batch == NULL) {
+        p_batch = (ABTI_task_batch *)ABTU_malloc(sizeof(ABTI_task_batch) +
+                                                 max_tasks * sizeof(void *));
+        p_batch->p_pool = p_pool;
+        p_batch->f_task = task_func;
+        p_batch->num_tasks = 0;
+        p_batch->start_ticks = ABTD_time_get_ticks();
+        p_batch->p_args = (void **)(p_batch + 1);
+        p_local->p_task_batch = p_batch;
+    }
+    p_batch->p_args[p_batch->num_tasks++] = arg;
+
+    if (p_batch->num_tasks == max_tasks ||
+        ABTD_time_ticks_to_sec(ABTD_time_get_ticks() - p_batch->start_ticks)
+            >= gp_ABTI_global->task_batch_latency) {
+        ABTI_task_flush_batch(p_local);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TASK
+ * @brief   Push the batch of tasklets of the calling ES.
+ *
+ * \c ABT_task_flush_batch() pushes the tasklets batched by
+ * \c ABT_task_create_batched() on the calling ES without waiting for the
+ * batch to be full.  It does nothing if there is no batch or the caller is an
+ * external thread.
+ *
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_task_flush_batch(void)
+{
+    ABTI_local *p_local = lp_ABTI_local;
+
+    if (p_local != NULL && p_local->p_task_batch != NULL) {
+        ABTI_task_flush_batch(p_local);
+    }
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup TASK
+ * @brief   Create a tasklet that may run right away on the calling ES.
+ *
+ * \c ABT_task_create_inline() has the same effect as \c ABT_task_create(),
+ * but it is intended for tiny tasklets, e.g., continuations, whose creator
+ * cannot do anything useful until they complete.  If the caller runs on an
+ * ES whose current scheduler takes units from \c pool and \c pool is empty,
+ * so the ES would run the tasklet as soon as the caller stopped, the tasklet
+ * is not pushed but runs to completion on the caller's stack before this
+ * routine returns, which saves the push, the pop, and the dispatch.
+ *
+ * Tasklets run inline may create other tasklets inline.  To bound the stack
+ * used by such chains, no more than \c ABT_TASK_INLINE_DEPTH of them are
+ * nested on an ES; beyond that, and in any other case, the tasklet is pushed
+ * into \c pool like \c ABT_task_create() does.  Tasklets are not run inline
+ * while schedules are recorded or replayed.
+ *
+ * @param[in]  pool       handle to the associated pool
+ * @param[in]  task_func  function to be executed by the tasklet
+ * @param[in]  arg        argument for task_func
+ * @param[out] newtask    handle to a newly created tasklet
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_task_create_inline(ABT_pool pool, void (*task_func)(void *),
+                           void *arg, ABT_task *newtask)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = lp_ABTI_local;
+    ABTI_xstream *p_xstream;
+    ABTI_thread *p_last_thread;
+    ABTI_task *p_last_task, *p_newtask;
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    if (ABTI_task_can_run_inline(p_local, p_pool) == ABT_FALSE) {
+        abt_errno = ABT_task_create(pool, task_func, arg, newtask);
+        ABTI_CHECK_ERROR(abt_errno);
+        goto fn_exit;
+    }
+
+    p_newtask = ABTI_task_alloc(p_local, p_pool, task_func, arg,
+                                newtask != NULL);
+    /* An unnamed tasklet is freed when it terminates. */
+    if (newtask) *newtask = ABTI_task_get_handle(p_newtask);
+
+    /* The caller is charged the time until now and resumes afterward as if
+     * it had been scheduled again. */
+    p_xstream = p_local->p_xstream;
+    p_last_thread = p_local->p_thread;
+    p_last_task = p_local->p_task;
+    if (p_last_thread != NULL) {
+        ABTI_cpu_time_stop_thread(p_xstream, p_last_thread);
+    } else if (p_last_task != NULL) {
+        ABTI_cpu_time_stop_task(p_xstream, p_last_task);
+    }
+
+    LOG_EVENT("[T%" PRIu64 ":E%" PRIu64 "] run inline\n",
+              ABTI_task_get_id(p_newtask), p_xstream->rank);
+    p_local->task_inline_depth++;
+    p_xstream->stats.num_units++;
+    p_xstream->stats.num_tasks++;
+    ABTI_xstream_schedule_task(p_xstream, p_newtask);
+    p_local->task_inline_depth--;
+
+    ABTI_local_set_thread(p_last_thread);
+    ABTI_local_set_task(p_last_task);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (newtask) *newtask = ABT_TASK_NULL;
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TASK
+ * @brief   Create a new resumable tasklet.
+ *
+ * \c ABT_task_create_resumable() creates a tasklet that is pushed into
+ * \c pool like \c ABT_task_create(), but \c task_func can be invoked more than
+ * once, so that a state machine can wait for a dependency without a ULT
+ * stack.  \c task_func is first invoked with state 0 and \c arg.  If it
+ * returns \c ABT_TASK_RESUMABLE_DONE, the tasklet terminates.  Otherwise, the
+ * returned value is passed to the next invocation of \c task_func.  If
+ * \c task_func has called \c ABT_task_await_eventual() or
+ * \c ABT_task_await_future() before returning, the tasklet is pushed into its
+ * pool again once the dependency becomes ready; otherwise, it is pushed back
+ * at once as if it yielded.
+ *
+ * Local variables of \c task_func are not kept across invocations, so the
+ * state that has to survive must be kept in \c arg or encoded in the returned
+ * value.  A named tasklet is in the \c ABT_TASK_STATE_READY state while it is
+ * waiting, and \c ABT_task_join() and \c ABT_task_free() wait until it
+ * terminates.
+ *
+ * @param[in]  pool       handle to the associated pool
+ * @param[in]  task_func  function to be executed by the new tasklet
+ * @param[in]  arg        argument for task_func
+ * @param[out] newtask    handle to a newly created tasklet
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_task_create_resumable(ABT_pool pool, int (*task_func)(int, void *),
+                              void *arg, ABT_task *newtask)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_resumable *p_res;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    p_res = (ABTI_task_resumable *)ABTU_malloc(sizeof(ABTI_task_resumable));
+    p_res->f_task = task_func;
+    p_res->p_arg = arg;
+    p_res->state = 0;
+    p_res->await_kind = ABTI_TASK_AWAIT_NONE;
+
+    /* If the push fails, p_res is freed together with the tasklet. */
+    abt_errno = ABT_task_create(pool, ABTI_task_run_resumable, p_res, newtask);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (newtask) *newtask = ABT_TASK_NULL;
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TASK
+ * @brief   Make the calling resumable tasklet wait for an eventual.
+ *
+ * \c ABT_task_await_eventual() does not block.  It records \c eventual so
+ * that the calling resumable tasklet is invoked again after \c eventual
+ * becomes ready once the current invocation returns a value other than
+ * \c ABT_TASK_RESUMABLE_DONE.  If it is called more than once in one
+ * invocation, the last dependency is used.
+ *
+ * @param[in] eventual  handle to the eventual
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_TASK the caller is not a resumable tasklet
+ */
+int ABT_task_await_eventual(ABT_eventual eventual)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_resumable *p_res;
+    ABTI_CHECK_NULL_EVENTUAL_PTR(ABTI_eventual_get_ptr(eventual));
+
+    abt_errno = ABTI_task_get_resumable(&p_res);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_res->await_kind = ABTI_TASK_AWAIT_EVENTUAL;
+    p_res->await.eventual = eventual;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TASK
+ * @brief   Make the calling resumable tasklet wait for a future.
+ *
+ * \c ABT_task_await_future() is the same as \c ABT_task_await_eventual()
+ * except that the calling resumable tasklet is invoked again after all the
+ * compartments of \c future have been set.
+ *
+ * @param[in] future  handle to the future
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_TASK the caller is not a resumable tasklet
+ */
+int ABT_task_await_future(ABT_future future)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_resumable *p_res;
+    ABTI_CHECK_NULL_FUTURE_PTR(ABTI_future_get_ptr(future));
+
+    abt_errno = ABTI_task_get_resumable(&p_res);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_res->await_kind = ABTI_TASK_AWAIT_FUTURE;
+    p_res->await.future = future;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup TASK
  * @brief   Revive the tasklet.
@@ -246,23 +653,33 @@ int ABT_task_revive(ABT_pool pool, void (*task_func)(void *), void *arg,
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
 
+    if (p_task->f_task == ABTI_task_run_resumable) ABTU_free(p_task->p_arg);
+
     p_task->p_xstream  = NULL;
     p_task->state      = ABT_TASK_STATE_READY;
     p_task->request    = 0;
     p_task->f_task     = task_func;
     p_task->p_arg      = arg;
     p_task->refcount   = 1;
-    p_task->p_keytable = NULL;
+    p_task->detach     = ABTI_DETACH_NONE;
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_task->cpu_ticks  = 0;
+#endif
+
+    /* The key-value table is kept but emptied. */
+    if (p_task->p_keytable) {
+        ABTI_ktable_clear(p_task->p_keytable);
+    }
 
     if (p_task->p_pool != p_pool) {
         /* Free the unit for the old pool */
-        p_task->p_pool->u_free(&p_task->unit);
+        ABTI_pool_unit_free(p_task->p_pool, &p_task->unit);
 
         /* Set the new pool */
         p_task->p_pool = p_pool;
 
         /* Create a wrapper work unit */
-        p_task->unit = p_pool->u_create_from_task(*task);
+        p_task->unit = ABTI_pool_unit_create_task(p_pool, p_task);
     }
 
     LOG_EVENT("[T%" PRIu64 "] revived\n", ABTI_task_get_id(p_task));
@@ -323,6 +740,48 @@ int ABT_task_free(ABT_task *task)
     goto fn_exit;
 }
 
+/**
+ * @ingroup TASK
+ * @brief   Give up the handle of a tasklet so that it is freed when it
+ *          terminates.
+ *
+ * \c ABT_task_detach() turns \c task into an unnamed tasklet, as if it had
+ * been created with \c NULL for its handle: the ES that terminates it frees
+ * it right away into the memory pool of the ES.  If \c task has already
+ * terminated, it is freed by this routine.  The handle must not be used after
+ * this routine, and \c task is set to \c ABT_TASK_NULL.
+ *
+ * @param[in,out] task  handle to the target tasklet
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_task_detach(ABT_task *task)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task *p_task = ABTI_task_get_ptr(*task);
+    ABTI_CHECK_NULL_TASK_PTR(p_task);
+
+    if (ABTD_atomic_cas_uint32(&p_task->detach, ABTI_DETACH_NONE,
+                               ABTI_DETACH_DETACHED) != ABTI_DETACH_NONE) {
+        /* The tasklet has ended.  Its ES sets the state right after that. */
+        while (*(volatile ABT_task_state *)&p_task->state !=
+               ABT_TASK_STATE_TERMINATED) {
+            ABTD_atomic_pause();
+        }
+        ABTI_task_free(p_task);
+    }
+
+    /* Return value */
+    *task = ABT_TASK_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup TASK
  * @brief   Wait for the tasklet to terminate.
@@ -766,6 +1225,48 @@ int ABT_task_get_id(ABT_task task, uint64_t *task_id)
     goto fn_exit;
 }
 
+/**
+ * @ingroup TASK
+ * @brief   Get the CPU time of the tasklet.
+ *
+ * \c ABT_task_get_cpu_time() returns the time in seconds for which an ES has
+ * run \c task.  The time of a running tasklet is counted when it returns.
+ *
+ * The CPU time is measured only if the environment variable
+ * \c ABT_CPU_TIME is set.
+ *
+ * @param[in]  task      handle to the target tasklet
+ * @param[out] cpu_time  CPU time in seconds
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA \c ABT_CPU_TIME is not set or Argobots is
+ *                            configured with --enable-feature=no-cpu-time
+ */
+int ABT_task_get_cpu_time(ABT_task task, double *cpu_time)
+{
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    int abt_errno = ABT_SUCCESS;
+
+    ABTI_task *p_task = ABTI_task_get_ptr(task);
+    ABTI_CHECK_NULL_TASK_PTR(p_task);
+    ABTI_CHECK_TRUE(gp_ABTI_global->use_cpu_time == ABT_TRUE,
+                    ABT_ERR_FEATURE_NA);
+
+    *cpu_time = ABTD_time_ticks_to_sec(p_task->cpu_ticks);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(task);
+    ABTI_UNUSED(cpu_time);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
 /**
  * @ingroup TASK
  * @brief   Retrieve the argument for the tasklet function
@@ -785,7 +1286,11 @@ int ABT_task_get_arg(ABT_task task, void **arg)
     ABTI_task *p_task = ABTI_task_get_ptr(task);
     ABTI_CHECK_NULL_THREAD_PTR(p_task);
 
-    *arg = p_task->p_arg;
+    if (p_task->f_task == ABTI_task_run_resumable) {
+        *arg = ((ABTI_task_resumable *)p_task->p_arg)->p_arg;
+    } else {
+        *arg = p_task->p_arg;
+    }
 
   fn_exit:
     return abt_errno;
@@ -805,16 +1310,97 @@ void ABTI_task_free(ABTI_task *p_task)
     LOG_EVENT("[T%" PRIu64 "] freed\n", ABTI_task_get_id(p_task));
 
     /* Free the unit */
-    p_task->p_pool->u_free(&p_task->unit);
+    ABTI_pool_unit_free(p_task->p_pool, &p_task->unit);
 
     /* Free the key-value table */
     if (p_task->p_keytable) {
         ABTI_ktable_free(p_task->p_keytable);
     }
 
+    if (p_task->f_task == ABTI_task_run_resumable) ABTU_free(p_task->p_arg);
+
     ABTI_mem_free_task(p_task);
 }
 
+/* Task function of resumable tasklets */
+void ABTI_task_run_resumable(void *arg)
+{
+    ABTI_task_resumable *p_res = (ABTI_task_resumable *)arg;
+
+    p_res->await_kind = ABTI_TASK_AWAIT_NONE;
+    p_res->state = p_res->f_task(p_res->state, p_res->p_arg);
+    if (p_res->state != ABT_TASK_RESUMABLE_DONE) {
+        ABTI_task_set_request(ABTI_local_get_task(), ABTI_TASK_REQ_RESUME);
+    }
+}
+
+/* Called by the ES after an invocation of a resumable tasklet returns.
+ * Once the continuation is registered, p_task can be pushed and run by
+ * another ES, so it must not be accessed after that. */
+void ABTI_task_suspend_resumable(ABTI_task *p_task)
+{
+    ABTI_task_resumable *p_res = (ABTI_task_resumable *)p_task->p_arg;
+    int abt_errno = ABT_SUCCESS;
+
+    LOG_EVENT("[T%" PRIu64 ":E%" PRIu64 "] suspended\n",
+              ABTI_task_get_id(p_task), p_task->p_xstream->rank);
+    p_task->state = ABT_TASK_STATE_READY;
+
+    switch (p_res->await_kind) {
+        case ABTI_TASK_AWAIT_EVENTUAL:
+            abt_errno = ABT_eventual_then(p_res->await.eventual,
+                                          ABTI_task_resume, p_task,
+                                          ABT_POOL_NULL);
+            break;
+        case ABTI_TASK_AWAIT_FUTURE:
+            abt_errno = ABT_future_then(p_res->await.future,
+                                        ABTI_task_resume, p_task,
+                                        ABT_POOL_NULL);
+            break;
+        default:
+            ABTI_task_resume(p_task);
+            break;
+    }
+    /* The tasklet must not be lost if the dependency has become invalid. */
+    if (abt_errno != ABT_SUCCESS) ABTI_task_resume(p_task);
+}
+
+/* Task function of a batch, which is freed after the last call */
+static void ABTI_task_run_batch(void *arg)
+{
+    ABTI_task_batch *p_batch = (ABTI_task_batch *)arg;
+    uint32_t i;
+
+    for (i = 0; i < p_batch->num_tasks; i++) {
+        p_batch->f_task(p_batch->p_args[i]);
+    }
+    ABTU_free(p_batch);
+}
+
+/* Push the open batch of p_local.  A single tasklet is pushed as it is.  If
+ * the pool refuses the batch, it is executed by the caller so that no
+ * tasklet is lost. */
+void ABTI_task_flush_batch(ABTI_local *p_local)
+{
+    ABTI_task_batch *p_batch = p_local->p_task_batch;
+    ABT_pool pool = ABTI_pool_get_handle(p_batch->p_pool);
+    int abt_errno;
+
+    p_local->p_task_batch = NULL;
+    if (p_batch->num_tasks == 1) {
+        abt_errno = ABT_task_create(pool, p_batch->f_task,
+                                    p_batch->p_args[0], NULL);
+        if (abt_errno == ABT_SUCCESS) {
+            ABTU_free(p_batch);
+            return;
+        }
+    } else {
+        abt_errno = ABT_task_create(pool, ABTI_task_run_batch, p_batch, NULL);
+        if (abt_errno == ABT_SUCCESS) return;
+    }
+    ABTI_task_run_batch(p_batch);
+}
+
 void ABTI_task_print(ABTI_task *p_task, FILE *p_os, int indent)
 {
     char *prefix = ABTU_get_indent_str(indent);
@@ -891,6 +1477,71 @@ void ABTI_task_release(ABTI_task *p_task)
     }
 }
 
+/* Allocate and initialize a tasklet of p_pool, which is not pushed yet */
+static ABTI_task *ABTI_task_alloc(ABTI_local *p_local, ABTI_pool *p_pool,
+                                  void (*task_func)(void *), void *arg,
+                                  int named)
+{
+    ABTI_task *p_newtask;
+
+    /* Allocate a task object */
+    p_newtask = ABTI_mem_alloc_task(p_local);
+
+    p_newtask->p_xstream  = NULL;
+    p_newtask->state      = ABT_TASK_STATE_READY;
+    p_newtask->request    = 0;
+    p_newtask->f_task     = task_func;
+    p_newtask->p_arg      = arg;
+#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+    p_newtask->is_sched   = NULL;
+#endif
+    p_newtask->p_pool     = p_pool;
+    p_newtask->refcount   = named ? 1 : 0;
+    p_newtask->detach     = ABTI_DETACH_NONE;
+    p_newtask->p_keytable = NULL;
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+    p_newtask->migratable = ABT_TRUE;
+#endif
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_newtask->cpu_ticks  = 0;
+#endif
+    p_newtask->id         = ABTI_TASK_INIT_ID;
+
+    /* Create a wrapper work unit */
+    p_newtask->unit = ABTI_pool_unit_create_task(p_pool, p_newtask);
+
+    LOG_EVENT("[T%" PRIu64 "] created\n", ABTI_task_get_id(p_newtask));
+    ABTI_trace_task(ABTI_TRACE_CREATE, p_newtask);
+    ABTI_record_create_task(p_newtask);
+    return p_newtask;
+}
+
+/* Whether a tasklet of p_pool can run inline on the calling ES: the caller
+ * is a unit on an ES, the nesting is below ABT_TASK_INLINE_DEPTH, and the
+ * current scheduler of the ES takes units from p_pool, which is empty. */
+static ABT_bool ABTI_task_can_run_inline(ABTI_local *p_local,
+                                         ABTI_pool *p_pool)
+{
+    ABTI_xstream *p_xstream;
+    ABTI_sched *p_sched;
+    int i;
+
+    if (p_local == NULL || p_local->p_xstream == NULL) return ABT_FALSE;
+    if (p_local->p_thread == NULL && p_local->p_task == NULL) return ABT_FALSE;
+    if (p_local->task_inline_depth >= gp_ABTI_global->task_inline_depth) {
+        return ABT_FALSE;
+    }
+    if (gp_ABTI_global->sched_record != ABTI_RECORD_OFF) return ABT_FALSE;
+
+    p_xstream = p_local->p_xstream;
+    p_sched = ABTI_xstream_get_top_sched(p_xstream);
+    for (i = 0; i < p_sched->num_pools; i++) {
+        if (ABTI_pool_get_ptr(p_sched->pools[i]) == p_pool) break;
+    }
+    if (i == p_sched->num_pools) return ABT_FALSE;
+    return (ABTI_pool_call_get_size(p_pool) == 0) ? ABT_TRUE : ABT_FALSE;
+}
+
 static uint64_t g_task_id = 0;
 void ABTI_task_reset_id(void)
 {
@@ -899,8 +1550,10 @@ void ABTI_task_reset_id(void)
 
 uint64_t ABTI_task_get_id(ABTI_task *p_task)
 {
+    /* Assigned on the first request as ABTI_thread_get_id() does */
     if (p_task->id == ABTI_TASK_INIT_ID) {
-        p_task->id = ABTI_task_get_new_id();
+        ABTD_atomic_cas_uint64(&p_task->id, ABTI_TASK_INIT_ID,
+                               ABTI_task_get_new_id());
     }
     return p_task->id;
 }
@@ -909,8 +1562,49 @@ uint64_t ABTI_task_get_id(ABTI_task *p_task)
 /* Internal static functions                                                 */
 /*****************************************************************************/
 
+/* Get the state of the calling resumable tasklet */
+static int ABTI_task_get_resumable(ABTI_task_resumable **pp_res)
+{
+    ABTI_task *p_task;
+
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    if (lp_ABTI_local == NULL) return ABT_ERR_INV_XSTREAM;
+#endif
+    p_task = ABTI_local_get_task();
+    if (p_task == NULL || p_task->f_task != ABTI_task_run_resumable) {
+        return ABT_ERR_INV_TASK;
+    }
+    *pp_res = (ABTI_task_resumable *)p_task->p_arg;
+    return ABT_SUCCESS;
+}
+
+/* Push the resumable tasklet into its pool again */
+static void ABTI_task_resume(void *arg)
+{
+    ABTI_task *p_task = (ABTI_task *)arg;
+
+    LOG_EVENT("[T%" PRIu64 "] resumed\n", ABTI_task_get_id(p_task));
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    ABTI_pool_push(p_task->p_pool, p_task->unit);
+#else
+    int abt_errno = ABTI_pool_push(p_task->p_pool, p_task->unit,
+                                   ABTI_xstream_self());
+    if (abt_errno != ABT_SUCCESS) HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+#endif
+}
+
+/* IDs are taken in blocks as ABTI_thread_get_new_id() does. */
 static inline uint64_t ABTI_task_get_new_id(void)
 {
-    return ABTD_atomic_fetch_add_uint64(&g_task_id, 1);
+    ABTI_xstream *p_xstream = lp_ABTI_local ? ABTI_local_get_xstream() : NULL;
+    if (p_xstream == NULL) {
+        return ABTD_atomic_fetch_add_uint64(&g_task_id, 1);
+    }
+    if (p_xstream->task_id_next == p_xstream->task_id_end) {
+        p_xstream->task_id_next =
+            ABTD_atomic_fetch_add_uint64(&g_task_id, ABTI_ID_BLOCK_SIZE);
+        p_xstream->task_id_end = p_xstream->task_id_next + ABTI_ID_BLOCK_SIZE;
+    }
+    return p_xstream->task_id_next++;
 }
 
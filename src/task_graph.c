@@ -0,0 +1,393 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Maximum number of ready successors pushed at once */
+#define ABTI_TASK_GRAPH_PUSH_BATCH  16
+
+static void ABTI_task_graph_run_node(void *arg);
+static void ABTI_task_graph_push(ABTI_task_graph_node **p_nodes, int num,
+                                 ABT_pool pool, ABT_pool alt_pool);
+static ABT_bool ABTI_task_graph_is_acyclic(ABTI_task_graph *p_graph);
+
+
+/** @defgroup TASK_GRAPH Task Graph
+ * A \a task graph is a directed acyclic graph of tasklets.  Each node of the
+ * graph is a tasklet, and an edge from one node to another means that the
+ * latter can start only after the former completes.  Unlike futures and
+ * eventuals, dependencies are resolved without blocking any ULT: when a node
+ * completes, the successors whose predecessors have all completed are pushed
+ * into the pool of the ES that executed the node.
+ */
+
+/**
+ * @ingroup TASK_GRAPH
+ * @brief   Create a new task graph.
+ *
+ * \c ABT_task_graph_create() creates an empty task graph and returns its
+ * handle through \c newgraph.
+ *
+ * @param[out] newgraph  handle to a new task graph
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_task_graph_create(ABT_task_graph *newgraph)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_graph *p_newgraph;
+
+    p_newgraph = (ABTI_task_graph *)ABTU_malloc(sizeof(ABTI_task_graph));
+    p_newgraph->num_nodes   = 0;
+    p_newgraph->max_nodes   = 0;
+    p_newgraph->p_nodes     = NULL;
+    p_newgraph->running     = ABT_FALSE;
+    p_newgraph->pool        = ABT_POOL_NULL;
+    p_newgraph->num_remains = 0;
+    p_newgraph->eventual    = ABT_EVENTUAL_NULL;
+
+    /* Return value */
+    *newgraph = ABTI_task_graph_get_handle(p_newgraph);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup TASK_GRAPH
+ * @brief   Free the task graph.
+ *
+ * \c ABT_task_graph_free() deallocates the resource used for the task graph
+ * \c graph and sets \c graph to \c ABT_TASK_GRAPH_NULL.  A running graph
+ * cannot be freed; \c ABT_task_graph_wait() has to be called first.
+ *
+ * @param[in,out] graph  handle to the task graph
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_TASK_GRAPH \c graph is running
+ */
+int ABT_task_graph_free(ABT_task_graph *graph)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_graph *p_graph = ABTI_task_graph_get_ptr(*graph);
+    int i;
+
+    ABTI_CHECK_NULL_TASK_GRAPH_PTR(p_graph);
+    ABTI_CHECK_TRUE(p_graph->running == ABT_FALSE, ABT_ERR_TASK_GRAPH);
+
+    for (i = 0; i < p_graph->num_nodes; i++) {
+        ABTI_task_graph_node *p_node = &p_graph->p_nodes[i];
+        if (p_node->p_succs) ABTU_free(p_node->p_succs);
+    }
+    if (p_graph->p_nodes) ABTU_free(p_graph->p_nodes);
+    ABTU_free(p_graph);
+
+    /* Return value */
+    *graph = ABT_TASK_GRAPH_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TASK_GRAPH
+ * @brief   Add a tasklet to the task graph.
+ *
+ * \c ABT_task_graph_add_task() adds a node that executes
+ * <tt>task_func(arg)</tt> to \c graph and returns the ID of the node through
+ * \c node_id.  IDs are assigned from zero in the order of addition.  Nodes
+ * cannot be added to a running graph.
+ *
+ * @param[in]  graph      handle to the task graph
+ * @param[in]  task_func  function to be executed by the tasklet
+ * @param[in]  arg        argument for \c task_func
+ * @param[out] node_id    ID of the new node
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_TASK_GRAPH \c graph is running
+ */
+int ABT_task_graph_add_task(ABT_task_graph graph, void (*task_func)(void *),
+                            void *arg, int *node_id)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_graph *p_graph = ABTI_task_graph_get_ptr(graph);
+    ABTI_task_graph_node *p_node;
+
+    ABTI_CHECK_NULL_TASK_GRAPH_PTR(p_graph);
+    ABTI_CHECK_TRUE(p_graph->running == ABT_FALSE, ABT_ERR_TASK_GRAPH);
+
+    if (p_graph->num_nodes == p_graph->max_nodes) {
+        int max_nodes = (p_graph->max_nodes == 0) ? 16
+                      : p_graph->max_nodes * 2;
+        p_graph->p_nodes = (ABTI_task_graph_node *)ABTU_realloc(
+                p_graph->p_nodes, max_nodes * sizeof(ABTI_task_graph_node));
+        p_graph->max_nodes = max_nodes;
+    }
+
+    p_node = &p_graph->p_nodes[p_graph->num_nodes];
+    p_node->f_task      = task_func;
+    p_node->p_arg       = arg;
+    p_node->p_graph     = p_graph;
+    p_node->num_preds   = 0;
+    p_node->num_pending = 0;
+    p_node->num_succs   = 0;
+    p_node->max_succs   = 0;
+    p_node->p_succs     = NULL;
+
+    /* Return value */
+    if (node_id) *node_id = p_graph->num_nodes;
+    p_graph->num_nodes++;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TASK_GRAPH
+ * @brief   Add a dependency between two nodes of the task graph.
+ *
+ * \c ABT_task_graph_add_dep() makes the node \c succ_id start only after the
+ * node \c pred_id completes.  Dependencies cannot be added to a running
+ * graph.
+ *
+ * @param[in] graph    handle to the task graph
+ * @param[in] pred_id  ID of the predecessor
+ * @param[in] succ_id  ID of the successor
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_TASK_GRAPH \c graph is running or an ID is invalid
+ */
+int ABT_task_graph_add_dep(ABT_task_graph graph, int pred_id, int succ_id)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_graph *p_graph = ABTI_task_graph_get_ptr(graph);
+    ABTI_task_graph_node *p_pred;
+
+    ABTI_CHECK_NULL_TASK_GRAPH_PTR(p_graph);
+    ABTI_CHECK_TRUE(p_graph->running == ABT_FALSE, ABT_ERR_TASK_GRAPH);
+    ABTI_CHECK_TRUE(pred_id >= 0 && pred_id < p_graph->num_nodes &&
+                    succ_id >= 0 && succ_id < p_graph->num_nodes &&
+                    pred_id != succ_id, ABT_ERR_TASK_GRAPH);
+
+    p_pred = &p_graph->p_nodes[pred_id];
+    if (p_pred->num_succs == p_pred->max_succs) {
+        int max_succs = (p_pred->max_succs == 0) ? 4 : p_pred->max_succs * 2;
+        p_pred->p_succs = (int *)ABTU_realloc(p_pred->p_succs,
+                                              max_succs * sizeof(int));
+        p_pred->max_succs = max_succs;
+    }
+    p_pred->p_succs[p_pred->num_succs++] = succ_id;
+    p_graph->p_nodes[succ_id].num_preds++;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TASK_GRAPH
+ * @brief   Start executing the task graph.
+ *
+ * \c ABT_task_graph_run() pushes the nodes that have no predecessor into
+ * \c pool as tasklets and returns without waiting for their completion.  When
+ * a node completes, each successor whose predecessors have all completed is
+ * pushed into the first pool of the main scheduler of the ES that executed
+ * the node, or into the pool of the node if that fails.  Therefore, the
+ * access types of the pools have to allow pushes from the ESs executing the
+ * graph.  \c ABT_task_graph_wait() has to be called before the graph is
+ * modified, run again, or freed.
+ *
+ * @param[in] graph  handle to the task graph
+ * @param[in] pool   handle to the pool for the first nodes
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_TASK_GRAPH \c graph is running or has a cycle
+ */
+int ABT_task_graph_run(ABT_task_graph graph, ABT_pool pool)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_graph *p_graph = ABTI_task_graph_get_ptr(graph);
+    ABTI_task_graph_node *p_roots[ABTI_TASK_GRAPH_PUSH_BATCH];
+    int i, num_roots = 0;
+
+    ABTI_CHECK_NULL_TASK_GRAPH_PTR(p_graph);
+    ABTI_CHECK_TRUE(p_graph->running == ABT_FALSE, ABT_ERR_TASK_GRAPH);
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+    ABTI_CHECK_TRUE(ABTI_task_graph_is_acyclic(p_graph) == ABT_TRUE,
+                    ABT_ERR_TASK_GRAPH);
+
+    abt_errno = ABT_eventual_create(0, &p_graph->eventual);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_graph->running = ABT_TRUE;
+    p_graph->pool = pool;
+    if (p_graph->num_nodes == 0) {
+        ABT_eventual_set(p_graph->eventual, NULL, 0);
+        goto fn_exit;
+    }
+
+    /* Reset the counters so that the graph can be run more than once */
+    p_graph->num_remains = (uint32_t)p_graph->num_nodes;
+    for (i = 0; i < p_graph->num_nodes; i++) {
+        p_graph->p_nodes[i].num_pending = p_graph->p_nodes[i].num_preds;
+    }
+
+    /* Push the nodes without predecessors */
+    for (i = 0; i < p_graph->num_nodes; i++) {
+        if (p_graph->p_nodes[i].num_preds > 0) continue;
+        p_roots[num_roots++] = &p_graph->p_nodes[i];
+        if (num_roots == ABTI_TASK_GRAPH_PUSH_BATCH) {
+            ABTI_task_graph_push(p_roots, num_roots, pool, ABT_POOL_NULL);
+            num_roots = 0;
+        }
+    }
+    ABTI_task_graph_push(p_roots, num_roots, pool, ABT_POOL_NULL);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TASK_GRAPH
+ * @brief   Wait for the completion of the task graph.
+ *
+ * \c ABT_task_graph_wait() blocks the caller until all the nodes of \c graph
+ * started by \c ABT_task_graph_run() complete.  It has to be called by a ULT
+ * or an external thread.
+ *
+ * @param[in] graph  handle to the task graph
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_TASK_GRAPH \c graph is not running
+ */
+int ABT_task_graph_wait(ABT_task_graph graph)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_task_graph *p_graph = ABTI_task_graph_get_ptr(graph);
+
+    ABTI_CHECK_NULL_TASK_GRAPH_PTR(p_graph);
+    ABTI_CHECK_TRUE(p_graph->running == ABT_TRUE, ABT_ERR_TASK_GRAPH);
+
+    abt_errno = ABT_eventual_wait(p_graph->eventual, NULL);
+    ABTI_CHECK_ERROR(abt_errno);
+    ABT_eventual_free(&p_graph->eventual);
+    p_graph->running = ABT_FALSE;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void ABTI_task_graph_run_node(void *arg)
+{
+    ABTI_task_graph_node *p_node = (ABTI_task_graph_node *)arg;
+    ABTI_task_graph *p_graph = p_node->p_graph;
+    ABTI_task_graph_node *p_ready[ABTI_TASK_GRAPH_PUSH_BATCH];
+    ABT_pool pool = p_graph->pool;
+    ABT_pool alt_pool = ABT_POOL_NULL;
+    int i, num_ready = 0;
+
+    p_node->f_task(p_node->p_arg);
+
+    /* Ready successors go to the pool of this ES for locality.  A node that
+     * has not been pushed is executed by its caller, which may not be a
+     * tasklet. */
+    if (lp_ABTI_local != NULL && ABTI_local_get_task() != NULL) {
+        ABTI_xstream *p_xstream = ABTI_local_get_xstream();
+        pool = p_xstream->p_main_sched->pools[0];
+        alt_pool = ABTI_pool_get_handle(ABTI_local_get_task()->p_pool);
+    }
+
+    for (i = 0; i < p_node->num_succs; i++) {
+        ABTI_task_graph_node *p_succ = &p_graph->p_nodes[p_node->p_succs[i]];
+        if (ABTD_atomic_fetch_sub_uint32(&p_succ->num_pending, 1) != 1) {
+            continue;
+        }
+        p_ready[num_ready++] = p_succ;
+        if (num_ready == ABTI_TASK_GRAPH_PUSH_BATCH) {
+            ABTI_task_graph_push(p_ready, num_ready, pool, alt_pool);
+            num_ready = 0;
+        }
+    }
+    ABTI_task_graph_push(p_ready, num_ready, pool, alt_pool);
+
+    /* The successors have been released, so the last node can signal. */
+    if (ABTD_atomic_fetch_sub_uint32(&p_graph->num_remains, 1) == 1) {
+        ABT_eventual_set(p_graph->eventual, NULL, 0);
+    }
+}
+
+/* Push num nodes into pool, or into alt_pool if it fails.  A node that cannot
+ * be pushed into either of them is executed here. */
+static void ABTI_task_graph_push(ABTI_task_graph_node **p_nodes, int num,
+                                 ABT_pool pool, ABT_pool alt_pool)
+{
+    void (*funcs[ABTI_TASK_GRAPH_PUSH_BATCH])(void *);
+    int i;
+
+    if (num == 0) return;
+    for (i = 0; i < num; i++) funcs[i] = ABTI_task_graph_run_node;
+
+    if (ABT_task_create_many(pool, num, funcs, (void **)p_nodes, NULL)
+        == ABT_SUCCESS) {
+        return;
+    }
+    if (alt_pool != ABT_POOL_NULL && alt_pool != pool &&
+        ABT_task_create_many(alt_pool, num, funcs, (void **)p_nodes, NULL)
+        == ABT_SUCCESS) {
+        return;
+    }
+    for (i = 0; i < num; i++) ABTI_task_graph_run_node((void *)p_nodes[i]);
+}
+
+/* Check whether the graph has no cycle with Kahn's algorithm. */
+static ABT_bool ABTI_task_graph_is_acyclic(ABTI_task_graph *p_graph)
+{
+    int num_nodes = p_graph->num_nodes;
+    int *p_pending, *p_queue;
+    int head = 0, tail = 0, i;
+
+    if (num_nodes == 0) return ABT_TRUE;
+
+    p_pending = (int *)ABTU_malloc(num_nodes * sizeof(int));
+    p_queue = (int *)ABTU_malloc(num_nodes * sizeof(int));
+    for (i = 0; i < num_nodes; i++) {
+        p_pending[i] = (int)p_graph->p_nodes[i].num_preds;
+        if (p_pending[i] == 0) p_queue[tail++] = i;
+    }
+    while (head < tail) {
+        ABTI_task_graph_node *p_node = &p_graph->p_nodes[p_queue[head++]];
+        for (i = 0; i < p_node->num_succs; i++) {
+            int succ = p_node->p_succs[i];
+            if (--p_pending[succ] == 0) p_queue[tail++] = succ;
+        }
+    }
+    ABTU_free(p_pending);
+    ABTU_free(p_queue);
+
+    return (tail == num_nodes) ? ABT_TRUE : ABT_FALSE;
+}
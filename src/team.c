@@ -0,0 +1,434 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Radix of the arrival tree */
+#define ABTI_TEAM_RADIX         4
+
+/* Number of spins between two reads of the clock */
+#define ABTI_TEAM_SPIN_CHECK    64
+
+
+/** @defgroup TEAM Team
+ * A \a team is a group of persistent ULTs, one per ES, that run functions
+ * together in repeated fork-join regions, like a hot team of OpenMP.  Member
+ * 0 is the ULT that calls \c ABT_team_run(), and the others are ULTs that
+ * are created with the team, pinned to their ESs, and kept until the team is
+ * freed.  A region is started by incrementing a generation counter, which
+ * the members poll, and it ends when the members have arrived at a combining
+ * tree, so no ULT is created, pushed, or freed per region.
+ *
+ * A member waiting for the next region, or member 0 waiting for the others,
+ * spins for \c ABT_TEAM_SPIN_TIME microseconds and then blocks, which lets
+ * its ES run other work units.
+ */
+
+/* A node of the arrival tree.  The leaves come first, and the root is the
+ * last node.  Member i arrives at leaf i / ABTI_TEAM_RADIX. */
+typedef struct {
+    uint32_t num_arrived ABTI_CACHE_ALIGNED;
+    uint32_t num_children;
+    int parent;                 /* Index of the parent, or -1 for the root */
+} ABTI_team_node;
+
+typedef struct ABTI_team ABTI_team;
+
+typedef struct {
+    ABTI_team *p_team;
+    int rank;
+} ABTI_team_member;
+
+struct ABTI_team {
+    /* Written by member 0 when a region starts */
+    uint64_t gen ABTI_CACHE_ALIGNED;    /* Generation of the last region */
+    void (*team_func)(int, void *);
+    void *arg;
+    ABT_bool stop;                      /* The workers exit */
+
+    /* Written by the member that arrives last */
+    uint64_t done ABTI_CACHE_ALIGNED;   /* Generation of the last completion */
+
+    uint32_t num_sleepers ABTI_CACHE_ALIGNED; /* # of blocked members */
+    ABT_mutex mutex;
+    ABT_cond cond;
+
+    int size;                           /* # of members */
+    double spin_time;                   /* Spin time before blocking (s) */
+    ABTI_team_node *p_nodes;
+    ABTI_team_member *p_members;
+    ABT_thread *workers;                /* workers[0] is not used */
+};
+
+static void ABTI_team_worker(void *arg);
+static void ABTI_team_wait(ABTI_team *p_team, uint64_t *p_word,
+                           uint64_t value);
+static void ABTI_team_wake(ABTI_team *p_team);
+static void ABTI_team_arrive(ABTI_team *p_team, int rank, uint64_t gen);
+
+
+static inline
+ABTI_team *ABTI_team_get_ptr(ABT_team team)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABTI_team *p_team;
+    if (team == ABT_TEAM_NULL) {
+        p_team = NULL;
+    } else {
+        p_team = (ABTI_team *)team;
+    }
+    return p_team;
+#else
+    return (ABTI_team *)team;
+#endif
+}
+
+static inline
+ABT_team ABTI_team_get_handle(ABTI_team *p_team)
+{
+#ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
+    ABT_team h_team;
+    if (p_team == NULL) {
+        h_team = ABT_TEAM_NULL;
+    } else {
+        h_team = (ABT_team)p_team;
+    }
+    return h_team;
+#else
+    return (ABT_team)p_team;
+#endif
+}
+
+/**
+ * @ingroup TEAM
+ * @brief   Create a new team.
+ *
+ * \c ABT_team_create() creates a team of \c num_xstreams members and returns
+ * its handle through \c newteam.  Member 0 is the caller of
+ * \c ABT_team_run(), which should run on \c xstreams[0].  For each \c i from
+ * 1, a non-migratable ULT is created in the first main pool of
+ * \c xstreams[i] as member \c i, and it waits there for regions until the
+ * team is freed.  The team has to be freed before these ESs are joined.
+ *
+ * @param[in]  num_xstreams  the number of members
+ * @param[in]  xstreams      ESs of the members
+ * @param[out] newteam       handle to a new team
+ * @return Error code
+ * @retval ABT_SUCCESS      on success
+ * @retval ABT_ERR_INV_TEAM \c num_xstreams is not positive
+ */
+int ABT_team_create(int num_xstreams, ABT_xstream *xstreams,
+                    ABT_team *newteam)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_team *p_team = NULL;
+    ABT_pool *pools = NULL;
+    ABT_thread_attr attr = ABT_THREAD_ATTR_NULL;
+    int i, num_nodes, level_size, level_start;
+
+    ABTI_CHECK_INITIALIZED();
+    ABTI_CHECK_TRUE(num_xstreams > 0, ABT_ERR_INV_TEAM);
+
+    /* Check the ESs before anything is created */
+    pools = (ABT_pool *)ABTU_malloc(num_xstreams * sizeof(ABT_pool));
+    for (i = 1; i < num_xstreams; i++) {
+        abt_errno = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
+    p_team = (ABTI_team *)ABTU_malloc_cache_aligned(sizeof(ABTI_team));
+    p_team->gen = 0;
+    p_team->team_func = NULL;
+    p_team->arg = NULL;
+    p_team->stop = ABT_FALSE;
+    p_team->done = 0;
+    p_team->num_sleepers = 0;
+    p_team->size = num_xstreams;
+    p_team->spin_time = gp_ABTI_global->team_spin_time;
+    abt_errno = ABT_mutex_create(&p_team->mutex);
+    ABTI_CHECK_ERROR(abt_errno);
+    abt_errno = ABT_cond_create(&p_team->cond);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* Count the nodes of the arrival tree */
+    level_size = (num_xstreams + ABTI_TEAM_RADIX - 1) / ABTI_TEAM_RADIX;
+    num_nodes = level_size;
+    while (level_size > 1) {
+        level_size = (level_size + ABTI_TEAM_RADIX - 1) / ABTI_TEAM_RADIX;
+        num_nodes += level_size;
+    }
+    p_team->p_nodes = (ABTI_team_node *)
+        ABTU_malloc_cache_aligned(num_nodes * sizeof(ABTI_team_node));
+
+    /* Each level is followed by its parents */
+    level_start = 0;
+    level_size = (num_xstreams + ABTI_TEAM_RADIX - 1) / ABTI_TEAM_RADIX;
+    for (i = 0; i < level_size; i++) {
+        ABTI_team_node *p_node = &p_team->p_nodes[i];
+        int first = i * ABTI_TEAM_RADIX;
+        p_node->num_arrived = 0;
+        p_node->num_children = (num_xstreams - first < ABTI_TEAM_RADIX)
+                             ? num_xstreams - first : ABTI_TEAM_RADIX;
+        p_node->parent = -1;
+    }
+    while (level_size > 1) {
+        int next_start = level_start + level_size;
+        int next_size = (level_size + ABTI_TEAM_RADIX - 1) / ABTI_TEAM_RADIX;
+        for (i = 0; i < level_size; i++) {
+            p_team->p_nodes[level_start + i].parent =
+                next_start + i / ABTI_TEAM_RADIX;
+        }
+        for (i = 0; i < next_size; i++) {
+            ABTI_team_node *p_node = &p_team->p_nodes[next_start + i];
+            int first = i * ABTI_TEAM_RADIX;
+            p_node->num_arrived = 0;
+            p_node->num_children = (level_size - first < ABTI_TEAM_RADIX)
+                                 ? level_size - first : ABTI_TEAM_RADIX;
+            p_node->parent = -1;
+        }
+        level_start = next_start;
+        level_size = next_size;
+    }
+
+    /* Create the workers */
+    p_team->p_members = (ABTI_team_member *)
+        ABTU_malloc(num_xstreams * sizeof(ABTI_team_member));
+    p_team->workers = (ABT_thread *)
+        ABTU_malloc(num_xstreams * sizeof(ABT_thread));
+    for (i = 0; i < num_xstreams; i++) {
+        p_team->p_members[i].p_team = p_team;
+        p_team->p_members[i].rank = i;
+        p_team->workers[i] = ABT_THREAD_NULL;
+    }
+    abt_errno = ABT_thread_attr_create(&attr);
+    ABTI_CHECK_ERROR(abt_errno);
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+    abt_errno = ABT_thread_attr_set_migratable(attr, ABT_FALSE);
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+    for (i = 1; i < num_xstreams; i++) {
+        abt_errno = ABT_thread_create(pools[i], ABTI_team_worker,
+                                      &p_team->p_members[i], attr,
+                                      &p_team->workers[i]);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+    ABT_thread_attr_free(&attr);
+    ABTU_free(pools);
+
+    *newteam = ABTI_team_get_handle(p_team);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (attr != ABT_THREAD_ATTR_NULL) {
+        /* The members created so far exit. */
+        ABT_team team = ABTI_team_get_handle(p_team);
+        ABT_thread_attr_free(&attr);
+        ABT_team_free(&team);
+    } else if (p_team != NULL) {
+        ABTU_free(p_team);
+    }
+    if (pools != NULL) ABTU_free(pools);
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    *newteam = ABT_TEAM_NULL;
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TEAM
+ * @brief   Free the team.
+ *
+ * \c ABT_team_free() lets the members of \c team exit, waits for them, and
+ * releases \c team.  No region of \c team can be running.  If it is
+ * successfully processed, \c team is set to \c ABT_TEAM_NULL.
+ *
+ * @param[in,out] team  handle to the team
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_team_free(ABT_team *team)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_team *p_team = ABTI_team_get_ptr(*team);
+    int i;
+
+    ABTI_CHECK_NULL_TEAM_PTR(p_team);
+
+    p_team->stop = ABT_TRUE;
+    ABTD_atomic_exchange_uint64(&p_team->gen, p_team->gen + 1);
+    ABTI_team_wake(p_team);
+    for (i = 1; i < p_team->size; i++) {
+        if (p_team->workers[i] == ABT_THREAD_NULL) continue;
+        abt_errno = ABT_thread_free(&p_team->workers[i]);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
+    ABT_cond_free(&p_team->cond);
+    ABT_mutex_free(&p_team->mutex);
+    ABTU_free(p_team->workers);
+    ABTU_free(p_team->p_members);
+    ABTU_free(p_team->p_nodes);
+    ABTU_free(p_team);
+
+    *team = ABT_TEAM_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TEAM
+ * @brief   Run a fork-join region on the team.
+ *
+ * \c ABT_team_run() calls <tt>team_func(rank, arg)</tt> on every member of
+ * \c team, where \c rank is the rank of the member, and returns when all of
+ * them have returned.  The caller runs the function as member 0.  Regions of
+ * a team cannot be run concurrently or nested.
+ *
+ * @param[in] team       handle to the team
+ * @param[in] team_func  function to be run by the members
+ * @param[in] arg        argument for team_func
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_team_run(ABT_team team, void (*team_func)(int, void *), void *arg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_team *p_team = ABTI_team_get_ptr(team);
+    uint64_t gen;
+
+    ABTI_CHECK_NULL_TEAM_PTR(p_team);
+
+    /* Fork.  The members read the function after they see the generation. */
+    p_team->team_func = team_func;
+    p_team->arg = arg;
+    gen = p_team->gen + 1;
+    ABTD_atomic_exchange_uint64(&p_team->gen, gen);
+    ABTI_team_wake(p_team);
+
+    team_func(0, arg);
+
+    /* Join */
+    ABTI_team_arrive(p_team, 0, gen);
+    ABTI_team_wait(p_team, &p_team->done, gen);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TEAM
+ * @brief   Get the number of members of the team.
+ *
+ * @param[in]  team  handle to the team
+ * @param[out] size  the number of members
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_team_get_size(ABT_team team, int *size)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_team *p_team = ABTI_team_get_ptr(team);
+    ABTI_CHECK_NULL_TEAM_PTR(p_team);
+
+    *size = p_team->size;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void ABTI_team_worker(void *arg)
+{
+    ABTI_team_member *p_member = (ABTI_team_member *)arg;
+    ABTI_team *p_team = p_member->p_team;
+    uint64_t gen = 0;
+
+    while (1) {
+        ABTI_team_wait(p_team, &p_team->gen, ++gen);
+        if (p_team->stop == ABT_TRUE) break;
+        p_team->team_func(p_member->rank, p_team->arg);
+        ABTI_team_arrive(p_team, p_member->rank, gen);
+    }
+}
+
+/* Wait until *p_word becomes value.  The caller spins for a while and then
+ * blocks on the condition variable.  A waker changes the word before it reads
+ * num_sleepers, and a sleeper increments num_sleepers before it reads the
+ * word again, so either the waker sees the sleeper or the sleeper sees the
+ * new value. */
+static void ABTI_team_wait(ABTI_team *p_team, uint64_t *p_word,
+                           uint64_t value)
+{
+    uint64_t start_ticks = ABTD_time_get_ticks();
+    uint32_t num_spins = 0;
+
+    while (*(volatile uint64_t *)p_word != value) {
+        if (++num_spins % ABTI_TEAM_SPIN_CHECK != 0) {
+            ABTD_atomic_pause();
+            continue;
+        }
+        if (ABTD_time_ticks_to_sec(ABTD_time_get_ticks() - start_ticks)
+            < p_team->spin_time) {
+            continue;
+        }
+
+        ABT_mutex_lock(p_team->mutex);
+        ABTD_atomic_fetch_add_uint32(&p_team->num_sleepers, 1);
+        while (*(volatile uint64_t *)p_word != value) {
+            ABT_cond_wait(p_team->cond, p_team->mutex);
+        }
+        ABTD_atomic_fetch_sub_uint32(&p_team->num_sleepers, 1);
+        ABT_mutex_unlock(p_team->mutex);
+        break;
+    }
+}
+
+static void ABTI_team_wake(ABTI_team *p_team)
+{
+    if (*(volatile uint32_t *)&p_team->num_sleepers == 0) return;
+    ABT_mutex_lock(p_team->mutex);
+    ABT_cond_broadcast(p_team->cond);
+    ABT_mutex_unlock(p_team->mutex);
+}
+
+/* Member rank has finished region gen.  The last member to arrive at a node
+ * resets the node and goes up, and the one that completes the root marks the
+ * region done.  The nodes are reset before the region is done, so they are
+ * ready for the next region. */
+static void ABTI_team_arrive(ABTI_team *p_team, int rank, uint64_t gen)
+{
+    int idx = rank / ABTI_TEAM_RADIX;
+
+    while (1) {
+        ABTI_team_node *p_node = &p_team->p_nodes[idx];
+        if (ABTD_atomic_fetch_add_uint32(&p_node->num_arrived, 1) + 1
+            != p_node->num_children) {
+            return;
+        }
+        p_node->num_arrived = 0;
+        if (p_node->parent < 0) break;
+        idx = p_node->parent;
+    }
+    ABTD_atomic_exchange_uint64(&p_team->done, gen);
+    ABTI_team_wake(p_team);
+}
@@ -6,7 +6,35 @@
 #include "abti.h"
 
 static inline ABT_bool ABTI_thread_is_ready(ABTI_thread *p_thread);
+static ABT_bool ABTI_thread_is_sole_consumer(ABTI_sched *p_sched,
+                                             ABTI_pool *p_pool);
+static ABT_bool ABTI_thread_yield_fast(ABTI_thread *p_thread);
+static ABT_bool ABTI_thread_yield_to_fast(ABTI_thread *p_cur_thread,
+                                          ABTI_thread *p_tar_thread,
+                                          ABTI_xstream *p_xstream);
+static ABT_bool ABTI_thread_spawn_work_first(ABTI_local *p_local,
+                                             ABTI_thread *p_newthread);
+static ABT_bool ABTI_thread_spawn_run_next(ABTI_local *p_local,
+                                           ABTI_thread *p_newthread);
+static ABT_bool ABTI_thread_take_run_next(ABTI_xstream *p_xstream,
+                                          ABTI_thread *p_thread);
+static ABT_bool ABTI_thread_take_for_join(ABTI_xstream *p_xstream,
+                                          ABTI_thread *p_thread);
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+static void ABTI_thread_join_ext(ABTI_thread *p_thread);
+#endif
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+static ABTI_xstream *ABTI_thread_choose_migration_target(ABTI_thread *p_thread);
+#endif
 static inline ABT_thread_id ABTI_thread_get_new_id(void);
+static inline void ABTI_thread_init_user(ABTI_thread *p_newthread,
+                                         ABTI_pool *p_pool, uint32_t refcount);
+static inline ABTI_thread *ABTI_thread_alloc_user(ABTI_local *p_local,
+                                                  ABT_thread_attr attr,
+                                                  size_t *p_stacksize);
+
+/* Maximum number of ULTs pushed at once by ABT_thread_create_many */
+#define ABTI_THREAD_CREATE_MANY_BATCH   64
 
 
 /** @defgroup ULT User-level Thread (ULT)
@@ -40,6 +68,7 @@ int ABT_thread_create(ABT_pool pool, void(*thread_func)(void *),
                       ABT_thread *newthread)
 {
     int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
     ABTI_thread *p_newthread;
     ABT_thread h_newthread;
     size_t stacksize;
@@ -48,50 +77,173 @@ int ABT_thread_create(ABT_pool pool, void(*thread_func)(void *),
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
 
     /* Allocate a ULT object and its stack */
-    p_newthread = ABTI_mem_alloc_thread(attr, &stacksize);
+    p_newthread = ABTI_thread_alloc_user(p_local, attr, &stacksize);
 
     /* Create a thread context */
     abt_errno = ABTD_thread_context_create(NULL,
             thread_func, arg, stacksize, p_newthread->attr.p_stack,
             &p_newthread->ctx);
     ABTI_CHECK_ERROR(abt_errno);
+    ABTI_thread_init_stack(p_newthread);
 
-    p_newthread->state          = ABT_THREAD_STATE_READY;
-    p_newthread->request        = 0;
-    p_newthread->p_last_xstream = NULL;
-#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
-    p_newthread->is_sched       = NULL;
+    ABTI_thread_init_user(p_newthread, p_pool, (newthread != NULL) ? 1 : 0);
+    h_newthread = ABTI_thread_get_handle(p_newthread);
+
+    LOG_EVENT("[U%" PRIu64 "] created\n", ABTI_thread_get_id(p_newthread));
+    ABTI_trace_thread(ABTI_TRACE_CREATE, p_newthread);
+    ABTI_record_create_thread(p_newthread);
+
+    /* Return value.  It is set first since a work-first ULT runs before the
+     * caller returns from the switch below. */
+    if (newthread) *newthread = h_newthread;
+
+    /* Run a work-first ULT in place of the caller if possible */
+    if (p_newthread->attr.work_first == ABT_TRUE &&
+        ABTI_thread_spawn_work_first(p_local, p_newthread) == ABT_TRUE) {
+        goto fn_exit;
+    }
+
+    /* Otherwise, run it next on this ES with the run-next policy */
+    if (ABTI_global_get_run_next() == ABT_TRUE &&
+        ABTI_thread_spawn_run_next(p_local, p_newthread) == ABT_TRUE) {
+        goto fn_exit;
+    }
+
+    /* Add this thread to the pool */
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    ABTI_pool_push(p_pool, p_newthread->unit);
+#else
+    abt_errno = ABTI_pool_push(p_pool, p_newthread->unit,
+                               ABTI_xstream_self_local(p_local));
+    if (abt_errno != ABT_SUCCESS) {
+        ABTI_join_counter_dec(p_newthread);
+        ABTI_thread_free(p_newthread);
+        goto fn_fail;
+    }
 #endif
-    p_newthread->p_pool         = p_pool;
-    p_newthread->refcount       = (newthread != NULL) ? 1 : 0;
-    p_newthread->type           = ABTI_THREAD_TYPE_USER;
-    p_newthread->p_req_arg      = NULL;
-    p_newthread->p_keytable     = NULL;
-    p_newthread->id             = ABTI_THREAD_INIT_ID;
 
-    /* Create a spinlock */
-    ABTI_spinlock_create(&p_newthread->lock);
+  fn_exit:
+    return abt_errno;
 
-    /* Create a wrapper unit */
+  fn_fail:
+    if (newthread) *newthread = ABT_THREAD_NULL;
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT
+ * @brief   Create a new ULT whose argument is kept on its own stack.
+ *
+ * \c ABT_thread_create_with_data() works like \c ABT_thread_create(), but
+ * it reserves \c data_size bytes at the top of the stack of the new ULT and
+ * passes the address of this area to \c thread_func.  Before the ULT is
+ * pushed into \c pool, the area is initialized by
+ * <tt>init_func(data, init_arg)</tt>, or by copying \c data_size bytes from
+ * \c init_arg if \c init_func is \c NULL.  Unlike an argument allocated by
+ * the caller, the area needs neither allocation nor release; it is valid
+ * until \c thread_func returns.  The area is aligned to 16 bytes.
+ *
+ * This is useful for wrappers in other languages, e.g., a C++ callable can be
+ * constructed in the area by \c init_func and destroyed by \c thread_func.
+ * If an error is returned after \c init_func has been called, the area is
+ * discarded without calling \c thread_func.
+ *
+ * The stack has to exist when the ULT is created, so \c attr must not
+ * specify a deferred stack, and \c data_size must be smaller than half of
+ * the stack size.
+ *
+ * @param[in]  pool         handle to the associated pool
+ * @param[in]  thread_func  function to be executed by a new thread
+ * @param[in]  data_size    size in bytes of the argument area
+ * @param[in]  init_func    function that initializes the area, or \c NULL
+ * @param[in]  init_arg     second argument for \c init_func, or the data to
+ *                          be copied
+ * @param[in]  attr         thread attribute. If it is ABT_THREAD_ATTR_NULL,
+ *                          the default attribute is used.
+ * @param[out] newthread    handle to a newly created thread
+ * @return Error code
+ * @retval ABT_SUCCESS              on success
+ * @retval ABT_ERR_INV_THREAD_ATTR  the stack is deferred or too small
+ */
+int ABT_thread_create_with_data(ABT_pool pool, void (*thread_func)(void *),
+                                size_t data_size,
+                                void (*init_func)(void *, void *),
+                                void *init_arg, ABT_thread_attr attr,
+                                ABT_thread *newthread)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_thread *p_newthread;
+    ABT_thread h_newthread;
+    size_t stacksize;
+    char *p_data;
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    /* Allocate a ULT object and its stack */
+    p_newthread = ABTI_thread_alloc_user(p_local, attr, &stacksize);
+    if (p_newthread->attr.p_stack == NULL || data_size >= stacksize / 2) {
+        ABTI_mem_free_thread(p_newthread);
+        abt_errno = ABT_ERR_INV_THREAD_ATTR;
+        goto fn_fail;
+    }
+
+    /* The area is taken from the top of the stack. */
+    p_data = (char *)(((uintptr_t)p_newthread->attr.p_stack + stacksize
+                       - data_size) & ~(uintptr_t)15);
+    stacksize = (size_t)(p_data - (char *)p_newthread->attr.p_stack);
+    if (init_func) {
+        init_func(p_data, init_arg);
+    } else if (data_size > 0) {
+        memcpy(p_data, init_arg, data_size);
+    }
+
+    /* Create a thread context */
+    abt_errno = ABTD_thread_context_create(NULL,
+            thread_func, p_data, stacksize, p_newthread->attr.p_stack,
+            &p_newthread->ctx);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTI_mem_free_thread(p_newthread);
+        goto fn_fail;
+    }
+    ABTI_thread_init_stack(p_newthread);
+
+    ABTI_thread_init_user(p_newthread, p_pool, (newthread != NULL) ? 1 : 0);
     h_newthread = ABTI_thread_get_handle(p_newthread);
-    p_newthread->unit = p_pool->u_create_from_thread(h_newthread);
 
     LOG_EVENT("[U%" PRIu64 "] created\n", ABTI_thread_get_id(p_newthread));
+    ABTI_trace_thread(ABTI_TRACE_CREATE, p_newthread);
+    ABTI_record_create_thread(p_newthread);
+
+    if (newthread) *newthread = h_newthread;
+
+    /* Run a work-first ULT in place of the caller if possible */
+    if (p_newthread->attr.work_first == ABT_TRUE &&
+        ABTI_thread_spawn_work_first(p_local, p_newthread) == ABT_TRUE) {
+        goto fn_exit;
+    }
+
+    /* Otherwise, run it next on this ES with the run-next policy */
+    if (ABTI_global_get_run_next() == ABT_TRUE &&
+        ABTI_thread_spawn_run_next(p_local, p_newthread) == ABT_TRUE) {
+        goto fn_exit;
+    }
 
     /* Add this thread to the pool */
 #ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
     ABTI_pool_push(p_pool, p_newthread->unit);
 #else
-    abt_errno = ABTI_pool_push(p_pool, p_newthread->unit, ABTI_xstream_self());
+    abt_errno = ABTI_pool_push(p_pool, p_newthread->unit,
+                               ABTI_xstream_self_local(p_local));
     if (abt_errno != ABT_SUCCESS) {
+        ABTI_join_counter_dec(p_newthread);
         ABTI_thread_free(p_newthread);
         goto fn_fail;
     }
 #endif
 
-    /* Return value */
-    if (newthread) *newthread = h_newthread;
-
   fn_exit:
     return abt_errno;
 
@@ -101,6 +253,130 @@ int ABT_thread_create(ABT_pool pool, void(*thread_func)(void *),
     goto fn_exit;
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Create multiple ULTs in the target pool at once.
+ *
+ * \c ABT_thread_create_many() has the same effect as calling
+ * \c ABT_thread_create() \c num_threads times with \c thread_func_list[i] and
+ * \c arg_list[i], but it is cheaper for a large number of ULTs.  The producer
+ * check of \c pool is done only once, and the ULTs are pushed into \c pool in
+ * batches so that a pool that supports a batched push is locked once per
+ * batch.  All new ULTs are created with the same attribute \c attr.
+ *
+ * If \c arg_list is \c NULL, \c NULL is passed to all the ULTs.  If
+ * \c newthread_list is \c NULL, all the ULTs are unnamed.  Otherwise, the
+ * handle of the i-th ULT is returned through \c newthread_list[i].
+ *
+ * If an error occurs, the ULTs that have already been pushed into \c pool are
+ * not cancelled, and the remaining elements of \c newthread_list are set to
+ * \c ABT_THREAD_NULL.
+ *
+ * @param[in]  pool              handle to the associated pool
+ * @param[in]  num_threads       the number of ULTs to create
+ * @param[in]  thread_func_list  functions to be executed by the new ULTs
+ * @param[in]  arg_list          arguments for the functions
+ * @param[in]  attr              ULT attribute. If it is ABT_THREAD_ATTR_NULL,
+ *                               the default attribute is used.
+ * @param[out] newthread_list    handles to the newly created ULTs
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_create_many(ABT_pool pool, int num_threads,
+                           void (**thread_func_list)(void *), void **arg_list,
+                           ABT_thread_attr attr, ABT_thread *newthread_list)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread *p_threads[ABTI_THREAD_CREATE_MANY_BATCH];
+    ABT_unit units[ABTI_THREAD_CREATE_MANY_BATCH];
+    ABTI_local *p_local = ABTI_local_get_local();
+    int i = 0, j, num;
+
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+    ABTI_CHECK_TRUE(num_threads >= 0, ABT_ERR_OTHER);
+    if (num_threads == 0) goto fn_exit;
+
+#ifndef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    /* Save the producer ES information in the pool */
+    abt_errno = ABTI_pool_set_producer(p_pool, ABTI_xstream_self_local(p_local));
+    ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+    while (i < num_threads) {
+        num = num_threads - i;
+        if (num > ABTI_THREAD_CREATE_MANY_BATCH) {
+            num = ABTI_THREAD_CREATE_MANY_BATCH;
+        }
+
+        for (j = 0; j < num; j++) {
+            ABTI_thread *p_newthread;
+            size_t stacksize;
+            void *arg = arg_list ? arg_list[i + j] : NULL;
+
+            /* Allocate a ULT object and its stack */
+            p_newthread = ABTI_thread_alloc_user(p_local, attr, &stacksize);
+
+            /* Create a thread context */
+            abt_errno = ABTD_thread_context_create(NULL,
+                    thread_func_list[i + j], arg, stacksize,
+                    p_newthread->attr.p_stack, &p_newthread->ctx);
+            if (abt_errno != ABT_SUCCESS) {
+                ABTI_mem_free_thread(p_newthread);
+                /* Free the ULTs of this batch, which have not been pushed */
+                while (j-- > 0) {
+                    ABTI_join_counter_dec(p_threads[j]);
+                    ABTI_thread_free(p_threads[j]);
+                }
+                goto fn_fail;
+            }
+            ABTI_thread_init_stack(p_newthread);
+
+            ABTI_thread_init_user(p_newthread, p_pool,
+                                  newthread_list ? 1 : 0);
+            p_threads[j] = p_newthread;
+            units[j] = p_newthread->unit;
+            LOG_EVENT("[U%" PRIu64 "] created\n",
+                      ABTI_thread_get_id(p_newthread));
+            ABTI_trace_thread(ABTI_TRACE_CREATE, p_newthread);
+            ABTI_record_create_thread(p_newthread);
+            LOG_EVENT_POOL_PUSH(p_pool, units[j],
+                                ABTI_xstream_self_local(p_local));
+            ABTI_trace_unit(ABTI_TRACE_PUSH, p_pool, units[j]);
+            ABTI_unit_stats_push(p_pool, units[j]);
+        }
+
+        /* Add this batch of ULTs to the pool */
+        if (p_pool->p_push_many) {
+            p_pool->p_push_many(pool, units, num);
+            ABTI_pool_stats_add(p_pool, ABTI_POOL_STATS_PUSH, num);
+        } else {
+            for (j = 0; j < num; j++) {
+                ABTI_pool_call_push(p_pool, units[j]);
+            }
+        }
+        ABTI_POOL_UNPARK(p_pool);
+
+        /* Return values */
+        if (newthread_list) {
+            for (j = 0; j < num; j++) {
+                newthread_list[i + j] = ABTI_thread_get_handle(p_threads[j]);
+            }
+        }
+        i += num;
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    if (newthread_list) {
+        for (; i < num_threads; i++) newthread_list[i] = ABT_THREAD_NULL;
+    }
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup ULT
  * @brief   Create a new ULT associated with the target ES (\c xstream).
@@ -188,6 +464,7 @@ int ABT_thread_revive(ABT_pool pool, void(*thread_func)(void *), void *arg,
 {
     int abt_errno = ABT_SUCCESS;
     size_t stacksize;
+    void *p_xsave;
 
     ABTI_thread *p_thread = ABTI_thread_get_ptr(*thread);
     ABTI_CHECK_NULL_THREAD_PTR(p_thread);
@@ -197,28 +474,42 @@ int ABT_thread_revive(ABT_pool pool, void(*thread_func)(void *), void *arg,
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
 
-    /* Create a ULT context */
-    stacksize = p_thread->attr.stacksize;
+    /* Create a ULT context.  The XSAVE area is kept. */
+    p_xsave = ABTD_thread_context_get_xsave(&p_thread->ctx);
+    stacksize = ABTI_mem_get_context_stacksize(p_thread);
     abt_errno = ABTD_thread_context_create(NULL, thread_func, arg,
                                            stacksize, p_thread->attr.p_stack,
                                            &p_thread->ctx);
     ABTI_CHECK_ERROR(abt_errno);
+    ABTI_thread_init_stack(p_thread);
+    ABTD_thread_context_set_fpu(&p_thread->ctx, p_thread->attr.use_fpu);
+    ABTD_thread_context_set_xsave(&p_thread->ctx, p_xsave);
 
     p_thread->state          = ABT_THREAD_STATE_READY;
     p_thread->request        = 0;
     p_thread->p_last_xstream = NULL;
     p_thread->refcount       = 1;
+    p_thread->detach         = ABTI_DETACH_NONE;
     p_thread->type           = ABTI_THREAD_TYPE_USER;
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_thread->cpu_ticks      = 0;
+#endif
+    ABTI_join_counter_inc(p_thread);
+
+    /* The key-value table is kept but emptied. */
+    if (p_thread->p_keytable) {
+        ABTI_ktable_clear(p_thread->p_keytable);
+    }
 
     if (p_thread->p_pool != p_pool) {
         /* Free the unit for the old pool */
-        p_thread->p_pool->u_free(&p_thread->unit);
+        ABTI_pool_unit_free(p_thread->p_pool, &p_thread->unit);
 
         /* Set the new pool */
         p_thread->p_pool = p_pool;
 
         /* Create a wrapper unit */
-        p_thread->unit = p_pool->u_create_from_thread(*thread);
+        p_thread->unit = ABTI_pool_unit_create_thread(p_pool, p_thread);
     }
 
     LOG_EVENT("[U%" PRIu64 "] revived\n", ABTI_thread_get_id(p_thread));
@@ -291,6 +582,54 @@ int ABT_thread_free(ABT_thread *thread)
     goto fn_exit;
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Give up the handle of a ULT so that it is freed when it terminates.
+ *
+ * \c ABT_thread_detach() turns \c thread into an unnamed ULT, as if it had
+ * been created with \c NULL for its handle: the ES that terminates it frees
+ * it right away into the memory pool of the ES, and nobody joins it.  If
+ * \c thread has already terminated, it is freed by this routine.  The ULT may
+ * still be running or waiting, and the running ULT may detach itself.  The
+ * handle must not be used after this routine, and \c thread is set to
+ * \c ABT_THREAD_NULL.
+ *
+ * @param[in,out] thread  handle to the target ULT
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_detach(ABT_thread *thread)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(*thread);
+    ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+
+    ABTI_CHECK_TRUE_MSG(p_thread->type != ABTI_THREAD_TYPE_MAIN &&
+                          p_thread->type != ABTI_THREAD_TYPE_MAIN_SCHED,
+                        ABT_ERR_INV_THREAD,
+                        "The main thread cannot be detached.");
+
+    if (ABTD_atomic_cas_uint32(&p_thread->detach, ABTI_DETACH_NONE,
+                               ABTI_DETACH_DETACHED) != ABTI_DETACH_NONE) {
+        /* The ULT has ended.  Its ES sets the state right after that. */
+        while (*(volatile ABT_thread_state *)&p_thread->state !=
+               ABT_THREAD_STATE_TERMINATED) {
+            ABTD_atomic_pause();
+        }
+        ABTI_thread_free(p_thread);
+    }
+
+    /* Return value */
+    *thread = ABT_THREAD_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup ULT
  * @brief   Wait for thread to terminate.
@@ -324,25 +663,16 @@ int ABT_thread_join(ABT_thread thread)
                         "The target ULT should be different.");
 
     ABTI_thread *p_self = ABTI_local_get_thread();
+    ABTI_xstream *p_xstream = p_self->p_last_xstream;
     ABT_pool_access access = p_self->p_pool->access;
 
     if ((p_self->p_pool == p_thread->p_pool) &&
         (access == ABT_POOL_ACCESS_PRIV ||
          access == ABT_POOL_ACCESS_MPSC ||
          access == ABT_POOL_ACCESS_SPSC) &&
-        (p_thread->state == ABT_THREAD_STATE_READY)) {
-
-        ABTI_xstream *p_xstream = p_self->p_last_xstream;
-
-        /* If other ES is calling ABTI_thread_set_ready(), p_thread may not
-         * have been added to the pool yet because ABTI_thread_set_ready()
-         * changes the state first followed by pushing p_thread to the pool.
-         * Therefore, we have to check whether p_thread is in the pool, and if
-         * not, we need to wait until it is added. */
-        while (p_thread->p_pool->u_is_in_pool(p_thread->unit) != ABT_TRUE) {}
-
-        /* Remove the target ULT from the pool */
-        ABTI_POOL_REMOVE(p_thread->p_pool, p_thread->unit, p_xstream);
+        (p_thread->state == ABT_THREAD_STATE_READY) &&
+        ABTI_thread_take_for_join(p_xstream, p_thread) == ABT_TRUE) {
+        /* p_thread is run directly on this ES. */
 
         /* Set the link in the context for the target ULT */
         ABTD_thread_context_change_link(&p_thread->ctx, &p_self->ctx);
@@ -362,7 +692,11 @@ int ABT_thread_join(ABT_thread thread)
                   ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
 
         /* Switch the context */
+        ABTI_THREAD_BIND_STACK(p_thread);
         ABTI_local_set_thread(p_thread);
+        ABTI_trace_thread(ABTI_TRACE_RUN, p_thread);
+        p_xstream->stats.num_switches++;
+        ABTI_cpu_time_stop_thread(p_xstream, p_self);
         ABTD_thread_context_switch(&p_self->ctx, &p_thread->ctx);
 
     } else if ((p_self->p_pool != p_thread->p_pool) &&
@@ -374,6 +708,8 @@ int ABT_thread_join(ABT_thread thread)
         goto yield_based;
 
     } else {
+        /* This is also the case of a ready ULT that another ES has not pushed
+         * yet (see ABTI_thread_take_for_join()). */
         /* Tell p_thread that there has been a join request. */
         /* If request already has ABTI_THREAD_REQ_JOIN, p_thread is terminating.
          * We can't block p_self in this case. */
@@ -404,11 +740,18 @@ int ABT_thread_join(ABT_thread thread)
         ABTI_pool_dec_num_blocked(p_self->p_pool);
         LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] resume after join\n",
                   ABTI_thread_get_id(p_self), p_self->p_last_xstream->rank);
+        ABTI_trace_thread(ABTI_TRACE_RUN, p_self);
         ABTI_local_set_thread(p_self);
         return abt_errno;
     }
 
   yield_based:
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+    if (type == ABT_UNIT_TYPE_EXT) {
+        ABTI_thread_join_ext(p_thread);
+        goto fn_exit;
+    }
+#endif
     while (p_thread->state != ABT_THREAD_STATE_TERMINATED) {
         ABT_thread_yield();
     }
@@ -421,6 +764,49 @@ int ABT_thread_join(ABT_thread thread)
     goto fn_exit;
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Wait for multiple ULTs to terminate.
+ *
+ * \c ABT_thread_join_many() waits for all the ULTs in \c thread_list to
+ * terminate.  It has the same effect as calling \c ABT_thread_join() for each
+ * of them in order, but the ULTs that have already terminated are skipped
+ * without any further check.  The caller may still be switched to and from
+ * for each ULT that has not terminated.  To be woken up only once for a large
+ * number of ULTs, create them with a join counter (see
+ * \c ABT_thread_attr_set_join_counter()) and wait on it with
+ * \c ABT_join_counter_wait().
+ *
+ * The ULTs are not freed by this routine.
+ *
+ * @param[in] num_threads  the number of ULTs to join
+ * @param[in] thread_list  handles to the target ULTs
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_join_many(int num_threads, ABT_thread *thread_list)
+{
+    int abt_errno = ABT_SUCCESS;
+    int i;
+
+    ABTI_CHECK_TRUE(num_threads >= 0, ABT_ERR_OTHER);
+    for (i = 0; i < num_threads; i++) {
+        ABTI_thread *p_thread = ABTI_thread_get_ptr(thread_list[i]);
+        ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+        if (p_thread->state == ABT_THREAD_STATE_TERMINATED) continue;
+
+        abt_errno = ABT_thread_join(thread_list[i]);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup ULT
  * @brief   The calling ULT terminates its execution.
@@ -465,10 +851,40 @@ int ABT_thread_exit(void)
     goto fn_exit;
 }
 
+#ifndef ABT_CONFIG_DISABLE_THREAD_CANCEL
+/* Remove p_thread from the waiters of the object that it is blocked on.  If
+ * this returns ABT_TRUE, no waker can find p_thread any longer and the caller
+ * has to make it ready. */
+static ABT_bool ABTI_thread_unlink_waiter(ABTI_thread *p_thread)
+{
+    ABT_bool unlinked = ABT_FALSE;
+
+    ABTI_spinlock_acquire(&p_thread->lock);
+    if (p_thread->f_wait_unlink != NULL &&
+        p_thread->state == ABT_THREAD_STATE_BLOCKED) {
+        unlinked = p_thread->f_wait_unlink(p_thread->p_wait_obj, p_thread);
+        if (unlinked == ABT_TRUE) {
+            /* p_thread will not resume to unset them. */
+            p_thread->p_wait_obj = NULL;
+            p_thread->f_wait_unlink = NULL;
+        }
+    }
+    ABTI_spinlock_release(&p_thread->lock);
+    return unlinked;
+}
+#endif
+
 /**
  * @ingroup ULT
  * @brief   Request the cancelation of the target thread.
  *
+ * \c ABT_thread_cancel() requests the cancelation of \c thread, which is
+ * terminated when it is scheduled next time.  If \c thread is blocked on a
+ * mutex, a condition variable, or an eventual, it is removed from the waiters
+ * of the object and pushed into its pool at once, so that it is terminated and
+ * its stack is released without waiting for the object.  The object must not
+ * be freed while this routine is running.
+ *
  * @param[in] thread  handle to the target thread
  * @return Error code
  * @retval ABT_SUCCESS on success
@@ -490,6 +906,12 @@ int ABT_thread_cancel(ABT_thread thread)
     /* Set the cancel request */
     ABTI_thread_set_request(p_thread, ABTI_THREAD_REQ_CANCEL);
 
+    /* A blocked ULT is made ready now instead of when it is woken up. */
+    if (ABTI_thread_unlink_waiter(p_thread) == ABT_TRUE) {
+        abt_errno = ABTI_thread_set_ready(p_thread);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+
   fn_exit:
     return abt_errno;
 
@@ -518,6 +940,7 @@ int ABT_thread_cancel(ABT_thread thread)
 int ABT_thread_self(ABT_thread *thread)
 {
     int abt_errno = ABT_SUCCESS;
+    ABTI_local *p_local = ABTI_local_get_local();
 
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
     /* In case that Argobots has not been initialized or this routine is called
@@ -528,14 +951,14 @@ int ABT_thread_self(ABT_thread *thread)
         *thread = ABT_THREAD_NULL;
         return abt_errno;
     }
-    if (lp_ABTI_local == NULL) {
+    if (p_local == NULL) {
         abt_errno = ABT_ERR_INV_XSTREAM;
         *thread = ABT_THREAD_NULL;
         return abt_errno;
     }
 #endif
 
-    ABTI_thread *p_thread = ABTI_local_get_thread();
+    ABTI_thread *p_thread = p_local->p_thread;
     if (p_thread != NULL) {
         *thread = ABTI_thread_get_handle(p_thread);
     } else {
@@ -546,6 +969,21 @@ int ABT_thread_self(ABT_thread *thread)
     return abt_errno;
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Return the handle of the calling ULT without error checking.
+ *
+ * \c ABT_thread_self_unchecked() returns the handle of the calling ULT, or
+ * \c ABT_THREAD_NULL if it is called by a tasklet.  Unlike
+ * \c ABT_thread_self(), it must not be called by an external thread.
+ *
+ * @return handle to the calling ULT
+ */
+ABT_thread ABT_thread_self_unchecked(void)
+{
+    return ABTI_thread_get_handle(ABTI_local_get_thread());
+}
+
 /**
  * @ingroup ULT
  * @brief   Return the calling ULT's ID.
@@ -720,6 +1158,11 @@ int ABT_thread_set_associated_pool(ABT_thread thread, ABT_pool pool)
  * This function can be used for users to explicitly schedule the next thread
  * to execute.
  *
+ * If only the calling ES pops from the pool of the two ULTs, the target is
+ * claimed by changing its state and the caller takes its place in the pool in
+ * one step.  Otherwise, the target is removed from the pool before the caller
+ * is pushed, so the caller is not pushed if another ES has taken the target.
+ *
  * @param[in] thread  handle to the target thread
  * @return Error code
  * @retval ABT_SUCCESS on success
@@ -761,11 +1204,19 @@ int ABT_thread_yield_to(ABT_thread thread)
                         ABT_ERR_INV_THREAD,
                         "The target thread's pool is not the same as mine.");
 
+    if (ABTI_thread_yield_to_fast(p_cur_thread, p_tar_thread, p_xstream)
+        == ABT_TRUE) {
+        goto fn_exit;
+    }
+
     /* If the target thread is not in READY, we don't yield. */
     if (ABTI_thread_is_ready(p_tar_thread) == ABT_FALSE) {
         goto fn_exit;
     }
 
+    /* Remove the target ULT from the pool */
+    ABTI_POOL_REMOVE(p_tar_thread->p_pool, p_tar_thread->unit, p_xstream);
+
     p_cur_thread->state = ABT_THREAD_STATE_READY;
 
     /* Add the current thread to the pool again */
@@ -779,9 +1230,6 @@ int ABT_thread_yield_to(ABT_thread thread)
     }
 #endif
 
-    /* Remove the target ULT from the pool */
-    ABTI_POOL_REMOVE(p_tar_thread->p_pool, p_tar_thread->unit, p_xstream);
-
 #ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
     /* Add a new scheduler if the ULT is a scheduler */
     if (p_tar_thread->is_sched != NULL) {
@@ -795,8 +1243,12 @@ int ABT_thread_yield_to(ABT_thread thread)
     p_tar_thread->p_last_xstream = p_xstream;
 
     /* Switch the context */
+    ABTI_THREAD_BIND_STACK(p_tar_thread);
     ABTI_local_set_thread(p_tar_thread);
     p_tar_thread->state = ABT_THREAD_STATE_RUNNING;
+    ABTI_trace_thread(ABTI_TRACE_RUN, p_tar_thread);
+    p_xstream->stats.num_switches++;
+    ABTI_cpu_time_stop_thread(p_xstream, p_cur_thread);
     ABTD_thread_context_switch(&p_cur_thread->ctx, &p_tar_thread->ctx);
 
   fn_exit:
@@ -815,6 +1267,12 @@ int ABT_thread_yield_to(ABT_thread thread)
  * The ULT that yields, goes back to its pool, and eventually will be
  * resumed automatically later.
  *
+ * When the ES runs a predefined scheduler, the scheduler is bypassed: if its
+ * pools are empty, the caller continues without a context switch, and
+ * otherwise the caller switches directly to the next ULT in the pools.  The
+ * scheduler still runs once every sched_event_freq yields and whenever
+ * requests or timed waits are pending on the ES.
+ *
  * @return Error code
  * @retval ABT_SUCCESS on success
  */
@@ -836,7 +1294,9 @@ int ABT_thread_yield(void)
     ABTI_CHECK_TRUE(p_thread->p_last_xstream == ABTI_local_get_xstream(),
                     ABT_ERR_THREAD);
 
-    ABTI_thread_yield(p_thread);
+    if (ABTI_thread_yield_fast(p_thread) == ABT_FALSE) {
+        ABTI_thread_yield(p_thread);
+    }
 
   fn_exit:
     return abt_errno;
@@ -848,21 +1308,100 @@ int ABT_thread_yield(void)
 
 /**
  * @ingroup ULT
- * @brief   Resume the target ULT.
+ * @brief   Yield the calling ULT without error checking.
  *
- * \c ABT_thread_resume() makes the blocked ULT schedulable by changing the
- * state of the target ULT to READY and pushing it to its associated pool.
- * The ULT will resume its execution when the scheduler schedules it.
+ * \c ABT_thread_yield_unchecked() is the same as \c ABT_thread_yield() except
+ * that it checks neither the caller nor the state of the ES.  It must be
+ * called by a ULT.
+ */
+void ABT_thread_yield_unchecked(void)
+{
+    ABTI_thread *p_thread = ABTI_local_get_thread();
+    if (ABTI_thread_yield_fast(p_thread) == ABT_FALSE) {
+        ABTI_thread_yield(p_thread);
+    }
+}
+
+/**
+ * @ingroup ULT
+ * @brief   Put the calling ULT to sleep for the given time.
  *
- * The ULT should have been blocked by \c ABT_self_suspend() or
- * \c ABT_thread_suspend().  Otherwise, the behavior of this routine is
- * undefined.
+ * \c ABT_thread_sleep() blocks the calling ULT for \c sec seconds without
+ * occupying its ES.  See \c ABT_thread_sleep_until() for details.
  *
- * @param[in] thread   handle to the target ULT
+ * @param[in] sec  time to sleep in seconds
  * @return Error code
- * @retval ABT_SUCCESS on success
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_INV_THREAD the caller is a tasklet
  */
-int ABT_thread_resume(ABT_thread thread)
+int ABT_thread_sleep(double sec)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_TRUE(lp_ABTI_local == NULL || ABTI_local_get_thread() != NULL,
+                    ABT_ERR_INV_THREAD);
+
+    ABTI_thread_sleep(ABTI_timeout_get_time() + sec);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT
+ * @brief   Put the calling ULT to sleep until the given time.
+ *
+ * \c ABT_thread_sleep_until() blocks the calling ULT until the absolute time
+ * \c abstime, which is measured by the same clock as
+ * \c ABT_cond_timedwait().  The ULT does not occupy its ES while sleeping;
+ * it is kept in the timer wheel of the ES and pushed back to its pool by the
+ * scheduler once the time has come.  Since the wheel is checked only when the
+ * scheduler checks events, the ULT may be resumed somewhat later than
+ * \c abstime.  If the ES is freed in the meantime, the ULT is resumed early.
+ *
+ * An external thread calling this routine sleeps with \c nanosleep().
+ *
+ * @param[in] abstime  absolute time to wake up
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_INV_THREAD the caller is a tasklet
+ */
+int ABT_thread_sleep_until(const struct timespec *abstime)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_TRUE(lp_ABTI_local == NULL || ABTI_local_get_thread() != NULL,
+                    ABT_ERR_INV_THREAD);
+
+    ABTI_thread_sleep(ABTI_timeout_convert(abstime));
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT
+ * @brief   Resume the target ULT.
+ *
+ * \c ABT_thread_resume() makes the blocked ULT schedulable by changing the
+ * state of the target ULT to READY and pushing it to its associated pool.
+ * The ULT will resume its execution when the scheduler schedules it.
+ *
+ * The ULT should have been blocked by \c ABT_self_suspend() or
+ * \c ABT_thread_suspend().  Otherwise, the behavior of this routine is
+ * undefined.
+ *
+ * @param[in] thread   handle to the target ULT
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_resume(ABT_thread thread)
 {
     int abt_errno = ABT_SUCCESS;
     ABTI_thread *p_thread;
@@ -881,6 +1420,62 @@ int ABT_thread_resume(ABT_thread thread)
     goto fn_exit;
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Resume multiple ULTs.
+ *
+ * \c ABT_thread_resume_many() has the same effect as calling
+ * \c ABT_thread_resume() for each ULT in \c thread_list, but the ULTs that
+ * belong to the same pool are pushed together by one call to the
+ * \c p_push_many function of the pool if it has one.  Waking up many ULTs
+ * thus takes one pool operation per pool rather than one per ULT.  The order
+ * in which the ULTs of different pools are resumed is unspecified.
+ *
+ * All the ULTs must have been blocked by \c ABT_self_suspend() or
+ * \c ABT_thread_suspend(), and each of them must appear only once in
+ * \c thread_list.  If any ULT is not blocked, none is resumed.
+ *
+ * @param[in] num_threads  the number of ULTs to resume
+ * @param[in] thread_list  handles to the target ULTs
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_INV_THREAD invalid ULT handle
+ * @retval ABT_ERR_THREAD     a ULT is not blocked
+ */
+int ABT_thread_resume_many(int num_threads, ABT_thread *thread_list)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_unit *p_head = NULL;
+    int i;
+
+    for (i = 0; i < num_threads; i++) {
+        ABTI_thread *p_thread = ABTI_thread_get_ptr(thread_list[i]);
+        ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+        ABTI_CHECK_TRUE(p_thread->state == ABT_THREAD_STATE_BLOCKED,
+                        ABT_ERR_THREAD);
+    }
+
+    /* A suspended ULT is in no wait queue, so its unit_def is free to link
+     * it.  The list is in the order of thread_list. */
+    for (i = num_threads - 1; i >= 0; i--) {
+        ABTI_thread *p_thread = ABTI_thread_get_ptr(thread_list[i]);
+        ABTI_unit *p_unit = &p_thread->unit_def;
+        p_unit->thread = thread_list[i];
+        p_unit->type = ABT_UNIT_TYPE_THREAD;
+        p_unit->p_next = p_head;
+        p_head = p_unit;
+    }
+    abt_errno = ABTI_thread_set_ready_list(p_head);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 /**
  * @ingroup ULT
  * @brief   Migrate a thread to a specific ES.
@@ -1079,6 +1674,12 @@ int ABT_thread_migrate_to_pool(ABT_thread thread, ABT_pool pool)
  * runtime. Other semantics of this routine are the same as those of
  * \c ABT_thread_migrate_to_xstream()
  *
+ * If the ULT has a home ES (see \c ABT_thread_attr_set_home()) other than the
+ * current one, the ULT goes there.  Otherwise, the ES whose main pool has the
+ * fewest units is chosen, and ESs on another NUMA node than the home ES (or
+ * the current ES if there is no home) are chosen only if they have more than
+ * \c ABT_SCHED_REMOTE_THRESHOLD fewer units than the nearby ones.
+ *
  * NOTE: This function may have some bugs.
  *
  * @param[in] thread  handle to the thread
@@ -1097,11 +1698,22 @@ int ABT_thread_migrate(ABT_thread thread)
     ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
     ABTI_CHECK_NULL_THREAD_PTR(p_thread);
 
-    ABTI_xstream **p_xstreams = gp_ABTI_global->p_xstreams;
+    int max_xstreams;
+    ABTI_xstream **p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+
+    /* Choose the destination xstream by locality first */
+    p_xstream = ABTI_thread_choose_migration_target(p_thread);
+    if (p_xstream != NULL) {
+        xstream = ABTI_xstream_get_handle(p_xstream);
+        abt_errno = ABT_thread_migrate_to_xstream(thread, xstream);
+        if (abt_errno != ABT_ERR_INV_XSTREAM &&
+                abt_errno != ABT_ERR_MIGRATION_TARGET) {
+            ABTI_CHECK_ERROR(abt_errno);
+            goto fn_exit;
+        }
+    }
 
-    /* Choose the destination xstream */
-    /* FIXME: Currenlty, the target xstream is randomly chosen. We need a
-     * better selection strategy. */
+    /* Otherwise, the target xstream is randomly chosen. */
     /* TODO: handle better when no pool accepts migration */
     /* TODO: choose a pool also when (p_thread->p_pool->consumer == NULL) */
     while (1) {
@@ -1111,7 +1723,7 @@ int ABT_thread_migrate(ABT_thread thread)
             break;
         }
 
-        p_xstream = p_xstreams[rand() % gp_ABTI_global->num_xstreams];
+        p_xstream = p_xstreams[rand() % max_xstreams];
         if (p_xstream && p_xstream != p_thread->p_last_xstream) {
             if (p_xstream->state == ABT_XSTREAM_STATE_RUNNING) {
                 xstream = ABTI_xstream_get_handle(p_xstream);
@@ -1412,6 +2024,61 @@ int ABT_thread_get_id(ABT_thread thread, ABT_thread_id *thread_id)
     goto fn_exit;
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Get the CPU time of the ULT.
+ *
+ * \c ABT_thread_get_cpu_time() returns the time in seconds for which ESs have
+ * run \c thread, accumulated across yields and migrations.  The time spent
+ * blocked or waiting in pools is not included.  If \c thread is the caller,
+ * the time since it was last scheduled is included.
+ *
+ * The CPU time is measured only if the environment variable
+ * \c ABT_CPU_TIME is set.
+ *
+ * @param[in]  thread    handle to the target thread
+ * @param[out] cpu_time  CPU time in seconds
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA \c ABT_CPU_TIME is not set or Argobots is
+ *                            configured with --enable-feature=no-cpu-time
+ */
+int ABT_thread_get_cpu_time(ABT_thread thread, double *cpu_time)
+{
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream;
+    uint64_t ticks;
+
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+    ABTI_CHECK_TRUE(gp_ABTI_global->use_cpu_time == ABT_TRUE,
+                    ABT_ERR_FEATURE_NA);
+
+    ticks = p_thread->cpu_ticks;
+    p_xstream = ABTI_local_get_xstream();
+    if (p_xstream != NULL && ABTI_local_get_thread() == p_thread &&
+        p_xstream->cpu_time_ticks != 0) {
+        uint64_t now = ABTD_time_get_ticks();
+        if (now > p_xstream->cpu_time_ticks) {
+            ticks += now - p_xstream->cpu_time_ticks;
+        }
+    }
+    *cpu_time = ABTD_time_ticks_to_sec(ticks);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    ABTI_UNUSED(thread);
+    ABTI_UNUSED(cpu_time);
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
 /**
  * @ingroup ULT
  * @brief   Set the argument for the ULT function
@@ -1554,7 +2221,6 @@ int ABTI_thread_create_main(ABTI_xstream *p_xstream, ABTI_thread **p_thread)
 {
     int abt_errno = ABT_SUCCESS;
     ABTI_thread *p_newthread;
-    ABT_thread h_newthread;
     ABTI_pool *p_pool;
 
     /* Get the first pool of ES */
@@ -1576,17 +2242,22 @@ int ABTI_thread_create_main(ABTI_xstream *p_xstream, ABTI_thread **p_thread)
 #endif
     p_newthread->p_pool          = p_pool;
     p_newthread->refcount        = 0;
+    p_newthread->detach          = ABTI_DETACH_NONE;
     p_newthread->type            = ABTI_THREAD_TYPE_MAIN;
     p_newthread->p_req_arg       = NULL;
+    p_newthread->p_wait_obj      = NULL;
+    p_newthread->f_wait_unlink   = NULL;
     p_newthread->p_keytable      = NULL;
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_newthread->cpu_ticks       = 0;
+#endif
     p_newthread->id              = ABTI_THREAD_INIT_ID;
 
     /* Create a spinlock */
     ABTI_spinlock_create(&p_newthread->lock);
 
     /* Create a wrapper unit */
-    h_newthread = ABTI_thread_get_handle(p_newthread);
-    p_newthread->unit = p_pool->u_create_from_thread(h_newthread);
+    p_newthread->unit = ABTI_pool_unit_create_thread(p_pool, p_newthread);
 
     LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] main ULT created\n",
               ABTI_thread_get_id(p_newthread),
@@ -1628,7 +2299,6 @@ int ABTI_thread_create_main_sched(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
         /* Create a ULT object and its stack */
         size_t stacksize = ABTI_global_get_sched_stacksize();
         p_newthread = ABTI_mem_alloc_thread_with_stacksize(&stacksize);
-        ABTI_VALGRIND_STACK_REGISTER(p_newthread->attr.p_stack, stacksize);
 
         /* When the main scheduler is terminated, the control will jump to the
          * primary ULT. */
@@ -1655,9 +2325,15 @@ int ABTI_thread_create_main_sched(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
     p_newthread->unit           = ABT_UNIT_NULL;
     p_newthread->p_pool         = NULL;
     p_newthread->refcount       = 0;
+    p_newthread->detach         = ABTI_DETACH_NONE;
     p_newthread->type           = ABTI_THREAD_TYPE_MAIN_SCHED;
     p_newthread->p_req_arg      = NULL;
+    p_newthread->p_wait_obj     = NULL;
+    p_newthread->f_wait_unlink  = NULL;
     p_newthread->p_keytable     = NULL;
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_newthread->cpu_ticks      = 0;
+#endif
     p_newthread->id             = ABTI_THREAD_INIT_ID;
 
     /* Create a spinlock */
@@ -1683,7 +2359,6 @@ int ABTI_thread_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched)
 {
     int abt_errno = ABT_SUCCESS;
     ABTI_thread *p_newthread;
-    ABT_thread h_newthread;
     size_t stacksize;
 
     /* If p_sched is reused, ABT_thread_revive() can be used. */
@@ -1706,6 +2381,7 @@ int ABTI_thread_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched)
             p_sched->run, (void *)ABTI_sched_get_handle(p_sched),
             stacksize, p_newthread->attr.p_stack, &p_newthread->ctx);
     ABTI_CHECK_ERROR(abt_errno);
+    ABTI_thread_init_stack(p_newthread);
 
     p_newthread->state          = ABT_THREAD_STATE_READY;
     p_newthread->request        = 0;
@@ -1715,19 +2391,26 @@ int ABTI_thread_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched)
 #endif
     p_newthread->p_pool         = p_pool;
     p_newthread->refcount       = 1;
+    p_newthread->detach         = ABTI_DETACH_NONE;
     p_newthread->type           = ABTI_THREAD_TYPE_USER;
     p_newthread->p_req_arg      = NULL;
+    p_newthread->p_wait_obj     = NULL;
+    p_newthread->f_wait_unlink  = NULL;
     p_newthread->p_keytable     = NULL;
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_newthread->cpu_ticks      = 0;
+#endif
     p_newthread->id             = ABTI_THREAD_INIT_ID;
 
     /* Create a spinlock */
     ABTI_spinlock_create(&p_newthread->lock);
 
     /* Create a wrapper unit */
-    h_newthread = ABTI_thread_get_handle(p_newthread);
-    p_newthread->unit = p_pool->u_create_from_thread(h_newthread);
+    p_newthread->unit = ABTI_pool_unit_create_thread(p_pool, p_newthread);
 
     LOG_EVENT("[U%" PRIu64 "] created\n", ABTI_thread_get_id(p_newthread));
+    ABTI_trace_thread(ABTI_TRACE_CREATE, p_newthread);
+    ABTI_record_create_thread(p_newthread);
 
     /* Save the ULT pointer in p_sched */
     p_sched->p_thread = p_newthread;
@@ -1754,6 +2437,8 @@ int ABTI_thread_create_sched(ABTI_pool *p_pool, ABTI_sched *p_sched)
 
 void ABTI_thread_free(ABTI_thread *p_thread)
 {
+    ABTI_local *p_local;
+
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     /* p_thread's lock may have been acquired somewhere. We free p_thread when
        the lock can be acquired here. */
@@ -1764,9 +2449,12 @@ void ABTI_thread_free(ABTI_thread *p_thread)
               ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
 
     /* Free the unit */
-    p_thread->p_pool->u_free(&p_thread->unit);
+    ABTI_pool_unit_free(p_thread->p_pool, &p_thread->unit);
 
     /* Free the context */
+    if (ABTD_thread_context_get_xsave(&p_thread->ctx)) {
+        ABTU_free(ABTD_thread_context_get_xsave(&p_thread->ctx));
+    }
     ABTD_thread_context_free(&p_thread->ctx);
 
     /* Free the key-value table */
@@ -1777,10 +2465,48 @@ void ABTI_thread_free(ABTI_thread *p_thread)
     /* Free the spinlock */
     ABTI_spinlock_free(&p_thread->lock);
 
+    /* Keep a reusable ULT in the ES for the next ABTI_thread_alloc_user. */
+    p_local = lp_ABTI_local;
+    if (p_thread->attr.reusable == ABT_TRUE &&
+        p_thread->attr.userstack == ABT_FALSE &&
+        p_thread->attr.deferred_stack == ABT_FALSE &&
+        p_thread->type == ABTI_THREAD_TYPE_USER && p_local != NULL &&
+        p_local->num_reuse_threads < ABTI_THREAD_MAX_REUSE) {
+        p_local->p_reuse_threads[p_local->num_reuse_threads++] = p_thread;
+        return;
+    }
+
     /* Free ABTI_thread (stack will also be freed) */
     ABTI_mem_free_thread(p_thread);
 }
 
+/* Release the reusable ULTs kept by the ES of p_local. */
+void ABTI_thread_free_reusable(ABTI_local *p_local)
+{
+    while (p_local->num_reuse_threads > 0) {
+        ABTI_mem_free_thread(
+            p_local->p_reuse_threads[--p_local->num_reuse_threads]);
+    }
+}
+
+#if defined(ABT_CONFIG_USE_MEM_POOL) && defined(ABT_CONFIG_USE_FCONTEXT)
+/* Bind a stack to a ULT created with a deferred stack and make its context.
+ * The function, the argument, and the link have been kept in the context. */
+void ABTI_thread_bind_stack(ABTI_thread *p_thread)
+{
+    ABTD_thread_context *p_ctx = &p_thread->ctx;
+    void *p_xsave = ABTD_thread_context_get_xsave(p_ctx);
+
+    ABTI_mem_bind_stack(p_thread);
+    ABTD_thread_context_create(p_ctx->p_link, p_ctx->f_thread, p_ctx->p_arg,
+                               ABTI_mem_get_context_stacksize(p_thread),
+                               p_thread->attr.p_stack, p_ctx);
+    ABTI_thread_init_stack(p_thread);
+    ABTD_thread_context_set_fpu(p_ctx, p_thread->attr.use_fpu);
+    ABTD_thread_context_set_xsave(p_ctx, p_xsave);
+}
+#endif
+
 void ABTI_thread_free_main(ABTI_thread *p_thread)
 {
     LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] main ULT freed\n",
@@ -1830,6 +2556,7 @@ int ABTI_thread_set_blocked(ABTI_thread *p_thread)
 
     LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] blocked\n",
               ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
+    ABTI_trace_thread(ABTI_TRACE_BLOCK, p_thread);
 
   fn_exit:
     return abt_errno;
@@ -1857,6 +2584,63 @@ void ABTI_thread_suspend(ABTI_thread *p_thread)
               ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
 }
 
+/* Return ABT_TRUE if the main scheduler of p_xstream uses p_pool, i.e., a ULT
+ * of p_pool can run on p_xstream as if it had been popped there.  The caller
+ * holds the sched_lock of p_xstream, under which the main scheduler is
+ * replaced. */
+static ABT_bool ABTI_thread_is_main_pool(ABTI_xstream *p_xstream,
+                                         ABTI_pool *p_pool)
+{
+    ABTI_sched *p_sched = p_xstream->p_main_sched;
+    int p;
+
+    for (p = 0; p < p_sched->num_pools; p++) {
+        if (ABTI_pool_get_ptr(p_sched->pools[p]) == p_pool) return ABT_TRUE;
+    }
+    return ABT_FALSE;
+}
+
+/* Put p_thread, which is being woken up, into the run-next slot of the ES
+ * where it last ran, so that it runs next there with warm caches instead of on
+ * whichever ES pops it first.  This is done only if the main scheduler of that
+ * ES consumes the pool of p_thread and has at most wake_affine_max_queue units
+ * and the slot is empty.  The sched_lock of the ES is taken so that its main
+ * scheduler is neither replaced nor terminating (see
+ * ABTI_sched_close_run_next()), and the ULT is pushed if the lock is busy.
+ * Returns ABT_FALSE without doing anything otherwise; the caller then pushes
+ * p_thread to its pool. */
+static ABT_bool ABTI_thread_wake_affine(ABTI_thread *p_thread)
+{
+    ABTI_xstream *p_xstream = p_thread->p_last_xstream;
+    ABT_bool placed = ABT_FALSE;
+
+    if (p_xstream == NULL || p_thread->is_sched != NULL ||
+        *(ABTI_thread *volatile *)&p_xstream->p_run_next != NULL ||
+        p_xstream->state != ABT_XSTREAM_STATE_RUNNING) {
+        return ABT_FALSE;
+    }
+    if (ABTI_spinlock_try_acquire(&p_xstream->sched_lock) == ABT_FALSE) {
+        return ABT_FALSE;
+    }
+    if (ABTI_thread_is_main_pool(p_xstream, p_thread->p_pool) == ABT_TRUE &&
+        ABTI_sched_get_size(p_xstream->p_main_sched)
+        <= ABTI_global_get_wake_affine_max_queue()) {
+        /* The state is set first since the ES can run p_thread at once.  If
+         * the slot has been taken, the caller sets it again. */
+        p_thread->state = ABT_THREAD_STATE_READY;
+        if (ABTD_atomic_cas_uint64((uint64_t *)&p_xstream->p_run_next, 0,
+                                   (uint64_t)(uintptr_t)p_thread) == 0) {
+            placed = ABT_TRUE;
+        }
+    }
+    ABTI_spinlock_release(&p_xstream->sched_lock);
+    if (placed == ABT_FALSE) return ABT_FALSE;
+    LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] woken up into the run-next slot\n",
+              ABTI_thread_get_id(p_thread), p_xstream->rank);
+    ABTI_POOL_UNPARK(p_thread->p_pool);
+    return ABT_TRUE;
+}
+
 int ABTI_thread_set_ready(ABTI_thread *p_thread)
 {
     int abt_errno = ABT_SUCCESS;
@@ -1873,8 +2657,11 @@ int ABTI_thread_set_ready(ABTI_thread *p_thread)
     LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] set ready\n",
               ABTI_thread_get_id(p_thread), p_thread->p_last_xstream->rank);
 
-    /* Add the ULT to its associated pool */
-    ABTI_POOL_ADD_THREAD(p_thread, ABTI_xstream_self());
+    /* Add the ULT to its associated pool unless its last ES takes it */
+    if (ABTI_global_get_wake_affine() == ABT_FALSE ||
+        ABTI_thread_wake_affine(p_thread) == ABT_FALSE) {
+        ABTI_POOL_ADD_THREAD(p_thread, ABTI_xstream_self());
+    }
 
     /* Decrease the number of blocked threads */
     ABTI_pool_dec_num_blocked(p_thread->p_pool);
@@ -1887,6 +2674,344 @@ int ABTI_thread_set_ready(ABTI_thread *p_thread)
     goto fn_exit;
 }
 
+/* Make the blocked ULTs in the list linked by p_next ready.  ULTs that belong
+ * to the same pool are pushed together with p_push_many if the pool has it.
+ * p_next of each unit is reset to NULL. */
+int ABTI_thread_set_ready_list(ABTI_unit *p_head)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread *p_threads[ABTI_THREAD_CREATE_MANY_BATCH];
+    ABT_unit units[ABTI_THREAD_CREATE_MANY_BATCH];
+    ABTI_xstream *p_producer = ABTI_xstream_self();
+    ABT_bool wake_affine = ABTI_global_get_wake_affine();
+    int i, num, num_push;
+
+    while (p_head) {
+        /* Take the ULTs that belong to the same pool as the first one */
+        ABTI_pool *p_pool = ABTI_thread_get_ptr(p_head->thread)->p_pool;
+        ABT_pool pool = ABTI_pool_get_handle(p_pool);
+        ABTI_unit **pp_unit = &p_head;
+        num = 0;
+        while (*pp_unit && num < ABTI_THREAD_CREATE_MANY_BATCH) {
+            ABTI_unit *p_unit = *pp_unit;
+            ABTI_thread *p_thread = ABTI_thread_get_ptr(p_unit->thread);
+            if (p_thread->p_pool == p_pool) {
+                *pp_unit = p_unit->p_next;
+                p_unit->p_next = NULL;
+                p_threads[num++] = p_thread;
+            } else {
+                pp_unit = &p_unit->p_next;
+            }
+        }
+
+        num_push = 0;
+        for (i = 0; i < num; i++) {
+            ABTI_thread *p_thread = p_threads[i];
+            ABTI_CHECK_TRUE(p_thread->state == ABT_THREAD_STATE_BLOCKED,
+                            ABT_ERR_THREAD);
+
+            /* See ABTI_thread_set_ready() */
+            while (*(volatile uint32_t *)(&p_thread->request)
+                   & ABTI_THREAD_REQ_BLOCK) {
+            }
+
+            LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] set ready\n",
+                      ABTI_thread_get_id(p_thread),
+                      p_thread->p_last_xstream->rank);
+            if (wake_affine == ABT_TRUE &&
+                ABTI_thread_wake_affine(p_thread) == ABT_TRUE) {
+                continue;
+            }
+            p_thread->state = ABT_THREAD_STATE_READY;
+            units[num_push] = p_thread->unit;
+            LOG_EVENT_POOL_PUSH(p_pool, units[num_push], p_producer);
+            ABTI_trace_unit(ABTI_TRACE_PUSH, p_pool, units[num_push]);
+            ABTI_unit_stats_push(p_pool, units[num_push]);
+            num_push++;
+        }
+
+#ifndef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+        /* Save the producer ES information in the pool */
+        abt_errno = ABTI_pool_set_producer(p_pool, p_producer);
+        ABTI_CHECK_ERROR(abt_errno);
+#endif
+
+        if (p_pool->p_push_many && num_push > 0) {
+            p_pool->p_push_many(pool, units, num_push);
+            ABTI_pool_stats_add(p_pool, ABTI_POOL_STATS_PUSH, num_push);
+        } else {
+            for (i = 0; i < num_push; i++) {
+                ABTI_pool_call_push(p_pool, units[i]);
+            }
+        }
+        ABTI_POOL_UNPARK(p_pool);
+
+        /* Decrease the number of blocked threads */
+        ABTD_atomic_fetch_sub_uint32(&p_pool->num_blocked, (uint32_t)num);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/* Switch from the calling ULT directly to p_thread, which is blocked and is
+ * being woken up, instead of pushing p_thread to its pool.  The caller is
+ * pushed to its pool instead.  Since the caller is pushed before its context
+ * is saved, only a ULT in the same pool that has a single consumer, i.e., this
+ * ES, is switched to.  Returns ABT_FALSE without doing anything if the handoff
+ * is not possible; the caller then has to make p_thread ready. */
+ABT_bool ABTI_thread_handoff(ABTI_thread *p_thread)
+{
+    ABTI_thread *p_self;
+    ABTI_xstream *p_xstream;
+    ABTI_pool *p_pool = p_thread->p_pool;
+
+    if (lp_ABTI_local == NULL || ABTI_local_get_task() != NULL) {
+        return ABT_FALSE;
+    }
+    p_self = ABTI_local_get_thread();
+    p_xstream = ABTI_local_get_xstream();
+    if (p_self == NULL || p_self == p_thread || p_self->p_pool != p_pool ||
+        p_self->p_last_xstream != p_xstream ||
+        p_self->is_sched != NULL || p_thread->is_sched != NULL ||
+        p_thread->state != ABT_THREAD_STATE_BLOCKED) {
+        return ABT_FALSE;
+    }
+    if (p_pool->access != ABT_POOL_ACCESS_PRIV &&
+        p_pool->access != ABT_POOL_ACCESS_SPSC &&
+        p_pool->access != ABT_POOL_ACCESS_MPSC) {
+        return ABT_FALSE;
+    }
+
+    /* Add the current ULT to the pool again */
+    p_self->state = ABT_THREAD_STATE_READY;
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    ABTI_pool_push(p_pool, p_self->unit);
+#else
+    if (ABTI_pool_push(p_pool, p_self->unit, p_xstream) != ABT_SUCCESS) {
+        p_self->state = ABT_THREAD_STATE_RUNNING;
+        return ABT_FALSE;
+    }
+#endif
+
+    /* See ABTI_thread_set_ready() */
+    while (*(volatile uint32_t *)(&p_thread->request) & ABTI_THREAD_REQ_BLOCK) {
+    }
+    ABTI_pool_dec_num_blocked(p_pool);
+
+    LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] handoff -> U%" PRIu64 "\n",
+              ABTI_thread_get_id(p_self), p_xstream->rank,
+              ABTI_thread_get_id(p_thread));
+
+    /* Switch the context */
+    p_thread->p_last_xstream = p_xstream;
+    ABTI_THREAD_BIND_STACK(p_thread);
+    ABTI_local_set_thread(p_thread);
+    p_thread->state = ABT_THREAD_STATE_RUNNING;
+    ABTI_trace_thread(ABTI_TRACE_RUN, p_thread);
+    p_xstream->stats.num_switches++;
+    ABTI_cpu_time_stop_thread(p_xstream, p_self);
+    ABTD_thread_context_switch(&p_self->ctx, &p_thread->ctx);
+    return ABT_TRUE;
+}
+
+/* Let p_newthread, which has not been pushed, run on this ES in place of the
+ * calling ULT.  The caller yields, and the scheduler pushes it back to its pool
+ * once its context has been saved, so that other ESs can steal it, and then
+ * runs p_newthread (see ABTI_xstream_run_unit()).  Returns ABT_FALSE without
+ * doing anything if the caller is not a ULT of the same pool on this ES or it
+ * is a scheduler. */
+static ABT_bool ABTI_thread_spawn_work_first(ABTI_local *p_local,
+                                             ABTI_thread *p_newthread)
+{
+    ABTI_thread *p_self;
+    ABTI_xstream *p_xstream;
+
+    if (p_local == NULL || p_local->p_task != NULL) {
+        return ABT_FALSE;
+    }
+    p_self = p_local->p_thread;
+    p_xstream = p_local->p_xstream;
+    if (p_self == NULL || p_self->p_pool != p_newthread->p_pool ||
+        p_self->p_last_xstream != p_xstream || p_self->is_sched != NULL ||
+        p_xstream->p_work_first != NULL) {
+        return ABT_FALSE;
+    }
+
+    LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] work-first -> U%" PRIu64 "\n",
+              ABTI_thread_get_id(p_self), p_xstream->rank,
+              ABTI_thread_get_id(p_newthread));
+
+    p_xstream->p_work_first = p_newthread;
+    ABTI_thread_yield(p_self);
+    return ABT_TRUE;
+}
+
+/* Put p_newthread, which has not been pushed, into the run-next slot of the
+ * calling ES so that it runs as soon as the caller stops, ahead of the units
+ * queued in the pools.  A ULT already in the slot is pushed to its pool.
+ * Returns ABT_FALSE without doing anything unless the pool of p_newthread is
+ * the first pool of the main scheduler of the calling ES, which the
+ * predefined schedulers pop first, so that priorities are kept. */
+static ABT_bool ABTI_thread_spawn_run_next(ABTI_local *p_local,
+                                           ABTI_thread *p_newthread)
+{
+    ABTI_xstream *p_xstream;
+    ABTI_thread *p_old;
+
+    if (p_local == NULL) return ABT_FALSE;
+    p_xstream = p_local->p_xstream;
+    if (ABTI_pool_get_ptr(p_xstream->p_main_sched->pools[0])
+        != p_newthread->p_pool) {
+        return ABT_FALSE;
+    }
+    do {
+        p_old = *(ABTI_thread *volatile *)&p_xstream->p_run_next;
+        if (p_old == ABTI_XSTREAM_RUN_NEXT_CLOSED) return ABT_FALSE;
+    } while (ABTD_atomic_cas_uint64((uint64_t *)&p_xstream->p_run_next,
+                                    (uint64_t)(uintptr_t)p_old,
+                                    (uint64_t)(uintptr_t)p_newthread)
+             != (uint64_t)(uintptr_t)p_old);
+
+    LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] created into the run-next slot\n",
+              ABTI_thread_get_id(p_newthread), p_xstream->rank);
+
+    /* The previous ULT in the slot loses its place. */
+    if (p_old) {
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+        ABTI_pool_push(p_old->p_pool, p_old->unit);
+#else
+        int abt_errno = ABTI_pool_push(p_old->p_pool, p_old->unit, p_xstream);
+        if (abt_errno != ABT_SUCCESS) HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+#endif
+    }
+    return ABT_TRUE;
+}
+
+/* Take p_thread out of the run-next slot of p_xstream, which is the calling ES,
+ * if it is there.  Only the calling ES takes ULTs out of its slot. */
+static ABT_bool ABTI_thread_take_run_next(ABTI_xstream *p_xstream,
+                                          ABTI_thread *p_thread)
+{
+    if (*(ABTI_thread *volatile *)&p_xstream->p_run_next != p_thread) {
+        return ABT_FALSE;
+    }
+    return (ABTD_atomic_cas_uint64((uint64_t *)&p_xstream->p_run_next,
+                                   (uint64_t)(uintptr_t)p_thread, 0)
+            == (uint64_t)(uintptr_t)p_thread) ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Take the ready ULT p_thread out of the run-next slot of p_xstream or out of
+ * its pool, from which only p_xstream pops, so that the caller can run it
+ * directly.  ABTI_thread_set_ready() on another ES makes a ULT ready before it
+ * pushes it, so p_thread may be in neither yet.  ABT_FALSE is returned then,
+ * without waiting for the push, and the caller joins p_thread through a join
+ * request instead.  Once p_thread is in the pool, nobody but p_xstream can
+ * take it out, so the check and the removal do not race. */
+static ABT_bool ABTI_thread_take_for_join(ABTI_xstream *p_xstream,
+                                          ABTI_thread *p_thread)
+{
+    if (ABTI_thread_take_run_next(p_xstream, p_thread) == ABT_TRUE) {
+        return ABT_TRUE;
+    }
+    if (ABTI_pool_unit_is_in_pool(p_thread->p_pool,
+                                  p_thread->unit) == ABT_TRUE) {
+        ABTI_POOL_REMOVE(p_thread->p_pool, p_thread->unit, p_xstream);
+        return ABT_TRUE;
+    }
+    return ABT_FALSE;
+}
+
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+/* An external thread waits for p_thread to terminate.  It spins for a while
+ * and then blocks on ext_join_seq, which is advanced whenever a ULT
+ * terminates while external joiners exist (see
+ * ABTI_xstream_wake_ext_joiners()). */
+static void ABTI_thread_join_ext(ABTI_thread *p_thread)
+{
+    volatile ABT_thread_state *p_state = &p_thread->state;
+    uint32_t seq;
+    int i;
+
+    for (i = 0; i < ABTD_FUTEX_SIGNAL_SPINS; i++) {
+        if (*p_state == ABT_THREAD_STATE_TERMINATED) return;
+        ABTD_atomic_pause();
+    }
+
+    ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->num_ext_joiners, 1);
+    while (1) {
+        seq = *(volatile uint32_t *)&gp_ABTI_global->ext_join_seq;
+        ABTD_atomic_mem_barrier();
+        if (*p_state == ABT_THREAD_STATE_TERMINATED) break;
+        ABTD_futex_wait(&gp_ABTI_global->ext_join_seq, seq, NULL);
+    }
+    ABTD_atomic_fetch_sub_uint32(&gp_ABTI_global->num_ext_joiners, 1);
+}
+#endif
+
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+/* Choose the ES to which ABT_thread_migrate() moves p_thread: its home ES if
+ * the ULT is elsewhere, even if the home has not started running yet, or the
+ * least loaded of the other running ESs.  An ES
+ * on another NUMA node than the home (or the current ES) wins only if it has
+ * more than sched_remote_threshold fewer units.  Returns NULL if no ES is
+ * found. */
+static ABTI_xstream *ABTI_thread_choose_migration_target(ABTI_thread *p_thread)
+{
+    ABTI_xstream *p_cur = p_thread->p_last_xstream;
+    ABTI_xstream *p_anchor = p_cur;
+    ABTI_xstream *p_near = NULL, *p_remote = NULL;
+    size_t near_load = 0, remote_load = 0;
+    int home = p_thread->attr.home;
+    int i, node, max_xstreams;
+    ABTI_xstream **p_xstreams = ABTI_global_get_xstreams(&max_xstreams);
+
+    if (home >= 0 && home < max_xstreams) {
+        ABTI_xstream *p_home = p_xstreams[home];
+        if (p_home && p_home->state != ABT_XSTREAM_STATE_TERMINATED) {
+            if (p_home != p_cur) return p_home;
+            p_anchor = p_home;
+        }
+    }
+    node = p_anchor ? ABTI_xstream_get_numa_node(p_anchor) : -1;
+
+    for (i = 0; i < max_xstreams; i++) {
+        ABTI_xstream *p_xstream = p_xstreams[i];
+        ABTI_sched *p_sched;
+        size_t load;
+        int xstream_node;
+
+        if (p_xstream == NULL || p_xstream == p_cur) continue;
+        if (p_xstream->state != ABT_XSTREAM_STATE_RUNNING) continue;
+        p_sched = p_xstream->p_main_sched;
+        if (p_sched == NULL || p_sched->num_pools == 0) continue;
+
+        load = ABTI_pool_call_get_size(ABTI_pool_get_ptr(p_sched->pools[0]));
+        xstream_node = ABTI_xstream_get_numa_node(p_xstream);
+        if (node >= 0 && xstream_node >= 0 && node != xstream_node) {
+            if (p_remote == NULL || load < remote_load) {
+                p_remote = p_xstream;
+                remote_load = load;
+            }
+        } else if (p_near == NULL || load < near_load) {
+            p_near = p_xstream;
+            near_load = load;
+        }
+    }
+
+    if (p_near == NULL) return p_remote;
+    if (p_remote != NULL &&
+        remote_load + gp_ABTI_global->sched_remote_threshold < near_load) {
+        return p_remote;
+    }
+    return p_near;
+}
+#endif
+
 static inline ABT_bool ABTI_thread_is_ready(ABTI_thread *p_thread)
 {
     /* ULT can be regarded as 'ready' only if its state is READY and it has been
@@ -1894,7 +3019,7 @@ static inline ABT_bool ABTI_thread_is_ready(ABTI_thread *p_thread)
      * into a pool, we check them in the reverse order, i.e., check if the ULT
      * is inside a pool and the its state. */
     ABTI_pool *p_pool = p_thread->p_pool;
-    if (p_pool->u_is_in_pool(p_thread->unit) == ABT_TRUE &&
+    if (ABTI_pool_unit_is_in_pool(p_pool, p_thread->unit) == ABT_TRUE &&
         p_thread->state == ABT_THREAD_STATE_READY) {
         return ABT_TRUE;
     }
@@ -1914,7 +3039,7 @@ void ABTI_thread_print(ABTI_thread *p_thread, FILE *p_os, int indent)
     ABTI_xstream *p_xstream = p_thread->p_last_xstream;
     uint64_t xstream_rank = p_xstream ? p_xstream->rank : 0;
     char *type, *state;
-    char attr[100];
+    char attr[352];
 
     switch (p_thread->type) {
         case ABTI_THREAD_TYPE_MAIN:       type = "MAIN"; break;
@@ -2046,8 +3171,11 @@ ABT_thread_id ABTI_thread_get_id(ABTI_thread *p_thread)
 {
     if (p_thread == NULL) return ABTI_THREAD_INIT_ID;
 
+    /* The ID is assigned on the first request.  If two requests race, the
+     * ID of the first one is kept and the other ID is not used. */
     if (p_thread->id == ABTI_THREAD_INIT_ID) {
-        p_thread->id = ABTI_thread_get_new_id();
+        ABTD_atomic_cas_uint64(&p_thread->id, ABTI_THREAD_INIT_ID,
+                               ABTI_thread_get_new_id());
     }
     return p_thread->id;
 }
@@ -2081,8 +3209,303 @@ int ABTI_thread_self_xstream_rank(void)
 /* Internal static functions                                                 */
 /*****************************************************************************/
 
+/* An ES takes IDs from the global counter in blocks, so the counter is
+ * updated once per ABTI_ID_BLOCK_SIZE IDs.  External threads update it for
+ * each ID. */
 static inline ABT_thread_id ABTI_thread_get_new_id(void)
 {
-    return (ABT_thread_id)ABTD_atomic_fetch_add_uint64(&g_thread_id, 1);
+    ABTI_xstream *p_xstream = lp_ABTI_local ? ABTI_local_get_xstream() : NULL;
+    if (p_xstream == NULL) {
+        return (ABT_thread_id)ABTD_atomic_fetch_add_uint64(&g_thread_id, 1);
+    }
+    if (p_xstream->thread_id_next == p_xstream->thread_id_end) {
+        p_xstream->thread_id_next =
+            ABTD_atomic_fetch_add_uint64(&g_thread_id, ABTI_ID_BLOCK_SIZE);
+        p_xstream->thread_id_end =
+            p_xstream->thread_id_next + ABTI_ID_BLOCK_SIZE;
+    }
+    return (ABT_thread_id)p_xstream->thread_id_next++;
+}
+
+/* Initialize a user ULT whose context has been created and create its unit. */
+/* The area is cleared so that its XSAVE header is valid even before the first
+ * XSAVE. */
+static inline void *ABTI_thread_alloc_xsave(void)
+{
+    size_t size = ABTD_xsave_get_size();
+    void *p_area = ABTU_memalign(ABTD_XSAVE_ALIGN, size);
+    memset(p_area, 0, size);
+    return p_area;
+}
+
+static inline void ABTI_thread_init_user(ABTI_thread *p_newthread,
+                                         ABTI_pool *p_pool, uint32_t refcount)
+{
+    p_newthread->state          = ABT_THREAD_STATE_READY;
+    p_newthread->request        = 0;
+    p_newthread->p_last_xstream = NULL;
+#ifndef ABT_CONFIG_DISABLE_STACKABLE_SCHED
+    p_newthread->is_sched       = NULL;
+#endif
+    p_newthread->p_pool         = p_pool;
+    p_newthread->refcount       = refcount;
+    p_newthread->detach         = ABTI_DETACH_NONE;
+    p_newthread->type           = ABTI_THREAD_TYPE_USER;
+    p_newthread->p_req_arg      = NULL;
+    p_newthread->p_wait_obj     = NULL;
+    p_newthread->f_wait_unlink  = NULL;
+    p_newthread->p_keytable     = NULL;
+#ifndef ABT_CONFIG_DISABLE_CPU_TIME
+    p_newthread->cpu_ticks      = 0;
+#endif
+    p_newthread->id             = ABTI_THREAD_INIT_ID;
+    ABTI_join_counter_inc(p_newthread);
+    ABTD_thread_context_set_fpu(&p_newthread->ctx, p_newthread->attr.use_fpu);
+    if (p_newthread->attr.vector_state == ABT_TRUE) {
+        ABTD_thread_context_set_xsave(&p_newthread->ctx,
+                                      ABTI_thread_alloc_xsave());
+    }
+
+    /* Create a spinlock */
+    ABTI_spinlock_create(&p_newthread->lock);
+
+    /* Create a wrapper unit */
+    p_newthread->unit = ABTI_pool_unit_create_thread(p_pool, p_newthread);
+}
+
+/* Allocate a ULT object and its stack for attr.  If attr is reusable, the
+ * ULT freed last by the caller's ES is taken instead when its stack has the
+ * requested size.  Its unit, context, and spinlock have already been freed,
+ * so it is set up like a new one, but the memory pool is skipped. */
+static inline ABTI_thread *ABTI_thread_alloc_user(ABTI_local *p_local,
+                                                  ABT_thread_attr attr,
+                                                  size_t *p_stacksize)
+{
+    ABTI_thread_attr *p_attr;
+    ABTI_thread *p_thread;
+    void *p_stack;
+    size_t stacksize;
+
+    if (attr == ABT_THREAD_ATTR_NULL || p_local == NULL ||
+        p_local->num_reuse_threads == 0) {
+        return ABTI_mem_alloc_thread(p_local, attr, p_stacksize);
+    }
+    p_attr = ABTI_thread_attr_get_ptr(attr);
+    p_thread = p_local->p_reuse_threads[p_local->num_reuse_threads - 1];
+    if (p_attr->reusable == ABT_FALSE || p_attr->p_stack != NULL ||
+        p_attr->deferred_stack == ABT_TRUE ||
+        p_thread->attr.stacksize !=
+            ABTI_mem_get_thread_stacksize(p_attr->stacksize)) {
+        return ABTI_mem_alloc_thread(p_local, attr, p_stacksize);
+    }
+    p_local->num_reuse_threads--;
+
+    /* The stack stays with the ULT object. */
+    p_stack = p_thread->attr.p_stack;
+    stacksize = p_thread->attr.stacksize;
+    ABTI_thread_attr_copy(&p_thread->attr, p_attr);
+    p_thread->attr.p_stack = p_stack;
+    p_thread->attr.stacksize = stacksize;
+
+    *p_stacksize = ABTI_mem_get_context_stacksize(p_thread);
+    return p_thread;
+}
+
+/* Whether p_sched is the only scheduler that pops from p_pool.  The access
+ * type only says that one ES pops from p_pool, which may be another ES, and
+ * schedulers of several ESs may still be associated with it. */
+static ABT_bool ABTI_thread_is_sole_consumer(ABTI_sched *p_sched,
+                                             ABTI_pool *p_pool)
+{
+    int i;
+
+    if (p_pool->access != ABT_POOL_ACCESS_PRIV &&
+        p_pool->access != ABT_POOL_ACCESS_SPSC &&
+        p_pool->access != ABT_POOL_ACCESS_MPSC) {
+        return ABT_FALSE;
+    }
+    if (*(volatile int32_t *)&p_pool->num_scheds != 1) return ABT_FALSE;
+    for (i = 0; i < p_sched->num_pools; i++) {
+        if (ABTI_pool_get_ptr(p_sched->pools[i]) == p_pool) return ABT_TRUE;
+    }
+    return ABT_FALSE;
 }
 
+/* Fast path of ABT_thread_yield_to().  If the pool of the two ULTs is a
+ * built-in one that only the calling ES pops from, no other ES can take the
+ * target, which is claimed by changing its state from READY to RUNNING, and
+ * the caller replaces it in the pool under one lock at most.  Returns
+ * ABT_FALSE if the caller has to take the normal path. */
+static ABT_bool ABTI_thread_yield_to_fast(ABTI_thread *p_cur_thread,
+                                          ABTI_thread *p_tar_thread,
+                                          ABTI_xstream *p_xstream)
+{
+    ABTI_pool *p_pool = p_cur_thread->p_pool;
+
+    if (p_cur_thread->is_sched != NULL || p_tar_thread->is_sched != NULL) {
+        return ABT_FALSE;
+    }
+    if (p_pool->builtin == ABTI_POOL_BUILTIN_NONE ||
+        ABTI_thread_is_sole_consumer(ABTI_xstream_get_top_sched(p_xstream),
+                                     p_pool) == ABT_FALSE) {
+        return ABT_FALSE;
+    }
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    /* The timings of units are recorded when they are pushed. */
+    if (gp_ABTI_global->use_unit_stats == ABT_TRUE) return ABT_FALSE;
+#endif
+
+    /* A ULT can be READY before it is pushed, in which case the claim is
+     * given up. */
+    if (ABTD_atomic_cas_int32((int32_t *)&p_tar_thread->state,
+                              ABT_THREAD_STATE_READY,
+                              ABT_THREAD_STATE_RUNNING)
+        != ABT_THREAD_STATE_READY) {
+        return ABT_FALSE;
+    }
+    p_cur_thread->state = ABT_THREAD_STATE_READY;
+    if (ABTI_pool_call_swap(p_pool, p_tar_thread->unit, p_cur_thread->unit)
+        == ABT_FALSE) {
+        p_cur_thread->state = ABT_THREAD_STATE_RUNNING;
+        p_tar_thread->state = ABT_THREAD_STATE_READY;
+        return ABT_FALSE;
+    }
+    LOG_EVENT_POOL_REMOVE(p_pool, p_tar_thread->unit, p_xstream);
+    LOG_EVENT_POOL_PUSH(p_pool, p_cur_thread->unit, p_xstream);
+    ABTI_trace_unit(ABTI_TRACE_PUSH, p_pool, p_cur_thread->unit);
+
+    /* Switch the context */
+    p_tar_thread->p_last_xstream = p_xstream;
+    ABTI_THREAD_BIND_STACK(p_tar_thread);
+    ABTI_local_set_thread(p_tar_thread);
+    ABTI_trace_thread(ABTI_TRACE_RUN, p_tar_thread);
+    p_xstream->stats.num_switches++;
+    ABTI_cpu_time_stop_thread(p_xstream, p_cur_thread);
+    ABTD_thread_context_switch(&p_cur_thread->ctx, &p_tar_thread->ctx);
+    return ABT_TRUE;
+}
+
+/* Fast path of ABT_thread_yield().  Predefined schedulers pop the first unit
+ * of their pools in order, so the yielding ULT can do the same without
+ * switching to the scheduler.  Returns ABT_FALSE if the scheduler has to run,
+ * i.e., the caller has to take the normal path. */
+static ABT_bool ABTI_thread_yield_fast(ABTI_thread *p_thread)
+{
+    ABTI_xstream *p_xstream = p_thread->p_last_xstream;
+    ABTI_pool *p_my_pool = p_thread->p_pool;
+    ABTI_sched *p_sched;
+    ABTI_pool *p_pool = NULL;
+    ABTI_thread *p_target = NULL;
+    ABT_unit unit = ABT_UNIT_NULL;
+    int i;
+
+    if (ABTI_local_get_task() != NULL || p_thread->is_sched != NULL ||
+        *(volatile uint32_t *)&p_thread->request != 0) {
+        return ABT_FALSE;
+    }
+    p_sched = ABTI_xstream_get_top_sched(p_xstream);
+    if (p_sched->kind != ABTI_sched_get_kind(ABTI_sched_get_basic_def()) &&
+        p_sched->kind != ABTI_sched_get_kind(ABTI_sched_get_prio_def())) {
+        return ABT_FALSE;
+    }
+    /* The caller is pushed before it switches, so no other ES may pop it. */
+    if (ABTI_thread_is_sole_consumer(p_sched, p_my_pool) == ABT_FALSE) {
+        return ABT_FALSE;
+    }
+
+    /* Let the scheduler check events periodically and handle the pending
+     * ones. */
+    if (++p_xstream->num_fast_yields >= ABTI_global_get_sched_event_freq() ||
+        *(volatile uint32_t *)&p_xstream->request != 0 ||
+        *(volatile uint32_t *)&p_sched->request != 0 ||
+        *(volatile uint32_t *)&p_xstream->timer_wheel.num_entries != 0 ||
+        p_xstream->io_poller.num_waiters != 0 ||
+        p_xstream->mpi_poller.num_waiters != 0 ||
+        *(volatile uint32_t *)&gp_ABTI_global->num_completion_waiters != 0) {
+        p_xstream->num_fast_yields = 0;
+        return ABT_FALSE;
+    }
+    /* The scheduler runs the ULT in the run-next slot first. */
+    if (*(ABTI_thread *volatile *)&p_xstream->p_run_next != NULL) {
+        return ABT_FALSE;
+    }
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+    /* The timings of units are recorded by the scheduler. */
+    if (gp_ABTI_global->use_unit_stats == ABT_TRUE) return ABT_FALSE;
+#endif
+
+    /* Nothing else to run */
+    for (i = 0; i < p_sched->num_pools; i++) {
+        ABT_pool pool = p_sched->pools[i];
+        if (ABTI_pool_call_get_size(ABTI_pool_get_ptr(pool)) > 0) break;
+    }
+    if (i == p_sched->num_pools) return ABT_TRUE;
+
+    /* Add the current ULT to the pool again and pop the next unit as the
+     * scheduler would do. */
+    p_thread->state = ABT_THREAD_STATE_READY;
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+    ABTI_pool_push(p_my_pool, p_thread->unit);
+#else
+    if (ABTI_pool_push(p_my_pool, p_thread->unit, p_xstream) != ABT_SUCCESS) {
+        p_thread->state = ABT_THREAD_STATE_RUNNING;
+        return ABT_FALSE;
+    }
+#endif
+    for (i = 0; i < p_sched->num_pools; i++) {
+        ABT_pool pool = p_sched->pools[i];
+        p_pool = ABTI_pool_get_ptr(pool);
+        if (ABTI_pool_call_get_size(p_pool) > 0) {
+            unit = ABTI_pool_call_pop(p_pool);
+            LOG_EVENT_POOL_POP(p_pool, unit);
+            ABTI_trace_unit(ABTI_TRACE_POP, p_pool, unit);
+            break;
+        }
+    }
+
+    if (unit == p_thread->unit) {
+        p_thread->state = ABT_THREAD_STATE_RUNNING;
+        return ABT_TRUE;
+    }
+    if (unit != ABT_UNIT_NULL &&
+        ABTI_pool_unit_get_type(p_pool, unit) == ABT_UNIT_TYPE_THREAD) {
+        p_target = ABTI_pool_unit_get_thread(p_pool, unit);
+        if (p_target->is_sched != NULL ||
+            (*(volatile uint32_t *)&p_target->request &
+             (ABTI_THREAD_REQ_CANCEL | ABTI_THREAD_REQ_MIGRATE))) {
+            p_target = NULL;
+        }
+    }
+
+    if (p_target == NULL) {
+        /* Tasklets, schedulers, and ULTs with requests are left to the
+         * scheduler, which must not push the current ULT again. */
+        if (unit != ABT_UNIT_NULL) {
+#ifdef ABT_CONFIG_DISABLE_POOL_PRODUCER_CHECK
+            ABTI_pool_push(p_pool, unit);
+#else
+            ABTI_pool_push(p_pool, unit, p_xstream);
+#endif
+        }
+        ABTI_thread_set_request(p_thread, ABTI_THREAD_REQ_NOPUSH);
+        ABTI_LOG_SET_SCHED(p_sched);
+        ABTD_thread_context_switch(&p_thread->ctx, p_sched->p_ctx);
+        return ABT_TRUE;
+    }
+
+    LOG_EVENT("[U%" PRIu64 ":E%" PRIu64 "] yield -> U%" PRIu64 "\n",
+              ABTI_thread_get_id(p_thread), p_xstream->rank,
+              ABTI_thread_get_id(p_target));
+
+    /* Switch the context */
+    p_target->p_last_xstream = p_xstream;
+    ABTI_THREAD_BIND_STACK(p_target);
+    ABTI_local_set_thread(p_target);
+    p_target->state = ABT_THREAD_STATE_RUNNING;
+    p_xstream->num_thread_runs++;
+    ABTI_trace_thread(ABTI_TRACE_RUN, p_target);
+    p_xstream->stats.num_switches++;
+    ABTI_cpu_time_stop_thread(p_xstream, p_thread);
+    ABTD_thread_context_switch(&p_thread->ctx, &p_target->ctx);
+    return ABT_TRUE;
+}
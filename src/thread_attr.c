@@ -284,6 +284,599 @@ int ABT_thread_attr_set_migratable(ABT_thread_attr attr, ABT_bool flag)
 #endif
 }
 
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set whether the ULT's stack is bound when it runs first.
+ *
+ * \c ABT_thread_attr_set_deferred_stack() sets the deferred-stack flag in the
+ * target attribute object.  If \c flag is \c ABT_TRUE, a ULT created with
+ * this attribute does not get a stack at creation.  Its stack is taken from
+ * the stack pool of the ES that runs the ULT for the first time, and it is
+ * returned when the ULT is freed.  Therefore, ULTs that are waiting in pools
+ * do not hold stacks, and ULTs that run to completion one after another reuse
+ * the same stacks cached by the ES.
+ *
+ * The flag is ignored if the attribute has a stack given by the user or a
+ * stack size that the stack pool does not manage, or if the ULT is created by
+ * an external thread.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] flag  deferred-stack flag (<tt>ABT_TRUE</tt>: defer the stack,
+ *                  <tt>ABT_FALSE</tt>: not)
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA the stack pool or fcontext is not used
+ */
+int ABT_thread_attr_set_deferred_stack(ABT_thread_attr attr, ABT_bool flag)
+{
+#if defined(ABT_CONFIG_USE_MEM_POOL) && defined(ABT_CONFIG_USE_FCONTEXT)
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->deferred_stack = flag;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the FPU usage in the attribute.
+ *
+ * \c ABT_thread_attr_set_fpu() declares whether ULTs created with the target
+ * attribute use floating-point or SIMD registers.  By default, ULTs are
+ * assumed to use them.  If \c flag is \c ABT_FALSE, the FPU state is not
+ * saved when such a ULT is switched out and not restored when it is switched
+ * in, which makes context switches cheaper.  The ULT then runs with the FPU
+ * control state (e.g., the rounding mode) left by the previous context.
+ *
+ * On x86, the FPU state is the MXCSR register and the x87 control word.  On
+ * ARM64, it is the callee-saved registers d8-d15, so \c ABT_FALSE is allowed
+ * only if no function on the stack of the ULT, including the ones in
+ * libraries, keeps values in these registers (e.g., code compiled with
+ * \c -mgeneral-regs-only).  The flag has no effect with ucontext.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] flag  FPU usage (<tt>ABT_TRUE</tt>: uses the FPU,
+ *                  <tt>ABT_FALSE</tt>: not)
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_set_fpu(ABT_thread_attr attr, ABT_bool flag)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->use_fpu = flag;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the vector-state flag in the attribute.
+ *
+ * \c ABT_thread_attr_set_vector_state() sets the vector-state flag in the
+ * target attribute object.  If \c flag is \c ABT_TRUE, the whole extended
+ * processor state of ULTs created with this attribute, including the upper
+ * halves of AVX and AVX-512 registers and the mask registers, is saved with
+ * XSAVE (XSAVEOPT if available) when they are switched out and restored with
+ * XRSTOR when they are switched back in.  XSAVEOPT skips the components that
+ * are in their initial state or have not been modified, so a ULT pays only
+ * for the state that it actually uses.  Other ULTs are not affected.
+ *
+ * Context switches are function calls, so the compiler does not keep vector
+ * values in registers across them.  This flag is for ULTs whose vector state
+ * has to survive a switch that the compiler does not see, e.g., a switch from
+ * a signal handler.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] flag  vector-state flag (<tt>ABT_TRUE</tt>: save the whole
+ *                  vector state, <tt>ABT_FALSE</tt>: not)
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA XSAVE is not available or fcontext is not used
+ */
+int ABT_thread_attr_set_vector_state(ABT_thread_attr attr, ABT_bool flag)
+{
+#if defined(ABT_CONFIG_USE_FCONTEXT)
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+    if (flag == ABT_TRUE && ABTD_xsave_get_size() == 0) {
+        abt_errno = ABT_ERR_FEATURE_NA;
+        goto fn_fail;
+    }
+
+    /* Set the value */
+    p_attr->vector_state = flag;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the preemptible flag in the attribute.
+ *
+ * \c ABT_thread_attr_set_preemptible() sets the preemptible flag in the
+ * target attribute object.  If \c flag is \c ABT_TRUE and preemption is
+ * enabled by the environment variable \c ABT_PREEMPTION_INTERVAL, a ULT
+ * created with this attribute that keeps running for longer than the
+ * preemption quantum is interrupted by a timer signal and pushed back to its
+ * pool as if it called \c ABT_thread_yield().
+ *
+ * A ULT is preempted only while it executes code of the main program, never
+ * inside Argobots or shared libraries.  Still, it can be preempted at any
+ * point of that code, so it must not hold locks or spin on conditions that a
+ * work unit on the same ES needs to make progress, e.g., a pthread mutex.
+ * Its stack also needs room for the signal frame, which is several KB with
+ * AVX-512.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] flag  preemptible flag (<tt>ABT_TRUE</tt>: preemptible,
+ *                  <tt>ABT_FALSE</tt>: not)
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_FEATURE_NA preemption is disabled or not supported
+ */
+int ABT_thread_attr_set_preemptible(ABT_thread_attr attr, ABT_bool flag)
+{
+#ifdef ABTD_PREEMPT_SUPPORTED
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+    if (flag == ABT_TRUE && (gp_ABTI_global == NULL ||
+                             ABTI_global_get_preempt_interval() == 0)) {
+        abt_errno = ABT_ERR_FEATURE_NA;
+        goto fn_fail;
+    }
+
+    /* Set the value */
+    p_attr->preemptible = flag;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+#else
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the priority in the attribute.
+ *
+ * \c ABT_thread_attr_set_priority() sets the priority in the target attribute
+ * object.  A pool of the kind \c ABT_POOL_PRIO pops ULTs with higher
+ * priorities first, and ULTs with the same priority in the order they were
+ * pushed.  Other pools ignore the priority.  The default priority is 0, which
+ * is also the priority of tasklets.
+ *
+ * @param[in] attr      handle to the target attribute object
+ * @param[in] priority  priority from 0 to \c ABT_POOL_PRIO_NUM_LEVELS - 1
+ * @return Error code
+ * @retval ABT_SUCCESS             on success
+ * @retval ABT_ERR_INV_THREAD_ATTR \c priority is out of range
+ */
+int ABT_thread_attr_set_priority(ABT_thread_attr attr, int priority)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+    ABTI_CHECK_TRUE(priority >= 0 && priority < ABT_POOL_PRIO_NUM_LEVELS,
+                    ABT_ERR_INV_THREAD_ATTR);
+
+    /* Set the value */
+    p_attr->priority = priority;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Get the priority from the attribute object.
+ *
+ * \c ABT_thread_attr_get_priority() returns the priority set by
+ * \c ABT_thread_attr_set_priority() through \c priority.
+ *
+ * @param[in]  attr      handle to the target attribute object
+ * @param[out] priority  priority
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_get_priority(ABT_thread_attr attr, int *priority)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    *priority = p_attr->priority;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the deadline in the attribute.
+ *
+ * \c ABT_thread_attr_set_deadline() sets the deadline in the target attribute
+ * object.  The deadline is an absolute time given by \c ABT_get_wtime().  A
+ * pool of the kind \c ABT_POOL_EDF pops ULTs with earlier deadlines first,
+ * and ULTs without a deadline and tasklets after them.  Other pools ignore the
+ * deadline.  A deadline of 0.0, the default, means that the ULT has none.
+ *
+ * @param[in] attr      handle to the target attribute object
+ * @param[in] deadline  deadline in seconds, or 0.0 for no deadline
+ * @return Error code
+ * @retval ABT_SUCCESS             on success
+ * @retval ABT_ERR_INV_THREAD_ATTR \c deadline is negative
+ */
+int ABT_thread_attr_set_deadline(ABT_thread_attr attr, double deadline)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+    ABTI_CHECK_TRUE(deadline >= 0.0, ABT_ERR_INV_THREAD_ATTR);
+
+    /* Set the value */
+    p_attr->deadline = deadline;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Get the deadline from the attribute object.
+ *
+ * \c ABT_thread_attr_get_deadline() returns the deadline set by
+ * \c ABT_thread_attr_set_deadline() through \c deadline.
+ *
+ * @param[in]  attr      handle to the target attribute object
+ * @param[out] deadline  deadline
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_get_deadline(ABT_thread_attr attr, double *deadline)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    *deadline = p_attr->deadline;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the spawn policy in the attribute.
+ *
+ * \c ABT_thread_attr_set_work_first() selects how \c ABT_thread_create()
+ * starts a ULT created with this attribute.  By default (\c ABT_FALSE), the
+ * new ULT is pushed into its pool and the caller goes on (help-first).  If
+ * \c flag is \c ABT_TRUE and the caller is a ULT associated with the same
+ * pool, the new ULT instead runs right away on the caller's ES, and the caller
+ * is pushed back to the pool, where another ES can steal it (work-first).
+ * For divide-and-conquer programs on a work-stealing pool such as
+ * \c ABT_POOL_DEQUE, this keeps the data of the child in the cache and the
+ * number of units in the pool bounded by the depth of the recursion.  In any
+ * other case, the attribute has no effect.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] flag  spawn policy (<tt>ABT_TRUE</tt>: work-first,
+ *                  <tt>ABT_FALSE</tt>: help-first)
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_set_work_first(ABT_thread_attr attr, ABT_bool flag)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->work_first = flag;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the home ES in the attribute.
+ *
+ * \c ABT_thread_attr_set_home() gives ULTs created with this attribute a
+ * locality hint: the rank of the ES near which their data live, e.g., the ES
+ * that first touched the data.  The hint does not decide where the ULTs are
+ * created, which is still the pool given to \c ABT_thread_create(); the pool
+ * of the home ES can be used with \c ABT_thread_create_on_xstream().  It is
+ * used when ULTs move: \c ABT_thread_migrate() prefers the home ES and ESs on
+ * its NUMA node, and moves the ULT to another node only if the other node is
+ * less loaded by more than \c ABT_SCHED_REMOTE_THRESHOLD units.  Passing
+ * \c ABT_XSTREAM_ANY_RANK, the default, removes the hint.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] rank  rank of the home ES, or \c ABT_XSTREAM_ANY_RANK
+ * @return Error code
+ * @retval ABT_SUCCESS             on success
+ * @retval ABT_ERR_INV_THREAD_ATTR \c rank is neither a valid rank nor
+ *                                 \c ABT_XSTREAM_ANY_RANK
+ */
+int ABT_thread_attr_set_home(ABT_thread_attr attr, int rank)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+    ABTI_CHECK_TRUE(rank >= ABT_XSTREAM_ANY_RANK, ABT_ERR_INV_THREAD_ATTR);
+
+    /* Set the value */
+    p_attr->home = rank;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Get the home ES from the attribute object.
+ *
+ * \c ABT_thread_attr_get_home() returns the rank of the home ES set by
+ * \c ABT_thread_attr_set_home() through \c rank, or \c ABT_XSTREAM_ANY_RANK
+ * if none has been set.
+ *
+ * @param[in]  attr  handle to the target attribute object
+ * @param[out] rank  rank of the home ES
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_get_home(ABT_thread_attr attr, int *rank)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    *rank = p_attr->home;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set whether ULTs are recycled in the attribute.
+ *
+ * \c ABT_thread_attr_set_reusable() sets the reusable flag in the target
+ * attribute object.  If \c flag is \c ABT_TRUE, a ULT created with this
+ * attribute is not released when it is freed on an ES, i.e., by
+ * \c ABT_thread_free() or at the end of an unnamed ULT.  Instead, the ES keeps
+ * up to a small number of such ULTs, and the next \c ABT_thread_create() or
+ * \c ABT_thread_create_many() on the ES with a reusable attribute of the same
+ * stack size takes the most recently freed one with its stack still in the
+ * cache.  A recycled ULT is a new ULT: it gets a new ID when it is asked for
+ * one, and its handle may be equal to the handle of the freed ULT.
+ *
+ * The flag is ignored if the attribute has a stack given by the user or a
+ * deferred stack.  The recycled ULTs of an ES are released when the OS thread
+ * of the ES finishes.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] flag  reusable flag (<tt>ABT_TRUE</tt>: recycle ULTs,
+ *                  <tt>ABT_FALSE</tt>: not)
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_set_reusable(ABT_thread_attr attr, ABT_bool flag)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->reusable = flag;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the join counter in the attribute.
+ *
+ * \c ABT_thread_attr_set_join_counter() sets the join counter \c counter in
+ * the target attribute object.  Each ULT created with this attribute
+ * increments the count of \c counter when it is created or revived and
+ * decrements it when it terminates, so \c ABT_join_counter_wait() on
+ * \c counter returns when all of them have terminated.  Such ULTs can be
+ * unnamed.  If \c counter is \c ABT_JOIN_COUNTER_NULL, the ULTs are not
+ * counted.
+ *
+ * @param[in] attr     handle to the target attribute object
+ * @param[in] counter  handle to the join counter
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_set_join_counter(ABT_thread_attr attr,
+                                     ABT_join_counter counter)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->p_join_counter = ABTI_join_counter_get_ptr(counter);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the gang in the attribute.
+ *
+ * \c ABT_thread_attr_set_gang() sets the gang \c gang in the target attribute
+ * object.  ULTs created with this attribute are members of \c gang and are
+ * dispatched on as many ESs as the members at once, or not at all (see
+ * \c ABT_gang_create()).  If \c gang is \c ABT_GANG_NULL, the ULTs are
+ * dispatched individually.
+ *
+ * @param[in] attr  handle to the target attribute object
+ * @param[in] gang  handle to the gang
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_set_gang(ABT_thread_attr attr, ABT_gang gang)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->p_gang = ABTI_gang_get_ptr(gang);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the preferred core class in the attribute.
+ *
+ * \c ABT_thread_attr_set_core_class() hints that ULTs created with this
+ * attribute, e.g., long-running or latency-critical ones, should run on ESs
+ * bound to cores of \c core_class (see \c ABT_topology_get_core_class()).
+ * With \c ABT_SCHED_RANDWS, an ES on an efficiency core that pops a ULT hinted
+ * with \c ABT_CORE_CLASS_PERF from its own pool passes it to the least loaded
+ * ES on a performance core instead of running it.  ULTs that ESs steal are run
+ * where they are stolen.  The default is \c ABT_CORE_CLASS_ANY, i.e., no
+ * preference.
+ *
+ * @param[in] attr        handle to the target attribute object
+ * @param[in] core_class  \c ABT_CORE_CLASS_ANY, \c ABT_CORE_CLASS_PERF, or
+ *                        \c ABT_CORE_CLASS_EFFICIENCY
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_INV_THREAD_ATTR \c core_class is invalid
+ */
+int ABT_thread_attr_set_core_class(ABT_thread_attr attr, int core_class)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+    ABTI_CHECK_TRUE(core_class >= ABT_CORE_CLASS_ANY &&
+                    core_class <= ABT_CORE_CLASS_EFFICIENCY,
+                    ABT_ERR_INV_THREAD_ATTR);
+
+    /* Set the value */
+    p_attr->core_class = core_class;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Get the preferred core class from the attribute object.
+ *
+ * \c ABT_thread_attr_get_core_class() returns the core class set by
+ * \c ABT_thread_attr_set_core_class() through \c core_class.
+ *
+ * @param[in]  attr        handle to the target attribute object
+ * @param[out] core_class  preferred core class
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_thread_attr_get_core_class(ABT_thread_attr attr, int *core_class)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    *core_class = p_attr->core_class;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
 
 /*****************************************************************************/
 /* Private APIs                                                              */
@@ -309,7 +902,7 @@ int ABT_thread_attr_set_migratable(ABT_thread_attr attr, ABT_bool flag)
 void ABTI_thread_attr_print(ABTI_thread_attr *p_attr, FILE *p_os, int indent)
 {
     char *prefix = ABTU_get_indent_str(indent);
-    char attr[100];
+    char attr[352];
 
     ABTI_thread_attr_get_str(p_attr, attr);
     fprintf(p_os, "%sULT attr: %s\n", prefix, attr);
@@ -330,6 +923,15 @@ void ABTI_thread_attr_get_str(ABTI_thread_attr *p_attr, char *p_buf)
         "stack:%p "
         "stacksize:%zu "
         "userstack:%s "
+        "deferred_stack:%s "
+        "use_fpu:%s "
+        "vector_state:%s "
+        "preemptible:%s "
+        "priority:%d "
+        "deadline:%g "
+        "work_first:%s "
+        "home:%d "
+        "reusable:%s "
         "migratable:%s "
         "cb_func:%p "
         "cb_arg:%p"
@@ -337,6 +939,15 @@ void ABTI_thread_attr_get_str(ABTI_thread_attr *p_attr, char *p_buf)
         p_attr->p_stack,
         p_attr->stacksize,
         (p_attr->userstack == ABT_TRUE ? "TRUE" : "FALSE"),
+        (p_attr->deferred_stack == ABT_TRUE ? "TRUE" : "FALSE"),
+        (p_attr->use_fpu == ABT_TRUE ? "TRUE" : "FALSE"),
+        (p_attr->vector_state == ABT_TRUE ? "TRUE" : "FALSE"),
+        (p_attr->preemptible == ABT_TRUE ? "TRUE" : "FALSE"),
+        p_attr->priority,
+        p_attr->deadline,
+        (p_attr->work_first == ABT_TRUE ? "TRUE" : "FALSE"),
+        p_attr->home,
+        (p_attr->reusable == ABT_TRUE ? "TRUE" : "FALSE"),
         (p_attr->migratable == ABT_TRUE ? "TRUE" : "FALSE"),
         p_attr->f_cb,
         p_attr->p_cb_arg
@@ -347,10 +958,28 @@ void ABTI_thread_attr_get_str(ABTI_thread_attr *p_attr, char *p_buf)
         "stack:%p "
         "stacksize:%zu "
         "userstack:%s "
+        "deferred_stack:%s "
+        "use_fpu:%s "
+        "vector_state:%s "
+        "preemptible:%s "
+        "priority:%d "
+        "deadline:%g "
+        "work_first:%s "
+        "home:%d "
+        "reusable:%s"
         "]",
         p_attr->p_stack,
         p_attr->stacksize,
-        (p_attr->userstack == ABT_TRUE ? "TRUE" : "FALSE")
+        (p_attr->userstack == ABT_TRUE ? "TRUE" : "FALSE"),
+        (p_attr->deferred_stack == ABT_TRUE ? "TRUE" : "FALSE"),
+        (p_attr->use_fpu == ABT_TRUE ? "TRUE" : "FALSE"),
+        (p_attr->vector_state == ABT_TRUE ? "TRUE" : "FALSE"),
+        (p_attr->preemptible == ABT_TRUE ? "TRUE" : "FALSE"),
+        p_attr->priority,
+        p_attr->deadline,
+        (p_attr->work_first == ABT_TRUE ? "TRUE" : "FALSE"),
+        p_attr->home,
+        (p_attr->reusable == ABT_TRUE ? "TRUE" : "FALSE")
     );
 #endif
 }
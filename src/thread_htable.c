@@ -18,16 +18,16 @@ ABTI_thread_htable *ABTI_thread_htable_create(uint32_t num_rows)
     lh_lock_init(&p_htable->mutex);
 #elif defined(HAVE_CLH_H)
     clh_init(&p_htable->mutex);
-#elif defined(USE_PTHREAD_MUTEX)
-    int ret = pthread_mutex_init(&p_htable->mutex, NULL);
-    assert(!ret);
+#elif defined(USE_MCS_LOCK)
+    ABTI_mcs_lock_create(&p_htable->mutex);
 #else
     p_htable->mutex[0] = 0;
     p_htable->mutex[1] = 0;
 #endif
     p_htable->num_elems = 0;
     p_htable->num_rows = num_rows;
-    p_htable->queue = (ABTI_thread_queue *)ABTU_memalign(64, q_size);
+    p_htable->queue = (ABTI_thread_queue *)
+        ABTU_memalign(ABT_CONFIG_CACHE_LINE_SIZE, q_size);
     memset(p_htable->queue, 0, q_size);
     p_htable->h_list = NULL;
     p_htable->l_list = NULL;
@@ -43,9 +43,8 @@ void ABTI_thread_htable_free(ABTI_thread_htable *p_htable)
     lh_lock_destroy(&p_htable->mutex);
 #elif defined(HAVE_CLH_H)
     clh_destroy(&p_htable->mutex);
-#elif defined(USE_PTHREAD_MUTEX)
-    int ret = pthread_mutex_destroy(&p_htable->mutex);
-    assert(!ret);
+#elif defined(USE_MCS_LOCK)
+    ABTI_mcs_lock_free(&p_htable->mutex);
 #endif
     ABTU_free(p_htable->queue);
     ABTU_free(p_htable);
@@ -105,8 +104,10 @@ ABT_bool ABTI_thread_htable_add(ABTI_thread_htable *p_htable, int idx,
         p_queue->tail = p_thread;
     }
     p_queue->num_threads++;
-    ABTI_PTR_UNLOCK(&p_queue->mutex);
+    /* Counted before the row is unlocked so that a waker that pops the ULT
+     * ahead of p_thread cannot see num_elems of zero afterwards. */
     ABTD_atomic_fetch_add_uint32(&p_htable->num_elems, 1);
+    ABTI_PTR_UNLOCK(&p_queue->mutex);
     return ABT_TRUE;
 }
 
@@ -164,8 +165,9 @@ ABT_bool ABTI_thread_htable_add_low(ABTI_thread_htable *p_htable, int idx,
         p_queue->low_tail = p_thread;
     }
     p_queue->low_num_threads++;
-    ABTI_PTR_UNLOCK(&p_queue->low_mutex);
+    /* See ABTI_thread_htable_add() */
     ABTD_atomic_fetch_add_uint32(&p_htable->num_elems, 1);
+    ABTI_PTR_UNLOCK(&p_queue->low_mutex);
     return ABT_TRUE;
 }
 
@@ -247,6 +249,9 @@ ABT_bool ABTI_thread_htable_switch_low(ABTI_thread_queue *p_queue,
         /* Context-switch to p_target */
         ABTI_local_set_thread(p_target);
         p_target->state = ABT_THREAD_STATE_RUNNING;
+        ABTI_trace_thread(ABTI_TRACE_RUN, p_target);
+        ABTI_local_get_xstream()->stats.num_switches++;
+        ABTI_cpu_time_stop_thread(ABTI_local_get_xstream(), p_thread);
         ABTD_thread_context_switch(&p_thread->ctx, &p_target->ctx);
         return ABT_TRUE;
     } else {
@@ -254,3 +259,64 @@ ABT_bool ABTI_thread_htable_switch_low(ABTI_thread_queue *p_queue,
     }
 }
 
+/* Remove p_thread from a singly-linked queue.  p_next of the tail is not
+ * maintained, so the walk stops at the tail. */
+static ABT_bool ABTI_thread_queue_remove(ABTI_thread **pp_head,
+                                         ABTI_thread **pp_tail,
+                                         ABTI_thread *p_thread)
+{
+    ABTI_thread *p_prev = NULL;
+    ABTI_thread *p_curr = *pp_head;
+
+    while (p_curr) {
+        ABT_bool is_tail = (p_curr == *pp_tail) ? ABT_TRUE : ABT_FALSE;
+        ABTI_thread *p_next = is_tail ? NULL
+            : ABTI_thread_get_ptr(p_curr->unit_def.p_next->thread);
+        if (p_curr == p_thread) {
+            if (p_prev) {
+                p_prev->unit_def.p_next = p_curr->unit_def.p_next;
+            } else {
+                *pp_head = p_next;
+            }
+            if (is_tail) *pp_tail = p_prev;
+            return ABT_TRUE;
+        }
+        p_prev = p_curr;
+        p_curr = p_next;
+    }
+    return ABT_FALSE;
+}
+
+/* Remove p_thread from any queue of p_htable.  An emptied queue is left in
+ * h_list or l_list, which the wakers skip and remove. */
+ABT_bool ABTI_thread_htable_remove(ABTI_thread_htable *p_htable,
+                                   ABTI_thread *p_thread)
+{
+    uint32_t i;
+    ABT_bool found;
+
+    for (i = 0; i < p_htable->num_rows; i++) {
+        ABTI_thread_queue *p_queue = &p_htable->queue[i];
+
+        ABTI_PTR_SPINLOCK(&p_queue->mutex);
+        found = ABTI_thread_queue_remove(&p_queue->head, &p_queue->tail,
+                                         p_thread);
+        if (found == ABT_TRUE) {
+            p_queue->num_threads--;
+            ABTD_atomic_fetch_sub_uint32(&p_htable->num_elems, 1);
+        }
+        ABTI_PTR_UNLOCK(&p_queue->mutex);
+        if (found == ABT_TRUE) return ABT_TRUE;
+
+        ABTI_PTR_SPINLOCK(&p_queue->low_mutex);
+        found = ABTI_thread_queue_remove(&p_queue->low_head,
+                                         &p_queue->low_tail, p_thread);
+        if (found == ABT_TRUE) {
+            p_queue->low_num_threads--;
+            ABTD_atomic_fetch_sub_uint32(&p_htable->num_elems, 1);
+        }
+        ABTI_PTR_UNLOCK(&p_queue->low_mutex);
+        if (found == ABT_TRUE) return ABT_TRUE;
+    }
+    return ABT_FALSE;
+}
@@ -0,0 +1,469 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Timed waits.  A ULT that waits with a deadline registers an ABTI_timeout in
+ * the timer wheel of its ES and in the wait queue of the synchronization
+ * object, and then it is suspended.  Either the signaler of the object or the
+ * scheduler of the ES, which expires the timeouts in the wheel whenever it
+ * checks events, wakes up the ULT, whichever changes the state first.
+ *
+ * The waiter itself never touches the wheel after it is suspended.  The
+ * signaler unlinks the timeout from the wheel before it makes the ULT ready,
+ * and the scheduler unlinks it before it changes the state.  External threads
+ * do not use the wheel and poll the state and the clock instead.
+ *
+ * A sleeping ULT puts its timeout only in the wheel, so it is woken up by the
+ * scheduler.  The wheel is hierarchical: a timeout is kept in a coarse bucket
+ * of an upper level until the bucket is reached, and then it is moved down,
+ * so timeouts far in the future are not scanned at every turn of level 0.
+ *
+ * A timeout that has f_expire, e.g., that of a delayed work unit, is not a
+ * waiter.  The wheel calls f_expire once the deadline passes, after the lock
+ * of the wheel is released, so f_expire may start the timeout again. */
+
+static void ABTI_timer_wheel_add(ABTI_timer_wheel *p_wheel,
+                                 ABTI_timeout *p_timeout);
+static void ABTI_timer_wheel_insert(ABTI_timer_wheel *p_wheel,
+                                    ABTI_timeout *p_timeout);
+static void ABTI_timer_wheel_cascade(ABTI_timer_wheel *p_wheel);
+static void ABTI_timer_wheel_unlink(ABTI_timer_wheel *p_wheel,
+                                    ABTI_timeout *p_timeout);
+static ABTI_unit *ABTI_timeout_chain_thread(ABTI_unit *p_threads,
+                                            ABTI_thread *p_thread);
+static void ABTI_timeout_call_expire(ABTI_timeout *p_timeouts);
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+void ABTI_timer_wheel_init(ABTI_timer_wheel *p_wheel)
+{
+    int i;
+
+    ABTI_spinlock_create(&p_wheel->lock);
+    p_wheel->num_entries = 0;
+    for (i = 0; i <= ABTI_TIMER_WHEEL_LEVELS; i++) {
+        p_wheel->num_level_entries[i] = 0;
+    }
+    p_wheel->cur_tick = ABTI_timer_wheel_get_tick(ABTI_timeout_get_time());
+    p_wheel->is_closed = ABT_FALSE;
+    for (i = 0; i < ABTI_TIMER_WHEEL_LEVELS * ABTI_TIMER_WHEEL_SIZE + 1; i++) {
+        p_wheel->buckets[i] = NULL;
+    }
+}
+
+/* Expire all the timeouts left in the wheel of an ES being freed.  Timeouts
+ * that have been signaled are unlinked by their signalers, so this waits for
+ * them before the wheel is freed.  The wheel is closed first, so periodic
+ * timeouts are not started again in it. */
+void ABTI_timer_wheel_fini(ABTI_timer_wheel *p_wheel)
+{
+    ABTI_spinlock_acquire(&p_wheel->lock);
+    p_wheel->is_closed = ABT_TRUE;
+    ABTI_spinlock_release(&p_wheel->lock);
+
+    while (1) {
+        ABTI_unit *p_threads = NULL;
+        ABTI_timeout *p_expired = NULL;
+        uint32_t num_entries;
+        int i;
+
+        ABTI_spinlock_acquire(&p_wheel->lock);
+        for (i = 0; i < ABTI_TIMER_WHEEL_LEVELS * ABTI_TIMER_WHEEL_SIZE + 1;
+             i++) {
+            ABTI_timeout *p_timeout = p_wheel->buckets[i];
+            while (p_timeout) {
+                ABTI_timeout *p_next = p_timeout->p_next;
+                ABTI_thread *p_thread = p_timeout->p_thread;
+                if (p_timeout->f_expire) {
+                    ABTI_timer_wheel_unlink(p_wheel, p_timeout);
+                    p_timeout->p_next = p_expired;
+                    p_expired = p_timeout;
+                } else if (ABTD_atomic_cas_uint32(&p_timeout->state,
+                                                  ABTI_TIMEOUT_WAITING,
+                                                  ABTI_TIMEOUT_EXPIRED)
+                           == ABTI_TIMEOUT_WAITING) {
+                    ABTI_timer_wheel_unlink(p_wheel, p_timeout);
+                    p_threads = ABTI_timeout_chain_thread(p_threads, p_thread);
+                }
+                p_timeout = p_next;
+            }
+        }
+        num_entries = p_wheel->num_entries;
+        ABTI_spinlock_release(&p_wheel->lock);
+
+        ABTI_thread_set_ready_list(p_threads);
+        ABTI_timeout_call_expire(p_expired);
+        if (num_entries == 0) break;
+        ABTD_atomic_pause();
+    }
+    ABTI_spinlock_free(&p_wheel->lock);
+}
+
+/* Wake up the ULTs whose deadlines have passed.  The buckets of level 0 are
+ * processed one tick at a time, but the ticks for which all the lower levels
+ * are empty are skipped at once. */
+void ABTI_timer_wheel_expire(ABTI_timer_wheel *p_wheel)
+{
+    ABTI_unit *p_threads = NULL;
+    ABTI_timeout *p_expired = NULL;
+    double now = ABTI_timeout_get_time();
+    uint64_t now_tick = ABTI_timer_wheel_get_tick(now);
+
+    ABTI_spinlock_acquire(&p_wheel->lock);
+
+    while (1) {
+        uint64_t tick = p_wheel->cur_tick;
+        int level;
+
+        if (p_wheel->num_level_entries[0] > 0) {
+            uint32_t bucket = (uint32_t)(tick & (ABTI_TIMER_WHEEL_SIZE - 1));
+            ABTI_timeout *p_timeout = p_wheel->buckets[bucket];
+            while (p_timeout) {
+                ABTI_timeout *p_next = p_timeout->p_next;
+                if (tick < now_tick || p_timeout->deadline <= now) {
+                    ABTI_thread *p_thread = p_timeout->p_thread;
+                    ABTI_timer_wheel_unlink(p_wheel, p_timeout);
+                    if (p_timeout->f_expire) {
+                        p_timeout->p_next = p_expired;
+                        p_expired = p_timeout;
+                        p_timeout = p_next;
+                        continue;
+                    }
+                    /* The timeout must not be touched once the state is
+                     * changed since a signaled waiter may return at any
+                     * time. */
+                    if (ABTD_atomic_cas_uint32(&p_timeout->state,
+                                               ABTI_TIMEOUT_WAITING,
+                                               ABTI_TIMEOUT_EXPIRED)
+                        == ABTI_TIMEOUT_WAITING) {
+                        p_threads = ABTI_timeout_chain_thread(p_threads,
+                                                              p_thread);
+                    }
+                }
+                p_timeout = p_next;
+            }
+        }
+        /* Ticks after now_tick are not processed even if the clock has been
+         * set back. */
+        if (tick >= now_tick) break;
+
+        level = 0;
+        while (level < ABTI_TIMER_WHEEL_LEVELS &&
+               p_wheel->num_level_entries[level] == 0) {
+            level++;
+        }
+        if (level > 0) {
+            int shift = ABTI_TIMER_WHEEL_BITS * level;
+            tick = ((tick >> shift) + 1) << shift;
+            if (tick > now_tick) {
+                /* No bucket of the nonempty levels is reached. */
+                p_wheel->cur_tick = now_tick;
+                break;
+            }
+        } else {
+            tick++;
+        }
+        p_wheel->cur_tick = tick;
+        ABTI_timer_wheel_cascade(p_wheel);
+    }
+
+    ABTI_spinlock_release(&p_wheel->lock);
+
+    ABTI_thread_set_ready_list(p_threads);
+    ABTI_timeout_call_expire(p_expired);
+}
+
+/* Start a timed wait of the caller, which has to be a ULT or an external
+ * thread.  A ULT is blocked and its timeout is put in the wheel of its ES, so
+ * this has to be called before the waiter becomes visible to signalers.  The
+ * ULT must not yield until ABTI_timeout_wait() is called. */
+void ABTI_timeout_prepare(ABTI_timeout *p_timeout, double deadline)
+{
+    p_timeout->state = ABTI_TIMEOUT_WAITING;
+    p_timeout->linked = ABT_FALSE;
+    p_timeout->bucket = 0;
+    p_timeout->p_thread = NULL;
+    p_timeout->p_wheel = NULL;
+    p_timeout->f_expire = NULL;
+    p_timeout->deadline = deadline;
+    p_timeout->p_prev = NULL;
+    p_timeout->p_next = NULL;
+
+    if (lp_ABTI_local != NULL) {
+        ABTI_thread *p_thread = ABTI_local_get_thread();
+        ABTI_ASSERT(p_thread != NULL);
+        p_timeout->p_thread = p_thread;
+        p_timeout->p_wheel = &ABTI_local_get_xstream()->timer_wheel;
+        ABTI_thread_set_blocked(p_thread);
+        ABTI_timer_wheel_add(p_timeout->p_wheel, p_timeout);
+    }
+}
+
+/* Wait until the waiter is signaled or the deadline passes.  Returns ABT_TRUE
+ * if it has been signaled.  If ABT_FALSE is returned, the caller has to remove
+ * itself from the wait queue of the synchronization object. */
+ABT_bool ABTI_timeout_wait(ABTI_timeout *p_timeout)
+{
+    volatile uint32_t *p_state = (volatile uint32_t *)&p_timeout->state;
+
+    if (p_timeout->p_thread) {
+        ABTI_thread_suspend(p_timeout->p_thread);
+    } else {
+        /* External thread */
+        while (*p_state == ABTI_TIMEOUT_WAITING) {
+            if (ABTI_timeout_get_time() >= p_timeout->deadline) {
+                ABTD_atomic_cas_uint32(&p_timeout->state, ABTI_TIMEOUT_WAITING,
+                                       ABTI_TIMEOUT_EXPIRED);
+            } else {
+                ABTD_atomic_pause();
+            }
+        }
+    }
+    return (*p_state == ABTI_TIMEOUT_SIGNALED) ? ABT_TRUE : ABT_FALSE;
+}
+
+/* Wake up the waiter unless its deadline has passed.  This has to be called
+ * while the waiter is found in the wait queue, i.e., with the lock that stops
+ * it from leaving the queue.  Returns ABT_FALSE if the waiter has timed out,
+ * in which case the signaler should pick another waiter. */
+ABT_bool ABTI_timeout_signal(ABTI_timeout *p_timeout)
+{
+    ABTI_thread *p_thread = p_timeout->p_thread;
+    ABTI_timer_wheel *p_wheel = p_timeout->p_wheel;
+
+    if (ABTD_atomic_cas_uint32(&p_timeout->state, ABTI_TIMEOUT_WAITING,
+                               ABTI_TIMEOUT_SIGNALED)
+        != ABTI_TIMEOUT_WAITING) {
+        return ABT_FALSE;
+    }
+
+    /* An external thread may return as soon as the state is changed, but a
+     * ULT does not until it is made ready. */
+    if (p_thread) {
+        ABTI_spinlock_acquire(&p_wheel->lock);
+        if (p_timeout->linked == ABT_TRUE) {
+            ABTI_timer_wheel_unlink(p_wheel, p_timeout);
+        }
+        ABTI_spinlock_release(&p_wheel->lock);
+        ABTI_thread_set_ready(p_thread);
+    }
+    return ABT_TRUE;
+}
+
+/* Give up a timed wait that has been prepared, e.g., because the condition is
+ * satisfied before the waiter is put in the wait queue.  Returns ABT_FALSE if
+ * the waiter has already been woken up by someone else; in this case, the
+ * wakeup is consumed here. */
+ABT_bool ABTI_timeout_cancel(ABTI_timeout *p_timeout)
+{
+    ABTI_thread *p_thread = p_timeout->p_thread;
+
+    if (ABTD_atomic_cas_uint32(&p_timeout->state, ABTI_TIMEOUT_WAITING,
+                               ABTI_TIMEOUT_EXPIRED)
+        == ABTI_TIMEOUT_WAITING) {
+        if (p_thread) {
+            ABTI_timer_wheel *p_wheel = p_timeout->p_wheel;
+            ABTI_spinlock_acquire(&p_wheel->lock);
+            if (p_timeout->linked == ABT_TRUE) {
+                ABTI_timer_wheel_unlink(p_wheel, p_timeout);
+            }
+            ABTI_spinlock_release(&p_wheel->lock);
+            ABTI_thread_unset_blocked(p_thread);
+        }
+        return ABT_TRUE;
+    }
+
+    if (p_thread) ABTI_thread_suspend(p_thread);
+    return ABT_FALSE;
+}
+
+/* Put p_timeout, which is not a waiter, in p_wheel so that f_expire is called
+ * once the deadline passes.  Returns ABT_FALSE if the wheel has been closed
+ * because its ES is being freed. */
+ABT_bool ABTI_timeout_start(ABTI_timeout *p_timeout, ABTI_timer_wheel *p_wheel,
+                            double deadline,
+                            void (*f_expire)(ABTI_timeout *))
+{
+    ABT_bool started = ABT_FALSE;
+
+    p_timeout->state = ABTI_TIMEOUT_WAITING;
+    p_timeout->p_thread = NULL;
+    p_timeout->f_expire = f_expire;
+    p_timeout->deadline = deadline;
+
+    ABTI_spinlock_acquire(&p_wheel->lock);
+    if (p_wheel->is_closed == ABT_FALSE) {
+        p_timeout->p_wheel = p_wheel;
+        ABTI_timer_wheel_insert(p_wheel, p_timeout);
+        started = ABT_TRUE;
+    } else {
+        p_timeout->p_wheel = NULL;
+    }
+    ABTI_spinlock_release(&p_wheel->lock);
+    return started;
+}
+
+/* Take a timeout started by ABTI_timeout_start() out of its wheel.  Returns
+ * ABT_FALSE if it is not in the wheel, e.g., because it is expiring, in which
+ * case f_expire is called as usual. */
+ABT_bool ABTI_timeout_stop(ABTI_timeout *p_timeout)
+{
+    ABTI_timer_wheel *p_wheel;
+    ABT_bool stopped = ABT_FALSE;
+
+    p_wheel = *(ABTI_timer_wheel * volatile *)&p_timeout->p_wheel;
+    if (p_wheel == NULL) return ABT_FALSE;
+
+    /* The timeout may be started in another wheel in the meantime. */
+    ABTI_spinlock_acquire(&p_wheel->lock);
+    if (p_timeout->p_wheel == p_wheel && p_timeout->linked == ABT_TRUE) {
+        ABTI_timer_wheel_unlink(p_wheel, p_timeout);
+        stopped = ABT_TRUE;
+    }
+    ABTI_spinlock_release(&p_wheel->lock);
+    return stopped;
+}
+
+/* Sleep until the deadline.  A ULT is woken up only by the timer wheel. */
+void ABTI_thread_sleep(double deadline)
+{
+    ABTI_timeout timeout;
+    double remain;
+
+    if (lp_ABTI_local != NULL) {
+        ABTI_timeout_prepare(&timeout, deadline);
+        ABTI_timeout_wait(&timeout);
+        return;
+    }
+
+    /* External thread */
+    while ((remain = deadline - ABTI_timeout_get_time()) > 0.0) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)remain;
+        ts.tv_nsec = (long)((remain - (double)ts.tv_sec) * 1.0e9);
+        nanosleep(&ts, NULL);
+    }
+}
+
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void ABTI_timer_wheel_add(ABTI_timer_wheel *p_wheel,
+                                 ABTI_timeout *p_timeout)
+{
+    ABTI_spinlock_acquire(&p_wheel->lock);
+    ABTI_timer_wheel_insert(p_wheel, p_timeout);
+    ABTI_spinlock_release(&p_wheel->lock);
+}
+
+/* Put a timeout in the lowest level whose current bucket covers the deadline.
+ * The caller has to hold the lock of p_wheel. */
+static void ABTI_timer_wheel_insert(ABTI_timer_wheel *p_wheel,
+                                    ABTI_timeout *p_timeout)
+{
+    uint64_t tick = ABTI_timer_wheel_get_tick(p_timeout->deadline);
+    uint64_t diff;
+    ABTI_timeout **pp_bucket;
+    int level;
+
+    /* A deadline that has passed is expired at the next check. */
+    if (tick < p_wheel->cur_tick) tick = p_wheel->cur_tick;
+    diff = tick ^ p_wheel->cur_tick;
+    for (level = 0; level < ABTI_TIMER_WHEEL_LEVELS; level++) {
+        if ((diff >> (ABTI_TIMER_WHEEL_BITS * (level + 1))) == 0) break;
+    }
+    if (level < ABTI_TIMER_WHEEL_LEVELS) {
+        uint64_t index = tick >> (ABTI_TIMER_WHEEL_BITS * level);
+        p_timeout->bucket = (uint32_t)(level * ABTI_TIMER_WHEEL_SIZE +
+                                       (index & (ABTI_TIMER_WHEEL_SIZE - 1)));
+    } else {
+        /* Overflow bucket */
+        p_timeout->bucket = ABTI_TIMER_WHEEL_LEVELS * ABTI_TIMER_WHEEL_SIZE;
+    }
+    pp_bucket = &p_wheel->buckets[p_timeout->bucket];
+
+    p_timeout->p_prev = NULL;
+    p_timeout->p_next = *pp_bucket;
+    if (*pp_bucket) (*pp_bucket)->p_prev = p_timeout;
+    *pp_bucket = p_timeout;
+    p_timeout->linked = ABT_TRUE;
+    p_wheel->num_level_entries[level]++;
+    p_wheel->num_entries++;
+}
+
+/* Move the timeouts in the buckets of the upper levels that cur_tick has just
+ * reached down to the lower levels.  The caller has to hold the lock of
+ * p_wheel. */
+static void ABTI_timer_wheel_cascade(ABTI_timer_wheel *p_wheel)
+{
+    uint64_t tick = p_wheel->cur_tick;
+    int level;
+
+    for (level = ABTI_TIMER_WHEEL_LEVELS; level > 0; level--) {
+        int shift = ABTI_TIMER_WHEEL_BITS * level;
+        uint32_t bucket;
+        ABTI_timeout *p_timeout;
+
+        if ((tick & ((UINT64_C(1) << shift) - 1)) != 0) continue;
+        if (p_wheel->num_level_entries[level] == 0) continue;
+
+        if (level == ABTI_TIMER_WHEEL_LEVELS) {
+            bucket = ABTI_TIMER_WHEEL_LEVELS * ABTI_TIMER_WHEEL_SIZE;
+        } else {
+            bucket = (uint32_t)(level * ABTI_TIMER_WHEEL_SIZE +
+                                ((tick >> shift) & (ABTI_TIMER_WHEEL_SIZE - 1)));
+        }
+        p_timeout = p_wheel->buckets[bucket];
+        while (p_timeout) {
+            ABTI_timeout *p_next = p_timeout->p_next;
+            ABTI_timer_wheel_unlink(p_wheel, p_timeout);
+            ABTI_timer_wheel_insert(p_wheel, p_timeout);
+            p_timeout = p_next;
+        }
+    }
+}
+
+/* The caller has to hold the lock of p_wheel. */
+static void ABTI_timer_wheel_unlink(ABTI_timer_wheel *p_wheel,
+                                    ABTI_timeout *p_timeout)
+{
+    if (p_timeout->p_prev) {
+        p_timeout->p_prev->p_next = p_timeout->p_next;
+    } else {
+        p_wheel->buckets[p_timeout->bucket] = p_timeout->p_next;
+    }
+    if (p_timeout->p_next) p_timeout->p_next->p_prev = p_timeout->p_prev;
+    p_timeout->p_prev = NULL;
+    p_timeout->p_next = NULL;
+    p_timeout->linked = ABT_FALSE;
+    p_wheel->num_level_entries[p_timeout->bucket / ABTI_TIMER_WHEEL_SIZE]--;
+    p_wheel->num_entries--;
+}
+
+static ABTI_unit *ABTI_timeout_chain_thread(ABTI_unit *p_threads,
+                                            ABTI_thread *p_thread)
+{
+    ABTI_unit *p_unit = &p_thread->unit_def;
+    p_unit->thread = ABTI_thread_get_handle(p_thread);
+    p_unit->type = ABT_UNIT_TYPE_THREAD;
+    p_unit->p_next = p_threads;
+    return p_unit;
+}
+
+static void ABTI_timeout_call_expire(ABTI_timeout *p_timeouts)
+{
+    while (p_timeouts) {
+        ABTI_timeout *p_next = p_timeouts->p_next;
+        p_timeouts->p_next = NULL;
+        p_timeouts->f_expire(p_timeouts);
+        p_timeouts = p_next;
+    }
+}
@@ -5,6 +5,14 @@
 
 #include "abti.h"
 
+/* The end time may precede the start time if the timer has not been stopped
+ * since it was restarted. */
+static inline double ABTI_timer_get_elapsed(ABTI_timer *p_timer)
+{
+    int64_t diff = (int64_t)(p_timer->end - p_timer->start);
+    if (diff < 0) return -ABTD_time_ticks_to_sec((uint64_t)-diff);
+    return ABTD_time_ticks_to_sec((uint64_t)diff);
+}
 
 /** @defgroup TIMER  Timer
  * This group is for Timer.
@@ -24,10 +32,49 @@
 double ABT_get_wtime(void)
 {
     ABTD_time t;
+    uint64_t ticks;
+
+    if (ABTD_time_get_ticks_source() == ABTD_TIME_TICKS_CYCLES) {
+        ticks = ABTD_time_get_ticks();
+        return g_ABTD_time_base_sec
+             + ABTD_time_ticks_to_sec(ticks - g_ABTD_time_base_ticks);
+    }
     ABTD_time_get(&t);
     return ABTD_time_read_sec(&t);
 }
 
+/**
+ * @ingroup TIMER
+ * @brief   Read the tick counter.
+ *
+ * \c ABT_get_ticks() returns the value of a monotonic tick counter, which is
+ * much cheaper to read than \c ABT_get_wtime().  The counter is the invariant
+ * TSC on x86 and the generic timer on ARM64, calibrated when first used; on
+ * other systems or when the counter does not tick at a constant rate across
+ * cores, it counts nanoseconds.  Use \c ABT_ticks_to_sec() to convert the
+ * difference of two values to seconds.
+ *
+ * @return Current value of the tick counter
+ */
+uint64_t ABT_get_ticks(void)
+{
+    return ABTD_time_get_ticks();
+}
+
+/**
+ * @ingroup TIMER
+ * @brief   Convert ticks to seconds.
+ *
+ * \c ABT_ticks_to_sec() returns \c ticks of \c ABT_get_ticks() in seconds.
+ *
+ * @param[in] ticks  number of ticks
+ * @return Time in seconds
+ */
+double ABT_ticks_to_sec(uint64_t ticks)
+{
+    return ABTD_time_ticks_to_sec(ticks);
+}
+
 /**
  * @ingroup TIMER
  * @brief   Create a new timer.
@@ -156,7 +203,7 @@ int ABT_timer_start(ABT_timer timer)
     ABTI_timer *p_timer = ABTI_timer_get_ptr(timer);
     ABTI_CHECK_NULL_TIMER_PTR(p_timer);
 
-    ABTD_time_get(&p_timer->start);
+    p_timer->start = ABTD_time_get_ticks();
 
   fn_exit:
     return abt_errno;
@@ -184,7 +231,7 @@ int ABT_timer_stop(ABT_timer timer)
     ABTI_timer *p_timer = ABTI_timer_get_ptr(timer);
     ABTI_CHECK_NULL_TIMER_PTR(p_timer);
 
-    ABTD_time_get(&p_timer->end);
+    p_timer->end = ABTD_time_get_ticks();
 
   fn_exit:
     return abt_errno;
@@ -214,12 +261,7 @@ int ABT_timer_read(ABT_timer timer, double *secs)
     ABTI_timer *p_timer = ABTI_timer_get_ptr(timer);
     ABTI_CHECK_NULL_TIMER_PTR(p_timer);
 
-    double start, end;
-
-    start = ABTD_time_read_sec(&p_timer->start);
-    end   = ABTD_time_read_sec(&p_timer->end);
-
-    *secs = end - start;
+    *secs = ABTI_timer_get_elapsed(p_timer);
 
   fn_exit:
     return abt_errno;
@@ -250,13 +292,8 @@ int ABT_timer_stop_and_read(ABT_timer timer, double *secs)
     ABTI_timer *p_timer = ABTI_timer_get_ptr(timer);
     ABTI_CHECK_NULL_TIMER_PTR(p_timer);
 
-    double start, end;
-
-    ABTD_time_get(&p_timer->end);
-    start = ABTD_time_read_sec(&p_timer->start);
-    end   = ABTD_time_read_sec(&p_timer->end);
-
-    *secs = end - start;
+    p_timer->end = ABTD_time_get_ticks();
+    *secs = ABTI_timer_get_elapsed(p_timer);
 
   fn_exit:
     return abt_errno;
@@ -287,13 +324,8 @@ int ABT_timer_stop_and_add(ABT_timer timer, double *secs)
     ABTI_timer *p_timer = ABTI_timer_get_ptr(timer);
     ABTI_CHECK_NULL_TIMER_PTR(p_timer);
 
-    double start, end;
-
-    ABTD_time_get(&p_timer->end);
-    start = ABTD_time_read_sec(&p_timer->start);
-    end   = ABTD_time_read_sec(&p_timer->end);
-
-    *secs += (end - start);
+    p_timer->end = ABTD_time_get_ticks();
+    *secs += ABTI_timer_get_elapsed(p_timer);
 
   fn_exit:
     return abt_errno;
@@ -0,0 +1,234 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+
+/** @defgroup TOPOLOGY  Topology
+ * This group is for the hardware topology of ESs, which user-defined
+ * schedulers and pools can use to decide where to push and steal work units.
+ */
+
+
+/**
+ * @ingroup TOPOLOGY
+ * @brief   Get the ID of the hardware object that contains the target ES.
+ *
+ * \c ABT_topology_get_id() returns through \c id the ID of the object at
+ * \c level (\c ABT_TOPOLOGY_CPU, \c ABT_TOPOLOGY_CORE, \c ABT_TOPOLOGY_L3,
+ * \c ABT_TOPOLOGY_NUMA, or \c ABT_TOPOLOGY_SOCKET) that contains the CPU the
+ * ES \c xstream is bound to.  Two ESs share an object if and only if they get
+ * the same ID for its level.  Cores and L3 caches are identified by the
+ * smallest CPU ID among their CPUs, and NUMA nodes and sockets by the IDs of
+ * the OS.
+ *
+ * \c id is set to -1 if \c xstream is not bound to a single CPU (see
+ * \c ABT_SET_AFFINITY) or the object is not known.
+ *
+ * @param[in]  xstream  handle to the target ES
+ * @param[in]  level    level of the topology
+ * @param[out] id       ID of the object
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_OTHER if \c level is invalid
+ */
+int ABT_topology_get_id(ABT_xstream xstream, int level, int *id)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+    ABTI_CHECK_TRUE(level >= 0 && level < ABT_TOPOLOGY_NUM_LEVELS,
+                    ABT_ERR_OTHER);
+
+    *id = ABTD_affinity_get_topology_id(p_xstream->ctx, level);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TOPOLOGY
+ * @brief   Get the hardware distance between two ESs.
+ *
+ * \c ABT_topology_get_distance() returns through \c distance the closest
+ * level that the CPUs of \c xstream1 and \c xstream2 share, as one of
+ * \c ABT_SCHED_STEAL_DIST_SMT (the same core), \c ABT_SCHED_STEAL_DIST_L3,
+ * \c ABT_SCHED_STEAL_DIST_NUMA, and \c ABT_SCHED_STEAL_DIST_REMOTE.  A smaller
+ * value means a closer pair.  ESs that are not bound to a single CPU are
+ * regarded as remote from the others.
+ *
+ * @param[in]  xstream1  handle to the first ES
+ * @param[in]  xstream2  handle to the second ES
+ * @param[out] distance  hardware distance
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_topology_get_distance(ABT_xstream xstream1, ABT_xstream xstream2,
+                              int *distance)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream1 = ABTI_xstream_get_ptr(xstream1);
+    ABTI_xstream *p_xstream2 = ABTI_xstream_get_ptr(xstream2);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream1);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream2);
+
+    if (p_xstream1 == p_xstream2) {
+        *distance = ABT_SCHED_STEAL_DIST_SMT;
+    } else {
+        *distance = ABTD_affinity_get_distance(p_xstream1->ctx,
+                                               p_xstream2->ctx);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TOPOLOGY
+ * @brief   Get the distance matrix of ESs.
+ *
+ * \c ABT_topology_get_distances() fills \c distances, an array of
+ * \c num_xstreams * \c num_xstreams integers, so that
+ * \c distances[i * num_xstreams + j] is the distance between \c xstreams[i]
+ * and \c xstreams[j] returned by \c ABT_topology_get_distance().  The matrix
+ * is symmetric.
+ *
+ * @param[in]  num_xstreams  number of ESs
+ * @param[in]  xstreams      array of handles to the ESs
+ * @param[out] distances     distance matrix
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_topology_get_distances(int num_xstreams, const ABT_xstream *xstreams,
+                               int *distances)
+{
+    int abt_errno = ABT_SUCCESS;
+    int i, j;
+
+    for (i = 0; i < num_xstreams; i++) {
+        distances[i * num_xstreams + i] = ABT_SCHED_STEAL_DIST_SMT;
+        for (j = 0; j < i; j++) {
+            int dist;
+            abt_errno = ABT_topology_get_distance(xstreams[i], xstreams[j],
+                                                  &dist);
+            ABTI_CHECK_ERROR(abt_errno);
+            distances[i * num_xstreams + j] = dist;
+            distances[j * num_xstreams + i] = dist;
+        }
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TOPOLOGY
+ * @brief   Get the number of NUMA nodes.
+ *
+ * \c ABT_topology_get_num_nodes() returns through \c num_nodes the number of
+ * NUMA nodes, which is one more than the largest ID that
+ * \c ABT_topology_get_id() returns for \c ABT_TOPOLOGY_NUMA.  It is 1 if the
+ * NUMA topology is not available.
+ *
+ * @param[out] num_nodes  number of NUMA nodes
+ * @return Error code
+ * @retval ABT_SUCCESS            on success
+ * @retval ABT_ERR_UNINITIALIZED  Argobots has not been initialized
+ */
+int ABT_topology_get_num_nodes(int *num_nodes)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_CHECK_INITIALIZED();
+
+    *num_nodes = ABTD_affinity_get_num_nodes();
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TOPOLOGY
+ * @brief   Get the class of the core that the target ES is bound to.
+ *
+ * \c ABT_topology_get_core_class() returns through \c core_class whether the
+ * ES \c xstream runs on a performance core (\c ABT_CORE_CLASS_PERF) or an
+ * efficiency core (\c ABT_CORE_CLASS_EFFICIENCY) of a heterogeneous processor,
+ * such as ARM big.LITTLE or Intel hybrid processors.  The class is detected
+ * from sysfs when the ES is bound to a CPU.  ESs that are not bound to a
+ * single CPU and ESs on homogeneous processors are on performance cores.
+ * \c ABT_SCHED_RANDWS prefers stealing from ESs on efficiency cores, which
+ * finish their units later.
+ *
+ * @param[in]  xstream     handle to the target ES
+ * @param[out] core_class  class of the core
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_topology_get_core_class(ABT_xstream xstream, int *core_class)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+
+    *core_class = p_xstream->core_class;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup TOPOLOGY
+ * @brief   Set the class of the core that the target ES is bound to.
+ *
+ * \c ABT_topology_set_core_class() overrides the detected class of the core
+ * of \c xstream, e.g., when the OS does not tell the classes apart.  The
+ * class is detected again when the ES is bound to another CPU.
+ *
+ * @param[in] xstream     handle to the target ES
+ * @param[in] core_class  \c ABT_CORE_CLASS_PERF or \c ABT_CORE_CLASS_EFFICIENCY
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ * @retval ABT_ERR_OTHER if \c core_class is invalid
+ */
+int ABT_topology_set_core_class(ABT_xstream xstream, int core_class)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_xstream *p_xstream = ABTI_xstream_get_ptr(xstream);
+    ABTI_CHECK_NULL_XSTREAM_PTR(p_xstream);
+    ABTI_CHECK_TRUE(core_class == ABT_CORE_CLASS_PERF ||
+                    core_class == ABT_CORE_CLASS_EFFICIENCY, ABT_ERR_OTHER);
+
+    if (p_xstream->core_class != core_class) {
+        p_xstream->core_class = core_class;
+        ABTD_atomic_fetch_add_uint32(&gp_ABTI_global->core_class_gen, 1);
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
@@ -0,0 +1,237 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+#include <unistd.h>
+
+/* Event tracing.  Each ES records binary events in its own ring buffer (see
+ * abti_trace.h).  The buffers outlive their ESs so that the whole execution
+ * can be dumped on ABT_finalize().  A dump is a JSON file in the Chrome trace
+ * event format, in which every ES is a thread of the process. */
+
+static const char *g_trace_names[ABTI_TRACE_NUM_KINDS] = {
+    "create", "push", "pop", "steal", "run", "stop", "block"
+};
+
+void ABTI_trace_init(void)
+{
+    gp_ABTI_global->p_trace_bufs = NULL;
+    /* The cycle counter is calibrated against ABT_get_wtime() when the
+     * traces are dumped. */
+    gp_ABTI_global->trace_cycles = ABTD_time_get_cycles();
+    gp_ABTI_global->trace_wtime = ABT_get_wtime();
+}
+
+void ABTI_trace_xstream_init(ABTI_xstream *p_xstream)
+{
+    ABTI_trace_buf *p_buf;
+    uint64_t size = 1;
+
+    p_xstream->p_trace = NULL;
+    if (gp_ABTI_global->use_tracing == ABT_FALSE) return;
+
+    while (size < gp_ABTI_global->trace_size) size <<= 1;
+
+    p_buf = (ABTI_trace_buf *)ABTU_malloc(sizeof(ABTI_trace_buf));
+    p_buf->pos = 0;
+    p_buf->mask = size - 1;
+    p_buf->rank = p_xstream->rank;
+    p_buf->p_entries = (ABTI_trace_entry *)ABTU_malloc(
+            size * sizeof(ABTI_trace_entry));
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    p_buf->p_next = gp_ABTI_global->p_trace_bufs;
+    gp_ABTI_global->p_trace_bufs = p_buf;
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+
+    p_xstream->p_trace = p_buf;
+}
+
+void ABTI_trace_finalize(void)
+{
+    ABTI_trace_buf *p_buf = gp_ABTI_global->p_trace_bufs;
+    char *filename = gp_ABTI_global->trace_filename;
+    char default_name[64];
+    FILE *fp;
+
+    if (p_buf == NULL) return;
+
+    if (filename == NULL) {
+        sprintf(default_name, "abt_trace.%d.%s", (int)getpid(),
+                gp_ABTI_global->trace_binary ? "bin" : "json");
+        filename = default_name;
+    }
+    if (!strcmp(filename, "stdout")) {
+        fp = stdout;
+    } else if (!strcmp(filename, "stderr")) {
+        fp = stderr;
+    } else {
+        fp = fopen(filename, "wb");
+    }
+    if (fp != NULL) {
+        if (gp_ABTI_global->trace_binary == ABT_TRUE) {
+            ABTI_trace_print_binary(fp);
+        } else {
+            ABTI_trace_print(fp);
+        }
+        if (fp != stdout && fp != stderr) fclose(fp);
+    }
+
+    while (p_buf) {
+        ABTI_trace_buf *p_next = p_buf->p_next;
+        ABTU_free(p_buf->p_entries);
+        ABTU_free(p_buf);
+        p_buf = p_next;
+    }
+    gp_ABTI_global->p_trace_bufs = NULL;
+}
+
+static void ABTI_trace_print_event(FILE *p_os, int *p_first, int pid,
+                                   uint64_t rank, const char *ph,
+                                   ABTI_trace_entry *p_entry, double ts)
+{
+    const char *type = (p_entry->kind & ABTI_TRACE_TASK) ? "tasklet" : "ULT";
+    uint32_t kind = p_entry->kind & ~ABTI_TRACE_TASK;
+
+    fprintf(p_os, "%s\n{\"pid\":%d,\"tid\":%" PRIu64 ",\"ts\":%.3f,"
+            "\"ph\":\"%s\"", *p_first ? "" : ",", pid, rank, ts, ph);
+    *p_first = 0;
+    if (kind == ABTI_TRACE_RUN || kind == ABTI_TRACE_STOP) {
+        fprintf(p_os, ",\"name\":\"%s 0x%" PRIx64 "\"}", type, p_entry->obj);
+    } else {
+        fprintf(p_os, ",\"name\":\"%s\",\"s\":\"t\",\"args\":{\"type\":\"%s\","
+                "\"unit\":\"0x%" PRIx64 "\",\"pool\":%u}}",
+                g_trace_names[kind], type, p_entry->obj, p_entry->arg);
+    }
+}
+
+/* Print the trace of one ES.  Run and stop events are converted into
+ * durations so that the timeline shows what the ES was running.  A ULT that
+ * switches to another one directly ends its duration without a stop event. */
+static void ABTI_trace_print_buf(FILE *p_os, int *p_first, int pid,
+                                 ABTI_trace_buf *p_buf, double us_per_cycle)
+{
+    uint64_t pos = *(volatile uint64_t *)&p_buf->pos;
+    uint64_t size = p_buf->mask + 1;
+    uint64_t i = (pos > size) ? pos - size : 0;
+    uint64_t cycles0 = gp_ABTI_global->trace_cycles;
+    ABTI_trace_entry running;
+    ABT_bool is_running = ABT_FALSE;
+    double ts = 0.0;
+
+    fprintf(p_os, "%s\n{\"pid\":%d,\"tid\":%" PRIu64 ",\"ph\":\"M\","
+            "\"name\":\"thread_name\",\"args\":{\"name\":\"ES %" PRIu64 "\"}}",
+            *p_first ? "" : ",", pid, p_buf->rank, p_buf->rank);
+    *p_first = 0;
+
+    for (; i < pos; i++) {
+        ABTI_trace_entry entry = p_buf->p_entries[i & p_buf->mask];
+        uint32_t kind = entry.kind & ~ABTI_TRACE_TASK;
+        if (kind >= ABTI_TRACE_NUM_KINDS) continue;
+
+        ts = (double)(int64_t)(entry.cycles - cycles0) * us_per_cycle;
+        if (kind == ABTI_TRACE_RUN) {
+            if (is_running == ABT_TRUE) {
+                ABTI_trace_print_event(p_os, p_first, pid, p_buf->rank, "E",
+                                       &running, ts);
+            }
+            ABTI_trace_print_event(p_os, p_first, pid, p_buf->rank, "B",
+                                   &entry, ts);
+            running = entry;
+            is_running = ABT_TRUE;
+        } else if (kind == ABTI_TRACE_STOP) {
+            if (is_running == ABT_TRUE && running.obj == entry.obj) {
+                ABTI_trace_print_event(p_os, p_first, pid, p_buf->rank, "E",
+                                       &entry, ts);
+                is_running = ABT_FALSE;
+            }
+        } else {
+            ABTI_trace_print_event(p_os, p_first, pid, p_buf->rank, "i",
+                                   &entry, ts);
+        }
+    }
+    if (is_running == ABT_TRUE) {
+        ABTI_trace_print_event(p_os, p_first, pid, p_buf->rank, "E",
+                               &running, ts);
+    }
+}
+
+/* Microseconds per cycle of ABTD_time_get_cycles() */
+static double ABTI_trace_get_us_per_cycle(void)
+{
+    double elapsed = ABT_get_wtime() - gp_ABTI_global->trace_wtime;
+    uint64_t cycles = ABTD_time_get_cycles() - gp_ABTI_global->trace_cycles;
+
+    if (elapsed > 0.0 && cycles > 0) {
+        return elapsed * 1.0e6 / (double)cycles;
+    }
+    return 1.0e-3;
+}
+
+void ABTI_trace_print(FILE *p_os)
+{
+    ABTI_trace_buf *p_buf;
+    double us_per_cycle = ABTI_trace_get_us_per_cycle();
+    int pid = (int)getpid();
+    int first = 1;
+
+    fprintf(p_os, "{\"traceEvents\":[");
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    for (p_buf = gp_ABTI_global->p_trace_bufs; p_buf; p_buf = p_buf->p_next) {
+        ABTI_trace_print_buf(p_os, &first, pid, p_buf, us_per_cycle);
+    }
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+    fprintf(p_os, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    fflush(p_os);
+}
+
+/* Write the raw events.  The format, in the native byte order, is
+ *   header:  char magic[8] = "ABTTRC01", double us_per_cycle,
+ *            uint64_t start_cycles, uint32_t pid, uint32_t num_xstreams
+ *   then for each ES:
+ *            uint64_t rank, uint64_t num_entries, uint64_t num_dropped,
+ *            ABTI_trace_entry entries[num_entries] in the recorded order
+ * maint/abt-trace.pl reads this format. */
+void ABTI_trace_print_binary(FILE *p_os)
+{
+    ABTI_trace_buf *p_buf;
+    double us_per_cycle = ABTI_trace_get_us_per_cycle();
+    uint32_t pid = (uint32_t)getpid();
+    uint32_t num_bufs = 0;
+
+    ABTI_spinlock_acquire(&gp_ABTI_global->lock);
+    for (p_buf = gp_ABTI_global->p_trace_bufs; p_buf; p_buf = p_buf->p_next) {
+        num_bufs++;
+    }
+    fwrite("ABTTRC01", 1, 8, p_os);
+    fwrite(&us_per_cycle, sizeof(double), 1, p_os);
+    fwrite(&gp_ABTI_global->trace_cycles, sizeof(uint64_t), 1, p_os);
+    fwrite(&pid, sizeof(uint32_t), 1, p_os);
+    fwrite(&num_bufs, sizeof(uint32_t), 1, p_os);
+
+    for (p_buf = gp_ABTI_global->p_trace_bufs; p_buf; p_buf = p_buf->p_next) {
+        uint64_t pos = *(volatile uint64_t *)&p_buf->pos;
+        uint64_t size = p_buf->mask + 1;
+        uint64_t start = (pos > size) ? pos - size : 0;
+        uint64_t num = pos - start;
+        uint64_t first = start & p_buf->mask;
+
+        fwrite(&p_buf->rank, sizeof(uint64_t), 1, p_os);
+        fwrite(&num, sizeof(uint64_t), 1, p_os);
+        fwrite(&start, sizeof(uint64_t), 1, p_os);
+        /* The events may wrap around the end of the buffer. */
+        if (first + num > size) {
+            fwrite(&p_buf->p_entries[first], sizeof(ABTI_trace_entry),
+                   size - first, p_os);
+            fwrite(p_buf->p_entries, sizeof(ABTI_trace_entry),
+                   num - (size - first), p_os);
+        } else {
+            fwrite(&p_buf->p_entries[first], sizeof(ABTI_trace_entry), num,
+                   p_os);
+        }
+    }
+    ABTI_spinlock_release(&gp_ABTI_global->lock);
+    fflush(p_os);
+}
@@ -53,3 +53,88 @@ int ABT_unit_set_associated_pool(ABT_unit unit, ABT_pool pool)
     HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
     goto fn_exit;
 }
+
+
+/**
+ * @ingroup UNIT
+ * @brief   Make a pool definition use the units embedded in work units.
+ *
+ * \c ABT_pool_def_set_intrusive_units() sets the unit functions of \c def
+ * (\c u_get_type, \c u_get_thread, \c u_get_task, \c u_is_in_pool,
+ * \c u_create_from_thread, \c u_create_from_task and \c u_free) to those of
+ * the built-in pools.  The unit of a ULT or tasklet is then a descriptor
+ * embedded in it, which is never allocated and stays valid as long as the
+ * work unit.  The runtime creates and inspects such units without calling
+ * the pool, and tracks whether they are in the pool around \c p_push,
+ * \c p_pop and \c p_remove.
+ *
+ * A unit can be cast to \c ABT_unit_links *, whose links are free for the
+ * pool to use while the unit is in the pool, so that the pool can queue
+ * units without allocating memory.  The pool must not write to the rest of
+ * the unit.  The other fields of \c def are not changed.
+ *
+ * @param[in,out] def  pool definition
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_pool_def_set_intrusive_units(ABT_pool_def *def)
+{
+    def->u_get_type           = ABTI_unit_get_type;
+    def->u_get_thread         = ABTI_unit_get_thread;
+    def->u_get_task           = ABTI_unit_get_task;
+    def->u_is_in_pool         = ABTI_unit_is_in_pool;
+    def->u_create_from_thread = ABTI_unit_create_from_thread;
+    def->u_create_from_task   = ABTI_unit_create_from_task;
+    def->u_free               = ABTI_unit_free;
+    return ABT_SUCCESS;
+}
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* Unit functions of all built-in pools.  The unit of a work unit is the
+ * ABTI_unit embedded in it, so nothing is allocated.  A pool using all of
+ * them gets intrusive_units, with which the runtime inlines them (see
+ * abti_unit.h). */
+
+ABT_unit_type ABTI_unit_get_type(ABT_unit unit)
+{
+    return ((ABTI_unit *)unit)->type;
+}
+
+ABT_thread ABTI_unit_get_thread(ABT_unit unit)
+{
+    ABTI_unit *p_unit = (ABTI_unit *)unit;
+    return (p_unit->type == ABT_UNIT_TYPE_THREAD) ? p_unit->thread
+                                                  : ABT_THREAD_NULL;
+}
+
+ABT_task ABTI_unit_get_task(ABT_unit unit)
+{
+    ABTI_unit *p_unit = (ABTI_unit *)unit;
+    return (p_unit->type == ABT_UNIT_TYPE_TASK) ? p_unit->task
+                                                : ABT_TASK_NULL;
+}
+
+ABT_bool ABTI_unit_is_in_pool(ABT_unit unit)
+{
+    return (((ABTI_unit *)unit)->pool != ABT_POOL_NULL) ? ABT_TRUE
+                                                         : ABT_FALSE;
+}
+
+ABT_unit ABTI_unit_create_from_thread(ABT_thread thread)
+{
+    return ABTI_unit_init_thread(ABTI_thread_get_ptr(thread));
+}
+
+ABT_unit ABTI_unit_create_from_task(ABT_task task)
+{
+    return ABTI_unit_init_task(ABTI_task_get_ptr(task));
+}
+
+void ABTI_unit_free(ABT_unit *unit)
+{
+    *unit = ABT_UNIT_NULL;
+}
@@ -0,0 +1,203 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Timings of work units.  A ULT or a tasklet saves the ticks when it is
+ * pushed to a pool (see ABTI_unit_stats_push()), and the ES that pops it
+ * records how long it waited and then how long it ran in the histograms of
+ * the ES and of the pool.  The histograms of an ES are written only by that
+ * ES, while those of a pool are updated atomically since any ES can pop from
+ * it.  The histogram helpers are also used for the stack usage (see
+ * stack_usage.c). */
+
+#define ABTI_HISTOGRAM_SUB_BITS     3   /* log2(ABT_HISTOGRAM_SUB_BUCKETS) */
+
+static inline int ABTI_histogram_get_index(uint64_t value)
+{
+    int msb, index;
+
+    if (value < ABT_HISTOGRAM_SUB_BUCKETS) return (int)value;
+    msb = 63 - __builtin_clzll(value);
+    index = (msb - ABTI_HISTOGRAM_SUB_BITS + 1) * ABT_HISTOGRAM_SUB_BUCKETS
+          + (int)((value >> (msb - ABTI_HISTOGRAM_SUB_BITS))
+                  & (ABT_HISTOGRAM_SUB_BUCKETS - 1));
+    if (index >= ABT_HISTOGRAM_NUM_BUCKETS) {
+        index = ABT_HISTOGRAM_NUM_BUCKETS - 1;
+    }
+    return index;
+}
+
+void ABTI_histogram_reset(ABT_histogram *p_hist)
+{
+    memset(p_hist, 0, sizeof(ABT_histogram));
+    p_hist->min = UINT64_MAX;
+}
+
+static inline void ABTI_histogram_add(ABT_histogram *p_hist, uint64_t value)
+{
+    p_hist->buckets[ABTI_histogram_get_index(value)]++;
+    p_hist->sum += value;
+    if (value < p_hist->min) p_hist->min = value;
+    if (value > p_hist->max) p_hist->max = value;
+    /* The count is updated last so that a reader sees the sample in a bucket
+     * if it is counted. */
+    ABTD_compiler_barrier();
+    *(volatile uint64_t *)&p_hist->count = p_hist->count + 1;
+}
+
+void ABTI_histogram_add_atomic(ABT_histogram *p_hist, uint64_t value)
+{
+    uint64_t old;
+
+    ABTD_atomic_fetch_add_uint64(
+        &p_hist->buckets[ABTI_histogram_get_index(value)], 1);
+    ABTD_atomic_fetch_add_uint64(&p_hist->sum, value);
+    while ((old = *(volatile uint64_t *)&p_hist->min) > value) {
+        if (ABTD_atomic_cas_uint64(&p_hist->min, old, value) == old) break;
+    }
+    while ((old = *(volatile uint64_t *)&p_hist->max) < value) {
+        if (ABTD_atomic_cas_uint64(&p_hist->max, old, value) == old) break;
+    }
+    ABTD_atomic_fetch_add_uint64(&p_hist->count, 1);
+}
+
+void ABTI_histogram_print(ABT_histogram *p_hist, FILE *p_os,
+                          const char *prefix, const char *name,
+                          const char *unit)
+{
+    uint64_t count = p_hist->count;
+
+    fprintf(p_os, "%s%s: count %" PRIu64, prefix, name, count);
+    if (count > 0) {
+        fprintf(p_os, ", mean %" PRIu64 " %s, p50 %" PRIu64 " %s"
+                ", p99 %" PRIu64 " %s, max %" PRIu64 " %s",
+                p_hist->sum / count, unit,
+                ABT_histogram_get_percentile(p_hist, 50.0), unit,
+                ABT_histogram_get_percentile(p_hist, 99.0), unit,
+                p_hist->max, unit);
+    }
+    fprintf(p_os, "\n");
+}
+
+#ifndef ABT_CONFIG_DISABLE_UNIT_STATS
+
+static inline uint64_t ABTI_unit_stats_get_nsec(uint64_t ticks)
+{
+    return (uint64_t)(ABTD_time_ticks_to_sec(ticks) * 1.0e9);
+}
+
+ABT_unit_stats *ABTI_unit_stats_create(void)
+{
+    ABT_unit_stats *p_stats;
+
+    p_stats = (ABT_unit_stats *)ABTU_malloc(sizeof(ABT_unit_stats));
+    ABTI_unit_stats_reset(p_stats);
+    return p_stats;
+}
+
+/* Samples recorded during the reset may be partially cleared. */
+void ABTI_unit_stats_reset(ABT_unit_stats *p_stats)
+{
+    ABTI_histogram_reset(&p_stats->queue_delay);
+    ABTI_histogram_reset(&p_stats->run_time);
+}
+
+void ABTI_unit_stats_stamp(ABTI_pool *p_pool, ABT_unit unit)
+{
+    uint64_t ticks = ABTD_time_get_ticks();
+
+    if (ABTI_pool_unit_get_type(p_pool, unit) == ABT_UNIT_TYPE_TASK) {
+        ABTI_task *p_task = ABTI_pool_unit_get_task(p_pool, unit);
+        p_task->push_ticks = ticks;
+    } else {
+        ABTI_thread *p_thread = ABTI_pool_unit_get_thread(p_pool, unit);
+        p_thread->push_ticks = ticks;
+    }
+}
+
+/* A unit pushed at push_ticks has been popped from p_pool */
+void ABTI_unit_stats_add_delay(ABTI_xstream *p_xstream, ABTI_pool *p_pool,
+                               uint64_t push_ticks)
+{
+    uint64_t now = ABTD_time_get_ticks();
+    uint64_t delay;
+
+    if (push_ticks == 0 || now < push_ticks) return;
+    delay = ABTI_unit_stats_get_nsec(now - push_ticks);
+    if (p_xstream->p_unit_stats) {
+        ABTI_histogram_add(&p_xstream->p_unit_stats->queue_delay, delay);
+    }
+    if (p_pool && p_pool->p_unit_stats) {
+        ABTI_histogram_add_atomic(&p_pool->p_unit_stats->queue_delay, delay);
+    }
+}
+
+/* A unit of p_pool that started running at start_ticks has stopped */
+void ABTI_unit_stats_add_run(ABTI_xstream *p_xstream, ABTI_pool *p_pool,
+                             uint64_t start_ticks)
+{
+    uint64_t now = ABTD_time_get_ticks();
+    uint64_t run;
+
+    if (now < start_ticks) return;
+    run = ABTI_unit_stats_get_nsec(now - start_ticks);
+    if (p_xstream->p_unit_stats) {
+        ABTI_histogram_add(&p_xstream->p_unit_stats->run_time, run);
+    }
+    if (p_pool && p_pool->p_unit_stats) {
+        ABTI_histogram_add_atomic(&p_pool->p_unit_stats->run_time, run);
+    }
+}
+
+void ABTI_unit_stats_print(ABT_unit_stats *p_stats, FILE *p_os,
+                           const char *prefix)
+{
+    ABTI_histogram_print(&p_stats->queue_delay, p_os, prefix, "queue_delay",
+                         "ns");
+    ABTI_histogram_print(&p_stats->run_time, p_os, prefix, "run_time   ",
+                         "ns");
+}
+
+#endif /* ABT_CONFIG_DISABLE_UNIT_STATS */
+
+/**
+ * @ingroup INFO
+ * @brief   Get a percentile of a histogram.
+ *
+ * \c ABT_histogram_get_percentile() returns the upper bound of the bucket of
+ * \c hist that holds the sample at \c percentile, which is between 0 and 100.
+ * The value is at most \c hist->max.  It returns 0 if \c hist is empty.
+ *
+ * @param[in] hist        histogram
+ * @param[in] percentile  percentile in [0, 100]
+ * @return Value at the percentile
+ */
+uint64_t ABT_histogram_get_percentile(const ABT_histogram *hist,
+                                      double percentile)
+{
+    uint64_t target, sum = 0, upper;
+    int i, group;
+
+    if (hist->count == 0) return 0;
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+    target = (uint64_t)(percentile / 100.0 * (double)hist->count + 0.5);
+    if (target == 0) target = 1;
+
+    for (i = 0; i < ABT_HISTOGRAM_NUM_BUCKETS - 1; i++) {
+        sum += hist->buckets[i];
+        if (sum >= target) break;
+    }
+    if (i < ABT_HISTOGRAM_SUB_BUCKETS) {
+        upper = (uint64_t)i;
+    } else {
+        group = i / ABT_HISTOGRAM_SUB_BUCKETS;
+        upper = ((uint64_t)(ABT_HISTOGRAM_SUB_BUCKETS
+                            + i % ABT_HISTOGRAM_SUB_BUCKETS + 1)
+                 << (group - 1)) - 1;
+    }
+    return (upper < hist->max) ? upper : hist->max;
+}
@@ -0,0 +1,237 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+
+/** @defgroup WAIT_GROUP Wait Group
+ * A \a wait group is a counting latch.  Work units add to its count the
+ * number of operations to wait for, each operation calls
+ * \c ABT_wait_group_done() when it completes, and a single waiter is released
+ * when the count reaches zero.  Unlike \c ABT_barrier, the operations do not
+ * wait, and unlike \c ABT_future, no compartment is allocated.  A wait group
+ * is a word for the count and a pointer to the waiter, and it is updated
+ * without a lock.
+ */
+
+/**
+ * @ingroup WAIT_GROUP
+ * @brief   Create a new wait group.
+ *
+ * \c ABT_wait_group_create() creates a new wait group whose count is zero and
+ * returns its handle through \c newwg.
+ *
+ * @param[out] newwg  handle to a new wait group
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_wait_group_create(ABT_wait_group *newwg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_wait_group *p_wg;
+
+    p_wg = (ABTI_wait_group *)ABTU_malloc(sizeof(ABTI_wait_group));
+    ABTI_wait_group_init(p_wg);
+
+    *newwg = ABTI_wait_group_get_handle(p_wg);
+
+    return abt_errno;
+}
+
+/**
+ * @ingroup WAIT_GROUP
+ * @brief   Free the wait group.
+ *
+ * \c ABT_wait_group_free() releases the wait group \c wg.  The count of
+ * \c wg must be zero, and no work unit may be waiting on it.  Since
+ * \c ABT_wait_group_done() does not touch \c wg after it has released the
+ * waiter, the waiter can free \c wg right after \c ABT_wait_group_wait()
+ * returns.  If it is successfully processed, \c wg is set to
+ * \c ABT_WAIT_GROUP_NULL.
+ *
+ * @param[in,out] wg  handle to the wait group
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_WAIT_GROUP the count is not zero
+ */
+int ABT_wait_group_free(ABT_wait_group *wg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_wait_group *p_wg = ABTI_wait_group_get_ptr(*wg);
+    ABTI_CHECK_NULL_WAIT_GROUP_PTR(p_wg);
+    ABTI_CHECK_TRUE(*(volatile uint64_t *)&p_wg->state == 0,
+                    ABT_ERR_WAIT_GROUP);
+
+    ABTU_free(p_wg);
+
+    *wg = ABT_WAIT_GROUP_NULL;
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup WAIT_GROUP
+ * @brief   Add to the count of the wait group.
+ *
+ * \c ABT_wait_group_add() adds \c n to the count of the wait group \c wg.
+ * It must be called before the work units that call
+ * \c ABT_wait_group_done() for these \c n operations can do so, e.g., before
+ * they are created.
+ *
+ * @param[in] wg  handle to the wait group
+ * @param[in] n   number of operations to add
+ * @return Error code
+ * @retval ABT_SUCCESS on success
+ */
+int ABT_wait_group_add(ABT_wait_group wg, uint32_t n)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_wait_group *p_wg = ABTI_wait_group_get_ptr(wg);
+    ABTI_CHECK_NULL_WAIT_GROUP_PTR(p_wg);
+
+    ABTI_wait_group_add(p_wg, n);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup WAIT_GROUP
+ * @brief   Complete an operation of the wait group.
+ *
+ * \c ABT_wait_group_done() decrements the count of the wait group \c wg by
+ * one.  If the count reaches zero and a ULT is waiting on \c wg, the ULT is
+ * woken up.  This routine can be called by ULTs, tasklets, and external
+ * threads.
+ *
+ * @param[in] wg  handle to the wait group
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_WAIT_GROUP the count is already zero
+ */
+int ABT_wait_group_done(ABT_wait_group wg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_wait_group *p_wg = ABTI_wait_group_get_ptr(wg);
+    ABTI_CHECK_NULL_WAIT_GROUP_PTR(p_wg);
+    ABTI_CHECK_TRUE(ABTI_wait_group_get_count(p_wg) != 0, ABT_ERR_WAIT_GROUP);
+
+    /* A tasklet runs on the ULT of its scheduler, which is not the caller. */
+    if (lp_ABTI_local == NULL || ABTI_local_get_task() != NULL) {
+        ABTI_wait_group_done(p_wg, NULL);
+    } else {
+        ABTI_wait_group_done(p_wg, ABTI_local_get_thread());
+    }
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+/**
+ * @ingroup WAIT_GROUP
+ * @brief   Wait until the count of the wait group becomes zero.
+ *
+ * \c ABT_wait_group_wait() blocks the caller ULT until the count of the wait
+ * group \c wg becomes zero.  Only one ULT can wait on \c wg at a time.  An
+ * external thread waits by polling the count.  If the count is already zero,
+ * this routine returns immediately.
+ *
+ * @param[in] wg  handle to the wait group
+ * @return Error code
+ * @retval ABT_SUCCESS        on success
+ * @retval ABT_ERR_WAIT_GROUP another ULT is waiting on \c wg, or called by a
+ *                            tasklet
+ */
+int ABT_wait_group_wait(ABT_wait_group wg)
+{
+    int abt_errno = ABT_SUCCESS;
+    ABTI_wait_group *p_wg = ABTI_wait_group_get_ptr(wg);
+    ABTI_CHECK_NULL_WAIT_GROUP_PTR(p_wg);
+
+    abt_errno = ABTI_wait_group_wait(p_wg);
+    ABTI_CHECK_ERROR(abt_errno);
+
+  fn_exit:
+    return abt_errno;
+
+  fn_fail:
+    HANDLE_ERROR_FUNC_WITH_CODE(abt_errno);
+    goto fn_exit;
+}
+
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* Wait until the count of p_wg becomes zero.  The caller ULT publishes itself
+ * in p_waiter and then sets ABTI_WAIT_GROUP_WAITER together with checking the
+ * count, so either the last ABTI_wait_group_done() sees the flag or the
+ * caller sees the count of zero.  Returns ABT_ERR_WAIT_GROUP if there is
+ * another waiter or the caller is a tasklet. */
+int ABTI_wait_group_wait(ABTI_wait_group *p_wg)
+{
+    uint64_t state;
+
+    if (ABTI_wait_group_get_count(p_wg) == 0) return ABT_SUCCESS;
+
+    if (lp_ABTI_local == NULL) {
+        /* External thread */
+        while (ABTI_wait_group_get_count(p_wg) != 0) {
+            ABTD_atomic_pause();
+        }
+        return ABT_SUCCESS;
+    }
+
+    if (ABTI_local_get_task() != NULL) return ABT_ERR_WAIT_GROUP;
+    ABTI_thread *p_self = ABTI_local_get_thread();
+
+    ABTI_thread_set_blocked(p_self);
+    do {
+        state = *(volatile uint64_t *)&p_wg->state;
+        if ((state & ABTI_WAIT_GROUP_COUNT_MASK) == 0 ||
+            (state & ABTI_WAIT_GROUP_WAITER)) {
+            ABTI_thread_unset_blocked(p_self);
+            return (state & ABTI_WAIT_GROUP_WAITER) ? ABT_ERR_WAIT_GROUP
+                                                    : ABT_SUCCESS;
+        }
+        p_wg->p_waiter = p_self;
+    } while (ABTD_atomic_cas_uint64(&p_wg->state, state,
+                                    state | ABTI_WAIT_GROUP_WAITER) != state);
+
+    /* Suspend the current ULT.  The flag has been cleared by the waker. */
+    ABTI_thread_suspend(p_self);
+    return ABT_SUCCESS;
+}
+
+/* Called by the ABTI_wait_group_done() that has brought the count to zero
+ * while a ULT is waiting.  The flag is cleared before the waiter is woken up
+ * so that a later round of the wait group does not wake it up again.  p_wg is
+ * not touched after that because the woken waiter may free it.  p_thread is
+ * the caller ULT or NULL. */
+void ABTI_wait_group_wake(ABTI_wait_group *p_wg, ABTI_thread *p_thread)
+{
+    ABTI_thread *p_waiter = p_wg->p_waiter;
+    ABTD_atomic_fetch_sub_uint64(&p_wg->state, ABTI_WAIT_GROUP_WAITER);
+
+    if (p_thread) {
+        ABTD_thread_wake_joiner(p_thread, p_waiter);
+    } else {
+        ABTI_thread_set_ready(p_waiter);
+    }
+}
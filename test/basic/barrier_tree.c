@@ -0,0 +1,157 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     37
+#define DEFAULT_NUM_ROUNDS      50
+#define RADIX                   3
+
+static int g_num_threads;
+static int g_num_rounds;
+static int g_num_xstreams;
+static int *g_arrived;
+static ABT_barrier g_barrier;
+static ABT_xstream_barrier g_xstream_barrier;
+static int g_xstream_counter = 0;
+
+/* Each ULT counts its arrival for the round, and all the arrivals of the
+ * round have to be visible after the barrier. */
+static void thread_func(void *arg)
+{
+    int r, ret;
+    ABT_TEST_UNUSED(arg);
+
+    for (r = 0; r < g_num_rounds; r++) {
+        __sync_fetch_and_add(&g_arrived[r], 1);
+        ret = ABT_barrier_wait(g_barrier);
+        ABT_TEST_ERROR(ret, "ABT_barrier_wait");
+        assert(g_arrived[r] == g_num_threads);
+    }
+}
+
+/* Each ES increments the counter once per round, so the counter has to be a
+ * multiple of the number of ESs between two barriers. */
+static void xstream_func(void *arg)
+{
+    int r, ret;
+    ABT_TEST_UNUSED(arg);
+
+    for (r = 0; r < g_num_rounds; r++) {
+        __sync_fetch_and_add(&g_xstream_counter, 1);
+        ret = ABT_xstream_barrier_wait(g_xstream_barrier);
+        ABT_TEST_ERROR(ret, "ABT_xstream_barrier_wait");
+        assert(g_xstream_counter == (r + 1) * g_num_xstreams);
+        ret = ABT_xstream_barrier_wait(g_xstream_barrier);
+        ABT_TEST_ERROR(ret, "ABT_xstream_barrier_wait");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    uint32_t num_waiters;
+    int i, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+    g_num_threads = DEFAULT_NUM_THREADS;
+    g_num_rounds = DEFAULT_NUM_ROUNDS;
+    if (argc > 1) {
+        g_num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_rounds   = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(g_num_xstreams > 0 && g_num_threads > 0);
+    ABT_test_printf(1, "# of ESs   : %d\n"
+                       "# of ULTs  : %d\n"
+                       "# of rounds: %d\n",
+                       g_num_xstreams, g_num_threads, g_num_rounds);
+
+    xstreams = (ABT_xstream *)malloc(g_num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(g_num_threads * sizeof(ABT_thread));
+    g_arrived = (int *)calloc(g_num_rounds, sizeof(int));
+
+    ret = ABT_barrier_create_tree((uint32_t)g_num_threads, RADIX, &g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_create_tree");
+    ret = ABT_barrier_get_num_waiters(g_barrier, &num_waiters);
+    ABT_TEST_ERROR(ret, "ABT_barrier_get_num_waiters");
+    assert(num_waiters == (uint32_t)g_num_threads);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* ULT barrier */
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_create(pools[i % g_num_xstreams], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_barrier_free(&g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_free");
+
+    /* Join Execution Streams */
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* ES barrier.  Each ES runs one ULT that blocks the ES in the barrier. */
+    ret = ABT_xstream_barrier_create_tree((uint32_t)g_num_xstreams, 2,
+                                          &g_xstream_barrier);
+    ABT_TEST_ERROR(ret, "ABT_xstream_barrier_create_tree");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        ret = ABT_thread_create(pools[i], xstream_func, NULL,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    xstream_func(NULL);
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_xstream_barrier_free(&g_xstream_barrier);
+    ABT_TEST_ERROR(ret, "ABT_xstream_barrier_free");
+
+    /* Finalize */
+    ret = ABT_test_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(g_arrived);
+
+    return ret;
+}
@@ -0,0 +1,256 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define DEFAULT_NUM_ITER        256
+#define BATCH_SIZE              8
+
+/* A message encodes its producer and sequence number, starting from one. */
+#define MSG(p, s)   ((void *)(intptr_t)(((p) << 20) | ((s) + 1)))
+#define MSG_PRODUCER(m) ((int)((intptr_t)(m) >> 20))
+#define MSG_SEQ(m)      ((int)((intptr_t)(m) & ((1 << 20) - 1)) - 1)
+
+typedef struct {
+    int id;
+    int batch;
+} arg_t;
+
+static ABT_channel g_channel;
+static int g_num_producers;
+static int g_num_iter;
+static int g_num_received = 0;
+static int g_num_errors = 0;
+static int g_task_done = 0;
+
+static void producer_func(void *arg)
+{
+    arg_t *p_arg = (arg_t *)arg;
+    void *msgs[BATCH_SIZE];
+    int i, j, ret;
+
+    for (i = 0; i < g_num_iter; i += p_arg->batch) {
+        if (p_arg->batch == 1) {
+            ret = ABT_channel_send(g_channel, MSG(p_arg->id, i));
+            ABT_TEST_ERROR(ret, "ABT_channel_send");
+        } else {
+            for (j = 0; j < p_arg->batch; j++) {
+                msgs[j] = MSG(p_arg->id, i + j);
+            }
+            ret = ABT_channel_send_many(g_channel, p_arg->batch, msgs);
+            ABT_TEST_ERROR(ret, "ABT_channel_send_many");
+        }
+    }
+}
+
+/* Each consumer must see the messages of each producer in order. */
+static void consumer_func(void *arg)
+{
+    arg_t *p_arg = (arg_t *)arg;
+    void *msgs[BATCH_SIZE];
+    int *last_seqs, i, j, ret;
+
+    last_seqs = (int *)malloc(sizeof(int) * g_num_producers);
+    for (i = 0; i < g_num_producers; i++) last_seqs[i] = -1;
+
+    for (i = 0; i < g_num_iter; i += p_arg->batch) {
+        if (p_arg->batch == 1) {
+            ret = ABT_channel_recv(g_channel, &msgs[0]);
+            ABT_TEST_ERROR(ret, "ABT_channel_recv");
+        } else {
+            ret = ABT_channel_recv_many(g_channel, p_arg->batch, msgs);
+            ABT_TEST_ERROR(ret, "ABT_channel_recv_many");
+        }
+        for (j = 0; j < p_arg->batch; j++) {
+            int producer = MSG_PRODUCER(msgs[j]);
+            int seq = MSG_SEQ(msgs[j]);
+            if (producer >= g_num_producers || seq <= last_seqs[producer]) {
+                __sync_fetch_and_add(&g_num_errors, 1);
+            } else {
+                last_seqs[producer] = seq;
+            }
+        }
+        __sync_fetch_and_add(&g_num_received, p_arg->batch);
+    }
+    free(last_seqs);
+}
+
+static void *ext_producer_func(void *arg)
+{
+    producer_func(arg);
+    return NULL;
+}
+
+/* Producers and consumers on all the ESs and a producer on an external
+ * thread exchange messages through a channel of the given capacity. */
+static int run_exchange(ABT_pool *pools, int num_pools, size_t capacity,
+                        int num_threads, int batch)
+{
+    ABT_thread *threads;
+    arg_t *args;
+    pthread_t ext_thread;
+    size_t count;
+    int i, ret, err = 0;
+
+    g_num_producers = num_threads + 1;
+    g_num_received = 0;
+    ret = ABT_channel_create(capacity, &g_channel);
+    ABT_TEST_ERROR(ret, "ABT_channel_create");
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * 2 * num_threads);
+    args = (arg_t *)malloc(sizeof(arg_t) * (num_threads + 1));
+    for (i = 0; i <= num_threads; i++) {
+        args[i].id = i;
+        args[i].batch = batch;
+    }
+    ret = pthread_create(&ext_thread, NULL, ext_producer_func,
+                         &args[num_threads]);
+    assert(ret == 0);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_pools], producer_func, &args[i],
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    /* One more consumer is needed for the external producer. */
+    for (i = 0; i <= num_threads; i++) {
+        if (i < num_threads) {
+            ret = ABT_thread_create(pools[(i + 1) % num_pools], consumer_func,
+                                    &args[i], ABT_THREAD_ATTR_NULL,
+                                    &threads[num_threads + i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        } else {
+            consumer_func(&args[i]);
+        }
+    }
+    for (i = 0; i < 2 * num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = pthread_join(ext_thread, NULL);
+    assert(ret == 0);
+
+    if (g_num_received != (num_threads + 1) * g_num_iter) {
+        fprintf(stderr, "%d messages received (expected %d)\n",
+                g_num_received, (num_threads + 1) * g_num_iter);
+        err++;
+    }
+    ret = ABT_channel_get_count(g_channel, &count);
+    ABT_TEST_ERROR(ret, "ABT_channel_get_count");
+    if (count != 0) {
+        fprintf(stderr, "%zu messages are left\n", count);
+        err++;
+    }
+    ret = ABT_channel_free(&g_channel);
+    ABT_TEST_ERROR(ret, "ABT_channel_free");
+    free(threads);
+    free(args);
+    return err;
+}
+
+/* A tasklet cannot wait, so it sends or receives all or nothing. */
+static void task_func(void *arg)
+{
+    void *msgs[3];
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_channel_send(g_channel, MSG(0, 2));
+    if (ret != ABT_ERR_CHANNEL) {
+        fprintf(stderr, "ABT_channel_send to a full channel returned %d\n",
+                ret);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    ret = ABT_channel_recv_many(g_channel, 3, msgs);
+    if (ret != ABT_ERR_CHANNEL) {
+        fprintf(stderr, "ABT_channel_recv_many of too many returned %d\n",
+                ret);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    ret = ABT_channel_recv_many(g_channel, 2, msgs);
+    ABT_TEST_ERROR(ret, "ABT_channel_recv_many");
+    if (msgs[0] != MSG(0, 0) || msgs[1] != MSG(0, 1)) {
+        fprintf(stderr, "the tasklet received wrong messages\n");
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    __sync_fetch_and_add(&g_task_done, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    void *msgs[2];
+    int i, ret, err = 0;
+
+    ABT_test_init(argc, argv);
+    g_num_iter = DEFAULT_NUM_ITER;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+        g_num_iter = (g_num_iter + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Unbuffered, single-slot, and larger channels, with single and batched
+     * messages */
+    err += run_exchange(pools, 1, 0, num_threads, 1);
+    err += run_exchange(pools, num_xstreams, 0, num_threads, 1);
+    err += run_exchange(pools, num_xstreams, 1, num_threads, 1);
+    err += run_exchange(pools, num_xstreams, 16, num_threads, 1);
+    err += run_exchange(pools, num_xstreams, 0, num_threads, BATCH_SIZE);
+    err += run_exchange(pools, num_xstreams, 3, num_threads, BATCH_SIZE);
+    err += run_exchange(pools, num_xstreams, 64, num_threads, BATCH_SIZE);
+
+    ret = ABT_channel_create(2, &g_channel);
+    ABT_TEST_ERROR(ret, "ABT_channel_create");
+    msgs[0] = MSG(0, 0);
+    msgs[1] = MSG(0, 1);
+    ret = ABT_channel_send_many(g_channel, 2, msgs);
+    ABT_TEST_ERROR(ret, "ABT_channel_send_many");
+    ret = ABT_task_create(pools[num_xstreams - 1], task_func, NULL, NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    while (*(volatile int *)&g_task_done == 0) {
+        ABT_thread_yield();
+    }
+    ret = ABT_channel_free(&g_channel);
+    ABT_TEST_ERROR(ret, "ABT_channel_free");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+
+    if (g_num_errors > 0) {
+        fprintf(stderr, "%d messages out of order\n", g_num_errors);
+        err += g_num_errors;
+    }
+    return ABT_test_finalize(err);
+}
@@ -0,0 +1,169 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <assert.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+#define DELAY_USEC              100
+
+/* An event completed by a "device" thread, like a GPU event */
+typedef struct {
+    volatile int done;
+} event_t;
+
+static event_t *g_events;
+static int g_num_events;
+static int g_num_errors = 0;
+static int g_num_polls = 0;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+static void poll_events(void *arg, int num_events, void **events,
+                        ABT_bool *completed)
+{
+    int i;
+    check(arg == &g_num_polls, "wrong argument");
+    /* The calls are serialized. */
+    g_num_polls++;
+    for (i = 0; i < num_events; i++) {
+        if (((event_t *)events[i])->done) completed[i] = ABT_TRUE;
+    }
+}
+
+static void *device_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < g_num_events; i++) {
+        usleep(DELAY_USEC);
+        g_events[i].done = 1;
+    }
+    return NULL;
+}
+
+typedef struct {
+    ABT_completion_source source;
+    event_t *p_event;
+} arg_t;
+
+static void wait_func(void *arg)
+{
+    arg_t *p_arg = (arg_t *)arg;
+    int ret = ABT_completion_source_wait(p_arg->source, p_arg->p_event);
+    ABT_TEST_ERROR(ret, "ABT_completion_source_wait");
+    check(p_arg->p_event->done, "returned before the completion");
+}
+
+static void *ext_thread_func(void *arg)
+{
+    wait_func(arg);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_task task;
+    ABT_completion_source source;
+    pthread_t device, ext_thread;
+    arg_t *args;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_completion_source_create(poll_events, &g_num_polls, &source);
+    ABT_TEST_ERROR(ret, "ABT_completion_source_create");
+
+    /* ULTs, a tasklet, and an external thread wait for one event each. */
+    g_num_events = num_threads + 2;
+    g_events = (event_t *)calloc(g_num_events, sizeof(event_t));
+    args = (arg_t *)malloc(sizeof(arg_t) * g_num_events);
+    for (i = 0; i < g_num_events; i++) {
+        args[i].source = source;
+        args[i].p_event = &g_events[i];
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], wait_func, &args[i],
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_task_create(pools[num_xstreams - 1], wait_func,
+                          &args[num_threads], &task);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    ret = pthread_create(&ext_thread, NULL, ext_thread_func,
+                         &args[num_threads + 1]);
+    assert(ret == 0);
+    ret = pthread_create(&device, NULL, device_func, NULL);
+    assert(ret == 0);
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_task_free(&task);
+    ABT_TEST_ERROR(ret, "ABT_task_free");
+    ret = pthread_join(ext_thread, NULL);
+    assert(ret == 0);
+    ret = pthread_join(device, NULL);
+    assert(ret == 0);
+
+    /* An event that has completed already */
+    ret = ABT_completion_source_wait(source, &g_events[0]);
+    ABT_TEST_ERROR(ret, "ABT_completion_source_wait");
+
+    ret = ABT_completion_source_free(&source);
+    ABT_TEST_ERROR(ret, "ABT_completion_source_free");
+    check(source == ABT_COMPLETION_SOURCE_NULL, "source is not NULL");
+    check(g_num_polls > 0, "the events are not polled");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(args);
+    free(g_events);
+
+    return ABT_test_finalize(g_num_errors);
+}
@@ -0,0 +1,151 @@
+/* -*- Mode: C++; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "abt.hpp"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_COROUTINES  10000
+#define FIB_N                   15
+
+static int g_num_errors = 0;
+static int g_num_resumed = 0;
+
+static void check(bool cond, const char *msg)
+{
+    if (!cond) {
+        std::fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+static bool on_tasklet()
+{
+    ABT_unit_type type;
+    ABT_self_get_type(&type);
+    return type == ABT_UNIT_TYPE_TASK;
+}
+
+static int self_rank()
+{
+    int rank;
+    ABT_xstream_self_rank(&rank);
+    return rank;
+}
+
+static abt::coroutine<int> fib(int n)
+{
+    if (n < 2) co_return n;
+    int a = co_await fib(n - 1);
+    co_await abt::yield();
+    int b = co_await fib(n - 2);
+    co_return a + b;
+}
+
+static abt::coroutine<> throw_error()
+{
+    co_await abt::yield();
+    throw std::runtime_error("error");
+}
+
+/* Every suspension point resumes the coroutine in a tasklet. */
+static abt::coroutine<std::string> run_steps(std::vector<ABT_pool> &pools,
+                                             abt::eventual<int> &start)
+{
+    int value = co_await start;
+    check(on_tasklet(), "not resumed by a tasklet");
+    for (size_t i = 0; i < pools.size(); i++) {
+        co_await abt::schedule_on(pools[i]);
+        check(on_tasklet(), "not resumed by a tasklet");
+        check(self_rank() == (int)i, "resumed in a wrong pool");
+    }
+    co_await abt::yield();
+    check(on_tasklet(), "not resumed by a tasklet");
+
+    bool caught = false;
+    try {
+        co_await throw_error();
+    } catch (const std::runtime_error &) {
+        caught = true;
+    }
+    check(caught, "the exception is not rethrown");
+    co_return std::to_string(value + co_await fib(FIB_N));
+}
+
+/* Many coroutines wait for a single eventual without a ULT each. */
+static abt::coroutine<> wait_start(abt::eventual<int> &start,
+                                   abt::future<int, int> &f)
+{
+    int value = co_await start;
+    check(value == 7, "wrong eventual value");
+    __sync_fetch_and_add(&g_num_resumed, 1);
+    std::tuple<int, int> &values = co_await f;
+    check(std::get<0>(values) + std::get<1>(values) == 3,
+          "wrong future values");
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_coroutines = DEFAULT_NUM_COROUTINES;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_coroutines = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    std::vector<ABT_xstream> xstreams(num_xstreams);
+    std::vector<ABT_pool> pools(num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    {
+        abt::eventual<int> start;
+        abt::eventual<std::string> result =
+            abt::co_spawn(pools[num_xstreams - 1], run_steps(pools, start));
+        start.set(1);
+        check(result.wait() == "611", "wrong coroutine result");
+    }
+
+    {
+        abt::eventual<int> start;
+        abt::future<int, int> f;
+        std::vector<abt::eventual<>> done;
+        for (i = 0; i < num_coroutines; i++) {
+            done.push_back(
+                abt::co_spawn(pools[i % num_xstreams], wait_start(start, f)));
+        }
+        start.set(7);
+        abt::thread t = abt::thread::create(pools[0], [&f]() {
+            f.set<0>(1);
+            f.set<1>(2);
+        });
+        for (i = 0; i < num_coroutines; i++) done[i].wait();
+        check(g_num_resumed == num_coroutines, "wrong number of coroutines");
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    return ABT_test_finalize(g_num_errors);
+}
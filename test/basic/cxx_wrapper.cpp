@@ -0,0 +1,172 @@
+/* -*- Mode: C++; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "abt.hpp"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+
+static int g_num_errors = 0;
+
+static void check(bool cond, const char *msg)
+{
+    if (!cond) {
+        std::fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+/* Callable that counts its copies, moves, and destructions */
+struct counted {
+    static int num_copies, num_moves, num_alive, num_calls;
+    int value;
+
+    explicit counted(int v) : value(v) { __sync_fetch_and_add(&num_alive, 1); }
+    counted(const counted &other) : value(other.value) {
+        __sync_fetch_and_add(&num_copies, 1);
+        __sync_fetch_and_add(&num_alive, 1);
+    }
+    counted(counted &&other) : value(other.value) {
+        __sync_fetch_and_add(&num_moves, 1);
+        __sync_fetch_and_add(&num_alive, 1);
+    }
+    ~counted() { __sync_fetch_and_sub(&num_alive, 1); }
+    void operator()() { __sync_fetch_and_add(&num_calls, value); }
+};
+int counted::num_copies = 0;
+int counted::num_moves = 0;
+int counted::num_alive = 0;
+int counted::num_calls = 0;
+
+/* Move-only callable */
+struct add_value {
+    std::unique_ptr<int> p_value;
+    abt::eventual<std::string> *p_ev;
+    int *p_sum;
+    abt::mutex *p_mutex;
+
+    void operator()() {
+        p_mutex->lock();
+        *p_sum += *p_value;
+        p_mutex->unlock();
+        p_ev->set(std::to_string(*p_value));
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    std::vector<ABT_xstream> xstreams(num_xstreams);
+    std::vector<ABT_pool> pools(num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    {
+        /* An rvalue is moved once into the ULT and an lvalue is copied once.
+         * The destructors of the ULTs join them. */
+        std::vector<abt::thread> threads;
+        counted c(2);
+        for (i = 0; i < num_threads; i++) {
+            threads.push_back(abt::thread::create(pools[i % num_xstreams],
+                                                  counted(1)));
+        }
+        threads.push_back(abt::thread::create(pools[0], c));
+        abt::thread moved = std::move(threads.back());
+        threads.pop_back();
+        check(moved.joinable(), "the moved thread is not joinable");
+        moved.join();
+    }
+    check(counted::num_calls == num_threads + 2, "wrong number of calls");
+    check(counted::num_moves == num_threads, "wrong number of moves");
+    check(counted::num_copies == 1, "wrong number of copies");
+    check(counted::num_alive == 0, "callables are not destroyed");
+
+    {
+        /* Move-only callables and typed eventuals */
+        std::vector<abt::eventual<std::string>> evs(num_threads);
+        abt::eventual<void> done;
+        int sum = 0;
+        abt::mutex mutex;
+        for (i = 0; i < num_threads; i++) {
+            add_value f = { std::unique_ptr<int>(new int(i)), &evs[i], &sum,
+                            &mutex };
+            abt::thread::spawn(pools[i % num_xstreams], std::move(f));
+        }
+        for (i = 0; i < num_threads; i++) {
+            check(evs[i].wait() == std::to_string(i), "wrong eventual value");
+        }
+        check(sum == num_threads * (num_threads - 1) / 2, "wrong sum");
+
+        abt::thread::spawn(pools[num_xstreams - 1], [&done]() {
+            abt::thread::yield();
+            done.set();
+        });
+        done.wait();
+    }
+
+    {
+        /* Each compartment of a future is set by a different ULT. */
+        abt::future<int, std::string> f;
+        abt::thread t0 = abt::thread::create(pools[0], [&f]() {
+            f.set<0>(42);
+        });
+        abt::thread t1 = abt::thread::create(pools[num_xstreams - 1], [&f]() {
+            f.set<1>(std::string("argobots"));
+        });
+        std::tuple<int, std::string> &values = f.wait();
+        check(std::get<0>(values) == 42, "wrong future value 0");
+        check(std::get<1>(values) == "argobots", "wrong future value 1");
+    }
+
+    {
+        /* Errors are thrown. */
+        ABT_thread_attr attr;
+        bool thrown = false;
+        ABT_thread_attr_create(&attr);
+        /* Deferred stacks need the stack pool and fcontext. */
+        if (ABT_thread_attr_set_deferred_stack(attr, ABT_TRUE) == ABT_SUCCESS) {
+            try {
+                abt::thread t = abt::thread::create(pools[0], counted(1),
+                                                    attr);
+            } catch (const abt::error &e) {
+                thrown = (e.code() == ABT_ERR_INV_THREAD_ATTR);
+            }
+            check(thrown, "no error is thrown");
+        }
+        ABT_thread_attr_free(&attr);
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    return ABT_test_finalize(g_num_errors);
+}
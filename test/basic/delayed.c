@@ -0,0 +1,195 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* Delayed and periodic tasklets and ULTs: delays, cancellation, coalescing of
+ * runs that are due while the previous run is busy, and a periodic work unit
+ * that outlives the ES holding it. */
+
+static int g_num_errors = 0;
+static double g_start;
+
+typedef struct {
+    int count;
+    int running;
+    double delay;
+} counter_t;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_SEQ_CST);
+        fprintf(stderr, "Error: %s\n", msg);
+    }
+}
+
+static void count_func(void *arg)
+{
+    counter_t *p_counter = (counter_t *)arg;
+    if (p_counter->delay > 0.0) {
+        check(ABT_get_wtime() - g_start >= p_counter->delay * 0.99,
+              "run before the delay");
+    }
+    __atomic_fetch_add(&p_counter->count, 1, __ATOMIC_SEQ_CST);
+}
+
+static void busy_func(void *arg)
+{
+    counter_t *p_counter = (counter_t *)arg;
+    check(__atomic_fetch_add(&p_counter->running, 1, __ATOMIC_SEQ_CST) == 0,
+          "runs overlap");
+    ABT_thread_sleep(0.01);
+    __atomic_fetch_sub(&p_counter->running, 1, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&p_counter->count, 1, __ATOMIC_SEQ_CST);
+}
+
+static int get_count(counter_t *p_counter)
+{
+    return __atomic_load_n(&p_counter->count, __ATOMIC_SEQ_CST);
+}
+
+static void wait_count(counter_t *p_counter, int count)
+{
+    double start = ABT_get_wtime();
+    while (get_count(p_counter) < count && ABT_get_wtime() - start < 10.0) {
+        ABT_thread_sleep(0.001);
+    }
+}
+
+static void create_periodic(void *arg)
+{
+    void **args = (void **)arg;
+    int ret = ABT_task_create_periodic(*(ABT_pool *)args[0], count_func,
+                                       args[1], 0.0, 0.002,
+                                       (ABT_delayed *)args[2]);
+    ABT_TEST_ERROR(ret, "ABT_task_create_periodic");
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream, xstream2;
+    ABT_pool pool, pool2;
+    ABT_delayed delayed;
+    counter_t counter;
+    uint64_t num_runs, num_coalesced;
+    int count, ret;
+
+    ABT_test_init(argc, argv);
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* One-shot tasklet without a handle */
+    counter.count = 0;
+    counter.delay = 0.02;
+    g_start = ABT_get_wtime();
+    ret = ABT_task_create_delayed(pool, count_func, &counter, counter.delay,
+                                  NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create_delayed");
+    wait_count(&counter, 1);
+    check(get_count(&counter) == 1, "delayed tasklet");
+
+    /* One-shot ULT */
+    counter.count = 0;
+    g_start = ABT_get_wtime();
+    ret = ABT_thread_create_delayed(pool, count_func, &counter,
+                                    ABT_THREAD_ATTR_NULL, counter.delay,
+                                    &delayed);
+    ABT_TEST_ERROR(ret, "ABT_thread_create_delayed");
+    wait_count(&counter, 1);
+    ret = ABT_delayed_get_num_runs(delayed, &num_runs);
+    ABT_TEST_ERROR(ret, "ABT_delayed_get_num_runs");
+    check(get_count(&counter) == 1 && num_runs == 1, "delayed ULT");
+    ret = ABT_delayed_free(&delayed);
+    ABT_TEST_ERROR(ret, "ABT_delayed_free");
+
+    /* Canceled before its time */
+    counter.count = 0;
+    counter.delay = 0.0;
+    ret = ABT_task_create_delayed(pool, count_func, &counter, 0.01, &delayed);
+    ABT_TEST_ERROR(ret, "ABT_task_create_delayed");
+    ret = ABT_delayed_free(&delayed);
+    ABT_TEST_ERROR(ret, "ABT_delayed_free");
+    ABT_thread_sleep(0.03);
+    check(get_count(&counter) == 0, "canceled delayed tasklet");
+
+    /* Periodic tasklet */
+    ret = ABT_task_create_periodic(pool, count_func, &counter, 0.0, 0.002,
+                                   &delayed);
+    ABT_TEST_ERROR(ret, "ABT_task_create_periodic");
+    wait_count(&counter, 5);
+    ret = ABT_delayed_cancel(delayed);
+    ABT_TEST_ERROR(ret, "ABT_delayed_cancel");
+    /* The tasklets pushed before the cancellation still run. */
+    ret = ABT_delayed_get_num_runs(delayed, &num_runs);
+    ABT_TEST_ERROR(ret, "ABT_delayed_get_num_runs");
+    wait_count(&counter, (int)num_runs);
+    count = get_count(&counter);
+    ABT_thread_sleep(0.01);
+    check(count >= 5 && count == (int)num_runs &&
+          get_count(&counter) == count, "periodic tasklet");
+    ret = ABT_delayed_free(&delayed);
+    ABT_TEST_ERROR(ret, "ABT_delayed_free");
+
+    /* Runs of a periodic ULT that is slower than its period are coalesced. */
+    counter.count = 0;
+    counter.running = 0;
+    ret = ABT_thread_create_periodic(pool, busy_func, &counter,
+                                     ABT_THREAD_ATTR_NULL, 0.0, 0.001,
+                                     &delayed);
+    ABT_TEST_ERROR(ret, "ABT_thread_create_periodic");
+    wait_count(&counter, 3);
+    ret = ABT_delayed_get_num_coalesced(delayed, &num_coalesced);
+    ABT_TEST_ERROR(ret, "ABT_delayed_get_num_coalesced");
+    check(num_coalesced > 0, "coalesced runs");
+    ret = ABT_delayed_free(&delayed);
+    ABT_TEST_ERROR(ret, "ABT_delayed_free");
+    while (__atomic_load_n(&counter.running, __ATOMIC_SEQ_CST)) {
+        ABT_thread_sleep(0.001);
+    }
+
+    /* A periodic tasklet held by an ES that is freed moves to this ES. */
+    {
+        ABT_thread thread;
+        void *args[3];
+
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstream2);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+        ret = ABT_xstream_get_main_pools(xstream2, 1, &pool2);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        counter.count = 0;
+        args[0] = &pool;
+        args[1] = &counter;
+        args[2] = &delayed;
+        ret = ABT_thread_create(pool2, create_periodic, args,
+                                ABT_THREAD_ATTR_NULL, &thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_free(&thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+        ret = ABT_xstream_join(xstream2);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstream2);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        count = get_count(&counter);
+        wait_count(&counter, count + 3);
+        check(get_count(&counter) >= count + 3, "moved periodic tasklet");
+        ret = ABT_delayed_free(&delayed);
+        ABT_TEST_ERROR(ret, "ABT_delayed_free");
+    }
+
+    /* A negative period is invalid. */
+    ret = ABT_task_create_periodic(pool, count_func, &counter, 0.0, -1.0,
+                                   &delayed);
+    check(ret == ABT_ERR_INV_DELAYED && delayed == ABT_DELAYED_NULL,
+          "negative period");
+
+    ret = ABT_test_finalize(g_num_errors != 0);
+    return ret;
+}
@@ -0,0 +1,149 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define NUM_CALLBACKS           16
+
+/* ULTs on several ESs add and delete event callbacks concurrently while the
+ * schedulers check events.  The IDs of the callbacks that are registered at
+ * the same time have to be distinct, and the IDs of deleted callbacks have to
+ * be reused.  Argobots configured without --enable-power-event does not
+ * return IDs, so nothing is checked then. */
+
+static int g_num_errors = 0;
+static int g_supported = 1;
+static int *g_owners;       /* Owner ULT of each ID + 1, or 0 */
+static int g_max_ids;
+
+static ABT_bool ask_cb(void *user_arg, void *abt_arg)
+{
+    ABT_TEST_UNUSED(user_arg);
+    ABT_TEST_UNUSED(abt_arg);
+    return ABT_FALSE;
+}
+
+static ABT_bool act_cb(void *user_arg, void *abt_arg)
+{
+    ABT_TEST_UNUSED(user_arg);
+    ABT_TEST_UNUSED(abt_arg);
+    return ABT_FALSE;
+}
+
+static void thread_func(void *arg)
+{
+    int rank = (int)(intptr_t)arg;
+    ABT_event_kind event = (rank % 2) ? ABT_EVENT_STOP_XSTREAM
+                                      : ABT_EVENT_ADD_XSTREAM;
+    int ids[NUM_CALLBACKS];
+    int i, ret, free_slot;
+
+    for (i = 0; i < NUM_CALLBACKS; i++) {
+        ids[i] = -1;
+        ret = ABT_event_add_callback(event, ask_cb, NULL, act_cb, NULL,
+                                     &ids[i]);
+        ABT_TEST_ERROR(ret, "ABT_event_add_callback");
+        if (ids[i] == -1) {
+            g_supported = 0;
+            return;
+        }
+        free_slot = 0;
+        if (ids[i] < 0 || ids[i] >= g_max_ids ||
+            !__atomic_compare_exchange_n(&g_owners[ids[i] * 2 + rank % 2],
+                                         &free_slot, rank + 1, 0,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            fprintf(stderr, "ULT %d: ID %d is in use\n", rank, ids[i]);
+            __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_RELAXED);
+            ids[i] = -1;
+        }
+        ABT_thread_yield();
+    }
+    for (i = 0; i < NUM_CALLBACKS; i++) {
+        if (ids[i] < 0) continue;
+        __atomic_store_n(&g_owners[ids[i] * 2 + rank % 2], 0,
+                         __ATOMIC_RELAXED);
+        ret = ABT_event_del_callback(event, ids[i]);
+        ABT_TEST_ERROR(ret, "ABT_event_del_callback");
+        ABT_thread_yield();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    ABT_pool *pools;
+    int i, ret, id = -1;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && num_threads > 0);
+
+    g_max_ids = num_threads * NUM_CALLBACKS;
+    g_owners = (int *)calloc(g_max_ids * 2, sizeof(int));
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* All the callbacks have been deleted, so the first ID is reused. */
+    if (g_supported) {
+        ret = ABT_event_add_callback(ABT_EVENT_STOP_XSTREAM, ask_cb, NULL,
+                                     act_cb, NULL, &id);
+        ABT_TEST_ERROR(ret, "ABT_event_add_callback");
+        if (id != 0) {
+            fprintf(stderr, "ID %d is given, expected 0\n", id);
+            g_num_errors++;
+        }
+        ret = ABT_event_del_callback(ABT_EVENT_STOP_XSTREAM, id);
+        ABT_TEST_ERROR(ret, "ABT_event_del_callback");
+    } else {
+        ABT_test_printf(1, "event callbacks are not supported\n");
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(threads);
+    free(pools);
+    free(xstreams);
+    free(g_owners);
+
+    return ABT_test_finalize(g_num_errors);
+}
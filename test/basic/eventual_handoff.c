@@ -0,0 +1,95 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_ITER    1000
+
+/* Two ULTs on the same ES play ping-pong with eventuals.  With the handoff
+ * policy, ABT_eventual_set() switches to the woken ULT at once, so the peer
+ * has already replied when the setter resumes. */
+
+static ABT_eventual g_ping, g_pong;
+static int g_iter = DEFAULT_NUM_ITER;
+static volatile int g_step = 0;
+static int g_num_late = 0;
+
+static void ping_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_iter; i++) {
+        int step = g_step;
+        ABT_eventual_set(g_ping, NULL, 0);
+        if (g_step == step) g_num_late++;
+        ABT_eventual_wait(g_pong, NULL);
+        ABT_eventual_reset(g_pong);
+    }
+}
+
+static void pong_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_iter; i++) {
+        ABT_eventual_wait(g_ping, NULL);
+        ABT_eventual_reset(g_ping);
+        g_step++;
+        ABT_eventual_set(g_pong, NULL, 0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread threads[2];
+    int ret;
+
+    setenv("ABT_HANDOFF", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        g_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    ret = ABT_eventual_create(0, &g_ping);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_eventual_create(0, &g_pong);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+
+    /* pong has to wait first. */
+    ret = ABT_thread_create(pool, pong_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[1]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ABT_thread_yield();
+    ret = ABT_thread_create(pool, ping_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+
+    ret = ABT_thread_free(&threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ret = ABT_thread_free(&threads[1]);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ABT_test_printf(1, "late replies: %d / %d\n", g_num_late, g_iter);
+    assert(g_step == g_iter);
+    assert(g_num_late == 0);
+
+    ret = ABT_eventual_free(&g_ping);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+    ret = ABT_eventual_free(&g_pong);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+
+    return ABT_test_finalize(0);
+}
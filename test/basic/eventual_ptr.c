@@ -0,0 +1,139 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define NUM_ROUNDS              10
+#define BUF_SIZE                (64 * 1024)
+
+/* Waiters on all ESs must receive the very pointer that is given to
+ * ABT_eventual_set() on an eventual created by ABT_eventual_create_ptr(). */
+
+static ABT_eventual g_eventual;
+static ABT_barrier g_barrier;
+static char *g_bufs[NUM_ROUNDS];
+static int g_num_errors = 0;
+
+static void waiter_func(void *arg)
+{
+    int i, ret;
+    void *value;
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        ret = ABT_eventual_wait(g_eventual, &value);
+        ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+        if (value != g_bufs[i] || ((char *)value)[BUF_SIZE - 1] != (char)i) {
+            __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_SEQ_CST);
+        }
+        /* All waiters are done before the eventual is reset. */
+        ret = ABT_barrier_wait(g_barrier);
+        ABT_TEST_ERROR(ret, "ABT_barrier_wait");
+        ret = ABT_barrier_wait(g_barrier);
+        ABT_TEST_ERROR(ret, "ABT_barrier_wait");
+    }
+}
+
+static void setter_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        ABT_thread_yield();
+        g_bufs[i][BUF_SIZE - 1] = (char)i;
+        ret = ABT_eventual_set(g_eventual, g_bufs[i], BUF_SIZE);
+        ABT_TEST_ERROR(ret, "ABT_eventual_set");
+        ret = ABT_barrier_wait(g_barrier);
+        ABT_TEST_ERROR(ret, "ABT_barrier_wait");
+        ret = ABT_eventual_reset(g_eventual);
+        ABT_TEST_ERROR(ret, "ABT_eventual_reset");
+        ret = ABT_barrier_wait(g_barrier);
+        ABT_TEST_ERROR(ret, "ABT_barrier_wait");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    void *value;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * (num_threads + 1));
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        g_bufs[i] = (char *)malloc(BUF_SIZE);
+    }
+
+    ret = ABT_eventual_create_ptr(&g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create_ptr");
+    ret = ABT_barrier_create(num_threads + 1, &g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_create");
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], waiter_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_create(pools[0], setter_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[num_threads]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+
+    for (i = 0; i < num_threads + 1; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* A ready eventual returns the pointer without blocking. */
+    ret = ABT_eventual_set(g_eventual, g_bufs[0], 0);
+    ABT_TEST_ERROR(ret, "ABT_eventual_set");
+    ret = ABT_eventual_wait(g_eventual, &value);
+    ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+    if (value != g_bufs[0]) g_num_errors++;
+
+    ABT_test_printf(1, "%d errors\n", g_num_errors);
+    ret = ABT_barrier_free(&g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_free");
+    /* The buffers are not freed by the eventual. */
+    ret = ABT_eventual_free(&g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+    ret = ABT_test_finalize(g_num_errors != 0);
+
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        free(g_bufs[i]);
+    }
+    free(threads);
+    free(pools);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,126 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_CONTS       100
+
+static int g_counter = 0;
+
+static void cont_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void set_func(void *arg)
+{
+    ABT_future future = (ABT_future)arg;
+    int ret = ABT_future_set(future, NULL);
+    ABT_TEST_ERROR(ret, "ABT_future_set");
+}
+
+/* Continuations registered before and after an eventual or a future becomes
+ * ready have to be invoked exactly once, either inline or as tasklets. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_conts = DEFAULT_NUM_CONTS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_eventual eventual;
+    ABT_future future;
+    int i, expected, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_conts    = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs          : %d\n"
+                       "# of continuations: %d\n",
+                       num_xstreams, num_conts);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Eventual: inline and pushed continuations before it is set */
+    ret = ABT_eventual_create(0, &eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+    for (i = 0; i < num_conts; i++) {
+        ABT_pool pool = (i % 2) ? pools[i % num_xstreams] : ABT_POOL_NULL;
+        ret = ABT_eventual_then(eventual, cont_func, NULL, pool);
+        ABT_TEST_ERROR(ret, "ABT_eventual_then");
+    }
+    assert(g_counter == 0);
+    ret = ABT_eventual_set(eventual, NULL, 0);
+    ABT_TEST_ERROR(ret, "ABT_eventual_set");
+
+    /* A continuation registered after the eventual is ready runs inline. */
+    ret = ABT_eventual_then(eventual, cont_func, NULL, ABT_POOL_NULL);
+    ABT_TEST_ERROR(ret, "ABT_eventual_then");
+    ret = ABT_eventual_free(&eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+
+    /* Future: the last tasklet that sets a compartment fires continuations */
+    ret = ABT_future_create(num_conts, NULL, &future);
+    ABT_TEST_ERROR(ret, "ABT_future_create");
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_future_then(future, cont_func, NULL, pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_future_then");
+    }
+    ret = ABT_future_then(future, cont_func, NULL, ABT_POOL_NULL);
+    ABT_TEST_ERROR(ret, "ABT_future_then");
+    for (i = 0; i < num_conts; i++) {
+        ret = ABT_task_create(pools[i % num_xstreams], set_func,
+                              (void *)future, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    ret = ABT_future_wait(future);
+    ABT_TEST_ERROR(ret, "ABT_future_wait");
+
+    /* Drain the pushed continuations */
+    expected = num_conts + 1 + num_xstreams + 1;
+    while (__sync_fetch_and_add(&g_counter, 0) != expected) {
+        ABT_thread_yield();
+    }
+    ret = ABT_future_free(&future);
+    ABT_TEST_ERROR(ret, "ABT_future_free");
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != expected);
+
+    free(xstreams);
+    free(pools);
+
+    return ret;
+}
@@ -0,0 +1,113 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     200
+#define DEFAULT_NUM_ROUNDS      20
+
+static ABT_eventual g_eventual;
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    int *p_value;
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_eventual_wait(g_eventual, (void **)&p_value);
+    ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+    __sync_fetch_and_add(&g_counter, *p_value);
+}
+
+/* Many ULTs in different pools wait on an eventual that is set and reset in
+ * several rounds.  Some of them reach the eventual after it has been set. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_rounds = DEFAULT_NUM_ROUNDS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int i, r, value = 1, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_rounds   = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs   : %d\n"
+                       "# of ULTs  : %d\n"
+                       "# of rounds: %d\n",
+                       num_xstreams, num_threads, num_rounds);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_eventual_create(sizeof(int), &g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+
+    for (r = 0; r < num_rounds; r++) {
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                    NULL, ABT_THREAD_ATTR_NULL, &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+            if (i == num_threads / 2) ABT_thread_yield();
+        }
+
+        ret = ABT_eventual_set(g_eventual, &value, sizeof(int));
+        ABT_TEST_ERROR(ret, "ABT_eventual_set");
+
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+
+        ret = ABT_eventual_reset(g_eventual);
+        ABT_TEST_ERROR(ret, "ABT_eventual_reset");
+    }
+
+    ret = ABT_eventual_free(&g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != num_threads * num_rounds);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
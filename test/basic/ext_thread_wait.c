@@ -0,0 +1,144 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DELAY_SEC   0.05
+
+/* A pthread waits on an eventual, a future, and a condition variable that
+ * ULTs set one after another, and then joins a ULT.  The waits have to block
+ * instead of spinning, so the pthread uses much less CPU time than the time it
+ * waits. */
+
+static ABT_eventual g_eventual;
+static ABT_future g_future;
+static ABT_mutex g_mutex;
+static ABT_cond g_cond;
+static int g_flag = 0;
+static ABT_thread g_sleeper;
+
+static void delay(double sec)
+{
+    double start = ABT_get_wtime();
+    while (ABT_get_wtime() - start < sec) {
+        ABT_thread_yield();
+    }
+}
+
+static void producer_func(void *arg)
+{
+    int value = 1;
+
+    delay(DELAY_SEC);
+    ABT_eventual_set(g_eventual, &value, sizeof(int));
+    delay(DELAY_SEC);
+    ABT_future_set(g_future, NULL);
+    delay(DELAY_SEC);
+    ABT_mutex_lock(g_mutex);
+    g_flag = 1;
+    ABT_cond_signal(g_cond);
+    ABT_mutex_unlock(g_mutex);
+}
+
+static void sleeper_func(void *arg)
+{
+    delay(DELAY_SEC * 4);
+}
+
+static double get_cpu_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void *waiter_func(void *arg)
+{
+    double *p_result = (double *)arg;
+    double start = ABT_get_wtime(), cpu_start = get_cpu_time();
+    int ret;
+
+    ret = ABT_eventual_wait(g_eventual, NULL);
+    ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+    ret = ABT_future_wait(g_future);
+    ABT_TEST_ERROR(ret, "ABT_future_wait");
+    ret = ABT_mutex_lock(g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_lock");
+    while (g_flag == 0) {
+        ret = ABT_cond_wait(g_cond, g_mutex);
+        ABT_TEST_ERROR(ret, "ABT_cond_wait");
+    }
+    ret = ABT_mutex_unlock(g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_unlock");
+    ret = ABT_thread_join(g_sleeper);
+    ABT_TEST_ERROR(ret, "ABT_thread_join");
+
+    p_result[0] = ABT_get_wtime() - start;
+    p_result[1] = get_cpu_time() - cpu_start;
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    pthread_t waiter;
+    double result[2];
+    int ret;
+
+    ABT_test_init(argc, argv);
+
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_eventual_create(sizeof(int), &g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_future_create(1, NULL, &g_future);
+    ABT_TEST_ERROR(ret, "ABT_future_create");
+    ret = ABT_mutex_create(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_cond_create(&g_cond);
+    ABT_TEST_ERROR(ret, "ABT_cond_create");
+
+    ret = ABT_thread_create(pool, sleeper_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &g_sleeper);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = pthread_create(&waiter, NULL, waiter_func, result);
+    assert(ret == 0);
+    ret = ABT_thread_create(pool, producer_func, NULL, ABT_THREAD_ATTR_NULL,
+                            NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = pthread_join(waiter, NULL);
+    assert(ret == 0);
+
+    ABT_test_printf(1, "waited %.3f sec using %.3f sec of CPU time\n",
+                    result[0], result[1]);
+    assert(result[0] >= DELAY_SEC * 3);
+    assert(result[1] < result[0] * 0.5);
+
+    ret = ABT_thread_free(&g_sleeper);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    ret = ABT_cond_free(&g_cond);
+    ABT_TEST_ERROR(ret, "ABT_cond_free");
+    ret = ABT_mutex_free(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_free");
+    ret = ABT_future_free(&g_future);
+    ABT_TEST_ERROR(ret, "ABT_future_free");
+    ret = ABT_eventual_free(&g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+
+    ret = ABT_test_finalize(0);
+    return ret;
+}
@@ -103,6 +103,14 @@ int main(int argc, char *argv[])
     ABT_future_wait(myfuture2);
     ABT_test_printf(1, "Thread main returns from future2\n");
 
+    /* A reset future can be set again. */
+    ret = ABT_future_reset(myfuture2);
+    ABT_TEST_ERROR(ret, "ABT_future_reset");
+    ret = ABT_future_set(myfuture2, NULL);
+    ABT_TEST_ERROR(ret, "ABT_future_set");
+    ret = ABT_future_wait(myfuture2);
+    ABT_TEST_ERROR(ret, "ABT_future_wait");
+
     /* Join Execution Streams */
     for (i = 1; i < num_xstreams; i++) {
         ret = ABT_xstream_join(xstreams[i]);
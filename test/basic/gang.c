@@ -0,0 +1,151 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define NUM_ROUNDS              10
+#define NUM_ITERS               20
+
+/* The members of a gang spin until all of them have started, which only
+ * returns if they run at once.  A gang that has more members than the ESs
+ * must not be dispatched at all until another ES is added.  Members that
+ * block on a barrier and yield are resumed one by one and must not wait for
+ * the whole gang again. */
+
+static int g_num_started = 0;
+static int g_num_finished = 0;
+static ABT_barrier g_barrier;
+
+static void member_func(void *arg)
+{
+    int num_members = (int)(intptr_t)arg;
+    __sync_fetch_and_add(&g_num_started, 1);
+    while (__sync_fetch_and_add(&g_num_started, 0) % num_members != 0) ;
+}
+
+static void barrier_member_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < NUM_ITERS; i++) {
+        ret = ABT_barrier_wait(g_barrier);
+        ABT_TEST_ERROR(ret, "ABT_barrier_wait");
+        ret = ABT_thread_yield();
+        ABT_TEST_ERROR(ret, "ABT_thread_yield");
+    }
+    __sync_fetch_and_add(&g_num_finished, 1);
+}
+
+static void run_gang(ABT_pool pool, ABT_gang gang, int num_members,
+                     void (*thread_func)(void *))
+{
+    ABT_thread_attr attr;
+    int i, ret;
+
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_gang(attr, gang);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_gang");
+    for (i = 0; i < num_members; i++) {
+        ret = ABT_thread_create(pool, thread_func,
+                                (void *)(intptr_t)num_members, attr, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_pool pool;
+    ABT_gang gang;
+    double start;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    }
+    if (num_xstreams < 2) num_xstreams = 2;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * (num_xstreams + 1));
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                           &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    /* Gangs as large as the ESs */
+    ret = ABT_gang_create(num_xstreams, &gang);
+    ABT_TEST_ERROR(ret, "ABT_gang_create");
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        run_gang(pool, gang, num_xstreams, member_func);
+        while (__sync_fetch_and_add(&g_num_started, 0) <
+               (i + 1) * num_xstreams) {
+            ABT_thread_yield();
+        }
+    }
+    ret = ABT_gang_free(&gang);
+    ABT_TEST_ERROR(ret, "ABT_gang_free");
+
+    /* Members that block and yield */
+    ret = ABT_barrier_create(num_xstreams, &g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_create");
+    ret = ABT_gang_create(num_xstreams, &gang);
+    ABT_TEST_ERROR(ret, "ABT_gang_create");
+    run_gang(pool, gang, num_xstreams, barrier_member_func);
+    while (__sync_fetch_and_add(&g_num_finished, 0) < num_xstreams) {
+        ABT_thread_yield();
+    }
+    ret = ABT_gang_free(&gang);
+    ABT_TEST_ERROR(ret, "ABT_gang_free");
+    ret = ABT_barrier_free(&g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_free");
+
+    /* A gang larger than the ESs */
+    g_num_started = 0;
+    ret = ABT_gang_create(num_xstreams + 1, &gang);
+    ABT_TEST_ERROR(ret, "ABT_gang_create");
+    run_gang(pool, gang, num_xstreams + 1, member_func);
+    start = ABT_get_wtime();
+    while (ABT_get_wtime() - start < 0.05) {
+        ABT_thread_yield();
+    }
+    assert(__sync_fetch_and_add(&g_num_started, 0) == 0);
+
+    ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pool,
+                                   ABT_SCHED_CONFIG_NULL,
+                                   &xstreams[num_xstreams]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    while (__sync_fetch_and_add(&g_num_started, 0) < num_xstreams + 1) {
+        ABT_thread_yield();
+    }
+
+    for (i = 1; i <= num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_gang_free(&gang);
+    ABT_TEST_ERROR(ret, "ABT_gang_free");
+
+    ret = ABT_test_finalize(g_num_started != num_xstreams + 1);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,114 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     64
+#define NUM_YIELDS              16
+
+/* ESs share one pool, whose internal lock is taken at every push and pop.
+ * With --enable-lock-profile, the lock profile has to report the call sites
+ * in the pool, and it has to be empty after a reset.  Otherwise, the
+ * functions report ABT_ERR_FEATURE_NA. */
+
+static void thread_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < NUM_YIELDS; i++) {
+        ABT_thread_yield();
+    }
+}
+
+/* Return the number of lines that report call sites */
+static int count_sites(void)
+{
+    char line[1024];
+    int num_lines = 0;
+    FILE *fp = tmpfile();
+    int ret;
+
+    assert(fp != NULL);
+    ret = ABT_info_print_lock_profile(fp);
+    ABT_TEST_ERROR(ret, "ABT_info_print_lock_profile");
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        ABT_test_printf(1, "%s", line);
+        if (strstr(line, ".c:") != NULL || strstr(line, ".h:") != NULL) {
+            num_lines++;
+        }
+    }
+    fclose(fp);
+    return num_lines;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool pool;
+    int i, ret, num_sites, num_errors = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && num_threads > 0);
+
+    ret = ABT_info_reset_lock_profile();
+    if (ret == ABT_ERR_FEATURE_NA) {
+        ret = ABT_info_print_lock_profile(stdout);
+        if (ret != ABT_ERR_FEATURE_NA) num_errors++;
+        ABT_test_printf(1, "Lock profiling is not enabled\n");
+        return ABT_test_finalize(num_errors);
+    }
+    ABT_TEST_ERROR(ret, "ABT_info_reset_lock_profile");
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+
+    num_sites = count_sites();
+    if (num_sites == 0) {
+        fprintf(stderr, "no call site is reported\n");
+        num_errors++;
+    }
+
+    ret = ABT_info_reset_lock_profile();
+    ABT_TEST_ERROR(ret, "ABT_info_reset_lock_profile");
+    num_sites = count_sites();
+    if (num_sites != 0) {
+        fprintf(stderr, "%d call sites are reported after the reset\n",
+                num_sites);
+        num_errors++;
+    }
+
+    return ABT_test_finalize(num_errors);
+}
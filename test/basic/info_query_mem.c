@@ -0,0 +1,169 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_TASKS       64
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+static void print_stats(const char *name, ABT_mem_stats *p_stats)
+{
+    ABT_test_printf(1, "[%s] stacks %" PRIu64 " (%" PRIu64 " B), task pages %"
+                    PRIu64 " (%" PRIu64 "/%" PRIu64 " free), remote frees %"
+                    PRIu64 ", buffered %" PRIu64 "\n", name,
+                    p_stats->num_stacks, p_stats->stack_bytes,
+                    p_stats->num_task_pages, p_stats->num_free_task_blks,
+                    p_stats->num_task_blks, p_stats->num_remote_frees,
+                    p_stats->num_buffered_frees);
+    ABT_test_printf(1, "[%s] global stacks %" PRIu64 ", global task pages %"
+                    PRIu64 ", stack pages %" PRIu64 " (%" PRIu64
+                    " B, %" PRIu64 " uncarved), malloc %" PRIu64
+                    " B, mmap %" PRIu64 "+%" PRIu64 " B, THP %" PRIu64 " B\n",
+                    name, p_stats->num_global_stacks,
+                    p_stats->num_global_task_pages, p_stats->num_stack_pages,
+                    p_stats->stack_page_bytes, p_stats->num_uncarved_stacks,
+                    p_stats->malloc_bytes, p_stats->mmap_rp_bytes,
+                    p_stats->mmap_hp_bytes, p_stats->thp_bytes);
+}
+
+static void run_units(ABT_pool pool, int num_threads, int num_tasks)
+{
+    ABT_thread *threads;
+    ABT_task *tasks;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    tasks = (ABT_task *)malloc(sizeof(ABT_task) * num_tasks);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pool, task_func, NULL, &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_free(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+    free(threads);
+    free(tasks);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream xstream, new_xstream;
+    ABT_pool pool;
+    ABT_mem_stats stats, all_stats;
+    ABT_thread_mem mem;
+    int ret, err = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+    }
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* The memory per ULT is reported with or without the memory pool. */
+    ret = ABT_info_query_thread_mem(&mem);
+    ABT_TEST_ERROR(ret, "ABT_info_query_thread_mem");
+    ABT_test_printf(1, "per ULT: thread %" PRIu64 " B, unit %" PRIu64
+                    " B, header %" PRIu64 " B, stack %" PRIu64 " B, ktable %"
+                    PRIu64 " B\n", mem.thread_bytes, mem.unit_bytes,
+                    mem.header_bytes, mem.stack_bytes, mem.ktable_bytes);
+    if (mem.unit_bytes == 0 || mem.unit_bytes > mem.thread_bytes ||
+        mem.header_bytes < mem.thread_bytes ||
+        mem.stack_bytes < mem.header_bytes || mem.ktable_bytes == 0) {
+        fprintf(stderr, "the memory per ULT is inconsistent\n");
+        err++;
+    }
+
+    ret = ABT_info_query_mem(xstream, &stats);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        /* The memory pool is disabled. */
+        ABT_test_printf(1, "The memory pool is not used\n");
+        return ABT_test_finalize(0);
+    }
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+    print_stats("initial", &stats);
+
+    /* Freed stacks and blocks stay in the caches of the primary ES. */
+    run_units(pool, num_threads, num_tasks);
+    ret = ABT_info_query_mem(xstream, &stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+    print_stats("primary", &stats);
+    if (num_threads > 0 &&
+        (stats.num_stacks == 0 || stats.num_stack_pages == 0 ||
+         stats.stack_bytes == 0)) {
+        fprintf(stderr, "no cached stack is reported\n");
+        err++;
+    }
+    if (num_tasks > 0 &&
+        (stats.num_task_pages == 0 ||
+         stats.num_free_task_blks != stats.num_task_blks)) {
+        fprintf(stderr, "task blocks are not reported as free\n");
+        err++;
+    }
+    if (stats.malloc_bytes + stats.mmap_rp_bytes + stats.mmap_hp_bytes +
+        stats.thp_bytes < stats.stack_page_bytes) {
+        fprintf(stderr, "large pages are not counted\n");
+        err++;
+    }
+
+    /* The sums over all ESs include the caches of the primary ES. */
+    ret = ABT_info_query_mem(ABT_XSTREAM_NULL, &all_stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+    if (all_stats.num_stacks < stats.num_stacks ||
+        all_stats.num_task_pages < stats.num_task_pages) {
+        fprintf(stderr, "the sums are smaller than the primary ES's\n");
+        err++;
+    }
+
+    /* A terminated ES reports no caches. */
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_xstream_get_main_pools(new_xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    run_units(pool, num_threads, 0);
+    ret = ABT_xstream_join(new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_info_query_mem(new_xstream, &stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+    print_stats("terminated", &stats);
+    if (stats.num_stacks != 0 || stats.num_task_pages != 0) {
+        fprintf(stderr, "a terminated ES has caches\n");
+        err++;
+    }
+    ret = ABT_xstream_free(&new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    return ABT_test_finalize(err);
+}
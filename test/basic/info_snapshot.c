@@ -0,0 +1,131 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_TASKS       1000
+#define NUM_PRINTERS            4
+#define NUM_PRINTS              50
+
+/* ULTs print the ESs while the ESs run tasklets.  The ESs publish their
+ * summaries as they check events, so the printed number of units run by the
+ * target ES eventually reaches the number of its tasklets. */
+
+static int g_num_done = 0;
+
+static void task_func(void *arg)
+{
+    __sync_fetch_and_add(&g_num_done, 1);
+}
+
+static void printer_func(void *arg)
+{
+    FILE *fp = fopen("/dev/null", "w");
+    int i, ret;
+
+    assert(fp);
+    for (i = 0; i < NUM_PRINTS; i++) {
+        ret = ABT_info_print_all_xstreams(fp);
+        ABT_TEST_ERROR(ret, "ABT_info_print_all_xstreams");
+        ABT_thread_yield();
+    }
+    fclose(fp);
+}
+
+/* Units run by xstream according to its last published summary */
+static uint64_t get_num_units(ABT_xstream xstream)
+{
+    char buf[4096], *p;
+    uint64_t num_units = 0;
+    FILE *fp = tmpfile();
+    size_t len;
+    int ret;
+
+    assert(fp);
+    ret = ABT_info_print_xstream(fp, xstream);
+    ABT_TEST_ERROR(ret, "ABT_info_print_xstream");
+    rewind(fp);
+    len = fread(buf, 1, sizeof(buf) - 1, fp);
+    buf[len] = '\0';
+    fclose(fp);
+
+    p = strstr(buf, "units     : ");
+    assert(p);
+    sscanf(p, "units     : %" SCNu64, &num_units);
+    return num_units;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread printers[NUM_PRINTERS];
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    if (num_xstreams < 2) num_xstreams = 2;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* The tasklets run on the last ES and the printers on the others. */
+    for (i = 0; i < NUM_PRINTERS; i++) {
+        ret = ABT_thread_create(pools[i % (num_xstreams - 1)], printer_func,
+                                NULL, ABT_THREAD_ATTR_NULL, &printers[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pools[num_xstreams - 1], task_func, NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 0; i < NUM_PRINTERS; i++) {
+        ret = ABT_thread_free(&printers[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    while (__sync_fetch_and_add(&g_num_done, 0) < num_tasks) {
+        ABT_thread_yield();
+    }
+
+    /* The idle ES keeps checking events and publishes its final count. */
+    while (get_num_units(xstreams[num_xstreams - 1]) < (uint64_t)num_tasks) {
+        ABT_thread_yield();
+    }
+    ABT_test_printf(1, "units of ES %d: %" PRIu64 "\n", num_xstreams - 1,
+                    get_num_units(xstreams[num_xstreams - 1]));
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_test_finalize(0);
+    free(pools);
+    free(xstreams);
+    return ret;
+}
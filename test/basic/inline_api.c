@@ -0,0 +1,121 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt_inline.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define NUM_ITERS               100
+
+/* The hot-path routines in abt_inline.h replace the ones in abt.h and keep
+ * their behavior for valid arguments. */
+
+static ABT_mutex g_mutex;
+static ABT_eventual g_eventual;
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    ABT_thread self;
+    ABT_unit_type type;
+    int i, ret;
+
+    ret = ABT_thread_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_thread_self");
+    assert(self != ABT_THREAD_NULL);
+    ret = ABT_self_get_type(&type);
+    ABT_TEST_ERROR(ret, "ABT_self_get_type");
+    assert(type == ABT_UNIT_TYPE_THREAD);
+
+    for (i = 0; i < NUM_ITERS; i++) {
+        ret = ABT_mutex_lock(g_mutex);
+        ABT_TEST_ERROR(ret, "ABT_mutex_lock");
+        g_counter++;
+        ret = ABT_mutex_unlock(g_mutex);
+        ABT_TEST_ERROR(ret, "ABT_mutex_unlock");
+        ret = ABT_thread_yield();
+        ABT_TEST_ERROR(ret, "ABT_thread_yield");
+    }
+}
+
+static void task_func(void *arg)
+{
+    ABT_thread self;
+    int value = 42;
+    assert(ABT_thread_self(&self) == ABT_ERR_INV_THREAD);
+    ABT_eventual_set(g_eventual, &value, sizeof(int));
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool pool;
+    ABT_thread *threads;
+    int *p_value;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                           &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    ret = ABT_mutex_create(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_eventual_create(sizeof(int), &g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_task_create(pool, task_func, NULL, NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    ret = ABT_eventual_wait(g_eventual, (void **)&p_value);
+    ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+    assert(*p_value == 42);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_eventual_free(&g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+    ret = ABT_mutex_free(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_free");
+
+    ret = ABT_test_finalize(g_counter != num_threads * NUM_ITERS);
+    free(threads);
+    free(xstreams);
+    return ret;
+}
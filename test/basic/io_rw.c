@@ -0,0 +1,211 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <assert.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_ITER        16
+#define BLOCK_SIZE              512
+
+/* Each ULT writes and reads its own blocks of a temporary file. */
+static int g_fd;
+static int g_num_threads;
+static int g_num_iter;
+static int g_num_errors = 0;
+static int g_task_done = 0;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+static off_t block_offset(int id, int iter)
+{
+    return (off_t)(iter * g_num_threads + id) * BLOCK_SIZE;
+}
+
+static void fill_block(char *buf, int id, int iter)
+{
+    int i;
+    for (i = 0; i < BLOCK_SIZE; i++) buf[i] = (char)(id * 7 + iter * 13 + i);
+}
+
+static void write_func(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    char buf[BLOCK_SIZE];
+    ssize_t len;
+    int i, ret;
+
+    for (i = 0; i < g_num_iter; i++) {
+        fill_block(buf, id, i);
+        ret = ABT_io_write(g_fd, buf, BLOCK_SIZE, block_offset(id, i), &len);
+        ABT_TEST_ERROR(ret, "ABT_io_write");
+        check(len == BLOCK_SIZE, "short write");
+    }
+}
+
+static void read_func(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    char buf[BLOCK_SIZE], expected[BLOCK_SIZE];
+    ssize_t len;
+    int i, ret;
+
+    for (i = 0; i < g_num_iter; i++) {
+        ret = ABT_io_read(g_fd, buf, BLOCK_SIZE, block_offset(id, i), &len);
+        ABT_TEST_ERROR(ret, "ABT_io_read");
+        check(len == BLOCK_SIZE, "short read");
+        fill_block(expected, id, i);
+        check(memcmp(buf, expected, BLOCK_SIZE) == 0, "wrong data");
+    }
+}
+
+static void run_threads(ABT_pool *pools, int num_pools, void (*func)(void *))
+{
+    ABT_thread *threads;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * g_num_threads);
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_pools], func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+}
+
+static void fsync_func(void *arg)
+{
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_io_fsync(g_fd);
+    ABT_TEST_ERROR(ret, "ABT_io_fsync");
+}
+
+/* Reads past the end of the file and from a bad descriptor */
+static void error_func(void *arg)
+{
+    char buf[BLOCK_SIZE];
+    ssize_t len = -1;
+    int ret, fd = *(int *)arg;
+
+    ret = ABT_io_read(g_fd, buf, BLOCK_SIZE,
+                      block_offset(0, g_num_iter + 1), &len);
+    ABT_TEST_ERROR(ret, "ABT_io_read");
+    check(len == 0, "no EOF");
+
+    errno = 0;
+    ret = ABT_io_read(fd, buf, BLOCK_SIZE, 0, &len);
+    check(ret == ABT_ERR_IO, "ABT_io_read from a bad descriptor succeeded");
+    check(errno == EBADF, "errno is not EBADF");
+}
+
+/* Tasklets and external threads perform the I/O synchronously. */
+static void task_func(void *arg)
+{
+    read_func(arg);
+    __sync_fetch_and_add(&g_task_done, 1);
+}
+
+static void *ext_thread_func(void *arg)
+{
+    read_func(arg);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread thread;
+    pthread_t ext_thread;
+    char path[] = "/tmp/abt_io_rw_XXXXXX";
+    int i, ret, bad_fd;
+
+    ABT_test_init(argc, argv);
+    g_num_threads = DEFAULT_NUM_THREADS;
+    g_num_iter = DEFAULT_NUM_ITER;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    g_fd = mkstemp(path);
+    assert(g_fd >= 0);
+    unlink(path);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    run_threads(pools, num_xstreams, write_func);
+    ret = ABT_thread_create(pools[num_xstreams - 1], fsync_func, NULL,
+                            ABT_THREAD_ATTR_NULL, &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    run_threads(pools, 1, read_func);
+    run_threads(pools, num_xstreams, read_func);
+
+    bad_fd = dup(g_fd);
+    assert(bad_fd >= 0);
+    close(bad_fd);
+    ret = ABT_thread_create(pools[num_xstreams - 1], error_func, &bad_fd,
+                            ABT_THREAD_ATTR_NULL, &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    ret = ABT_task_create(pools[num_xstreams - 1], task_func, (void *)0, NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    while (*(volatile int *)&g_task_done == 0) {
+        ABT_thread_yield();
+    }
+    ret = pthread_create(&ext_thread, NULL, ext_thread_func, (void *)1);
+    assert(ret == 0);
+    ret = pthread_join(ext_thread, NULL);
+    assert(ret == 0);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+    close(g_fd);
+
+    return ABT_test_finalize(g_num_errors);
+}
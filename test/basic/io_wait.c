@@ -0,0 +1,233 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <assert.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define DEFAULT_NUM_ITER        100
+
+/* Two ULTs of a pair bounce a byte through two pipes. */
+typedef struct {
+    int recv_fd;
+    int send_fd;
+    int is_first;
+} arg_t;
+
+static int g_num_iter;
+static int g_num_errors = 0;
+static int g_task_done = 0;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+static void pingpong_func(void *arg)
+{
+    arg_t *p_arg = (arg_t *)arg;
+    char c = 0;
+    int i, ret, revents;
+
+    for (i = 0; i < g_num_iter; i++) {
+        if (!p_arg->is_first || i > 0) {
+            ret = ABT_io_wait(p_arg->recv_fd, POLLIN, -1.0, &revents);
+            ABT_TEST_ERROR(ret, "ABT_io_wait");
+            check(revents & POLLIN, "POLLIN is not reported");
+            ret = (int)read(p_arg->recv_fd, &c, 1);
+            check(ret == 1, "read failed");
+        }
+        c++;
+        ret = (int)write(p_arg->send_fd, &c, 1);
+        check(ret == 1, "write failed");
+    }
+    if (p_arg->is_first) {
+        /* Take the last byte of the second ULT. */
+        ret = ABT_io_wait(p_arg->recv_fd, POLLIN, -1.0, NULL);
+        ABT_TEST_ERROR(ret, "ABT_io_wait");
+        ret = (int)read(p_arg->recv_fd, &c, 1);
+        check(ret == 1, "read failed");
+        check(c == (char)(2 * g_num_iter), "bytes are lost");
+    }
+}
+
+/* Pairs of ULTs on different ESs exchange bytes through pipes. */
+static void run_pingpong(ABT_pool *pools, int num_pools, int num_pairs)
+{
+    ABT_thread *threads;
+    arg_t *args;
+    int (*fds)[2];
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * 2 * num_pairs);
+    args = (arg_t *)malloc(sizeof(arg_t) * 2 * num_pairs);
+    fds = (int (*)[2])malloc(sizeof(int[2]) * 2 * num_pairs);
+    for (i = 0; i < 2 * num_pairs; i++) {
+        ret = pipe(fds[i]);
+        assert(ret == 0);
+    }
+    for (i = 0; i < num_pairs; i++) {
+        args[2 * i].recv_fd = fds[2 * i][0];
+        args[2 * i].send_fd = fds[2 * i + 1][1];
+        args[2 * i].is_first = 1;
+        args[2 * i + 1].recv_fd = fds[2 * i + 1][0];
+        args[2 * i + 1].send_fd = fds[2 * i][1];
+        args[2 * i + 1].is_first = 0;
+    }
+    for (i = 0; i < 2 * num_pairs; i++) {
+        ret = ABT_thread_create(pools[i % num_pools], pingpong_func, &args[i],
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < 2 * num_pairs; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < 2 * num_pairs; i++) {
+        close(fds[i][0]);
+        close(fds[i][1]);
+    }
+    free(threads);
+    free(args);
+    free(fds);
+}
+
+static void timeout_func(void *arg)
+{
+    int *fds = (int *)arg;
+    double start;
+    int ret, revents = -1;
+
+    /* Nothing is written, so it times out. */
+    start = ABT_get_wtime();
+    ret = ABT_io_wait(fds[0], POLLIN, 0.01, &revents);
+    check(ret == ABT_ERR_TIMEDOUT, "ABT_io_wait did not time out");
+    check(revents == 0, "events are reported on timeout");
+    check(ABT_get_wtime() - start >= 0.009, "ABT_io_wait returned early");
+
+    /* An empty pipe can be written immediately. */
+    ret = ABT_io_wait(fds[1], POLLOUT, 0.0, &revents);
+    ABT_TEST_ERROR(ret, "ABT_io_wait");
+    check(revents & POLLOUT, "POLLOUT is not reported");
+}
+
+/* A tasklet only checks the descriptor. */
+static void task_func(void *arg)
+{
+    int *fds = (int *)arg;
+    int ret, revents;
+    char c = 0;
+
+    ret = ABT_io_wait(fds[0], POLLIN, -1.0, &revents);
+    check(ret == ABT_ERR_TIMEDOUT, "ABT_io_wait in a tasklet waited");
+    ret = (int)write(fds[1], &c, 1);
+    check(ret == 1, "write failed");
+    ret = ABT_io_wait(fds[0], POLLIN, -1.0, &revents);
+    ABT_TEST_ERROR(ret, "ABT_io_wait");
+    check(revents & POLLIN, "POLLIN is not reported");
+    ret = (int)read(fds[0], &c, 1);
+    check(ret == 1, "read failed");
+    __sync_fetch_and_add(&g_task_done, 1);
+}
+
+static void *ext_thread_func(void *arg)
+{
+    int *fds = (int *)arg;
+    int ret, revents;
+    char c;
+
+    ret = ABT_io_wait(fds[0], POLLIN, -1.0, &revents);
+    ABT_TEST_ERROR(ret, "ABT_io_wait");
+    check(revents & POLLIN, "POLLIN is not reported");
+    ret = (int)read(fds[0], &c, 1);
+    check(ret == 1, "read failed");
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread thread;
+    pthread_t ext_thread;
+    int fds[2];
+    char c = 0;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    g_num_iter = DEFAULT_NUM_ITER;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* ULTs on the same ES and on different ESs */
+    run_pingpong(pools, 1, num_threads / 2);
+    run_pingpong(pools, num_xstreams, num_threads / 2);
+
+    ret = pipe(fds);
+    assert(ret == 0);
+
+    /* Timeouts and descriptors that are ready already */
+    ret = ABT_thread_create(pools[num_xstreams - 1], timeout_func, fds,
+                            ABT_THREAD_ATTR_NULL, &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    ret = ABT_task_create(pools[num_xstreams - 1], task_func, fds, NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    while (*(volatile int *)&g_task_done == 0) {
+        ABT_thread_yield();
+    }
+
+    /* An external thread waits in poll(). */
+    ret = pthread_create(&ext_thread, NULL, ext_thread_func, fds);
+    assert(ret == 0);
+    ABT_thread_sleep(0.01);
+    ret = (int)write(fds[1], &c, 1);
+    assert(ret == 1);
+    ret = pthread_join(ext_thread, NULL);
+    assert(ret == 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+
+    return ABT_test_finalize(g_num_errors);
+}
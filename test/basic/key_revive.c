@@ -0,0 +1,135 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     100
+#define NUM_REVIVES             4
+
+/* A revived ULT or tasklet keeps its key table, which has to be emptied and
+ * have the destructors called.  The tables freed by other work units are
+ * reused through the cache of the ES. */
+
+static ABT_key g_key;
+static int g_num_destructed = 0;
+static int g_num_errors = 0;
+
+static void destructor(void *value)
+{
+    ABT_TEST_UNUSED(value);
+    __sync_fetch_and_add(&g_num_destructed, 1);
+}
+
+static void key_func(void *arg)
+{
+    void *value;
+    int ret;
+
+    ret = ABT_key_get(g_key, &value);
+    ABT_TEST_ERROR(ret, "ABT_key_get");
+    if (value != NULL) __sync_fetch_and_add(&g_num_errors, 1);
+
+    ret = ABT_key_set(g_key, arg);
+    ABT_TEST_ERROR(ret, "ABT_key_set");
+    ret = ABT_key_get(g_key, &value);
+    ABT_TEST_ERROR(ret, "ABT_key_get");
+    if (value != arg) __sync_fetch_and_add(&g_num_errors, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_task *tasks;
+    int i, k, ret, expected;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    tasks = (ABT_task *)malloc(sizeof(ABT_task) * num_threads);
+
+    ret = ABT_key_create(destructor, &g_key);
+    ABT_TEST_ERROR(ret, "ABT_key_create");
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        void *arg = (void *)(intptr_t)(i + 1);
+        ret = ABT_thread_create(pools[i % num_xstreams], key_func, arg,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_task_create(pools[i % num_xstreams], key_func, arg,
+                              &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+
+    for (k = 0; k < NUM_REVIVES; k++) {
+        for (i = 0; i < num_threads; i++) {
+            void *arg = (void *)(intptr_t)(i + 1);
+            ret = ABT_thread_join(threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_join");
+            ret = ABT_thread_revive(pools[(i + k) % num_xstreams], key_func,
+                                    arg, &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_revive");
+            ret = ABT_task_join(tasks[i]);
+            ABT_TEST_ERROR(ret, "ABT_task_join");
+            ret = ABT_task_revive(pools[(i + k) % num_xstreams], key_func,
+                                  arg, &tasks[i]);
+            ABT_TEST_ERROR(ret, "ABT_task_revive");
+        }
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+        ret = ABT_task_free(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+
+    /* Every run set a value, so every run ends with a destructor call. */
+    expected = 2 * num_threads * (NUM_REVIVES + 1);
+    if (g_num_destructed != expected) {
+        fprintf(stderr, "destructed: %d (expected %d)\n", g_num_destructed,
+                expected);
+        g_num_errors++;
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_key_free(&g_key);
+    ABT_TEST_ERROR(ret, "ABT_key_free");
+
+    ret = ABT_test_finalize(g_num_errors);
+    free(tasks);
+    free(threads);
+    free(pools);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,90 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define NUM_KEYS    37
+#define NUM_THREADS 4
+#define NUM_ROUNDS  3
+
+static ABT_key g_keys[NUM_KEYS];
+static int g_num_destructed = 0;
+
+static void destructor(void *value)
+{
+    __sync_fetch_and_add(&g_num_destructed, 1);
+    free(value);
+}
+
+/* Each ULT sets more keys than the initial slots of its key table, so the
+ * slots have to grow while keeping the values set before. */
+static void thread_func(void *arg)
+{
+    int rank = (int)(intptr_t)arg;
+    int i, ret;
+    void *value;
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        ret = ABT_key_get(g_keys[i], &value);
+        ABT_TEST_ERROR(ret, "ABT_key_get");
+        assert(value == NULL);
+
+        int *p_val = (int *)malloc(sizeof(int));
+        *p_val = rank * NUM_KEYS + i;
+        ret = ABT_key_set(g_keys[i], p_val);
+        ABT_TEST_ERROR(ret, "ABT_key_set");
+    }
+    ABT_thread_yield();
+    for (i = 0; i < NUM_KEYS; i++) {
+        ret = ABT_key_get(g_keys[i], &value);
+        ABT_TEST_ERROR(ret, "ABT_key_get");
+        assert(*(int *)value == rank * NUM_KEYS + i);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread threads[NUM_THREADS];
+    int i, r, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* Keys are freed and created again in every round, so the IDs of the
+     * freed keys are reused by the new keys. */
+    for (r = 0; r < NUM_ROUNDS; r++) {
+        for (i = 0; i < NUM_KEYS; i++) {
+            ret = ABT_key_create(destructor, &g_keys[i]);
+            ABT_TEST_ERROR(ret, "ABT_key_create");
+        }
+        for (i = 0; i < NUM_THREADS; i++) {
+            ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i,
+                                    ABT_THREAD_ATTR_NULL, &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < NUM_THREADS; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+        for (i = 0; i < NUM_KEYS; i++) {
+            ret = ABT_key_free(&g_keys[i]);
+            ABT_TEST_ERROR(ret, "ABT_key_free");
+        }
+        assert(g_num_destructed == (r + 1) * NUM_THREADS * NUM_KEYS);
+    }
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
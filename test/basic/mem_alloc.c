@@ -0,0 +1,132 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     4
+#define NUM_BLKS                1000
+#define NUM_ROUNDS              3
+
+/* Blocks of ABT_mem_alloc() are allocated by ULTs on one ES and freed by ULTs
+ * on another ES, so most frees are remote.  Their contents must stay intact
+ * and the freed blocks must be reusable. */
+
+static void **g_blks;
+
+static size_t blk_size(int idx)
+{
+    /* From 1 byte to beyond the largest size class */
+    return (size_t)(idx * 37 % 4099) + 1;
+}
+
+static void alloc_func(void *arg)
+{
+    int first = (int)(intptr_t)arg;
+    int i, ret;
+
+    for (i = first; i < first + NUM_BLKS; i++) {
+        ret = ABT_mem_alloc(blk_size(i), &g_blks[i]);
+        ABT_TEST_ERROR(ret, "ABT_mem_alloc");
+        assert(((uintptr_t)g_blks[i] & 15) == 0);
+        memset(g_blks[i], i & 0xff, blk_size(i));
+    }
+}
+
+static void free_func(void *arg)
+{
+    int first = (int)(intptr_t)arg;
+    int i, ret;
+
+    for (i = first; i < first + NUM_BLKS; i++) {
+        unsigned char *p = (unsigned char *)g_blks[i];
+        assert(p[0] == (i & 0xff) && p[blk_size(i) - 1] == (i & 0xff));
+        ret = ABT_mem_free(g_blks[i]);
+        ABT_TEST_ERROR(ret, "ABT_mem_free");
+    }
+}
+
+static void run_on_xstreams(ABT_pool *pools, int num_xstreams, int num_threads,
+                            void (*func)(void *), int shift)
+{
+    ABT_thread *threads;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[(i + shift) % num_xstreams], func,
+                                (void *)(intptr_t)(i * NUM_BLKS),
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    void *ptr;
+    int i, r, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    num_threads *= num_xstreams;
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    g_blks = (void **)malloc(sizeof(void *) * num_threads * NUM_BLKS);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (r = 0; r < NUM_ROUNDS; r++) {
+        run_on_xstreams(pools, num_xstreams, num_threads, alloc_func, 0);
+        run_on_xstreams(pools, num_xstreams, num_threads, free_func, r + 1);
+    }
+
+    /* Blocks of the primary ULT */
+    ret = ABT_mem_alloc(64, &ptr);
+    ABT_TEST_ERROR(ret, "ABT_mem_alloc");
+    ret = ABT_mem_free(ptr);
+    ABT_TEST_ERROR(ret, "ABT_mem_free");
+    ret = ABT_mem_free(NULL);
+    ABT_TEST_ERROR(ret, "ABT_mem_free");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_test_finalize(0);
+    free(g_blks);
+    free(pools);
+    free(xstreams);
+    return ret;
+}
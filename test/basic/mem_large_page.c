@@ -0,0 +1,131 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     64
+#define GP_SIZE                 (1024 * 1024 * 1024)
+
+static uintptr_t *g_offsets;
+
+static void thread_func(void *arg)
+{
+    int local;
+    size_t idx = (size_t)arg;
+    long pgsize = sysconf(_SC_PAGESIZE);
+
+    /* Offset of the top of the stack in its page */
+    g_offsets[idx] = (uintptr_t)&local % (uintptr_t)pgsize;
+}
+
+static void run_threads(int num_threads)
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread *threads;
+    int i, ret;
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, (void *)(size_t)i,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+}
+
+static int count_offsets(int num_threads)
+{
+    int i, j, num_offsets = 0;
+    for (i = 0; i < num_threads; i++) {
+        for (j = 0; j < i; j++) {
+            if (g_offsets[j] == g_offsets[i]) break;
+        }
+        if (j == i) num_offsets++;
+    }
+    return num_offsets;
+}
+
+/* Stack pages of 1GB are mapped with 1GB huge pages if possible, and
+ * otherwise the fallbacks are counted.  Stacks are placed so that their tops
+ * are not at the same offset in the pages. */
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_offsets, ret, err = 0;
+    ABT_mem_stats stats;
+
+    setenv("ABT_MEM_LP_ALLOC", "mmap_gp_hp_rp", 1);
+    setenv("ABT_MEM_STACK_PAGE_SIZE", "1073741824", 1);
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    g_offsets = (uintptr_t *)calloc(num_threads, sizeof(uintptr_t));
+
+    run_threads(num_threads);
+    ret = ABT_info_query_mem(ABT_XSTREAM_NULL, &stats);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        /* The memory pool is disabled. */
+        ABT_test_printf(1, "The memory pool is not used\n");
+        free(g_offsets);
+        return ABT_test_finalize(0);
+    }
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+    ABT_test_printf(1, "1GB pages: %" PRIu64 " bytes, failures: %" PRIu64
+                    " (1GB), %" PRIu64 " (huge), %" PRIu64 " (regular)\n",
+                    stats.mmap_gp_bytes, stats.num_gp_failures,
+                    stats.num_hp_failures, stats.num_mmap_failures);
+    if (stats.stack_page_bytes < GP_SIZE ||
+        (stats.mmap_gp_bytes < GP_SIZE && stats.num_gp_failures == 0 &&
+         stats.malloc_bytes < GP_SIZE)) {
+        fprintf(stderr, "the 1GB stack page is not reported\n");
+        err++;
+    }
+    num_offsets = count_offsets(num_threads);
+    ABT_test_printf(1, "regular stacks: %d offsets\n", num_offsets);
+    if (num_threads >= 8 && num_offsets < 8) {
+        fprintf(stderr, "tops of regular stacks are aligned\n");
+        err++;
+    }
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+
+    /* Lazily committed stacks are in page-aligned slots. */
+    unsetenv("ABT_MEM_LP_ALLOC");
+    unsetenv("ABT_MEM_STACK_PAGE_SIZE");
+    setenv("ABT_MEM_LAZY_STACK", "1", 1);
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+
+    run_threads(num_threads);
+    num_offsets = count_offsets(num_threads);
+    ABT_test_printf(1, "lazy stacks: %d offsets\n", num_offsets);
+    if (num_threads >= 8 && num_offsets < 8) {
+        fprintf(stderr, "tops of lazy stacks are aligned\n");
+        err++;
+    }
+
+    free(g_offsets);
+    return ABT_test_finalize(err);
+}
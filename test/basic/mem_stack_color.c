@@ -0,0 +1,114 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     2048
+#define OFFSET_SIZE             (2 * 1024 * 1024)
+
+static uintptr_t *g_offsets;
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    int local;
+    size_t idx = (size_t)arg;
+
+    /* Offset of the top of the stack in a huge page */
+    g_offsets[idx] = (uintptr_t)&local % OFFSET_SIZE;
+    g_counter++;
+}
+
+/* Return the number of distinct offsets of the tops of num_threads stacks */
+static int run_threads(int num_threads)
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread *threads;
+    int i, j, num_offsets = 0, ret;
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, (void *)(size_t)i,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+
+    for (i = 0; i < num_threads; i++) {
+        for (j = 0; j < i; j++) {
+            if (g_offsets[j] == g_offsets[i]) break;
+        }
+        if (j == i) num_offsets++;
+    }
+    return num_offsets;
+}
+
+/* Stacks at the same position of different stack pages get different colors,
+ * so the tops of more stacks are at distinct offsets with coloring. */
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_uncolored, num_colored, ret, err = 0;
+    ABT_mem_stats stats;
+
+    unsetenv("ABT_MEM_LAZY_STACK");
+    unsetenv("ABT_ENV_MEM_LAZY_STACK");
+    unsetenv("ABT_ENV_MEM_STACK_COLORS");
+    setenv("ABT_MEM_STACK_COLORS", "1", 1);
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    g_offsets = (uintptr_t *)calloc(num_threads, sizeof(uintptr_t));
+
+    ret = ABT_info_query_mem(ABT_XSTREAM_NULL, &stats);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        /* The memory pool is disabled. */
+        ABT_test_printf(1, "The memory pool is not used\n");
+        free(g_offsets);
+        return ABT_test_finalize(0);
+    }
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+
+    num_uncolored = run_threads(num_threads);
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+
+    setenv("ABT_MEM_STACK_COLORS", "8", 1);
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+    num_colored = run_threads(num_threads);
+
+    ABT_test_printf(1, "distinct offsets: %d (uncolored), %d (colored)\n",
+                    num_uncolored, num_colored);
+    if (num_uncolored < num_threads && num_colored <= num_uncolored) {
+        fprintf(stderr, "tops of stacks are not colored\n");
+        err++;
+    }
+    if (g_counter != 2 * num_threads) {
+        fprintf(stderr, "%d ULTs run (expected %d)\n", g_counter,
+                2 * num_threads);
+        err++;
+    }
+
+    free(g_offsets);
+    return ABT_test_finalize(err);
+}
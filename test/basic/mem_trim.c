@@ -0,0 +1,148 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     4096
+#define DEFAULT_NUM_TASKS       4096
+
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Create and free a burst of ULTs and tasklets on the primary ES */
+static void run_burst(ABT_pool pool, int num_threads, int num_tasks)
+{
+    ABT_thread *threads;
+    ABT_task *tasks;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    tasks = (ABT_task *)malloc(sizeof(ABT_task) * num_tasks);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pool, task_func, NULL, &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_free(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+    free(threads);
+    free(tasks);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_mem_stats before, after;
+    int ret, err = 0;
+
+    /* Background trims would release pages before the checks below. */
+    unsetenv("ABT_MEM_TRIM_INTERVAL");
+    unsetenv("ABT_ENV_MEM_TRIM_INTERVAL");
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+    }
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    ret = ABT_mem_trim(0);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        /* The memory pool is disabled. */
+        ABT_test_printf(1, "The memory pool is not used\n");
+        return ABT_test_finalize(0);
+    }
+    ABT_TEST_ERROR(ret, "ABT_mem_trim");
+
+    run_burst(pool, num_threads, num_tasks);
+
+    /* Nothing is released if the caches fit. */
+    ret = ABT_info_query_mem(xstream, &before);
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+    ret = ABT_mem_trim(SIZE_MAX);
+    ABT_TEST_ERROR(ret, "ABT_mem_trim");
+    ret = ABT_info_query_mem(xstream, &after);
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+    if (after.trimmed_bytes != before.trimmed_bytes ||
+        after.num_stack_pages != before.num_stack_pages) {
+        fprintf(stderr, "pages are released with no limit\n");
+        err++;
+    }
+    before = after;
+
+    /* Release everything that is not used */
+    ret = ABT_mem_trim(0);
+    ABT_TEST_ERROR(ret, "ABT_mem_trim");
+    ret = ABT_info_query_mem(xstream, &after);
+    ABT_TEST_ERROR(ret, "ABT_info_query_mem");
+    ABT_test_printf(1, "stacks: %" PRIu64 " -> %" PRIu64 ", stack pages: %"
+                    PRIu64 " -> %" PRIu64 ", task pages: %" PRIu64 " -> %"
+                    PRIu64 ", trimmed: %" PRIu64 " bytes\n",
+                    before.num_stacks, after.num_stacks,
+                    before.num_stack_pages, after.num_stack_pages,
+                    before.num_task_pages, after.num_task_pages,
+                    after.trimmed_bytes);
+    if (after.num_stacks > before.num_stacks ||
+        after.num_task_pages > 1) {
+        fprintf(stderr, "the caches of the ES are not trimmed\n");
+        err++;
+    }
+    if (num_threads >= 1024 &&
+        (after.num_stack_pages >= before.num_stack_pages ||
+         after.trimmed_bytes <= before.trimmed_bytes)) {
+        fprintf(stderr, "no stack page is released\n");
+        err++;
+    }
+    if (after.num_global_free_task_blks != 0) {
+        fprintf(stderr, "free task pages are left in the global data\n");
+        err++;
+    }
+
+    /* The memory pool works after trims. */
+    run_burst(pool, num_threads, num_tasks);
+    ret = ABT_mem_trim(0);
+    ABT_TEST_ERROR(ret, "ABT_mem_trim");
+    run_burst(pool, num_threads, num_tasks);
+
+    if (g_counter != 3 * (num_threads + num_tasks)) {
+        fprintf(stderr, "%d units run (expected %d)\n", g_counter,
+                3 * (num_threads + num_tasks));
+        err++;
+    }
+
+    return ABT_test_finalize(err);
+}
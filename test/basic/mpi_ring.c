@@ -0,0 +1,124 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "abt_mpi.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_TASKS       1024
+#define RING_CAPACITY           16
+
+/* Each process ships tasklets to the next process through its ring and runs
+ * those shipped to it by popping the pool of its own ring.  The tasklets
+ * check that they run on their target process, and the processes count them
+ * with MPI_Allreduce() until all have run. */
+
+typedef struct {
+    int target;
+    int idx;
+} task_arg_t;
+
+static int g_rank;
+static int g_num_done = 0;
+static int g_num_errors = 0;
+
+static void task_func(void *arg)
+{
+    task_arg_t *p_arg = (task_arg_t *)arg;
+    if (p_arg->target != g_rank) {
+        __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_fetch_add(&g_num_done, 1, __ATOMIC_SEQ_CST);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_mpi_ring ring;
+    ABT_pool ring_pool, my_pools[2];
+    ABT_remote_desc desc;
+    task_arg_t task_arg;
+    int i, ret, provided, size, func_id, target, local, total;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    if (provided != MPI_THREAD_MULTIPLE) {
+        fprintf(stderr, "MPI_THREAD_MULTIPLE is not supported\n");
+        MPI_Finalize();
+        return 77;
+    }
+    MPI_Comm_rank(MPI_COMM_WORLD, &g_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    ret = ABT_remote_func_register(task_func, &func_id);
+    ABT_TEST_ERROR(ret, "ABT_remote_func_register");
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && num_tasks > 0);
+
+    ret = ABT_mpi_ring_create(MPI_COMM_WORLD, RING_CAPACITY, &ring);
+    ABT_TEST_ERROR(ret, "ABT_mpi_ring_create");
+    ret = ABT_mpi_ring_get_pool(ring, &ring_pool);
+    ABT_TEST_ERROR(ret, "ABT_mpi_ring_get_pool");
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &my_pools[0]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+        my_pools[1] = ring_pool;
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, 2, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    target = (g_rank + 1) % size;
+    for (i = 0; i < num_tasks; i++) {
+        task_arg.target = target;
+        task_arg.idx = i;
+        ret = ABT_remote_desc_set(&desc, func_id, &task_arg,
+                                  sizeof(task_arg));
+        ABT_TEST_ERROR(ret, "ABT_remote_desc_set");
+        while ((ret = ABT_mpi_ring_push(ring, target, &desc)) ==
+               ABT_ERR_POOL_FULL) {
+            ABT_thread_yield();
+        }
+        ABT_TEST_ERROR(ret, "ABT_mpi_ring_push");
+    }
+
+    do {
+        ABT_thread_yield();
+        local = __atomic_load_n(&g_num_done, __ATOMIC_SEQ_CST);
+        MPI_Allreduce(&local, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    } while (total < num_tasks * size);
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_mpi_ring_free(&ring);
+    ABT_TEST_ERROR(ret, "ABT_mpi_ring_free");
+
+    if (g_num_done != num_tasks) g_num_errors++;
+
+    ret = ABT_test_finalize(g_num_errors);
+    free(scheds);
+    free(xstreams);
+    MPI_Finalize();
+    return ret;
+}
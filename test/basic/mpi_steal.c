@@ -0,0 +1,151 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "abt_mpi.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_DEPTH           10
+#define QUEUE_CAPACITY          64
+
+/* A binary tree is searched from its root on rank 0.  Each node pushes its
+ * children into the queue of its process, or visits them by itself if the
+ * queue is full.  Randws schedulers steal the nodes through the remote pool,
+ * so the other processes take work from rank 0.  Every node must be visited
+ * once in total, which the processes check with MPI_Allreduce(). */
+
+typedef struct {
+    int depth;
+    int origin;
+} node_t;
+
+static ABT_mpi_steal g_steal;
+static int g_func_id;
+static int g_depth;
+static int g_rank;
+static int g_num_nodes = 0;
+static int g_num_leaves = 0;
+static int g_num_stolen = 0;
+
+static void node_func(void *arg)
+{
+    node_t *p_node = (node_t *)arg;
+    node_t child;
+    ABT_remote_desc desc;
+    int i, ret;
+
+    if (p_node->origin != g_rank) {
+        __atomic_fetch_add(&g_num_stolen, 1, __ATOMIC_SEQ_CST);
+    }
+    if (p_node->depth == g_depth) {
+        __atomic_fetch_add(&g_num_leaves, 1, __ATOMIC_SEQ_CST);
+    } else {
+        child.depth = p_node->depth + 1;
+        child.origin = g_rank;
+        for (i = 0; i < 2; i++) {
+            ret = ABT_remote_desc_set(&desc, g_func_id, &child, sizeof(child));
+            ABT_TEST_ERROR(ret, "ABT_remote_desc_set");
+            ret = ABT_mpi_steal_push(g_steal, &desc);
+            if (ret == ABT_ERR_POOL_FULL) {
+                node_func(&child);
+            } else {
+                ABT_TEST_ERROR(ret, "ABT_mpi_steal_push");
+            }
+        }
+    }
+    /* Counted last so that all the nodes are visited when the count is
+     * complete. */
+    __atomic_fetch_add(&g_num_nodes, 1, __ATOMIC_SEQ_CST);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool remote, my_pools[2];
+    ABT_remote_desc desc;
+    node_t root;
+    int i, ret, provided, size, num_errors = 0;
+    int local[2], total[2], num_total;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    if (provided != MPI_THREAD_MULTIPLE) {
+        fprintf(stderr, "MPI_THREAD_MULTIPLE is not supported\n");
+        MPI_Finalize();
+        return 77;
+    }
+    MPI_Comm_rank(MPI_COMM_WORLD, &g_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    ret = ABT_remote_func_register(node_func, &g_func_id);
+    ABT_TEST_ERROR(ret, "ABT_remote_func_register");
+    ABT_test_init(argc, argv);
+    g_depth = DEFAULT_DEPTH;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    }
+    assert(num_xstreams > 0);
+    num_total = (1 << (g_depth + 1)) - 1;
+
+    ret = ABT_mpi_steal_create(MPI_COMM_WORLD, QUEUE_CAPACITY, &g_steal);
+    ABT_TEST_ERROR(ret, "ABT_mpi_steal_create");
+    ret = ABT_mpi_steal_get_pool(g_steal, &remote);
+    ABT_TEST_ERROR(ret, "ABT_mpi_steal_get_pool");
+
+    if (g_rank == 0) {
+        root.depth = 0;
+        root.origin = 0;
+        ret = ABT_remote_desc_set(&desc, g_func_id, &root, sizeof(root));
+        ABT_TEST_ERROR(ret, "ABT_remote_desc_set");
+        ret = ABT_mpi_steal_push(g_steal, &desc);
+        ABT_TEST_ERROR(ret, "ABT_mpi_steal_push");
+    }
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &my_pools[0]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+        my_pools[1] = remote;
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, 2, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* The search ends when all the processes have visited all the nodes. */
+    do {
+        ABT_thread_yield();
+        local[0] = __atomic_load_n(&g_num_nodes, __ATOMIC_SEQ_CST);
+        local[1] = __atomic_load_n(&g_num_leaves, __ATOMIC_SEQ_CST);
+        MPI_Allreduce(local, total, 2, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    } while (total[0] < num_total);
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_mpi_steal_free(&g_steal);
+    ABT_TEST_ERROR(ret, "ABT_mpi_steal_free");
+
+    if (total[0] != num_total) num_errors++;
+    if (total[1] != (1 << g_depth)) num_errors++;
+    ABT_test_printf(1, "rank %d: %d nodes, %d stolen\n", g_rank, g_num_nodes,
+                    g_num_stolen);
+
+    ret = ABT_test_finalize(num_errors);
+    free(scheds);
+    free(xstreams);
+    MPI_Finalize();
+    return ret;
+}
@@ -0,0 +1,210 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+#include "abt_mpi.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     16
+#define DEFAULT_NUM_ITER        100
+
+/* Two ULTs of a pair bounce a counter through MPI_COMM_SELF.  Each ULT
+ * receives messages with its own tag. */
+typedef struct {
+    int recv_tag;
+    int send_tag;
+    int is_first;
+} arg_t;
+
+static int g_num_iter;
+static int g_num_errors = 0;
+static int g_task_done = 0;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+static void recv_value(int *p_value, int tag)
+{
+    MPI_Request req;
+    MPI_Status status;
+    int ret;
+
+    MPI_Irecv(p_value, 1, MPI_INT, 0, tag, MPI_COMM_SELF, &req);
+    ret = ABT_mpi_wait(&req, &status);
+    ABT_TEST_ERROR(ret, "ABT_mpi_wait");
+    check(req == MPI_REQUEST_NULL, "the request is not freed");
+    check(status.MPI_TAG == tag, "wrong tag");
+}
+
+static void send_value(int value, int tag)
+{
+    MPI_Request req;
+    int ret;
+
+    MPI_Isend(&value, 1, MPI_INT, 0, tag, MPI_COMM_SELF, &req);
+    ret = ABT_mpi_wait(&req, MPI_STATUS_IGNORE);
+    ABT_TEST_ERROR(ret, "ABT_mpi_wait");
+}
+
+static void pingpong_func(void *arg)
+{
+    arg_t *p_arg = (arg_t *)arg;
+    int i, value = 0;
+
+    for (i = 0; i < g_num_iter; i++) {
+        if (!p_arg->is_first || i > 0) {
+            int expected = value + 1;
+            recv_value(&value, p_arg->recv_tag);
+            check(value == expected, "wrong value");
+        }
+        value++;
+        send_value(value, p_arg->send_tag);
+    }
+    if (p_arg->is_first) {
+        /* Take the last value of the second ULT. */
+        recv_value(&value, p_arg->recv_tag);
+        check(value == 2 * g_num_iter, "values are lost");
+    }
+}
+
+/* Pairs of ULTs on the same ES and on different ESs exchange values. */
+static void run_pingpong(ABT_pool *pools, int num_pools, int num_pairs)
+{
+    ABT_thread *threads;
+    arg_t *args;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * 2 * num_pairs);
+    args = (arg_t *)malloc(sizeof(arg_t) * 2 * num_pairs);
+    for (i = 0; i < 2 * num_pairs; i++) {
+        args[i].recv_tag = i;
+        args[i].send_tag = i ^ 1;
+        args[i].is_first = (i % 2 == 0);
+    }
+    for (i = 0; i < 2 * num_pairs; i++) {
+        ret = ABT_thread_create(pools[i % num_pools], pingpong_func, &args[i],
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < 2 * num_pairs; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+    free(args);
+}
+
+/* Tasklets and external threads call MPI_Wait(). */
+static void task_func(void *arg)
+{
+    int value, tag = *(int *)arg;
+    send_value(tag, tag);
+    recv_value(&value, tag);
+    check(value == tag, "wrong value");
+    __sync_fetch_and_add(&g_task_done, 1);
+}
+
+static void *ext_thread_func(void *arg)
+{
+    int value, tag = *(int *)arg;
+    recv_value(&value, tag);
+    check(value == tag, "wrong value");
+    return NULL;
+}
+
+static void null_func(void *arg)
+{
+    MPI_Request req = MPI_REQUEST_NULL;
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_mpi_wait(&req, MPI_STATUS_IGNORE);
+    ABT_TEST_ERROR(ret, "ABT_mpi_wait");
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread thread;
+    pthread_t ext_thread;
+    int i, ret, provided, tag = 1000;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    if (provided != MPI_THREAD_MULTIPLE) {
+        fprintf(stderr, "MPI_THREAD_MULTIPLE is not supported\n");
+        MPI_Finalize();
+        return 77;
+    }
+
+    ABT_test_init(argc, argv);
+    g_num_iter = DEFAULT_NUM_ITER;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    run_pingpong(pools, 1, num_threads / 2);
+    run_pingpong(pools, num_xstreams, num_threads / 2);
+
+    /* A request that has completed already */
+    ret = ABT_thread_create(pools[num_xstreams - 1], null_func, NULL,
+                            ABT_THREAD_ATTR_NULL, &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    ret = ABT_task_create(pools[num_xstreams - 1], task_func, &tag, NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    while (*(volatile int *)&g_task_done == 0) {
+        ABT_thread_yield();
+    }
+
+    /* An external thread waits in MPI_Wait(). */
+    ret = pthread_create(&ext_thread, NULL, ext_thread_func, &tag);
+    assert(ret == 0);
+    ABT_thread_sleep(0.01);
+    send_value(tag, tag);
+    ret = pthread_join(ext_thread, NULL);
+    assert(ret == 0);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+
+    ret = ABT_test_finalize(g_num_errors);
+    MPI_Finalize();
+    return ret;
+}
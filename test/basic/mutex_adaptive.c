@@ -0,0 +1,156 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     4
+#define DEFAULT_NUM_ITER        1000
+#define NUM_SLOW_ITER           5
+
+static ABT_mutex g_mutex;
+static int g_counter = 0;
+static int g_iter = DEFAULT_NUM_ITER;
+
+/* Short critical sections with all the locking routines */
+static void fast_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_iter; i++) {
+        if (i % 3 == 0) {
+            ABT_mutex_lock(g_mutex);
+        } else if (i % 3 == 1) {
+            ABT_mutex_lock_low(g_mutex);
+        } else {
+            while (ABT_mutex_trylock(g_mutex) != ABT_SUCCESS) {
+                ABT_thread_yield();
+            }
+        }
+        g_counter++;
+        ABT_mutex_unlock(g_mutex);
+    }
+}
+
+/* Long critical sections */
+static void slow_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < NUM_SLOW_ITER; i++) {
+        ABT_mutex_lock(g_mutex);
+        ABT_thread_sleep(1.0e-3);
+        g_counter++;
+        ABT_mutex_unlock(g_mutex);
+    }
+}
+
+static void run_threads(ABT_xstream *xstreams, int num_xstreams,
+                        int num_threads, void (*func)(void *))
+{
+    ABT_thread *threads;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams
+                                   * num_threads);
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_create_on_xstream(xstreams[i % num_xstreams], func,
+                                           NULL, ABT_THREAD_ATTR_NULL,
+                                           &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create_on_xstream");
+    }
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_mutex_attr attr;
+    ABT_mutex_stats stats;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int i, ret, expected;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc >= 2) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* Create an adaptive mutex */
+    ret = ABT_mutex_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_mutex_attr_create");
+    ret = ABT_mutex_attr_set_adaptive(attr, ABT_TRUE);
+    ABT_TEST_ERROR(ret, "ABT_mutex_attr_set_adaptive");
+    ret = ABT_mutex_create_with_attr(attr, &g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create_with_attr");
+    ret = ABT_mutex_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_mutex_attr_free");
+
+    /* Fast holders */
+    run_threads(xstreams, num_xstreams, num_threads, fast_func);
+    expected = num_xstreams * num_threads * g_iter;
+    assert(g_counter == expected);
+
+    ret = ABT_mutex_get_stats(g_mutex, &stats);
+    ABT_TEST_ERROR(ret, "ABT_mutex_get_stats");
+    ABT_test_printf(1, "locks: %llu, contended: %llu, spins: %llu, "
+                    "parks: %llu, hold: %.3e sec\n",
+                    (unsigned long long)stats.num_locks,
+                    (unsigned long long)stats.num_contended,
+                    (unsigned long long)stats.num_spins,
+                    (unsigned long long)stats.num_parks, stats.avg_hold_time);
+    assert(stats.num_locks == (uint64_t)expected);
+    assert(stats.num_contended <= stats.num_locks);
+    assert(stats.num_spins <= stats.num_contended);
+    assert(stats.avg_hold_time >= 0.0);
+
+    /* Slow holders raise the average hold time. */
+    run_threads(xstreams, num_xstreams, 1, slow_func);
+    expected += num_xstreams * NUM_SLOW_ITER;
+    assert(g_counter == expected);
+
+    ret = ABT_mutex_get_stats(g_mutex, &stats);
+    ABT_TEST_ERROR(ret, "ABT_mutex_get_stats");
+    ABT_test_printf(1, "hold after slow holders: %.3e sec\n",
+                    stats.avg_hold_time);
+    assert(stats.num_locks == (uint64_t)expected);
+    assert(stats.avg_hold_time > 1.0e-4);
+
+    ret = ABT_mutex_free(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_free");
+
+    /* Join Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(0);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,130 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_FILLERS     100
+#define PRIO_LOW                1
+#define PRIO_HIGH               2
+
+/* A low-priority holder yields while it holds a mutex and goes behind many
+ * low-priority fillers in an ABT_POOL_PRIO pool.  Then a high-priority waiter
+ * wants the mutex.  With priority inheritance, the holder has to be boosted
+ * ahead of the fillers; without it, it runs after all of them. */
+
+static ABT_pool g_pool;
+static ABT_mutex g_mutex;
+static int g_num_fillers;
+static int g_num_fillers_run;
+static int g_num_fillers_before_holder;
+static int g_num_done;
+
+static void filler_func(void *arg)
+{
+    g_num_fillers_run++;
+    g_num_done++;
+}
+
+static void waiter_func(void *arg)
+{
+    int ret;
+    ret = ABT_mutex_lock(g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_lock");
+    ret = ABT_mutex_unlock(g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_unlock");
+    g_num_done++;
+}
+
+static void create_thread(void (*func)(void *), int priority)
+{
+    ABT_thread_attr attr;
+    int ret;
+
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_priority(attr, priority);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_priority");
+    ret = ABT_thread_create(g_pool, func, NULL, attr, NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+}
+
+static void holder_func(void *arg)
+{
+    int i, ret;
+
+    ret = ABT_mutex_lock(g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_lock");
+    for (i = 0; i < g_num_fillers; i++) {
+        create_thread(filler_func, PRIO_LOW);
+    }
+    create_thread(waiter_func, PRIO_HIGH);
+    ABT_thread_yield();
+    g_num_fillers_before_holder = g_num_fillers_run;
+    ret = ABT_mutex_unlock(g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_unlock");
+    g_num_done++;
+}
+
+static int run(ABT_bool prio_inherit)
+{
+    ABT_mutex_attr attr;
+    int ret;
+
+    ret = ABT_mutex_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_mutex_attr_create");
+    ret = ABT_mutex_attr_set_prio_inherit(attr, prio_inherit);
+    ABT_TEST_ERROR(ret, "ABT_mutex_attr_set_prio_inherit");
+    ret = ABT_mutex_create_with_attr(attr, &g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create_with_attr");
+    ret = ABT_mutex_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_mutex_attr_free");
+
+    g_num_fillers_run = 0;
+    g_num_fillers_before_holder = -1;
+    g_num_done = 0;
+    create_thread(holder_func, PRIO_LOW);
+    while (g_num_done < g_num_fillers + 2) {
+        ABT_thread_yield();
+    }
+
+    ret = ABT_mutex_free(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_free");
+    ABT_test_printf(1, "prio_inherit=%d: %d fillers ran before the holder\n",
+                    prio_inherit, g_num_fillers_before_holder);
+    return g_num_fillers_before_holder;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    int ret;
+
+    g_num_fillers = DEFAULT_NUM_FILLERS;
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        g_num_fillers = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    /* All the ULTs run on the primary ES in one priority pool. */
+    ret = ABT_pool_create_basic(ABT_POOL_PRIO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &g_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstream, ABT_SCHED_DEFAULT, 1,
+                                           &g_pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+
+    assert(run(ABT_FALSE) == g_num_fillers);
+    assert(run(ABT_TRUE) == 0);
+
+    ret = ABT_test_finalize(0);
+    return ret;
+}
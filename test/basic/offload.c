@@ -0,0 +1,157 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <assert.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     16
+#define DEFAULT_NUM_ITER        4
+#define SLEEP_USEC              2000
+
+static int g_num_iter;
+static int g_num_calls = 0;
+static int g_num_errors = 0;
+static volatile int g_done = 0;
+
+/* A blocking call, which runs on a helper OS thread for ULTs */
+static void blocking_func(void *arg)
+{
+    int *p_value = (int *)arg;
+    usleep(SLEEP_USEC);
+    (*p_value)++;
+    __sync_fetch_and_add(&g_num_calls, 1);
+}
+
+static void thread_func(void *arg)
+{
+    int i, ret, value = 0;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_num_iter; i++) {
+        ret = ABT_offload(blocking_func, &value);
+        ABT_TEST_ERROR(ret, "ABT_offload");
+    }
+    if (value != g_num_iter) {
+        fprintf(stderr, "value is %d (expected %d)\n", value, g_num_iter);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+/* It keeps running on the same ES while the other ULTs are blocked. */
+static void ticker_func(void *arg)
+{
+    int *p_ticks = (int *)arg;
+    while (!g_done) {
+        (*p_ticks)++;
+        ABT_thread_yield();
+    }
+}
+
+/* Tasklets and external threads make the call by themselves. */
+static void task_func(void *arg)
+{
+    int ret = ABT_offload(blocking_func, arg);
+    ABT_TEST_ERROR(ret, "ABT_offload");
+}
+
+static void *ext_thread_func(void *arg)
+{
+    int ret = ABT_offload(blocking_func, arg);
+    ABT_TEST_ERROR(ret, "ABT_offload");
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads, ticker;
+    ABT_task task;
+    pthread_t ext_thread;
+    int i, ret, ticks = 0, task_value = 0, ext_value = 0, expected;
+
+    ABT_test_init(argc, argv);
+    g_num_iter = DEFAULT_NUM_ITER;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_thread_create(pools[num_xstreams - 1], ticker_func, &ticks,
+                            ABT_THREAD_ATTR_NULL, &ticker);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_task_create(pools[num_xstreams - 1], task_func, &task_value,
+                          &task);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    ret = pthread_create(&ext_thread, NULL, ext_thread_func, &ext_value);
+    assert(ret == 0);
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_task_free(&task);
+    ABT_TEST_ERROR(ret, "ABT_task_free");
+    ret = pthread_join(ext_thread, NULL);
+    assert(ret == 0);
+    g_done = 1;
+    ret = ABT_thread_free(&ticker);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    expected = num_threads * g_num_iter + 2;
+    if (g_num_calls != expected) {
+        fprintf(stderr, "%d calls (expected %d)\n", g_num_calls, expected);
+        g_num_errors++;
+    }
+    if (task_value != 1 || ext_value != 1) {
+        fprintf(stderr, "the tasklet or external thread failed\n");
+        g_num_errors++;
+    }
+    /* The ES of the ticker must not have been blocked by the calls. */
+    if (ticks < num_threads * g_num_iter / num_xstreams) {
+        fprintf(stderr, "the ticker ran only %d times\n", ticks);
+        g_num_errors++;
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ABT_test_finalize(g_num_errors);
+}
@@ -0,0 +1,285 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define NUM_ITERS               1000
+#define NUM_NOWAIT_LOOPS        20
+#define NUM_TASKS               100
+#define FIB_N                   15
+
+static int g_num_errors = 0;
+static int g_num_xstreams;
+static int g_counts[NUM_ITERS];
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+static void check_counts(int expected, const char *msg)
+{
+    int i;
+    for (i = 0; i < NUM_ITERS; i++) {
+        if (g_counts[i] != expected) {
+            fprintf(stderr, "%s: iteration %d ran %d times\n", msg, i,
+                    g_counts[i]);
+            g_num_errors++;
+            break;
+        }
+    }
+    memset(g_counts, 0, sizeof(g_counts));
+}
+
+static void check_xstreams(void)
+{
+    int num_xstreams;
+    ABT_xstream_get_num(&num_xstreams);
+    check(num_xstreams == g_num_xstreams, "the number of ESs has changed");
+}
+
+/* Team threads are ULTs on different ESs. */
+static void test_parallel(void)
+{
+    int ranks[DEFAULT_NUM_XSTREAMS];
+    int n = g_num_xstreams < DEFAULT_NUM_XSTREAMS ? g_num_xstreams
+                                                  : DEFAULT_NUM_XSTREAMS;
+    int i, j;
+
+#pragma omp parallel num_threads(n)
+    {
+        ABT_unit_type type;
+        int tid = omp_get_thread_num();
+        ABT_self_get_type(&type);
+        check(type == ABT_UNIT_TYPE_THREAD, "a team thread is not a ULT");
+        check(omp_get_num_threads() == n, "wrong team size");
+        check(omp_in_parallel() == (n > 1), "wrong active region");
+        check(omp_get_level() == 1, "wrong level");
+        ABT_xstream_self_rank(&ranks[tid]);
+    }
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < i; j++) {
+            check(ranks[i] != ranks[j], "team threads share an ES");
+        }
+    }
+    check(omp_in_parallel() == 0, "in a parallel region");
+    check(omp_get_num_threads() == 1, "wrong number of threads");
+    check_xstreams();
+}
+
+static void test_loops(void)
+{
+    int i, k;
+    double sum = 0.0;
+
+#pragma omp parallel
+    {
+#pragma omp for schedule(static)
+        for (i = 0; i < NUM_ITERS; i++) __sync_fetch_and_add(&g_counts[i], 1);
+#pragma omp for schedule(static, 7)
+        for (i = 0; i < NUM_ITERS; i++) __sync_fetch_and_add(&g_counts[i], 1);
+#pragma omp for schedule(dynamic, 3)
+        for (i = NUM_ITERS - 1; i >= 0; i--) {
+            __sync_fetch_and_add(&g_counts[i], 1);
+        }
+#pragma omp for schedule(guided, 2)
+        for (i = 0; i < NUM_ITERS; i++) __sync_fetch_and_add(&g_counts[i], 1);
+#pragma omp for schedule(runtime) reduction(+:sum)
+        for (i = 0; i < NUM_ITERS; i++) {
+            __sync_fetch_and_add(&g_counts[i], 1);
+            sum += i;
+        }
+    }
+    check_counts(5, "loops");
+    check(sum == (double)NUM_ITERS * (NUM_ITERS - 1) / 2, "wrong reduction");
+
+    /* More nowait loops than the states that a team keeps */
+#pragma omp parallel private(k)
+    {
+        for (k = 0; k < NUM_NOWAIT_LOOPS; k++) {
+#pragma omp for schedule(dynamic) nowait
+            for (i = 0; i < NUM_ITERS; i++) {
+                __sync_fetch_and_add(&g_counts[i], 1);
+            }
+        }
+    }
+    check_counts(NUM_NOWAIT_LOOPS, "nowait loops");
+
+#pragma omp parallel for schedule(dynamic, 5)
+    for (i = 0; i < NUM_ITERS; i += 2) __sync_fetch_and_add(&g_counts[i], 1);
+#pragma omp parallel for schedule(static)
+    for (i = 1; i < NUM_ITERS; i += 2) __sync_fetch_and_add(&g_counts[i], 1);
+    check_counts(1, "combined loops");
+}
+
+static void test_sync(void)
+{
+    int num_singles = 0, num_sections = 0, num_criticals = 0;
+    int num_named = 0, num_atomics = 0, num_locked = 0, copied = 0;
+    int num_threads = 0;
+    omp_lock_t lock;
+
+    omp_init_lock(&lock);
+#pragma omp parallel
+    {
+        int value;
+#pragma omp single
+        {
+            num_singles++;
+            num_threads = omp_get_num_threads();
+        }
+#pragma omp single copyprivate(value)
+        value = 42;
+        check(value == 42, "the single value is not copied");
+#pragma omp atomic
+        copied += (value == 42);
+#pragma omp critical
+        num_criticals++;
+#pragma omp critical(named)
+        num_named++;
+#pragma omp atomic
+        num_atomics++;
+        omp_set_lock(&lock);
+        num_locked++;
+        omp_unset_lock(&lock);
+#pragma omp sections
+        {
+#pragma omp section
+            __sync_fetch_and_add(&num_sections, 1);
+#pragma omp section
+            __sync_fetch_and_add(&num_sections, 1);
+#pragma omp section
+            __sync_fetch_and_add(&num_sections, 1);
+        }
+#pragma omp barrier
+#pragma omp master
+        check(num_sections == 3, "sections are not done at the barrier");
+    }
+    omp_destroy_lock(&lock);
+    check(num_singles == 1, "single ran more than once");
+    check(copied == num_threads, "wrong copyprivate");
+    check(num_criticals == num_threads, "wrong critical");
+    check(num_named == num_threads, "wrong named critical");
+    check(num_atomics == num_threads, "wrong atomic");
+    check(num_locked == num_threads, "wrong lock");
+    check(num_sections == 3, "wrong sections");
+}
+
+static int fib(int n)
+{
+    int a, b;
+    if (n < 2) return n;
+#pragma omp task shared(a)
+    a = fib(n - 1);
+#pragma omp task shared(b)
+    b = fib(n - 2);
+#pragma omp taskwait
+    return a + b;
+}
+
+static void test_tasks(void)
+{
+    int result = 0, num_done = 0, num_grouped = 0, i;
+
+#pragma omp parallel
+    {
+#pragma omp single
+        result = fib(FIB_N);
+
+        /* Tasks complete at the barrier. */
+#pragma omp single nowait
+        for (i = 0; i < NUM_TASKS; i++) {
+#pragma omp task
+            __sync_fetch_and_add(&num_done, 1);
+        }
+#pragma omp barrier
+        check(num_done == NUM_TASKS, "tasks are not done at the barrier");
+
+#pragma omp single
+        {
+#pragma omp taskgroup
+            {
+                for (i = 0; i < NUM_TASKS; i++) {
+#pragma omp task
+                    {
+                        /* A grandchild is also waited for. */
+#pragma omp task
+                        __sync_fetch_and_add(&num_grouped, 1);
+                    }
+                }
+            }
+            check(num_grouped == NUM_TASKS, "the task group is not done");
+#pragma omp task if(0)
+            num_grouped++;
+            check(num_grouped == NUM_TASKS + 1, "undeferred task");
+        }
+    }
+    check(result == 610, "wrong fib");
+    check(num_done == NUM_TASKS, "tasks are lost");
+}
+
+/* Nested regions run on the same ESs. */
+static void test_nested(void)
+{
+    int num_inner = 0;
+
+#pragma omp parallel num_threads(2)
+    {
+#pragma omp parallel num_threads(3)
+        {
+            check(omp_get_level() == 2, "wrong nested level");
+            check(omp_get_num_threads() == 3, "wrong nested team size");
+            __sync_fetch_and_add(&num_inner, 1);
+        }
+        check(omp_get_num_threads() == 2, "wrong outer team size");
+    }
+    check(num_inner == 6, "wrong number of inner threads");
+    check_xstreams();
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+    if (argc > 1) {
+        g_num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    }
+
+    /* The OpenMP runtime uses the ESs created here. */
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * g_num_xstreams);
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    check(omp_get_max_threads() == g_num_xstreams, "wrong max threads");
+
+    test_parallel();
+    test_loops();
+    test_sync();
+    test_tasks();
+    test_nested();
+
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+
+    return ABT_test_finalize(g_num_errors);
+}
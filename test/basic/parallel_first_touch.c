@@ -0,0 +1,123 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_ELEMS       100000
+#define PATTERN_OFFSET          3
+
+/* Memory from ABT_numa_alloc() has to be zero-filled after
+ * ABT_parallel_first_touch() with either policy, and a loop over the main
+ * pools of the same ESs has to be able to use it.  A first touch of memory
+ * that is not page-aligned and already holds data must not change it. */
+
+static void init_body(size_t begin, size_t end, void *arg)
+{
+    double *a = (double *)arg;
+    size_t i;
+    for (i = begin; i < end; i++) a[i] = (double)i;
+}
+
+static int check_zero(const double *a, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++) {
+        if (a[i] != 0.0) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    size_t num_elems = DEFAULT_NUM_ELEMS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    double *a;
+    char *buf;
+    size_t i, buf_len;
+    int p, ret, err = 0;
+    const int policies[2] = { ABT_FIRST_TOUCH_BLOCK, ABT_FIRST_TOUCH_CYCLIC };
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_elems = (size_t)ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0 && num_elems > 0);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < (size_t)num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < (size_t)num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (p = 0; p < 2; p++) {
+        ret = ABT_numa_alloc(num_elems * sizeof(double), (void **)&a);
+        ABT_TEST_ERROR(ret, "ABT_numa_alloc");
+        ret = ABT_parallel_first_touch(num_xstreams, xstreams, a,
+                                       num_elems * sizeof(double),
+                                       policies[p]);
+        ABT_TEST_ERROR(ret, "ABT_parallel_first_touch");
+        if (check_zero(a, num_elems)) {
+            fprintf(stderr, "policy %d: memory is not zero-filled\n", p);
+            err++;
+        }
+
+        ret = ABT_parallel_for(num_xstreams, pools, 0, num_elems, 1000,
+                               init_body, (void *)a);
+        ABT_TEST_ERROR(ret, "ABT_parallel_for");
+        for (i = 0; i < num_elems; i++) {
+            if (a[i] != (double)i) break;
+        }
+        if (i != num_elems) {
+            fprintf(stderr, "policy %d: a[%zu] = %f\n", p, i, a[i]);
+            err++;
+        }
+        ret = ABT_numa_free(a, num_elems * sizeof(double));
+        ABT_TEST_ERROR(ret, "ABT_numa_free");
+    }
+
+    /* A range that does not start or end at a page boundary */
+    buf_len = num_elems;
+    buf = (char *)malloc(buf_len + PATTERN_OFFSET);
+    for (i = 0; i < buf_len + PATTERN_OFFSET; i++) buf[i] = (char)(i % 127);
+    for (p = 0; p < 2; p++) {
+        ret = ABT_parallel_first_touch(num_xstreams, xstreams,
+                                       buf + PATTERN_OFFSET, buf_len,
+                                       policies[p]);
+        ABT_TEST_ERROR(ret, "ABT_parallel_first_touch");
+        for (i = 0; i < buf_len + PATTERN_OFFSET; i++) {
+            if (buf[i] != (char)(i % 127)) break;
+        }
+        if (i != buf_len + PATTERN_OFFSET) {
+            fprintf(stderr, "policy %d: data is changed at %zu\n", p, i);
+            err++;
+        }
+    }
+    free(buf);
+
+    for (i = 1; i < (size_t)num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(pools);
+    free(xstreams);
+
+    return ABT_test_finalize(err);
+}
@@ -0,0 +1,144 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_ITERS       10000
+
+typedef struct {
+    int *p_counts;
+    size_t grain;
+    int num_errors;
+} loop_arg_t;
+
+static void loop_body(size_t begin, size_t end, void *arg)
+{
+    loop_arg_t *p_arg = (loop_arg_t *)arg;
+    size_t i;
+
+    if (end <= begin || end - begin > p_arg->grain) {
+        __sync_fetch_and_add(&p_arg->num_errors, 1);
+    }
+    for (i = begin; i < end; i++) {
+        __sync_fetch_and_add(&p_arg->p_counts[i], 1);
+    }
+}
+
+static int run_loop(int num_pools, ABT_pool *pools, size_t begin, size_t end,
+                    size_t grain, int num_iters)
+{
+    loop_arg_t arg;
+    size_t i;
+    int ret, err = 0;
+
+    arg.p_counts = (int *)calloc(num_iters, sizeof(int));
+    arg.grain = (grain == 0) ? 1 : grain;
+    arg.num_errors = 0;
+
+    ret = ABT_parallel_for(num_pools, pools, begin, end, grain, loop_body,
+                           (void *)&arg);
+    ABT_TEST_ERROR(ret, "ABT_parallel_for");
+
+    /* Every iteration in [begin, end) has to be executed exactly once. */
+    for (i = 0; i < (size_t)num_iters; i++) {
+        int expected = (begin <= i && i < end) ? 1 : 0;
+        if (arg.p_counts[i] != expected) err++;
+    }
+    if (err || arg.num_errors) {
+        ABT_test_printf(0, "[%zu, %zu) grain %zu: %d wrong counts, "
+                        "%d wrong ranges\n", begin, end, grain, err,
+                        arg.num_errors);
+    }
+
+    free(arg.p_counts);
+    return err + arg.num_errors;
+}
+
+/* Loops are executed by work-stealing ESs with various grain sizes. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_iters = DEFAULT_NUM_ITERS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools, *my_pools;
+    int i, k, ret, err = 0;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_iters    = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0 && num_iters > 0);
+    ABT_test_printf(1, "# of ESs       : %d\n"
+                       "# of iterations: %d\n",
+                       num_xstreams, num_iters);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds   = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+
+    /* Create pools and work-stealing schedulers */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+
+    /* Create Execution Streams */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* Run loops */
+    err += run_loop(num_xstreams, pools, 0, num_iters, 1, num_iters);
+    err += run_loop(num_xstreams, pools, 0, num_iters, 0, num_iters);
+    err += run_loop(num_xstreams, pools, 0, num_iters, 37, num_iters);
+    err += run_loop(num_xstreams, pools, 5, num_iters - 3, 100, num_iters);
+    err += run_loop(num_xstreams, pools, 0, num_iters, num_iters, num_iters);
+    err += run_loop(1, pools, 0, num_iters, 16, num_iters);
+    err += run_loop(num_xstreams, pools, 0, 1, 16, num_iters);
+    err += run_loop(num_xstreams, pools, 3, 3, 16, num_iters);
+
+    /* Join and free Execution Streams */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Free pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(err);
+
+    free(xstreams);
+    free(scheds);
+    free(pools);
+    free(my_pools);
+
+    return ret;
+}
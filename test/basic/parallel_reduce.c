@@ -0,0 +1,197 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_ITERS       10000
+
+/* A sum and a maximum are reduced together, and prefix sums are scanned, by
+ * work-stealing ESs with various grain sizes. */
+
+typedef struct {
+    uint64_t sum;
+    uint64_t max;
+} result_t;
+
+static uint64_t value_of(size_t i)
+{
+    return (uint64_t)((i * 7919) % 1000);
+}
+
+static void reduce_body(size_t begin, size_t end, void *acc, void *arg)
+{
+    result_t *p_acc = (result_t *)acc;
+    size_t i;
+
+    ABT_TEST_UNUSED(arg);
+    for (i = begin; i < end; i++) {
+        uint64_t v = value_of(i);
+        p_acc->sum += v;
+        if (v > p_acc->max) p_acc->max = v;
+    }
+}
+
+static void reduce_combine(void *dst, const void *src, void *arg)
+{
+    result_t *p_dst = (result_t *)dst;
+    const result_t *p_src = (const result_t *)src;
+
+    ABT_TEST_UNUSED(arg);
+    p_dst->sum += p_src->sum;
+    if (p_src->max > p_dst->max) p_dst->max = p_src->max;
+}
+
+static void scan_body(size_t begin, size_t end, void *acc, ABT_bool final,
+                      void *arg)
+{
+    uint64_t *p_acc = (uint64_t *)acc;
+    uint64_t *p_out = (uint64_t *)arg;
+    size_t i;
+
+    for (i = begin; i < end; i++) {
+        *p_acc += value_of(i);
+        if (final == ABT_TRUE) p_out[i] = *p_acc;
+    }
+}
+
+static void scan_combine(void *dst, const void *src, void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    *(uint64_t *)dst += *(const uint64_t *)src;
+}
+
+static int run_reduce(int num_pools, ABT_pool *pools, size_t begin,
+                      size_t end, size_t grain)
+{
+    result_t identity = { 0, 0 }, result, expected = { 0, 0 };
+    size_t i;
+    int ret;
+
+    for (i = begin; i < end; i++) {
+        reduce_body(i, i + 1, &expected, NULL);
+    }
+    ret = ABT_parallel_reduce(num_pools, pools, begin, end, grain,
+                              sizeof(result_t), &identity, reduce_body,
+                              reduce_combine, NULL, &result);
+    ABT_TEST_ERROR(ret, "ABT_parallel_reduce");
+
+    if (result.sum != expected.sum || result.max != expected.max) {
+        ABT_test_printf(0, "reduce [%zu, %zu) grain %zu: sum %llu max %llu "
+                        "(expected %llu %llu)\n", begin, end, grain,
+                        (unsigned long long)result.sum,
+                        (unsigned long long)result.max,
+                        (unsigned long long)expected.sum,
+                        (unsigned long long)expected.max);
+        return 1;
+    }
+    return 0;
+}
+
+static int run_scan(int num_pools, ABT_pool *pools, size_t begin, size_t end,
+                    size_t grain, size_t num_iters)
+{
+    uint64_t identity = 0, total = 1, expected = 0;
+    uint64_t *p_out;
+    size_t i;
+    int ret, err = 0;
+
+    p_out = (uint64_t *)calloc(num_iters, sizeof(uint64_t));
+    ret = ABT_parallel_scan(num_pools, pools, begin, end, grain,
+                            sizeof(uint64_t), &identity, scan_body,
+                            scan_combine, (void *)p_out, &total);
+    ABT_TEST_ERROR(ret, "ABT_parallel_scan");
+
+    for (i = 0; i < num_iters; i++) {
+        if (begin <= i && i < end) {
+            expected += value_of(i);
+            if (p_out[i] != expected) err++;
+        } else if (p_out[i] != 0) {
+            err++;
+        }
+    }
+    if (total != expected) err++;
+    if (err) {
+        ABT_test_printf(0, "scan [%zu, %zu) grain %zu: %d errors\n", begin,
+                        end, grain, err);
+    }
+
+    free(p_out);
+    return err;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_iters = DEFAULT_NUM_ITERS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools, *my_pools;
+    int i, k, ret, err = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_iters    = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0 && num_iters > 0);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds   = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    err += run_reduce(num_xstreams, pools, 0, num_iters, 1);
+    err += run_reduce(num_xstreams, pools, 0, num_iters, 37);
+    err += run_reduce(num_xstreams, pools, 5, num_iters - 3, 100);
+    err += run_reduce(1, pools, 0, num_iters, num_iters);
+    err += run_reduce(num_xstreams, pools, 3, 3, 16);
+    err += run_scan(num_xstreams, pools, 0, num_iters, 1, num_iters);
+    err += run_scan(num_xstreams, pools, 0, num_iters, 37, num_iters);
+    err += run_scan(num_xstreams, pools, 5, num_iters - 3, 100, num_iters);
+    err += run_scan(1, pools, 0, num_iters, num_iters, num_iters);
+    err += run_scan(num_xstreams, pools, 3, 3, 16, num_iters);
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    ret = ABT_test_finalize(err);
+
+    free(xstreams);
+    free(scheds);
+    free(pools);
+    free(my_pools);
+
+    return ret;
+}
@@ -232,7 +232,8 @@ int main(int argc, char *argv[])
     ret_add_to_another_ES[0] = error;
     int temp00[5] = {success, success, success, error, error};
     ret_add_to_another_access[0] = temp00;
-    int temp01[2] = {error, error};
+    /* Other ESs push to the inbox of a private FIFO pool. */
+    int temp01[2] = {success, success};
     ret_push_from_another_pool[0] = temp01;
 
     /* ABT_POOL_ACCESS_SPSC */
@@ -0,0 +1,131 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     4000
+#define NUM_ROUNDS              5
+
+static int num_threads = DEFAULT_NUM_THREADS;
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Each round pushes a burst of ULTs to the deque of the ES running the
+ * spawner, which grows the deque while the other ESs steal from it.  The
+ * deque shrinks back as the burst drains, so every round grows it again. */
+static void spawner(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    ABT_xstream xstream;
+    ABT_pool pool;
+    int round, i, ret;
+
+    for (round = 0; round < NUM_ROUNDS; round++) {
+        ret = ABT_xstream_self(&xstream);
+        ABT_TEST_ERROR(ret, "ABT_xstream_self");
+        ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pool, thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        /* The other ESs run the burst.  The spawner does not yield since
+         * it would be pushed back to the deque it was stolen from. */
+        while (__sync_fetch_and_add(&g_counter, 0) < (round + 1) * num_threads)
+            ;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools, *my_pools;
+    ABT_pool_stats stats;
+    uint64_t num_resizes = 0;
+    int i, k, ret;
+
+    /* Initialize */
+    setenv("ABT_POOL_STATS", "1", 1);
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 1);
+    ABT_test_printf(1, "# of ESs  : %d\n"
+                       "# of ULTs : %d x %d\n",
+                       num_xstreams, num_threads, NUM_ROUNDS);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds   = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_DEQUE, ABT_POOL_ACCESS_SPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    /* Push the spawner before the pools get a producer ES */
+    ret = ABT_thread_create(pools[0], spawner, NULL, ABT_THREAD_ATTR_NULL,
+                            NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_info_query_pool_stats(pools[i], ABT_XSTREAM_ANY_RANK,
+                                        &stats);
+        ABT_TEST_ERROR(ret, "ABT_info_query_pool_stats");
+        num_resizes += stats.num_resizes;
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+    ABT_test_printf(1, "# of growths: %llu\n",
+                    (unsigned long long)num_resizes);
+    /* A deque that kept its size would grow only in the first round. */
+    if (num_threads >= 1024) assert(num_resizes >= NUM_ROUNDS);
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != NUM_ROUNDS * num_threads);
+
+    free(xstreams);
+    free(scheds);
+    free(pools);
+    free(my_pools);
+
+    return ret;
+}
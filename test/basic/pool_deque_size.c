@@ -0,0 +1,105 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     1000
+
+/* The size of a deque does not count the units removed from it, so a
+ * scheduler does not take a deque that holds only removed units for a
+ * non-empty one. */
+
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream xstream;
+    ABT_pool pool, deque;
+    ABT_thread *threads;
+    ABT_unit *units, unit;
+    size_t size;
+    int i, num_popped, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    units = (ABT_unit *)malloc(sizeof(ABT_unit) * num_threads);
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_pool_create_basic(ABT_POOL_DEQUE, ABT_POOL_ACCESS_SPMC,
+                                ABT_FALSE, &deque);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    /* Queue the ULTs in the deque, take their units, and queue them again */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(deque, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_pool_pop(deque, &units[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_pop");
+        assert(units[i] != ABT_UNIT_NULL);
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_pool_push(deque, units[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_push");
+    }
+
+    /* Remove every other unit */
+    for (i = 0; i < num_threads; i += 2) {
+        ret = ABT_pool_remove(deque, units[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_remove");
+    }
+    ret = ABT_pool_get_size(deque, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == (size_t)(num_threads / 2));
+
+    /* Only the remaining units are popped, and the size drops with them. */
+    num_popped = 0;
+    while (1) {
+        ret = ABT_pool_pop(deque, &unit);
+        ABT_TEST_ERROR(ret, "ABT_pool_pop");
+        if (unit == ABT_UNIT_NULL) break;
+        num_popped++;
+        ret = ABT_pool_get_size(deque, &size);
+        ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+        assert(size == (size_t)(num_threads / 2 - num_popped));
+    }
+    assert(num_popped == num_threads / 2);
+
+    /* Run all the ULTs in the main pool */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_unit_set_associated_pool(units[i], pool);
+        ABT_TEST_ERROR(ret, "ABT_unit_set_associated_pool");
+        ret = ABT_pool_push(pool, units[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_push");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_pool_free(&deque);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    ret = ABT_test_finalize(g_counter != num_threads);
+    free(units);
+    free(threads);
+    return ret;
+}
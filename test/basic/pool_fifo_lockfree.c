@@ -0,0 +1,117 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     2000    /* Larger than the internal ring */
+
+static int g_counter = 0;
+
+void thread_func(void *arg)
+{
+    ABT_test_printf(2, "[TH%lu]: running\n", (size_t)arg);
+    __sync_fetch_and_add(&g_counter, 1);
+    ABT_thread_yield();
+}
+
+/* Pop a unit, push it back, and remove it, which has to fail the second
+ * time.  The unit goes back to the ring if the overflow list is empty and to
+ * the overflow list otherwise. */
+void check_remove(ABT_pool pool, size_t size)
+{
+    ABT_unit unit;
+    size_t new_size;
+    int ret;
+
+    ret = ABT_pool_pop(pool, &unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_pop");
+    assert(unit != ABT_UNIT_NULL);
+    ret = ABT_pool_push(pool, unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+    ret = ABT_pool_remove(pool, unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_remove");
+    ret = ABT_pool_get_size(pool, &new_size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(new_size == size - 1);
+    ret = ABT_pool_remove(pool, unit);
+    assert(ret == ABT_ERR_POOL);
+    ret = ABT_pool_push(pool, unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+    int ret;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    if (argc > 1) num_xstreams = atoi(argv[1]);
+    assert(num_xstreams > 0);
+    if (argc > 2) num_threads = atoi(argv[2]);
+    assert(num_threads >= 0);
+
+    ABT_xstream *xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_thread *threads;
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    /* Create a shared lock-free pool */
+    ABT_pool pool;
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO_LOCKFREE, ABT_POOL_ACCESS_MPMC,
+                                ABT_TRUE, &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    /* Create ULTs before any ES consumes the pool */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, (void *)(size_t)i,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        if (i == 0) check_remove(pool, 1);
+    }
+
+    size_t size;
+    ret = ABT_pool_get_size(pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == (size_t)num_threads);
+
+    if (num_threads > 0) check_remove(pool, num_threads);
+
+    /* Create Execution Streams sharing the pool */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    /* Join and free Execution Streams.  They stop once the pool is drained,
+     * so all ULTs have terminated afterwards. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Free ULTs */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != num_threads);
+
+    free(threads);
+    free(xstreams);
+
+    return ret;
+}
@@ -0,0 +1,146 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+
+/* A private FIFO pool accepts units pushed by other ESs and by an external
+ * thread while its ES keeps pushing and popping, and all of them run on that
+ * ES. */
+
+static ABT_pool g_priv_pool;
+static ABT_xstream g_owner;
+static int g_num_threads = DEFAULT_NUM_THREADS;
+static int g_num_runs = 0;
+static int g_num_pushes = 0;
+static int g_num_wrong_es = 0;
+
+static void target_func(void *arg)
+{
+    ABT_xstream xstream;
+    ABT_xstream_self(&xstream);
+    if (xstream != g_owner) {
+        __atomic_fetch_add(&g_num_wrong_es, 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_fetch_add(&g_num_runs, 1, __ATOMIC_SEQ_CST);
+}
+
+static void push_threads(void)
+{
+    int i, ret;
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_create(g_priv_pool, target_func, NULL,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        if (ret != ABT_SUCCESS) continue;
+        __atomic_fetch_add(&g_num_pushes, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/* Runs on the owner ES, so its pushes go to the list of the pool. */
+static void local_func(void *arg)
+{
+    push_threads();
+}
+
+/* Runs on the other ESs */
+static void remote_func(void *arg)
+{
+    push_threads();
+    ABT_thread_yield();
+    push_threads();
+}
+
+static void *external_func(void *arg)
+{
+    /* This fails if external threads are not supported. */
+    push_threads();
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_pool pool;
+    ABT_thread *threads, local_thread;
+    pthread_t external;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    if (num_xstreams < 2) num_xstreams = 2;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams);
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                           &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams - 1; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    /* The last ES runs only the private pool. */
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_PRIV, ABT_TRUE,
+                                &g_priv_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &g_priv_pool,
+                                   ABT_SCHED_CONFIG_NULL,
+                                   &xstreams[num_xstreams - 1]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    g_owner = xstreams[num_xstreams - 1];
+
+    ret = ABT_thread_create(g_priv_pool, local_func, NULL,
+                            ABT_THREAD_ATTR_NULL, &local_thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = pthread_create(&external, NULL, external_func, NULL);
+    assert(ret == 0);
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_create(pool, remote_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    push_threads();
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = pthread_join(external, NULL);
+    assert(ret == 0);
+    ret = ABT_thread_free(&local_thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ABT_test_printf(1, "%d of %d pushed ULTs ran\n", g_num_runs,
+                    g_num_pushes);
+    assert(g_num_pushes >= g_num_threads * (2 * num_xstreams + 2));
+    ret = ABT_test_finalize(g_num_runs != g_num_pushes ||
+                            g_num_wrong_es != 0);
+    free(threads);
+    free(xstreams);
+    return ret;
+}
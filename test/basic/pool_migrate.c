@@ -0,0 +1,153 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     100
+
+static int g_counter = 0;
+static int g_num_callbacks = 0;
+static size_t g_num_cb_units = 0;
+
+void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+void migrate_cb(ABT_unit *units, size_t num_units, void *arg)
+{
+    ABT_TEST_UNUSED(units);
+    assert(arg == (void *)&g_num_callbacks);
+    g_num_callbacks++;
+    g_num_cb_units += num_units;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret, err = 0;
+    int num_threads = DEFAULT_NUM_THREADS;
+    size_t size, num;
+    ABT_pool src_pool, dst_pool, pool;
+    ABT_xstream xstream;
+    ABT_thread *threads;
+    ABT_task task;
+    ABT_unit *units;
+
+    if (argc > 1) num_threads = atoi(argv[1]);
+    assert(num_threads >= 2);
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    units = (ABT_unit *)malloc(sizeof(ABT_unit) * (num_threads + 1));
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_FALSE,
+                                &src_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_FALSE,
+                                &dst_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(src_pool, thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_task_create(src_pool, task_func, NULL, &task);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+
+    /* The first ULT stays in the source pool. */
+    ret = ABT_thread_set_migratable(threads[0], ABT_FALSE);
+    ABT_TEST_ERROR(ret, "ABT_thread_set_migratable");
+
+    ret = ABT_pool_migrate(src_pool, src_pool, units, num_threads + 1, &num,
+                           NULL, NULL);
+    assert(ret == ABT_ERR_MIGRATION_TARGET);
+
+    /* Move all at once */
+    ret = ABT_pool_migrate(src_pool, dst_pool, units, num_threads + 1, &num,
+                           migrate_cb, (void *)&g_num_callbacks);
+    ABT_TEST_ERROR(ret, "ABT_pool_migrate");
+    if (num != (size_t)num_threads || g_num_callbacks != 1 ||
+        g_num_cb_units != num) {
+        fprintf(stderr, "%zu units migrated, %d callbacks for %zu units\n",
+                num, g_num_callbacks, g_num_cb_units);
+        err++;
+    }
+
+    ret = ABT_pool_get_size(src_pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == 1);
+    ret = ABT_pool_get_size(dst_pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == (size_t)num_threads);
+
+    ret = ABT_thread_get_last_pool(threads[0], &pool);
+    ABT_TEST_ERROR(ret, "ABT_thread_get_last_pool");
+    assert(pool == src_pool);
+    ret = ABT_thread_get_last_pool(threads[1], &pool);
+    ABT_TEST_ERROR(ret, "ABT_thread_get_last_pool");
+    assert(pool == dst_pool);
+
+    /* Nothing is left to migrate, so the callback is not called. */
+    ret = ABT_pool_migrate(src_pool, dst_pool, units, num_threads + 1, &num,
+                           migrate_cb, (void *)&g_num_callbacks);
+    ABT_TEST_ERROR(ret, "ABT_pool_migrate");
+    assert(num == 0 && g_num_callbacks == 1);
+
+    /* Run the migrated units on a new ES */
+    ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &dst_pool,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    if (g_counter != num_threads) {
+        fprintf(stderr, "%d units run (expected %d)\n", g_counter,
+                num_threads);
+        err++;
+    }
+
+    /* Run the one left behind */
+    ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &src_pool,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_task_free(&task);
+    ABT_TEST_ERROR(ret, "ABT_task_free");
+    ret = ABT_pool_free(&src_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+    ret = ABT_pool_free(&dst_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    /* Finalize */
+    ret = ABT_test_finalize(err || g_counter != num_threads + 1);
+
+    free(units);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,112 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define NUM_QUEUES_ENV          "8"
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     2000
+#define NUM_YIELDS              4
+
+static int *g_num_runs;
+
+/* Each ULT yields a few times, so the ESs push it back to random sub-queues
+ * while the others pop from them. */
+void thread_func(void *arg)
+{
+    int i, idx = (int)(intptr_t)arg;
+    ABT_test_printf(2, "[TH%d]: running\n", idx);
+    for (i = 0; i < NUM_YIELDS; i++) {
+        ABT_thread_yield();
+    }
+    __sync_fetch_and_add(&g_num_runs[idx], 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret, err = 0;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_pool pool;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    ABT_unit unit;
+    size_t size;
+
+    if (argc > 1) num_xstreams = atoi(argv[1]);
+    assert(num_xstreams > 0);
+    if (argc > 2) num_threads = atoi(argv[2]);
+    assert(num_threads > 0);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    g_num_runs = (int *)calloc(num_threads, sizeof(int));
+
+    setenv("ABT_POOL_MULTIQ_NUM_QUEUES", NUM_QUEUES_ENV, 1);
+    ABT_test_init(argc, argv);
+
+    ret = ABT_pool_create_basic(ABT_POOL_MULTIQ, ABT_POOL_ACCESS_MPMC,
+                                ABT_TRUE, &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_pool_get_size(pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == (size_t)num_threads);
+
+    /* Remove a unit from whichever sub-queue holds it, and put it back */
+    ret = ABT_pool_pop(pool, &unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_pop");
+    assert(unit != ABT_UNIT_NULL);
+    ret = ABT_pool_push(pool, unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+    ret = ABT_pool_remove(pool, unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_remove");
+    ret = ABT_pool_remove(pool, unit);
+    assert(ret != ABT_SUCCESS);
+    ret = ABT_pool_get_size(pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == (size_t)num_threads - 1);
+    ret = ABT_pool_push(pool, unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+
+    /* ESs sharing the pool stop once it is drained. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        if (g_num_runs[i] != 1) {
+            fprintf(stderr, "ULT %d finished %d times\n", i, g_num_runs[i]);
+            err++;
+            break;
+        }
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    ret = ABT_test_finalize(err);
+
+    free(g_num_runs);
+    free(threads);
+    free(xstreams);
+
+    return ret;
+}
@@ -0,0 +1,155 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     1000
+#define NUM_PRIORITIES          16
+
+static int g_num_threads = DEFAULT_NUM_THREADS;
+static int *g_order;
+static int g_num_run = 0;
+
+static int get_priority(int idx)
+{
+    /* The tasklet has priority 0. */
+    if (idx == g_num_threads) return 0;
+    /* Spread over all levels, including the highest one */
+    return (idx * 7 % NUM_PRIORITIES) * (ABT_POOL_PRIO_NUM_LEVELS - 1)
+           / (NUM_PRIORITIES - 1);
+}
+
+void thread_func(void *arg)
+{
+    g_order[g_num_run++] = (int)(intptr_t)arg;
+}
+
+/* Units must come out in decreasing order of priority, and in the order of
+ * creation within a priority.  The tasklet (index num_threads) has priority 0
+ * and was created last. */
+static int check_order(int *order, int num)
+{
+    int i;
+    for (i = 1; i < num; i++) {
+        int prev = order[i - 1], cur = order[i];
+        int p_prev = get_priority(prev), p_cur = get_priority(cur);
+        if (p_prev < p_cur || (p_prev == p_cur && prev > cur)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret, err = 0;
+    int num_threads;
+    ABT_pool pool;
+    ABT_thread_attr attr;
+    ABT_thread *threads;
+    ABT_task task;
+    ABT_unit *units, unit;
+    ABT_xstream xstream;
+    size_t size;
+    int priority;
+
+    if (argc > 1) g_num_threads = atoi(argv[1]);
+    assert(g_num_threads > 0);
+    num_threads = g_num_threads;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    units = (ABT_unit *)malloc(sizeof(ABT_unit) * (num_threads + 1));
+    g_order = (int *)malloc(sizeof(int) * (num_threads + 1));
+
+    ABT_test_init(argc, argv);
+
+    ret = ABT_pool_create_basic(ABT_POOL_PRIO, ABT_POOL_ACCESS_MPMC,
+                                ABT_TRUE, &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    /* Priorities out of range are rejected. */
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_priority(attr, ABT_POOL_PRIO_NUM_LEVELS);
+    assert(ret == ABT_ERR_INV_THREAD_ATTR);
+    ret = ABT_thread_attr_set_priority(attr, -1);
+    assert(ret == ABT_ERR_INV_THREAD_ATTR);
+    ret = ABT_thread_attr_get_priority(attr, &priority);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_get_priority");
+    assert(priority == 0);
+
+    /* Create ULTs with various priorities and a tasklet */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_attr_set_priority(attr, get_priority(i));
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_set_priority");
+        ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i, attr,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_task_create(pool, thread_func, (void *)(intptr_t)num_threads,
+                          &task);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    /* Pop all units */
+    for (i = 0; i < num_threads + 1; i++) {
+        ret = ABT_pool_pop(pool, &units[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_pop");
+        assert(units[i] != ABT_UNIT_NULL);
+    }
+    ret = ABT_pool_get_size(pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == 0);
+
+    /* Push a unit and remove it */
+    ret = ABT_pool_push(pool, units[num_threads / 2]);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+    ret = ABT_pool_remove(pool, units[num_threads / 2]);
+    ABT_TEST_ERROR(ret, "ABT_pool_remove");
+    ret = ABT_pool_pop(pool, &unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_pop");
+    assert(unit == ABT_UNIT_NULL);
+
+    /* Push the units back in the order they were popped, which keeps the
+     * order of creation within each priority. */
+    for (i = 0; i < num_threads + 1; i++) {
+        ret = ABT_pool_push(pool, units[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_push");
+    }
+
+    /* Run them on a single ES and check the order of execution */
+    ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    assert(g_num_run == num_threads + 1);
+    if (check_order(g_order, num_threads + 1)) {
+        fprintf(stderr, "wrong order of execution\n");
+        err++;
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_task_free(&task);
+    ABT_TEST_ERROR(ret, "ABT_task_free");
+
+    ret = ABT_test_finalize(err);
+
+    free(g_order);
+    free(units);
+    free(threads);
+
+    return ret;
+}
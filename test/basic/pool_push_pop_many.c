@@ -0,0 +1,107 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     100
+#define BATCH_SIZE              16
+
+static int g_counter = 0;
+
+void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Create ULTs in a pool that no scheduler uses, move them in batches to a pool
+ * of a new ES, and let them run there. */
+static void test_kind(ABT_pool_kind kind, ABT_pool_access access,
+                      int num_threads)
+{
+    int i, ret;
+    size_t size, num, total = 0;
+    ABT_pool src_pool, dst_pool;
+    ABT_xstream xstream;
+    ABT_unit units[BATCH_SIZE];
+    ABT_thread *threads;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    ret = ABT_pool_create_basic(kind, access, ABT_TRUE, &src_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_pool_create_basic(kind, access, ABT_FALSE, &dst_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(src_pool, thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    do {
+        ret = ABT_pool_pop_many(src_pool, units, BATCH_SIZE, &num);
+        ABT_TEST_ERROR(ret, "ABT_pool_pop_many");
+        for (i = 0; i < (int)num; i++) {
+            ret = ABT_unit_set_associated_pool(units[i], dst_pool);
+            ABT_TEST_ERROR(ret, "ABT_unit_set_associated_pool");
+        }
+        ret = ABT_pool_push_many(dst_pool, units, num);
+        ABT_TEST_ERROR(ret, "ABT_pool_push_many");
+        total += num;
+    } while (num > 0);
+    assert(total == (size_t)num_threads);
+
+    ret = ABT_pool_get_size(src_pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == 0);
+    ret = ABT_pool_get_size(dst_pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == (size_t)num_threads);
+
+    /* The source pool is not used anymore. */
+    ret = ABT_pool_free(&src_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &dst_pool,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_pool_free(&dst_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    free(threads);
+}
+
+int main(int argc, char *argv[])
+{
+    int ret;
+    int num_threads = DEFAULT_NUM_THREADS;
+    if (argc > 1) num_threads = atoi(argv[1]);
+    assert(num_threads >= 0);
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    test_kind(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, num_threads);
+    test_kind(ABT_POOL_FIFO_LOCKFREE, ABT_POOL_ACCESS_MPMC, num_threads);
+    test_kind(ABT_POOL_DEQUE, ABT_POOL_ACCESS_SPMC, num_threads);
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != 3 * num_threads);
+
+    return ret;
+}
@@ -0,0 +1,147 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_TASKS       1024
+#define NUM_LOCAL_TASKS         16
+
+/* The descriptors of another process are simulated by an array, from which
+ * the steal function takes them one by one.  Randws schedulers have a remote
+ * pool as a victim besides their own pools, so every descriptor must run
+ * once as a tasklet.  Some tasklets are also created in the remote pool
+ * directly, and the errors of invalid descriptors are checked. */
+
+typedef struct {
+    int idx;
+    int check;
+} task_arg_t;
+
+static ABT_remote_desc *g_descs;
+static int g_num_descs;
+static int g_next = 0;
+static int g_num_done = 0;
+static int *g_counts;
+
+static void task_func(void *arg)
+{
+    task_arg_t *p_arg = (task_arg_t *)arg;
+    if (p_arg->check == p_arg->idx * 3 + 1) {
+        __atomic_fetch_add(&g_counts[p_arg->idx], 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_fetch_add(&g_num_done, 1, __ATOMIC_SEQ_CST);
+}
+
+static ABT_bool steal_fn(void *arg, ABT_remote_desc *desc)
+{
+    int idx = __atomic_fetch_add(&g_next, 1, __ATOMIC_SEQ_CST);
+    if (idx >= g_num_descs) return ABT_FALSE;
+    *desc = g_descs[idx];
+    return ABT_TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools;
+    ABT_pool remote, my_pools[2];
+    ABT_remote_desc desc;
+    task_arg_t arg;
+    int func_id, i, ret, num_errors = 0;
+    size_t size;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && num_tasks > 0);
+
+    ret = ABT_remote_func_register(task_func, &func_id);
+    ABT_TEST_ERROR(ret, "ABT_remote_func_register");
+
+    /* Invalid descriptors */
+    ret = ABT_remote_desc_set(&desc, func_id + 1, NULL, 0);
+    if (ret != ABT_ERR_INV_REMOTE_DESC) num_errors++;
+    ret = ABT_remote_desc_set(&desc, func_id, &arg, ABT_REMOTE_ARGS_SIZE + 1);
+    if (ret != ABT_ERR_INV_REMOTE_DESC) num_errors++;
+
+    g_num_descs = num_tasks;
+    g_descs = (ABT_remote_desc *)malloc(num_tasks * sizeof(ABT_remote_desc));
+    g_counts = (int *)calloc(num_tasks + NUM_LOCAL_TASKS, sizeof(int));
+    for (i = 0; i < num_tasks + NUM_LOCAL_TASKS; i++) {
+        arg.idx = i;
+        arg.check = i * 3 + 1;
+        ret = ABT_remote_desc_set(i < num_tasks ? &g_descs[i] : &desc,
+                                  func_id, &arg, sizeof(arg));
+        ABT_TEST_ERROR(ret, "ABT_remote_desc_set");
+    }
+
+    ret = ABT_pool_create_remote(steal_fn, NULL, ABT_FALSE, &remote);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_remote");
+    desc.func_id = func_id + 1;
+    ret = ABT_task_create_from_desc(remote, &desc, NULL);
+    if (ret != ABT_ERR_INV_REMOTE_DESC) num_errors++;
+    for (i = num_tasks; i < num_tasks + NUM_LOCAL_TASKS; i++) {
+        arg.idx = i;
+        arg.check = i * 3 + 1;
+        ret = ABT_remote_desc_set(&desc, func_id, &arg, sizeof(arg));
+        ABT_TEST_ERROR(ret, "ABT_remote_desc_set");
+        ret = ABT_task_create_from_desc(remote, &desc, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create_from_desc");
+    }
+    ret = ABT_pool_get_total_size(remote, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_total_size");
+    if (size != NUM_LOCAL_TASKS) num_errors++;
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+        my_pools[0] = pools[i];
+        my_pools[1] = remote;
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, 2, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    while (__atomic_load_n(&g_num_done, __ATOMIC_SEQ_CST) <
+           num_tasks + NUM_LOCAL_TASKS) {
+        ABT_thread_yield();
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_pool_free(&remote);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    for (i = 0; i < num_tasks + NUM_LOCAL_TASKS; i++) {
+        if (g_counts[i] != 1) num_errors++;
+    }
+
+    ret = ABT_test_finalize(num_errors);
+    free(pools);
+    free(scheds);
+    free(xstreams);
+    free(g_counts);
+    free(g_descs);
+    return ret;
+}
@@ -0,0 +1,151 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_TASKS       1024
+#define NUM_CLIENTS             4
+#define RING_CAPACITY           16
+
+/* Client ULTs on the primary ES push descriptors into a small ring, which
+ * stands for memory written by other processes, and retry while it is full.
+ * The other ESs pop the ring through its pool besides their own pools, so
+ * every descriptor must run once as a tasklet. */
+
+typedef struct {
+    int idx;
+} task_arg_t;
+
+static void *g_ring;
+static int g_func_id;
+static int g_num_tasks;
+static int g_num_done = 0;
+static int g_num_full = 0;
+static int *g_counts;
+
+static void task_func(void *arg)
+{
+    task_arg_t *p_arg = (task_arg_t *)arg;
+    __atomic_fetch_add(&g_counts[p_arg->idx], 1, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&g_num_done, 1, __ATOMIC_SEQ_CST);
+}
+
+static void client_func(void *arg)
+{
+    int client = (int)(intptr_t)arg;
+    ABT_remote_desc desc;
+    task_arg_t task_arg;
+    int i, ret;
+
+    for (i = client; i < g_num_tasks; i += NUM_CLIENTS) {
+        task_arg.idx = i;
+        ret = ABT_remote_desc_set(&desc, g_func_id, &task_arg,
+                                  sizeof(task_arg));
+        ABT_TEST_ERROR(ret, "ABT_remote_desc_set");
+        while ((ret = ABT_remote_ring_push(g_ring, &desc)) ==
+               ABT_ERR_POOL_FULL) {
+            __atomic_fetch_add(&g_num_full, 1, __ATOMIC_SEQ_CST);
+            ABT_thread_yield();
+        }
+        ABT_TEST_ERROR(ret, "ABT_remote_ring_push");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream xstream, *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools;
+    ABT_pool main_pool, ring_pool, my_pools[2];
+    ABT_thread clients[NUM_CLIENTS];
+    size_t size;
+    int i, ret, num_errors = 0;
+
+    ABT_test_init(argc, argv);
+    g_num_tasks = DEFAULT_NUM_TASKS;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && g_num_tasks > 0);
+
+    ret = ABT_remote_func_register(task_func, &g_func_id);
+    ABT_TEST_ERROR(ret, "ABT_remote_func_register");
+    ret = ABT_remote_ring_get_size(0, &size);
+    if (ret != ABT_ERR_INV_POOL) num_errors++;
+    ret = ABT_remote_ring_get_size(RING_CAPACITY, &size);
+    ABT_TEST_ERROR(ret, "ABT_remote_ring_get_size");
+    ret = posix_memalign(&g_ring, 64, size);
+    assert(ret == 0);
+    ret = ABT_remote_ring_init(g_ring, RING_CAPACITY);
+    ABT_TEST_ERROR(ret, "ABT_remote_ring_init");
+    ret = ABT_pool_create_remote_ring(g_ring, ABT_FALSE, &ring_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_remote_ring");
+    g_counts = (int *)calloc(g_num_tasks, sizeof(int));
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+        my_pools[0] = pools[i];
+        my_pools[1] = ring_pool;
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, 2, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &main_pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    for (i = 0; i < NUM_CLIENTS; i++) {
+        ret = ABT_thread_create(main_pool, client_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &clients[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    for (i = 0; i < NUM_CLIENTS; i++) {
+        ret = ABT_thread_free(&clients[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    while (__atomic_load_n(&g_num_done, __ATOMIC_SEQ_CST) < g_num_tasks) {
+        ABT_thread_yield();
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_pool_free(&ring_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    for (i = 0; i < g_num_tasks; i++) {
+        if (g_counts[i] != 1) num_errors++;
+    }
+    ABT_test_printf(1, "%d tasks, %d pushes to a full ring\n", g_num_tasks,
+                    g_num_full);
+
+    ret = ABT_test_finalize(num_errors);
+    free(pools);
+    free(scheds);
+    free(xstreams);
+    free(g_counts);
+    free(g_ring);
+    return ret;
+}
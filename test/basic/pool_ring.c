@@ -0,0 +1,131 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* Rounded up to 64 */
+#define RING_CAPACITY_ENV       "60"
+#define RING_CAPACITY           64
+#define DEFAULT_NUM_TASKS       10000
+
+static int *g_order;
+static int g_num_run = 0;
+
+void task_func(void *arg)
+{
+    g_order[g_num_run++] = (int)(intptr_t)arg;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret, err = 0;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    int num_total;
+    ABT_pool ring, fifo;
+    ABT_task tasks[RING_CAPACITY + 1];
+    ABT_unit first, extra, unit;
+    ABT_xstream xstream;
+    size_t size;
+
+    if (argc > 1) num_tasks = atoi(argv[1]);
+    assert(num_tasks >= 0);
+    num_total = RING_CAPACITY + 1 + num_tasks;
+    g_order = (int *)malloc(sizeof(int) * num_total);
+
+    setenv("ABT_POOL_RING_CAPACITY", RING_CAPACITY_ENV, 1);
+    ABT_test_init(argc, argv);
+
+    ret = ABT_pool_create_basic(ABT_POOL_RING, ABT_POOL_ACCESS_SPSC, ABT_TRUE,
+                                &ring);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPSC, ABT_FALSE,
+                                &fifo);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    /* Fill the ring */
+    for (i = 0; i < RING_CAPACITY; i++) {
+        ret = ABT_task_create(ring, task_func, (void *)(intptr_t)i, &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    ret = ABT_pool_get_size(ring, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == RING_CAPACITY);
+
+    /* Take a unit created in another pool */
+    ret = ABT_task_create(fifo, task_func, (void *)(intptr_t)RING_CAPACITY,
+                          &tasks[RING_CAPACITY]);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    ret = ABT_pool_pop(fifo, &extra);
+    ABT_TEST_ERROR(ret, "ABT_pool_pop");
+    assert(extra != ABT_UNIT_NULL);
+
+    /* A full ring rejects it until a unit is popped. */
+    ret = ABT_pool_try_push(ring, extra);
+    assert(ret == ABT_ERR_POOL_FULL);
+    ret = ABT_pool_pop(ring, &first);
+    ABT_TEST_ERROR(ret, "ABT_pool_pop");
+    assert(first != ABT_UNIT_NULL);
+    ret = ABT_pool_try_push(ring, extra);
+    ABT_TEST_ERROR(ret, "ABT_pool_try_push");
+
+    /* A removed unit is skipped. */
+    ret = ABT_pool_remove(ring, extra);
+    ABT_TEST_ERROR(ret, "ABT_pool_remove");
+
+    /* The consumer ES drains the ring while the pushes below wait for room:
+     * tasks 1..63, 0, the extra one, and then the others in order. */
+    ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &ring,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    ret = ABT_pool_push(ring, first);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+    ret = ABT_pool_push(ring, extra);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(ring, task_func,
+                              (void *)(intptr_t)(RING_CAPACITY + 1 + i), NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    ret = ABT_pool_pop(fifo, &unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_pop");
+    assert(unit == ABT_UNIT_NULL);
+
+    if (g_num_run != num_total) {
+        fprintf(stderr, "%d tasks run (expected %d)\n", g_num_run, num_total);
+        err++;
+    } else {
+        for (i = 0; i < num_total; i++) {
+            int expected = (i < RING_CAPACITY - 1) ? i + 1
+                         : (i == RING_CAPACITY - 1) ? 0 : i;
+            if (g_order[i] != expected) {
+                fprintf(stderr, "task %d run at %d\n", g_order[i], i);
+                err++;
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < RING_CAPACITY + 1; i++) {
+        ret = ABT_task_free(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+    ret = ABT_pool_free(&fifo);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    ret = ABT_test_finalize(err);
+
+    free(g_order);
+
+    return ret;
+}
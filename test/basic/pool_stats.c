@@ -0,0 +1,158 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     1000
+
+/* ULTs are created in the first pool of a set of FIFO pools and of a set of
+ * deque pools, and the counters of that pool have to account for all of them.
+ * By default, the deque pool is filled beyond its initial size of 256 units
+ * so that it grows. */
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+static void check_stats(ABT_pool pool, int num_xstreams, int num_threads,
+                        int is_deque)
+{
+    ABT_pool_stats total, es;
+    uint64_t sum_pushes = 0, sum_pops = 0;
+    int i, ret;
+
+    ret = ABT_info_query_pool_stats(pool, ABT_XSTREAM_ANY_RANK, &total);
+    ABT_TEST_ERROR(ret, "ABT_info_query_pool_stats");
+    ABT_test_printf(1, "pushes %llu pops %llu empty %llu waits %llu "
+                    "resizes %llu steals %llu/%llu\n",
+                    (unsigned long long)total.num_pushes,
+                    (unsigned long long)total.num_pops,
+                    (unsigned long long)total.num_empty_pops,
+                    (unsigned long long)total.num_lock_waits,
+                    (unsigned long long)total.num_resizes,
+                    (unsigned long long)total.num_steals,
+                    (unsigned long long)total.num_steal_attempts);
+    assert(total.num_pushes >= (uint64_t)num_threads);
+    assert(total.num_pops + total.num_steals >= (uint64_t)num_threads);
+    assert(total.num_steals <= total.num_steal_attempts);
+    if (is_deque && num_threads > 256) assert(total.num_resizes > 0);
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_info_query_pool_stats(pool, i, &es);
+        ABT_TEST_ERROR(ret, "ABT_info_query_pool_stats");
+        sum_pushes += es.num_pushes;
+        sum_pops += es.num_pops;
+    }
+    assert(sum_pushes <= total.num_pushes && sum_pops <= total.num_pops);
+
+    ret = ABT_info_query_pool_stats(pool, -2, &es);
+    assert(ret == ABT_ERR_INV_XSTREAM_RANK);
+
+    ret = ABT_info_reset_pool_stats(pool);
+    ABT_TEST_ERROR(ret, "ABT_info_reset_pool_stats");
+    ret = ABT_info_query_pool_stats(pool, ABT_XSTREAM_ANY_RANK, &total);
+    ABT_TEST_ERROR(ret, "ABT_info_query_pool_stats");
+    assert(total.num_pushes == 0 && total.num_pops == 0);
+}
+
+static void run(ABT_pool_kind kind, int num_xstreams, int num_threads)
+{
+    ABT_pool_access access;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools, *my_pools;
+    ABT_thread *threads;
+    char *buf;
+    size_t size;
+    FILE *fp;
+    int i, k, ret;
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    scheds = (ABT_sched *)malloc(sizeof(ABT_sched) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    my_pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    /* A deque pool is popped only by its own ES and stolen from by others. */
+    access = (kind == ABT_POOL_DEQUE) ? ABT_POOL_ACCESS_SPMC
+                                      : ABT_POOL_ACCESS_MPMC;
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(kind, access, ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* The ULTs are queued in the first pool before any ES runs them. */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[0], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    fp = open_memstream(&buf, &size);
+    assert(fp != NULL);
+    ret = ABT_info_print_pool(fp, pools[0]);
+    ABT_TEST_ERROR(ret, "ABT_info_print_pool");
+    fclose(fp);
+    ABT_test_printf(1, "%s", buf);
+    assert(strstr(buf, "ops (total)") != NULL);
+    free(buf);
+    check_stats(pools[0], num_xstreams, num_threads, kind == ABT_POOL_DEQUE);
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    free(xstreams);
+    free(scheds);
+    free(pools);
+    free(my_pools);
+    free(threads);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+
+    setenv("ABT_POOL_STATS", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    run(ABT_POOL_FIFO, num_xstreams, num_threads);
+    run(ABT_POOL_DEQUE, num_xstreams, num_threads);
+
+    return ABT_test_finalize(0);
+}
@@ -0,0 +1,221 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     100
+#define NUM_YIELDS              5
+
+/* A user-defined FIFO pool with intrusive units: units are linked through
+ * ABT_unit_links, so the pool never allocates memory. */
+
+typedef struct {
+    volatile int lock;
+    size_t num_units;
+    ABT_unit_links *p_head;
+    ABT_unit_links *p_tail;
+} pool_data_t;
+
+static int g_counter = 0;
+
+static void pool_lock(pool_data_t *p_data)
+{
+    while (__sync_lock_test_and_set(&p_data->lock, 1)) {
+        while (p_data->lock);
+    }
+}
+
+static void pool_unlock(pool_data_t *p_data)
+{
+    __sync_lock_release(&p_data->lock);
+}
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABT_TEST_UNUSED(config);
+    pool_data_t *p_data = (pool_data_t *)calloc(1, sizeof(pool_data_t));
+    return ABT_pool_set_data(pool, p_data);
+}
+
+static int pool_free(ABT_pool pool)
+{
+    pool_data_t *p_data;
+    ABT_pool_get_data(pool, (void **)&p_data);
+    free(p_data);
+    return ABT_SUCCESS;
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    pool_data_t *p_data;
+    ABT_pool_get_data(pool, (void **)&p_data);
+    return p_data->num_units;
+}
+
+static void pool_push(ABT_pool pool, ABT_unit unit)
+{
+    pool_data_t *p_data;
+    ABT_unit_links *p_links = (ABT_unit_links *)unit;
+    ABT_pool_get_data(pool, (void **)&p_data);
+
+    pool_lock(p_data);
+    p_links->p_next = NULL;
+    p_links->p_prev = p_data->p_tail;
+    if (p_data->p_tail) {
+        p_data->p_tail->p_next = p_links;
+    } else {
+        p_data->p_head = p_links;
+    }
+    p_data->p_tail = p_links;
+    p_data->num_units++;
+    pool_unlock(p_data);
+}
+
+static void pool_unlink(pool_data_t *p_data, ABT_unit_links *p_links)
+{
+    if (p_links->p_prev) {
+        p_links->p_prev->p_next = p_links->p_next;
+    } else {
+        p_data->p_head = p_links->p_next;
+    }
+    if (p_links->p_next) {
+        p_links->p_next->p_prev = p_links->p_prev;
+    } else {
+        p_data->p_tail = p_links->p_prev;
+    }
+    p_data->num_units--;
+}
+
+static ABT_unit pool_pop(ABT_pool pool)
+{
+    pool_data_t *p_data;
+    ABT_unit_links *p_links;
+    ABT_pool_get_data(pool, (void **)&p_data);
+
+    if (p_data->num_units == 0) return ABT_UNIT_NULL;
+    pool_lock(p_data);
+    p_links = p_data->p_head;
+    if (p_links) pool_unlink(p_data, p_links);
+    pool_unlock(p_data);
+    return p_links ? (ABT_unit)p_links : ABT_UNIT_NULL;
+}
+
+static int pool_remove(ABT_pool pool, ABT_unit unit)
+{
+    pool_data_t *p_data;
+    ABT_pool_get_data(pool, (void **)&p_data);
+
+    pool_lock(p_data);
+    pool_unlink(p_data, (ABT_unit_links *)unit);
+    pool_unlock(p_data);
+    return ABT_SUCCESS;
+}
+
+static void thread_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < NUM_YIELDS; i++) {
+        ABT_thread_yield();
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_pool_def def;
+    ABT_pool pool;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    ABT_task *tasks;
+    ABT_unit unit;
+    size_t size;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    tasks = (ABT_task *)malloc(sizeof(ABT_task) * num_threads);
+
+    def.access     = ABT_POOL_ACCESS_MPMC;
+    def.p_init     = pool_init;
+    def.p_free     = pool_free;
+    def.p_get_size = pool_get_size;
+    def.p_push     = pool_push;
+    def.p_pop      = pool_pop;
+    def.p_remove   = pool_remove;
+    ret = ABT_pool_def_set_intrusive_units(&def);
+    ABT_TEST_ERROR(ret, "ABT_pool_def_set_intrusive_units");
+    ret = ABT_pool_create(&def, ABT_POOL_CONFIG_NULL, &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create");
+
+    /* The runtime creates the units without calling the pool, and tracks
+     * whether they are in the pool. */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_task_create(pool, task_func, NULL, &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    ret = ABT_pool_get_size(pool, &size);
+    ABT_TEST_ERROR(ret, "ABT_pool_get_size");
+    assert(size == (size_t)(2 * num_threads));
+    ret = ABT_pool_pop(pool, &unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_pop");
+    assert(def.u_get_type(unit) == ABT_UNIT_TYPE_THREAD);
+    assert(def.u_is_in_pool(unit) == ABT_FALSE);
+    ret = ABT_pool_push(pool, unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+    assert(def.u_is_in_pool(unit) == ABT_TRUE);
+
+    for (i = 0; i < num_xstreams; i++) {
+        ABT_sched sched;
+        ret = ABT_sched_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                     ABT_SCHED_CONFIG_NULL, &sched);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(sched, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+        ret = ABT_task_free(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_pool_free(&pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    ret = ABT_test_finalize(g_counter != 2 * num_threads);
+
+    free(xstreams);
+    free(threads);
+    free(tasks);
+    return ret;
+}
@@ -0,0 +1,116 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     4
+
+/* The ULTs spin long enough to be sampled several times, and the profile
+ * written by ABT_info_print_profile() names the function they run. */
+
+static volatile double g_sink = 0.0;
+
+static void busy_func(void *arg)
+{
+    double start = ABT_get_wtime();
+    double x = 0.0;
+    ABT_TEST_UNUSED(arg);
+
+    /* 50 ms, which is much longer than the sampling interval */
+    while (ABT_get_wtime() - start < 0.05) {
+        int i;
+        for (i = 0; i < 1000; i++) x += (double)i * 0.5;
+    }
+    g_sink += x;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    char addr[64], *buf, *line;
+    size_t size, len;
+    FILE *fp;
+    int num_funcs = 0, found = 0;
+    int i, ret;
+
+    setenv("ABT_PROFILE_INTERVAL", "1000", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], busy_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    fp = open_memstream(&buf, &size);
+    assert(fp != NULL);
+    ret = ABT_info_print_profile(fp);
+    ABT_TEST_ERROR(ret, "ABT_info_print_profile");
+    fclose(fp);
+    ABT_test_printf(1, "%s", buf);
+
+    /* Sampling is not available everywhere, and ULT functions are unknown
+     * with ucontext, so only check the function if a ULT function was
+     * sampled. */
+    sprintf(addr, "%p", (void *)busy_func);
+    len = strlen(addr);
+    for (line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+        char *p_func;
+        if (strstr(line, " ULT ") == NULL) continue;
+        p_func = strstr(line, "0x");
+        if (p_func == NULL) continue;
+        num_funcs++;
+        if (strncmp(p_func, addr, len) == 0 &&
+            (p_func[len] == ' ' || p_func[len] == '\0')) {
+            found = 1;
+        }
+    }
+    ABT_test_printf(1, "ULT functions: %d, found: %d\n", num_funcs, found);
+    assert(num_funcs == 0 || found);
+    free(buf);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ABT_test_finalize(0);
+}
@@ -0,0 +1,213 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define NUM_READS               2000
+#define NUM_UPDATES             200
+#define LIVE                    0x1234
+#define DEAD                    0xdead
+
+/* Readers on all ESs read a shared object while writers replace it and mark
+ * the old one as dead after ABT_rcu_synchronize() or in an ABT_rcu_call()
+ * callback.  No reader may see a dead object.  The objects are freed at the
+ * end, so reading a dead one is not undefined. */
+
+typedef struct obj {
+    volatile int magic;
+    struct obj *p_next;         /* For freeing */
+} obj_t;
+
+static obj_t *volatile g_ptr;
+static obj_t *g_all = NULL;
+static ABT_mutex g_all_mutex;
+static int g_num_errors = 0;
+static int g_num_calls = 0;
+static int g_num_callbacks = 0;
+static int g_external_done = 0;
+
+static obj_t *obj_new(void)
+{
+    int ret;
+    obj_t *p_obj = (obj_t *)malloc(sizeof(obj_t));
+    p_obj->magic = LIVE;
+    ret = ABT_mutex_lock(g_all_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_lock");
+    p_obj->p_next = g_all;
+    g_all = p_obj;
+    ret = ABT_mutex_unlock(g_all_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_unlock");
+    return p_obj;
+}
+
+static void kill_obj(void *arg)
+{
+    ((obj_t *)arg)->magic = DEAD;
+    __atomic_fetch_add(&g_num_callbacks, 1, __ATOMIC_SEQ_CST);
+}
+
+static void reader_func(void *arg)
+{
+    int i, j, ret;
+    for (i = 0; i < NUM_READS; i++) {
+        ret = ABT_rcu_read_lock();
+        ABT_TEST_ERROR(ret, "ABT_rcu_read_lock");
+        obj_t *p_obj = g_ptr;
+        for (j = 0; j < 100; j++) {
+            if (p_obj->magic != LIVE) {
+                __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_SEQ_CST);
+                break;
+            }
+        }
+        ret = ABT_rcu_read_unlock();
+        ABT_TEST_ERROR(ret, "ABT_rcu_read_unlock");
+        ABT_thread_yield();
+    }
+}
+
+static void sync_writer_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < NUM_UPDATES; i++) {
+        obj_t *p_old = __atomic_exchange_n(&g_ptr, obj_new(),
+                                           __ATOMIC_SEQ_CST);
+        ret = ABT_rcu_synchronize();
+        ABT_TEST_ERROR(ret, "ABT_rcu_synchronize");
+        p_old->magic = DEAD;
+    }
+}
+
+static void call_writer_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < NUM_UPDATES; i++) {
+        obj_t *p_old = __atomic_exchange_n(&g_ptr, obj_new(),
+                                           __ATOMIC_SEQ_CST);
+        ret = ABT_rcu_call(kill_obj, p_old);
+        ABT_TEST_ERROR(ret, "ABT_rcu_call");
+        __atomic_fetch_add(&g_num_calls, 1, __ATOMIC_SEQ_CST);
+        ABT_thread_yield();
+    }
+}
+
+static void *external_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < NUM_UPDATES / 10; i++) {
+        obj_t *p_old = __atomic_exchange_n(&g_ptr, obj_new(),
+                                           __ATOMIC_SEQ_CST);
+        /* This fails if external threads are not supported. */
+        ret = ABT_rcu_synchronize();
+        if (ret != ABT_SUCCESS) break;
+        p_old->magic = DEAD;
+    }
+    __atomic_store_n(&g_external_done, 1, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    pthread_t external;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * (num_threads + 2));
+
+    /* Not in a critical section */
+    ret = ABT_rcu_read_unlock();
+    assert(ret == ABT_ERR_RCU);
+    ret = ABT_rcu_read_lock();
+    ABT_TEST_ERROR(ret, "ABT_rcu_read_lock");
+    ret = ABT_rcu_synchronize();
+    assert(ret == ABT_ERR_RCU);
+    ret = ABT_rcu_read_unlock();
+    ABT_TEST_ERROR(ret, "ABT_rcu_read_unlock");
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    /* The mutex is created after the ESs, which it needs to know. */
+    ret = ABT_mutex_create(&g_all_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create");
+    g_ptr = obj_new();
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], reader_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_create(pools[1 % num_xstreams], sync_writer_func, NULL,
+                            ABT_THREAD_ATTR_NULL, &threads[num_threads]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_create(pools[(num_xstreams - 1)], call_writer_func, NULL,
+                            ABT_THREAD_ATTR_NULL, &threads[num_threads + 1]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = pthread_create(&external, NULL, external_func, NULL);
+    assert(ret == 0);
+
+    for (i = 0; i < num_threads + 2; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    /* Blocking this ES in pthread_join() would stall the grace periods that
+     * the external thread waits for. */
+    while (!__atomic_load_n(&g_external_done, __ATOMIC_SEQ_CST)) {
+        ABT_thread_yield();
+    }
+    ret = pthread_join(external, NULL);
+    assert(ret == 0);
+
+    /* The schedulers call the callbacks while they check events. */
+    while (__atomic_load_n(&g_num_callbacks, __ATOMIC_SEQ_CST) < g_num_calls) {
+        ABT_thread_yield();
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ABT_test_printf(1, "%d errors, %d of %d callbacks\n", g_num_errors,
+                    g_num_callbacks, g_num_calls);
+    ret = ABT_mutex_free(&g_all_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_free");
+    ret = ABT_test_finalize(g_num_errors != 0 ||
+                            g_num_callbacks != NUM_UPDATES);
+    while (g_all != NULL) {
+        obj_t *p_next = g_all->p_next;
+        free(g_all);
+        g_all = p_next;
+    }
+    free(threads);
+    free(pools);
+    free(xstreams);
+    return ret;
+}
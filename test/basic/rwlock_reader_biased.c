@@ -0,0 +1,136 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define DEFAULT_NUM_ITERS       500
+
+static ABT_rwlock g_rwlock;
+static int g_num_readers = 0;
+static int g_num_writers = 0;
+static int g_value = 0;
+static int g_num_errors = 0;
+static int g_num_iters = DEFAULT_NUM_ITERS;
+
+/* Every fourth ULT is a writer; the others are readers. */
+static void thread_func(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    int i, ret;
+
+    for (i = 0; i < g_num_iters; i++) {
+        if (id % 4 == 0) {
+            ret = ABT_rwlock_wrlock(g_rwlock);
+            ABT_TEST_ERROR(ret, "ABT_rwlock_wrlock");
+            if (__sync_fetch_and_add(&g_num_writers, 1) != 0 ||
+                __sync_fetch_and_add(&g_num_readers, 0) != 0) {
+                __sync_fetch_and_add(&g_num_errors, 1);
+            }
+            g_value++;
+            ABT_thread_yield();
+            __sync_fetch_and_sub(&g_num_writers, 1);
+        } else {
+            ret = ABT_rwlock_rdlock(g_rwlock);
+            ABT_TEST_ERROR(ret, "ABT_rwlock_rdlock");
+            __sync_fetch_and_add(&g_num_readers, 1);
+            if (__sync_fetch_and_add(&g_num_writers, 0) != 0) {
+                __sync_fetch_and_add(&g_num_errors, 1);
+            }
+            ABT_thread_yield();
+            __sync_fetch_and_sub(&g_num_readers, 1);
+        }
+        ret = ABT_rwlock_unlock(g_rwlock);
+        ABT_TEST_ERROR(ret, "ABT_rwlock_unlock");
+    }
+}
+
+/* Readers and writers of a reader-biased rwlock must exclude each other. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_writers;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int i, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iters  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs       : %d\n"
+                       "# of ULTs/ES   : %d\n"
+                       "# of iterations: %d\n",
+                       num_xstreams, num_threads, g_num_iters);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_xstreams * num_threads *
+                                    sizeof(ABT_thread));
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* The rwlock is created after the ESs since its internal mutex has a
+     * queue for each ES. */
+    ret = ABT_rwlock_create_reader_biased(&g_rwlock);
+    ABT_TEST_ERROR(ret, "ABT_rwlock_create_reader_biased");
+
+    /* Create ULTs */
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    /* Join and free ULTs */
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_rwlock_free(&g_rwlock);
+    ABT_TEST_ERROR(ret, "ABT_rwlock_free");
+
+    /* Finalize */
+    num_writers = (num_xstreams * num_threads + 3) / 4;
+    ret = ABT_test_finalize(g_num_errors != 0 ||
+                            g_value != num_writers * g_num_iters);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,80 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_TASKS       100
+
+/* With ABT_SCHED_AUTOTUNE, a scheduler running short tasklets measures its
+ * event checks and keeps its event frequency and sleep time in range. */
+
+static int g_num_done = 0;
+
+static void task_func(void *arg)
+{
+    double start = ABT_get_wtime();
+    while (ABT_get_wtime() - start < 1.0e-6) ;
+    __sync_fetch_and_add(&g_num_done, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_tasks = DEFAULT_NUM_TASKS;
+    int num_created = 0;
+    ABT_xstream xstream;
+    ABT_sched sched;
+    ABT_pool pool;
+    ABT_sched_tuning tuning;
+    int i, ret;
+
+    setenv("ABT_SCHED_AUTOTUNE", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_xstream_get_main_sched(xstream, &sched);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_sched");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* Keep the ES busy until at least one tuning window has ended. */
+    do {
+        for (i = 0; i < num_tasks; i++) {
+            ret = ABT_task_create(pool, task_func, NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_task_create");
+        }
+        num_created += num_tasks;
+        while (__sync_fetch_and_add(&g_num_done, 0) < num_created) {
+            ABT_thread_yield();
+        }
+        ret = ABT_info_query_sched_tuning(sched, &tuning);
+        ABT_TEST_ERROR(ret, "ABT_info_query_sched_tuning");
+    } while (tuning.check_cost == 0.0);
+
+    ABT_test_printf(1, "event_freq %u, sleep_nsec %ld, check cost %.3e s, "
+                    "overhead %.3f, idle %.3f, %" PRIu64 " adjustments\n",
+                    tuning.event_freq, tuning.sleep_nsec, tuning.check_cost,
+                    tuning.check_overhead, tuning.idle_ratio,
+                    tuning.num_adjustments);
+    assert(tuning.enabled == ABT_TRUE);
+    assert(tuning.event_freq >= 4 && tuning.event_freq <= 4096);
+    assert(tuning.sleep_nsec >= 0);
+    assert(tuning.idle_ratio >= 0.0 && tuning.idle_ratio <= 1.0);
+
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    ret = ABT_test_finalize(0);
+    return ret;
+}
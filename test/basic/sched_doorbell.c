@@ -0,0 +1,81 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define NUM_ROUNDS              5
+#define SLEEP_NSEC              "1000000000"
+#define MAX_LATENCY             0.2
+
+/* Idle ESs sleep for up to a second, but a unit pushed to the pool of one of
+ * them has to run long before that.  Every round pushes to the pool of a
+ * different ES while the others keep sleeping. */
+
+static double g_start_time;
+static double g_latency;
+
+static void thread_func(void *arg)
+{
+    g_latency = ABT_get_wtime() - g_start_time;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    double max_latency = 0.0;
+    int i, ret;
+
+    setenv("ABT_SCHED_SLEEP_NSEC", SLEEP_NSEC, 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    }
+    if (num_xstreams < 2) num_xstreams = 2;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < NUM_ROUNDS; i++) {
+        ABT_thread thread;
+        int target = 1 + i % (num_xstreams - 1);
+
+        /* Let the ESs go to sleep. */
+        usleep(100000);
+        g_start_time = ABT_get_wtime();
+        ret = ABT_thread_create(pools[target], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_free(&thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+        ABT_test_printf(1, "round %d: ES %d woke up in %.6f sec\n", i,
+                        target, g_latency);
+        if (g_latency > max_latency) max_latency = g_latency;
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_test_finalize(max_latency > MAX_LATENCY);
+    free(pools);
+    free(xstreams);
+    return ret;
+}
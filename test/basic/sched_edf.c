@@ -0,0 +1,164 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     1000
+#define NUM_POOLS               2
+
+static int g_num_threads = DEFAULT_NUM_THREADS;
+static int *g_order;
+static int g_num_run = 0;
+
+/* Every fifth ULT has no deadline.  The keys of the others are shuffled, and
+ * the deadlines increase with the keys. */
+static int has_deadline(int idx)
+{
+    return idx < g_num_threads && idx % 5 != 4;
+}
+
+static int get_key(int idx)
+{
+    return idx * 7 % g_num_threads;
+}
+
+/* The first half of the deadlines have already passed. */
+static double get_deadline(double base, int idx)
+{
+    int key = get_key(idx);
+    double offset = (key < g_num_threads / 2) ? -1000.0 : 1000.0;
+    return base + offset + key * 1.0e-3;
+}
+
+void thread_func(void *arg)
+{
+    g_order[g_num_run++] = (int)(intptr_t)arg;
+}
+
+/* Units with a deadline must come out in the order of deadline, and then the
+ * others in the order of creation.  The tasklet (index num_threads) has no
+ * deadline and was created last. */
+static int check_order(int *order, int num)
+{
+    int i;
+    for (i = 1; i < num; i++) {
+        int prev = order[i - 1], cur = order[i];
+        if (has_deadline(prev) && has_deadline(cur)) {
+            if (get_key(prev) > get_key(cur)) return 1;
+        } else if (has_deadline(cur)) {
+            return 1;
+        } else if (!has_deadline(prev) && prev > cur) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret, err = 0;
+    int num_threads, num_expected_units = 0, num_expected_misses = 0;
+    ABT_pool pools[NUM_POOLS];
+    ABT_thread_attr attr;
+    ABT_thread *threads;
+    ABT_task task;
+    ABT_xstream xstream;
+    ABT_xstream_stats stats;
+    double base, deadline;
+
+    if (argc > 1) g_num_threads = atoi(argv[1]);
+    assert(g_num_threads > 0);
+    num_threads = g_num_threads;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    g_order = (int *)malloc(sizeof(int) * (num_threads + 1));
+
+    ABT_test_init(argc, argv);
+
+    for (i = 0; i < NUM_POOLS; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_EDF, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Negative deadlines are rejected. */
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_deadline(attr, -1.0);
+    assert(ret == ABT_ERR_INV_THREAD_ATTR);
+    ret = ABT_thread_attr_get_deadline(attr, &deadline);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_get_deadline");
+    assert(deadline == 0.0);
+
+    /* ULTs with a deadline are spread over both pools, and the others and the
+     * tasklet go to the first one. */
+    base = ABT_get_wtime();
+    for (i = 0; i < num_threads; i++) {
+        ABT_pool pool = pools[0];
+        deadline = 0.0;
+        if (has_deadline(i)) {
+            deadline = get_deadline(base, i);
+            pool = pools[i % NUM_POOLS];
+            num_expected_units++;
+            if (deadline < base) num_expected_misses++;
+        }
+        ret = ABT_thread_attr_set_deadline(attr, deadline);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_set_deadline");
+        ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i, attr,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_task_create(pools[0], thread_func, (void *)(intptr_t)num_threads,
+                          &task);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    /* Run them on a single ES and check the order of execution */
+    ret = ABT_xstream_create_basic(ABT_SCHED_EDF, NUM_POOLS, pools,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_info_query_xstream_stats(xstream, &stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_xstream_stats");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    assert(g_num_run == num_threads + 1);
+    if (check_order(g_order, num_threads + 1)) {
+        fprintf(stderr, "wrong order of execution\n");
+        err++;
+    }
+
+    /* Only the ULTs with a deadline are counted. */
+    ABT_test_printf(1, "deadline units %llu, misses %llu, max lateness %.3f\n",
+                    (unsigned long long)stats.num_deadline_units,
+                    (unsigned long long)stats.num_deadline_misses,
+                    stats.max_lateness);
+    if (stats.num_deadline_units != (uint64_t)num_expected_units ||
+        stats.num_deadline_misses != (uint64_t)num_expected_misses ||
+        (num_expected_misses > 0 && stats.max_lateness < 999.0)) {
+        fprintf(stderr, "wrong deadline statistics\n");
+        err++;
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_task_free(&task);
+    ABT_TEST_ERROR(ret, "ABT_task_free");
+
+    ret = ABT_test_finalize(err);
+
+    free(g_order);
+    free(threads);
+
+    return ret;
+}
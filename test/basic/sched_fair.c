@@ -0,0 +1,117 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_TASKS       2000
+#define NUM_TENANTS             2
+
+/* Two tenants flood their pools with the same tasklets.  The fair-share
+ * scheduler with weights 3:1 has to give the first tenant about three times
+ * the run time of the second one while both have work.  The run times are
+ * taken by the ES itself when three quarters of the first tenant's tasklets
+ * have run, and the weighted times may differ only by about the run time of
+ * one tasklet, however long a tasklet takes on a loaded machine. */
+
+static int g_weights[NUM_TENANTS] = { 3, 1 };
+static int g_counters[NUM_TENANTS];
+static int g_num_snap;
+static ABT_sched g_sched;
+static double g_snap_times[NUM_TENANTS];
+static int g_snap_counters[NUM_TENANTS];
+static double g_max_time = 0.0;
+
+static void task_func(void *arg)
+{
+    int tenant = (int)(intptr_t)arg;
+    double start = ABT_get_wtime();
+    double elapsed;
+    int ret, count;
+    while (ABT_get_wtime() - start < 1.0e-5) ;
+    /* Only the ES of g_sched runs tasklets, so no atomics are needed. */
+    count = ++g_counters[tenant];
+    if (tenant == 0 && count == g_num_snap) {
+        ret = ABT_sched_get_pool_times(g_sched, NUM_TENANTS, g_snap_times);
+        ABT_TEST_ERROR(ret, "ABT_sched_get_pool_times");
+        g_snap_counters[0] = g_counters[0];
+        g_snap_counters[1] = g_counters[1];
+    }
+    elapsed = ABT_get_wtime() - start;
+    if (elapsed > g_max_time) g_max_time = elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream xstream;
+    ABT_pool pools[NUM_TENANTS];
+    ABT_sched_config config;
+    double times[NUM_TENANTS], diff;
+    int i, k, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    g_num_snap = num_tasks * 3 / 4;
+
+    for (k = 0; k < NUM_TENANTS; k++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPSC,
+                                    ABT_FALSE, &pools[k]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+        for (i = 0; i < num_tasks; i++) {
+            ret = ABT_task_create(pools[k], task_func, (void *)(intptr_t)k,
+                                  NULL);
+            ABT_TEST_ERROR(ret, "ABT_task_create");
+        }
+    }
+
+    ret = ABT_sched_config_create(&config, ABT_sched_fair_weights, g_weights,
+                                  ABT_sched_config_var_end);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_create");
+    ret = ABT_sched_create_basic(ABT_SCHED_FAIR, NUM_TENANTS, pools, config,
+                                 &g_sched);
+    ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_sched_config_free(&config);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_free");
+    ret = ABT_xstream_create(g_sched, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+
+    /* Every tasklet has run and is accounted to its own tenant.  The clock of
+     * the scheduler may be calibrated slightly differently. */
+    ret = ABT_sched_get_pool_times(g_sched, NUM_TENANTS, times);
+    ABT_TEST_ERROR(ret, "ABT_sched_get_pool_times");
+    ABT_test_printf(1, "run time: %.6f : %.6f sec (tasklets %d : %d)\n",
+                    times[0], times[1], g_counters[0], g_counters[1]);
+    assert(g_counters[0] == num_tasks && g_counters[1] == num_tasks);
+    assert(times[0] >= num_tasks * 0.5e-5 && times[1] >= num_tasks * 0.5e-5);
+
+    /* While both had work, the weighted run times stayed close. */
+    diff = g_snap_times[0] / g_weights[0] - g_snap_times[1] / g_weights[1];
+    ABT_test_printf(1, "at %d tasklets: %.6f : %.6f sec (tasklets %d : %d), "
+                    "longest tasklet %.6f sec\n", g_num_snap,
+                    g_snap_times[0], g_snap_times[1], g_snap_counters[0],
+                    g_snap_counters[1], g_max_time);
+    assert(g_snap_counters[0] == g_num_snap);
+    assert(diff < 2.0 * g_max_time + 2.0e-3 &&
+           -diff < 2.0 * g_max_time + 2.0e-3);
+
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    for (k = 0; k < NUM_TENANTS; k++) {
+        ret = ABT_pool_free(&pools[k]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    ret = ABT_test_finalize(g_counters[0] != num_tasks ||
+                            g_counters[1] != num_tasks);
+    return ret;
+}
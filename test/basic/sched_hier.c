@@ -0,0 +1,110 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     1000
+
+/* All ESs run the hierarchical scheduler.  One ULT spawns every ULT into its
+ * own pool, and the ULTs moved up to the shared pools have to be run by the
+ * other ESs.  The ESs cannot be joined before the shared pools are empty. */
+
+static int g_counter = 0;
+static int *g_num_runs;
+static int g_num_xstreams;
+
+static void leaf_func(void *arg)
+{
+    int rank;
+    ABT_TEST_UNUSED(arg);
+    ABT_xstream_self_rank(&rank);
+    if (rank < g_num_xstreams) __sync_fetch_and_add(&g_num_runs[rank], 1);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void spawn_func(void *arg)
+{
+    int i, ret;
+    int num = (int)(intptr_t)arg;
+    ABT_xstream xstream;
+    ABT_pool pool;
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    for (i = 0; i < num; i++) {
+        ret = ABT_thread_create(pool, leaf_func, NULL, ABT_THREAD_ATTR_NULL,
+                                NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        if (i % 64 == 0) ABT_thread_yield();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_sched_config config;
+    ABT_pool pool;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    g_num_xstreams = num_xstreams;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    g_num_runs = (int *)calloc(num_xstreams, sizeof(int));
+
+    ret = ABT_sched_config_create(&config, ABT_sched_hier_spill, 8,
+                                  ABT_sched_config_var_end);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_create");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_HIER, 0,
+                                           NULL);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_HIER, 0, NULL, config,
+                                       &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+    ret = ABT_sched_config_free(&config);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_free");
+
+    /* Spawn from the last ES */
+    ret = ABT_xstream_get_main_pools(xstreams[num_xstreams - 1], 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_thread_create(pool, spawn_func, (void *)(intptr_t)num_threads,
+                            ABT_THREAD_ATTR_NULL, NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    /* The primary ES runs what is left in the shared pools. */
+    while (__sync_fetch_and_add(&g_counter, 0) < num_threads) {
+        ABT_thread_yield();
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ABT_test_printf(1, "ES%d ran %d ULTs\n", i, g_num_runs[i]);
+    }
+
+    ret = ABT_test_finalize(g_counter != num_threads);
+    free(g_num_runs);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,118 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     100
+
+/* A polling ULT that loops on ABT_thread_yield() runs only when the other
+ * pools of its scheduler are empty, and it does not keep the ES from being
+ * joined. */
+
+static volatile int g_num_polls = 0;
+static volatile int g_stop = 0;
+static int g_num_polls_seen = 0;
+static int g_counter = 0;
+
+static void polling_func(void *arg)
+{
+    while (g_stop == 0) {
+        g_num_polls++;
+        ABT_thread_yield();
+    }
+}
+
+static void thread_func(void *arg)
+{
+    g_num_polls_seen += g_num_polls;
+    g_counter++;
+    ABT_thread_yield();
+    g_num_polls_seen += g_num_polls;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream xstream, self;
+    ABT_pool pool, polling_pool, main_pool;
+    ABT_sched sched;
+    ABT_thread polling_thread;
+    ABT_unit unit;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPSC, ABT_FALSE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_FALSE,
+                                &polling_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    /* The work is queued before the ES starts, so the polling ULT must not run
+     * until all of it is done. */
+    ret = ABT_thread_create(polling_pool, polling_func, NULL,
+                            ABT_THREAD_ATTR_NULL, &polling_thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    ret = ABT_sched_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                 ABT_SCHED_CONFIG_NULL, &sched);
+    ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_sched_add_polling_pool(sched, polling_pool);
+    ABT_TEST_ERROR(ret, "ABT_sched_add_polling_pool");
+    ret = ABT_sched_add_polling_pool(sched, pool);
+    assert(ret == ABT_ERR_SCHED);
+    ret = ABT_xstream_create(sched, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_sched_add_polling_pool(sched, polling_pool);
+    assert(ret == ABT_ERR_SCHED);
+
+    /* The ES polls once it is idle. */
+    while (g_num_polls == 0) {
+        ABT_thread_yield();
+    }
+    assert(g_counter == num_threads && g_num_polls_seen == 0);
+
+    /* The polling ULT does not block the join. */
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    /* Finish the polling ULT on the primary ES. */
+    g_stop = 1;
+    ret = ABT_xstream_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(self, 1, &main_pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_pool_pop(polling_pool, &unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_pop");
+    assert(unit != ABT_UNIT_NULL);
+    ret = ABT_unit_set_associated_pool(unit, main_pool);
+    ABT_TEST_ERROR(ret, "ABT_unit_set_associated_pool");
+    ret = ABT_pool_push(main_pool, unit);
+    ABT_TEST_ERROR(ret, "ABT_pool_push");
+    ret = ABT_thread_free(&polling_thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    ret = ABT_pool_free(&polling_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+    ret = ABT_pool_free(&pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    ret = ABT_test_finalize(g_counter != num_threads);
+    return ret;
+}
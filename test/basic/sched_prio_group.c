@@ -0,0 +1,123 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     200
+#define NUM_PRIOS               16
+
+/* The priority scheduler finds the non-empty pools through a bitmap.  The
+ * ULTs pushed before the ES starts have to run in the order of priority, and
+ * the ones pushed by running ULTs to any level must not be missed. */
+
+static ABT_pool g_pools[NUM_PRIOS];
+static int g_order[NUM_PRIOS];
+static int g_num_done = 0;
+static int g_counter = 0;
+
+static void prio_func(void *arg)
+{
+    int idx = __sync_fetch_and_add(&g_num_done, 1);
+    g_order[idx] = (int)(intptr_t)arg;
+}
+
+static void leaf_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void spawn_func(void *arg)
+{
+    int i, ret;
+    int num = (int)(intptr_t)arg;
+    unsigned int seed = (unsigned int)num;
+
+    for (i = 0; i < num; i++) {
+        ABT_pool pool = g_pools[rand_r(&seed) % NUM_PRIOS];
+        ret = ABT_thread_create(pool, leaf_func, NULL, ABT_THREAD_ATTR_NULL,
+                                NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        if (i % 16 == 0) ABT_thread_yield();
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_sched sched;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    if (num_xstreams < 2) num_xstreams = 2;
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+
+    for (i = 0; i < NUM_PRIOS; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Push one ULT to each level from the lowest priority */
+    for (i = NUM_PRIOS - 1; i >= 0; i--) {
+        ret = ABT_thread_create(g_pools[i], prio_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    ret = ABT_sched_create_basic(ABT_SCHED_PRIO, NUM_PRIOS, g_pools,
+                                 ABT_SCHED_CONFIG_NULL, &sched);
+    ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_xstream_create(sched, &xstreams[1]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+
+    while (__sync_fetch_and_add(&g_num_done, 0) < NUM_PRIOS) {
+        ABT_thread_yield();
+    }
+    for (i = 0; i < NUM_PRIOS; i++) {
+        assert(g_order[i] == i);
+    }
+
+    /* The other ESs share the pools and the bitmap. */
+    for (i = 2; i < num_xstreams; i++) {
+        ret = ABT_sched_create_basic(ABT_SCHED_PRIO, NUM_PRIOS, g_pools,
+                                     ABT_SCHED_CONFIG_NULL, &sched);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(sched, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < NUM_PRIOS; i++) {
+        ret = ABT_thread_create(g_pools[i], spawn_func,
+                                (void *)(intptr_t)num_threads,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    for (i = 0; i < NUM_PRIOS; i++) {
+        ret = ABT_pool_free(&g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    ret = ABT_test_finalize(g_counter != NUM_PRIOS * (num_threads + 1));
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,127 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     256
+#define NUM_PRIOS               2
+
+/* The first ES has many high-priority ULTs, but it is stuck in another
+ * high-priority ULT that waits for all of them, while the second ES has only
+ * low-priority ULTs.  The other ESs have to steal the high-priority ULTs, and
+ * the second ES must run them before its own low-priority ones. */
+
+static int g_num_threads;
+static int g_high_done = 0;
+static int g_low_done = 0;
+static int g_num_errors = 0;
+
+static void hog_func(void *arg)
+{
+    while (__atomic_load_n(&g_high_done, __ATOMIC_SEQ_CST) < g_num_threads);
+}
+
+static void high_func(void *arg)
+{
+    __atomic_fetch_add(&g_high_done, 1, __ATOMIC_SEQ_CST);
+}
+
+static void low_func(void *arg)
+{
+    int check = (int)(intptr_t)arg;
+    if (check &&
+        __atomic_load_n(&g_high_done, __ATOMIC_SEQ_CST) < g_num_threads) {
+        __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_fetch_add(&g_low_done, 1, __ATOMIC_SEQ_CST);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_sched_config config;
+    int i, k, ret, num_units;
+
+    ABT_test_init(argc, argv);
+    g_num_threads = DEFAULT_NUM_THREADS;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    if (num_xstreams < 2) num_xstreams = 2;
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools = (ABT_pool *)malloc(num_xstreams * NUM_PRIOS * sizeof(ABT_pool));
+    num_units = 2 * g_num_threads + 1;
+    threads = (ABT_thread *)malloc(num_units * sizeof(ABT_thread));
+
+    ret = ABT_sched_config_create(&config, ABT_sched_prio_steal, 1,
+                                  ABT_sched_config_var_end);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_create");
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < NUM_PRIOS; k++) {
+            ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                        ABT_TRUE, &pools[i * NUM_PRIOS + k]);
+            ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_PRIO, NUM_PRIOS,
+                                     &pools[i * NUM_PRIOS], config,
+                                     &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+    ret = ABT_sched_config_free(&config);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_free");
+
+    /* The hog runs first on the first ES. */
+    ret = ABT_thread_create(pools[0], hog_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_create(pools[0], high_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[1 + i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        /* With two ESs, the second ES is the only thief, so it must have run
+         * all the high-priority ULTs before any low-priority one. */
+        ret = ABT_thread_create(pools[NUM_PRIOS + 1], low_func,
+                                (void *)(intptr_t)(num_xstreams == 2),
+                                ABT_THREAD_ATTR_NULL,
+                                &threads[1 + g_num_threads + i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_units; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    if (g_high_done != g_num_threads) g_num_errors++;
+    if (g_low_done != g_num_threads) g_num_errors++;
+
+    ret = ABT_test_finalize(g_num_errors);
+    free(threads);
+    free(pools);
+    free(scheds);
+    free(xstreams);
+    return ret;
+}
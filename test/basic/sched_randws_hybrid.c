@@ -0,0 +1,138 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     256
+#define NUM_YIELDS              4
+
+/* ESs with random work-stealing schedulers are marked as on performance or
+ * efficiency cores alternately, and ULTs, half of which are hinted to run on
+ * performance cores, are created in the pools of the ESs on efficiency cores.
+ * Every ULT has to run to completion exactly once wherever it is moved. */
+
+static int *g_counts;
+static int g_num_on_perf[2];    /* Indexed by the hint (0: any, 1: perf) */
+
+static void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int hinted = idx % 2;
+    int i, core_class, ret;
+    ABT_xstream xstream;
+
+    for (i = 0; i < NUM_YIELDS; i++) {
+        ABT_thread_yield();
+    }
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_topology_get_core_class(xstream, &core_class);
+    ABT_TEST_ERROR(ret, "ABT_topology_get_core_class");
+    if (core_class == ABT_CORE_CLASS_PERF) {
+        __atomic_fetch_add(&g_num_on_perf[hinted], 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_fetch_add(&g_counts[idx], 1, __ATOMIC_SEQ_CST);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools, *my_pools;
+    ABT_thread_attr attr;
+    int i, j, k, core_class, ret, num_errors = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && num_threads > 0);
+    g_counts = (int *)calloc(num_threads, sizeof(int));
+
+    /* Attributes */
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_get_core_class(attr, &core_class);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_get_core_class");
+    if (core_class != ABT_CORE_CLASS_ANY) num_errors++;
+    ret = ABT_thread_attr_set_core_class(attr, 2);
+    if (ret != ABT_ERR_INV_THREAD_ATTR) num_errors++;
+    ret = ABT_thread_attr_set_core_class(attr, ABT_CORE_CLASS_PERF);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_core_class");
+    ret = ABT_thread_attr_get_core_class(attr, &core_class);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_get_core_class");
+    if (core_class != ABT_CORE_CLASS_PERF) num_errors++;
+
+    /* ESs on alternating core classes */
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        for (j = 0, k = i; j < num_xstreams; j++, k = (k + 1) % num_xstreams) {
+            my_pools[j] = pools[k];
+        }
+        ret = ABT_xstream_create_basic(ABT_SCHED_RANDWS, num_xstreams,
+                                       my_pools, ABT_SCHED_CONFIG_NULL,
+                                       &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+        ret = ABT_topology_get_core_class(xstreams[i], &core_class);
+        ABT_TEST_ERROR(ret, "ABT_topology_get_core_class");
+        if (core_class != ABT_CORE_CLASS_PERF &&
+            core_class != ABT_CORE_CLASS_EFFICIENCY) {
+            num_errors++;
+        }
+        ret = ABT_topology_set_core_class(xstreams[i], (i % 2 == 0)
+                                          ? ABT_CORE_CLASS_EFFICIENCY
+                                          : ABT_CORE_CLASS_PERF);
+        ABT_TEST_ERROR(ret, "ABT_topology_set_core_class");
+    }
+    ret = ABT_topology_set_core_class(xstreams[0], ABT_CORE_CLASS_ANY);
+    if (ret != ABT_ERR_OTHER) num_errors++;
+    ret = ABT_topology_get_core_class(xstreams[0], &core_class);
+    ABT_TEST_ERROR(ret, "ABT_topology_get_core_class");
+    if (core_class != ABT_CORE_CLASS_EFFICIENCY) num_errors++;
+
+    /* ULTs in the pools of the ESs on efficiency cores */
+    for (i = 0; i < num_threads; i++) {
+        ABT_pool pool = pools[(i / 2 * 2) % num_xstreams];
+        ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i,
+                                (i % 2) ? attr : ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    for (i = 0; i < num_threads; i++) {
+        if (g_counts[i] != 1) num_errors++;
+    }
+    ABT_test_printf(1, "on performance cores: %d of %d hinted ULTs, "
+                    "%d of %d others\n", g_num_on_perf[1], num_threads / 2,
+                    g_num_on_perf[0], (num_threads + 1) / 2);
+
+    ret = ABT_test_finalize(num_errors);
+    free(my_pools);
+    free(pools);
+    free(xstreams);
+    free(g_counts);
+    return ret;
+}
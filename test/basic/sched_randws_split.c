@@ -0,0 +1,149 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_ITEMS       4096
+#define WORK_PER_ITEM           2000
+
+/* A loop over all the items starts as a single ULT.  ESs with randws
+ * schedulers that have nothing to steal request a split, and only then does a
+ * running ULT give half of its remaining items to a new ULT.  All the items
+ * must be processed once, with far fewer ULTs than items.  The last items of
+ * each ULT are kept until a split has happened so that the test does not
+ * depend on the timing of the ESs. */
+
+typedef struct {
+    int lo;
+    int hi;
+} range_t;
+
+static int g_wait_split = 0;
+static int g_num_done = 0;
+static int g_num_splits = 0;
+static int *g_items;
+
+static void loop_func(void *arg)
+{
+    range_t *p_range = (range_t *)arg;
+    int lo = p_range->lo, hi = p_range->hi;
+    volatile int w;
+    ABT_pool pool;
+    int ret;
+
+    free(p_range);
+    while (lo < hi) {
+        ret = ABT_self_get_split_pool(&pool);
+        ABT_TEST_ERROR(ret, "ABT_self_get_split_pool");
+        if (pool != ABT_POOL_NULL && hi - lo >= 2) {
+            range_t *p_child = (range_t *)malloc(sizeof(range_t));
+            p_child->lo = lo + (hi - lo) / 2;
+            p_child->hi = hi;
+            hi = p_child->lo;
+            __atomic_fetch_add(&g_num_splits, 1, __ATOMIC_SEQ_CST);
+            ret = ABT_thread_create(pool, loop_func, p_child,
+                                    ABT_THREAD_ATTR_NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+            continue;
+        }
+        if (hi - lo == 2 && g_wait_split &&
+            __atomic_load_n(&g_num_splits, __ATOMIC_SEQ_CST) == 0) {
+            continue;
+        }
+        for (w = 0; w < WORK_PER_ITEM; w++);
+        g_items[lo++]++;
+        __atomic_fetch_add(&g_num_done, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_items = DEFAULT_NUM_ITEMS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools, *my_pools;
+    ABT_sched_config config;
+    ABT_thread root;
+    range_t *p_range;
+    int i, k, ret, num_errors = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_items = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && num_items > 0);
+    g_wait_split = (num_xstreams > 1 && num_items >= 2);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    g_items = (int *)calloc(num_items, sizeof(int));
+
+    ret = ABT_sched_config_create(&config, ABT_sched_randws_split, 1,
+                                  ABT_sched_config_var_end);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_create");
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
+                                     config, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+    ret = ABT_sched_config_free(&config);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_free");
+
+    p_range = (range_t *)malloc(sizeof(range_t));
+    p_range->lo = 0;
+    p_range->hi = num_items;
+    ret = ABT_thread_create(pools[0], loop_func, p_range,
+                            ABT_THREAD_ATTR_NULL, &root);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* The split ULTs are not joined, so wait for all the items. */
+    while (__atomic_load_n(&g_num_done, __ATOMIC_SEQ_CST) < num_items) {
+        ABT_thread_yield();
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_thread_free(&root);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    for (i = 0; i < num_items; i++) {
+        if (g_items[i] != 1) num_errors++;
+    }
+    if (g_num_splits >= num_items) num_errors++;
+    if (g_wait_split && g_num_splits == 0) num_errors++;
+
+    ABT_test_printf(1, "%d items, %d splits\n", num_items, g_num_splits);
+    ret = ABT_test_finalize(num_errors);
+    free(g_items);
+    free(my_pools);
+    free(pools);
+    free(scheds);
+    free(xstreams);
+    return ret;
+}
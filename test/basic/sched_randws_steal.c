@@ -0,0 +1,121 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     1000
+
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    int rank;
+    ABT_xstream_self_rank(&rank);
+    ABT_test_printf(1, "[TH%lu:E%d] running\n", (size_t)arg, rank);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* All the ULTs are created in the pool of the first secondary ES.  The other
+ * ESs have to steal them, half of the victim's units at a time. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools, *my_pools;
+    ABT_thread *threads;
+    ABT_sched_config config;
+    int i, k, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs : %d\n"
+                       "# of ULTs: %d\n",
+                       num_xstreams, num_threads);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds   = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* Create a config to steal half of the victim's units at once */
+    ret = ABT_sched_config_create(&config,
+                                  ABT_sched_randws_steal,
+                                  ABT_SCHED_RANDWS_STEAL_HALF,
+                                  ABT_sched_config_var_end);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_create");
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_DEQUE, ABT_POOL_ACCESS_SPMC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Create schedulers */
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
+                                     config, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+    free(my_pools);
+
+    ret = ABT_sched_config_free(&config);
+    ABT_TEST_ERROR(ret, "ABT_sched_config_free");
+
+    /* Create ULTs before any ES consumes the pool */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[0], thread_func, (void *)(size_t)i,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    /* Create Execution Streams */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* Join and free Execution Streams.  They stop once all pools are
+     * drained, so all ULTs have terminated afterwards. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Free ULTs */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != num_threads);
+
+    free(xstreams);
+    free(scheds);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,127 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_TASKS       256
+#define MAX_XSTREAMS            64
+
+/* ESs with basic schedulers share one pool of tasklets, so which ES runs
+ * which tasklet depends on timing.  The schedule is recorded with
+ * ABT_SCHED_RECORD and replayed with ABT_SCHED_REPLAY, in which every
+ * tasklet has to run on the same ES at the same position. */
+
+typedef struct {
+    int rank;                   /* Rank of the ES that ran the tasklet */
+    int pos;                    /* Number of tasklets run by the ES before */
+} run_t;
+
+static run_t *g_runs;
+static int g_counts[MAX_XSTREAMS];
+
+static void task_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int rank, ret;
+    double start = ABT_get_wtime();
+
+    ret = ABT_xstream_self_rank(&rank);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self_rank");
+    assert(rank < MAX_XSTREAMS);
+    g_runs[idx].rank = rank;
+    g_runs[idx].pos = g_counts[rank]++;
+    while (ABT_get_wtime() - start < 1.0e-6) ;
+}
+
+static void run_tasks(int num_xstreams, int num_tasks)
+{
+    ABT_xstream xstreams[MAX_XSTREAMS];
+    ABT_pool pool;
+    int i, ret;
+
+    memset(g_counts, 0, sizeof(g_counts));
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pool, task_func, (void *)(intptr_t)i, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    run_t *recorded;
+    char filename[64];
+    FILE *fp;
+    char magic[8];
+    int i, ret, num_diffs = 0;
+
+    sprintf(filename, "/tmp/abt_sched_replay.%d.rec", (int)getpid());
+
+    /* Record */
+    setenv("ABT_SCHED_RECORD", filename, 1);
+    unsetenv("ABT_SCHED_REPLAY");
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+    }
+    assert(num_xstreams > 0 && num_xstreams < MAX_XSTREAMS && num_tasks > 0);
+    g_runs = (run_t *)calloc(num_tasks, sizeof(run_t));
+    recorded = (run_t *)calloc(num_tasks, sizeof(run_t));
+    run_tasks(num_xstreams, num_tasks);
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+    memcpy(recorded, g_runs, num_tasks * sizeof(run_t));
+
+    fp = fopen(filename, "rb");
+    assert(fp != NULL);
+    ret = (int)fread(magic, 1, sizeof(magic), fp);
+    assert(ret == sizeof(magic) && memcmp(magic, "ABTREC01", 8) == 0);
+    fclose(fp);
+
+    /* Replay */
+    unsetenv("ABT_SCHED_RECORD");
+    setenv("ABT_SCHED_REPLAY", filename, 1);
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+    memset(g_runs, 0, num_tasks * sizeof(run_t));
+    run_tasks(num_xstreams, num_tasks);
+    unsetenv("ABT_SCHED_REPLAY");
+
+    for (i = 0; i < num_tasks; i++) {
+        if (g_runs[i].rank != recorded[i].rank ||
+            g_runs[i].pos != recorded[i].pos) {
+            num_diffs++;
+        }
+    }
+    ABT_test_printf(1, "%d of %d tasklets ran differently\n", num_diffs,
+                    num_tasks);
+    remove(filename);
+    free(recorded);
+    free(g_runs);
+
+    return ABT_test_finalize(num_diffs);
+}
@@ -0,0 +1,99 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_ROUNDS      10
+#define DEFAULT_NUM_UNITS       100
+#define TIMEOUT_SEC             10.0
+
+/* A nested tasklet-type scheduler is pushed with ABT_pool_add_sched_inline()
+ * into the pool of a secondary ES.  It has to stay in the pool after its own
+ * pool drains, so units pushed in later rounds still run, and it has to
+ * terminate when the ES is joined. */
+
+static int g_counter = 0;
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    ABT_thread_yield();
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_rounds = DEFAULT_NUM_ROUNDS;
+    int num_units = DEFAULT_NUM_UNITS;
+    ABT_xstream xstream;
+    ABT_pool main_pool, nested_pool;
+    ABT_sched nested_sched;
+    double deadline;
+    int i, k, ret, expected = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_units = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &main_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &main_pool,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &nested_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_sched_create_basic(ABT_SCHED_BASIC, 1, &nested_pool,
+                                 ABT_SCHED_CONFIG_NULL, &nested_sched);
+    ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_pool_add_sched_inline(main_pool, nested_sched);
+    ABT_TEST_ERROR(ret, "ABT_pool_add_sched_inline");
+
+    for (k = 0; k < num_rounds; k++) {
+        for (i = 0; i < num_units; i++) {
+            if (i % 2) {
+                ret = ABT_task_create(nested_pool, task_func, NULL, NULL);
+                ABT_TEST_ERROR(ret, "ABT_task_create");
+            } else {
+                ret = ABT_thread_create(nested_pool, thread_func, NULL,
+                                        ABT_THREAD_ATTR_NULL, NULL);
+                ABT_TEST_ERROR(ret, "ABT_thread_create");
+            }
+        }
+        expected += num_units;
+
+        /* The units are not run if the nested scheduler has terminated. */
+        deadline = ABT_get_wtime() + TIMEOUT_SEC;
+        while (__sync_fetch_and_add(&g_counter, 0) < expected) {
+            if (ABT_get_wtime() > deadline) break;
+            ABT_thread_yield();
+        }
+        if (g_counter != expected) {
+            fprintf(stderr, "round %d: %d units did not run\n", k,
+                    expected - g_counter);
+            break;
+        }
+    }
+
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    ret = ABT_test_finalize(g_counter != expected);
+    return ret;
+}
@@ -0,0 +1,195 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     32
+#define DEFAULT_NUM_TASKS       32
+#define DEFAULT_NUM_ITER        100
+#define NUM_PERMITS             3
+#define NUM_EXT_THREADS         2
+
+static ABT_sem g_sem;
+static int g_num_iter;
+static int g_num_holders = 0;
+static int g_max_holders = 0;
+static int g_counter = 0;
+static int g_num_tasks_done = 0;
+
+static void enter(void)
+{
+    int num = __sync_add_and_fetch(&g_num_holders, 1);
+    int max = g_max_holders;
+    while (num > max) {
+        if (__sync_bool_compare_and_swap(&g_max_holders, max, num)) break;
+        max = g_max_holders;
+    }
+}
+
+static void leave(void)
+{
+    __sync_fetch_and_sub(&g_num_holders, 1);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void thread_func(void *arg)
+{
+    int i, ret, is_ext = (int)(intptr_t)arg;
+
+    for (i = 0; i < g_num_iter; i++) {
+        ret = ABT_sem_wait(g_sem);
+        ABT_TEST_ERROR(ret, "ABT_sem_wait");
+        enter();
+        if (!is_ext) ABT_thread_yield();
+        leave();
+        ret = ABT_sem_post(g_sem);
+        ABT_TEST_ERROR(ret, "ABT_sem_post");
+    }
+}
+
+/* Tasklets cannot wait but take a permit when one is available. */
+static void task_func(void *arg)
+{
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_sem_wait(g_sem);
+    if (ret != ABT_ERR_SEM) {
+        fprintf(stderr, "ABT_sem_wait in a tasklet returned %d\n", ret);
+        exit(EXIT_FAILURE);
+    }
+    if (ABT_sem_trywait(g_sem) == ABT_SUCCESS) {
+        enter();
+        leave();
+        ret = ABT_sem_post(g_sem);
+        ABT_TEST_ERROR(ret, "ABT_sem_post");
+    }
+    __sync_fetch_and_add(&g_num_tasks_done, 1);
+}
+
+static void *ext_thread_func(void *arg)
+{
+    thread_func(arg);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    pthread_t ext_threads[NUM_EXT_THREADS];
+    int i, ret, value, expected, err = 0;
+
+    ABT_test_init(argc, argv);
+    g_num_iter = DEFAULT_NUM_ITER;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Permits are counted without waiting. */
+    ret = ABT_sem_create(0, &g_sem);
+    ABT_TEST_ERROR(ret, "ABT_sem_create");
+    ret = ABT_sem_trywait(g_sem);
+    if (ret != ABT_ERR_SEM) {
+        fprintf(stderr, "ABT_sem_trywait without permits returned %d\n", ret);
+        err++;
+    }
+    for (i = 0; i < NUM_PERMITS; i++) {
+        ret = ABT_sem_post(g_sem);
+        ABT_TEST_ERROR(ret, "ABT_sem_post");
+    }
+    ret = ABT_sem_get_value(g_sem, &value);
+    ABT_TEST_ERROR(ret, "ABT_sem_get_value");
+    if (value != NUM_PERMITS) {
+        fprintf(stderr, "value is %d (expected %d)\n", value, NUM_PERMITS);
+        err++;
+    }
+
+    /* ULTs on all the ESs, tasklets, and external threads share the permits. */
+    expected = (num_threads + NUM_EXT_THREADS) * g_num_iter;
+    for (i = 0; i < NUM_EXT_THREADS; i++) {
+        ret = pthread_create(&ext_threads[i], NULL, ext_thread_func,
+                             (void *)(intptr_t)1);
+        assert(ret == 0);
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pools[i % num_xstreams], task_func, NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < NUM_EXT_THREADS; i++) {
+        ret = pthread_join(ext_threads[i], NULL);
+        assert(ret == 0);
+    }
+    while (*(volatile int *)&g_num_tasks_done < num_tasks) {
+        ABT_thread_yield();
+    }
+
+    if (g_counter < expected) {
+        fprintf(stderr, "%d permits taken (expected at least %d)\n",
+                g_counter, expected);
+        err++;
+    }
+    if (g_max_holders > NUM_PERMITS) {
+        fprintf(stderr, "%d holders at once (permits: %d)\n", g_max_holders,
+                NUM_PERMITS);
+        err++;
+    }
+    ret = ABT_sem_get_value(g_sem, &value);
+    ABT_TEST_ERROR(ret, "ABT_sem_get_value");
+    if (value != NUM_PERMITS) {
+        fprintf(stderr, "%d permits left (expected %d)\n", value, NUM_PERMITS);
+        err++;
+    }
+    ret = ABT_sem_free(&g_sem);
+    ABT_TEST_ERROR(ret, "ABT_sem_free");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ABT_test_finalize(err);
+}
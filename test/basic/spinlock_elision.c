@@ -0,0 +1,110 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_TASKS       10000
+
+/* Push and pop tasklets through one shared FIFO pool, whose lock is elided
+ * when configured with --enable-lock-elision on a processor with RTM.  The
+ * elision statistics of the ESs are printed with -v. */
+
+static int g_counter = 0;
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void spawn_func(void *arg)
+{
+    int i, ret;
+    int num_tasks = (int)(intptr_t)arg;
+    ABT_xstream xstream;
+    ABT_pool pool;
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pool, task_func, NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream *xstreams;
+    ABT_xstream_stats stats;
+    ABT_pool pool;
+    uint64_t num_elisions = 0, num_aborts = 0;
+    double start, end;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                           &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    start = ABT_get_wtime();
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_create(pool, spawn_func, (void *)(intptr_t)num_tasks,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    while (__sync_fetch_and_add(&g_counter, 0) < num_xstreams * num_tasks) {
+        ABT_thread_yield();
+    }
+    end = ABT_get_wtime();
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_info_query_xstream_stats(xstreams[i], &stats);
+        ABT_TEST_ERROR(ret, "ABT_info_query_xstream_stats");
+        num_elisions += stats.num_lock_elisions;
+        num_aborts += stats.num_lock_elision_aborts;
+    }
+    ABT_test_printf(1, "# of tasklets: %d x %d\n", num_xstreams, num_tasks);
+    ABT_test_printf(1, "time: %.6f sec\n", end - start);
+    ABT_test_printf(1, "elided sections: %llu, aborts: %llu (%.1f%%)\n",
+                    (unsigned long long)num_elisions,
+                    (unsigned long long)num_aborts,
+                    (num_elisions + num_aborts) ? 100.0 * num_aborts /
+                    (num_elisions + num_aborts) : 0.0);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_test_finalize(g_counter != num_xstreams * num_tasks);
+    free(xstreams);
+    return ret;
+}
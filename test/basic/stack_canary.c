@@ -0,0 +1,152 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     100
+#define STACKSIZE               (64 * 1024)
+
+/* With ABT_STACK_CANARY, ULTs that stay within their stacks run normally,
+ * while a ULT that has written below the bottom of its stack aborts the
+ * process when it switches back to its scheduler. */
+
+static int g_counter = 0;
+
+static int use_stack(int depth)
+{
+    volatile char buf[256];
+    memset((char *)buf, depth, sizeof(buf));
+    if (depth == 0) return buf[0];
+    return use_stack(depth - 1) + buf[1];
+}
+
+static void thread_func(void *arg)
+{
+    use_stack(32);
+    ABT_thread_yield();
+    use_stack(32);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void overflow_func(void *arg)
+{
+    /* What a deep recursion would do to the bottom of the stack */
+    memset(arg, 0, 16);
+    ABT_thread_yield();
+}
+
+/* Run in a child process, which has to be killed by SIGABRT. */
+static void run_overflow(void)
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread_attr attr;
+    void *p_stack = malloc(STACKSIZE);
+
+    ABT_init(0, NULL);
+    ABT_xstream_self(&xstream);
+    ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_thread_attr_create(&attr);
+    ABT_thread_attr_set_stack(attr, p_stack, STACKSIZE);
+    ABT_thread_create(pool, overflow_func, p_stack, attr, NULL);
+    ABT_thread_attr_free(&attr);
+    ABT_thread_yield();
+    ABT_thread_yield();
+    /* Not reached if the overflow is detected */
+    exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread_attr attr;
+    void **stacks;
+    pid_t pid;
+    int status;
+    int i, ret;
+
+    setenv("ABT_STACK_CANARY", "1", 1);
+
+    /* The child is forked before Argobots creates any thread. */
+    fflush(stdout);
+    fflush(stderr);
+    pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        /* Keep the expected report out of the output of the test. */
+        if (freopen("/dev/null", "w", stderr) == NULL) exit(1);
+        run_overflow();
+    }
+    assert(waitpid(pid, &status, 0) == pid);
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    ABT_test_printf(1, "child: signaled=%d signal=%d\n", WIFSIGNALED(status),
+                    WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    stacks = (void **)malloc(sizeof(void *) * num_threads);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Pooled stacks and user stacks that are used properly */
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        stacks[i] = malloc(STACKSIZE);
+        ret = ABT_thread_attr_set_stack(attr, stacks[i], STACKSIZE);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_set_stack");
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func, NULL,
+                                attr, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    while (__sync_fetch_and_add(&g_counter, 0) < num_threads * 2) {
+        ABT_thread_yield();
+    }
+
+    ret = ABT_test_finalize(g_counter != num_threads * 2);
+    for (i = 0; i < num_threads; i++) free(stacks[i]);
+    free(stacks);
+    free(pools);
+    free(xstreams);
+    return ret;
+}
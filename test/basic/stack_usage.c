@@ -0,0 +1,143 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     32
+#define STACKSIZE               (64 * 1024)
+#define SHALLOW_DEPTH           2
+#define DEEP_DEPTH              64
+
+/* With ABT_STACK_PROFILE, the stack usage of ULTs is reported per function.
+ * ULTs of a function that recurses deeply have to show a larger usage than
+ * those of a function that hardly uses its stack, and both have to fit their
+ * stacks. */
+
+static int use_stack(int depth)
+{
+    volatile char buf[256];
+    memset((char *)buf, depth, sizeof(buf));
+    if (depth == 0) return buf[0];
+    return use_stack(depth - 1) + buf[1];
+}
+
+static void shallow_func(void *arg)
+{
+    use_stack(SHALLOW_DEPTH);
+}
+
+static void deep_func(void *arg)
+{
+    use_stack(DEEP_DEPTH);
+    ABT_thread_yield();
+}
+
+static ABT_histogram *find_usage(ABT_stack_usage *entries, int num_entries,
+                                 void (*thread_func)(void *))
+{
+    int i;
+    for (i = 0; i < num_entries; i++) {
+        if (entries[i].thread_func == thread_func) return &entries[i].usage;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool pool;
+    ABT_thread_attr attr;
+    ABT_thread *threads;
+    ABT_stack_usage *entries;
+    ABT_histogram *p_shallow, *p_deep;
+    int i, num_entries, ret;
+
+    setenv("ABT_STACK_PROFILE", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    ret = ABT_info_query_stack_usage(0, NULL, &num_entries);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        /* Stacks are not painted without fcontext. */
+        return ABT_test_finalize(0);
+    }
+    ABT_TEST_ERROR(ret, "ABT_info_query_stack_usage");
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads * 2);
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                           &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_stacksize(attr, STACKSIZE);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_stacksize");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, shallow_func, NULL, attr,
+                                &threads[2 * i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_create(pool, deep_func, NULL, attr,
+                                &threads[2 * i + 1]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+    for (i = 0; i < num_threads * 2; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    ret = ABT_info_query_stack_usage(0, NULL, &num_entries);
+    ABT_TEST_ERROR(ret, "ABT_info_query_stack_usage");
+    assert(num_entries >= 2);
+    entries = (ABT_stack_usage *)malloc(sizeof(ABT_stack_usage) * num_entries);
+    ret = ABT_info_query_stack_usage(num_entries, entries, &num_entries);
+    ABT_TEST_ERROR(ret, "ABT_info_query_stack_usage");
+
+    p_shallow = find_usage(entries, num_entries, shallow_func);
+    p_deep = find_usage(entries, num_entries, deep_func);
+    assert(p_shallow != NULL && p_deep != NULL);
+    assert(p_shallow->count == (uint64_t)num_threads);
+    assert(p_deep->count == (uint64_t)num_threads);
+    ABT_test_printf(1, "max usage: shallow %" PRIu64 " B, deep %" PRIu64
+                    " B\n", p_shallow->max, p_deep->max);
+    assert(p_deep->min > (uint64_t)DEEP_DEPTH * 256);
+    assert(p_deep->min > p_shallow->max);
+    assert(p_deep->max < STACKSIZE);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_test_finalize(0);
+    free(entries);
+    free(threads);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,162 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define NUM_ITER                100
+#define SMALL_SIZE              16
+#define LARGE_SIZE              4096
+#define NUM_COMPARTMENTS        3
+#define MANY_COMPARTMENTS       100
+
+/* Each request ULT creates an eventual and a future, either in its own memory
+ * or with the create routines, and a helper ULT on another ES sets them.  The
+ * sizes alternate between those that fit in the memory of the object and
+ * those that do not. */
+
+typedef struct {
+    ABT_eventual eventual;
+    ABT_future future;
+    int nbytes;
+    int compartments;
+    int id;
+} request_t;
+
+static ABT_pool *g_pools;
+static int g_num_xstreams;
+static int g_num_errors = 0;
+
+static void helper_func(void *arg)
+{
+    request_t *p_req = (request_t *)arg;
+    char *buf = (char *)malloc(p_req->nbytes);
+    int i, ret;
+
+    for (i = 0; i < p_req->compartments; i++) {
+        ret = ABT_future_set(p_req->future, (void *)(intptr_t)(p_req->id + i));
+        ABT_TEST_ERROR(ret, "ABT_future_set");
+    }
+    memset(buf, p_req->id & 0xff, p_req->nbytes);
+    ret = ABT_eventual_set(p_req->eventual, buf, p_req->nbytes);
+    ABT_TEST_ERROR(ret, "ABT_eventual_set");
+    free(buf);
+}
+
+static void check_request(request_t *p_req)
+{
+    ABT_thread helper;
+    void *value;
+    int ret, i;
+
+    ret = ABT_thread_create(g_pools[(p_req->id + 1) % g_num_xstreams],
+                            helper_func, p_req, ABT_THREAD_ATTR_NULL, &helper);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_future_wait(p_req->future);
+    ABT_TEST_ERROR(ret, "ABT_future_wait");
+    ret = ABT_eventual_wait(p_req->eventual, &value);
+    ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+    for (i = 0; i < p_req->nbytes; i++) {
+        if (((unsigned char *)value)[i] != (p_req->id & 0xff)) {
+            __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_SEQ_CST);
+            break;
+        }
+    }
+    ret = ABT_thread_free(&helper);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+}
+
+static void request_func(void *arg)
+{
+    int rank = (int)(intptr_t)arg;
+    int i, ret;
+
+    for (i = 0; i < NUM_ITER; i++) {
+        ABT_eventual_memory eventual_mem;
+        ABT_future_memory future_mem;
+        request_t req;
+        ABT_bool in_place = (i % 2 == 0) ? ABT_TRUE : ABT_FALSE;
+
+        req.nbytes = (i % 4 < 2) ? SMALL_SIZE : LARGE_SIZE;
+        req.compartments = (i % 8 < 4) ? NUM_COMPARTMENTS : MANY_COMPARTMENTS;
+        req.id = rank * NUM_ITER + i;
+        if (in_place == ABT_TRUE) {
+            ret = ABT_eventual_init(&eventual_mem, req.nbytes, &req.eventual);
+            ABT_TEST_ERROR(ret, "ABT_eventual_init");
+            ret = ABT_future_init(&future_mem, req.compartments, NULL,
+                                  &req.future);
+            ABT_TEST_ERROR(ret, "ABT_future_init");
+        } else {
+            ret = ABT_eventual_create(req.nbytes, &req.eventual);
+            ABT_TEST_ERROR(ret, "ABT_eventual_create");
+            ret = ABT_future_create(req.compartments, NULL, &req.future);
+            ABT_TEST_ERROR(ret, "ABT_future_create");
+        }
+        check_request(&req);
+        ret = ABT_eventual_free(&req.eventual);
+        ABT_TEST_ERROR(ret, "ABT_eventual_free");
+        ret = ABT_future_free(&req.future);
+        ABT_TEST_ERROR(ret, "ABT_future_free");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    int i, ret;
+
+    g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        g_num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * g_num_xstreams);
+    g_pools = (ABT_pool *)malloc(sizeof(ABT_pool) * g_num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(g_pools[i % g_num_xstreams], request_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ABT_test_printf(1, "%d errors\n", g_num_errors);
+    ret = ABT_test_finalize(g_num_errors != 0);
+
+    free(threads);
+    free(g_pools);
+    free(xstreams);
+    return ret;
+}
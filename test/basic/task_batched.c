@@ -0,0 +1,121 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_TASKS       10000
+
+/* Tiny tasklets are created with ABT_task_create_batched() by ULTs, which
+ * alternate two functions and yield now and then, and by the main ULT, which
+ * leaves an open batch to ABT_finalize().  Every tasklet has to run once. */
+
+static int *g_counts;
+static int g_num_tasks;
+static int g_num_others = 0;
+
+static void count_func(void *arg)
+{
+    __sync_fetch_and_add(&g_counts[(intptr_t)arg], 1);
+}
+
+static void other_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_num_others, 1);
+}
+
+static void spawn_func(void *arg)
+{
+    int rank = (int)(intptr_t)arg;
+    int i, ret;
+    ABT_xstream xstream;
+    ABT_pool pool;
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    for (i = rank; i < g_num_tasks; i += DEFAULT_NUM_XSTREAMS) {
+        ret = ABT_task_create_batched(pool, count_func, (void *)(intptr_t)i);
+        ABT_TEST_ERROR(ret, "ABT_task_create_batched");
+        if (i % 100 == 0) {
+            ret = ABT_task_create_batched(pool, other_func, NULL);
+            ABT_TEST_ERROR(ret, "ABT_task_create_batched");
+        }
+        if (i % 1000 == 0) ABT_thread_yield();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    ABT_pool pool;
+    int i, ret, err = 0, expected_others = 0;
+
+    ABT_test_init(argc, argv);
+    g_num_tasks = DEFAULT_NUM_TASKS;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    g_counts = (int *)calloc(g_num_tasks + 1, sizeof(int));
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * DEFAULT_NUM_XSTREAMS);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    for (i = 0; i < DEFAULT_NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i % num_xstreams], 1, &pool);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        ret = ABT_thread_create(pool, spawn_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < DEFAULT_NUM_XSTREAMS; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* This one is left in the batch of the primary ES. */
+    ret = ABT_xstream_get_main_pools(xstreams[0], 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_task_create_batched(pool, count_func,
+                                  (void *)(intptr_t)g_num_tasks);
+    ABT_TEST_ERROR(ret, "ABT_task_create_batched");
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+
+    for (i = 0; i <= g_num_tasks; i++) {
+        if (g_counts[i] != 1) err++;
+        if (i < g_num_tasks && i % 100 == 0) expected_others++;
+    }
+    if (g_num_others != expected_others) err++;
+    if (err) fprintf(stderr, "%d errors\n", err);
+    if (err == 0) printf("No Errors\n");
+
+    free(threads);
+    free(xstreams);
+    free(g_counts);
+    return err;
+}
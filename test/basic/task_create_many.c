@@ -0,0 +1,140 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_TASKS       1000
+
+static int *g_flags;
+
+static void task_func(void *arg)
+{
+    size_t idx = (size_t)arg;
+    __sync_fetch_and_add(&g_flags[idx], 1);
+}
+
+/* Named tasklets are created at once in the pool of the first ES, and unnamed
+ * tasklets in the pool of the last ES.  Each tasklet has to run exactly once,
+ * and the IDs of the named tasklets have to be distinct. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_task *tasks;
+    uint64_t *ids;
+    void (**funcs)(void *);
+    void **args;
+    int i, k, ret, err = 0;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_tasks    = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs     : %d\n"
+                       "# of tasklets: %d\n",
+                       num_xstreams, num_tasks);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    tasks    = (ABT_task *)malloc(num_tasks * sizeof(ABT_task));
+    ids      = (uint64_t *)malloc(num_tasks * sizeof(uint64_t));
+    funcs    = (void (**)(void *))malloc(2 * num_tasks * sizeof(funcs[0]));
+    args     = (void **)malloc(2 * num_tasks * sizeof(void *));
+    g_flags  = (int *)calloc(2 * num_tasks, sizeof(int));
+
+    for (i = 0; i < 2 * num_tasks; i++) {
+        funcs[i] = task_func;
+        args[i] = (void *)(size_t)i;
+    }
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Create named and unnamed tasklets before any ES consumes the pools */
+    ret = ABT_task_create_many(pools[0], num_tasks, funcs, args, tasks);
+    ABT_TEST_ERROR(ret, "ABT_task_create_many");
+    ret = ABT_task_create_many(pools[num_xstreams - 1], num_tasks,
+                               &funcs[num_tasks], &args[num_tasks], NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create_many");
+
+    /* Creating no tasklet is allowed */
+    ret = ABT_task_create_many(pools[0], 0, NULL, NULL, NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create_many");
+
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_get_id(tasks[i], &ids[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_get_id");
+        for (k = 0; k < i; k++) {
+            if (ids[k] == ids[i]) {
+                ABT_test_printf(0, "Tasklets %d and %d have the same ID\n",
+                                k, i);
+                err++;
+                break;
+            }
+        }
+    }
+
+    /* Create Execution Streams */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pools[i],
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    /* Join and free Execution Streams.  They stop once their pools are
+     * drained, so all tasklets have been executed afterwards. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Free tasklets */
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_free(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+
+    /* Free pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    for (i = 0; i < 2 * num_tasks; i++) {
+        if (g_flags[i] != 1) {
+            ABT_test_printf(0, "Tasklet %d ran %d times\n", i, g_flags[i]);
+            err++;
+        }
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(err);
+
+    free(xstreams);
+    free(pools);
+    free(tasks);
+    free(ids);
+    free(funcs);
+    free(args);
+    free(g_flags);
+
+    return ret;
+}
@@ -0,0 +1,136 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_ITER        3
+#define WIDTH                   32
+#define DEPTH                   16
+
+/* Node (l, i) of a WIDTH x DEPTH grid depends on nodes (l - 1, i - 1),
+ * (l - 1, i), and (l - 1, i + 1).  Each node records the sequence number of
+ * its completion, which has to be larger than those of its predecessors. */
+static int g_seq = 0;
+static int g_order[DEPTH][WIDTH];
+static int g_num_errors = 0;
+
+static void node_func(void *arg)
+{
+    int id = (int)(size_t)arg;
+    int l = id / WIDTH, i = id % WIDTH, k;
+
+    for (k = i - 1; l > 0 && k <= i + 1; k++) {
+        if (k < 0 || k >= WIDTH) continue;
+        if (g_order[l - 1][k] == 0) __sync_fetch_and_add(&g_num_errors, 1);
+    }
+    g_order[l][i] = __sync_add_and_fetch(&g_seq, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_iter = DEFAULT_NUM_ITER;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_task_graph graph;
+    int i, k, l, n, id, ret, err = 0;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_iter     = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs       : %d\n"
+                       "# of iterations: %d\n",
+                       num_xstreams, num_iter);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Build the graph */
+    ret = ABT_task_graph_create(&graph);
+    ABT_TEST_ERROR(ret, "ABT_task_graph_create");
+    for (l = 0; l < DEPTH; l++) {
+        for (i = 0; i < WIDTH; i++) {
+            ret = ABT_task_graph_add_task(graph, node_func,
+                                          (void *)(size_t)(l * WIDTH + i),
+                                          &id);
+            ABT_TEST_ERROR(ret, "ABT_task_graph_add_task");
+            assert(id == l * WIDTH + i);
+            for (k = i - 1; l > 0 && k <= i + 1; k++) {
+                if (k < 0 || k >= WIDTH) continue;
+                ret = ABT_task_graph_add_dep(graph, (l - 1) * WIDTH + k, id);
+                ABT_TEST_ERROR(ret, "ABT_task_graph_add_dep");
+            }
+        }
+    }
+
+    /* Run the graph several times */
+    for (n = 0; n < num_iter; n++) {
+        for (l = 0; l < DEPTH; l++) {
+            for (i = 0; i < WIDTH; i++) g_order[l][i] = 0;
+        }
+        ret = ABT_task_graph_run(graph, pools[n % num_xstreams]);
+        ABT_TEST_ERROR(ret, "ABT_task_graph_run");
+        ret = ABT_task_graph_wait(graph);
+        ABT_TEST_ERROR(ret, "ABT_task_graph_wait");
+        for (l = 0; l < DEPTH; l++) {
+            for (i = 0; i < WIDTH; i++) {
+                if (g_order[l][i] == 0) err++;
+            }
+        }
+    }
+
+    /* A cycle has to be rejected. */
+    ret = ABT_task_graph_add_task(graph, node_func, (void *)0, &id);
+    ABT_TEST_ERROR(ret, "ABT_task_graph_add_task");
+    ret = ABT_task_graph_add_dep(graph, id, 0);
+    ABT_TEST_ERROR(ret, "ABT_task_graph_add_dep");
+    ret = ABT_task_graph_add_dep(graph, (DEPTH - 1) * WIDTH, id);
+    ABT_TEST_ERROR(ret, "ABT_task_graph_add_dep");
+    ret = ABT_task_graph_run(graph, pools[0]);
+    if (ret != ABT_ERR_TASK_GRAPH) {
+        ABT_test_printf(0, "A cycle was not detected\n");
+        err++;
+    }
+
+    ret = ABT_task_graph_free(&graph);
+    ABT_TEST_ERROR(ret, "ABT_task_graph_free");
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(err + g_num_errors);
+
+    free(xstreams);
+    free(pools);
+
+    return ret;
+}
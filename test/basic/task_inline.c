@@ -0,0 +1,169 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define INLINE_DEPTH    4
+#define CHAIN_LENGTH    20
+
+/* Tasklets created with ABT_task_create_inline() into the empty main pool of
+ * the calling ES have to run before the call returns, and a chain of them has
+ * to nest no deeper than ABT_TASK_INLINE_DEPTH.  Tasklets created into a
+ * non-empty pool or into the pool of another ES have to be pushed.  Every
+ * tasklet has to run once. */
+
+static int g_num_errors = 0;
+static int g_num_runs = 0;
+static int g_depth = 0;
+static int g_max_depth = 0;
+static ABT_pool g_pool;
+static ABT_xstream g_last_xstream;
+
+static void task_func(void *arg)
+{
+    ABT_task self;
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_task_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_task_self");
+    ret = ABT_xstream_self(&g_last_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    __atomic_fetch_add(&g_num_runs, 1, __ATOMIC_RELEASE);
+}
+
+/* Each link creates the next one inline */
+static void chain_func(void *arg)
+{
+    int n = (int)(intptr_t)arg;
+    int ret;
+
+    g_num_runs++;
+    if (++g_depth > g_max_depth) g_max_depth = g_depth;
+    if (n + 1 < CHAIN_LENGTH) {
+        ret = ABT_task_create_inline(g_pool, chain_func,
+                                     (void *)(intptr_t)(n + 1), NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create_inline");
+    }
+    g_depth--;
+}
+
+static void check_state(ABT_task task, ABT_task_state expected,
+                        const char *name)
+{
+    ABT_task_state state;
+    int ret = ABT_task_get_state(task, &state);
+    ABT_TEST_ERROR(ret, "ABT_task_get_state");
+    if (state != expected) {
+        fprintf(stderr, "%s: state %d, expected %d\n", name, (int)state,
+                (int)expected);
+        g_num_errors++;
+    }
+}
+
+static void wait_runs(int expected)
+{
+    while (__atomic_load_n(&g_num_runs, __ATOMIC_ACQUIRE) < expected) {
+        ABT_thread_yield();
+    }
+}
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream, xstream2;
+    ABT_pool pool2;
+    ABT_thread thread;
+    ABT_task task;
+    int ret;
+    char depth[16];
+
+    sprintf(depth, "%d", INLINE_DEPTH);
+    setenv("ABT_TASK_INLINE_DEPTH", depth, 1);
+    ABT_test_init(argc, argv);
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &g_pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* The main pool is empty, so the tasklet runs inline. */
+    ret = ABT_task_create_inline(g_pool, task_func, NULL, &task);
+    ABT_TEST_ERROR(ret, "ABT_task_create_inline");
+    if (g_num_runs != 1) {
+        fprintf(stderr, "the tasklet has not run inline\n");
+        g_num_errors++;
+    }
+    check_state(task, ABT_TASK_STATE_TERMINATED, "inline");
+    ret = ABT_task_free(&task);
+    ABT_TEST_ERROR(ret, "ABT_task_free");
+
+    /* A chain nests up to the depth limit, and the rest runs later.  The
+     * links run by the scheduler are pushed since the main ULT, which yields,
+     * is in the pool. */
+    g_num_runs = 0;
+    ret = ABT_task_create_inline(g_pool, chain_func, (void *)(intptr_t)0,
+                                 NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create_inline");
+    if (g_num_runs != INLINE_DEPTH) {
+        fprintf(stderr, "%d links have run inline, expected %d\n",
+                g_num_runs, INLINE_DEPTH);
+        g_num_errors++;
+    }
+    wait_runs(CHAIN_LENGTH);
+    if (g_max_depth != INLINE_DEPTH) {
+        fprintf(stderr, "max. depth %d, expected %d\n", g_max_depth,
+                INLINE_DEPTH);
+        g_num_errors++;
+    }
+
+    /* The main pool is not empty, so the tasklet is pushed behind the ULT. */
+    g_num_runs = 0;
+    ret = ABT_thread_create(g_pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_task_create_inline(g_pool, task_func, NULL, &task);
+    ABT_TEST_ERROR(ret, "ABT_task_create_inline");
+    if (g_num_runs != 0) {
+        fprintf(stderr, "the tasklet has run ahead of the ULT\n");
+        g_num_errors++;
+    }
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ret = ABT_task_free(&task);
+    ABT_TEST_ERROR(ret, "ABT_task_free");
+    if (g_num_runs != 1) {
+        fprintf(stderr, "the pushed tasklet has not run\n");
+        g_num_errors++;
+    }
+
+    /* The pool of another ES is not taken by the caller's scheduler. */
+    g_num_runs = 0;
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &xstream2);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_xstream_get_main_pools(xstream2, 1, &pool2);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_task_create_inline(pool2, task_func, NULL, &task);
+    ABT_TEST_ERROR(ret, "ABT_task_create_inline");
+    ret = ABT_task_free(&task);
+    ABT_TEST_ERROR(ret, "ABT_task_free");
+    if (g_num_runs != 1 || g_last_xstream != xstream2) {
+        fprintf(stderr, "the tasklet has not run on the other ES\n");
+        g_num_errors++;
+    }
+    ret = ABT_xstream_join(xstream2);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream2);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    return ABT_test_finalize(g_num_errors);
+}
@@ -0,0 +1,98 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_TASKS       1000
+#define DEFAULT_NUM_ROUNDS      4
+
+static int g_counter = 0;
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Tasklets without handles are created by the primary ES and freed by the ESs
+ * that execute them, so their blocks are freed to pages owned by another ES.
+ * The blocks have to be reused by the primary ES in the following rounds. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    int num_rounds = DEFAULT_NUM_ROUNDS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    int i, r, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_tasks    = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+        num_rounds   = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs     : %d\n"
+                       "# of tasklets: %d\n"
+                       "# of rounds  : %d\n",
+                       num_xstreams, num_tasks, num_rounds);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    for (r = 0; r < num_rounds; r++) {
+        /* Create tasklets before any ES consumes the pools */
+        for (i = 0; i < num_tasks; i++) {
+            ret = ABT_task_create(pools[i % num_xstreams], task_func, NULL,
+                                  NULL);
+            ABT_TEST_ERROR(ret, "ABT_task_create");
+        }
+
+        /* Create Execution Streams */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pools[i],
+                                           ABT_SCHED_CONFIG_NULL,
+                                           &xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+        }
+
+        /* Join and free Execution Streams.  They stop once their pools are
+         * drained, so all tasklets have been executed and freed. */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_join(xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+    }
+
+    /* Free pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != num_tasks * num_rounds);
+
+    free(xstreams);
+    free(pools);
+
+    return ret;
+}
@@ -0,0 +1,176 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_TASKS       1000
+#define NUM_COMPARTMENTS        2
+
+enum {
+    STATE_START,
+    STATE_STARTED,
+    STATE_YIELDED,
+    STATE_FINISHED
+};
+
+typedef struct {
+    int id;
+    int num_calls;
+} task_arg_t;
+
+static ABT_eventual g_start;
+static ABT_future g_finish;
+static int g_num_started = 0;
+static int g_num_finished = 0;
+static int g_num_errors = 0;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+/* A state machine that waits for g_start, yields once, and then waits for
+ * g_finish.  Each suspension returns from the function. */
+static int task_func(int state, void *arg)
+{
+    task_arg_t *p_arg = (task_arg_t *)arg;
+    ABT_unit_type type;
+    int ret;
+
+    ABT_self_get_type(&type);
+    check(type == ABT_UNIT_TYPE_TASK, "not run by a tasklet");
+    p_arg->num_calls++;
+
+    switch (state) {
+        case STATE_START:
+            ret = ABT_task_await_eventual(g_start);
+            ABT_TEST_ERROR(ret, "ABT_task_await_eventual");
+            return STATE_STARTED;
+        case STATE_STARTED:
+            __sync_fetch_and_add(&g_num_started, 1);
+            return STATE_YIELDED;
+        case STATE_YIELDED:
+            ret = ABT_task_await_future(g_finish);
+            ABT_TEST_ERROR(ret, "ABT_task_await_future");
+            return STATE_FINISHED;
+        case STATE_FINISHED:
+            __sync_fetch_and_add(&g_num_finished, 1);
+            break;
+        default:
+            check(0, "wrong state");
+            break;
+    }
+    return ABT_TASK_RESUMABLE_DONE;
+}
+
+static void thread_func(void *arg)
+{
+    /* Only resumable tasklets can await. */
+    int ret = ABT_task_await_eventual(g_start);
+    check(ret == ABT_ERR_INV_TASK, "a ULT can await");
+}
+
+static void set_finish(void *arg)
+{
+    ABT_future_set(g_finish, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_task *tasks;
+    task_arg_t *args;
+    ABT_task_state state;
+    void *p_arg;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    tasks = (ABT_task *)malloc(sizeof(ABT_task) * num_tasks);
+    args = (task_arg_t *)calloc(num_tasks, sizeof(task_arg_t));
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    ret = ABT_eventual_create(0, &g_start);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_future_create(NUM_COMPARTMENTS, NULL, &g_finish);
+    ABT_TEST_ERROR(ret, "ABT_future_create");
+
+    /* Odd tasklets are unnamed. */
+    for (i = 0; i < num_tasks; i++) {
+        args[i].id = i;
+        ret = ABT_task_create_resumable(pools[i % num_xstreams], task_func,
+                                        &args[i], (i % 2) ? NULL : &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create_resumable");
+    }
+    ret = ABT_thread_create(pools[0], thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                            NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+
+    /* Nothing can start before g_start is set. */
+    for (i = 0; i < 10; i++) ABT_thread_yield();
+    check(g_num_started == 0, "tasklets started too early");
+    ret = ABT_task_get_state(tasks[0], &state);
+    ABT_TEST_ERROR(ret, "ABT_task_get_state");
+    check(state != ABT_TASK_STATE_TERMINATED, "a waiting tasklet terminated");
+    ret = ABT_task_get_arg(tasks[0], &p_arg);
+    ABT_TEST_ERROR(ret, "ABT_task_get_arg");
+    check(p_arg == &args[0], "wrong argument");
+
+    ret = ABT_eventual_set(g_start, NULL, 0);
+    ABT_TEST_ERROR(ret, "ABT_eventual_set");
+    ret = ABT_future_set(g_finish, NULL);
+    ABT_TEST_ERROR(ret, "ABT_future_set");
+    ret = ABT_thread_create(pools[num_xstreams - 1], set_finish, NULL,
+                            ABT_THREAD_ATTR_NULL, NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+
+    for (i = 0; i < num_tasks; i += 2) {
+        ret = ABT_task_free(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+        check(args[i].num_calls == 4, "wrong number of invocations");
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    check(g_num_started == num_tasks, "wrong number of started tasklets");
+    check(g_num_finished == num_tasks, "wrong number of finished tasklets");
+
+    ABT_future_free(&g_finish);
+    ABT_eventual_free(&g_start);
+    free(xstreams);
+    free(pools);
+    free(tasks);
+    free(args);
+
+    return ABT_test_finalize(g_num_errors);
+}
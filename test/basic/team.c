@@ -0,0 +1,102 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    6
+#define DEFAULT_NUM_REGIONS     1000
+#define IDLE_INTERVAL           100
+
+/* A team runs many regions, in which every member marks its slot with the
+ * number of the region.  When ABT_team_run() returns, every slot has to be
+ * marked, and every member has to have run on its own ES.  Now and then, the
+ * main ULT sleeps between regions so that the members block. */
+
+static int g_num_errors = 0;
+static int *g_marks;
+static ABT_xstream *g_xstreams;
+
+static void team_func(int rank, void *arg)
+{
+    int region = (int)(intptr_t)arg;
+    ABT_xstream xstream;
+    int ret;
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    if (rank > 0 && xstream != g_xstreams[rank]) {
+        fprintf(stderr, "member %d runs on another ES\n", rank);
+        __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_RELAXED);
+    }
+    if (g_marks[rank] != region - 1) {
+        fprintf(stderr, "member %d: mark %d in region %d\n", rank,
+                g_marks[rank], region);
+        __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_RELAXED);
+    }
+    g_marks[rank] = region;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_regions = DEFAULT_NUM_REGIONS;
+    ABT_team team;
+    int i, r, ret, size;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_regions = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0 && num_regions > 0);
+
+    g_xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    g_marks = (int *)calloc(num_xstreams, sizeof(int));
+    ret = ABT_xstream_self(&g_xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &g_xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    ret = ABT_team_create(num_xstreams, g_xstreams, &team);
+    ABT_TEST_ERROR(ret, "ABT_team_create");
+    ret = ABT_team_get_size(team, &size);
+    ABT_TEST_ERROR(ret, "ABT_team_get_size");
+    if (size != num_xstreams) {
+        fprintf(stderr, "size %d, expected %d\n", size, num_xstreams);
+        g_num_errors++;
+    }
+
+    for (r = 1; r <= num_regions; r++) {
+        ret = ABT_team_run(team, team_func, (void *)(intptr_t)r);
+        ABT_TEST_ERROR(ret, "ABT_team_run");
+        for (i = 0; i < num_xstreams; i++) {
+            if (g_marks[i] != r) {
+                fprintf(stderr, "member %d has not finished region %d\n", i,
+                        r);
+                g_num_errors++;
+            }
+        }
+        if (r % IDLE_INTERVAL == 0) usleep(1000);
+    }
+
+    ret = ABT_team_free(&team);
+    ABT_TEST_ERROR(ret, "ABT_team_free");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(g_xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&g_xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(g_marks);
+    free(g_xstreams);
+
+    return ABT_test_finalize(g_num_errors);
+}
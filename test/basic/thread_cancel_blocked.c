@@ -0,0 +1,177 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     30
+
+enum {
+    KIND_MUTEX,
+    KIND_COND,
+    KIND_EVENTUAL,
+    NUM_KINDS
+};
+
+static ABT_mutex g_mutex;
+static ABT_cond g_cond;
+static ABT_eventual g_eventual;
+static int g_cond_flag = 0;
+static int g_num_passed[NUM_KINDS];
+static int g_num_errors = 0;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+static void thread_func(void *arg)
+{
+    int kind = (int)(intptr_t)arg;
+
+    switch (kind) {
+        case KIND_MUTEX:
+            ABT_mutex_lock(g_mutex);
+            ABT_mutex_unlock(g_mutex);
+            break;
+        case KIND_COND:
+            ABT_mutex_lock(g_mutex);
+            while (g_cond_flag == 0) ABT_cond_wait(g_cond, g_mutex);
+            ABT_mutex_unlock(g_mutex);
+            break;
+        case KIND_EVENTUAL:
+            ABT_eventual_wait(g_eventual, NULL);
+            break;
+    }
+    __sync_fetch_and_add(&g_num_passed[kind], 1);
+}
+
+static void wait_blocked(ABT_thread *threads, int num_threads)
+{
+    ABT_thread_state state;
+    int i;
+
+    for (i = 0; i < num_threads; i++) {
+        do {
+            ABT_thread_yield();
+            ABT_thread_get_state(threads[i], &state);
+        } while (state != ABT_THREAD_STATE_BLOCKED);
+    }
+}
+
+/* Create num_threads ULTs blocked on kind, cancel all but the last one, and
+ * check that the canceled ones terminate without being woken up. */
+static void test_kind(int kind, ABT_pool *pools, int num_xstreams,
+                      int num_threads)
+{
+    ABT_thread *threads;
+    ABT_thread_state state;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    if (kind == KIND_MUTEX) ABT_mutex_lock(g_mutex);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)kind, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    wait_blocked(threads, num_threads);
+
+    for (i = 0; i < num_threads - 1; i++) {
+        ret = ABT_thread_cancel(threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_cancel");
+    }
+    /* The canceled ULTs terminate while the object is still held. */
+    for (i = 0; i < num_threads - 1; i++) {
+        do {
+            ABT_thread_yield();
+            ABT_thread_get_state(threads[i], &state);
+        } while (state != ABT_THREAD_STATE_TERMINATED);
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    check(g_num_passed[kind] == 0, "a canceled ULT passed the wait");
+
+    /* The remaining waiter is woken up as usual. */
+    switch (kind) {
+        case KIND_MUTEX:
+            ABT_mutex_unlock(g_mutex);
+            break;
+        case KIND_COND:
+            ABT_mutex_lock(g_mutex);
+            g_cond_flag = 1;
+            ABT_cond_signal(g_cond);
+            ABT_mutex_unlock(g_mutex);
+            break;
+        case KIND_EVENTUAL:
+            ABT_eventual_set(g_eventual, NULL, 0);
+            break;
+    }
+    ret = ABT_thread_free(&threads[num_threads - 1]);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    check(g_num_passed[kind] == 1, "the last waiter did not pass the wait");
+    free(threads);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    if (num_threads < 2) num_threads = 2;
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    ret = ABT_mutex_create(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_cond_create(&g_cond);
+    ABT_TEST_ERROR(ret, "ABT_cond_create");
+    ret = ABT_eventual_create(0, &g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+
+    for (i = 0; i < NUM_KINDS; i++) {
+        test_kind(i, pools, num_xstreams, num_threads);
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ABT_eventual_free(&g_eventual);
+    ABT_cond_free(&g_cond);
+    ABT_mutex_free(&g_mutex);
+    free(xstreams);
+    free(pools);
+
+    return ABT_test_finalize(g_num_errors);
+}
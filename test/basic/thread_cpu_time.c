@@ -0,0 +1,160 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     8
+#define NUM_YIELDS              10
+#define SPIN_TIME               1.0e-3
+
+/* With ABT_CPU_TIME, ULTs that spin between yields have to be charged at
+ * least the time they spin, and not much more than the elapsed time.  The
+ * same holds for tasklets, and the sums per function have to be reported.
+ * Argobots configured with --enable-feature=no-cpu-time returns
+ * ABT_ERR_FEATURE_NA instead. */
+
+static int g_num_errors = 0;
+
+static void spin(double duration)
+{
+    double t_start = ABT_get_wtime();
+    while (ABT_get_wtime() - t_start < duration);
+}
+
+static void thread_func(void *arg)
+{
+    ABT_thread self;
+    double cpu_time, last = 0.0;
+    int i, ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_thread_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_thread_self");
+    for (i = 0; i < NUM_YIELDS; i++) {
+        spin(SPIN_TIME);
+        ret = ABT_thread_get_cpu_time(self, &cpu_time);
+        ABT_TEST_ERROR(ret, "ABT_thread_get_cpu_time");
+        if (cpu_time < last) {
+            fprintf(stderr, "CPU time decreases: %f -> %f\n", last, cpu_time);
+            __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_RELAXED);
+        }
+        last = cpu_time;
+        ABT_thread_yield();
+    }
+    spin(SPIN_TIME);
+}
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    spin(SPIN_TIME);
+}
+
+static void check_cpu_time(const char *kind, double cpu_time, double min,
+                           double max)
+{
+    ABT_test_printf(1, "%s: %f s\n", kind, cpu_time);
+    if (cpu_time < min * 0.9 || cpu_time > max) {
+        fprintf(stderr, "%s: CPU time %f s is out of [%f, %f]\n", kind,
+                cpu_time, min, max);
+        g_num_errors++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    ABT_task *tasks;
+    ABT_pool pool;
+    double cpu_time, t_start, elapsed;
+    char line[1024];
+    int i, ret, num_funcs = 0;
+    FILE *fp;
+
+    setenv("ABT_CPU_TIME", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && num_threads > 0);
+
+    ret = ABT_info_print_cpu_time(stdout);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        ABT_test_printf(1, "CPU time is not measured\n");
+        return ABT_test_finalize(0);
+    }
+    ABT_TEST_ERROR(ret, "ABT_info_print_cpu_time");
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    tasks = (ABT_task *)malloc(num_threads * sizeof(ABT_task));
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_task_create(pool, task_func, NULL, &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    elapsed = ABT_get_wtime() - t_start;
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_get_cpu_time(threads[i], &cpu_time);
+        ABT_TEST_ERROR(ret, "ABT_thread_get_cpu_time");
+        check_cpu_time("ULT", cpu_time, SPIN_TIME * (NUM_YIELDS + 1), elapsed);
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+        ret = ABT_task_get_cpu_time(tasks[i], &cpu_time);
+        ABT_TEST_ERROR(ret, "ABT_task_get_cpu_time");
+        check_cpu_time("tasklet", cpu_time, SPIN_TIME, elapsed);
+        ret = ABT_task_free(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+    free(tasks);
+    free(threads);
+    free(xstreams);
+
+    /* Both functions have to be reported */
+    fp = tmpfile();
+    assert(fp != NULL);
+    ret = ABT_info_print_cpu_time(fp);
+    ABT_TEST_ERROR(ret, "ABT_info_print_cpu_time");
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        ABT_test_printf(1, "%s", line);
+        if (strstr(line, "cpu_time: count") != NULL) num_funcs++;
+    }
+    fclose(fp);
+    if (num_funcs != 2) {
+        fprintf(stderr, "%d functions are reported\n", num_funcs);
+        g_num_errors++;
+    }
+
+    return ABT_test_finalize(g_num_errors);
+}
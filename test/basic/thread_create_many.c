@@ -0,0 +1,142 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     1000
+
+static int *g_flags;
+
+static void thread_func(void *arg)
+{
+    size_t idx = (size_t)arg;
+    __sync_fetch_and_add(&g_flags[idx], 1);
+}
+
+/* Named ULTs are created at once in the pool of each ES, as well as unnamed
+ * ULTs.  Each ULT has to run exactly once, and the IDs of the named ULTs have
+ * to be distinct. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_id *ids;
+    void (**funcs)(void *);
+    void **args;
+    int i, k, ret, err = 0;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs : %d\n"
+                       "# of ULTs: %d\n",
+                       num_xstreams, num_threads);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    ids      = (ABT_thread_id *)malloc(num_threads * sizeof(ABT_thread_id));
+    funcs    = (void (**)(void *))malloc(2 * num_threads * sizeof(funcs[0]));
+    args     = (void **)malloc(2 * num_threads * sizeof(void *));
+    g_flags  = (int *)calloc(2 * num_threads, sizeof(int));
+
+    for (i = 0; i < 2 * num_threads; i++) {
+        funcs[i] = thread_func;
+        args[i] = (void *)(size_t)i;
+    }
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Create named and unnamed ULTs before any ES consumes the pools */
+    ret = ABT_thread_create_many(pools[0], num_threads, funcs, args,
+                                 ABT_THREAD_ATTR_NULL, threads);
+    ABT_TEST_ERROR(ret, "ABT_thread_create_many");
+    ret = ABT_thread_create_many(pools[num_xstreams - 1], num_threads,
+                                 &funcs[num_threads], &args[num_threads],
+                                 ABT_THREAD_ATTR_NULL, NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create_many");
+
+    /* Creating no ULT is allowed */
+    ret = ABT_thread_create_many(pools[0], 0, NULL, NULL,
+                                 ABT_THREAD_ATTR_NULL, NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create_many");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_get_id(threads[i], &ids[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_get_id");
+        for (k = 0; k < i; k++) {
+            if (ids[k] == ids[i]) {
+                ABT_test_printf(0, "ULTs %d and %d have the same ID\n", k, i);
+                err++;
+                break;
+            }
+        }
+    }
+
+    /* Create Execution Streams */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pools[i],
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    /* Join and free Execution Streams.  They stop once their pools are
+     * drained, so all ULTs have terminated afterwards. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Free ULTs */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Free pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    for (i = 0; i < 2 * num_threads; i++) {
+        if (g_flags[i] != 1) {
+            ABT_test_printf(0, "ULT %d ran %d times\n", i, g_flags[i]);
+            err++;
+        }
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(err);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(ids);
+    free(funcs);
+    free(args);
+    free(g_flags);
+
+    return ret;
+}
@@ -0,0 +1,148 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+#define DATA_SIZE               100
+
+typedef struct {
+    int id;
+    char buf[DATA_SIZE];
+} data_t;
+
+static int g_num_errors = 0;
+static int g_num_inits = 0;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        __sync_fetch_and_add(&g_num_errors, 1);
+    }
+}
+
+static void init_func(void *data, void *arg)
+{
+    data_t *p_data = (data_t *)data;
+    check(((uintptr_t)data & 15) == 0, "the area is not aligned");
+    p_data->id = *(int *)arg;
+    memset(p_data->buf, p_data->id & 0xff, DATA_SIZE);
+    g_num_inits++;
+}
+
+/* The area is on the stack of the running ULT. */
+static void thread_func(void *arg)
+{
+    data_t *p_data = (data_t *)arg;
+    ABT_thread self;
+    ABT_thread_attr attr;
+    void *p_stack;
+    size_t stacksize;
+    int i, ret;
+
+    ret = ABT_thread_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_thread_self");
+    ret = ABT_thread_get_attr(self, &attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_get_attr");
+    ret = ABT_thread_attr_get_stack(attr, &p_stack, &stacksize);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_get_stack");
+    ABT_thread_attr_free(&attr);
+    check((char *)arg >= (char *)p_stack &&
+          (char *)arg + sizeof(data_t) <= (char *)p_stack + stacksize,
+          "the area is not on the stack");
+
+    ABT_thread_yield();
+    for (i = 0; i < DATA_SIZE; i++) {
+        check(p_data->buf[i] == (char)(p_data->id & 0xff), "wrong data");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr attr;
+    data_t data;
+    int i, ret, *ids;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    ids = (int *)malloc(sizeof(int) * num_threads);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* The areas are initialized by init_func. */
+    for (i = 0; i < num_threads; i++) {
+        ids[i] = i;
+        ret = ABT_thread_create_with_data(pools[i % num_xstreams], thread_func,
+                                          sizeof(data_t), init_func, &ids[i],
+                                          ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create_with_data");
+    }
+    check(g_num_inits == num_threads, "init_func is not called");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* The data is copied without init_func, so it can be reused at once. */
+    for (i = 0; i < num_threads; i++) {
+        data.id = i;
+        memset(data.buf, i & 0xff, DATA_SIZE);
+        ret = ABT_thread_create_with_data(pools[i % num_xstreams], thread_func,
+                                          sizeof(data_t), NULL, &data,
+                                          ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create_with_data");
+    }
+
+    /* A deferred stack cannot hold the data. */
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_deferred_stack(attr, ABT_TRUE);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_deferred_stack");
+    ret = ABT_thread_create_with_data(pools[0], thread_func, sizeof(data_t),
+                                      NULL, &data, attr, &threads[0]);
+    check(ret == ABT_ERR_INV_THREAD_ATTR, "a deferred stack is accepted");
+    check(threads[0] == ABT_THREAD_NULL, "the handle is not NULL");
+    ABT_thread_attr_free(&attr);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(ids);
+
+    return ABT_test_finalize(g_num_errors);
+}
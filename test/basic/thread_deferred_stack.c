@@ -0,0 +1,145 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     200
+#define DEFAULT_NUM_ROUNDS      3
+#define NUM_YIELDS              4
+#define BUF_SIZE                1024
+
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    volatile char buf[BUF_SIZE];
+    size_t val = (size_t)arg;
+    int i, k;
+
+    /* The stack has to be kept across context switches. */
+    for (i = 0; i < NUM_YIELDS; i++) {
+        for (k = 0; k < BUF_SIZE; k++) buf[k] = (char)(val + i + k);
+        ABT_thread_yield();
+        for (k = 0; k < BUF_SIZE; k++) {
+            assert(buf[k] == (char)(val + i + k));
+        }
+    }
+
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void short_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* ULTs with deferred stacks are created before any ES runs them.  Half of
+ * them yield while using their stacks, and the others run to completion.
+ * They are revived in the following rounds. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_rounds = DEFAULT_NUM_ROUNDS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr attr;
+    int i, r, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_rounds   = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs   : %d\n"
+                       "# of ULTs  : %d\n"
+                       "# of rounds: %d\n",
+                       num_xstreams, num_threads, num_rounds);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* Create an attribute for deferred stacks */
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_deferred_stack(attr, ABT_TRUE);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        ABT_test_printf(1, "Deferred stacks are not supported\n");
+    } else {
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_set_deferred_stack");
+    }
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    for (r = 0; r < num_rounds; r++) {
+        /* Create or revive ULTs before any ES consumes the pools */
+        for (i = 0; i < num_threads; i++) {
+            void (*func)(void *) = (i % 2) ? thread_func : short_func;
+            if (r == 0) {
+                ret = ABT_thread_create(pools[i % num_xstreams], func,
+                                        (void *)(size_t)i, attr, &threads[i]);
+                ABT_TEST_ERROR(ret, "ABT_thread_create");
+            } else {
+                ret = ABT_thread_revive(pools[i % num_xstreams], func,
+                                        (void *)(size_t)i, &threads[i]);
+                ABT_TEST_ERROR(ret, "ABT_thread_revive");
+            }
+        }
+
+        /* Create Execution Streams */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pools[i],
+                                           ABT_SCHED_CONFIG_NULL,
+                                           &xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+        }
+
+        /* Join and free Execution Streams.  They stop once their pools are
+         * drained, so all ULTs have terminated afterwards. */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_join(xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+    }
+
+    /* Free ULTs, pools, and the attribute */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != num_threads * num_rounds);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,166 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_TASKS       64
+
+static int g_counter = 0;
+
+static void unit_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void self_detach_func(void *arg)
+{
+    ABT_thread self;
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_thread_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_thread_self");
+    ret = ABT_thread_detach(&self);
+    ABT_TEST_ERROR(ret, "ABT_thread_detach");
+    ABT_thread_yield();
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void wait_counter(int expected)
+{
+    while (*(volatile int *)&g_counter < expected) {
+        ABT_thread_yield();
+    }
+}
+
+/* Detach ULTs and tasklets before they run and after they have finished */
+static void run_detached(ABT_pool pool, int num_threads, int num_tasks)
+{
+    ABT_thread *threads;
+    ABT_task *tasks;
+    int i, ret, expected;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    tasks = (ABT_task *)malloc(sizeof(ABT_task) * num_tasks);
+    expected = g_counter + num_threads + num_tasks;
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, unit_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_detach(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_detach");
+        if (threads[i] != ABT_THREAD_NULL) {
+            fprintf(stderr, "the handle is not cleared\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pool, unit_func, NULL, &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+        ret = ABT_task_detach(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_detach");
+    }
+    wait_counter(expected);
+
+    expected = g_counter + num_threads + num_tasks;
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, unit_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pool, unit_func, NULL, &tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    wait_counter(expected);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_detach(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_detach");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_detach(&tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_detach");
+    }
+
+    free(threads);
+    free(tasks);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    ABT_xstream xstream, new_xstream;
+    ABT_pool pool, new_pool;
+    ABT_thread_attr attr;
+    ABT_thread thread, first;
+    int ret, err = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+    }
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_xstream_get_main_pools(new_xstream, 1, &new_pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* Units of the primary ES and of another ES */
+    run_detached(pool, num_threads, num_tasks);
+    run_detached(new_pool, num_threads, num_tasks);
+
+    /* A ULT that detaches itself */
+    ret = ABT_thread_create(pool, self_detach_func, NULL,
+                            ABT_THREAD_ATTR_NULL, &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    wait_counter(4 * (num_threads + num_tasks) + 1);
+
+    /* A detached ULT is freed on termination, so a reusable ULT is
+     * recycled right away. */
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_reusable(attr, ABT_TRUE);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_reusable");
+    ret = ABT_thread_create(pool, unit_func, NULL, attr, &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    first = thread;
+    ret = ABT_thread_detach(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_detach");
+    wait_counter(4 * (num_threads + num_tasks) + 2);
+    ret = ABT_thread_create(pool, unit_func, NULL, attr, &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    if (thread != first) {
+        fprintf(stderr, "the detached ULT is not freed\n");
+        err++;
+    }
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    ret = ABT_xstream_join(new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    if (g_counter != 4 * (num_threads + num_tasks) + 3) {
+        fprintf(stderr, "%d units run (expected %d)\n", g_counter,
+                4 * (num_threads + num_tasks) + 3);
+        err++;
+    }
+
+    return ABT_test_finalize(err);
+}
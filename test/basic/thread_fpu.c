@@ -0,0 +1,143 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     4
+#define DEFAULT_NUM_ITER        10000
+
+static int g_num_threads = DEFAULT_NUM_THREADS;
+static int g_num_iter = DEFAULT_NUM_ITER;
+
+/* ULT that uses the FPU across context switches */
+static void fpu_func(void *arg)
+{
+    double *p_result = (double *)arg;
+    double sum = 0.0;
+    int i;
+
+    for (i = 0; i < g_num_iter; i++) {
+        sum += 0.5;
+        ABT_thread_yield();
+    }
+    *p_result = sum;
+}
+
+/* ULT that does not use the FPU */
+static void int_func(void *arg)
+{
+    int *p_result = (int *)arg;
+    int sum = 0;
+    int i;
+
+    for (i = 0; i < g_num_iter; i++) {
+        sum += 2;
+        ABT_thread_yield();
+    }
+    *p_result = sum;
+}
+
+/* Run the ULTs of the given kinds on the primary ES and return the time per
+ * context switch. */
+static double run(ABT_pool pool, ABT_thread_attr fpu_attr,
+                  ABT_thread_attr int_attr, double *fpu_results,
+                  int *int_results)
+{
+    ABT_thread *threads;
+    double start, end;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(2 * g_num_threads * sizeof(ABT_thread));
+    start = ABT_get_wtime();
+    for (i = 0; i < g_num_threads; i++) {
+        if (fpu_results) {
+            ret = ABT_thread_create(pool, fpu_func, &fpu_results[i], fpu_attr,
+                                    &threads[2 * i]);
+        } else {
+            ret = ABT_thread_create(pool, int_func, &int_results[2 * i],
+                                    fpu_attr, &threads[2 * i]);
+        }
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_create(pool, int_func, &int_results[2 * i + 1],
+                                int_attr, &threads[2 * i + 1]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < 2 * g_num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    end = ABT_get_wtime();
+    free(threads);
+
+    return (end - start) / (2.0 * g_num_threads * g_num_iter);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread_attr fpu_attr, nofpu_attr;
+    double *fpu_results;
+    int *int_results;
+    double t_fpu, t_mixed, t_nofpu;
+    int i, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        g_num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    ret = ABT_thread_attr_create(&fpu_attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_create(&nofpu_attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_fpu(nofpu_attr, ABT_FALSE);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_fpu");
+
+    fpu_results = (double *)malloc(g_num_threads * sizeof(double));
+    int_results = (int *)malloc(2 * g_num_threads * sizeof(int));
+
+    /* All ULTs save the FPU state. */
+    t_fpu = run(pool, fpu_attr, fpu_attr, NULL, int_results);
+    for (i = 0; i < 2 * g_num_threads; i++) {
+        assert(int_results[i] == 2 * g_num_iter);
+    }
+
+    /* ULTs using the FPU interleave with ULTs that do not. */
+    t_mixed = run(pool, fpu_attr, nofpu_attr, fpu_results, int_results);
+    for (i = 0; i < g_num_threads; i++) {
+        assert(fpu_results[i] == 0.5 * g_num_iter);
+        assert(int_results[2 * i + 1] == 2 * g_num_iter);
+    }
+
+    /* No ULT saves the FPU state. */
+    t_nofpu = run(pool, nofpu_attr, nofpu_attr, NULL, int_results);
+    for (i = 0; i < 2 * g_num_threads; i++) {
+        assert(int_results[i] == 2 * g_num_iter);
+    }
+
+    ABT_test_printf(1, "context switch with FPU   : %.1f ns\n"
+                       "context switch mixed      : %.1f ns\n"
+                       "context switch without FPU: %.1f ns\n",
+                       t_fpu * 1.0e9, t_mixed * 1.0e9, t_nofpu * 1.0e9);
+
+    ABT_thread_attr_free(&fpu_attr);
+    ABT_thread_attr_free(&nofpu_attr);
+    free(fpu_results);
+    free(int_results);
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
@@ -0,0 +1,116 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     4
+#define MAX_YIELDS              10000
+
+static int g_num_home = 0;
+
+/* Each ULT is created on one ES and is asked to migrate once.  It has to end
+ * up on its home ES. */
+void thread_func(void *arg)
+{
+    int i, ret, rank, home = (int)(intptr_t)arg;
+    ABT_thread thread;
+
+    ABT_thread_self(&thread);
+    ret = ABT_thread_migrate(thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_migrate");
+    for (i = 0; i < MAX_YIELDS; i++) {
+        ABT_xstream_self_rank(&rank);
+        if (rank == home) break;
+        ABT_thread_yield();
+    }
+    ABT_test_printf(1, "[home %d]: on ES %d\n", home, rank);
+    if (rank == home) __sync_fetch_and_add(&g_num_home, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, j, ret, home;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr attr;
+
+    if (argc > 1) num_xstreams = atoi(argv[1]);
+    assert(num_xstreams >= 2);
+    if (argc > 2) num_threads = atoi(argv[2]);
+    assert(num_threads >= 0);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams *
+                                   num_threads);
+
+    ABT_test_init(argc, argv);
+
+    /* The hint is a rank or ABT_XSTREAM_ANY_RANK. */
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_get_home(attr, &home);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_get_home");
+    assert(home == ABT_XSTREAM_ANY_RANK);
+    ret = ABT_thread_attr_set_home(attr, -2);
+    assert(ret == ABT_ERR_INV_THREAD_ATTR);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* The ULTs created on ES i have the next ES as their home. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_rank(xstreams[(i + 1) % num_xstreams], &home);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_rank");
+        ret = ABT_thread_attr_set_home(attr, home);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_set_home");
+        for (j = 0; j < num_threads; j++) {
+            ret = ABT_thread_create(pools[i], thread_func,
+                                    (void *)(intptr_t)home, attr,
+                                    &threads[i * num_threads + j]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    if (g_num_home != num_xstreams * num_threads) {
+        fprintf(stderr, "%d ULTs out of %d reached their home ES\n",
+                g_num_home, num_xstreams * num_threads);
+    }
+    ret = ABT_test_finalize(g_num_home != num_xstreams * num_threads);
+
+    free(threads);
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
@@ -11,14 +11,25 @@
 #define DEFAULT_NUM_XSTREAMS    4
 #define DEFAULT_NUM_THREADS     4
 
+/* IDs of the ULTs, which are handed out by several ESs */
+static ABT_thread_id *g_ids;
+
 void thread_func(void *arg)
 {
-    ABT_TEST_UNUSED(arg);
+    size_t tid = (size_t)arg;
     ABT_thread thread;
     ABT_thread_id thread_id;
     ABT_thread_self(&thread);
     ABT_thread_get_id(thread, &thread_id);
     ABT_test_printf(1, "My thread id is %lu\n", thread_id);
+    g_ids[tid - 1] = thread_id;
+}
+
+static int cmp_ids(const void *p1, const void *p2)
+{
+    ABT_thread_id id1 = *(const ABT_thread_id *)p1;
+    ABT_thread_id id2 = *(const ABT_thread_id *)p2;
+    return (id1 > id2) - (id1 < id2);
 }
 
 int main(int argc, char *argv[])
@@ -34,6 +45,8 @@ int main(int argc, char *argv[])
 
     ABT_xstream *xstreams;
     xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    g_ids = (ABT_thread_id *)malloc(sizeof(ABT_thread_id) * num_xstreams *
+                                    num_threads);
 
     /* Initialize */
     ABT_test_init(argc, argv);
@@ -77,9 +90,17 @@ int main(int argc, char *argv[])
         ABT_TEST_ERROR(ret, "ABT_xstream_free");
     }
 
+    /* No two ULTs have the same ID. */
+    int err = 0;
+    qsort(g_ids, num_xstreams * num_threads, sizeof(ABT_thread_id), cmp_ids);
+    for (i = 1; i < num_xstreams * num_threads; i++) {
+        if (g_ids[i] == g_ids[i - 1]) err++;
+    }
+
     /* Finalize */
-    ret = ABT_test_finalize(0);
+    ret = ABT_test_finalize(err);
 
+    free(g_ids);
     free(pools);
     free(xstreams);
 
@@ -0,0 +1,211 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     256
+
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    int i, num_yields = (int)(intptr_t)arg;
+    for (i = 0; i < num_yields; i++) {
+        ABT_thread_yield();
+    }
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Create unnamed ULTs counted by a join counter over the pools and wait for
+ * all of them at once */
+static int run_counted(ABT_pool *pools, int num_pools, int num_threads)
+{
+    ABT_join_counter counter;
+    ABT_thread_attr attr;
+    uint32_t count;
+    int i, ret, err = 0, expected = g_counter + num_threads;
+
+    ret = ABT_join_counter_create(&counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_create");
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_join_counter(attr, counter);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_join_counter");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_pools], thread_func,
+                                (void *)(intptr_t)(i % 3), attr, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_join_counter_wait(counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_wait");
+
+    if (g_counter != expected) {
+        fprintf(stderr, "woken up before all ULTs terminate: %d (%d)\n",
+                g_counter, expected);
+        err++;
+    }
+    ret = ABT_join_counter_get_count(counter, &count);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_get_count");
+    if (count != 0) {
+        fprintf(stderr, "count is %u after the wait\n", count);
+        err++;
+    }
+
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+    ret = ABT_join_counter_free(&counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_free");
+    return err;
+}
+
+/* Revived ULTs are counted again. */
+static int run_revived(ABT_pool pool, int num_threads)
+{
+    ABT_join_counter counter;
+    ABT_thread_attr attr;
+    ABT_thread *threads;
+    int i, ret, err = 0, expected;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    ret = ABT_join_counter_create(&counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_create");
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_join_counter(attr, counter);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_join_counter");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)1, attr,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_join_counter_wait(counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_wait");
+
+    expected = g_counter + num_threads;
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_revive(pool, thread_func, (void *)(intptr_t)2,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_revive");
+    }
+    ret = ABT_join_counter_wait(counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_wait");
+    if (g_counter != expected) {
+        fprintf(stderr, "revived ULTs are not counted: %d (%d)\n",
+                g_counter, expected);
+        err++;
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+    ret = ABT_join_counter_free(&counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_free");
+    free(threads);
+    return err;
+}
+
+/* Join named ULTs at once, some of which have already terminated */
+static int run_join_many(ABT_pool *pools, int num_pools, int num_threads)
+{
+    ABT_thread *threads;
+    ABT_thread_state state;
+    int i, ret, err = 0, expected = g_counter + num_threads;
+
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_pools], thread_func,
+                                (void *)(intptr_t)(i % 2), ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_join(threads[num_threads / 2]);
+    ABT_TEST_ERROR(ret, "ABT_thread_join");
+    ret = ABT_thread_join_many(num_threads, threads);
+    ABT_TEST_ERROR(ret, "ABT_thread_join_many");
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_get_state(threads[i], &state);
+        ABT_TEST_ERROR(ret, "ABT_thread_get_state");
+        if (state != ABT_THREAD_STATE_TERMINATED) {
+            fprintf(stderr, "ULT %d has not terminated\n", i);
+            err++;
+        }
+    }
+    if (g_counter != expected) {
+        fprintf(stderr, "%d ULTs run (expected %d)\n", g_counter, expected);
+        err++;
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+    return err;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_join_counter counter;
+    int i, ret, err = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Waiting on an unused counter returns immediately. */
+    ret = ABT_join_counter_create(&counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_create");
+    ret = ABT_join_counter_wait(counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_wait");
+    ret = ABT_join_counter_free(&counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_free");
+
+    /* ULTs on the primary ES only and on all the ESs */
+    err += run_counted(pools, 1, num_threads);
+    err += run_counted(pools, num_xstreams, num_threads);
+    err += run_counted(&pools[num_xstreams - 1], 1, num_threads);
+    err += run_revived(pools[0], num_threads);
+    err += run_join_many(pools, 1, num_threads);
+    err += run_join_many(pools, num_xstreams, num_threads);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+
+    return ABT_test_finalize(err);
+}
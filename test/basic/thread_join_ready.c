@@ -0,0 +1,111 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_ITER        1000
+
+/* A ULT joins another one in the same MPSC pool right when a third ULT on
+ * another ES makes the target ready, so that the target is often ready but
+ * not pushed yet when the join looks for it. */
+
+static ABT_eventual g_eventual;
+static volatile int g_go = 0;
+static volatile int g_quit = 0;
+static int g_num_runs = 0;
+
+static void target_func(void *arg)
+{
+    int ret = ABT_eventual_wait(g_eventual, NULL);
+    ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+    g_num_runs++;
+}
+
+static void waker_func(void *arg)
+{
+    int ret;
+    while (1) {
+        while (g_go == 0 && g_quit == 0) ABT_thread_yield();
+        if (g_quit) break;
+        g_go = 0;
+        ret = ABT_eventual_set(g_eventual, NULL, 0);
+        ABT_TEST_ERROR(ret, "ABT_eventual_set");
+    }
+}
+
+static void joiner_func(void *arg)
+{
+    ABT_pool pool = *(ABT_pool *)arg;
+    int num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    ABT_thread thread;
+    int i, ret;
+
+    if (num_iter <= 1) num_iter = DEFAULT_NUM_ITER;
+    for (i = 0; i < num_iter; i++) {
+        ret = ABT_eventual_reset(g_eventual);
+        ABT_TEST_ERROR(ret, "ABT_eventual_reset");
+        ret = ABT_thread_create(pool, target_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        /* Let the target block on the eventual. */
+        ABT_thread_yield();
+        g_go = 1;
+        ret = ABT_thread_join(thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_join");
+        ret = ABT_thread_free(&thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    g_quit = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstreams[2];
+    ABT_pool pools[2];
+    ABT_thread joiner, waker;
+    int num_iter, i, ret;
+
+    ABT_test_init(argc, argv);
+    num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    if (num_iter <= 1) num_iter = DEFAULT_NUM_ITER;
+
+    for (i = 0; i < 2; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPSC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pools[i],
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+    ret = ABT_eventual_create(0, &g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+
+    ret = ABT_thread_create(pools[1], waker_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &waker);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_create(pools[0], joiner_func, &pools[0],
+                            ABT_THREAD_ATTR_NULL, &joiner);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+
+    ret = ABT_thread_free(&joiner);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ret = ABT_thread_free(&waker);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    for (i = 0; i < 2; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_eventual_free(&g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+
+    ABT_test_printf(1, "%d of %d targets ran\n", g_num_runs, num_iter);
+    ret = ABT_test_finalize(g_num_runs != num_iter);
+    return ret;
+}
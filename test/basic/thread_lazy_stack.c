@@ -0,0 +1,119 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     1000
+#define DEFAULT_NUM_ROUNDS      4
+#define BUF_SIZE                (8 * 1024)
+
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    char buf[BUF_SIZE];
+    size_t i, sum = 0;
+
+    /* Touch several pages of the stack */
+    memset(buf, (int)(size_t)arg, BUF_SIZE);
+    for (i = 0; i < BUF_SIZE; i += 512) sum += buf[i];
+    assert(sum == (BUF_SIZE / 512) * (size_t)(char)(size_t)arg);
+
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* Stacks are committed lazily and have guard pages.  ULTs touching their
+ * stacks are created in several rounds so that stacks cached by the primary
+ * ES are reclaimed and reused. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_rounds = DEFAULT_NUM_ROUNDS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int i, r, ret;
+
+    setenv("ABT_MEM_LAZY_STACK", "1", 1);
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_rounds   = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs   : %d\n"
+                       "# of ULTs  : %d\n"
+                       "# of rounds: %d\n",
+                       num_xstreams, num_threads, num_rounds);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    for (r = 0; r < num_rounds; r++) {
+        /* Create ULTs before any ES consumes the pools */
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                    (void *)(size_t)(r + 1),
+                                    ABT_THREAD_ATTR_NULL, &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+
+        /* Create Execution Streams */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pools[i],
+                                           ABT_SCHED_CONFIG_NULL,
+                                           &xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+        }
+
+        /* Join and free Execution Streams.  They stop once their pools are
+         * drained, so all ULTs have terminated afterwards. */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_join(xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+
+        /* Free ULTs, whose stacks are cached by the primary ES */
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+    }
+
+    /* Free pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != num_threads * num_rounds);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,87 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define TIMEOUT     10.0    /* sec */
+
+static volatile int g_flag = 0;
+static int g_timedout = 0;
+
+/* Spin without yielding until the other ULT on the same ES sets the flag,
+ * which is possible only if this ULT is preempted. */
+static void spin_func(void *arg)
+{
+    double start = ABT_get_wtime();
+    uint64_t count = 0;
+    ABT_TEST_UNUSED(arg);
+
+    while (g_flag == 0) {
+        if ((++count & 0xfffff) == 0 && ABT_get_wtime() - start > TIMEOUT) {
+            g_timedout = 1;
+            break;
+        }
+    }
+}
+
+static void set_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    g_flag = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread_attr attr;
+    ABT_thread threads[2];
+    int i, ret;
+
+    /* 1 ms quantum */
+    setenv("ABT_PREEMPTION_INTERVAL", "1000", 1);
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_preemptible(attr, ABT_TRUE);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        ABT_test_printf(1, "Preemption is not supported\n");
+        ABT_thread_attr_free(&attr);
+        return ABT_test_finalize(0);
+    }
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_preemptible");
+
+    /* The spinning ULT runs first. */
+    ret = ABT_thread_create(pool, spin_func, NULL, attr, &threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_create(pool, set_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[1]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    if (g_timedout) {
+        fprintf(stderr, "The spinning ULT was not preempted\n");
+        ABT_test_error(ABT_ERR_OTHER, "preemption", __FILE__, __LINE__);
+    }
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
@@ -0,0 +1,130 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_ITER        20
+
+/* ULTs spread over the main pools of all ESs suspend themselves repeatedly,
+ * and the main ULT resumes all of them with one call each time they are all
+ * blocked.  Every ULT has to be resumed exactly once per round.  The list
+ * passed to ABT_thread_resume_many() interleaves the pools. */
+
+static int g_num_errors = 0;
+static int *g_counts;
+static int g_num_iter;
+
+static void thread_func(void *arg)
+{
+    int rank = (int)(intptr_t)arg;
+    int i, ret;
+
+    for (i = 0; i < g_num_iter; i++) {
+        ret = ABT_self_suspend();
+        ABT_TEST_ERROR(ret, "ABT_self_suspend");
+        g_counts[rank]++;
+    }
+}
+
+static void wait_blocked(ABT_thread thread)
+{
+    ABT_thread_state state;
+    int ret;
+
+    while (1) {
+        ret = ABT_thread_get_state(thread, &state);
+        ABT_TEST_ERROR(ret, "ABT_thread_get_state");
+        if (state == ABT_THREAD_STATE_BLOCKED) break;
+        ret = ABT_thread_yield();
+        ABT_TEST_ERROR(ret, "ABT_thread_yield");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    ABT_pool *pools;
+    int i, r, ret;
+
+    ABT_test_init(argc, argv);
+    g_num_iter = DEFAULT_NUM_ITER;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0 && num_threads > 0);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    g_counts = (int *)calloc(num_threads, sizeof(int));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+
+    for (r = 1; r <= g_num_iter; r++) {
+        for (i = 0; i < num_threads; i++) wait_blocked(threads[i]);
+        for (i = 0; i < num_threads; i++) {
+            if (g_counts[i] != r - 1) {
+                fprintf(stderr, "ULT %d: count %d in round %d\n", i,
+                        g_counts[i], r);
+                g_num_errors++;
+            }
+        }
+        ret = ABT_thread_resume_many(num_threads, threads);
+        ABT_TEST_ERROR(ret, "ABT_thread_resume_many");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+        if (g_counts[i] != g_num_iter) {
+            fprintf(stderr, "ULT %d: count %d, expected %d\n", i, g_counts[i],
+                    g_num_iter);
+            g_num_errors++;
+        }
+    }
+
+    /* Resuming no ULT is not an error. */
+    ret = ABT_thread_resume_many(0, threads);
+    ABT_TEST_ERROR(ret, "ABT_thread_resume_many");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(g_counts);
+    free(threads);
+    free(pools);
+    free(xstreams);
+
+    return ABT_test_finalize(g_num_errors);
+}
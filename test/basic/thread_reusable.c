@@ -0,0 +1,149 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     256
+
+static int g_counter = 0;
+static int g_sum = 0;
+
+static void thread_func(void *arg)
+{
+    int value = (int)(intptr_t)arg;
+    __sync_fetch_and_add(&g_counter, 1);
+    __sync_fetch_and_add(&g_sum, value);
+}
+
+/* Run unnamed ULTs until all of them finish */
+static void run_unnamed(ABT_pool pool, ABT_thread_attr attr, int num_threads)
+{
+    int i, ret, expected = g_counter + num_threads;
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)1, attr,
+                                NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    while (*(volatile int *)&g_counter < expected) {
+        ABT_thread_yield();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream xstream, new_xstream;
+    ABT_pool pool, new_pool;
+    ABT_thread_attr attr, attr_large;
+    ABT_thread thread, first, reused, other;
+    ABT_thread_id id1, id2;
+    size_t stacksize;
+    int i, ret, err = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_reusable(attr, ABT_TRUE);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_reusable");
+    ret = ABT_thread_attr_get_stacksize(attr, &stacksize);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_get_stacksize");
+    ret = ABT_thread_attr_create(&attr_large);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_reusable(attr_large, ABT_TRUE);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_reusable");
+    ret = ABT_thread_attr_set_stacksize(attr_large, stacksize * 2);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_stacksize");
+
+    /* A freed ULT is recycled by the next creation on the same ES. */
+    ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)2, attr,
+                            &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_get_id(thread, &id1);
+    ABT_TEST_ERROR(ret, "ABT_thread_get_id");
+    first = thread;
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)3, attr,
+                            &reused);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_get_id(reused, &id2);
+    ABT_TEST_ERROR(ret, "ABT_thread_get_id");
+    if (reused != first) {
+        fprintf(stderr, "the freed ULT is not recycled\n");
+        err++;
+    }
+    ret = ABT_thread_free(&reused);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    if (g_sum != 5) {
+        fprintf(stderr, "the recycled ULT ran with a wrong argument\n");
+        err++;
+    }
+    if (id1 == id2) {
+        fprintf(stderr, "the recycled ULT has the same ID\n");
+        err++;
+    }
+
+    /* A ULT of another stack size is not recycled. */
+    ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)0,
+                            attr_large, &other);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    first = other;
+    ret = ABT_thread_free(&other);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)0, attr,
+                            &reused);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    if (reused == first) {
+        fprintf(stderr, "a ULT of another stack size is recycled\n");
+        err++;
+    }
+    ret = ABT_thread_free(&reused);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    /* Unnamed ULTs are recycled when they finish. */
+    for (i = 0; i < 4; i++) {
+        run_unnamed(pool, attr, num_threads);
+    }
+
+    /* The recycled ULTs of a secondary ES are released when it finishes. */
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_xstream_get_main_pools(new_xstream, 1, &new_pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    for (i = 0; i < 4; i++) {
+        run_unnamed(new_pool, attr, num_threads);
+    }
+    ret = ABT_xstream_join(new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&new_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    if (g_counter != 4 + 8 * num_threads) {
+        fprintf(stderr, "%d ULTs run (expected %d)\n", g_counter,
+                4 + 8 * num_threads);
+        err++;
+    }
+
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+    ret = ABT_thread_attr_free(&attr_large);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    return ABT_test_finalize(err);
+}
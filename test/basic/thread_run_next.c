@@ -0,0 +1,177 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_ITER        100
+
+/* With the run-next policy, the ULT created last on an ES runs as soon as its
+ * creator stops, ahead of the ULTs queued in the pool, and ULTs queued in the
+ * pool still run in between. */
+
+static int g_num_iter = DEFAULT_NUM_ITER;
+static int g_order = 0;
+static int g_child_order = -1;
+static int g_num_children = 0;
+static int g_num_probes = 0;
+static volatile int g_done = 0;
+
+static void filler_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    g_order++;
+}
+
+static void child_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    g_child_order = g_order++;
+}
+
+static void count_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_num_children, 1);
+}
+
+/* Creates a child and yields in each iteration. */
+static void spawn_func(void *arg)
+{
+    int i, ret;
+    ABT_pool pool = (ABT_pool)arg;
+
+    for (i = 0; i < g_num_iter; i++) {
+        ret = ABT_thread_create(pool, count_func, NULL, ABT_THREAD_ATTR_NULL,
+                                NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ABT_thread_yield();
+    }
+    g_done = 1;
+}
+
+static void probe_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    while (g_done == 0) {
+        g_num_probes++;
+        ABT_thread_yield();
+    }
+}
+
+/* Creates children and joins them at once. */
+static void join_func(void *arg)
+{
+    ABT_pool pool;
+    ABT_thread self, threads[4];
+    int i, ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_thread_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_thread_self");
+    ret = ABT_thread_get_last_pool(self, &pool);
+    ABT_TEST_ERROR(ret, "ABT_thread_get_last_pool");
+    for (i = 0; i < 4; i++) {
+        ret = ABT_thread_create(pool, count_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 3; i >= 0; i--) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int i, ret;
+
+    setenv("ABT_RUN_NEXT", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstreams[0], 1, &pools[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* The child created last runs first. */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[0], filler_func, NULL,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_create(pools[0], child_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ABT_thread_yield();
+    ret = ABT_thread_free(&threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    while (g_order != num_threads + 1) ABT_thread_yield();
+    ABT_test_printf(1, "order of the child: %d\n", g_child_order);
+    assert(g_child_order == 0);
+
+    /* The children do not starve the ULTs in the pool. */
+    ret = ABT_thread_create(pools[0], spawn_func, (void *)pools[0],
+                            ABT_THREAD_ATTR_NULL, &threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_create(pools[0], probe_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[1]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    while (g_num_children != g_num_iter) ABT_thread_yield();
+    ABT_test_printf(1, "probes: %d / %d\n", g_num_probes, g_num_iter);
+    assert(g_num_probes >= g_num_iter / 2);
+
+    /* Children in the slot can be joined on every ES. */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    g_num_children = 0;
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], join_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_num_children == num_threads * 4);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ABT_test_finalize(0);
+}
@@ -0,0 +1,131 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     1000
+#define MAX_SLEEP_MSEC          60
+
+static int g_num_late = 0;
+
+static double get_time(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + 1.0e-6 * (double)tv.tv_usec;
+}
+
+/* Each ULT sleeps for a different time, which covers the buckets of the
+ * first two levels of the timer wheel, and checks it did not wake up early. */
+static void thread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    double sec = 1.0e-3 * (double)(idx % MAX_SLEEP_MSEC);
+    double start = get_time();
+    int ret;
+
+    if (idx % 2 == 0) {
+        ret = ABT_thread_sleep(sec);
+        ABT_TEST_ERROR(ret, "ABT_thread_sleep");
+    } else {
+        struct timespec ts;
+        double deadline = start + sec;
+        ts.tv_sec = (time_t)deadline;
+        ts.tv_nsec = (long)((deadline - (double)ts.tv_sec) * 1.0e9);
+        ret = ABT_thread_sleep_until(&ts);
+        ABT_TEST_ERROR(ret, "ABT_thread_sleep_until");
+    }
+    if (get_time() < start + sec - 1.0e-5) {
+        __sync_fetch_and_add(&g_num_late, 1);
+    }
+}
+
+static void task_func(void *arg)
+{
+    int *p_ret = (int *)arg;
+    *p_ret = ABT_thread_sleep(0.001);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int num_xstreams, num_threads;
+    int i, ret, task_ret = ABT_SUCCESS;
+    double start;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    num_xstreams = DEFAULT_NUM_XSTREAMS;
+    num_threads = DEFAULT_NUM_THREADS;
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    assert(num_xstreams > 0 && num_threads > 0);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* All the ULTs sleep at the same time, so they have to finish in about
+     * the longest sleep time. */
+    start = get_time();
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ABT_test_printf(1, "elapsed: %.3f sec\n", get_time() - start);
+    assert(g_num_late == 0);
+
+    /* A tasklet cannot sleep. */
+    ret = ABT_task_create(pools[0], task_func, &task_ret, NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    ABT_thread_yield();
+    while (task_ret == ABT_SUCCESS) ABT_thread_yield();
+    assert(task_ret == ABT_ERR_INV_THREAD);
+
+    /* Join Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,168 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     200
+#define DEFAULT_NUM_ROUNDS      3
+#define NUM_STACKSIZES          5
+
+/* Stack sizes of size classes, ones between classes, and one that is too
+ * large for any class */
+static const size_t g_stacksizes[NUM_STACKSIZES] = {
+    4096, 12000, 65536, 256 * 1024, 3 * 1024 * 1024
+};
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    size_t i, stacksize, expected = (size_t)arg;
+    ABT_thread thread;
+    ABT_thread_attr attr;
+    int ret;
+
+    ABT_thread_self(&thread);
+    ret = ABT_thread_get_attr(thread, &attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_get_attr");
+    ret = ABT_thread_attr_get_stacksize(attr, &stacksize);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_get_stacksize");
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    /* The header of a ULT is placed in its stack. */
+    assert(stacksize <= expected && stacksize + 4096 > expected);
+
+    /* Touch the usable stack except for a margin.  No function is called
+     * while the stack is touched since even the lazy binding of a function
+     * might need a few kilobytes of the stack. */
+    if (stacksize > 2048) {
+        size_t len = stacksize - 2048;
+        volatile char *buf = (volatile char *)__builtin_alloca(len);
+        for (i = 0; i < len; i++) buf[i] = 1;
+        for (i = 0; i < len; i += 1024) assert(buf[i] == 1);
+    }
+
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* ULTs with various stack sizes are created and freed in several rounds so
+ * that stacks of each size class are recycled. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_rounds = DEFAULT_NUM_ROUNDS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr attrs[NUM_STACKSIZES];
+    int i, r, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_rounds   = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs   : %d\n"
+                       "# of ULTs  : %d\n"
+                       "# of rounds: %d\n",
+                       num_xstreams, num_threads, num_rounds);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* Call the functions used by the ULTs once here so that their lazy
+     * binding does not run on the small stacks of the ULTs. */
+    {
+        ABT_thread thread;
+        ABT_thread_attr attr;
+        size_t stacksize;
+        ret = ABT_thread_self(&thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_self");
+        ret = ABT_thread_get_attr(thread, &attr);
+        ABT_TEST_ERROR(ret, "ABT_thread_get_attr");
+        ret = ABT_thread_attr_get_stacksize(attr, &stacksize);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_get_stacksize");
+        ret = ABT_thread_attr_free(&attr);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+    }
+
+    /* Create ULT attributes */
+    for (i = 0; i < NUM_STACKSIZES; i++) {
+        ret = ABT_thread_attr_create(&attrs[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+        ret = ABT_thread_attr_set_stacksize(attrs[i], g_stacksizes[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_set_stacksize");
+    }
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    for (r = 0; r < num_rounds; r++) {
+        /* Create ULTs before any ES consumes the pools */
+        for (i = 0; i < num_threads; i++) {
+            int k = (i + r) % NUM_STACKSIZES;
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                    (void *)g_stacksizes[k], attrs[k],
+                                    &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+
+        /* Create Execution Streams */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pools[i],
+                                           ABT_SCHED_CONFIG_NULL,
+                                           &xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+        }
+
+        /* Join and free Execution Streams.  They stop once their pools are
+         * drained, so all ULTs have terminated afterwards. */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_join(xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+
+        /* Free ULTs */
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+    }
+
+    /* Free pools and attributes */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+    for (i = 0; i < NUM_STACKSIZES; i++) {
+        ret = ABT_thread_attr_free(&attrs[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != num_threads * num_rounds);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,132 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     200
+#define DEFAULT_NUM_ROUNDS      3
+#define STACKSIZE               (64 * 1024)
+
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    char *p_stack = (char *)arg;
+    char local;
+
+    /* The ULT has to run on the stack given by the user. */
+    assert(p_stack < &local && &local < p_stack + STACKSIZE);
+
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+/* ULTs with stacks given by the user are created and freed in several rounds
+ * so that the same stacks are reused by new ULTs. */
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_rounds = DEFAULT_NUM_ROUNDS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr *attrs;
+    char **stacks;
+    int i, r, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_rounds   = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    assert(num_xstreams > 0);
+    ABT_test_printf(1, "# of ESs   : %d\n"
+                       "# of ULTs  : %d\n"
+                       "# of rounds: %d\n",
+                       num_xstreams, num_threads, num_rounds);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools    = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads  = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    attrs    = (ABT_thread_attr *)malloc(num_threads * sizeof(ABT_thread_attr));
+    stacks   = (char **)malloc(num_threads * sizeof(char *));
+
+    /* Create stacks and ULT attributes */
+    for (i = 0; i < num_threads; i++) {
+        stacks[i] = (char *)malloc(STACKSIZE);
+        ret = ABT_thread_attr_create(&attrs[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+        ret = ABT_thread_attr_set_stack(attrs[i], stacks[i], STACKSIZE);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_set_stack");
+    }
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_FALSE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    for (r = 0; r < num_rounds; r++) {
+        /* Create ULTs before any ES consumes the pools */
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                    (void *)stacks[i], attrs[i], &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+
+        /* Create Execution Streams */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pools[i],
+                                           ABT_SCHED_CONFIG_NULL,
+                                           &xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+        }
+
+        /* Join and free Execution Streams.  They stop once their pools are
+         * drained, so all ULTs have terminated afterwards. */
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_join(xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+
+        /* Free ULTs.  Their stacks are not freed by Argobots. */
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+    }
+
+    /* Free pools, attributes, and stacks */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_free(&pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_free");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_attr_free(&attrs[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+        free(stacks[i]);
+    }
+
+    /* Finalize */
+    ret = ABT_test_finalize(g_counter != num_threads * num_rounds);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(attrs);
+    free(stacks);
+
+    return ret;
+}
@@ -0,0 +1,91 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define NUM_XSTREAMS    2
+#define NUM_THREADS     8
+#define NUM_ITER        1000
+
+static ABT_pool g_pools[NUM_XSTREAMS];
+
+/* ULTs with and without the vector state keep their own values across
+ * context switches. */
+static void thread_func(void *arg)
+{
+    int rank = (int)(intptr_t)arg;
+    double vec[8];
+    int i, j, ret;
+
+    for (j = 0; j < 8; j++) vec[j] = rank + j;
+    for (i = 0; i < NUM_ITER; i++) {
+        for (j = 0; j < 8; j++) vec[j] = vec[j] * 1.0 + 0.25;
+        ret = ABT_thread_yield();
+        ABT_TEST_ERROR(ret, "ABT_thread_yield");
+    }
+    for (j = 0; j < 8; j++) {
+        assert(vec[j] == rank + j + 0.25 * NUM_ITER);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstreams[NUM_XSTREAMS];
+    ABT_thread threads[NUM_THREADS];
+    ABT_thread_attr attr;
+    int i, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_thread_attr_create(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_vector_state(attr, ABT_TRUE);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        ABT_test_printf(1, "XSAVE is not available\n");
+    } else {
+        ABT_TEST_ERROR(ret, "ABT_thread_attr_set_vector_state");
+    }
+
+    /* Every other ULT saves the vector state. */
+    for (i = 0; i < NUM_THREADS; i++) {
+        ret = ABT_thread_create(g_pools[i % NUM_XSTREAMS], thread_func,
+                                (void *)(intptr_t)i,
+                                (i % 2) ? attr : ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < NUM_THREADS; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    /* Join Execution Streams */
+    for (i = 1; i < NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
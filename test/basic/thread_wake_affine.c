@@ -0,0 +1,139 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     16
+#define DEFAULT_NUM_ITER        200
+
+/* The secondary ESs share one pool.  With the wake-affinity policy, a ULT
+ * woken up while the pool is empty runs again on the ES where it blocked,
+ * even though any of them could pop it. */
+
+static ABT_eventual g_ev;
+static ABT_mutex g_mutex;
+static volatile int g_num_wakeups = 0;
+static int g_num_iter = DEFAULT_NUM_ITER;
+static int g_num_moved = 0;
+static int g_counter = 0;
+
+static void wait_func(void *arg)
+{
+    int i, rank_before, rank_after;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_num_iter; i++) {
+        /* Yielding lets the ULT move between the ESs. */
+        ABT_thread_yield();
+        ABT_xstream_self_rank(&rank_before);
+        ABT_eventual_wait(g_ev, NULL);
+        ABT_eventual_reset(g_ev);
+        ABT_xstream_self_rank(&rank_after);
+        if (rank_after != rank_before) g_num_moved++;
+        g_num_wakeups++;
+    }
+}
+
+static void lock_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_num_iter; i++) {
+        ABT_mutex_lock(g_mutex);
+        g_counter++;
+        ABT_mutex_unlock(g_mutex);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    ABT_sched *scheds;
+    ABT_pool pool;
+    ABT_thread_state state;
+    int i, ret;
+
+    setenv("ABT_WAKE_AFFINE", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+    if (num_xstreams < 2) num_xstreams = 2;
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    scheds = (ABT_sched *)malloc(sizeof(ABT_sched) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_sched_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    ret = ABT_eventual_create(0, &g_ev);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_mutex_create(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create");
+
+    /* The primary ES wakes up a single ULT of the shared pool. */
+    ret = ABT_thread_create(pool, wait_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    for (i = 0; i < g_num_iter; i++) {
+        while (g_num_wakeups != i) ABT_thread_yield();
+        do {
+            ABT_thread_yield();
+            ret = ABT_thread_get_state(threads[0], &state);
+            ABT_TEST_ERROR(ret, "ABT_thread_get_state");
+        } while (state != ABT_THREAD_STATE_BLOCKED);
+        ret = ABT_eventual_set(g_ev, NULL, 0);
+        ABT_TEST_ERROR(ret, "ABT_eventual_set");
+    }
+    ret = ABT_thread_free(&threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ABT_test_printf(1, "moved on wakeup: %d / %d\n", g_num_moved, g_num_iter);
+    assert(g_num_wakeups == g_num_iter);
+    assert(g_num_moved == 0);
+
+    /* Contended ULTs wake each other up. */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, lock_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_counter == num_threads * g_num_iter);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ABT_mutex_free(&g_mutex);
+    ABT_eventual_free(&g_ev);
+    free(xstreams);
+    free(scheds);
+    free(threads);
+
+    return ABT_test_finalize(0);
+}
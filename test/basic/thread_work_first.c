@@ -0,0 +1,171 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_N               15
+
+static ABT_thread_attr g_attr;
+static int g_flag = 0;
+
+typedef struct {
+    int n;
+    int result;
+} fib_arg_t;
+
+void set_flag(void *arg)
+{
+    g_flag = (int)(intptr_t)arg;
+}
+
+/* Both children are created work-first, so the caller is pushed to the pool
+ * twice and can be stolen in between. */
+void fib_thread(void *arg)
+{
+    fib_arg_t *p_arg = (fib_arg_t *)arg;
+    int ret;
+
+    if (p_arg->n < 2) {
+        p_arg->result = p_arg->n;
+    } else {
+        ABT_pool pool;
+        ABT_thread threads[2];
+        fib_arg_t args[2] = { { p_arg->n - 1, 0 }, { p_arg->n - 2, 0 } };
+        int i;
+
+        ABT_thread self;
+        ret = ABT_thread_self(&self);
+        ABT_TEST_ERROR(ret, "ABT_thread_self");
+        ret = ABT_thread_get_last_pool(self, &pool);
+        ABT_TEST_ERROR(ret, "ABT_thread_get_last_pool");
+        for (i = 0; i < 2; i++) {
+            ret = ABT_thread_create(pool, fib_thread, &args[i], g_attr,
+                                    &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < 2; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+        p_arg->result = args[0].result + args[1].result;
+    }
+}
+
+static int fib_seq(int n)
+{
+    return (n < 2) ? n : fib_seq(n - 1) + fib_seq(n - 2);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret, err = 0;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int n = DEFAULT_N;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools;
+    ABT_pool main_pool;
+    ABT_thread self, thread;
+    fib_arg_t arg;
+
+    if (argc > 1) num_xstreams = atoi(argv[1]);
+    assert(num_xstreams > 0);
+    if (argc > 2) n = atoi(argv[2]);
+    assert(n >= 0);
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    scheds = (ABT_sched *)malloc(sizeof(ABT_sched) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+
+    ABT_test_init(argc, argv);
+
+    ret = ABT_thread_attr_create(&g_attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_thread_self");
+    ret = ABT_thread_get_last_pool(self, &main_pool);
+    ABT_TEST_ERROR(ret, "ABT_thread_get_last_pool");
+
+    /* A help-first ULT has not run when ABT_thread_create() returns, */
+    ret = ABT_thread_create(main_pool, set_flag, (void *)(intptr_t)1, g_attr,
+                            &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    if (g_flag != 0) err++;
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    if (g_flag != 1) err++;
+
+    /* but a work-first one in the caller's pool has. */
+    ret = ABT_thread_attr_set_work_first(g_attr, ABT_TRUE);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_work_first");
+    ret = ABT_thread_create(main_pool, set_flag, (void *)(intptr_t)2, g_attr,
+                            &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    if (g_flag != 2) err++;
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    if (err) fprintf(stderr, "wrong order of execution\n");
+
+    /* Divide and conquer on work-stealing schedulers */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ABT_pool *my_pools = (ABT_pool *)malloc(sizeof(ABT_pool) *
+                                                num_xstreams);
+        int k;
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        free(my_pools);
+    }
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    arg.n = n;
+    arg.result = 0;
+    ret = ABT_thread_create(pools[0], fib_thread, &arg, ABT_THREAD_ATTR_NULL,
+                            &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    if (arg.result != fib_seq(n)) {
+        fprintf(stderr, "fib(%d) = %d (expected %d)\n", n, arg.result,
+                fib_seq(n));
+        err++;
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_thread_attr_free(&g_attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+
+    ret = ABT_test_finalize(err);
+
+    free(pools);
+    free(scheds);
+    free(xstreams);
+
+    return ret;
+}
@@ -0,0 +1,164 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     4
+#define DEFAULT_NUM_ITER        10000
+#define TIMEOUT                 20      /* msec */
+
+static int g_num_threads;
+static int g_num_iter;
+static int g_counter = 0;
+static volatile int g_task_done = 0;
+static volatile int g_wait_done = 0;
+
+/* On a single ES with a FIFO pool, yielding ULTs run in round-robin order, so
+ * every other ULT runs once between two yields of a ULT.  In the last round,
+ * the ULTs that have already finished do not run. */
+static void round_robin_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_num_iter; i++) {
+        int prev = g_counter++;
+        ABT_thread_yield();
+        if (i < g_num_iter - 1) assert(g_counter == prev + g_num_threads);
+    }
+}
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    g_task_done = 1;
+}
+
+/* A tasklet pushed to the pool runs while ULTs keep yielding. */
+static void spawn_task_func(void *arg)
+{
+    ABT_pool pool = (ABT_pool)arg;
+    int ret = ABT_task_create(pool, task_func, NULL, NULL);
+    ABT_TEST_ERROR(ret, "ABT_task_create");
+    while (g_task_done == 0) {
+        ABT_thread_yield();
+    }
+}
+
+/* A timed wait expires while another ULT keeps yielding. */
+static void timedwait_func(void *arg)
+{
+    ABT_eventual eventual = (ABT_eventual)arg;
+    struct timespec ts;
+    struct timeval tv;
+    int ret;
+
+    gettimeofday(&tv, NULL);
+    ts.tv_sec = tv.tv_sec;
+    ts.tv_nsec = tv.tv_usec * 1000 + (long)TIMEOUT * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    ret = ABT_eventual_timedwait(eventual, NULL, &ts);
+    if (ret != ABT_ERR_TIMEDOUT) {
+        ABT_test_error(ABT_ERR_OTHER, "ABT_eventual_timedwait", __FILE__,
+                       __LINE__);
+    }
+    g_wait_done = 1;
+}
+
+static void poll_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    while (g_wait_done == 0) {
+        ABT_thread_yield();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread *threads;
+    ABT_eventual eventual;
+    double t_start, t_end;
+    int i, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        g_num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_iter    = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        g_num_threads = DEFAULT_NUM_THREADS;
+        g_num_iter    = DEFAULT_NUM_ITER;
+    }
+    ABT_test_printf(1, "# of ULTs      : %d\n", g_num_threads);
+    ABT_test_printf(1, "# of iterations: %d\n", g_num_iter);
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    threads = (ABT_thread *)malloc(g_num_threads * sizeof(ABT_thread));
+
+    /* The main ULT yields while its pool is empty. */
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_iter; i++) {
+        ret = ABT_thread_yield();
+        ABT_TEST_ERROR(ret, "ABT_thread_yield");
+    }
+    t_end = ABT_get_wtime();
+    ABT_test_printf(1, "yield (empty pool): %.3f us\n",
+                    (t_end - t_start) * 1.0e6 / g_num_iter);
+
+    /* Round-robin among ULTs */
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_create(pool, round_robin_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    t_end = ABT_get_wtime();
+    assert(g_counter == g_num_threads * g_num_iter);
+    ABT_test_printf(1, "yield (%d ULTs): %.3f us\n", g_num_threads,
+                    (t_end - t_start) * 1.0e6 / g_num_iter / g_num_threads);
+
+    /* Tasklets and timed waits are not starved by yielding ULTs. */
+    ret = ABT_thread_create(pool, spawn_task_func, (void *)pool,
+                            ABT_THREAD_ATTR_NULL, &threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    ret = ABT_eventual_create(0, &eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_thread_create(pool, timedwait_func, (void *)eventual,
+                            ABT_THREAD_ATTR_NULL, &threads[0]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_create(pool, poll_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &threads[1]);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_eventual_free(&eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+
+    free(threads);
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
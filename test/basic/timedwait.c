@@ -0,0 +1,189 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define NUM_XSTREAMS    2
+#define SHORT_TIMEOUT   20      /* msec */
+#define LONG_TIMEOUT    10000   /* msec */
+
+static ABT_mutex g_mutex;
+static ABT_eventual g_eventual;
+static ABT_future g_future;
+static ABT_barrier g_barrier;
+static ABT_pool g_pools[NUM_XSTREAMS];
+
+static void get_deadline(struct timespec *ts, int msec)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    ts->tv_sec = tv.tv_sec + msec / 1000;
+    ts->tv_nsec = tv.tv_usec * 1000 + (long)(msec % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+static void expect_ret(int ret, int expected, const char *msg)
+{
+    if (ret != expected) {
+        fprintf(stderr, "%s: %d (expected %d)\n", msg, ret, expected);
+        ABT_test_error(ABT_ERR_OTHER, msg, __FILE__, __LINE__);
+    }
+}
+
+static void run_on(int rank, void (*func)(void *), void *arg,
+                   ABT_thread *thread)
+{
+    int ret = ABT_thread_create(g_pools[rank], func, arg,
+                                ABT_THREAD_ATTR_NULL, thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+}
+
+static void join(ABT_thread *thread)
+{
+    int ret = ABT_thread_free(thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+}
+
+static void mutex_func(void *arg)
+{
+    int expected = (int)(intptr_t)arg;
+    struct timespec ts;
+    int ret;
+
+    get_deadline(&ts, expected == ABT_SUCCESS ? LONG_TIMEOUT : SHORT_TIMEOUT);
+    ret = ABT_mutex_timedlock(g_mutex, &ts);
+    expect_ret(ret, expected, "ABT_mutex_timedlock");
+    if (ret == ABT_SUCCESS) ABT_mutex_unlock(g_mutex);
+}
+
+static void eventual_func(void *arg)
+{
+    int expected = (int)(intptr_t)arg;
+    struct timespec ts;
+    int *value = NULL;
+    int ret;
+
+    get_deadline(&ts, expected == ABT_SUCCESS ? LONG_TIMEOUT : SHORT_TIMEOUT);
+    ret = ABT_eventual_timedwait(g_eventual, (void **)&value, &ts);
+    expect_ret(ret, expected, "ABT_eventual_timedwait");
+    if (ret == ABT_SUCCESS) assert(*value == 42);
+}
+
+static void future_func(void *arg)
+{
+    int expected = (int)(intptr_t)arg;
+    struct timespec ts;
+    int ret;
+
+    get_deadline(&ts, expected == ABT_SUCCESS ? LONG_TIMEOUT : SHORT_TIMEOUT);
+    ret = ABT_future_timedwait(g_future, &ts);
+    expect_ret(ret, expected, "ABT_future_timedwait");
+}
+
+static void barrier_func(void *arg)
+{
+    int expected = (int)(intptr_t)arg;
+    struct timespec ts;
+    int ret;
+
+    get_deadline(&ts, expected == ABT_SUCCESS ? LONG_TIMEOUT : SHORT_TIMEOUT);
+    ret = ABT_barrier_timedwait(g_barrier, &ts);
+    expect_ret(ret, expected, "ABT_barrier_timedwait");
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstreams[NUM_XSTREAMS];
+    ABT_thread threads[2];
+    int value = 42;
+    int i, ret;
+    void *timedout = (void *)(intptr_t)ABT_ERR_TIMEDOUT;
+    void *success = (void *)(intptr_t)ABT_SUCCESS;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Mutex: time out while the main ULT holds it, and then lock it after the
+     * main ULT releases it while waiting. */
+    ret = ABT_mutex_create(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create");
+    ABT_mutex_lock(g_mutex);
+    run_on(1, mutex_func, timedout, &threads[0]);
+    join(&threads[0]);
+    run_on(1, mutex_func, success, &threads[0]);
+    ABT_thread_yield();
+    ABT_mutex_unlock(g_mutex);
+    join(&threads[0]);
+    ret = ABT_mutex_free(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_free");
+
+    /* Eventual */
+    ret = ABT_eventual_create(sizeof(int), &g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+    run_on(1, eventual_func, timedout, &threads[0]);
+    join(&threads[0]);
+    run_on(0, eventual_func, success, &threads[0]);
+    run_on(1, eventual_func, success, &threads[1]);
+    ABT_thread_yield();
+    ABT_eventual_set(g_eventual, &value, sizeof(int));
+    join(&threads[0]);
+    join(&threads[1]);
+    ret = ABT_eventual_free(&g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+
+    /* Future */
+    ret = ABT_future_create(1, NULL, &g_future);
+    ABT_TEST_ERROR(ret, "ABT_future_create");
+    run_on(1, future_func, timedout, &threads[0]);
+    join(&threads[0]);
+    run_on(1, future_func, success, &threads[0]);
+    ABT_thread_yield();
+    ABT_future_set(g_future, NULL);
+    join(&threads[0]);
+    ret = ABT_future_free(&g_future);
+    ABT_TEST_ERROR(ret, "ABT_future_free");
+
+    /* Barrier: a lone waiter withdraws its arrival, so the next round still
+     * needs two waiters. */
+    ret = ABT_barrier_create(2, &g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_create");
+    run_on(1, barrier_func, timedout, &threads[0]);
+    join(&threads[0]);
+    run_on(0, barrier_func, success, &threads[0]);
+    run_on(1, barrier_func, success, &threads[1]);
+    join(&threads[0]);
+    join(&threads[1]);
+    ret = ABT_barrier_free(&g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_free");
+
+    /* Join Execution Streams */
+    for (i = 1; i < NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
@@ -57,6 +57,33 @@ void thread_create(void *arg)
     ABT_TEST_ERROR(ret, "ABT_timer_free");
 }
 
+/* The tick counter is monotonic and agrees with ABT_get_wtime().  The
+ * measurement is repeated a few times since this process may be preempted
+ * between reading the two clocks on a loaded machine. */
+#define NUM_TICKS_TRIALS    5
+void check_ticks(void)
+{
+    uint64_t t1, t2, prev;
+    double w1, w2, secs;
+    int i, num_agreed = 0;
+
+    for (i = 0; i < NUM_TICKS_TRIALS && num_agreed == 0; i++) {
+        t1 = prev = ABT_get_ticks();
+        w1 = ABT_get_wtime();
+        do {
+            t2 = ABT_get_ticks();
+            assert(t2 >= prev);
+            prev = t2;
+            w2 = ABT_get_wtime();
+        } while (w2 - w1 < 0.01);
+        secs = ABT_ticks_to_sec(t2 - t1);
+        ABT_test_printf(1, "Ticks         : %.9f sec for %.9f sec\n",
+                        secs, w2 - w1);
+        if (secs > (w2 - w1) * 0.5 && secs < (w2 - w1) * 2.0) num_agreed++;
+    }
+    assert(num_agreed > 0);
+}
+
 int main(int argc, char *argv[])
 {
     int i, ret;
@@ -74,7 +101,8 @@ int main(int argc, char *argv[])
     ABT_xstream *xstreams;
     ABT_pool *pools;
 
-    /* ABT_timer can be created regardless of Argobots initialization */
+    /* ABT_timer can be used regardless of Argobots initialization */
+    check_ticks();
     ret = ABT_timer_create(&timer);
     ABT_TEST_ERROR(ret, "ABT_timer_create");
 
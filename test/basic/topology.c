@@ -0,0 +1,111 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+
+static const char *g_level_names[ABT_TOPOLOGY_NUM_LEVELS] = {
+    "CPU", "core", "L3", "NUMA", "socket"
+};
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    int *ids, *dists;
+    int num_xstreams, num_nodes;
+    int i, j, level, ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    } else {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+    }
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    ids = (int *)malloc(num_xstreams * ABT_TOPOLOGY_NUM_LEVELS * sizeof(int));
+    dists = (int *)malloc(num_xstreams * num_xstreams * sizeof(int));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    ret = ABT_topology_get_num_nodes(&num_nodes);
+    ABT_TEST_ERROR(ret, "ABT_topology_get_num_nodes");
+    assert(num_nodes >= 1);
+
+    /* IDs of the objects that contain each ES */
+    for (i = 0; i < num_xstreams; i++) {
+        int *p_ids = &ids[i * ABT_TOPOLOGY_NUM_LEVELS];
+        for (level = 0; level < ABT_TOPOLOGY_NUM_LEVELS; level++) {
+            ret = ABT_topology_get_id(xstreams[i], level, &p_ids[level]);
+            ABT_TEST_ERROR(ret, "ABT_topology_get_id");
+            ABT_test_printf(1, "[E%d] %s: %d\n", i, g_level_names[level],
+                            p_ids[level]);
+        }
+        if (p_ids[ABT_TOPOLOGY_CPU] < 0) {
+            for (level = 0; level < ABT_TOPOLOGY_NUM_LEVELS; level++) {
+                assert(p_ids[level] == -1);
+            }
+        } else {
+            int cpuid;
+            ret = ABT_xstream_get_cpubind(xstreams[i], &cpuid);
+            ABT_TEST_ERROR(ret, "ABT_xstream_get_cpubind");
+            assert(cpuid == p_ids[ABT_TOPOLOGY_CPU]);
+            assert(p_ids[ABT_TOPOLOGY_CORE] <= p_ids[ABT_TOPOLOGY_CPU]);
+            assert(p_ids[ABT_TOPOLOGY_NUMA] >= 0 &&
+                   p_ids[ABT_TOPOLOGY_NUMA] < num_nodes);
+        }
+    }
+    ret = ABT_topology_get_id(xstreams[0], ABT_TOPOLOGY_NUM_LEVELS, &level);
+    assert(ret != ABT_SUCCESS);
+
+    /* The distance matrix agrees with the pairwise distances and the IDs. */
+    ret = ABT_topology_get_distances(num_xstreams, xstreams, dists);
+    ABT_TEST_ERROR(ret, "ABT_topology_get_distances");
+    for (i = 0; i < num_xstreams; i++) {
+        for (j = 0; j < num_xstreams; j++) {
+            int dist = dists[i * num_xstreams + j];
+            int *p_ids1 = &ids[i * ABT_TOPOLOGY_NUM_LEVELS];
+            int *p_ids2 = &ids[j * ABT_TOPOLOGY_NUM_LEVELS];
+            int pair_dist;
+
+            ret = ABT_topology_get_distance(xstreams[i], xstreams[j],
+                                            &pair_dist);
+            ABT_TEST_ERROR(ret, "ABT_topology_get_distance");
+            assert(dist == pair_dist);
+            assert(dist == dists[j * num_xstreams + i]);
+            assert(dist >= 0 && dist < ABT_SCHED_STEAL_DIST_NUM);
+            if (i == j) {
+                assert(dist == ABT_SCHED_STEAL_DIST_SMT);
+            } else if (p_ids1[ABT_TOPOLOGY_CORE] >= 0 &&
+                       p_ids1[ABT_TOPOLOGY_CORE] == p_ids2[ABT_TOPOLOGY_CORE]) {
+                assert(dist == ABT_SCHED_STEAL_DIST_SMT);
+            }
+        }
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    free(dists);
+    free(ids);
+    free(xstreams);
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
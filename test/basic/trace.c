@@ -0,0 +1,155 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_THREADS     8
+#define DEFAULT_NUM_TASKS       8
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    ABT_thread_yield();
+}
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+/* Read the whole file into a NUL-terminated buffer */
+static char *read_file(FILE *fp)
+{
+    long size;
+    char *p_buf;
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    p_buf = (char *)malloc(size + 1);
+    size = (long)fread(p_buf, 1, size, fp);
+    p_buf[size] = '\0';
+    return p_buf;
+}
+
+static int count_str(const char *p_buf, const char *str)
+{
+    int num = 0;
+    while ((p_buf = strstr(p_buf, str)) != NULL) {
+        num++;
+        p_buf += strlen(str);
+    }
+    return num;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    char filename[64];
+    char header[32];
+    uint32_t num_bufs;
+    size_t num_read;
+    char *p_buf;
+    FILE *fp;
+    int num_xstreams, num_threads, num_tasks;
+    int i, j, ret;
+
+    sprintf(filename, "/tmp/abt_trace_test.%d.bin", (int)getpid());
+    setenv("ABT_TRACE", "1", 1);
+    setenv("ABT_TRACE_FILE", filename, 1);
+    setenv("ABT_TRACE_FORMAT", "binary", 1);
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_tasks    = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+    } else {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads  = DEFAULT_NUM_THREADS;
+        num_tasks    = DEFAULT_NUM_TASKS;
+    }
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPSC,
+                                    ABT_TRUE, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+        for (j = 0; j < num_threads; j++) {
+            ret = ABT_thread_create(pools[i], thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        for (j = 0; j < num_tasks; j++) {
+            ret = ABT_task_create(pools[i], task_func, NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_task_create");
+        }
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pools[i],
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* The traces of the freed ESs are kept.  Every work unit has been
+     * created, pushed, popped, and run at least once. */
+    fp = tmpfile();
+    assert(fp != NULL);
+    ret = ABT_info_print_trace(fp);
+    ABT_TEST_ERROR(ret, "ABT_info_print_trace");
+    p_buf = read_file(fp);
+    fclose(fp);
+    ABT_test_printf(1, "%d events, %d durations\n",
+                    count_str(p_buf, "\"ts\":"),
+                    count_str(p_buf, "\"ph\":\"B\""));
+    assert(strncmp(p_buf, "{\"traceEvents\":[", 16) == 0);
+    assert(count_str(p_buf, "\"name\":\"thread_name\"") >= num_xstreams + 1);
+    assert(count_str(p_buf, "\"name\":\"create\"") >=
+           num_xstreams * (num_threads + num_tasks));
+    assert(count_str(p_buf, "\"name\":\"push\"") >=
+           num_xstreams * (num_threads + num_tasks));
+    assert(count_str(p_buf, "\"name\":\"pop\"") >=
+           num_xstreams * (num_threads + num_tasks));
+    assert(count_str(p_buf, "\"ph\":\"B\",\"name\":\"ULT") >=
+           num_xstreams * num_threads);
+    assert(count_str(p_buf, "\"ph\":\"B\",\"name\":\"tasklet") ==
+           num_xstreams * num_tasks);
+    assert(count_str(p_buf, "\"ph\":\"B\"") ==
+           count_str(p_buf, "\"ph\":\"E\""));
+    free(p_buf);
+
+    free(pools);
+    free(xstreams);
+
+    /* Finalize */
+    ret = ABT_test_finalize(0);
+
+    /* ABT_finalize has dumped the traces to ABT_TRACE_FILE in the binary
+     * format, which has a header followed by the events of each ES. */
+    fp = fopen(filename, "rb");
+    assert(fp != NULL);
+    num_read = fread(header, 1, sizeof(header), fp);
+    assert(num_read == sizeof(header));
+    assert(memcmp(header, "ABTTRC01", 8) == 0);
+    memcpy(&num_bufs, &header[28], sizeof(uint32_t));
+    assert(num_bufs == (uint32_t)num_xstreams + 1);
+    fclose(fp);
+    remove(filename);
+
+    return ret;
+}
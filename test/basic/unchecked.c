@@ -0,0 +1,156 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     8
+#define NUM_ITERS               100
+
+/* The unchecked variants of the hot APIs behave like the checked ones when
+ * they are used correctly. */
+
+static ABT_mutex g_mutex;
+static ABT_eventual g_eventual;
+static int g_counter = 0;
+static int g_num_tasks = 0;
+static int g_side_done = 0;
+
+static void thread_func(void *arg)
+{
+    ABT_thread self;
+    int i, ret;
+
+    ret = ABT_thread_self(&self);
+    ABT_TEST_ERROR(ret, "ABT_thread_self");
+    assert(ABT_thread_self_unchecked() == self);
+    assert(ABT_self_get_type_unchecked() == ABT_UNIT_TYPE_THREAD);
+
+    for (i = 0; i < NUM_ITERS; i++) {
+        ABT_mutex_lock_unchecked(g_mutex);
+        g_counter++;
+        ABT_mutex_unlock_unchecked(g_mutex);
+        ABT_thread_yield_unchecked();
+    }
+}
+
+static void task_func(void *arg)
+{
+    assert(ABT_self_get_type_unchecked() == ABT_UNIT_TYPE_TASK);
+    assert(ABT_thread_self_unchecked() == ABT_THREAD_NULL);
+    ABT_mutex_lock_unchecked(g_mutex);
+    g_num_tasks++;
+    ABT_mutex_unlock_unchecked(g_mutex);
+}
+
+static void side_func(void *arg)
+{
+    g_side_done = 1;
+}
+
+static void setter_func(void *arg)
+{
+    int value = 42;
+    ABT_eventual_set_unchecked(g_eventual, &value, sizeof(int));
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool pool, side_pool;
+    ABT_thread *threads, thread;
+    ABT_unit unit;
+    int *p_value;
+    int i, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                           &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    ret = ABT_mutex_create(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_eventual_create(sizeof(int), &g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_create");
+
+    /* Mutex, yield, and self queries */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_task_create(pool, task_func, NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    assert(ABT_self_get_type_unchecked() == ABT_UNIT_TYPE_THREAD);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Eventual */
+    ret = ABT_thread_create(pool, setter_func, NULL, ABT_THREAD_ATTR_NULL,
+                            NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_eventual_wait(g_eventual, (void **)&p_value);
+    ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+    assert(*p_value == 42);
+
+    /* Move a ULT from a pool without scheduler to the running pool */
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_FALSE,
+                                &side_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_thread_create(side_pool, side_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    unit = ABT_pool_pop_unchecked(side_pool);
+    assert(unit != ABT_UNIT_NULL);
+    assert(ABT_pool_pop_unchecked(side_pool) == ABT_UNIT_NULL);
+    ret = ABT_unit_set_associated_pool(unit, pool);
+    ABT_TEST_ERROR(ret, "ABT_unit_set_associated_pool");
+    ABT_pool_push_unchecked(pool, unit);
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_pool_free(&side_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+    ret = ABT_eventual_free(&g_eventual);
+    ABT_TEST_ERROR(ret, "ABT_eventual_free");
+    ret = ABT_mutex_free(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_free");
+
+    ret = ABT_test_finalize(g_counter != num_threads * NUM_ITERS ||
+                            g_num_tasks != num_threads || g_side_done != 1);
+    free(threads);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,168 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     16
+#define RUN_SEC                 0.0002
+
+/* ULTs and tasklets that run for at least RUN_SEC each are recorded in the
+ * timing histograms of the ESs and the pools. */
+
+static int g_num_errors = 0;
+
+static void check(int cond, const char *msg)
+{
+    if (!cond) {
+        fprintf(stderr, "%s\n", msg);
+        g_num_errors++;
+    }
+}
+
+static void busy_func(void *arg)
+{
+    double start = ABT_get_wtime();
+    ABT_TEST_UNUSED(arg);
+    while (ABT_get_wtime() - start < RUN_SEC);
+}
+
+static void thread_func(void *arg)
+{
+    busy_func(arg);
+    ABT_thread_yield();
+    busy_func(arg);
+}
+
+static void check_histogram(const ABT_histogram *hist, uint64_t num_samples,
+                            uint64_t min_value)
+{
+    uint64_t sum = 0, p50, p99;
+    int i;
+
+    for (i = 0; i < ABT_HISTOGRAM_NUM_BUCKETS; i++) sum += hist->buckets[i];
+    check(sum == hist->count, "buckets do not add up to the count");
+    check(hist->count >= num_samples, "too few samples");
+    if (hist->count == 0) return;
+    check(hist->min <= hist->max, "min is larger than max");
+    check(hist->sum >= hist->min * hist->count, "wrong sum");
+    p50 = ABT_histogram_get_percentile(hist, 50.0);
+    p99 = ABT_histogram_get_percentile(hist, 99.0);
+    check(p50 <= p99 && p99 <= hist->max, "percentiles are not ordered");
+    check(ABT_histogram_get_percentile(hist, 100.0) == hist->max,
+          "p100 is not max");
+    check(hist->max >= min_value, "max is too small");
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_unit_stats stats, total;
+    /* The run times are converted from ticks that are calibrated over a short
+     * period, so allow some error against ABT_get_wtime(). */
+    uint64_t min_run = (uint64_t)(RUN_SEC * 1.0e9 * 0.5);
+    int i, ret;
+
+    setenv("ABT_UNIT_STATS", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_info_query_xstream_unit_stats(xstreams[0], &stats);
+    if (ret == ABT_ERR_FEATURE_NA) {
+        /* Disabled at build */
+        free(xstreams);
+        free(pools);
+        return ABT_test_finalize(0);
+    }
+    ABT_TEST_ERROR(ret, "ABT_info_query_xstream_unit_stats");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_task_create(pools[i % num_xstreams], busy_func, NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    }
+    while (1) {
+        size_t size;
+        ABT_pool_get_total_size(pools[0], &size);
+        if (size == 0) break;
+        ABT_thread_yield();
+    }
+
+    /* Each ULT runs twice and each tasklet once. */
+    memset(&total, 0, sizeof(total));
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_info_query_pool_unit_stats(pools[i], &stats);
+        ABT_TEST_ERROR(ret, "ABT_info_query_pool_unit_stats");
+        check_histogram(&stats.queue_delay, 0, 0);
+        check_histogram(&stats.run_time, 0, 0);
+        total.queue_delay.count += stats.queue_delay.count;
+        total.run_time.count += stats.run_time.count;
+        if (stats.run_time.count > 0) {
+            check(stats.run_time.max >= min_run, "a run is too short");
+        }
+    }
+    check(total.run_time.count >= (uint64_t)num_threads * 3,
+          "runs are missing");
+    check(total.queue_delay.count >= (uint64_t)num_threads * 3,
+          "waits are missing");
+
+    ret = ABT_info_query_xstream_unit_stats(xstreams[1 % num_xstreams],
+                                            &stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_xstream_unit_stats");
+    check_histogram(&stats.run_time, 1, min_run);
+
+    /* Reset */
+    ret = ABT_info_reset_pool_unit_stats(pools[0]);
+    ABT_TEST_ERROR(ret, "ABT_info_reset_pool_unit_stats");
+    ret = ABT_info_query_pool_unit_stats(pools[0], &stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_pool_unit_stats");
+    check(stats.run_time.count == 0 && stats.run_time.max == 0 &&
+          stats.run_time.min == 0, "the pool is not reset");
+    ret = ABT_info_reset_xstream_unit_stats(xstreams[1 % num_xstreams]);
+    ABT_TEST_ERROR(ret, "ABT_info_reset_xstream_unit_stats");
+    ret = ABT_info_query_xstream_unit_stats(xstreams[1 % num_xstreams],
+                                            &stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_xstream_unit_stats");
+    check(stats.queue_delay.count == 0 && stats.run_time.count == 0,
+          "the ES is not reset");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+
+    return ABT_test_finalize(g_num_errors);
+}
@@ -0,0 +1,150 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_TASKS       64
+#define DEFAULT_NUM_ITER        50
+
+static ABT_wait_group g_wg;
+static int g_counter = 0;
+
+static void unit_func(void *arg)
+{
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    __sync_fetch_and_add(&g_counter, 1);
+    ret = ABT_wait_group_done(g_wg);
+    ABT_TEST_ERROR(ret, "ABT_wait_group_done");
+}
+
+static void yield_func(void *arg)
+{
+    ABT_thread_yield();
+    unit_func(arg);
+}
+
+/* Each round waits for ULTs and tasklets spread over the pools.  The wait
+ * group is reused in the next round right after the waiter is released. */
+static int run_rounds(ABT_pool *pools, int num_pools, int num_threads,
+                      int num_tasks, int num_iter)
+{
+    int i, r, ret, err = 0, expected;
+
+    for (r = 0; r < num_iter; r++) {
+        expected = g_counter + num_threads + num_tasks;
+        ret = ABT_wait_group_add(g_wg, num_threads + num_tasks);
+        ABT_TEST_ERROR(ret, "ABT_wait_group_add");
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[i % num_pools],
+                                    (i % 2) ? yield_func : unit_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < num_tasks; i++) {
+            ret = ABT_task_create(pools[i % num_pools], unit_func, NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_task_create");
+        }
+        ret = ABT_wait_group_wait(g_wg);
+        ABT_TEST_ERROR(ret, "ABT_wait_group_wait");
+        if (*(volatile int *)&g_counter != expected) {
+            fprintf(stderr, "round %d: released at %d (expected %d)\n", r,
+                    g_counter, expected);
+            err++;
+        }
+    }
+    return err;
+}
+
+/* A ULT on a secondary ES waits for the units it creates. */
+static void waiter_func(void *arg)
+{
+    ABT_pool *pools = (ABT_pool *)arg;
+    int err = run_rounds(pools, 1, DEFAULT_NUM_THREADS, DEFAULT_NUM_TASKS, 4);
+    if (err) {
+        fprintf(stderr, "the waiter on a secondary ES failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_tasks = DEFAULT_NUM_TASKS;
+    int num_iter = DEFAULT_NUM_ITER;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread waiter;
+    int i, ret, err = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_tasks = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+        num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_wait_group_create(&g_wg);
+    ABT_TEST_ERROR(ret, "ABT_wait_group_create");
+
+    /* Waiting on a wait group of zero returns immediately, and completing an
+     * operation that has not been added is an error. */
+    ret = ABT_wait_group_wait(g_wg);
+    ABT_TEST_ERROR(ret, "ABT_wait_group_wait");
+    ret = ABT_wait_group_done(g_wg);
+    if (ret != ABT_ERR_WAIT_GROUP) {
+        fprintf(stderr, "ABT_wait_group_done on zero returned %d\n", ret);
+        err++;
+    }
+
+    err += run_rounds(pools, 1, num_threads, num_tasks, num_iter);
+    err += run_rounds(pools, num_xstreams, num_threads, num_tasks, num_iter);
+    ret = ABT_wait_group_free(&g_wg);
+    ABT_TEST_ERROR(ret, "ABT_wait_group_free");
+
+    /* The waiter runs on the last ES, and its units run there. */
+    ret = ABT_wait_group_create(&g_wg);
+    ABT_TEST_ERROR(ret, "ABT_wait_group_create");
+    ret = ABT_thread_create(pools[num_xstreams - 1], waiter_func,
+                            &pools[num_xstreams - 1], ABT_THREAD_ATTR_NULL,
+                            &waiter);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&waiter);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    ret = ABT_wait_group_free(&g_wg);
+    ABT_TEST_ERROR(ret, "ABT_wait_group_free");
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+
+    return ABT_test_finalize(err);
+}
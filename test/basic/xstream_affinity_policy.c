@@ -0,0 +1,85 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+
+static const char *g_policies[] = {
+    "default", "chameleon", "compact", "scatter", "core"
+};
+
+/* Every ES is bound to one CPU that the process is allowed to use. */
+static void check_policy(const char *policy, int num_xstreams,
+                         cpu_set_t *p_allowed)
+{
+    ABT_xstream *xstreams;
+    int i, ret, cpuid;
+
+    setenv("ABT_SET_AFFINITY", "1", 1);
+    setenv("ABT_AFFINITY_TYPE", policy, 1);
+    ret = ABT_init(0, NULL);
+    ABT_TEST_ERROR(ret, "ABT_init");
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_cpubind(xstreams[i], &cpuid);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_cpubind");
+        ABT_test_printf(1, "[%s] E%d: CPU %d\n", policy, i, cpuid);
+        assert(cpuid >= 0 && cpuid < CPU_SETSIZE);
+        assert(CPU_ISSET(cpuid, p_allowed));
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+}
+
+int main(int argc, char *argv[])
+{
+    cpu_set_t allowed;
+    int num_xstreams;
+    size_t i;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    } else {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+    }
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return ABT_test_finalize(0);
+    }
+
+    /* ABT_test_init has already initialized Argobots. */
+    ABT_finalize();
+    for (i = 0; i < sizeof(g_policies) / sizeof(g_policies[0]); i++) {
+        check_policy(g_policies[i], num_xstreams, &allowed);
+    }
+    ABT_init(0, NULL);
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
@@ -0,0 +1,99 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    9
+#define NUM_ROUNDS              3
+
+/* ABT_xstream_create_many() has to return distinct ESs that all run their
+ * main schedulers, so a ULT pushed into the main pool of each ES has to run
+ * on that ES.  The bring-up tree is deeper than one level with the default
+ * number of ESs, and the ESs of one round reuse the OS threads of the
+ * previous one. */
+
+static int g_num_errors = 0;
+static ABT_xstream *g_xstreams;
+
+static void thread_func(void *arg)
+{
+    int rank = (int)(intptr_t)arg;
+    ABT_xstream xstream;
+    int ret;
+
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    if (xstream != g_xstreams[rank]) {
+        fprintf(stderr, "ULT %d runs on another ES\n", rank);
+        __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_RELAXED);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_thread *threads;
+    ABT_pool pool;
+    ABT_xstream_state state;
+    int i, j, r, ret;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    }
+    assert(num_xstreams > 0);
+
+    g_xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    threads = (ABT_thread *)malloc(num_xstreams * sizeof(ABT_thread));
+
+    for (r = 0; r < NUM_ROUNDS; r++) {
+        ret = ABT_xstream_create_many(num_xstreams, g_xstreams);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create_many");
+
+        for (i = 0; i < num_xstreams; i++) {
+            for (j = 0; j < i; j++) {
+                if (g_xstreams[i] == g_xstreams[j]) {
+                    fprintf(stderr, "ES %d and ES %d are the same\n", j, i);
+                    g_num_errors++;
+                }
+            }
+            ret = ABT_xstream_get_state(g_xstreams[i], &state);
+            ABT_TEST_ERROR(ret, "ABT_xstream_get_state");
+            if (state == ABT_XSTREAM_STATE_CREATED ||
+                state == ABT_XSTREAM_STATE_TERMINATED) {
+                fprintf(stderr, "ES %d is in state %d\n", i, (int)state);
+                g_num_errors++;
+            }
+            ret = ABT_xstream_get_main_pools(g_xstreams[i], 1, &pool);
+            ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+            ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i,
+                                    ABT_THREAD_ATTR_NULL, &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_join(g_xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&g_xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+    }
+
+    /* Creating no ES is not an error. */
+    ret = ABT_xstream_create_many(0, g_xstreams);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_many");
+
+    free(threads);
+    free(g_xstreams);
+
+    return ABT_test_finalize(g_num_errors);
+}
@@ -0,0 +1,113 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     64
+
+/* Several ESs are joined asynchronously at the same time.  The ESs joined
+ * with migration still have ULTs that keep yielding until all the joins have
+ * completed, so the joins finish only if those ULTs are moved to the other
+ * ESs.  The ESs joined without migration execute their ULTs by themselves. */
+
+static volatile int g_go = 0;
+static int g_num_done = 0;
+
+static void wait_func(void *arg)
+{
+    while (g_go == 0) ABT_thread_yield();
+    __atomic_fetch_add(&g_num_done, 1, __ATOMIC_SEQ_CST);
+}
+
+static void run_func(void *arg)
+{
+    ABT_thread_yield();
+    __atomic_fetch_add(&g_num_done, 1, __ATOMIC_SEQ_CST);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams, primary;
+    ABT_eventual *eventuals, eventual;
+    ABT_thread *threads;
+    ABT_pool pool;
+    int i, j, ret, num_errors = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    /* ESs 1 .. num_xstreams are joined and one more ES keeps running. */
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * (num_xstreams + 1));
+    eventuals = (ABT_eventual *)malloc(sizeof(ABT_eventual) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams *
+                                   num_threads);
+
+    ret = ABT_xstream_self(&primary);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_join_async(primary, ABT_TRUE, &eventual);
+    if (ret != ABT_ERR_INV_XSTREAM) num_errors++;
+
+    for (i = 0; i < num_xstreams + 1; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pool);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        for (j = 0; j < num_threads; j++) {
+            ret = ABT_thread_create(pool, i % 2 ? run_func : wait_func, NULL,
+                                    ABT_THREAD_ATTR_NULL,
+                                    &threads[i * num_threads + j]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+    }
+
+    /* Even ESs move their ULTs, and odd ESs execute them. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_join_async(xstreams[i], i % 2 ? ABT_FALSE : ABT_TRUE,
+                                     &eventuals[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join_async");
+    }
+    ret = ABT_xstream_join_async(xstreams[0], ABT_TRUE, &eventual);
+    if (ret != ABT_ERR_INV_XSTREAM) num_errors++;
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_eventual_wait(eventuals[i], NULL);
+        ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+        ret = ABT_eventual_free(&eventuals[i]);
+        ABT_TEST_ERROR(ret, "ABT_eventual_free");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* The moved ULTs finish on the remaining ESs. */
+    g_go = 1;
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    if (g_num_done != num_xstreams * num_threads) num_errors++;
+
+    ret = ABT_xstream_join(xstreams[num_xstreams]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstreams[num_xstreams]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    ABT_test_printf(1, "%d of %d ULTs done\n", g_num_done,
+                    num_xstreams * num_threads);
+    ret = ABT_test_finalize(num_errors);
+    free(threads);
+    free(eventuals);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,90 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* Set the OS scheduling of a running secondary ES and check it from a ULT
+ * on that ES.  Raising the niceness and SCHED_BATCH do not need a privilege.
+ * A real-time policy is not set since a spinning ES with it can starve the
+ * other threads if the test runs with a privilege. */
+
+static int g_policy = -1;
+static int g_nice = 0;
+
+static void check_func(void *arg)
+{
+#if defined(__linux__)
+    g_nice = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+    g_policy = sched_getscheduler(0);
+#endif
+}
+
+static int run_check(ABT_xstream xstream)
+{
+    ABT_pool pool;
+    int ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_thread_create(pool, check_func, NULL, ABT_THREAD_ATTR_NULL,
+                            NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    /* Wait for the ULT */
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_xstream_os_policy policy;
+    int priority, ret, num_errors = 0;
+
+    ABT_test_init(argc, argv);
+
+    /* Default */
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_xstream_get_os_priority(xstream, &policy, &priority);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_os_priority");
+    if (policy != ABT_XSTREAM_OS_POLICY_OTHER || priority != 0) num_errors++;
+
+    /* Out of range */
+    ret = ABT_xstream_set_os_priority(xstream, ABT_XSTREAM_OS_POLICY_OTHER,
+                                      100);
+    if (ret != ABT_ERR_XSTREAM) num_errors++;
+    ret = ABT_xstream_set_os_priority(xstream, ABT_XSTREAM_OS_POLICY_FIFO, 0);
+    if (ret != ABT_ERR_XSTREAM) num_errors++;
+
+    /* Lower the priority of the running ES */
+    ret = ABT_xstream_set_os_priority(xstream, ABT_XSTREAM_OS_POLICY_BATCH, 5);
+#if defined(__linux__)
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_os_priority");
+    ret = ABT_xstream_get_os_priority(xstream, &policy, &priority);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_os_priority");
+    if (policy != ABT_XSTREAM_OS_POLICY_BATCH || priority != 5) num_errors++;
+
+    run_check(xstream);
+    ABT_test_printf(1, "policy %d, nice %d\n", g_policy, g_nice);
+    if (g_policy != SCHED_BATCH || g_nice != 5) num_errors++;
+#else
+    run_check(xstream);
+#endif
+
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    ret = ABT_test_finalize(num_errors);
+    return ret;
+}
@@ -0,0 +1,135 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define NUM_CALLS               100
+#define LONG_PERIOD             10
+#define NUM_SELF_CALLS          5
+
+typedef struct {
+    ABT_xstream xstream;
+    volatile int num_calls;
+    volatile int num_long_calls;
+    volatile int num_self_calls;
+    int num_wrong_xstreams;
+} hook_arg_t;
+
+static void hook_func(void *arg)
+{
+    hook_arg_t *p_arg = (hook_arg_t *)arg;
+    ABT_xstream self;
+    ABT_bool equal;
+
+    ABT_xstream_self(&self);
+    ABT_xstream_equal(self, p_arg->xstream, &equal);
+    if (equal != ABT_TRUE) p_arg->num_wrong_xstreams++;
+    p_arg->num_calls++;
+}
+
+static void long_hook_func(void *arg)
+{
+    ((hook_arg_t *)arg)->num_long_calls++;
+}
+
+/* It removes itself. */
+static void self_hook_func(void *arg)
+{
+    hook_arg_t *p_arg = (hook_arg_t *)arg;
+    int ret;
+    if (++p_arg->num_self_calls == NUM_SELF_CALLS) {
+        ret = ABT_xstream_remove_poll_hook(p_arg->xstream, self_hook_func,
+                                           arg);
+        ABT_TEST_ERROR(ret, "ABT_xstream_remove_poll_hook");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    hook_arg_t *args;
+    int i, ret, num_errors = 0, done = 0;
+    double start;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    }
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    args = (hook_arg_t *)calloc(num_xstreams, sizeof(hook_arg_t));
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        args[i].xstream = xstreams[i];
+        ret = ABT_xstream_add_poll_hook(xstreams[i], hook_func, &args[i], 1);
+        ABT_TEST_ERROR(ret, "ABT_xstream_add_poll_hook");
+        ret = ABT_xstream_add_poll_hook(xstreams[i], long_hook_func, &args[i],
+                                        LONG_PERIOD);
+        ABT_TEST_ERROR(ret, "ABT_xstream_add_poll_hook");
+        ret = ABT_xstream_add_poll_hook(xstreams[i], self_hook_func, &args[i],
+                                        0);
+        ABT_TEST_ERROR(ret, "ABT_xstream_add_poll_hook");
+    }
+
+    /* The hooks run even if the ESs are idle. */
+    start = ABT_get_wtime();
+    while (!done && ABT_get_wtime() - start < 10.0) {
+        ABT_thread_yield();
+        done = 1;
+        for (i = 0; i < num_xstreams; i++) {
+            if (args[i].num_calls < NUM_CALLS) done = 0;
+        }
+    }
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_remove_poll_hook(xstreams[i], hook_func, &args[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_remove_poll_hook");
+        ret = ABT_xstream_remove_poll_hook(xstreams[i], long_hook_func,
+                                           &args[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_remove_poll_hook");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        int num_calls = args[i].num_calls;
+        int num_long_calls = args[i].num_long_calls;
+        if (num_calls < NUM_CALLS || args[i].num_wrong_xstreams > 0) {
+            fprintf(stderr, "ES %d: %d calls, %d on other ESs\n", i,
+                    num_calls, args[i].num_wrong_xstreams);
+            num_errors++;
+        }
+        if (num_long_calls < num_calls / LONG_PERIOD - 1 ||
+            num_long_calls > num_calls / LONG_PERIOD + 1) {
+            fprintf(stderr, "ES %d: %d calls with period %d for %d calls\n",
+                    i, num_long_calls, LONG_PERIOD, num_calls);
+            num_errors++;
+        }
+        if (args[i].num_self_calls != NUM_SELF_CALLS) {
+            fprintf(stderr, "ES %d: the hook removing itself ran %d times\n",
+                    i, args[i].num_self_calls);
+            num_errors++;
+        }
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(args);
+
+    return ABT_test_finalize(num_errors);
+}
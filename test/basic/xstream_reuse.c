@@ -0,0 +1,101 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define MAX_PARKED          "4"
+#define DEFAULT_NUM_XSTREAMS 8
+#define DEFAULT_NUM_ITER    50
+
+static pthread_t g_last_os_thread;
+static double g_create_time = 0.0;
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    g_last_os_thread = pthread_self();
+}
+
+/* Create an ES, run one ULT on it, and free the ES. */
+static pthread_t run_xstream(void)
+{
+    ABT_xstream xstream;
+    ABT_pool pool;
+    double t_start;
+    int ret;
+
+    t_start = ABT_get_wtime();
+    ret = ABT_xstream_create(ABT_SCHED_NULL, &xstream);
+    g_create_time += ABT_get_wtime() - t_start;
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                            NULL);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_xstream_join(xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    return g_last_os_thread;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    pthread_t first;
+    double t_start, t_end;
+    int num_xstreams, num_iter;
+    int i, k, ret;
+
+    setenv("ABT_MAX_PARKED_XSTREAMS", MAX_PARKED, 1);
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_iter     = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_iter     = DEFAULT_NUM_ITER;
+    }
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+
+    /* Consecutive ESs run on the same OS thread. */
+    first = run_xstream();
+    g_create_time = 0.0;
+    t_start = ABT_get_wtime();
+    for (i = 0; i < num_iter; i++) {
+        pthread_t os_thread = run_xstream();
+        assert(pthread_equal(os_thread, first));
+    }
+    t_end = ABT_get_wtime();
+    ABT_test_printf(1, "ES create: %.3f us, create/join/free: %.3f us\n",
+                    g_create_time * 1.0e6 / num_iter,
+                    (t_end - t_start) * 1.0e6 / num_iter);
+
+    /* More ESs than the parked OS threads can be created and freed. */
+    for (k = 0; k < 3; k++) {
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create");
+        }
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_join(xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+    }
+
+    free(xstreams);
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
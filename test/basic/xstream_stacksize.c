@@ -0,0 +1,71 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define SCHED_STACKSIZE         (1024 * 1024)
+
+/* The OS threads of secondary ESs, on whose stacks their main schedulers and
+ * tasklets run, get the stack size of ABT_SCHED_STACKSIZE. */
+
+static int g_num_errors = 0;
+
+static void task_func(void *arg)
+{
+#if defined(__linux__) && defined(__GLIBC__)
+    pthread_attr_t attr;
+    size_t stacksize = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        pthread_attr_getstacksize(&attr, &stacksize);
+        pthread_attr_destroy(&attr);
+    }
+    ABT_test_printf(1, "stack size: %zu\n", stacksize);
+    if (stacksize < SCHED_STACKSIZE || stacksize >= 2 * SCHED_STACKSIZE) {
+        __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_SEQ_CST);
+    }
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_pool pool;
+    int i, ret;
+    char buf[32];
+
+    sprintf(buf, "%d", SCHED_STACKSIZE);
+    setenv("ABT_SCHED_STACKSIZE", buf, 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    }
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pool);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        ret = ABT_task_create(pool, task_func, NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_test_finalize(g_num_errors);
+    free(xstreams);
+    return ret;
+}
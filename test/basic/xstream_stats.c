@@ -0,0 +1,133 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS     8
+#define DEFAULT_NUM_TASKS       8
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    ABT_thread_yield();
+}
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+static void print_stats(const char *name, ABT_xstream_stats *p_stats)
+{
+    ABT_test_printf(1, "[%s] units %" PRIu64 " (ULTs %" PRIu64 ", tasklets %"
+                    PRIu64 "), pops %" PRIu64 " (failed %" PRIu64 "), steals %"
+                    PRIu64 "/%" PRIu64 ", switches %" PRIu64 ", idle loops %"
+                    PRIu64 ", events %.3f ms\n", name,
+                    p_stats->num_units, p_stats->num_threads,
+                    p_stats->num_tasks, p_stats->num_pops,
+                    p_stats->num_failed_pops, p_stats->num_steals,
+                    p_stats->num_steal_attempts, p_stats->num_switches,
+                    p_stats->num_idle_loops,
+                    p_stats->check_events_time * 1.0e3);
+}
+
+static void push_units(ABT_pool pool, int num_threads, int num_tasks)
+{
+    int i, ret;
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_tasks; i++) {
+        ret = ABT_task_create(pool, task_func, NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+}
+
+static void finish_xstream(ABT_xstream *p_xstream, ABT_xstream_stats *p_stats)
+{
+    int ret = ABT_xstream_join(*p_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_info_query_xstream_stats(*p_xstream, p_stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_xstream_stats");
+    ret = ABT_xstream_free(p_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_pool pools[2];
+    ABT_xstream_stats stats;
+    int num_threads, num_tasks;
+    int ret;
+
+    /* Initialize */
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        num_tasks   = ABT_test_get_arg_val(ABT_TEST_ARG_N_TASK);
+    } else {
+        num_threads = DEFAULT_NUM_THREADS;
+        num_tasks   = DEFAULT_NUM_TASKS;
+    }
+
+    /* The basic scheduler pops every work unit from its pool. */
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPSC, ABT_TRUE,
+                                &pools[0]);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    push_units(pools[0], num_threads, num_tasks);
+    ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, pools,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    finish_xstream(&xstream, &stats);
+    print_stats("basic", &stats);
+    assert(stats.num_tasks == (uint64_t)num_tasks);
+    assert(stats.num_threads >= (uint64_t)num_threads);
+    assert(stats.num_units == stats.num_threads + stats.num_tasks);
+    assert(stats.num_pops == stats.num_units);
+    assert(stats.num_switches >= stats.num_threads);
+    assert(stats.num_steal_attempts == 0 && stats.num_steals == 0);
+    assert(stats.check_events_time >= 0.0);
+
+    /* The random work-stealing scheduler steals all work units from the
+     * second pool. */
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pools[0]);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_FALSE,
+                                &pools[1]);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    push_units(pools[1], 0, num_tasks);
+    ret = ABT_xstream_create_basic(ABT_SCHED_RANDWS, 2, pools,
+                                   ABT_SCHED_CONFIG_NULL, &xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+    finish_xstream(&xstream, &stats);
+    print_stats("randws", &stats);
+    assert(stats.num_tasks == (uint64_t)num_tasks);
+    assert(stats.num_units == stats.num_tasks);
+    assert(num_tasks == 0 || stats.num_steals >= 1);
+    assert(stats.num_steals <= stats.num_steal_attempts);
+    assert(stats.num_steal_attempts <= stats.num_failed_pops);
+    assert(stats.num_pops + stats.num_steals == stats.num_units);
+    ret = ABT_pool_free(&pools[1]);
+    ABT_TEST_ERROR(ret, "ABT_pool_free");
+
+    /* The primary ES can be queried while it is running. */
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_info_query_xstream_stats(xstream, &stats);
+    ABT_TEST_ERROR(ret, "ABT_info_query_xstream_stats");
+    print_stats("primary", &stats);
+    assert(stats.num_units == stats.num_threads + stats.num_tasks);
+
+    /* Finalize */
+    return ABT_test_finalize(0);
+}
@@ -0,0 +1,120 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    3
+#define DEFAULT_NUM_THREADS     64
+#define DEFAULT_NUM_ITER        20
+
+/* The main schedulers of running ESs, including the primary one, are
+ * replaced several times while their pools are full of yielding ULTs.  All
+ * the ULTs must complete, and every replacement must happen. */
+
+static int g_num_iter;
+static int g_num_done = 0;
+
+static void thread_func(void *arg)
+{
+    int i;
+    for (i = 0; i < g_num_iter; i++) ABT_thread_yield();
+    __atomic_fetch_add(&g_num_done, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Wait until the main scheduler of xstream is not old_sched any more */
+static void wait_swap(ABT_xstream xstream, ABT_sched old_sched)
+{
+    ABT_sched sched;
+    do {
+        ABT_thread_yield();
+        int ret = ABT_xstream_get_main_sched(xstream, &sched);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_sched");
+    } while (sched == old_sched);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_sched_predef predefs[] = { ABT_SCHED_RANDWS, ABT_SCHED_BASIC };
+    ABT_xstream *xstreams;
+    ABT_sched *scheds, sched;
+    ABT_thread *threads;
+    ABT_pool pool;
+    int i, j, k, ret, num_errors = 0;
+
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    }
+    g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    if (g_num_iter <= 1) g_num_iter = DEFAULT_NUM_ITER;
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    scheds = (ABT_sched *)malloc(sizeof(ABT_sched) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams *
+                                   num_threads);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pool);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        for (j = 0; j < num_threads; j++) {
+            ret = ABT_thread_create(pool, thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL,
+                                    &threads[i * num_threads + j]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+    }
+
+    /* A scheduler in use cannot be the next one. */
+    ret = ABT_xstream_get_main_sched(xstreams[0], &sched);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_sched");
+    ret = ABT_xstream_swap_main_sched(xstreams[num_xstreams - 1], sched);
+    if (ret != ABT_ERR_INV_SCHED) num_errors++;
+
+    for (k = 0; k < 4; k++) {
+        for (i = 0; i < num_xstreams; i++) {
+            ret = ABT_xstream_get_main_sched(xstreams[i], &scheds[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_get_main_sched");
+            ret = ABT_xstream_swap_main_sched_basic(xstreams[i],
+                                                    predefs[k % 2]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_swap_main_sched_basic");
+        }
+        for (i = 0; i < num_xstreams; i++) {
+            wait_swap(xstreams[i], scheds[i]);
+        }
+    }
+
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    if (g_num_done != num_xstreams * num_threads) num_errors++;
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ABT_test_printf(1, "%d of %d ULTs done\n", g_num_done,
+                    num_xstreams * num_threads);
+    ret = ABT_test_finalize(num_errors);
+    free(threads);
+    free(scheds);
+    free(xstreams);
+    return ret;
+}
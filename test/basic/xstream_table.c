@@ -0,0 +1,131 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_ITER        20
+#define NUM_CHILDREN            3
+#define HIGH_RANK               37
+
+/* ULTs on several ESs create and free ESs at the same time, starting from an
+ * ES array of one entry, so that the array grows while other ESs read it
+ * (e.g., to find migration targets and the owners of pools).  The children
+ * of each round must get distinct ranks. */
+
+static int g_num_iter;
+static int g_num_errors = 0;
+
+static void child_func(void *arg)
+{
+    ABT_thread_yield();
+}
+
+static void creator_func(void *arg)
+{
+    ABT_xstream xstreams[NUM_CHILDREN];
+    ABT_pool pool;
+    int ranks[NUM_CHILDREN];
+    int i, j, k, ret;
+
+    for (i = 0; i < g_num_iter; i++) {
+        for (j = 0; j < NUM_CHILDREN; j++) {
+            ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[j]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create");
+            ret = ABT_xstream_get_rank(xstreams[j], &ranks[j]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_get_rank");
+            for (k = 0; k < j; k++) {
+                if (ranks[k] == ranks[j]) {
+                    __atomic_fetch_add(&g_num_errors, 1, __ATOMIC_SEQ_CST);
+                }
+            }
+            ret = ABT_xstream_get_main_pools(xstreams[j], 1, &pool);
+            ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+            ret = ABT_thread_create(pool, child_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        for (j = 0; j < NUM_CHILDREN; j++) {
+            ret = ABT_xstream_join(xstreams[j]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[j]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+        ABT_thread_yield();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams, high, extra;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int i, rank, num, ret;
+
+    setenv("ABT_MAX_NUM_XSTREAMS", "1", 1);
+    ABT_test_init(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+    }
+    g_num_iter = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    if (g_num_iter <= 1) g_num_iter = DEFAULT_NUM_ITER;
+
+    xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        ret = ABT_thread_create(pools[i], creator_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* A rank beyond the ES array */
+    ret = ABT_xstream_create_with_rank(ABT_SCHED_NULL, HIGH_RANK, &high);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create_with_rank");
+    ret = ABT_xstream_get_rank(high, &rank);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_rank");
+    if (rank != HIGH_RANK) g_num_errors++;
+    ret = ABT_xstream_create_with_rank(ABT_SCHED_NULL, HIGH_RANK, &extra);
+    if (ret != ABT_ERR_INV_XSTREAM_RANK) g_num_errors++;
+
+    ret = ABT_xstream_get_num(&num);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_num");
+    if (num != num_xstreams + 1) g_num_errors++;
+
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_xstream_join(high);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&high);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    ABT_test_printf(1, "%d errors, %d ESs left\n", g_num_errors, num);
+    ret = ABT_test_finalize(g_num_errors);
+    free(threads);
+    free(pools);
+    free(xstreams);
+    return ret;
+}
@@ -0,0 +1,92 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTBENCH_H_INCLUDED
+#define ABTBENCH_H_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* Each measurement is repeated ABT_BENCH_REPEATS times (5 by default) after
+ * a warm-up run, and one JSON object per line is written to stdout:
+ *   {"bench":"...","case":"...","num_xstreams":E,"num_ops":N,"repeats":R,
+ *    "min_ns":..,"median_ns":..,"max_ns":..,"mops":..}
+ * The times are per operation, and mops is millions of operations per second
+ * at the median.  Sizes are reported in the same way by
+ * ABT_bench_report_bytes(), whose objects have "min_bytes", "median_bytes",
+ * and "max_bytes" per operation instead of the times and mops. */
+
+#define ABT_BENCH_DEFAULT_REPEATS   5
+
+static inline int ABT_bench_get_repeats(void)
+{
+    char *env = getenv("ABT_BENCH_REPEATS");
+    if (env != NULL && atoi(env) > 0) return atoi(env);
+    return ABT_BENCH_DEFAULT_REPEATS;
+}
+
+static inline int ABT_bench_cmp_double(const void *p1, const void *p2)
+{
+    double d1 = *(const double *)p1, d2 = *(const double *)p2;
+    return (d1 < d2) ? -1 : ((d1 > d2) ? 1 : 0);
+}
+
+/* Report the elapsed times (in seconds) of num_repeats runs of num_ops
+ * operations each.  times is sorted. */
+static inline void ABT_bench_report(const char *bench, const char *name,
+                                    int num_xstreams, int num_ops,
+                                    double *times, int num_repeats)
+{
+    double scale = 1.0e9 / (double)num_ops;
+    double median;
+
+    qsort(times, num_repeats, sizeof(double), ABT_bench_cmp_double);
+    median = times[num_repeats / 2];
+    printf("{\"bench\":\"%s\",\"case\":\"%s\",\"num_xstreams\":%d,"
+           "\"num_ops\":%d,\"repeats\":%d,\"min_ns\":%.2f,\"median_ns\":%.2f,"
+           "\"max_ns\":%.2f,\"mops\":%.3f}\n", bench, name, num_xstreams,
+           num_ops, num_repeats, times[0] * scale, median * scale,
+           times[num_repeats - 1] * scale,
+           median > 0.0 ? num_ops / median * 1.0e-6 : 0.0);
+    fflush(stdout);
+}
+
+/* Report the sizes (in bytes) measured in num_repeats runs of num_ops
+ * operations each.  bytes is sorted. */
+static inline void ABT_bench_report_bytes(const char *bench, const char *name,
+                                          int num_xstreams, int num_ops,
+                                          double *bytes, int num_repeats)
+{
+    double scale = 1.0 / (double)num_ops;
+
+    qsort(bytes, num_repeats, sizeof(double), ABT_bench_cmp_double);
+    printf("{\"bench\":\"%s\",\"case\":\"%s\",\"num_xstreams\":%d,"
+           "\"num_ops\":%d,\"repeats\":%d,\"min_bytes\":%.1f,"
+           "\"median_bytes\":%.1f,\"max_bytes\":%.1f}\n", bench, name,
+           num_xstreams, num_ops, num_repeats, bytes[0] * scale,
+           bytes[num_repeats / 2] * scale, bytes[num_repeats - 1] * scale);
+    fflush(stdout);
+}
+
+/* Run f(arg) once to warm up and then ABT_bench_get_repeats() times, and
+ * report the times that f returns. */
+static inline void ABT_bench_run(const char *bench, const char *name,
+                                 int num_xstreams, int num_ops,
+                                 double (*f)(void *), void *arg)
+{
+    int i, num_repeats = ABT_bench_get_repeats();
+    double *times = (double *)malloc(num_repeats * sizeof(double));
+
+    f(arg);
+    for (i = 0; i < num_repeats; i++) {
+        times[i] = f(arg);
+    }
+    ABT_bench_report(bench, name, num_xstreams, num_ops, times, num_repeats);
+    free(times);
+}
+
+#endif /* ABTBENCH_H_INCLUDED */
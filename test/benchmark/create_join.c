@@ -0,0 +1,305 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Latency and throughput of creating and joining ULTs and tasklets, and the
+ * latency of fork-join regions with new ULTs and with a team */
+
+#include "abtbench.h"
+
+#define DEFAULT_NUM_XSTREAMS    1
+#define DEFAULT_NUM_OPS         10000
+
+static int g_num_xstreams;
+static int g_num_ops;
+static ABT_pool *g_pools;
+static ABT_thread *g_threads;
+static ABT_task *g_tasks;
+static ABT_thread_attr g_reusable_attr;
+static ABT_thread_attr g_counted_attr;
+static ABT_join_counter g_counter;
+static ABT_team g_team;
+
+static void empty_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+static void empty_team_func(int rank, void *arg)
+{
+    ABT_TEST_UNUSED(rank);
+    ABT_TEST_UNUSED(arg);
+}
+
+/* Create a ULT in the caller's pool and free it before creating the next.
+ * With a non-NULL arg, the ULTs are reusable. */
+static double thread_latency(void *arg)
+{
+    ABT_thread_attr attr = arg ? g_reusable_attr : ABT_THREAD_ATTR_NULL;
+    int i, ret;
+    double t_start;
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_thread_create(g_pools[0], empty_func, NULL, attr,
+                                &g_threads[0]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_free(&g_threads[0]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    return ABT_get_wtime() - t_start;
+}
+
+/* Create all ULTs in the pools of the ESs and then free them */
+static double thread_throughput(void *arg)
+{
+    int i, ret;
+    double t_start;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_thread_create(g_pools[i % g_num_xstreams], empty_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &g_threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_thread_free(&g_threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    return ABT_get_wtime() - t_start;
+}
+
+/* Create ULTs without handles, which are freed when they finish.  With a
+ * non-NULL arg, the ULTs are reusable. */
+static double thread_detached(void *arg)
+{
+    ABT_thread_attr attr = arg ? g_reusable_attr : ABT_THREAD_ATTR_NULL;
+    int i, ret;
+    double t_start;
+    size_t size;
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_thread_create(g_pools[0], empty_func, NULL, attr, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    do {
+        ABT_thread_yield();
+        ret = ABT_pool_get_total_size(g_pools[0], &size);
+        ABT_TEST_ERROR(ret, "ABT_pool_get_total_size");
+    } while (size > 0);
+    return ABT_get_wtime() - t_start;
+}
+
+/* Create all ULTs in the pools of the ESs, join them at once, and then free
+ * them */
+static double thread_join_many(void *arg)
+{
+    int i, ret;
+    double t_start;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_thread_create(g_pools[i % g_num_xstreams], empty_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &g_threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_join_many(g_num_ops, g_threads);
+    ABT_TEST_ERROR(ret, "ABT_thread_join_many");
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_thread_free(&g_threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    return ABT_get_wtime() - t_start;
+}
+
+/* Create ULTs without handles in the pools of the ESs and wait for all of
+ * them on a join counter */
+static double thread_join_counter(void *arg)
+{
+    int i, ret;
+    double t_start;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_thread_create(g_pools[i % g_num_xstreams], empty_func, NULL,
+                                g_counted_attr, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_join_counter_wait(g_counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_wait");
+    return ABT_get_wtime() - t_start;
+}
+
+/* Fork-join regions in which one ULT per ES is created, joined, and freed */
+static double fork_join_threads(void *arg)
+{
+    int i, j, ret;
+    double t_start;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        for (j = 0; j < g_num_xstreams; j++) {
+            ret = ABT_thread_create(g_pools[j], empty_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &g_threads[j]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        ret = ABT_thread_join_many(g_num_xstreams, g_threads);
+        ABT_TEST_ERROR(ret, "ABT_thread_join_many");
+        for (j = 0; j < g_num_xstreams; j++) {
+            ret = ABT_thread_free(&g_threads[j]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+    }
+    return ABT_get_wtime() - t_start;
+}
+
+/* The same regions run by a team with one member per ES */
+static double fork_join_team(void *arg)
+{
+    int i, ret;
+    double t_start;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_team_run(g_team, empty_team_func, NULL);
+        ABT_TEST_ERROR(ret, "ABT_team_run");
+    }
+    return ABT_get_wtime() - t_start;
+}
+
+static double task_latency(void *arg)
+{
+    int i, ret;
+    double t_start;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_task_create(g_pools[0], empty_func, NULL, &g_tasks[0]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+        ret = ABT_task_free(&g_tasks[0]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+    return ABT_get_wtime() - t_start;
+}
+
+static double task_throughput(void *arg)
+{
+    int i, ret;
+    double t_start;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_task_create(g_pools[i % g_num_xstreams], empty_func, NULL,
+                              &g_tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_task_free(&g_tasks[i]);
+        ABT_TEST_ERROR(ret, "ABT_task_free");
+    }
+    return ABT_get_wtime() - t_start;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    int i, ret;
+
+    ABT_test_read_args(argc, argv);
+    if (argc > 1) {
+        g_num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_ops      = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+        g_num_ops      = DEFAULT_NUM_OPS;
+    }
+
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+
+    xstreams = (ABT_xstream *)malloc(g_num_xstreams * sizeof(ABT_xstream));
+    g_pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+    g_threads = (ABT_thread *)malloc(g_num_ops * sizeof(ABT_thread));
+    g_tasks = (ABT_task *)malloc(g_num_ops * sizeof(ABT_task));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_thread_attr_create(&g_reusable_attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_reusable(g_reusable_attr, ABT_TRUE);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_reusable");
+    ret = ABT_join_counter_create(&g_counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_create");
+    ret = ABT_thread_attr_create(&g_counted_attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_join_counter(g_counted_attr, g_counter);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_set_join_counter");
+    ret = ABT_team_create(g_num_xstreams, xstreams, &g_team);
+    ABT_TEST_ERROR(ret, "ABT_team_create");
+
+    ABT_bench_run("create_join", "ult_latency", g_num_xstreams, g_num_ops,
+                  thread_latency, NULL);
+    ABT_bench_run("create_join", "ult_latency_reusable", g_num_xstreams,
+                  g_num_ops, thread_latency, (void *)1);
+    ABT_bench_run("create_join", "ult_throughput", g_num_xstreams, g_num_ops,
+                  thread_throughput, NULL);
+    ABT_bench_run("create_join", "ult_join_many", g_num_xstreams, g_num_ops,
+                  thread_join_many, NULL);
+    ABT_bench_run("create_join", "ult_join_counter", g_num_xstreams,
+                  g_num_ops, thread_join_counter, NULL);
+    ABT_bench_run("create_join", "ult_detached", g_num_xstreams, g_num_ops,
+                  thread_detached, NULL);
+    ABT_bench_run("create_join", "ult_detached_reusable", g_num_xstreams,
+                  g_num_ops, thread_detached, (void *)1);
+    ABT_bench_run("create_join", "tasklet_latency", g_num_xstreams, g_num_ops,
+                  task_latency, NULL);
+    ABT_bench_run("create_join", "tasklet_throughput", g_num_xstreams,
+                  g_num_ops, task_throughput, NULL);
+    ABT_bench_run("create_join", "fork_join_ults", g_num_xstreams, g_num_ops,
+                  fork_join_threads, NULL);
+    ABT_bench_run("create_join", "fork_join_team", g_num_xstreams, g_num_ops,
+                  fork_join_team, NULL);
+
+    ret = ABT_team_free(&g_team);
+    ABT_TEST_ERROR(ret, "ABT_team_free");
+
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_thread_attr_free(&g_reusable_attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+    ret = ABT_thread_attr_free(&g_counted_attr);
+    ABT_TEST_ERROR(ret, "ABT_thread_attr_free");
+    ret = ABT_join_counter_free(&g_counter);
+    ABT_TEST_ERROR(ret, "ABT_join_counter_free");
+    free(g_tasks);
+    free(g_threads);
+    free(g_pools);
+    free(xstreams);
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+    return EXIT_SUCCESS;
+}
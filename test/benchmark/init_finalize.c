@@ -0,0 +1,163 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Latency of ABT_init and ABT_finalize, and of the first ULT afterwards, and
+ * of ABT_finalize after many ULTs have been created, and of creating many ESs
+ * one by one or with ABT_xstream_create_many */
+
+#include "abtbench.h"
+
+#define DEFAULT_NUM_OPS         100
+#define NUM_ROUNDS_CACHED       10
+#define NUM_CACHED_THREADS      100000
+#define NUM_ROUNDS_XSTREAMS     10
+#define NUM_XSTREAMS            32
+
+static void thread_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+/* Initialize and finalize Argobots num_ops times.  With a non-NULL arg, one
+ * ULT is also created and joined in each round, which touches the memory
+ * pools that ABT_init may set up lazily. */
+static double init_finalize(void *arg)
+{
+    int num_ops = DEFAULT_NUM_OPS;
+    double t_start, t_end;
+    ABT_xstream xstream;
+    ABT_pool pool;
+    int i, ret;
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < num_ops; i++) {
+        ret = ABT_init(0, NULL);
+        ABT_TEST_ERROR(ret, "ABT_init");
+        if (arg) {
+            ret = ABT_xstream_self(&xstream);
+            ABT_TEST_ERROR(ret, "ABT_xstream_self");
+            ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+            ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+            ret = ABT_thread_create(pool, thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+            ret = ABT_thread_yield();
+            ABT_TEST_ERROR(ret, "ABT_thread_yield");
+        }
+        ret = ABT_finalize();
+        ABT_TEST_ERROR(ret, "ABT_finalize");
+    }
+    t_end = ABT_get_wtime();
+    return t_end - t_start;
+}
+
+/* Measure only ABT_finalize after NUM_CACHED_THREADS ULTs have been alive at
+ * once, so that many stacks are cached by the memory pool.  With
+ * ABT_MEM_FAST_FINALIZE, the pages of every round are kept until exit. */
+static double finalize_cached(void *arg)
+{
+    double t_total = 0.0, t_start;
+    ABT_thread *threads;
+    ABT_xstream xstream;
+    ABT_pool pool;
+    int i, r, ret;
+
+    ABT_TEST_UNUSED(arg);
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * NUM_CACHED_THREADS);
+    for (r = 0; r < NUM_ROUNDS_CACHED; r++) {
+        ret = ABT_init(0, NULL);
+        ABT_TEST_ERROR(ret, "ABT_init");
+        ret = ABT_xstream_self(&xstream);
+        ABT_TEST_ERROR(ret, "ABT_xstream_self");
+        ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+        for (i = 0; i < NUM_CACHED_THREADS; i++) {
+            ret = ABT_thread_create(pool, thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < NUM_CACHED_THREADS; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+
+        t_start = ABT_get_wtime();
+        ret = ABT_finalize();
+        ABT_TEST_ERROR(ret, "ABT_finalize");
+        t_total += ABT_get_wtime() - t_start;
+    }
+    free(threads);
+    return t_total;
+}
+
+/* Measure the time until NUM_XSTREAMS new ESs have each run a ULT.  The ESs
+ * are created one by one if arg is NULL and with ABT_xstream_create_many()
+ * otherwise.  New OS threads are created in every round since ABT_finalize
+ * terminates the parked ones. */
+static double create_xstreams(void *arg)
+{
+    double t_total = 0.0, t_start;
+    ABT_xstream xstreams[NUM_XSTREAMS];
+    ABT_thread threads[NUM_XSTREAMS];
+    ABT_pool pool;
+    int i, r, ret;
+
+    for (r = 0; r < NUM_ROUNDS_XSTREAMS; r++) {
+        ret = ABT_init(0, NULL);
+        ABT_TEST_ERROR(ret, "ABT_init");
+
+        t_start = ABT_get_wtime();
+        if (arg) {
+            ret = ABT_xstream_create_many(NUM_XSTREAMS, xstreams);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create_many");
+        } else {
+            for (i = 0; i < NUM_XSTREAMS; i++) {
+                ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+                ABT_TEST_ERROR(ret, "ABT_xstream_create");
+            }
+        }
+        for (i = 0; i < NUM_XSTREAMS; i++) {
+            ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pool);
+            ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+            ret = ABT_thread_create(pool, thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < NUM_XSTREAMS; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ABT_TEST_ERROR(ret, "ABT_thread_free");
+        }
+        t_total += ABT_get_wtime() - t_start;
+
+        for (i = 0; i < NUM_XSTREAMS; i++) {
+            ret = ABT_xstream_join(xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[i]);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+        ret = ABT_finalize();
+        ABT_TEST_ERROR(ret, "ABT_finalize");
+    }
+    return t_total;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_TEST_UNUSED(argc);
+    ABT_TEST_UNUSED(argv);
+
+    /* ABT_get_wtime() works without ABT_init(). */
+    ABT_bench_run("init_finalize", "init_finalize", 1, DEFAULT_NUM_OPS,
+                  init_finalize, NULL);
+    ABT_bench_run("init_finalize", "init_first_ult_finalize", 1,
+                  DEFAULT_NUM_OPS, init_finalize, (void *)1);
+    ABT_bench_run("init_finalize", "finalize_cached_stacks", 1,
+                  NUM_ROUNDS_CACHED, finalize_cached, NULL);
+    ABT_bench_run("init_finalize", "create_xstreams_loop", NUM_XSTREAMS,
+                  NUM_ROUNDS_XSTREAMS, create_xstreams, NULL);
+    ABT_bench_run("init_finalize", "create_xstreams_many", NUM_XSTREAMS,
+                  NUM_ROUNDS_XSTREAMS, create_xstreams, (void *)1);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Cost of ABT_pool_push and ABT_pool_pop for each kind and access mode of
+ * the predefined pools */
+
+#include "abtbench.h"
+
+#define DEFAULT_NUM_UNITS       64
+#define DEFAULT_NUM_OPS         100000
+
+static const char *g_kind_names[] = {
+    "fifo", "deque", "fifo_lockfree", "ring", "multiq"
+};
+static const ABT_pool_kind g_kinds[] = {
+    ABT_POOL_FIFO, ABT_POOL_DEQUE, ABT_POOL_FIFO_LOCKFREE, ABT_POOL_RING,
+    ABT_POOL_MULTIQ
+};
+static const char *g_access_names[] = { "priv", "spsc", "mpsc", "spmc", "mpmc" };
+static const ABT_pool_access g_accesses[] = {
+    ABT_POOL_ACCESS_PRIV, ABT_POOL_ACCESS_SPSC, ABT_POOL_ACCESS_MPSC,
+    ABT_POOL_ACCESS_SPMC, ABT_POOL_ACCESS_MPMC
+};
+
+static int g_num_units;
+static int g_num_ops;
+static ABT_pool g_pool;
+static ABT_unit *g_units;
+
+static void empty_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+}
+
+/* Push a unit and pop it again */
+static double push_pop_one(void *arg)
+{
+    ABT_unit unit = g_units[0];
+    double t_start;
+    int i;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ABT_pool_push(g_pool, unit);
+        ABT_pool_pop(g_pool, &unit);
+    }
+    return ABT_get_wtime() - t_start;
+}
+
+/* Push num_units units and pop all of them */
+static double push_pop_batch(void *arg)
+{
+    int num_rounds = g_num_ops / g_num_units;
+    double t_start;
+    int i, j;
+    ABT_TEST_UNUSED(arg);
+
+    t_start = ABT_get_wtime();
+    for (i = 0; i < num_rounds; i++) {
+        for (j = 0; j < g_num_units; j++) {
+            ABT_pool_push(g_pool, g_units[j]);
+        }
+        for (j = 0; j < g_num_units; j++) {
+            ABT_pool_pop(g_pool, &g_units[j]);
+        }
+    }
+    return (ABT_get_wtime() - t_start) * g_num_ops /
+           ((double)num_rounds * g_num_units);
+}
+
+/* Run on the ES that consumes g_pool, so the scheduler does not touch the
+ * pool until this ULT finishes. */
+static void bench_func(void *arg)
+{
+    char *name = (char *)arg;
+    char case_name[64];
+    int i, ret;
+
+    for (i = 0; i < g_num_units; i++) {
+        ret = ABT_thread_create(g_pool, empty_func, NULL,
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < g_num_units; i++) {
+        ret = ABT_pool_pop(g_pool, &g_units[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_pop");
+        assert(g_units[i] != ABT_UNIT_NULL);
+    }
+
+    sprintf(case_name, "%s_one", name);
+    ABT_bench_run("pool_push_pop", case_name, 1, g_num_ops, push_pop_one,
+                  NULL);
+    sprintf(case_name, "%s_batch", name);
+    ABT_bench_run("pool_push_pop", case_name, 1, g_num_ops, push_pop_batch,
+                  NULL);
+
+    /* The scheduler runs the ULTs after this ULT finishes. */
+    for (i = 0; i < g_num_units; i++) {
+        ret = ABT_pool_push(g_pool, g_units[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_push");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    char name[64];
+    size_t k, a;
+    int ret;
+
+    ABT_test_read_args(argc, argv);
+    if (argc > 1) {
+        g_num_units = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_ops   = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        g_num_units = DEFAULT_NUM_UNITS;
+        g_num_ops   = DEFAULT_NUM_OPS;
+    }
+    if (g_num_ops < g_num_units) g_num_ops = g_num_units;
+
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+    g_units = (ABT_unit *)malloc(g_num_units * sizeof(ABT_unit));
+
+    for (k = 0; k < sizeof(g_kinds) / sizeof(g_kinds[0]); k++) {
+        for (a = 0; a < sizeof(g_accesses) / sizeof(g_accesses[0]); a++) {
+            /* The deque pool only supports SPMC. */
+            if (g_kinds[k] == ABT_POOL_DEQUE &&
+                g_accesses[a] != ABT_POOL_ACCESS_SPMC) continue;
+            /* The ring also holds this ULT, and a push to a full ring would
+             * wait forever (the default capacity is 1024). */
+            if (g_kinds[k] == ABT_POOL_RING && g_num_units >= 1024) continue;
+            ret = ABT_pool_create_basic(g_kinds[k], g_accesses[a], ABT_TRUE,
+                                        &g_pool);
+            ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+            sprintf(name, "%s_%s", g_kind_names[k], g_access_names[a]);
+            ret = ABT_thread_create(g_pool, bench_func, name,
+                                    ABT_THREAD_ATTR_NULL, NULL);
+            ABT_TEST_ERROR(ret, "ABT_thread_create");
+            ret = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &g_pool,
+                                           ABT_SCHED_CONFIG_NULL, &xstream);
+            ABT_TEST_ERROR(ret, "ABT_xstream_create_basic");
+            ret = ABT_xstream_join(xstream);
+            ABT_TEST_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstream);
+            ABT_TEST_ERROR(ret, "ABT_xstream_free");
+        }
+    }
+
+    free(g_units);
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+    return EXIT_SUCCESS;
+}
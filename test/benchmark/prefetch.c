@@ -0,0 +1,141 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Cost of yielding among many ULTs scheduled by the random work-stealing
+ * scheduler, with and without prefetching of the next unit and of the saved
+ * contexts (ABT_SCHED_PREFETCH).  With many ULTs, their descriptors and stack
+ * tops do not stay in the cache between their runs. */
+
+#include "abtbench.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_THREADS     16384
+#define DEFAULT_NUM_OPS         20
+#define NUM_LINES               2
+#define LINE_SIZE               64
+
+static int g_num_xstreams;
+static int g_num_threads;
+static int g_num_ops;
+static ABT_pool *g_pools;
+
+static void yield_func(void *arg)
+{
+    volatile char buf[NUM_LINES * LINE_SIZE];
+    int i, j;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_num_ops; i++) {
+        for (j = 0; j < NUM_LINES; j++) {
+            buf[j * LINE_SIZE]++;
+        }
+        ABT_thread_yield();
+    }
+}
+
+static double yield_many(void *arg)
+{
+    ABT_thread *threads;
+    double t_start, t_end;
+    int i, ret;
+    ABT_TEST_UNUSED(arg);
+
+    threads = (ABT_thread *)malloc(g_num_threads * sizeof(ABT_thread));
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_create(g_pools[i % g_num_xstreams], yield_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_join(threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_join");
+    }
+    t_end = ABT_get_wtime();
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+    return t_end - t_start;
+}
+
+/* Run the benchmark in a new Argobots instance with the given setting */
+static void run_case(const char *name, const char *prefetch)
+{
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *my_pools;
+    int i, k, ret;
+
+    setenv("ABT_SCHED_PREFETCH", prefetch, 1);
+    ret = ABT_init(0, NULL);
+    ABT_TEST_ERROR(ret, "ABT_init");
+
+    xstreams = (ABT_xstream *)malloc(g_num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(g_num_xstreams * sizeof(ABT_sched));
+    g_pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+    my_pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    for (i = 0; i < g_num_xstreams; i++) {
+        for (k = 0; k < g_num_xstreams; k++) {
+            my_pools[k] = g_pools[(i + k) % g_num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, g_num_xstreams,
+                                     my_pools, ABT_SCHED_CONFIG_NULL,
+                                     &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+    free(my_pools);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* Each yield is an operation. */
+    ABT_bench_run("prefetch", name, g_num_xstreams,
+                  g_num_threads * g_num_ops, yield_many, NULL);
+
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(g_pools);
+    free(scheds);
+    free(xstreams);
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_test_read_args(argc, argv);
+    if (argc > 1) {
+        g_num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_threads  = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_ops      = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+        g_num_threads  = DEFAULT_NUM_THREADS;
+        g_num_ops      = DEFAULT_NUM_OPS;
+    }
+
+    run_case("randws_yield_noprefetch", "0");
+    run_case("randws_yield_prefetch", "1");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,252 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Scale of mostly blocked ULTs: a large number of ULTs are created, block on
+ * eventuals or condition variables, and are woken in waves.  The creation
+ * rate, the resident memory per blocked ULT, the wake-up throughput, and the
+ * time of ABT_finalize() are reported, together with the breakdown of the
+ * runtime's memory per ULT from ABT_info_query_thread_mem(). */
+
+#include <unistd.h>
+#include "abtbench.h"
+
+#define DEFAULT_NUM_XSTREAMS    1
+#define DEFAULT_NUM_ULTS        1000000
+#define NUM_WAVES               10
+
+enum { CASE_EVENTUAL = 0, CASE_COND };
+
+typedef struct {
+    ABT_eventual eventual;
+    ABT_mutex mutex;
+    ABT_cond cond;
+    int released;
+} wave_t;
+
+static int g_num_xstreams;
+static int g_num_ults;
+static int g_case;
+static wave_t g_waves[NUM_WAVES];
+static int g_num_arrived;
+static int g_num_done;
+
+/* Resident set size of the process in bytes */
+static double get_rss(void)
+{
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (fp == NULL) return 0.0;
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(fp);
+    return (double)resident * (double)sysconf(_SC_PAGESIZE);
+}
+
+static void blocked_func(void *arg)
+{
+    wave_t *p_wave = &g_waves[(int)(intptr_t)arg];
+    int ret;
+
+    __atomic_fetch_add(&g_num_arrived, 1, __ATOMIC_RELEASE);
+    if (g_case == CASE_EVENTUAL) {
+        ret = ABT_eventual_wait(p_wave->eventual, NULL);
+        ABT_TEST_ERROR(ret, "ABT_eventual_wait");
+    } else {
+        ret = ABT_mutex_lock(p_wave->mutex);
+        ABT_TEST_ERROR(ret, "ABT_mutex_lock");
+        while (!p_wave->released) {
+            ret = ABT_cond_wait(p_wave->cond, p_wave->mutex);
+            ABT_TEST_ERROR(ret, "ABT_cond_wait");
+        }
+        ret = ABT_mutex_unlock(p_wave->mutex);
+        ABT_TEST_ERROR(ret, "ABT_mutex_unlock");
+    }
+    __atomic_fetch_add(&g_num_done, 1, __ATOMIC_RELEASE);
+}
+
+static void wait_count(int *p_count, int target)
+{
+    while (__atomic_load_n(p_count, __ATOMIC_ACQUIRE) < target) {
+        ABT_thread_yield();
+    }
+}
+
+/* Number of ULTs that block in wave w */
+static int get_wave_size(int w)
+{
+    return g_num_ults / NUM_WAVES + (w < g_num_ults % NUM_WAVES ? 1 : 0);
+}
+
+/* One run from ABT_init() to ABT_finalize().  The elapsed times of the three
+ * phases are stored in t_create, t_wake, and t_finalize, and the growth of the
+ * resident memory while the ULTs are created is stored in rss. */
+static void run(int argc, char *argv[], double *t_create, double *t_wake,
+                double *t_finalize, double *rss)
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    int i, w, target, ret;
+    double t_start, rss_start;
+
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+
+    xstreams = (ABT_xstream *)malloc(g_num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    for (w = 0; w < NUM_WAVES; w++) {
+        wave_t *p_wave = &g_waves[w];
+        if (g_case == CASE_EVENTUAL) {
+            ret = ABT_eventual_create(0, &p_wave->eventual);
+            ABT_TEST_ERROR(ret, "ABT_eventual_create");
+        } else {
+            ret = ABT_mutex_create(&p_wave->mutex);
+            ABT_TEST_ERROR(ret, "ABT_mutex_create");
+            ret = ABT_cond_create(&p_wave->cond);
+            ABT_TEST_ERROR(ret, "ABT_cond_create");
+            p_wave->released = 0;
+        }
+    }
+    g_num_arrived = 0;
+    g_num_done = 0;
+
+    /* Create the ULTs and wait until all of them block */
+    rss_start = get_rss();
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ults; i++) {
+        ret = ABT_thread_create(pools[i % g_num_xstreams], blocked_func,
+                                (void *)(intptr_t)(i % NUM_WAVES),
+                                ABT_THREAD_ATTR_NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    wait_count(&g_num_arrived, g_num_ults);
+    *t_create = ABT_get_wtime() - t_start;
+    *rss = get_rss() - rss_start;
+
+    /* Wake them wave by wave */
+    t_start = ABT_get_wtime();
+    for (w = 0, target = 0; w < NUM_WAVES; w++) {
+        wave_t *p_wave = &g_waves[w];
+        if (g_case == CASE_EVENTUAL) {
+            ret = ABT_eventual_set(p_wave->eventual, NULL, 0);
+            ABT_TEST_ERROR(ret, "ABT_eventual_set");
+        } else {
+            ret = ABT_mutex_lock(p_wave->mutex);
+            ABT_TEST_ERROR(ret, "ABT_mutex_lock");
+            p_wave->released = 1;
+            ret = ABT_cond_broadcast(p_wave->cond);
+            ABT_TEST_ERROR(ret, "ABT_cond_broadcast");
+            ret = ABT_mutex_unlock(p_wave->mutex);
+            ABT_TEST_ERROR(ret, "ABT_mutex_unlock");
+        }
+        target += get_wave_size(w);
+        wait_count(&g_num_done, target);
+    }
+    *t_wake = ABT_get_wtime() - t_start;
+
+    for (w = 0; w < NUM_WAVES; w++) {
+        wave_t *p_wave = &g_waves[w];
+        if (g_case == CASE_EVENTUAL) {
+            ret = ABT_eventual_free(&p_wave->eventual);
+            ABT_TEST_ERROR(ret, "ABT_eventual_free");
+        } else {
+            ret = ABT_cond_free(&p_wave->cond);
+            ABT_TEST_ERROR(ret, "ABT_cond_free");
+            ret = ABT_mutex_free(&p_wave->mutex);
+            ABT_TEST_ERROR(ret, "ABT_mutex_free");
+        }
+    }
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(pools);
+    free(xstreams);
+
+    t_start = ABT_get_wtime();
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+    *t_finalize = ABT_get_wtime() - t_start;
+}
+
+static void run_case(int argc, char *argv[], int c, const char *name)
+{
+    int i, num_repeats = ABT_bench_get_repeats();
+    double t_create[num_repeats], t_wake[num_repeats];
+    double t_finalize[num_repeats], rss[num_repeats];
+    double dummy;
+    char case_name[64];
+
+    g_case = c;
+    run(argc, argv, &dummy, &dummy, &dummy, &dummy);
+    for (i = 0; i < num_repeats; i++) {
+        run(argc, argv, &t_create[i], &t_wake[i], &t_finalize[i], &rss[i]);
+    }
+
+    sprintf(case_name, "%s_create", name);
+    ABT_bench_report("scale", case_name, g_num_xstreams, g_num_ults, t_create,
+                     num_repeats);
+    sprintf(case_name, "%s_rss", name);
+    ABT_bench_report_bytes("scale", case_name, g_num_xstreams, g_num_ults, rss,
+                           num_repeats);
+    sprintf(case_name, "%s_wake", name);
+    ABT_bench_report("scale", case_name, g_num_xstreams, g_num_ults, t_wake,
+                     num_repeats);
+    sprintf(case_name, "%s_finalize", name);
+    ABT_bench_report("scale", case_name, g_num_xstreams, g_num_ults,
+                     t_finalize, num_repeats);
+}
+
+/* Print the breakdown of the memory per ULT in the same format */
+static void report_thread_mem(int argc, char *argv[])
+{
+    ABT_thread_mem mem;
+    int ret;
+
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+    ret = ABT_info_query_thread_mem(&mem);
+    ABT_TEST_ERROR(ret, "ABT_info_query_thread_mem");
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+
+    printf("{\"bench\":\"scale\",\"case\":\"thread_mem\",\"thread_bytes\":%llu,"
+           "\"unit_bytes\":%llu,\"header_bytes\":%llu,\"stack_bytes\":%llu,"
+           "\"ktable_bytes\":%llu}\n", (unsigned long long)mem.thread_bytes,
+           (unsigned long long)mem.unit_bytes,
+           (unsigned long long)mem.header_bytes,
+           (unsigned long long)mem.stack_bytes,
+           (unsigned long long)mem.ktable_bytes);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_test_read_args(argc, argv);
+    if (argc > 1) {
+        g_num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_ults     = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+    } else {
+        g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+        g_num_ults     = DEFAULT_NUM_ULTS;
+    }
+
+    report_thread_mem(argc, argv);
+    run_case(argc, argv, CASE_EVENTUAL, "eventual");
+    run_case(argc, argv, CASE_COND, "cond");
+
+    return EXIT_SUCCESS;
+}
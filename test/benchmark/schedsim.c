@@ -0,0 +1,950 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Trace-driven evaluation of the predefined schedulers.  A trace of work
+ * units, i.e., which unit created which one and when, how long each ran, and
+ * how long it blocked, is replayed on ESs that run a predefined scheduler
+ * with real pools, and the makespan, the steals and the queueing delay are
+ * reported for each scheduler.
+ *
+ *   schedsim [-e ESs] [-s SCHED[,SCHED...]] [-g GRACE] [-d] [TRACE_FILE]
+ *
+ * SCHED is one of basic, randws, localws and hier (all by default).  Each ES
+ * has its own FIFO pool, which the work-stealing schedulers share with the
+ * others as victims.  TRACE_FILE is either a binary trace written with
+ * ABT_TRACE=1 ABT_TRACE_FORMAT=binary or a text trace with one record per
+ * line:
+ *   u ID PARENT AT   unit ID is created by unit PARENT after PARENT has run
+ *                    for AT us, or AT us after the start if PARENT is "-"
+ *   r ID US          unit ID runs for US us
+ *   b ID US          unit ID blocks for US us
+ * The IDs are 0, 1, ... in the order of the u records, a parent comes before
+ * its children, and the r and b records of each unit are in order.  Lines
+ * starting with # are ignored.  Without TRACE_FILE, a fork-join tree is
+ * replayed.  With -d, the trace is printed in the text format instead.
+ *
+ * Time is virtual.  Each unit becomes a ULT that only advances the clock of
+ * its ES.  Before a ULT creates a unit, resumes one, or finishes at virtual
+ * time T, it waits until no other busy ES is behind T, so that the
+ * schedulers see the units in the order of virtual time and decide as if the
+ * units really took that long.  While units are queued, an idle ES that is
+ * behind is waited for only GRACE us of real time (100 by default) since its
+ * scheduler may not be allowed to pop them; GRACE counts from when the ES
+ * became idle or a unit became ready, whichever is later.  A blocked ULT
+ * suspends itself and is resumed into its pool when the virtual time reaches
+ * the end of the block.  Blocks are replayed with their recorded lengths, so waits for
+ * other units are not modeled as dependencies.
+ *
+ * One JSON object per scheduler is written to stdout:
+ *   {"sim":"...","sched":"...","num_xstreams":E,"num_units":N,
+ *    "makespan_us":..,"work_us":..,"critical_path_us":..,"steals":..,
+ *    "migrations":..,"queue_mean_us":..,"queue_max_us":..}
+ * work_us / E and critical_path_us are lower bounds of the makespan.  steals
+ * is counted by the schedulers, migrations is the number of runs on another
+ * ES than the one that made the unit ready, and the queueing delay is from a
+ * unit becoming ready to the start of its run. */
+
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include "abtbench.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_SCHEDS          "basic,randws,localws,hier"
+#define DEFAULT_GRACE_US        100
+
+/* Fork-join tree replayed without a trace: every inner unit spawns two
+ * children, and every GEN_BLOCK_EVERY-th leaf blocks in the middle. */
+#define GEN_DEPTH               8
+#define GEN_SPAWN_NS            1000
+#define GEN_LEAF_NS             20000
+#define GEN_BLOCK_NS            50000
+#define GEN_BLOCK_EVERY         4
+
+typedef struct {
+    uint64_t run;               /* Running time in ns */
+    uint64_t block;             /* Blocked time after the run in ns */
+} seg_t;
+
+typedef struct {
+    int parent;                 /* -1 for a root */
+    uint64_t at;                /* Running time of the parent, or since the
+                                 * start for a root, at the creation in ns */
+    int num_segs, max_segs;
+    seg_t *segs;
+    int num_children, max_children;
+    int *children;              /* In the order of creation */
+    /* Replay */
+    ABT_thread thread;
+    uint64_t ready;             /* Virtual time when it became ready */
+    int ready_es;               /* ES that made it ready, or -1 */
+} unit_t;
+
+/* A root to create or a blocked unit to resume at a virtual time */
+typedef struct {
+    uint64_t time;
+    int unit;
+} timer_t_;
+
+typedef struct {
+    uint64_t clock;             /* Virtual time in ns */
+    int busy;                   /* Whether a unit is running */
+    uint64_t idle_since;        /* Real time when it became idle in ns */
+    /* Statistics, which only this ES updates */
+    uint64_t num_runs;
+    uint64_t num_migrations;
+    uint64_t queue_sum;
+    uint64_t queue_max;
+    char pad[64];
+} es_t;
+
+static int g_num_xstreams;
+static uint64_t g_grace_ns;
+static unit_t *g_units;
+static int g_num_units, g_max_units;
+static es_t *g_es;
+static ABT_pool *g_pools;       /* Own pool of each ES */
+static int *g_es_of_rank;
+
+static timer_t_ *g_timers;      /* Binary heap ordered by time */
+static int g_num_timers;
+static volatile int g_timer_lock;
+
+static int g_queued;            /* Units made ready but not started */
+static uint64_t g_ready_since;  /* Real time when a unit last became ready */
+static int g_done;              /* Units finished */
+static uint64_t g_makespan;
+
+static uint64_t now_ns(void)
+{
+    return (uint64_t)(ABT_get_wtime() * 1.0e9);
+}
+
+
+/*****************************************************************************/
+/* Trace                                                                     */
+/*****************************************************************************/
+
+static int add_unit(int parent, uint64_t at)
+{
+    unit_t *p_unit;
+
+    if (g_num_units == g_max_units) {
+        g_max_units = g_max_units ? g_max_units * 2 : 256;
+        g_units = (unit_t *)realloc(g_units, g_max_units * sizeof(unit_t));
+    }
+    p_unit = &g_units[g_num_units];
+    memset(p_unit, 0, sizeof(unit_t));
+    p_unit->parent = parent;
+    p_unit->at = at;
+    if (parent >= 0) {
+        unit_t *p_parent = &g_units[parent];
+        if (p_parent->num_children == p_parent->max_children) {
+            p_parent->max_children = p_parent->max_children
+                                   ? p_parent->max_children * 2 : 4;
+            p_parent->children = (int *)realloc(p_parent->children,
+                    p_parent->max_children * sizeof(int));
+        }
+        p_parent->children[p_parent->num_children++] = g_num_units;
+    }
+    return g_num_units++;
+}
+
+static seg_t *add_seg(unit_t *p_unit)
+{
+    if (p_unit->num_segs == p_unit->max_segs) {
+        p_unit->max_segs = p_unit->max_segs ? p_unit->max_segs * 2 : 2;
+        p_unit->segs = (seg_t *)realloc(p_unit->segs,
+                                        p_unit->max_segs * sizeof(seg_t));
+    }
+    p_unit->segs[p_unit->num_segs].run = 0;
+    p_unit->segs[p_unit->num_segs].block = 0;
+    return &p_unit->segs[p_unit->num_segs++];
+}
+
+/* Consecutive runs are merged, and so are consecutive blocks. */
+static void add_run(int id, uint64_t ns)
+{
+    unit_t *p_unit = &g_units[id];
+    seg_t *p_seg = p_unit->num_segs ? &p_unit->segs[p_unit->num_segs - 1]
+                                    : NULL;
+    if (p_seg == NULL || p_seg->block > 0) p_seg = add_seg(p_unit);
+    p_seg->run += ns;
+}
+
+static void add_block(int id, uint64_t ns)
+{
+    unit_t *p_unit = &g_units[id];
+    seg_t *p_seg = p_unit->num_segs ? &p_unit->segs[p_unit->num_segs - 1]
+                                    : add_seg(p_unit);
+    p_seg->block += ns;
+}
+
+static void gen_unit(int parent, uint64_t at, int depth)
+{
+    int id = add_unit(parent, at);
+
+    if (depth == 0) {
+        if (id % GEN_BLOCK_EVERY == 0) {
+            add_run(id, GEN_LEAF_NS / 2);
+            add_block(id, GEN_BLOCK_NS);
+            add_run(id, GEN_LEAF_NS / 2);
+        } else {
+            add_run(id, GEN_LEAF_NS);
+        }
+    } else {
+        add_run(id, 2 * GEN_SPAWN_NS);
+        gen_unit(id, GEN_SPAWN_NS, depth - 1);
+        gen_unit(id, 2 * GEN_SPAWN_NS, depth - 1);
+    }
+}
+
+static uint64_t us_to_ns(double us)
+{
+    return us > 0.0 ? (uint64_t)(us * 1000.0 + 0.5) : 0;
+}
+
+static int load_text(FILE *fp, const char *filename)
+{
+    char line[256], parent[32];
+    int id, lineno = 0;
+    double us;
+
+    while (fgets(line, sizeof(line), fp)) {
+        lineno++;
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (sscanf(line, "u %d %31s %lf", &id, parent, &us) == 3) {
+            int p = strcmp(parent, "-") ? atoi(parent) : -1;
+            if (id != g_num_units || p >= id) goto fn_fail;
+            add_unit(p, us_to_ns(us));
+        } else if (sscanf(line, "r %d %lf", &id, &us) == 2) {
+            if (id < 0 || id >= g_num_units) goto fn_fail;
+            add_run(id, us_to_ns(us));
+        } else if (sscanf(line, "b %d %lf", &id, &us) == 2) {
+            if (id < 0 || id >= g_num_units) goto fn_fail;
+            add_block(id, us_to_ns(us));
+        } else {
+            goto fn_fail;
+        }
+    }
+    return 0;
+
+  fn_fail:
+    fprintf(stderr, "%s:%d: invalid record\n", filename, lineno);
+    return 1;
+}
+
+/* Kinds of the events in binary traces (see src/include/abti_trace.h) */
+enum { EV_CREATE = 0, EV_PUSH, EV_POP, EV_STEAL, EV_RUN, EV_STOP, EV_BLOCK };
+#define EV_TASK     0x100
+
+typedef struct {
+    uint64_t cycles;
+    uint64_t obj;
+    uint32_t kind;
+    uint32_t arg;
+} trace_entry_t;
+
+typedef struct {
+    uint64_t cycles;
+    uint64_t obj;
+    uint32_t kind;
+    int es;
+    uint64_t seq;
+} event_t;
+
+typedef struct {
+    uint64_t blocked_at;        /* Cycles at the last block, or 0 */
+    uint64_t ready_at;          /* Cycles at the push after it, or 0 */
+    uint64_t run;               /* Running time so far in ns */
+    int new_seg;                /* Whether the next run follows a block */
+} conv_t;
+
+static int cmp_event(const void *p1, const void *p2)
+{
+    const event_t *e1 = (const event_t *)p1, *e2 = (const event_t *)p2;
+    if (e1->cycles != e2->cycles) return e1->cycles < e2->cycles ? -1 : 1;
+    return e1->seq < e2->seq ? -1 : (e1->seq > e2->seq);
+}
+
+/* Units are identified by the addresses of their ABT_unit objects, which may
+ * be reused, so an address refers to the last unit created with it. */
+static int map_find(uint64_t *keys, int *vals, size_t mask, uint64_t obj,
+                    int insert)
+{
+    size_t i = (size_t)((obj >> 4) * 0x9E3779B97F4A7C15ULL) & mask;
+    while (keys[i] != 0 && keys[i] != obj) i = (i + 1) & mask;
+    if (insert >= 0) {
+        keys[i] = obj;
+        vals[i] = insert;
+    }
+    return keys[i] == obj ? vals[i] : -1;
+}
+
+/* Build the units from the events of all ESs in the order of time.  The
+ * running time of a unit is the sum of its runs, during which it creates the
+ * units that the ES records.  A block lasts until the unit is pushed again,
+ * or until it runs again if the push was not recorded; a yield is not a
+ * block. */
+static int load_binary(FILE *fp, const char *filename)
+{
+    char magic[8];
+    double us_per_cycle, ns_per_cycle;
+    uint64_t start_cycles, first = UINT64_MAX, last = 0;
+    uint32_t pid, num_bufs, b;
+    event_t *events = NULL;
+    size_t num_events = 0, max_events = 0, i, mask;
+    uint64_t *keys;
+    int *vals, *cur, max_conv = 0;
+    uint64_t *seg_start;
+    conv_t *conv = NULL;
+
+    if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, "ABTTRC01", 8) ||
+        fread(&us_per_cycle, sizeof(double), 1, fp) != 1 ||
+        fread(&start_cycles, sizeof(uint64_t), 1, fp) != 1 ||
+        fread(&pid, sizeof(uint32_t), 1, fp) != 1 ||
+        fread(&num_bufs, sizeof(uint32_t), 1, fp) != 1) {
+        goto fn_fail;
+    }
+    ns_per_cycle = us_per_cycle * 1000.0;
+
+    for (b = 0; b < num_bufs; b++) {
+        uint64_t rank, num, start, k;
+        trace_entry_t entry;
+        if (fread(&rank, sizeof(uint64_t), 1, fp) != 1 ||
+            fread(&num, sizeof(uint64_t), 1, fp) != 1 ||
+            fread(&start, sizeof(uint64_t), 1, fp) != 1) {
+            goto fn_fail;
+        }
+        for (k = 0; k < num; k++) {
+            if (fread(&entry, sizeof(entry), 1, fp) != 1) goto fn_fail;
+            if (num_events == max_events) {
+                max_events = max_events ? max_events * 2 : 4096;
+                events = (event_t *)realloc(events,
+                                            max_events * sizeof(event_t));
+            }
+            events[num_events].cycles = entry.cycles;
+            events[num_events].obj = entry.obj;
+            events[num_events].kind = entry.kind & ~EV_TASK;
+            events[num_events].es = (int)b;
+            events[num_events].seq = num_events;
+            num_events++;
+            if (entry.cycles < first) first = entry.cycles;
+            if (entry.cycles > last) last = entry.cycles;
+        }
+    }
+    if (num_events == 0) return 0;
+    qsort(events, num_events, sizeof(event_t), cmp_event);
+
+    for (mask = 1; mask < 2 * num_events; mask <<= 1);
+    keys = (uint64_t *)calloc(mask, sizeof(uint64_t));
+    vals = (int *)calloc(mask, sizeof(int));
+    mask--;
+    cur = (int *)malloc(num_bufs * sizeof(int));
+    seg_start = (uint64_t *)calloc(num_bufs, sizeof(uint64_t));
+    for (b = 0; b < num_bufs; b++) cur[b] = -1;
+
+#define CONV_ENSURE()                                                       \
+    if (g_num_units > max_conv) {                                           \
+        int old = max_conv;                                                 \
+        max_conv = g_max_units;                                             \
+        conv = (conv_t *)realloc(conv, max_conv * sizeof(conv_t));          \
+        memset(&conv[old], 0, (max_conv - old) * sizeof(conv_t));          \
+    }
+#define CYCLES_TO_NS(c) ((uint64_t)((double)(c) * ns_per_cycle))
+#define CLOSE_RUN(es, c)                                                    \
+    do {                                                                    \
+        int u_ = cur[es];                                                   \
+        uint64_t ns_ = CYCLES_TO_NS((c) - seg_start[es]);                   \
+        if (conv[u_].new_seg) add_seg(&g_units[u_]);                        \
+        conv[u_].new_seg = 0;                                               \
+        add_run(u_, ns_);                                                   \
+        conv[u_].run += ns_;                                                \
+        cur[es] = -1;                                                       \
+    } while (0)
+
+    for (i = 0; i < num_events; i++) {
+        event_t *p_ev = &events[i];
+        int es = p_ev->es, u = map_find(keys, vals, mask, p_ev->obj, -1);
+
+        if (p_ev->kind == EV_CREATE || u < 0) {
+            /* Units created before the trace starts are roots. */
+            int parent = (p_ev->kind == EV_CREATE) ? cur[es] : -1;
+            uint64_t at;
+            if (parent >= 0) {
+                at = conv[parent].run
+                   + CYCLES_TO_NS(p_ev->cycles - seg_start[es]);
+            } else {
+                at = CYCLES_TO_NS(p_ev->cycles - first);
+            }
+            u = add_unit(parent, at);
+            CONV_ENSURE();
+            map_find(keys, vals, mask, p_ev->obj, u);
+        }
+
+        switch (p_ev->kind) {
+            case EV_RUN:
+                /* A ULT may switch to another one directly. */
+                if (cur[es] >= 0) CLOSE_RUN(es, p_ev->cycles);
+                if (conv[u].blocked_at) {
+                    uint64_t ready = conv[u].ready_at ? conv[u].ready_at
+                                                      : p_ev->cycles;
+                    add_block(u, CYCLES_TO_NS(ready - conv[u].blocked_at));
+                    conv[u].blocked_at = 0;
+                    conv[u].ready_at = 0;
+                    conv[u].new_seg = 1;
+                }
+                cur[es] = u;
+                seg_start[es] = p_ev->cycles;
+                break;
+            case EV_STOP:
+                if (cur[es] == u) CLOSE_RUN(es, p_ev->cycles);
+                break;
+            case EV_BLOCK:
+                conv[u].blocked_at = p_ev->cycles;
+                conv[u].ready_at = 0;
+                break;
+            case EV_PUSH:
+                if (conv[u].blocked_at && !conv[u].ready_at) {
+                    conv[u].ready_at = p_ev->cycles;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    for (b = 0; b < num_bufs; b++) {
+        if (cur[b] >= 0) CLOSE_RUN(b, last);
+    }
+
+#undef CLOSE_RUN
+#undef CYCLES_TO_NS
+#undef CONV_ENSURE
+
+    free(conv);
+    free(seg_start);
+    free(cur);
+    free(vals);
+    free(keys);
+    free(events);
+    return 0;
+
+  fn_fail:
+    fprintf(stderr, "%s: invalid binary trace\n", filename);
+    free(events);
+    return 1;
+}
+
+static int load_trace(const char *filename)
+{
+    FILE *fp = fopen(filename, "rb");
+    char magic[8];
+    int ret;
+
+    if (fp == NULL) {
+        perror(filename);
+        return 1;
+    }
+    if (fread(magic, 1, 8, fp) == 8 && !memcmp(magic, "ABTTRC01", 8)) {
+        rewind(fp);
+        ret = load_binary(fp, filename);
+    } else {
+        rewind(fp);
+        ret = load_text(fp, filename);
+    }
+    fclose(fp);
+    return ret;
+}
+
+static void dump_trace(FILE *fp)
+{
+    int i, s;
+    for (i = 0; i < g_num_units; i++) {
+        unit_t *p_unit = &g_units[i];
+        if (p_unit->parent >= 0) {
+            fprintf(fp, "u %d %d %.3f\n", i, p_unit->parent,
+                    p_unit->at / 1000.0);
+        } else {
+            fprintf(fp, "u %d - %.3f\n", i, p_unit->at / 1000.0);
+        }
+        for (s = 0; s < p_unit->num_segs; s++) {
+            if (p_unit->segs[s].run) {
+                fprintf(fp, "r %d %.3f\n", i, p_unit->segs[s].run / 1000.0);
+            }
+            if (p_unit->segs[s].block) {
+                fprintf(fp, "b %d %.3f\n", i, p_unit->segs[s].block / 1000.0);
+            }
+        }
+    }
+}
+
+/* Time from the start of p_unit to the creation of a child at running time
+ * at.  A child created at the end of a run is created before the block. */
+static uint64_t child_offset(const unit_t *p_unit, uint64_t at)
+{
+    uint64_t t = 0, run = 0;
+    int s;
+    for (s = 0; s < p_unit->num_segs; s++) {
+        const seg_t *p_seg = &p_unit->segs[s];
+        if (at <= run + p_seg->run) return t + (at - run);
+        t += p_seg->run + p_seg->block;
+        run += p_seg->run;
+    }
+    return t;
+}
+
+static int cmp_child(const void *p1, const void *p2)
+{
+    int c1 = *(const int *)p1, c2 = *(const int *)p2;
+    if (g_units[c1].at != g_units[c2].at) {
+        return g_units[c1].at < g_units[c2].at ? -1 : 1;
+    }
+    return c1 - c2;
+}
+
+/* Sort the children by creation and compute the total running time and the
+ * makespan with unlimited ESs.  Parents come before their children. */
+static void analyze_trace(uint64_t *p_work, uint64_t *p_critical_path)
+{
+    uint64_t *starts = (uint64_t *)malloc(g_num_units * sizeof(uint64_t));
+    uint64_t work = 0, cp = 0;
+    int i, c, s;
+
+    for (i = 0; i < g_num_units; i++) {
+        unit_t *p_unit = &g_units[i];
+        uint64_t t;
+        qsort(p_unit->children, p_unit->num_children, sizeof(int),
+              cmp_child);
+        if (p_unit->parent < 0) starts[i] = p_unit->at;
+        t = starts[i];
+        for (s = 0; s < p_unit->num_segs; s++) {
+            t += p_unit->segs[s].run + p_unit->segs[s].block;
+            work += p_unit->segs[s].run;
+        }
+        if (t > cp) cp = t;
+        for (c = 0; c < p_unit->num_children; c++) {
+            int child = p_unit->children[c];
+            starts[child] = starts[i]
+                          + child_offset(p_unit, g_units[child].at);
+        }
+    }
+    free(starts);
+    *p_work = work;
+    *p_critical_path = cp;
+}
+
+
+/*****************************************************************************/
+/* Replay                                                                    */
+/*****************************************************************************/
+
+static void timer_lock(void)
+{
+    while (__atomic_test_and_set(&g_timer_lock, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+static void timer_unlock(void)
+{
+    __atomic_clear(&g_timer_lock, __ATOMIC_RELEASE);
+}
+
+static void timer_push(uint64_t time, int unit)
+{
+    int i = g_num_timers++;
+    while (i > 0 && g_timers[(i - 1) / 2].time > time) {
+        g_timers[i] = g_timers[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    g_timers[i].time = time;
+    g_timers[i].unit = unit;
+}
+
+static timer_t_ timer_pop(void)
+{
+    timer_t_ top = g_timers[0], last = g_timers[--g_num_timers];
+    int i = 0, child;
+    while ((child = 2 * i + 1) < g_num_timers) {
+        if (child + 1 < g_num_timers &&
+            g_timers[child + 1].time < g_timers[child].time) {
+            child++;
+        }
+        if (last.time <= g_timers[child].time) break;
+        g_timers[i] = g_timers[child];
+        i = child;
+    }
+    g_timers[i] = last;
+    return top;
+}
+
+static uint64_t timer_next(void)
+{
+    uint64_t time;
+    timer_lock();
+    time = g_num_timers ? g_timers[0].time : UINT64_MAX;
+    timer_unlock();
+    return time;
+}
+
+static void unit_func(void *arg);
+
+/* Make a unit ready at virtual time on ES es (-1 for none).  A root is
+ * created in the pool of the first ES, and a child in the pool of the ES
+ * that creates it.  A blocked unit is resumed into its pool. */
+static void make_ready(int id, uint64_t time, int es)
+{
+    unit_t *p_unit = &g_units[id];
+    ABT_thread_state state;
+    int ret;
+
+    p_unit->ready = time;
+    p_unit->ready_es = es;
+    __atomic_fetch_add(&g_queued, 1, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&g_ready_since, now_ns(), __ATOMIC_RELEASE);
+    if (p_unit->thread == ABT_THREAD_NULL) {
+        ret = ABT_thread_create(g_pools[es < 0 ? 0 : es], unit_func,
+                                (void *)(intptr_t)id, ABT_THREAD_ATTR_NULL,
+                                NULL);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    } else {
+        /* The unit may not have been suspended yet. */
+        do {
+            ABT_thread_get_state(p_unit->thread, &state);
+        } while (state != ABT_THREAD_STATE_BLOCKED && (sched_yield(), 1));
+        ret = ABT_thread_resume(p_unit->thread);
+        ABT_TEST_ERROR(ret, "ABT_thread_resume");
+    }
+}
+
+/* Make the units whose timers have expired by time ready.  Returns the
+ * number of them. */
+static int fire_timers(uint64_t time, int es)
+{
+    timer_t_ timers[16];
+    int i, num = 0;
+
+    timer_lock();
+    while (num < 16 && g_num_timers && g_timers[0].time <= time) {
+        timers[num++] = timer_pop();
+    }
+    timer_unlock();
+    for (i = 0; i < num; i++) make_ready(timers[i].unit, timers[i].time, es);
+    return num;
+}
+
+/* Wait until no other ES has to act before the clock of ES e.  Busy ESs
+ * behind it, or at the same time with a lower index, go first.  Idle ESs
+ * behind it get GRACE to pop queued units. */
+static void wait_turn(int e)
+{
+    uint64_t time = g_es[e].clock;
+    int f;
+
+  retry:
+    for (f = 0; f < g_num_xstreams; f++) {
+        es_t *p_es = &g_es[f];
+        uint64_t clock;
+        if (f == e) continue;
+        if (__atomic_load_n(&p_es->busy, __ATOMIC_ACQUIRE)) {
+            clock = __atomic_load_n(&p_es->clock, __ATOMIC_ACQUIRE);
+            if (clock < time || (clock == time && f < e)) goto wait;
+        } else {
+            uint64_t since;
+            clock = __atomic_load_n(&p_es->clock, __ATOMIC_ACQUIRE);
+            if (clock >= time ||
+                __atomic_load_n(&g_queued, __ATOMIC_ACQUIRE) == 0) {
+                continue;
+            }
+            since = __atomic_load_n(&p_es->idle_since, __ATOMIC_ACQUIRE);
+            if (since < __atomic_load_n(&g_ready_since, __ATOMIC_ACQUIRE)) {
+                since = __atomic_load_n(&g_ready_since, __ATOMIC_ACQUIRE);
+            }
+            if (now_ns() < since + g_grace_ns) goto wait;
+        }
+    }
+    return;
+
+  wait:
+    sched_yield();
+    goto retry;
+}
+
+/* Advance the clock of ES e to time, making the units whose timers expire
+ * on the way ready in order. */
+static void advance(int e, uint64_t time)
+{
+    es_t *p_es = &g_es[e];
+    while (1) {
+        uint64_t next = timer_next();
+        if (next > time) next = time;
+        if (next > p_es->clock) {
+            __atomic_store_n(&p_es->clock, next, __ATOMIC_RELEASE);
+        }
+        wait_turn(e);
+        if (fire_timers(p_es->clock, e) == 0 && p_es->clock >= time) break;
+    }
+}
+
+/* Start or restart running p_unit on the calling ES */
+static int run_begin(unit_t *p_unit)
+{
+    int rank, e;
+    uint64_t start, delay;
+    es_t *p_es;
+
+    ABT_xstream_self_rank(&rank);
+    e = g_es_of_rank[rank];
+    p_es = &g_es[e];
+    start = p_es->clock > p_unit->ready ? p_es->clock : p_unit->ready;
+    __atomic_store_n(&p_es->clock, start, __ATOMIC_RELEASE);
+    __atomic_store_n(&p_es->busy, 1, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&g_queued, 1, __ATOMIC_ACQ_REL);
+
+    delay = start - p_unit->ready;
+    p_es->num_runs++;
+    p_es->queue_sum += delay;
+    if (delay > p_es->queue_max) p_es->queue_max = delay;
+    if (p_unit->ready_es >= 0 && p_unit->ready_es != e) {
+        p_es->num_migrations++;
+    }
+    return e;
+}
+
+static void run_end(int e)
+{
+    __atomic_store_n(&g_es[e].idle_since, now_ns(), __ATOMIC_RELEASE);
+    __atomic_store_n(&g_es[e].busy, 0, __ATOMIC_RELEASE);
+}
+
+static void unit_func(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    unit_t *p_unit = &g_units[id];
+    uint64_t t, run = 0, makespan;
+    int e, s, c = 0;
+
+    ABT_thread_self(&p_unit->thread);
+    e = run_begin(p_unit);
+    t = g_es[e].clock;
+
+    for (s = 0; s < p_unit->num_segs; s++) {
+        seg_t *p_seg = &p_unit->segs[s];
+        while (c < p_unit->num_children &&
+               g_units[p_unit->children[c]].at <= run + p_seg->run) {
+            int child = p_unit->children[c++];
+            uint64_t at = g_units[child].at;
+            advance(e, t + (at > run ? at - run : 0));
+            make_ready(child, g_es[e].clock, e);
+        }
+        t += p_seg->run;
+        run += p_seg->run;
+        advance(e, t);
+
+        if (p_seg->block > 0) {
+            timer_lock();
+            timer_push(t + p_seg->block, id);
+            timer_unlock();
+            run_end(e);
+            ABT_self_suspend();
+            e = run_begin(p_unit);
+            t = g_es[e].clock;
+        }
+    }
+    while (c < p_unit->num_children) {
+        advance(e, t);
+        make_ready(p_unit->children[c++], g_es[e].clock, e);
+    }
+
+    makespan = __atomic_load_n(&g_makespan, __ATOMIC_RELAXED);
+    while (t > makespan &&
+           !__atomic_compare_exchange_n(&g_makespan, &makespan, t, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    __atomic_fetch_add(&g_done, 1, __ATOMIC_ACQ_REL);
+    run_end(e);
+}
+
+static int all_idle(void)
+{
+    int e;
+    if (__atomic_load_n(&g_queued, __ATOMIC_ACQUIRE) > 0) return 0;
+    for (e = 0; e < g_num_xstreams; e++) {
+        if (__atomic_load_n(&g_es[e].busy, __ATOMIC_ACQUIRE)) return 0;
+    }
+    return 1;
+}
+
+static void replay(const char *sim, const char *name, ABT_sched_predef predef,
+                   int steal, uint64_t work, uint64_t critical_path)
+{
+    ABT_xstream *xstreams;
+    ABT_pool *my_pools;
+    ABT_sched sched;
+    ABT_xstream_stats stats;
+    uint64_t num_steals = 0, num_runs = 0, num_migrations = 0;
+    uint64_t queue_sum = 0, queue_max = 0;
+    int i, k, max_rank = 0, ret;
+
+    ret = ABT_init(0, NULL);
+    ABT_TEST_ERROR(ret, "ABT_init");
+
+    xstreams = (ABT_xstream *)malloc(g_num_xstreams * sizeof(ABT_xstream));
+    my_pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    memset(g_es, 0, g_num_xstreams * sizeof(es_t));
+
+    /* The primary ES only drives the replay. */
+    for (i = 0; i < g_num_xstreams; i++) {
+        for (k = 0; k < g_num_xstreams; k++) {
+            my_pools[k] = g_pools[(i + k) % g_num_xstreams];
+        }
+        ret = ABT_sched_create_basic(predef, steal ? g_num_xstreams : 1,
+                                     my_pools, ABT_SCHED_CONFIG_NULL, &sched);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(sched, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+        ret = ABT_xstream_get_rank(xstreams[i], &k);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_rank");
+        if (k > max_rank) max_rank = k;
+    }
+    g_es_of_rank = (int *)malloc((max_rank + 1) * sizeof(int));
+    for (i = 0; i < g_num_xstreams; i++) {
+        ABT_xstream_get_rank(xstreams[i], &k);
+        g_es_of_rank[k] = i;
+    }
+
+    g_queued = 0;
+    g_done = 0;
+    g_makespan = 0;
+    g_num_timers = 0;
+    for (i = 0; i < g_num_units; i++) {
+        g_units[i].thread = ABT_THREAD_NULL;
+        if (g_units[i].parent < 0) timer_push(g_units[i].at, i);
+    }
+
+    /* Start the earliest roots or blocked units whenever nothing runs */
+    while (__atomic_load_n(&g_done, __ATOMIC_ACQUIRE) < g_num_units) {
+        if (all_idle()) fire_timers(timer_next(), -1);
+        sched_yield();
+    }
+
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_info_query_xstream_stats(xstreams[i], &stats);
+        ABT_TEST_ERROR(ret, "ABT_info_query_xstream_stats");
+        num_steals += stats.num_steals;
+        num_runs += g_es[i].num_runs;
+        num_migrations += g_es[i].num_migrations;
+        queue_sum += g_es[i].queue_sum;
+        if (g_es[i].queue_max > queue_max) queue_max = g_es[i].queue_max;
+    }
+    printf("{\"sim\":\"%s\",\"sched\":\"%s\",\"num_xstreams\":%d,"
+           "\"num_units\":%d,\"makespan_us\":%.3f,\"work_us\":%.3f,"
+           "\"critical_path_us\":%.3f,\"steals\":%llu,\"migrations\":%llu,"
+           "\"queue_mean_us\":%.3f,\"queue_max_us\":%.3f}\n",
+           sim, name, g_num_xstreams, g_num_units, g_makespan / 1000.0,
+           work / 1000.0, critical_path / 1000.0,
+           (unsigned long long)num_steals, (unsigned long long)num_migrations,
+           num_runs ? queue_sum / 1000.0 / num_runs : 0.0,
+           queue_max / 1000.0);
+    fflush(stdout);
+
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(g_es_of_rank);
+    free(my_pools);
+    free(xstreams);
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+}
+
+static const struct {
+    const char *name;
+    ABT_sched_predef predef;
+    int steal;                  /* Whether the other pools are victims */
+} g_scheds[] = {
+    { "basic", ABT_SCHED_BASIC, 0 },
+    { "randws", ABT_SCHED_RANDWS, 1 },
+    { "localws", ABT_SCHED_LOCALWS, 1 },
+    { "hier", ABT_SCHED_HIER, 0 },
+};
+
+int main(int argc, char *argv[])
+{
+    const char *sim = "forkjoin", *scheds = DEFAULT_SCHEDS;
+    char *list, *name;
+    uint64_t work, critical_path;
+    int opt, dump = 0, i, n;
+
+    g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+    g_grace_ns = DEFAULT_GRACE_US * 1000;
+    while ((opt = getopt(argc, argv, "e:s:g:d")) != -1) {
+        switch (opt) {
+            case 'e': g_num_xstreams = atoi(optarg); break;
+            case 's': scheds = optarg; break;
+            case 'g': g_grace_ns = us_to_ns(atof(optarg)); break;
+            case 'd': dump = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-e ESs] [-s SCHED[,SCHED...]] "
+                        "[-g GRACE] [-d] [TRACE_FILE]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (g_num_xstreams <= 0) g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+
+    if (optind < argc) {
+        sim = argv[optind];
+        if (load_trace(sim)) return EXIT_FAILURE;
+        if (strrchr(sim, '/')) sim = strrchr(sim, '/') + 1;
+    } else {
+        gen_unit(-1, 0, GEN_DEPTH);
+    }
+    if (dump) {
+        dump_trace(stdout);
+        return EXIT_SUCCESS;
+    }
+    if (g_num_units == 0) {
+        fprintf(stderr, "no work units\n");
+        return EXIT_FAILURE;
+    }
+    analyze_trace(&work, &critical_path);
+
+    g_es = (es_t *)malloc(g_num_xstreams * sizeof(es_t));
+    g_pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+    g_timers = (timer_t_ *)malloc(g_num_units * sizeof(timer_t_));
+
+    list = strdup(scheds);
+    for (name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        n = sizeof(g_scheds) / sizeof(g_scheds[0]);
+        for (i = 0; i < n; i++) {
+            if (!strcmp(name, g_scheds[i].name)) break;
+        }
+        if (i == n) {
+            fprintf(stderr, "unknown scheduler: %s\n", name);
+            return EXIT_FAILURE;
+        }
+        replay(sim, g_scheds[i].name, g_scheds[i].predef, g_scheds[i].steal,
+               work, critical_path);
+    }
+    free(list);
+
+    for (i = 0; i < g_num_units; i++) {
+        free(g_units[i].segs);
+        free(g_units[i].children);
+    }
+    free(g_units);
+    free(g_timers);
+    free(g_pools);
+    free(g_es);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Cost of yielding among many ULTs that keep data at the tops of their
+ * stacks, with and without stack coloring (ABT_MEM_STACK_COLORS) */
+
+#include "abtbench.h"
+
+#define DEFAULT_NUM_THREADS     2048
+#define DEFAULT_NUM_OPS         200
+#define NUM_LINES               4
+#define LINE_SIZE               64
+
+static int g_num_threads;
+static int g_num_ops;
+static ABT_pool g_pool;
+
+/* Touch a few cache lines near the top of the stack between yields, as a ULT
+ * with a shallow call chain does. */
+static void yield_func(void *arg)
+{
+    volatile char buf[NUM_LINES * LINE_SIZE];
+    int i, j;
+    ABT_TEST_UNUSED(arg);
+
+    for (i = 0; i < g_num_ops; i++) {
+        for (j = 0; j < NUM_LINES; j++) {
+            buf[j * LINE_SIZE]++;
+        }
+        ABT_thread_yield();
+    }
+}
+
+static double yield_many(void *arg)
+{
+    ABT_thread *threads;
+    double t_start, t_end;
+    int i, ret;
+    ABT_TEST_UNUSED(arg);
+
+    threads = (ABT_thread *)malloc(g_num_threads * sizeof(ABT_thread));
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_create(g_pool, yield_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_join(threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_join");
+    }
+    t_end = ABT_get_wtime();
+    for (i = 0; i < g_num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+    return t_end - t_start;
+}
+
+/* Run the benchmark in a new Argobots instance with the given colors */
+static void run_case(const char *name, const char *colors)
+{
+    ABT_xstream xstream;
+    int ret;
+
+    setenv("ABT_MEM_STACK_COLORS", colors, 1);
+    ret = ABT_init(0, NULL);
+    ABT_TEST_ERROR(ret, "ABT_init");
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &g_pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* Each yield is an operation. */
+    ABT_bench_run("stack_color", name, 1, g_num_threads * g_num_ops,
+                  yield_many, NULL);
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_test_read_args(argc, argv);
+    if (argc > 1) {
+        g_num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_ops     = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        g_num_threads = DEFAULT_NUM_THREADS;
+        g_num_ops     = DEFAULT_NUM_OPS;
+    }
+
+    run_case("yield_uncolored", "1");
+    run_case("yield_colored", "8");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Cost of load balancing by the random work-stealing scheduler.  One ULT
+ * creates all tasklets in the pool of the primary ES, and the other ESs have
+ * to steal them. */
+
+#include "abtbench.h"
+
+#define DEFAULT_NUM_XSTREAMS    4
+#define DEFAULT_NUM_OPS         100000
+
+static int g_num_xstreams;
+static int g_num_ops;
+static ABT_pool *g_pools;
+static volatile int g_counter;
+
+static void task_func(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    __sync_fetch_and_add(&g_counter, 1);
+}
+
+static void root_func(void *arg)
+{
+    double *p_time = (double *)arg;
+    double t_start;
+    int i, ret;
+
+    g_counter = 0;
+    t_start = ABT_get_wtime();
+    for (i = 0; i < g_num_ops; i++) {
+        ret = ABT_task_create(g_pools[0], task_func, NULL, NULL);
+        ABT_TEST_ERROR(ret, "ABT_task_create");
+    }
+    while (g_counter < g_num_ops) {
+        ABT_thread_yield();
+    }
+    *p_time = ABT_get_wtime() - t_start;
+}
+
+static double steal_tasks(void *arg)
+{
+    ABT_thread thread;
+    double time;
+    int ret;
+    ABT_TEST_UNUSED(arg);
+
+    ret = ABT_thread_create(g_pools[0], root_func, &time,
+                            ABT_THREAD_ATTR_NULL, &thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&thread);
+    ABT_TEST_ERROR(ret, "ABT_thread_free");
+    return time;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *my_pools;
+    ABT_xstream_stats stats;
+    uint64_t num_steals = 0;
+    int i, k, ret;
+
+    ABT_test_read_args(argc, argv);
+    if (argc > 1) {
+        g_num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_ops      = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+        g_num_ops      = DEFAULT_NUM_OPS;
+    }
+
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+
+    xstreams = (ABT_xstream *)malloc(g_num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(g_num_xstreams * sizeof(ABT_sched));
+    g_pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+    my_pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    }
+    for (i = 0; i < g_num_xstreams; i++) {
+        for (k = 0; k < g_num_xstreams; k++) {
+            my_pools[k] = g_pools[(i + k) % g_num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, g_num_xstreams,
+                                     my_pools, ABT_SCHED_CONFIG_NULL,
+                                     &scheds[i]);
+        ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    }
+    free(my_pools);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_set_main_sched");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+
+    ABT_bench_run("steal", "randws_tasklets", g_num_xstreams, g_num_ops,
+                  steal_tasks, NULL);
+
+    /* stdout only has the results, so the number of steals goes to stderr. */
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_info_query_xstream_stats(xstreams[i], &stats);
+        ABT_TEST_ERROR(ret, "ABT_info_query_xstream_stats");
+        num_steals += stats.num_steals;
+    }
+    fprintf(stderr, "# of steals: %llu\n", (unsigned long long)num_steals);
+
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(g_pools);
+    free(scheds);
+    free(xstreams);
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+    return EXIT_SUCCESS;
+}
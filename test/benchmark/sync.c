@@ -0,0 +1,587 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Latency of the synchronization objects.  Pairs of ULTs on different ESs
+ * (on the same ES if only one ES is used) pass a token back and forth through
+ * each kind of object, a ULT streams batches of messages to another through a
+ * channel, ULTs more than the permits of a semaphore share them, and ULTs on
+ * all ESs repeatedly wait on a barrier.  A pair of ULTs also bounces a byte
+ * through pipes with ABT_io_wait(), and many ULTs read small blocks of a file
+ * with ABT_io_read() and, for comparison, with pread().  Many suspended ULTs
+ * are also woken up at once by ABT_thread_resume() on each of them and by one
+ * ABT_thread_resume_many(). */
+
+#include <unistd.h>
+#include <poll.h>
+#include "abtbench.h"
+
+#define DEFAULT_NUM_XSTREAMS    2
+#define DEFAULT_NUM_OPS         10000
+#define NUM_THROTTLED_THREADS   4
+#define NUM_MUTEX_THREADS       8
+#define NUM_PERMITS             2
+#define CHANNEL_CAPACITY        64
+#define CHANNEL_BATCH           16
+#define NUM_IO_THREADS          64
+#define IO_BLOCK_SIZE           512
+#define NUM_RESUME_THREADS      256
+
+static int g_num_xstreams;
+static int g_num_ops;
+static ABT_pool *g_pools;
+
+static ABT_mutex g_mutex;
+static ABT_cond g_cond;
+static ABT_eventual g_eventuals[2];
+static ABT_future g_futures[2];
+static ABT_wait_group g_wgs[2];
+static ABT_sem g_sem;
+static ABT_channel g_channels[2];
+static ABT_barrier g_barrier;
+static int g_pipes[2][2];
+static int g_file;
+static int g_turn;
+static int g_counter;
+static int g_permits;
+static int g_num_rounds;
+
+/* Run func on num_threads ULTs, one on each ES in turn, and return the time
+ * until all of them finish. */
+static double run_threads(int num_threads, void (*func)(void *))
+{
+    ABT_thread *threads;
+    double t_start, t_end;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    t_start = ABT_get_wtime();
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(g_pools[i % g_num_xstreams], func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    t_end = ABT_get_wtime();
+    free(threads);
+    return t_end - t_start;
+}
+
+static void mutex_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < g_num_ops; i++) {
+        ABT_mutex_lock(g_mutex);
+        g_counter++;
+        ABT_mutex_unlock(g_mutex);
+    }
+}
+
+/* Same as mutex_func, but the owner yields so that the others are queued on
+ * the mutex. */
+static void mutex_yield_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < g_num_ops; i++) {
+        ABT_mutex_lock(g_mutex);
+        g_counter++;
+        ABT_thread_yield();
+        ABT_mutex_unlock(g_mutex);
+    }
+}
+
+/* Wait for the turn of this ULT and pass the turn to the other */
+static void cond_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int i;
+    for (i = 0; i < g_num_ops; i++) {
+        ABT_mutex_lock(g_mutex);
+        while (g_turn != idx) {
+            ABT_cond_wait(g_cond, g_mutex);
+        }
+        g_turn = 1 - idx;
+        ABT_cond_signal(g_cond);
+        ABT_mutex_unlock(g_mutex);
+    }
+}
+
+/* The first ULT sets g_eventuals[0] and waits for g_eventuals[1], and the
+ * other does the reverse.  Each ULT resets the eventual it waited for before
+ * answering, so the next set is never lost. */
+static void eventual_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int i;
+    for (i = 0; i < g_num_ops; i++) {
+        if (idx == 0) {
+            ABT_eventual_set(g_eventuals[0], NULL, 0);
+            ABT_eventual_wait(g_eventuals[1], NULL);
+            ABT_eventual_reset(g_eventuals[1]);
+        } else {
+            ABT_eventual_wait(g_eventuals[0], NULL);
+            ABT_eventual_reset(g_eventuals[0]);
+            ABT_eventual_set(g_eventuals[1], NULL, 0);
+        }
+    }
+}
+
+static void future_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int i;
+    for (i = 0; i < g_num_ops; i++) {
+        if (idx == 0) {
+            ABT_future_set(g_futures[0], NULL);
+            ABT_future_wait(g_futures[1]);
+            ABT_future_reset(g_futures[1]);
+        } else {
+            ABT_future_wait(g_futures[0]);
+            ABT_future_reset(g_futures[0]);
+            ABT_future_set(g_futures[1], NULL);
+        }
+    }
+}
+
+/* Same as future_func, but the count of a wait group is added back after the
+ * wait instead of resetting a future. */
+static void wait_group_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int i;
+    for (i = 0; i < g_num_ops; i++) {
+        if (idx == 0) {
+            ABT_wait_group_done(g_wgs[0]);
+            ABT_wait_group_wait(g_wgs[1]);
+            ABT_wait_group_add(g_wgs[1], 1);
+        } else {
+            ABT_wait_group_wait(g_wgs[0]);
+            ABT_wait_group_add(g_wgs[0], 1);
+            ABT_wait_group_done(g_wgs[1]);
+        }
+    }
+}
+
+/* ULTs more than the permits repeatedly take a permit of a semaphore, yield
+ * while holding it, and return it. */
+static void sem_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < g_num_ops; i++) {
+        ABT_sem_wait(g_sem);
+        ABT_thread_yield();
+        ABT_sem_post(g_sem);
+    }
+}
+
+/* Same as sem_func, but the semaphore is emulated with a mutex and a
+ * condition variable. */
+static void sem_cond_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < g_num_ops; i++) {
+        ABT_mutex_lock(g_mutex);
+        while (g_permits == 0) {
+            ABT_cond_wait(g_cond, g_mutex);
+        }
+        g_permits--;
+        ABT_mutex_unlock(g_mutex);
+        ABT_thread_yield();
+        ABT_mutex_lock(g_mutex);
+        g_permits++;
+        ABT_cond_signal(g_cond);
+        ABT_mutex_unlock(g_mutex);
+    }
+}
+
+/* Same as eventual_func, but the token is a message through a channel of
+ * each direction. */
+static void channel_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    void *msg;
+    int i;
+    for (i = 0; i < g_num_ops; i++) {
+        if (idx == 0) {
+            ABT_channel_send(g_channels[0], NULL);
+            ABT_channel_recv(g_channels[1], &msg);
+        } else {
+            ABT_channel_recv(g_channels[0], &msg);
+            ABT_channel_send(g_channels[1], NULL);
+        }
+    }
+}
+
+static void io_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    char c = 0;
+    int i;
+    for (i = 0; i < g_num_ops; i++) {
+        if (idx == 0) {
+            if (write(g_pipes[0][1], &c, 1) != 1) break;
+            ABT_io_wait(g_pipes[1][0], POLLIN, -1.0, NULL);
+            if (read(g_pipes[1][0], &c, 1) != 1) break;
+        } else {
+            ABT_io_wait(g_pipes[0][0], POLLIN, -1.0, NULL);
+            if (read(g_pipes[0][0], &c, 1) != 1) break;
+            if (write(g_pipes[1][1], &c, 1) != 1) break;
+        }
+    }
+}
+
+static void io_read_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    char buf[IO_BLOCK_SIZE];
+    int i;
+    for (i = 0; i < g_num_ops / NUM_IO_THREADS; i++) {
+        ABT_io_read(g_file, buf, IO_BLOCK_SIZE, (off_t)idx * IO_BLOCK_SIZE,
+                    NULL);
+    }
+}
+
+static void pread_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    char buf[IO_BLOCK_SIZE];
+    int i;
+    for (i = 0; i < g_num_ops / NUM_IO_THREADS; i++) {
+        if (pread(g_file, buf, IO_BLOCK_SIZE, (off_t)idx * IO_BLOCK_SIZE) < 0)
+            break;
+    }
+}
+
+/* The first ULT streams messages to the other in batches. */
+static void channel_batch_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    void *msgs[CHANNEL_BATCH] = { NULL };
+    int i;
+    for (i = 0; i < g_num_ops; i += CHANNEL_BATCH) {
+        if (idx == 0) {
+            ABT_channel_send_many(g_channels[0], CHANNEL_BATCH, msgs);
+        } else {
+            ABT_channel_recv_many(g_channels[0], CHANNEL_BATCH, msgs);
+        }
+    }
+}
+
+static void barrier_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < g_num_ops; i++) {
+        ABT_barrier_wait(g_barrier);
+    }
+}
+
+static void suspend_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < g_num_rounds; i++) {
+        ABT_self_suspend();
+    }
+}
+
+/* Create NUM_RESUME_THREADS ULTs that suspend themselves repeatedly, and
+ * resume all of them one by one if many is zero or with one call otherwise
+ * whenever they are all blocked.  Returns the time per resumed ULT. */
+static double resume_threads(int many)
+{
+    ABT_thread threads[NUM_RESUME_THREADS];
+    ABT_thread_state state;
+    double t_start, t_end;
+    int i, r, ret;
+
+    g_num_rounds = g_num_ops / NUM_RESUME_THREADS;
+    if (g_num_rounds == 0) g_num_rounds = 1;
+    t_start = ABT_get_wtime();
+    for (i = 0; i < NUM_RESUME_THREADS; i++) {
+        ret = ABT_thread_create(g_pools[i % g_num_xstreams], suspend_func,
+                                NULL, ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    for (r = 0; r < g_num_rounds; r++) {
+        for (i = 0; i < NUM_RESUME_THREADS; i++) {
+            do {
+                ABT_thread_get_state(threads[i], &state);
+                if (state == ABT_THREAD_STATE_BLOCKED) break;
+                ABT_thread_yield();
+            } while (1);
+        }
+        if (many) {
+            ret = ABT_thread_resume_many(NUM_RESUME_THREADS, threads);
+            ABT_TEST_ERROR(ret, "ABT_thread_resume_many");
+        } else {
+            for (i = 0; i < NUM_RESUME_THREADS; i++) {
+                ret = ABT_thread_resume(threads[i]);
+                ABT_TEST_ERROR(ret, "ABT_thread_resume");
+            }
+        }
+    }
+    for (i = 0; i < NUM_RESUME_THREADS; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    t_end = ABT_get_wtime();
+    return (t_end - t_start) * g_num_ops / (g_num_rounds * NUM_RESUME_THREADS);
+}
+
+static double mutex_uncontended(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(1, mutex_func);
+}
+
+static double mutex_contended(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    /* Per lock and unlock of either ULT */
+    return run_threads(2, mutex_func) / 2;
+}
+
+static double mutex_queued(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    /* Per lock and unlock of any ULT */
+    return run_threads(NUM_MUTEX_THREADS, mutex_yield_func)
+           / NUM_MUTEX_THREADS;
+}
+
+static double cond_pingpong(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    g_turn = 0;
+    return run_threads(2, cond_func);
+}
+
+static double eventual_pingpong(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(2, eventual_func);
+}
+
+static double future_pingpong(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(2, future_func);
+}
+
+static double wait_group_pingpong(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(2, wait_group_func);
+}
+
+static double sem_throttle(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    /* Per wait and post of any ULT */
+    return run_threads(NUM_THROTTLED_THREADS, sem_func)
+           / NUM_THROTTLED_THREADS;
+}
+
+static double sem_cond_throttle(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    g_permits = NUM_PERMITS;
+    return run_threads(NUM_THROTTLED_THREADS, sem_cond_func)
+           / NUM_THROTTLED_THREADS;
+}
+
+static double channel_pingpong(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(2, channel_func);
+}
+
+static double channel_stream_batch(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(2, channel_batch_func);
+}
+
+static double io_pingpong(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(2, io_func);
+}
+
+static double io_file_read(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(NUM_IO_THREADS, io_read_func);
+}
+
+static double io_file_pread(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(NUM_IO_THREADS, pread_func);
+}
+
+static double barrier_wait(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return run_threads(g_num_xstreams, barrier_func);
+}
+
+static double resume_loop(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return resume_threads(0);
+}
+
+static double resume_many(void *arg)
+{
+    ABT_TEST_UNUSED(arg);
+    return resume_threads(1);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    int i, ret;
+
+    ABT_test_read_args(argc, argv);
+    if (argc > 1) {
+        g_num_xstreams = ABT_test_get_arg_val(ABT_TEST_ARG_N_ES);
+        g_num_ops      = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+        g_num_ops      = DEFAULT_NUM_OPS;
+    }
+
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+
+    xstreams = (ABT_xstream *)malloc(g_num_xstreams * sizeof(ABT_xstream));
+    g_pools = (ABT_pool *)malloc(g_num_xstreams * sizeof(ABT_pool));
+    ret = ABT_xstream_self(&xstreams[0]);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &g_pools[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_mutex_create(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_cond_create(&g_cond);
+    ABT_TEST_ERROR(ret, "ABT_cond_create");
+    for (i = 0; i < 2; i++) {
+        ret = ABT_eventual_create(0, &g_eventuals[i]);
+        ABT_TEST_ERROR(ret, "ABT_eventual_create");
+        ret = ABT_future_create(1, NULL, &g_futures[i]);
+        ABT_TEST_ERROR(ret, "ABT_future_create");
+        ret = ABT_wait_group_create(&g_wgs[i]);
+        ABT_TEST_ERROR(ret, "ABT_wait_group_create");
+        ret = ABT_wait_group_add(g_wgs[i], 1);
+        ABT_TEST_ERROR(ret, "ABT_wait_group_add");
+        ret = ABT_channel_create(CHANNEL_CAPACITY, &g_channels[i]);
+        ABT_TEST_ERROR(ret, "ABT_channel_create");
+        if (pipe(g_pipes[i]) != 0) {
+            perror("pipe");
+            return EXIT_FAILURE;
+        }
+    }
+    {
+        char path[] = "/tmp/abt_bench_sync_XXXXXX";
+        char buf[NUM_IO_THREADS * IO_BLOCK_SIZE] = { 0 };
+        g_file = mkstemp(path);
+        if (g_file < 0 || write(g_file, buf, sizeof(buf)) != sizeof(buf)) {
+            perror("mkstemp");
+            return EXIT_FAILURE;
+        }
+        unlink(path);
+    }
+    ret = ABT_sem_create(NUM_PERMITS, &g_sem);
+    ABT_TEST_ERROR(ret, "ABT_sem_create");
+    ret = ABT_barrier_create(g_num_xstreams, &g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_create");
+
+    ABT_bench_run("sync", "mutex_uncontended", g_num_xstreams, g_num_ops,
+                  mutex_uncontended, NULL);
+    ABT_bench_run("sync", "mutex_contended", g_num_xstreams, g_num_ops,
+                  mutex_contended, NULL);
+    ABT_bench_run("sync", "mutex_queued", g_num_xstreams, g_num_ops,
+                  mutex_queued, NULL);
+    ABT_bench_run("sync", "cond_pingpong", g_num_xstreams, g_num_ops,
+                  cond_pingpong, NULL);
+    ABT_bench_run("sync", "eventual_pingpong", g_num_xstreams, g_num_ops,
+                  eventual_pingpong, NULL);
+    ABT_bench_run("sync", "future_pingpong", g_num_xstreams, g_num_ops,
+                  future_pingpong, NULL);
+    ABT_bench_run("sync", "wait_group_pingpong", g_num_xstreams, g_num_ops,
+                  wait_group_pingpong, NULL);
+    ABT_bench_run("sync", "sem_throttle", g_num_xstreams, g_num_ops,
+                  sem_throttle, NULL);
+    ABT_bench_run("sync", "sem_cond_throttle", g_num_xstreams, g_num_ops,
+                  sem_cond_throttle, NULL);
+    ABT_bench_run("sync", "channel_pingpong", g_num_xstreams, g_num_ops,
+                  channel_pingpong, NULL);
+    ABT_bench_run("sync", "channel_stream_batch", g_num_xstreams, g_num_ops,
+                  channel_stream_batch, NULL);
+    ABT_bench_run("sync", "io_pingpong", g_num_xstreams, g_num_ops,
+                  io_pingpong, NULL);
+    ABT_bench_run("sync", "io_file_read", g_num_xstreams, g_num_ops,
+                  io_file_read, NULL);
+    ABT_bench_run("sync", "io_file_pread", g_num_xstreams, g_num_ops,
+                  io_file_pread, NULL);
+    ABT_bench_run("sync", "barrier", g_num_xstreams, g_num_ops,
+                  barrier_wait, NULL);
+    ABT_bench_run("sync", "resume_loop", g_num_xstreams, g_num_ops,
+                  resume_loop, NULL);
+    ABT_bench_run("sync", "resume_many", g_num_xstreams, g_num_ops,
+                  resume_many, NULL);
+
+    ret = ABT_barrier_free(&g_barrier);
+    ABT_TEST_ERROR(ret, "ABT_barrier_free");
+    ret = ABT_sem_free(&g_sem);
+    ABT_TEST_ERROR(ret, "ABT_sem_free");
+    for (i = 0; i < 2; i++) {
+        ret = ABT_wait_group_done(g_wgs[i]);
+        ABT_TEST_ERROR(ret, "ABT_wait_group_done");
+        ret = ABT_wait_group_free(&g_wgs[i]);
+        ABT_TEST_ERROR(ret, "ABT_wait_group_free");
+        ret = ABT_channel_free(&g_channels[i]);
+        ABT_TEST_ERROR(ret, "ABT_channel_free");
+        close(g_pipes[i][0]);
+        close(g_pipes[i][1]);
+        ret = ABT_future_free(&g_futures[i]);
+        ABT_TEST_ERROR(ret, "ABT_future_free");
+        ret = ABT_eventual_free(&g_eventuals[i]);
+        ABT_TEST_ERROR(ret, "ABT_eventual_free");
+    }
+    close(g_file);
+    ret = ABT_cond_free(&g_cond);
+    ABT_TEST_ERROR(ret, "ABT_cond_free");
+    ret = ABT_mutex_free(&g_mutex);
+    ABT_TEST_ERROR(ret, "ABT_mutex_free");
+
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ABT_TEST_ERROR(ret, "ABT_xstream_free");
+    }
+    free(g_pools);
+    free(xstreams);
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* Cost of yielding and of context switches between ULTs on one ES.  The
+ * context switches by ABT_thread_yield_to() are measured in the private pool
+ * of the primary ES and in a pool that other ESs may pop from, where the
+ * target has to be removed from the pool under its lock. */
+
+#include "abtbench.h"
+
+#define DEFAULT_NUM_THREADS     2
+#define DEFAULT_NUM_OPS         100000
+
+static int g_num_threads;
+static int g_num_ops;
+static ABT_pool g_pool;
+static ABT_thread g_pair[2];
+static volatile int g_done;
+
+static void yield_func(void *arg)
+{
+    int i;
+    ABT_TEST_UNUSED(arg);
+    for (i = 0; i < g_num_ops; i++) {
+        ABT_thread_yield();
+    }
+}
+
+/* Switch to the other ULT of the pair until the first one finishes */
+static void yield_to_func(void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+    int i, ret;
+
+    if (idx == 0) {
+        for (i = 0; i < g_num_ops; i++) {
+            ret = ABT_thread_yield_to(g_pair[1]);
+            ABT_TEST_ERROR(ret, "ABT_thread_yield_to");
+        }
+        g_done = 1;
+    } else {
+        while (!g_done) {
+            ret = ABT_thread_yield_to(g_pair[0]);
+            ABT_TEST_ERROR(ret, "ABT_thread_yield_to");
+        }
+    }
+}
+
+/* Yield from num_threads ULTs.  With one ULT, the scheduler finds nothing
+ * else to run. */
+static double yield_n(void *arg)
+{
+    int num_threads = (int)(intptr_t)arg;
+    ABT_thread *threads;
+    double t_start, t_end;
+    int i, ret;
+
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(g_pool, yield_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    t_start = ABT_get_wtime();
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_join(threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_join");
+    }
+    t_end = ABT_get_wtime();
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+    /* The ULTs yield num_threads * g_num_ops times in total. */
+    return (t_end - t_start) / num_threads;
+}
+
+static double yield_to_pair(void *arg)
+{
+    ABT_pool pool = (ABT_pool)arg;
+    double t_start, t_end;
+    int i, ret;
+
+    g_done = 0;
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_create(pool, yield_to_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &g_pair[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_create");
+    }
+    t_start = ABT_get_wtime();
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_join(g_pair[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_join");
+    }
+    t_end = ABT_get_wtime();
+    for (i = 0; i < 2; i++) {
+        ret = ABT_thread_free(&g_pair[i]);
+        ABT_TEST_ERROR(ret, "ABT_thread_free");
+    }
+    /* Each yield_to of the first ULT makes two context switches. */
+    return (t_end - t_start) / 2;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream, shared_xstream;
+    ABT_pool shared_pool;
+    ABT_sched sched;
+    int ret;
+
+    ABT_test_read_args(argc, argv);
+    if (argc > 1) {
+        g_num_threads = ABT_test_get_arg_val(ABT_TEST_ARG_N_ULT);
+        g_num_ops     = ABT_test_get_arg_val(ABT_TEST_ARG_N_ITER);
+    } else {
+        g_num_threads = DEFAULT_NUM_THREADS;
+        g_num_ops     = DEFAULT_NUM_OPS;
+    }
+
+    ret = ABT_init(argc, argv);
+    ABT_TEST_ERROR(ret, "ABT_init");
+    ret = ABT_xstream_self(&xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &g_pool);
+    ABT_TEST_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    ABT_bench_run("yield", "yield_alone", 1, g_num_ops, yield_n,
+                  (void *)(intptr_t)1);
+    ABT_bench_run("yield", "yield", 1, g_num_ops, yield_n,
+                  (void *)(intptr_t)g_num_threads);
+    ABT_bench_run("yield", "context_switch", 1, g_num_ops, yield_to_pair,
+                  (void *)g_pool);
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &shared_pool);
+    ABT_TEST_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_sched_create_basic(ABT_SCHED_BASIC, 1, &shared_pool,
+                                 ABT_SCHED_CONFIG_NULL, &sched);
+    ABT_TEST_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_xstream_create(sched, &shared_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_create");
+    ABT_bench_run("yield", "context_switch_shared", 2, g_num_ops,
+                  yield_to_pair, (void *)shared_pool);
+    ret = ABT_xstream_join(shared_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&shared_xstream);
+    ABT_TEST_ERROR(ret, "ABT_xstream_free");
+
+    ret = ABT_finalize();
+    ABT_TEST_ERROR(ret, "ABT_finalize");
+    return EXIT_SUCCESS;
+}
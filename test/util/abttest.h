@@ -16,6 +16,11 @@
 #endif
 #include <assert.h>
 
+/* Keep C++ compilers from getting confused */
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
 
 /** @defgroup TESTUTIL Test utility
  * This group is for test utility routines.
@@ -153,4 +158,8 @@ static inline uint64_t ABT_test_get_cycles()
 }
 #endif
 
+#if defined(__cplusplus)
+}
+#endif
+
 #endif /* ABTTEST_H_INCLUDED */